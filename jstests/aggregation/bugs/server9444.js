@@ -33,6 +33,13 @@ function test(pipeline, outOfMemoryCode) {
     // ensure we work when allowingDiskUsage === true
     var res = t.aggregate(pipeline, {allowDiskUsage: true});
     assert.eq(res.itcount(), t.count()); // all tests output one doc per input doc
+
+    // allowDiskUse is the same option
+    var res = t.aggregate(pipeline, {allowDiskUse: true});
+    assert.eq(res.itcount(), t.count());
+    var res = t.runCommand('aggregate', {pipeline: pipeline, allowDiskUse: 1});
+    assert.commandFailed(res);
+    assert.eq(res.code, 16949);
 }
 
 var groupCode = 16945;
@@ -54,5 +61,20 @@ test([{$group: {_id: '$_id', bigStr: {$first: '$bigStr'}}}, {$sort: {_id:-1}}],
 test([{$group: {_id: '$_id', bigStr: {$first: '$bigStr'}}}, {$sort: {random:1}}], groupCode);
 test([{$sort: {random:1}}, {$group: {_id: '$_id', bigStr: {$first: '$bigStr'}}}], sortCode);
 
+// the stages share one memory limit, so two that each fit under it alone can exceed it together
+var halfStr = Array(1024*1024 + 1).toString();
+var u = db.server9444_budget;
+u.drop();
+for (var i = 0; i < 70; i++)
+    u.insert({_id: i, bigStr: i + halfStr, random: Math.random()});
+var budgetPipeline = [{$sort: {random: 1}}, {$project: {bigStr: 1, random: 1}},
+                      {$sort: {bigStr: 1}}];
+assert.eq(u.aggregate([{$sort: {random: 1}}]).itcount(), 70);
+var res = u.runCommand('aggregate', {pipeline: budgetPipeline});
+assert.commandFailed(res);
+assert.eq(res.code, sortCode);
+assert.eq(u.aggregate(budgetPipeline, {allowDiskUse: true}).itcount(), 70);
+u.drop();
+
 // don't leave large collection laying around
 t.drop();
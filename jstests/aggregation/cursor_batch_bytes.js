@@ -0,0 +1,44 @@
+// Aggregation cursors size their batches by aggregationCursorBatchBytes as well as by count.
+var t = db.cursor_batch_bytes;
+t.drop();
+
+var str = new Array(10 * 1024).toString(); // about 10KB
+for (var i = 0; i < 100; i++)
+    t.insert({_id: i, str: str});
+
+var admin = db.getSisterDB('admin');
+var old = admin.runCommand({getParameter: 1, aggregationCursorBatchBytes: 1});
+assert.commandWorked(old);
+assert.commandWorked(admin.runCommand({setParameter: 1, aggregationCursorBatchBytes: 100 * 1024}));
+
+// the first batch stops short of the target, even though batchSize allows more
+var res = db.runCommand({aggregate: t.getName(), pipeline: [{$sort: {_id: 1}}],
+                         cursor: {batchSize: 50}});
+assert.commandWorked(res);
+assert.gt(res.cursor.firstBatch.length, 0);
+assert.lte(res.cursor.firstBatch.length, 10);
+
+// and so does each getmore, with nothing lost between batches
+var firstBatchSize = res.cursor.firstBatch.length;
+var cursor = new DBCommandCursor(db.getMongo(), res, 50);
+var seen = 0;
+while (cursor.hasNext()) {
+    if (seen >= firstBatchSize) {
+        // the first document of a new batch
+        assert.lte(cursor.objsLeftInBatch(), 10);
+    }
+    assert.eq(cursor.next()._id, seen);
+    seen++;
+}
+assert.eq(seen, 100);
+
+// a document bigger than the target still goes out, alone
+t.insert({_id: 100, str: new Array(200 * 1024).toString()});
+res = db.runCommand({aggregate: t.getName(), pipeline: [{$match: {_id: 100}}], cursor: {}});
+assert.eq(res.cursor.firstBatch.length, 1);
+assert.eq(res.cursor.id, 0);
+
+assert.commandWorked(admin.runCommand({setParameter: 1,
+                                       aggregationCursorBatchBytes:
+                                           old.aggregationCursorBatchBytes}));
+t.drop();
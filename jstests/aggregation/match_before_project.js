@@ -0,0 +1,39 @@
+// A $match on fields that the $project before it only includes or renames moves ahead of the
+// $project, so it can use the query system.
+var t = db.match_before_project;
+t.drop();
+
+for (var i = 0; i < 20; i++)
+    t.insert({_id: i, a: i % 5, b: {c: i}, d: [i, i + 1]});
+t.ensureIndex({a: 1});
+
+function firstStage(pipeline) {
+    var res = db.runCommand({aggregate: t.getName(), pipeline: pipeline, explain: true});
+    assert.commandWorked(res);
+    return res.stages[0];
+}
+
+// a renamed field is matched under its original name, and the projection still applies
+var pipeline = [{$project: {x: '$a', b: 1}}, {$match: {x: 3, 'b.c': {$gt: 10}}}];
+assert.eq(firstStage(pipeline).$cursor.query, {a: 3, 'b.c': {$gt: 10}});
+assert.eq(t.aggregate(pipeline).toArray().sort(function(l, r) { return l._id - r._id; }),
+          [{_id: 13, b: {c: 13}, x: 3}, {_id: 18, b: {c: 18}, x: 3}]);
+
+// through $or and past several projects, with _id passed through implicitly
+pipeline = [{$project: {x: '$a'}}, {$project: {y: '$x'}},
+            {$match: {$or: [{y: 1}, {_id: 4}]}}];
+assert.eq(firstStage(pipeline).$cursor.query, {$or: [{a: 1}, {_id: 4}]});
+assert.eq(t.aggregate(pipeline).itcount(), 5);
+
+// computed, dotted and excluded fields keep the match where it is
+[[{$project: {x: {$add: ['$a', 1]}}}, {$match: {x: 3}}],
+ [{$project: {x: '$b.c'}}, {$match: {x: 3}}],
+ [{$project: {_id: 0, a: 1}}, {$match: {_id: 3}}],
+ [{$project: {a: 1}}, {$match: {d: 3}}],
+].forEach(function(pipeline) {
+    assert.eq(firstStage(pipeline).$cursor.query, {}, tojson(pipeline));
+});
+assert.eq(t.aggregate([{$project: {x: '$b.c'}}, {$match: {x: 3}}]).toArray(), [{_id: 3, x: 3}]);
+assert.eq(t.aggregate([{$project: {_id: 0, a: 1}}, {$match: {_id: 3}}]).itcount(), 0);
+
+t.drop();
@@ -0,0 +1,60 @@
+// $out in merge mode upserts by _id, so a rollup can be kept up to date from just the new input.
+load('jstests/aggregation/extras/utils.js'); // assertErrorCode
+
+var input = db.out_merge_in;
+var output = db.out_merge_out;
+input.drop();
+output.drop();
+
+for (var i = 0; i < 100; i++)
+    input.insert({_id: i, hour: Math.floor(i / 10), n: 1});
+
+function rollup(watermark) {
+    var cursor = input.aggregate([{$match: {_id: {$gt: watermark}}},
+                                  {$group: {_id: '$hour', count: {$sum: '$n'}, last: {$max: '$_id'}}},
+                                  {$out: {to: output.getName(), mode: 'merge'}}]);
+    assert.eq(cursor.itcount(), 0); // empty cursor returned
+}
+
+// documents already in the output and not in the results are left alone
+output.insert({_id: 'untouched'});
+rollup(-1);
+assert.eq(output.count(), 11);
+assert.eq(output.findOne({_id: 3}), {_id: 3, count: 10, last: 39});
+assert.eq(output.findOne({_id: 'untouched'}), {_id: 'untouched'});
+
+// the next hours only read what came after the last watermark
+for (var i = 100; i < 120; i++)
+    input.insert({_id: i, hour: Math.floor(i / 10), n: 2});
+var watermark = output.find({_id: {$type: 1}}).sort({last: -1}).limit(1).next().last;
+assert.eq(watermark, 99);
+assert.eq(input.aggregate([{$match: {_id: {$gt: watermark}}}]).itcount(), 20);
+rollup(watermark);
+assert.eq(output.count(), 13);
+assert.eq(output.findOne({_id: 11}), {_id: 11, count: 20, last: 119});
+assert.eq(output.findOne({_id: 3}), {_id: 3, count: 10, last: 39});
+
+// merged results replace the whole output document for their _id
+input.update({_id: 105}, {$set: {n: 12}});
+rollup(watermark);
+assert.eq(output.findOne({_id: 10}), {_id: 10, count: 30, last: 109});
+assert.eq(output.count(), 13);
+
+// "replace" is the same as giving just the name
+input.aggregate({$match: {_id: {$lt: 3}}}, {$out: {to: output.getName(), mode: 'replace'}});
+assert.eq(output.find().sort({_id: 1}).toArray(),
+          [{_id: 0, hour: 0, n: 1}, {_id: 1, hour: 0, n: 1}, {_id: 2, hour: 0, n: 1}]);
+
+// bad specs
+assertErrorCode(input, {$out: {to: output.getName(), mode: 'append'}}, 17359);
+assertErrorCode(input, {$out: {to: output.getName(), extra: 1}}, 17357);
+assertErrorCode(input, [{$project: {_id: 0, n: 1}}, {$out: {to: output.getName(), mode: 'merge'}}],
+                17360);
+
+// capped collections can't be merged into either
+output.drop();
+db.createCollection(output.getName(), {capped: true, size: 2});
+assertErrorCode(input, {$out: {to: output.getName(), mode: 'merge'}}, 17152);
+
+input.drop();
+output.drop();
@@ -0,0 +1,51 @@
+// With aggregationGroupThreads set, $group splits its input across worker threads and returns
+// the same groups it does on one thread.
+
+var t = db.jstests_aggregation_parallel_group;
+t.drop();
+
+for ( var i = 0; i < 20000; ++i ) {
+    t.insert( { _id: i, a: i % 97, b: i % 3, s: "x" + ( i % 5 ) } );
+}
+assert( !db.getLastError() );
+
+var pipeline = [ { $sort: { _id: 1 } },
+                 { $group: { _id: { a: "$a", b: "$b" },
+                             count: { $sum: 1 },
+                             total: { $sum: "$_id" },
+                             avg: { $avg: "$_id" },
+                             first: { $first: "$_id" },
+                             last: { $last: "$_id" },
+                             min: { $min: "$s" },
+                             pushed: { $push: "$_id" },
+                             set: { $addToSet: "$s" } } },
+                 { $sort: { _id: 1 } } ];
+
+function setThreads( n ) {
+    assert.commandWorked( db.adminCommand( { setParameter: 1, aggregationGroupThreads: n } ) );
+}
+
+function run() {
+    var res = t.aggregate( pipeline ).result;
+    res.forEach( function( g ) { g.set.sort(); } );
+    return res;
+}
+
+setThreads( 1 );
+var expected = run();
+assert.eq( 97 * 3, expected.length );
+
+[ 2, 4, 7 ].forEach( function( n ) {
+    setThreads( n );
+    // $first, $last and $push see documents in input order, as on one thread
+    assert.eq( expected, run() );
+} );
+
+// Errors in the accumulators on a worker come back to the client.
+setThreads( 4 );
+var res = t.runCommand( "aggregate", { pipeline: [ { $group: { _id: "$a",
+                                                               x: { $sum: { $add: [ "$s", 1 ] } } } } ] } );
+assert.commandFailed( res );
+assert.eq( 16554, res.code );
+
+setThreads( 1 );
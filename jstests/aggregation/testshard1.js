@@ -198,6 +198,14 @@ testSortLimit(10, -1);
 testSortLimit(100,  1);
 testSortLimit(100, -1);
 
+// test a sort of everything, which the merger reads from each shard over many batches
+var sortedAll = db.ts1.aggregate([{$project: {random:1, _id:0}}, {$sort: {random: 1}}],
+                                 {cursor: {batchSize: 1000}}).toArray();
+assert.eq(nItems, sortedAll.length);
+for (var i = 1; i < sortedAll.length; i++) {
+    assert.lte(sortedAll[i - 1].random, sortedAll[i].random);
+}
+
 // test $out by copying source collection verbatim to output
 var outCollection = db.ts1_out;
 var res = aggregateOrdered(db.ts1, [{$out: outCollection.getName()}]);
@@ -799,6 +799,28 @@ var tests = [
             { runOnDb: secondDbName, rolesAllowed: roles_all }
         ]
     },
+    {
+        testname: "planCacheClear",
+        command: {planCacheClear: "x"},
+        skipSharded: true,
+        setup: function (db) { db.x.save({a: 1}); },
+        teardown: function (db) { db.x.drop(); },
+        testcases: [
+            { runOnDb: firstDbName, rolesAllowed: {dbAdmin: 1, dbAdminAnyDatabase: 1, __system: 1} },
+            { runOnDb: secondDbName, rolesAllowed: {dbAdminAnyDatabase: 1, __system: 1} }
+        ]
+    },
+    {
+        testname: "planCacheListQueryShapes",
+        command: {planCacheListQueryShapes: "x"},
+        skipSharded: true,
+        setup: function (db) { db.x.save({a: 1}); },
+        teardown: function (db) { db.x.drop(); },
+        testcases: [
+            { runOnDb: firstDbName, rolesAllowed: roles_readWriteDbAdmin },
+            { runOnDb: secondDbName, rolesAllowed: roles_readWriteDbAdminAny }
+        ]
+    },
     {
         testname: "profile",  
         command: {profile: 0},
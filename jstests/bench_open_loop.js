@@ -0,0 +1,39 @@
+// benchRun with opsPerSecond sends operations at the target rate and reports latency percentiles
+
+t = db.bench_open_loop;
+t.drop();
+
+t.insert( { _id : 1 , x : 1 } )
+
+ops = [
+    { op : "findOne" , ns : t.getFullName() , query : { _id : 1 } } ,
+    { op : "update" , ns : t.getFullName() , query : { _id : 1 } , update : { $inc : { x : 1 } } }
+]
+
+seconds = 2
+
+benchArgs =  { ops : ops , parallel : 2 , seconds : seconds , opsPerSecond : 200 ,
+               host : db.getMongo().host };
+
+if (jsTest.options().auth) {
+    benchArgs['db'] = 'admin';
+    benchArgs['username'] = jsTest.options().adminUser;
+    benchArgs['password'] = jsTest.options().adminPassword;
+}
+res = benchRun( benchArgs );
+printjson( res );
+
+// half the operations are updates, so about 200 of them in two seconds
+x = t.findOne( { _id : 1 } ).x - 1;
+assert.lte( x , 200 + 10 , "A1" )
+assert.gte( x , 100 , "A2" )
+
+p = res.updateLatencyPercentilesMicros;
+assert( p , "B1" )
+assert.lte( p.p50 , p.p99 , "B2" )
+assert.lte( p.p99 , p.p999 , "B3" )
+assert( res.findOneLatencyPercentilesMicros , "B4" )
+assert.eq( undefined , res.insertLatencyPercentilesMicros , "B5" )
+
+benchArgs['opsPerSecond'] = -1;
+assert.throws( function() { benchRun( benchArgs ); } , [] , "C1" )
@@ -0,0 +1,36 @@
+// The background btree defragmenter merges the half empty buckets a large remove leaves behind.
+
+var t = db.jstests_btree_defrag;
+t.drop();
+
+t.ensureIndex( { a: 1 } );
+var pad = new Array( 100 ).toString();
+for ( var i = 0; i < 20000; ++i ) {
+    t.insert( { _id: i, a: pad + i } );
+}
+assert( !db.getLastError() );
+
+// Every other key goes, which leaves each bucket too full to be merged by the removes.
+t.remove( { _id: { $mod: [ 2, 0 ] } } );
+assert( !db.getLastError() );
+var before = t.stats().indexSizes.a_1;
+
+var metrics = function() { return db.serverStatus().metrics.btree.defrag; };
+var finished = metrics().indexesFinished;
+
+assert.commandWorked( db.adminCommand( { setParameter: 1, btreeDefragStepsPerSecond: 1000 } ) );
+try {
+    assert.soon( function() { return t.stats().indexSizes.a_1 < before * 0.7; },
+                 "index wasn't defragmented", 60 * 1000 );
+    assert.soon( function() { return metrics().indexesFinished > finished; } );
+}
+finally {
+    assert.commandWorked( db.adminCommand( { setParameter: 1, btreeDefragStepsPerSecond: 0 } ) );
+}
+assert.lt( 0, metrics().bucketsMerged );
+
+// Every remaining key is still found.
+assert( t.validate( true ).valid );
+assert.eq( 10000, t.find().hint( { a: 1 } ).itcount() );
+assert.eq( 1, t.find( { a: pad + 4321 } ).hint( { a: 1 } ).itcount() );
+assert.eq( 0, t.find( { a: pad + 4320 } ).hint( { a: 1 } ).itcount() );
@@ -0,0 +1,30 @@
+// A capped collection that has wrapped many times, with a mix of document sizes, keeps its newest
+// documents in insertion order and stays valid.
+
+var t = db.jstests_capped_ring;
+t.drop();
+db.createCollection( t.getName(), { capped: true, size: 64 * 1024, autoIndexId: false } );
+
+var sizes = [ 10, 300, 40, 2000, 5, 700 ];
+for ( var i = 0; i < 20000; ++i ) {
+    t.insert( { i: i, s: new Array( sizes[ i % sizes.length ] ).toString() } );
+}
+assert( !db.getLastError() );
+
+var docs = t.find().toArray();
+assert.lt( 50, docs.length );
+assert.eq( 19999, docs[ docs.length - 1 ].i );
+for ( var j = 1; j < docs.length; ++j ) {
+    assert.eq( docs[ j - 1 ].i + 1, docs[ j ].i );
+}
+assert.eq( t.count(), t.find().sort( { $natural: -1 } ).itcount() );
+assert( t.validate( true ).valid );
+
+// A document bigger than most, after many small ones, pushes out as many as it needs.
+for ( var i = 0; i < 2000; ++i ) {
+    t.insert( { i: 20000 + i } );
+}
+t.insert( { i: "big", s: new Array( 30 * 1024 ).toString() } );
+assert( !db.getLastError() );
+assert.eq( "big", t.find().sort( { $natural: -1 } ).next().i );
+assert( t.validate( true ).valid );
@@ -0,0 +1,51 @@
+// Background compaction moves documents out of sparse extents and frees the extents it empties,
+// keeping the indexes consistent.
+
+var t = db.jstests_compact_background;
+t.drop();
+
+t.ensureIndex( { a: 1 }, { unique: true } );
+
+var big = new Array( 1000 ).toString();
+for ( var i = 0; i < 3000; ++i ) {
+    t.insert( { _id: i, a: i, s: big } );
+}
+assert( !db.getLastError() );
+
+// Remove all but one document in ten.
+t.remove( { _id: { $not: { $mod: [ 10, 0 ] } } } );
+assert.eq( 300, t.count() );
+
+var before = t.stats();
+
+var res = t.runCommand( "compact", { background: true, batchSize: 7 } );
+assert.commandWorked( res );
+assert.lt( 0, res.documentsMoved );
+assert.lt( 0, res.extentsFreed );
+
+var after = t.stats();
+assert.eq( before.numExtents - res.extentsFreed, after.numExtents );
+assert.eq( 300, after.count );
+
+// Every document is still there, and reachable through each index.
+assert.eq( 300, t.find().itcount() );
+assert.eq( 300, t.find().hint( { _id: 1 } ).itcount() );
+assert.eq( 300, t.find().hint( { a: 1 } ).itcount() );
+for ( var i = 0; i < 3000; i += 10 ) {
+    assert.eq( 1, t.find( { a: i } ).hint( { a: 1 } ).itcount() );
+}
+assert( t.validate( true ).valid );
+
+// The unique index still rejects duplicates.
+t.insert( { _id: 3001, a: 10 } );
+assert( db.getLastError() );
+
+// Bad options are refused, as are capped collections.
+assert.commandFailed( t.runCommand( "compact", { background: true, maxFill: 0 } ) );
+assert.commandFailed( t.runCommand( "compact", { background: true, batchSize: 0 } ) );
+
+var c = db.jstests_compact_background_capped;
+c.drop();
+db.createCollection( c.getName(), { capped: true, size: 10000 } );
+assert.commandFailed( c.runCommand( "compact", { background: true } ) );
+c.drop();
@@ -0,0 +1,71 @@
+// Collections with compressRecords set store their documents compressed.
+
+var plain = db.jstests_compress_records_plain;
+var t = db.jstests_compress_records;
+plain.drop();
+t.drop();
+
+db.createCollection( plain.getName() );
+db.createCollection( t.getName() );
+var res = db.runCommand( { collMod: t.getName(), compressRecords: true } );
+assert.commandWorked( res );
+assert.eq( false, res.compressRecords_old );
+assert.eq( true, res.compressRecords_new );
+
+t.ensureIndex( { a: 1 } );
+
+var line = "GET /index.html HTTP/1.1 200 - Mozilla/5.0 (X11; Linux x86_64) ";
+for ( var i = 0; i < 500; ++i ) {
+    var doc = { _id: i, a: i, n: 0, msg: line + line + line + line };
+    plain.insert( doc );
+    t.insert( doc );
+}
+// A document without an _id gets one, and tiny documents aren't worth compressing.
+t.insert( { a: 1000, msg: line + line } );
+t.insert( { a: 1001 } );
+assert( !db.getLastError() );
+
+assert.lt( t.stats().size, plain.stats().size / 2 );
+
+// Documents read back whole, whether found through a scan or an index.
+assert.eq( 502, t.find().itcount() );
+assert.eq( line + line + line + line, t.findOne( { _id: 7 } ).msg );
+assert.eq( line + line + line + line, t.find( { a: 8 } ).hint( { a: 1 } ).next().msg );
+assert.eq( line + line, t.findOne( { a: 1000 } ).msg );
+assert( t.findOne( { a: 1000 } )._id );
+assert.eq( 1, t.find( { a: 1001 } ).hint( { a: 1 } ).itcount() );
+
+// Updates that would otherwise be applied in place, ones that grow the document, and ones that
+// change an indexed field.
+t.update( { _id: 3 }, { $inc: { n: 1 } } );
+t.update( { _id: 4 }, { $set: { extra: line + line + line + line + line + line } } );
+t.update( { _id: 5 }, { $set: { a: 5000 } } );
+assert( !db.getLastError() );
+assert.eq( 1, t.findOne( { _id: 3 } ).n );
+assert.eq( line + line + line + line, t.findOne( { _id: 3 } ).msg );
+assert.eq( line + line + line + line + line + line, t.findOne( { _id: 4 } ).extra );
+assert.eq( 5, t.find( { a: 5000 } ).hint( { a: 1 } ).next()._id );
+assert.eq( 0, t.find( { a: 5 } ).hint( { a: 1 } ).itcount() );
+
+t.remove( { _id: { $lt: 100 } } );
+assert.eq( 402, t.count() );
+assert( t.validate( true ).valid );
+
+// Compaction keeps documents compressed.
+var before = t.stats().size;
+assert.commandWorked( t.runCommand( "compact" ) );
+assert.eq( 402, t.find().itcount() );
+assert.gte( before, t.stats().size );
+
+// Turning compression off leaves what's stored readable.
+assert.commandWorked( db.runCommand( { collMod: t.getName(), compressRecords: false } ) );
+t.insert( { _id: "new", msg: line + line + line + line } );
+assert.eq( 403, t.find().itcount() );
+assert.eq( line + line + line + line, t.findOne( { _id: 200 } ).msg );
+
+// Capped collections can't be compressed.
+var c = db.jstests_compress_records_capped;
+c.drop();
+db.createCollection( c.getName(), { capped: true, size: 10000 } );
+assert.commandFailed( db.runCommand( { collMod: c.getName(), compressRecords: true } ) );
+c.drop();
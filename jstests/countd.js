@@ -0,0 +1,41 @@
+// Counts whose predicate the index bounds capture exactly count index keys without fetching.
+// Check multikey dedup, compound bounds, $in and $or intervals, and skip and limit.
+
+t = db.jstests_countd;
+t.drop();
+
+t.ensureIndex( { a:1, b:1 } );
+for( i = 0; i < 1000; ++i ) {
+    t.save( { a:i % 10, b:i } );
+}
+assert.eq( null, db.getLastError() );
+
+function check( query ) {
+    assert.eq( t.find( query ).itcount(), t.count( query ), tojson( query ) );
+}
+
+check( { a:3 } );
+check( { a:{ $gte:2, $lt:5 } } );
+check( { a:{ $in:[ 1, 4, 11 ] } } );
+check( { a:5, b:{ $gt:500 } } );
+check( { a:{ $in:[ 1, 2 ] }, b:{ $lte:100 } } );
+check( { a:{ $gt:20 } } );
+// Not exact: b alone is not a prefix of the index, and $mod needs the matcher.
+check( { b:{ $lt:10 } } );
+check( { a:3, b:{ $mod:[ 2, 1 ] } } );
+
+assert.eq( 100, t.count( { a:3 } ) );
+assert.eq( 90, t.find( { a:3 } ).skip( 10 ).count( true ) );
+assert.eq( 5, t.find( { a:3 } ).skip( 10 ).limit( 5 ).count( true ) );
+assert.eq( 0, t.find( { a:3 } ).skip( 200 ).count( true ) );
+
+// Every document has several keys within the bounds but is counted once.
+t.drop();
+t.ensureIndex( { a:1 } );
+for( i = 0; i < 100; ++i ) {
+    t.save( { a:[ i, i + 1, i + 2 ] } );
+}
+assert.eq( null, db.getLastError() );
+check( { a:{ $gte:10, $lt:20 } } );
+assert.eq( 12, t.count( { a:{ $gte:10, $lt:20 } } ) );
+check( { a:{ $in:[ 5, 6, 50 ] } } );
@@ -0,0 +1,34 @@
+// Predicates the index bounds can't answer exactly are checked against the index keys when the
+// projection is covered, rather than fetching the document.
+
+var t = db.jstests_covered_index_filter;
+t.drop();
+
+for (var i = 0; i < 100; ++i) {
+    t.save({a: i % 10, b: "str" + i, c: i});
+}
+t.save({a: 1});
+t.save({a: 1, b: null});
+t.ensureIndex({a: 1, b: 1});
+
+// Unanchored regex on the second field of a compound index.
+var res = t.find({a: 1, b: /1/}, {_id: 0, a: 1, b: 1}).toArray();
+assert.eq(10, res.length);
+res.forEach(function(doc) {
+    assert.eq(1, doc.a);
+    assert(/1/.test(doc.b), tojson(doc));
+    assert.eq(undefined, doc.c);
+});
+
+// Negated predicates match both the missing field and the null the index stores for it.
+assert.eq(2, t.find({a: 1, b: {$not: /str/}}, {_id: 0, a: 1}).itcount());
+assert.eq(2, t.find({a: 1, b: {$nin: ["str1", "str11", "str21", "str31", "str41", "str51",
+                                       "str61", "str71", "str81", "str91"]}},
+                    {_id: 0, a: 1}).itcount());
+
+// $exists can tell missing from null, so it has to look at the documents.
+assert.eq(11, t.find({a: 1, b: {$exists: true}}, {_id: 0, a: 1}).itcount());
+
+// Same results with the index made multikey, when keys can't be filtered on.
+t.save({a: 1, b: ["x1", "y"]});
+assert.eq(11, t.find({a: 1, b: /1/}, {_id: 0, a: 1}).itcount());
@@ -0,0 +1,48 @@
+// The createIndexes command builds several indexes from one scan of the collection.
+
+var t = db.jstests_create_indexes;
+t.drop();
+
+for ( var i = 0; i < 1000; ++i ) {
+    t.insert( { _id: i, a: i % 10, b: [ i, -i ], c: "x" + i } );
+}
+assert( !db.getLastError() );
+
+var res = db.runCommand( { createIndexes: t.getName(),
+                           indexes: [ { key: { a: 1 }, name: "a_1" },
+                                      { key: { b: 1 }, name: "b_1" },
+                                      { key: { c: 1 }, name: "c_1", unique: true } ] } );
+assert.commandWorked( res );
+assert.eq( 1, res.numIndexesBefore );
+assert.eq( 4, res.numIndexesAfter );
+
+assert.eq( 100, t.find( { a: 3 } ).hint( { a: 1 } ).itcount() );
+assert.eq( 1, t.find( { b: -5 } ).hint( { b: 1 } ).itcount() );
+assert.eq( 1, t.find( { c: "x7" } ).hint( { c: 1 } ).itcount() );
+assert( t.validate( true ).valid );
+
+// Indexes that already exist are skipped.
+res = db.runCommand( { createIndexes: t.getName(),
+                       indexes: [ { key: { a: 1 }, name: "a_1" },
+                                  { key: { a: 1, c: 1 }, name: "a_1_c_1" } ] } );
+assert.commandWorked( res );
+assert.eq( 5, res.numIndexesAfter );
+
+// A failing index in the batch leaves none of them behind.
+t.insert( { _id: 1000, a: 1, c: "x1" } );
+res = db.runCommand( { createIndexes: t.getName(),
+                       indexes: [ { key: { a: -1 }, name: "a_-1" },
+                                  { key: { c: -1 }, name: "c_-1", unique: true } ] } );
+assert.commandFailed( res );
+assert.eq( 5, t.getIndexes().length );
+
+// Specs naming another namespace are refused, and the collection is created if missing.
+assert.commandFailed( db.runCommand( { createIndexes: t.getName(),
+                                       indexes: [ { ns: "other.coll", key: { d: 1 },
+                                                    name: "d_1" } ] } ) );
+var u = db.jstests_create_indexes_new;
+u.drop();
+assert.commandWorked( db.runCommand( { createIndexes: u.getName(),
+                                       indexes: [ { key: { x: 1 }, name: "x_1" } ] } ) );
+assert.eq( 2, u.getIndexes().length );
+u.drop();
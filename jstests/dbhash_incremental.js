@@ -0,0 +1,56 @@
+// dbhash_incremental.js
+// Tests that dbHash's incremental hashes don't depend on document order, and that the hash
+// writes keep current matches one computed afresh from the same documents
+
+var a = db.dbhash_incremental_a;
+var b = db.dbhash_incremental_b;
+a.drop();
+b.drop();
+
+function hashes() {
+    var ret = db.runCommand({dbHash : 1, incremental : true,
+                             collections : [a.getName(), b.getName()]});
+    assert.commandWorked(ret);
+    assert(ret.incremental);
+    return ret;
+}
+
+for (var i = 0; i < 100; i++) {
+    a.insert({_id : i, x : i});
+}
+for (var i = 99; i >= 0; i--) {
+    b.insert({_id : i, x : i});
+}
+assert.eq(null, db.getLastError());
+
+var ret = hashes();
+assert.eq(0, ret.fromCache.length);
+assert.eq(ret.collections[a.getName()], ret.collections[b.getName()]);
+assert.eq(0, ret.collections[a.getName()].indexOf("100:"));
+
+// in place, moving and multi updates, removes and inserts
+a.update({_id : 5}, {$inc : {x : 1}});
+a.update({_id : 6}, {$set : {s : new Array(10000).toString()}});
+a.update({x : {$lt : 20}}, {$set : {y : 1}}, false, true);
+a.remove({_id : {$gte : 90}});
+a.insert({_id : 200, z : "new"});
+a.update({_id : 201}, {$set : {z : "upserted"}}, true);
+assert.eq(null, db.getLastError());
+
+ret = hashes();
+assert.eq([a.getFullName(), b.getFullName()], ret.fromCache.sort());
+assert.neq(ret.collections[a.getName()], ret.collections[b.getName()]);
+
+// the same documents, hashed by a fresh scan
+b.drop();
+a.find().sort({_id : -1}).forEach(function(doc) { b.insert(doc); });
+assert.eq(null, db.getLastError());
+
+ret = hashes();
+assert.eq([a.getFullName()], ret.fromCache);
+assert.eq(ret.collections[a.getName()], ret.collections[b.getName()]);
+assert.eq(0, ret.collections[a.getName()].indexOf("92:"));
+
+// the md5 hashes still depend only on _id order
+assert.eq(db.runCommand({dbHash : 1, collections : [a.getName()]}).collections[a.getName()],
+          db.runCommand({dbHash : 1, collections : [b.getName()]}).collections[b.getName()]);
@@ -0,0 +1,38 @@
+// The heat of each database's extents is saved at shutdown and read back when it is opened.
+
+port = allocatePorts( 1 )[ 0 ];
+var baseName = "jstests_disk_extent_heat";
+var dbpath = "/data/db/" + baseName;
+
+var heatFile = function() {
+    return listFiles( dbpath ).filter( function( f ) {
+        return f.name.match( /test\.heat$/ );
+    } );
+}
+
+var m = startMongod( "--smallfiles", "--port", port, "--dbpath", dbpath );
+var t = m.getDB( "test" )[ baseName ];
+
+var big = new Array( 1000 ).toString();
+for ( var i = 0; i < 2000; ++i ) {
+    t.insert( { _id: i, s: big } );
+}
+assert( !m.getDB( "test" ).getLastError() );
+for ( var pass = 0; pass < 20; ++pass ) {
+    assert.eq( 2000, t.find().itcount() );
+}
+
+stopMongod( port );
+assert.eq( 1, heatFile().length );
+
+// Opening the database again warms it from the saved heat, and what's stored is unaffected.
+m = startMongodNoReset( "--smallfiles", "--port", port, "--dbpath", dbpath );
+t = m.getDB( "test" )[ baseName ];
+assert.eq( 2000, t.find().itcount() );
+assert.eq( big, t.findOne( { _id: 1999 } ).s );
+
+// Dropping the database removes its heat.
+m.getDB( "test" ).dropDatabase();
+assert.eq( 0, heatFile().length );
+
+stopMongod( port );
@@ -0,0 +1,54 @@
+// Databases named in inMemoryDatabases work as any other, but have no files and are gone after a
+// restart.
+
+port = allocatePorts( 1 )[ 0 ];
+var baseName = "jstests_disk_in_memory_db";
+var dbpath = "/data/db/" + baseName;
+
+var filesOf = function( dbname ) {
+    return listFiles( dbpath ).filter( function( f ) {
+        return f.name.indexOf( "/" + dbname + "." ) >= 0;
+    } );
+}
+
+var m = startMongod( "--journal", "--smallfiles", "--port", port, "--dbpath", dbpath,
+                     "--setParameter", "inMemoryDatabases=cache,sessions" );
+var cache = m.getDB( "cache" );
+var disk = m.getDB( "disk" );
+
+cache.c.ensureIndex( { a: 1 } );
+var big = new Array( 1000 ).toString();
+for ( var i = 0; i < 5000; ++i ) {
+    cache.c.insert( { _id: i, a: i % 100, s: big } );
+    disk.c.insert( { _id: i } );
+}
+cache.c.update( { _id: 5 }, { $set: { s: big + big } } );
+cache.c.remove( { _id: { $lt: 1000 } } );
+assert( !cache.getLastError() );
+
+assert.eq( 4000, cache.c.count() );
+assert.eq( 40, cache.c.find( { a: 7 } ).hint( { a: 1 } ).itcount() );
+assert( cache.c.validate( true ).valid );
+assert.lt( 0, cache.stats().fileSize );
+
+// Nothing reaches the dbpath, but the database is still listed.
+assert.eq( 0, filesOf( "cache" ).length );
+assert.lt( 0, filesOf( "disk" ).length );
+assert( m.getDBNames().indexOf( "cache" ) >= 0 );
+
+// Repair has nothing to work on.
+assert.commandFailed( cache.runCommand( { repairDatabase: 1 } ) );
+
+// A dropped in memory database can be used again.
+m.getDB( "sessions" ).s.insert( { x: 1 } );
+m.getDB( "sessions" ).dropDatabase();
+m.getDB( "sessions" ).s.insert( { x: 2 } );
+assert.eq( 2, m.getDB( "sessions" ).s.findOne().x );
+
+stopMongod( port );
+
+m = startMongodNoReset( "--journal", "--smallfiles", "--port", port, "--dbpath", dbpath,
+                        "--setParameter", "inMemoryDatabases=cache,sessions" );
+assert.eq( 0, m.getDB( "cache" ).c.count() );
+assert.eq( 5000, m.getDB( "disk" ).c.count() );
+stopMongod( port );
@@ -34,11 +34,12 @@ assert.eq( 1000 , x.stats.nscannedObjects , "AC3" )
 
 t.ensureIndex( { a : 1 } )
 
+// A skip scan of the index reads one key per value.
 x = d( "a" );
-assert.eq( 1000 , x.stats.n , "BA1" )
-assert.eq( 1000 , x.stats.nscanned , "BA2" )
-// QUERY_MIGRATION: pending projection support
-//assert.eq( 0 , x.stats.nscannedObjects , "BA3" )
+assert.eq( 10 , x.stats.n , "BA1" )
+assert.eq( 10 , x.stats.nscanned , "BA2" )
+assert.eq( 0 , x.stats.nscannedObjects , "BA3" )
+assert.eq( "DistinctScan a_1" , x.stats.cursor , "BA4" )
 
 x = d( "a" , { a : { $gt : 5 } } );
 assert.eq( 398 , x.stats.n , "BB1" )
@@ -0,0 +1,64 @@
+// distinct on the first field of an index, with no query, skip scans the index.
+
+var t = db.jstests_distinct_skip_scan;
+t.drop();
+
+t.ensureIndex( { a : 1 , b : -1 } );
+for ( var i = 0; i < 2000; ++i ) {
+    t.insert( { a : i % 20 , b : i } );
+}
+t.insert( { a : "x" } );
+t.insert( { a : { c : 1 } } );
+t.insert( { b : 5 } );
+assert( !db.getLastError() );
+
+function distinct( key , query ) {
+    var res = t.runCommand( "distinct" , { key : key , query : query || {} } );
+    assert.commandWorked( res );
+    return res;
+}
+
+function sorted( values ) {
+    return values.map( tojson ).sort();
+}
+
+var res = distinct( "a" );
+assert.eq( "DistinctScan a_1_b_-1" , res.stats.cursor );
+assert.eq( 22 , res.values.length );
+assert.gt( 100 , res.stats.nscanned );
+// The document without 'a' is indexed as null, but null isn't a value of 'a'.
+assert.eq( -1 , sorted( res.values ).indexOf( "null" ) );
+assert.neq( -1 , sorted( res.values ).indexOf( tojson( "x" ) ) );
+assert.neq( -1 , sorted( res.values ).indexOf( tojson( { c : 1 } ) ) );
+
+// An explicit null is a value.
+t.insert( { a : null } );
+res = distinct( "a" );
+assert.eq( 23 , res.values.length );
+assert.neq( -1 , sorted( res.values ).indexOf( "null" ) );
+
+// Queries, and fields that aren't first in an index, still look at every match.
+res = distinct( "a" , { b : { $lt : 100 } } );
+assert.eq( 20 , res.values.length );
+res = distinct( "b" );
+assert.eq( 2000 , res.values.length );
+
+// Arrays make the index multikey, which the skip scan can't use.
+t.insert( { a : [ 100 , 101 ] } );
+res = distinct( "a" );
+assert.neq( "DistinctScan a_1_b_-1" , res.stats.cursor );
+assert.eq( 25 , res.values.length );
+
+// Descending indexes and sparse ones.
+t.drop();
+t.ensureIndex( { a : -1 } );
+t.ensureIndex( { c : 1 } , { sparse : true } );
+for ( var i = 0; i < 100; ++i ) {
+    t.insert( { a : i % 7 , c : i % 3 } );
+}
+res = distinct( "a" );
+assert.eq( "DistinctScan a_-1" , res.stats.cursor );
+assert.eq( [ 0 , 1 , 2 , 3 , 4 , 5 , 6 ] , res.values.sort() );
+res = distinct( "c" );
+assert.neq( "DistinctScan c_1" , res.stats.cursor );
+assert.eq( [ 0 , 1 , 2 ] , res.values.sort() );
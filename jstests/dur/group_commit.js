@@ -0,0 +1,39 @@
+// getLastError j:true is acknowledged by the next group commit, which starts as soon as it is
+// asked for rather than at the end of journalCommitInterval.
+
+var path = "/data/db/group_commit";
+
+var conn = startMongodEmpty("--port", 30001, "--dbpath", path, "--dur", "--smallfiles",
+                            "--journalCommitInterval", "300");
+var d = conn.getDB("test");
+
+// waiting out a third of the interval each time would take at least 5 seconds
+var n = 50;
+var start = new Date();
+for (var i = 0; i < n; ++i) {
+    d.foo.insert({ _id: i });
+    var res = d.runCommand({ getlasterror: 1, j: true });
+    assert.eq(null, res.err);
+}
+assert.lt(new Date() - start, n * 100 * 0.8);
+
+// several connections waiting at once share commits
+var s = startParallelShell("for (var i = 0; i < 200; ++i) {" +
+                           "    db.bar.insert({ a: i });" +
+                           "    db.runCommand({ getlasterror: 1, j: true });" +
+                           "}", 30001);
+for (var i = 0; i < 200; ++i) {
+    d.baz.insert({ a: i });
+    d.runCommand({ getlasterror: 1, j: true });
+}
+s();
+assert.eq(200, d.bar.count());
+
+// the stats cover the previous three second interval
+sleep(3500);
+var gc = d.serverStatus().dur.groupCommit;
+printjson(gc);
+assert.lt(0, gc.batches);
+assert.lte(gc.batches, gc.waiters);
+
+stopMongod(30001);
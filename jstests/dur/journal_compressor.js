@@ -0,0 +1,35 @@
+// Journal sections written with different compressors, in the same journal file, all recover.
+
+var path = "/data/db/journal_compressor";
+
+var conn = startMongodEmpty("--port", 30001, "--dbpath", path, "--dur", "--smallfiles",
+                            "--setParameter", "journalCompressor=none");
+var d = conn.getDB("test");
+var admin = conn.getDB("admin");
+assert.eq("none", d.serverStatus().dur.compressor);
+
+var big = new Array(1000).toString();
+for (var i = 0; i < 500; ++i) {
+    d.foo.insert({ _id: i, big: big });
+}
+d.runCommand({ getlasterror: 1, j: true });
+
+assert.commandFailed(admin.runCommand({ setParameter: 1, journalCompressor: "bogus" }));
+assert.commandWorked(admin.runCommand({ setParameter: 1, journalCompressor: "snappy" }));
+assert.eq("snappy", d.serverStatus().dur.compressor);
+
+for (var i = 500; i < 1000; ++i) {
+    d.foo.insert({ _id: i, big: big });
+}
+d.foo.update({ _id: 3 }, { $set: { x: 1 } });
+d.runCommand({ getlasterror: 1, j: true });
+
+// kill hard so the writes come back from the journal
+stopMongod(30001, /*signal*/9);
+
+conn = startMongodNoReset("--port", 30002, "--dbpath", path, "--dur", "--smallfiles");
+d = conn.getDB("test");
+assert.eq(1000, d.foo.count());
+assert.eq(1, d.foo.findOne({ _id: 3 }).x);
+assert(d.foo.validate(true).valid);
+stopMongod(30002);
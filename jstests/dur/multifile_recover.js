@@ -0,0 +1,43 @@
+// Recovery of a journal whose sections write to many data files, in several databases, and
+// reopening databases whose files are mapped only when first used.
+
+var path = "/data/db/multifile_recover";
+
+var conn = startMongodEmpty("--port", 30001, "--dbpath", path, "--dur", "--smallfiles",
+                            "--setParameter", "journalRecoveryThreads=3");
+var a = conn.getDB("multifile_a");
+var b = conn.getDB("multifile_b");
+
+// enough to need several smallfiles in each database
+var big = new Array(16 * 1024).toString();
+for (var i = 0; i < 800; ++i) {
+    a.foo.insert({ _id: i, big: big });
+    b.foo.insert({ _id: i, big: big });
+    if (i % 7 == 0) {
+        a.bar.update({ _id: 0 }, { $inc: { n: 1 } }, true);
+    }
+}
+b.foo.remove({ _id: { $lt: 100 } });
+assert(!b.getLastError());
+assert.lt(3, a.stats().numExtents);
+
+// wait for a group commit, then kill hard so the writes are recovered from the journal
+sleep(8000);
+stopMongod(30001, /*signal*/9);
+
+conn = startMongodNoReset("--port", 30002, "--dbpath", path, "--dur", "--smallfiles",
+                          "--setParameter", "journalRecoveryThreads=3");
+a = conn.getDB("multifile_a");
+b = conn.getDB("multifile_b");
+
+assert.eq(800, a.foo.count());
+assert.eq(700, b.foo.count());
+assert.eq(Math.ceil(800 / 7), a.bar.findOne().n);
+
+// the last documents live in the last files, which are mapped on first use
+assert.eq(big, a.foo.findOne({ _id: 799 }).big);
+assert.eq(big, b.foo.findOne({ _id: 799 }).big);
+assert(a.foo.validate(true).valid);
+assert(b.foo.validate(true).valid);
+
+stopMongod(30002);
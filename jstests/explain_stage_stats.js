@@ -0,0 +1,45 @@
+// Per-stage execution stats in explain and the profiler.
+
+var stddb = db;
+var db = db.getSisterDB("explain_stage_stats");
+var t = db.explain_stage_stats;
+t.drop();
+
+for (var i = 0; i < 100; ++i) {
+    t.save({a: i});
+}
+t.ensureIndex({a: 1});
+
+// A detailed explain carries the stats tree of the plan.
+var stats = t.find({a: {$gt: 50}}).explain(true).stats;
+assert(stats, "no stats in explain");
+assert.eq("FETCH", stats.type);
+assert.eq(49, stats.advanced);
+assert.eq("IXSCAN", stats.children[0].type);
+assert.lte(49, stats.workingSetPeak);
+
+// Timings are only measured when asked for.
+assert.eq(0, stats.executionTimeMicros);
+assert.commandWorked(db.adminCommand({setParameter: 1, internalQueryExecStageTiming: true}));
+try {
+    stats = t.find({$where: "sleep(1); return true;"}).explain(true).stats;
+    assert.eq("COLLSCAN", stats.type);
+    assert.lt(0, stats.executionTimeMicros);
+}
+finally {
+    db.adminCommand({setParameter: 1, internalQueryExecStageTiming: false});
+}
+
+// The profiler records the same stats.
+db.setProfilingLevel(0);
+db.system.profile.drop();
+db.setProfilingLevel(2);
+assert.eq(49, t.find({a: {$gt: 50}}).itcount());
+db.setProfilingLevel(0);
+
+var op = db.system.profile.find({ns: t.getFullName(), op: "query"}).sort({$natural: -1}).next();
+assert(op.execStats, "no execStats in " + tojson(op));
+assert.eq("FETCH", op.execStats.type);
+assert.eq("IXSCAN", op.execStats.children[0].type);
+
+db = stddb;
@@ -0,0 +1,51 @@
+// Tests that findAndModify returns the right image of the document it updates, whether the update
+// is applied in place, moves the document or inserts it
+
+t = db.find_and_modify_images;
+t.drop();
+
+for (var i = 0; i < 10; i++) {
+    t.insert({_id: i, state: 0, n: i});
+}
+
+// in place: the old image is from before the bytes were changed
+var old = t.findAndModify({query: {state: 0, n: {$gte: 5}}, update: {$inc: {state: 1}}});
+assert.eq(0, old.state);
+assert.eq(1, t.findOne({_id: old._id}).state);
+
+var now = t.findAndModify({query: {state: 0, n: {$gte: 5}}, update: {$inc: {state: 1}},
+                           'new': true});
+assert.neq(old._id, now._id);
+assert.eq(1, now.state);
+
+// moved: the document grows past its record
+var big = new Array(10 * 1024).toString();
+now = t.findAndModify({query: {_id: 2}, update: {$set: {big: big}}, 'new': true});
+assert.eq(big, now.big);
+old = t.findAndModify({query: {_id: 2}, update: {$unset: {big: 1}, $set: {small: 1}}});
+assert.eq(big, old.big);
+assert.eq(undefined, t.findOne({_id: 2}).big);
+
+// every queue entry is taken exactly once
+var taken = {};
+while ((old = t.findAndModify({query: {state: 0}, update: {$set: {state: 2}}})) != null) {
+    assert(!taken[old._id]);
+    taken[old._id] = true;
+}
+assert.eq(8, Object.keySet(taken).length);
+assert.eq(0, t.count({state: 0}));
+
+// positional update
+t.insert({_id: 'p', a: [{b: 1}, {b: 2}]});
+now = t.findAndModify({query: {'a.b': 2}, update: {$set: {'a.$.c': 1}}, 'new': true});
+assert.eq({b: 2, c: 1}, now.a[1]);
+
+// no match, with and without upsert
+assert.eq(null, t.findAndModify({query: {_id: 'none'}, update: {$set: {x: 1}}}));
+assert.eq(null, t.findAndModify({query: {_id: 'none'}, update: {$set: {x: 1}}, upsert: true}));
+assert.eq({_id: 'up', x: 1},
+          t.findAndModify({query: {_id: 'up'}, update: {$set: {x: 1}}, upsert: true, 'new': true}));
+var res = t.runCommand('findAndModify', {query: {_id: 'up2'}, update: {$set: {x: 1}},
+                                         upsert: true});
+assert.eq(false, res.lastErrorObject.updatedExisting);
+assert.eq('up2', res.lastErrorObject.upserted);
@@ -0,0 +1,38 @@
+// Test that $text queries with small limits return the same top results as with a limit large
+// enough to score every matching document.
+
+var t = db.getSiblingDB("test").getCollection("fts_query_limit");
+
+db.adminCommand({setParameter:1, textSearchEnabled:true});
+db.adminCommand({setParameter:1, newQueryFrameworkEnabled:true});
+
+t.drop();
+
+var words = ["apple", "banana", "cherry", "date", "elder", "fig", "grape"];
+Random.setRandomSeed();
+for (var i = 0; i < 2000; i++) {
+    var text = [];
+    var n = 1 + Random.randInt(20);
+    for (var j = 0; j < n; j++) {
+        text.push(words[Random.randInt(words.length)]);
+    }
+    t.insert({_id: i, a: text.join(" "), b: i % 3});
+}
+t.ensureIndex({a: "text"});
+assert.eq(null, db.getLastError());
+
+function ids(query, limit) {
+    return t.find(query).limit(limit).toArray().map(function(doc) { return doc._id; });
+}
+
+[{$text: {$search: "apple"}},
+ {$text: {$search: "apple banana"}},
+ {$text: {$search: "cherry date elder fig"}},
+ {$text: {$search: "apple grape -banana"}},
+ {$text: {$search: "fig \"fig grape\""}},
+ {$text: {$search: "banana cherry"}, b: 1}].forEach(function(query) {
+    var all = ids(query, 5000);
+    [1, 5, 20, 100].forEach(function(limit) {
+        assert.eq(all.slice(0, limit), ids(query, limit), tojson(query) + " limit " + limit);
+    });
+});
@@ -0,0 +1,67 @@
+// Test that $near on a 2dsphere index with the new query framework returns every document in
+// order of distance, including shapes spanning several of the annuli it searches.
+
+var t = db.geo_s2near_annuli;
+t.drop();
+
+db.adminCommand({setParameter: 1, newQueryFrameworkEnabled: true});
+
+var origin = {type: "Point", coordinates: [0, 0]};
+
+// Rings of points at growing distances, and a few lines and polygons that overlap them.
+var n = 0;
+for (var r = 1; r <= 40; r++) {
+    for (var a = 0; a < 360; a += 30) {
+        var lng = r * 0.01 * Math.cos(a * Math.PI / 180);
+        var lat = r * 0.01 * Math.sin(a * Math.PI / 180);
+        t.insert({_id: n++, geo: {type: "Point", coordinates: [lng, lat]}});
+    }
+}
+t.insert({_id: n++, geo: {type: "LineString", coordinates: [[0.05, 0.05], [0.3, 0.3]]}});
+t.insert({_id: n++, geo: {type: "Polygon",
+                          coordinates: [[[0.1, -0.1], [0.35, -0.1], [0.35, -0.2], [0.1, -0.1]]]}});
+t.insert({_id: n++, geo: {type: "Polygon",
+                          coordinates: [[[-0.2, -0.2], [0.2, -0.2], [0.2, 0.2], [-0.2, 0.2],
+                                         [-0.2, -0.2]]]}});
+t.ensureIndex({geo: "2dsphere"});
+assert.eq(null, db.getLastError());
+
+function near(limit, maxDistance) {
+    var query = {$near: {$geometry: origin}};
+    if (maxDistance) {
+        query.$near.$maxDistance = maxDistance;
+    }
+    return t.find({geo: query}).limit(limit).toArray();
+}
+
+var all = near(n + 10);
+assert.eq(n, all.length);
+
+// Each point comes after the ones closer to the origin.
+var last = 0;
+all.forEach(function(doc) {
+    if (doc.geo.type != "Point") {
+        return;
+    }
+    var c = doc.geo.coordinates;
+    var d = Math.sqrt(c[0] * c[0] + c[1] * c[1]);
+    assert.lte(last, d + 1e-9, tojson(doc));
+    last = d;
+});
+
+// The polygon around the origin is at distance 0.
+assert.eq(n - 1, all[0]._id);
+
+// Smaller limits return a prefix of the same order.
+[1, 10, 100].forEach(function(limit) {
+    var some = near(limit);
+    assert.eq(limit, some.length);
+    for (var i = 0; i < limit; i++) {
+        assert.eq(all[i]._id, some[i]._id);
+    }
+});
+
+// The inner eleven rings, the line and the polygon around the origin.
+assert.eq(12 * 11 + 2, near(n, 0.115 * 111195).length);
+
+db.adminCommand({setParameter: 1, newQueryFrameworkEnabled: false});
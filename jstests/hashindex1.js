@@ -1,8 +1,8 @@
 var t = db.hashindex1;
 t.drop()
 
-//test non-single field hashed indexes don't get created (maybe change later)
-var badspec = {a : "hashed" , b : 1};
+//test hashed indexes whose hashed field isn't first don't get created
+var badspec = {a : 1 , b : "hashed"};
 t.ensureIndex( badspec );
 assert.eq( t.getIndexes().length , 1 , "only _id index should be created");
 
@@ -0,0 +1,51 @@
+// Hashed indexes may be followed by ascending or descending fields, which keep their order within
+// each hashed value so that ranges over them are scanned rather than searched for.
+
+var t = db.jstests_hashindex_compound;
+t.drop();
+
+// Only the first field may be hashed, the rest must be ascending or descending.
+t.ensureIndex( { device: "hashed", ts: "hashed" } );
+assert( db.getLastError() );
+t.ensureIndex( { device: "hashed", ts: 2 } );
+assert( db.getLastError() );
+t.ensureIndex( { device: "hashed", ts: 1 }, { unique: true } );
+assert( db.getLastError() );
+assert.eq( 1, t.getIndexes().length );
+
+var spec = { device: "hashed", ts: 1 };
+t.ensureIndex( spec );
+assert( !db.getLastError() );
+assert.eq( 2, t.getIndexes().length );
+
+for ( var d = 0; d < 10; ++d ) {
+    for ( var ts = 0; ts < 100; ++ts ) {
+        t.insert( { device: d, ts: ts } );
+    }
+}
+t.insert( { device: 3 } );
+assert( !db.getLastError() );
+
+// A range within one hashed value only scans that range.
+var cursor = t.find( { device: 3, ts: { $gte: 10, $lt: 20 } } ).hint( spec );
+assert.eq( 10, cursor.itcount() );
+var explain = t.find( { device: 3, ts: { $gte: 10, $lt: 20 } } ).hint( spec ).explain();
+assert.eq( 10, explain.n );
+assert.gte( 20, explain.nscanned );
+
+assert.eq( 100, t.find( { device: 7, ts: { $gte: 0 } } ).hint( spec ).itcount() );
+assert.eq( 20, t.find( { device: { $in: [ 1, 2 ] }, ts: { $lt: 10 } } ).hint( spec ).itcount() );
+assert.eq( 101, t.find( { device: 3 } ).hint( spec ).itcount() );
+assert.eq( 1, t.find( { device: 3, ts: null } ).hint( spec ).itcount() );
+assert.eq( 0, t.find( { device: 11, ts: 5 } ).hint( spec ).itcount() );
+
+// Descending fields work the same way.
+t.ensureIndex( { device: "hashed", ts: -1 } );
+assert( !db.getLastError() );
+assert.eq( 10, t.find( { device: 3, ts: { $gt: 89 } } ).hint( { device: "hashed", ts: -1 } )
+                .itcount() );
+
+// Like the hashed field, the others can't hold arrays.
+t.insert( { device: 1, ts: [ 1, 2 ] } );
+assert( db.getLastError() );
+assert( t.validate( true ).valid );
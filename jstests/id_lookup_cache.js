@@ -0,0 +1,53 @@
+// Collections with idLookupCache set remember where documents are by _id.  Lookups must still
+// see inserts, removes and documents moved by updates or compaction.
+
+var t = db.jstests_id_lookup_cache;
+t.drop();
+
+db.createCollection( t.getName() );
+var res = db.runCommand( { collMod: t.getName(), idLookupCache: true } );
+assert.commandWorked( res );
+assert.eq( false, res.idLookupCache_old );
+assert.eq( true, res.idLookupCache_new );
+
+for ( var i = 0; i < 1000; ++i ) {
+    t.insert( { _id: i, n: i } );
+}
+assert( !db.getLastError() );
+
+// Look each up twice, the second time from the cache.
+for ( var i = 0; i < 1000; i += 7 ) {
+    assert.eq( i, t.findOne( { _id: i } ).n );
+    assert.eq( i, t.findOne( { _id: i } ).n );
+}
+assert.isnull( t.findOne( { _id: 5000 } ) );
+
+// Growing documents moves them.
+var big = new Array( 2000 ).toString();
+for ( var i = 0; i < 1000; i += 7 ) {
+    t.update( { _id: i }, { $set: { big: big } } );
+}
+assert( !db.getLastError() );
+for ( var i = 0; i < 1000; i += 7 ) {
+    var doc = t.findOne( { _id: i } );
+    assert.eq( i, doc.n );
+    assert.eq( big, doc.big );
+}
+
+// Removed documents aren't found, and reinserted ones are found where they now are.
+t.remove( { _id: 14 } );
+assert.isnull( t.findOne( { _id: 14 } ) );
+t.insert( { _id: 14, n: "again" } );
+assert.eq( "again", t.findOne( { _id: 14 } ).n );
+
+// Compaction moves everything.
+t.remove( { _id: { $lt: 500 } } );
+assert.commandWorked( t.runCommand( "compact" ) );
+assert.isnull( t.findOne( { _id: 21 } ) );
+for ( var i = 500; i < 1000; i += 3 ) {
+    assert.eq( i, t.findOne( { _id: i } ).n );
+}
+
+assert.commandWorked( db.runCommand( { collMod: t.getName(), idLookupCache: false } ) );
+assert.eq( 700, t.findOne( { _id: 700 } ).n );
+t.drop();
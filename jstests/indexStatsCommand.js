@@ -86,3 +86,51 @@ function textWithIndexVersion(version) {
 }
 
 [0, 1].map(textWithIndexVersion);
+
+// Geo indexes also count their keys per cell of the plane.
+function testGeoBuckets() {
+    var g = db.jstests_commands_geo;
+    g.drop();
+    // Four points in one corner of the world for each one elsewhere.
+    for (var i = 0; i < 1000; ++i) {
+        var crowded = i % 5 != 0;
+        g.insert({loc: crowded ? [-170 + i % 7, -80 + i % 3] : [(i % 300) - 150, (i % 150) - 75],
+                  type: i % 2 ? "a" : "b"});
+    }
+
+    g.ensureIndex({loc: "2d"}, {name: "loc_2d"});
+    var result = g.indexStats({index: "loc_2d"});
+    if (result["bad cmd"]) {
+        return;
+    }
+    assert.commandWorked(result);
+    assert.eq(4, result.geoBuckets.bits);
+    assert.lt(1, result.geoBuckets.numBuckets);
+    assert.eq(800, result.geoBuckets.densest[0].keys, tojson(result.geoBuckets));
+    assert.eq(8, result.geoBuckets.densest[0].bucket.length);
+
+    result = g.indexStats({index: "loc_2d", geoBits: 1});
+    assert.commandWorked(result);
+    assert.eq(1, result.geoBuckets.bits);
+    assert.gte(4, result.geoBuckets.numBuckets);
+
+    result = g.indexStats({index: "loc_2d", geoBits: 40});
+    assert.commandFailed(result);
+    assert(result.errmsg.match(/geoBits/));
+
+    g.ensureIndex({loc: "geoHaystack", type: 1}, {name: "loc_haystack", bucketSize: 1});
+    result = g.indexStats({index: "loc_haystack"});
+    assert.commandWorked(result);
+    assert.eq(undefined, result.geoBuckets.bits);
+    assert.lt(1, result.geoBuckets.numBuckets);
+    assert.gte(10, result.geoBuckets.densest.length);
+
+    // Other indexes have no geo counts.
+    result = g.indexStats({index: "_id_"});
+    assert.commandWorked(result);
+    assert.eq(undefined, result.geoBuckets);
+
+    g.drop();
+}
+
+testGeoBuckets();
@@ -0,0 +1,46 @@
+// Queries over two separately indexed fields may be answered by intersecting the results of two
+// index scans.  Whichever plan wins, the results must be the same as without the indices.
+
+var t = db.jstests_index_intersection;
+t.drop();
+
+for (var i = 0; i < 500; ++i) {
+    t.save({a: i % 10, b: i % 7, c: i});
+}
+
+var queries = [
+    {a: 3, b: 4},
+    {a: {$gt: 7}, b: 2},
+    {a: {$lt: 2}, b: {$gte: 5}},
+    {a: {$in: [1, 2]}, b: 0, c: {$lt: 250}},
+    {a: 42, b: 1}
+];
+
+var expected = [];
+queries.forEach(function(q) {
+    expected.push(t.find(q).sort({c: 1}).toArray());
+});
+
+t.ensureIndex({a: 1});
+t.ensureIndex({b: 1});
+
+for (var i = 0; i < queries.length; ++i) {
+    // Run each query a few times so that both fresh and cached plans are exercised.
+    for (var run = 0; run < 3; ++run) {
+        assert.eq(expected[i], t.find(queries[i]).sort({c: 1}).toArray(), tojson(queries[i]));
+    }
+}
+
+// Deletes during the scan mustn't produce removed documents.
+var res = t.find({a: 3, b: 4}).batchSize(2);
+assert(res.hasNext());
+res.next();
+t.remove({a: 3, b: 4, c: {$gt: 100}});
+var count = 1;
+while (res.hasNext()) {
+    var doc = res.next();
+    assert.eq(3, doc.a);
+    assert.eq(4, doc.b);
+    ++count;
+}
+assert.lte(count, expected[0].length);
@@ -0,0 +1,69 @@
+// Partial indexes only hold the documents matching their partialFilterExpression, and are only
+// used by queries that imply that filter.
+
+var t = db.jstests_index_partial;
+t.drop();
+
+t.ensureIndex( { a: 1 }, { partialFilterExpression: { status: "open" } } );
+assert( !db.getLastError() );
+
+for ( var i = 0; i < 100; ++i ) {
+    t.insert( { _id: i, a: i % 10, status: ( i % 4 == 0 ) ? "open" : "closed" } );
+}
+assert( !db.getLastError() );
+
+// Only the open documents are indexed.
+var res = t.validate( true );
+assert( res.valid );
+assert.eq( 25, res.keysPerIndex[ t.getFullName() + ".$a_1" ] );
+
+// Queries implying the filter use the index and see every match.
+assert.eq( 5, t.find( { status: "open", a: 4 } ).itcount() );
+assert.eq( 5, t.find( { status: "open", a: 4 } ).hint( { a: 1 } ).itcount() );
+assert.eq( "BtreeCursor a_1", t.find( { status: "open", a: 4 } ).explain().cursor );
+assert.eq( 10, t.find( { status: "open", a: { $gte: 4, $lte: 6 } } ).itcount() );
+
+// Queries that don't imply it can't use the index.
+assert.eq( 10, t.find( { a: 4 } ).itcount() );
+assert.eq( "BasicCursor", t.find( { a: 4 } ).explain().cursor );
+assert.eq( "BasicCursor", t.find( { status: "closed", a: 4 } ).explain().cursor );
+assert.eq( 5, t.find( { status: "closed", a: 4 } ).itcount() );
+
+// Updates move documents in and out of the index.
+t.update( { _id: 1 }, { $set: { status: "open" } } );
+t.update( { _id: 4 }, { $set: { status: "closed" } } );
+t.update( { _id: 8 }, { $set: { a: 4 } } );
+assert( !db.getLastError() );
+assert.eq( [ 8, 24, 44, 64, 84 ],
+           t.find( { status: "open", a: 4 } ).sort( { _id: 1 } ).map( function( d ) {
+               return d._id; } ) );
+assert.eq( 1, t.find( { status: "open", a: 1 } ).hint( { a: 1 } ).itcount() );
+
+t.remove( { _id: { $lt: 50 } } );
+assert.eq( 2, t.find( { status: "open", a: 4 } ).hint( { a: 1 } ).itcount() );
+assert( t.validate( true ).valid );
+
+// An index built over existing documents only takes those matching.
+t.ensureIndex( { a: 1, _id: 1 }, { partialFilterExpression: { a: { $gt: 5 } } } );
+assert( !db.getLastError() );
+res = t.validate( true );
+assert.eq( 20, res.keysPerIndex[ t.getFullName() + ".$a_1__id_1" ] );
+assert.eq( 10, t.find( { a: { $gt: 7 } } ).hint( { a: 1, _id: 1 } ).itcount() );
+
+// Filters must be simple conjunctions, and the _id index can't be partial.
+t.ensureIndex( { b: 1 }, { partialFilterExpression: 5 } );
+assert( db.getLastError() );
+t.ensureIndex( { b: 1 }, { partialFilterExpression: { $or: [ { a: 1 }, { a: 2 } ] } } );
+assert( db.getLastError() );
+t.ensureIndex( { b: 1 }, { partialFilterExpression: { a: { $in: [ 1, 2 ] } } } );
+assert( db.getLastError() );
+t.ensureIndex( { b: 1 }, { partialFilterExpression: { a: { $gt: 1 }, b: { $exists: true } } } );
+assert( !db.getLastError() );
+assert.eq( 4, t.getIndexes().length );
+
+var u = db.jstests_index_partial_id;
+u.drop();
+db.createCollection( u.getName(), { autoIndexId: false } );
+u.ensureIndex( { _id: 1 }, { partialFilterExpression: { a: 1 } } );
+assert( db.getLastError() );
+u.drop();
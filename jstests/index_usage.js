@@ -0,0 +1,59 @@
+// The indexUsage command and serverStatus section report how each index has been used, so that
+// unused ones can be found.
+
+var t = db.jstests_index_usage;
+t.drop();
+
+t.ensureIndex( { a: 1 } );
+t.ensureIndex( { b: 1 } );
+t.ensureIndex( { c: 1 } );
+for ( var i = 0; i < 100; ++i ) {
+    t.insert( { a: i, b: i % 10, c: i } );
+}
+assert( !db.getLastError() );
+
+var usage = function( name ) {
+    var res = t.runCommand( "indexUsage" );
+    assert.commandWorked( res );
+    for ( var i = 0; i < res.indexes.length; ++i ) {
+        if ( res.indexes[ i ].name == name ) {
+            return res.indexes[ i ];
+        }
+    }
+    assert( false, "no index " + name );
+};
+
+assert.eq( 4, t.runCommand( "indexUsage" ).indexes.length );
+assert.eq( 0, usage( "a_1" ).ops );
+assert.eq( null, usage( "a_1" ).lastUsed );
+
+for ( var i = 0; i < 3; ++i ) {
+    assert.eq( 11, t.find( { a: { $gte: 20, $lte: 30 } } ).itcount() );
+}
+var a = usage( "a_1" );
+assert.eq( 3, a.ops );
+assert.lte( 33, a.keysExamined );
+assert( a.lastUsed instanceof Date );
+
+// Plan ranking counts a win for the index the chosen plan uses.
+assert.eq( 1, t.find( { a: 5, b: 5 } ).itcount() );
+assert.eq( 1, usage( "a_1" ).planWins + usage( "b_1" ).planWins );
+
+// Untouched indexes stay at zero.
+var c = usage( "c_1" );
+assert.eq( 0, c.ops );
+assert.eq( 0, c.keysExamined );
+assert.eq( 0, c.planWins );
+
+// serverStatus lists every index that has been used.
+var ss = db.serverStatus( { indexUsage: 1 } ).indexUsage;
+assert.eq( usage( "a_1" ).ops, ss[ t.getFullName() + ".$a_1" ].ops );
+assert.eq( undefined, ss[ t.getFullName() + ".$c_1" ] );
+assert.eq( undefined, db.serverStatus().indexUsage );
+
+// Dropping an index forgets its usage.
+t.dropIndex( { a: 1 } );
+t.ensureIndex( { a: 1 } );
+assert.eq( 0, usage( "a_1" ).ops );
+
+assert.commandFailed( db.runCommand( { indexUsage: "jstests_index_usage_missing" } ) );
@@ -0,0 +1,47 @@
+// Background builds of non unique indexes bulk load the btree, then replay the writes made while
+// they ran.
+
+var t = db.jstests_indexbg_bulk_load;
+t.drop();
+
+for ( var i = 0; i < 50000; ++i ) {
+    t.insert( { _id: i, a: i % 1000, b: [ i, -i ] } );
+}
+assert( !db.getLastError() );
+
+// Start the build from another connection and write to the collection while it runs.
+var other = new Mongo( db.getMongo().host ).getDB( db.getName() );
+other.system.indexes.insert( { ns: t.getFullName(), key: { a: 1 }, name: "a_1",
+                               background: true } );
+
+for ( var i = 0; i < 5000; ++i ) {
+    t.insert( { _id: 50000 + i, a: 5000 + i } );
+    t.update( { _id: i * 7 }, { $set: { a: -1 } } );
+    t.remove( { _id: i * 7 + 1 } );
+}
+assert( !db.getLastError() );
+assert( !other.getLastError() );
+
+assert.soon( function() { return t.getIndexes().length == 2; } );
+assert.soon( function() {
+    return db.currentOp( { ns: t.getFullName(), "msg": /Index/ } ).inprog.length == 0;
+} );
+
+// The index agrees with a collection scan.
+assert.eq( t.count(), t.find().hint( { a: 1 } ).itcount() );
+assert.eq( 5000, t.find( { a: -1 } ).hint( { a: 1 } ).itcount() );
+assert.eq( t.find( { a: 3 } ).itcount(), t.find( { a: 3 } ).hint( { a: 1 } ).itcount() );
+assert.eq( 1, t.find( { a: 9999 } ).hint( { a: 1 } ).itcount() );
+assert( t.validate( true ).valid );
+
+// Multikey indexes are built the same way.
+t.ensureIndex( { b: 1 }, { background: true } );
+assert( !db.getLastError() );
+assert( t.find( { b: 5 } ).hint( { b: 1 } ).explain().isMultiKey );
+assert.eq( 1, t.find( { b: -5 } ).hint( { b: 1 } ).itcount() );
+
+// Unique indexes still reject duplicates as they're found.
+t.ensureIndex( { a: 1, _id: 1 }, { background: true, unique: true } );
+assert( !db.getLastError() );
+t.ensureIndex( { a: -1 }, { background: true, unique: true } );
+assert( db.getLastError() );
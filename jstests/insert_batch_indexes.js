@@ -0,0 +1,57 @@
+// Batch inserts put the keys of indexes allowing duplicates in after the batch, in index order.
+// The indexes must end up the same as if each document had been indexed as it was inserted.
+
+var t = db.jstests_insert_batch_indexes;
+t.drop();
+
+t.ensureIndex( { a : 1 } );
+t.ensureIndex( { b : -1 } );
+t.ensureIndex( { a : 1 , b : 1 } );
+t.ensureIndex( { c : 1 } );
+t.ensureIndex( { d : "hashed" } );
+t.ensureIndex( { u : 1 } , { unique : true } );
+
+var batch = [];
+for ( var i = 0; i < 5000; ++i ) {
+    batch.push( { _id : i , a : i % 97 , b : -i , c : [ i , i + 1 ] , d : "d" + ( i % 13 ) ,
+                  u : i } );
+}
+t.insert( batch );
+assert( !db.getLastError() );
+
+function check( n ) {
+    assert.eq( n , t.count() );
+    assert.eq( n , t.find().hint( { a : 1 } ).itcount() );
+    assert.eq( n , t.find().hint( { b : -1 } ).itcount() );
+    assert.eq( n , t.find().hint( { a : 1 , b : 1 } ).itcount() );
+    assert.eq( n , t.find().hint( { u : 1 } ).itcount() );
+    assert.eq( t.find( { a : 5 } ).itcount() , t.find( { a : 5 } ).hint( { a : 1 } ).itcount() );
+    assert.eq( t.find( { d : "d3" } ).itcount() ,
+               t.find( { d : "d3" } ).hint( { d : "hashed" } ).itcount() );
+    assert( t.validate( true ).valid );
+}
+check( 5000 );
+
+// Arrays in a batch make the index multikey.
+assert( t.find( { c : 7 } ).hint( { c : 1 } ).explain().isMultiKey );
+assert.eq( 2 , t.find( { c : 7 } ).hint( { c : 1 } ).itcount() );
+
+// Documents failing a unique index in the middle of a batch leave no keys behind in the
+// others, whether the batch stops there or keeps going.
+batch = [];
+for ( var i = 5000; i < 6000; ++i ) {
+    batch.push( { _id : i , a : i % 97 , b : -i , u : ( i == 5500 ) ? 7 : i } );
+}
+t.insert( batch );
+assert( db.getLastError() );
+check( 5500 );
+
+batch = [];
+for ( var i = 5500; i < 7000; ++i ) {
+    batch.push( { _id : i , a : i % 97 , b : -i , u : ( i % 100 == 0 ) ? 7 : i } );
+}
+t.insert( batch , true /* continueOnError */ );
+assert( db.getLastError() );
+check( 5500 + 1500 - 15 );
+assert.eq( 0 , t.find( { b : -5600 } ).hint( { b : -1 } ).itcount() );
+assert.eq( 1 , t.find( { b : -5601 } ).hint( { b : -1 } ).itcount() );
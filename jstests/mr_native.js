@@ -0,0 +1,75 @@
+// Map and reduce functions of the simplest shapes run without JS, with the same results as JS.
+
+t = db.mr_native;
+t.drop();
+
+for ( i = 0; i < 1000; i++ ) {
+    t.insert( { _id : i , k : i % 7 , s : "k" + ( i % 3 ) , x : i / 4 , n : NumberInt( i % 5 ) } );
+}
+// fields that the native map leaves to JS
+t.insert( { _id : 1000 , s : "k0" , x : 1 } );
+t.insert( { _id : 1001 , k : 1 , s : { a : 1 } , x : "str" } );
+
+function setNative( on ) {
+    assert.commandWorked( db.adminCommand( { setParameter : 1 , mapReduceNativeFunctions : on } ) );
+}
+
+function run( map , reduce , options ) {
+    options = Object.extend( { out : { inline : 1 } , verbose : true } , options || {} );
+    var res = t.mapReduce( map , reduce , options );
+    assert.commandWorked( res );
+    return res;
+}
+
+function check( map , reduce , options ) {
+    setNative( false );
+    var js = run( map , reduce , options );
+    assert.neq( "native" , js.timing.mode );
+    setNative( true );
+    var nat = run( map , reduce , options );
+    assert.eq( "native" , nat.timing.mode , tojson( map ) );
+    assert.eq( js.results , nat.results , tojson( [ map , reduce ] ) );
+    assert.eq( js.counts.emit , nat.counts.emit );
+    return nat;
+}
+
+var sum = function( key , values ) { return Array.sum( values ); };
+var min = function( k , vs ) { return Math.min.apply( Math , vs ); };
+var max = function( k , vs ) {
+    return Math.max.apply(Math, vs)
+};
+
+var res = check( function() { emit( this.k , 1 ); } , sum );
+assert.eq( 8 , res.results.length ); // 7 values of k, and null for the document without it
+assert.eq( { _id : 3 , value : 143 } , res.results[ 4 ] );
+
+check( function(){ emit(this.s, this.x) } , sum );
+check( function() { emit( this.s , this.n ); } , min );
+check( function() { emit( this.k , this.x ); } , max );
+check( function() { emit( this.k , -0.5 ); } , sum , { query : { _id : { $lt : 500 } } } );
+check( function() { emit( this.k , this.x ); } , sum , { finalize : function( k , v ) { return v * 2; } } );
+
+// output collections go through the same reduce
+check( function() { emit( this.s , 1 ); } , sum , { out : "mr_native_out" } );
+res = run( function() { emit( this.s , 1 ); } , sum , { out : { reduce : "mr_native_out" } } );
+assert.eq( 2 * 334 + 2 , db.mr_native_out.findOne( { _id : "k0" } ).value );
+db.mr_native_out.drop();
+
+// anything else is left to JS
+[ function() { emit( this.k , 1 ); emit( this.k , 2 ); } ,
+  function() { emit( this.k , "1" ); } ,
+  function() { emit( this.s[ 0 ] , 1 ); } ,
+  function() { if ( this.k ) emit( this.k , 1 ); } ,
+  function( x ) { emit( this.k , 1 ); } ,
+].forEach( function( map ) {
+    assert.neq( "native" , run( map , sum ).timing.mode , tojson( map ) );
+} );
+assert.neq( "native" ,
+            run( function() { emit( this.k , z ); } , sum , { scope : { z : 1 } } ).timing.mode );
+
+// a JS reduce still works with the native map, and a native reduce with a JS map
+check( function() { emit( this.k , 1 ); } , function( k , vs ) { return vs.length; } );
+var s = run( function() { emit( this.k , 2 ); emit( this.k , 1 ); } , sum ).results;
+assert.eq( 3 * 143 , s[ 4 ].value );
+
+t.drop();
@@ -0,0 +1,38 @@
+// Documents passed to map functions convert back to BSON with changes made anywhere inside
+// them, and as they were when subobjects were only read
+
+t = db.mr_nested_writeback;
+t.drop();
+
+t.insert({_id : 1, a : {b : {c : 1, d : [1, 2]}, e : "x"}, f : 1});
+t.insert({_id : 2, a : {b : {c : 2, d : [3, 4]}, e : "y"}, f : 2});
+
+function run(map) {
+    var out = {};
+    t.mapReduce(map, function(k, vals) { return vals[0]; }, {out : {inline : 1}})
+     .results.forEach(function(r) { out[r._id] = r.value; });
+    return out;
+}
+
+// read only
+var res = run(function() { if (this.a.b.c > 0) emit(this._id, this); });
+assert.eq(t.findOne({_id : 1}), res[1]);
+assert.eq(t.findOne({_id : 2}), res[2]);
+
+// a change two levels down
+res = run(function() { this.a.b.c = 10; emit(this._id, this); });
+assert.eq(10, res[1].a.b.c);
+assert.eq("x", res[1].a.e);
+assert.eq([1, 2], res[1].a.b.d);
+
+// a deletion inside a subobject
+res = run(function() { delete this.a.b.c; emit(this._id, this); });
+assert.eq({d : [3, 4]}, res[2].a.b);
+
+// an array change
+res = run(function() { this.a.b.d.push(5); emit(this._id, this.a); });
+assert.eq([1, 2, 5], res[1].b.d);
+
+// a subobject emitted on its own outlives its document's conversion
+res = run(function() { emit(this._id, this.a.b); });
+assert.eq({c : 2, d : [3, 4]}, res[2]);
@@ -0,0 +1,60 @@
+// mapThreads maps on several threads, each with a scope of its own, with the same results.
+
+t = db.mr_threads;
+t.drop();
+
+for ( i = 0; i < 5000; i++ ) {
+    t.insert( { _id : i , k : i % 13 , tags : [ "a" + ( i % 3 ) , "b" + ( i % 5 ) ] } );
+}
+
+var map = function() {
+    for ( var i = 0; i < this.tags.length; i++ )
+        emit( this.tags[ i ] , { count : 1 , k : this.k } );
+};
+var reduce = function( key , values ) {
+    var res = { count : 0 , k : 0 };
+    values.forEach( function( v ) { res.count += v.count; res.k += v.k; } );
+    return res;
+};
+
+function run( options ) {
+    var res = t.mapReduce( map , reduce , Object.extend( { out : { inline : 1 } } , options ) );
+    assert.commandWorked( res );
+    return res;
+}
+
+var single = run( {} );
+var parallel = run( { mapThreads : 4 } );
+assert.eq( single.results , parallel.results );
+assert.eq( single.counts , parallel.counts );
+assert.eq( 8 , parallel.results.length );
+
+// with a query, a limit, a scope and an output collection
+var options = { query : { k : { $lt : 7 } } , limit : 2000 , sort : { _id : 1 } ,
+                scope : { unused : 1 } , out : "mr_threads_out" };
+run( options );
+var expected = db.mr_threads_out.find().sort( { _id : 1 } ).toArray();
+run( Object.extend( { mapThreads : 3 } , options ) );
+assert.eq( expected , db.mr_threads_out.find().sort( { _id : 1 } ).toArray() );
+db.mr_threads_out.drop();
+
+// errors in the map fail the command
+var res = db.runCommand( { mapReduce : t.getName() , map : function() { throw "boom"; } ,
+                           reduce : reduce , out : { inline : 1 } , mapThreads : 2 } );
+assert.commandFailed( res );
+res = db.runCommand( { mapReduce : t.getName() , map : function() { db.foo.findOne(); } ,
+                       reduce : reduce , out : { inline : 1 } , mapThreads : 2 } );
+assert.commandFailed( res );
+
+// bad options
+[ 0 , 65 , "2" ].forEach( function( n ) {
+    res = db.runCommand( { mapReduce : t.getName() , map : map , reduce : reduce ,
+                           out : { inline : 1 } , mapThreads : n } );
+    assert.commandFailed( res );
+    assert.eq( 17363 , res.code , tojson( n ) );
+} );
+res = db.runCommand( { mapReduce : t.getName() , map : map , reduce : reduce ,
+                       out : { inline : 1 } , mapThreads : 2 , jsMode : true } );
+assert.eq( 17364 , res.code );
+
+t.drop();
@@ -0,0 +1,31 @@
+// Namespaces on either side of dropped ones, in a database with many of them, are still found,
+// the dropped ones are not, and recreating them reuses their slots
+
+var d = db.getSisterDB("nsindex_holes");
+d.dropDatabase();
+
+var n = 1000;
+for (var i = 0; i < n; i++) {
+    d["c" + i].insert({i : i});
+}
+assert.eq(null, d.getLastError());
+
+for (var i = 0; i < n; i += 2) {
+    d["c" + i].drop();
+}
+
+for (var i = 0; i < n; i++) {
+    assert.eq(i % 2 ? 1 : 0, d["c" + i].find().itcount(), "c" + i);
+}
+assert.eq(n / 2 + 1, d.getCollectionNames().length); // and system.indexes
+
+for (var i = 0; i < n; i += 2) {
+    d["c" + i].insert({i : i});
+}
+assert.eq(null, d.getLastError());
+for (var i = 0; i < n; i++) {
+    assert.eq(i, d["c" + i].findOne().i);
+}
+assert.eq(n + 1, d.getCollectionNames().length);
+
+d.dropDatabase();
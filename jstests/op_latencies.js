@@ -0,0 +1,58 @@
+// The opLatencies serverStatus section keeps latency histograms per op type, and per namespace
+// when opLatencyPerNamespace is set.
+
+var t = db.jstests_op_latencies;
+t.drop();
+
+var latencies = function( config ) {
+    var res = db.serverStatus( { opLatencies: config || 1 } );
+    assert.commandWorked( res );
+    return res.opLatencies;
+}
+
+var before = latencies();
+[ "query", "getmore", "insert", "update", "delete", "command" ].forEach( function( type ) {
+    assert( before[ type ], type );
+    assert.eq( "number", typeof before[ type ].count, type );
+} );
+
+assert.commandWorked( db.adminCommand( { setParameter: 1, opLatencyPerNamespace: true } ) );
+for ( var i = 0; i < 100; ++i ) {
+    t.insert( { _id: i } );
+}
+t.update( { _id: 1 }, { $set: { a: 1 } } );
+t.remove( { _id: 2 } );
+assert.eq( 99, t.find().batchSize( 10 ).itcount() );
+assert( !db.getLastError() );
+
+var after = latencies( { namespaces: true } );
+assert.lte( before.insert.count + 100, after.insert.count );
+assert.lte( before.update.count + 1, after.update.count );
+assert.lte( before.delete.count + 1, after.delete.count );
+assert.lte( before.query.count + 1, after.query.count );
+assert.lte( before.getmore.count + 1, after.getmore.count );
+
+// Percentiles are bucket bounds that never decrease, and the buckets add up to the count.
+var check = function( histogram ) {
+    assert.lte( histogram.p50, histogram.p95 );
+    assert.lte( histogram.p95, histogram.p99 );
+    assert.lte( histogram.p99, histogram.p999 );
+    var sum = 0;
+    histogram.buckets.forEach( function( bucket ) { sum += bucket.count; } );
+    assert.eq( histogram.count, sum );
+}
+check( after.insert );
+
+var mine = after.namespaces[ t.getFullName() ];
+assert( mine, tojson( after.namespaces ) );
+assert.eq( 100, mine.insert.count );
+assert.eq( 1, mine.update.count );
+assert.eq( 1, mine.delete.count );
+check( mine.insert );
+
+// Namespaces only on request.
+assert.eq( undefined, latencies().namespaces );
+
+assert.commandWorked( db.adminCommand( { setParameter: 1, opLatencyPerNamespace: false } ) );
+t.insert( { _id: 1000 } );
+assert.eq( 100, latencies( { namespaces: true } ).namespaces[ t.getFullName() ].insert.count );
@@ -0,0 +1,37 @@
+// Read and write ticket pools limit concurrent user operations, and can be resized at runtime.
+
+var admin = db.getSisterDB( "admin" );
+
+var original = admin.runCommand( { getParameter: 1, concurrentReadOps: 1, concurrentWriteOps: 1 } );
+assert.commandWorked( original );
+assert.lt( 0, original.concurrentReadOps );
+assert.lt( 0, original.concurrentWriteOps );
+
+var tickets = db.serverStatus().opTickets;
+assert.eq( original.concurrentReadOps, tickets.read.totalTickets );
+assert.eq( original.concurrentWriteOps, tickets.write.totalTickets );
+assert.eq( tickets.read.totalTickets, tickets.read.out + tickets.read.available );
+
+try {
+    assert.commandWorked( admin.runCommand( { setParameter: 1, concurrentWriteOps: 2 } ) );
+    assert.eq( 2, db.serverStatus().opTickets.write.totalTickets );
+    assert.commandFailed( admin.runCommand( { setParameter: 1, concurrentWriteOps: 0 } ) );
+
+    // With few tickets, writes from several clients queue and all complete.
+    var t = db.jstests_op_tickets;
+    t.drop();
+    var writer = "for ( var i = 0; i < 500; ++i ) db.jstests_op_tickets.insert( { i: i } );" +
+                 "db.getLastError();";
+    var shells = [];
+    for ( var i = 0; i < 4; ++i ) {
+        shells.push( startParallelShell( writer ) );
+    }
+    for ( var i = 0; i < shells.length; ++i ) {
+        shells[ i ]();
+    }
+    assert.eq( 2000, t.count() );
+    t.drop();
+}
+finally {
+    admin.runCommand( { setParameter: 1, concurrentWriteOps: original.concurrentWriteOps } );
+}
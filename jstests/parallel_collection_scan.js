@@ -0,0 +1,53 @@
+// Tests for the parallelCollectionScan command.
+
+var t = db.jstests_parallel_collection_scan;
+t.drop();
+
+var s = "";
+while (s.length < 1000) {
+    s += ".";
+}
+for (var i = 0; i < 2000; ++i) {
+    t.insert({x: i, s: s});
+}
+
+function drainAll(numCursors) {
+    var res = db.runCommand({parallelCollectionScan: t.getName(), numCursors: numCursors});
+    assert.commandWorked(res);
+    assert.lte(res.cursors.length, numCursors);
+
+    var seen = {};
+    var count = 0;
+    res.cursors.forEach(function(cursorResult) {
+        assert(cursorResult.ok);
+        var cursor = new DBCommandCursor(db.getMongo(), cursorResult);
+        while (cursor.hasNext()) {
+            var x = cursor.next().x;
+            assert(!seen[x], "saw " + x + " twice");
+            seen[x] = true;
+            ++count;
+        }
+    });
+    return {numCursors: res.cursors.length, count: count};
+}
+
+// Every document is returned exactly once, however many cursors we ask for.
+[1, 2, 4, 50].forEach(function(n) {
+    assert.eq(2000, drainAll(n).count);
+});
+
+// A collection this size has enough extents to split.
+assert.lt(1, drainAll(4).numCursors);
+
+// Bad arguments.
+assert.commandFailed(db.runCommand({parallelCollectionScan: t.getName()}));
+assert.commandFailed(db.runCommand({parallelCollectionScan: t.getName(), numCursors: 0}));
+assert.commandFailed(db.runCommand({parallelCollectionScan: "jstests_parallel_nonexistent",
+                                    numCursors: 2}));
+
+// Capped collections aren't supported.
+var capped = db.jstests_parallel_collection_scan_capped;
+capped.drop();
+db.createCollection(capped.getName(), {capped: true, size: 4096});
+assert.commandFailed(db.runCommand({parallelCollectionScan: capped.getName(), numCursors: 2}));
+capped.drop();
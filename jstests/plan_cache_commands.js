@@ -0,0 +1,56 @@
+// Tests for the plan cache and the commands that list and clear it.
+
+var t = db.jstests_plan_cache_commands;
+t.drop();
+
+for (var i = 0; i < 200; ++i) {
+    t.save({a: i, b: i % 10});
+}
+t.ensureIndex({a: 1});
+t.ensureIndex({b: 1});
+
+function shapes() {
+    var res = db.runCommand({planCacheListQueryShapes: t.getName()});
+    assert.commandWorked(res);
+    return res.shapes;
+}
+
+// Nothing has been raced yet.
+assert.eq(0, shapes().length);
+
+// Two candidate indices: the winner is cached under the query's shape.
+assert.eq(1, t.find({a: 5, b: 5}).itcount());
+assert.eq(1, shapes().length);
+
+// Another query of the same shape reuses the entry rather than adding one.
+assert.eq(0, t.find({a: 6, b: 5}).itcount());
+assert.eq(1, shapes().length);
+
+// A different shape gets its own entry.
+assert.eq(20, t.find({a: {$gt: 100}, b: {$lt: 2}}).itcount());
+assert.eq(2, shapes().length);
+
+// Hinted queries aren't cached.
+assert.eq(0, t.find({a: 7, b: 1}).hint({a: 1}).sort({b: 1}).itcount());
+assert.eq(2, shapes().length);
+
+// planCacheClear drops every entry.
+var res = db.runCommand({planCacheClear: t.getName()});
+assert.commandWorked(res);
+assert.eq(2, res.removed);
+assert.eq(0, shapes().length);
+
+// Creating or dropping an index clears the cache.
+t.find({a: 5, b: 5}).itcount();
+assert.eq(1, shapes().length);
+t.ensureIndex({a: 1, b: 1});
+assert.eq(0, shapes().length);
+
+t.find({a: 5, b: 5}).itcount();
+assert.eq(1, shapes().length);
+t.dropIndex({a: 1, b: 1});
+assert.eq(0, shapes().length);
+
+// Both commands fail on a collection that doesn't exist.
+assert.commandFailed(db.runCommand({planCacheListQueryShapes: "jstests_plan_cache_nonexistent"}));
+assert.commandFailed(db.runCommand({planCacheClear: "jstests_plan_cache_nonexistent"}));
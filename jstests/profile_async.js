@@ -0,0 +1,31 @@
+// Tests that with profileAsync set, profile entries still reach system.profile once the
+// background writer gets to them, and that the dropped count is reported
+
+var testDB = db.getSisterDB("profile_async");
+testDB.dropDatabase();
+var coll = testDB.foo;
+coll.insert({x : 1});
+assert.eq(null, testDB.getLastError());
+
+assert.commandWorked(db.adminCommand({setParameter : 1, profileAsync : true}));
+try {
+    testDB.setProfilingLevel(2);
+    for (var i = 0; i < 50; i++) {
+        coll.find({x : i}).itcount();
+    }
+    testDB.setProfilingLevel(0);
+
+    assert.soon(function() {
+        return testDB.system.profile.find({op : "query", ns : coll.getFullName()}).itcount() == 50;
+    }, "profile entries were never written");
+
+    var metrics = db.serverStatus().metrics;
+    assert(metrics.profiler, tojson(metrics));
+    assert.eq(0, metrics.profiler.dropped);
+}
+finally {
+    testDB.setProfilingLevel(0);
+    db.adminCommand({setParameter : 1, profileAsync : false});
+}
+
+testDB.dropDatabase();
@@ -0,0 +1,59 @@
+// Operations report the locks they acquired, by mode and namespace, in currentOp and the profiler.
+
+// special db so that it can be run in parallel tests
+var stddb = db;
+var db = db.getSisterDB( "profile_lock_acquisitions" );
+
+var t = db.jstests_profile_lock_acquisitions;
+t.drop();
+for ( var i = 0; i < 100; ++i ) {
+    t.insert( { _id: i } );
+}
+assert( !db.getLastError() );
+
+function acquisitionsFor( entry, mode, ns ) {
+    assert( entry.lockAcquisitions, tojson( entry ) );
+    return entry.lockAcquisitions.filter( function( a ) {
+        return a.mode == mode && a.ns == ns;
+    } );
+}
+
+try {
+    db.setProfilingLevel( 0 );
+    db.system.profile.drop();
+    db.setProfilingLevel( 2 );
+
+    t.find( { _id: { $gte: 50 } } ).itcount();
+    t.update( { _id: 3 }, { $set: { a: 1 } } );
+    db.getLastError();
+
+    db.setProfilingLevel( 0 );
+
+    var query = db.system.profile.findOne( { op: "query", ns: t.getFullName() } );
+    var reads = acquisitionsFor( query, "r", db.getName() );
+    assert.eq( 1, reads.length, tojson( query ) );
+    assert.lte( 1, reads[ 0 ].count );
+    assert.lte( 0, reads[ 0 ].waitMicros );
+    assert.lte( reads[ 0 ].maxWaitMicros, reads[ 0 ].waitMicros );
+
+    var update = db.system.profile.findOne( { op: "update", ns: t.getFullName() } );
+    assert.lte( 1, update.lockAcquisitions.length, tojson( update ) );
+    assert.eq( "w", update.lockAcquisitions[ 0 ].mode );
+
+    // A running operation shows its acquisitions too, reacquisitions after yields included.
+    var s = startParallelShell( "db.getSisterDB( 'profile_lock_acquisitions' )." +
+                                "jstests_profile_lock_acquisitions.find( { $where: " +
+                                "function() { sleep( 30 ); return true; } } ).itcount();" );
+    var op;
+    assert.soon( function() {
+        var inprog = db.currentOp( { ns: t.getFullName(), op: "query" } ).inprog;
+        op = inprog.length ? inprog[ 0 ] : null;
+        return op && op.lockAcquisitions.length > 0;
+    } );
+    assert.eq( "r", op.lockAcquisitions[ 0 ].mode, tojson( op ) );
+    s();
+}
+finally {
+    db.setProfilingLevel( 0 );
+    db = stddb;
+}
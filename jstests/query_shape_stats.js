@@ -0,0 +1,60 @@
+// queryShapeStats aggregates the executions of queries by namespace and shape.
+
+var t = db.jstests_query_shape_stats;
+t.drop();
+
+db.adminCommand( { setParameter: 1, newQueryFrameworkEnabled: true } );
+
+for ( var i = 0; i < 100; ++i ) {
+    t.insert( { _id: i, a: i % 10, b: i } );
+}
+t.ensureIndex( { a: 1 } );
+assert( !db.getLastError() );
+
+assert.commandWorked( db.adminCommand( { queryShapeStats: 1, reset: true } ) );
+
+var shapesOf = function( sortBy ) {
+    var res = db.adminCommand( { queryShapeStats: 1, sortBy: sortBy, limit: 100 } );
+    assert.commandWorked( res );
+    return res.shapes.filter( function( s ) { return s.ns == t.getFullName(); } );
+}
+
+// Queries differing only in the values they compare share a shape.
+for ( var i = 0; i < 10; ++i ) {
+    assert.eq( 10, t.find( { a: i } ).itcount() );
+}
+assert.eq( 1, t.find( { b: 5 } ).itcount() );
+assert.eq( 1, t.find( { b: 7 } ).itcount() );
+assert.eq( 10, t.find( { a: 3 } ).sort( { b: 1 } ).itcount() );
+
+var shapes = shapesOf( "count" );
+assert.eq( 3, shapes.length, tojson( shapes ) );
+assert.eq( 10, shapes[ 0 ].count );
+assert.eq( 100, shapes[ 0 ].nReturned );
+assert.eq( 100, shapes[ 0 ].docsExamined );
+assert.eq( { a: 1 }, shapes[ 0 ].example.filter );
+assert( /a_1/.test( shapes[ 0 ].plan ), shapes[ 0 ].plan );
+assert.lte( shapes[ 0 ].maxMicros, shapes[ 0 ].totalMicros );
+
+// The collection scans look at every document.
+shapes = shapesOf( "docsExamined" );
+assert.eq( 200, shapes[ 0 ].docsExamined );
+assert.eq( 2, shapes[ 0 ].count );
+assert.eq( "BasicCursor", shapes[ 0 ].plan );
+assert.eq( 0, shapes[ 0 ].keysExamined );
+
+assert.commandFailed( db.adminCommand( { queryShapeStats: 1, sortBy: "nope" } ) );
+
+res = db.adminCommand( { queryShapeStats: 1, limit: 1 } );
+assert.commandWorked( res );
+assert.eq( 1, res.shapes.length );
+
+// 0 turns the statistics off.
+assert.commandWorked( db.adminCommand( { queryShapeStats: 1, reset: true } ) );
+var old = db.adminCommand( { getParameter: 1, internalQueryShapeStatsSize: 1 } );
+assert.commandWorked( db.adminCommand( { setParameter: 1, internalQueryShapeStatsSize: 0 } ) );
+t.find( { a: 1 } ).itcount();
+assert.eq( 0, shapesOf( "count" ).length );
+assert.commandWorked( db.adminCommand( { setParameter: 1,
+                                         internalQueryShapeStatsSize:
+                                             old.internalQueryShapeStatsSize } ) );
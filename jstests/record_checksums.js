@@ -0,0 +1,40 @@
+// Collections with recordChecksums set keep a checksum after each document, which full validation
+// and the background scrubber check.
+
+var t = db.jstests_record_checksums;
+t.drop();
+
+db.createCollection( t.getName() );
+var res = db.runCommand( { collMod: t.getName(), recordChecksums: true } );
+assert.commandWorked( res );
+assert.eq( false, res.recordChecksums_old );
+assert.eq( true, res.recordChecksums_new );
+
+for ( var i = 0; i < 300; ++i ) {
+    t.insert( { _id: i, n: 0, s: "abc" + i } );
+}
+// Updates applied in place, ones that grow the document, and ones that move it.
+t.update( {}, { $inc: { n: 1 } }, false, true );
+t.update( { _id: 7 }, { $set: { s: "a longer string than before" } } );
+t.update( { _id: 8 }, { $set: { big: new Array( 2000 ).toString() } } );
+assert( !db.getLastError() );
+assert.eq( 300, t.find( { n: 1 } ).itcount() );
+
+res = t.validate( true );
+assert( res.valid, tojson( res ) );
+assert.eq( 0, res.badChecksums );
+
+// The scrubber gets through the collection without finding anything wrong.
+var scrub = function() {
+    return db.serverStatus().metrics.record.scrub;
+}
+var before = scrub();
+assert.commandWorked( db.adminCommand( { setParameter: 1, recordScrubExtentsPerSecond: 100 } ) );
+assert.soon( function() { return scrub().extents > before.extents; } );
+assert.eq( before.checksumFailures, scrub().checksumFailures );
+assert.commandWorked( db.adminCommand( { setParameter: 1, recordScrubExtentsPerSecond: 0 } ) );
+
+// Turning checksums off clears them as documents are rewritten.
+assert.commandWorked( db.runCommand( { collMod: t.getName(), recordChecksums: false } ) );
+t.update( {}, { $inc: { n: 1 } }, false, true );
+assert( t.validate( true ).valid );
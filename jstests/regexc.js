@@ -0,0 +1,44 @@
+// Case-insensitive prefix regexes are answered from index bounds spelling out the cases of the
+// prefix, and return the same documents as without an index.
+
+t = db.jstests_regexc;
+t.drop();
+u = db.jstests_regexc_noindex;
+u.drop();
+
+var names = [ "abc", "ABC", "aBc", "abcdef", "ABCDEF", "abd", "ab", "xabc", "Abc1", "ab.c",
+              "éabc", "Éabc", "kelvin", "KELVIN", "longprefixname", "LONGPREFIXNAME",
+              "LongPrefixName2", "longprefixnamf" ];
+names.forEach( function( name ) {
+    t.save( { name:name } );
+    u.save( { name:name } );
+} );
+t.save( { name:5 } );
+u.save( { name:5 } );
+t.ensureIndex( { name:1 } );
+assert.eq( null, db.getLastError() );
+
+function check( regex ) {
+    var indexed = t.find( { name:regex } ).sort( { name:1 } ).toArray().map( function( d ) { return d.name; } );
+    var scanned = u.find( { name:regex } ).toArray().map( function( d ) { return d.name; } ).sort();
+    assert.eq( scanned, indexed.sort(), tojson( regex ) );
+}
+
+check( /^abc/i );
+check( /^ABC/i );
+check( /^abc$/i );
+check( /^ab\.c/i );
+check( /^ab.c/i );
+check( /^abc?/i );
+check( /^éabc/i );
+check( /^kel/i );
+check( /abc/i );
+check( /^longprefixname/i );
+check( { $regex:"^abc", $options:"i" } );
+check( { $in:[ /^abc/i, /^kel/i ] } );
+
+assert.eq( 6, t.count( { name:/^abc/i } ) );
+assert.eq( 2, t.count( { name:/^abcdef/i } ) );
+
+// The scan covers the spellings of the prefix only, not every string.
+assert.gt( names.length, t.find( { name:/^abc/i } ).explain().nscanned );
@@ -0,0 +1,61 @@
+// The writer and prefetcher pools and the batch limits can be changed at runtime, and take
+// effect from the next batch a secondary applies.
+
+var replTest = new ReplSetTest( { name: "apply_pool_params", nodes: 2 } );
+replTest.startSet();
+replTest.initiate();
+
+var primary = replTest.getMaster();
+var secondary = replTest.liveNodes.slaves[ 0 ];
+var admin = secondary.getDB( "admin" );
+
+function insertSome( n ) {
+    var d = primary.getDB( "test" );
+    for ( var i = 0; i < n; ++i ) {
+        d[ "c" + ( i % 8 ) ].insert( { x: i } );
+    }
+    assert( !d.getLastError( 2 ) );
+}
+
+insertSome( 100 );
+var applier = admin.serverStatus().repl.applier;
+assert.eq( false, applier.writerThreadCountAuto );
+assert.lt( 0, applier.lastBatch.ops );
+
+// Resized pools are used from the next batch.
+assert.commandWorked( admin.runCommand( { setParameter: 1, replWriterThreadCount: 3,
+                                          replPrefetcherThreadCount: 5 } ) );
+insertSome( 100 );
+applier = admin.serverStatus().repl.applier;
+assert.eq( 3, applier.writerThreads );
+assert.eq( 5, applier.prefetcherThreads );
+assert.lte( applier.lastBatch.writersUsed, 3 );
+
+// Smaller batches.
+assert.commandWorked( admin.runCommand( { setParameter: 1, replBatchLimitOperations: 10 } ) );
+insertSome( 200 );
+applier = admin.serverStatus().repl.applier;
+assert.eq( 10, applier.batchLimits.operations );
+assert.lte( applier.lastBatch.ops, 11 );
+
+// Sized automatically, never past replWriterThreadCount.
+assert.commandWorked( admin.runCommand( { setParameter: 1, replWriterThreadCountAuto: true } ) );
+insertSome( 200 );
+applier = admin.serverStatus().repl.applier;
+assert( applier.writerThreadCountAuto );
+assert.lte( applier.writerThreads, 3 );
+secondary.setSlaveOk();
+var total = 0;
+for ( var c = 0; c < 8; ++c ) {
+    total += secondary.getDB( "test" )[ "c" + c ].count();
+}
+assert.eq( 600, total );
+
+// Out of range values are refused.
+assert.commandFailed( admin.runCommand( { setParameter: 1, replWriterThreadCount: 0 } ) );
+assert.commandFailed( admin.runCommand( { setParameter: 1, replPrefetcherThreadCount: 1000 } ) );
+assert.commandFailed( admin.runCommand( { setParameter: 1,
+                                          replBatchLimitBytes: 1024 * 1024 * 1024 } ) );
+assert.commandFailed( admin.runCommand( { setParameter: 1, replBatchLimitSeconds: 0 } ) );
+
+replTest.stopSet();
@@ -0,0 +1,50 @@
+// With batchScopedReads set, a secondary applying a batch only holds up the readers of the
+// databases the batch writes.
+
+var replTest = new ReplSetTest( { name: "batch_scoped_reads", nodes: 2,
+                                  nodeOptions: { setParameter: "batchScopedReads=true" } } );
+replTest.startSet();
+replTest.initiate();
+
+var primary = replTest.getMaster();
+primary.getDB( "other" ).foo.insert( { _id: 1 } );
+primary.getDB( "test" ).foo.insert( { _id: 0 } );
+assert( !primary.getDB( "test" ).getLastError( 2 ) );
+
+var secondary = replTest.liveNodes.slaves[ 0 ];
+secondary.setSlaveOk();
+var admin = secondary.getDB( "admin" );
+
+// Hold the next batch open on the secondary, once it has taken its ops off the buffer.
+assert.commandWorked( admin.runCommand( { configureFailPoint: "rsSyncHoldBatch",
+                                          mode: "alwaysOn" } ) );
+primary.getDB( "test" ).foo.insert( { _id: 1 } );
+assert( !primary.getDB( "test" ).getLastError() );
+assert.soon( function() {
+    var metrics = admin.serverStatus().metrics.repl;
+    return metrics.network.ops > 0 && metrics.buffer.count == 0;
+}, "the secondary never started its batch" );
+sleep( 1000 );
+
+// A database the batch doesn't write reads on, the one it does waits for the batch.
+assert.eq( 1, secondary.getDB( "other" ).foo.count() );
+var waiter = startParallelShell( "db.getMongo().setSlaveOk();" +
+                                 "assert.eq( 2, db.getSiblingDB( 'test' ).foo.count() );",
+                                 secondary.port );
+assert.soon( function() {
+    return admin.serverStatus().globalLock.currentQueue.readers > 0;
+}, "the reader of the batch's database didn't wait for it" );
+assert.eq( 1, secondary.getDB( "other" ).foo.count() );
+
+assert.commandWorked( admin.runCommand( { configureFailPoint: "rsSyncHoldBatch", mode: "off" } ) );
+waiter();
+replTest.awaitReplication();
+assert.eq( 2, secondary.getDB( "test" ).foo.count() );
+
+// Without it, the batch holds up every reader again.
+assert.commandWorked( admin.runCommand( { setParameter: 1, batchScopedReads: false } ) );
+primary.getDB( "test" ).foo.insert( { _id: 2 } );
+assert( !primary.getDB( "test" ).getLastError( 2 ) );
+assert.eq( 1, secondary.getDB( "other" ).foo.count() );
+
+replTest.stopSet();
@@ -0,0 +1,68 @@
+// With flowControl set, a primary whose secondaries stop keeping up slows its writes down to
+// keep the majority's lag near flowControlTargetLagSeconds, and reports the time it made them wait.
+
+var replTest = new ReplSetTest( { name: "flow_control", nodes: 3 } );
+replTest.startSet();
+replTest.initiate();
+
+var primary = replTest.getMaster();
+var admin = primary.getDB( "admin" );
+var t = primary.getDB( "test" ).foo;
+t.insert( { _id: -1 } );
+replTest.awaitReplication();
+
+assert.commandWorked( admin.runCommand( { setParameter: 1, flowControl: true,
+                                          flowControlTargetLagSeconds: 1,
+                                          flowControlMinTicketsPerSecond: 20 } ) );
+assert.commandFailed( admin.runCommand( { setParameter: 1, flowControlTargetLagSeconds: 0 } ) );
+
+function flowControlStatus() {
+    return admin.serverStatus().flowControl;
+}
+assert( flowControlStatus().enabled );
+assert( !flowControlStatus().isThrottling );
+
+// Neither secondary applies anything, so the majority falls behind as the primary writes.
+replTest.liveNodes.slaves.forEach( function( s ) {
+    assert.commandWorked( s.getDB( "admin" ).runCommand( { configureFailPoint: "rsSyncApplyStop",
+                                                           mode: "alwaysOn" } ) );
+} );
+
+var i = 0;
+assert.soon( function() {
+    for ( var j = 0; j < 100; ++j ) {
+        t.insert( { _id: i++ } );
+    }
+    primary.getDB( "test" ).getLastError();
+    return flowControlStatus().isThrottling;
+}, "the primary never started throttling", 60 * 1000, 10 );
+
+// Throttled writes wait for their tickets, and say so.
+var before = flowControlStatus();
+assert.gte( before.lagSecs, 1 );
+assert.soon( function() {
+    for ( var j = 0; j < 20; ++j ) {
+        t.insert( { _id: i++ } );
+    }
+    primary.getDB( "test" ).getLastError();
+    var after = flowControlStatus();
+    return after.throttledOps > before.throttledOps &&
+           after.throttledMicros > before.throttledMicros;
+}, "no write waited for a ticket", 60 * 1000, 10 );
+
+// Once the secondaries catch up the primary stops throttling.
+replTest.liveNodes.slaves.forEach( function( s ) {
+    assert.commandWorked( s.getDB( "admin" ).runCommand( { configureFailPoint: "rsSyncApplyStop",
+                                                           mode: "off" } ) );
+} );
+replTest.awaitReplication();
+assert.soon( function() {
+    t.insert( { _id: i++ } );
+    primary.getDB( "test" ).getLastError();
+    return !flowControlStatus().isThrottling;
+}, "the primary kept throttling", 60 * 1000, 10 );
+
+assert.commandWorked( admin.runCommand( { setParameter: 1, flowControl: false } ) );
+assert( !flowControlStatus().enabled );
+
+replTest.stopSet();
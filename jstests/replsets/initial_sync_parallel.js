@@ -0,0 +1,53 @@
+// With initialSyncCloneThreads set, a new member clones several collections at once and builds
+// each collection's indexes together, ending up with the same data and indexes.
+
+var rs = new ReplSetTest( { name: "initial_sync_parallel", nodes: 1 } );
+rs.startSet();
+rs.initiate();
+var primary = rs.getMaster();
+
+var dbs = [ "initial_sync_parallel_a", "initial_sync_parallel_b", "initial_sync_parallel_c" ];
+dbs.forEach( function( name ) {
+    var d = primary.getDB( name );
+    for ( var c = 0; c < 4; ++c ) {
+        var t = d[ "coll" + c ];
+        for ( var i = 0; i < 500; ++i ) {
+            t.insert( { _id: i, a: i % 7, b: -i, s: "x" + i } );
+        }
+        t.ensureIndex( { a: 1 } );
+        t.ensureIndex( { b: 1, s: 1 } );
+        t.ensureIndex( { s: 1 }, { unique: true } );
+    }
+    d.capped.drop();
+    d.createCollection( "capped", { capped: true, size: 4096 } );
+    d.capped.insert( { x: 1 } );
+    assert( !d.getLastError() );
+} );
+
+rs.nodeOptions.n1 = { setParameter: "initialSyncCloneThreads=4" };
+var secondary = rs.add();
+rs.reInitiate();
+rs.awaitSecondaryNodes();
+rs.awaitReplication();
+secondary.setSlaveOk();
+
+dbs.forEach( function( name ) {
+    var p = primary.getDB( name );
+    var s = secondary.getDB( name );
+    for ( var c = 0; c < 4; ++c ) {
+        var coll = "coll" + c;
+        assert.eq( 500, s[ coll ].count(), name + "." + coll );
+        assert.eq( p[ coll ].getIndexKeys().map( tojson ).sort(),
+                   s[ coll ].getIndexKeys().map( tojson ).sort(), name + "." + coll );
+        assert.eq( 71, s[ coll ].find( { a: 3 } ).hint( { a: 1 } ).itcount() );
+    }
+    assert( s.capped.isCapped() );
+    assert.eq( 1, s.capped.count() );
+} );
+
+// Writes after the sync still replicate.
+primary.getDB( dbs[ 0 ] ).coll0.insert( { _id: 1000, a: 3, b: 0, s: "late" } );
+assert( !primary.getDB( dbs[ 0 ] ).getLastError( 2 ) );
+assert.eq( 501, secondary.getDB( dbs[ 0 ] ).coll0.count() );
+
+rs.stopSet();
@@ -0,0 +1,41 @@
+// With networkMessageCompression set on every member, replication traffic goes compressed.
+
+var replTest = new ReplSetTest( { name: "message_compression", nodes: 2,
+                                  nodeOptions: { setParameter: "networkMessageCompression=true" } } );
+replTest.startSet();
+replTest.initiate();
+
+var primary = replTest.getMaster();
+var t = primary.getDB( "test" ).foo;
+
+var line = "a line of text that compresses rather well, ";
+var text = "";
+for ( var i = 0; i < 40; ++i ) {
+    text += line;
+}
+for ( var i = 0; i < 2000; ++i ) {
+    t.insert( { _id: i, text: text } );
+}
+assert( !primary.getDB( "test" ).getLastError( 2 ) );
+
+replTest.awaitReplication();
+var secondary = replTest.liveNodes.slaves[ 0 ];
+secondary.setSlaveOk();
+assert.eq( 2000, secondary.getDB( "test" ).foo.count() );
+assert.eq( text, secondary.getDB( "test" ).foo.findOne( { _id: 1999 } ).text );
+
+// The oplog went out compressed, to much less than its size.
+var sent = primary.getDB( "admin" ).serverStatus().network.compression;
+assert.lt( 0, sent.messagesOut );
+assert.lt( sent.bytesOutCompressed * 4, sent.bytesOutUncompressed );
+var received = secondary.getDB( "admin" ).serverStatus().network.compression;
+assert.lt( 0, received.messagesIn );
+
+// A client that doesn't ask for compression doesn't get it.
+var res = primary.getDB( "admin" ).runCommand( { isMaster: 1 } );
+assert( !res.compression );
+res = primary.getDB( "admin" ).runCommand( { isMaster: 1, compression: [ "zip" ] } );
+assert( !res.compression );
+assert.lte( 3, res.maxWireVersion );
+
+replTest.stopSet();
@@ -0,0 +1,62 @@
+// With oplogDeltaUpdates set, updates made in place are logged as the bytes they changed when
+// that is smaller than the $set form, and secondaries apply them to the same documents.
+
+var replTest = new ReplSetTest( { name: "oplog_delta", nodes: 2,
+                                  nodeOptions: { setParameter: "oplogDeltaUpdates=true" } } );
+replTest.startSet();
+replTest.initiate();
+
+var primary = replTest.getMaster();
+var t = primary.getDB( "test" ).foo;
+var oplog = primary.getDB( "local" ).oplog.rs;
+
+var path = "counters.by_day.2013_10_14.page_views_from_search_engines_and_aggregators";
+var doc = { _id: 1,
+            counters: { by_day: { "2013_10_14": {
+                page_views_from_search_engines_and_aggregators: 0 } } },
+            name: "hot" };
+t.insert( doc );
+for ( var i = 0; i < 100; ++i ) {
+    var inc = {};
+    inc[ path ] = 1;
+    t.update( { _id: 1 }, { $inc: inc } );
+}
+assert( !primary.getDB( "test" ).getLastError( 2 ) );
+
+// each $inc went in as a small delta rather than a $set of the long path
+var ops = oplog.find( { op: "u", ns: t.getFullName() } ).toArray();
+assert.eq( 100, ops.length );
+ops.forEach( function( op ) {
+    assert( op.o.$delta, tojson( op ) );
+    assert.eq( 2, op.o.$delta.d.length );
+} );
+
+// updates that can't be made in place, or whose delta is no smaller, keep the $set form
+t.update( { _id: 1 }, { $set: { name: "a much longer name than before" } } );
+var big = new Array( 200 ).join( "x" );
+t.update( { _id: 1 }, { $set: { big: big } } );
+t.update( { _id: 1 }, { $set: { big: big.replace( /x/g, "y" ) } } );
+t.update( { _id: 1 }, { $set: { name: "hot" } } );
+assert( !primary.getDB( "test" ).getLastError( 2 ) );
+oplog.find( { op: "u", ns: t.getFullName() } ).sort( { $natural: -1 } ).limit( 3 ).forEach(
+    function( op ) {
+        assert( op.o.$set, tojson( op ) );
+    } );
+
+replTest.awaitReplication();
+var secondary = replTest.liveNodes.slaves[ 0 ];
+secondary.setSlaveOk();
+var mine = secondary.getDB( "test" ).foo.findOne( { _id: 1 } );
+assert.eq( t.findOne( { _id: 1 } ), mine );
+assert.eq( 100,
+           mine.counters.by_day[ "2013_10_14" ].page_views_from_search_engines_and_aggregators );
+
+// a delta applied again, as on replay, leaves the document alone
+var last = oplog.find( { "o.$delta": { $exists: true } } ).sort( { $natural: -1 } ).next();
+assert.commandWorked( primary.getDB( "admin" ).runCommand(
+    { applyOps: [ { op: "u", ns: last.ns, o2: last.o2, o: last.o } ] } ) );
+assert.eq( mine, t.findOne( { _id: 1 } ) );
+replTest.awaitReplication();
+assert.eq( mine, secondary.getDB( "test" ).foo.findOne( { _id: 1 } ) );
+
+replTest.stopSet();
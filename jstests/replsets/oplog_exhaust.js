@@ -0,0 +1,42 @@
+// Secondaries tail the oplog with an exhaust cursor unless replOplogExhaustCursor is off, and
+// end up with the same data either way.
+
+var replTest = new ReplSetTest( { name: "oplog_exhaust", nodes: 3 } );
+replTest.nodeOptions.n2 = { setParameter: "replOplogExhaustCursor=false" };
+replTest.startSet();
+replTest.initiate();
+
+var primary = replTest.getMaster();
+var t = primary.getDB( "test" ).foo;
+
+// Enough for several batches, in a few spurts.
+var text = new Array( 500 ).toString();
+for ( var spurt = 0; spurt < 5; ++spurt ) {
+    for ( var i = 0; i < 2000; ++i ) {
+        t.insert( { _id: spurt * 2000 + i, text: text } );
+    }
+    t.update( { _id: { $lt: 100 } }, { $inc: { n: 1 } }, false, true );
+    assert( !primary.getDB( "test" ).getLastError( 3 ) );
+    sleep( 500 );
+}
+replTest.awaitReplication();
+
+replTest.liveNodes.slaves.forEach( function( secondary ) {
+    secondary.setSlaveOk();
+    var s = secondary.getDB( "test" ).foo;
+    assert.eq( 10000, s.count() );
+    assert.eq( 100, s.find( { n: 5 } ).count() );
+    assert.eq( 9999, s.find().sort( { _id: -1 } ).limit( 1 ).next()._id );
+    var received = secondary.getDB( "admin" ).serverStatus().metrics.repl;
+    assert.lte( 10000, received.network.ops );
+} );
+
+// Writes after an idle while, when the exhaust stream has only sent empty batches, still arrive.
+sleep( 6000 );
+primary.getDB( "test" ).foo.insert( { _id: "last" } );
+assert( !primary.getDB( "test" ).getLastError( 3 ) );
+replTest.liveNodes.slaves.forEach( function( secondary ) {
+    assert.eq( 1, secondary.getDB( "test" ).foo.find( { _id: "last" } ).itcount() );
+} );
+
+replTest.stopSet();
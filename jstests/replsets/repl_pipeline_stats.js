@@ -0,0 +1,33 @@
+// Tests that a secondary reports the time each replication stage took and what is queued between
+// them in the replPipeline serverStatus section, which is only there when asked for
+
+var rt = new ReplSetTest( { name : "repl_pipeline_stats" , nodes: 2, oplogSize: 100 } );
+rt.startSet();
+rt.initiate();
+rt.awaitSecondaryNodes();
+
+var primary = rt.getPrimary();
+var secondary = rt.getSecondary();
+var testDB = primary.getDB("test");
+
+for (var i = 0; i < 1000; i++) {
+    testDB.a.insert({_id : i});
+}
+testDB.getLastError(2);
+
+assert.eq(undefined, secondary.getDB("admin").serverStatus().replPipeline);
+
+var stats = secondary.getDB("admin").serverStatus({replPipeline : 1}).replPipeline;
+printjson(stats);
+["fetch", "prefetch", "apply", "oplogWrite"].forEach(function(stage) {
+    assert.gt(stats[stage].count, 0, stage);
+});
+["bufferFullWait", "bufferEmptyWait"].forEach(function(stage) {
+    assert.gte(stats[stage].count, 0, stage);
+});
+assert.gte(stats.queued.bufferOps, 0);
+assert.gte(stats.queued.bufferBytes, 0);
+assert.gt(stats.queued.bufferMaxBytes, 0);
+assert.gte(stats.queued.batchOps, 0);
+
+rt.stopSet();
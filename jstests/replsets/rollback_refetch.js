@@ -0,0 +1,87 @@
+// Rolling back thousands of ops refetches their documents from the sync source in batches, on
+// several connections at once, and still leaves the member with the source's versions.
+
+function wait(f) {
+    assert.soon(function() {
+        try {
+            return f();
+        }
+        catch (e) {
+            print(e);
+            return false;
+        }
+    }, "rollback_refetch.js wait", 200 * 1000);
+}
+
+var replTest = new ReplSetTest({ name: "rollback_refetch", nodes: 3,
+                                 nodeOptions: { setParameter: "rollbackRefetchThreads=3" } });
+var nodes = replTest.nodeList();
+var conns = replTest.startSet();
+replTest.initiate({ _id: "rollback_refetch",
+                    members: [ { _id: 0, host: nodes[0] },
+                               { _id: 1, host: nodes[1] },
+                               { _id: 2, host: nodes[2], arbiterOnly: true } ] });
+
+var a_conn = conns[0];
+var b_conn = conns[1];
+a_conn.setSlaveOk();
+b_conn.setSlaveOk();
+var A = a_conn.getDB("admin");
+var B = b_conn.getDB("admin");
+assert.eq(replTest.getMaster(), a_conn, "conns[0] assumed to be master");
+var a = a_conn.getDB("foo");
+var b = b_conn.getDB("foo");
+wait(function() { return A.runCommand({ replSetGetStatus: 1 }).members[1].state == 2; });
+
+// kept: documents every member has, in two collections, with _ids of mixed types
+for (var i = 0; i < 3000; i++) {
+    a.bar.insert({ _id: i, x: 0 });
+}
+for (var i = 0; i < 500; i++) {
+    a.baz.insert({ _id: "s" + i, x: 0 });
+}
+a.baz.insert({ _id: { k: 1 }, x: 0 });
+a.baz.insert({ _id: /re/, x: 0 });
+assert(!a.getLastError(2));
+wait(function() { return b.bar.count() == 3000 && b.baz.count() == 502; });
+
+// B takes over while A is cut off, and writes what will be rolled back
+A.runCommand({ replSetTest: 1, blind: true });
+wait(function() { return B.isMaster().ismaster; });
+for (var i = 0; i < 3000; i += 2) {
+    b.bar.update({ _id: i }, { $set: { x: 1, rb: true } });
+}
+b.bar.remove({ _id: { $gte: 2000, $lt: 2500 } });
+for (var i = 3000; i < 4000; i++) {
+    b.bar.insert({ _id: i, rb: true });
+}
+b.baz.update({}, { $set: { rb: true } }, false, true);
+assert(!b.getLastError());
+
+// A takes back over and makes its own writes
+B.runCommand({ replSetTest: 1, blind: true });
+A.runCommand({ replSetTest: 1, blind: false });
+wait(function() { return A.isMaster().ismaster; });
+a.bar.update({ _id: 10 }, { $set: { x: 2 } });
+a.bar.remove({ _id: 11 });
+a.baz.update({ _id: "s7" }, { $set: { x: 2 } });
+assert(!a.getLastError());
+
+// B rolls back and catches up
+B.runCommand({ replSetTest: 1, blind: false });
+wait(function() { return B.isMaster().secondary; });
+replTest.awaitReplication();
+
+assert.eq(0, b.bar.find({ rb: true }).itcount());
+assert.eq(0, b.baz.find({ rb: true }).itcount());
+assert.eq(2999, b.bar.count());
+assert.eq(502, b.baz.count());
+assert.eq(2, b.bar.findOne({ _id: 10 }).x);
+assert.eq(null, b.bar.findOne({ _id: 11 }));
+assert.eq(0, b.bar.findOne({ _id: 2000 }).x);
+assert.eq(2, b.baz.findOne({ _id: "s7" }).x);
+assert.eq(0, b.baz.findOne({ _id: { k: 1 } }).x);
+assert.eq(a.bar.find().sort({ _id: 1 }).toArray(), b.bar.find().sort({ _id: 1 }).toArray());
+assert.eq(a.baz.find().sort({ _id: 1 }).toArray(), b.baz.find().sort({ _id: 1 }).toArray());
+
+replTest.stopSet(15);
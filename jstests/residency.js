@@ -0,0 +1,40 @@
+// The residency command reports how much of a collection and its indexes is in memory, and the
+// pageFaultsByNamespace serverStatus section how often accesses to each namespace missed it.
+
+var t = db.jstests_residency;
+t.drop();
+
+t.ensureIndex( { a: 1 } );
+var big = new Array( 1024 ).toString();
+for ( var i = 0; i < 1000; ++i ) {
+    t.insert( { a: i, s: big } );
+}
+assert( !db.getLastError() );
+
+var res = t.runCommand( "residency" );
+if ( res.errmsg && /not supported/.test( res.errmsg ) ) {
+    print( "residency not supported on this platform" );
+}
+else {
+    assert.commandWorked( res );
+    assert.eq( t.getFullName(), res.ns );
+
+    // everything was just written, so it's all resident
+    var coll = res.collection;
+    assert.lte( 1, coll.extents );
+    assert.lte( 1000 * 1024, coll.bytes );
+    assert.lt( 0, coll.residentBytes );
+    assert.lte( coll.residentBytes, coll.bytes );
+    assert.eq( "number", typeof coll.accessesNotInMemory );
+    assert.eq( "number", typeof coll.pageFaultExceptionsThrown );
+
+    assert.eq( [ "_id_", "a_1" ], Object.keySet( res.indexes ).sort() );
+    assert.lt( 0, res.indexes.a_1.bytes );
+    assert.lte( res.indexes.a_1.residentBytes, res.indexes.a_1.bytes );
+
+    assert.commandFailed( db.runCommand( { residency: "jstests_residency_missing" } ) );
+}
+
+var status = db.serverStatus( { pageFaultsByNamespace: 1 } );
+assert.commandWorked( status );
+assert.eq( "object", typeof status.pageFaultsByNamespace );
@@ -0,0 +1,55 @@
+//
+// Tests that with balanceByLoad set, the balancer moves chunks off a shard with most of a
+// collection's data even though both shards have as many chunks
+//
+
+var st = new ShardingTest({shards : 2, mongos : 1});
+
+st.stopBalancer();
+
+var mongos = st.s0;
+var config = mongos.getDB("config");
+var shards = config.shards.find().sort({_id : 1}).toArray();
+var coll = mongos.getCollection("foo.bar");
+
+assert(mongos.adminCommand({enableSharding : coll.getDB() + ""}).ok);
+mongos.adminCommand({movePrimary : coll.getDB() + "", to : shards[0]._id});
+assert(mongos.adminCommand({shardCollection : coll + "", key : {_id : 1}}).ok);
+
+// [0, 100) and [100, 200) on shard0 with all the big documents; [200, 300) and [300, ...) on
+// shard1 with small ones
+var bigString = new Array(64 * 1024).toString();
+for (var i = 0; i < 400; i++) {
+    coll.insert({_id : i, s : i < 200 ? bigString : ""});
+}
+assert.eq(null, coll.getDB().getLastError());
+[100, 200, 300].forEach(function(middle) {
+    assert(mongos.adminCommand({split : coll + "", middle : {_id : middle}}).ok);
+});
+[200, 300].forEach(function(min) {
+    assert(mongos.adminCommand({moveChunk : coll + "", find : {_id : min}, to : shards[1]._id,
+                                _waitForDelete : true}).ok);
+});
+assert.eq(2, config.chunks.count({ns : coll + "", shard : shards[0]._id}));
+assert.eq(2, config.chunks.count({ns : coll + "", shard : shards[1]._id}));
+
+config.settings.update({_id : "balancer"}, {$set : {balanceByLoad : true}}, true);
+assert.eq(null, config.getLastError());
+
+st.startBalancer();
+
+assert.soon(function() {
+    return config.chunks.count({ns : coll + "", shard : shards[1]._id}) == 3;
+}, "balancer never moved a big chunk", 5 * 60 * 1000);
+
+// one more would just make shard1 the overloaded one
+sleep(30 * 1000);
+assert.eq(3, config.chunks.count({ns : coll + "", shard : shards[1]._id}));
+
+st.stopBalancer();
+
+assert.eq(400, coll.find().itcount());
+
+jsTest.log("DONE!");
+
+st.stop();
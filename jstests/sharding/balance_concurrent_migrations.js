@@ -0,0 +1,66 @@
+//
+// Tests that with maxConcurrentMigrations set, a balancer round moves chunks between distinct
+// shards at once
+//
+
+var st = new ShardingTest({shards : 4, mongos : 1, other : {chunksize : 1}});
+
+st.stopBalancer();
+
+var mongos = st.s0;
+var config = mongos.getDB("config");
+var shards = config.shards.find().sort({_id : 1}).toArray();
+
+// Two collections, each with all its chunks on a shard of its own
+var colls = [mongos.getCollection("a.foo"), mongos.getCollection("b.foo")];
+var bigString = new Array(10 * 1024).toString();
+colls.forEach(function(coll, n) {
+    assert(mongos.adminCommand({enableSharding : coll.getDB() + ""}).ok);
+    mongos.adminCommand({movePrimary : coll.getDB() + "", to : shards[2 * n]._id});
+    assert(mongos.adminCommand({shardCollection : coll + "", key : {_id : 1}}).ok);
+    for (var i = 0; i < 400; i++) {
+        coll.insert({_id : i, s : bigString});
+    }
+    assert.eq(null, coll.getDB().getLastError());
+    for (var i = 20; i < 400; i += 20) {
+        assert(mongos.adminCommand({split : coll + "", middle : {_id : i}}).ok);
+    }
+});
+
+config.settings.update({_id : "balancer"}, {$set : {maxConcurrentMigrations : 2}}, true);
+assert.eq(null, config.getLastError());
+
+st.startBalancer();
+
+assert.soon(function() {
+    return colls.every(function(coll) {
+        return config.chunks.count({ns : coll + "", shard : shards[1]._id}) +
+               config.chunks.count({ns : coll + "", shard : shards[3]._id}) >= 5;
+    });
+}, "collections were never balanced", 5 * 60 * 1000);
+
+st.stopBalancer();
+
+// Some migration of one collection started before one of the other had committed, and ended
+// after it started
+var moves = {};
+colls.forEach(function(coll) {
+    moves[coll] = [];
+    config.changelog.find({ns : coll + "", what : "moveChunk.start"}).forEach(function(start) {
+        var commit = config.changelog.findOne({ns : coll + "", what : "moveChunk.commit",
+                                               "details.min" : start.details.min});
+        if (commit)
+            moves[coll].push({start : start.time, end : commit.time});
+    });
+    assert.lt(0, moves[coll].length);
+});
+var overlapped = moves[colls[0]].some(function(a) {
+    return moves[colls[1]].some(function(b) {
+        return a.start < b.end && b.start < a.end;
+    });
+});
+assert(overlapped, "no migrations ran at once: " + tojson(moves));
+
+jsTest.log("DONE!");
+
+st.stop();
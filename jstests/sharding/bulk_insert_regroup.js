@@ -0,0 +1,49 @@
+//
+// Tests that continue-on-error bulk inserts whose documents alternate between shards insert every
+// good document and still report the last error, and that ordered inserts stop at the first one
+//
+
+var st = new ShardingTest({shards : 2, mongos : 1});
+st.stopBalancer();
+
+var mongos = st.s0;
+var coll = mongos.getCollection("foo.bar");
+var shards = mongos.getCollection("config.shards").find().sort({_id : 1}).toArray();
+assert(mongos.adminCommand({enableSharding : coll.getDB() + ""}).ok);
+printjson(mongos.adminCommand({movePrimary : coll.getDB() + "", to : shards[0]._id}));
+assert(mongos.adminCommand({shardCollection : coll + "", key : {_id : 1}}).ok);
+assert(mongos.adminCommand({split : coll + "", middle : {_id : 0}}).ok);
+assert(mongos.adminCommand({moveChunk : coll + "", find : {_id : 0}, to : shards[1]._id,
+                            _waitForDelete : true}).ok);
+
+// every other document goes to the other shard
+var inserts = [];
+for (var i = 0; i < 100; i++) {
+    inserts.push({_id : (i % 2 ? -1 : 1) * (i + 1)});
+}
+
+coll.insert(inserts, 1); // COE
+assert.eq(null, coll.getDB().getLastError());
+assert.eq(100, coll.find().itcount());
+assert.eq(50, coll.find({_id : {$lt : 0}}).itcount());
+
+// duplicates on both shards, and a document without a shard key
+coll.remove({});
+assert.eq(null, coll.getDB().getLastError());
+inserts.splice(10, 0, {_id : 1});
+inserts.splice(20, 0, {_id : -2});
+inserts.push({hello : "world"});
+
+coll.insert(inserts, 1);
+assert.neq(null, printPass(coll.getDB().getLastError()));
+assert.eq(100, coll.find().itcount());
+
+// the same documents in order stop at the first duplicate
+coll.remove({});
+assert.eq(null, coll.getDB().getLastError());
+
+coll.insert(inserts);
+assert(isDupKeyError(printPass(coll.getDB().getLastError())));
+assert.eq(10, coll.find().itcount());
+
+st.stop();
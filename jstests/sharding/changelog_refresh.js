@@ -0,0 +1,46 @@
+//
+// Tests that a mongos picks up chunk changes made through another mongos from config.changelog,
+// without having to hit a stale version first
+//
+
+var st = new ShardingTest({shards : 2, mongos : 2});
+st.stopBalancer();
+
+var mongosA = st.s0;
+var mongosB = st.s1;
+var coll = mongosA.getCollection("foo.bar");
+var shards = mongosA.getCollection("config.shards").find().sort({_id : 1}).toArray();
+assert(mongosA.adminCommand({enableSharding : coll.getDB() + ""}).ok);
+printjson(mongosA.adminCommand({movePrimary : coll.getDB() + "", to : shards[0]._id}));
+assert(mongosA.adminCommand({shardCollection : coll + "", key : {_id : 1}}).ok);
+
+// mongosB loads the collection
+assert.eq(0, mongosB.getCollection(coll + "").find().itcount());
+
+function versionOn(mongos) {
+    var res = mongos.adminCommand({getShardVersion : coll + ""});
+    assert(res.ok, tojson(res));
+    return tojson(res.version);
+}
+
+function checkSameVersion(message) {
+    var expected = versionOn(mongosA);
+    assert.soon(function() { return versionOn(mongosB) == expected; }, message, 30 * 1000);
+}
+
+assert(mongosA.adminCommand({split : coll + "", middle : {_id : 0}}).ok);
+checkSameVersion("split not seen by the other mongos");
+
+assert(mongosA.adminCommand({moveChunk : coll + "", find : {_id : 0}, to : shards[1]._id}).ok);
+checkSameVersion("migration not seen by the other mongos");
+
+assert(mongosA.adminCommand({split : coll + "", middle : {_id : 100}}).ok);
+assert(mongosA.adminCommand({mergeChunks : coll + "", bounds : [{_id : 0}, {_id : MaxKey}]}).ok);
+checkSameVersion("merge not seen by the other mongos");
+
+// and the routing is right
+mongosB.getCollection(coll + "").insert({_id : 1});
+assert.eq(null, mongosB.getDB(coll.getDB() + "").getLastError());
+assert.eq(1, st.shard1.getCollection(coll + "").count());
+
+st.stop();
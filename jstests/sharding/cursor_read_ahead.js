@@ -0,0 +1,55 @@
+//
+// Tests that scatter queries through mongos return every document, in order when sorted, while
+// the shard cursors read ahead, and with read-ahead turned off
+//
+
+var st = new ShardingTest({shards : 2, mongos : 1});
+st.stopBalancer();
+
+var mongos = st.s0;
+var coll = mongos.getCollection("foo.bar");
+var shards = mongos.getCollection("config.shards").find().sort({_id : 1}).toArray();
+assert(mongos.adminCommand({enableSharding : coll.getDB() + ""}).ok);
+printjson(mongos.adminCommand({movePrimary : coll.getDB() + "", to : shards[0]._id}));
+assert(mongos.adminCommand({shardCollection : coll + "", key : {_id : 1}}).ok);
+assert(mongos.adminCommand({split : coll + "", middle : {_id : 0}}).ok);
+assert(mongos.adminCommand({moveChunk : coll + "", find : {_id : 0}, to : shards[1]._id}).ok);
+
+// enough for many batches from each shard
+var str = new Array(1024).toString();
+for (var i = -5000; i < 5000; i++) {
+    coll.insert({_id : i, a : (i * 7919) % 10000, s : str});
+}
+assert.eq(null, coll.getDB().getLastError());
+
+function check() {
+    assert.eq(10000, coll.find().itcount());
+    assert.eq(10000, coll.find().batchSize(50).itcount());
+
+    var last = null;
+    var n = 0;
+    coll.find({}, {a : 1}).sort({a : 1}).forEach(function(doc) {
+        if (last !== null) assert.lte(last, doc.a);
+        last = doc.a;
+        n++;
+    });
+    assert.eq(10000, n);
+
+    // cursors dropped part way through leave their connections usable
+    for (var i = 0; i < 20; i++) {
+        var cursor = coll.find().sort({a : -1});
+        for (var j = 0; j < 500; j++) cursor.next();
+        assert.eq(10000, coll.count());
+    }
+    assert.eq(10000, coll.find().itcount());
+}
+
+check();
+
+assert(mongos.adminCommand({setParameter : 1, internalShardCursorReadAhead : 0}).ok);
+check();
+
+assert(mongos.adminCommand({setParameter : 1, internalShardCursorReadAhead : 1000000}).ok);
+check();
+
+st.stop();
@@ -0,0 +1,43 @@
+//
+// Tests that mongos merges the distinct values of every shard: each value once and in order,
+// with arrays flattened as on a single server, and a query narrowing the shards
+//
+
+var st = new ShardingTest({shards : 2, mongos : 1});
+st.stopBalancer();
+
+var mongos = st.s0;
+var coll = mongos.getCollection("foo.bar");
+var shards = mongos.getCollection("config.shards").find().sort({_id : 1}).toArray();
+assert(mongos.adminCommand({enableSharding : coll.getDB() + ""}).ok);
+printjson(mongos.adminCommand({movePrimary : coll.getDB() + "", to : shards[0]._id}));
+assert(mongos.adminCommand({shardCollection : coll + "", key : {_id : 1}}).ok);
+assert(mongos.adminCommand({split : coll + "", middle : {_id : 0}}).ok);
+assert(mongos.adminCommand({moveChunk : coll + "", find : {_id : 0}, to : shards[1]._id}).ok);
+
+for (var i = -500; i < 500; i++) {
+    coll.insert({_id : i, a : Math.abs(i) % 10, b : [Math.abs(i) % 3, 'x'], c : {d : i < 0 ? 'neg' : 'pos'}});
+}
+assert.eq(null, coll.getDB().getLastError());
+
+// both shards have each of these values
+assert.eq([0, 1, 2, 3, 4, 5, 6, 7, 8, 9], coll.distinct('a'));
+assert.eq([0, 1, 2, 'x'], coll.distinct('b'));
+assert.eq(['neg', 'pos'], coll.distinct('c.d'));
+assert.eq([], coll.distinct('nothing'));
+
+// only the shard with positive _ids is asked
+assert.eq([0, 1, 2, 3, 4, 5, 6, 7, 8, 9], coll.distinct('a', {_id : {$gte : 0}}));
+assert.eq(['pos'], coll.distinct('c.d', {_id : {$gte : 0}}));
+assert.eq([0, 1, 2], coll.distinct('a', {a : {$lte : 2}, _id : {$gte : 0}}));
+assert.eq([4], coll.distinct('a', {_id : {$in : [-4, 4, 14]}}));
+
+// too many distinct values for a single response
+var str = new Array(1024 * 1024).toString();
+for (var i = 0; i < 20; i++) {
+    coll.insert({_id : (i % 2 ? -1 : 1) * (1000 + i), big : str + i});
+}
+assert.eq(null, coll.getDB().getLastError());
+assert.throws(function() { coll.distinct('big'); });
+
+st.stop();
@@ -0,0 +1,54 @@
+// A shard key made of a hashed field followed by ascending ones spreads its hashed values over the
+// shards, and a range query fixing the hashed value is sent only to the shard holding it.
+
+var s = new ShardingTest( { name : jsTestName() , shards : 3 , mongos : 1 } );
+var db = s.getDB( "test" );
+var admin = s.getDB( "admin" );
+var t = db.foo;
+
+assert.commandWorked( admin.runCommand( { enableSharding : "test" } ) );
+s.stopBalancer();
+
+// Only the first field may be hashed, and the rest must be ascending.
+assert.commandFailed( admin.runCommand( { shardCollection : "test.bad1",
+                                          key : { ts : 1 , device : "hashed" } } ) );
+assert.commandFailed( admin.runCommand( { shardCollection : "test.bad2",
+                                          key : { device : "hashed" , ts : -1 } } ) );
+
+assert.commandWorked( admin.runCommand( { shardCollection : t.getFullName(),
+                                          key : { device : "hashed" , ts : 1 },
+                                          numInitialChunks : 6 } ) );
+
+// The initial chunks are split on the hashed field alone, and spread over every shard.
+var chunks = s.config.chunks.find( { ns : t.getFullName() } ).toArray();
+assert.eq( 6, chunks.length );
+chunks.forEach( function( c ) {
+    assert.eq( [ "device", "ts" ], Object.keySet( c.min ) );
+} );
+assert.eq( 3, s.config.chunks.distinct( "shard", { ns : t.getFullName() } ).length );
+
+for ( var d = 0; d < 50; ++d ) {
+    for ( var ts = 0; ts < 20; ++ts ) {
+        t.insert( { device : d , ts : ts } );
+    }
+}
+assert.eq( null, db.getLastError() );
+assert.eq( 1000, t.count() );
+
+var shardsHit = function( query ) {
+    return Object.keySet( t.find( query ).explain().shards ).length;
+};
+
+// Queries fixing the hashed value are sent to one shard, whatever range they ask for.
+for ( var d = 0; d < 50; d += 7 ) {
+    var query = { device : d , ts : { $gte : 5 , $lt : 15 } };
+    assert.eq( 10, t.find( query ).itcount() );
+    assert.eq( 1, shardsHit( query ) );
+    assert.eq( 1, shardsHit( { device : d } ) );
+}
+
+// Ones that don't go everywhere.
+assert.eq( 150, t.find( { ts : { $gte : 5 , $lt : 8 } } ).itcount() );
+assert.eq( 3, shardsHit( { ts : { $gte : 5 , $lt : 8 } } ) );
+
+s.stop();
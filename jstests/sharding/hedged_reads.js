@@ -0,0 +1,43 @@
+//
+// Tests that secondary reads through mongos still return every document when they are slow
+// enough to be hedged to a second secondary
+//
+
+load("jstests/replsets/rslib.js");
+
+var st = new ShardingTest({shards : {rs0 : {nodes : 3}}, mongos : 1});
+st.stopBalancer();
+st.rs0.awaitSecondaryNodes();
+ReplSetTest.awaitRSClientHosts(st.s, st.rs0.nodes);
+
+var mongos = st.s0;
+var coll = mongos.getCollection("foo.bar");
+assert(mongos.adminCommand({enableSharding : coll.getDB() + ""}).ok);
+assert(mongos.adminCommand({shardCollection : coll + "", key : {_id : 1}}).ok);
+
+for (var i = 0; i < 100; i++) {
+    coll.insert({_id : i});
+}
+assert.eq(null, coll.getDB().getLastErrorCmd({w : 3}).err);
+
+function check() {
+    mongos.setReadPref("secondary");
+    assert.eq(100, coll.find().itcount());
+    assert.eq(100, coll.find().batchSize(10).itcount());
+    // every document sleeps, so every query is slower than the hedging delay
+    assert.eq(10, coll.find({$where : "sleep(5); return this._id < 10;"}).itcount());
+    assert.eq(100, coll.find().sort({_id : -1}).batchSize(7).itcount());
+    mongos.setReadPref(null);
+    assert.eq(100, coll.find().itcount());
+}
+
+check();
+
+assert(mongos.adminCommand({setParameter : 1, hedgedReadDelayMillis : 1}).ok);
+check();
+
+assert(!mongos.adminCommand({setParameter : 1, hedgedReadDelayMillis : -1}).ok);
+assert(mongos.adminCommand({setParameter : 1, hedgedReadDelayMillis : 0}).ok);
+check();
+
+st.stop();
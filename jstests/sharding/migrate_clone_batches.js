@@ -0,0 +1,43 @@
+//
+// Tests that a migration clones a chunk of several _migrateClone batches with every document and
+// index key, and that the recipient's secondaries get them too
+//
+
+var st = new ShardingTest({shards : 2, mongos : 1,
+                           other : {rs : true, rsOptions : {nodes : 2, oplogSize : 100}}});
+st.stopBalancer();
+
+var mongos = st.s0;
+var coll = mongos.getCollection("foo.bar");
+var shards = mongos.getCollection("config.shards").find().sort({_id : 1}).toArray();
+assert(mongos.adminCommand({enableSharding : coll.getDB() + ""}).ok);
+printjson(mongos.adminCommand({movePrimary : coll.getDB() + "", to : shards[0]._id}));
+assert(mongos.adminCommand({shardCollection : coll + "", key : {_id : 1}}).ok);
+coll.ensureIndex({a : 1});
+coll.ensureIndex({b : 1}, {unique : true});
+
+// large enough for the donor to send it in several batches
+var str = new Array(1024 * 8).toString();
+for (var i = 0; i < 6000; i++) {
+    coll.insert({_id : i, a : i % 7, b : i, s : str});
+}
+assert.eq(null, coll.getDB().getLastError());
+
+assert(mongos.adminCommand({moveChunk : coll + "", find : {_id : 0}, to : shards[1]._id,
+                            _waitForDelete : true}).ok);
+
+var recipient = st.rs1.getPrimary().getCollection(coll + "");
+assert.eq(6000, recipient.count());
+assert.eq(857, recipient.find({a : 3}).hint({a : 1}).itcount());
+assert.eq(1, recipient.find({b : 4321}).hint({b : 1}).itcount());
+var res = recipient.validate(true);
+assert(res.valid, tojson(res));
+assert.eq(6000, res.keysPerIndex[recipient.getFullName() + ".$a_1"]);
+
+st.rs1.awaitReplication();
+var secondary = st.rs1.getSecondary();
+secondary.setSlaveOk();
+assert.eq(6000, secondary.getCollection(coll + "").count());
+assert.eq(6000, secondary.getCollection(coll + "").find({a : {$gte : 0}}).hint({a : 1}).itcount());
+
+st.stop();
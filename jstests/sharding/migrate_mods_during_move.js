@@ -0,0 +1,63 @@
+//
+// Tests that writes to a chunk while it migrates all end up on the recipient: updates to the same
+// documents over and over, deletes and re-inserts, with a tight critical section budget
+//
+
+var st = new ShardingTest({shards : 2, mongos : 1});
+st.stopBalancer();
+
+var db = st.s0.getDB("test"); // db variable name is required due to startParallelShell()
+var coll = db.foo;
+var shards = st.s0.getCollection("config.shards").find().sort({_id : 1}).toArray();
+assert(db.adminCommand({enableSharding : "test"}).ok);
+printjson(db.adminCommand({movePrimary : "test", to : shards[0]._id}));
+assert(db.adminCommand({shardCollection : coll + "", key : {_id : 1}}).ok);
+
+var numDocs = 20000;
+var str = new Array(512).toString();
+for (var i = 0; i < numDocs; i++) {
+    coll.insert({_id : i, n : 0, s : str});
+}
+assert.eq(null, db.getLastError());
+
+st.shard0.getDB("admin").runCommand({setParameter : 1, migrateCriticalSectionBudgetMillis : 1});
+
+var join = startParallelShell(
+    "printjson(assert.commandWorked(db.adminCommand({moveChunk : 'test.foo', find : {_id : 0}," +
+    "                                                to : '" + shards[1]._id + "'," +
+    "                                                _waitForDelete : true})));", st.s0.port);
+
+// hammer a few documents, and delete and bring back others, while the chunk moves
+var expected = {};
+var gone = {};
+for (var round = 0; round < 2000; round++) {
+    var id = round % 50;
+    coll.update({_id : id}, {$inc : {n : 1}});
+    expected[id] = (expected[id] || 0) + 1;
+
+    var other = 1000 + (round % 200) * 50;
+    if (gone[other]) {
+        coll.insert({_id : other, n : 0, s : str});
+        delete gone[other];
+    }
+    else {
+        coll.remove({_id : other});
+        gone[other] = true;
+    }
+}
+assert.eq(null, db.getLastError());
+
+join();
+
+assert.eq(shards[1]._id, st.s0.getCollection("config.chunks").findOne({ns : coll + ""}).shard);
+assert.eq(0, st.shard0.getCollection(coll + "").count());
+
+for (var id in expected) {
+    assert.eq(expected[id], coll.findOne({_id : parseInt(id)}).n, "lost updates to " + id);
+}
+assert.eq(numDocs - Object.keySet(gone).length, coll.count());
+for (var id in gone) {
+    assert.eq(null, coll.findOne({_id : parseInt(id)}));
+}
+
+st.stop();
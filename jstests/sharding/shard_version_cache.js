@@ -0,0 +1,44 @@
+//
+// Tests that a shard notices metadata changes made through another mongos even though each
+// connection caches the metadata it checks versions against
+//
+
+var st = new ShardingTest({shards : 2, mongos : 2});
+st.stopBalancer();
+
+var mongosA = st.s0;
+var mongosB = st.s1;
+var collA = mongosA.getCollection("foo.bar");
+var collB = mongosB.getCollection("foo.bar");
+var shards = mongosA.getCollection("config.shards").find().sort({_id : 1}).toArray();
+assert(mongosA.adminCommand({enableSharding : collA.getDB() + ""}).ok);
+printjson(mongosA.adminCommand({movePrimary : collA.getDB() + "", to : shards[0]._id}));
+assert(mongosA.adminCommand({shardCollection : collA + "", key : {_id : 1}}).ok);
+assert(mongosA.adminCommand({split : collA + "", middle : {_id : 0}}).ok);
+
+// both mongoses have versioned connections to shard0
+for (var i = -10; i < 10; i++) {
+    collA.insert({_id : i});
+    collB.insert({_id : i + 100});
+}
+assert.eq(null, collA.getDB().getLastError());
+assert.eq(null, collB.getDB().getLastError());
+assert.eq(30, collB.find({_id : {$gte : 0}}).itcount());
+
+// each move bumps the shard version, which the cached connections on B must pick up
+for (var round = 0; round < 4; round++) {
+    var to = shards[(round + 1) % 2]._id;
+    assert(mongosA.adminCommand({moveChunk : collA + "", find : {_id : 0}, to : to,
+                                 _waitForDelete : true}).ok);
+
+    collB.insert({_id : 1000 + round});
+    assert.eq(null, collB.getDB().getLastError());
+    collB.update({_id : 1000 + round}, {$set : {round : round}});
+    assert.eq(null, collB.getDB().getLastError());
+
+    assert.eq(31 + round, collB.find({_id : {$gte : 0}}).itcount());
+    assert.eq(round, collB.findOne({_id : 1000 + round}).round);
+    assert.eq(40 + round + 1, collA.find().itcount());
+}
+
+st.stop();
@@ -0,0 +1,51 @@
+//
+// Tests that forcing a split of a chunk where most documents share its min key splits right after
+// that key, instead of failing and leaving a jumbo chunk that can't be moved
+//
+
+var st = new ShardingTest({shards : 2, mongos : 1, other : {chunksize : 1}});
+st.stopBalancer();
+
+var mongos = st.s0;
+var config = mongos.getDB("config");
+var shards = config.shards.find().sort({_id : 1}).toArray();
+
+assert(mongos.adminCommand({enableSharding : "foo"}).ok);
+printjson(mongos.adminCommand({movePrimary : "foo", to : shards[0]._id}));
+
+// makeKey(0) is the hot key, makeKey(1) the next one and makeKey(100) the end of the chunk
+function test(name, keyPattern, makeKey) {
+    var coll = mongos.getCollection("foo." + name);
+    assert(mongos.adminCommand({shardCollection : coll + "", key : keyPattern}).ok);
+    assert(mongos.adminCommand({split : coll + "", middle : makeKey(0)}).ok);
+    assert(mongos.adminCommand({split : coll + "", middle : makeKey(100)}).ok);
+
+    var str = new Array(1024).toString();
+    for (var i = 0; i < 2000; i++) {
+        coll.insert(Object.extend({i : i, s : str}, makeKey(0)));
+    }
+    for (var k = 1; k <= 10; k++) {
+        coll.insert(Object.extend({i : 0, s : str}, makeKey(k)));
+    }
+    assert.eq(null, coll.getDB().getLastError());
+
+    assert(mongos.adminCommand({split : coll + "", find : makeKey(0)}).ok);
+    var chunks = config.chunks.find({ns : coll + ""}).sort({min : 1}).toArray();
+    printjson(chunks);
+    assert.eq(4, chunks.length);
+    assert.eq(makeKey(0), chunks[1].min);
+    assert.eq(makeKey(1), chunks[2].min);
+
+    // the hot key alone can't be split any further
+    assert(!mongos.adminCommand({split : coll + "", find : makeKey(0)}).ok);
+
+    // but the rest of the old chunk can move
+    assert(mongos.adminCommand({moveChunk : coll + "", find : makeKey(1),
+                                to : shards[1]._id}).ok);
+    assert.eq(2010, coll.find().itcount());
+}
+
+test("single", {a : 1}, function(k) { return {a : k}; });
+test("compound", {a : 1, b : 1}, function(k) { return {a : 0, b : k}; });
+
+st.stop();
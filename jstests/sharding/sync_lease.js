@@ -0,0 +1,24 @@
+// Tests that the distributed lock stays exclusive between threads when released locks are kept
+// under lease and taken back without the config servers
+// NOTE: this test is skipped when running smoke.py with --auth or --keyFile to force authentication
+// in all tests.
+test = new SyncCCTest( "sync_lease" )
+
+var admin = test._connections[0].getDB( "admin" );
+assert( admin.runCommand( { setParameter : 1, distLockLeaseMillis : 200 } ).ok );
+
+x = admin.runCommand( { "_testDistLockWithSyncCluster" : 1 , host : test.url , secs : 5 } )
+printjson( x )
+assert( x.ok );
+assert.lt( 0, x.count );
+
+// nothing stays locked once the leases run out
+sleep( 3000 );
+test._connections.forEach( function( conn ) {
+    assert.eq( 0, conn.getDB( "config" ).locks.count( { _id : "testdistlockwithsync", state : { $ne : 0 } } ) );
+} );
+
+assert( !admin.runCommand( { setParameter : 1, distLockLeaseMillis : -1 } ).ok );
+assert( admin.runCommand( { setParameter : 1, distLockLeaseMillis : 0 } ).ok );
+
+test.stop();
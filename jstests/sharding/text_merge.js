@@ -0,0 +1,54 @@
+//
+// Tests that the text command through mongos merges the results of every shard best score first,
+// returning the same documents as a limit large enough for every match
+//
+
+var st = new ShardingTest({shards : 2, mongos : 1});
+st.stopBalancer();
+
+var mongos = st.s0;
+[mongos, st.shard0, st.shard1].forEach(function(conn) {
+    assert(conn.adminCommand({setParameter : 1, textSearchEnabled : true}).ok);
+});
+
+var coll = mongos.getCollection("foo.bar");
+var shards = mongos.getCollection("config.shards").find().sort({_id : 1}).toArray();
+assert(mongos.adminCommand({enableSharding : coll.getDB() + ""}).ok);
+printjson(mongos.adminCommand({movePrimary : coll.getDB() + "", to : shards[0]._id}));
+assert(mongos.adminCommand({shardCollection : coll + "", key : {_id : 1}}).ok);
+assert(mongos.adminCommand({split : coll + "", middle : {_id : 0}}).ok);
+assert(mongos.adminCommand({moveChunk : coll + "", find : {_id : 0}, to : shards[1]._id}).ok);
+
+var words = ["apple", "banana", "cherry", "date"];
+for (var i = -200; i < 200; i++) {
+    var text = [];
+    for (var j = 0; j <= Math.abs(i) % 7; j++) {
+        text.push(words[(i + j + 200) % words.length]);
+    }
+    coll.insert({_id : i, a : text.join(" ")});
+}
+coll.ensureIndex({a : "text"});
+assert.eq(null, coll.getDB().getLastError());
+
+function search(limit) {
+    var res = coll.runCommand("text", {search : "apple", limit : limit});
+    assert(res.ok, tojson(res));
+    for (var i = 1; i < res.results.length; i++) {
+        assert.gte(res.results[i - 1].score, res.results[i].score);
+    }
+    assert.eq(res.results.length, res.stats.n);
+    return res.results;
+}
+
+var all = search(1000);
+assert.eq(coll.find({a : /apple/}).itcount(), all.length);
+
+[1, 5, 50].forEach(function(limit) {
+    var top = search(limit);
+    assert.eq(limit, top.length);
+    for (var i = 0; i < limit; i++) {
+        assert.eq(all[i].score, top[i].score);
+    }
+});
+
+st.stop();
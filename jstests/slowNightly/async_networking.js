@@ -0,0 +1,56 @@
+// With asyncNetworking set, many connections share a small pool of workers, and each keeps its
+// own lastError, cursors and reply order.
+
+var port = 30001;
+var conn = startMongodEmpty("--port", port, "--dbpath", "/data/db/async_networking",
+                            "--setParameter", "asyncNetworking=true",
+                            "--setParameter", "asyncNetworkingWorkers=2");
+db = conn.getDB("async_networking");
+var t = db.foo;
+
+// More clients than workers, each checking its own errors.
+var writer = function(n) {
+    return "var t = db.getSiblingDB('async_networking').foo;" +
+           "for (var i = 0; i < 2000; ++i) {" +
+           "    t.insert({ _id: " + n + " * 10000 + i, n: " + n + " });" +
+           "    if (i % 100 == 0) {" +
+           "        t.insert({ _id: " + n + " * 10000 });" +
+           "        assert.eq(11000, db.getLastErrorObj().code);" +
+           "        assert(!db.getLastError());" + // a new request clears it
+           "    }" +
+           "}";
+};
+var shells = [];
+for (var n = 0; n < 6; ++n) {
+    shells.push(startParallelShell(writer(n), port));
+}
+
+// Idle connections don't hold workers.
+var idle = [];
+for (var i = 0; i < 20; ++i) {
+    idle.push(new Mongo(conn.host));
+}
+for (var i = 0; i < 50; ++i) {
+    assert.eq(1, db.runCommand({ ping: 1 }).ok);
+}
+shells.forEach(function(join) { join(); });
+assert.eq(12000, t.count());
+idle.forEach(function(c) { assert.eq(6, c.getDB("async_networking").foo.distinct("n").length); });
+
+// Replies bigger than what the reactor buffers, and exhaust cursors, which reply many times to
+// one request.
+var big = new Array(1024 * 1024).toString();
+for (var i = 0; i < 8; ++i) {
+    db.big.insert({ _id: i, s: big });
+}
+assert(!db.getLastError());
+assert.eq(8, db.big.find().batchSize(8).itcount());
+assert.eq(12000, t.find().addOption(DBQuery.Option.exhaust).itcount());
+
+// Messages still route to the right connection after others close.
+idle.forEach(function(c) { c.getDB("admin").runCommand({ ping: 1 }); });
+idle = null;
+gc();
+assert.eq(12000, t.find().itcount());
+
+stopMongod(port);
@@ -0,0 +1,55 @@
+// With collectionLevelLocking set, writes to different collections of a database run under
+// collection locks, and report their lock statistics per collection.
+
+var port = 30001;
+var conn = startMongodEmpty("--port", port, "--dbpath", "/data/db/collection_level_locking",
+                            "--setParameter", "collectionLevelLocking=true");
+db = conn.getDB("collection_level_locking");
+
+// Collections must exist before their writes can take collection locks.
+db.a.insert({ _id: -1 });
+db.b.insert({ _id: -1 });
+db.a.ensureIndex({ x: 1 });
+assert(!db.getLastError());
+
+var writer = function(coll) {
+    return "var t = db." + coll + ";" +
+           "for (var i = 0; i < 20000; ++i) {" +
+           "    t.insert({ _id: i, x: i % 100 });" +
+           "    if (i % 10 == 0) t.update({ _id: i - 5 }, { $inc: { n: 1 } });" +
+           "    if (i % 100 == 0) t.remove({ _id: i - 50 });" +
+           "}" +
+           "assert(!db.getLastError());";
+};
+var pa = startParallelShell(writer("a"), port);
+var pb = startParallelShell(writer("b"), port);
+
+// Readers and commands still work while the writers run.
+for (var i = 0; i < 50; ++i) {
+    db.a.findOne({ x: i });
+    db.b.count();
+    db.c.insert({ i: i }); // creates a collection, so takes the database lock
+}
+assert(!db.getLastError());
+pa();
+pb();
+
+assert.eq(20001 - 200, db.a.count());
+assert.eq(20001 - 200, db.b.count());
+assert.eq(db.a.count(), db.a.find().hint({ x: 1 }).itcount());
+assert.eq(1, db.a.findOne({ _id: 15 }).n);
+assert.eq(50, db.c.count());
+assert(db.a.validate(true).valid);
+assert(db.b.validate(true).valid);
+
+// Each collection has its own lock statistics, and top reports the time spent waiting on locks.
+var locks = db.serverStatus({ collectionLocks: 1 }).collectionLocks;
+assert(locks["collection_level_locking.a"], tojson(locks));
+assert(locks["collection_level_locking.b"], tojson(locks));
+assert.lt(0, locks["collection_level_locking.a"].timeLockedMicros.w);
+
+var top = conn.getDB("admin").runCommand("top");
+assert.commandWorked(top);
+assert(top.totals["collection_level_locking.a"].lockWait, tojson(top));
+
+stopMongod(port);
@@ -0,0 +1,43 @@
+/**
+ * Tests that the TTL monitor deletes a large backlog of expired documents in batches, leaves
+ * the unexpired ones, and reports each index's backlog and delete rate in serverStatus.
+ */
+var t = db.ttl_batches;
+t.drop();
+
+assert.commandWorked(db.adminCommand({setParameter : 1, ttlDeleteBatchSize : 100}));
+
+var now = (new Date()).getTime();
+for (var i = 0; i < 5000; i++) {
+    t.insert({x : new Date(now - 3600 * 1000), i : i});
+}
+for (var i = 0; i < 10; i++) {
+    t.insert({x : new Date(now + 3600 * 1000), i : i});
+}
+assert.eq(null, db.getLastError());
+
+var batches = db.serverStatus().metrics.ttl.deleteBatches;
+t.ensureIndex({x : 1}, {expireAfterSeconds : 60});
+
+assert.soon(function() {
+    return t.count() == 10;
+}, "TTL index on x didn't delete the backlog", 70 * 1000);
+
+assert.eq(10, t.find({x : {$gt : new Date(now)}}).count());
+assert.lte(batches + 50, db.serverStatus().metrics.ttl.deleteBatches);
+
+var ttl = db.serverStatus({ttl : 1}).ttl;
+printjson(ttl);
+var found = false;
+ttl.indexes.forEach(function(idx) {
+    if (idx.ns == t.getFullName()) {
+        found = true;
+        assert.eq("x_1", idx.name);
+        assert.eq(0, idx.backlog);
+    }
+});
+assert(found, "no ttl stats for " + t.getFullName());
+assert.eq(0, ttl.backlog);
+
+assert.commandWorked(db.adminCommand({setParameter : 1, ttlDeleteBatchSize : 500}));
+t.drop();
@@ -0,0 +1,30 @@
+// Test that reconnecting clients resume their SSL session rather than doing a full handshake,
+// and that serverStatus counts both.
+ports = allocatePorts( 2 );
+
+var baseName = "jstests_ssl_ssl_session_resumption";
+
+var md = startMongod( "--port", ports[0], "--dbpath", "/data/db/" + baseName,
+                      "--sslMode", "sslOnly",
+                      "--sslPEMKeyFile", "jstests/libs/server.pem",
+                      "--sslCAFile", "jstests/libs/ca.pem",
+                      "--sslWeakCertificateValidation");
+
+var before = md.getDB( "admin" ).serverStatus().ssl.handshakes;
+for ( var i = 0; i < 10; ++i ) {
+    var conn = new Mongo( "localhost:" + ports[0] );
+    assert.eq( 1, conn.getDB( "admin" ).runCommand( { ping: 1 } ).ok );
+}
+var after = md.getDB( "admin" ).serverStatus().ssl.handshakes;
+
+assert.eq( before.accepted + 10, after.accepted );
+assert.lte( before.acceptedResumed + 9, after.acceptedResumed );
+assert.lt( before.totalMicros, after.totalMicros );
+
+// A cipher config OpenSSL can't make anything of keeps the server from starting.
+var ret = runMongoProgram( "mongod", "--port", ports[1],
+                           "--dbpath", "/data/db/" + baseName + "2",
+                           "--sslMode", "sslOnly",
+                           "--sslPEMKeyFile", "jstests/libs/server.pem",
+                           "--sslCipherConfig", "NO-SUCH-CIPHER" );
+assert.neq( 0, ret );
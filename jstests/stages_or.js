@@ -31,3 +31,44 @@ orix1ix2nodd = {or: {args: {nodes: [ixscan1, ixscan2], dedup:false}}};
 res = db.runCommand({stageDebug: orix1ix2nodd});
 assert.eq(res.ok, 1);
 assert.eq(res.results.length, 20);
+
+// Point scans are in DiskLoc order, so they can be merged.  Stay in DiskLoc order and still dedup.
+t.drop();
+for (var i = 0; i < N; ++i) {
+    t.insert({foo: i % 5, bar: i % 3, baz: i});
+}
+t.ensureIndex({foo: 1})
+t.ensureIndex({bar: 1})
+
+// foo == 2
+ixscan1 = {ixscan: {args:{name: "stages_or", keyPattern:{foo: 1},
+                          startKey: {"": 2}, endKey: {"": 2},
+                          endKeyInclusive: true, direction: 1}}};
+// bar == 1
+ixscan2 = {ixscan: {args:{name: "stages_or", keyPattern:{bar: 1},
+                          startKey: {"": 1}, endKey: {"": 1},
+                          endKeyInclusive: true, direction: 1}}};
+
+var expected = 0;
+for (var i = 0; i < N; ++i) {
+    if (i % 5 == 2 || i % 3 == 1) { ++expected; }
+}
+
+ormerged = {fetch: {args: {node: {or: {args: {nodes: [ixscan1, ixscan2], dedup: true,
+                                              mergeByDiskLoc: true}}}}}};
+res = db.runCommand({stageDebug: ormerged});
+assert.eq(res.ok, 1);
+assert.eq(res.results.length, expected);
+for (var i = 1; i < res.results.length; ++i) {
+    assert.lt(res.results[i - 1].baz, res.results[i].baz);
+}
+
+// No deduping, every match from both scans.
+ormergednodd = {fetch: {args: {node: {or: {args: {nodes: [ixscan1, ixscan2], dedup: false,
+                                                  mergeByDiskLoc: true}}}}}};
+res = db.runCommand({stageDebug: ormergednodd});
+assert.eq(res.ok, 1);
+assert.eq(res.results.length, t.find({foo: 2}).count() + t.find({bar: 1}).count());
+
+// The planner's merged OR gives the same answer.
+assert.eq(expected, t.find({$or: [{foo: 2}, {bar: 1}]}).itcount());
@@ -0,0 +1,44 @@
+// Tests that statsDelta returns the whole serverStatus or top document on a new stream, and
+// afterwards only the fields that changed
+
+var admin = db.getSisterDB("admin");
+var t = db.stats_delta;
+t.drop();
+
+var first = admin.runCommand({statsDelta : "serverStatus"});
+assert.commandWorked(first);
+assert(first.full);
+assert.eq("number", typeof first.changed.opcounters.insert);
+assert(first.changed.host);
+
+t.insert({a : 1});
+assert.eq(null, db.getLastError());
+
+var second = admin.runCommand({statsDelta : "serverStatus", token : first.token});
+assert.commandWorked(second);
+assert(!second.full);
+assert.eq(first.token, second.token);
+assert.eq(undefined, second.changed.host, "unchanged fields are left out");
+assert.gt(second.changed.opcounters.insert, first.changed.opcounters.insert);
+
+// sections are passed through to serverStatus
+var noMetrics = admin.runCommand({statsDelta : "serverStatus", metrics : 0});
+assert(noMetrics.full);
+assert.eq(undefined, noMetrics.changed.metrics);
+
+// a token the server doesn't know starts a new stream
+var unknown = admin.runCommand({statsDelta : "serverStatus", token : NumberLong(12345)});
+assert(unknown.full);
+assert.neq(12345, unknown.token);
+
+var top = admin.runCommand({statsDelta : "top"});
+assert.commandWorked(top);
+assert(top.full);
+assert(top.changed.totals);
+t.findOne();
+var top2 = admin.runCommand({statsDelta : "top", token : top.token});
+assert(top2.changed.totals[t.getFullName()]);
+assert.eq(undefined, top2.changed.totals.note);
+
+assert.commandFailed(admin.runCommand({statsDelta : "listDatabases"}));
+assert.commandFailed(db.runCommand({statsDelta : "serverStatus"}), "admin only");
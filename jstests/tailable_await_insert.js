@@ -0,0 +1,27 @@
+// Tests that an awaitData getMore on a capped collection returns the document inserted while it
+// waits, well before the wait would time out, and that one with nothing new returns empty
+
+var t = db.tailable_await_insert;
+t.drop();
+db.createCollection(t.getName(), {capped : true, size : 64 * 1024});
+t.insert({_id : 0});
+assert.eq(null, db.getLastError());
+
+var cursor = t.find().addOption(DBQuery.Option.tailable).addOption(DBQuery.Option.awaitData);
+assert.eq(0, cursor.next()._id);
+
+// nothing new: the getMore waits out its timeout and returns no documents
+var start = new Date();
+assert(!cursor.hasNext());
+assert.gte(new Date() - start, 1000);
+
+var s = startParallelShell('sleep(1000); db.tailable_await_insert.insert({_id : 1});');
+
+start = new Date();
+assert.soon(function() { return cursor.hasNext(); }, "tailable cursor never saw the insert");
+assert.eq(1, cursor.next()._id);
+// the waiting getMore returns with the insert rather than after its timeout
+assert.lt(new Date() - start, 3500);
+
+s();
+t.drop();
@@ -0,0 +1,47 @@
+// dumprestore_parallel.js
+// Tests that dumping several collections at once, several ranges of each, and compressing the
+// files restores every document, and that restore and bsondump read the compressed files
+
+t = new ToolTest( "dumprestore_parallel" );
+
+c = t.startDB( "foo" );
+var db = c.getDB();
+var str = new Array( 1024 ).toString();
+for ( var i = 0; i < 5; i++ ) {
+    for ( var j = 0; j < 2000; j++ ) {
+        db["coll" + i].insert( { _id : j , s : str } );
+    }
+    db["coll" + i].ensureIndex( { a : 1 } );
+}
+db.createCollection( "capped" , { capped : true , size : 100000 } );
+db.capped.insert( { x : 1 } );
+assert.eq( null , db.getLastError() );
+
+function check( msg ) {
+    for ( var i = 0; i < 5; i++ ) {
+        assert.eq( 2000 , db["coll" + i].count() , msg + " coll" + i );
+        assert.eq( 2 , db["coll" + i].getIndexes().length , msg + " coll" + i + " indexes" );
+    }
+    assert.eq( 1 , db.capped.count() , msg + " capped" );
+    assert( db.capped.isCapped() , msg + " capped" );
+}
+
+assert.eq( 0 , t.runTool( "dump" , "--out" , t.ext , "-j" , "3" ,
+                          "--numCursorsPerCollection" , "4" , "--compress" ) );
+assert( listFiles( t.ext + "/foo" ).some( function( f ) {
+    return /coll0\.bson\.snappy$/.test( f.name );
+} ) , "no compressed files" );
+
+db.dropDatabase();
+assert.eq( 0 , t.runTool( "restore" , "--dir" , t.ext ) );
+check( "compressed" );
+
+assert.eq( 0 , t.runTool( "bsondump" , t.ext + "/foo/coll0.bson.snappy" ) );
+
+resetDbpath( t.ext );
+assert.eq( 0 , t.runTool( "dump" , "--out" , t.ext , "-j" , "1" ) );
+db.dropDatabase();
+assert.eq( 0 , t.runTool( "restore" , "--dir" , t.ext ) );
+check( "serial" );
+
+t.stop();
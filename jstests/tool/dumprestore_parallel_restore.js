@@ -0,0 +1,54 @@
+// dumprestore_parallel_restore.js
+// Tests that restoring several collections at once, each with several insertion workers, restores
+// every document and index, with or without a write concern, and that restoring over the
+// existing documents leaves them alone
+
+t = new ToolTest( "dumprestore_parallel_restore" );
+
+c = t.startDB( "foo" );
+var db = c.getDB();
+var str = new Array( 1024 ).toString();
+for ( var i = 0; i < 5; i++ ) {
+    for ( var j = 0; j < 20000; j++ ) {
+        db["coll" + i].insert( { _id : j , a : j % 100 , s : str } );
+    }
+    db["coll" + i].ensureIndex( { a : 1 } );
+    db["coll" + i].ensureIndex( { s : 1 , a : -1 } );
+}
+db.createCollection( "capped" , { capped : true , size : 100000 } );
+db.capped.insert( { x : 1 } );
+assert.eq( null , db.getLastError() );
+
+function check( msg ) {
+    for ( var i = 0; i < 5; i++ ) {
+        assert.eq( 20000 , db["coll" + i].count() , msg + " coll" + i );
+        assert.eq( 3 , db["coll" + i].getIndexes().length , msg + " coll" + i + " indexes" );
+    }
+    assert.eq( 1 , db.capped.count() , msg + " capped" );
+    assert( db.capped.isCapped() , msg + " capped" );
+}
+
+assert.eq( 0 , t.runTool( "dump" , "--out" , t.ext ) );
+
+db.dropDatabase();
+assert.eq( 0 , t.runTool( "restore" , "--dir" , t.ext , "-j" , "3" ,
+                          "--numInsertionWorkersPerCollection" , "4" ) );
+check( "parallel" );
+
+db.dropDatabase();
+assert.eq( 0 , t.runTool( "restore" , "--dir" , t.ext , "-j" , "1" ,
+                          "--numInsertionWorkersPerCollection" , "1" ) );
+check( "serial" );
+
+// a write concern sends the batches as pipelined write commands
+db.dropDatabase();
+assert.eq( 0 , t.runTool( "restore" , "--dir" , t.ext , "--w" , "1" ,
+                          "--numInsertionWorkersPerCollection" , "2" ) );
+check( "write concern" );
+
+// every insert is a duplicate key, which restore reports without stopping
+assert.eq( 0 , t.runTool( "restore" , "--dir" , t.ext , "--w" , "1" ,
+                          "--numInsertionWorkersPerCollection" , "2" ) );
+check( "duplicates" );
+
+t.stop();
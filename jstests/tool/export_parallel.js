@@ -0,0 +1,38 @@
+// export_parallel.js
+// Tests that exporting over several cursors, in order or not, writes every document once as
+// JSON, a JSON array or CSV
+
+t = new ToolTest( "export_parallel" );
+
+c = t.startDB( "foo" );
+var str = new Array( 1024 ).toString();
+for ( var i = 0; i < 20000; i++ ) {
+    c.insert( { _id : i , a : i % 7 , s : str } );
+}
+assert.eq( null , c.getDB().getLastError() );
+
+function roundTrip( msg , exportArgs , importArgs ) {
+    var f = t.extFile + "." + msg;
+    var args = [ "export" , "--out" , f , "-d" , t.baseName , "-c" , "foo" ].concat( exportArgs );
+    assert.eq( 0 , t.runTool.apply( t , args ) , msg + " export" );
+
+    var imported = c.getDB().bar;
+    imported.drop();
+    args = [ "import" , "--file" , f , "-d" , t.baseName , "-c" , "bar" ].concat( importArgs );
+    assert.eq( 0 , t.runTool.apply( t , args ) , msg + " import" );
+    assert.eq( 20000 , imported.count() , msg );
+    assert.eq( 20000 , imported.distinct( "_id" ).length , msg + " distinct" );
+    assert.eq( str , imported.findOne( { _id : 12345 } ).s , msg + " s" );
+}
+
+roundTrip( "ordered" , [ "--numCursors" , "4" ] , [] );
+roundTrip( "unordered" , [ "--numCursors" , "4" , "--unordered" ] , [] );
+roundTrip( "array" , [ "--numCursors" , "3" , "--jsonArray" ] , [ "--jsonArray" ] );
+roundTrip( "csv" , [ "--numCursors" , "3" , "--csv" , "-f" , "_id,a,s" ] ,
+           [ "--type" , "csv" , "--headerline" ] );
+
+// a query goes back to one cursor
+assert.eq( 0 , t.runTool( "export" , "--out" , t.extFile + ".query" , "-d" , t.baseName , "-c" ,
+                          "foo" , "--numCursors" , "4" , "-q" , "{ a : 3 }" ) );
+
+t.stop();
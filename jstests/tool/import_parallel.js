@@ -0,0 +1,41 @@
+// import_parallel.js
+// Tests that importing with several parsing and insertion workers loads every row, that
+// --maintainInsertionOrder keeps the order of the input
+
+t = new ToolTest( "import_parallel" );
+
+c = t.startDB( "foo" );
+var str = new Array( 512 ).toString();
+for ( var i = 0; i < 30000; i++ ) {
+    c.insert( { _id : i , a : i % 7 , s : str } );
+}
+assert.eq( null , c.getDB().getLastError() );
+
+assert.eq( 0 , t.runTool( "export" , "--out" , t.extFile , "-d" , t.baseName , "-c" , "foo" ) );
+assert.eq( 0 , t.runTool( "export" , "--out" , t.extFile + ".csv" , "-d" , t.baseName , "-c" ,
+                          "foo" , "--csv" , "-f" , "_id,a,s" ) );
+
+c.drop();
+assert.eq( 0 , t.runTool( "import" , "--file" , t.extFile , "-d" , t.baseName , "-c" , "foo" ,
+                          "--numParsingWorkers" , "4" , "--numInsertionWorkers" , "3" ) );
+assert.eq( 30000 , c.count() , "json" );
+assert.eq( 4286 , c.find( { a : 3 } ).count() , "json a" );
+
+c.drop();
+assert.eq( 0 , t.runTool( "import" , "--file" , t.extFile + ".csv" , "-d" , t.baseName , "-c" ,
+                          "foo" , "--type" , "csv" , "--headerline" , "--numParsingWorkers" , "3" ,
+                          "--numInsertionWorkers" , "2" ) );
+assert.eq( 30000 , c.count() , "csv" );
+assert.eq( str , c.findOne( { _id : 12345 } ).s , "csv s" );
+
+// the natural order of the collection follows the file
+c.drop();
+assert.eq( 0 , t.runTool( "import" , "--file" , t.extFile , "-d" , t.baseName , "-c" , "foo" ,
+                          "--numParsingWorkers" , "4" , "--maintainInsertionOrder" ) );
+var n = 0;
+c.find().sort( { $natural : 1 } ).forEach( function( doc ) {
+    assert.eq( n++ , doc._id , "insertion order" );
+} );
+assert.eq( 30000 , n );
+
+t.stop();
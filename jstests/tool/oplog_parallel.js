@@ -0,0 +1,50 @@
+// oplog_parallel.js
+// Tests that mongooplog applies a batch of ops over several writers in order per document, with
+// commands in place, and resumes after the op its checkpoint file records
+
+t = new ToolTest( "oplog_parallel" );
+
+db = t.startDB();
+
+output = db.output;
+var oplog = db.oplog;
+var now = Math.floor( new Date().getTime() / 1000 );
+var inc = 1;
+function op( o ) {
+    o.ts = new Timestamp( now , inc++ );
+    oplog.insert( o );
+}
+
+for ( var i = 0; i < 1000; i++ ) {
+    op( { op : "i" , ns : output.getFullName() , o : { _id : i , x : 0 } } );
+}
+for ( var i = 0; i < 1000; i++ ) {
+    op( { op : "u" , ns : output.getFullName() , o2 : { _id : i } , o : { $inc : { x : 1 } } } );
+}
+op( { op : "c" , ns : db.getName() + ".$cmd" , o : { create : "other" } } );
+for ( var i = 0; i < 500; i++ ) {
+    op( { op : "i" , ns : db.getName() + ".other" , o : { _id : i } } );
+    op( { op : "d" , ns : output.getFullName() , o : { _id : i } } );
+}
+assert.eq( null , db.getLastError() );
+
+var checkpoint = t.root + "_checkpoint";
+removeFile( checkpoint );
+
+t.runTool( "oplog" , "--oplogns" , db.getName() + ".oplog" , "--from" , "127.0.0.1:" + t.port ,
+           "--numWriters" , "4" , "--checkpointFile" , checkpoint );
+
+assert.eq( 500 , output.count() , "after" );
+assert.eq( 500 , output.find( { x : 1 } ).count() , "updates" );
+assert.eq( 500 , db.other.count() , "other" );
+assert.eq( 500 , output.find().sort( { _id : 1 } ).limit( 1 ).next()._id , "deletes" );
+
+// only the op at the checkpoint and the ones after it are applied again
+db.other.drop();
+op( { op : "i" , ns : output.getFullName() , o : { _id : "last" } } );
+t.runTool( "oplog" , "--oplogns" , db.getName() + ".oplog" , "--from" , "127.0.0.1:" + t.port ,
+           "--numWriters" , "4" , "--checkpointFile" , checkpoint );
+assert.eq( 501 , output.count() , "resumed" );
+assert.eq( 0 , db.other.count() , "resumed other" );
+
+t.stop();
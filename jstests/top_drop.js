@@ -0,0 +1,51 @@
+// Tests that top forgets dropped collections and databases, and that namespaces past
+// topMaxNamespaces only count toward the untracked ops
+
+var admin = db.getSisterDB("admin");
+var topDB = db.getSisterDB("top_drop");
+topDB.dropDatabase();
+
+function topTotals() {
+    var res = admin.runCommand({top : 1});
+    assert.commandWorked(res);
+    return res.totals;
+}
+
+for (var i = 0; i < 5; i++) {
+    topDB["c" + i].insert({a : i});
+}
+assert.eq(null, topDB.getLastError());
+
+var totals = topTotals();
+for (var i = 0; i < 5; i++) {
+    assert(totals["top_drop.c" + i], "top_drop.c" + i + " not in top");
+}
+
+// a dropped collection
+assert(topDB.c0.drop());
+totals = topTotals();
+assert.eq(undefined, totals["top_drop.c0"]);
+assert(totals["top_drop.c1"]);
+
+// a dropped database
+assert.commandWorked(topDB.dropDatabase());
+totals = topTotals();
+for (var i = 0; i < 5; i++) {
+    assert.eq(undefined, totals["top_drop.c" + i], "top_drop.c" + i + " still in top");
+}
+
+// past the limit new namespaces aren't tracked
+var old = admin.runCommand({getParameter : 1, topMaxNamespaces : 1}).topMaxNamespaces;
+assert.commandWorked(admin.runCommand({setParameter : 1, topMaxNamespaces : 0}));
+var untracked = db.serverStatus().metrics.top.untrackedOps;
+topDB.untracked.insert({a : 1});
+assert.eq(null, topDB.getLastError());
+assert.eq(undefined, topTotals()["top_drop.untracked"]);
+assert.gt(db.serverStatus().metrics.top.untrackedOps, untracked);
+assert.commandWorked(admin.runCommand({setParameter : 1, topMaxNamespaces : old}));
+
+topDB.untracked.insert({a : 2});
+assert.eq(null, topDB.getLastError());
+assert(topTotals()["top_drop.untracked"]);
+
+topDB.dropDatabase();
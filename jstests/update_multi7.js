@@ -0,0 +1,33 @@
+// Multi-updates that touch no indexed field leave every index right, whether the documents stay
+// in place or move, and changing a partial index's filter field still updates that index
+
+t = db.update_multi7;
+t.drop();
+
+t.ensureIndex({a : 1});
+t.ensureIndex({b : 1}, {partialFilterExpression : {c : {$gt : 5}}});
+for (var i = 0; i < 100; i++) {
+    t.insert({_id : i, a : i % 10, b : i, c : i % 10, d : ""});
+}
+assert.eq(null, db.getLastError());
+
+// stays in place
+t.update({}, {$set : {d : "x"}}, false, true);
+assert.eq(null, db.getLastError());
+assert.eq(100, t.find({d : "x"}).itcount());
+
+// grows enough to move
+t.update({}, {$set : {d : new Array(1024).toString()}}, false, true);
+assert.eq(null, db.getLastError());
+assert.eq(10, t.find({a : 3}).hint({a : 1}).itcount());
+assert.eq(40, t.find({b : {$gte : 0}, c : {$gt : 5}}).hint({b : 1}).itcount());
+
+// the filter field decides which documents the partial index holds
+t.update({c : {$gt : 5}}, {$set : {c : 0}}, false, true);
+assert.eq(null, db.getLastError());
+assert.eq(0, t.find({b : {$gte : 0}, c : {$gt : 5}}).hint({b : 1}).itcount());
+t.update({c : 0}, {$set : {c : 9}}, false, true);
+assert.eq(null, db.getLastError());
+assert.eq(50, t.find({b : {$gte : 0}, c : {$gt : 5}}).hint({b : 1}).itcount());
+
+assert(t.validate(true).valid);
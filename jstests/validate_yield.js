@@ -0,0 +1,45 @@
+// validate_yield.js
+// Tests that validate checks several indexes at once, and that yield and maxMBPerSec scan the
+// records in batches with the lock released in between without changing the result
+
+var t = db.validate_yield;
+t.drop();
+
+for (var i = 0; i < 5000; i++) {
+    t.insert({_id : i, a : i % 100, b : [i, -i], s : "abcdefghij" + i});
+}
+t.ensureIndex({a : 1});
+t.ensureIndex({b : 1});
+t.ensureIndex({s : 1, a : -1});
+assert.eq(null, db.getLastError());
+
+function check(res) {
+    printjson(res);
+    assert(res.valid, "not valid");
+    assert.eq(5000, res.objectsFound);
+    assert.eq(4, res.nIndexes);
+    assert.eq(5000, res.keysPerIndex[t.getFullName() + ".$_id_"]);
+    assert.eq(5000, res.keysPerIndex[t.getFullName() + ".$a_1"]);
+    assert.eq(10000 - 1, res.keysPerIndex[t.getFullName() + ".$b_1"]); // 0 and -0 are one key
+    assert.eq(5000, res.keysPerIndex[t.getFullName() + ".$s_1_a_-1"]);
+}
+
+check(t.validate(true));
+
+var res = t.runCommand("validate", {full : true, yield : true});
+check(res);
+assert(res.yielded);
+
+// 5000 small records at 1MB/s take a moment
+var start = new Date();
+res = t.runCommand("validate", {full : true, maxMBPerSec : 1});
+check(res);
+assert(res.yielded);
+assert.lte(100, new Date() - start);
+
+// one index at a time gives the same answer
+assert.commandWorked(db.adminCommand({setParameter : 1, validateIndexThreads : 1}));
+check(t.validate(true));
+assert.commandWorked(db.adminCommand({setParameter : 1, validateIndexThreads : 0}));
+
+t.drop();
@@ -0,0 +1,31 @@
+// Repeated $where queries reuse pooled scopes, and the pool still works when it's turned off
+
+t = db.where_scope_pool;
+t.drop();
+
+for (var i = 0; i < 10; i++) {
+    t.insert({a : i});
+}
+
+function scopePool() {
+    return db.serverStatus().metrics.scripting.scopePool;
+}
+
+t.find({$where : "this.a > 4"}).itcount();
+var before = scopePool();
+for (var i = 0; i < 5; i++) {
+    assert.eq(5, t.find({$where : "this.a > 4"}).itcount());
+}
+var after = scopePool();
+assert.lt(before.hits, after.hits);
+
+var old = db.adminCommand({getParameter : 1, jsScopePoolSize : 1}).jsScopePoolSize;
+assert.commandWorked(db.adminCommand({setParameter : 1, jsScopePoolSize : 0}));
+before = scopePool();
+for (var i = 0; i < 3; i++) {
+    assert.eq(5, t.find({$where : "this.a > 4"}).itcount());
+}
+after = scopePool();
+assert.eq(before.hits, after.hits);
+assert.lte(before.misses + 3, after.misses);
+assert.commandWorked(db.adminCommand({setParameter : 1, jsScopePoolSize : old}));
@@ -0,0 +1,65 @@
+// Tests that batches of inserts, updates and deletes through the write commands apply every item
+// and report each failure at its index, however the items are grouped under the write lock
+
+var t = db.write_cmd_lock_groups;
+t.drop();
+t.ensureIndex({a : 1}, {unique : true});
+
+function batchOf(n, f) {
+    var items = [];
+    for (var i = 0; i < n; i++) {
+        items.push(f(i));
+    }
+    return items;
+}
+
+function run(itemsPerLock) {
+    assert.commandWorked(db.adminCommand({setParameter : 1,
+                                          internalWriteBatchItemsPerLock : itemsPerLock}));
+    t.remove({});
+    assert.eq(null, db.getLastError());
+
+    var docs = batchOf(1000, function(i) { return {_id : i, a : i}; });
+    docs[500] = {_id : 1000, a : 10}; // duplicate key
+    var res = db.runCommand({insert : t.getName(), documents : docs, ordered : false});
+    assert.eq(999, res.n, tojson(res));
+    assert.eq(1, res.errDetails.length, tojson(res));
+    assert.eq(500, res.errDetails[0].index, tojson(res));
+    assert.eq(999, t.count());
+
+    // an ordered batch stops at its first failure
+    docs = batchOf(10, function(i) { return {_id : 2000 + i, a : 2000 + i}; });
+    docs[5].a = 1;
+    res = db.runCommand({insert : t.getName(), documents : docs, ordered : true});
+    assert.eq(5, res.n, tojson(res));
+    assert.eq(5, res.errDetails[0].index, tojson(res));
+    assert.eq(1004, t.count());
+
+    var updates = batchOf(1000, function(i) {
+        return {q : {_id : i}, u : {$set : {b : i}}, upsert : true};
+    });
+    res = db.runCommand({update : t.getName(), updates : updates});
+    assert(res.ok, tojson(res));
+    // _id 500 was never inserted so it's upserted, which n doesn't count
+    assert.eq(999, res.n, tojson(res));
+    assert.eq(1, res.upserted.length, tojson(res));
+    assert.eq(1000, t.count({b : {$exists : true}}));
+    assert.eq(1005, t.count());
+
+    var deletes = batchOf(500, function(i) { return {q : {_id : i * 2}, limit : 0}; });
+    res = db.runCommand({delete : t.getName(), deletes : deletes});
+    assert(res.ok, tojson(res));
+    assert.eq(500, res.n, tojson(res));
+    assert.eq(505, t.count());
+}
+
+try {
+    run(1);
+    run(7);
+    run(128);
+}
+finally {
+    db.adminCommand({setParameter : 1, internalWriteBatchItemsPerLock : 128});
+}
+
+t.drop();
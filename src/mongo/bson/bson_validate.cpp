@@ -127,6 +127,44 @@ namespace mongo {
             int _startPosition;
         };
 
+        /**
+         * The open objects, innermost last.  Nearly every document nests only a few levels, so
+         * those frames live in the stack itself and only deeper ones cost an allocation, instead
+         * of the first of every validation as with a plain deque.  Pointers to frames stay valid
+         * while frames are pushed above them.
+         */
+        class ValidationFrameStack {
+        public:
+            ValidationFrameStack() : _size( 0 ) {}
+
+            ValidationObjectFrame* push() {
+                if ( _size < kInlineFrames )
+                    return &_inline[_size++];
+                _size++;
+                _overflow.push_back( ValidationObjectFrame() );
+                return &_overflow.back();
+            }
+
+            void pop() {
+                if ( _size > kInlineFrames )
+                    _overflow.pop_back();
+                _size--;
+            }
+
+            ValidationObjectFrame* back() {
+                return _size > kInlineFrames ? &_overflow.back() : &_inline[_size - 1];
+            }
+
+            bool empty() const { return _size == 0; }
+
+        private:
+            enum { kInlineFrames = 32 };
+
+            ValidationObjectFrame _inline[kInlineFrames];
+            std::deque<ValidationObjectFrame> _overflow;
+            size_t _size;
+        };
+
         Status validateElementInfo(Buffer* buffer, ValidationState::State* nextState) {
             Status status = Status::OK();
 
@@ -222,15 +260,14 @@ namespace mongo {
         }
 
         Status validateBSONIterative(Buffer* buffer) {
-            std::deque<ValidationObjectFrame> frames;
+            ValidationFrameStack frames;
             ValidationObjectFrame* curr = NULL;
             ValidationState::State state = ValidationState::BeginObj;
 
             while (state != ValidationState::Done) {
                 switch (state) {
                 case ValidationState::BeginObj:
-                    frames.push_back(ValidationObjectFrame());
-                    curr = &frames.back();
+                    curr = frames.push();
                     curr->setStartPosition(buffer->position());
                     curr->setIsCodeWithScope(false);
                     if (!buffer->readNumber<int>(&curr->expectedSize)) {
@@ -251,12 +288,12 @@ namespace mongo {
                         return Status( ErrorCodes::InvalidBSON,
                                        "bson length doesn't match what we found" );
                     }
-                    frames.pop_back();
+                    frames.pop();
                     if (frames.empty()) {
                         state = ValidationState::Done;
                     }
                     else {
-                        curr = &frames.back();
+                        curr = frames.back();
                         if (curr->isCodeWithScope())
                             state = ValidationState::EndCodeWScope;
                         else
@@ -265,8 +302,7 @@ namespace mongo {
                     break;
                 }
                 case ValidationState::BeginCodeWScope: {
-                    frames.push_back(ValidationObjectFrame());
-                    curr = &frames.back();
+                    curr = frames.push();
                     curr->setStartPosition(buffer->position());
                     curr->setIsCodeWithScope(true);
                     if ( !buffer->readNumber<int>( &curr->expectedSize ) )
@@ -283,10 +319,10 @@ namespace mongo {
                         return Status( ErrorCodes::InvalidBSON,
                                        "bson length for CodeWScope doesn't match what we found" );
                     }
-                    frames.pop_back();
+                    frames.pop();
                     if (frames.empty())
                         return Status(ErrorCodes::InvalidBSON, "unnested CodeWScope");
-                    curr = &frames.back();
+                    curr = frames.back();
                     state = ValidationState::WithinObj;
                     break;
                 }
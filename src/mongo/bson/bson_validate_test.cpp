@@ -213,4 +213,25 @@ namespace {
         ASSERT_NOT_OK(validateBSON(x.objdata(), x.objsize() / 2));
     }
 
+    BSONObj nested( int depth ) {
+        BSONObj x = BSON( "x" << 1 );
+        for ( int i = 0; i < depth; i++ )
+            x = i % 2 ? BSON( "a" << x << "c" << i ) : BSON( "b" << BSON_ARRAY( i << x ) );
+        return x;
+    }
+
+    TEST(BSONValidateFast, DeeplyNestedObject) {
+        // past the frames validation keeps without allocating, and back
+        for ( int depth = 1; depth < 40; depth += 7 ) {
+            BSONObj x = nested( depth );
+            ASSERT_OK(validateBSON(x.objdata(), x.objsize()));
+            ASSERT_NOT_OK(validateBSON(x.objdata(), x.objsize() - 1));
+        }
+
+        BSONObjBuilder b;
+        b.appendCodeWScope( "code", "return a;", nested( 35 ) );
+        BSONObj x = b.obj();
+        ASSERT_OK(validateBSON(x.objdata(), x.objsize()));
+    }
+
 }
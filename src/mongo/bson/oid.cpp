@@ -24,7 +24,6 @@
 #include "mongo/platform/random.h"
 #include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/bson/oid.h"
-#include "mongo/bson/util/atomic_int.h"
 
 #define verify MONGO_verify
 
@@ -33,6 +32,24 @@ BOOST_STATIC_ASSERT( sizeof(mongo::OID) == 12 );
 
 namespace mongo {
 
+namespace {
+
+    // increments OID::init() hands a thread at a time
+    const unsigned kIncBlockSize = 256;
+
+    struct IncBlock {
+        unsigned next;
+        unsigned left;
+    };
+
+#if defined(MONGO_HAVE___THREAD)
+    __thread IncBlock threadIncBlock;
+#elif defined(MONGO_HAVE___DECLSPEC_THREAD)
+    __declspec( thread ) IncBlock threadIncBlock;
+#endif
+
+} // namespace
+
     void OID::hash_combine(size_t &seed) const {
         boost::hash_combine(seed, x);
         boost::hash_combine(seed, y);
@@ -97,8 +114,8 @@ namespace mongo {
     }
 
     void OID::init() {
-        static AtomicUInt inc = static_cast<unsigned>(
-            scoped_ptr<SecureRandom>(SecureRandom::create())->nextInt64());
+        static AtomicUInt32 inc(static_cast<unsigned>(
+            scoped_ptr<SecureRandom>(SecureRandom::create())->nextInt64()));
 
         {
             unsigned t = (unsigned) time(0);
@@ -112,7 +129,19 @@ namespace mongo {
         _machineAndPid = ourMachineAndPid;
 
         {
-            int new_inc = inc++;
+#if defined(MONGO_HAVE___THREAD) || defined(MONGO_HAVE___DECLSPEC_THREAD)
+            // threads reserve increments a block at a time, so that threads creating ids at
+            // once don't all write the counter's cache line.  a thread's own ids still increase.
+            IncBlock& block = threadIncBlock;
+            if ( block.left == 0 ) {
+                block.next = inc.fetchAndAdd( kIncBlockSize );
+                block.left = kIncBlockSize;
+            }
+            --block.left;
+            unsigned new_inc = block.next++;
+#else
+            unsigned new_inc = inc.fetchAndAdd( 1 );
+#endif
             unsigned char *T = (unsigned char *) &new_inc;
             _inc[0] = T[2];
             _inc[1] = T[1];
@@ -20,6 +20,9 @@
 
 #include "mongo/pch.h"
 
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
 #include "mongo/client/connpool.h"
 #include "mongo/client/dbclient_rs.h"
 #include "mongo/client/syncclusterconnection.h"
@@ -143,6 +146,32 @@ namespace mongo {
         }
     }
 
+    void PoolForHost::takeIdleConnections( time_t idleSince, vector<DBClientBase*>& idle ) {
+        vector<StoredConnection> all;
+        while ( ! _pool.empty() ) {
+            StoredConnection c = _pool.top();
+            _pool.pop();
+
+            if ( c.when < idleSince )
+                idle.push_back( c.conn );
+            else
+                all.push_back( c );
+        }
+
+        // push back in the same order so the most recently used stays on top
+        for ( vector<StoredConnection>::reverse_iterator i = all.rbegin(); i != all.rend(); ++i ) {
+            _pool.push( *i );
+        }
+    }
+
+    int PoolForHost::numToWarm() const {
+        if ( _created == 0 )
+            return 0;
+        // done() would throw away anything past the maximum
+        int missing = (int)std::min( _minPerHost, _maxPerHost ) - (int)_pool.size();
+        return missing > 0 ? missing : 0;
+    }
+
 
     PoolForHost::StoredConnection::StoredConnection( DBClientBase * c ) {
         conn = c;
@@ -167,6 +196,7 @@ namespace mongo {
     }
 
     unsigned PoolForHost::_maxPerHost = 50;
+    unsigned PoolForHost::_minPerHost = 0;
 
     // ------ DBConnectionPool ------
 
@@ -251,7 +281,15 @@ namespace mongo {
 
     void DBConnectionPool::release(const string& host, DBClientBase *c) {
         scoped_lock L(_mutex);
-        _pools[PoolKey(host,c->getSoTimeout())].done(this,c);
+        PoolMap::iterator i = _pools.insert( make_pair( PoolKey( host, c->getSoTimeout() ),
+                                                        PoolForHost() ) ).first;
+        int before = i->second.numAvailable();
+        i->second.done(this,c);
+
+        // a bad connection cleared the pool, probably because the host failed over: refill it
+        // now rather than have every request open its own connection
+        if ( i->second.numAvailable() < before && i->second.numToWarm() > 0 )
+            _startMaintenance_inlock( i, vector<DBClientBase*>() );
     }
 
 
@@ -444,8 +482,17 @@ namespace mongo {
             // we need to get the connections inside the lock
             // but we can actually delete them outside
             scoped_lock lk( _mutex );
+            const time_t idleSince = time(0) - kHealthCheckIdleSecs;
             for ( PoolMap::iterator i=_pools.begin(); i!=_pools.end(); ++i ) {
                 i->second.getStaleConnections( toDelete );
+
+                if ( i->second.isMaintaining() )
+                    continue;
+
+                vector<DBClientBase*> idle;
+                i->second.takeIdleConnections( idleSince, idle );
+                if ( ! idle.empty() || i->second.numToWarm() > 0 )
+                    _startMaintenance_inlock( i, idle );
             }
         }
 
@@ -460,6 +507,96 @@ namespace mongo {
         }
     }
 
+    void DBConnectionPool::_startMaintenance_inlock( PoolMap::iterator i,
+                                                     const vector<DBClientBase*>& idle ) {
+        if ( i->second.isMaintaining() || inShutdown() ) {
+            for ( size_t j = 0; j < idle.size(); j++ )
+                i->second.done( this, idle[j] );
+            return;
+        }
+
+        try {
+            boost::thread t( boost::bind( &DBConnectionPool::_maintain, this, i->first, idle ) );
+            i->second.setMaintaining( true );
+        }
+        catch ( boost::thread_resource_error& ) {
+            warning() << "can't start a thread to maintain " << _name << " connections to "
+                      << i->first.ident << endl;
+            for ( size_t j = 0; j < idle.size(); j++ )
+                i->second.done( this, idle[j] );
+        }
+    }
+
+    void DBConnectionPool::_maintain( PoolKey key, vector<DBClientBase*> idle ) {
+        try {
+            for ( size_t i = 0; i < idle.size(); i++ ) {
+                DBClientBase* conn = idle[i];
+                bool alive = false;
+                try {
+                    bool isMaster;
+                    conn->isMaster( isMaster );
+                    alive = ! conn->isFailed();
+                }
+                catch ( const DBException& e ) {
+                    LOG(1) << "idle pooled connection to " << key.ident << " failed check"
+                           << causedBy( e ) << endl;
+                }
+
+                if ( alive ) {
+                    release( key.ident, conn );
+                    continue;
+                }
+
+                try {
+                    onDestroy( conn );
+                }
+                catch ( ... ) {
+                    // we don't care if there was a socket error
+                }
+                delete conn;
+            }
+
+            while ( ! inShutdown() ) {
+                {
+                    scoped_lock lk( _mutex );
+                    if ( _pools[key].numToWarm() == 0 )
+                        break;
+                }
+
+                string errmsg;
+                ConnectionString cs = ConnectionString::parse( key.ident, errmsg );
+                DBClientBase* conn = cs.isValid() ? cs.connect( errmsg, key.timeout ) : NULL;
+                if ( ! conn ) {
+                    LOG(1) << _name << " couldn't warm up a connection to " << key.ident
+                           << causedBy( errmsg ) << endl;
+                    break;
+                }
+
+                try {
+                    onCreate( conn );
+                }
+                catch ( std::exception& e ) {
+                    LOG(1) << _name << " couldn't warm up a connection to " << key.ident
+                           << causedBy( e ) << endl;
+                    delete conn;
+                    break;
+                }
+
+                scoped_lock lk( _mutex );
+                PoolForHost& p = _pools[key];
+                p.createdOne( conn );
+                p.done( this, conn );
+            }
+        }
+        catch ( std::exception& e ) {
+            warning() << "error maintaining " << _name << " connections to " << key.ident
+                      << causedBy( e ) << endl;
+        }
+
+        scoped_lock lk( _mutex );
+        _pools[key].setMaintaining( false );
+    }
+
     // ------ ScopedDbConnection ------
 
     void ScopedDbConnection::_setSocketTimeout(){
@@ -35,12 +35,13 @@ namespace mongo {
     class PoolForHost {
     public:
         PoolForHost()
-            : _created(0), _minValidCreationTimeMicroSec(0) {}
+            : _created(0), _minValidCreationTimeMicroSec(0), _maintaining(false) {}
 
         PoolForHost( const PoolForHost& other ) {
             verify(other._pool.size() == 0);
             _created = other._created;
             _minValidCreationTimeMicroSec = other._minValidCreationTimeMicroSec;
+            _maintaining = false;
             verify( _created == 0 );
         }
 
@@ -67,6 +68,24 @@ namespace mongo {
         
         void getStaleConnections( vector<DBClientBase*>& stale );
 
+        /**
+         * Takes out the connections that have sat in the pool since before idleSince, so they
+         * can be checked without holding the pool lock.  They go back through done().
+         */
+        void takeIdleConnections( time_t idleSince, vector<DBClientBase*>& idle );
+
+        /**
+         * @return how many idle connections short of getMinPerHost() this pool is, 0 for a
+         *     host that has never been used.
+         */
+        int numToWarm() const;
+
+        /**
+         * Only one background health check or warm-up runs per pool at a time.
+         */
+        bool isMaintaining() const { return _maintaining; }
+        void setMaintaining( bool maintaining ) { _maintaining = maintaining; }
+
         /**
          * Sets the lower bound for creation times that can be considered as
          *     good connections.
@@ -86,6 +105,13 @@ namespace mongo {
 
         static void setMaxPerHost( unsigned max ) { _maxPerHost = max; }
         static unsigned getMaxPerHost() { return _maxPerHost; }
+
+        /**
+         * Idle connections kept open in the background to each host that has been used.
+         * 0, the default, turns the warm-up off.
+         */
+        static void setMinPerHost( unsigned min ) { _minPerHost = min; }
+        static unsigned getMinPerHost() { return _minPerHost; }
     private:
 
         struct StoredConnection {
@@ -103,8 +129,10 @@ namespace mongo {
         int64_t _created;
         uint64_t _minValidCreationTimeMicroSec;
         ConnectionString::ConnectionType _type;
+        bool _maintaining;
 
         static unsigned _maxPerHost;
+        static unsigned _minPerHost;
     };
 
     class DBConnectionHook {
@@ -179,7 +207,16 @@ namespace mongo {
         };
 
         virtual string taskName() const { return "DBConnectionPool-cleaner"; }
-        virtual void taskDoWork();        
+
+        /**
+         * Deletes the stale connections, then starts a background health check of the
+         * connections idle for kHealthCheckIdleSecs and a warm-up to getMinPerHost() for
+         * every host that has been used.
+         */
+        virtual void taskDoWork();
+
+        /** pooled connections unused for this long get pinged by taskDoWork */
+        static const int kHealthCheckIdleSecs = 30;
 
     private:
         DBConnectionPool( DBConnectionPool& p );
@@ -200,6 +237,15 @@ namespace mongo {
 
         typedef map<PoolKey,PoolForHost,poolKeyCompare> PoolMap; // servername -> pool
 
+        /**
+         * Starts a thread to check the given idle connections of one pool and then bring it
+         * up to getMinPerHost(), unless one is already running for that pool.  Each host gets
+         * its own thread so that a host which stopped answering can't hold up the others, and
+         * requests never wait on these connects.
+         */
+        void _startMaintenance_inlock( PoolMap::iterator i, const vector<DBClientBase*>& idle );
+        void _maintain( PoolKey key, vector<DBClientBase*> idle );
+
         mongo::mutex _mutex;
         string _name;
         
@@ -31,6 +31,7 @@
 #include "mongo/s/stale_exception.h"  // for RecvStaleConfigException
 #include "mongo/util/assert_util.h"
 #include "mongo/util/md5.hpp"
+#include "mongo/util/net/message_compression.h"
 #include "mongo/util/net/ssl_manager.h"
 #include "mongo/util/net/ssl_options.h"
 
@@ -895,13 +896,34 @@ namespace mongo {
         int sslModeVal = sslGlobalParams.sslMode.load();
         if (sslModeVal == SSLGlobalParams::SSLMode_sendAcceptSSL ||
             sslModeVal == SSLGlobalParams::SSLMode_sslOnly) {
-            return p->secure( sslManager() );
+            if ( !p->secure( sslManager() ) )
+                return false;
         }
 #endif
 
+        if ( messageCompressionEnabled )
+            _negotiateCompression();
+
         return true;
     }
 
+    void DBClientConnection::_negotiateCompression() {
+        BSONObjBuilder cmd;
+        cmd.append( "isMaster", 1 );
+        appendMessageCompressionRequest( cmd );
+        try {
+            // a server that doesn't know about compression ignores the request
+            BSONObj res;
+            if ( runCommand( "admin", cmd.obj(), res ) && messageCompressionAccepted( res ) )
+                p->startCompressing( false );
+        }
+        catch ( DBException& e ) {
+            // the connection's use will report whatever's wrong with it
+            LOG(1) << "couldn't negotiate compression with " << _serverString << ": " << e
+                   << endl;
+        }
+    }
+
     void DBClientConnection::logout(const string& dbname, BSONObj& info){
         authCache.erase(dbname);
         runCommand(dbname, BSON("logout" << 1), info);
@@ -30,6 +30,7 @@
 #include "mongo/db/dbmessage.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/json.h"
+#include "mongo/platform/random.h"
 #include "mongo/util/background.h"
 #include "mongo/util/concurrency/mutex.h" // for StaticObserver
 #include "mongo/util/scopeguard.h"
@@ -37,6 +38,10 @@
 
 namespace mongo {
 
+    // in dbclient.cpp
+    void assembleRequest( const string &ns, BSONObj query, int nToReturn, int nToSkip,
+                          const BSONObj *fieldsToReturn, int queryOptions, Message &toSend );
+
     /*  Replica Set statics:
      *      If a program (such as one built with the C++ driver) exits (by either calling exit()
      *      or by returning from main()), static objects will be destroyed in the reverse order
@@ -229,6 +234,17 @@ namespace mongo {
         return false;
     }
 
+    SimpleMutex randomIndexMutex("ReplicaSetMonitorRandomIndex");
+    PseudoRandom randomIndexGenerator(static_cast<int64_t>(curTimeMicros64()));
+
+    /**
+     * @return a number in [0, max)
+     */
+    size_t nextRandomIndex(size_t max) {
+        SimpleMutex::scoped_lock lk(randomIndexMutex);
+        return static_cast<uint32_t>(randomIndexGenerator.nextInt32()) % max;
+    }
+
     /**
      * Selects the right node given the nodes to pick from and the preference.
      * This method does strict tag matching, and will not implicitly fallback
@@ -258,6 +274,9 @@ namespace mongo {
                             bool* isPrimarySelected) {
         HostAndPort fallbackHost;
 
+        // local candidates, in round robin order
+        vector<size_t> localNodes;
+
         // Implicit: start from index 0 if lastHost doesn't exist anymore
         size_t nextNodeIndex = 0;
 
@@ -293,13 +312,30 @@ namespace mongo {
                 *isPrimarySelected = node.ismaster;
 
                 if (node.isLocalSecondary(localThresholdMillis)) {
-                    // found a local node.  return early.
-                    LOG(2) << "dbclient_rs selecting local secondary " << fallbackHost
-                                      << ", ping time: " << node.pingTimeMillis << endl;
-                    *lastHost = fallbackHost;
-                    return fallbackHost;
+                    localNodes.push_back(nextNodeIndex);
+                }
+            }
+        }
+
+        if (!localNodes.empty()) {
+            // power of two choices: the round robin pick against a random other local node,
+            // so reads move off members that are slow or backed up right now
+            const ReplicaSetMonitor::Node* selected = &nodes[localNodes[0]];
+            if (localNodes.size() > 1) {
+                const ReplicaSetMonitor::Node& other =
+                        nodes[localNodes[1 + nextRandomIndex(localNodes.size() - 1)]];
+                if (other.loadScore() < selected->loadScore()) {
+                    selected = &other;
                 }
             }
+
+            LOG(2) << "dbclient_rs selecting local secondary " << selected->addr
+                              << ", ping time: " << selected->pingTimeMillis
+                              << ", latency: " << selected->latencyMicros << "us"
+                              << ", in flight: " << selected->inFlight << endl;
+            *isPrimarySelected = selected->ismaster;
+            *lastHost = selected->addr;
+            return selected->addr;
         }
 
         if (!fallbackHost.empty()) {
@@ -731,6 +767,41 @@ namespace mongo {
         }
     }
 
+    void ReplicaSetMonitor::notifyRequestStart( const string& server ) {
+        scoped_lock lk( _lock );
+        int x = _find_inlock( server );
+        if ( x >= 0 ) {
+            _nodes[x].inFlight++;
+        }
+    }
+
+    void ReplicaSetMonitor::notifyRequestDone( const string& server, long long micros,
+                                               bool succeeded ) {
+        scoped_lock lk( _lock );
+        int x = _find_inlock( server );
+        if ( x < 0 ) {
+            return;
+        }
+
+        Node& node = _nodes[x];
+        // the node may have been replaced while the request was in flight
+        if ( node.inFlight > 0 ) {
+            node.inFlight--;
+        }
+
+        if ( !succeeded ) {
+            return;
+        }
+
+        if ( node.latencyMicros == 0 ) {
+            node.latencyMicros = micros;
+        }
+        else {
+            // same smoothing as the ping time (1/4th the delta)
+            node.latencyMicros += ( micros - node.latencyMicros ) / 4;
+        }
+    }
+
     NodeDiff ReplicaSetMonitor::_getHostDiff_inlock( const BSONObj& hostList ){
 
         NodeDiff diff;
@@ -1096,6 +1167,8 @@ namespace mongo {
             builder.append("hidden", node.hidden);
             builder.append("secondary", node.secondary);
             builder.append("pingTimeMillis", node.pingTimeMillis);
+            builder.append("latencyMicros", node.latencyMicros);
+            builder.append("inFlight", node.inFlight);
 
             const BSONElement& tagElem = node.lastIsMaster["tags"];
             if (tagElem.ok() && tagElem.isABSONObj()) {
@@ -1147,6 +1220,26 @@ namespace mongo {
         return candidate;
     }
 
+    HostAndPort ReplicaSetMonitor::selectNodeExcept(ReadPreference preference,
+                                                    TagSet* tags,
+                                                    const string& exclude,
+                                                    bool* isPrimarySelected) {
+        vector<Node> nodes;
+        HostAndPort lastHost;
+        {
+            scoped_lock lk(_lock);
+            for (vector<Node>::const_iterator iter = _nodes.begin(); iter != _nodes.end(); ++iter) {
+                if (iter->addr.toString() != exclude) {
+                    nodes.push_back(*iter);
+                }
+            }
+            lastHost = _lastReadPrefHost;
+        }
+
+        return ReplicaSetMonitor::selectNode(nodes, preference, tags, _localThresholdMillis,
+                &lastHost, isPrimarySelected);
+    }
+
     // static
     HostAndPort ReplicaSetMonitor::selectNode(const std::vector<Node>& nodes,
                                               ReadPreference preference,
@@ -1414,12 +1507,46 @@ namespace mongo {
 
     const size_t DBClientReplicaSet::MAX_RETRY = 3;
 
+    int DBClientReplicaSet::hedgedReadDelayMillis = 0;
+
+    namespace {
+        /**
+         * Counts a request to a member of the set as in flight with the monitor while this is
+         * alive, and reports its latency once done() is called.
+         */
+        class SecondaryRequest : boost::noncopyable {
+        public:
+            SecondaryRequest( const ReplicaSetMonitorPtr& monitor, DBClientConnection* conn )
+                : _monitor( monitor ), _host( conn->getServerAddress() ), _done( false ) {
+                _monitor->notifyRequestStart( _host );
+            }
+
+            ~SecondaryRequest() {
+                if ( !_done )
+                    _monitor->notifyRequestDone( _host, 0, false );
+            }
+
+            void done() {
+                _done = true;
+                _monitor->notifyRequestDone( _host, static_cast<long long>( _timer.micros() ),
+                                             true );
+            }
+
+        private:
+            ReplicaSetMonitorPtr _monitor;
+            string _host;
+            Timer _timer;
+            bool _done;
+        };
+    } // namespace
+
     DBClientReplicaSet::DBClientReplicaSet( const string& name , const vector<HostAndPort>& servers, double so_timeout )
         : _setName( name ), _so_timeout( so_timeout ) {
         ReplicaSetMonitor::createIfNeeded( name, servers );
     }
 
     DBClientReplicaSet::~DBClientReplicaSet() {
+        _finishLazyRequest( false );
     }
 
     ReplicaSetMonitorPtr DBClientReplicaSet::_getMonitor() const {
@@ -1656,9 +1783,11 @@ namespace mongo {
                         break;
                     }
 
+                    SecondaryRequest request(_getMonitor(), conn);
                     auto_ptr<DBClientCursor> cursor = conn->query(ns, query,
                             nToReturn, nToSkip, fieldsToReturn, queryOptions,
                             batchSize);
+                    request.done();
 
                     return checkSlaveQueryResult(cursor);
                 }
@@ -1706,7 +1835,11 @@ namespace mongo {
                         break;
                     }
 
-                    return conn->findOne(ns,query,fieldsToReturn,queryOptions);
+                    SecondaryRequest request(_getMonitor(), conn);
+                    BSONObj result = conn->findOne(ns,query,fieldsToReturn,queryOptions);
+                    request.done();
+
+                    return result;
                 }
                 catch ( const DBException &dbExcep ) {
                     LOG(1) << "can't findone replica set node " << _lastSlaveOkHost << ": "
@@ -1835,8 +1968,10 @@ namespace mongo {
 
     void DBClientReplicaSet::say(Message& toSend, bool isRetry, string* actualServer) {
 
+        _finishLazyRequest( false );
         if (!isRetry)
             _lazyState = LazyState();
+        _lazyState._hedgeReadPref.reset();
 
         const int lastOp = toSend.operation();
         bool slaveOk = false;
@@ -1879,6 +2014,22 @@ namespace mongo {
                         _lazyState._lastOp = lastOp;
                         _lazyState._slaveOk = slaveOk;
                         _lazyState._lastClient = conn;
+
+                        _lazyState._requestHost = conn->getServerAddress();
+                        _lazyState._requestTimer.reset();
+                        _getMonitor()->notifyRequestStart( _lazyState._requestHost );
+
+                        if (hedgedReadDelayMillis > 0 && conn != _master.get() &&
+                                !(qm.queryOptions & (QueryOption_CursorTailable |
+                                                      QueryOption_Exhaust))) {
+                            _lazyState._hedgeReadPref = readPref;
+                            _lazyState._hedgeNS = qm.ns;
+                            _lazyState._hedgeQuery = qm.query.getOwned();
+                            _lazyState._hedgeFields = qm.fields.getOwned();
+                            _lazyState._hedgeToSkip = qm.ntoskip;
+                            _lazyState._hedgeToReturn = qm.ntoreturn;
+                            _lazyState._hedgeOptions = qm.queryOptions;
+                        }
                     }
                     catch ( const DBException& DBExcep ) {
                         LOG(1) << "can't callLazy replica set node " << _lastSlaveOkHost << ": "
@@ -1918,14 +2069,95 @@ namespace mongo {
 
         // TODO: It would be nice if we could easily wrap a conn error as a result error
         try {
-            return _lazyState._lastClient->recv( m );
+            if ( _lazyState._hedgeReadPref )
+                _hedgeLazyRead();
+            bool received = _lazyState._lastClient->recv( m );
+            _finishLazyRequest( received );
+            return received;
         }
         catch( DBException& e ){
+            _finishLazyRequest( false );
             log() << "could not receive data from " << _lazyState._lastClient->toString() << causedBy( e ) << endl;
             return false;
         }
     }
 
+    void DBClientReplicaSet::_finishLazyRequest( bool succeeded ) {
+        if ( _lazyState._requestHost.empty() )
+            return;
+
+        string host;
+        host.swap( _lazyState._requestHost );
+
+        // a hedged read that won leaves the first host with at least this latency
+        ReplicaSetMonitorPtr monitor = ReplicaSetMonitor::get( _setName );
+        if ( monitor ) {
+            monitor->notifyRequestDone( host, static_cast<long long>( _lazyState._requestTimer.micros() ),
+                                        succeeded );
+        }
+    }
+
+    void DBClientReplicaSet::_hedgeLazyRead() {
+        // only the first recv after the say
+        shared_ptr<ReadPreferenceSetting> readPref;
+        readPref.swap( _lazyState._hedgeReadPref );
+
+        DBClientConnection* first = _lazyState._lastClient;
+        vector<MessagingPort*> ports;
+        ports.push_back( &first->port() );
+        if ( MessagingPort::waitForInput( ports, hedgedReadDelayMillis ) == 0 )
+            return;
+
+        shared_ptr<DBClientConnection> second;
+        try {
+            TagSet tags( readPref->tags );
+            tags.reset();
+            bool isPrimarySelected = false;
+            HostAndPort host = _getMonitor()->selectNodeExcept( readPref->pref, &tags,
+                                                                first->getServerAddress(),
+                                                                &isPrimarySelected );
+
+            // the primary connection is versioned in mongos and must stay the only one
+            if ( host.empty() || isPrimarySelected )
+                return;
+
+            string errmsg;
+            second.reset( dynamic_cast<DBClientConnection*>(
+                    ConnectionString( host ).connect( errmsg, _so_timeout ) ) );
+            if ( ! second ) {
+                LOG(1) << "can't hedge read to " << host << causedBy( errmsg ) << endl;
+                return;
+            }
+            second->setReplSetClientCallback( this );
+            _auth( second.get() );
+
+            Message toSend;
+            assembleRequest( _lazyState._hedgeNS, _lazyState._hedgeQuery,
+                             _lazyState._hedgeToReturn, _lazyState._hedgeToSkip,
+                             _lazyState._hedgeFields.isEmpty() ? NULL : &_lazyState._hedgeFields,
+                             _lazyState._hedgeOptions, toSend );
+            second->say( toSend );
+
+            LOG(2) << "dbclient_rs hedged read to " << host << " after "
+                   << first->getServerAddress() << " took " << hedgedReadDelayMillis << "ms"
+                   << endl;
+
+            ports.push_back( &second->port() );
+            int timeoutMillis = _so_timeout > 0 ? static_cast<int>( _so_timeout * 1000 ) : -1;
+            if ( MessagingPort::waitForInput( ports, timeoutMillis ) != 1 )
+                return;
+
+            // the first connection still owes a reply, so it can't be used again
+            _lastSlaveOkConn = second;
+            _lastSlaveOkHost = host;
+            _lazyState._lastClient = second.get();
+        }
+        catch ( const DBException& e ) {
+            LOG(1) << "can't hedge read from " << first->getServerAddress() << causedBy( e )
+                   << endl;
+        }
+    }
+
     void DBClientReplicaSet::checkResponse( const char* data, int nReturned, bool* retry, string* targetHost ){
 
         // For now, do exactly as we did before, so as not to break things.  In general though, we
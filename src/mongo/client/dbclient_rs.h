@@ -26,6 +26,7 @@
 
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/util/net/hostandport.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -62,7 +63,9 @@ namespace mongo {
                 ismaster(false),
                 secondary( false ),
                 hidden( false ),
-                pingTimeMillis( 0 ) {
+                pingTimeMillis( 0 ),
+                latencyMicros( 0 ),
+                inFlight( 0 ) {
             }
 
             bool okForSecondaryQueries() const {
@@ -108,6 +111,15 @@ namespace mongo {
              */
             bool isCompatible(ReadPreference readPreference, const TagSet* tag) const;
 
+            /**
+             * @return how busy this node looks to the requests sent to it: the smoothed
+             *     request latency times the requests still waiting for a reply. Lower is
+             *     better; nodes nothing has been measured against score the lowest.
+             */
+            long long loadScore() const {
+                return ( latencyMicros + 1 ) * ( inFlight + 1 );
+            }
+
             BSONObj toBSON() const;
 
             string toString() const {
@@ -131,6 +143,12 @@ namespace mongo {
 
             int pingTimeMillis;
 
+            // smoothed latency of the requests sent to this node, 0 until one completes
+            long long latencyMicros;
+
+            // requests sent to this node that haven't been answered yet
+            int inFlight;
+
         };
 
         static const double SOCKET_TIMEOUT_SECS;
@@ -146,9 +164,10 @@ namespace mongo {
          *     nodes if multiple nodes matches the other criteria.
          * @param lastHost the host used in the last successful request. This is used for
          *     selecting a different node as much as possible, by doing a simple round
-         *     robin, starting from the node next to this lastHost. This will be overwritten
-         *     with the newly chosen host if not empty, not primary and when preference
-         *     is not Nearest.
+         *     robin, starting from the node next to this lastHost. The node the round
+         *     robin lands on is compared with another random local node and the one with
+         *     the lower Node::loadScore() wins. This will be overwritten with the newly
+         *     chosen host if not empty, not primary and when preference is not Nearest.
          * @param isPrimarySelected out parameter that is set to true if the returned host
          *     is a primary. Cannot be NULL and valid only if returned host is not empty.
          *
@@ -180,6 +199,16 @@ namespace mongo {
                                        TagSet* tags,
                                        bool* isPrimarySelected);
 
+        /**
+         * Like selectAndCheckNode, but never picks the member at address 'exclude' and doesn't
+         * refresh the view of the set or move the round robin along.  Used to find a second
+         * member for a hedged read.
+         */
+        HostAndPort selectNodeExcept(ReadPreference preference,
+                                     TagSet* tags,
+                                     const string& exclude,
+                                     bool* isPrimarySelected);
+
         /**
          * Creates a new ReplicaSetMonitor, if it doesn't already exist.
          */
@@ -262,6 +291,18 @@ namespace mongo {
          */
         void notifySlaveFailure( const HostAndPort& server );
 
+        /**
+         * Notifies the monitor that a request was sent to server and is waiting for a reply.
+         * Every call must be paired with a notifyRequestDone.
+         */
+        void notifyRequestStart( const string& server );
+
+        /**
+         * Notifies the monitor that a request sent to server has finished.  When it
+         * succeeded, micros is folded into the smoothed latency of the node.
+         */
+        void notifyRequestDone( const string& server, long long micros, bool succeeded );
+
         /**
          * checks for current master and new secondaries
          */
@@ -430,6 +471,14 @@ namespace mongo {
 
         /** Call connect() after constructing. autoReconnect is always on for DBClientReplicaSet connections. */
         DBClientReplicaSet( const string& name , const vector<HostAndPort>& servers, double so_timeout=0 );
+
+        /**
+         * When positive, a lazy (say then recv) query sent to a secondary that hasn't started
+         * answering after this many milliseconds is sent again to another eligible secondary,
+         * and whichever answers first is used.  The other connection is closed, since it still
+         * owes a reply.  0, the default, turns hedged reads off.
+         */
+        static int hedgedReadDelayMillis;
         virtual ~DBClientReplicaSet();
 
         /**
@@ -570,6 +619,18 @@ namespace mongo {
 
         void _auth( DBClientConnection * conn );
 
+        /**
+         * Waits hedgedReadDelayMillis for the reply to the lazy query in _lazyState, then sends
+         * it to a second secondary and switches _lazyState to whichever connection answers
+         * first.
+         */
+        void _hedgeLazyRead();
+
+        /**
+         * Reports the lazy request in flight to a secondary, if any, to the monitor as done.
+         */
+        void _finishLazyRequest( bool succeeded );
+
         /**
          * Maximum number of retries to make for auto-retry logic when performing a slave ok
          * operation.
@@ -611,12 +672,26 @@ namespace mongo {
          */
         class LazyState {
         public:
-            LazyState() : _lastClient( NULL ), _lastOp( -1 ), _slaveOk( false ), _retries( 0 ) {}
+            LazyState() : _lastClient( NULL ), _lastOp( -1 ), _slaveOk( false ), _retries( 0 ),
+                          _hedgeToSkip( 0 ), _hedgeToReturn( 0 ), _hedgeOptions( 0 ) {}
             DBClientConnection* _lastClient;
             int _lastOp;
             bool _slaveOk;
             int _retries;
 
+            // set while the query sent to a secondary may still be hedged
+            shared_ptr<ReadPreferenceSetting> _hedgeReadPref;
+            string _hedgeNS;
+            BSONObj _hedgeQuery;
+            BSONObj _hedgeFields;
+            int _hedgeToSkip;
+            int _hedgeToReturn;
+            int _hedgeOptions;
+
+            // the secondary the lazy request is in flight to, reported to the monitor on recv
+            string _requestHost;
+            Timer _requestTimer;
+
         } _lazyState;
 
     };
@@ -102,6 +102,8 @@ namespace mongo {
         }
 
         dataReceived( retry, _lazyHost );
+        if ( ! retry )
+            _prefetchMore();
         return ! retry;
     }
 
@@ -115,9 +117,7 @@ namespace mongo {
         return ok;
     }
 
-    void DBClientCursor::requestMore() {
-        verify( cursorId && batch.pos == batch.nReturned );
-
+    void DBClientCursor::_assembleGetMore( Message& toSend ) {
         if (haveLimit) {
             nToReturn -= batch.nReturned;
             verify(nToReturn > 0);
@@ -128,14 +128,32 @@ namespace mongo {
         b.appendNum(nextBatchSize());
         b.appendNum(cursorId);
 
-        Message toSend;
         toSend.setData(dbGetMore, b.buf(), b.len());
+    }
+
+    void DBClientCursor::requestMore() {
+        verify( cursorId && batch.pos == batch.nReturned );
+
+        if ( _getMorePending ) {
+            _receivePrefetched();
+            return;
+        }
+
+        if ( opts & QueryOption_Exhaust ) {
+            // the server sends each batch without being asked
+            exhaustReceiveMore();
+            return;
+        }
+
+        Message toSend;
+        _assembleGetMore( toSend );
         auto_ptr<Message> response(new Message());
 
         if ( _client ) {
             _client->call( toSend, *response );
             this->batch.m = response;
             dataReceived();
+            _prefetchMore();
         }
         else {
             verify( _scopedHost.size() );
@@ -149,6 +167,103 @@ namespace mongo {
         }
     }
 
+    void DBClientCursor::_prefetchMore() {
+        const int whenLeft = _prefetchWhenLeft == PrefetchAtHalfBatch ?
+                             batch.nReturned / 2 : _prefetchWhenLeft;
+        if ( !_prefetch || _getMorePending || !cursorId || haveLimit ||
+             objsLeftInBatch() > whenLeft ||
+             ( opts & ( QueryOption_CursorTailable | QueryOption_Exhaust ) ) )
+            return;
+
+        if ( !_client ) {
+            // Attached, so borrow a connection until the reply is read
+            if ( _scopedHost.empty() )
+                return;
+            _prefetchConn = new ScopedDbConnection( _scopedHost );
+            _client = _prefetchConn->get();
+        }
+
+        if ( !_client->lazySupported() ) {
+            _releasePrefetchConn();
+            return;
+        }
+
+        Message toSend;
+        _assembleGetMore( toSend );
+        try {
+            _client->say( toSend );
+        }
+        catch ( ... ) {
+            _releasePrefetchConn();
+            throw;
+        }
+        _getMorePending = true;
+
+        if ( _prefetchInBackground ) {
+            _prefetched.reset( new Message() );
+            _prefetchReceived = false;
+            _prefetchThread.reset( new boost::thread( boost::bind(
+                    &DBClientCursor::_backgroundReceive, this ) ) );
+        }
+    }
+
+    void DBClientCursor::_backgroundReceive() {
+        try {
+            _prefetchReceived = _client->recv( *_prefetched );
+        }
+        catch ( std::exception& e ) {
+            LOG(1) << "DBClientCursor background receive failed: " << e.what() << endl;
+            _prefetchReceived = false;
+        }
+    }
+
+    bool DBClientCursor::_recvPrefetched( Message& response ) {
+        if ( !_prefetchThread )
+            return _client->recv( response );
+
+        _prefetchThread->join();
+        _prefetchThread.reset();
+        response.reset();
+        if ( _prefetchReceived )
+            response = *_prefetched;   // takes the buffer over
+        _prefetched.reset();
+        return _prefetchReceived;
+    }
+
+    void DBClientCursor::_receivePrefetched() {
+        _getMorePending = false;
+        auto_ptr<Message> response(new Message());
+        if (!_recvPrefetched(*response)) {
+            _releasePrefetchConn();
+            uasserted(17356, "recv failed while reading prefetched batch");
+        }
+        batch.m = response;
+        try {
+            dataReceived();
+        }
+        catch ( ... ) {
+            _releasePrefetchConn();
+            throw;
+        }
+        _releasePrefetchConn();
+        _prefetchMore();
+    }
+
+    void DBClientCursor::_releasePrefetchConn() {
+        if ( !_prefetchConn )
+            return;
+
+        // A connection with a reply still to read can't go back to the pool
+        if ( !_getMorePending )
+            _prefetchConn->done();
+        else
+            _prefetchConn->kill();
+
+        delete _prefetchConn;
+        _prefetchConn = NULL;
+        _client = 0;
+    }
+
     /** with QueryOption_Exhaust, the server just blasts data at us (marked at end with cursorid==0). */
     void DBClientCursor::exhaustReceiveMore() {
         verify( cursorId && batch.pos == batch.nReturned );
@@ -235,10 +350,36 @@ namespace mongo {
         batch.pos++;
         BSONObj o(batch.data);
         batch.data += o.objsize();
+
+        if ( _prefetch && !_getMorePending )
+            _prefetchMore();
         /* todo would be good to make data null at end of batch for safety */
         return o;
     }
 
+    bool DBClientCursor::nextBatch( DBClientBatch* out ) {
+        massert( 17380, "DBClientCursor nextBatch() called with objects put back",
+                 _putBack.empty() );
+        if ( !more() )
+            return false;
+
+        int n = batch.nReturned - batch.pos;
+        if ( haveLimit && nToReturn - batch.pos < n )
+            n = nToReturn - batch.pos;
+
+        *out = DBClientBatch( batch.m, batch.data, n );
+
+        // skip over them without copying, reading only the lengths
+        for ( int i = 0; i < n; i++ ) {
+            batch.data += BSONObj( batch.data ).objsize();
+        }
+        batch.pos += n;
+
+        if ( _prefetch && !_getMorePending )
+            _prefetchMore();
+        return true;
+    }
+
     void DBClientCursor::peek(vector<BSONObj>& v, int atMost) {
         int m = atMost;
 
@@ -286,6 +427,7 @@ namespace mongo {
 
     void DBClientCursor::attach( AScopedConnection * conn ) {
         verify( _scopedHost.size() == 0 );
+        verify( !_getMorePending );
         verify( conn );
         verify( conn->get() );
 
@@ -313,6 +455,19 @@ namespace mongo {
 
         DESTRUCTOR_GUARD (
 
+        if ( _getMorePending ) {
+            // leave the connection as the next user expects it
+            Message unread;
+            _recvPrefetched( unread );
+            _getMorePending = false;
+        }
+
+        );
+
+        DESTRUCTOR_GUARD( _releasePrefetchConn(); );
+
+        DESTRUCTOR_GUARD (
+
         if ( cursorId && _ownCursor && ! inShutdown() ) {
             BufBuilder b;
             b.appendNum( (int)0 ); // reserved
@@ -19,6 +19,7 @@
 
 #include "mongo/pch.h"
 
+#include <boost/thread/thread.hpp>
 #include <stack>
 
 #include "mongo/client/dbclientinterface.h"
@@ -29,6 +30,7 @@
 namespace mongo {
 
     class AScopedConnection;
+    class ScopedDbConnection;
 
     /** for mock purposes only -- do not create variants of DBClientCursor, nor hang code here 
         @see DBClientMockCursor
@@ -43,6 +45,49 @@ namespace mongo {
         DBClientCursorInterface() {}
     };
 
+    /**
+     * The documents of one reply to a query or getMore, which stay valid for as long as the
+     * DBClientBatch or a copy of it does rather than only until the cursor reads its next batch.
+     * Copies share the reply, so nothing is copied per document.  As with next(), an error
+     * reply holds a single { $err : ... } document.
+     */
+    class DBClientBatch {
+    public:
+        DBClientBatch() : _data( NULL ), _n( 0 ) {}
+
+        int size() const { return _n; }
+        bool empty() const { return _n == 0; }
+
+        /** Walks the documents of a batch in order; each is valid while the batch is. */
+        class Iterator {
+        public:
+            bool more() const { return _left > 0; }
+            BSONObj next() {
+                verify( more() );
+                BSONObj o( _data );
+                _data += o.objsize();
+                _left--;
+                return o;
+            }
+        private:
+            friend class DBClientBatch;
+            Iterator( const char* data, int n ) : _data( data ), _left( n ) {}
+            const char* _data;
+            int _left;
+        };
+
+        Iterator iterator() const { return Iterator( _data, _n ); }
+
+    private:
+        friend class DBClientCursor;
+        DBClientBatch( const boost::shared_ptr<Message>& message, const char* data, int n ) :
+            _message( message ), _data( data ), _n( n ) {}
+
+        boost::shared_ptr<Message> _message;
+        const char* _data;
+        int _n;
+    };
+
     /** Queries return a cursor object */
     class DBClientCursor : public DBClientCursorInterface {
     public:
@@ -68,6 +113,14 @@ namespace mongo {
         */
         BSONObj next();
 
+        /**
+         * Takes the documents left in the current batch, asking the server for the next one if
+         * none are left, as a DBClientBatch that outlives later batches.  Can't be mixed with
+         * putBack().
+         * @return false, leaving 'out' alone, once the cursor has nothing more.
+         */
+        bool nextBatch( DBClientBatch* out );
+
         /**
             restore an object previously returned by next() to the cursor
          */
@@ -132,6 +185,30 @@ namespace mongo {
         /// Change batchSize after construction. Can change after requesting first batch.
         void setBatchSize(int newBatchSize) { batchSize = newBatchSize; }
 
+        /**
+         * Asks for each next batch as soon as no more than whenLeft objects are left in the last
+         * one (by default, as soon as it comes in), so the server works on it while this one is
+         * read; more() then only has to wait for what's left of it.  Only takes effect on
+         * connections that support lazy calls, for cursors without a limit that aren't tailable
+         * or exhaust.  Nothing else may use the connection until the cursor is done.  Attached
+         * cursors borrow a pooled connection from when they ask until the batch is read.
+         *
+         * Exhaust cursors read each batch as the server sends it, and also keep the connection
+         * to themselves; destroy it rather than reuse it once they're done.
+         */
+        void setPrefetch( bool prefetch, int whenLeft = INT_MAX, bool receiveInBackground = false ) {
+            _prefetch = prefetch;
+            _prefetchWhenLeft = whenLeft;
+            _prefetchInBackground = receiveInBackground;
+        }
+
+        /**
+         * For setPrefetch(): ask for the next batch once half of the last one has been read.
+         * With receiveInBackground, a thread reads the prefetched reply off the connection as
+         * it arrives, so the server isn't left waiting on a full socket while this one is read.
+         */
+        static const int PrefetchAtHalfBatch = -1;
+
         DBClientCursor( DBClientBase* client, const string &_ns, BSONObj _query, int _nToReturn,
                         int _nToSkip, const BSONObj *_fieldsToReturn, int queryOptions , int bs ) :
             _client(client),
@@ -146,7 +223,13 @@ namespace mongo {
             resultFlags(0),
             cursorId(),
             _ownCursor( true ),
-            wasError( false ) {
+            wasError( false ),
+            _prefetch( false ),
+            _prefetchWhenLeft( INT_MAX ),
+            _prefetchInBackground( false ),
+            _getMorePending( false ),
+            _prefetchConn( NULL ),
+            _prefetchReceived( false ) {
             _finishConsInit();
         }
 
@@ -162,7 +245,13 @@ namespace mongo {
             resultFlags(0),
             cursorId(_cursorId),
             _ownCursor(true),
-            wasError(false) {
+            wasError(false),
+            _prefetch(false),
+            _prefetchWhenLeft(INT_MAX),
+            _prefetchInBackground(false),
+            _getMorePending(false),
+            _prefetchConn(NULL),
+            _prefetchReceived(false) {
             _finishConsInit();
         }
 
@@ -203,7 +292,7 @@ namespace mongo {
 
         class Batch : boost::noncopyable { 
             friend class DBClientCursor;
-            auto_ptr<Message> m;
+            boost::shared_ptr<Message> m; // shared with the DBClientBatches taken from it
             int nReturned;
             int pos;
             const char *data;
@@ -242,6 +331,23 @@ namespace mongo {
         void requestMore();
         void exhaustReceiveMore(); // for exhaust
 
+        bool _prefetch; // see setPrefetch()
+        int _prefetchWhenLeft;
+        bool _prefetchInBackground;
+        bool _getMorePending; // the reply to a prefetched getMore is yet to be read
+        ScopedDbConnection* _prefetchConn; // what an attached cursor prefetches on, if anything
+        // with _prefetchInBackground, what reads the reply to the pending getMore into
+        // _prefetched, and whether it did
+        boost::scoped_ptr<boost::thread> _prefetchThread;
+        auto_ptr<Message> _prefetched;
+        bool _prefetchReceived;
+        void _assembleGetMore( Message& toSend );
+        void _prefetchMore();
+        void _receivePrefetched();
+        void _backgroundReceive();
+        bool _recvPrefetched( Message& response );
+        void _releasePrefetchConn();
+
         // Don't call from a virtual function
         void _assertIfNull() const { uassert(13348, "connection died", this); }
 
@@ -957,6 +957,12 @@ namespace mongo {
 
         virtual string toString() = 0;
 
+        /**
+         * Look up the options available on this client.  Caches the answer from
+         * _lookupAvailableOptions(), below.
+         */
+        QueryOptions availableOptions();
+
     protected:
         /** if the result of a command is ok*/
         bool isOk(const BSONObj&);
@@ -966,12 +972,6 @@ namespace mongo {
 
         BSONObj _countCmd(const string &ns, const BSONObj& query, int options, int limit, int skip );
 
-        /**
-         * Look up the options available on this client.  Caches the answer from
-         * _lookupAvailableOptions(), below.
-         */
-        QueryOptions availableOptions();
-
         virtual QueryOptions _lookupAvailableOptions();
 
         virtual void _auth(const BSONObj& params);
@@ -1293,6 +1293,9 @@ namespace mongo {
         double _so_timeout;
         bool _connect( string& errmsg );
 
+        /** asks the server, if it's willing, to exchange compressed messages */
+        void _negotiateCompression();
+
         static AtomicUInt _numConnections;
         static bool _lazyKillCursor; // lazy means we piggy back kill cursors on next op
 
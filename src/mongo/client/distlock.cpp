@@ -31,6 +31,7 @@ namespace mongo {
 
     LabeledLevel DistributedLock::logLvl( 1 );
     DistributedLock::LastPings DistributedLock::lastPings;
+    int DistributedLock::leaseMillis = 0;
 
     ThreadLocalValue<string> distLockIds("");
 
@@ -325,6 +326,160 @@ namespace mongo {
 
     } distLockPinger;
 
+    /**
+     * Locks this process released while DistributedLock::leaseMillis is set.  They stay held on
+     * the config servers, pinged as usual, so the next lock_try for them here can take them back
+     * without a round trip.  A background thread unlocks the ones whose lease ran out.
+     */
+    class DistLockLeases {
+    public:
+        DistLockLeases() : _mutex( "DistLockLeases" ), _releaserStarted( false ) {}
+
+        /**
+         * @return true and the held lock document in lockDoc if 'lock' was released by this
+         *     process and its lease is still valid
+         */
+        bool reacquire( const DistributedLock& lock, BSONObj* lockDoc ) {
+            scoped_lock lk( _mutex );
+
+            LeaseMap::iterator it = _leases.find( key( lock ) );
+            if ( it == _leases.end() || it->second.inUse ||
+                    it->second.processId != lock._processId ||
+                    it->second.expiresMillis <= curTimeMillis64() ) {
+                return false;
+            }
+
+            it->second.inUse = true;
+            *lockDoc = it->second.lockDoc;
+            return true;
+        }
+
+        /**
+         * @return true if 'lock', held as lockDoc, is kept under lease instead of being unlocked
+         */
+        bool release( const DistributedLock& lock, const BSONObj& lockDoc ) {
+            const int leaseMillis = DistributedLock::leaseMillis;
+            const unsigned long long now = curTimeMillis64();
+
+            scoped_lock lk( _mutex );
+
+            LeaseMap::iterator it = _leases.find( key( lock ) );
+            if ( it != _leases.end() &&
+                    it->second.lockDoc[LocksType::lockID()].OID() !=
+                    lockDoc[LocksType::lockID()].OID() ) {
+                // taken again through the config servers since
+                _leases.erase( it );
+                it = _leases.end();
+            }
+
+            if ( leaseMillis <= 0 || lockDoc[LocksType::process()].str() != lock._processId ) {
+                if ( it != _leases.end() )
+                    _leases.erase( it );
+                return false;
+            }
+
+            if ( it == _leases.end() ) {
+                Lease lease;
+                lease.conn = lock._conn;
+                lease.processId = lock._processId;
+                lease.lockTimeout = lock._lockTimeout;
+                lease.lockDoc = lockDoc.getOwned();
+                lease.renewUntilMillis =
+                        now + leaseMillis * static_cast<unsigned long long>(
+                                DistributedLock::LEASE_RENEWALS_MAX );
+                it = _leases.insert( make_pair( key( lock ), lease ) ).first;
+            }
+
+            if ( now >= it->second.renewUntilMillis ) {
+                // let everyone else have a go
+                _leases.erase( it );
+                return false;
+            }
+
+            it->second.inUse = false;
+            it->second.expiresMillis = std::min( now + leaseMillis, it->second.renewUntilMillis );
+
+            if ( !_releaserStarted ) {
+                boost::thread releaser( boost::bind( &DistLockLeases::_releaseExpired, this ) );
+                _releaserStarted = true;
+            }
+            _leaseReleased.notify_one();
+            return true;
+        }
+
+    private:
+        struct Lease {
+            Lease() : lockTimeout( 0 ), expiresMillis( 0 ), renewUntilMillis( 0 ),
+                      inUse( true ) {}
+
+            ConnectionString conn;
+            string processId;
+            unsigned long long lockTimeout;
+            BSONObj lockDoc;
+            unsigned long long expiresMillis;
+            unsigned long long renewUntilMillis;
+            bool inUse;
+        };
+
+        typedef map< pair<string, string>, Lease > LeaseMap;
+
+        static pair<string, string> key( const DistributedLock& lock ) {
+            return make_pair( lock._conn.toString(), lock._name );
+        }
+
+        void _releaseExpired() {
+            setThreadName( "DistLockLeases" );
+
+            while ( true ) {
+                vector< pair<string, Lease> > expired;
+                {
+                    scoped_lock lk( _mutex );
+
+                    const unsigned long long now = curTimeMillis64();
+                    unsigned long long nextMillis = now + 1000;
+                    for ( LeaseMap::iterator it = _leases.begin(); it != _leases.end(); ) {
+                        if ( it->second.inUse ) {
+                            ++it;
+                        }
+                        else if ( it->second.expiresMillis <= now || inShutdown() ) {
+                            expired.push_back( make_pair( it->first.second, it->second ) );
+                            _leases.erase( it++ );
+                        }
+                        else {
+                            nextMillis = std::min( nextMillis, it->second.expiresMillis );
+                            ++it;
+                        }
+                    }
+
+                    if ( expired.empty() && !inShutdown() ) {
+                        _leaseReleased.timed_wait( lk.boost(),
+                                boost::posix_time::milliseconds( nextMillis - now ) );
+                        continue;
+                    }
+                }
+
+                for ( size_t i = 0; i < expired.size(); i++ ) {
+                    Lease& lease = expired[i].second;
+                    LOG( DistributedLock::logLvl ) << "lease expired for distributed lock "
+                                                   << expired[i].first << endl;
+
+                    DistributedLock lock( lease.conn, expired[i].first, lease.lockTimeout );
+                    lock._unlock( &lease.lockDoc );
+                }
+
+                if ( inShutdown() )
+                    return;
+            }
+        }
+
+        // Protects all of the members below.
+        mongo::mutex _mutex;
+        boost::condition _leaseReleased;
+        LeaseMap _leases;
+        bool _releaserStarted;
+
+    } distLockLeases;
+
     /**
      * Create a new distributed lock, potentially with a custom sleep and takeover time.  If a custom sleep time is
      * specified (time between pings)
@@ -576,6 +731,13 @@ namespace mongo {
         if ( other == NULL )
             other = &dummyOther;
 
+        if ( !reenter && distLockLeases.reacquire( *this, other ) ) {
+            LOG( logLvl - 1 ) << "distributed lock '" << _name << "/" << _processId
+                              << "' reacquired under lease, ts : "
+                              << (*other)[LocksType::lockID()].OID() << endl;
+            return true;
+        }
+
         ScopedDbConnection conn(_conn.toString(), timeout );
 
         BSONObjBuilder queryBuilder;
@@ -1018,6 +1180,22 @@ namespace mongo {
 
         verify( _name != "" );
 
+        if ( oldLockPtr && ( *oldLockPtr )[LocksType::state()].numberInt() == 2 &&
+                ( *oldLockPtr )[LocksType::lockID()].type() == jstOID &&
+                distLockLeases.release( *this, *oldLockPtr ) ) {
+            LOG( logLvl - 1 ) << "distributed lock '" << _name << "/" << _processId
+                              << "' released under lease, ts : "
+                              << ( *oldLockPtr )[LocksType::lockID()].OID() << endl;
+            return;
+        }
+
+        _unlock( oldLockPtr );
+    }
+
+    void DistributedLock::_unlock( BSONObj* oldLockPtr ) {
+
+        verify( _name != "" );
+
         string lockName = _name + string("/") + _processId;
 
         const int maxAttempts = 3;
@@ -134,7 +134,9 @@ namespace mongo {
         bool isLockHeld( double timeout, string* errMsg );
 
         /**
-         * Releases a previously taken lock.
+         * Releases a previously taken lock.  While leaseMillis is set, the lock stays held on
+         * the config servers for that long so this process can take it back without going
+         * through the config servers again.
          */
         void unlock( BSONObj* oldLockPtr = NULL );
 
@@ -158,6 +160,15 @@ namespace mongo {
 
         static bool killPinger( DistributedLock& lock );
 
+        /**
+         * How long, in milliseconds, a lock this process released is kept so that lock_try can
+         * take it back locally.  Each local reacquire renews the lease, up to
+         * LEASE_RENEWALS_MAX times its length.  0 (the default) unlocks right away.
+         */
+        static int leaseMillis;
+
+        static const int LEASE_RENEWALS_MAX = 10;
+
         /**
          * Namespace for lock pings
          */
@@ -179,6 +190,12 @@ namespace mongo {
         const unsigned long long _lockPing;
 
     private:
+        friend class DistLockLeases;
+
+        /**
+         * Unlocks on the config servers, ignoring any lease.
+         */
+        void _unlock( BSONObj* oldLockPtr );
 
         void resetLastPing(){ lastPings.setLastPing( _conn, _name, PingData() ); }
         void setLastPing( const PingData& pd ){ lastPings.setLastPing( _conn, _name, pd ); }
@@ -83,7 +83,8 @@ namespace mongo {
                                            std::vector<Privilege>* out) {}
         static void runThread() {
             while (keepGoing) {
-                if (current->lock_try( "test" )) {
+                BSONObj lockObj;
+                if (current->lock_try( "test", false, &lockObj )) {
                     count++;
                     int before = count;
                     sleepmillis(3);
@@ -94,7 +95,7 @@ namespace mongo {
                                 << endl;
                     }
 
-                    current->unlock();
+                    current->unlock( &lockObj );
                 }
             }
         }
@@ -30,6 +30,7 @@
 #endif
 
 #include "mongo/client/dbclientcursor.h"
+#include "mongo/client/write_pipeline.h"
 
 #ifndef MIN
 #define MIN(a,b) ( (a) < (b) ? (a) : (b) )
@@ -39,6 +40,48 @@
 namespace mongo {
 
     const unsigned DEFAULT_CHUNK_SIZE = 256 * 1024;
+    const int DEFAULT_MAX_IN_FLIGHT = 16;
+
+    namespace {
+
+        /**
+         * Inserts a file's chunks.  Where the connection can pipeline write commands, up to
+         * maxInFlight of them await acknowledgement at once, so a failed insert is reported
+         * without letting the transfer wait on every round trip; otherwise they're sent
+         * unacknowledged as before.
+         */
+        class ChunkInserter {
+        public:
+            ChunkInserter( DBClientBase& client , const string& ns , int maxInFlight )
+                : _client( client ) , _ns( ns ) {
+                if ( maxInFlight > 1 && DBClientWritePipeline::supported( &client ) )
+                    _pipeline.reset( new DBClientWritePipeline( &client , BSONObj() , maxInFlight ) );
+            }
+
+            void insert( const BSONObj& chunk ) {
+                if ( ! _pipeline ) {
+                    _client.insert( _ns , chunk );
+                    return;
+                }
+                _pipeline->insert( _ns , vector<BSONObj>( 1 , chunk ) );
+            }
+
+            /** waits for the chunks in flight, uasserting if any failed */
+            void finish( const string& name ) {
+                if ( ! _pipeline || _pipeline->flush() == 0 )
+                    return;
+                uasserted( 16428,
+                           str::stream() << "Error storing GridFS chunk for file: " << name
+                                         << ", error: " << _pipeline->errors()[0].reply );
+            }
+
+        private:
+            DBClientBase& _client;
+            const string _ns;
+            boost::scoped_ptr<DBClientWritePipeline> _pipeline;
+        };
+
+    } // namespace
 
     GridFSChunk::GridFSChunk( BSONObj o ) {
         _data = o;
@@ -57,6 +100,7 @@ namespace mongo {
         _filesNS = dbName + "." + prefix + ".files";
         _chunksNS = dbName + "." + prefix + ".chunks";
         _chunkSize = DEFAULT_CHUNK_SIZE;
+        _maxInFlight = DEFAULT_MAX_IN_FLIGHT;
 
         client.ensureIndex( _filesNS , BSON( "filename" << 1 ) );
         client.ensureIndex( _chunksNS , BSON( "files_id" << 1 << "n" << 1 ) , /*unique=*/true );
@@ -75,6 +119,15 @@ namespace mongo {
         return _chunkSize;
     }
 
+    void GridFS::setMaxInFlight(int n) {
+        massert( 17384 , "max chunks in flight must be at least 1", n >= 1 );
+        _maxInFlight = n;
+    }
+
+    int GridFS::getMaxInFlight() const {
+        return _maxInFlight;
+    }
+
     BSONObj GridFS::storeFile( const char* data , size_t length , const string& remoteName , const string& contentType) {
         char const * const end = data + length;
 
@@ -82,15 +135,17 @@ namespace mongo {
         id.init();
         BSONObj idObj = BSON("_id" << id);
 
+        ChunkInserter inserter( _client , _chunksNS , _maxInFlight );
         int chunkNumber = 0;
         while (data < end) {
             int chunkLen = MIN(_chunkSize, (unsigned)(end-data));
             GridFSChunk c(idObj, chunkNumber, data, chunkLen);
-            _client.insert( _chunksNS.c_str() , c._data );
+            inserter.insert( c._data );
 
             chunkNumber++;
             data += chunkLen;
         }
+        inserter.finish( remoteName );
 
         return insertFile(remoteName, id, length, contentType);
     }
@@ -110,6 +165,7 @@ namespace mongo {
         id.init();
         BSONObj idObj = BSON("_id" << id);
 
+        ChunkInserter inserter( _client , _chunksNS , _maxInFlight );
         int chunkNumber = 0;
         gridfs_offset length = 0;
         while (!feof(fd)) {
@@ -126,7 +182,7 @@ namespace mongo {
             }
 
             GridFSChunk c(idObj, chunkNumber, buf, chunkLen);
-            _client.insert( _chunksNS.c_str() , c._data );
+            inserter.insert( c._data );
 
             length += chunkLen;
             chunkNumber++;
@@ -136,6 +192,8 @@ namespace mongo {
         if (fd != stdin)
             fclose( fd );
 
+        inserter.finish( remoteName.empty() ? fileName : remoteName );
+
         return insertFile((remoteName.empty() ? fileName : remoteName), id, length, contentType);
     }
 
@@ -230,10 +288,9 @@ namespace mongo {
     gridfs_offset GridFile::write( ostream & out ) const {
         _exists();
 
-        const int num = getNumChunks();
-
-        for ( int i=0; i<num; i++ ) {
-            GridFSChunk c = getChunk( i );
+        GridFileReader reader( *this );
+        while ( reader.more() ) {
+            GridFSChunk c = reader.next();
 
             int len;
             const char * data = c.data( len );
@@ -258,4 +315,35 @@ namespace mongo {
         uassert( 10015 ,  "doesn't exists" , exists() );
     }
 
+    GridFileReader::GridFileReader( const GridFile& file )
+        : _numChunks( file.getNumChunks() ) , _next( 0 ) {
+        file._exists();
+        const GridFS* grid = file._grid;
+
+        BSONObjBuilder b;
+        b.appendAs( file._obj["_id"] , "files_id" );
+        Query q = Query( b.obj() ).sort( BSON( "n" << 1 ) );
+
+        // a batch is the window of chunks read ahead; the next is asked for halfway through
+        int batchSize = grid->_maxInFlight > 1 ? grid->_maxInFlight : 0;
+        _cursor.reset( grid->_client.query( grid->_chunksNS , q , 0 , 0 , 0 , 0 ,
+                                            batchSize ).release() );
+        uassert( 17385 , "couldn't query GridFS chunks" , _cursor.get() );
+        if ( grid->_maxInFlight > 1 )
+            _cursor->setPrefetch( true , DBClientCursor::PrefetchAtHalfBatch , true );
+    }
+
+    GridFileReader::~GridFileReader() {
+    }
+
+    GridFSChunk GridFileReader::next() {
+        verify( more() );
+        uassert( 10014 ,  "chunk is empty!" , _cursor->more() );
+        BSONObj o = _cursor->nextSafe();
+        uassert( 17386 , str::stream() << "missing GridFS chunk " << _next << ", next is " << o["n"] ,
+                 o["n"].numberInt() == _next );
+        _next++;
+        return GridFSChunk( o.getOwned() );
+    }
+
 }
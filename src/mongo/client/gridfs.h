@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <boost/scoped_ptr.hpp>
+
 #include "mongo/bson/bsonelement.h"
 #include "mongo/bson/bsonobj.h"
 #include "mongo/client/dbclientinterface.h"
@@ -27,6 +29,7 @@ namespace mongo {
 
     class GridFS;
     class GridFile;
+    class GridFileReader;
 
     class GridFSChunk {
     public:
@@ -70,6 +73,15 @@ namespace mongo {
 
         unsigned int getChunkSize() const;
 
+        /**
+         * How many chunks may be in flight at once: chunk inserts awaiting acknowledgement
+         * when storing a file, and chunks per batch read ahead when reading one back.
+         * 1 stores and reads one chunk at a time.
+         */
+        void setMaxInFlight(int n);
+
+        int getMaxInFlight() const;
+
         /**
          * puts the file reference by fileName into the db
          * @param fileName local filename relative to process
@@ -127,11 +139,13 @@ namespace mongo {
         string _filesNS;
         string _chunksNS;
         unsigned int _chunkSize;
+        int _maxInFlight;
 
         // insert fileobject. All chunks must be in DB.
         BSONObj insertFile(const string& name, const OID& id, gridfs_offset length, const string& contentType);
 
         friend class GridFile;
+        friend class GridFileReader;
     };
 
     /**
@@ -202,5 +216,32 @@ namespace mongo {
         BSONObj        _obj;
 
         friend class GridFS;
+        friend class GridFileReader;
+    };
+
+    /**
+     * Streams a file's chunks in order over a single cursor, which asks for the next batch of
+     * chunks while the current one is still being read rather than querying for each chunk.
+     *
+     *   GridFileReader reader( file );
+     *   while ( reader.more() ) {
+     *       GridFSChunk c = reader.next();
+     *       ...
+     *   }
+     */
+    class GridFileReader {
+    public:
+        explicit GridFileReader( const GridFile& file );
+        ~GridFileReader();
+
+        bool more() const { return _next < _numChunks; }
+
+        /** uasserts if the next chunk is missing */
+        GridFSChunk next();
+
+    private:
+        boost::scoped_ptr<DBClientCursor> _cursor;
+        const int _numChunks;
+        int _next;
     };
 }
@@ -23,6 +23,7 @@
 #include "mongo/client/connpool.h"
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/db/dbmessage.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/s/chunk.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/config.h"
@@ -34,6 +35,11 @@ namespace mongo {
 
     LabeledLevel pc( "pcursor", 2 );
 
+    // Shard cursors ask for their next batch once this many results or fewer are left in the
+    // current one, so every shard works on its next batch while the results are merged.  The
+    // default is a whole first batch.  0 turns read-ahead off.
+    MONGO_EXPORT_SERVER_PARAMETER(internalShardCursorReadAhead, int, 101);
+
     // --------  ClusteredCursor -----------
 
     ClusteredCursor::ClusteredCursor( const QuerySpec& q ) {
@@ -369,6 +375,11 @@ namespace mongo {
         return _next;
     }
 
+    bool FilteringClientCursor::moreInCurrentBatch() {
+        // next() reads ahead one result, which only waits once this batch is used up
+        return _done || ! _cursor.get() || _cursor->moreInCurrentBatch() || _cursor->isDead();
+    }
+
     void FilteringClientCursor::_advance() {
         verify( _next.isEmpty() );
         if ( ! _cursor.get() || _done )
@@ -1258,6 +1269,10 @@ namespace mongo {
 
             PCMData& mdata = i->second;
 
+            if ( internalShardCursorReadAhead > 0 ) {
+                mdata.pcState->cursor->setPrefetch( true, internalShardCursorReadAhead );
+            }
+
             _cursors[ index ].reset( mdata.pcState->cursor.get(), &mdata );
             _servers.insert( ServerAndQuery( i->first.getConnString(), BSONObj() ) );
 
@@ -1648,6 +1663,15 @@ namespace mongo {
         return best;
     }
 
+    bool ParallelSortClusteredCursor::nextIsBuffered() {
+        // conservatively, any shard cursor that is out of results may be the next one used
+        for ( int i = 0; i < _numServers; i++ ) {
+            if ( ! _cursors[i].moreInCurrentBatch() )
+                return false;
+        }
+        return true;
+    }
+
     void ParallelSortClusteredCursor::_explain( map< string,list<BSONObj> >& out ) {
 
         set<Shard> shards;
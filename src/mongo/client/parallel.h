@@ -84,6 +84,12 @@ namespace mongo {
         virtual bool more() = 0;
         virtual BSONObj next() = 0;
 
+        /**
+         * @return false if the next result may have to wait for a server to answer.  Callers
+         *         filling a batch can use this to send what they have instead of waiting.
+         */
+        virtual bool nextIsBuffered() { return true; }
+
         static BSONObj concatQuery( const BSONObj& query , const BSONObj& extraFilter );
 
         virtual string type() const = 0;
@@ -139,6 +145,12 @@ namespace mongo {
 
         BSONObj peek();
 
+        /**
+         * @return true if more() and next() can be answered from what this cursor already
+         *         received, without a getMore to the server
+         */
+        bool moreInCurrentBatch();
+
         DBClientCursor* raw() { return _cursor.get(); }
         ParallelConnectionMetadata* rawMData(){ return _pcmData; }
 
@@ -342,6 +354,7 @@ namespace mongo {
         virtual ~ParallelSortClusteredCursor();
         virtual bool more();
         virtual BSONObj next();
+        virtual bool nextIsBuffered();
         virtual string type() const { return "ParallelSort"; }
 
         void fullInit();
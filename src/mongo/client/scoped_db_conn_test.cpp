@@ -194,6 +194,7 @@ namespace mongo_test {
     public:
         void setUp() {
             _maxPoolSizePerHost = mongo::PoolForHost::getMaxPerHost();
+            _minPoolSizePerHost = mongo::PoolForHost::getMinPerHost();
             _dummyServer = new DummyServer(TARGET_PORT);
 
             _dummyServer->run(&dummyHandler);
@@ -218,6 +219,7 @@ namespace mongo_test {
             delete _dummyServer;
 
             mongo::PoolForHost::setMaxPerHost(_maxPoolSizePerHost);
+            mongo::PoolForHost::setMinPerHost(_minPoolSizePerHost);
         }
 
     protected:
@@ -279,6 +281,7 @@ namespace mongo_test {
 
         DummyServer* _dummyServer;
         uint32_t _maxPoolSizePerHost;
+        uint32_t _minPoolSizePerHost;
     };
 
     TEST_F(DummyServerFixture, BasicScopedDbConnection) {
@@ -402,4 +405,41 @@ namespace mongo_test {
 
         conn1Again.done();
     }
+
+    TEST_F(DummyServerFixture, WarmUpToMinPerHost) {
+        mongo::PoolForHost::setMinPerHost(3);
+
+        {
+            ScopedDbConnection conn(TARGET_HOST);
+            conn.done();
+        }
+
+        // the warm-up connects in the background
+        mongo::pool.taskDoWork();
+
+        mongo::Timer timer;
+        while (true) {
+            mongo::BSONObjBuilder info;
+            mongo::pool.appendInfo(info);
+            if (info.obj()["totalAvailable"].numberInt() == 3) {
+                break;
+            }
+            if (timer.seconds() > 20) {
+                FAIL("Timed out warming up the pool");
+            }
+            mongo::sleepmillis(10);
+        }
+
+        // the warmed up connections are handed out without connecting again
+        ScopedDbConnection conn1(TARGET_HOST);
+        ScopedDbConnection conn2(TARGET_HOST);
+        ScopedDbConnection conn3(TARGET_HOST);
+        mongo::BSONObjBuilder info;
+        mongo::pool.appendInfo(info);
+        ASSERT_EQUALS(3, info.obj()["totalCreated"].numberInt());
+
+        conn1.done();
+        conn2.done();
+        conn3.done();
+    }
 }
@@ -0,0 +1,134 @@
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/client/write_pipeline.h"
+
+#include "mongo/db/dbmessage.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/db/wire_version.h"
+#include "mongo/util/net/message.h"
+
+namespace mongo {
+
+    void assembleRequest( const string &ns, BSONObj query, int nToReturn, int nToSkip, const BSONObj *fieldsToReturn, int queryOptions, Message &toSend );
+
+    bool DBClientWritePipeline::supported( DBClientBase* conn ) {
+        if ( !conn->lazySupported() )
+            return false;
+        BSONObj info;
+        bool isMaster;
+        if ( !conn->isMaster( isMaster, &info ) )
+            return false;
+        return info["maxWireVersion"].numberInt() >= BATCH_COMMANDS;
+    }
+
+    DBClientWritePipeline::DBClientWritePipeline( DBClientBase* conn,
+                                                  const BSONObj& writeConcern,
+                                                  int maxInFlight ) :
+        _conn( conn ),
+        _writeConcern( writeConcern.getOwned() ),
+        _maxInFlight( maxInFlight > 0 ? maxInFlight : 1 ),
+        _numWritten( 0 ) {
+        massert( 17381, "write pipelining needs a connection that supports lazy calls",
+                 _conn->lazySupported() );
+    }
+
+    DBClientWritePipeline::~DBClientWritePipeline() {
+        DESTRUCTOR_GUARD( flush(); );
+    }
+
+    int DBClientWritePipeline::insert( const StringData& ns, const vector<BSONObj>& documents,
+                                       bool ordered ) {
+        return send( ns, "insert", "documents", documents, ordered );
+    }
+
+    int DBClientWritePipeline::update( const StringData& ns, const vector<BSONObj>& updates,
+                                       bool ordered ) {
+        return send( ns, "update", "updates", updates, ordered );
+    }
+
+    int DBClientWritePipeline::remove( const StringData& ns, const vector<BSONObj>& deletes,
+                                       bool ordered ) {
+        return send( ns, "delete", "deletes", deletes, ordered );
+    }
+
+    BSONObj DBClientWritePipeline::updateDocument( const BSONObj& query,
+                                                   const BSONObj& updateExpr,
+                                                   bool upsert, bool multi ) {
+        return BSON( "q" << query << "u" << updateExpr << "upsert" << upsert << "multi" << multi );
+    }
+
+    BSONObj DBClientWritePipeline::deleteDocument( const BSONObj& query, bool justOne ) {
+        return BSON( "q" << query << "limit" << ( justOne ? 1 : 0 ) );
+    }
+
+    int DBClientWritePipeline::send( const StringData& ns, const char* commandName,
+                                     const char* itemsName, const vector<BSONObj>& items,
+                                     bool ordered ) {
+        while ( _inFlight.size() >= _maxInFlight )
+            receiveOne();
+
+        BSONObjBuilder b;
+        b.append( commandName, nsToCollectionSubstring( ns ) );
+        b.append( itemsName, items );
+        if ( !_writeConcern.isEmpty() )
+            b.append( "writeConcern", _writeConcern );
+        b.append( "ordered", ordered );
+
+        Message toSend;
+        assembleRequest( nsToDatabase( ns ) + ".$cmd", b.done(), -1, 0, NULL, 0, toSend );
+        _conn->say( toSend );
+
+        int requestId = toSend.header()->id;
+        _inFlight.push_back( requestId );
+        return requestId;
+    }
+
+    void DBClientWritePipeline::receiveOne() {
+        verify( !_inFlight.empty() );
+        int requestId = _inFlight.front();
+        _inFlight.pop_front();
+
+        Message response;
+        uassert( 17382, str::stream() << "recv failed reading the reply to write command "
+                                      << requestId,
+                 _conn->recv( response ) );
+        massert( 17383, str::stream() << "reply to " << response.header()->responseTo
+                                      << " where one to write command " << requestId
+                                      << " was expected",
+                 response.header()->responseTo == requestId );
+
+        QueryResult* qr = reinterpret_cast<QueryResult*>( response.singleData() );
+        BSONObj reply = qr->nReturned == 1 ? BSONObj( qr->data() ).getOwned() : BSONObj();
+
+        _numWritten += reply["n"].numberLong();
+        if ( !reply["ok"].trueValue() || reply.hasField( "errDetails" ) ||
+             reply.hasField( "errCode" ) ) {
+            Error error;
+            error.requestId = requestId;
+            error.reply = reply;
+            _errors.push_back( error );
+        }
+    }
+
+    int DBClientWritePipeline::flush() {
+        while ( !_inFlight.empty() )
+            receiveOne();
+        return _errors.size();
+    }
+
+} // namespace mongo
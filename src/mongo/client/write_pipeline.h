@@ -0,0 +1,105 @@
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/client/dbclientinterface.h"
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    /**
+     * Sends insert, update and delete write commands over a connection without waiting for
+     * each reply, so writes with a write concern flow as fast as unacknowledged ones.  Up to
+     * maxInFlight commands are outstanding at once; the replies, which the server sends in the
+     * order it got the commands, are matched to them by request id as they're read.
+     *
+     * Nothing else may use the connection while commands are in flight, that is until flush()
+     * returns.  The destructor flushes, ignoring errors.
+     *
+     *   DBClientWritePipeline pipeline( &conn, BSON( "w" << 2 ) );
+     *   for ( ... )
+     *       pipeline.insert( "test.foo", docs );
+     *   if ( pipeline.flush() )
+     *       ... pipeline.errors() ...
+     */
+    class DBClientWritePipeline {
+        MONGO_DISALLOW_COPYING(DBClientWritePipeline);
+    public:
+        /** A reply that reported an error, and the request id of the command it answers */
+        struct Error {
+            int requestId;
+            BSONObj reply;
+        };
+
+        /** @return true if conn can pipeline and its server takes write commands */
+        static bool supported( DBClientBase* conn );
+
+        DBClientWritePipeline( DBClientBase* conn,
+                               const BSONObj& writeConcern = BSONObj(),
+                               int maxInFlight = 16 );
+        ~DBClientWritePipeline();
+
+        /** @return the request id the command was sent with */
+        int insert( const StringData& ns, const std::vector<BSONObj>& documents,
+                    bool ordered = true );
+
+        /** 'updates' are made with updateDocument() */
+        int update( const StringData& ns, const std::vector<BSONObj>& updates,
+                    bool ordered = true );
+
+        /** 'deletes' are made with deleteDocument() */
+        int remove( const StringData& ns, const std::vector<BSONObj>& deletes,
+                    bool ordered = true );
+
+        static BSONObj updateDocument( const BSONObj& query, const BSONObj& updateExpr,
+                                       bool upsert = false, bool multi = false );
+        static BSONObj deleteDocument( const BSONObj& query, bool justOne = false );
+
+        /**
+         * Reads the replies to every command in flight.
+         * @return the number of commands whose replies reported an error, now or before
+         */
+        int flush();
+
+        int numInFlight() const { return _inFlight.size(); }
+
+        /** Documents the acknowledged commands reported writing */
+        long long numWritten() const { return _numWritten; }
+
+        const std::vector<Error>& errors() const { return _errors; }
+
+    private:
+        int send( const StringData& ns, const char* commandName,
+                  const char* itemsName, const std::vector<BSONObj>& items, bool ordered );
+
+        /** Reads the reply to the oldest command in flight */
+        void receiveOne();
+
+        DBClientBase* const _conn;
+        const BSONObj _writeConcern;
+        const size_t _maxInFlight;
+        std::deque<int> _inFlight; // request ids, oldest first
+        long long _numWritten;
+        std::vector<Error> _errors;
+    };
+
+} // namespace mongo
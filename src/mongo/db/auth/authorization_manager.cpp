@@ -186,7 +186,7 @@ namespace mongo {
             fassert(17191, !_authzManager->_isFetchPhaseBusy);
             _isThisGuardInFetchPhase = true;
             _authzManager->_isFetchPhaseBusy = true;
-            _startGeneration = _authzManager->_cacheGeneration;
+            _startGeneration = _authzManager->_cacheGeneration.load();
             _lock.unlock();
         }
 
@@ -207,7 +207,7 @@ namespace mongo {
          */
         bool isSameCacheGeneration() const {
             fassert(17223, !_isThisGuardInFetchPhase);
-            return _startGeneration == _authzManager->_cacheGeneration;
+            return _startGeneration == _authzManager->_cacheGeneration.load();
         }
 
     private:
@@ -690,6 +690,11 @@ namespace mongo {
             return;
         }
 
+        // Only the last reference needs the lock, to take the user out of the cache.
+        if (user->decrementRefCountIfNotLast()) {
+            return;
+        }
+
         CacheGuard guard(this, CacheGuard::fetchSynchronizationManual);
         user->decrementRefCount();
         if (user->getRefCount() == 0) {
@@ -704,20 +709,17 @@ namespace mongo {
 
     void AuthorizationManager::invalidateUserByName(const UserName& userName) {
         CacheGuard guard(this, CacheGuard::fetchSynchronizationManual);
-        ++_cacheGeneration;
         unordered_map<UserName, User*>::iterator it = _userCache.find(userName);
-        if (it == _userCache.end()) {
-            return;
+        if (it != _userCache.end()) {
+            User* user = it->second;
+            _userCache.erase(it);
+            user->invalidate();
         }
-
-        User* user = it->second;
-        _userCache.erase(it);
-        user->invalidate();
+        _cacheGeneration.fetchAndAdd(1);
     }
 
     void AuthorizationManager::invalidateUsersFromDB(const std::string& dbname) {
         CacheGuard guard(this, CacheGuard::fetchSynchronizationManual);
-        ++_cacheGeneration;
         unordered_map<UserName, User*>::iterator it = _userCache.begin();
         while (it != _userCache.end()) {
             User* user = it->second;
@@ -728,6 +730,7 @@ namespace mongo {
                 ++it;
             }
         }
+        _cacheGeneration.fetchAndAdd(1);
     }
 
 
@@ -742,7 +745,6 @@ namespace mongo {
     }
 
     void AuthorizationManager::_invalidateUserCache_inlock() {
-        ++_cacheGeneration;
         for (unordered_map<UserName, User*>::iterator it = _userCache.begin();
                 it != _userCache.end(); ++it) {
             if (it->second->getName() == internalSecurity.user->getName()) {
@@ -754,6 +756,7 @@ namespace mongo {
         _userCache.clear();
         // Make sure the internal user stays in the cache.
         _userCache.insert(make_pair(internalSecurity.user->getName(), internalSecurity.user));
+        _cacheGeneration.fetchAndAdd(1);
 
         // If the authorization manager was running with version 2.4 schema data, check to
         // see if the version has updated next time we go to add data to the cache.
@@ -335,6 +335,13 @@ namespace mongo {
          */
         void invalidateUserCache();
 
+        /**
+         * Returns the generation of the user cache, which every invalidation bumps once the
+         * User objects it invalidates are marked so.  Safe to call without any lock, so a caller
+         * that has seen the same generation before knows that the Users it holds are still valid.
+         */
+        uint64_t getCacheGeneration() const { return _cacheGeneration.load(); }
+
         /**
          * Parses privDoc and fully initializes the user object (credentials, roles, and privileges)
          * with the information extracted from the privilege document.
@@ -450,9 +457,10 @@ namespace mongo {
 
         /**
          * Current generation of cached data.  Bumped every time part of the cache gets
-         * invalidated.
+         * invalidated, after the invalidated User objects are marked so.  Changed only under
+         * CacheGuard.
          */
-        uint64_t _cacheGeneration;
+        AtomicUInt64 _cacheGeneration;
 
         /**
          * True if there is an update to the _userCache in progress, and that update is currently in
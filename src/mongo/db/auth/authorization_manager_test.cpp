@@ -361,6 +361,46 @@ namespace {
         authzManager->releaseUser(v2cluster);
     }
 
+    TEST_F(AuthorizationManagerTest, ReleaseAndInvalidateUser) {
+        externalState->setAuthzVersion(AuthorizationManager::schemaVersion26Final);
+        ASSERT_OK(externalState->insertPrivilegeDocument(
+                "admin",
+                BSON("user" << "v2read" <<
+                     "db" << "test" <<
+                     "credentials" << BSON("MONGODB-CR" << "password") <<
+                     "roles" << BSON_ARRAY(BSON("role" << "read" <<
+                                                "db" << "test" <<
+                                                "canDelegate" << false <<
+                                                "hasRole" << true))),
+                BSONObj()));
+
+        User* first;
+        User* second;
+        ASSERT_OK(authzManager->acquireUser(UserName("v2read", "test"), &first));
+        ASSERT_OK(authzManager->acquireUser(UserName("v2read", "test"), &second));
+        ASSERT_EQUALS(first, second);
+        ASSERT_EQUALS((uint32_t)2, first->getRefCount());
+
+        // dropping a reference other than the last leaves the user cached
+        authzManager->releaseUser(second);
+        ASSERT_EQUALS((uint32_t)1, first->getRefCount());
+        ASSERT_OK(authzManager->acquireUser(UserName("v2read", "test"), &second));
+        ASSERT_EQUALS(first, second);
+        authzManager->releaseUser(second);
+
+        // the generation moves once the user is marked invalid
+        const uint64_t generation = authzManager->getCacheGeneration();
+        authzManager->invalidateUserByName(UserName("v2read", "test"));
+        ASSERT_FALSE(first->isValid());
+        ASSERT_NOT_EQUALS(generation, authzManager->getCacheGeneration());
+
+        ASSERT_OK(authzManager->acquireUser(UserName("v2read", "test"), &second));
+        ASSERT_NOT_EQUALS(first, second);
+        ASSERT(second->isValid());
+        authzManager->releaseUser(first);
+        authzManager->releaseUser(second);
+    }
+
     class AuthzUpgradeTest : public AuthorizationManagerTest {
     public:
         static const NamespaceString versionCollectionName;
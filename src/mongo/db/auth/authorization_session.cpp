@@ -51,7 +51,10 @@ namespace {
     const std::string ADMIN_DBNAME = "admin";
 }  // namespace
 
-    AuthorizationSession::AuthorizationSession(AuthzSessionExternalState* externalState) {
+    const uint64_t AuthorizationSession::noGeneration;
+
+    AuthorizationSession::AuthorizationSession(AuthzSessionExternalState* externalState)
+        : _validAtGeneration(noGeneration) {
         _externalState.reset(externalState);
     }
 
@@ -80,6 +83,7 @@ namespace {
 
         // Calling add() on the UserSet may return a user that was replaced because it was from the
         // same database.
+        _validAtGeneration = noGeneration;
         User* replacedUser = _authenticatedUsers.add(user);
         if (replacedUser) {
             getAuthorizationManager().releaseUser(replacedUser);
@@ -385,6 +389,14 @@ namespace {
 
     void AuthorizationSession::_refreshUserInfoAsNeeded() {
         AuthorizationManager& authMan = getAuthorizationManager();
+
+        // Invalidations mark Users before bumping the generation, so if it hasn't moved since
+        // every User here was last seen valid, they all still are.
+        const uint64_t generation = authMan.getCacheGeneration();
+        if (generation == _validAtGeneration)
+            return;
+
+        bool allValid = true;
         UserSet::iterator it = _authenticatedUsers.begin();
         while (it != _authenticatedUsers.end()) {
             User* user = *it;
@@ -402,6 +414,9 @@ namespace {
                     fassert(17067, _authenticatedUsers.replaceAt(it, updatedUser) == user);
                     authMan.releaseUser(user);
                     LOG(1) << "Updated session cache of user information for " << name;
+                    // fetched while the cache was being invalidated again
+                    if (!updatedUser->isValid())
+                        allValid = false;
                     break;
                 }
                 case ErrorCodes::UserNotFound: {
@@ -417,11 +432,14 @@ namespace {
                     // out-of-date privilege data.
                     warning() << "Could not fetch updated user privilege information for " <<
                         name << "; continuing to use old information.  Reason is " << status;
+                    allValid = false;
                     break;
                 }
             }
             ++it;
         }
+
+        _validAtGeneration = allValid ? generation : noGeneration;
     }
 
     bool AuthorizationSession::_isAuthorizedForPrivilege(const Privilege& privilege) {
@@ -450,6 +468,7 @@ namespace {
                     if (user != updatedUser) {
                         LOG(1) << "Updated session cache for V1 user " << name;
                         fassert(17226, _authenticatedUsers.replaceAt(it, updatedUser) == user);
+                        _validAtGeneration = noGeneration;
                     }
                     getAuthorizationManager().releaseUser(user);
                     user = updatedUser;
@@ -195,6 +195,11 @@ namespace mongo {
 
         // All Users who have been authenticated on this connection
         UserSet _authenticatedUsers;
+
+        // The AuthorizationManager's cache generation when _refreshUserInfoAsNeeded() last found
+        // every User in _authenticatedUsers valid, or noGeneration if Users were added since.
+        uint64_t _validAtGeneration;
+        static const uint64_t noGeneration = ~0ULL;
     };
 
 } // namespace mongo
@@ -89,7 +89,8 @@ namespace {
             << ActionType::dbHash
             << ActionType::dbStats
             << ActionType::find
-            << ActionType::killCursors;
+            << ActionType::killCursors
+            << ActionType::planCacheRead;
 
         // Read-write role
         readWriteRoleActions += readRoleActions;
@@ -135,6 +136,8 @@ namespace {
             << ActionType::dropIndex
             << ActionType::createIndex
             << ActionType::indexStats
+            << ActionType::planCacheRead
+            << ActionType::planCacheWrite
             << ActionType::profileEnable
             << ActionType::reIndex
             << ActionType::renameCollectionSameDB // read_write gets this also
@@ -193,6 +193,13 @@ namespace mongo {
          */
         void decrementRefCount();
 
+        /**
+         * Decrements the reference count unless this holds the last reference, which only the
+         * AuthorizationManager may drop, under its lock.  Returns false, and drops nothing, if
+         * this was the last reference.  Safe to call without the AuthorizationManager's lock.
+         */
+        bool decrementRefCountIfNotLast();
+
     private:
 
         UserName _name;
@@ -216,8 +223,9 @@ namespace mongo {
 
         // _refCount and _isInvalidated are modified exclusively by the AuthorizationManager
         // _isInvalidated can be read by any consumer of User, but _refCount can only be
-        // meaningfully read by the AuthorizationManager, as _refCount is guarded by the AM's _lock
-        uint32_t _refCount;
+        // meaningfully read by the AuthorizationManager.  References other than the last may be
+        // dropped without the AM's _lock; the rest of the changes to _refCount are made under it.
+        AtomicUInt32 _refCount;
         AtomicUInt32 _isValid; // Using as a boolean
     };
 
@@ -45,6 +45,7 @@
 #include "mongo/db/json.h"
 #include "mongo/db/kill_current_op.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/server.h"
 #include "mongo/util/startup_test.h"
@@ -555,14 +556,11 @@ namespace mongo {
      * This function is expected to be called on a packed bucket.
      */
     template< class V >
-    int BucketBasics<V>::splitPos( int keypos ) const {
+    int BucketBasics<V>::splitPos( int keypos, int rightPercent ) const {
         verify( this->n > 2 );
         int split = 0;
         int rightSize = 0;
-        // when splitting a btree node, if the new key is greater than all the other keys, we should not do an even split, but a 90/10 split.
-        // see SERVER-983
-        // TODO I think we only want to do the 90% split on the rhs node of the tree.
-        int rightSizeLimit = ( this->topSize + sizeof( _KeyNode ) * this->n ) / ( keypos == this->n ? 10 : 2 );
+        int rightSizeLimit = ( this->topSize + sizeof( _KeyNode ) * this->n ) * rightPercent / 100;
         for( int i = this->n - 1; i > -1; --i ) {
             rightSize += keyNode( i ).key.dataSize() + sizeof( _KeyNode );
             if ( rightSize > rightSizeLimit ) {
@@ -1251,6 +1249,7 @@ namespace mongo {
         int pos;
         bool found;
         const Ordering ord = Ordering::make(id.keyPattern());
+        BtreeLatches::WriteScope latches;
         DiskLoc loc = locate(id, thisLoc, key, ord, pos, found, recordLoc, 1);
         if ( found ) {
             if ( key.objsize() > this->KeyMax ) {
@@ -1262,6 +1261,71 @@ namespace mongo {
         return false;
     }
 
+    template< class V >
+    BtreeDefragResult BtreeBucket<V>::defragStep( const DiskLoc thisLoc, IndexDetails& id,
+                                                  BSONObj& resumeKey, DiskLoc& resumeLoc ) const {
+        const Ordering order = Ordering::make( id.keyPattern() );
+        BtreeLatches::WriteScope latches;
+
+        // find the leaf to look at
+        DiskLoc leafLoc = thisLoc;
+        if ( !resumeKey.isEmpty() ) {
+            int pos;
+            bool found;
+            leafLoc = locate( id, thisLoc, resumeKey, order, pos, found, resumeLoc, 1 );
+            if ( leafLoc.isNull() ) {
+                return DefragDone;
+            }
+            // a merge below may have promoted the key; its followers are to its right
+            DiskLoc child = BTREE(leafLoc)->childForPos( found ? pos + 1 : pos );
+            if ( !child.isNull() ) {
+                leafLoc = child;
+            }
+        }
+        while ( !BTREE(leafLoc)->childForPos( 0 ).isNull() ) {
+            leafLoc = BTREE(leafLoc)->childForPos( 0 );
+        }
+
+        const BtreeBucket* leaf = BTREE(leafLoc);
+        if ( leaf->isHead() || leaf->n == 0 ) {
+            // the whole index fits in one bucket, or this is a legacy btree's transient state
+            return DefragDone;
+        }
+
+        resumeKey = leaf->keyNode( 0 ).key.toBson().getOwned();
+        resumeLoc = leaf->keyNode( 0 ).recordLoc;
+
+        const BtreeBucket* p = BTREE(leaf->parent);
+        int parentIdx = leaf->indexInParent( leafLoc );
+        if ( parentIdx < p->n && p->canMergeChildren( leaf->parent, parentIdx ) ) {
+            // the merged bucket is the left one, so its first key is still resumeKey
+            BTREEMOD(leaf->parent)->doMergeChildren( leaf->parent, parentIdx, id, order );
+            return DefragMerged;
+        }
+
+        // move on: the next leaf starts after the separator following this one
+        int keyOfs = leaf->n - 1;
+        DiskLoc next = leaf->advance( leafLoc, keyOfs, 1, "defragStep" );
+        if ( next.isNull() ) {
+            return DefragDone;
+        }
+        DiskLoc nextLeaf = BTREE(next)->childForPos( keyOfs + 1 );
+        if ( nextLeaf.isNull() ) {
+            // only expected in legacy btrees
+            return DefragDone;
+        }
+        while ( !BTREE(nextLeaf)->childForPos( 0 ).isNull() ) {
+            nextLeaf = BTREE(nextLeaf)->childForPos( 0 );
+        }
+        const BtreeBucket* nl = BTREE(nextLeaf);
+        if ( nl->n == 0 ) {
+            return DefragDone;
+        }
+        resumeKey = nl->keyNode( 0 ).key.toBson().getOwned();
+        resumeLoc = nl->keyNode( 0 ).recordLoc;
+        return DefragMovedOn;
+    }
+
     template< class V >
     inline void BtreeBucket<V>::fix(const DiskLoc thisLoc, const DiskLoc child) {
         if ( !child.isNull() ) {
@@ -1371,6 +1435,80 @@ namespace mongo {
         }
     }
 
+    // Whether splits may be skewed by where an index's recent splits were caused.
+    MONGO_EXPORT_SERVER_PARAMETER( btreeAdaptiveSplits, bool, true );
+
+    namespace {
+
+        /**
+         * Where in their buckets the inserts causing an index's recent splits landed, by tenths
+         * of the bucket, with the last slot for appends past the last key.  Each split weighs
+         * less than those after it, so the history follows the index's current insert pattern.
+         */
+        struct SplitHistory {
+            enum { Slots = 11 };
+            SplitHistory() {
+                for ( int i = 0; i < Slots; ++i ) {
+                    weight[i] = 0;
+                }
+            }
+            double weight[Slots];
+        };
+
+        SimpleMutex splitHistoryMutex( "btreeSplitHistory" );
+
+        // Keyed by the index's info DiskLoc.  Writes to different databases may split at once.
+        map<DiskLoc, SplitHistory> splitHistories;
+
+        /**
+         * Records a split of a bucket of 'n' keys caused by an insert at 'keypos', and returns
+         * about how full, in percent, the new right bucket should be.
+         *
+         * A key past the end of the bucket always gets a 90/10 split (SERVER-983).  When nearly
+         * all of the index's recent splits were caused near one edge of their buckets, the
+         * index is mostly ascending or mostly descending, and a split caused near that edge
+         * leaves the bucket that won't see more inserts about 90% full.  Otherwise the split
+         * is even.
+         */
+        int splitRightPercent( const IndexDetails& idx, int keypos, int n ) {
+            const int slot = keypos >= n ? SplitHistory::Slots - 1 : keypos * 10 / n;
+
+            double total = 0;
+            double nearLeft = 0;
+            double nearRight = 0;
+            {
+                SimpleMutex::scoped_lock lk( splitHistoryMutex );
+                SplitHistory& history = splitHistories[ idx.info ];
+                for ( int i = 0; i < SplitHistory::Slots; ++i ) {
+                    history.weight[i] *= 0.9;
+                }
+                history.weight[slot] += 1;
+
+                for ( int i = 0; i < SplitHistory::Slots; ++i ) {
+                    total += history.weight[i];
+                }
+                nearLeft = history.weight[0];
+                nearRight = history.weight[9] + history.weight[10];
+            }
+
+            if ( keypos >= n ) {
+                return 10;
+            }
+            // a few splits aren't a pattern
+            if ( !btreeAdaptiveSplits || total < 4 ) {
+                return 50;
+            }
+            if ( slot >= 9 && nearRight >= 0.75 * total ) {
+                return 10;
+            }
+            if ( slot == 0 && nearLeft >= 0.75 * total ) {
+                return 90;
+            }
+            return 50;
+        }
+
+    } // namespace
+
     template< class V >
     void BtreeBucket<V>::split(const DiskLoc thisLoc, int keypos, const DiskLoc recordLoc, const Key& key, const Ordering& order, const DiskLoc lchild, const DiskLoc rchild, IndexDetails& idx) {
         this->assertWritable();
@@ -1378,7 +1516,13 @@ namespace mongo {
         if ( split_debug )
             out() << "    " << thisLoc.toString() << ".split" << endl;
 
-        int split = this->splitPos( keypos );
+        int rightPercent = splitRightPercent( idx, keypos, this->n );
+        int split = this->splitPos( keypos, rightPercent );
+        // The new key must go in the bucket left with the room.  If a skewed split would put it
+        // in the full one, split evenly instead.
+        if ( ( rightPercent < 50 && keypos <= split ) || ( rightPercent > 50 && keypos > split ) ) {
+            split = this->splitPos( keypos, 50 );
+        }
         DiskLoc rLoc = addBucket(idx);
         BtreeBucket *r = rLoc.btreemod<V>();
         if ( split_debug )
@@ -1470,6 +1614,21 @@ namespace mongo {
 
     template< class V >
     DiskLoc BtreeBucket<V>::advance(const DiskLoc& thisLoc, int& keyOfs, int direction, const char *caller) const {
+        BtreeLatches::ReadSet reads;
+        const int startOfs = keyOfs;
+        while ( 1 ) {
+            DiskLoc l = _advance(thisLoc, keyOfs, direction, caller, &reads);
+            if ( reads.validate() )
+                return l;
+            reads.clear();
+            keyOfs = startOfs;
+        }
+    }
+
+    template< class V >
+    DiskLoc BtreeBucket<V>::_advance(const DiskLoc& thisLoc, int& keyOfs, int direction, const char *caller,
+                                     BtreeLatches::ReadSet* reads) const {
+        reads->add(thisLoc);
         if ( keyOfs < 0 || keyOfs >= this->n ) {
             out() << "ASSERT failure BtreeBucket<V>::advance, caller: " << caller << endl;
             out() << "  thisLoc: " << thisLoc.toString() << endl;
@@ -1482,6 +1641,7 @@ namespace mongo {
         DiskLoc nextDown = this->childForPos(ko+adj);
         if ( !nextDown.isNull() ) {
             while ( 1 ) {
+                reads->add(nextDown);
                 keyOfs = direction>0 ? 0 : BTREE(nextDown)->n - 1;
                 DiskLoc loc = BTREE(nextDown)->childForPos(keyOfs + adj);
                 if ( loc.isNull() )
@@ -1502,6 +1662,7 @@ namespace mongo {
         while ( 1 ) {
             if ( ancestor.isNull() )
                 break;
+            reads->add(ancestor);
             const BtreeBucket *an = BTREE(ancestor);
             for ( int i = 0; i < an->n; i++ ) {
                 if ( an->childForPos(i+adj) == childLoc ) {
@@ -1526,6 +1687,19 @@ namespace mongo {
 
     template< class V >
     DiskLoc BtreeBucket<V>::locate(const IndexDetails& idx, const DiskLoc& thisLoc, const Key& key, const Ordering &order, int& pos, bool& found, const DiskLoc &recordLoc, int direction) const {
+        BtreeLatches::ReadSet reads;
+        while ( 1 ) {
+            DiskLoc l = _locate(idx, thisLoc, key, order, pos, found, recordLoc, direction, &reads);
+            if ( reads.validate() )
+                return l;
+            reads.clear();
+        }
+    }
+
+    template< class V >
+    DiskLoc BtreeBucket<V>::_locate(const IndexDetails& idx, const DiskLoc& thisLoc, const Key& key, const Ordering &order, int& pos, bool& found, const DiskLoc &recordLoc, int direction,
+                                    BtreeLatches::ReadSet* reads) const {
+        reads->add(thisLoc);
         int p;
         found = find(idx, key, recordLoc, order, p, /*assertIfDup*/ false);
         if ( found ) {
@@ -1536,7 +1710,7 @@ namespace mongo {
         DiskLoc child = this->childForPos(p);
 
         if ( !child.isNull() ) {
-            DiskLoc l = BTREE(child)->locate(idx, child, key, order, pos, found, recordLoc, direction);
+            DiskLoc l = BTREE(child)->_locate(idx, child, key, order, pos, found, recordLoc, direction, reads);
             if ( !l.isNull() )
                 return l;
         }
@@ -1549,7 +1723,7 @@ namespace mongo {
     }
 
     template< class V >
-    bool BtreeBucket<V>::customFind( int l, int h, const BSONObj &keyBegin, int keyBeginLen, bool afterKey, const vector< const BSONElement * > &keyEnd, const vector< bool > &keyEndInclusive, const Ordering &order, int direction, DiskLoc &thisLoc, int &keyOfs, pair< DiskLoc, int > &bestParent ) {
+    bool BtreeBucket<V>::customFind( int l, int h, const BSONObj &keyBegin, int keyBeginLen, bool afterKey, const vector< const BSONElement * > &keyEnd, const vector< bool > &keyEndInclusive, const Ordering &order, int direction, DiskLoc &thisLoc, int &keyOfs, pair< DiskLoc, int > &bestParent, BufBuilder &scratch ) {
         const BtreeBucket<V> * bucket = BTREE(thisLoc);
         while( 1 ) {
             if ( l + 1 == h ) {
@@ -1565,7 +1739,7 @@ namespace mongo {
                 }
             }
             int m = l + ( h - l ) / 2;
-            int cmp = customBSONCmp( bucket->keyNode( m ).key.toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction );
+            int cmp = customBSONCmp( bucket->keyNode( m ).key.toBson(scratch), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction );
             if ( cmp < 0 ) {
                 l = m;
             }
@@ -1590,22 +1764,23 @@ namespace mongo {
      */
     template< class V >
     void BtreeBucket<V>::advanceTo(DiskLoc &thisLoc, int &keyOfs, const BSONObj &keyBegin, int keyBeginLen, bool afterKey, const vector< const BSONElement * > &keyEnd, const vector< bool > &keyEndInclusive, const Ordering &order, int direction ) const {
+        BufBuilder scratch;
         int l,h;
         bool dontGoUp;
         if ( direction > 0 ) {
             l = keyOfs;
             h = this->n - 1;
-            dontGoUp = ( customBSONCmp( keyNode( h ).key.toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction ) >= 0 );
+            dontGoUp = ( customBSONCmp( keyNode( h ).key.toBson(scratch), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction ) >= 0 );
         }
         else {
             l = 0;
             h = keyOfs;
-            dontGoUp = ( customBSONCmp( keyNode( l ).key.toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction ) <= 0 );
+            dontGoUp = ( customBSONCmp( keyNode( l ).key.toBson(scratch), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction ) <= 0 );
         }
         pair< DiskLoc, int > bestParent;
         if ( dontGoUp ) {
             // this comparison result assures h > l
-            if ( !customFind( l, h, keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction, thisLoc, keyOfs, bestParent ) ) {
+            if ( !customFind( l, h, keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction, thisLoc, keyOfs, bestParent, scratch ) ) {
                 return;
             }
         }
@@ -1614,12 +1789,12 @@ namespace mongo {
             while( !BTREE(thisLoc)->parent.isNull() ) {
                 thisLoc = BTREE(thisLoc)->parent;
                 if ( direction > 0 ) {
-                    if ( customBSONCmp( BTREE(thisLoc)->keyNode( BTREE(thisLoc)->n - 1 ).key.toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction ) >= 0 ) {
+                    if ( customBSONCmp( BTREE(thisLoc)->keyNode( BTREE(thisLoc)->n - 1 ).key.toBson(scratch), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction ) >= 0 ) {
                         break;
                     }
                 }
                 else {
-                    if ( customBSONCmp( BTREE(thisLoc)->keyNode( 0 ).key.toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction ) <= 0 ) {
+                    if ( customBSONCmp( BTREE(thisLoc)->keyNode( 0 ).key.toBson(scratch), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction ) <= 0 ) {
                         break;
                     }
                 }
@@ -1649,6 +1824,8 @@ namespace mongo {
             locInOut = DiskLoc();
             return;
         }
+        // every key compared is decoded into this one buffer
+        BufBuilder scratch;
         // go down until find smallest/biggest >=/<= target
         while( 1 ) {
             int l = 0;
@@ -1658,7 +1835,7 @@ namespace mongo {
             int z = (1-direction)/2*h;
 
             // leftmost/rightmost key may possibly be >=/<= search key
-            int res = customBSONCmp( bucket->keyNode( z ).key.toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction );
+            int res = customBSONCmp( bucket->keyNode( z ).key.toBson(scratch), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction );
             bool firstCheck = direction*res >= 0;
 
             if ( firstCheck ) {
@@ -1682,7 +1859,7 @@ namespace mongo {
                 }
             }
 
-            res = customBSONCmp( bucket->keyNode( h-z ).key.toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction );
+            res = customBSONCmp( bucket->keyNode( h-z ).key.toBson(scratch), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction );
             bool secondCheck = direction*res < 0;
 
             if ( secondCheck ) {
@@ -1706,7 +1883,7 @@ namespace mongo {
                 }
             }
 
-            if ( !customFind( l, h, keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction, locInOut, keyOfs, bestParent ) ) {
+            if ( !customFind( l, h, keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction, locInOut, keyOfs, bestParent, scratch ) ) {
                 return;
             }
             bucket = BTREE(locInOut);
@@ -1807,6 +1984,7 @@ namespace mongo {
         }
 
         int x;
+        BtreeLatches::WriteScope latches;
         try {
             x = _insert(thisLoc, recordLoc, key, order, dupsAllowed, DiskLoc(), DiskLoc(), idx);
             this->assertValid( order );
@@ -32,6 +32,7 @@
 
 #include "mongo/pch.h"
 
+#include "mongo/db/btree_latch.h"
 #include "mongo/db/diskloc.h"
 #include "mongo/db/dur.h"
 #include "mongo/db/jsobj.h"
@@ -578,8 +579,10 @@ namespace mongo {
          * @return the key index to be promoted on split
          * @param keypos The requested index of a key to insert, which may affect
          *  the choice of split position.
+         * @param rightPercent About how much of the bucket the keys moved to the new right
+         *  bucket should fill, in percent.
          */
-        int splitPos( int keypos ) const;
+        int splitPos( int keypos, int rightPercent ) const;
 
         /**
          * Preconditions: nAdd * sizeof( _KeyNode ) <= emptySize
@@ -606,6 +609,9 @@ namespace mongo {
 
     class IndexDetails;
 
+    /** What a step of BtreeBucket::defragStep() did. */
+    enum BtreeDefragResult { DefragMerged, DefragMovedOn, DefragDone };
+
     /**
      * This class adds functionality for manipulating buckets that are assembled
      * in a tree.  The requirements for const and non const functions and
@@ -724,6 +730,22 @@ namespace mongo {
          */
         bool unindex(const DiskLoc thisLoc, IndexDetails& id, const BSONObj& key, const DiskLoc recordLoc) const;
 
+        /**
+         * One step of background defragmentation, called on the head.  Finds the leaf holding
+         * or following resumeKey / resumeLoc, or the first leaf if resumeKey is empty, and
+         * merges it with its right sibling if both fit in one bucket.  Deletes leave buckets
+         * half full before they're merged, so this is what shrinks an index after a large
+         * remove.
+         *
+         * @return DefragMerged if the leaf was merged, leaving resumeKey / resumeLoc on it so
+         *   the next step may merge it again, DefragMovedOn if it wasn't, moving them to the
+         *   next leaf, and DefragDone if there is no next leaf.
+         *
+         * Postconditions: as for a delete, the head may change.
+         */
+        BtreeDefragResult defragStep(const DiskLoc thisLoc, IndexDetails& id, BSONObj& resumeKey,
+                                     DiskLoc& resumeLoc) const;
+
         /**
          * locate may return an "unused" key that is just a marker.  so be careful.
          *   looks for a key:recordloc pair.
@@ -768,6 +790,16 @@ namespace mongo {
         static int getKeyMax();
 
     protected:
+        /**
+         * locate() and advance() for one optimistic pass, adding each bucket looked at to
+         * 'reads'.  The result may only be used if the read set still validates afterwards.
+         */
+        DiskLoc _locate(const IndexDetails &idx, const DiskLoc& thisLoc, const Key& key,
+                        const Ordering &order, int& pos, bool& found, const DiskLoc &recordLoc,
+                        int direction, BtreeLatches::ReadSet* reads) const;
+        DiskLoc _advance(const DiskLoc& thisLoc, int& keyOfs, int direction, const char *caller,
+                         BtreeLatches::ReadSet* reads) const;
+
         /**
          * Preconditions:
          *  - 0 <= firstIndex <= n
@@ -905,7 +937,7 @@ namespace mongo {
          * @return index of the rebalanced separator; the index value is
          *  determined as if we had a bucket with body
          *  <left bucket keys array>.push( <old separator> ).concat( <right bucket keys array> )
-         *  and called splitPos( 0 ) on it.
+         *  and called splitPos( 0, 50 ) on it.
          */
         int rebalancedSeparatorPos( const DiskLoc &thisLoc, int leftIndex ) const;
 
@@ -966,7 +998,7 @@ namespace mongo {
                     const DiskLoc lChild, const DiskLoc rChild, IndexDetails &idx) const;
 
         bool find(const IndexDetails& idx, const Key& key, const DiskLoc &recordLoc, const Ordering &order, int& pos, bool assertIfDup) const;        
-        static bool customFind( int l, int h, const BSONObj &keyBegin, int keyBeginLen, bool afterKey, const vector< const BSONElement * > &keyEnd, const vector< bool > &keyEndInclusive, const Ordering &order, int direction, DiskLoc &thisLoc, int &keyOfs, pair< DiskLoc, int > &bestParent ) ;
+        static bool customFind( int l, int h, const BSONObj &keyBegin, int keyBeginLen, bool afterKey, const vector< const BSONElement * > &keyEnd, const vector< bool > &keyEndInclusive, const Ordering &order, int direction, DiskLoc &thisLoc, int &keyOfs, pair< DiskLoc, int > &bestParent, BufBuilder &scratch ) ;
         static void findLargestKey(const DiskLoc& thisLoc, DiskLoc& largestLoc, int& largestKey);
         static int customBSONCmp( const BSONObj &l, const BSONObj &rBegin, int rBeginLen, bool rSup, const vector< const BSONElement * > &rEnd, const vector< bool > &rEndInclusive, const Ordering &o, int direction );
         
@@ -1018,6 +1050,7 @@ namespace mongo {
     template< class V >
     BtreeBucket<V> * DiskLoc::btreemod() const {
         verify( _a != -1 );
+        BtreeLatches::noteWrite( *this );
         BtreeBucket<V> *b = const_cast< BtreeBucket<V> * >( btree<V>() );
         return static_cast< BtreeBucket<V>* >( getDur().writingPtr( b, V::BucketSize ) );
     }
@@ -0,0 +1,186 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/db/btree_defrag.h"
+
+#include <deque>
+
+#include "mongo/base/counter.h"
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/background.h"
+#include "mongo/db/btree.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/database_holder.h"
+#include "mongo/db/dur.h"
+#include "mongo/db/instance.h"
+#include "mongo/db/pdfile.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/background.h"
+
+namespace mongo {
+
+    Counter64 defragBucketsVisited;
+    Counter64 defragBucketsMerged;
+    Counter64 defragIndexesFinished;
+
+    ServerStatusMetricField<Counter64> defragBucketsVisitedDisplay("btree.defrag.bucketsVisited",
+                                                                   &defragBucketsVisited);
+    ServerStatusMetricField<Counter64> defragBucketsMergedDisplay("btree.defrag.bucketsMerged",
+                                                                  &defragBucketsMerged);
+    ServerStatusMetricField<Counter64> defragIndexesFinishedDisplay("btree.defrag.indexesFinished",
+                                                                    &defragIndexesFinished);
+
+    // 0 leaves the defragmenter idle
+    MONGO_EXPORT_SERVER_PARAMETER( btreeDefragStepsPerSecond, int, 0 );
+
+    // How many steps are taken under one write lock before it is released for others.
+    static const int stepsPerLock = 64;
+
+    /**
+     * Works through every completed index, leaf by leaf, merging each leaf with its right
+     * sibling while the two fit in one bucket.  Deletes only merge a bucket once it is below
+     * lowWaterMark, so after a large remove an index can be twice the size its keys need; this
+     * brings it back without a reIndex.  Each batch of steps takes its own write lock, and where
+     * it got to is kept as a key, so the index may change freely in between.
+     */
+    class BtreeDefragmenter : public BackgroundJob {
+    public:
+        BtreeDefragmenter() {}
+        virtual ~BtreeDefragmenter() {}
+
+        virtual string name() const { return "BtreeDefragmenter"; }
+
+        virtual void run() {
+            Client::initThread( name().c_str() );
+            cc().getAuthorizationSession()->grantInternalAuthorization();
+
+            while ( ! inShutdown() ) {
+                sleepsecs( 1 );
+
+                int steps = btreeDefragStepsPerSecond;
+                while ( steps > 0 && ! inShutdown() ) {
+                    int taken = 0;
+                    try {
+                        taken = defragSome( std::min( steps, stepsPerLock ) );
+                    }
+                    catch ( DBException& e ) {
+                        error() << "btree defragmenter stopped on " << _indexName << " of "
+                                << _ns << ": " << e << endl;
+                        _ns.clear();
+                        break;
+                    }
+                    if ( taken == 0 )
+                        break;
+                    steps -= taken;
+                }
+            }
+        }
+
+    private:
+        /** @return how many steps were taken, 0 if there is nothing to do */
+        int defragSome( int maxSteps ) {
+            if ( _ns.empty() ) {
+                if ( _todo.empty() )
+                    findIndexes();
+                if ( _todo.empty() )
+                    return 0;
+                _ns = _todo.front().first;
+                _indexName = _todo.front().second;
+                _todo.pop_front();
+                _resumeKey = BSONObj();
+                _resumeLoc = DiskLoc();
+            }
+
+            Client::WriteContext ctx( _ns );
+            NamespaceDetails* d = nsdetails( _ns );
+            int idxNo = d ? d->findIndexByName( _indexName ) : -1;
+            if ( idxNo < 0 || BackgroundOperation::inProgForNs( _ns ) ) {
+                // dropped since we found it, or being built or compacted: leave it be this pass
+                _ns.clear();
+                return 1;
+            }
+
+            IndexDetails& id = d->idx( idxNo );
+            int steps = 0;
+            while ( steps < maxSteps ) {
+                steps++;
+                defragBucketsVisited.increment();
+                BtreeDefragResult result = 0 == id.version() ?
+                    id.head.btree<V0>()->defragStep( id.head, id, _resumeKey, _resumeLoc ) :
+                    id.head.btree<V1>()->defragStep( id.head, id, _resumeKey, _resumeLoc );
+                if ( result == DefragMerged ) {
+                    defragBucketsMerged.increment();
+                }
+                else if ( result == DefragDone ) {
+                    defragIndexesFinished.increment();
+                    _ns.clear();
+                    break;
+                }
+                getDur().commitIfNeeded();
+            }
+            return steps;
+        }
+
+        void findIndexes() {
+            set<string> dbs;
+            {
+                Lock::DBRead lk( "local" );
+                dbHolder().getAllShortNames( dbs );
+            }
+
+            for ( set<string>::const_iterator i = dbs.begin(); i != dbs.end(); ++i ) {
+                Client::ReadContext ctx( *i );
+                list<string> collections;
+                cc().database()->namespaceIndex().getNamespaces( collections );
+                for ( list<string>::const_iterator j = collections.begin();
+                      j != collections.end(); ++j ) {
+                    NamespaceDetails* d = nsdetails( *j );
+                    if ( ! d )
+                        continue;
+                    for ( int k = 0; k < d->getCompletedIndexCount(); k++ ) {
+                        _todo.push_back( make_pair( *j, d->idx( k ).indexName() ) );
+                    }
+                }
+            }
+        }
+
+        std::deque<pair<string, string> > _todo;   // ns and index name
+        string _ns;             // of the index being defragmented, or empty between indexes
+        string _indexName;
+        BSONObj _resumeKey;     // the first key of the next leaf to look at
+        DiskLoc _resumeLoc;
+    };
+
+    void startBtreeDefragmenter() {
+        BtreeDefragmenter* defragmenter = new BtreeDefragmenter();
+        defragmenter->go();
+    }
+}
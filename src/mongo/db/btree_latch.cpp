@@ -0,0 +1,157 @@
+// btree_latch.cpp
+
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/btree_latch.h"
+
+#include <algorithm>
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/threadlocal.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    namespace {
+
+        struct Latch {
+            AtomicUInt32 writers;
+            AtomicUInt32 version;
+        };
+
+        const unsigned NumLatches = 4096;
+        Latch latches[NumLatches];
+
+        ThreadLocalValue<BtreeLatches::WriteScope*> currentWriteScope;
+
+        unsigned slotFor(const DiskLoc& bucket) {
+            unsigned x = static_cast<unsigned>(bucket.a()) * 0x9E3779B1U ^
+                static_cast<unsigned>(bucket.getOfs());
+            x ^= x >> 15;
+            x *= 0x2C1B3C6DU;
+            x ^= x >> 12;
+            return x & (NumLatches - 1);
+        }
+
+        bool heldByThisThread(unsigned slot) {
+            BtreeLatches::WriteScope* scope = currentWriteScope.get();
+            return scope && scope->holds(slot);
+        }
+
+    } // namespace
+
+    // static
+    unsigned BtreeLatches::readBegin(const DiskLoc& bucket) {
+        unsigned slot = slotFor(bucket);
+        Latch& latch = latches[slot];
+        for (int spins = 0; ; ++spins) {
+            if (latch.writers.load() == 0) {
+                unsigned version = latch.version.load();
+                if (latch.writers.load() == 0)
+                    return version;
+            }
+            // our own operation's latches don't keep us from reading what it has written
+            if (heldByThisThread(slot))
+                return latch.version.load();
+            if (spins > 1000)
+                sleepmillis(0);
+        }
+    }
+
+    // static
+    bool BtreeLatches::validate(const DiskLoc& bucket, unsigned version) {
+        unsigned slot = slotFor(bucket);
+        Latch& latch = latches[slot];
+        if (latch.version.load() != version)
+            return false;
+        return latch.writers.load() == 0 || heldByThisThread(slot);
+    }
+
+    // static
+    void BtreeLatches::noteWrite(const DiskLoc& bucket) {
+        unsigned slot = slotFor(bucket);
+        Latch& latch = latches[slot];
+        WriteScope* scope = currentWriteScope.get();
+        if (!scope) {
+            latch.version.fetchAndAdd(1);
+            return;
+        }
+        if (scope->holds(slot))
+            return;
+        latch.writers.fetchAndAdd(1);
+        latch.version.fetchAndAdd(1);
+        scope->_held.push_back(slot);
+    }
+
+    BtreeLatches::WriteScope::WriteScope() : _outermost(currentWriteScope.get() == NULL) {
+        if (_outermost)
+            currentWriteScope.set(this);
+    }
+
+    BtreeLatches::WriteScope::~WriteScope() {
+        if (!_outermost)
+            return;
+        for (std::vector<unsigned>::const_iterator i = _held.begin(); i != _held.end(); ++i) {
+            Latch& latch = latches[*i];
+            latch.version.fetchAndAdd(1);
+            latch.writers.fetchAndSubtract(1);
+        }
+        currentWriteScope.set(NULL);
+    }
+
+    bool BtreeLatches::WriteScope::holds(unsigned slot) const {
+        return std::find(_held.begin(), _held.end(), slot) != _held.end();
+    }
+
+    void BtreeLatches::ReadSet::add(const DiskLoc& bucket) {
+        Read r;
+        r.bucket = bucket;
+        r.version = readBegin(bucket);
+        if (_n < InlineReads)
+            _reads[_n++] = r;
+        else
+            _more.push_back(r);
+    }
+
+    bool BtreeLatches::ReadSet::validate() const {
+        for (int i = 0; i < _n; ++i) {
+            if (!BtreeLatches::validate(_reads[i].bucket, _reads[i].version))
+                return false;
+        }
+        for (std::vector<Read>::const_iterator i = _more.begin(); i != _more.end(); ++i) {
+            if (!BtreeLatches::validate(i->bucket, i->version))
+                return false;
+        }
+        return true;
+    }
+
+} // namespace mongo
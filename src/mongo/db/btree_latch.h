@@ -0,0 +1,111 @@
+// btree_latch.h
+
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include <boost/noncopyable.hpp>
+#include <vector>
+
+#include "mongo/db/diskloc.h"
+
+namespace mongo {
+
+    /**
+     * Version-validated latches on btree buckets.
+     *
+     * Each bucket hashes onto one of a fixed table of latches (so unrelated buckets may share
+     * one).  A latch has a count of the writers holding it and a version that changes whenever
+     * it is taken or released.  Readers don't take latches: they note the version of each bucket
+     * they look at and validate the versions once they are done, starting over if any changed.
+     * Writers latch each bucket as they first modify it (see DiskLoc::btreemod) and release the
+     * latches when their WriteScope ends.  Writers never wait on each other, so holding several
+     * latches can't deadlock; readers wait only while a bucket they look at is latched.
+     *
+     * Btree operations still run under the database lock, so for now a read never fails
+     * validation.  This is the groundwork for letting reads run without it: a traversal that
+     * loses a race with a split also needs a way to the new right sibling, as in a B-link tree.
+     */
+    class BtreeLatches {
+    public:
+        /** Begins an optimistic read of 'bucket' and returns the version to validate against. */
+        static unsigned readBegin(const DiskLoc& bucket);
+
+        /** @return true if 'bucket' hasn't been written since readBegin() returned 'version'. */
+        static bool validate(const DiskLoc& bucket, unsigned version);
+
+        /**
+         * Notes that 'bucket' is about to be modified.  Inside a WriteScope the bucket stays
+         * latched until the scope ends.  Outside one the bucket's readers are just invalidated.
+         */
+        static void noteWrite(const DiskLoc& bucket);
+
+        /**
+         * Holds the latches of the buckets modified by one btree operation until it's done.
+         * Scopes nest: an inner scope leaves its latches to the outermost one.
+         */
+        class WriteScope : boost::noncopyable {
+        public:
+            WriteScope();
+            ~WriteScope();
+
+            /** @return true if this scope holds latch 'slot'. */
+            bool holds(unsigned slot) const;
+        private:
+            friend class BtreeLatches;
+            bool _outermost;
+            std::vector<unsigned> _held;
+        };
+
+        /** The buckets looked at by one traversal, validated together at its end. */
+        class ReadSet : boost::noncopyable {
+        public:
+            ReadSet() : _n(0) { }
+
+            void add(const DiskLoc& bucket);
+
+            /** @return true if none of the buckets added has been written since. */
+            bool validate() const;
+
+            void clear() { _n = 0; _more.clear(); }
+
+        private:
+            struct Read {
+                DiskLoc bucket;
+                unsigned version;
+            };
+            enum { InlineReads = 16 };
+            Read _reads[InlineReads];
+            int _n;
+            std::vector<Read> _more;
+        };
+    };
+
+} // namespace mongo
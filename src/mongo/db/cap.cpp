@@ -34,6 +34,7 @@
 #include <algorithm>
 #include <list>
 
+#include "mongo/db/capped_insert_notifier.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/db.h"
 #include "mongo/db/json.h"
@@ -116,6 +117,35 @@ namespace mongo {
 
     }
 
+    /* a looped capped collection is a ring: the cap extent holds one deleted record, the space
+       between the newest record written and the oldest one left.  allocation takes from the front
+       of it and freeing the oldest record grows its back, so there is nothing to search or sort.
+    */
+    void NamespaceDetails::cappedMergeFreed() {
+        verify( isCapped() );
+
+        DiskLoc f = cappedFirstDeletedInCurExtent();
+        verify( !f.isNull() && inCapExtent( f ) );
+        DiskLoc g = f.drec()->nextDeleted();
+        if ( g.isNull() || !inCapExtent( g ) || nextIsInCapExtent( g ) ) {
+            compact();
+            return;
+        }
+
+        DeletedRecord* fd = f.drec();
+        DeletedRecord* gd = g.drec();
+        if ( g.a() == f.a() && g.getOfs() + gd->lengthWithHeaders() == f.getOfs() ) {
+            // the usual case: the free space runs up to the freed record
+            getDur().writingInt( gd->lengthWithHeaders() ) += fd->lengthWithHeaders();
+            getDur().writingDiskLoc( cappedFirstDeletedInCurExtent() ) = g;
+        }
+        else if ( f.a() == g.a() && f.getOfs() + fd->lengthWithHeaders() == g.getOfs() ) {
+            getDur().writingInt( fd->lengthWithHeaders() ) += gd->lengthWithHeaders();
+            getDur().writingDiskLoc( fd->nextDeleted() ) = gd->nextDeleted();
+        }
+        // otherwise the two aren't adjacent and there's nothing to merge
+    }
+
     DiskLoc &NamespaceDetails::cappedFirstDeletedInCurExtent() {
         if ( cappedLastDelRecLastExtent().isNull() )
             return cappedListOfAllDeletedRecords();
@@ -279,7 +309,7 @@ namespace mongo {
 
             DiskLoc fr = theCapExtent()->firstRecord;
             theDataFileMgr.deleteRecord(this, ns, fr.rec(), fr, true); // ZZZZZZZZZZZZ
-            compact();
+            cappedMergeFreed();
             if( ++passes > maxPasses ) {
                 StringBuilder sb;
                 sb << "passes >= maxPasses in NamespaceDetails::cappedAlloc: ns: " << ns
@@ -296,6 +326,9 @@ namespace mongo {
         if ( _capFirstNewRecord.isValid() && _capFirstNewRecord.isNull() )
             getDur().writingDiskLoc(_capFirstNewRecord) = loc;
 
+        // tailers waiting on the collection run once our write lock is released
+        CappedInsertNotifier::notifyInsert(ns);
+
         return loc;
     }
 
@@ -0,0 +1,107 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/db/capped_insert_notifier.h"
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <map>
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+    struct CappedInsertNotifier::Waiters {
+        Waiters() : count(0), version(0) {}
+
+        // notifiers for the collection
+        int count;
+
+        // inserts seen while count is above zero
+        unsigned long long version;
+
+        boost::condition_variable inserted;
+    };
+
+namespace {
+
+    typedef std::map<std::string, CappedInsertNotifier::Waiters*> WaitersByNs;
+
+    // Guards every Waiters as well as the map.  Only ever held briefly.
+    boost::mutex waitersMutex;
+    WaitersByNs waitersByNs;
+
+} // namespace
+
+    CappedInsertNotifier::CappedInsertNotifier(const StringData& ns) : _ns(ns.toString()) {
+        boost::lock_guard<boost::mutex> lk(waitersMutex);
+        Waiters*& waiters = waitersByNs[_ns];
+        if (!waiters)
+            waiters = new Waiters();
+        waiters->count++;
+        _waiters = waiters;
+    }
+
+    CappedInsertNotifier::~CappedInsertNotifier() {
+        boost::lock_guard<boost::mutex> lk(waitersMutex);
+        if (--_waiters->count == 0) {
+            waitersByNs.erase(_ns);
+            delete _waiters;
+        }
+    }
+
+    unsigned long long CappedInsertNotifier::version() const {
+        boost::lock_guard<boost::mutex> lk(waitersMutex);
+        return _waiters->version;
+    }
+
+    bool CappedInsertNotifier::waitForInsert(unsigned long long since, int millis) const {
+        boost::system_time deadline = boost::get_system_time() +
+                                      boost::posix_time::milliseconds(std::max(0, millis));
+        boost::unique_lock<boost::mutex> lk(waitersMutex);
+        while (_waiters->version == since) {
+            if (!_waiters->inserted.timed_wait(lk, deadline))
+                return _waiters->version != since;
+        }
+        return true;
+    }
+
+    void CappedInsertNotifier::notifyInsert(const StringData& ns) {
+        boost::lock_guard<boost::mutex> lk(waitersMutex);
+        if (waitersByNs.empty())
+            return;
+        WaitersByNs::iterator it = waitersByNs.find(ns.toString());
+        if (it == waitersByNs.end())
+            return;
+        it->second->version++;
+        it->second->inserted.notify_all();
+    }
+
+} // namespace mongo
@@ -0,0 +1,77 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+
+namespace mongo {
+
+    /**
+     * Lets an awaitData getMore sleep until something is inserted into its capped collection.
+     *
+     * Usage:
+     *     CappedInsertNotifier notifier(ns);
+     *     unsigned long long version = notifier.version();
+     *     ... look for new documents, and if there are none ...
+     *     notifier.waitForInsert(version, timeoutMillis);
+     *
+     * Inserts only look the collection up here, so a collection nobody is waiting on costs them
+     * one map lookup.
+     */
+    class CappedInsertNotifier {
+        MONGO_DISALLOW_COPYING(CappedInsertNotifier);
+    public:
+        /** Starts counting inserts into 'ns' until this is destroyed. */
+        explicit CappedInsertNotifier(const StringData& ns);
+        ~CappedInsertNotifier();
+
+        /** @return the number of inserts into the collection seen so far */
+        unsigned long long version() const;
+
+        /**
+         * Returns once the collection has seen an insert beyond 'since' or after 'millis'.
+         * @return true if there was an insert
+         */
+        bool waitForInsert(unsigned long long since, int millis) const;
+
+        /** Called by capped inserts, with the collection's write lock held. */
+        static void notifyInsert(const StringData& ns);
+
+        // The notifiers for one collection.  Defined in the .cpp.
+        struct Waiters;
+
+    private:
+        const std::string _ns;
+        Waiters* _waiters;
+    };
+
+} // namespace mongo
@@ -30,8 +30,12 @@
 
 #include "mongo/db/catalog/index_catalog.h"
 
+#include <algorithm>
+#include <boost/scoped_ptr.hpp>
+#include <utility>
 #include <vector>
 
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/audit.h"
 #include "mongo/db/background.h"
 #include "mongo/db/catalog/index_create.h"
@@ -48,9 +52,14 @@
 #include "mongo/db/index/s2_access_method.h"
 #include "mongo/db/index_names.h"
 #include "mongo/db/keypattern.h"
+#include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/ops/delete.h"
+#include "mongo/db/pagefault.h"
+#include "mongo/db/pdfile_private.h"
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/repl/rs.h" // this is ugly
+#include "mongo/db/stats/index_usage.h"
+#include "mongo/db/stats/residency.h"
 #include "mongo/db/structure/collection.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/log.h"
@@ -70,7 +79,8 @@ namespace mongo {
         : _magic(INDEX_CATALOG_MAGIC), _collection( collection ), _details( details ),
           _descriptorCache( NamespaceDetails::NIndexesMax ),
           _accessMethodCache( NamespaceDetails::NIndexesMax ),
-          _forcedBtreeAccessMethodCache( NamespaceDetails::NIndexesMax ) {
+          _forcedBtreeAccessMethodCache( NamespaceDetails::NIndexesMax ),
+          _batchInsert( false ), _numBatchKeys( 0 ) {
     }
 
     IndexCatalog::~IndexCatalog() {
@@ -179,26 +189,23 @@ namespace mongo {
         return Status::OK();
     }
 
-    Status IndexCatalog::createIndex( BSONObj spec, bool mayInterrupt ) {
-
-        // 1) add entry in system.indexes
-        // 2) call into buildAnIndex?
+    Status IndexCatalog::_insertIndexSpec( BSONObj* spec, DiskLoc* infoLoc ) {
 
-        Status status = okToAddIndex( spec );
+        Status status = okToAddIndex( *spec );
         if ( !status.isOK() )
             return status;
 
-        spec = fixIndexSpec( spec );
+        *spec = fixIndexSpec( *spec );
 
         // we double check with new index spec
-        status = okToAddIndex( spec );
+        status = okToAddIndex( *spec );
         if ( !status.isOK() )
             return status;
 
 
         Database* db = _collection->_database;
 
-        string pluginName = IndexNames::findPluginName( spec["key"].Obj() );
+        string pluginName = IndexNames::findPluginName( (*spec)["key"].Obj() );
         if ( pluginName.size() ) {
             Status s = _upgradeDatabaseMinorVersionIfNeeded( pluginName );
             if ( !s.isOK() )
@@ -212,11 +219,25 @@ namespace mongo {
             verify( systemIndexes );
         }
 
-        StatusWith<DiskLoc> loc = systemIndexes->insertDocument( spec, false );
+        StatusWith<DiskLoc> loc = systemIndexes->insertDocument( *spec, false );
         if ( !loc.isOK() )
             return loc.getStatus();
         verify( !loc.getValue().isNull() );
 
+        *infoLoc = loc.getValue();
+        return Status::OK();
+    }
+
+    Status IndexCatalog::createIndex( BSONObj spec, bool mayInterrupt ) {
+
+        // 1) add entry in system.indexes
+        // 2) call into buildAnIndex?
+
+        DiskLoc infoLoc;
+        Status status = _insertIndexSpec( &spec, &infoLoc );
+        if ( !status.isOK() )
+            return status;
+
         string idxName = spec["name"].valuestr();
 
         // Set curop description before setting indexBuildInProg, so that there's something
@@ -226,7 +247,7 @@ namespace mongo {
             cc().curop()->setQuery( spec );
         }
 
-        IndexBuildBlock indexBuildBlock( this, idxName, loc.getValue() );
+        IndexBuildBlock indexBuildBlock( this, idxName, infoLoc );
         verify( indexBuildBlock.indexDetails() );
 
         try {
@@ -236,25 +257,93 @@ namespace mongo {
             return Status::OK();
         }
         catch (DBException& e) {
-            // save our error msg string as an exception or dropIndexes will overwrite our message
-            LastError *le = lastError.get();
-            int savecode = 0;
-            string saveerrmsg;
-            if ( le ) {
-                savecode = le->code;
-                saveerrmsg = le->msg;
-            }
-            else {
-                savecode = e.getCode();
-                saveerrmsg = e.what();
+            _saveBuildError( e );
+            throw; // XXX
+        }
+
+
+    }
+
+    Status IndexCatalog::createIndexes( const std::vector<BSONObj>& specs, bool mayInterrupt ) {
+
+        // Background builds scan on their own, and dropping duplicates deletes documents the
+        // other indexes have already seen, so those are built one at a time.
+        std::vector<BSONObj> shared;
+        for ( size_t i = 0; i < specs.size(); ++i ) {
+            const BSONObj& spec = specs[i];
+            if ( specs.size() > 1 &&
+                 !inDBRepair &&
+                 !spec["background"].trueValue() &&
+                 !spec["dropDups"].trueValue() ) {
+                shared.push_back( spec );
+                continue;
             }
+            Status status = createIndex( spec, mayInterrupt );
+            if ( !status.isOK() && status.code() != ErrorCodes::IndexAlreadyExists )
+                return status;
+        }
 
-            verify(le && !saveerrmsg.empty());
-            setLastError(savecode,saveerrmsg.c_str());
-            throw; // XXX
+        if ( shared.empty() )
+            return Status::OK();
+
+        if ( mayInterrupt ) {
+            BSONArrayBuilder b;
+            for ( size_t i = 0; i < shared.size(); ++i )
+                b.append( shared[i] );
+            cc().curop()->setQuery( BSON( "createIndexes" << _collection->ns().coll() <<
+                                          "indexes" << b.arr() ) );
+        }
+
+        // If any of these fails they're all dropped.
+        OwnedPointerVector<IndexBuildBlock> blocks;
+        std::vector<IndexDetails*> indexes;
+        for ( size_t i = 0; i < shared.size(); ++i ) {
+            BSONObj spec = shared[i];
+            DiskLoc infoLoc;
+            Status status = _insertIndexSpec( &spec, &infoLoc );
+            if ( status.code() == ErrorCodes::IndexAlreadyExists )
+                continue;
+            if ( !status.isOK() )
+                return status;
+
+            IndexBuildBlock* block = new IndexBuildBlock( this, spec["name"].valuestr(), infoLoc );
+            blocks.mutableVector().push_back( block );
+            verify( block->indexDetails() );
+            indexes.push_back( block->indexDetails() );
+        }
+
+        if ( indexes.empty() )
+            return Status::OK();
+
+        try {
+            buildIndexes( _collection, indexes, mayInterrupt );
+            for ( size_t i = 0; i < blocks.size(); ++i )
+                blocks.vector()[i]->success();
+            return Status::OK();
+        }
+        catch (DBException& e) {
+            _saveBuildError( e );
+            throw;
         }
+    }
 
+    // static
+    void IndexCatalog::_saveBuildError( const DBException& e ) {
+        // save our error msg string as an exception or dropIndexes will overwrite our message
+        LastError *le = lastError.get();
+        int savecode = 0;
+        string saveerrmsg;
+        if ( le ) {
+            savecode = le->code;
+            saveerrmsg = le->msg;
+        }
+        else {
+            savecode = e.getCode();
+            saveerrmsg = e.what();
+        }
 
+        verify(le && !saveerrmsg.empty());
+        setLastError(savecode,saveerrmsg.c_str());
     }
 
     IndexCatalog::IndexBuildBlock::IndexBuildBlock( IndexCatalog* catalog,
@@ -462,6 +551,63 @@ namespace mongo {
 
         }
 
+        BSONElement filterElt = spec["partialFilterExpression"];
+        if ( !filterElt.eoo() ) {
+            Status status = validPartialFilter( key, filterElt );
+            if ( !status.isOK() )
+                return status;
+        }
+
+        return Status::OK();
+    }
+
+    namespace {
+        // Partial index filters are kept to conjunctions of simple comparisons, which are cheap
+        // to test on every write and which the planners can reason about.
+        bool isSimpleFilter( const MatchExpression* expr ) {
+            switch ( expr->matchType() ) {
+            case MatchExpression::AND:
+                for ( size_t i = 0; i < expr->numChildren(); ++i ) {
+                    if ( !isSimpleFilter( expr->getChild( i ) ) )
+                        return false;
+                }
+                return true;
+            case MatchExpression::EQ:
+            case MatchExpression::LT:
+            case MatchExpression::LTE:
+            case MatchExpression::GT:
+            case MatchExpression::GTE:
+            case MatchExpression::EXISTS:
+            case MatchExpression::TYPE_OPERATOR:
+                return true;
+            default:
+                return false;
+            }
+        }
+    }
+
+    Status IndexCatalog::validPartialFilter( const BSONObj& key, const BSONElement& filter ) {
+        if ( IndexDetails::isIdIndexPattern( key ) )
+            return Status( ErrorCodes::CannotCreateIndex,
+                           "the _id index cannot be partial" );
+
+        if ( !filter.isABSONObj() )
+            return Status( ErrorCodes::CannotCreateIndex,
+                           "partialFilterExpression must be an object" );
+
+        StatusWithMatchExpression parsed = MatchExpressionParser::parse( filter.Obj() );
+        if ( !parsed.isOK() )
+            return Status( ErrorCodes::CannotCreateIndex,
+                           str::stream() << "bad partialFilterExpression: "
+                           << parsed.getStatus().reason() );
+
+        boost::scoped_ptr<MatchExpression> expr( parsed.getValue() );
+        if ( !isSimpleFilter( expr.get() ) )
+            return Status( ErrorCodes::CannotCreateIndex,
+                           str::stream() << "partialFilterExpression may only use $and, "
+                           << "equality, $lt, $lte, $gt, $gte, $exists and $type: "
+                           << filter.Obj() );
+
         return Status::OK();
     }
 
@@ -566,6 +712,9 @@ namespace mongo {
         string indexNamespace = _details->idx( idxNo ).indexNamespace();
         string indexName = _details->idx( idxNo ).indexName();
 
+        IndexUsageTracker::global.indexDropped( indexNamespace );
+        ResidencyTracker::global.indexDropped( indexNamespace );
+
         // delete my entries first so we don't have invalid pointers lying around
         delete _descriptorCache[idxNo];
         delete _accessMethodCache[idxNo];
@@ -789,9 +938,29 @@ namespace mongo {
 
 
     void IndexCatalog::indexRecord( const BSONObj& obj, const DiskLoc &loc ) {
+        _collection->infoCache()->idLookupCache()->invalidate( obj["_id"] );
+
+        // Keys a batch insert holds back.  They only join _batchKeys once every index has taken
+        // obj, so a failure below has nothing of obj's to take back out.
+        vector<KeyLocVector> heldKeys;
 
         for ( int i = 0; i < numIndexesTotal(); i++ ) {
             try {
+                if ( _batchInsert && _canBatchKeys( i ) ) {
+                    IndexDescriptor* desc = getDescriptor( i );
+                    BtreeBasedAccessMethod* iam =
+                        static_cast<BtreeBasedAccessMethod*>( getIndex( desc ) );
+                    BSONObjSet keys;
+                    iam->getIndexedKeys( obj, &keys );
+                    if ( heldKeys.empty() )
+                        heldKeys.resize( numIndexesTotal() );
+                    for ( BSONObjSet::const_iterator k = keys.begin(); k != keys.end(); ++k )
+                        heldKeys[i].push_back( make_pair( *k, loc ) );
+                    if ( keys.size() > 1 )
+                        desc->setMultikey();
+                    continue;
+                }
+
                 Status s = _indexRecord( i, obj, loc );
                 uassert(s.location(), s.reason(), s.isOK() );
             }
@@ -812,9 +981,94 @@ namespace mongo {
             }
         }
 
+        for ( size_t i = 0; i < heldKeys.size(); i++ ) {
+            KeyLocVector& keys = _batchKeys[i];
+            keys.insert( keys.end(), heldKeys[i].begin(), heldKeys[i].end() );
+            _numBatchKeys += heldKeys[i].size();
+        }
+
+        // Bound the memory a long batch holds.
+        if ( _numBatchKeys >= 100 * 1000 )
+            _flushBatchKeys();
+    }
+
+    void IndexCatalog::beginBatchInsert() {
+        verify( !_batchInsert );
+        if ( _details->isCapped() )
+            return;
+        _batchInsert = true;
+        _batchKeys.resize( NamespaceDetails::NIndexesMax );
+    }
+
+    void IndexCatalog::finishBatchInsert() {
+        if ( !_batchInsert )
+            return;
+        _flushBatchKeys();
+        _batchInsert = false;
+    }
+
+    bool IndexCatalog::_canBatchKeys( int idxNo ) {
+        // Background builds and their change logs see inserts as they come.
+        if ( idxNo >= numIndexesReady() )
+            return false;
+
+        IndexDescriptor* desc = getDescriptor( idxNo );
+        return ignoreUniqueIndex( desc->getOnDisk() ) ||
+            ( !KeyPattern::isIdKeyPattern( desc->keyPattern() ) && !desc->unique() );
+    }
+
+    namespace {
+        // Orders a batch's keys the way the index does, with ties broken by record.
+        class KeyLocLess {
+        public:
+            KeyLocLess( const BSONObj& keyPattern ) : _ordering( Ordering::make( keyPattern ) ) { }
+            bool operator()( const pair<BSONObj, DiskLoc>& l,
+                             const pair<BSONObj, DiskLoc>& r ) const {
+                int cmp = l.first.woCompare( r.first, _ordering, false );
+                if ( cmp != 0 )
+                    return cmp < 0;
+                return l.second < r.second;
+            }
+        private:
+            Ordering _ordering;
+        };
+    }
+
+    void IndexCatalog::_flushBatchKeys() {
+        if ( _numBatchKeys == 0 )
+            return;
+
+        // This can run as an insert unwinds, so it mustn't start another retry.
+        NoPageFaultsAllowed npfa;
+
+        for ( size_t i = 0; i < _batchKeys.size(); i++ ) {
+            KeyLocVector& keys = _batchKeys[i];
+            if ( keys.empty() )
+                continue;
+
+            IndexDescriptor* desc = getDescriptor( i );
+            std::sort( keys.begin(), keys.end(), KeyLocLess( desc->keyPattern() ) );
+
+            int64_t inserted;
+            BtreeBasedAccessMethod* iam = static_cast<BtreeBasedAccessMethod*>( getIndex( desc ) );
+            Status s = iam->insertKeys( keys, &inserted );
+            if ( !s.isOK() ) {
+                problem() << "batch insert couldn't index every key in "
+                          << desc->indexNamespace() << ": " << s.toString();
+            }
+
+            KeyLocVector().swap( keys );
+        }
+        _numBatchKeys = 0;
     }
 
     void IndexCatalog::unindexRecord( const BSONObj& obj, const DiskLoc& loc, bool noWarn ) {
+        _collection->infoCache()->idLookupCache()->invalidate( obj["_id"] );
+
+        // Anything a batch holds back has to be in the indexes before keys come out of them.
+        if ( _batchInsert )
+            _flushBatchKeys();
+
         int numIndices = numIndexesTotal();
 
         for (int i = 0; i < numIndices; i++) {
@@ -82,6 +82,13 @@ namespace mongo {
 
         Status createIndex( BSONObj spec, bool mayInterrupt );
 
+        /**
+         * Creates several indexes.  Those built in the foreground without dropDups are built
+         * together from one scan of the collection, and if one of them fails all of them are
+         * dropped.  Specs for indexes that already exist are skipped.
+         */
+        Status createIndexes( const std::vector<BSONObj>& specs, bool mayInterrupt );
+
         Status okToAddIndex( const BSONObj& spec ) const;
 
         // Status addIndex( ... )
@@ -128,6 +135,17 @@ namespace mongo {
         // this throws for now
         void indexRecord( const BSONObj& obj, const DiskLoc &loc );
 
+        /**
+         * While a batch insert is open, indexRecord holds back the keys of indexes that allow
+         * duplicates, and finishBatchInsert puts them in each btree in one ordered pass, rather
+         * than descending every btree for every document.  Indexes checking uniqueness are still
+         * maintained document by document.  The write lock must be held from begin to finish,
+         * and finish must be called, even on error, before anything reads the indexes.  Does
+         * nothing for capped collections, whose inserts can delete documents.
+         */
+        void beginBatchInsert();
+        void finishBatchInsert();
+
         void unindexRecord( const BSONObj& obj, const DiskLoc& loc, bool noWarn );
 
         /**
@@ -149,10 +167,22 @@ namespace mongo {
 
         static BSONObj fixIndexKey( const BSONObj& key );
 
+        // checks the filter of a partial index with key pattern 'key'
+        static Status validPartialFilter( const BSONObj& key, const BSONElement& filter );
+
     private:
 
         Status _upgradeDatabaseMinorVersionIfNeeded( const string& newPluginName );
 
+        /**
+         * Checks and fixes up 'spec', then adds it to system.indexes.
+         * @param infoLoc set to the location of the new system.indexes entry
+         */
+        Status _insertIndexSpec( BSONObj* spec, DiskLoc* infoLoc );
+
+        /** Keeps a failed build's error from being overwritten by dropping the index. */
+        static void _saveBuildError( const DBException& e );
+
         /**
          * this is just an attempt to clean up old orphaned stuff on a delete all indexes
          * call. repair database is the clean solution, but this gives one a lighter weight
@@ -175,6 +205,12 @@ namespace mongo {
         void _checkMagic() const;
 
         Status _indexRecord( int idxNo, const BSONObj& obj, const DiskLoc &loc );
+
+        /** Can a batch insert hold back the keys for index idxNo? */
+        bool _canBatchKeys( int idxNo );
+
+        /** Put the keys held back by a batch insert in their indexes. */
+        void _flushBatchKeys();
         Status _unindexRecord( int idxNo, const BSONObj& obj, const DiskLoc &loc, bool logIfError );
 
         /**
@@ -193,6 +229,12 @@ namespace mongo {
         std::vector<IndexAccessMethod*> _accessMethodCache;
         std::vector<BtreeBasedAccessMethod*> _forcedBtreeAccessMethodCache;
 
+        // Keys held back by an open batch insert, by index number.
+        typedef std::vector< std::pair<BSONObj, DiskLoc> > KeyLocVector;
+        bool _batchInsert;
+        std::vector<KeyLocVector> _batchKeys;
+        size_t _numBatchKeys;
+
         static const BSONObj _idObj; // { _id : 1 }
     };
 
@@ -47,11 +47,16 @@
 #include "mongo/db/repl/is_master.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/rs.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/structure/collection.h"
 #include "mongo/util/processinfo.h"
 
 namespace mongo {
 
+    // Background builds of indexes that allow duplicates sort the collection's keys and bulk
+    // load the btree rather than inserting documents one at a time.
+    MONGO_EXPORT_SERVER_PARAMETER(backgroundIndexBulkLoad, bool, true);
+
     /**
      * Add the provided (obj, dl) pair to the provided index.
      */
@@ -120,7 +125,14 @@ namespace mongo {
 
         try {
             idx.head.writing() = BtreeBasedBuilder::makeEmptyIndex( idx );
-            unsigned long long n = addExistingToIndex( collection, idx );
+            // Writers' inserts into a unique index are checked against it as they happen, which
+            // a bulk load can't do, so those still go one document at a time.
+            bool bulkLoad = backgroundIndexBulkLoad &&
+                            !idx.unique() &&
+                            !KeyPattern::isIdKeyPattern( idx.keyPattern() );
+            unsigned long long n = bulkLoad ?
+                BtreeBasedBuilder::backgroundBuildIndex( collection, idx.indexName() ) :
+                addExistingToIndex( collection, idx );
             // idx may point at an invalid index entry at this point
             done( ns );
             return n;
@@ -265,5 +277,48 @@ namespace mongo {
         MONGO_TLOG(0) << "build index done.  scanned " << n << " total records. " << t.millis() / 1000.0 << " secs" << endl;
     }
 
+    // throws DBException
+    void buildIndexes( Collection* collection,
+                       const std::vector<IndexDetails*>& indexes,
+                       bool mayInterrupt ) {
+
+        if ( indexes.size() == 1 ) {
+            buildAnIndex( collection, *indexes[0], mayInterrupt );
+            return;
+        }
+
+        string ns = collection->ns().ns(); // our copy
+
+        verify( Lock::isWriteLocked( ns ) );
+
+        std::vector<int> idxNos;
+        for ( size_t i = 0; i < indexes.size(); ++i ) {
+            IndexDetails& idx = *indexes[i];
+            BSONObj idxInfo = idx.info.obj();
+            verify( inDBRepair || !idxInfo["background"].trueValue() );
+            verify( !idx.dropDups() );
+
+            MONGO_TLOG(0) << "build index on: " << ns
+                          << " properties: " << idxInfo.jsonString() << endl;
+
+            audit::logCreateIndex( currentClient.get(), &idxInfo, idx.indexName(), ns );
+
+            int idxNo = collection->details()->findIndexByName( idx.indexName(), true );
+            verify( idxNo >= 0 );
+            idxNos.push_back( idxNo );
+        }
+
+        Timer t;
+        unsigned long long n = BtreeBasedBuilder::fastBuildIndexes( ns.c_str(),
+                                                                    collection->details(),
+                                                                    idxNos,
+                                                                    mayInterrupt );
+        for ( size_t i = 0; i < indexes.size(); ++i ) {
+            verify( !indexes[i]->head.isNull() );
+        }
+        MONGO_TLOG(0) << "build " << indexes.size() << " indexes done.  scanned " << n
+                      << " total records. " << t.millis() / 1000.0 << " secs" << endl;
+    }
+
 }  // namespace mongo
 
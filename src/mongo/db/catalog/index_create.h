@@ -31,6 +31,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "mongo/db/storage/index_details.h"
 
@@ -44,4 +45,10 @@ namespace mongo {
                        IndexDetails& idx,
                        bool mayInterrupt );
 
+    // Build several indexes in the foreground from one scan of the collection.  None may be
+    // background or dropDups builds.
+    void buildIndexes( Collection* collection,
+                       const std::vector<IndexDetails*>& indexes,
+                       bool mayInterrupt );
+
 } // namespace mongo
@@ -106,6 +106,8 @@ namespace mongo {
         static void check(StringData tname) {
             static int max;
             StackChecker *sc = checker.get();
+            if ( ! sc ) // a client that moved between threads, see ConnectionThreadState
+                return;
             const char *p = sc->buf;
 
             int lastStackByteModifed = 0;
@@ -300,7 +302,8 @@ namespace mongo {
             else if( !Lock::nested() ) { 
                 lk.reset(0);
                 {
-                    Lock::GlobalWrite w;
+                    // only this database's lock: opening it mustn't stall all the others
+                    Lock::DBWrite w(ns);
                     Context c(ns, path);
                 }
                 // db could be closed at this interim point -- that is ok, we will throw, and don't mind throwing.
@@ -474,22 +477,22 @@ namespace mongo {
     } handshakeCmd;
 
     int Client::recommendedYieldMicros( int * writers , int * readers, bool needExact ) {
-        int num = 0;
         int w = 0;
         int r = 0;
-        {
+        if ( !needExact ) {
+            // what the walk below would find, kept in counters by the lock code
+            LockState::queuedRequests( &w , &r );
+        }
+        else {
             scoped_lock bl(clientsMutex);
             for ( set<Client*>::iterator i=clients.begin(); i!=clients.end(); ++i ) {
                 Client* c = *i;
                 if ( c->lockState().hasLockPending() ) {
-                    num++;
                     if ( c->lockState().hasAnyWriteLock() )
                         w++;
                     else
                         r++;
                 }
-                if (num > 100 && !needExact)
-                    break;
             }
         }
 
@@ -575,6 +578,8 @@ namespace mongo {
         fastmodinsert = false;
         upsert = false;
         keyUpdates = 0;  // unsigned, so -1 not possible
+        flowControlMicros = -1;
+        execStats = BSONObj();
         
         exceptionInfo.reset();
         
@@ -623,6 +628,7 @@ namespace mongo {
         OPDEBUG_TOSTRING_HELP_BOOL( fastmodinsert );
         OPDEBUG_TOSTRING_HELP_BOOL( upsert );
         OPDEBUG_TOSTRING_HELP( keyUpdates );
+        OPDEBUG_TOSTRING_HELP( flowControlMicros );
         
         if ( extra.len() )
             s << " " << extra.str();
@@ -716,9 +722,14 @@ namespace mongo {
         OPDEBUG_APPEND_BOOL( fastmodinsert );
         OPDEBUG_APPEND_BOOL( upsert );
         OPDEBUG_APPEND_NUMBER( keyUpdates );
+        OPDEBUG_APPEND_NUMBER( flowControlMicros );
+
+        if ( ! execStats.isEmpty() )
+            b.append( "execStats" , execStats );
 
         b.appendNumber( "numYield" , curop.numYields() );
         b.append( "lockStats" , curop.lockStat().report() );
+        curop.appendLockAcquisitions( b );
 
         if ( ! exceptionInfo.empty() )
             exceptionInfo.append( b , "exception" , "exceptionCode" );
@@ -46,18 +46,22 @@
 #include "mongo/db/introspect.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/kill_current_op.h"
+#include "mongo/db/lockstate.h"
 #include "mongo/db/pagefault.h"
 #include "mongo/db/parsed_query.h"
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/repl/write_concern.h"
 #include "mongo/db/scanandorder.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/platform/random.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/timer.h"
 
 namespace mongo {
 
-    ClientCursor::CCById ClientCursor::clientCursorsById;
+    ClientCursor::CursorShard* ClientCursor::cursorShards(
+        new ClientCursor::CursorShard[ClientCursor::NumCursorShards] );
+    ClientCursor::CCByNs ClientCursor::cursorsByNs;
     boost::recursive_mutex& ClientCursor::ccmutex( *(new boost::recursive_mutex()) );
     long long ClientCursor::numberTimedOut = 0;
     set<Runner*> ClientCursor::nonCachedRunners;
@@ -69,7 +73,7 @@ namespace mongo {
 
     ClientCursor::ClientCursor(int qopts, const shared_ptr<Cursor>& c, const StringData& ns,
                                BSONObj query)
-        : _ns(ns.toString()), _query(query), _runner(NULL), _c(c), _yieldSometimesTracker(128, 10) {
+        : _ns(ns.toString()), _query(query), _runner(NULL), _c(c) {
 
         _queryOptions = qopts;
         _doingDeletes = false;
@@ -77,7 +81,7 @@ namespace mongo {
     }
 
     ClientCursor::ClientCursor(Runner* runner, int qopts, const BSONObj query)
-        : _yieldSometimesTracker(128, 10) {
+        {
 
         _runner.reset(runner);
         _ns = runner->ns();
@@ -106,7 +110,12 @@ namespace mongo {
 
         recursive_scoped_lock lock(ccmutex);
         _cursorid = allocCursorId_inlock();
-        clientCursorsById.insert( make_pair(_cursorid, this) );
+        {
+            CursorShard& shard = shardFor(_cursorid);
+            recursive_scoped_lock shardLock(shard.mutex);
+            shard.byId.insert( make_pair(_cursorid, this) );
+        }
+        cursorsByNs[_ns].insert(this);
     }
 
     ClientCursor::~ClientCursor() {
@@ -123,7 +132,18 @@ namespace mongo {
                 setLastLoc_inlock( DiskLoc() );
             }
 
-            clientCursorsById.erase(_cursorid);
+            {
+                CursorShard& shard = shardFor(_cursorid);
+                recursive_scoped_lock shardLock(shard.mutex);
+                shard.byId.erase(_cursorid);
+            }
+
+            CCByNs::iterator byNs = cursorsByNs.find(_ns);
+            if (byNs != cursorsByNs.end()) {
+                byNs->second.erase(this);
+                if (byNs->second.empty())
+                    cursorsByNs.erase(byNs);
+            }
 
             // defensive:
             _cursorid = INVALID_CURSOR_ID;
@@ -135,15 +155,29 @@ namespace mongo {
     // static
     void ClientCursor::assertNoCursors() {
         recursive_scoped_lock lock(ccmutex);
-        if (clientCursorsById.size() > 0) {
-            log() << "ERROR clientcursors exist but should not at this point" << endl;
-            ClientCursor *cc = clientCursorsById.begin()->second;
-            log() << "first one: " << cc->_cursorid << ' ' << cc->_ns << endl;
-            clientCursorsById.clear();
-            verify(false);
+        for (int i = 0; i < NumCursorShards; i++) {
+            CursorShard& shard = cursorShards[i];
+            recursive_scoped_lock shardLock(shard.mutex);
+            if (shard.byId.size() > 0) {
+                log() << "ERROR clientcursors exist but should not at this point" << endl;
+                ClientCursor *cc = shard.byId.begin()->second;
+                log() << "first one: " << cc->_cursorid << ' ' << cc->_ns << endl;
+                shard.byId.clear();
+                verify(false);
+            }
         }
     }
 
+    unsigned ClientCursor::numCursors() {
+        unsigned n = 0;
+        for (int i = 0; i < NumCursorShards; i++) {
+            CursorShard& shard = cursorShards[i];
+            recursive_scoped_lock shardLock(shard.mutex);
+            n += shard.byId.size();
+        }
+        return n;
+    }
+
     void ClientCursor::invalidate(const StringData& ns) {
         Lock::assertWriteLocked(ns);
 
@@ -171,15 +205,31 @@ namespace mongo {
             }
         }
 
-        CCById::const_iterator it = clientCursorsById.begin();
-        while (it != clientCursorsById.end()) {
-            ClientCursor* cc = it->second;
+        // Only the cursors over 'ns', or over the db's collections when dropping a db, are
+        // affected.  Collect their ids first, as deleting a cursor changes cursorsByNs.
+        vector<CursorId> candidates;
+        const string nsString = ns.toString();
+        for (CCByNs::const_iterator i = cursorsByNs.lower_bound(nsString);
+             i != cursorsByNs.end(); ++i) {
+            if (isDB ? !StringData(i->first).startsWith(ns) : i->first != nsString)
+                break;
+            for (set<ClientCursor*>::const_iterator j = i->second.begin();
+                 j != i->second.end(); ++j) {
+                candidates.push_back((*j)->_cursorid);
+            }
+        }
+
+        for (vector<CursorId>::const_iterator it = candidates.begin(); it != candidates.end();
+             ++it) {
+            // The pin value is only stable under the cursor's shard mutex.
+            recursive_scoped_lock shardLock(shardFor(*it).mutex);
+            ClientCursor* cc = find_inlock(*it, false);
+            if (NULL == cc)
+                continue;
 
             // We're only interested in cursors over one db.
-            if (cc->_db != db) {
-                ++it;
+            if (cc->_db != db)
                 continue;
-            }
 
             bool shouldDelete = false;
 
@@ -220,16 +270,7 @@ namespace mongo {
             // End cursor-only DEPRECATED
 
             if (shouldDelete) {
-                ClientCursor* toDelete = it->second;
-                CursorId id = toDelete->cursorid();
-                delete toDelete;
-                // We're not following the usual paradigm of saving it, ++it, and deleting the saved
-                // 'it' because deleting 'it' might invalidate the next thing in clientCursorsById.
-                // TODO: Why?
-                it = clientCursorsById.upper_bound(id);
-            }
-            else {
-                ++it;
+                delete cc;
             }
         }
     }
@@ -259,21 +300,23 @@ namespace mongo {
             }
         }
 
-        // TODO: This requires optimization.  We walk through *all* CCs and send the delete to every
-        // CC open on the db we're deleting from.  We could:
-        // 1. Map from ns to open runners,
-        // 2. Map from ns -> (a map of DiskLoc -> runners who care about that DL)
+        // Only the runners over this ns can hold the DiskLoc.  With collection level locking,
+        // runners over the db's other collections may be in use by their writers, so we must not
+        // touch them anyway.
         //
-        // We could also queue invalidations somehow and have them processed later in the runner's
-        // read locks.
-        for (CCById::const_iterator it = clientCursorsById.begin(); it != clientCursorsById.end();
-             ++it) {
-
-            ClientCursor* cc = it->second;
-            // We're only interested in cursors over one db.
-            if (cc->_db != db) { continue; }
-            if (NULL == cc->_runner.get()) { continue; }
-            cc->_runner->invalidate(dl);
+        // TODO: Map DiskLoc -> runners who care about that DL, or queue invalidations and have
+        // them processed later in the runner's read locks.
+        CCByNs::const_iterator byNs = cursorsByNs.find(ns.toString());
+        if (byNs != cursorsByNs.end()) {
+            for (set<ClientCursor*>::const_iterator it = byNs->second.begin();
+                 it != byNs->second.end(); ++it) {
+
+                ClientCursor* cc = *it;
+                // We're only interested in cursors over one db.
+                if (cc->_db != db) { continue; }
+                if (NULL == cc->_runner.get()) { continue; }
+                cc->_runner->invalidate(dl);
+            }
         }
 
         // Begin cursor-only
@@ -449,22 +492,23 @@ namespace mongo {
         // two passes so that we don't need to readlock unless we really do some timeouts
         // we assume here that incrementing _idleAgeMillis outside readlock is ok.
         {
-            recursive_scoped_lock lock(ccmutex);
-            {
-                unsigned sz = clientCursorsById.size();
-                static time_t last;
-                if( sz >= 100000 ) { 
-                    if( time(0) - last > 300 ) {
-                        last = time(0);
-                        log() << "warning number of open cursors is very large: " << sz << endl;
+            unsigned sz = 0;
+            for (int s = 0; s < NumCursorShards; s++) {
+                CursorShard& shard = cursorShards[s];
+                recursive_scoped_lock shardLock(shard.mutex);
+                sz += shard.byId.size();
+                for ( CCById::iterator i = shard.byId.begin(); i != shard.byId.end(); ++i ) {
+                    if( i->second->shouldTimeout( millis ) ) {
+                        foundSomeToTimeout = true;
                     }
                 }
             }
-            for ( CCById::iterator i = clientCursorsById.begin(); i != clientCursorsById.end();  ) {
-                CCById::iterator j = i;
-                i++;
-                if( j->second->shouldTimeout( millis ) ) {
-                    foundSomeToTimeout = true;
+
+            static time_t last;
+            if( sz >= 100000 ) { 
+                if( time(0) - last > 300 ) {
+                    last = time(0);
+                    log() << "warning number of open cursors is very large: " << sz << endl;
                 }
             }
         }
@@ -473,21 +517,22 @@ namespace mongo {
             Lock::GlobalRead lk;
 
             recursive_scoped_lock cclock(ccmutex);
-            CCById::const_iterator it = clientCursorsById.begin();
-            while (it != clientCursorsById.end()) {
-                ClientCursor* cc = it->second;
-                if( cc->shouldTimeout(0) ) {
+            for (int s = 0; s < NumCursorShards; s++) {
+                CursorShard& shard = cursorShards[s];
+                recursive_scoped_lock shardLock(shard.mutex);
+                vector<ClientCursor*> toDelete;
+                for ( CCById::iterator i = shard.byId.begin(); i != shard.byId.end(); ++i ) {
+                    if( i->second->shouldTimeout(0) )
+                        toDelete.push_back( i->second );
+                }
+                for ( vector<ClientCursor*>::iterator i = toDelete.begin(); i != toDelete.end();
+                      ++i ) {
+                    ClientCursor* cc = *i;
                     numberTimedOut++;
                     LOG(1) << "killing old cursor " << cc->_cursorid << ' ' << cc->_ns
                            << " idle:" << cc->idleTime() << "ms\n";
-                    ClientCursor* toDelete = it->second;
-                    CursorId id = toDelete->cursorid();
                     // This is what winds up removing it from the map.
-                    delete toDelete;
-                    it = clientCursorsById.upper_bound(id);
-                }
-                else {
-                    ++it;
+                    delete cc;
                 }
             }
         }
@@ -514,19 +559,24 @@ namespace mongo {
     }
 
     void ClientCursor::appendStats( BSONObjBuilder& result ) {
-        recursive_scoped_lock lock(ccmutex);
-        result.appendNumber("totalOpen", clientCursorsById.size() );
-        result.appendNumber("clientCursors_size", (int) numCursors());
-        result.appendNumber("timedOut" , numberTimedOut);
+        size_t open = 0;
         unsigned pinned = 0;
         unsigned notimeout = 0;
-        for ( CCById::iterator i = clientCursorsById.begin(); i != clientCursorsById.end(); i++ ) {
-            unsigned p = i->second->_pinValue;
-            if( p >= 100 )
-                pinned++;
-            else if( p > 0 )
-                notimeout++;
+        for (int s = 0; s < NumCursorShards; s++) {
+            CursorShard& shard = cursorShards[s];
+            recursive_scoped_lock shardLock(shard.mutex);
+            open += shard.byId.size();
+            for ( CCById::iterator i = shard.byId.begin(); i != shard.byId.end(); i++ ) {
+                unsigned p = i->second->_pinValue;
+                if( p >= 100 )
+                    pinned++;
+                else if( p > 0 )
+                    notimeout++;
+            }
         }
+        result.appendNumber("totalOpen", open );
+        result.appendNumber("clientCursors_size", (int) open);
+        result.appendNumber("timedOut" , numberTimedOut);
         if( pinned ) 
             result.append("pinned", pinned);
         if( notimeout )
@@ -561,7 +611,11 @@ namespace mongo {
 
             if ( x < 0 ) { x *= -1; }
 
-            if ( ts != cursorGenTSLast || ClientCursor::find_inlock(x, false) == 0 )
+            if ( ts != cursorGenTSLast )
+                break;
+
+            recursive_scoped_lock shardLock(shardFor(x).mutex);
+            if ( ClientCursor::find_inlock(x, false) == 0 )
                 break;
         }
 
@@ -571,8 +625,9 @@ namespace mongo {
 
     // static
     ClientCursor* ClientCursor::find_inlock(CursorId id, bool warn) {
-        CCById::iterator it = clientCursorsById.find(id);
-        if ( it == clientCursorsById.end() ) {
+        CCById& byId = shardFor(id).byId;
+        CCById::iterator it = byId.find(id);
+        if ( it == byId.end() ) {
             if ( warn ) {
                 OCCASIONALLY out() << "ClientCursor::find(): cursor not found in map '" << id
                     << "' (ok after a drop)" << endl;
@@ -585,15 +640,18 @@ namespace mongo {
     void ClientCursor::find( const string& ns , set<CursorId>& all ) {
         recursive_scoped_lock lock(ccmutex);
 
-        for ( CCById::iterator i=clientCursorsById.begin(); i!=clientCursorsById.end(); ++i ) {
-            if ( i->second->_ns == ns )
-                all.insert( i->first );
+        CCByNs::const_iterator byNs = cursorsByNs.find(ns);
+        if ( byNs == cursorsByNs.end() )
+            return;
+        for ( set<ClientCursor*>::const_iterator i = byNs->second.begin();
+              i != byNs->second.end(); ++i ) {
+            all.insert( (*i)->_cursorid );
         }
     }
 
     // static
     ClientCursor* ClientCursor::find(CursorId id, bool warn) {
-        recursive_scoped_lock lock(ccmutex);
+        recursive_scoped_lock lock(shardFor(id).mutex);
         ClientCursor *c = find_inlock(id, warn);
         // if this asserts, your code was not thread safe - you either need to set no timeout
         // for the cursor or keep a ClientCursor::Pointer in scope for it.
@@ -612,6 +670,7 @@ namespace mongo {
 
     bool ClientCursor::erase(CursorId id) {
         recursive_scoped_lock lock(ccmutex);
+        recursive_scoped_lock shardLock(shardFor(id).mutex);
         ClientCursor* cursor = find_inlock(id);
         if (!cursor) { return false; }
         _erase_inlock(cursor);
@@ -633,7 +692,7 @@ namespace mongo {
     bool ClientCursor::eraseIfAuthorized(CursorId id) {
         NamespaceString ns;
         {
-            recursive_scoped_lock lock(ccmutex);
+            recursive_scoped_lock lock(shardFor(id).mutex);
             ClientCursor* cursor = find_inlock(id);
             if (!cursor) {
                 audit::logKillCursorsAuthzCheck(
@@ -662,6 +721,7 @@ namespace mongo {
         // of 2 invariants: that the cursor ID won't be re-used in a short period of time, and that
         // the namespace associated with a cursor cannot change.
         recursive_scoped_lock lock(ccmutex);
+        recursive_scoped_lock shardLock(shardFor(id).mutex);
         ClientCursor* cursor = find_inlock(id);
         if (!cursor) {
             // Cursor was deleted in another thread since we found it earlier in this function.
@@ -822,6 +882,45 @@ namespace mongo {
         return true;
     }
 
+    MONGO_EXPORT_SERVER_PARAMETER(yieldMaxIntervalMillis, int, 10);
+    MONGO_EXPORT_SERVER_PARAMETER(yieldTargetLockWaitMicros, int, 2000);
+
+    YieldTracker::YieldTracker() : _pings(0), _last( Listener::getElapsedTimeMillis() ) { }
+
+    int YieldTracker::currentIntervalMillis() {
+        int maxMillis = std::max( 1, static_cast<int>(yieldMaxIntervalMillis) );
+        long long wait = LockState::recentAcquireMicros();
+        if ( wait <= yieldTargetLockWaitMicros )
+            return maxMillis;
+        return static_cast<int>( std::max( 1LL, maxMillis * yieldTargetLockWaitMicros / wait ) );
+    }
+
+    bool YieldTracker::intervalHasElapsed() {
+        ++_pings;
+
+        int writers;
+        int readers;
+        LockState::queuedRequests( &writers , &readers );
+        if ( writers + readers == 0 ) {
+            // nobody to yield to, but notice kills and time limits about as often as we used to
+            if ( _pings % 1024 != 0 )
+                return false;
+            _last = Listener::getElapsedTimeMillis();
+            return true;
+        }
+
+        long long now = Listener::getElapsedTimeMillis();
+        if ( now - _last >= currentIntervalMillis() ) {
+            _last = now;
+            return true;
+        }
+        return false;
+    }
+
+    void YieldTracker::resetLastTime() {
+        _last = Listener::getElapsedTimeMillis();
+    }
+
     int ClientCursor::suggestYieldMicros() {
         int writers = 0;
         int readers = 0;
@@ -845,7 +944,7 @@ namespace mongo {
     //
 
     ClientCursorPin::ClientCursorPin(long long cursorid) : _cursorid( INVALID_CURSOR_ID ) {
-        recursive_scoped_lock lock( ClientCursor::ccmutex );
+        recursive_scoped_lock lock( ClientCursor::shardFor( cursorid ).mutex );
         ClientCursor *cursor = ClientCursor::find_inlock( cursorid, true );
         if (NULL != cursor) {
             uassert( 12051, "clientcursor already in use? driver problem?",
@@ -961,8 +1060,8 @@ namespace mongo {
                     log() << " connections:" << Listener::globalTicketHolder.used();
                     if (theReplSet) {
                         log() << " replication threads:" << 
-                            ReplSetImpl::replWriterThreadCount + 
-                            ReplSetImpl::replPrefetcherThreadCount;
+                            theReplSet->replWriterThreadCount() +
+                            theReplSet->replPrefetcherThreadCount();
                     }
                     last = now;
                     mlast = m;
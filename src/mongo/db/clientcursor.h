@@ -52,6 +52,30 @@ namespace mongo {
     class ClientCursor;
     class ParsedQuery;
 
+    /**
+     * Decides when a long running operation should offer up its lock.  While some op is queued
+     * for a lock, that's once the lock has been held for the yield interval: yieldMaxIntervalMillis
+     * while queued ops wait no longer than yieldTargetLockWaitMicros on average to get their
+     * locks, and proportionally less (down to 1ms) the longer they've been waiting.  While
+     * nobody is queued the op only looks in occasionally, to notice it has been killed; the
+     * queue is kept in counters, so looking is cheap either way.
+     */
+    class YieldTracker {
+    public:
+        YieldTracker();
+
+        /** call every iteration. @return true if it's time to consider yielding */
+        bool intervalHasElapsed();
+        void resetLastTime();
+
+        /** the interval for the current queue, in millis */
+        static int currentIntervalMillis();
+
+    private:
+        uint64_t _pings;
+        long long _last;
+    };
+
     /**
      * ClientCursor is a wrapper that represents a cursorid from our database application's
      * perspective.
@@ -125,13 +149,13 @@ namespace mongo {
         // ClientCursor creation/deletion.
         //
 
-        static unsigned numCursors() { return clientCursorsById.size(); }
+        static unsigned numCursors();
         static void find( const string& ns , set<CursorId>& all );
         static ClientCursor* find(CursorId id, bool warn = true);
 
         // Same as erase but checks to make sure this thread has read permission on the cursor's
         // namespace.  This should be called when receiving killCursors from a client.  This should
-        // not be called when ccmutex is held.
+        // not be called when ccmutex or a cursor shard's mutex is held.
         static int eraseIfAuthorized(int n, long long* ids);
         static bool eraseIfAuthorized(CursorId id);
 
@@ -272,10 +296,24 @@ namespace mongo {
         friend struct ClientCursorYieldLock;
         friend class CmdCursorInfo;
 
-        // A map from the CursorId to the ClientCursor behind it.
-        // TODO: Consider making this per-connection.
+        // A map from the CursorId to the ClientCursor behind it, split into shards by the id's
+        // random low bits.  Each shard has its own mutex, so creating, finding and pinning
+        // cursors on different shards don't contend; a getMore only takes its cursor's shard.
         typedef map<CursorId, ClientCursor*> CCById;
-        static CCById clientCursorsById;
+        struct CursorShard {
+            boost::recursive_mutex mutex;
+            CCById byId;
+        };
+        enum { NumCursorShards = 16 };
+        static CursorShard* cursorShards;
+        static CursorShard& shardFor(CursorId id) {
+            return cursorShards[static_cast<unsigned long long>(id) % NumCursorShards];
+        }
+
+        // The cursors open on each namespace, so that drops and deletions only visit the cursors
+        // they can affect.
+        typedef map<string, set<ClientCursor*> > CCByNs;
+        static CCByNs cursorsByNs;
 
         // A list of NON-CACHED runners.  Any runner that yields must be put into this map before
         // yielding in order to be notified of invalidation and namespace deletion.  Before the
@@ -287,7 +325,9 @@ namespace mongo {
         // How many cursors have timed out?
         static long long numberTimedOut;
 
-        // This must be held when modifying any static member.
+        // This must be held when modifying cursorsByNs, nonCachedRunners or a database's
+        // ccByLoc, and when adding or deleting a cursor.  It is taken before any shard's mutex,
+        // never while holding one.
         static boost::recursive_mutex& ccmutex;
 
         /**
@@ -304,13 +344,14 @@ namespace mongo {
 
         /**
          * Find the ClientCursor with the provided ID.  Optionally warn if it's not found.
-         * Assumes ccmutex is held.
+         * Assumes the mutex of the id's shard is held.
          */
 
         static ClientCursor* find_inlock(CursorId id, bool warn = true);
 
         /**
          * Delete the ClientCursor with the provided ID.  masserts if the cursor is pinned.
+         * Assumes ccmutex and the mutex of the cursor's shard are held.
          */
         static void _erase_inlock(ClientCursor* cursor);
 
@@ -385,7 +426,7 @@ namespace mongo {
         bool _doingDeletes; // when true we are the delete and aboutToDelete shouldn't manipulate us
 
         // TODO: This will be moved into the runner.
-        ElapsedTracker _yieldSometimesTracker;
+        YieldTracker _yieldSometimesTracker;
     };
 
     /**
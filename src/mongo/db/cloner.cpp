@@ -220,6 +220,38 @@ namespace mongo {
                          query, 0, options);
         }
 
+        if ( storedForLater.size() && !logForRepl ) {
+            // With no oplog entry to write per index, each collection's indexes are built
+            // together from one scan of it.
+            map<string, vector<BSONObj> > byCollection;
+            list<BSONObj> remaining;
+            for (list<BSONObj>::const_iterator i = storedForLater.begin();
+                 i != storedForLater.end();
+                 ++i) {
+                string ns = i->getStringField("ns");
+                if ( cc().database()->getCollection( ns ) )
+                    byCollection[ns].push_back( *i );
+                else
+                    remaining.push_back( *i );
+            }
+            for (map<string, vector<BSONObj> >::const_iterator i = byCollection.begin();
+                 i != byCollection.end();
+                 ++i) {
+                mayInterrupt( mayBeInterrupted );
+                Collection* collection = cc().database()->getCollection( i->first );
+                verify( collection );
+                Status status = collection->getIndexCatalog()->createIndexes( i->second,
+                                                                              mayBeInterrupted );
+                if ( !status.isOK() ) {
+                    error() << "error: exception building indexes of " << i->first << " cloned from "
+                            << from_collection << ' ' << status.toString() << endl;
+                    uassertStatusOK( status );
+                }
+                getDur().commitIfNeeded();
+            }
+            storedForLater.swap( remaining );
+        }
+
         if ( storedForLater.size() ) {
             for (list<BSONObj>::const_iterator i = storedForLater.begin();
                  i != storedForLater.end();
@@ -311,6 +343,10 @@ namespace mongo {
 
     extern bool inDBRepair;
 
+    // Guards inDBRepair while the deferred _id index of a cloned collection is built, as initial
+    // sync may clone several databases at once.
+    static mongo::mutex idIndexMutex("Cloner id index");
+
     bool Cloner::go(const char *masterHost, string& errmsg, const string& fromdb, bool logForRepl, bool slaveOk, bool useReplAuth, bool snapshot, bool mayYield, bool mayBeInterrupted, int *errCode) {
 
         CloneOptions opts;
@@ -422,6 +458,12 @@ namespace mongo {
                     continue;
                 }
 
+                if ( !opts.collsToClone.empty() &&
+                     opts.collsToClone.find( string( from_name ) ) == opts.collsToClone.end() ) {
+                    LOG(2) << "\t\t not cloning because not asked for" << endl;
+                    continue;
+                }
+
                 if( opts.collsToIgnore.find( string( from_name ) ) != opts.collsToIgnore.end() ){
                     LOG(2) << "\t\t ignoring collection " << from_name << endl;
                     continue;
@@ -467,6 +509,7 @@ namespace mongo {
                 /* we need dropDups to be true as we didn't do a true snapshot and this is before applying oplog operations
                    that occur during the initial sync.  inDBRepair makes dropDups be true.
                    */
+                scoped_lock lk( idIndexMutex );
                 bool old = inDBRepair;
                 try {
                     inDBRepair = true;
@@ -124,6 +124,7 @@ namespace mongo {
             
         string fromDB;
         set<string> collsToIgnore;
+        set<string> collsToClone; // if not empty, only these are cloned
 
         bool logForRepl;
         bool slaveOk;
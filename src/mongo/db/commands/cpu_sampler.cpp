@@ -0,0 +1,386 @@
+// @file cpu_sampler.cpp
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+/**
+ * This module provides an always-available sampling cpu profiler built on the Google perftools
+ * SIGPROF handler.  While it runs, each profiling tick records the stack of the interrupted
+ * thread, and the type and namespace of the operation that thread was running, into a ring buffer
+ * holding the most recent samples.  Nothing is written to disk.
+ *
+ * The following commands start and stop sampling:
+ *     { _cpuSamplerStart: 1 }
+ *     { _cpuSamplerStop: 1 }
+ *
+ * The following command returns the samples of the last "seconds" seconds (default 60)
+ * aggregated by operation type and namespace, and the "limit" most frequent stacks (default 20):
+ *     { _cpuSamples: 1, seconds: 60, limit: 20 }
+ *
+ * Sampling can also start with the server, with --setParameter cpuSamplerOnStartup=true.
+ *
+ * Like the commands in cpuprofile.cpp, these are only available when enabled at build-time with
+ * the "--use-cpu-profiler" argument to scons.  They are mongod only, since mongos has no CurOp.
+ */
+
+#include "mongo/pch.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <signal.h>
+#include <string>
+#include <vector>
+
+#include "third_party/gperftools-2.0/src/gperftools/stacktrace.h"
+
+#include "mongo/base/init.h"
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/curop.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/backtrace.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/net/listen.h"
+#include "mongo/util/net/message.h"
+
+// From third_party/gperftools-2.0/src/profile-handler.h, which can't be included from here since
+// it needs the gperftools build configuration.
+extern "C" {
+    struct ProfileHandlerToken;
+    typedef void (*ProfileHandlerCallback)(int sig, siginfo_t* sig_info,
+                                           void* ucontext, void* callback_arg);
+    ProfileHandlerToken* ProfileHandlerRegisterCallback(ProfileHandlerCallback callback,
+                                                        void* callback_arg);
+    void ProfileHandlerUnregisterCallback(ProfileHandlerToken* token);
+}
+
+namespace mongo {
+
+    // start the cpu sampler when the server starts
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(cpuSamplerOnStartup, bool, false);
+
+    namespace {
+
+        const int kMaxDepth = 32;
+
+        // About eighty seconds at the default profiling frequency of 100 per second.
+        const int kNumSamples = 8192;
+
+        /**
+         * One stack, written by the signal handler.  'version' is odd while the sample is being
+         * written, so a reader that sees the same even version before and after copying it has a
+         * consistent copy.
+         */
+        struct Sample {
+            AtomicUInt32 version;
+            long long elapsedMillis;
+            int op;
+            int depth;
+            char ns[96];
+            void* stack[kMaxDepth];
+        };
+
+        /** A sample copied out of the ring buffer. */
+        struct SampleCopy {
+            int op;
+            std::string ns;
+            std::vector<void*> stack;
+        };
+
+        class CpuSampler {
+        public:
+            CpuSampler() : _lock("CpuSampler"), _token(NULL) { }
+
+            /** Returns false if the sampler was already running. */
+            bool start();
+
+            /** Returns false if the sampler was not running. */
+            bool stop();
+
+            bool running() const;
+
+            /** Copies out the samples taken at 'sinceElapsedMillis' or later. */
+            void collect(long long sinceElapsedMillis, std::vector<SampleCopy>* out) const;
+
+            static CpuSampler global;
+
+        private:
+            static void onTick(int sig, siginfo_t* info, void* ucontext, void* arg);
+
+            /** Called in the signal handler, so must be async-signal-safe. */
+            void record(void* ucontext);
+
+            // Serializes start and stop.  The profile handler runs at most one callback at a
+            // time, so record() itself needs no lock.
+            mutable SimpleMutex _lock;
+            ProfileHandlerToken* _token;
+
+            // The number of samples ever recorded.  Only record() stores it.
+            AtomicUInt64 _next;
+            Sample _samples[kNumSamples];
+        };
+
+        CpuSampler CpuSampler::global;
+
+        bool CpuSampler::start() {
+            SimpleMutex::scoped_lock lk(_lock);
+            if (_token) {
+                return false;
+            }
+            _token = ProfileHandlerRegisterCallback(&CpuSampler::onTick, this);
+            return true;
+        }
+
+        bool CpuSampler::stop() {
+            SimpleMutex::scoped_lock lk(_lock);
+            if (!_token) {
+                return false;
+            }
+            // Waits for a running callback to return.
+            ProfileHandlerUnregisterCallback(_token);
+            _token = NULL;
+            return true;
+        }
+
+        bool CpuSampler::running() const {
+            SimpleMutex::scoped_lock lk(_lock);
+            return _token != NULL;
+        }
+
+        // static
+        void CpuSampler::onTick(int sig, siginfo_t* info, void* ucontext, void* arg) {
+            static_cast<CpuSampler*>(arg)->record(ucontext);
+        }
+
+        void CpuSampler::record(void* ucontext) {
+            unsigned long long n = _next.load();
+            Sample& sample = _samples[n % kNumSamples];
+
+            sample.version.fetchAndAdd(1);
+            sample.elapsedMillis = Listener::getElapsedTimeMillis();
+            // skip onTick and record
+            sample.depth = GetStackTraceWithContext(sample.stack, kMaxDepth, 2, ucontext);
+
+            // The tick interrupted this thread, so its CurOp can't change under us.
+            Client* client = currentClient.get();
+            CurOp* curOp = client ? client->curop() : NULL;
+            if (curOp && curOp->active()) {
+                sample.op = curOp->getOp();
+                strncpy(sample.ns, curOp->getNS(), sizeof(sample.ns) - 1);
+                sample.ns[sizeof(sample.ns) - 1] = '\0';
+            }
+            else {
+                sample.op = 0;
+                sample.ns[0] = '\0';
+            }
+            sample.version.fetchAndAdd(1);
+
+            _next.store(n + 1);
+        }
+
+        void CpuSampler::collect(long long sinceElapsedMillis,
+                                 std::vector<SampleCopy>* out) const {
+            for (int i = 0; i < kNumSamples; ++i) {
+                const Sample& sample = _samples[i];
+                unsigned version = sample.version.load();
+                if (version == 0 || version % 2 == 1) {
+                    continue;
+                }
+
+                SampleCopy copy;
+                long long elapsedMillis = sample.elapsedMillis;
+                int depth = std::max(0, std::min(sample.depth, kMaxDepth));
+                copy.op = sample.op;
+                copy.ns.assign(sample.ns, strnlen(sample.ns, sizeof(sample.ns)));
+                copy.stack.assign(sample.stack, sample.stack + depth);
+
+                if (sample.version.load() != version || elapsedMillis < sinceElapsedMillis) {
+                    continue;
+                }
+                out->push_back(copy);
+            }
+        }
+
+        /**
+         * Common code for the implementation of cpu sampler commands.
+         */
+        class CpuSamplerCommand : public Command {
+        public:
+            CpuSamplerCommand( char const *name ) : Command( name ) {}
+            virtual bool slaveOk() const { return true; }
+            virtual bool adminOnly() const { return true; }
+            virtual bool localHostOnlyIfNoAuth( const BSONObj& cmdObj ) { return true; }
+            virtual LockType locktype() const { return NONE; }
+            virtual void addRequiredPrivileges(const std::string& dbname,
+                                               const BSONObj& cmdObj,
+                                               std::vector<Privilege>* out) {
+                ActionSet actions;
+                actions.addAction(ActionType::cpuProfiler);
+                out->push_back(Privilege(ResourcePattern::forClusterResource(), actions));
+            }
+        };
+
+        class CpuSamplerStartCommand : public CpuSamplerCommand {
+        public:
+            CpuSamplerStartCommand() : CpuSamplerCommand( "_cpuSamplerStart" ) {}
+            virtual void help( stringstream& help ) const {
+                help << "start recording cpu samples into memory";
+            }
+            virtual bool run( string const &db,
+                              BSONObj &cmdObj,
+                              int options,
+                              string &errmsg,
+                              BSONObjBuilder &result,
+                              bool fromRepl ) {
+                result.append( "wasRunning", !CpuSampler::global.start() );
+                return true;
+            }
+        } cpuSamplerStartCommandInstance;
+
+        class CpuSamplerStopCommand : public CpuSamplerCommand {
+        public:
+            CpuSamplerStopCommand() : CpuSamplerCommand( "_cpuSamplerStop" ) {}
+            virtual void help( stringstream& help ) const {
+                help << "stop recording cpu samples; those recorded are kept";
+            }
+            virtual bool run( string const &db,
+                              BSONObj &cmdObj,
+                              int options,
+                              string &errmsg,
+                              BSONObjBuilder &result,
+                              bool fromRepl ) {
+                result.append( "wasRunning", CpuSampler::global.stop() );
+                return true;
+            }
+        } cpuSamplerStopCommandInstance;
+
+        class CpuSamplesCommand : public CpuSamplerCommand {
+        public:
+            CpuSamplesCommand() : CpuSamplerCommand( "_cpuSamples" ) {}
+            virtual void help( stringstream& help ) const {
+                help << "recent cpu samples by operation and namespace, and the most frequent "
+                        "stacks\n{ _cpuSamples: 1, seconds: 60, limit: 20 }";
+            }
+            virtual bool run( string const &db,
+                              BSONObj &cmdObj,
+                              int options,
+                              string &errmsg,
+                              BSONObjBuilder &result,
+                              bool fromRepl );
+        } cpuSamplesCommandInstance;
+
+        typedef std::pair<int, std::string> OpAndNs;
+        typedef std::pair<OpAndNs, std::vector<void*> > StackKey;
+
+        template <typename Key>
+        bool byCountDescending(const std::pair<Key, int>& a, const std::pair<Key, int>& b) {
+            return a.second > b.second;
+        }
+
+        bool CpuSamplesCommand::run( string const &db,
+                                     BSONObj &cmdObj,
+                                     int options,
+                                     string &errmsg,
+                                     BSONObjBuilder &result,
+                                     bool fromRepl ) {
+            long long seconds = cmdObj["seconds"].isNumber() ? cmdObj["seconds"].numberLong() : 60;
+            int limit = cmdObj["limit"].isNumber() ? cmdObj["limit"].numberInt() : 20;
+            if ( seconds <= 0 || limit < 0 ) {
+                errmsg = "seconds must be positive and limit must not be negative";
+                return false;
+            }
+
+            std::vector<SampleCopy> samples;
+            CpuSampler::global.collect( Listener::getElapsedTimeMillis() - seconds * 1000,
+                                        &samples );
+
+            std::map<OpAndNs, int> byOp;
+            std::map<StackKey, int> byStack;
+            for ( size_t i = 0; i < samples.size(); ++i ) {
+                OpAndNs opAndNs( samples[i].op, samples[i].ns );
+                ++byOp[opAndNs];
+                ++byStack[StackKey( opAndNs, samples[i].stack )];
+            }
+
+            result.append( "running", CpuSampler::global.running() );
+            result.append( "samples", static_cast<int>( samples.size() ) );
+
+            std::vector<std::pair<OpAndNs, int> > ops( byOp.begin(), byOp.end() );
+            std::sort( ops.begin(), ops.end(), byCountDescending<OpAndNs> );
+            BSONArrayBuilder opsBuilder( result.subarrayStart( "byOperation" ) );
+            for ( size_t i = 0; i < ops.size(); ++i ) {
+                opsBuilder.append( BSON( "op" << opToString( ops[i].first.first ) <<
+                                         "ns" << ops[i].first.second <<
+                                         "count" << ops[i].second ) );
+            }
+            opsBuilder.done();
+
+            std::vector<std::pair<StackKey, int> > stacks( byStack.begin(), byStack.end() );
+            std::sort( stacks.begin(), stacks.end(), byCountDescending<StackKey> );
+            BSONArrayBuilder stacksBuilder( result.subarrayStart( "stacks" ) );
+            for ( size_t i = 0; i < stacks.size() && i < static_cast<size_t>( limit ); ++i ) {
+                const StackKey& key = stacks[i].first;
+                BSONObjBuilder stackBuilder( stacksBuilder.subobjStart() );
+                stackBuilder.append( "op", opToString( key.first.first ) );
+                stackBuilder.append( "ns", key.first.second );
+                stackBuilder.append( "count", stacks[i].second );
+
+                BSONArrayBuilder frames( stackBuilder.subarrayStart( "frames" ) );
+                if ( !key.second.empty() ) {
+                    char** symbols = backtrace_symbols( &key.second[0], key.second.size() );
+                    for ( size_t j = 0; j < key.second.size(); ++j ) {
+                        frames.append( symbols ? symbols[j] : "" );
+                    }
+                    free( symbols );
+                }
+                frames.done();
+                stackBuilder.done();
+            }
+            stacksBuilder.done();
+
+            return true;
+        }
+
+    }  // namespace
+
+    MONGO_INITIALIZER_WITH_PREREQUISITES(CpuSamplerOnStartup, ("EndStartupOptionHandling"))
+            (InitializerContext* context) {
+        if (cpuSamplerOnStartup) {
+            CpuSampler::global.start();
+        }
+        return Status::OK();
+    }
+
+}  // namespace mongo
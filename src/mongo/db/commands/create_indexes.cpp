@@ -0,0 +1,128 @@
+// create_indexes.cpp
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include <string>
+#include <vector>
+
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/database.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/structure/collection.h"
+
+namespace mongo {
+
+    void ensureIdIndexForNewNs( Collection* collection ); // pdfile.cpp
+
+    /**
+     * { createIndexes : <collection>, indexes : [ <spec>, ... ] }
+     *
+     * Like inserting each spec into system.indexes, except that the foreground builds share a
+     * single scan of the collection.
+     */
+    class CmdCreateIndexes : public Command {
+    public:
+        CmdCreateIndexes() : Command( "createIndexes" ) { }
+
+        virtual bool logTheOp() { return true; }
+        virtual bool slaveOk() const { return false; }
+        virtual LockType locktype() const { return WRITE; }
+        virtual void help( stringstream& help ) const {
+            help << "create several indexes on a collection, building them together\n"
+                    "{ createIndexes : <collection>, indexes : [ <index spec>, ... ] }";
+        }
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::createIndex);
+            out->push_back(Privilege(parseResourcePattern(dbname, cmdObj), actions));
+        }
+
+        bool run( const string& dbname, BSONObj& cmdObj, int, string& errmsg,
+                  BSONObjBuilder& result, bool fromRepl ) {
+            string ns = parseNs( dbname, cmdObj );
+            if ( !NamespaceString::normal( ns ) || ns.find( ".system." ) != string::npos ) {
+                errmsg = "bad namespace name";
+                return false;
+            }
+
+            BSONElement indexes = cmdObj["indexes"];
+            if ( indexes.type() != Array ) {
+                errmsg = "indexes must be an array of index specs";
+                return false;
+            }
+
+            std::vector<BSONObj> specs;
+            BSONForEach( e, indexes.Obj() ) {
+                if ( e.type() != Object ) {
+                    errmsg = "each index spec must be an object";
+                    return false;
+                }
+                BSONObj spec = e.Obj();
+                BSONElement specNs = spec["ns"];
+                if ( specNs.eoo() ) {
+                    BSONObjBuilder b;
+                    b.appendElements( spec );
+                    b.append( "ns", ns );
+                    spec = b.obj();
+                }
+                else if ( specNs.type() != String || specNs.String() != ns ) {
+                    errmsg = str::stream() << "index spec ns must be " << ns << ": " << spec;
+                    return false;
+                }
+                specs.push_back( spec.getOwned() );
+            }
+
+            Database* db = cc().database();
+            Collection* collection = db->getCollection( ns );
+            if ( !collection ) {
+                collection = db->createCollection( ns, false, NULL, true );
+                verify( collection );
+                ensureIdIndexForNewNs( collection );
+            }
+
+            int before = collection->getIndexCatalog()->numIndexesTotal();
+            Status status = collection->getIndexCatalog()->createIndexes( specs, !fromRepl );
+            if ( !status.isOK() ) {
+                appendCommandStatus( result, status );
+                return false;
+            }
+            result.append( "numIndexesBefore", before );
+            result.append( "numIndexesAfter", collection->getIndexCatalog()->numIndexesTotal() );
+            return true;
+        }
+    } cmdCreateIndexes;
+
+}  // namespace mongo
@@ -34,6 +34,8 @@
 #include "mongo/db/commands.h"
 #include "mongo/db/database.h"
 #include "mongo/db/query/internal_plans.h"
+#include "mongo/db/structure/collection.h"
+#include "mongo/util/hex.h"
 #include "mongo/util/md5.hpp"
 #include "mongo/util/timer.h"
 
@@ -140,6 +142,34 @@ namespace mongo {
         return hash;
     }
 
+    string DBHashCmd::contentHashCollection( const string& fullCollectionName, bool* fromCache ) {
+        Collection* collection = cc().database()->getCollection( fullCollectionName );
+        verify( collection );
+
+        // concurrent dbHash readers would otherwise compute and set it at once
+        scoped_lock lk( _cachedHashedMutex );
+
+        uint64_t hash = 0;
+        long long n = 0;
+        *fromCache = collection->getContentHash( &hash, &n );
+        if ( !*fromCache ) {
+            auto_ptr<Runner> runner( InternalPlanner::collectionScan( fullCollectionName ) );
+            Runner::RunnerState state;
+            BSONObj c;
+            while ( Runner::RUNNER_ADVANCED == ( state = runner->getNext( &c, NULL ) ) ) {
+                hash += Collection::documentHash( c );
+                n++;
+            }
+            if ( Runner::RUNNER_EOF != state ) {
+                warning() << "error while hashing, db dropped? ns=" << fullCollectionName << endl;
+                return "error";
+            }
+            collection->setContentHash( hash, n );
+        }
+
+        return str::stream() << n << ':' << toHexLower( &hash, sizeof(hash) );
+    }
+
     bool DBHashCmd::run(const string& dbname , BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool) {
         Timer timer;
 
@@ -156,6 +186,10 @@ namespace mongo {
             }
         }
 
+        // an order-independent hash of each collection, which writes keep current, rather
+        // than an md5 of a scan in _id order
+        const bool incremental = cmdObj["incremental"].trueValue();
+
         list<string> colls;
         Database* db = cc().database();
         if ( db )
@@ -183,7 +217,8 @@ namespace mongo {
                 continue;
 
             bool fromCache = false;
-            string hash = hashCollection( fullCollectionName, &fromCache );
+            string hash = incremental ? contentHashCollection( fullCollectionName, &fromCache ) :
+                                        hashCollection( fullCollectionName, &fromCache );
 
             bb.append( shortCollectionName, hash );
 
@@ -198,6 +233,8 @@ namespace mongo {
         string hash = digestToString( d );
 
         result.append( "md5" , hash );
+        if ( incremental )
+            result.append( "incremental" , true );
         result.appendNumber( "timeMillis", timer.millis() );
 
         result.append( "fromCache", cached );
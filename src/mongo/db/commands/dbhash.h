@@ -61,6 +61,12 @@ namespace mongo {
 
         string hashCollection( const string& fullCollectionName, bool* fromCache );
 
+        /**
+         * The collection's order-independent content hash, kept up to date by writes after
+         * the first call for it scans the collection.
+         */
+        string contentHashCollection( const string& fullCollectionName, bool* fromCache );
+
         map<string,string> _cachedHashed;
         mutex _cachedHashedMutex;
 
@@ -28,23 +28,32 @@
 *    it in the license file.
 */
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
 #include "mongo/db/auth/action_set.h"
 #include "mongo/db/auth/action_type.h"
 #include "mongo/db/auth/privilege.h"
+#include "mongo/db/catalog/index_catalog.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/commands.h"
+#include "mongo/db/exec/fetch.h"
+#include "mongo/db/exec/index_scan.h"
+#include "mongo/db/index/catalog_hack.h"
+#include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/kill_current_op.h"
+#include "mongo/db/query/index_bounds_builder.h"
+#include "mongo/db/query/internal_runner.h"
 #include "mongo/db/query/new_find.h"
 #include "mongo/db/query/query_planner_common.h"
 #include "mongo/db/query/type_explain.h"
 #include "mongo/db/query_optimizer.h"  // XXX old sys
 #include "mongo/db/server_options.h"
 #include "mongo/db/server_parameters.h"
+#include "mongo/db/structure/collection.h"
 #include "mongo/util/timer.h"
 
 namespace mongo {
@@ -105,7 +114,60 @@ namespace mongo {
                 return true;
             }
 
-            if (newDistinct) {
+            IndexDescriptor* scanIndex = NULL;
+            if (newDistinct && query.isEmpty()) {
+                scanIndex = distinctScanIndex(cc().database()->getCollection(ns), key);
+            }
+
+            if (NULL != scanIndex) {
+                // One seek per distinct value rather than a walk over every key.  An internal
+                // runner registers itself for yields.
+                auto_ptr<Runner> runner(makeDistinctScan(ns, scanIndex, false));
+                runner->setYieldPolicy(Runner::YIELD_AUTO);
+
+                BSONObj obj;
+                while (Runner::RUNNER_ADVANCED == runner->getNext(&obj, NULL)) {
+                    ++nscanned;
+                    ++n;
+                    BSONElement elt = obj.firstElement();
+                    int currentBufPos = bb.len();
+
+                    uassert(17338, "distinct too big, 16mb cap",
+                            (currentBufPos + elt.size() + 1024) < bufSize);
+
+                    arr.append(elt);
+                    BSONElement x(start + currentBufPos);
+                    values.insert(x);
+                }
+
+                // Documents missing the field are indexed under null too, so null is only a value
+                // if some document really holds it.
+                runner.reset(makeDistinctScan(ns, scanIndex, true));
+                runner->setYieldPolicy(Runner::YIELD_AUTO);
+
+                while (Runner::RUNNER_ADVANCED == runner->getNext(&obj, NULL)) {
+                    ++nscanned;
+                    ++nscannedObjects;
+                    BSONElementSet elts;
+                    obj.getFieldsDotted(key, elts);
+                    if (elts.empty()) { continue; }
+
+                    ++n;
+                    BSONElement elt = *elts.begin();
+                    int currentBufPos = bb.len();
+
+                    uassert(17339, "distinct too big, 16mb cap",
+                            (currentBufPos + elt.size() + 1024) < bufSize);
+
+                    arr.append(elt);
+                    BSONElement x(start + currentBufPos);
+                    values.insert(x);
+                    break;
+                }
+
+                cursorName = "DistinctScan " + scanIndex->indexName();
+            }
+            else if (newDistinct) {
                 CanonicalQuery* cq;
                 // XXX: project out just the field we're distinct-ing.  May be covered.
                 if (!CanonicalQuery::canonicalize(ns, query, &cq).isOK()) {
@@ -263,6 +325,85 @@ namespace mongo {
             return true;
         }
     private:
+        /**
+         * Returns an index holding the value of 'key' for every document as its first key field,
+         * which a skip scan can take the distinct values from, or NULL if there is none.
+         */
+        IndexDescriptor* distinctScanIndex(Collection* collection, const string& key) {
+            if (NULL == collection) { return NULL; }
+
+            IndexCatalog* catalog = collection->getIndexCatalog();
+            for (int i = 0; i < catalog->numIndexesReady(); ++i) {
+                IndexDescriptor* desc = catalog->getDescriptor(i);
+                // Arrays give several keys per document, and sparse or partial indexes are
+                // missing documents.
+                if (desc->isMultikey() || desc->isSparse() || desc->isPartial()) {
+                    continue;
+                }
+                if (!CatalogHack::getAccessMethodName(desc->keyPattern()).empty()) {
+                    continue;
+                }
+                if (key == desc->keyPattern().firstElementFieldName()) {
+                    return desc;
+                }
+            }
+            return NULL;
+        }
+
+        /**
+         * Returns a runner skip scanning 'desc' for the distinct non null values of its first
+         * field, or if 'nullsOnly' every document (fetched) whose first field is indexed as null.
+         * Caller owns the returned pointer.
+         */
+        Runner* makeDistinctScan(const string& ns, IndexDescriptor* desc, bool nullsOnly) {
+            IndexScanParams params;
+            params.descriptor = desc;
+            params.direction = 1;
+            params.doNotDedup = true;
+            params.forceBtreeAccessMethod = true;
+            params.bounds.isSimpleRange = false;
+            if (!nullsOnly) {
+                params.skipPrefixLen = 1;
+            }
+
+            BSONObjIterator it(desc->keyPattern());
+            bool first = true;
+            while (it.more()) {
+                BSONElement elt = it.next();
+                OrderedIntervalList oil(elt.fieldName());
+                if (!first) {
+                    oil.intervals.push_back(IndexBoundsBuilder::allValues());
+                }
+                else if (nullsOnly) {
+                    oil.intervals.push_back(
+                        IndexBoundsBuilder::makePointInterval(BSON("" << BSONNULL)));
+                }
+                else {
+                    oil.intervals.push_back(IndexBoundsBuilder::makeRangeInterval(
+                        BSON("" << MINKEY << "" << BSONNULL), true, false));
+                    oil.intervals.push_back(IndexBoundsBuilder::makeRangeInterval(
+                        BSON("" << BSONNULL << "" << MAXKEY), false, true));
+                }
+                first = false;
+
+                // The bounds must run the way the index does.
+                if (elt.numberInt() < 0) {
+                    std::reverse(oil.intervals.begin(), oil.intervals.end());
+                    for (size_t i = 0; i < oil.intervals.size(); ++i) {
+                        IndexBoundsBuilder::reverseInterval(&oil.intervals[i]);
+                    }
+                }
+                params.bounds.fields.push_back(oil);
+            }
+
+            WorkingSet* ws = new WorkingSet();
+            PlanStage* root = new IndexScan(params, ws, NULL);
+            if (nullsOnly) {
+                root = new FetchStage(ws, root, NULL);
+            }
+            return new InternalRunner(ns, root, ws);
+        }
+
         /**
          * Tries to get the fields from the key first, then the object if the keys don't have it.
          */
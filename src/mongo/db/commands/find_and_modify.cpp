@@ -134,135 +134,59 @@ namespace mongo {
             Lock::DBWrite lk( ns );
             Client::Context cx( ns );
 
-            BSONObj doc;
-            bool found = Helpers::findOne( ns.c_str() , queryOriginal , doc );
-
-            BSONObj queryModified = queryOriginal;
-            if ( found && doc["_id"].type() && ! isSimpleIdQuery( queryOriginal ) ) {
-                // we're going to re-write the query to be more efficient
-                // we have to be a little careful because of positional operators
-                // maybe we can pass this all through eventually, but right now isn't an easy way
-                
-                bool hasPositionalUpdate = false;
-                {
-                    // if the update has a positional piece ($)
-                    // then we need to pull all query parts in
-                    // so here we check for $
-                    // a little hacky
-                    BSONObjIterator i( update );
-                    while ( i.more() ) {
-                        const BSONElement& elem = i.next();
-                        
-                        if ( elem.fieldName()[0] != '$' || elem.type() != Object )
-                            continue;
-
-                        BSONObjIterator j( elem.Obj() );
-                        while ( j.more() ) {
-                            if ( str::contains( j.next().fieldName(), ".$" ) ) {
-                                hasPositionalUpdate = true;
-                                break;
-                            }
-                        }
-                    }
-                }
-
-                BSONObjBuilder b( queryOriginal.objsize() + 10 );
-                b.append( doc["_id"] );
-                
-                bool addedAtomic = false;
-
-                BSONObjIterator i( queryOriginal );
-                while ( i.more() ) {
-                    const BSONElement& elem = i.next();
-
-                    if ( str::equals( "_id" , elem.fieldName() ) ) {
-                        // we already do _id
-                        continue;
-                    }
-                    
-                    if ( ! hasPositionalUpdate ) {
-                        // if there is a dotted field, accept we may need more query parts
-                        continue;
-                    }
-                    
-                    if ( ! addedAtomic ) {
-                        b.appendBool( "$atomic" , true );
-                        addedAtomic = true;
-                    }
-
-                    b.append( elem );
-                }
-                queryModified = b.obj();
-            }
-
             if ( remove ) {
+                BSONObj doc;
+                bool found = Helpers::findOne( ns.c_str() , queryOriginal , doc );
+
                 _appendHelper( result , doc , found , fields );
                 if ( found ) {
+                    // delete exactly the document we are returning
+                    BSONObj queryModified = queryOriginal;
+                    if ( doc["_id"].type() && ! isSimpleIdQuery( queryOriginal ) )
+                        queryModified = doc["_id"].wrap();
+
                     deleteObjects( ns , queryModified , true , true );
                     BSONObjBuilder le( result.subobjStart( "lastErrorObject" ) );
                     le.appendNumber( "n" , 1 );
                     le.done();
                 }
+                return true;
             }
-            else {
-                // update
-                if ( ! found && ! upsert ) {
-                    // didn't have it, and am not upserting
-                    _appendHelper( result , doc , found , fields );
-                }
-                else {
-                    // we found it or we're updating
-                    
-                    if ( ! returnNew ) {
-                        _appendHelper( result , doc , found , fields );
-                    }
-                    
-                    const NamespaceString requestNs(ns);
-                    UpdateRequest request(requestNs);
-
-                    request.setQuery(queryModified);
-                    request.setUpdates(update);
-                    request.setUpsert(upsert);
-                    request.setUpdateOpLog();
-
-                    UpdateResult res = mongo::update(request, &cc().curop()->debug());
-
-                    LOG(3) << "update result: "  << res ;
-                    if ( returnNew ) {
-                        if ( !res.upserted.isEmpty() ) {
-                            BSONElement upsertedElem = res.upserted[kUpsertedFieldName];
-                            LOG(3) << "using new _id to get new doc: "
-                                   << upsertedElem;
-                            queryModified = upsertedElem.wrap("_id");
-                        }
-                        else if ( queryModified["_id"].type() ) {
-                            // we do this so that if the update changes the fields, it still matches
-                            queryModified = queryModified["_id"].wrap();
-                        }
 
-                        LOG(3) << "using modified query to return the new doc: " << queryModified;
-                        if ( ! Helpers::findOne( ns.c_str() , queryModified , doc ) ) {
-                            errmsg = str::stream() << "can't find object after modification  " 
-                                                   << " ns: " << ns 
-                                                   << " queryModified: " << queryModified 
-                                                   << " queryOriginal: " << queryOriginal;
-                            log() << errmsg << endl;
-                            return false;
-                        }
-                        _appendHelper( result , doc , true , fields );
-                    }
-                    
-                    BSONObjBuilder le( result.subobjStart( "lastErrorObject" ) );
-                    le.appendBool( "updatedExisting" , res.existing );
-                    le.appendNumber( "n" , res.numMatched );
-                    if ( !res.upserted.isEmpty() ) {
-                        le.append( res.upserted[kUpsertedFieldName] );
-                    }
-                    le.done();
-                    
-                }
+            // A single update finds the document, modifies it where it lies and hands back the
+            // image we return, so there is no query before or after it.  The update matches
+            // with the original query, which also takes care of positional operators.
+            const NamespaceString requestNs(ns);
+            UpdateRequest request(requestNs);
+
+            request.setQuery(queryOriginal);
+            request.setUpdates(update);
+            request.setUpsert(upsert);
+            request.setUpdateOpLog();
+            request.setReturnDoc( returnNew ? UpdateRequest::RETURN_NEW
+                                            : UpdateRequest::RETURN_OLD );
+
+            UpdateResult res = mongo::update(request, &cc().curop()->debug());
+
+            LOG(3) << "update result: "  << res ;
+
+            if ( ! res.existing && ! upsert ) {
+                // didn't have it, and am not upserting
+                _appendHelper( result , BSONObj() , false , fields );
+                return true;
             }
-            
+
+            // when upserting there is no old document to return
+            _appendHelper( result , res.doc , ! res.doc.isEmpty() , fields );
+
+            BSONObjBuilder le( result.subobjStart( "lastErrorObject" ) );
+            le.appendBool( "updatedExisting" , res.existing );
+            le.appendNumber( "n" , res.numMatched );
+            if ( !res.upserted.isEmpty() ) {
+                le.append( res.upserted[kUpsertedFieldName] );
+            }
+            le.done();
+
             return true;
         }
         
@@ -33,6 +33,8 @@
 #include "mongo/db/btree.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/db.h"
+#include "mongo/db/geo/hash.h"
+#include "mongo/db/index_names.h"
 #include "mongo/db/storage/index_details.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/kill_current_op.h"
@@ -45,8 +47,12 @@ namespace mongo {
      * Holds operation parameters.
      */
     struct IndexStatsParams {
+        IndexStatsParams() : geoBits(4) { }
+
         string indexName;
         vector<int> expandNodes;
+        // Bits per dimension of the GeoHash prefixes 2d index keys are counted by.
+        int geoBits;
     };
 
     /**
@@ -193,6 +199,65 @@ namespace mongo {
         }
     };
 
+    /**
+     * Counts the keys of a 2d or geoHaystack index that fall in each cell of the plane: the
+     * GeoHash prefix of a given number of bits for 2d, the haystack bucket for geoHaystack.
+     * Shows how evenly the points are spread, and so how many keys a geo predicate over some
+     * area reads.
+     */
+    class GeoBucketStats {
+    public:
+        static const int quantiles = 99;
+        static const size_t kDensest = 10;
+
+        GeoBucketStats(bool is2d, unsigned bits) : _is2d(is2d), _bits(bits) { }
+
+        void add(const BSONObj& key) {
+            BSONElement e = key.firstElement();
+            if (_is2d) {
+                if (BinData != e.type()) { return; }
+                ++_keysPerBucket[GeoHash(e, _bits).toString()];
+            }
+            else {
+                if (String != e.type()) { return; }
+                ++_keysPerBucket[e.String()];
+            }
+        }
+
+        void appendTo(BSONObjBuilder& builder) const {
+            SummaryEstimators<unsigned int, quantiles> keys;
+            vector<pair<unsigned int, string> > densest;
+            for (map<string, unsigned int>::const_iterator it = _keysPerBucket.begin();
+                 it != _keysPerBucket.end();
+                 ++it) {
+                keys << it->second;
+                densest.push_back(make_pair(it->second, it->first));
+            }
+            size_t n = min(kDensest, densest.size());
+            partial_sort(densest.begin(), densest.begin() + n, densest.end(),
+                         greater<pair<unsigned int, string> >());
+
+            BSONObjBuilder geoBuilder(builder.subobjStart("geoBuckets"));
+            if (_is2d) {
+                geoBuilder << "bits" << _bits;
+            }
+            geoBuilder << "numBuckets" << static_cast<long long>(_keysPerBucket.size())
+                       << "keysPerBucket" << keys.statisticSummaryToBSONObj();
+            BSONArrayBuilder densestBuilder(geoBuilder.subarrayStart("densest"));
+            for (size_t i = 0; i < n; ++i) {
+                densestBuilder << BSON("bucket" << densest[i].second
+                                       << "keys" << densest[i].first);
+            }
+            densestBuilder.doneFast();
+            geoBuilder.doneFast();
+        }
+
+    private:
+        bool _is2d;
+        unsigned _bits;
+        map<string, unsigned int> _keysPerBucket;
+    };
+
     /**
      * Performs the btree analysis for a generic btree version. After inspect() is called on the
      * tree root, statistics are available through stats().
@@ -215,7 +280,8 @@ namespace mongo {
         typedef typename mongo::BucketBasics<Version>::KeyNode KeyNode;
         typedef typename mongo::BucketBasics<Version>::Key Key;
 
-        BtreeInspectorImpl(vector<int> expandNodes) : _expandNodes(expandNodes) {
+        BtreeInspectorImpl(vector<int> expandNodes, GeoBucketStats* geoStats)
+            : _expandNodes(expandNodes), _geoStats(geoStats) {
         }
 
         virtual bool inspect(const DiskLoc& head)  {
@@ -286,6 +352,10 @@ namespace mongo {
                     }
                     lastKeyNode = &kn;
 
+                    if (_geoStats) {
+                        _geoStats->add(KeyNode(*bucket, kn).key.toBson());
+                    }
+
                     this->inspectBucket(kn.prevChildBucket, depth + 1, i, curNodeIsExpanded,
                                         expandedAncestors);
                 }
@@ -342,6 +412,8 @@ namespace mongo {
 
         vector<int> _expandNodes;
         BtreeStats _stats;
+        // Not owned, NULL unless this is a geo index.
+        GeoBucketStats* _geoStats;
     };
 
     typedef BtreeInspectorImpl<V0> BtreeInspectorV0;
@@ -377,10 +449,23 @@ namespace mongo {
                << "keyPattern" << details->keyPattern()
                << "storageNs" << details->indexNamespace();
 
+        scoped_ptr<GeoBucketStats> geoStats;
+        string pluginName = IndexNames::findPluginName(details->keyPattern());
+        if (IndexNames::GEO_2D == pluginName) {
+            geoStats.reset(new GeoBucketStats(true, params.geoBits));
+        }
+        else if (IndexNames::GEO_HAYSTACK == pluginName) {
+            geoStats.reset(new GeoBucketStats(false, 0));
+        }
+
         scoped_ptr<BtreeInspector> inspector(NULL);
         switch (details->version()) {
-          case 1: inspector.reset(new BtreeInspectorV1(params.expandNodes)); break;
-          case 0: inspector.reset(new BtreeInspectorV0(params.expandNodes)); break;
+          case 1:
+            inspector.reset(new BtreeInspectorV1(params.expandNodes, geoStats.get()));
+            break;
+          case 0:
+            inspector.reset(new BtreeInspectorV0(params.expandNodes, geoStats.get()));
+            break;
           default:
             errmsg = str::stream() << "index version " << details->version() << " is "
                                    << "not supported";
@@ -390,6 +475,9 @@ namespace mongo {
         inspector->inspect(details->head);
 
         inspector->stats().appendTo(result);
+        if (geoStats) {
+            geoStats->appendTo(result);
+        }
 
         return true;
     }
@@ -464,6 +552,18 @@ namespace mongo {
      *       lastKey: <bson object containing the value for the last key>
      *     }
      *
+     * For 2d and geoHaystack indexes there is also a field 'geoBuckets' counting the keys in
+     * each cell of the plane.  For 2d the cells are the GeoHash prefixes of 'geoBits: <n>' bits
+     * per dimension (4 by default, so a 16 by 16 grid); for geoHaystack they are the haystack
+     * buckets:
+     *     { bits: <bits per dimension, 2d only>,
+     *       numBuckets: <number of cells with at least one key>,
+     *       keysPerBucket: <stats about the number of keys in a non-empty cell>
+     *           (same structure as keyCount),
+     *       densest: [ { bucket: <GeoHash prefix or haystack bucket>, keys: <number> }, ... ]
+     *           (the ten cells with the most keys, most first)
+     *     }
+     *
      */
     class IndexStatsCmd : public Command {
     public:
@@ -482,7 +582,8 @@ namespace mongo {
               << "of the nodes to be expanded, {expandNodes: [...]}. "
               << "For example, {indexStats: 'collection', index: '_id', expandNodes: [0, 4]} "
               << "aggregates statistics for the _id index for 'collection' and expands root "
-              << "and the fifth child of root.";
+              << "and the fifth child of root. For 2d indexes, {geoBits: n} sets the bits per "
+              << "dimension of the cells keys are counted in.";
         }
 
         virtual LockType locktype() const { return READ; }
@@ -534,6 +635,15 @@ namespace mongo {
                 }
             }
 
+            BSONElement geoBits = cmdObj["geoBits"];
+            if (geoBits.ok()) {
+                if (!geoBits.isNumber() || geoBits.numberInt() < 1 || geoBits.numberInt() > 16) {
+                    errmsg = "geoBits must be a number from 1 to 16";
+                    return false;
+                }
+                params.geoBits = geoBits.numberInt();
+            }
+
             BSONObjBuilder resultBuilder;
             if (!runInternal(nsd, params, errmsg, resultBuilder))
                 return false;
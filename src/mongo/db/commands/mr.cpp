@@ -43,12 +43,14 @@
 #include "mongo/db/matcher.h"
 #include "mongo/db/query_optimizer.h"
 #include "mongo/db/repl/is_master.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/scripting/engine.h"
 #include "mongo/s/collection_metadata.h"
 #include "mongo/s/d_logic.h"
 #include "mongo/s/grid.h"
 #include "mongo/s/stale_exception.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/scopeguard.h"
 
 namespace mongo {
@@ -57,6 +59,9 @@ namespace mongo {
 
         AtomicUInt Config::JOB_NUMBER;
 
+        // Run map and reduce functions of the simplest, most common shapes without JS.
+        MONGO_EXPORT_SERVER_PARAMETER(mapReduceNativeFunctions, bool, true);
+
         JSFunction::JSFunction( const std::string& type , const BSONElement& e ) {
             _type = type;
             _code = e._asCode();
@@ -234,6 +239,305 @@ namespace mongo {
             _reduce( x , key , endSizeEstimate );
         }
 
+        namespace {
+            bool isIdentifierChar( char c ) {
+                return isalnum( c ) || c == '_' || c == '$';
+            }
+
+            /**
+             * @return code without whitespace, except for one space between two identifier
+             * characters. Only good for comparing code without string literals.
+             */
+            string normalizeCode( const string& code ) {
+                string normalized;
+                bool pendingSpace = false;
+                for ( size_t i = 0; i < code.size(); i++ ) {
+                    const char c = code[i];
+                    if ( isspace( c ) ) {
+                        pendingSpace = true;
+                        continue;
+                    }
+                    if ( pendingSpace && !normalized.empty()
+                            && isIdentifierChar( normalized[normalized.size() - 1] )
+                            && isIdentifierChar( c ) ) {
+                        normalized += ' ';
+                    }
+                    pendingSpace = false;
+                    normalized += c;
+                }
+                return normalized;
+            }
+
+            bool isIdentifier( const StringData& s ) {
+                if ( s.empty() || isdigit( s[0] ) )
+                    return false;
+                for ( size_t i = 0; i < s.size(); i++ ) {
+                    if ( !isIdentifierChar( s[i] ) )
+                        return false;
+                }
+                return true;
+            }
+
+            /** Consumes prefix from the front of s if it's there. */
+            bool consume( StringData& s , const StringData& prefix ) {
+                if ( !s.startsWith( prefix ) )
+                    return false;
+                s = s.substr( prefix.size() );
+                return true;
+            }
+
+            /** Consumes the identifier at the front of s into out. */
+            bool consumeIdentifier( StringData& s , string& out ) {
+                size_t end = 0;
+                while ( end < s.size() && isIdentifierChar( s[end] ) )
+                    end++;
+                if ( !isIdentifier( s.substr( 0, end ) ) )
+                    return false;
+                out = s.substr( 0, end ).toString();
+                s = s.substr( end );
+                return true;
+            }
+
+            /** Parses "this.a.b" into the path "a.b". */
+            bool parseThisPath( const StringData& s , string& path ) {
+                StringData rest = s;
+                if ( !consume( rest , "this." ) )
+                    return false;
+                path = rest.toString();
+                size_t start = 0;
+                while ( true ) {
+                    const size_t dot = path.find( '.' , start );
+                    if ( !isIdentifier( StringData( path ).substr( start , dot - start ) ) )
+                        return false;
+                    if ( dot == string::npos )
+                        return true;
+                    start = dot + 1;
+                }
+            }
+
+            /** Parses a plain decimal literal, like 1, -2 or 0.5. */
+            bool parseNumber( const StringData& s , double& number ) {
+                if ( s.empty() || s.size() > 30 )
+                    return false;
+                bool digits = false;
+                bool point = false;
+                for ( size_t i = 0; i < s.size(); i++ ) {
+                    if ( isdigit( s[i] ) )
+                        digits = true;
+                    else if ( s[i] == '.' && !point )
+                        point = true;
+                    else if ( !( s[i] == '-' && i == 0 ) )
+                        return false;
+                }
+                if ( !digits )
+                    return false;
+                number = strtod( s.toString().c_str() , NULL );
+                return true;
+            }
+
+            /** @return code's text if it's a function without a scope of its own */
+            bool getPlainCode( const BSONElement& code , StringData& text ) {
+                if ( code.type() != Code && code.type() != String )
+                    return false;
+                text = StringData( code.valuestr() , code.valuestrsize() - 1 );
+                return true;
+            }
+
+            /**
+             * @return the value emitted for field on its way through JS, or just false if that's
+             * not a type that's sure to come back out of JS as it went in.
+             */
+            bool appendAsFromJS( BSONObjBuilder& b , const StringData& name ,
+                                 const BSONElement& field ) {
+                switch ( field.type() ) {
+                case NumberInt:
+                case NumberDouble:
+                    b.append( name , field.number() ); // JS numbers are doubles
+                    return true;
+                case String:
+                case Bool:
+                case jstNULL:
+                case Date:
+                case jstOID:
+                    b.appendAs( field , name );
+                    return true;
+                default:
+                    return false;
+                }
+            }
+        }
+
+        NativeMapper* NativeMapper::parse( const BSONElement& code ) {
+            StringData text;
+            if ( !getPlainCode( code , text ) )
+                return NULL;
+            const string normalized = normalizeCode( text.toString() );
+
+            StringData body( normalized );
+            if ( !consume( body , "function(){emit(" ) )
+                return NULL;
+            if ( !body.endsWith( ");}" ) ) {
+                if ( !body.endsWith( ")}" ) )
+                    return NULL;
+                body = body.substr( 0 , body.size() - 2 );
+            }
+            else {
+                body = body.substr( 0 , body.size() - 3 );
+            }
+
+            const size_t comma = body.find( ',' );
+            if ( comma == string::npos )
+                return NULL;
+
+            auto_ptr<NativeMapper> mapper( new NativeMapper( code ) );
+            if ( !parseThisPath( body.substr( 0 , comma ) , mapper->_keyPath ) )
+                return NULL;
+
+            const StringData value = body.substr( comma + 1 );
+            if ( !parseThisPath( value , mapper->_valuePath )
+                    && !parseNumber( value , mapper->_value ) ) {
+                return NULL;
+            }
+
+            return mapper.release();
+        }
+
+        void NativeMapper::init( State * state ) {
+            _js.init( state );
+            _state = state;
+        }
+
+        void NativeMapper::map( const BSONObj& o ) {
+            BSONObjBuilder b;
+            if ( appendAsFromJS( b , "0" , o.getFieldDotted( _keyPath ) ) ) {
+                if ( _valuePath.empty() ) {
+                    b.append( "1" , _value );
+                    _state->emit( b.obj() );
+                    return;
+                }
+                if ( appendAsFromJS( b , "1" , o.getFieldDotted( _valuePath ) ) ) {
+                    _state->emit( b.obj() );
+                    return;
+                }
+            }
+            _js.map( o );
+        }
+
+        NativeReducer* NativeReducer::parse( const BSONElement& code ) {
+            StringData text;
+            if ( !getPlainCode( code , text ) )
+                return NULL;
+            const string normalized = normalizeCode( text.toString() );
+
+            StringData body( normalized );
+            string key;
+            string values;
+            if ( !consume( body , "function(" )
+                    || !consumeIdentifier( body , key )
+                    || !consume( body , "," )
+                    || !consumeIdentifier( body , values )
+                    || key == values
+                    || !consume( body , "){return " ) ) {
+                return NULL;
+            }
+
+            const string end = body.endsWith( ";}" ) ? ";}" : "}";
+            const StringData expression = body.substr( 0 , body.size() - end.size() );
+            if ( expression == "Array.sum(" + values + ")" )
+                return new NativeReducer( code , SUM );
+            if ( expression == "Math.min.apply(Math," + values + ")" )
+                return new NativeReducer( code , MIN );
+            if ( expression == "Math.max.apply(Math," + values + ")" )
+                return new NativeReducer( code , MAX );
+            return NULL;
+        }
+
+        bool NativeReducer::_reduce( const BSONList& tuples , double& result ) const {
+            uassert( 17362 ,  "need values" , tuples.size() );
+
+            for ( size_t i = 0; i < tuples.size(); i++ ) {
+                BSONObjIterator it( tuples[i] );
+                it.next();
+                const BSONElement value = it.next();
+                if ( value.type() != NumberDouble )
+                    return false;
+            }
+
+            // The same order and doubles as the JS, so the same result to the bit.
+            for ( size_t i = 0; i < tuples.size(); i++ ) {
+                BSONObjIterator it( tuples[i] );
+                it.next();
+                const double value = it.next().Double();
+                if ( i == 0 ) {
+                    result = value;
+                    continue;
+                }
+
+                switch ( _op ) {
+                case SUM:
+                    result += value;
+                    break;
+                case MIN:
+                    // like Math.min: NaN wins, and -0 is less than 0
+                    if ( result == result && ( value != value || value < result
+                            || ( value == 0 && result == 0 && 1 / value < 0 ) ) ) {
+                        result = value;
+                    }
+                    break;
+                case MAX:
+                    if ( result == result && ( value != value || value > result
+                            || ( value == 0 && result == 0 && 1 / value > 0 ) ) ) {
+                        result = value;
+                    }
+                    break;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * Reduces a list of tuple objects (key, value) to a single tuple {"0": key, "1": value}
+         */
+        BSONObj NativeReducer::reduce( const BSONList& tuples ) {
+            if ( tuples.size() <= 1 )
+                return tuples[0];
+
+            ++numReduces;
+            double result;
+            if ( !_reduce( tuples , result ) )
+                return _js.reduce( tuples );
+
+            BSONObjBuilder b;
+            b.appendAs( tuples[0].firstElement() , "0" );
+            b.append( "1" , result );
+            return b.obj();
+        }
+
+        /**
+         * Reduces a list of tuple object (key, value) to a single tuple {_id: key, value: val}
+         * Also applies a finalizer method if present.
+         */
+        BSONObj NativeReducer::finalReduce( const BSONList& tuples , Finalizer * finalizer ) {
+            double result;
+            if ( tuples.size() == 1 || !_reduce( tuples , result ) ) {
+                if ( tuples.size() > 1 )
+                    ++numReduces;
+                return _js.finalReduce( tuples , finalizer );
+            }
+
+            ++numReduces;
+            BSONObjBuilder b;
+            b.appendAs( tuples[0].firstElement() , "_id" );
+            b.append( "value" , result );
+            BSONObj res = b.obj();
+
+            if ( finalizer ) {
+                res = finalizer->finalize( res );
+            }
+
+            return res;
+        }
+
         Config::Config( const string& _dbname , const BSONObj& cmdObj )
         {
             dbname = _dbname;
@@ -245,6 +549,8 @@ namespace mongo {
             if (cmdObj.hasField("splitInfo"))
                 splitInfo = cmdObj["splitInfo"].Int();
 
+            mapThreads = parseMapThreads( cmdObj );
+
             jsMaxKeys = 500000;
             reduceTriggerRatio = 10.0;
             maxInMemSize = 500 * 1024;
@@ -286,6 +592,20 @@ namespace mongo {
                     mapParams = cmdObj["mapparams"].embeddedObjectUserCheck();
                 }
 
+                // A scope could redefine what the functions call, and the native mapper can't
+                // pass on mapparams.
+                nativeMap = false;
+                if ( mapReduceNativeFunctions && scopeSetup.isEmpty() ) {
+                    if ( mapParams.isEmpty() ) {
+                        if ( Mapper* native = NativeMapper::parse( cmdObj["map"] ) ) {
+                            mapper.reset( native );
+                            nativeMap = true;
+                            jsMode = false; // emits go straight to the C++ map
+                        }
+                    }
+                    if ( Reducer* native = NativeReducer::parse( cmdObj["reduce"] ) )
+                        reducer.reset( native );
+                }
             }
 
             {
@@ -1066,24 +1386,29 @@ namespace mongo {
         }
 
         /**
-         * emit that will be called by js function
+         * @return the tuple emitted by a js emit() called with args
          */
-        BSONObj fast_emit( const BSONObj& args, void* data ) {
+        static BSONObj emittedTuple( const BSONObj& args ) {
             uassert( 10077 , "fast_emit takes 2 args" , args.nFields() == 2 );
             uassert( 13069 , "an emit can't be more than half max bson size" , args.objsize() < ( BSONObjMaxUserSize / 2 ) );
-            
-            State* state = (State*) data;
+
             if ( args.firstElement().type() == Undefined ) {
                 BSONObjBuilder b( args.objsize() );
                 b.appendNull( "" );
                 BSONObjIterator i( args );
                 i.next();
                 b.append( i.next() );
-                state->emit( b.obj() );
-            }
-            else {
-                state->emit( args );
+                return b.obj();
             }
+            return args;
+        }
+
+        /**
+         * emit that will be called by js function
+         */
+        BSONObj fast_emit( const BSONObj& args, void* data ) {
+            State* state = (State*) data;
+            state->emit( emittedTuple( args ) );
             return BSONObj();
         }
 
@@ -1101,6 +1426,134 @@ namespace mongo {
             return BSONObj();
         }
 
+        /**
+         * Maps batches of documents for mapThreads, with a scope of its own on whichever pool
+         * thread runs the batch. Only one batch at a time is out with the worker, and what it
+         * emitted is handed to the command's State before the next goes out, so the State is
+         * only touched by the command's thread.
+         */
+        class MapWorker : boost::noncopyable {
+        public:
+            MapWorker( const Config& config , const BSONElement& mapCode )
+                : _config( config )
+                , _mapCode( mapCode )
+                , _mutex( "mr::MapWorker" )
+                , _busy( false )
+                , _errorCode( 0 )
+            {}
+
+            /** queues a copy of o, handing the queue to the worker once it makes a batch */
+            void add( const BSONObj& o , ThreadPool& threads , State& state ) {
+                _queued.push_back( o.getOwned() );
+                if ( _queued.size() >= BatchSize )
+                    handOff( threads , state );
+            }
+
+            /** hands off what's queued, then waits for the worker */
+            void finish( ThreadPool& threads , State& state ) {
+                if ( !_queued.empty() )
+                    handOff( threads , state );
+                collect( state );
+            }
+
+        private:
+            static const size_t BatchSize = 256;
+
+            void handOff( ThreadPool& threads , State& state ) {
+                collect( state );
+                _batch.swap( _queued );
+                {
+                    scoped_lock lk( _mutex );
+                    _busy = true;
+                }
+                threads.schedule( &MapWorker::mapBatch , this );
+            }
+
+            /** waits for the worker and emits what it did into state, or throws what it hit */
+            void collect( State& state ) {
+                {
+                    scoped_lock lk( _mutex );
+                    while ( _busy )
+                        _workerDone.wait( lk.boost() );
+                }
+                if ( _errorCode != 0 )
+                    throw UserException( _errorCode , _errorMessage );
+
+                for ( BSONList::const_iterator it = _emitted.begin(); it != _emitted.end(); ++it )
+                    state.emit( *it );
+                _emitted.clear();
+            }
+
+            /** on a pool thread */
+            void mapBatch() {
+                // Scopes use the thread's op to check for interrupts.
+                Client::initThread( "mapReduceWorker" );
+
+                try {
+                    if ( !_scope ) {
+                        _scope.reset( globalScriptEngine->newScope() );
+                        if ( !_config.scopeSetup.isEmpty() )
+                            _scope->init( &_config.scopeSetup );
+                        if ( _mapCode.type() == CodeWScope ) {
+                            BSONObj wantedScope = _mapCode.codeWScopeObject();
+                            _scope->init( &wantedScope );
+                        }
+                        _func = _scope->createFunction( _mapCode._asCode().c_str() );
+                        uassert( 13598 , "couldn't compile code for: _map" , _func );
+                        _scope->injectNative( "emit" , emit , this );
+                    }
+
+                    Scope::NoDBAccess no =
+                            _scope->disableDBAccess( "can't access db inside map with mapThreads" );
+                    for ( BSONList::const_iterator it = _batch.begin(); it != _batch.end(); ++it ) {
+                        if ( _scope->invoke( _func , &_config.mapParams , &*it , 0 , true ) )
+                            uasserted( 9014 , str::stream() << "map invoke failed: "
+                                                            << _scope->getError() );
+                    }
+                }
+                catch ( const DBException& e ) {
+                    _errorCode = e.getCode();
+                    _errorMessage = e.what();
+                }
+                catch ( const std::exception& e ) {
+                    _errorCode = 17365;
+                    _errorMessage = str::stream() << "map worker failed: " << e.what();
+                }
+                _batch.clear();
+
+                Client::resetThread( "mapReduceWorkerPool" );
+
+                scoped_lock lk( _mutex );
+                _busy = false;
+                _workerDone.notify_one();
+            }
+
+            static BSONObj emit( const BSONObj& args , void* data ) {
+                MapWorker* worker = static_cast<MapWorker*>( data );
+                worker->_emitted.push_back( emittedTuple( args ).getOwned() );
+                return BSONObj();
+            }
+
+            const Config& _config;
+            const BSONElement _mapCode;
+
+            BSONList _queued; // filled by the command's thread
+            BSONList _batch; // the worker's while _busy
+            BSONList _emitted; // the worker's while _busy
+
+            // the worker's, kept between batches
+            scoped_ptr<Scope> _scope;
+            ScriptingFunction _func;
+
+            mongo::mutex _mutex;
+            boost::condition _workerDone;
+            bool _busy;
+
+            // an error the worker hit, after which the command fails
+            int _errorCode;
+            string _errorMessage;
+        };
+
         /**
          * This class represents a map/reduce command executed on a single server
          */
@@ -1209,6 +1662,17 @@ namespace mongo {
 
                     wassert( config.limit < 0x4000000 ); // see case on next line to 32 bit unsigned
                     long long mapTime = 0;
+
+                    // Declared before the threads so that they outlive the batches they map.
+                    vector<shared_ptr<MapWorker> > mapWorkers;
+                    scoped_ptr<ThreadPool> mapThreads;
+                    if ( config.mapThreads > 1 && !config.nativeMap ) {
+                        for ( int i = 0; i < config.mapThreads; i++ )
+                            mapWorkers.push_back( boost::make_shared<MapWorker>( config ,
+                                                                                 cmd["map"] ) );
+                        mapThreads.reset( new ThreadPool( config.mapThreads ) );
+                    }
+
                     {
                         // We've got a cursor preventing migrations off, now re-establish our useful cursor
 
@@ -1262,7 +1726,11 @@ namespace mongo {
 
                             // do map
                             if ( config.verbose ) mt.reset();
-                            config.mapper->map( o );
+                            if ( mapWorkers.empty() )
+                                config.mapper->map( o );
+                            else
+                                mapWorkers[ num % mapWorkers.size() ]->add( o , *mapThreads ,
+                                                                            state );
                             if ( config.verbose ) mapTime += mt.micros();
 
                             num++;
@@ -1285,6 +1753,9 @@ namespace mongo {
                             if ( config.limit && num >= config.limit )
                                 break;
                         }
+
+                        for ( size_t i = 0; i < mapWorkers.size(); i++ )
+                            mapWorkers[i]->finish( *mapThreads , state );
                     }
                     pm.finished();
 
@@ -1311,7 +1782,9 @@ namespace mongo {
                     inReduce += rt.micros();
                     countsBuilder.appendNumber( "reduce" , state.numReduces() );
                     timingBuilder.appendNumber( "reduceTime" , inReduce / 1000 );
-                    timingBuilder.append( "mode" , state.jsMode() ? "js" : "mixed" );
+                    timingBuilder.append( "mode" , state.jsMode() ? "js"
+                                                   : config.nativeMap ? "native"
+                                                   : "mixed" );
 
                     long long finalCount = state.postProcessCollection(op, pm);
                     state.appendResults( result );
@@ -151,6 +151,60 @@ namespace mongo {
 
         };
 
+        // ------------  native function implementations -----------
+
+        /**
+         * Runs map functions of the form function() { emit(this.<path>, <value>); }, where the
+         * value is a number or this.<path>, without calling into JS. Documents whose key or value
+         * might not come out of JS the same way, eg. because a field is missing or is an object,
+         * go through the JS function instead.
+         */
+        class NativeMapper : public Mapper {
+        public:
+            /** @return a mapper for code, or NULL if it isn't of the form above */
+            static NativeMapper* parse( const BSONElement& code );
+
+            virtual void map( const BSONObj& o );
+            virtual void init( State * state );
+
+        private:
+            NativeMapper( const BSONElement& code ) : _js( code ) , _state( 0 ) {}
+
+            string _keyPath;
+            string _valuePath; // if empty, _value is emitted
+            double _value;
+
+            JSMapper _js;
+            State * _state;
+        };
+
+        /**
+         * Runs reduce functions that return Array.sum(values), Math.min.apply(Math, values) or
+         * Math.max.apply(Math, values) without calling into JS, as long as every value is a
+         * double, which is what JS numbers come back as. Anything else goes to the JS function.
+         */
+        class NativeReducer : public Reducer {
+        public:
+            /** @return a reducer for code, or NULL if it isn't of one of the forms above */
+            static NativeReducer* parse( const BSONElement& code );
+
+            virtual void init( State * state ) { _js.init( state ); }
+
+            virtual BSONObj reduce( const BSONList& tuples );
+            virtual BSONObj finalReduce( const BSONList& tuples , Finalizer * finalizer );
+
+        private:
+            enum Op { SUM, MIN, MAX };
+
+            NativeReducer( const BSONElement& code , Op op ) : _op( op ) , _js( code ) {}
+
+            /** @return false, leaving result unset, if a value isn't a double */
+            bool _reduce( const BSONList& tuples , double& result ) const;
+
+            const Op _op;
+            JSReducer _js;
+        };
+
         // -----------------
 
 
@@ -225,6 +279,18 @@ namespace mongo {
             // true when called from mongos to do phase-1 of M/R
             bool shardedFirstPass;
 
+            // true when mapper is a NativeMapper, which can't run in jsMode
+            bool nativeMap;
+
+            // threads for the map phase, each with a scope of its own (see parseMapThreads)
+            int mapThreads;
+
+            /**
+             * @return the mapThreads option, 1 if not given.
+             * Map functions don't get db access when this is more than 1.
+             */
+            static int parseMapThreads(const BSONObj& cmdObj);
+
             static AtomicUInt JOB_NUMBER;
         }; // end MRsetup
 
@@ -102,6 +102,19 @@ namespace mongo {
             return outputOptions;
         }
 
+        int Config::parseMapThreads(const BSONObj& cmdObj) {
+            BSONElement mapThreads = cmdObj["mapThreads"];
+            if (mapThreads.eoo())
+                return 1;
+
+            uassert(17363, "mapThreads must be a number from 1 to 64",
+                    mapThreads.isNumber()
+                        && mapThreads.numberLong() >= 1 && mapThreads.numberLong() <= 64);
+            uassert(17364, "mapThreads can't be used with jsMode",
+                    mapThreads.numberInt() == 1 || !cmdObj["jsMode"].trueValue());
+            return mapThreads.numberInt();
+        }
+
         void addPrivilegesRequiredForMapReduce(Command* commandTemplate,
                                                const std::string& dbname,
                                                const BSONObj& cmdObj,
@@ -0,0 +1,182 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/clientcursor.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/database.h"
+#include "mongo/db/exec/collection_scan.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/namespace_details.h"
+#include "mongo/db/query/internal_runner.h"
+#include "mongo/db/storage/extent.h"
+#include "mongo/db/storage/extent_manager.h"
+#include "mongo/db/structure/collection.h"
+
+namespace mongo {
+
+    /**
+     * Splits a collection into disjoint ranges of extents and returns one cursor per range, so
+     * that clients can read the whole collection in parallel.  Each cursor is a collection scan
+     * bounded to its extents.
+     *
+     * For example, {parallelCollectionScan: 'collection', numCursors: 4}.
+     */
+    class ParallelCollectionScanCmd : public Command {
+    public:
+        // Bounds numCursors.
+        static const int kMaxCursors = 10000;
+
+        ParallelCollectionScanCmd() : Command("parallelCollectionScan") { }
+
+        virtual bool slaveOk() const { return true; }
+
+        virtual LockType locktype() const { return READ; }
+
+        virtual void help(stringstream& h) const {
+            h << "Returns up to numCursors cursors which between them return every document in "
+              << "a collection once.  The cursors can be drained in parallel. "
+              << "For example, {parallelCollectionScan: 'collection', numCursors: 4}.";
+        }
+
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::find);
+            out->push_back(Privilege(parseResourcePattern(dbname, cmdObj), actions));
+        }
+
+        /**
+         * Divide the extents of 'collection' into at most 'numRanges' contiguous runs holding
+         * roughly the same number of bytes.  Each run is a (first extent, last extent) pair.
+         */
+        static void splitExtents(const Collection* collection, int numRanges,
+                                 std::vector<std::pair<DiskLoc, DiskLoc> >* out) {
+            const NamespaceDetails* nsd = collection->details();
+            const ExtentManager* em = &cc().database()->getExtentManager();
+            if (nsd->firstExtent().isNull()) {
+                return;
+            }
+
+            long long totalBytes = 0;
+            for (Extent* e = em->getExtent(nsd->firstExtent()); NULL != e;
+                 e = em->getNextExtent(e)) {
+                totalBytes += e->length;
+            }
+
+            long long bytesSoFar = 0;
+            DiskLoc first;
+            for (Extent* e = em->getExtent(nsd->firstExtent()); NULL != e;
+                 e = em->getNextExtent(e)) {
+                if (first.isNull()) {
+                    first = e->myLoc;
+                }
+                bytesSoFar += e->length;
+
+                // Close the current run once it's reached its share of the bytes.
+                long long target = totalBytes * static_cast<long long>(out->size() + 1);
+                if (bytesSoFar * numRanges >= target || e->xnext.isNull()) {
+                    out->push_back(std::make_pair(first, e->myLoc));
+                    first = DiskLoc();
+                }
+            }
+        }
+
+        virtual bool run(const string& dbname, BSONObj& cmdObj, int, string& errmsg,
+                         BSONObjBuilder& result, bool fromRepl) {
+            string ns = parseNs(dbname, cmdObj);
+
+            BSONElement numCursorsElt = cmdObj["numCursors"];
+            if (!numCursorsElt.isNumber()) {
+                errmsg = "numCursors must be a number";
+                return false;
+            }
+            int numCursors = numCursorsElt.numberInt();
+            if (numCursors < 1 || numCursors > kMaxCursors) {
+                errmsg = str::stream() << "numCursors must be between 1 and " << kMaxCursors;
+                return false;
+            }
+
+            Collection* collection = cc().database()->getCollection(ns);
+            if (NULL == collection) {
+                errmsg = "ns not found";
+                return false;
+            }
+
+            if (collection->details()->isCapped()) {
+                errmsg = "can't do a parallel scan of a capped collection";
+                return false;
+            }
+
+            std::vector<std::pair<DiskLoc, DiskLoc> > ranges;
+            splitExtents(collection, numCursors, &ranges);
+
+            BSONArrayBuilder cursors(result.subarrayStart("cursors"));
+            for (size_t i = 0; i < ranges.size(); ++i) {
+                CollectionScanParams params;
+                params.ns = ns;
+                params.direction = CollectionScanParams::FORWARD;
+                params.firstExtent = ranges[i].first;
+                params.lastExtent = ranges[i].second;
+
+                // Takes ownership of the working set and the scan.
+                WorkingSet* ws = new WorkingSet();
+                auto_ptr<InternalRunner> runner(
+                    new InternalRunner(ns, new CollectionScan(params, ws, NULL), ws));
+                runner->setYieldPolicy(Runner::YIELD_AUTO);
+
+                // We won't use the runner until it's getMore'd.
+                runner->saveState();
+
+                // The ClientCursor is put in a global map by its ctor and takes ownership of the
+                // runner.
+                ClientCursor* cc = new ClientCursor(runner.release());
+
+                BSONObjBuilder cursor(cursors.subobjStart());
+                BSONObjBuilder cursorObj(cursor.subobjStart("cursor"));
+                cursorObj.append("id", cc->cursorid());
+                cursorObj.append("ns", ns);
+                cursorObj.append("firstBatch", BSONArray());
+                cursorObj.done();
+                cursor.append("ok", true);
+                cursor.done();
+            }
+            cursors.done();
+
+            return true;
+        }
+    } parallelCollectionScanCmd;
+
+}  // namespace mongo
@@ -34,6 +34,7 @@
 #include "mongo/db/auth/action_type.h"
 #include "mongo/db/auth/privilege.h"
 #include "mongo/db/commands.h"
+#include "mongo/db/curop.h"
 #include "mongo/db/interrupt_status_mongod.h"
 #include "mongo/db/pipeline/accumulator.h"
 #include "mongo/db/pipeline/document.h"
@@ -43,10 +44,22 @@
 #include "mongo/db/pipeline/pipeline_d.h"
 #include "mongo/db/pipeline/pipeline.h"
 #include "mongo/db/ops/query.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
 
 namespace mongo {
 
+    // The most bytes of results an aggregation cursor returns per batch. Smaller batches hold
+    // less in memory at once and reach the client sooner.
+    MONGO_EXPORT_SERVER_PARAMETER(aggregationCursorBatchBytes, int, MaxBytesToReturnToClientAtOnce);
+
+    static int cursorBatchBytes() {
+        const int batchBytes = aggregationCursorBatchBytes;
+        return (batchBytes > 0 && batchBytes < MaxBytesToReturnToClientAtOnce)
+                ? batchBytes
+                : MaxBytesToReturnToClientAtOnce;
+    }
+
     static bool isCursorCommand(BSONObj cmdObj) {
         BSONElement cursorElem = cmdObj["cursor"];
         if (cursorElem.eoo())
@@ -95,10 +108,11 @@ namespace mongo {
 
             // can't use result BSONObjBuilder directly since it won't handle exceptions correctly.
             BSONArrayBuilder resultsArray;
-            const int byteLimit = MaxBytesToReturnToClientAtOnce;
+            const int byteLimit = cursorBatchBytes();
             for (int objCount = 0; objCount < batchSize && cursor->ok(); objCount++) {
                 BSONObj current = cursor->current();
-                if (resultsArray.len() + current.objsize() > byteLimit)
+                if (resultsArray.len() + current.objsize() > byteLimit
+                        && (objCount > 0 || current.objsize() > MaxBytesToReturnToClientAtOnce))
                     break; // too big. current will be the first doc in the second batch
 
                 resultsArray.append(current);
@@ -179,15 +193,27 @@ namespace mongo {
         virtual bool isMultiKey() const { return false; }
         virtual bool modifiedKeys() const { return false; }
         virtual string toString() { return "Aggregate_Cursor"; }
+        virtual int batchBytesTarget() const { return cursorBatchBytes(); }
 
         // These probably won't be needed once aggregation supports it's own explain.
         virtual long long nscanned() { return 0; }
         virtual void explainDetails( BSONObjBuilder& b ) { return; }
+
+        /** Keeps op's peakMemoryBytes up to the pipeline's from here on. */
+        static void reportMemoryTo(const intrusive_ptr<Pipeline>& pipeline, CurOp* op) {
+            ExpressionContext* ctx = pipeline->getContext().get();
+            ctx->reportPeakMemoryBytes = &op->peakMemoryBytes();
+            ctx->reportPeakMemoryBytes->store(ctx->peakMemoryBytes);
+        }
+
     private:
         const DocumentSource* iterator() const { return _pipeline->output(); }
         DocumentSource* iterator() { return _pipeline->output(); }
 
         void getNext() {
+            // Whichever op runs the pipeline, the command or a getmore, reports its memory.
+            reportMemoryTo(_pipeline, cc().curop());
+
             if (boost::optional<Document> result = iterator()->getNext()) {
                 _currentObj = result->toBson();
             }
@@ -214,7 +240,7 @@ namespace mongo {
         virtual void help(stringstream &help) const {
             help << "{ pipeline: [ { $operator: {...}}, ... ]"
                  << ", explain: <bool>"
-                 << ", allowDiskUsage: <bool>"
+                 << ", allowDiskUse: <bool>"
                  << ", cursor: {batchSize: <number>}"
                  << " }"
                  << endl
@@ -280,6 +306,7 @@ namespace mongo {
                 handleCursorCommand(id, cmdObj, result);
             }
             else {
+                PipelineCursor::reportMemoryTo(pPipeline, cc().curop());
                 pPipeline->run(result);
             }
 
@@ -0,0 +1,122 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include <string>
+#include <vector>
+
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/query/plan_cache.h"
+
+namespace mongo {
+
+    /**
+     * Base class for the commands that inspect or manipulate the plan cache of a collection.
+     * Both run under a read lock; the cache does its own locking.
+     */
+    class PlanCacheCommand : public Command {
+    public:
+        PlanCacheCommand(const string& name, ActionType actionType)
+            : Command(name), _actionType(actionType) { }
+
+        virtual bool slaveOk() const { return true; }
+
+        virtual LockType locktype() const { return READ; }
+
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(_actionType);
+            out->push_back(Privilege(parseResourcePattern(dbname, cmdObj), actions));
+        }
+
+        bool run(const string& dbname, BSONObj& cmdObj, int, string& errmsg,
+                 BSONObjBuilder& result, bool fromRepl) {
+            string ns = parseNs(dbname, cmdObj);
+            PlanCache* planCache = PlanCache::get(ns);
+            if (NULL == planCache) {
+                errmsg = "ns not found";
+                return false;
+            }
+            return runOnCache(planCache, errmsg, result);
+        }
+
+        virtual bool runOnCache(PlanCache* planCache, string& errmsg,
+                                BSONObjBuilder& result) = 0;
+
+    private:
+        ActionType _actionType;
+    };
+
+    class PlanCacheListQueryShapes : public PlanCacheCommand {
+    public:
+        PlanCacheListQueryShapes()
+            : PlanCacheCommand("planCacheListQueryShapes", ActionType::planCacheRead) { }
+
+        virtual void help(stringstream& h) const {
+            h << "Lists the query shapes in the plan cache of a collection, most recently used "
+              << "first, along with the plan each one is answered by. "
+              << "For example, {planCacheListQueryShapes: 'collection'}.";
+        }
+
+        virtual bool runOnCache(PlanCache* planCache, string& errmsg, BSONObjBuilder& result) {
+            vector<BSONObj> entries;
+            planCache->getEntries(&entries);
+
+            BSONArrayBuilder arr(result.subarrayStart("shapes"));
+            for (vector<BSONObj>::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+                arr.append(*it);
+            }
+            arr.doneFast();
+            return true;
+        }
+    };
+    static PlanCacheListQueryShapes planCacheListQueryShapes;
+
+    class PlanCacheClear : public PlanCacheCommand {
+    public:
+        PlanCacheClear() : PlanCacheCommand("planCacheClear", ActionType::planCacheWrite) { }
+
+        virtual void help(stringstream& h) const {
+            h << "Drops every entry from the plan cache of a collection. "
+              << "For example, {planCacheClear: 'collection'}.";
+        }
+
+        virtual bool runOnCache(PlanCache* planCache, string& errmsg, BSONObjBuilder& result) {
+            result.appendNumber("removed", static_cast<long long>(planCache->size()));
+            planCache->clear();
+            return true;
+        }
+    };
+    static PlanCacheClear planCacheClear;
+
+}  // namespace mongo
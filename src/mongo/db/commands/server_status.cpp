@@ -41,6 +41,8 @@
 #include "mongo/db/stats/counters.h"
 #include "mongo/platform/process_id.h"
 #include "mongo/util/net/listen.h"
+#include "mongo/util/net/message_compression.h"
+#include "mongo/util/net/ssl_manager.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/ramlog.h"
 #include "mongo/util/version.h"
@@ -324,11 +326,27 @@ namespace mongo {
             BSONObj generateSection(const BSONElement& configElement) const {
                 BSONObjBuilder b;
                 networkCounter.append( b );
+                appendMessageCompressionStats( b );
                 return b.obj();
             }
                 
         } network;
 
+#ifdef MONGO_SSL
+        class SSLStatus : public ServerStatusSection {
+        public:
+            SSLStatus() : ServerStatusSection( "ssl" ){}
+            virtual bool includeByDefault() const { return getSSLManager() != NULL; }
+
+            BSONObj generateSection(const BSONElement& configElement) const {
+                BSONObjBuilder b;
+                appendSSLStats( b );
+                return b.obj();
+            }
+
+        } sslStatus;
+#endif
+
         class MemBase : public ServerStatusMetric {
         public:
             MemBase() : ServerStatusMetric(".mem.bits") {}
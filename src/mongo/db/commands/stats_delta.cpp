@@ -0,0 +1,203 @@
+// @file stats_delta.cpp
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+/*
+ * serverStatus and top reduced to what changed since the last sample, for tools that sample
+ * many times a second.
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+namespace {
+
+    /**
+     * Appends the fields of 'now' that are not the same in 'prev' to 'b', recursing into
+     * subobjects so that one counter changing deep in a section costs one field.  Fields usually
+     * come in the same order in both, so 'prev' is walked alongside 'now' and only searched when
+     * they differ.
+     */
+    void appendChanged(const BSONObj& prev, const BSONObj& now, BSONObjBuilder* b) {
+        BSONObjIterator p(prev);
+        BSONObjIterator i(now);
+        while (i.more()) {
+            BSONElement e = i.next();
+            BSONElement old = p.more() ? p.next() : BSONElement();
+            if (old.eoo() || old.fieldNameStringData() != e.fieldNameStringData())
+                old = prev[e.fieldName()];
+
+            if (e.type() == Object && old.type() == Object) {
+                BSONObjBuilder sub;
+                appendChanged(old.Obj(), e.Obj(), &sub);
+                BSONObj changed = sub.done();
+                if (!changed.isEmpty())
+                    b->append(e.fieldName(), changed);
+            }
+            else if (old.type() != e.type() || !old.valuesEqual(e)) {
+                b->append(e);
+            }
+        }
+    }
+
+    /**
+     * The last document sent on each stream, for the most recently used streams.  A stream
+     * whose token has been forgotten, or comes from before a restart, starts over with the
+     * whole document.
+     */
+    class DeltaStreams {
+    public:
+        DeltaStreams() : _lock("DeltaStreams"), _nextToken(curTimeMillis64()), _uses(0) { }
+
+        /**
+         * Replaces the last document of stream 'token' with 'now' and returns the previous one,
+         * or an empty document if the stream is new.  Sets '*token' to the token to send next.
+         */
+        BSONObj swap(long long* token, const BSONObj& now) {
+            SimpleMutex::scoped_lock lk(_lock);
+            Streams::iterator it = _streams.find(*token);
+            if (it == _streams.end()) {
+                if (_streams.size() >= kMaxStreams)
+                    evictOldest();
+                *token = _nextToken++;
+                it = _streams.insert(std::make_pair(*token, Stream())).first;
+            }
+            BSONObj prev = it->second.last;
+            it->second.last = now;
+            it->second.lastUse = ++_uses;
+            return prev;
+        }
+
+    private:
+        static const size_t kMaxStreams = 64;
+
+        struct Stream {
+            Stream() : lastUse(0) { }
+            BSONObj last;
+            unsigned long long lastUse;
+        };
+        typedef std::map<long long, Stream> Streams;
+
+        void evictOldest() {
+            Streams::iterator oldest = _streams.begin();
+            for (Streams::iterator it = _streams.begin(); it != _streams.end(); ++it) {
+                if (it->second.lastUse < oldest->second.lastUse)
+                    oldest = it;
+            }
+            _streams.erase(oldest);
+        }
+
+        SimpleMutex _lock;
+        Streams _streams;
+        long long _nextToken;
+        unsigned long long _uses;
+    } deltaStreams;
+
+    /**
+     * { statsDelta : "serverStatus" | "top", token : <from the last reply> }
+     *
+     * Runs the named command, passing it the other fields, and returns in 'changed' only the
+     * fields that differ from the last reply on the same stream.  The first reply of a stream,
+     * with 'full' set, has the whole document.  Fields that stop being reported are not
+     * mentioned; the sections of both commands are fixed once the server is up.
+     */
+    class CmdStatsDelta : public Command {
+    public:
+        CmdStatsDelta() : Command("statsDelta") { }
+
+        virtual bool slaveOk() const { return true; }
+        virtual bool adminOnly() const { return true; }
+        virtual LockType locktype() const { return NONE; }
+        virtual void help(stringstream& help) const {
+            help << "{ statsDelta : \"serverStatus\" | \"top\", token : <from the last reply> }"
+                    " returns what changed since the last reply";
+        }
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            // the same as the command run
+            ActionSet actions;
+            if (cmdObj.firstElement().str() == "top")
+                actions.addAction(ActionType::top);
+            else
+                actions.addAction(ActionType::serverStatus);
+            out->push_back(Privilege(ResourcePattern::forClusterResource(), actions));
+        }
+
+        virtual bool run(const string& dbname,
+                         BSONObj& cmdObj,
+                         int options,
+                         string& errmsg,
+                         BSONObjBuilder& result,
+                         bool fromRepl) {
+            Command* target = findTarget(cmdObj);
+            if (!target) {
+                errmsg = "statsDelta must name serverStatus or top, on a server that has it";
+                return false;
+            }
+
+            BSONObjBuilder nowBuilder;
+            if (!target->run(dbname, cmdObj, options, errmsg, nowBuilder, fromRepl))
+                return false;
+            BSONObj now = nowBuilder.obj();
+
+            long long token = cmdObj["token"].numberLong();
+            BSONObj prev = deltaStreams.swap(&token, now);
+
+            result.append("token", token);
+            result.append("full", prev.isEmpty());
+            BSONObjBuilder changed(result.subobjStart("changed"));
+            appendChanged(prev, now, &changed);
+            changed.done();
+            return true;
+        }
+
+    private:
+        static Command* findTarget(const BSONObj& cmdObj) {
+            std::string name = cmdObj.firstElement().str();
+            if (name != "serverStatus" && name != "top")
+                return NULL;
+            return Command::findCommand(name);
+        }
+    } cmdStatsDelta;
+
+} // namespace
+
+} // namespace mongo
@@ -28,17 +28,30 @@
  *    it in the license file.
  */
 
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "mongo/db/clientcursor.h"
 #include "mongo/db/commands.h"
+#include "mongo/db/index/index_access_method.h"
 #include "mongo/db/kill_current_op.h"
 #include "mongo/db/namespace_details.h"
 #include "mongo/db/pdfile.h"
 #include "mongo/db/query/internal_plans.h"
+#include "mongo/db/query/new_find.h"
 #include "mongo/db/query/runner.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/extent.h"
 #include "mongo/db/structure/collection.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/processinfo.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
+    // threads validating a collection's indexes at once; 0 is one per core, up to 8
+    MONGO_EXPORT_SERVER_PARAMETER(validateIndexThreads, int, 0);
+
     class ValidateCmd : public Command {
     public:
         ValidateCmd() : Command( "validate" ) {}
@@ -48,7 +61,8 @@ namespace mongo {
         }
 
         virtual void help(stringstream& h) const { h << "Validate contents of a namespace by scanning its data structures for correctness.  Slow.\n"
-                                                        "Add full:true option to do a more thorough check"; }
+                                                        "Add full:true option to do a more thorough check\n"
+                                                        "Add yield:true to let writes in while records are scanned, and maxMBPerSec:<n> to limit how fast they're read"; }
 
         virtual LockType locktype() const { return READ; }
         virtual void addRequiredPrivileges(const std::string& dbname,
@@ -58,7 +72,8 @@ namespace mongo {
             actions.addAction(ActionType::validate);
             out->push_back(Privilege(parseResourcePattern(dbname, cmdObj), actions));
         }
-        //{ validate: "collectionnamewithoutthedbpart" [, scandata: <bool>] [, full: <bool> } */
+        //{ validate: "collectionnamewithoutthedbpart" [, scandata: <bool>] [, full: <bool>]
+        //  [, yield: <bool>] [, maxMBPerSec: <number>] } */
 
         bool run(const string& dbname , BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl ) {
             string ns = dbname + "." + cmdObj.firstElement().valuestrsafe();
@@ -85,6 +100,60 @@ namespace mongo {
         }
 
     private:
+        // records scanned between yields when yielding
+        static const int RecordsPerYield = 1000;
+
+        struct IndexValidation {
+            IndexValidation( const string& ns, IndexAccessMethod* iam )
+                : ns( ns ), iam( iam ), keys( 0 ), ok( false ) { }
+            string ns;
+            IndexAccessMethod* iam;
+            int64_t keys;
+            bool ok;
+        };
+
+        static void validateIndex( IndexValidation* v ) {
+            try {
+                v->ok = v->iam->validate( &v->keys ).isOK();
+            }
+            catch (...) {
+                v->ok = false;
+            }
+        }
+
+        /** takes the next index to validate until there are none; the caller holds the lock */
+        static void validateIndexesWorker( vector<IndexValidation>* indexes, AtomicUInt32* next ) {
+            Client::initThread( "validate index" );
+            for ( unsigned i = next->fetchAndAdd( 1 ); i < indexes->size(); i = next->fetchAndAdd( 1 ) ) {
+                validateIndex( &(*indexes)[i] );
+            }
+            cc().shutdown();
+        }
+
+        /** walks each index's btree, several at once on their own threads */
+        static void validateIndexes( vector<IndexValidation>* indexes ) {
+            size_t nThreads = validateIndexThreads;
+            if ( validateIndexThreads <= 0 )
+                nThreads = std::min( ProcessInfo().getNumCores(), 8U );
+            nThreads = std::min( nThreads, indexes->size() );
+
+            if ( nThreads <= 1 ) {
+                for ( size_t i = 0; i < indexes->size(); i++ ) {
+                    validateIndex( &(*indexes)[i] );
+                    killCurrentOp.checkForInterrupt();
+                }
+                return;
+            }
+
+            AtomicUInt32 next( 0 );
+            boost::thread_group threads;
+            for ( size_t i = 0; i < nThreads; i++ ) {
+                threads.create_thread( boost::bind( &ValidateCmd::validateIndexesWorker,
+                                                    indexes, &next ) );
+            }
+            threads.join_all();
+        }
+
         void validateNS(const string& ns,
                         Collection* collection,
                         const BSONObj& cmdObj,
@@ -92,6 +161,9 @@ namespace mongo {
 
             const bool full = cmdObj["full"].trueValue();
             const bool scanData = full || cmdObj["scandata"].trueValue();
+            // the throttle sleeps with the lock released, so it implies yielding
+            const double maxMBPerSec = cmdObj["maxMBPerSec"].numberDouble();
+            const bool yield = cmdObj["yield"].trueValue() || maxMBPerSec > 0;
 
             NamespaceDetails* nsd = collection->details();
 
@@ -216,9 +288,11 @@ namespace mongo {
                 }
 
                 set<DiskLoc> recs;
+                bool yielded = false; // writes may have come in during the record scan
                 if( scanData ) {
                     int n = 0;
                     int nInvalid = 0;
+                    int nBadChecksums = 0;
                     long long nQuantizedSize = 0;
                     long long nPowerOf2QuantizedSize = 0;
                     long long len = 0;
@@ -230,6 +304,14 @@ namespace mongo {
                     DiskLoc cl;
                     Runner::RunnerState state;
                     auto_ptr<Runner> runner(InternalPlanner::collectionScan(ns));
+                    scoped_ptr<DeregisterEvenIfUnderlyingCodeThrows> safety;
+                    if ( yield ) {
+                        // yields are manual, but deletes in them still have to reach the runner
+                        ClientCursor::registerRunner(runner.get());
+                        safety.reset(new DeregisterEvenIfUnderlyingCodeThrows(runner.get()));
+                    }
+                    Timer scanTimer;
+                    bool dropped = false;
                     while (Runner::RUNNER_ADVANCED == (state = runner->getNext(NULL, &cl))) {
                         n++;
 
@@ -265,6 +347,14 @@ namespace mongo {
                         }
 
                         if (full){
+                            if (checkRecordChecksum(r) == RecordChecksumBad) {
+                                valid = false;
+                                if (nBadChecksums == 0) // only log once;
+                                    errors << "record checksum mismatch detected (see logs for more info)";
+                                nBadChecksums++;
+                                log() << "Record checksum mismatch in " << ns << " at " << cl.toString() << endl;
+                            }
+
                             BSONObj obj = BSONObj::make(r);
                             if (!obj.isValid() || !obj.valid()){ // both fast and deep checks
                                 valid = false;
@@ -289,6 +379,34 @@ namespace mongo {
                                 bsonLen += obj.objsize();
                             }
                         }
+
+                        if ( yield && n % RecordsPerYield == 0 ) {
+                            runner->saveState();
+                            {
+                                dbtempreleasecond unlock;
+                                if ( unlock.unlocked() ) {
+                                    yielded = true;
+                                    if ( maxMBPerSec > 0 ) {
+                                        long long due = static_cast<long long>(
+                                            len / ( maxMBPerSec * 1024 * 1024 ) * 1000 );
+                                        long long ahead = due - scanTimer.millis();
+                                        if ( ahead > 0 )
+                                            sleepmillis( ahead );
+                                    }
+                                }
+                            }
+                            if ( !runner->restoreState() ) {
+                                dropped = true;
+                                break;
+                            }
+                            killCurrentOp.checkForInterrupt();
+                        }
+                    }
+                    if ( dropped || ( yielded && cc().database()->getCollection( ns ) != collection ) ) {
+                        errors << "collection dropped during validate";
+                        result.appendBool("valid", false);
+                        result.append("errors", errors.arr());
+                        return;
                     }
                     if (Runner::RUNNER_EOF != state) {
                         // TODO: more descriptive logging.
@@ -305,6 +423,7 @@ namespace mongo {
 
                     if (full) {
                         result.append("invalidObjects", nInvalid);
+                        result.append("badChecksums", nBadChecksums);
                     }
 
                     result.appendNumber("nQuantizedSize", nQuantizedSize);
@@ -315,6 +434,9 @@ namespace mongo {
                     if (full) {
                         result.appendNumber("bytesBson", bsonLen);
                     }
+                    if (yield) {
+                        result.appendBool("yielded", yielded);
+                    }
                 }
 
                 BSONArrayBuilder deletedListArray;
@@ -371,7 +493,8 @@ namespace mongo {
                     result << "delBucketSizes" << delBucketSizes.arr();
                 }
 
-                if ( incorrect ) {
+                // records deleted while the scan yielded are rightly in the deleted lists
+                if ( incorrect && !yielded ) {
                     errors << (BSONObjBuilder::numStr(incorrect) + " records from datafile are in deleted list");
                     valid = false;
                 }
@@ -381,7 +504,9 @@ namespace mongo {
                     IndexCatalog* indexCatalog = collection->getIndexCatalog();
 
                     result.append("nIndexes", nsd->getCompletedIndexCount());
-                    BSONObjBuilder indexes; // not using subObjStart to be exception safe
+                    // the catalog isn't safe to share, so the validating threads are handed
+                    // the access methods
+                    vector<IndexValidation> toValidate;
                     NamespaceDetails::IndexIterator i = nsd->ii();
                     while( i.more() ) {
                         IndexDetails& id = i.next();
@@ -392,11 +517,23 @@ namespace mongo {
                         IndexAccessMethod* iam = indexCatalog->getIndex( descriptor );
                         verify( iam );
 
-                        int64_t keys;
-                        iam->validate(&keys);
-                        indexes.appendNumber(id.indexNamespace(), static_cast<long long>(keys));
+                        toValidate.push_back( IndexValidation( id.indexNamespace(), iam ) );
                         idxn++;
                     }
+
+                    validateIndexes( &toValidate );
+
+                    BSONObjBuilder indexes; // not using subObjStart to be exception safe
+                    for ( size_t j = 0; j < toValidate.size(); j++ ) {
+                        const IndexValidation& v = toValidate[j];
+                        if ( !v.ok ) {
+                            errors << ("exception during index validate idxn " +
+                                       BSONObjBuilder::numStr( static_cast<int>( j ) ));
+                            valid = false;
+                            continue;
+                        }
+                        indexes.appendNumber(v.ns, static_cast<long long>(v.keys));
+                    }
                     result.append("keysPerIndex", indexes.done());
                 }
                 catch (...) {
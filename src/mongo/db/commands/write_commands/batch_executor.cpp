@@ -38,6 +38,8 @@
 #include "mongo/db/ops/delete.h"
 #include "mongo/db/ops/update.h"
 #include "mongo/db/pagefault.h"
+#include "mongo/db/repl/flow_control.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/db/write_concern.h"
 #include "mongo/s/batched_error_detail.h"
@@ -66,8 +68,72 @@ namespace mongo {
             return false;
         }
 
+        // How many items of a batch, and for how long, may run under one acquisition of the
+        // write lock before it's released to let other operations in.
+        MONGO_EXPORT_SERVER_PARAMETER(internalWriteBatchItemsPerLock, int, 128);
+        MONGO_EXPORT_SERVER_PARAMETER(internalWriteBatchMillisPerLock, int, 10);
+
     }
 
+    /**
+     * Holds the collection's write lock and a Client::Context across consecutive items of a
+     * batch, so each item doesn't acquire them again.  Once the items run under one acquisition
+     * use up their budget, release() gives other operations a turn.
+     *
+     * The PageFaultRetryableSection is entered before the lock, as it must be for page faults
+     * to be retried, and each item is its own retry: one that faults is run again, the ones
+     * before it stay done.
+     */
+    class WriteBatchExecutor::WriteGroup {
+        MONGO_DISALLOW_COPYING(WriteGroup);
+    public:
+        explicit WriteGroup( const string& ns ) : _ns( ns ), _items( 0 ) {}
+
+        bool held() const { return _ctx.get() != NULL; }
+
+        void acquire( CurOp& op ) {
+            verify( !held() );
+            _pageFaults.reset( new PageFaultRetryableSection() );
+            waitForFlowControlTicket( _ns, op );
+            _lock.reset( new Lock::CollectionWrite( _ns ) );
+            _ctx.reset( new Client::Context( _ns,
+                                             storageGlobalParams.dbpath, // TODO: better constructor?
+                                             false /* don't check version here */ ) );
+            _items = 0;
+            _timer.reset();
+        }
+
+        /** Makes 'op', an item after the first, one run in the group's context. */
+        void enter( CurOp& op ) {
+            // what the items before wrote needn't be retried with this one
+            cc().newTopLevelRequest();
+            op.enter( _ctx.get() );
+        }
+
+        /** Notes an item run under the lock and releases it if that used up the budget. */
+        void itemDone() {
+            if ( ++_items >= internalWriteBatchItemsPerLock
+                 || _timer.millis() >= internalWriteBatchMillisPerLock ) {
+                release();
+            }
+        }
+
+        void release() {
+            _ctx.reset();
+            _lock.reset();
+            _pageFaults.reset();
+        }
+
+    private:
+        const string _ns;
+        // members are released in the reverse order
+        scoped_ptr<PageFaultRetryableSection> _pageFaults;
+        scoped_ptr<Lock::CollectionWrite> _lock;
+        scoped_ptr<Client::Context> _ctx;
+        int _items;
+        Timer _timer;
+    };
+
     WriteBatchExecutor::WriteBatchExecutor( const BSONObj& wc,
                                             Client* client,
                                             OpCounters* opCounters,
@@ -90,9 +156,11 @@ namespace mongo {
         // sequentially.
         size_t numBatchOps = request.sizeWriteOps();
         bool verbose = verboseResponse( request );
+        WriteGroup group( request.getNS() );
         for ( size_t i = 0; i < numBatchOps; i++ ) {
 
             if ( applyWriteItem( BatchItemRef( &request, i ),
+                                 &group,
                                  &stats,
                                  &upsertedID,
                                  error.get() ) ) {
@@ -136,6 +204,9 @@ namespace mongo {
             }
         }
 
+        // the write concern and shard version refresh below can't wait while we hold the lock
+        group.release();
+
         // So far, we may have failed some of the batch's items. So we record
         // that. Rergardless, we still need to apply the write concern.  If that generates a
         // more specific error, we'd replace for the intermediate error here. Note that we
@@ -218,6 +289,7 @@ namespace mongo {
     } // namespace
 
     bool WriteBatchExecutor::applyWriteItem( const BatchItemRef& itemRef,
+                                             WriteGroup* group,
                                              WriteStats* stats,
                                              BSONObj* upsertedID,
                                              BatchedErrorDetail* error ) {
@@ -230,10 +302,9 @@ namespace mongo {
         //uint64_t itemTimeMicros = 0;
         bool opSuccess = true;
 
-        // Each write operation executes in its own PageFaultRetryableSection.  This means that
+        // Each write operation is retried on its own after a PageFaultException.  This means that
         // a single batch can throw multiple PageFaultException's, which is not the case for
         // other operations.
-        PageFaultRetryableSection s;
         while ( true ) {
             try {
                 // Execute the write item as a child operation of the current operation.
@@ -249,13 +320,25 @@ namespace mongo {
                 childOp.ensureStarted();
                 OpDebug& opDebug = childOp.debug();
                 opDebug.ns = ns;
-                {
-                    Lock::DBWrite dbLock( ns );
-                    Client::Context ctx( ns,
-                                         storageGlobalParams.dbpath, // TODO: better constructor?
-                                         false /* don't check version here */);
+                if ( !group->held() ) {
+                    group->acquire( childOp );
+                }
+                else {
+                    group->enter( childOp );
+                }
 
-                    opSuccess = doWrite( ns, itemRef, &childOp, stats, upsertedID, error );
+                opSuccess = doWrite( ns, itemRef, &childOp, stats, upsertedID, error );
+
+                // The context records its time against the item current when it's released, so
+                // release it before the batch's own operation is current again.
+                const bool lastItem =
+                    itemRef.getItemIndex() + 1 == static_cast<int>( request.sizeWriteOps() )
+                    || ( !opSuccess && request.getOrdered() );
+                if ( lastItem ) {
+                    group->release();
+                }
+                else {
+                    group->itemDone();
                 }
                 childOp.done();
                 //itemTimeMicros = childOp.totalTimeMicros();
@@ -274,13 +357,16 @@ namespace mongo {
                 // TODO Log operation if logLevel >= 3 and assertion thrown (as assembleResponse()
                 // does).
 
-                // Save operation to system.profile if shouldDBProfile().
+                // Save operation to system.profile if shouldDBProfile().  Profiling takes the
+                // lock itself, so the next item acquires ours again.
                 if ( childOp.shouldDBProfile( opDebug.executionTime ) ) {
+                    group->release();
                     profile( *_client, getOpCode( request.getBatchType() ), childOp );
                 }
                 break;
             }
             catch ( PageFaultException& e ) {
+                group->release();
                 e.touch();
             }
         }
@@ -312,7 +398,9 @@ namespace mongo {
              && !ChunkVersion::isIgnoredVersion( request.getShardVersion() ) ) {
 
             Lock::assertWriteLocked( ns );
-            CollectionMetadataPtr metadata = shardingState.getCollectionMetadata( ns );
+            ShardedConnectionInfo* info = ShardedConnectionInfo::get( false );
+            CollectionMetadataPtr metadata = info ? info->getCollectionMetadata( ns )
+                                                  : shardingState.getCollectionMetadata( ns );
             ChunkVersion shardVersion =
                 metadata ? metadata->getShardVersion() : ChunkVersion::UNSHARDED();
 
@@ -77,13 +77,19 @@ namespace mongo {
             int numDeleted;
         };
 
+        // The write lock and Client::Context that consecutive items of a batch share
+        class WriteGroup;
+
         /**
          * Issues the single write 'itemRef'. Returns true iff write item was issued
          * sucessfully and increments 'stats'. If the item is an upsert, fills in the
          * 'upsertedID' also, with the '_id' chosen for that update. If the write failed,
          * returns false and populates 'error'
+         *
+         * Takes the lock of 'group' if it isn't held, and may leave it held for the next item.
          */
         bool applyWriteItem( const BatchItemRef& itemRef,
+                             WriteGroup* group,
                              WriteStats* stats,
                              BSONObj* upsertedID,
                              BatchedErrorDetail* error );
@@ -112,12 +112,19 @@ namespace mongo {
 
                     if( !validate || objOld.valid() ) {
                         nrecords++;
+                        const char *stored = objOld.objdata();
                         unsigned sz = objOld.objsize();
+                        std::string compressed;
+                        if (d->isUserFlagSet(NamespaceDetails::Flag_CompressRecords)
+                                && compressRecordData(objOld, &compressed)) {
+                            stored = compressed.data();
+                            sz = compressed.size();
+                        }
 
                         oldObjSize += sz;
                         oldObjSizeWithPadding += recOld->netLength();
 
-                        unsigned lenWHdr = sz + Record::HeaderSize;
+                        unsigned lenWHdr = sz + recordChecksumRoom(d) + Record::HeaderSize;
                         unsigned lenWPadding = lenWHdr;
                         // maintain UsePowerOf2Sizes if no padding values were passed in
                         if (d->isUserFlagSet(NamespaceDetails::Flag_UsePowerOf2Sizes)
@@ -139,7 +146,8 @@ namespace mongo {
                         datasize += recNew->netLength();
                         recNew = (Record *) getDur().writingPtr(recNew, lenWHdr);
                         addRecordToRecListInExtent(recNew, loc);
-                        memcpy(recNew->data(), objOld.objdata(), sz);
+                        memcpy(recNew->data(), stored, sz);
+                        updateRecordChecksum(d, recNew);
                     }
                     else { 
                         if( ++skipped <= 10 )
@@ -292,6 +300,117 @@ namespace mongo {
         return true;
     }
 
+    /** @return the fraction of extent 'e' taken up by its live records */
+    static double extentFill(Extent *e) {
+        ExtentManager& em = cc().database()->getExtentManager();
+        long long used = 0;
+        for( DiskLoc L = e->firstRecord; !L.isNull(); L = em.getNextRecordInExtent(L) )
+            used += L.rec()->lengthWithHeaders();
+        return static_cast<double>(used) / (e->length - Extent::HeaderSize());
+    }
+
+    /** unlink the empty, non-last extent at 'extentLoc' from 'd' and give it back to the database */
+    static void freeEmptyExtent(NamespaceDetails *d, const DiskLoc extentLoc) {
+        // space freed here by other writers since we started is still on the deleted lists.
+        d->orphanDeletedRecordsInExtent(extentLoc);
+
+        Extent *e = extentLoc.ext();
+        verify( e->firstRecord.isNull() );
+        verify( d->lastExtent() != extentLoc );
+        if( e->xprev.isNull() )
+            d->firstExtent().writing() = e->xnext;
+        else
+            e->xprev.ext()->xnext.writing() = e->xnext;
+        e->xnext.ext()->xprev.writing() = e->xprev;
+        getDur().writing(e)->markEmpty();
+        cc().database()->getExtentManager().freeExtents( extentLoc, extentLoc );
+    }
+
+    /** moves up to 'batchSize' records out of the extent at 'extentLoc', freeing it once empty.
+        @return true if done with the extent: it has been freed, or on the first batch it was
+                found too full to be worth emptying
+    */
+    static bool compactExtentBatch(Collection *collection, const DiskLoc extentLoc,
+                                   bool firstBatch, double maxFill, int batchSize,
+                                   long long *moved, int *freed) {
+        NamespaceDetails *d = collection->details();
+        Extent *e = extentLoc.ext();
+        e->assertOk();
+
+        if( firstBatch ) {
+            if( extentFill(e) > maxFill )
+                return true;
+            // from here on nothing is allocated in the extent, so what we move can't land here
+            d->orphanDeletedRecordsInExtent(extentLoc);
+        }
+
+        for( int n = 0; n < batchSize && !e->firstRecord.isNull(); n++ ) {
+            DiskLoc loc = e->firstRecord;
+            StatusWith<DiskLoc> newLoc = collection->moveDocument(loc);
+            uassertStatusOK( newLoc.getStatus() );
+            d->orphanDeletedRecord(loc);
+            ++*moved;
+        }
+
+        if( !e->firstRecord.isNull() )
+            return false;
+
+        freeEmptyExtent(d, extentLoc);
+        ++*freed;
+        return true;
+    }
+
+    /** empty out and free the extents of 'ns' that are no more than 'maxFill' full, a batch of
+        records at a time.  the lock is released between batches, like a ClientCursor yield, so
+        other operations on the database carry on meanwhile.  indexes are kept up to date.
+    */
+    bool _compactInBackground(const string& ns, string& errmsg, BSONObjBuilder& result,
+                              double maxFill, int batchSize) {
+        // extents created while we run are where the records go, so only pick existing ones
+        list<DiskLoc> extents;
+        {
+            Lock::DBWrite lk(ns);
+            Client::Context ctx(ns);
+            NamespaceDetails *d = nsdetails(ns);
+            massert( 17300, str::stream() << "namespace " << ns << " does not exist", d );
+            massert( 17301, "cannot compact capped collection", !d->isCapped() );
+            // the last extent is where inserts go, so it stays
+            for( DiskLoc L = d->firstExtent(); L != d->lastExtent(); L = L.ext()->xnext )
+                extents.push_back(L);
+        }
+        log() << "compact " << ns << " background: considering " << extents.size() << " extents" << endl;
+
+        ProgressMeterHolder pm(cc().curop()->setMessage("compact extent",
+                                                        "Background Compaction Progress",
+                                                        extents.size()));
+
+        long long moved = 0;
+        int freed = 0;
+        for( list<DiskLoc>::iterator i = extents.begin(); i != extents.end(); i++ ) {
+            bool done = false;
+            for( bool firstBatch = true; !done; firstBatch = false ) {
+                killCurrentOp.checkForInterrupt();
+
+                Lock::DBWrite lk(ns);
+                Client::Context ctx(ns);
+                Collection *collection = ctx.db()->getCollection(ns);
+                massert( 17302, str::stream() << "namespace " << ns << " dropped during compact",
+                         collection );
+                done = compactExtentBatch(collection, *i, firstBatch, maxFill, batchSize,
+                                          &moved, &freed);
+                getDur().commitIfNeeded();
+            }
+            pm.hit();
+        }
+        pm.finished();
+
+        log() << "compact " << ns << " background: moved " << moved << " documents, freed "
+              << freed << " extents" << endl;
+        result.append("documentsMoved", moved);
+        result.append("extentsFreed", freed);
+        return true;
+    }
+
     bool isCurrentlyAReplSetPrimary();
 
     class CompactCmd : public Command {
@@ -312,8 +431,12 @@ namespace mongo {
             help << "compact collection\n"
                 "warning: this operation blocks the server and is slow. you can cancel with cancelOp()\n"
                 "{ compact : <collection_name>, [force:<bool>], [validate:<bool>],\n"
-                "  [paddingFactor:<num>], [paddingBytes:<num>] }\n"
+                "  [paddingFactor:<num>], [paddingBytes:<num>], [background:<bool>] }\n"
                 "  force - allows to run on a replica set primary\n"
+                "  background - move documents out of sparse extents a batch at a time, yielding in between,\n"
+                "     and free the extents emptied.  doesn't block and may run on a primary.\n"
+                "     [maxFill:<num>] - only empty extents at most this fraction full (default 0.5)\n"
+                "     [batchSize:<num>] - documents moved between yields (default 100)\n"
                 "  validate - check records are noncorrupt before adding to newly compacting extents. slower but safer (defaults to true in this version)\n";
         }
         CompactCmd() : Command("compact") { }
@@ -335,7 +458,9 @@ namespace mongo {
                 return false;
             }
 
-            if( isCurrentlyAReplSetPrimary() && !cmdObj["force"].trueValue() ) { 
+            bool background = cmdObj["background"].trueValue();
+
+            if( !background && isCurrentlyAReplSetPrimary() && !cmdObj["force"].trueValue() ) { 
                 errmsg = "will not run compact on an active replica set primary as this is a slow blocking operation. use force:true to force";
                 return false;
             }
@@ -367,6 +492,37 @@ namespace mongo {
                 }
             }
 
+            if( background ) {
+                double maxFill = 0.5;
+                if( cmdObj.hasElement("maxFill") ) {
+                    maxFill = cmdObj["maxFill"].Number();
+                    if( maxFill <= 0 || maxFill > 1 ) {
+                        errmsg = "maxFill must be greater than 0 and at most 1";
+                        return false;
+                    }
+                }
+                int batchSize = 100;
+                if( cmdObj.hasElement("batchSize") ) {
+                    batchSize = cmdObj["batchSize"].numberInt();
+                    if( batchSize <= 0 ) {
+                        errmsg = "batchSize must be positive";
+                        return false;
+                    }
+                }
+
+                // keeps the collection from being dropped or foreground compacted under us
+                scoped_ptr<BackgroundOperation> bgop;
+                {
+                    Lock::DBWrite lk(ns);
+                    BackgroundOperation::assertNoBgOpInProgForNs(ns.c_str());
+                    bgop.reset(new BackgroundOperation(ns));
+                }
+                log() << "compact " << ns << " background begin" << endl;
+                bool ok = _compactInBackground(ns, errmsg, result, maxFill, batchSize);
+                log() << "compact " << ns << " background end" << endl;
+                return ok;
+            }
+
             double pf = 1.0;
             int pb = 0;
             // useDefaultPadding is used to track whether or not a padding requirement was passed in
@@ -80,8 +80,11 @@ namespace mongo {
         _killPending.store(0);
         killCurrentOp.notifyAllWaiters();
         _numYields = 0;
+        _peakMemoryBytes.store(0);
         _expectedLatencyMs = 0;
         _lockStat.reset();
+        _lockAcquisitions.reset();
+        _lockWaitRecorded = 0;
     }
 
     void CurOp::reset() {
@@ -187,11 +190,14 @@ namespace mongo {
     void CurOp::leave( Client::Context * context ) {
     }
 
-    void CurOp::recordGlobalTime( long long micros ) const {
+    void CurOp::recordGlobalTime( long long micros ) {
         if ( _client ) {
             const LockState& ls = _client->lockState();
             verify( ls.threadState() );
-            Top::global.record( _ns , _op , ls.hasAnyWriteLock() ? 1 : -1 , micros , _command );
+            long long lockWait = _lockStat.getTotalTimeAcquiring() - _lockWaitRecorded;
+            _lockWaitRecorded += lockWait;
+            Top::global.record( _ns , _op , ls.hasAnyWriteLock() ? 1 : -1 , micros , _command ,
+                                lockWait );
         }
     }
 
@@ -248,11 +254,20 @@ namespace mongo {
             b.append("killPending", true);
 
         b.append( "numYields" , _numYields );
+        if ( long long peakMemoryBytes = _peakMemoryBytes.load() )
+            b.appendNumber( "peakMemoryBytes" , peakMemoryBytes );
         b.append( "lockStats" , _lockStat.report() );
+        appendLockAcquisitions( b );
 
         return b.obj();
     }
 
+    void CurOp::appendLockAcquisitions( BSONObjBuilder& b ) const {
+        BSONArrayBuilder a( b.subarrayStart( "lockAcquisitions" ) );
+        _lockAcquisitions.append( a );
+        a.done();
+    }
+
     BSONObj CurOp::description() {
         BSONObjBuilder bob;
         bool a = _active && _start;
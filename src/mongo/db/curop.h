@@ -101,6 +101,8 @@ namespace mongo {
         bool fastmodinsert;  // upsert of an $operation. builds a default object
         bool upsert;         // true if the update actually did an insert
         int keyUpdates;
+        long long flowControlMicros; // time waited for a flow control ticket
+        BSONObj execStats;   // per-stage stats of the query plan, if it ran in the new framework
 
         // error handling
         ExceptionInfo exceptionInfo;
@@ -289,16 +291,26 @@ namespace mongo {
         bool killPending() const { return _killPending.loadRelaxed(); }
         void yielded() { _numYields++; }
         int numYields() const { return _numYields; }
+
+        /**
+         * The most memory one stage of an aggregation run by this op has held at once, for
+         * currentOp. Kept up to date by the aggregation as it runs.
+         */
+        AtomicInt64& peakMemoryBytes() { return _peakMemoryBytes; }
         void suppressFromCurop() { _suppressFromCurop = true; }
         
         long long getExpectedLatencyMs() const { return _expectedLatencyMs; }
         void setExpectedLatencyMs( long long latency ) { _expectedLatencyMs = latency; }
 
-        void recordGlobalTime( long long micros ) const;
+        void recordGlobalTime( long long micros );
         
         const LockStat& lockStat() const { return _lockStat; }
         LockStat& lockStat() { return _lockStat; }
 
+        LockAcquisitions& lockAcquisitions() { return _lockAcquisitions; }
+        /** appends the locks this op acquired, as lockAcquisitions */
+        void appendLockAcquisitions( BSONObjBuilder& b ) const;
+
         void setKillWaiterFlags();
 
         /**
@@ -332,7 +344,10 @@ namespace mongo {
         ProgressMeter _progressMeter;
         AtomicInt32 _killPending;
         int _numYields;
+        AtomicInt64 _peakMemoryBytes;
         LockStat _lockStat;
+        LockAcquisitions _lockAcquisitions;
+        long long _lockWaitRecorded;     // of _lockStat's acquiring time, how much Top has seen
         // _notifyList is protected by the global killCurrentOp's mtx.
         std::vector<bool*> _notifyList;
         
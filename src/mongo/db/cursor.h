@@ -227,6 +227,12 @@ namespace mongo {
 
         /// Should this cursor be destroyed when it's namespace is deleted
         virtual bool shouldDestroyOnNSDeletion() { return true; }
+
+        /**
+         * If nonzero, getmore leaves a document for the next batch rather than go over this many
+         * bytes of reply, unless it's the first in the batch.
+         */
+        virtual int batchBytesTarget() const { return 0; }
     };
 
     // strategy object implementing direction of traversal.
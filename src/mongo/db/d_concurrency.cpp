@@ -36,15 +36,20 @@
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/d_globals.h"
+#include "mongo/db/database.h"
+#include "mongo/db/database_holder.h"
 #include "mongo/db/dur.h"
 #include "mongo/db/lockstat.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/server.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/concurrency/mapsf.h"
+#include "mongo/util/concurrency/priority_gate.h"
 #include "mongo/util/concurrency/qlock.h"
 #include "mongo/util/concurrency/rwlock.h"
 #include "mongo/util/concurrency/threadlocal.h"
+#include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/util/stacktrace.h"
 
 // oplog locking
@@ -65,6 +70,17 @@ namespace mongo {
 
     static const bool DB_LEVEL_LOCKING_ENABLED = ( ( MONGOD_CONCURRENCY_LEVEL ) >= MONGOD_CONCURRENCY_LEVEL_DB );
 
+    // lets writers of different collections of a database run at once, see Lock::CollectionWrite
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(collectionLevelLocking, bool, false);
+
+    // see Lock::Priority.  with lockAdmissionPriorities off every acquisition queues as equals
+    MONGO_EXPORT_SERVER_PARAMETER(lockAdmissionPriorities, bool, true);
+    MONGO_EXPORT_SERVER_PARAMETER(lockAdmissionMaxWaitMillis, int, 100);
+    // whether new operations hold off while the replication batch writer waits to start a batch
+    MONGO_EXPORT_SERVER_PARAMETER(parallelBatchWriterPriority, bool, true);
+    // whether a replication batch only blocks the threads locking the databases it writes
+    MONGO_EXPORT_SERVER_PARAMETER(batchScopedReads, bool, false);
+
     inline LockState& lockState() { 
         return cc().lockState();
     }
@@ -73,6 +89,25 @@ namespace mongo {
         return lockState().threadState();
     }
 
+    /** brackets acquiring a lock, queueing by admission class at its gate */
+    class Admission : boost::noncopyable {
+    public:
+        explicit Admission( PriorityGate& gate, bool enabled = true ) : _gate(0), _cls(0) {
+            if( !enabled || !lockAdmissionPriorities )
+                return;
+            _cls = lockState().admissionPriority();
+            _gate = &gate;
+            _gate->arrive( _cls, lockAdmissionMaxWaitMillis );
+        }
+        ~Admission() {
+            if( _gate )
+                _gate->leave( _cls );
+        }
+    private:
+        PriorityGate* _gate;
+        int _cls;
+    };
+
     class DBTryLockTimeoutException : public std::exception {
     public:
         DBTryLockTimeoutException() {}
@@ -100,6 +135,9 @@ namespace mongo {
     typedef mapsf< StringMap<WrapperForRWLock*> > DBLocksMap;
     static DBLocksMap dblocks;
 
+    /* ns->lock, for collection level locking.  like dblocks these are never deleted. */
+    static DBLocksMap collectionLocks;
+
     /* we don't want to touch dblocks too much as a mutex is involved.  thus party for that, 
        this is here...
     */
@@ -119,12 +157,14 @@ namespace mongo {
 
     class WrapperForQLock { 
         QLock q;
+        PriorityGate gate;
     public:
         LockStat stats;
 
         void lock_r() { 
             verify( threadState() == 0 );
             lockState().lockedStart( 'r' );
+            Admission a(gate);
             q.lock_r(); 
         }
         
@@ -132,6 +172,7 @@ namespace mongo {
             verify( threadState() == 0 );
             getDur().commitIfNeeded();
             lockState().lockedStart( 'w' );
+            Admission a(gate);
             q.lock_w(); 
         }
         
@@ -139,6 +180,7 @@ namespace mongo {
             LockState& ls = lockState();
             massert(16103, str::stream() << "can't lock_R, threadState=" << (int) ls.threadState(), ls.threadState() == 0);
             ls.lockedStart( 'R' );
+            Admission a(gate);
             q.lock_R(); 
         }
 
@@ -151,6 +193,7 @@ namespace mongo {
             getDur().commitIfNeeded(); // check before locking - will use an R lock for the commit if need to do one, which is better than W
             ls.lockedStart( 'W' );
             {
+                Admission a(gate);
                 q.lock_W();
             }
             locked_W();
@@ -275,31 +318,237 @@ namespace mongo {
     bool Lock::dbLevelLockingEnabled() {
         return DB_LEVEL_LOCKING_ENABLED;
     }
+    bool Lock::collectionLockingEnabled() {
+        return DB_LEVEL_LOCKING_ENABLED && collectionLevelLocking;
+    }
+    bool Lock::isIntentWriteLocked(const StringData& db) {
+        LockState &ls = lockState();
+        return ls.threadState() == 'w' && ls.otherIsIntent() && db == ls.otherName();
+    }
+
+    Lock::Priority Lock::threadPriority() {
+        return lockState().admissionPriority();
+    }
+    void Lock::setThreadPriority( Priority p ) {
+        lockState().setAdmissionPriority( p );
+    }
+
+    Lock::ScopedPriority::ScopedPriority( Priority p ) : _old( threadPriority() ) {
+        setThreadPriority( p );
+    }
+    Lock::ScopedPriority::~ScopedPriority() {
+        setThreadPriority( _old );
+    }
 
     RWLockRecursive &Lock::ParallelBatchWriterMode::_batchLock = *(new RWLockRecursive("special"));
+    static PriorityGate& batchGate = *(new PriorityGate());
+
+    /** which databases the running batch writes, and the threads that went ahead without
+        _batchLock because theirs isn't one of them.  a batch publishes its databases, waits for
+        the threads already in any of them to leave, and only then takes _batchLock; so a thread
+        inside a database outside the batch that goes on to lock one in it gets _batchLock
+        before the batch does, or waits for a batch that doesn't wait for it.
+    */
+    class BatchScope : boost::noncopyable {
+    public:
+        BatchScope() : _blockAll(false), _outside(0) { }
+
+        /** @return true if db may be used without _batchLock, until leave( db ) */
+        bool enter( const string& db ) {
+            boost::mutex::scoped_lock lk(_m);
+            if ( _blockAll || _dbs.count( db ) )
+                return false;
+            ++_inside[db];
+            ++_outside;
+            return true;
+        }
+        void leave( const string& db ) {
+            boost::mutex::scoped_lock lk(_m);
+            map<string,int>::iterator i = _inside.find( db );
+            verify( i != _inside.end() );
+            if ( --i->second == 0 )
+                _inside.erase( i );
+            --_outside;
+            _c.notify_all();
+        }
+
+        /** a batch writing dbs, or every database if dbs is null, is about to start */
+        void batchStarting( const set<string>* dbs ) {
+            boost::mutex::scoped_lock lk(_m);
+            if ( dbs )
+                _dbs = *dbs;
+            else
+                _blockAll = true;
+            while ( _outside && ( _blockAll || anyInside( _dbs ) ) )
+                _c.wait( lk );
+        }
+        void batchDone() {
+            boost::mutex::scoped_lock lk(_m);
+            _dbs.clear();
+            _blockAll = false;
+        }
+
+    private:
+        bool anyInside( const set<string>& dbs ) const {
+            for ( set<string>::const_iterator i = dbs.begin(); i != dbs.end(); ++i )
+                if ( _inside.count( *i ) )
+                    return true;
+            return false;
+        }
+
+        boost::mutex _m;
+        boost::condition _c;
+        set<string> _dbs;
+        bool _blockAll;
+        map<string,int> _inside; // threads per database in use without _batchLock
+        int _outside;            // their total
+    };
+    static BatchScope& batchScope = *(new BatchScope());
+
+    Lock::ParallelBatchWriterMode::ParallelBatchWriterMode() {
+        Admission a( batchGate, parallelBatchWriterPriority );
+        batchScope.batchStarting( 0 );
+        _lk.reset( new RWLockRecursive::Exclusive(_batchLock) );
+    }
+    Lock::ParallelBatchWriterMode::ParallelBatchWriterMode( const std::set<std::string>& dbs ) {
+        Admission a( batchGate, parallelBatchWriterPriority );
+        // with global locking every write excludes every reader anyway
+        batchScope.batchStarting( DB_LEVEL_LOCKING_ENABLED ? &dbs : 0 );
+        _lk.reset( new RWLockRecursive::Exclusive(_batchLock) );
+    }
+    Lock::ParallelBatchWriterMode::~ParallelBatchWriterMode() {
+        // until _lk goes, threads of the batch's databases must keep queueing on it
+        _lk.reset( 0 );
+        batchScope.batchDone();
+    }
     void Lock::ParallelBatchWriterMode::iAmABatchParticipant() {
         lockState()._batchWriter = true;
     }
 
-    Lock::ParallelBatchWriterSupport::ParallelBatchWriterSupport() {
+    Lock::ParallelBatchWriterSupport::ParallelBatchWriterSupport( const StringData& db )
+        : _db( db.toString() ), _outsideBatch( false ) {
         relock();
     }
 
+    Lock::ParallelBatchWriterSupport::~ParallelBatchWriterSupport() {
+        tempRelease();
+    }
+
     void Lock::ParallelBatchWriterSupport::tempRelease() {
         _lk.reset( 0 );
+        if ( _outsideBatch ) {
+            batchScope.leave( _db );
+            _outsideBatch = false;
+        }
     }
 
     void Lock::ParallelBatchWriterSupport::relock() {
         LockState& ls = lockState();
         if ( ! ls._batchWriter ) {
+            if ( batchScopedReads && !_db.empty() && batchScope.enter( _db ) ) {
+                _outsideBatch = true;
+                return;
+            }
             AcquiringParallelWriter a(ls);
+            // only the outermost lock queues, nested ones already hold what they'd wait for
+            Admission admission( batchGate, ls.threadState() == 0 );
             _lk.reset( new RWLockRecursive::Shared(ParallelBatchWriterMode::_batchLock) );
         }
     }
 
 
+    TicketHolder& Lock::readTickets() {
+        static TicketHolder& tickets = *new TicketHolder(128);
+        return tickets;
+    }
+    TicketHolder& Lock::writeTickets() {
+        static TicketHolder& tickets = *new TicketHolder(128);
+        return tickets;
+    }
+
+    Lock::TicketSupport::TicketSupport( char type ) : _type(type), _holder(0) {
+        relock();
+    }
+
+    Lock::TicketSupport::~TicketSupport() {
+        tempRelease();
+    }
+
+    void Lock::TicketSupport::tempRelease() {
+        if ( _holder ) {
+            _holder->release();
+            _holder = 0;
+        }
+    }
+
+    void Lock::TicketSupport::relock() {
+        // internal threads, and nested locks, never queue: what they'd wait on may be waiting
+        // on them
+        LockState& ls = lockState();
+        if ( ls.threadState() != 0 || ls._batchWriter ||
+             ls.admissionPriority() == Lock::priorityCritical || !cc().port() )
+            return;
+
+        TicketHolder& tickets = ( _type == 'w' || _type == 'W' ) ? Lock::writeTickets()
+                                                                 : Lock::readTickets();
+        tickets.waitForTicket();
+        _holder = &tickets;
+    }
+
+    /** resizes a ticket pool, for concurrentReadOps and concurrentWriteOps */
+    class TicketsParameter : public ServerParameter {
+    public:
+        TicketsParameter( const std::string& name, TicketHolder& tickets )
+            : ServerParameter( ServerParameterSet::getGlobal(), name, true, true ),
+              _tickets( tickets ) {
+        }
+
+        virtual void append( BSONObjBuilder& b, const std::string& name ) {
+            b.append( name, _tickets.outof() );
+        }
+
+        virtual Status set( const BSONElement& newValueElement ) {
+            int newSize;
+            if ( !newValueElement.coerce( &newSize ) )
+                return Status( ErrorCodes::BadValue, str::stream() << "invalid value for "
+                               << name() << ": " << newValueElement );
+            return _set( newSize );
+        }
+
+        virtual Status setFromString( const std::string& str ) {
+            int newSize;
+            Status status = parseNumberFromString( str, &newSize );
+            if ( !status.isOK() )
+                return status;
+            return _set( newSize );
+        }
+
+    private:
+        Status _set( int newSize ) {
+            if ( newSize < 1 )
+                return Status( ErrorCodes::BadValue, str::stream() << name()
+                               << " must be at least 1" );
+            if ( !_tickets.resize( newSize ) )
+                return Status( ErrorCodes::BadValue, str::stream() << "can't set " << name()
+                               << " below the " << _tickets.used() << " tickets in use" );
+            return Status::OK();
+        }
+
+        TicketHolder& _tickets;
+    };
+
+    static TicketsParameter concurrentReadOps( "concurrentReadOps",
+                                               Lock::readTickets() );
+    static TicketsParameter concurrentWriteOps( "concurrentWriteOps",
+                                                Lock::writeTickets() );
+
     Lock::ScopedLock::ScopedLock( char type ) 
-        : _type(type), _stat(0) {
+        : _ticket(type), _pbws_lk(""), _type(type), _stat(0) {
+        LockState& ls = lockState();
+        ls.enterScopedLock( this );
+    }
+    Lock::ScopedLock::ScopedLock( char type, const StringData& ns )
+        : _ticket(type), _pbws_lk(nsToDatabaseSubstring(ns)), _type(type), _stat(0) {
         LockState& ls = lockState();
         ls.enterScopedLock( this );
     }
@@ -314,7 +563,10 @@ namespace mongo {
         long long acquisitionTime = _timer.micros();
         _timer.reset();
         _stat = stat;
-        cc().curop()->lockStat().recordAcquireTimeMicros( _type , acquisitionTime );
+        CurOp* curop = cc().curop();
+        curop->lockStat().recordAcquireTimeMicros( _type , acquisitionTime );
+        curop->lockAcquisitions().record( _type , lockState().getRelevantResource() ,
+                                          acquisitionTime );
         return acquisitionTime;
     }
 
@@ -322,6 +574,7 @@ namespace mongo {
         long long micros = _timer.micros();
         _tempRelease();
         _pbws_lk.tempRelease();
+        _ticket.tempRelease();
         _recordTime( micros ); // might as well do after we unlock
     }
 
@@ -340,6 +593,7 @@ namespace mongo {
     }
     
     void Lock::ScopedLock::relock() {
+        _ticket.relock();
         _pbws_lk.relock();
         _relock();
         resetTime();
@@ -505,6 +759,7 @@ namespace mongo {
             fassert(16132,_weLocked==0);
             ls.lockedNestable(db, 1);
             _weLocked = nestableLocks[db];
+            Admission a( _weLocked->gate, ls.otherCount() == 0 );
             _weLocked->lock();
         }
     }
@@ -518,6 +773,7 @@ namespace mongo {
             ls.lockedNestable(db,-1);
             fassert(16133,_weLocked==0);
             _weLocked = nestableLocks[db];
+            Admission a( _weLocked->gate, ls.otherCount() == 0 );
             _weLocked->lock_shared();
         }
     }
@@ -531,6 +787,9 @@ namespace mongo {
             // nested. if/when we do temprelease with DBWrite we will need to increment here
             // (so we can not release or assert if nested).
             massert(16106, str::stream() << "internal error tried to lock two databases at the same time. old:" << ls.otherName() << " new:" << db , db == ls.otherName() );
+            massert(17342, str::stream() << "can't lock " << _what << " for writing while only "
+                           << ls.collectionName() << " is locked",
+                    !ls.otherIsIntent() );
             return;
         }
 
@@ -551,7 +810,10 @@ namespace mongo {
         }
         
         fassert(16134,_weLocked==0);
-        ls.otherLock()->lock();
+        {
+            Admission a( ls.otherLock()->gate );
+            ls.otherLock()->lock();
+        }
         _weLocked = ls.otherLock();
     }
 
@@ -571,6 +833,7 @@ namespace mongo {
         _locked_W=false;
         _locked_w=false; 
         _weLocked=0;
+        _collectionLocked=0;
 
 
         massert( 16186 , "can't get a DBWrite while having a read lock" , ! ls.hasAnyReadLock() );
@@ -586,8 +849,11 @@ namespace mongo {
                 _locked_W = true;
                 return;
             } 
-            if( !nested )
+            if( !nested ) {
+                if( lockCollection(ls, ns) )
+                    return;
                 lockOther(db);
+            }
             lockTop(ls);
             if( nested )
                 lockNestable(nested);
@@ -598,6 +864,69 @@ namespace mongo {
         }
     }
 
+    bool Lock::DBWrite::lockCollection(LockState& ls, const string& ns) {
+        if( !_collectionOnly || !collectionLockingEnabled() )
+            return false;
+
+        NamespaceString nss( ns );
+        if( !nss.isValid() || nss.isSystem() || nss.isConfigDB() || nss.isSpecial() )
+            return false;
+
+        if( ls.otherCount() ) {
+            // nested within a lock of this collection is fine, anything else is for lockOther
+            // to sort out
+            return ls.otherIsIntent() && ls.collectionName() == ns;
+        }
+        if( ls.nestableCount() )
+            return false; // lockOther will assert
+
+        StringData db = nss.db();
+        WrapperForRWLock* dbLock;
+        {
+            DBLocksMap::ref r(dblocks);
+            WrapperForRWLock*& lock = r[db];
+            if( lock == 0 )
+                lock = new WrapperForRWLock(db);
+            dbLock = lock;
+        }
+        WrapperForRWLock* collectionLock;
+        {
+            DBLocksMap::ref r(collectionLocks);
+            WrapperForRWLock*& lock = r[ns];
+            if( lock == 0 )
+                lock = new WrapperForRWLock(ns);
+            collectionLock = lock;
+        }
+
+        fassert(17345, _weLocked == 0);
+        {
+            Admission a( dbLock->gate );
+            dbLock->lock_intent();
+        }
+        ls.lockedOther( db , 1 , dbLock );
+        collectionLock->lock();
+        ls.lockedCollection( ns , collectionLock );
+        lockTop(ls);
+
+        // creating a collection, or opening its database, changes database wide structures
+        Database* database = dbHolder().get( ns , storageGlobalParams.dbpath );
+        if( database && database->namespaceIndex().details( ns ) ) {
+            _weLocked = dbLock;
+            _collectionLocked = collectionLock;
+            return true;
+        }
+
+        if( _locked_w ) {
+            qlk.unlock_w();
+            _locked_w = false;
+        }
+        ls.unlockedCollection();
+        collectionLock->unlock();
+        ls.unlockedOther();
+        dbLock->unlock_intent();
+        return false;
+    }
+
     void Lock::DBRead::lockDB(const string& ns) {
         fassert( 16254, !ns.empty() );
         LockState& ls = lockState();
@@ -610,6 +939,9 @@ namespace mongo {
             return;
         if (DB_LEVEL_LOCKING_ENABLED) {
             StringData db = nsToDatabaseSubstring(ns);
+            massert( 17344, str::stream() << "can't lock " << ns << " for reading while only "
+                            << ls.collectionName() << " is locked",
+                     !ls.otherIsIntent() || db != ls.otherName() || ls.isLocked(ns) );
             Nestable nested = n(db);
             if( !nested )
                 lockOther(db);
@@ -624,12 +956,19 @@ namespace mongo {
     }
 
     Lock::DBWrite::DBWrite( const StringData& ns )
-        : ScopedLock( 'w' ), _what(ns.toString()), _nested(false) {
+        : ScopedLock( 'w', ns ), _collectionLocked(0), _what(ns.toString()), _nested(false),
+          _collectionOnly(false) {
+        lockDB( _what );
+    }
+
+    Lock::DBWrite::DBWrite( const StringData& ns, bool collectionOnly )
+        : ScopedLock( 'w', ns ), _collectionLocked(0), _what(ns.toString()), _nested(false),
+          _collectionOnly(collectionOnly) {
         lockDB( _what );
     }
 
     Lock::DBRead::DBRead( const StringData& ns )
-        : ScopedLock( 'r' ), _what(ns.toString()), _nested(false) {
+        : ScopedLock( 'r', ns ), _what(ns.toString()), _nested(false) {
         lockDB( _what );
     }
 
@@ -641,7 +980,15 @@ namespace mongo {
     }
 
     void Lock::DBWrite::unlockDB() {
-        if( _weLocked ) {
+        if( _collectionLocked ) {
+            recordTime();  // for lock stats
+
+            lockState().unlockedCollection();
+            _collectionLocked->unlock();
+            lockState().unlockedOther();
+            _weLocked->unlock_intent();
+        }
+        else if( _weLocked ) {
             recordTime();  // for lock stats
         
             if ( _nested )
@@ -663,6 +1010,7 @@ namespace mongo {
             qlk.unlock_W();
         }
         _weLocked = 0;
+        _collectionLocked = 0;
         _locked_W = _locked_w = false;
     }
     void Lock::DBRead::unlockDB() {
@@ -740,7 +1088,10 @@ namespace mongo {
             ls.lockedOther(-1);
         }
         fassert(16135,_weLocked==0);
-        ls.otherLock()->lock_shared();
+        {
+            Admission a( ls.otherLock()->gate );
+            ls.otherLock()->lock_shared();
+        }
         _weLocked = ls.otherLock();
     }
 
@@ -876,4 +1227,46 @@ namespace mongo {
 
     } lockStatsServerStatusSection;
 
+    class TicketsServerStatusSection : public ServerStatusSection {
+    public:
+        TicketsServerStatusSection() : ServerStatusSection( "opTickets" ){}
+        virtual bool includeByDefault() const { return true; }
+
+        virtual BSONObj generateSection( const BSONElement& configElement ) const {
+            BSONObjBuilder b;
+            append( b, "read", Lock::readTickets() );
+            append( b, "write", Lock::writeTickets() );
+            return b.obj();
+        }
+
+    private:
+        static void append( BSONObjBuilder& b, const char* name, const TicketHolder& tickets ) {
+            BSONObjBuilder t( b.subobjStart( name ) );
+            t.append( "out", tickets.used() );
+            t.append( "available", tickets.available() );
+            t.append( "totalTickets", tickets.outof() );
+            t.append( "waiting", tickets.waiting() );
+            t.done();
+        }
+
+    } ticketsServerStatusSection;
+
+    /** the collections written under collection level locking.  not included by default, there
+        may be many. */
+    class CollectionLockStatsServerStatusSection : public ServerStatusSection {
+    public:
+        CollectionLockStatsServerStatusSection() : ServerStatusSection( "collectionLocks" ){}
+        virtual bool includeByDefault() const { return false; }
+
+        BSONObj generateSection( const BSONElement& configElement ) const {
+            BSONObjBuilder b;
+            DBLocksMap::ref r(collectionLocks);
+            for( DBLocksMap::const_iterator i = r.r.begin(); i != r.r.end(); ++i ) {
+                b.append(i->first, i->second->stats.report());
+            }
+            return b.obj();
+        }
+
+    } collectionLockStatsServerStatusSection;
+
 }
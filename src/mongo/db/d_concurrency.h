@@ -44,6 +44,7 @@ namespace mongo {
 
     class WrapperForRWLock;
     class LockState;
+    class TicketHolder;
 
     class Lock : boost::noncopyable { 
     public:
@@ -61,10 +62,40 @@ namespace mongo {
         static void assertWriteLocked(const StringData& ns);
 
         static bool dbLevelLockingEnabled(); 
+
+        /** true with --setParameter collectionLevelLocking=true, see CollectionWrite */
+        static bool collectionLockingEnabled();
+        /** true if we hold db intent exclusive, with one of its collections write locked */
+        static bool isIntentWriteLocked(const StringData& db);
         
         static LockStat* globalLockStat();
         static LockStat* nestableLockStat( Nestable db );
 
+        /** the tickets user operations take to read or write, see TicketSupport */
+        static TicketHolder& readTickets();
+        static TicketHolder& writeTickets();
+
+        /** admission classes of lock acquisitions.  while a thread of a class is waiting for a
+            lock, threads of lower classes hold off from queueing on it, for up to
+            lockAdmissionMaxWaitMillis.  user operations are priorityUser; maintenance work
+            (ttl, range deletes) is priorityBackground; replication application and
+            heartbeats are priorityCritical, which never holds off.
+        */
+        enum Priority { priorityBackground=0, priorityUser, priorityCritical };
+
+        /** the admission class of this thread's lock acquisitions */
+        static Priority threadPriority();
+        static void setThreadPriority( Priority p );
+
+        /** sets this thread's admission class for the scope */
+        class ScopedPriority : boost::noncopyable {
+        public:
+            explicit ScopedPriority( Priority p );
+            ~ScopedPriority();
+        private:
+            const Priority _old;
+        };
+
         class ScopedLock;
 
         // note: avoid TempRelease when possible. not a good thing.
@@ -79,11 +110,17 @@ namespace mongo {
             by default. note only one thread creates a ParallelBatchWriterMode object; the rest just
             call iAmABatchParticipant().  Note that this lock is not released on a temprelease, just
             the normal lock things below.
+
+            given the databases the batch writes, and with --setParameter batchScopedReads=true,
+            only threads locking one of them, or locking globally, block.  the others get on with
+            a database no write of the batch changes.
             */
         class ParallelBatchWriterMode : boost::noncopyable {
-            RWLockRecursive::Exclusive _lk;
+            scoped_ptr<RWLockRecursive::Exclusive> _lk;
         public:
-            ParallelBatchWriterMode() : _lk(_batchLock) {}
+            ParallelBatchWriterMode();
+            explicit ParallelBatchWriterMode( const std::set<std::string>& dbs );
+            ~ParallelBatchWriterMode();
             static void iAmABatchParticipant();
             static RWLockRecursive &_batchLock;
         };
@@ -91,13 +128,35 @@ namespace mongo {
     private:
         class ParallelBatchWriterSupport : boost::noncopyable {
         public:
-            ParallelBatchWriterSupport();
+            explicit ParallelBatchWriterSupport( const StringData& db );
+            ~ParallelBatchWriterSupport();
 
         private:
             void tempRelease();
             void relock();
 
             scoped_ptr<RWLockRecursive::Shared> _lk;
+            const std::string _db; // empty for global locks, which every batch blocks
+            bool _outsideBatch;    // true if we went ahead without _lk, see batchScopedReads
+            friend class ScopedLock;
+        };
+
+        /** user operations hold a read or write ticket while they hold locks, which limits how
+            many run in the storage layer at once (concurrentReadOps, concurrentWriteOps).
+            excess ones queue for a ticket before touching any lock.  only the outermost lock
+            takes one, and gives it up over a temprelease.
+            */
+        class TicketSupport : boost::noncopyable {
+        public:
+            explicit TicketSupport( char type );
+            ~TicketSupport();
+
+        private:
+            void tempRelease();
+            void relock();
+
+            const char _type;
+            TicketHolder* _holder; // the pool we hold a ticket of, if we do
             friend class ScopedLock;
         };
 
@@ -109,6 +168,8 @@ namespace mongo {
             /** @return micros since we started acquiring */
             long long acquireFinished( LockStat* stat );
 
+            char type() const { return _type; }
+
             // Accrue elapsed lock time since last we called reset
             void recordTime();
             // Start recording a new period, starting now()
@@ -116,6 +177,7 @@ namespace mongo {
 
         protected:
             explicit ScopedLock( char type ); 
+            ScopedLock( char type, const StringData& ns ); // a lock of ns's database only
 
         private:
             friend struct TempRelease;
@@ -127,6 +189,7 @@ namespace mongo {
             virtual void _relock() = 0;
 
         private:
+            TicketSupport _ticket;           // before _pbws_lk: taken first, released last
             ParallelBatchWriterSupport _pbws_lk;
 
             void _recordTime( long long micros );
@@ -176,6 +239,7 @@ namespace mongo {
             void lockTop(LockState&);
             void lockNestable(Nestable db);
             void lockOther(const StringData& db);
+            bool lockCollection(LockState&, const string& ns);
             void lockDB(const string& ns);
             void unlockDB();
 
@@ -183,6 +247,9 @@ namespace mongo {
             void _tempRelease();
             void _relock();
 
+            /** for CollectionWrite */
+            DBWrite(const StringData& ns, bool collectionOnly);
+
         public:
             DBWrite(const StringData& dbOrNs);
             virtual ~DBWrite();
@@ -197,12 +264,32 @@ namespace mongo {
                 bool _gotUpgrade;
             };
 
-        private:
+        protected:
             bool _locked_w;
             bool _locked_W;
             WrapperForRWLock *_weLocked;
+            WrapperForRWLock *_collectionLocked; // set if the db is only intent locked
             const string _what;
             bool _nested;
+            const bool _collectionOnly;
+        };
+
+        /** lock one collection for writing, where collection level locking is enabled.  its 
+            database is then locked intent exclusive, so writers of its other collections may 
+            run alongside, and the collection exclusive.
+
+            writes that change database wide structures need the database exclusive, so this 
+            is no more than a DBWrite for collections or databases that don't exist yet, system 
+            collections, and the local, admin and config databases.  extent allocation, the one 
+            database wide structure ordinary writes change, is serialized by the ExtentManager.
+            nesting a lock on another namespace of the database inside this one asserts.
+        */
+        class CollectionWrite : public DBWrite {
+        public:
+            CollectionWrite(const StringData& ns) : DBWrite(ns, true) { }
+
+            /** @return true if only the collection, rather than its whole db, is locked */
+            bool collectionOnly() const { return _collectionLocked != 0; }
         };
 
         // lock this database for reading. do not shared_lock globally first, that is handledin herein. 
@@ -40,12 +40,15 @@
 #include "mongo/db/background.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/database_holder.h"
+#include "mongo/db/storage/in_memory_files.h"
 #include "mongo/db/storage/index_details.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/introspect.h"
 #include "mongo/db/pdfile.h"
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/ops/delete.h"
+#include "mongo/db/stats/index_usage.h"
+#include "mongo/db/stats/residency.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/db/structure/collection.h"
 
@@ -103,8 +106,9 @@ namespace mongo {
 
     Database::Database(const char *nm, bool& newDb, const string& path )
         : _name(nm), _path(path),
-          _namespaceIndex( _path, _name ),
-          _extentManager(_name, _path, 0, storageGlobalParams.directoryperdb),
+          _namespaceIndex( _path, _name, isInMemoryDatabase( _name ) ),
+          _extentManager(_name, _path, 0, storageGlobalParams.directoryperdb,
+                         isInMemoryDatabase( _name ) ),
           _profileName(_name + ".system.profile"),
           _namespacesName(_name + ".system.namespaces"),
           _indexesName(_name + ".system.indexes"),
@@ -317,6 +321,8 @@ namespace mongo {
 
         ClientCursor::invalidate( fullns );
         Top::global.collectionDropped( fullns );
+        IndexUsageTracker::global.collectionDropped( fullns );
+        ResidencyTracker::global.collectionDropped( fullns );
 
         Status s = _dropNS( fullns );
 
@@ -447,6 +453,8 @@ namespace mongo {
         }
 
         Top::global.collectionDropped( fromNS.toString() );
+        IndexUsageTracker::global.collectionDropped( fromNS );
+        ResidencyTracker::global.collectionDropped( fromNS );
 
         return Status::OK();
     }
@@ -35,6 +35,7 @@
 #include "mongo/db/client.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/database_holder.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
@@ -69,6 +70,16 @@ namespace mongo {
         // once we start creating a new database
         cc().writeHappened();
 
+        string lower( dbname );
+        std::transform( lower.begin(), lower.end(), lower.begin(), ::tolower );
+        {
+            boost::unique_lock<boost::mutex> lk( _openingMutex );
+            while ( _opening.count( lower ) )
+                _openingDone.wait( lk );
+            _opening.insert( lower );
+        }
+        ON_BLOCK_EXIT( &DatabaseHolder::_doneOpening, this, lower );
+
         // this locks _m for defensive checks, so we don't want to be locked right here :
         Database *db = new Database( dbname.c_str() , justCreated , path );
 
@@ -85,6 +96,12 @@ namespace mongo {
         return db;
     }
 
+    void DatabaseHolder::_doneOpening( const string& lower ) {
+        boost::unique_lock<boost::mutex> lk( _openingMutex );
+        _opening.erase( lower );
+        _openingDone.notify_all();
+    }
+
     bool DatabaseHolder::closeAll( const string& path , BSONObjBuilder& result , bool force ) {
         log() << "DatabaseHolder::closeAll path:" << path << endl;
         verify( Lock::isW() );
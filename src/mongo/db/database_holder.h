@@ -30,6 +30,9 @@
 
 #pragma once
 
+#include <boost/thread/condition.hpp>
+#include <boost/thread/mutex.hpp>
+
 #include "mongo/db/database.h"
 #include "mongo/db/namespace_string.h"
 
@@ -45,6 +48,13 @@ namespace mongo {
         mutable SimpleMutex _m;
         Paths _paths;
         int _size;
+
+        // A database is opened under its own write lock, but names differing only in case take
+        // different locks and must not both open.  The lowercased names being opened, so that
+        // such opens wait on each other rather than all opens on the global write lock.
+        boost::mutex _openingMutex;
+        boost::condition _openingDone;
+        set<string> _opening;
     public:
         DatabaseHolder() : _m("dbholder"),_size(0) { }
 
@@ -111,6 +121,8 @@ namespace mongo {
         }
 
     private:
+        void _doneOpening( const string& lower );
+
         static string _todb( const string& ns ) {
             string d = __todb( ns );
             uassert( 13280 , (string)"invalid db name: " + ns , NamespaceString::validDBName( d ) );
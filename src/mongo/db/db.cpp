@@ -40,6 +40,7 @@
 #include "mongo/db/auth/authz_manager_external_state_d.h"
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/authorization_manager_global.h"
+#include "mongo/db/btree_defrag.h"
 #include "mongo/db/client.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/commands/server_status.h"
@@ -61,6 +62,7 @@
 #include "mongo/db/pdfile.h"
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/range_deleter_service.h"
+#include "mongo/db/record_scrubber.h"
 #include "mongo/db/repl/repl_start.h"
 #include "mongo/db/repl/replication_server_status.h"
 #include "mongo/db/repl/rs.h"
@@ -71,6 +73,7 @@
 #include "mongo/db/storage_options.h"
 #include "mongo/db/ttl.h"
 #include "mongo/platform/process_id.h"
+#include "mongo/s/d_logic.h"
 #include "mongo/s/d_writeback.h"
 #include "mongo/scripting/engine.h"
 #include "mongo/util/background.h"
@@ -179,6 +182,35 @@ namespace mongo {
         sleepmicros( Client::recommendedYieldMicros() );
     }
 
+    /** a connection's Client and sharding info, carried between the threads that serve it */
+    class ClientThreadState : public ConnectionThreadState {
+    public:
+        ClientThreadState() :
+            _client( currentClient.release() ),
+            _sharding( ShardedConnectionInfo::release() ) {
+        }
+
+        virtual ~ClientThreadState() {
+            delete _sharding;
+            delete _client;
+        }
+
+        virtual void attach() {
+            verify( currentClient.get() == 0 );
+            currentClient.reset( _client );
+            ShardedConnectionInfo::attach( _sharding );
+        }
+
+        virtual void detach() {
+            _client = currentClient.release();
+            _sharding = ShardedConnectionInfo::release();
+        }
+
+    private:
+        Client* _client;
+        ShardedConnectionInfo* _sharding;
+    };
+
     class MyMessageHandler : public MessageHandler {
     public:
         virtual void connected( AbstractMessagingPort* p ) {
@@ -204,19 +236,23 @@ namespace mongo {
                 }
 
                 if ( dbresponse.response ) {
-                    port->reply(m, *dbresponse.response, dbresponse.responseTo);
+                    // the port may keep the reply's buffers, so read what exhaust needs first
+                    long long cursorid = 0;
+                    if( dbresponse.exhaustNS.size() > 0 ) {
+                        QueryResult *qr = (QueryResult *) dbresponse.response->header();
+                        cursorid = qr->cursorId;
+                    }
+                    MSGID replyId = port->replyReleasing(m, *dbresponse.response,
+                                                         dbresponse.responseTo);
                     if( dbresponse.exhaustNS.size() > 0 ) {
-                        MsgData *header = dbresponse.response->header();
-                        QueryResult *qr = (QueryResult *) header;
-                        long long cursorid = qr->cursorId;
                         if( cursorid ) {
                             verify( dbresponse.exhaustNS.size() && dbresponse.exhaustNS[0] );
                             string ns = dbresponse.exhaustNS; // before reset() free's it...
                             m.reset();
                             BufBuilder b(512);
                             b.appendNum((int) 0 /*size set later in appendData()*/);
-                            b.appendNum(header->id);
-                            b.appendNum(header->responseTo);
+                            b.appendNum(replyId);
+                            b.appendNum(dbresponse.responseTo);
                             b.appendNum((int) dbGetMore);
                             b.appendNum((int) 0);
                             b.appendStr(ns);
@@ -239,6 +275,12 @@ namespace mongo {
             if( c ) c->shutdown();
         }
 
+        virtual ConnectionThreadState* detachThreadState() {
+            return new ClientThreadState();
+        }
+
+        virtual bool canDetachThreadState() const { return true; }
+
     };
 
     void logStartup() {
@@ -732,6 +774,7 @@ namespace mongo {
 
         snapshotThread.go();
         d.clientCursorMonitor.go();
+        startProfileWriter();
         PeriodicTask::theRunner->go();
         if (missingRepl) {
             // a warning was logged earlier
@@ -739,6 +782,8 @@ namespace mongo {
         else {
             startTTLBackgroundJob();
         }
+        startRecordScrubber();
+        startBtreeDefragmenter();
 
 #ifndef _WIN32
         mongo::signalForkSuccess();
@@ -750,7 +795,7 @@ namespace mongo {
             Client::WriteContext c("admin", storageGlobalParams.dbpath);
         }
 
-        getDeleter()->startWorkers();
+        startDeleterWorkers();
 
         // Starts a background thread that rebuilds all incomplete indices. 
         indexRebuilder.go(); 
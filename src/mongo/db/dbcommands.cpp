@@ -66,6 +66,7 @@
 #include "mongo/db/query_optimizer.h"
 #include "mongo/db/repl/is_master.h"
 #include "mongo/db/repl/oplog.h"
+#include "mongo/db/structure/collection.h"
 #include "mongo/db/write_concern.h"
 #include "mongo/s/d_writeback.h"
 #include "mongo/s/stale_exception.h"  // for SendStaleConfigException
@@ -1138,6 +1139,9 @@ namespace mongo {
             help << 
                 "Sets collection options.\n"
                 "Example: { collMod: 'foo', usePowerOf2Sizes:true }\n"
+                "Example: { collMod: 'foo', compressRecords:true }\n"
+                "Example: { collMod: 'foo', recordChecksums:true }\n"
+                "Example: { collMod: 'foo', idLookupCache:true }\n"
                 "Example: { collMod: 'foo', index: {keyPattern: {a: 1}, expireAfterSeconds: 600} }";
         }
         virtual void addRequiredPrivileges(const std::string& dbname,
@@ -1177,6 +1181,61 @@ namespace mongo {
                         result.appendBool( "usePowerOf2Sizes_new", newPowerOf2 );
                     }
                 }
+                else if ( str::equals( "compressRecords", e.fieldName() ) ) {
+                    if ( nsd->isCapped() ) {
+                        errmsg = "can't compress the records of a capped collection";
+                        ok = false;
+                        continue;
+                    }
+
+                    bool oldCompress = nsd->isUserFlagSet(NamespaceDetails::Flag_CompressRecords);
+                    bool newCompress = e.trueValue();
+
+                    if ( oldCompress != newCompress ) {
+                        // documents already stored stay as they are until rewritten
+                        result.appendBool( "compressRecords_old", oldCompress );
+
+                        newCompress ? nsd->setUserFlag( NamespaceDetails::Flag_CompressRecords ) :
+                                      nsd->clearUserFlag( NamespaceDetails::Flag_CompressRecords );
+                        nsd->syncUserFlags( ns ); // must keep system.namespaces up-to-date
+
+                        result.appendBool( "compressRecords_new", newCompress );
+                    }
+                }
+                else if ( str::equals( "recordChecksums", e.fieldName() ) ) {
+                    bool oldChecksums = nsd->isUserFlagSet(NamespaceDetails::Flag_RecordChecksums);
+                    bool newChecksums = e.trueValue();
+
+                    if ( oldChecksums != newChecksums ) {
+                        // documents get checksums as they are next written
+                        result.appendBool( "recordChecksums_old", oldChecksums );
+
+                        newChecksums ? nsd->setUserFlag( NamespaceDetails::Flag_RecordChecksums ) :
+                                       nsd->clearUserFlag( NamespaceDetails::Flag_RecordChecksums );
+                        nsd->syncUserFlags( ns ); // must keep system.namespaces up-to-date
+
+                        result.appendBool( "recordChecksums_new", newChecksums );
+                    }
+                }
+                else if ( str::equals( "idLookupCache", e.fieldName() ) ) {
+                    bool oldCache = nsd->isUserFlagSet(NamespaceDetails::Flag_IdLookupCache);
+                    bool newCache = e.trueValue();
+
+                    if ( oldCache != newCache ) {
+                        result.appendBool( "idLookupCache_old", oldCache );
+
+                        newCache ? nsd->setUserFlag( NamespaceDetails::Flag_IdLookupCache ) :
+                                   nsd->clearUserFlag( NamespaceDetails::Flag_IdLookupCache );
+                        nsd->syncUserFlags( ns ); // must keep system.namespaces up-to-date
+
+                        // give back the memory of a cache no longer used
+                        Collection* collection = ctx.db()->getCollection( ns );
+                        if ( collection )
+                            collection->infoCache()->idLookupCache()->clear();
+
+                        result.appendBool( "idLookupCache_new", newCache );
+                    }
+                }
                 else if ( str::equals( "index", e.fieldName() ) ) {
                     BSONObj indexObj = e.Obj();
                     BSONObj keyPattern = indexObj.getObjectField( "keyPattern" );
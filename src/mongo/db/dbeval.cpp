@@ -37,6 +37,7 @@
 #include "mongo/db/auth/authorization_manager_global.h"
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/commands.h"
+#include "mongo/db/commands/server_status.h"
 #include "mongo/db/introspect.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/json.h"
@@ -48,6 +49,11 @@ namespace mongo {
 
     const int edebug=0;
 
+    static ServerStatusMetricField<Counter64> displayScopePoolHits(
+        "scripting.scopePool.hits", ScriptEngine::scopePoolHits() );
+    static ServerStatusMetricField<Counter64> displayScopePoolMisses(
+        "scripting.scopePool.misses", ScriptEngine::scopePoolMisses() );
+
     bool dbEval(const string& dbName, BSONObj& cmd, BSONObjBuilder& result, string& errmsg) {
         BSONElement e = cmd.firstElement();
         uassert( 10046 ,  "eval needs Code" , e.type() == Code || e.type() == CodeWScope || e.type() == String );
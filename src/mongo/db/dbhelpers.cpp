@@ -49,6 +49,7 @@
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/write_concern.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/db/structure/collection.h"
 #include "mongo/s/d_logic.h"
@@ -130,7 +131,19 @@ namespace mongo {
 
         BSONObj key = i.getKeyFromQuery( query );
 
-        DiskLoc loc = QueryRunner::fastFindSingle(i, key);
+        IdLookupCache* idCache = NULL;
+        if ( d->isUserFlagSet( NamespaceDetails::Flag_IdLookupCache ) && !key.isEmpty() ) {
+            Collection* collection = database->getCollection( ns );
+            if ( collection )
+                idCache = collection->infoCache()->idLookupCache();
+        }
+
+        DiskLoc loc;
+        if ( !idCache || !idCache->find( key.firstElement(), &loc ) ) {
+            loc = QueryRunner::fastFindSingle(i, key);
+            if ( idCache && !loc.isNull() )
+                idCache->add( key.firstElement(), loc );
+        }
         if ( loc.isNull() )
             return false;
         result = loc.obj();
@@ -283,6 +296,12 @@ namespace mongo {
         return findShardKeyIndexPattern_inlock( ns, shardKeyPattern, indexPattern );
     }
 
+    // How long removeRange aims to hold the write lock for each batch of documents.
+    MONGO_EXPORT_SERVER_PARAMETER(removeRangeBatchMillis, int, 10);
+
+    // Most documents removeRange deletes in one batch.
+    static const long long kMaxRemoveBatch = 1024;
+
     long long Helpers::removeRange( const KeyRange& range,
                                     bool maxInclusive,
                                     bool secondaryThrottle,
@@ -327,10 +346,16 @@ namespace mongo {
         
         long long millisWaitingForReplication = 0;
 
-        while ( 1 ) {
+        // Documents removed per write lock, adjusted so the lock is held for about
+        // removeRangeBatchMillis at a time.
+        long long batchSize = 1;
+        bool done = false;
+
+        while ( !done ) {
             // Scoping for write lock.
             {
                 Client::WriteContext ctx(ns);
+                Timer batchTime;
 
                 NamespaceDetails* nsd = nsdetails( ns );
                 if (NULL == nsd) { break; }
@@ -341,53 +366,73 @@ namespace mongo {
                                                                    InternalPlanner::FORWARD,
                                                                    InternalPlanner::IXSCAN_FETCH));
 
-                runner->setYieldPolicy(Runner::YIELD_AUTO);
-
+                // The runner does not yield, so the documents it returns stay put until they
+                // are deleted below, under the same lock.
+                vector<DiskLoc> locs;
+                vector<BSONObj> objs;
                 DiskLoc rloc;
                 BSONObj obj;
-                Runner::RunnerState state;
-                // This may yield so we cannot touch nsd after this.
-                state = runner->getNext(&obj, &rloc);
+                Runner::RunnerState state = Runner::RUNNER_ADVANCED;
+                while ( static_cast<long long>( locs.size() ) < batchSize &&
+                        Runner::RUNNER_ADVANCED == ( state = runner->getNext(&obj, &rloc) ) ) {
+                    locs.push_back( rloc );
+                    objs.push_back( obj );
+                }
                 runner.reset();
-                if (Runner::RUNNER_EOF == state) { break; }
+                if ( locs.empty() ) { break; }
+                done = Runner::RUNNER_ADVANCED != state;
 
+                CollectionMetadataPtr metadataNow;
                 if ( onlyRemoveOrphanedDocs ) {
-                    // Do a final check in the write lock to make absolutely sure that our
-                    // collection hasn't been modified in a way that invalidates our migration
-                    // cleanup.
-
                     // We should never be able to turn off the sharding state once enabled, but
                     // in the future we might want to.
                     verify(shardingState.enabled());
 
                     // In write lock, so will be the most up-to-date version
-                    CollectionMetadataPtr metadataNow = shardingState.getCollectionMetadata( ns );
-
-                    bool docIsOrphan;
-                    if ( metadataNow ) {
-                        KeyPattern kp( metadataNow->getKeyPattern() );
-                        BSONObj key = kp.extractSingleKey( obj );
-                        docIsOrphan = !metadataNow->keyBelongsToMe( key )
-                            && !metadataNow->keyIsPending( key );
-                    }
-                    else {
-                        docIsOrphan = false;
-                    }
+                    metadataNow = shardingState.getCollectionMetadata( ns );
+                }
 
-                    if ( !docIsOrphan ) {
-                        warning() << "aborting migration cleanup for chunk " << min << " to " << max
-                                  << ( metadataNow ? (string) " at document " + obj.toString() : "" )
-                                  << ", collection " << ns << " has changed " << endl;
-                        break;
+                Collection* collection = c.database()->getCollection( ns );
+                for ( size_t i = 0; i < locs.size(); i++ ) {
+                    if ( onlyRemoveOrphanedDocs ) {
+                        // Do a final check in the write lock to make absolutely sure that our
+                        // collection hasn't been modified in a way that invalidates our
+                        // migration cleanup.
+                        bool docIsOrphan;
+                        if ( metadataNow ) {
+                            KeyPattern kp( metadataNow->getKeyPattern() );
+                            BSONObj key = kp.extractSingleKey( objs[i] );
+                            docIsOrphan = !metadataNow->keyBelongsToMe( key )
+                                && !metadataNow->keyIsPending( key );
+                        }
+                        else {
+                            docIsOrphan = false;
+                        }
+
+                        if ( !docIsOrphan ) {
+                            warning() << "aborting migration cleanup for chunk " << min << " to " << max
+                                      << ( metadataNow ? (string) " at document " + objs[i].toString() : "" )
+                                      << ", collection " << ns << " has changed " << endl;
+                            done = true;
+                            break;
+                        }
                     }
-                }
 
-                if ( callback )
-                    callback->goingToDelete( obj );
+                    if ( callback )
+                        callback->goingToDelete( objs[i] );
 
-                logOp("d", ns.c_str(), obj["_id"].wrap(), 0, 0, fromMigrate);
-                c.database()->getCollection( ns )->deleteDocument( rloc );
-                numDeleted++;
+                    logOp("d", ns.c_str(), objs[i]["_id"].wrap(), 0, 0, fromMigrate);
+                    collection->deleteDocument( locs[i] );
+                    numDeleted++;
+                }
+
+                const long long batchMillis = batchTime.millis();
+                if ( batchMillis * 2 < removeRangeBatchMillis && batchSize < kMaxRemoveBatch ) {
+                    batchSize *= 2;
+                }
+                else if ( batchMillis > removeRangeBatchMillis && batchSize > 1 ) {
+                    batchSize /= 2;
+                }
             }
 
             Timer secondaryThrottleTime;
@@ -95,10 +95,13 @@ namespace mongo {
 
         void assertNothingSpooled();
         void unspoolWriteIntents();
+        void claimWriteIntents();
 
         void PREPLOGBUFFER(JSectHeader& outParm, AlignedBuilder&);
         void WRITETOJOURNAL(JSectHeader h, AlignedBuilder& uncompressed);
         void WRITETODATAFILES(const JSectHeader& h, AlignedBuilder& uncompressed);
+        void WRITETODATAFILES_PIPELINED(const JSectHeader& h, AlignedBuilder& uncompressed);
+        void waitForDataFileWrites();
 
         /** declared later in this file
             only used in this file -- use DurableInterface::commitNow() outside
@@ -126,7 +129,7 @@ namespace mongo {
         string _CSVHeader();
 
         string Stats::S::_CSVHeader() { 
-            return "cmts  jrnMB\twrDFMB\tcIWLk\tearly\tprpLgB  wrToJ\twrToDF\trmpPrVw";
+            return "cmts  jrnMB\twrDFMB\tcIWLk\tearly\tgrpCmt\tprpLgB  wrToJ\twrToDF\trmpPrVw";
         }
 
         string Stats::S::_asCSV() { 
@@ -138,6 +141,7 @@ namespace mongo {
                 _writeToDataFilesBytes / 1000000.0 << '\t' << 
                 _commitsInWriteLock << '\t' << 
                 _earlyCommits <<  '\t' << 
+                _groupCommits <<  '\t' << 
                 (unsigned) (_prepLogBufferMicros/1000) << '\t' << 
                 (unsigned) (_writeToJournalMicros/1000) << '\t' << 
                 (unsigned) (_writeToDataFilesMicros/1000) << '\t' << 
@@ -153,8 +157,16 @@ namespace mongo {
                        "journaledMB" << _journaledBytes / 1000000.0 <<
                        "writeToDataFilesMB" << _writeToDataFilesBytes / 1000000.0 <<
                        "compression" << _journaledBytes / (_uncompressedBytes+1.0) <<
+                       "compressor" << journalCompressorName() <<
                        "commitsInWriteLock" << _commitsInWriteLock <<
                        "earlyCommits" << _earlyCommits << 
+                       "groupCommit" <<
+                       BSON( "batches" << _groupCommits <<
+                             "waiters" << (long long) _groupCommitWaiters <<
+                             "avgWaitersPerBatch" <<
+                                 ( _groupCommits ? (double) _groupCommitWaiters / _groupCommits : 0.0 ) <<
+                             "avgBatchMicros" <<
+                                 (long long) ( _groupCommits ? _groupCommitMicros / _groupCommits : 0 ) ) <<
                        "timeMs" <<
                        BSON( "dt" << _dtMillis <<
                              "prepLogBuffer" << (unsigned) (_prepLogBufferMicros/1000) <<
@@ -215,8 +227,38 @@ namespace mongo {
             return true;
         }
 
+        /* getLastError j:true waiters wake the journal thread rather than waiting out the rest of
+           the commit interval.  a commit already underway can't include their writes, so the
+           request stays pending and the next commit starts as soon as that one has finished,
+           acknowledging everyone who asked in the meantime as one batch.
+        */
+        static mongo::mutex commitRequestMutex("commitRequest");
+        static boost::condition commitRequested;
+        static bool commitRequestPending = false;
+
+        static void requestCommit() {
+            scoped_lock lk(commitRequestMutex);
+            if( !commitRequestPending ) {
+                commitRequestPending = true;
+                commitRequested.notify_one();
+            }
+        }
+
+        /** @return true if a commit was requested, either already or within 'ms' */
+        static bool awaitCommitRequest(unsigned ms) {
+            scoped_lock lk(commitRequestMutex);
+            if( !commitRequestPending )
+                commitRequested.timed_wait(lk.boost(), boost::posix_time::milliseconds(ms));
+            bool requested = commitRequestPending;
+            commitRequestPending = false;
+            return requested;
+        }
+
         bool DurableImpl::awaitCommit() {
-            commitJob._notify.awaitBeyondNow();
+            // any commit numbered after 'e' began after our writes, so includes them
+            NotifyAll::When e = commitJob._notify.now();
+            requestCommit();
+            commitJob._notify.waitFor(e + 1);
             return true;
         }
 
@@ -329,7 +371,8 @@ namespace mongo {
             perf note: this function is called a lot, on every lock_w() ... and usually returns right away
         */
         bool DurableImpl::commitIfNeeded(bool force) {
-            unspoolWriteIntents();
+            // no unspoolWriteIntents() here: the commit claims every thread's intents, and a
+            // thread hands them over sooner by itself once it has a lot pending
             DEV commitJob._nSinceCommitIfNeededCall = 0;
             if( likely( commitJob.bytes() < UncommittedBytesLimit && !force ) ) {
                 return false;
@@ -531,8 +574,7 @@ namespace mongo {
                     DurableMappedFile *mmf = (DurableMappedFile*) *i;
                     verify(mmf);
                     if( mmf->willNeedRemap() ) {
-                        mmf->willNeedRemap() = false;
-                        mmf->remapThePrivateView();
+                        mmf->remapWrittenChunks();
                     }
                     i++;
                     if( i == e ) i = b;
@@ -553,12 +595,19 @@ namespace mongo {
         // this is a pseudo-local variable in the groupcommit functions 
         // below.  however we don't truly do that so that we don't have to 
         // reallocate, and more importantly regrow it, on every single commit.
-        static AlignedBuilder __theBuilder(4 * 1024 * 1024);
+        // there are two so one commit can be prepared while the previous one is still being
+        // written to the data files from the other; see WRITETODATAFILES_PIPELINED().
+        static AlignedBuilder __theBuilderA(4 * 1024 * 1024);
+        static AlignedBuilder __theBuilderB(4 * 1024 * 1024);
+        static AlignedBuilder* __theBuilder = &__theBuilderA;
 
-        static bool _groupCommitWithLimitedLocks() {
-            unspoolWriteIntents(); // in case we were doing some writing ourself (likely impossible with limitedlocks version)
-            AlignedBuilder &ab = __theBuilder;
+        static AlignedBuilder& nextBuilder() {
+            commitJob.groupCommitMutex.dassertLocked();
+            __theBuilder = __theBuilder == &__theBuilderA ? &__theBuilderB : &__theBuilderA;
+            return *__theBuilder;
+        }
 
+        static bool _groupCommitWithLimitedLocks() {
             verify( ! Lock::isLocked() );
 
             // do we need this to be greedy, so that it can start working fairly soon?
@@ -568,6 +617,8 @@ namespace mongo {
             scoped_ptr<Lock::GlobalRead> lk1( new Lock::GlobalRead() );
 
             SimpleMutex::scoped_lock lk2(commitJob.groupCommitMutex);
+            AlignedBuilder &ab = nextBuilder();
+            claimWriteIntents();
 
             commitJob.commitingBegin(); // increments the commit epoch for getlasterror j:true
 
@@ -602,9 +653,11 @@ namespace mongo {
             // as we are not in Lock::GlobalRead anymore. private view readers won't see 
             // anything as we do this, but external viewers of the datafiles will see them 
             // mutating.
-            WRITETODATAFILES(h, ab);
-            verify( abLen == ab.len() ); // check again wasn't modded
-            ab.reset();
+            //
+            // this returns once the previous commit has reached the data files; ours is written
+            // while we go on to the next one.  a commit in a write lock, and so any remap, waits
+            // for it first.
+            WRITETODATAFILES_PIPELINED(h, ab);
 
             // can't : d.dbMutex._remapPrivateViewRequested = true;
             // (writes have happened we released)
@@ -642,14 +695,15 @@ namespace mongo {
             // We are 'R' or 'W'
             assertLockedForCommitting();
 
-            unspoolWriteIntents(); // in case we were doing some writing ourself
-
             {
-                AlignedBuilder &ab = __theBuilder;
-
                 // we need to make sure two group commits aren't running at the same time
                 // (and we are only read locked in the dbMutex, so it could happen)
                 SimpleMutex::scoped_lock lk(commitJob.groupCommitMutex);
+                AlignedBuilder &ab = nextBuilder();
+                claimWriteIntents(); // including any of our own
+
+                // REMAPPRIVATEVIEW below needs every earlier commit in the data files
+                waitForDataFileWrites();
 
                 commitJob.commitingBegin();
 
@@ -812,14 +866,13 @@ namespace mongo {
                 try {
                     stats.rotate();
 
-                    // commit sooner if one or more getLastError j:true is pending
-                    sleepmillis(oneThird);
-                    for( unsigned i = 1; i <= 2; i++ ) {
-                        if( commitJob._notify.nWaiting() )
+                    // commit as soon as a getLastError j:true is pending, or sooner than the
+                    // interval if a lot has been written
+                    for( unsigned i = 1; i <= 3; i++ ) {
+                        if( awaitCommitRequest(oneThird) )
                             break;
                         if( commitJob.bytes() > UncommittedBytesLimit / 2  )
                             break;
-                        sleepmillis(oneThird);
                     }
                                         
                     //DEV log() << "privateMapBytes=" << privateMapBytes << endl;
@@ -837,7 +890,8 @@ namespace mongo {
         void recover();
 
         void releasingWriteLock() {
-            unspoolWriteIntents();
+            // nothing to hand over: our write intents stay in our ThreadLocalIntents until the
+            // next commit claims them
         }
 
         void preallocateFiles();
@@ -46,16 +46,36 @@ namespace mongo {
 
     namespace dur {
 
+        // the threads that have declared write intents; see ThreadLocalIntents
+        static SimpleMutex& writersMutex = *(new SimpleMutex("durWriters"));
+        static std::set<ThreadLocalIntents*>& writers = *(new std::set<ThreadLocalIntents*>());
+
+        ThreadLocalIntents::ThreadLocalIntents() {
+            intents.reserve(N);
+            SimpleMutex::scoped_lock lk(writersMutex);
+            writers.insert(this);
+        }
+
         ThreadLocalIntents::~ThreadLocalIntents() {
-            fassert( 16731, intents.size() == 0 );
+            // the thread is exiting.  anything it declared since the last commit goes to the
+            // commit job now, as no one will claim it from us later
+            SimpleMutex::scoped_lock lk(commitJob.groupCommitMutex);
+            SimpleMutex::scoped_lock lk2(writersMutex);
+            _unspool();
+            writers.erase(this);
         }
 
         void ThreadLocalIntents::push(const WriteIntent& x) {
             if( !commitJob._hasWritten )
                 commitJob._hasWritten = true;
 
+            if( _alreadyNoted.checkAndSet(x.start(), x.length()) )
+                return;
+
             if( intents.size() == N ) {
-                if ( !condense() ) {
+                // a lot of distinct writes since the last commit.  hand them over so that
+                // commitIfNeeded() sees how much is pending.
+                if ( !condense() || intents.size() > N / 2 ) {
                     unspool();
                 }
             }
@@ -66,6 +86,7 @@ namespace mongo {
 #endif
         }
         void ThreadLocalIntents::_unspool() {
+            _alreadyNoted.clear();
             if ( intents.size() == 0 )
                 return;
 
@@ -80,6 +101,16 @@ namespace mongo {
             intents.clear();
         }
 
+        // static
+        void ThreadLocalIntents::claimAll() {
+            assertLockedForCommitting();
+            commitJob.groupCommitMutex.dassertLocked();
+            SimpleMutex::scoped_lock lk(writersMutex);
+            for( std::set<ThreadLocalIntents*>::iterator i = writers.begin(); i != writers.end(); ++i ) {
+                (*i)->_unspool();
+            }
+        }
+
         bool ThreadLocalIntents::condense() {
             std::sort( intents.begin(), intents.end() );
 
@@ -126,13 +157,17 @@ namespace mongo {
             }
 #endif
         }
-        // when we release our w or W lock this is invoked
+        /** hands the calling thread's pending intents to the commit job */
         void unspoolWriteIntents() { 
             ThreadLocalIntents *t = tlIntents.get();
             if( t ) 
                 t->unspool();
         }
 
+        void claimWriteIntents() {
+            ThreadLocalIntents::claimAll();
+        }
+
         /** base declare write intent function that all the helpers call. */
         /** we batch up our write intents so that we do not have to synchronize too often */
         void DurableImpl::declareWriteIntent(void *p, unsigned len) {
@@ -192,9 +227,20 @@ namespace mongo {
         void CommitJob::commitingBegin() { 
             assertLockedForCommitting();
             _commitNumber = _notify.now();
+            _commitTimer.reset();
             stats.curr->_commits++;
         }
 
+        void CommitJob::committingNotifyCommitted() {
+            groupCommitMutex.dassertLocked();
+            unsigned n = _notify.notifyAll(_commitNumber);
+            if( n ) {
+                stats.curr->_groupCommits++;
+                stats.curr->_groupCommitWaiters += n;
+                stats.curr->_groupCommitMicros += _commitTimer.micros();
+            }
+        }
+
         void CommitJob::_committingReset() {
             _hasWritten = false;
             _intentsAndDurOps.clear();
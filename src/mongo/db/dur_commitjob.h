@@ -37,6 +37,7 @@
 #include "mongo/util/alignedbuilder.h"
 #include "mongo/util/concurrency/synchronization.h"
 #include "mongo/util/mongoutils/hash.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
     namespace dur {
@@ -116,18 +117,28 @@ namespace mongo {
             #endif
         };
 
-        /** so we don't have to lock the groupCommitMutex too often */
+        /** each writing thread's pending write intents, so that declaring one takes no lock.
+
+            a thread only pushes while it holds a write lock, and the commit claims every thread's
+            intents while it holds at least a global read lock, which excludes all writers -- so the
+            two never run at once and the lock handoffs order their memory accesses.  the list of
+            threads is locked only when a thread first writes or exits.
+        */
         class ThreadLocalIntents {
-            enum { N = 21 };
+            enum { N = 1024 };
             std::vector<dur::WriteIntent> intents;
+            Already<127> _alreadyNoted;     // per thread, so repeats never reach the commit job
             bool condense();
         public:
-            ThreadLocalIntents() : intents(N) { intents.clear(); }
+            ThreadLocalIntents();
             ~ThreadLocalIntents();
             void _unspool();
+            /** hands this thread's intents to the commit job now.  takes groupCommitMutex. */
             void unspool();
             void push(const WriteIntent& i);
             int n_informational() const { return intents.size(); }
+            /** moves every thread's intents into the commit job.  in groupCommitMutex and R or W. */
+            static void claimAll();
             static AtomicUInt nSpooled;
         };
 
@@ -168,10 +179,7 @@ namespace mongo {
             /** these called by the groupCommit code as it goes along */
             void commitingBegin();
             /** the commit code calls this when data reaches the journal (on disk) */
-            void committingNotifyCommitted() { 
-                groupCommitMutex.dassertLocked();
-                _notify.notifyAll(_commitNumber); 
-            }
+            void committingNotifyCommitted();
             /** we use the commitjob object over and over, calling reset() rather than reconstructing */
             void committingReset() {
                 groupCommitMutex.dassertLocked();
@@ -195,6 +203,7 @@ namespace mongo {
 
         private:
             NotifyAll::When _commitNumber;
+            Timer _commitTimer;                 // since commitingBegin(), for the group commit stats
             IntentsAndDurOps _intentsAndDurOps;
             size_t _bytes;
         public:
@@ -38,9 +38,11 @@
 
 #include "mongo/base/init.h"
 #include "mongo/db/client.h"
+#include "mongo/db/dur_commitjob.h"
 #include "mongo/db/dur_journalformat.h"
 #include "mongo/db/dur_journalimpl.h"
 #include "mongo/db/dur_stats.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/platform/random.h"
 #include "mongo/server.h"
@@ -638,7 +640,51 @@ namespace mongo {
             }
         }
 
+        void waitForDataFileWrites();
+
+        namespace {
+            std::string journalCompressor = "snappy";
+            volatile unsigned journalCodec = JSectHeader::CodecSnappy;
+
+            /** how new journal sections are compressed.  every section records its codec, so this
+                can change at any time.
+            */
+            class JournalCompressorSetting : public ExportedServerParameter<std::string> {
+            public:
+                JournalCompressorSetting() :
+                    ExportedServerParameter<std::string>(ServerParameterSet::getGlobal(),
+                                                         "journalCompressor",
+                                                         &journalCompressor,
+                                                         true,
+                                                         true) {
+                }
+
+                virtual Status set(const std::string& newValue) {
+                    unsigned codec;
+                    if( newValue == "snappy" )
+                        codec = JSectHeader::CodecSnappy;
+                    else if( newValue == "none" )
+                        codec = JSectHeader::CodecNone;
+                    else
+                        return Status(ErrorCodes::BadValue,
+                                      "journalCompressor must be \"snappy\" or \"none\"");
+                    Status status = ExportedServerParameter<std::string>::set(newValue);
+                    if( status.isOK() )
+                        journalCodec = codec;
+                    return status;
+                }
+            } journalCompressorSetting;
+        }
+
+        const char* journalCompressorName() {
+            return journalCodec == JSectHeader::CodecNone ? "none" : "snappy";
+        }
+
         void Journal::preFlush() {
+            // everything journaled before the time we take must be in the data files we flush,
+            // so wait for any commit still being written to them
+            SimpleMutex::scoped_lock lk(commitJob.groupCommitMutex);
+            waitForDataFileWrites();
             j._preFlushTime = Listener::getElapsedTimeMillis();
         }
 
@@ -735,18 +781,27 @@ namespace mongo {
                compressed operations
                JSectFooter
             */
+            const unsigned codec = journalCodec;
             const unsigned headTailSize = sizeof(JSectHeader) + sizeof(JSectFooter);
-            const unsigned max = maxCompressedLength(uncompressed.len()) + headTailSize;
+            const unsigned max = ( codec == JSectHeader::CodecNone ?
+                                   uncompressed.len() :
+                                   maxCompressedLength(uncompressed.len()) ) + headTailSize;
             b.reset(max);
 
             {
-                dassert( h.sectionLen() == (unsigned) 0xffffffff ); // we will backfill later
+                dassert( h.sectionLen() == (unsigned) JSectHeader::LenMask ); // we will backfill later
                 b.appendStruct(h);
             }
 
             size_t compressedLength = 0;
-            rawCompress(uncompressed.buf(), uncompressed.len(), b.cur(), &compressedLength);
-            verify( compressedLength < 0xffffffff );
+            if( codec == JSectHeader::CodecNone ) {
+                memcpy(b.cur(), uncompressed.buf(), uncompressed.len());
+                compressedLength = uncompressed.len();
+            }
+            else {
+                rawCompress(uncompressed.buf(), uncompressed.len(), b.cur(), &compressedLength);
+            }
+            verify( compressedLength < JSectHeader::LenMask );
             verify( compressedLength < max );
             b.skip(compressedLength);
 
@@ -759,7 +814,7 @@ namespace mongo {
                 L = (lenUnpadded + Alignment-1) & (~(Alignment-1));
                 dassert( L >= lenUnpadded );
 
-                ((JSectHeader*)b.atOfs(0))->setSectionLen(lenUnpadded);
+                ((JSectHeader*)b.atOfs(0))->setSectionLen(lenUnpadded, codec);
 
                 JSectFooter f(b.buf(), b.len()); // computes checksum
                 b.appendStruct(f);
@@ -56,6 +56,9 @@ namespace mongo {
          */
         void journalRotate();
 
+        /** the codec new journal sections are written with; see the journalCompressor parameter */
+        const char* journalCompressorName();
+
         /** flag that something has gone wrong during writing to the journal
             (not for recovery mode)
         */
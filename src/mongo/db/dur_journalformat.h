@@ -77,15 +77,26 @@ namespace mongo {
         */
         struct JSectHeader {
         private:
-            unsigned _sectionLen;          // unpadded length in bytes of the whole section
+            unsigned _sectionLen;          // unpadded length in bytes of the whole section, and the codec
         public:
             unsigned long long seqNumber;  // sequence number that can be used on recovery to not do too much work
             unsigned long long fileId;     // matches JHeader::fileId
-            unsigned sectionLen() const { return _sectionLen; }
+
+            /** how the operations between header and footer are compressed.  kept in the top bits
+                of _sectionLen, as sections are much smaller than 1GB; versions that always used
+                snappy left them 0, so their sections read as CodecSnappy.
+            */
+            enum Codec { CodecSnappy = 0, CodecNone = 1 };
+            enum { CodecShift = 30, LenMask = (1U << CodecShift) - 1 };
+
+            unsigned sectionLen() const { return _sectionLen & LenMask; }
+            unsigned codec() const { return _sectionLen >> CodecShift; }
 
             // we store the unpadded length so we can use that when we uncompress. to 
             // get the true total size this must be rounded up to the Alignment.
-            void setSectionLen(unsigned lenUnpadded) { _sectionLen = lenUnpadded; }
+            void setSectionLen(unsigned lenUnpadded, unsigned codec = CodecSnappy) {
+                _sectionLen = (lenUnpadded & LenMask) | (codec << CodecShift);
+            }
 
             unsigned sectionLenWithPadding() const { 
                 unsigned x = (sectionLen() + (Alignment-1)) & (~(Alignment-1));
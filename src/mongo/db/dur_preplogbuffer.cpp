@@ -43,6 +43,7 @@
 #include "mongo/db/dur_journal.h"
 #include "mongo/db/dur_journalimpl.h"
 #include "mongo/db/dur_stats.h"
+#include "mongo/db/storage/in_memory_files.h"
 #include "mongo/server.h"
 #include "mongo/util/alignedbuilder.h"
 #include "mongo/util/mongoutils/hash.h"
@@ -59,8 +60,11 @@ namespace mongo {
 
         RelativePath local = RelativePath::fromRelativePath("local");
 
+        /** @return NULL if 'ptr' is in an in memory database, whose writes aren't journaled */
         static DurableMappedFile* findMMF_inlock(void *ptr, size_t &ofs) {
             DurableMappedFile *f = privateViews.find_inlock(ptr, ofs);
+            if( f == 0 && InMemoryFiles::contains(ptr) )
+                return 0;
             if( f == 0 ) {
                 error() << "findMMF_inlock failed " << privateViews.numberOfViews_inlock() << endl;
                 printStackTrace(); // we want a stack trace and the assert below didn't print a trace once in the real world - not sure why
@@ -75,13 +79,8 @@ namespace mongo {
         static void prepBasicWrite_inlock(AlignedBuilder&bb, const WriteIntent *i, RelativePath& lastDbPath) {
             size_t ofs = 1;
             DurableMappedFile *mmf = findMMF_inlock(i->start(), /*out*/ofs);
-
-            if( unlikely(!mmf->willNeedRemap()) ) {
-                // tag this mmf as needed a remap of its private view later.
-                // usually it will already be dirty/already set, so we do the if above first
-                // to avoid possibility of cpu cache line contention
-                mmf->willNeedRemap() = true;
-            }
+            if( mmf == 0 )
+                return;
 
             // since we have already looked up the mmf, we go ahead and remember the write view location
             // so we don't have to find the DurableMappedFile again later in WRITETODATAFILES()
@@ -98,6 +97,9 @@ namespace mongo {
             verify( ofs <= 0x80000000 );
             e.ofs = (unsigned) ofs;
             e.setFileNo( mmf->fileSuffixNo() );
+
+            // tag what we wrote as needing a remap of the private view later
+            mmf->noteWritten(ofs, e.len);
             if( mmf->relativePath() == local ) {
                 e.setLocalDbContextBit();
             }
@@ -32,7 +32,9 @@
 
 #include "mongo/db/dur_recover.h"
 
+#include <boost/bind.hpp>
 #include <boost/filesystem/operations.hpp>
+#include <boost/thread/thread.hpp>
 #include <fcntl.h>
 #include <sys/stat.h>
 
@@ -48,6 +50,7 @@
 #include "mongo/db/kill_current_op.h"
 #include "mongo/db/storage/durable_mapped_file.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/util/bufreader.h"
 #include "mongo/util/checksum.h"
@@ -121,11 +124,18 @@ namespace mongo {
                 , _doDurOps(doDurOpsRecovering)
             {
                 verify( doDurOpsRecovering );
-                bool ok = uncompress((const char *)compressed, compressedLen, &_uncompressed);
-                if( !ok ) { 
-                    // it should always be ok (i think?) as there is a previous check to see that the JSectFooter is ok
-                    log() << "couldn't uncompress journal section" << endl;
-                    msgasserted(15874, "couldn't uncompress journal section");
+                if( h.codec() == JSectHeader::CodecNone ) {
+                    _uncompressed.assign((const char *)compressed, compressedLen);
+                }
+                else {
+                    massert(17330, str::stream() << "journal section has unknown codec " << h.codec(),
+                            h.codec() == JSectHeader::CodecSnappy);
+                    bool ok = uncompress((const char *)compressed, compressedLen, &_uncompressed);
+                    if( !ok ) { 
+                        // it should always be ok (i think?) as there is a previous check to see that the JSectFooter is ok
+                        log() << "couldn't uncompress journal section" << endl;
+                        msgasserted(15874, "couldn't uncompress journal section");
+                    }
                 }
                 const char *p = _uncompressed.c_str();
                 verify( compressedLen == _h.sectionLen() - sizeof(JSectFooter) - sizeof(JSectHeader) );
@@ -348,11 +358,86 @@ namespace mongo {
             return mmf;
         }
 
+        // recovery applies a section's writes to different files on up to this many threads
+        MONGO_EXPORT_STARTUP_SERVER_PARAMETER(journalRecoveryThreads, int, 4);
+
+        typedef vector<const ParsedJournalEntry*> FileWrites;
+        typedef vector<pair<DurableMappedFile*, FileWrites> > FilesWrites;
+
+        /** apply, in order, the writes to each of 'files'.  entries past the end of a file are
+            skipped, as RecoveryJob::write does when recovering.
+        */
+        static void writeFiles(const FilesWrites* files, unsigned long long* bytes) {
+            for( FilesWrites::const_iterator f = files->begin(); f != files->end(); ++f ) {
+                DurableMappedFile *mmf = f->first;
+                char *view = (char *) mmf->view_write();
+                verify(view);
+                for( FileWrites::const_iterator i = f->second.begin(); i != f->second.end(); ++i ) {
+                    const JEntry *e = (*i)->e;
+                    if( e->ofs + e->len <= mmf->length() ) {
+                        memcpy(view + e->ofs, e->srcData(), e->len);
+                        *bytes += e->len;
+                    }
+                }
+            }
+        }
+
+        void RecoveryJob::applyEntriesInParallel(const vector<ParsedJournalEntry> &entries) {
+            vector<ParsedJournalEntry>::const_iterator i = entries.begin();
+            while( i != entries.end() ) {
+                if( i->op ) {
+                    // ops act on whole files, so they are applied one at a time, in order
+                    Last last;
+                    applyEntry(last, *i, true, false);
+                    ++i;
+                    continue;
+                }
+
+                // a write is only ordered relative to writes to the same file, so the run of them
+                // up to the next op is split up by file and the files written concurrently
+                map<DurableMappedFile*, FileWrites> byFile;
+                for( ; i != entries.end() && !i->op; ++i ) {
+                    byFile[getDurableMappedFile(*i)].push_back(&*i);
+                }
+
+                size_t nThreads = std::min(byFile.size(),
+                                           static_cast<size_t>(std::max(journalRecoveryThreads, 1)));
+                vector<FilesWrites> perThread(nThreads);
+                size_t n = 0;
+                for( map<DurableMappedFile*, FileWrites>::iterator f = byFile.begin();
+                     f != byFile.end(); ++f, ++n ) {
+                    perThread[n % nThreads].push_back(*f);
+                }
+
+                vector<unsigned long long> bytes(nThreads, 0);
+                if( nThreads == 1 ) {
+                    writeFiles(&perThread[0], &bytes[0]);
+                }
+                else {
+                    boost::thread_group threads;
+                    for( size_t t = 0; t < nThreads; t++ ) {
+                        threads.create_thread(boost::bind(&writeFiles, &perThread[t], &bytes[t]));
+                    }
+                    threads.join_all();
+                }
+
+                for( size_t t = 0; t < nThreads; t++ ) {
+                    stats.curr->_writeToDataFilesBytes += bytes[t];
+                }
+            }
+        }
+
         void RecoveryJob::applyEntries(const vector<ParsedJournalEntry> &entries) {
             bool apply = (storageGlobalParams.durOptions &
                           StorageGlobalParams::DurScanOnly) == 0;
             bool dump = storageGlobalParams.durOptions &
                         StorageGlobalParams::DurDumpJournal;
+
+            if( apply && !dump && _recovering && journalRecoveryThreads > 1 ) {
+                applyEntriesInParallel(entries);
+                return;
+            }
+
             if( dump )
                 log() << "BEGIN section" << endl;
 
@@ -63,6 +63,12 @@ namespace mongo {
                 // - data being written faster than the normal group commit interval
                 unsigned _commitsInWriteLock;
 
+                // commits that acknowledged getLastError j:true waiters, how many waiters they
+                // acknowledged, and how long they took from starting to reaching the journal
+                unsigned _groupCommits;
+                unsigned long long _groupCommitWaiters;
+                unsigned long long _groupCommitMicros;
+
                 unsigned _dtMillis;
             };
             S *curr;
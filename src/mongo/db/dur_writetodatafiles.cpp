@@ -30,10 +30,16 @@
 
 #include "mongo/pch.h"
 
+#include <boost/thread/thread.hpp>
+
+#include "mongo/db/client.h"
 #include "mongo/db/dur_commitjob.h"
 #include "mongo/db/dur_recover.h"
 #include "mongo/db/dur_stats.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/server.h"
 #include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/mmap.h"
 #include "mongo/util/timer.h"
 
 namespace mongo {
@@ -109,5 +115,92 @@ namespace mongo {
             LOG(2) << "journal WRITETODATAFILES " << m / 1000.0 << "ms" << endl;
         }
 
+        MONGO_EXPORT_STARTUP_SERVER_PARAMETER(journalPipelinedDataFileWrites, bool, true);
+
+        /** applies each commit's writes to the data files on a thread of its own, so that the
+            journal thread can prepare, compress and journal the next commit meanwhile.  at most one
+            commit is outstanding: handing over another waits for the previous to be written, which
+            keeps them in order and leaves the caller's other builder free for reuse.
+        */
+        class DataFileWriter : boost::noncopyable {
+        public:
+            DataFileWriter() : _m("DataFileWriter"), _ab(0), _started(false) { }
+
+            /** takes over 'ab', which is reset once written.  call in groupCommitMutex. */
+            void write(const JSectHeader& h, AlignedBuilder& ab) {
+                commitJob.groupCommitMutex.dassertLocked();
+                if( !journalPipelinedDataFileWrites ) {
+                    WRITETODATAFILES(h, ab);
+                    ab.reset();
+                    return;
+                }
+                scoped_lock lk(_m);
+                if( !_started ) {
+                    boost::thread t(boost::bind(&DataFileWriter::run, this));
+                    _started = true;
+                }
+                while( _ab )
+                    _written.wait(lk.boost());
+                _h = h;
+                _ab = &ab;
+                _queued.notify_one();
+            }
+
+            void waitUntilWritten() {
+                scoped_lock lk(_m);
+                while( _ab )
+                    _written.wait(lk.boost());
+            }
+
+        private:
+            void run() {
+                Client::initThread("journalDataFileWriter");
+                while( 1 ) {
+                    AlignedBuilder* ab;
+                    JSectHeader h;
+                    {
+                        scoped_lock lk(_m);
+                        while( !_ab )
+                            _queued.wait(lk.boost());
+                        ab = _ab;
+                        h = _h;
+                    }
+
+                    try {
+                        // files close only after waitUntilWritten(), but mustn't mid-write
+                        LockMongoFilesShared lk;
+                        WRITETODATAFILES(h, *ab);
+                        ab->reset();
+                    }
+                    catch(std::exception& e) {
+                        log() << "exception writing to data files causing immediate shutdown: "
+                              << e.what() << endl;
+                        mongoAbort("dur5");
+                    }
+
+                    scoped_lock lk(_m);
+                    _ab = 0;
+                    _written.notify_all();
+                }
+            }
+
+            mongo::mutex _m;
+            boost::condition _queued;
+            boost::condition _written;
+            JSectHeader _h;
+            AlignedBuilder* _ab;
+            bool _started;
+        };
+
+        static DataFileWriter& dataFileWriter = *(new DataFileWriter()); // don't destroy
+
+        void WRITETODATAFILES_PIPELINED(const JSectHeader& h, AlignedBuilder& uncompressed) {
+            dataFileWriter.write(h, uncompressed);
+        }
+
+        void waitForDataFileWrites() {
+            dataFileWriter.waitUntilWritten();
+        }
+
     }
 }
@@ -28,6 +28,7 @@
 
 #include "mongo/db/exec/2d.h"
 
+#include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/structure/collection.h"
@@ -45,6 +46,7 @@ namespace mongo {
     }
 
     PlanStage::StageState TwoD::work(WorkingSetID* out) {
+        ScopedTimer timer(&_commonStats);
         if (isEOF()) { return PlanStage::IS_EOF; }
 
         if (!_initted) {
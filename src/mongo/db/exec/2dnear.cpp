@@ -28,6 +28,7 @@
 
 #include "mongo/db/exec/2dnear.h"
 
+#include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/structure/collection.h"
@@ -47,6 +48,7 @@ namespace mongo {
     }
 
     PlanStage::StageState TwoDNear::work(WorkingSetID* out) {
+        ScopedTimer timer(&_commonStats);
         ++_commonStats.works;
         if (!_initted) {
             _initted = true;
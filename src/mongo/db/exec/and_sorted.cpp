@@ -30,6 +30,7 @@
 
 #include "mongo/db/exec/and_common-inl.h"
 #include "mongo/db/exec/filter.h"
+#include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
 
 namespace mongo {
@@ -49,6 +50,7 @@ namespace mongo {
     bool AndSortedStage::isEOF() { return _isEOF; }
 
     PlanStage::StageState AndSortedStage::work(WorkingSetID* out) {
+        ScopedTimer timer(&_commonStats);
         ++_commonStats.works;
 
         if (isEOF()) { return PlanStage::IS_EOF; }
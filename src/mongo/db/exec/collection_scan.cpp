@@ -30,7 +30,7 @@
 
 #include "mongo/db/database.h"
 #include "mongo/db/exec/collection_scan_common.h"
-#include "mongo/db/exec/filter.h"
+#include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/structure/collection.h"
 #include "mongo/db/structure/collection_iterator.h"
@@ -43,9 +43,37 @@ namespace mongo {
     CollectionScan::CollectionScan(const CollectionScanParams& params,
                                    WorkingSet* workingSet,
                                    const MatchExpression* filter)
-        : _workingSet(workingSet), _filter(filter), _params(params), _nsDropped(false) { }
+        : _workingSet(workingSet), _filter(filter), _params(params), _nsDropped(false) {
+
+        if (NULL != _filter) {
+            _compiledFilter.reset(new CompiledMatchExpression(_filter));
+        }
+    }
 
     PlanStage::StageState CollectionScan::work(WorkingSetID* out) {
+        ScopedTimer timer(&_commonStats);
+        return doWork(out);
+    }
+
+    PlanStage::StageState CollectionScan::workBatch(size_t maxWorks,
+                                                    vector<WorkingSetID>* out) {
+        ScopedTimer timer(&_commonStats);
+        // Same as the default, but without a virtual call per unit of work.
+        StageState state = PlanStage::NEED_TIME;
+        for (size_t i = 0; i < maxWorks; ++i) {
+            WorkingSetID id;
+            state = doWork(&id);
+            if (PlanStage::ADVANCED == state) {
+                out->push_back(id);
+            }
+            else if (PlanStage::NEED_TIME != state) {
+                return state;
+            }
+        }
+        return state;
+    }
+
+    PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
         ++_commonStats.works;
         if (_nsDropped) { return PlanStage::DEAD; }
 
@@ -56,9 +84,15 @@ namespace mongo {
                 return PlanStage::DEAD;
             }
 
-            _iter.reset( collection->getIterator( _params.start,
-                                                  _params.tailable,
-                                                  _params.direction ) );
+            if (_params.firstExtent.isNull()) {
+                _iter.reset( collection->getIterator( _params.start,
+                                                      _params.tailable,
+                                                      _params.direction ) );
+            }
+            else {
+                _iter.reset( collection->getExtentRangeIterator( _params.firstExtent,
+                                                                 _params.lastExtent ) );
+            }
 
             ++_commonStats.needTime;
             return PlanStage::NEED_TIME;
@@ -92,7 +126,8 @@ namespace mongo {
 
         ++_specificStats.docsTested;
 
-        if (Filter::passes(member, _filter)) {
+        // Every member has its object here, so the filter can skip the WorkingSetMember.
+        if (NULL == _compiledFilter || _compiledFilter->matchesBSON(member->obj)) {
             *out = id;
             ++_commonStats.advanced;
             return PlanStage::ADVANCED;
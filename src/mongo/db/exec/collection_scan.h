@@ -32,6 +32,7 @@
 #include "mongo/db/exec/collection_scan_common.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/expression_compiled.h"
 #include "mongo/db/structure/collection_iterator.h"
 
 namespace mongo {
@@ -50,6 +51,7 @@ namespace mongo {
                        const MatchExpression* filter);
 
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxWorks, std::vector<WorkingSetID>* out);
         virtual bool isEOF();
 
         virtual void invalidate(const DiskLoc& dl);
@@ -59,12 +61,20 @@ namespace mongo {
         virtual PlanStageStats* getStats();
 
     private:
+        /**
+         * The body of work(...), which workBatch(...) calls directly.
+         */
+        StageState doWork(WorkingSetID* out);
+
         // WorkingSet is not owned by us.
         WorkingSet* _workingSet;
 
         // The filter is not owned by us.
         const MatchExpression* _filter;
 
+        // _filter prepared for the documents we scan, NULL without a filter.
+        scoped_ptr<CompiledMatchExpression> _compiledFilter;
+
         scoped_ptr<CollectionIterator> _iter;
 
         CollectionScanParams _params;
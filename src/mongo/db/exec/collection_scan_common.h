@@ -53,6 +53,13 @@ namespace mongo {
 
         // Do we want the scan to be 'tailable'?  Only meaningful if the collection is capped.
         bool tailable;
+
+        // If not null, only scan the records in the extents from 'firstExtent' through
+        // 'lastExtent', inclusive, following the collection's extent chain.  Scans of disjoint
+        // ranges can run side by side to read a collection in parallel.  Only for forward scans
+        // of non-capped collections.  'start' is ignored.
+        DiskLoc firstExtent;
+        DiskLoc lastExtent;
     };
 
 }  // namespace mongo
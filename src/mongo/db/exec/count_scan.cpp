@@ -0,0 +1,267 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/exec/count_scan.h"
+
+#include "mongo/db/exec/scoped_timer.h"
+#include "mongo/db/index/catalog_hack.h"
+#include "mongo/db/index/index_access_method.h"
+#include "mongo/db/index/index_cursor.h"
+#include "mongo/db/index/index_descriptor.h"
+
+namespace {
+
+    // Return a value in the set {-1, 0, 1} to represent the sign of parameter i.
+    int sgn(int i) {
+        if (i == 0)
+            return 0;
+        return i > 0 ? 1 : -1;
+    }
+
+}  // namespace
+
+namespace mongo {
+
+    CountScan::CountScan(const CountScanParams& params)
+        : _btreeCursor(NULL), _descriptor(params.descriptor), _hitEnd(false), _count(0),
+          _shouldDedup(params.descriptor->isMultikey()), _yieldMovedCursor(false),
+          _params(params) {
+
+        // Only a Btree knows the keys between two bounds.
+        _iam = CatalogHack::getBtreeIndex(_descriptor);
+
+        _specificStats.indexName = _descriptor->infoObj()["name"].String();
+        _specificStats.indexBounds = _params.bounds.toBSON();
+        _specificStats.isMultiKey = _descriptor->isMultikey();
+        _specificStats.keyPattern = _descriptor->keyPattern();
+    }
+
+    CountScan::~CountScan() { }
+
+    PlanStage::StageState CountScan::work(WorkingSetID* out) {
+        ScopedTimer timer(&_commonStats);
+        return doWork();
+    }
+
+    PlanStage::StageState CountScan::workBatch(size_t maxWorks, vector<WorkingSetID>* out) {
+        ScopedTimer timer(&_commonStats);
+        // There are never results, so only EOF and failure end the batch early.
+        StageState state = PlanStage::NEED_TIME;
+        for (size_t i = 0; i < maxWorks && PlanStage::NEED_TIME == state; ++i) {
+            state = doWork();
+        }
+        return state;
+    }
+
+    PlanStage::StageState CountScan::doWork() {
+        ++_commonStats.works;
+
+        if (NULL == _indexCursor.get()) {
+            // First call to work().  Perform cursor init.
+            CursorOptions cursorOptions;
+            if (1 == _params.direction) {
+                cursorOptions.direction = CursorOptions::INCREASING;
+            }
+            else {
+                cursorOptions.direction = CursorOptions::DECREASING;
+            }
+
+            IndexCursor *cursor;
+            Status s = _iam->newCursor(&cursor);
+            verify(s.isOK());
+            _indexCursor.reset(cursor);
+            _indexCursor->setOptions(cursorOptions);
+            _btreeCursor = static_cast<BtreeIndexCursor*>(_indexCursor.get());
+
+            if (_params.bounds.isSimpleRange) {
+                Status status = _indexCursor->seek(_params.bounds.startKey);
+                if (!status.isOK()) {
+                    warning() << "Seek failed: " << status.toString();
+                    _hitEnd = true;
+                    return PlanStage::FAILURE;
+                }
+            }
+            else {
+                _checker.reset(new IndexBoundsChecker(&_params.bounds,
+                                                      _descriptor->keyPattern(),
+                                                      _params.direction));
+
+                int nFields = _descriptor->keyPattern().nFields();
+                vector<const BSONElement*> key;
+                vector<bool> inc;
+                key.resize(nFields);
+                inc.resize(nFields);
+                if (_checker->getStartKey(&key, &inc)) {
+                    _btreeCursor->seek(key, inc);
+                    _keyElts.resize(nFields);
+                    _keyEltsInc.resize(nFields);
+                }
+                else {
+                    _hitEnd = true;
+                }
+            }
+
+            checkEnd();
+        }
+        else if (_yieldMovedCursor) {
+            // The key the cursor moved onto hasn't been counted yet.
+            _yieldMovedCursor = false;
+        }
+        else if (!isEOF()) {
+            _indexCursor->next();
+            checkEnd();
+        }
+
+        if (isEOF()) { return PlanStage::IS_EOF; }
+
+        if (_shouldDedup) {
+            DiskLoc loc = _indexCursor->getValue();
+            ++_specificStats.dupsTested;
+            if (!_counted.insert(loc).second) {
+                ++_specificStats.dupsDropped;
+                ++_commonStats.needTime;
+                return PlanStage::NEED_TIME;
+            }
+        }
+
+        ++_count;
+        if (0 != _params.limit && _count >= _params.limit) {
+            _hitEnd = true;
+        }
+
+        ++_commonStats.needTime;
+        return PlanStage::NEED_TIME;
+    }
+
+    bool CountScan::isEOF() {
+        if (NULL == _indexCursor.get()) {
+            // Have to call work() at least once.
+            return false;
+        }
+
+        return _hitEnd || _indexCursor->isEOF();
+    }
+
+    void CountScan::prepareToYield() {
+        ++_commonStats.yields;
+
+        if (isEOF() || (NULL == _indexCursor.get())) { return; }
+        _savedKey = _indexCursor->getKey().getOwned();
+        _savedLoc = _indexCursor->getValue();
+        _indexCursor->savePosition();
+    }
+
+    void CountScan::recoverFromYield() {
+        ++_commonStats.unyields;
+
+        if (isEOF() || (NULL == _indexCursor.get())) { return; }
+
+        if (!_indexCursor->restorePosition().isOK() || _indexCursor->isEOF()) {
+            _hitEnd = true;
+            return;
+        }
+
+        if (!_savedKey.binaryEqual(_indexCursor->getKey())
+            || _savedLoc != _indexCursor->getValue()) {
+            // The key we counted last is gone and we're on the one after it.
+            _yieldMovedCursor = true;
+            ++_specificStats.yieldMovedCursor;
+            checkEnd();
+        }
+    }
+
+    void CountScan::invalidate(const DiskLoc& dl) {
+        ++_commonStats.invalidates;
+
+        // A document counted before being deleted stays counted, but what's inserted at its
+        // DiskLoc afterwards is a different document.
+        _counted.erase(dl);
+    }
+
+    void CountScan::checkEnd() {
+        if (isEOF()) {
+            _commonStats.isEOF = true;
+            return;
+        }
+
+        if (_params.bounds.isSimpleRange) {
+            ++_specificStats.keysExamined;
+
+            // If there is an empty endKey we will scan until we run out of index to scan over.
+            if (_params.bounds.endKey.isEmpty()) { return; }
+
+            int cmp = sgn(_params.bounds.endKey.woCompare(_indexCursor->getKey(),
+                                                          _descriptor->keyPattern()));
+
+            if ((cmp != 0 && cmp != _params.direction)
+                || (cmp == 0 && !_params.bounds.endKeyInclusive)) {
+                _hitEnd = true;
+                _commonStats.isEOF = true;
+            }
+            return;
+        }
+
+        for (;;) {
+            IndexBoundsChecker::KeyState keyState;
+            keyState = _checker->checkKey(_indexCursor->getKey(),
+                                          &_keyEltsToUse,
+                                          &_movePastKeyElts,
+                                          &_keyElts,
+                                          &_keyEltsInc);
+
+            if (IndexBoundsChecker::DONE == keyState) {
+                _hitEnd = true;
+                break;
+            }
+
+            ++_specificStats.keysExamined;
+
+            if (IndexBoundsChecker::VALID == keyState) {
+                break;
+            }
+
+            verify(IndexBoundsChecker::MUST_ADVANCE == keyState);
+            _btreeCursor->skip(_indexCursor->getKey(), _keyEltsToUse, _movePastKeyElts,
+                               _keyElts, _keyEltsInc);
+
+            // Must check underlying cursor EOF after every cursor movement.
+            if (_btreeCursor->isEOF()) {
+                _hitEnd = true;
+                break;
+            }
+        }
+    }
+
+    PlanStageStats* CountScan::getStats() {
+        _commonStats.isEOF = isEOF();
+        auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, STAGE_COUNT_SCAN));
+        ret->specific.reset(new CountScanStats(_specificStats));
+        return ret.release();
+    }
+
+}  // namespace mongo
@@ -0,0 +1,127 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/db/diskloc.h"
+#include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/index/btree_index_cursor.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/query/index_bounds.h"
+#include "mongo/platform/unordered_set.h"
+
+namespace mongo {
+
+    class IndexAccessMethod;
+    class IndexDescriptor;
+
+    struct CountScanParams {
+        CountScanParams() : descriptor(NULL), direction(1), limit(0) { }
+
+        IndexDescriptor* descriptor;
+
+        IndexBounds bounds;
+
+        int direction;
+
+        // If non-zero, stop once this many documents have been counted.
+        long long limit;
+    };
+
+    /**
+     * Stage counts the documents with keys within the bounds of a Btree index, for counts whose
+     * predicate the bounds capture exactly.  Nothing is fetched or matched and no WorkingSetMember
+     * is allocated: work() returns NEED_TIME for each key until IS_EOF, and getCount() has the
+     * count.  Keys of a multikey index are counted once per DiskLoc.
+     *
+     * Sub-stage preconditions: None.  Is a leaf and consumes no stage data.
+     */
+    class CountScan : public PlanStage {
+    public:
+        explicit CountScan(const CountScanParams& params);
+
+        virtual ~CountScan();
+
+        virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxWorks, std::vector<WorkingSetID>* out);
+        virtual bool isEOF();
+        virtual void prepareToYield();
+        virtual void recoverFromYield();
+        virtual void invalidate(const DiskLoc& dl);
+
+        virtual PlanStageStats* getStats();
+
+        /** The number of documents counted so far. */
+        long long getCount() const { return _count; }
+
+    private:
+        /**
+         * The body of work(...), which workBatch(...) calls directly.
+         */
+        StageState doWork();
+
+        /** See if the cursor is past the bounds, skipping keys between intervals. */
+        void checkEnd();
+
+        // Index access.
+        IndexAccessMethod* _iam; // owned by Collection -> IndexCatalog
+        scoped_ptr<IndexCursor> _indexCursor;
+        BtreeIndexCursor* _btreeCursor;
+        IndexDescriptor* _descriptor; // owned by Collection -> IndexCatalog
+
+        // Have we hit the end of the bounds or the limit?
+        bool _hitEnd;
+
+        long long _count;
+
+        // Could our index have duplicates?  If so, we use _counted to dedup.
+        bool _shouldDedup;
+        unordered_set<DiskLoc, DiskLoc::Hasher> _counted;
+
+        // For yielding.
+        BSONObj _savedKey;
+        DiskLoc _savedLoc;
+
+        // True if there was a yield and the yield moved the cursor onto a key not yet counted.
+        bool _yieldMovedCursor;
+
+        CountScanParams _params;
+
+        // For complex bounds.
+        scoped_ptr<IndexBoundsChecker> _checker;
+        int _keyEltsToUse;
+        bool _movePastKeyElts;
+        vector<const BSONElement*> _keyElts;
+        vector<bool> _keyEltsInc;
+
+        // Stats
+        CommonStats _commonStats;
+        CountScanStats _specificStats;
+    };
+
+}  // namespace mongo
@@ -28,19 +28,29 @@
 
 #include "mongo/db/exec/fetch.h"
 
+#include <algorithm>
+
 #include "mongo/db/exec/filter.h"
+#include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/fail_point_service.h"
+#include "mongo/util/processinfo.h"
 
 namespace mongo {
 
+    // How many records per batch we'll ask the OS to read in ahead of fetching them.  0 disables
+    // read-ahead.
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecFetchReadAhead, int, 16);
+
     // Some fail points for testing.
     MONGO_FP_DECLARE(fetchInMemoryFail);
     MONGO_FP_DECLARE(fetchInMemorySucceed);
 
     FetchStage::FetchStage(WorkingSet* ws, PlanStage* child, const MatchExpression* filter)
-        : _ws(ws), _child(child), _filter(filter), _idBeingPagedIn(WorkingSet::INVALID_ID) { }
+        : _ws(ws), _child(child), _filter(filter), _idBeingPagedIn(WorkingSet::INVALID_ID),
+          _childFetchRequest(WorkingSet::INVALID_ID) { }
 
     FetchStage::~FetchStage() { }
 
@@ -51,6 +61,11 @@ namespace mongo {
             return false;
         }
 
+        if (!_pending.empty() || WorkingSet::INVALID_ID != _childFetchRequest) {
+            // We're still holding on to part of a batch.
+            return false;
+        }
+
         return _child->isEOF();
     }
 
@@ -67,6 +82,7 @@ namespace mongo {
     }
 
     PlanStage::StageState FetchStage::work(WorkingSetID* out) {
+        ScopedTimer timer(&_commonStats);
         ++_commonStats.works;
 
         if (isEOF()) { return PlanStage::IS_EOF; }
@@ -76,42 +92,28 @@ namespace mongo {
             return fetchCompleted(out);
         }
 
+        // Results left over from a batch that stopped for a page-in come before anything new.
+        if (!_pending.empty()) {
+            WorkingSetID id = _pending.front();
+            _pending.pop_front();
+            return fetchMember(id, out);
+        }
+
+        // So does a page-in our child asked for at the end of that batch.
+        if (WorkingSet::INVALID_ID != _childFetchRequest) {
+            *out = _childFetchRequest;
+            _childFetchRequest = WorkingSet::INVALID_ID;
+            ++_commonStats.needFetch;
+            return PlanStage::NEED_FETCH;
+        }
+
         // If we're here, we're not waiting for a DiskLoc to be fetched.  Get another to-be-fetched
         // result from our child.
         WorkingSetID id;
         StageState status = _child->work(&id);
 
         if (PlanStage::ADVANCED == status) {
-            WorkingSetMember* member = _ws->get(id);
-
-            // If there's an obj there, there is no fetching to perform.
-            if (member->hasObj()) {
-                ++_specificStats.alreadyHasObj;
-                return returnIfMatches(member, id, out);
-            }
-
-            // We need a valid loc to fetch from and this is the only state that has one.
-            verify(WorkingSetMember::LOC_AND_IDX == member->state);
-            verify(member->hasLoc());
-
-            Record* record = member->loc.rec();
-            const char* data = record->dataNoThrowing();
-
-            if (!recordInMemory(data)) {
-                // member->loc points to a record that's NOT in memory.  Pass a fetch request up.
-                verify(WorkingSet::INVALID_ID == _idBeingPagedIn);
-                _idBeingPagedIn = id;
-                *out = id;
-                ++_commonStats.needFetch;
-                return PlanStage::NEED_FETCH;
-            }
-            else {
-                // Don't need index data anymore as we have an obj.
-                member->keyData.clear();
-                member->obj = BSONObj(data);
-                member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
-                return returnIfMatches(member, id, out);
-            }
+            return fetchMember(id, out);
         }
         else {
             if (PlanStage::NEED_FETCH == status) {
@@ -125,6 +127,104 @@ namespace mongo {
         }
     }
 
+    PlanStage::StageState FetchStage::workBatch(size_t maxWorks, vector<WorkingSetID>* out) {
+        // Anything left over from the last batch is handed out one at a time.
+        if (isEOF() || WorkingSet::INVALID_ID != _idBeingPagedIn || !_pending.empty()
+            || WorkingSet::INVALID_ID != _childFetchRequest) {
+            return PlanStage::workBatch(maxWorks, out);
+        }
+
+        ScopedTimer timer(&_commonStats);
+
+        vector<WorkingSetID> ids;
+        StageState status = _child->workBatch(maxWorks, &ids);
+
+        size_t numResults = ids.size();
+        if (PlanStage::NEED_FETCH == status) {
+            // Pass our child's page-in request up once we're done with its results.
+            _childFetchRequest = ids.back();
+            --numResults;
+        }
+
+        readAhead(ids, numResults);
+
+        for (size_t i = 0; i < numResults; ++i) {
+            ++_commonStats.works;
+
+            WorkingSetID id;
+            StageState memberStatus = fetchMember(ids[i], &id);
+
+            if (PlanStage::ADVANCED == memberStatus) {
+                out->push_back(id);
+            }
+            else if (PlanStage::NEED_FETCH == memberStatus) {
+                // Hold on to the rest of the batch until the page-in is done.
+                _pending.insert(_pending.end(), ids.begin() + i + 1, ids.begin() + numResults);
+                out->push_back(id);
+                return PlanStage::NEED_FETCH;
+            }
+        }
+
+        if (WorkingSet::INVALID_ID != _childFetchRequest) {
+            out->push_back(_childFetchRequest);
+            _childFetchRequest = WorkingSet::INVALID_ID;
+            ++_commonStats.needFetch;
+            return PlanStage::NEED_FETCH;
+        }
+
+        return status;
+    }
+
+    PlanStage::StageState FetchStage::fetchMember(WorkingSetID id, WorkingSetID* out) {
+        WorkingSetMember* member = _ws->get(id);
+
+        // If there's an obj there, there is no fetching to perform.
+        if (member->hasObj()) {
+            ++_specificStats.alreadyHasObj;
+            return returnIfMatches(member, id, out);
+        }
+
+        // We need a valid loc to fetch from and this is the only state that has one.
+        verify(WorkingSetMember::LOC_AND_IDX == member->state);
+        verify(member->hasLoc());
+
+        Record* record = member->loc.rec();
+        const char* data = record->dataNoThrowing();
+
+        if (!recordInMemory(data)) {
+            // member->loc points to a record that's NOT in memory.  Pass a fetch request up.
+            verify(WorkingSet::INVALID_ID == _idBeingPagedIn);
+            _idBeingPagedIn = id;
+            *out = id;
+            ++_commonStats.needFetch;
+            return PlanStage::NEED_FETCH;
+        }
+        else {
+            // Don't need index data anymore as we have an obj.
+            member->keyData.clear();
+            member->obj = BSONObj(data);
+            member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
+            return returnIfMatches(member, id, out);
+        }
+    }
+
+    void FetchStage::readAhead(const vector<WorkingSetID>& ids, size_t numIds) {
+        size_t remaining = static_cast<size_t>(std::max(0, internalQueryExecFetchReadAhead));
+        for (size_t i = 0; i < numIds && remaining > 0; ++i) {
+            WorkingSetMember* member = _ws->get(ids[i]);
+            if (member->hasObj() || !member->hasLoc()) { continue; }
+
+            // Asking where the record is doesn't touch it.  The header comes first, and we can't
+            // look at it to learn the length without faulting, so we just ask for its page.
+            Record* record = member->loc.rec();
+            if (recordInMemory(record->dataNoThrowing())) { continue; }
+
+            ProcessInfo::willNeed(record, Record::HeaderSize);
+            ++_specificStats.readAheads;
+            --remaining;
+        }
+    }
+
     void FetchStage::prepareToYield() {
         ++_commonStats.yields;
         _child->prepareToYield();
@@ -152,6 +252,16 @@ namespace mongo {
                 ++_specificStats.forcedFetches;
             }
         }
+
+        // Results held over from a batch may refer to the DiskLoc as well.
+        for (deque<WorkingSetID>::const_iterator it = _pending.begin(); it != _pending.end();
+             ++it) {
+            WorkingSetMember* member = _ws->get(*it);
+            if (member->hasLoc() && member->loc == dl) {
+                WorkingSetCommon::fetchAndInvalidateLoc(member);
+                ++_specificStats.forcedFetches;
+            }
+        }
     }
 
     PlanStage::StageState FetchStage::fetchCompleted(WorkingSetID* out) {
@@ -28,6 +28,9 @@
 
 #pragma once
 
+#include <deque>
+#include <vector>
+
 #include "mongo/db/diskloc.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/jsobj.h"
@@ -41,6 +44,11 @@ namespace mongo {
      * In WorkingSetMember terms, it transitions from LOC_AND_IDX to LOC_AND_UNOWNED_OBJ by reading
      * the record at the provided loc.  Returns verbatim any data that already has an object.
      *
+     * When working in batches, we look over the whole batch from our child before fetching any
+     * of it, and ask the OS to start reading in up to internalQueryExecFetchReadAhead records
+     * that aren't in memory.  By the time we get to them, and pass a page-in request up for the
+     * first, the rest are already on their way in.
+     *
      * Preconditions: Valid DiskLoc.
      */
     class FetchStage : public PlanStage {
@@ -50,6 +58,7 @@ namespace mongo {
 
         virtual bool isEOF();
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxWorks, std::vector<WorkingSetID>* out);
 
         virtual void prepareToYield();
         virtual void recoverFromYield();
@@ -65,6 +74,19 @@ namespace mongo {
         StageState returnIfMatches(WorkingSetMember* member, WorkingSetID memberID,
                                    WorkingSetID* out);
 
+        /**
+         * Fetch the object for the member with id 'id', a result from our child.  Returns
+         * NEED_FETCH (setting *out to 'id') if the record isn't in memory, otherwise the result of
+         * returnIfMatches.
+         */
+        StageState fetchMember(WorkingSetID id, WorkingSetID* out);
+
+        /**
+         * Hint to the OS that we'll soon read the records of the members with the first
+         * 'numIds' ids in 'ids', for those that aren't in memory.
+         */
+        void readAhead(const std::vector<WorkingSetID>& ids, size_t numIds);
+
         /**
          * work(...) delegates to this when we're called after requesting a fetch.
          */
@@ -81,6 +103,12 @@ namespace mongo {
         // a "please page this in" result and hold on to the WSID until the next call to work(...).
         WorkingSetID _idBeingPagedIn;
 
+        // If a batch from our child stops at a record that's not in memory, the rest of the
+        // batch waits here, and any page-in our child requested at the end of the batch waits in
+        // _childFetchRequest.  Both are handed out by work(...) after the page-in.
+        std::deque<WorkingSetID> _pending;
+        WorkingSetID _childFetchRequest;
+
         // Stats
         CommonStats _commonStats;
         FetchStats _specificStats;
@@ -29,10 +29,12 @@
 #include "mongo/db/exec/index_scan.h"
 
 #include "mongo/db/exec/filter.h"
+#include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/index/catalog_hack.h"
 #include "mongo/db/index/index_access_method.h"
 #include "mongo/db/index/index_cursor.h"
 #include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/stats/index_usage.h"
 
 namespace {
 
@@ -51,7 +53,7 @@ namespace mongo {
                          const MatchExpression* filter)
         : _workingSet(workingSet), _descriptor(params.descriptor), _hitEnd(false), _filter(filter), 
           _shouldDedup(params.descriptor->isMultikey()), _yieldMovedCursor(false), _params(params),
-          _btreeCursor(NULL) {
+          _btreeCursor(NULL), _indexNs(params.descriptor->indexNamespace()) {
 
         string amName;
 
@@ -76,6 +78,11 @@ namespace mongo {
             _shouldDedup = false;
         }
 
+        if (_params.skipPrefixLen > 0) {
+            verify(!_params.bounds.isSimpleRange);
+            verify(_params.skipPrefixLen <= _descriptor->keyPattern().nFields());
+        }
+
         _specificStats.indexType = "BtreeCursor"; // TODO amName;
         _specificStats.indexName = _descriptor->infoObj()["name"].String();
         _specificStats.indexBounds = _params.bounds.toBSON();
@@ -84,7 +91,34 @@ namespace mongo {
         _specificStats.keyPattern = _descriptor->keyPattern();
     }
 
+    IndexScan::~IndexScan() {
+        // The descriptor may be gone by now, so the index is named by what we saved from it.
+        IndexUsageTracker::global.recordScan(_indexNs, _specificStats.keysExamined);
+    }
+
     PlanStage::StageState IndexScan::work(WorkingSetID* out) {
+        ScopedTimer timer(&_commonStats);
+        return doWork(out);
+    }
+
+    PlanStage::StageState IndexScan::workBatch(size_t maxWorks, vector<WorkingSetID>* out) {
+        ScopedTimer timer(&_commonStats);
+        // Same as the default, but without a virtual call per unit of work.
+        StageState state = PlanStage::NEED_TIME;
+        for (size_t i = 0; i < maxWorks; ++i) {
+            WorkingSetID id;
+            state = doWork(&id);
+            if (PlanStage::ADVANCED == state) {
+                out->push_back(id);
+            }
+            else if (PlanStage::NEED_TIME != state) {
+                return state;
+            }
+        }
+        return state;
+    }
+
+    PlanStage::StageState IndexScan::doWork(WorkingSetID* out) {
         ++_commonStats.works;
 
         if (NULL == _indexCursor.get()) {
@@ -150,17 +184,26 @@ namespace mongo {
         }
         else if (_yieldMovedCursor) {
             _yieldMovedCursor = false;
-            // Note that we're not calling next() here.
+            // Note that we're not calling next() here.  A skip scan may have been moved onto
+            // another key with the prefix we just returned though.
+            if (!isEOF() && skipPastPrefix()) {
+                checkEnd();
+            }
         }
         else {
             // You're allowed to call work() even if the stage is EOF, but we can't call
             // _indexCursor->next() if we're EOF.
             if (!isEOF()) {
-                _indexCursor->next();
+                if (!skipPastPrefix()) {
+                    _indexCursor->next();
+                }
                 checkEnd();
             }
         }
 
+        // Only a returned key lets a skip scan pass over its prefix.
+        _skipPrefix = BSONObj();
+
         if (isEOF()) { return PlanStage::IS_EOF; }
 
         DiskLoc loc = _indexCursor->getValue();
@@ -188,6 +231,14 @@ namespace mongo {
             if (NULL != _filter) {
                 ++_specificStats.matchTested;
             }
+            if (_params.skipPrefixLen > 0) {
+                BSONObjBuilder prefix;
+                BSONObjIterator it(member->keyData.back().keyData);
+                for (int i = 0; i < _params.skipPrefixLen; ++i) {
+                    prefix.append(it.next());
+                }
+                _skipPrefix = prefix.obj();
+            }
             *out = id;
             ++_commonStats.advanced;
             return PlanStage::ADVANCED;
@@ -325,6 +376,25 @@ namespace mongo {
         }
     }
 
+    bool IndexScan::skipPastPrefix() {
+        if (_skipPrefix.isEmpty()) { return false; }
+
+        // Is the cursor still within the prefix?
+        BSONObjIterator prefix(_skipPrefix);
+        BSONObjIterator key(_indexCursor->getKey());
+        while (prefix.more()) {
+            if (0 != prefix.next().woCompare(key.next(), false)) { return false; }
+        }
+
+        // The prefix decides where we land, so the rest of the key isn't looked at.
+        int nFields = _descriptor->keyPattern().nFields();
+        vector<const BSONElement*> unusedEnd(nFields, NULL);
+        vector<bool> unusedInc(nFields, true);
+        _btreeCursor->skip(_skipPrefix, _params.skipPrefixLen, true, unusedEnd, unusedInc);
+        ++_specificStats.prefixesSkipped;
+        return true;
+    }
+
     PlanStageStats* IndexScan::getStats() {
         _commonStats.isEOF = isEOF();
         auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, STAGE_IXSCAN));
@@ -46,7 +46,8 @@ namespace mongo {
 
     struct IndexScanParams {
         IndexScanParams() : descriptor(NULL), direction(1), limit(0),
-                            forceBtreeAccessMethod(false), doNotDedup(false) { }
+                            forceBtreeAccessMethod(false), doNotDedup(false),
+                            skipPrefixLen(0) { }
 
         IndexDescriptor* descriptor;
 
@@ -61,6 +62,12 @@ namespace mongo {
         bool forceBtreeAccessMethod;
 
         bool doNotDedup;
+
+        // If non-zero, return only the first key that passes the filter for each distinct value
+        // of the first 'skipPrefixLen' key fields, seeking straight past the rest of the keys
+        // sharing that prefix.  Requires complex bounds (!bounds.isSimpleRange) since those are
+        // walked with a BtreeIndexCursor.
+        int skipPrefixLen;
     };
 
     /**
@@ -74,9 +81,10 @@ namespace mongo {
         IndexScan(const IndexScanParams& params, WorkingSet* workingSet,
                   const MatchExpression* filter);
 
-        virtual ~IndexScan() { }
+        virtual ~IndexScan();
 
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxWorks, std::vector<WorkingSetID>* out);
         virtual bool isEOF();
         virtual void prepareToYield();
         virtual void recoverFromYield();
@@ -85,9 +93,20 @@ namespace mongo {
         virtual PlanStageStats* getStats();
 
     private:
+        /**
+         * The body of work(...), which workBatch(...) calls directly.
+         */
+        StageState doWork(WorkingSetID* out);
+
         /** See if the cursor is pointing at or past _endKey, if _endKey is non-empty. */
         void checkEnd();
 
+        /**
+         * For skip scans, move the cursor past the keys sharing _skipPrefix if it points at one.
+         * Returns true if the cursor moved.
+         */
+        bool skipPastPrefix();
+
         // The WorkingSet we annotate with results.  Not owned by us.
         WorkingSet* _workingSet;
 
@@ -125,6 +144,13 @@ namespace mongo {
         vector<const BSONElement*> _keyElts;
         vector<bool> _keyEltsInc;
 
+        // For skip scans, the prefix of the last key returned, or empty if the last key examined
+        // wasn't returned.
+        BSONObj _skipPrefix;
+
+        // The namespace of the index, which its usage is recorded under.
+        string _indexNs;
+
         // Stats
         CommonStats _commonStats;
         IndexScanStats _specificStats;
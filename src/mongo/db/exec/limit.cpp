@@ -28,6 +28,8 @@
 
 #include "mongo/db/exec/limit.h"
 
+#include "mongo/db/exec/scoped_timer.h"
+
 namespace mongo {
 
     LimitStage::LimitStage(int limit, WorkingSet* ws, PlanStage* child)
@@ -38,6 +40,7 @@ namespace mongo {
     bool LimitStage::isEOF() { return (0 == _numToReturn) || _child->isEOF(); }
 
     PlanStage::StageState LimitStage::work(WorkingSetID* out) {
+        ScopedTimer timer(&_commonStats);
         ++_commonStats.works;
 
         // If we've returned as many results as we're limited to, isEOF will be true.
@@ -64,6 +67,31 @@ namespace mongo {
         }
     }
 
+    PlanStage::StageState LimitStage::workBatch(size_t maxWorks, vector<WorkingSetID>* out) {
+        ScopedTimer timer(&_commonStats);
+        ++_commonStats.works;
+
+        if (isEOF()) { return PlanStage::IS_EOF; }
+
+        // Each unit of work yields at most one result, so this keeps us within the limit.
+        if (_numToReturn > 0 && maxWorks > static_cast<size_t>(_numToReturn)) {
+            maxWorks = _numToReturn;
+        }
+
+        size_t numBefore = out->size();
+        StageState status = _child->workBatch(maxWorks, out);
+
+        size_t numResults = out->size() - numBefore;
+        if (PlanStage::NEED_FETCH == status) {
+            --numResults;
+            ++_commonStats.needFetch;
+        }
+
+        _numToReturn -= numResults;
+        _commonStats.advanced += numResults;
+        return status;
+    }
+
     void LimitStage::prepareToYield() {
         ++_commonStats.yields;
         _child->prepareToYield();
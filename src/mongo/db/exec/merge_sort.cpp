@@ -28,6 +28,7 @@
 
 #include "mongo/db/exec/merge_sort.h"
 
+#include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/exec/working_set_common.h"
 
@@ -55,6 +56,7 @@ namespace mongo {
     }
 
     PlanStage::StageState MergeSortStage::work(WorkingSetID* out) {
+        ScopedTimer timer(&_commonStats);
         ++_commonStats.works;
 
         if (isEOF()) { return PlanStage::IS_EOF; }
@@ -76,24 +76,38 @@ namespace mongo {
     }
 
     PlanStage::StageState OplogStart::workExtentHopping(WorkingSetID* out) {
-        if (_curloc.isNull()) {
-            _done = true;
-            return PlanStage::IS_EOF;
+        _done = true;
+
+        // The first records of the extents from _curloc's back to the oldest have decreasing
+        // timestamps, so those matching our query come first and we binary search for the first
+        // one that doesn't.  Walking the extents only touches their headers.
+        vector<DiskLoc> extentStarts;
+        for (DiskLoc loc = _curloc; !loc.isNull(); loc = prevExtentFirstLoc(_nsd, loc)) {
+            extentStarts.push_back(loc);
         }
 
-        if (!_filter->matchesBSON(_curloc.obj())) {
-            _done = true;
-            WorkingSetID id = _workingSet->allocate();
-            WorkingSetMember* member = _workingSet->get(id);
-            member->loc = _curloc;
-            member->obj = member->loc.obj();
-            member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
-            *out = id;
-            return PlanStage::ADVANCED;
+        size_t lo = 0;
+        size_t hi = extentStarts.size();
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (_filter->matchesBSON(extentStarts[mid].obj())) {
+                lo = mid + 1;
+            }
+            else {
+                hi = mid;
+            }
         }
 
-        _curloc = prevExtentFirstLoc(_nsd, _curloc);
-        return PlanStage::NEED_TIME;
+        // Everything matches.  Start from the beginning.
+        if (extentStarts.size() == lo) { return PlanStage::IS_EOF; }
+
+        WorkingSetID id = _workingSet->allocate();
+        WorkingSetMember* member = _workingSet->get(id);
+        member->loc = extentStarts[lo];
+        member->obj = member->loc.obj();
+        member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
+        *out = id;
+        return PlanStage::ADVANCED;
     }
 
     void OplogStart::switchToExtentHopping() {
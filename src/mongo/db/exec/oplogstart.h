@@ -51,7 +51,7 @@ namespace mongo {
      * normal reverse collection scan.  However, that's not fast enough.  Since we know all
      * documents are oriented on disk in insertion order, we know all documents in one extent were
      * inserted before documents in a subsequent extent.  As such we can skip through entire extents
-     * looking only at the first document.
+     * looking only at the first document, and binary search the extents for the one to start in.
      *
      * Why is this a stage?  Because we want to yield, and we want to be notified of DiskLoc
      * invalidations.  :(
@@ -85,7 +85,7 @@ namespace mongo {
         scoped_ptr<CollectionScan> _cs;
 
         // What's our current DiskLoc?  Set by both collscan and extent hopping.
-        // Only written by collscan, read and written by extent hopping.
+        // Only written by collscan, read by extent hopping.
         DiskLoc _curloc;
 
         // Have we done our heavy init yet?
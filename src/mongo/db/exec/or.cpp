@@ -28,11 +28,15 @@
 
 #include "mongo/db/exec/or.h"
 #include "mongo/db/exec/filter.h"
+#include "mongo/db/exec/scoped_timer.h"
+#include "mongo/db/exec/working_set_common.h"
 
 namespace mongo {
 
-    OrStage::OrStage(WorkingSet* ws, bool dedup, const MatchExpression* filter)
-        : _ws(ws), _filter(filter), _currentChild(0), _dedup(dedup) { }
+    OrStage::OrStage(WorkingSet* ws, bool dedup, const MatchExpression* filter,
+                     bool mergeByDiskLoc)
+        : _ws(ws), _filter(filter), _currentChild(0), _dedup(dedup),
+          _mergeByDiskLoc(mergeByDiskLoc) { }
 
     OrStage::~OrStage() {
         for (size_t i = 0; i < _children.size(); ++i) {
@@ -40,11 +44,24 @@ namespace mongo {
         }
     }
 
-    void OrStage::addChild(PlanStage* child) { _children.push_back(child); }
+    void OrStage::addChild(PlanStage* child) {
+        _children.push_back(child);
+        _pending.push_back(WorkingSet::INVALID_ID);
+        _childEOF.push_back(false);
+    }
 
-    bool OrStage::isEOF() { return _currentChild >= _children.size(); }
+    bool OrStage::isEOF() {
+        if (!_mergeByDiskLoc) { return _currentChild >= _children.size(); }
+
+        // We're done merging once every child is EOF and we've returned everything they gave us.
+        for (size_t i = 0; i < _children.size(); ++i) {
+            if (!_childEOF[i] || WorkingSet::INVALID_ID != _pending[i]) { return false; }
+        }
+        return true;
+    }
 
     PlanStage::StageState OrStage::work(WorkingSetID* out) {
+        ScopedTimer timer(&_commonStats);
         ++_commonStats.works;
 
         if (isEOF()) { return PlanStage::IS_EOF; }
@@ -53,6 +70,8 @@ namespace mongo {
             _specificStats.matchTested = vector<uint64_t>(_children.size(), 0);
         }
 
+        if (_mergeByDiskLoc) { return workMerging(out); }
+
         WorkingSetID id;
         StageState childStatus = _children[_currentChild]->work(&id);
 
@@ -121,6 +140,107 @@ namespace mongo {
         }
     }
 
+    PlanStage::StageState OrStage::workMerging(WorkingSetID* out) {
+        // We need a result from every child that isn't EOF before we can pick the smallest.
+        for (size_t i = 0; i < _children.size(); ++i) {
+            if (_childEOF[i] || WorkingSet::INVALID_ID != _pending[i]) { continue; }
+
+            WorkingSetID id;
+            StageState childStatus = _children[i]->work(&id);
+
+            if (PlanStage::ADVANCED == childStatus) {
+                WorkingSetMember* member = _ws->get(id);
+                verify(member->hasLoc());
+
+                // The children are in DiskLoc order, so a duplicate of something we've returned
+                // can only be of the last thing we returned.
+                if (_dedup) {
+                    ++_specificStats.dupsTested;
+                    if (!_lastLoc.isNull() && member->loc == _lastLoc) {
+                        ++_specificStats.dupsDropped;
+                        _ws->free(id);
+                        ++_commonStats.needTime;
+                        return PlanStage::NEED_TIME;
+                    }
+                }
+
+                _pending[i] = id;
+            }
+            else if (PlanStage::IS_EOF == childStatus) {
+                _childEOF[i] = true;
+            }
+            else {
+                if (PlanStage::NEED_FETCH == childStatus) {
+                    *out = id;
+                    ++_commonStats.needFetch;
+                }
+                else if (PlanStage::NEED_TIME == childStatus) {
+                    ++_commonStats.needTime;
+                }
+
+                // NEED_TIME, ERROR, NEED_YIELD, pass them up.
+                return childStatus;
+            }
+
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+
+        // Every child is EOF or has given us a result.  Pick the one with the smallest DiskLoc.
+        // A result that was invalidated while we held it has no DiskLoc; we return it right away.
+        size_t min = _children.size();
+        for (size_t i = 0; i < _children.size(); ++i) {
+            if (WorkingSet::INVALID_ID == _pending[i]) { continue; }
+
+            WorkingSetMember* member = _ws->get(_pending[i]);
+            if (!member->hasLoc()) {
+                min = i;
+                break;
+            }
+            if (_children.size() == min || member->loc < _ws->get(_pending[min])->loc) {
+                min = i;
+            }
+        }
+
+        if (_children.size() == min) { return PlanStage::IS_EOF; }
+
+        WorkingSetID id = _pending[min];
+        _pending[min] = WorkingSet::INVALID_ID;
+
+        WorkingSetMember* member = _ws->get(id);
+        if (_dedup && member->hasLoc()) {
+            _lastLoc = member->loc;
+            dropPendingDups(_lastLoc);
+        }
+
+        if (Filter::passes(member, _filter)) {
+            if (NULL != _filter) {
+                ++_specificStats.matchTested[min];
+            }
+            *out = id;
+            ++_commonStats.advanced;
+            return PlanStage::ADVANCED;
+        }
+        else {
+            _ws->free(id);
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+    }
+
+    void OrStage::dropPendingDups(const DiskLoc& loc) {
+        for (size_t i = 0; i < _pending.size(); ++i) {
+            if (WorkingSet::INVALID_ID == _pending[i]) { continue; }
+
+            WorkingSetMember* member = _ws->get(_pending[i]);
+            if (member->hasLoc() && loc == member->loc) {
+                ++_specificStats.dupsDropped;
+                _ws->free(_pending[i]);
+                _pending[i] = WorkingSet::INVALID_ID;
+            }
+        }
+    }
+
     void OrStage::prepareToYield() {
         ++_commonStats.yields;
         for (size_t i = 0; i < _children.size(); ++i) {
@@ -144,6 +264,27 @@ namespace mongo {
             _children[i]->invalidate(dl);
         }
 
+        if (_mergeByDiskLoc) {
+            // Go through the results we're holding and see if any of them is the invalidated loc.
+            for (size_t i = 0; i < _pending.size(); ++i) {
+                if (WorkingSet::INVALID_ID == _pending[i]) { continue; }
+
+                WorkingSetMember* member = _ws->get(_pending[i]);
+                if (member->hasLoc() && dl == member->loc) {
+                    WorkingSetCommon::fetchAndInvalidateLoc(member);
+                    ++_specificStats.forcedFetches;
+                }
+            }
+
+            // If we see DL again it is not the same record as it once was so we still want to
+            // return it.
+            if (_dedup && dl == _lastLoc) {
+                ++_specificStats.locsForgotten;
+                _lastLoc = DiskLoc();
+            }
+            return;
+        }
+
         // If we see DL again it is not the same record as it once was so we still want to
         // return it.
         if (_dedup) {
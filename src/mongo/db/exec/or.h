@@ -39,13 +39,17 @@ namespace mongo {
     /**
      * This stage outputs the union of its children.  It optionally deduplicates on DiskLoc.
      *
+     * If 'mergeByDiskLoc' is set, every child must output its results in DiskLoc order (an index
+     * scan over one point, say).  The children are then merged and the output is in DiskLoc order
+     * too, which lets us dedup by remembering only the last DiskLoc returned instead of every one.
+     *
      * Preconditions: Valid DiskLoc.
      *
      * If we're deduping, we may fail to dedup any invalidated DiskLoc properly.
      */
     class OrStage : public PlanStage {
     public:
-        OrStage(WorkingSet* ws, bool dedup, const MatchExpression* filter);
+        OrStage(WorkingSet* ws, bool dedup, const MatchExpression* filter, bool mergeByDiskLoc);
         virtual ~OrStage();
 
         void addChild(PlanStage* child);
@@ -61,6 +65,11 @@ namespace mongo {
         virtual PlanStageStats* getStats();
 
     private:
+        StageState workMerging(WorkingSetID* out);
+
+        // Frees any other pending result with the DiskLoc we're about to return.
+        void dropPendingDups(const DiskLoc& loc);
+
         // Not owned by us.
         WorkingSet* _ws;
 
@@ -76,9 +85,24 @@ namespace mongo {
         // True if we dedup on DiskLoc, false otherwise.
         bool _dedup;
 
-        // Which DiskLocs have we returned?
+        // Which DiskLocs have we returned?  Unused when merging.
         unordered_set<DiskLoc, DiskLoc::Hasher> _seen;
 
+        // True if our children are sorted by DiskLoc and we merge them, false if we read them one
+        // after the other.
+        bool _mergeByDiskLoc;
+
+        // When merging, the result each child gave us that we haven't returned yet, or INVALID_ID
+        // if we need to work the child for one.
+        vector<WorkingSetID> _pending;
+
+        // When merging, which children are EOF?
+        vector<bool> _childEOF;
+
+        // When merging and deduping, the last DiskLoc we returned.  Any duplicate of it is the
+        // next thing out of some child.
+        DiskLoc _lastLoc;
+
         // Stats
         CommonStats _commonStats;
         OrStats _specificStats;
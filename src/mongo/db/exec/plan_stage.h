@@ -28,6 +28,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/exec/working_set.h"
 
@@ -167,6 +169,38 @@ namespace mongo {
          */
         virtual StageState work(WorkingSetID* out) = 0;
 
+        /**
+         * Perform up to 'maxWorks' units of work, appending each result produced to 'out'.  This
+         * is equivalent to calling work(...) up to 'maxWorks' times and collecting the ids it
+         * ADVANCEs, stopping early at the first state other than ADVANCED or NEED_TIME.
+         *
+         * Returns the state of the last unit of work performed.  The ids appended to 'out' are
+         * results whatever the state, with one exception: if NEED_FETCH is returned, the last id
+         * appended is the member to page in (with the same semantics as for work(...)) rather
+         * than a result.
+         *
+         * Stages that can produce results more cheaply in bulk override this.  The default
+         * simply loops over work(...).
+         */
+        virtual StageState workBatch(size_t maxWorks, std::vector<WorkingSetID>* out) {
+            StageState state = PlanStage::NEED_TIME;
+            for (size_t i = 0; i < maxWorks; ++i) {
+                WorkingSetID id;
+                state = work(&id);
+                if (PlanStage::ADVANCED == state) {
+                    out->push_back(id);
+                }
+                else if (PlanStage::NEED_FETCH == state) {
+                    out->push_back(id);
+                    return state;
+                }
+                else if (PlanStage::NEED_TIME != state) {
+                    return state;
+                }
+            }
+            return state;
+        }
+
         /**
          * Returns true if no more work can be done on the query / out of results.
          */
@@ -51,6 +51,9 @@ namespace mongo {
                         advanced(0),
                         needTime(0),
                         needFetch(0),
+                        executionTimeMicros(0),
+                        cpuTimeMicros(0),
+                        majorFaults(0),
                         isEOF(false) { }
 
         // Count calls into the stage.
@@ -67,8 +70,12 @@ namespace mongo {
         // TODO: have some way of tracking WSM sizes (or really any series of #s).  We can measure
         // the size of our inputs and the size of our outputs.  We can do a lot with the WS here.
 
-        // TODO: once we've picked a plan, collect different (or additional) stats for display to
-        // the user, eg. time_t totalTimeSpent;
+        // Time spent in work(...) and the major page faults taken there, including those of any
+        // children.  Only measured if internalQueryExecStageTiming is set (see scoped_timer.h),
+        // and the CPU time and faults only where per-thread usage is available.
+        uint64_t executionTimeMicros;
+        uint64_t cpuTimeMicros;
+        uint64_t majorFaults;
 
         // TODO: keep track of total yield time / fetch time for a plan (done by runner)
 
@@ -77,7 +84,9 @@ namespace mongo {
 
     // The universal container for a stage's stats.
     struct PlanStageStats {
-        PlanStageStats(const CommonStats& c, StageType t) : stageType(t), common(c) { }
+        PlanStageStats(const CommonStats& c, StageType t) : stageType(t),
+                                                            common(c),
+                                                            workingSetPeak(0) { }
 
         ~PlanStageStats() {
             for (size_t i = 0; i < children.size(); ++i) {
@@ -97,6 +106,10 @@ namespace mongo {
         // The stats of the node's children.
         std::vector<PlanStageStats*> children;
 
+        // The most WorkingSetMembers the plan has had allocated at once.  Only filled in for the
+        // root of the tree, by the PlanExecutor that owns the WorkingSet.
+        size_t workingSetPeak;
+
     private:
         MONGO_DISALLOW_COPYING(PlanStageStats);
     };
@@ -153,10 +166,37 @@ namespace mongo {
         uint64_t matchTested;
     };
 
+    struct CountScanStats : public SpecificStats {
+        CountScanStats() : isMultiKey(false),
+                           keysExamined(0),
+                           dupsTested(0),
+                           dupsDropped(0),
+                           yieldMovedCursor(0) { }
+
+        virtual ~CountScanStats() { }
+
+        // name of the index being used
+        std::string indexName;
+
+        BSONObj keyPattern;
+
+        // A BSON (opaque, ie. hands off other than toString() it) representation of the bounds
+        // used.
+        BSONObj indexBounds;
+
+        bool isMultiKey;
+
+        uint64_t keysExamined;
+        uint64_t dupsTested;
+        uint64_t dupsDropped;
+        uint64_t yieldMovedCursor;
+    };
+
     struct FetchStats : public SpecificStats {
         FetchStats() : alreadyHasObj(0),
                        forcedFetches(0),
-                       matchTested(0) { }
+                       matchTested(0),
+                       readAheads(0) { }
 
         virtual ~FetchStats() { }
 
@@ -172,6 +212,9 @@ namespace mongo {
 
         // We know how many passed (it's the # of advanced) and therefore how many failed.
         uint64_t matchTested;
+
+        // How many records not in memory did we ask the OS to start reading in ahead of time?
+        uint64_t readAheads;
     };
 
     struct IndexScanStats : public SpecificStats {
@@ -181,7 +224,8 @@ namespace mongo {
                            dupsDropped(0),
                            seenInvalidated(0),
                            matchTested(0),
-                           keysExamined(0) { }
+                           keysExamined(0),
+                           prefixesSkipped(0) { }
 
         virtual ~IndexScanStats() { }
 
@@ -217,12 +261,16 @@ namespace mongo {
         // Number of entries retrieved from the index during the scan.
         uint64_t keysExamined;
 
+        // How many times did a skip scan seek past the rest of a key prefix?
+        uint64_t prefixesSkipped;
+
     };
 
     struct OrStats : public SpecificStats {
         OrStats() : dupsTested(0),
                     dupsDropped(0),
-                    locsForgotten(0) { }
+                    locsForgotten(0),
+                    forcedFetches(0) { }
 
         virtual ~OrStats() { }
 
@@ -232,17 +280,24 @@ namespace mongo {
         // How many calls to invalidate(...) actually removed a DiskLoc from our deduping map?
         uint64_t locsForgotten;
 
+        // How many results held while merging were we forced to fetch as the result of an
+        // invalidation?
+        uint64_t forcedFetches;
+
         // We know how many passed (it's the # of advanced) and therefore how many failed.
         std::vector<uint64_t> matchTested;
     };
 
     struct SortStats : public SpecificStats {
-        SortStats() : forcedFetches(0) { }
+        SortStats() : forcedFetches(0), spilled(false) { }
 
         virtual ~SortStats() { }
 
         // How many records were we forced to fetch as the result of an invalidation?
         uint64_t forcedFetches;
+
+        // Did we run out of memory and hand our data to the external sorter?
+        bool spilled;
     };
 
     struct MergeSortStats : public SpecificStats {
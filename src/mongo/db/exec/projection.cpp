@@ -31,6 +31,7 @@
 #include "mongo/db/diskloc.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/projection_executor.h"
+#include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression.h"
 
@@ -45,6 +46,7 @@ namespace mongo {
     bool ProjectionStage::isEOF() { return _child->isEOF(); }
 
     PlanStage::StageState ProjectionStage::work(WorkingSetID* out) {
+        ScopedTimer timer(&_commonStats);
         ++_commonStats.works;
 
         if (isEOF()) { return PlanStage::IS_EOF; }
@@ -69,6 +71,43 @@ namespace mongo {
         return status;
     }
 
+    PlanStage::StageState ProjectionStage::workBatch(size_t maxWorks,
+                                                     vector<WorkingSetID>* out) {
+        ScopedTimer timer(&_commonStats);
+        // Project a whole batch from our child, so that its child can work in batches too.
+        if (isEOF()) { return PlanStage::IS_EOF; }
+
+        size_t firstResult = out->size();
+        StageState status = _child->workBatch(maxWorks, out);
+
+        size_t numResults = out->size() - firstResult;
+        if (PlanStage::NEED_FETCH == status) {
+            // The last id is a page-in request, not a result.
+            --numResults;
+            ++_commonStats.needFetch;
+        }
+
+        for (size_t i = firstResult; i < firstResult + numResults; ++i) {
+            ++_commonStats.works;
+            WorkingSetMember* member = _ws->get((*out)[i]);
+            Status projStatus = ProjectionExecutor::apply(_projection, member);
+            if (!projStatus.isOK()) {
+                warning() << "Couldn't execute projection: " << projStatus.toString() << endl;
+                // Whoever asked for the batch frees the results before this one.
+                for (size_t j = i; j < out->size(); ++j) {
+                    if (PlanStage::NEED_FETCH != status || j + 1 < out->size()) {
+                        _ws->free((*out)[j]);
+                    }
+                }
+                out->resize(i);
+                return PlanStage::FAILURE;
+            }
+            ++_commonStats.advanced;
+        }
+
+        return status;
+    }
+
     void ProjectionStage::prepareToYield() {
         ++_commonStats.yields;
         _child->prepareToYield();
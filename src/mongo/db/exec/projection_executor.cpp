@@ -48,6 +48,26 @@ namespace mongo {
     // static
     Status ProjectionExecutor::applyFindSyntax(const FindProjection* proj, WorkingSetMember* wsm) {
         BSONObjBuilder bob;
+
+        // Including top-level fields from a document is the common case.  Rather than look up
+        // each field, walk the document once and copy over the elements we want.
+        if (proj->_includeTopLevelOnly && wsm->hasObj()) {
+            const unordered_set<StringData, StringData::Hasher>& fields = proj->_includedTopLevel;
+            BSONObjIterator it(wsm->obj);
+            while (it.more()) {
+                BSONElement elt = it.next();
+                if (fields.end() != fields.find(elt.fieldNameStringData())) {
+                    bob.append(elt);
+                }
+            }
+
+            wsm->state = WorkingSetMember::OWNED_OBJ;
+            wsm->obj = bob.obj();
+            wsm->keyData.clear();
+            wsm->loc = DiskLoc();
+            return Status::OK();
+        }
+
         if (proj->_includeID) {
             BSONElement elt;
             if (!wsm->getFieldDotted("_id", &elt)) {
@@ -30,6 +30,7 @@
 
 #include "mongo/db/exec/fetch.h"
 #include "mongo/db/exec/index_scan.h"
+#include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/geo/geoconstants.h"
 #include "mongo/db/index/catalog_hack.h"
@@ -91,6 +92,7 @@ namespace mongo {
     }
 
     PlanStage::StageState S2NearStage::work(WorkingSetID* out) {
+        ScopedTimer timer(&_commonStats);
         if (_failed) { return PlanStage::FAILURE; }
         if (isEOF()) { return PlanStage::IS_EOF; }
         ++_commonStats.works;
@@ -146,6 +148,13 @@ namespace mongo {
                                          S1Angle::Radians(_innerRadius / kRadiusOfEarthInMeters));
         _outerCap = S2Cap::FromAxisAngle(_nearQuery.centroid.point,
                                          S1Angle::Radians(_outerRadius / kRadiusOfEarthInMeters));
+
+        // Everything closer than _innerRadius was looked at by the annuli before this one (or is
+        // closer than _minDistance), so cells of the covering entirely in there need not be read
+        // again.  A hair smaller so that documents exactly on the inner edge are found.
+        S2Cap scanned = S2Cap::FromAxisAngle(_nearQuery.centroid.point,
+            S1Angle::Radians(_innerRadius * (1 - 1E-9) / kRadiusOfEarthInMeters));
+
         _innerCap = _innerCap.Complement();
 
         vector<S2Region*> regions;
@@ -156,7 +165,8 @@ namespace mongo {
         _annulus.Init(&regions);
 
         _baseBounds.fields[_nearFieldIndex].intervals.clear();
-        ExpressionMapping::cover2dsphere(_annulus, &_baseBounds.fields[_nearFieldIndex]);
+        ExpressionMapping::cover2dsphere(_annulus, scanned,
+                                         &_baseBounds.fields[_nearFieldIndex]);
 
         // Step 3: Actually create the ixscan.
         // TODO: Cache params.
@@ -0,0 +1,80 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/exec/plan_stats.h"
+#include "mongo/platform/cstdint.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+    // Set by the internalQueryExecStageTiming server parameter.
+    extern bool internalQueryExecStageTiming;
+
+    /**
+     * Adds the wall time, CPU time and major page faults spent in its scope to a stage's
+     * CommonStats.  Stages put one at the top of work(...) and of any workBatch(...) that doesn't
+     * go through work(...).  As children are worked from inside their parents' work(...), the
+     * figures for a stage include those of its children.
+     *
+     * Reading the clocks costs a couple of system calls per unit of work, so nothing is measured
+     * unless internalQueryExecStageTiming is set.
+     */
+    class ScopedTimer {
+        MONGO_DISALLOW_COPYING(ScopedTimer);
+    public:
+        explicit ScopedTimer(CommonStats* stats) : _stats(NULL) {
+            if (internalQueryExecStageTiming) {
+                start(stats);
+            }
+        }
+
+        ~ScopedTimer() {
+            if (NULL != _stats) {
+                stop();
+            }
+        }
+
+    private:
+        void start(CommonStats* stats);
+        void stop();
+
+        // Where to add what was measured, or NULL if we're not measuring.  Not owned here.
+        CommonStats* _stats;
+
+        Timer _timer;
+
+        // Whether per-thread usage is available, and if so what it was at the start.
+        bool _haveUsage;
+        uint64_t _startCpuMicros;
+        uint64_t _startMajorFaults;
+    };
+
+}  // namespace mongo
@@ -28,6 +28,8 @@
 
 #include "mongo/db/exec/skip.h"
 
+#include "mongo/db/exec/scoped_timer.h"
+
 namespace mongo {
 
     SkipStage::SkipStage(int toSkip, WorkingSet* ws, PlanStage* child)
@@ -38,6 +40,7 @@ namespace mongo {
     bool SkipStage::isEOF() { return _child->isEOF(); }
 
     PlanStage::StageState SkipStage::work(WorkingSetID* out) {
+        ScopedTimer timer(&_commonStats);
         ++_commonStats.works;
 
         if (isEOF()) { return PlanStage::IS_EOF; }
@@ -72,6 +75,34 @@ namespace mongo {
         }
     }
 
+    PlanStage::StageState SkipStage::workBatch(size_t maxWorks, vector<WorkingSetID>* out) {
+        ScopedTimer timer(&_commonStats);
+        ++_commonStats.works;
+
+        if (isEOF()) { return PlanStage::IS_EOF; }
+
+        vector<WorkingSetID> ids;
+        StageState status = _child->workBatch(maxWorks, &ids);
+
+        size_t numResults = ids.size();
+        if (PlanStage::NEED_FETCH == status) {
+            --numResults;
+            ++_commonStats.needFetch;
+        }
+
+        // Drop results from the front of the batch while we're still skipping.
+        size_t numSkipped = 0;
+        while (_toSkip > 0 && numSkipped < numResults) {
+            _ws->free(ids[numSkipped]);
+            --_toSkip;
+            ++numSkipped;
+        }
+
+        out->insert(out->end(), ids.begin() + numSkipped, ids.end());
+        _commonStats.advanced += numResults - numSkipped;
+        return status;
+    }
+
     void SkipStage::prepareToYield() {
         ++_commonStats.yields;
         _child->prepareToYield();
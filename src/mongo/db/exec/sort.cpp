@@ -25,69 +25,104 @@
  *    exception statement from all source files in the program, then also delete
  *    it in the license file.
  */
-
 #include "mongo/db/exec/sort.h"
 
 #include <algorithm>
 
+#include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage_options.h"
+#include "mongo/util/log.h"
 
 namespace mongo {
 
-    const size_t kMaxBytes = 32 * 1024 * 1024;
+    // How much data we buffer before spilling to the external sorter (or failing, if we can't).
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecMaxBlockingSortBytes, int, 32 * 1024 * 1024);
 
-    // Used in STL sort.
-    struct WorkingSetComparison {
-        WorkingSetComparison(WorkingSet* ws, BSONObj pattern) : _ws(ws), _pattern(pattern) { }
+    // May a sort that outgrows internalQueryExecMaxBlockingSortBytes spill to disk?
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecAllowExternalSort, bool, true);
 
-        bool operator()(const WorkingSetID& lhs, const WorkingSetID& rhs) const {
-            WorkingSetMember* lhsMember = _ws->get(lhs);
-            WorkingSetMember* rhsMember = _ws->get(rhs);
+    // Threads the external sorter may use to sort a batch before spilling it and to merge spilled
+    // files.  SortKeyComparator needs nothing from the thread it runs on.
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecSortThreads, int, 4);
 
-            BSONObjIterator it(_pattern);
-            while (it.more()) {
-                BSONElement patternElt = it.next();
-                string fn = patternElt.fieldName();
+    namespace {
 
-                BSONElement lhsElt;
-                verify(lhsMember->getFieldDotted(fn, &lhsElt));
+        /**
+         * Pack the data of 'member' into an owned object that the Sorter can write to disk.
+         */
+        BSONObj encodeMember(const WorkingSetMember* member) {
+            BSONObjBuilder bob;
+            if (member->hasObj()) {
+                bob.append("o", member->obj);
+            }
+            else {
+                verify(WorkingSetMember::LOC_AND_IDX == member->state);
+                bob.append("l", member->loc.toBSONObj());
+                BSONArrayBuilder keys(bob.subarrayStart("k"));
+                for (size_t i = 0; i < member->keyData.size(); ++i) {
+                    const IndexKeyDatum& datum = member->keyData[i];
+                    keys.append(BSON("p" << datum.indexKeyPattern << "d" << datum.keyData));
+                }
+                keys.done();
+            }
+            return bob.obj();
+        }
 
-                BSONElement rhsElt;
-                verify(rhsMember->getFieldDotted(fn, &rhsElt));
+        /**
+         * Fill out 'member' from an object made by encodeMember.  We can't track the DiskLoc of
+         * a document once it's been spilled, so it comes back as an OWNED_OBJ.
+         */
+        void decodeMember(const BSONObj& encoded, WorkingSetMember* member) {
+            BSONElement obj = encoded["o"];
+            if (!obj.eoo()) {
+                member->obj = obj.Obj().getOwned();
+                member->state = WorkingSetMember::OWNED_OBJ;
+                return;
+            }
 
-                // false means don't compare field name.
-                int x = lhsElt.woCompare(rhsElt, false);
-                if (-1 == patternElt.number()) { x = -x; }
-                if (x != 0) { return x < 0; }
+            BSONObj loc = encoded["l"].Obj();
+            member->loc = DiskLoc(loc["file"].numberInt(), loc["offset"].numberInt());
+            BSONObjIterator it(encoded["k"].Obj());
+            while (it.more()) {
+                BSONObj datum = it.next().Obj();
+                member->keyData.push_back(IndexKeyDatum(datum["p"].Obj().getOwned(),
+                                                        datum["d"].Obj().getOwned()));
             }
+            member->state = WorkingSetMember::LOC_AND_IDX;
+        }
 
-            // A comparator for use with sort is required to model a strict weak ordering, so
-            // to satisfy irreflexivity we must return 'false' for elements that we consider
-            // equivalent under the pattern.
-            return false;
+        size_t maxBytes() {
+            return static_cast<size_t>(std::max(0, internalQueryExecMaxBlockingSortBytes));
         }
 
-        WorkingSet* _ws;
-        BSONObj _pattern;
-    };
+    }  // namespace
 
     SortStage::SortStage(const SortStageParams& params, WorkingSet* ws, PlanStage* child)
-        : _ws(ws), _child(child), _pattern(params.pattern), _sorted(false),
-          _resultIterator(_data.end()), _memUsage(0) { }
+        : _ws(ws), _child(child), _pattern(params.pattern), _limit(params.limit),
+          _cmp(params.pattern), _sorted(false), _resultIterator(_data.end()), _memUsage(0) { }
 
     SortStage::~SortStage() { }
 
     bool SortStage::isEOF() {
+        if (!_child->isEOF() || !_sorted) { return false; }
+
         // We're done when our child has no more results, we've sorted the child's results, and
         // we've returned all sorted results.
-        return _child->isEOF() && _sorted && (_data.end() == _resultIterator);
+        if (NULL != _sortedIterator.get()) {
+            return !_sortedIterator->more();
+        }
+        return _data.end() == _resultIterator;
     }
 
     PlanStage::StageState SortStage::work(WorkingSetID* out) {
+        ScopedTimer timer(&_commonStats);
         ++_commonStats.works;
 
-        if (_memUsage > kMaxBytes) {
+        // We only stay over the limit if we're not allowed to spill.
+        if (_memUsage > maxBytes()) {
             return PlanStage::FAILURE;
         }
 
@@ -99,33 +134,26 @@ namespace mongo {
             StageState code = _child->work(&id);
 
             if (PlanStage::ADVANCED == code) {
-                // We let the data stay in the WorkingSet and sort using the IDs.
-                _data.push_back(id);
-
-                // Add it into the map for quick invalidation if it has a valid DiskLoc.
-                // A DiskLoc may be invalidated at any time (during a yield).  We need to get into
-                // the WorkingSet as quickly as possible to handle it.
-                WorkingSetMember* member = _ws->get(id);
-                if (member->hasLoc()) {
-                    _wsidByDiskLoc[member->loc] = id;
-                }
-
-                // Do some accounting to make sure we're not using too much memory.
-                if (member->hasLoc()) {
-                    _memUsage += sizeof(DiskLoc);
+                if (!addToBuffer(id)) {
+                    warning() << "sort stage buffered " << _memUsage << " bytes, more than the "
+                              << maxBytes() << " allowed, and can't spill to disk" << endl;
+                    return PlanStage::FAILURE;
                 }
-
-                if (member->hasObj()) {
-                    _memUsage += member->obj.objsize();
-                }
-
                 ++_commonStats.needTime;
                 return PlanStage::NEED_TIME;
             }
             else if (PlanStage::IS_EOF == code) {
                 // TODO: We don't need the lock for this.  We could ask for a yield and do this work
                 // unlocked.  Also, this is performing a lot of work for one call to work(...)
-                std::sort(_data.begin(), _data.end(), WorkingSetComparison(_ws, _pattern));
+                if (NULL != _sorter.get()) {
+                    _sortedIterator.reset(_sorter->done());
+                }
+                else if (0 != _limit) {
+                    std::sort_heap(_data.begin(), _data.end(), ItemLessThan(&_cmp));
+                }
+                else {
+                    std::sort(_data.begin(), _data.end(), ItemLessThan(&_cmp));
+                }
                 _resultIterator = _data.begin();
                 _sorted = true;
                 ++_commonStats.needTime;
@@ -144,9 +172,20 @@ namespace mongo {
         }
 
         // Returning results.
-        verify(_resultIterator != _data.end());
         verify(_sorted);
-        *out = *_resultIterator++;
+
+        if (NULL != _sortedIterator.get()) {
+            verify(_sortedIterator->more());
+            SpillSorter::Iterator::Data data = _sortedIterator->next();
+            *out = _ws->allocate();
+            decodeMember(data.second, _ws->get(*out));
+            ++_commonStats.advanced;
+            return PlanStage::ADVANCED;
+        }
+
+        verify(_resultIterator != _data.end());
+        *out = _resultIterator->wsid;
+        ++_resultIterator;
 
         // If we're returning something, take it out of our DL -> WSID map so that future
         // calls to invalidate don't cause us to take action for a DL we're done with.
@@ -159,6 +198,109 @@ namespace mongo {
         return PlanStage::ADVANCED;
     }
 
+    BSONObj SortStage::getSortKey(WorkingSetMember* member) const {
+        BSONObjBuilder bob;
+        BSONObjIterator it(_pattern);
+        while (it.more()) {
+            BSONElement patternElt = it.next();
+            BSONElement elt;
+            verify(member->getFieldDotted(patternElt.fieldName(), &elt));
+            if (elt.eoo()) {
+                bob.appendNull("");
+            }
+            else {
+                bob.appendAs(elt, "");
+            }
+        }
+        return bob.obj();
+    }
+
+    bool SortStage::addToBuffer(WorkingSetID id) {
+        WorkingSetMember* member = _ws->get(id);
+
+        SortableDataItem item;
+        item.wsid = id;
+        item.sortKey = getSortKey(member);
+
+        // Once we've spilled everything goes straight to the Sorter.
+        if (NULL != _sorter.get()) {
+            _sorter->add(item.sortKey, encodeMember(member));
+            _ws->free(id);
+            return true;
+        }
+
+        // We let the data stay in the WorkingSet and sort using the IDs.  Add it into the map for
+        // quick invalidation if it has a valid DiskLoc.  A DiskLoc may be invalidated at any time
+        // (during a yield).  We need to get into the WorkingSet as quickly as possible to handle
+        // it.
+        if (member->hasLoc()) {
+            _wsidByDiskLoc[member->loc] = id;
+        }
+
+        // Do some accounting to make sure we're not using too much memory.
+        item.memUsage = item.sortKey.objsize();
+        if (member->hasLoc()) {
+            item.memUsage += sizeof(DiskLoc);
+        }
+        if (member->hasObj()) {
+            item.memUsage += member->obj.objsize();
+        }
+        for (size_t i = 0; i < member->keyData.size(); ++i) {
+            item.memUsage += member->keyData[i].keyData.objsize();
+        }
+        _memUsage += item.memUsage;
+
+        _data.push_back(item);
+
+        // With a limit we only need the best '_limit' results.  Drop the worst.
+        if (0 != _limit) {
+            std::push_heap(_data.begin(), _data.end(), ItemLessThan(&_cmp));
+            if (_data.size() > _limit) {
+                std::pop_heap(_data.begin(), _data.end(), ItemLessThan(&_cmp));
+                const SortableDataItem& worst = _data.back();
+                WorkingSetMember* worstMember = _ws->get(worst.wsid);
+                if (worstMember->hasLoc()) {
+                    _wsidByDiskLoc.erase(worstMember->loc);
+                }
+                _memUsage -= worst.memUsage;
+                _ws->free(worst.wsid);
+                _data.pop_back();
+            }
+        }
+
+        if (_memUsage > maxBytes()) {
+            if (!internalQueryExecAllowExternalSort) {
+                return false;
+            }
+            spill();
+        }
+
+        return true;
+    }
+
+    void SortStage::spill() {
+        verify(NULL == _sorter.get());
+        _specificStats.spilled = true;
+
+        SortOptions opts;
+        opts.TempDir(storageGlobalParams.dbpath + "/_tmp")
+            .ExtSortAllowed()
+            .MaxMemoryUsageBytes(maxBytes())
+            .Limit(_limit)
+            .SortThreads(static_cast<unsigned>(std::max(1, internalQueryExecSortThreads)));
+        _sorter.reset(SpillSorter::make(opts, _cmp));
+
+        for (size_t i = 0; i < _data.size(); ++i) {
+            _sorter->add(_data[i].sortKey, encodeMember(_ws->get(_data[i].wsid)));
+            _ws->free(_data[i].wsid);
+        }
+
+        _data.clear();
+        _resultIterator = _data.end();
+        _wsidByDiskLoc.clear();
+        _memUsage = 0;
+    }
+
     void SortStage::prepareToYield() {
         ++_commonStats.yields;
         _child->prepareToYield();
@@ -176,6 +318,8 @@ namespace mongo {
         // _data contains indices into the WorkingSet, not actual data.  If a WorkingSetMember in
         // the WorkingSet needs to change state as a result of a DiskLoc invalidation, it will still
         // be at the same spot in the WorkingSet.  As such, we don't need to modify _data.
+        //
+        // Whatever we've spilled has no DiskLoc to invalidate.
 
         DataMap::iterator it = _wsidByDiskLoc.find(dl);
 
@@ -198,3 +342,6 @@ namespace mongo {
     }
 
 }  // namespace mongo
+
+#include "mongo/db/sorter/sorter.cpp"
+MONGO_CREATE_SORTER(mongo::BSONObj, mongo::BSONObj, mongo::SortKeyComparator);
@@ -34,6 +34,7 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher.h"
 #include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/sorter/sorter.h"
 #include "mongo/platform/unordered_map.h"
 
 namespace mongo {
@@ -41,9 +42,40 @@ namespace mongo {
     // External params for the sort stage.  Declared below.
     class SortStageParams;
 
+    /**
+     * Orders sort keys according to a sort pattern.  Used both for the results we buffer in memory
+     * and by the Sorter we spill to.
+     */
+    class SortKeyComparator {
+    public:
+        explicit SortKeyComparator(const BSONObj& pattern) : _ordering(Ordering::make(pattern)) { }
+
+        // Used by the Sorter.
+        int operator()(const std::pair<BSONObj, BSONObj>& lhs,
+                       const std::pair<BSONObj, BSONObj>& rhs) const {
+            return compare(lhs.first, rhs.first);
+        }
+
+        int compare(const BSONObj& lhs, const BSONObj& rhs) const {
+            // false means don't compare field name.
+            return lhs.woCompare(rhs, _ordering, false);
+        }
+
+    private:
+        Ordering _ordering;
+    };
+
     /**
      * Sorts the input received from the child according to the sort pattern provided.
      *
+     * If the sort has a limit, only the best 'limit' results are kept, in a heap.
+     *
+     * Results are buffered in the WorkingSet until they use more than
+     * internalQueryExecMaxBlockingSortBytes.  Past that, if internalQueryExecAllowExternalSort
+     * is set, everything buffered and everything still to come is handed to a Sorter which may
+     * spill to disk.  Otherwise the stage fails.  A spilled result no longer has a DiskLoc to
+     * invalidate: documents come back as OWNED_OBJ and index keys as LOC_AND_IDX.
+     *
      * Preconditions: For each field in 'pattern', all inputs in the child must handle a
      * getFieldDotted for that field.
      */
@@ -63,6 +95,45 @@ namespace mongo {
         PlanStageStats* getStats();
 
     private:
+        typedef Sorter<BSONObj, BSONObj> SpillSorter;
+
+        // A buffered result and the key it sorts by.
+        struct SortableDataItem {
+            WorkingSetID wsid;
+            BSONObj sortKey;
+
+            // What this item adds to _memUsage.
+            size_t memUsage;
+        };
+
+        // Orders SortableDataItems for the STL sort and heap algorithms.
+        class ItemLessThan {
+        public:
+            explicit ItemLessThan(const SortKeyComparator* cmp) : _cmp(cmp) { }
+            bool operator()(const SortableDataItem& lhs, const SortableDataItem& rhs) const {
+                return _cmp->compare(lhs.sortKey, rhs.sortKey) < 0;
+            }
+        private:
+            const SortKeyComparator* _cmp;
+        };
+
+        /**
+         * Extract the values of the sort pattern's fields from 'member', with missing fields
+         * as null.
+         */
+        BSONObj getSortKey(WorkingSetMember* member) const;
+
+        /**
+         * Add a result that the child produced.  Returns false if we're out of memory and not
+         * allowed to spill.
+         */
+        bool addToBuffer(WorkingSetID id);
+
+        /**
+         * Move everything buffered into a new Sorter and free it from the WorkingSet.
+         */
+        void spill();
+
         // Not owned by us.
         WorkingSet* _ws;
 
@@ -72,14 +143,26 @@ namespace mongo {
         // Our sort pattern.
         BSONObj _pattern;
 
-        // We read the child into this.
-        vector<WorkingSetID> _data;
+        // Equal to 0 for no limit.
+        size_t _limit;
+
+        SortKeyComparator _cmp;
+
+        // We read the child into this.  With a limit, this is a max-heap so that the worst result
+        // is the one we drop.
+        vector<SortableDataItem> _data;
 
         // Have we sorted our data?
         bool _sorted;
 
         // Iterates through _data post-sort returning it.
-        vector<WorkingSetID>::iterator _resultIterator;
+        vector<SortableDataItem>::iterator _resultIterator;
+
+        // Non-NULL once we've spilled.  Everything is then sorted by the Sorter instead of _data.
+        scoped_ptr<SpillSorter> _sorter;
+
+        // Iterates through the Sorter's output post-sort.
+        scoped_ptr<SpillSorter::Iterator> _sortedIterator;
 
         // We buffer a lot of data and we want to look it up by DiskLoc quickly upon invalidation.
         typedef unordered_map<DiskLoc, WorkingSetID, DiskLoc::Hasher> DataMap;
@@ -96,14 +179,13 @@ namespace mongo {
     // Parameters that must be provided to a SortStage
     class SortStageParams {
     public:
-        //SortStageParams() : limit(0) { }
+        SortStageParams() : limit(0) { }
 
         // How we're sorting.
         BSONObj pattern;
 
-        // TODO: Implement this.
         // Must be >= 0.  Equal to 0 for no limit.
-        // int limit;
+        int limit;
     };
 
 }  // namespace mongo
@@ -72,7 +72,8 @@ namespace mongo {
      *
      * node -> {andHash: {filter: {filter}, args: { nodes: [node, node]}}}
      * node -> {andSorted: {filter: {filter}, args: { nodes: [node, node]}}}
-     * node -> {or: {filter: {filter}, args: { dedup:bool, nodes:[node, node]}}}
+     * node -> {or: {filter: {filter}, args: { dedup:bool, nodes:[node, node],
+     *                                   mergeByDiskLoc:bool (optional)}}}
      * node -> {fetch: {filter: {filter}, args: {node: node}}}
      * node -> {limit: {args: {node: node, num: posint}}}
      * node -> {skip: {args: {node: node, num: posint}}}
@@ -248,7 +249,8 @@ namespace mongo {
                         !nodeArgs["dedup"].eoo());
                 BSONObjIterator it(nodeArgs["nodes"].Obj());
                 auto_ptr<OrStage> orStage(new OrStage(workingSet, nodeArgs["dedup"].Bool(),
-                                                      matcher));
+                                                      matcher,
+                                                      nodeArgs["mergeByDiskLoc"].trueValue()));
                 while (it.more()) {
                     BSONElement e = it.next();
                     if (!e.isABSONObj()) { return NULL; }
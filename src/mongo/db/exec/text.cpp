@@ -28,12 +28,17 @@
 
 #include "mongo/db/exec/text.h"
 #include "mongo/db/exec/filter.h"
+#include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/query/internal_plans.h"
 
 namespace mongo {
 
+    // Queries for at most this many results only score the documents that could make them,
+    // see readTopResults().
+    static const size_t kMaxTopResultsLimit = 1000;
+
     TextStage::TextStage(const TextStageParams& params, WorkingSet* ws,
                          const MatchExpression* filter)
         : _params(params), _ftsMatcher(params.query, params.spec), _ws(ws), _filter(filter),
@@ -51,6 +56,7 @@ namespace mongo {
     }
 
     PlanStage::StageState TextStage::work(WorkingSetID* out) {
+        ScopedTimer timer(&_commonStats);
         ++_commonStats.works;
         if (isEOF()) { return PlanStage::IS_EOF; }
 
@@ -134,6 +140,22 @@ namespace mongo {
             scanners.push_back(ixscan);
         }
 
+        const bool readTop = _params.limit > 0 && _params.limit <= kMaxTopResultsLimit;
+        const bool ok = readTop ? readTopResults(scanners) : readAllResults(scanners);
+        for (size_t i=0; i<scanners.size(); ++i) { delete scanners[i]; }
+        if (!ok) {
+            return PlanStage::FAILURE;
+        }
+
+        _filledOutResults = true;
+
+        if (_results.size() == 0) {
+            return PlanStage::IS_EOF;
+        }
+        return PlanStage::NEED_TIME;
+    }
+
+    bool TextStage::readAllResults(const vector<IndexScan*>& scanners) {
         // For each index scan, read all results and store scores.
         size_t currentIndexScanner = 0;
         while (currentIndexScanner < scanners.size()) {
@@ -162,13 +184,10 @@ namespace mongo {
             else {
                 verify(PlanStage::FAILURE == state);
                 warning() << "error from index scan during text stage: invalid FAILURE state";
-                for (size_t i=0; i<scanners.size(); ++i) { delete scanners[i]; }
-                return PlanStage::FAILURE;
+                return false;
             }
         }
-        for (size_t i=0; i<scanners.size(); ++i) { delete scanners[i]; }
 
-        // Filter for phrases and negative terms, score and truncate.
         for (ScoreMap::iterator i = _scores.begin(); i != _scores.end(); ++i) {
             DiskLoc loc = i->first;
             double score = i->second;
@@ -178,32 +197,115 @@ namespace mongo {
                 continue;
             }
 
-            // Filter for phrases and negated terms
-            if (_params.query.hasNonTermPieces()) {
-                Record* rec_p = loc.rec();
-                if (!_ftsMatcher.matchesNonTerm(BSONObj::make(rec_p))) {
-                    continue;
-                }
-            }
             _results.push_back(ScoredLocation(loc, score));
         }
 
         // Sort results by score (not always in correct order, especially w.r.t. multiterm).
         sort(_results.begin(), _results.end());
 
+        // Filter for phrases and negated terms.  These need the document, so go down the
+        // results only as far as it takes to keep as many as we return.
+        if (_params.query.hasNonTermPieces()) {
+            size_t numKept = 0;
+            for (size_t i = 0; i < _results.size() && numKept < _params.limit; ++i) {
+                Record* rec_p = _results[i].loc.rec();
+                if (_ftsMatcher.matchesNonTerm(BSONObj::make(rec_p))) {
+                    _results[numKept++] = _results[i];
+                }
+            }
+            _results.resize(numKept);
+        }
+
         if (_results.size() > _params.limit) {
             _results.resize(_params.limit);
         }
 
-        _filledOutResults = true;
+        return true;
+    }
 
-        if (_results.size() == 0) {
-            return PlanStage::IS_EOF;
+    bool TextStage::readTopResults(const vector<IndexScan*>& scanners) {
+        // Each scan returns the postings of its term by descending score, so a document that
+        // none of them has reached yet can't score more than the sum of their latest scores.
+        // This is the "threshold algorithm": a document is scored in full, from the document
+        // itself, the first time any scan reaches it, and we stop once we have enough
+        // documents scoring above that sum.
+        vector<double> latestScores(scanners.size(), MAX_WEIGHT);
+        vector<bool> exhausted(scanners.size(), false);
+        size_t numExhausted = 0;
+
+        // The best documents so far, the lowest ranked on top.
+        std::priority_queue<ScoredLocation> top;
+
+        while (numExhausted < scanners.size()) {
+            for (size_t i = 0; i < scanners.size(); ++i) {
+                if (exhausted[i]) {
+                    continue;
+                }
+
+                WorkingSetID id;
+                PlanStage::StageState state = scanners[i]->work(&id);
+
+                if (PlanStage::ADVANCED == state) {
+                    WorkingSetMember* wsm = _ws->get(id);
+                    const DiskLoc loc = wsm->loc;
+                    latestScores[i] = getTermScore(wsm->keyData.back().keyData);
+                    _ws->free(id);
+
+                    // Already scored, or rejected, through another term.
+                    if (!_scores.insert(ScoreMap::value_type(loc, -1)).second) {
+                        continue;
+                    }
+
+                    double score;
+                    if (!matchAndScore(loc, latestScores[i], &score)) {
+                        continue;
+                    }
+                    _scores[loc] = score;
+
+                    top.push(ScoredLocation(loc, score));
+                    if (top.size() > _params.limit) {
+                        top.pop();
+                    }
+                }
+                else if (PlanStage::IS_EOF == state) {
+                    exhausted[i] = true;
+                    latestScores[i] = 0;
+                    ++numExhausted;
+                }
+                else if (PlanStage::NEED_FETCH == state) {
+                    // We're calling work() on ixscans and they have no way to return a fetch.
+                    verify(false);
+                }
+                else if (PlanStage::NEED_TIME == state) {
+                    // We are a blocking stage, so ignore scanner's request for more time.
+                }
+                else {
+                    verify(PlanStage::FAILURE == state);
+                    warning() << "error from index scan during text stage: invalid FAILURE state";
+                    return false;
+                }
+            }
+
+            // Ties with a document not seen yet would be broken by DiskLoc, so only a strictly
+            // higher score is known to stay.
+            double threshold = 0;
+            for (size_t i = 0; i < latestScores.size(); ++i) {
+                threshold += latestScores[i];
+            }
+            if (top.size() == _params.limit && top.top().score > threshold) {
+                break;
+            }
         }
-        return PlanStage::NEED_TIME;
+
+        while (!top.empty()) {
+            _results.push_back(top.top());
+            top.pop();
+        }
+        std::reverse(_results.begin(), _results.end());
+        return true;
     }
 
-    void TextStage::filterAndScore(BSONObj key, DiskLoc loc) {
+    double TextStage::getTermScore(const BSONObj& key) const {
         // Locate score within possibly compound key: {prefix,term,score,suffix}.
         BSONObjIterator keyIt(key);
         for (unsigned i = 0; i < _params.spec.numExtraBefore(); i++) {
@@ -212,8 +314,52 @@ namespace mongo {
 
         keyIt.next(); // Skip past 'term'.
 
-        BSONElement scoreElement = keyIt.next();
-        double documentTermScore = scoreElement.number();
+        return keyIt.next().number();
+    }
+
+    bool TextStage::matchAndScore(const DiskLoc& loc, double termScore, double* score) {
+        const vector<string>& terms = _params.query.getTerms();
+        const bool needDocument = terms.size() > 1 || _filter
+            || _params.query.hasNonTermPieces();
+        if (!needDocument) {
+            *score = termScore;
+            return true;
+        }
+
+        BSONObj doc = BSONObj::make(loc.rec());
+
+        if (_filter) {
+            MatchDetails d;
+            if (!_filter->matchesBSON(doc, &d)) {
+                return false;
+            }
+        }
+
+        if (_params.query.hasNonTermPieces() && !_ftsMatcher.matchesNonTerm(doc)) {
+            return false;
+        }
+
+        if (terms.size() == 1) {
+            *score = termScore;
+            return true;
+        }
+
+        // Score the document as its index keys were made, adding up the terms in the order
+        // readAllResults() would.
+        fts::TermFrequencyMap termScores;
+        _params.spec.scoreDocument(doc, _params.spec.defaultLanguage(), "", false, &termScores);
+        *score = 0;
+        for (size_t i = 0; i < terms.size(); ++i) {
+            fts::TermFrequencyMap::const_iterator it = termScores.find(terms[i]);
+            if (it != termScores.end()) {
+                *score += it->second;
+            }
+        }
+        return true;
+    }
+
+    void TextStage::filterAndScore(BSONObj key, DiskLoc loc) {
+        double documentTermScore = getTermScore(key);
         double& documentAggregateScore = _scores[loc];
         
         // Handle filtering.
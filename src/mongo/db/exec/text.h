@@ -80,6 +80,8 @@ namespace mongo {
      * Prerequisites: None; is a leaf node.
      * Output type: LOC_AND_OBJ_UNOWNED.
      */
+    class IndexScan;
+
     class TextStage : public PlanStage {
     public:
         TextStage(const TextStageParams& params, WorkingSet* ws, const MatchExpression* filter);
@@ -117,6 +119,23 @@ namespace mongo {
         // IS_EOF, or FAILURE.
         StageState fillOutResults();
 
+        // Reads every posting from 'scanners' into _scores, then fills out _results.  Returns
+        // false on a scan failure.
+        bool readAllResults(const vector<IndexScan*>& scanners);
+
+        // Fills out _results with the top _params.limit documents, reading the scanners in
+        // turn only until no document they have yet to reach could make it.  Returns false on
+        // a scan failure.
+        bool readTopResults(const vector<IndexScan*>& scanners);
+
+        // Returns the term score stored in a text index key.
+        double getTermScore(const BSONObj& key) const;
+
+        // Returns whether the document at 'loc' matches this stage's filter, phrases and negated
+        // terms, and sets 'score' to its score for the query terms.  'termScore' is the score
+        // of a posting for it; it is the whole score of a one term query.
+        bool matchAndScore(const DiskLoc& loc, double termScore, double* score);
+
         // Helper to update _scores with a new-found (term, score) pair for this document.  Also
         // rejects documents that don't match this stage's filter.
         void filterAndScore(BSONObj key, DiskLoc loc);
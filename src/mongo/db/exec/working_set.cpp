@@ -28,37 +28,76 @@
 
 #include "mongo/db/exec/working_set.h"
 
+#include <algorithm>
+
 #include "mongo/db/index/index_descriptor.h"
 
 namespace mongo {
 
     const WorkingSetID WorkingSet::INVALID_ID = -1;
 
-    WorkingSet::WorkingSet() : _nextId(0) { }
+    // static
+    const size_t WorkingSet::kMembersPerSlab = 128;
+
+    // static
+    const WorkingSetID WorkingSet::kInUse = -2;
+
+    WorkingSet::WorkingSet() : _freeListHead(INVALID_ID), _inUse(0), _peakInUse(0) { }
 
     WorkingSet::~WorkingSet() {
-        for (DataMap::const_iterator i = _data.begin(); i != _data.end(); ++i) {
-            delete i->second;
+        for (size_t i = 0; i < _slabs.size(); ++i) {
+            delete[] _slabs[i];
         }
     }
 
+    void WorkingSet::addSlab() {
+        verify(INVALID_ID == _freeListHead);
+
+        WorkingSetID firstId = _nextFree.size();
+        _slabs.push_back(new WorkingSetMember[kMembersPerSlab]);
+
+        // Thread the new members onto the free list in order.
+        _nextFree.reserve(_nextFree.size() + kMembersPerSlab);
+        for (size_t i = 1; i < kMembersPerSlab; ++i) {
+            _nextFree.push_back(firstId + i);
+        }
+        _nextFree.push_back(INVALID_ID);
+        _freeListHead = firstId;
+    }
+
     WorkingSetID WorkingSet::allocate() {
-        verify(_data.end() == _data.find(_nextId));
-        _data[_nextId] = new WorkingSetMember();
-        return _nextId++;
+        if (INVALID_ID == _freeListHead) {
+            addSlab();
+        }
+
+        WorkingSetID id = _freeListHead;
+        _freeListHead = _nextFree[id];
+        _nextFree[id] = kInUse;
+        if (++_inUse > _peakInUse) {
+            _peakInUse = _inUse;
+        }
+        return id;
     }
 
     WorkingSetMember* WorkingSet::get(const WorkingSetID& i) {
-        DataMap::iterator it = _data.find(i);
-        verify(_data.end() != it);
-        return it->second;
+        verify(i >= 0 && static_cast<size_t>(i) < _nextFree.size());
+        verify(kInUse == _nextFree[i]);
+        return &_slabs[i / kMembersPerSlab][i % kMembersPerSlab];
     }
 
     void WorkingSet::free(const WorkingSetID& i) {
-        DataMap::iterator it = _data.find(i);
-        verify(_data.end() != it);
-        delete it->second;
-        _data.erase(it);
+        WorkingSetMember* member = get(i);
+
+        // Drop what the member refers to but hang on to its buffers for the next user.
+        member->loc = DiskLoc();
+        member->obj = BSONObj();
+        member->keyData.clear();
+        member->clearFieldOffsets();
+        member->state = WorkingSetMember::INVALID;
+
+        _nextFree[i] = _freeListHead;
+        _freeListHead = i;
+        --_inUse;
     }
 
     void WorkingSet::flagForReview(const WorkingSetID& i) {
@@ -71,7 +110,12 @@ namespace mongo {
         return _flagged;
     }
 
-    WorkingSetMember::WorkingSetMember() : state(WorkingSetMember::INVALID) { }
+    // static
+    const int WorkingSetMember::kMinFieldsToIndex = 16;
+
+    WorkingSetMember::WorkingSetMember() : state(WorkingSetMember::INVALID),
+                                           _indexedObjData(NULL),
+                                           _lookupsIntoObj(0) { }
 
     bool WorkingSetMember::hasLoc() const {
         return state == LOC_AND_IDX || state == LOC_AND_UNOWNED_OBJ;
@@ -92,7 +136,18 @@ namespace mongo {
     bool WorkingSetMember::getFieldDotted(const string& field, BSONElement* out) const {
         // If our state is such that we have an object, use it.
         if (hasObj()) {
-            *out = obj.getFieldDotted(field);
+            if (_indexedObjData != obj.objdata()) {
+                clearFieldOffsets();
+                _indexedObjData = obj.objdata();
+            }
+
+            // A single lookup is cheapest with a plain scan.
+            if (++_lookupsIntoObj < 2) {
+                *out = obj.getFieldDotted(field);
+                return true;
+            }
+
+            *out = getFieldDottedIndexed(field);
             return true;
         }
 
@@ -116,4 +171,62 @@ namespace mongo {
         return false;
     }
 
+    void WorkingSetMember::clearFieldOffsets() {
+        _indexedObjData = NULL;
+        _lookupsIntoObj = 0;
+        _fieldOffsets.clear();
+    }
+
+    namespace {
+        bool fieldOffsetNameLess(const pair<StringData, int>& lhs,
+                                 const pair<StringData, int>& rhs) {
+            return lhs.first < rhs.first;
+        }
+    }
+
+    BSONElement WorkingSetMember::getTopLevelFieldIndexed(const StringData& name) const {
+        if (_fieldOffsets.empty()) {
+            if (2 == _lookupsIntoObj) {
+                if (obj.nFields() >= kMinFieldsToIndex) {
+                    _fieldOffsets.reserve(obj.nFields());
+                    BSONObjIterator it(obj);
+                    while (it.more()) {
+                        BSONElement e = it.next();
+                        _fieldOffsets.push_back(
+                            FieldOffset(e.fieldName(), e.rawdata() - obj.objdata()));
+                    }
+                    // Stable so that a repeated name finds its first field, as a scan would.
+                    std::stable_sort(_fieldOffsets.begin(), _fieldOffsets.end(),
+                                     fieldOffsetNameLess);
+                }
+            }
+            if (_fieldOffsets.empty())
+                return obj.getField(name);
+        }
+
+        vector<FieldOffset>::const_iterator it =
+            std::lower_bound(_fieldOffsets.begin(), _fieldOffsets.end(), FieldOffset(name, 0),
+                             fieldOffsetNameLess);
+        if (it == _fieldOffsets.end() || it->first != name)
+            return BSONElement();
+        return BSONElement(obj.objdata() + it->second);
+    }
+
+    BSONElement WorkingSetMember::getFieldDottedIndexed(const StringData& field) const {
+        // The same steps as BSONObj::getFieldDotted(), with the top-level lookups indexed.
+        BSONElement e = getTopLevelFieldIndexed(field);
+        if (e.eoo()) {
+            size_t dotOffset = field.find('.');
+            if (dotOffset != string::npos) {
+                BSONElement left = getTopLevelFieldIndexed(field.substr(0, dotOffset));
+                if (left.type() != Object && left.type() != Array)
+                    return BSONElement();
+                BSONObj sub = left.embeddedObject();
+                return sub.isEmpty() ? BSONElement()
+                                     : sub.getFieldDotted(field.substr(dotOffset + 1));
+            }
+        }
+        return e;
+    }
+
 }  // namespace mongo
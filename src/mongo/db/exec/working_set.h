@@ -28,10 +28,12 @@
 
 #pragma once
 
+#include <utility>
 #include <vector>
+
+#include "mongo/base/disallow_copying.h"
 #include "mongo/db/diskloc.h"
 #include "mongo/db/jsobj.h"
-#include "mongo/platform/unordered_map.h"
 
 namespace mongo {
 
@@ -43,8 +45,13 @@ namespace mongo {
      * All data in use by a query.  Data is passed through the stage tree by referencing the ID of
      * an element of the working set.  Stages can add elements to the working set, delete elements
      * from the working set, or mutate elements in the working set.
+     *
+     * Members are allocated in slabs and never move, so a WorkingSetMember* stays valid until its
+     * ID is freed.  IDs are indices into the slabs.  Freed members go on a free list and are
+     * reused by later calls to allocate(), keeping the capacity of their keyData.
      */
     class WorkingSet {
+        MONGO_DISALLOW_COPYING(WorkingSet);
     public:
         static const WorkingSetID INVALID_ID;
 
@@ -81,14 +88,37 @@ namespace mongo {
          */
         const vector<WorkingSetID>& getFlagged() const;
 
+        /**
+         * Returns the most members that have been allocated at once.
+         */
+        size_t getPeakSize() const { return _peakInUse; }
+
     private:
-        typedef unordered_map<WorkingSetID, WorkingSetMember*> DataMap;
+        // How many members are in each slab.
+        static const size_t kMembersPerSlab;
+
+        // Marks an in-use ID in _nextFree.
+        static const WorkingSetID kInUse;
+
+        /**
+         * Add a new slab and put its members on the free list.
+         */
+        void addSlab();
+
+        // Owned here.  Each points to kMembersPerSlab members.
+        vector<WorkingSetMember*> _slabs;
+
+        // For each ID, the next ID on the free list (INVALID_ID at the end of the list), or kInUse
+        // if the ID has been allocated.
+        vector<WorkingSetID> _nextFree;
 
-        DataMap _data;
+        // The WorkingSetID returned by the next call to allocate(), or INVALID_ID if there are no
+        // free members left.
+        WorkingSetID _freeListHead;
 
-        // The WorkingSetID returned by the next call to allocate().  Should refer to the next valid
-        // ID.  IDs allocated contiguously.  Should never point at an in-use ID.  
-        WorkingSetID _nextId;
+        // How many members are allocated now, and the most that ever have been.
+        size_t _inUse;
+        size_t _peakInUse;
 
         // All WSIDs invalidated during evaluation of a predicate (AND).
         vector<WorkingSetID> _flagged;
@@ -155,8 +185,36 @@ namespace mongo {
          * object.  *out is set to the element if so.
          *
          * Returns false otherwise.  Returning false indicates a query planning error.
+         *
+         * Sort, merge and projection stages look up several fields in the same object, so from
+         * the second lookup into a wide object on, the top-level field is found by binary search
+         * in a table of field offsets rather than by scanning the object.
          */
         bool getFieldDotted(const string& field, BSONElement* out) const;
+
+        /**
+         * Forget the field offsets of the current object.  Called when the member is freed.
+         */
+        void clearFieldOffsets();
+
+    private:
+        // Objects with fewer top-level fields than this are always scanned.
+        static const int kMinFieldsToIndex;
+
+        typedef std::pair<StringData, int> FieldOffset;
+
+        BSONElement getFieldDottedIndexed(const StringData& field) const;
+        BSONElement getTopLevelFieldIndexed(const StringData& name) const;
+
+        // The field lookups below are only good for the object whose data is '_indexedObjData'.
+        // An object assigned to 'obj' is built while the previous one is still held there, so a
+        // new object never has the data pointer of the one before it.
+        mutable const char* _indexedObjData;
+        mutable int _lookupsIntoObj;
+
+        // The top-level fields of 'obj' by name, first occurrence first, as offsets from its
+        // start.  Empty until built, or if the object is too narrow to be worth it.
+        mutable vector<FieldOffset> _fieldOffsets;
     };
 
 }  // namespace mongo
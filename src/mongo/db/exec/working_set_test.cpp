@@ -30,31 +30,36 @@
  * This file contains tests for mongo/db/exec/working_set.cpp
  */
 
+#include <boost/scoped_ptr.hpp>
+
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/json.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/mongoutils/str.h"
 
 using namespace mongo;
+using boost::scoped_ptr;
 
 namespace {
 
     class WorkingSetFixture : public mongo::unittest::Test {
     protected:
         void setUp() {
-            WorkingSetID id = ws.allocate();
+            ws.reset(new WorkingSet());
+            WorkingSetID id = ws->allocate();
             ASSERT(id != WorkingSet::INVALID_ID);
-            member = ws.get(id);
+            member = ws->get(id);
             ASSERT(NULL != member);
         }
 
         void tearDown() {
-            ws = WorkingSet();
+            ws.reset();
             member = NULL;
         }
 
-        WorkingSet ws;
+        scoped_ptr<WorkingSet> ws;
         WorkingSetMember* member;
     };
 
@@ -144,4 +149,98 @@ namespace {
         ASSERT_FALSE(member->getFieldDotted("y", &elt));
     }
 
+    TEST_F(WorkingSetFixture, getFieldFromWideObject) {
+        BSONObjBuilder bob;
+        for (int i = 0; i < 200; ++i) {
+            bob.append(string(mongoutils::str::stream() << "f" << i), i);
+        }
+        bob.append("sub", BSON("x" << 1 << "y" << BSON("z" << 2)));
+        bob.append("arr", BSON_ARRAY(3 << 4));
+        bob.append("f7", "repeated");
+        bob.append("a.b", "dotted");
+        bob.append("a", BSON("b" << "nested"));
+        member->obj = bob.obj();
+        member->state = WorkingSetMember::OWNED_OBJ;
+
+        // Every lookup gives what BSONObj::getFieldDotted would, before and after the field
+        // offsets are built.
+        const char* fields[] = { "f0", "f199", "f7", "sub.x", "sub.y.z", "sub.q", "arr.1",
+                                 "arr.2", "f3.x", "a.b", "missing", "missing.too" };
+        for (int pass = 0; pass < 2; ++pass) {
+            for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); ++i) {
+                BSONElement elt;
+                ASSERT_TRUE(member->getFieldDotted(fields[i], &elt));
+                BSONElement expected = member->obj.getFieldDotted(fields[i]);
+                ASSERT_EQUALS(expected.eoo(), elt.eoo());
+                if (!expected.eoo()) {
+                    ASSERT_EQUALS(expected.rawdata(), elt.rawdata());
+                }
+            }
+        }
+
+        // A different object replaces the offsets of the old one.
+        member->obj = BSON("f0" << "new" << "f1" << "object");
+        BSONElement elt;
+        for (int i = 0; i < 3; ++i) {
+            ASSERT_TRUE(member->getFieldDotted("f1", &elt));
+            ASSERT_EQUALS(string("object"), elt.String());
+            ASSERT_TRUE(member->getFieldDotted("f199", &elt));
+            ASSERT_TRUE(elt.eoo());
+        }
+    }
+
+    TEST(WorkingSetTest, freedIdsAreReused) {
+        WorkingSet ws;
+        WorkingSetID first = ws.allocate();
+        WorkingSetID second = ws.allocate();
+        ASSERT_NOT_EQUALS(first, second);
+
+        WorkingSetMember* member = ws.get(first);
+        member->state = WorkingSetMember::OWNED_OBJ;
+        member->obj = BSON("a" << 1);
+        ws.free(first);
+
+        // The freed member comes back, cleared out.
+        ASSERT_EQUALS(first, ws.allocate());
+        ASSERT_EQUALS(WorkingSetMember::INVALID, member->state);
+        ASSERT_TRUE(member->obj.isEmpty());
+        ASSERT_TRUE(member->keyData.empty());
+    }
+
+    TEST(WorkingSetTest, membersDontMove) {
+        WorkingSet ws;
+        vector<WorkingSetID> ids;
+        vector<WorkingSetMember*> members;
+
+        // Allocate enough to span several slabs.
+        for (int i = 0; i < 1000; ++i) {
+            WorkingSetID id = ws.allocate();
+            WorkingSetMember* member = ws.get(id);
+            member->state = WorkingSetMember::OWNED_OBJ;
+            member->obj = BSON("a" << i);
+            ids.push_back(id);
+            members.push_back(member);
+        }
+
+        for (int i = 0; i < 1000; ++i) {
+            ASSERT_EQUALS(members[i], ws.get(ids[i]));
+            ASSERT_EQUALS(i, members[i]->obj["a"].numberInt());
+        }
+    }
+
+    TEST(WorkingSetTest, peakSize) {
+        WorkingSet ws;
+        ASSERT_EQUALS(0U, ws.getPeakSize());
+
+        WorkingSetID first = ws.allocate();
+        WorkingSetID second = ws.allocate();
+        ws.free(first);
+        ws.free(second);
+        ASSERT_EQUALS(2U, ws.getPeakSize());
+
+        // Reusing freed members doesn't raise the peak.
+        ws.allocate();
+        ASSERT_EQUALS(2U, ws.getPeakSize());
+    }
+
 }  // namespace
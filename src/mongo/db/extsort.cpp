@@ -77,14 +77,54 @@ namespace mongo {
     }
 
     BSONObjExternalSorter::BSONObjExternalSorter(const ExternalSortComparison* comp,
-                                                 long maxFileSize)
-        : _mayInterrupt(boost::make_shared<bool>(false))
-        , _sorter(Sorter<BSONObj, DiskLoc>::make(
-                    SortOptions().TempDir(storageGlobalParams.dbpath + "/_tmp")
-                                 .ExtSortAllowed()
-                                 .MaxMemoryUsageBytes(maxFileSize),
-                    OldExtSortComparator(comp, _mayInterrupt)))
-    {}
+                                                 long maxFileSize,
+                                                 int nRuns)
+        : _comp(comp)
+        , _opts(SortOptions().TempDir(storageGlobalParams.dbpath + "/_tmp")
+                             .ExtSortAllowed()
+                             .MaxMemoryUsageBytes(maxFileSize / nRuns))
+        , _mayInterrupt(boost::make_shared<bool>(false))
+    {
+        verify(nRuns >= 1);
+        _runs.push_back(shared_ptr<Sorter<BSONObj, DiskLoc> >(Sorter<BSONObj, DiskLoc>::make(
+                            _opts, OldExtSortComparator(comp, _mayInterrupt))));
+
+        // The other runs are added to off the client's thread, where checking is impossible.
+        boost::shared_ptr<const bool> neverInterrupt = boost::make_shared<bool>(false);
+        for (int i = 1; i < nRuns; ++i) {
+            _runs.push_back(shared_ptr<Sorter<BSONObj, DiskLoc> >(Sorter<BSONObj, DiskLoc>::make(
+                                _opts, OldExtSortComparator(comp, neverInterrupt))));
+        }
+    }
+
+    auto_ptr<BSONObjExternalSorter::Iterator> BSONObjExternalSorter::iterator() {
+        if (_runs.size() == 1) {
+            return auto_ptr<Iterator>(_runs[0]->done());
+        }
+
+        std::vector<boost::shared_ptr<Iterator> > iters;
+        for (size_t i = 0; i < _runs.size(); ++i) {
+            iters.push_back(boost::shared_ptr<Iterator>(_runs[i]->done()));
+        }
+        return auto_ptr<Iterator>(Iterator::merge(iters, _opts,
+                                                  OldExtSortComparator(_comp, _mayInterrupt)));
+    }
+
+    int BSONObjExternalSorter::numFiles() {
+        int n = 0;
+        for (size_t i = 0; i < _runs.size(); ++i) {
+            n += _runs[i]->numFiles();
+        }
+        return n;
+    }
+
+    long BSONObjExternalSorter::getCurSizeSoFar() {
+        long size = 0;
+        for (size_t i = 0; i < _runs.size(); ++i) {
+            size += _runs[i]->memUsed();
+        }
+        return size;
+    }
 }
 
 #include "mongo/db/sorter/sorter.cpp"
@@ -64,23 +64,40 @@ namespace mongo {
         typedef pair<BSONObj, DiskLoc> Data;
         typedef SortIteratorInterface<BSONObj, DiskLoc> Iterator;
 
-        BSONObjExternalSorter(const ExternalSortComparison* comp, long maxFileSize=100*1024*1024);
+        /**
+         * With nRuns > 1 the data is sorted as that many independent runs, each limited to
+         * maxFileSize / nRuns of memory, which iterator() merges.
+         */
+        BSONObjExternalSorter(const ExternalSortComparison* comp, long maxFileSize=100*1024*1024,
+                              int nRuns=1);
 
         void add( const BSONObj& o, const DiskLoc& loc, bool mayInterrupt ) {
             *_mayInterrupt = mayInterrupt;
-            _sorter->add(o.getOwned(), loc);
+            _runs[0]->add(o.getOwned(), loc);
         }
 
-        auto_ptr<Iterator> iterator() { return auto_ptr<Iterator>(_sorter->done()); }
+        /**
+         * Adds to one of the runs.  Different threads may add to different runs at once, and
+         * runs other than the first never check for interrupts.
+         */
+        void addToRun( int run, const BSONObj& o, const DiskLoc& loc ) {
+            _runs[run]->add(o.getOwned(), loc);
+        }
+
+        int numRuns() const { return _runs.size(); }
+
+        auto_ptr<Iterator> iterator();
 
         void sort( bool mayInterrupt ) { *_mayInterrupt = mayInterrupt; }
-        int numFiles() { return _sorter->numFiles(); }
-        long getCurSizeSoFar() { return _sorter->memUsed(); }
+        int numFiles();
+        long getCurSizeSoFar();
         void hintNumObjects(long long) {} // unused
 
     private:
+        const ExternalSortComparison* _comp;
+        const SortOptions _opts;
         shared_ptr<bool> _mayInterrupt;
-        scoped_ptr<Sorter<BSONObj, DiskLoc> > _sorter;
+        vector<shared_ptr<Sorter<BSONObj, DiskLoc> > > _runs;
     };
 #else
     /**
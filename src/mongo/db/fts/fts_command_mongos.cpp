@@ -29,6 +29,7 @@
  */
 
 #include <map>
+#include <queue>
 #include <string>
 #include <vector>
 
@@ -42,16 +43,23 @@
 namespace mongo {
     namespace fts {
 
+        /**
+         * The next result of one shard.  Each shard sends its results best score first, and
+         * scores depend only on the document itself, so merging the heads of every shard's list
+         * gives the same order as sorting everything.
+         */
         struct Scored {
-            Scored( BSONObj full )
-                : full( full ) {
+            Scored( BSONObj full, size_t shard )
+                : full( full ), shard( shard ) {
                 score = full["score"].numberDouble();
             }
+            // the best score on top of a priority_queue
             bool operator<( const Scored& other ) const {
-                return other.score < score;
+                return score < other.score;
             }
             BSONObj full;
             double score;
+            size_t shard;
         };
 
 
@@ -75,7 +83,8 @@ namespace mongo {
             vector<Strategy::CommandResult> results;
             SHARDED->commandOp( dbName, cmdObj, cmdOptions, ns, filter, &results );
 
-            vector<Scored> all;
+            vector<BSONObjIterator> lists;
+            priority_queue<Scored> heads;
             long long nscanned = 0;
             long long nscannedObjects = 0;
 
@@ -103,22 +112,25 @@ namespace mongo {
                 }
 
                 if ( r["results"].isABSONObj() ) {
-                    BSONObjIterator j( r["results"].Obj() );
-                    while ( j.more() ) {
-                        BSONElement e = j.next();
-                        all.push_back( Scored(e.Obj()) );
-                    }
+                    lists.push_back( BSONObjIterator( r["results"].Obj() ) );
+                    if ( lists.back().more() )
+                        heads.push( Scored( lists.back().next().Obj(), lists.size() - 1 ) );
                 }
             }
 
-            sort( all.begin(), all.end() );
+            // k-way merge, only looking at as many results as are returned
             long long n = 0;
             {
                 BSONArrayBuilder arr( result.subarrayStart( "results" ) );
-                for ( unsigned i = 0; i < all.size(); i++ ) {
-                    arr.append( all[i].full );
-                    if ( ++n >= limit )
-                        break;
+                while ( n < limit && !heads.empty() ) {
+                    Scored best = heads.top();
+                    heads.pop();
+                    arr.append( best.full );
+                    n++;
+
+                    BSONObjIterator& list = lists[best.shard];
+                    if ( list.more() )
+                        heads.push( Scored( list.next().Obj(), best.shard ) );
                 }
                 arr.done();
             }
@@ -136,6 +136,20 @@ namespace mongo {
             string language = getLanguageToUse( obj, parentLanguage );
             Stemmer stemmer( language );
             Tools tools( language, &stemmer, StopWords::getStopWords( language ) );
+            _scoreDocument( obj, tools, parentPath, isArray, term_freqs );
+        }
+
+        void FTSSpec::_scoreDocument( const BSONObj& obj,
+                                      const Tools& parentTools,
+                                      const string& parentPath,
+                                      bool isArray,
+                                      TermFrequencyMap* term_freqs ) const {
+            string language = getLanguageToUse( obj, parentTools.language );
+            if ( language != parentTools.language ) {
+                scoreDocument( obj, language, parentPath, isArray, term_freqs );
+                return;
+            }
+            const Tools& tools = parentTools;
 
             // Perform a depth-first traversal of obj, skipping fields not touched by this spec.
             BSONObjIterator j( obj );
@@ -197,13 +211,13 @@ namespace mongo {
                     // !exactMatch is a sufficient test for proper prefix match, because of
                     // matchPrefix() continue block above.
                     if ( !exactMatch || wildcard() ) {
-                        scoreDocument( elem.Obj(), language, dottedName, false, term_freqs );
+                        _scoreDocument( elem.Obj(), tools, dottedName, false, term_freqs );
                     }
                     break;
                 case Array:
                     // Only descend into arrays from non-array parents or on wildcard.
                     if ( !isArray || wildcard() ) {
-                        scoreDocument( elem.Obj(), language, dottedName, true, term_freqs );
+                        _scoreDocument( elem.Obj(), tools, dottedName, true, term_freqs );
                     }
                     break;
                 default:
@@ -222,7 +236,8 @@ namespace mongo {
                 double count;
                 double exp;
             };
-            typedef unordered_map<string,ScoreHelperStruct> ScoreHelperMap;
+            // Keyed by the stems held in Tools::stems.
+            typedef unordered_map<StringData,ScoreHelperStruct,StringData::Hasher> ScoreHelperMap;
         }
 
         void FTSSpec::_scoreString( const Tools& tools,
@@ -240,13 +255,19 @@ namespace mongo {
                 if ( t.type != Token::TEXT )
                     continue;
 
-                string term = t.data.toString();
-                makeLower( &term );
-                if ( tools.stopwords->isStopWord( term ) )
+                tools.word.assign( t.data.rawData(), t.data.size() );
+                makeLower( &tools.word );
+
+                unordered_map<string,string>::iterator stem = tools.stems.find( tools.word );
+                if ( stem == tools.stems.end() ) {
+                    const string term = tools.stopwords->isStopWord( tools.word )
+                        ? string() : tools.stemmer->stem( tools.word );
+                    stem = tools.stems.insert( make_pair( tools.word, term ) ).first;
+                }
+                if ( stem->second.empty() )
                     continue;
-                term = tools.stemmer->stem( term );
 
-                ScoreHelperStruct& data = terms[term];
+                ScoreHelperStruct& data = terms[stem->second];
 
                 if ( data.exp )
                     data.exp *= 2;
@@ -260,7 +281,7 @@ namespace mongo {
 
             for ( ScoreHelperMap::const_iterator i = terms.begin(); i != terms.end(); ++i ) {
 
-                const string& term = i->first;
+                const StringData term = i->first;
                 const ScoreHelperStruct& data = i->second;
 
                 // in order to adjust weights as a function of term count as it
@@ -273,10 +294,10 @@ namespace mongo {
                 // if term is identical to the raw form of the
                 // field (untokenized) give it a small boost.
                 double adjustment = 1;
-                if ( raw.size() == term.length() && raw.equalCaseInsensitive( term ) )
+                if ( raw.size() == term.size() && raw.equalCaseInsensitive( term ) )
                     adjustment += 0.1;
 
-                double& score = (*docScores)[term];
+                double& score = (*docScores)[term.toString()];
                 score += ( weight * data.freq * coeff * adjustment );
                 verify( score <= MAX_WEIGHT );
             }
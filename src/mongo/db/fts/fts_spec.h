@@ -54,7 +54,7 @@ namespace mongo {
         class FTSSpec {
 
             struct Tools {
-                Tools( string _language,
+                Tools( const string& _language,
                        const Stemmer* _stemmer,
                        const StopWords* _stopwords )
                     : language( _language )
@@ -64,6 +64,13 @@ namespace mongo {
                 const std::string& language;
                 const Stemmer* stemmer;
                 const StopWords* stopwords;
+
+                // The stem of each lowercased word met so far in the document, or the empty
+                // string for a stop word, so each distinct word is stemmed once.
+                mutable unordered_map<string,string> stems;
+
+                // Reused to lowercase each token.
+                mutable string word;
             };
 
         public:
@@ -109,6 +116,16 @@ namespace mongo {
 
             static BSONObj fixSpec( const BSONObj& spec );
         private:
+            /**
+             * scoreDocument() with the tools of the enclosing document, which are used again
+             * unless obj names a language of its own.
+             */
+            void _scoreDocument( const BSONObj& obj,
+                                 const Tools& parentTools,
+                                 const string& parentPath,
+                                 bool isArray,
+                                 TermFrequencyMap* term_freqs ) const;
+
             void _scoreString( const Tools& tools,
                                const StringData& raw,
                                TermFrequencyMap* term_freqs,
@@ -102,6 +102,42 @@ namespace mongo {
 
         }
 
+        TEST( FTSSpec, ScoreRepeatStemAcrossFields ) {
+            BSONObj user = BSON( "key" << BSON( "title" << "fts" <<
+                                                "text" << "fts" ) );
+
+            FTSSpec spec( FTSSpec::fixSpec( user ) );
+
+            TermFrequencyMap once;
+            spec.scoreDocument( BSON( "title" << "run" ), "english", "", false, &once );
+
+            TermFrequencyMap m;
+            spec.scoreDocument( BSON( "title" << "Running the RUNS" << "text" << "run" ),
+                                "english", "", false, &m );
+            ASSERT_EQUALS( 1U, m.size() );
+            ASSERT( m["run"] > once["run"] );
+        }
+
+        // the same word stems differently in a sub-document of another language
+        TEST( FTSSpec, NestedLanguages_RepeatWord ) {
+            BSONObj indexSpec = BSON( "key" << BSON( "a.c" << "fts" ) );
+            FTSSpec spec( FTSSpec::fixSpec( indexSpec ) );
+            TermFrequencyMap tfm;
+
+            BSONObj obj = fromjson(
+                "{ a :"
+                "    [ { c : \"running\" },"
+                "      { c : \"running\", language : \"none\" },"
+                "      { c : \"running\" } ]"
+                " }" );
+
+            spec.scoreDocument( obj, "english", "", false, &tfm );
+
+            ASSERT_EQUALS( 2U, tfm.size() );
+            ASSERT_EQUALS( 1U, tfm.count( "run" ) );
+            ASSERT_EQUALS( 1U, tfm.count( "running" ) );
+        }
+
         TEST( FTSSpec, Extra1 ) {
             BSONObj user = BSON( "key" << BSON( "data" << "fts" ) );
             FTSSpec spec( FTSSpec::fixSpec( user ) );
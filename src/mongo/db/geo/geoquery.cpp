@@ -237,7 +237,9 @@ namespace mongo {
     }
 
     bool GeoQuery::parseFrom(const BSONObj &obj) {
-        return parseLegacyQuery(obj) || parseNewQuery(obj);
+        if (!parseLegacyQuery(obj) && !parseNewQuery(obj)) { return false; }
+        _rawObj = obj.getOwned();
+        return true;
     }
 
     const S2Region& GeoQuery::getRegion() const {
@@ -169,6 +169,9 @@ namespace mongo {
 
         bool uniqueDocs() const { return _uniqueDocs; }
 
+        // The query this was parsed from.  Equal queries have equal regions.
+        const BSONObj& getRawObj() const { return _rawObj; }
+
     private:
         // Try to parse the provided object into the right place.
         bool parseLegacyQuery(const BSONObj &obj);
@@ -179,5 +182,6 @@ namespace mongo {
         GeometryContainer geoContainer;
         Predicate predicate;
         bool _uniqueDocs;
+        BSONObj _rawObj;
     };
 }  // namespace mongo
@@ -0,0 +1,104 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/geo/s2_covering_cache.h"
+
+#include "mongo/db/server_parameters.h"
+
+namespace mongo {
+
+    // How many query region coverings we keep.
+    MONGO_EXPORT_SERVER_PARAMETER(internalGeoCoveringCacheSize, int, 1000);
+
+    namespace {
+
+        std::string makeKey(const GeoQuery& query, const S2RegionCoverer& coverer) {
+            StringBuilder sb;
+            sb << coverer.min_level() << ',' << coverer.max_level() << ','
+               << coverer.level_mod() << ',' << coverer.max_cells() << ',';
+            const BSONObj& obj = query.getRawObj();
+            sb.write(obj.objdata(), obj.objsize());
+            return sb.str();
+        }
+
+    }  // namespace
+
+    bool S2CoveringCache::getCovering(const GeoQuery& query, S2RegionCoverer* coverer,
+                                      std::vector<S2CellId>* out) {
+        if (internalGeoCoveringCacheSize <= 0 || query.getRawObj().isEmpty()) {
+            coverer->GetCovering(query.getRegion(), out);
+            return false;
+        }
+
+        std::string key = makeKey(query, *coverer);
+        {
+            scoped_lock lk(_mutex);
+            EntryMap::iterator it = _entries.find(key);
+            if (_entries.end() != it) {
+                _lru.splice(_lru.begin(), _lru, it->second.lruPosition);
+                *out = it->second.cover;
+                return true;
+            }
+        }
+
+        // Not holding the lock while covering; two queries may both compute the same one.
+        coverer->GetCovering(query.getRegion(), out);
+
+        scoped_lock lk(_mutex);
+        if (_entries.end() != _entries.find(key)) {
+            return false;
+        }
+        while (!_lru.empty() && _lru.size() >= static_cast<size_t>(internalGeoCoveringCacheSize)) {
+            _entries.erase(_lru.back());
+            _lru.pop_back();
+        }
+        _lru.push_front(key);
+        Entry& entry = _entries[key];
+        entry.cover = *out;
+        entry.lruPosition = _lru.begin();
+        return false;
+    }
+
+    void S2CoveringCache::clear() {
+        scoped_lock lk(_mutex);
+        _entries.clear();
+        _lru.clear();
+    }
+
+    size_t S2CoveringCache::size() const {
+        scoped_lock lk(_mutex);
+        return _entries.size();
+    }
+
+    // static
+    S2CoveringCache* S2CoveringCache::global() {
+        static S2CoveringCache cache;
+        return &cache;
+    }
+
+}  // namespace mongo
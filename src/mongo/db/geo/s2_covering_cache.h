@@ -0,0 +1,90 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/geo/geoquery.h"
+#include "mongo/platform/unordered_map.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "third_party/s2/s2regioncoverer.h"
+
+namespace mongo {
+
+    /**
+     * Remembers the coverings of query regions, so that queries asking for the same geometry with
+     * the same covering limits don't compute it again.  Covering a complex polygon is much more
+     * expensive than looking it up.
+     *
+     * Entries are keyed by the raw query the region was parsed from and the coverer's limits, and
+     * are evicted in LRU order once there are internalGeoCoveringCacheSize of them.
+     */
+    class S2CoveringCache {
+        MONGO_DISALLOW_COPYING(S2CoveringCache);
+    public:
+        S2CoveringCache() : _mutex("S2CoveringCache") { }
+
+        /**
+         * Fills 'out' with the covering of the region of 'query', as 'coverer' computes it.
+         * Returns true if the covering was found in the cache.
+         */
+        bool getCovering(const GeoQuery& query, S2RegionCoverer* coverer,
+                         std::vector<S2CellId>* out);
+
+        void clear();
+
+        size_t size() const;
+
+        /**
+         * The cache shared by every query.
+         */
+        static S2CoveringCache* global();
+
+    private:
+        struct Entry {
+            std::vector<S2CellId> cover;
+            // Where this entry's key lives in '_lru'.
+            std::list<std::string>::iterator lruPosition;
+        };
+
+        typedef unordered_map<std::string, Entry> EntryMap;
+
+        // Protects everything below.
+        mutable mongo::mutex _mutex;
+
+        EntryMap _entries;
+
+        // Keys of '_entries', most recently used at the front.
+        std::list<std::string> _lru;
+    };
+
+}  // namespace mongo
@@ -0,0 +1,124 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * This file contains tests for mongo/db/geo/s2_covering_cache.cpp
+ */
+
+#include "mongo/db/geo/s2_covering_cache.h"
+
+#include "mongo/db/json.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/unittest/unittest.h"
+
+using namespace mongo;
+
+namespace {
+
+    GeoQuery parseQuery(const char* queryStr) {
+        GeoQuery query("loc");
+        ASSERT_TRUE(query.parseFrom(fromjson(queryStr)));
+        return query;
+    }
+
+    GeoQuery boxQuery(int size) {
+        std::string queryStr = mongoutils::str::stream() << "{$within: {$box: [[0, 0], ["
+                                                         << size << ", " << size << "]]}}";
+        return parseQuery(queryStr.c_str());
+    }
+
+    void setServerParameter(const char* name, int value) {
+        ServerParameter* param = ServerParameterSet::getGlobal()->getMap().find(name)->second;
+        ASSERT_OK(param->set(BSON("" << value).firstElement()));
+    }
+
+    TEST(S2CoveringCacheTest, SameQueryHits) {
+        S2CoveringCache cache;
+        GeoQuery query = parseQuery("{$geoWithin: {$geometry: {type: 'Polygon', coordinates: "
+                                    "[[[0, 0], [3, 0], [3, 1], [1, 3], [0, 0]]]}}}");
+        S2RegionCoverer coverer;
+
+        vector<S2CellId> expected;
+        coverer.GetCovering(query.getRegion(), &expected);
+        ASSERT_FALSE(expected.empty());
+
+        vector<S2CellId> first;
+        ASSERT_FALSE(cache.getCovering(query, &coverer, &first));
+        ASSERT_EQUALS(1U, cache.size());
+
+        // A separately parsed copy of the query finds the same entry.
+        GeoQuery copy = parseQuery(query.getRawObj().toString().c_str());
+        vector<S2CellId> second;
+        ASSERT_TRUE(cache.getCovering(copy, &coverer, &second));
+        ASSERT_EQUALS(1U, cache.size());
+
+        ASSERT(expected == first);
+        ASSERT(expected == second);
+    }
+
+    TEST(S2CoveringCacheTest, CovererLimitsMatter) {
+        S2CoveringCache cache;
+        GeoQuery query = boxQuery(10);
+        S2RegionCoverer coverer;
+        vector<S2CellId> cover;
+        ASSERT_FALSE(cache.getCovering(query, &coverer, &cover));
+
+        coverer.set_max_cells(coverer.max_cells() * 2);
+        ASSERT_FALSE(cache.getCovering(query, &coverer, &cover));
+        ASSERT_EQUALS(2U, cache.size());
+
+        vector<S2CellId> expected;
+        coverer.GetCovering(query.getRegion(), &expected);
+        ASSERT(expected == cover);
+    }
+
+    TEST(S2CoveringCacheTest, EvictsLeastRecentlyUsed) {
+        setServerParameter("internalGeoCoveringCacheSize", 2);
+
+        S2CoveringCache cache;
+        S2RegionCoverer coverer;
+        vector<S2CellId> cover;
+        ASSERT_FALSE(cache.getCovering(boxQuery(1), &coverer, &cover));
+        ASSERT_FALSE(cache.getCovering(boxQuery(2), &coverer, &cover));
+        // Touch the first box so that the second is the least recently used entry.
+        ASSERT_TRUE(cache.getCovering(boxQuery(1), &coverer, &cover));
+        ASSERT_FALSE(cache.getCovering(boxQuery(3), &coverer, &cover));
+        ASSERT_EQUALS(2U, cache.size());
+
+        ASSERT_TRUE(cache.getCovering(boxQuery(1), &coverer, &cover));
+        ASSERT_TRUE(cache.getCovering(boxQuery(3), &coverer, &cover));
+        ASSERT_FALSE(cache.getCovering(boxQuery(2), &coverer, &cover));
+        ASSERT_EQUALS(2U, cache.size());
+
+        cache.clear();
+        ASSERT_EQUALS(0U, cache.size());
+
+        setServerParameter("internalGeoCoveringCacheSize", 1000);
+    }
+
+}  // namespace
@@ -54,6 +54,17 @@ namespace mongo {
 
     bool S2SearchUtil::getKeysForObject(const BSONObj& obj, const S2IndexingParams& params,
                                         vector<string>* out) {
+        // Points are most of what gets indexed, and the covering of a point is just the cell
+        // at the finest indexed level that contains it.  Skip the container and the coverer.
+        if (GeoParser::isPoint(obj)) {
+            PointWithCRS point;
+            if (!GeoParser::parsePoint(obj, &point)) { return false; }
+            if (SPHERE != point.crs && !point.flatUpgradedToSphere) { return false; }
+            out->push_back(
+                S2CellId::FromPoint(point.point).parent(params.finestIndexedLevel).toString());
+            return true;
+        }
+
         S2RegionCoverer coverer;
         params.configureCoverer(&coverer);
 
@@ -31,10 +31,12 @@
 #include <vector>
 
 #include "mongo/base/status.h"
+#include "mongo/db/index/btree_based_builder.h"
 #include "mongo/db/index/btree_index_cursor.h"
 #include "mongo/db/index/btree_interface.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/keypattern.h"
+#include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/pdfile.h"
 #include "mongo/db/pdfile_private.h"
 
@@ -45,6 +47,30 @@ namespace mongo {
 
         verify(0 == descriptor->version() || 1 == descriptor->version());
         _interface = BtreeInterface::interfaces[descriptor->version()];
+
+        if (descriptor->isPartial()) {
+            _filterSpec = descriptor->partialFilterExpression().getOwned();
+            StatusWithMatchExpression parsed = MatchExpressionParser::parse(_filterSpec);
+            // The filter was checked when the index was created.
+            massert(17337, "bad partialFilterExpression: " + parsed.getStatus().toString(),
+                    parsed.isOK());
+            _filter.reset(parsed.getValue());
+        }
+    }
+
+    void BtreeBasedAccessMethod::getIndexedKeys(const BSONObj& obj, BSONObjSet* keys) {
+        if (_filter && !_filter->matchesBSON(obj)) {
+            return;
+        }
+        getKeys(obj, keys);
+    }
+
+    // While a background build bulk loads an index, changes to it go to its change log.
+    static BackgroundBuildChangeLog* changeLogFor(const IndexDescriptor* descriptor) {
+        if (!descriptor->isBackgroundIndex()) {
+            return NULL;
+        }
+        return BackgroundBuildChangeLog::get(descriptor->indexNamespace());
     }
 
     // Find the keys for obj, put them in the tree pointing to loc
@@ -55,7 +81,19 @@ namespace mongo {
 
         BSONObjSet keys;
         // Delegate to the subclass.
-        getKeys(obj, &keys);
+        getIndexedKeys(obj, &keys);
+
+        BackgroundBuildChangeLog* changeLog = changeLogFor(_descriptor);
+        if (changeLog) {
+            for (BSONObjSet::const_iterator i = keys.begin(); i != keys.end(); ++i) {
+                changeLog->noteInsert(*i, loc);
+            }
+            *numInserted = keys.size();
+            if (*numInserted > 1) {
+                _descriptor->setMultikey();
+            }
+            return Status::OK();
+        }
 
         Status ret = Status::OK();
 
@@ -92,6 +130,32 @@ namespace mongo {
         return ret;
     }
 
+    Status BtreeBasedAccessMethod::insertKeys(const vector<pair<BSONObj, DiskLoc> >& keys,
+                                              int64_t* numInserted) {
+        *numInserted = 0;
+        Status ret = Status::OK();
+
+        BackgroundBuildChangeLog* changeLog = changeLogFor(_descriptor);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (changeLog) {
+                changeLog->noteInsert(keys[i].first, keys[i].second);
+                ++*numInserted;
+                continue;
+            }
+            try {
+                _interface->bt_insert(_descriptor->getHead(), keys[i].second, keys[i].first,
+                                      _ordering, true, _descriptor->getOnDisk(), true);
+                ++*numInserted;
+            } catch (AssertionException& e) {
+                problem() << " caught assertion insertKeys "
+                          << _descriptor->indexNamespace() << ' ' << keys[i].first << endl;
+                ret = Status(ErrorCodes::InternalError, e.what(), e.getCode());
+            }
+        }
+
+        return ret;
+    }
+
     bool BtreeBasedAccessMethod::removeOneKey(const BSONObj& key, const DiskLoc& loc) {
         bool ret = false;
 
@@ -115,9 +179,18 @@ namespace mongo {
         const InsertDeleteOptions &options, int64_t* numDeleted) {
 
         BSONObjSet keys;
-        getKeys(obj, &keys);
+        getIndexedKeys(obj, &keys);
         *numDeleted = 0;
 
+        BackgroundBuildChangeLog* changeLog = changeLogFor(_descriptor);
+        if (changeLog) {
+            for (BSONObjSet::const_iterator i = keys.begin(); i != keys.end(); ++i) {
+                changeLog->noteRemove(*i, loc);
+            }
+            *numDeleted = keys.size();
+            return Status::OK();
+        }
+
         for (BSONObjSet::const_iterator i = keys.begin(); i != keys.end(); ++i) {
             bool thisKeyOK = removeOneKey(*i, loc);
 
@@ -154,19 +227,23 @@ namespace mongo {
 
     Status BtreeBasedAccessMethod::touch(const BSONObj& obj) {
         BSONObjSet keys;
-        getKeys(obj, &keys);
+        getIndexedKeys(obj, &keys);
 
         for (BSONObjSet::const_iterator i = keys.begin(); i != keys.end(); ++i) {
-            int unusedPos;
-            bool unusedFound;
-            DiskLoc unusedDiskLoc;
-            _interface->locate(_descriptor->getOnDisk(), _descriptor->getHead(), *i, _ordering,
-                               unusedPos, unusedFound, unusedDiskLoc, 1);
+            touchKey(*i);
         }
 
         return Status::OK();
     }
 
+    void BtreeBasedAccessMethod::touchKey(const BSONObj& key) {
+        int unusedPos;
+        bool unusedFound;
+        DiskLoc unusedDiskLoc;
+        _interface->locate(_descriptor->getOnDisk(), _descriptor->getHead(), key, _ordering,
+                           unusedPos, unusedFound, unusedDiskLoc, 1);
+    }
+
     Status BtreeBasedAccessMethod::validate(int64_t* numKeys) {
         *numKeys = _interface->fullValidate(_descriptor->getHead(), _descriptor->keyPattern());
         return Status::OK();
@@ -179,8 +256,8 @@ namespace mongo {
         BtreeBasedPrivateUpdateData *data = new BtreeBasedPrivateUpdateData();
         status->_indexSpecificUpdateData.reset(data);
 
-        getKeys(from, &data->oldKeys);
-        getKeys(to, &data->newKeys);
+        getIndexedKeys(from, &data->oldKeys);
+        getIndexedKeys(to, &data->newKeys);
         data->loc = record;
         data->dupsAllowed = options.dupsAllowed;
 
@@ -221,6 +298,18 @@ namespace mongo {
             _descriptor->setMultikey();
         }
 
+        BackgroundBuildChangeLog* changeLog = changeLogFor(_descriptor);
+        if (changeLog) {
+            for (size_t i = 0; i < data->added.size(); ++i) {
+                changeLog->noteInsert(*data->added[i], data->loc);
+            }
+            for (size_t i = 0; i < data->removed.size(); ++i) {
+                changeLog->noteRemove(*data->removed[i], data->loc);
+            }
+            *numUpdated = data->added.size();
+            return Status::OK();
+        }
+
         for (size_t i = 0; i < data->added.size(); ++i) {
             _interface->bt_insert(_descriptor->getHead(), data->loc, *data->added[i], _ordering,
                                   data->dupsAllowed, _descriptor->getOnDisk(), true);
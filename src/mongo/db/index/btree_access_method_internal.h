@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <boost/scoped_ptr.hpp>
 #include <vector>
 
 #include "mongo/db/diskloc.h"
@@ -36,6 +37,7 @@
 #include "mongo/db/index/index_access_method.h"
 #include "mongo/db/index/index_cursor.h"
 #include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/matcher/expression.h"
 
 namespace mongo {
 
@@ -74,8 +76,28 @@ namespace mongo {
 
         virtual Status touch(const BSONObj& obj);
 
+        /** Page in the buckets a lookup of one key, from getIndexedKeys, goes through. */
+        void touchKey(const BSONObj& key);
+
         virtual Status validate(int64_t* numKeys);
 
+        virtual const MatchExpression* getFilterExpression() const { return _filter.get(); }
+
+        /**
+         * The keys the index holds for obj: those from getKeys, or none if this is a partial
+         * index and obj doesn't match its filter.
+         */
+        void getIndexedKeys(const BSONObj &obj, BSONObjSet *keys);
+
+        /**
+         * Put keys already generated for several records into an index allowing duplicates.
+         * Each key still descends from the root, but when 'keys' is in index order each descent
+         * follows the last one through buckets that are still in cache.  Keys that can't be
+         * inserted are logged and skipped.
+         */
+        Status insertKeys(const std::vector<std::pair<BSONObj, DiskLoc> >& keys,
+                          int64_t* numInserted);
+
     protected:
         // Friends who need getKeys.
         friend class BtreeBasedBuilder;
@@ -91,6 +113,10 @@ namespace mongo {
         // There are 2 types of Btree disk formats.  We put them both behind one interface.
         BtreeInterface* _interface;
 
+        // For partial indexes, the filter documents must match to be indexed.
+        BSONObj _filterSpec;
+        boost::scoped_ptr<MatchExpression> _filter;
+
     private:
         bool removeOneKey(const BSONObj& key, const DiskLoc& loc);
     };
@@ -28,17 +28,25 @@
 
 #include "mongo/db/index/btree_based_builder.h"
 
+#include <boost/thread/thread.hpp>
+
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/btreebuilder.h"
+#include "mongo/db/index/btree_interface.h"
 #include "mongo/db/index/catalog_hack.h"
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/index/index_access_method.h"
 #include "mongo/db/kill_current_op.h"
 #include "mongo/db/pdfile_private.h"
 #include "mongo/db/query/internal_plans.h"
+#include "mongo/db/query/runner_yield_policy.h"
 #include "mongo/db/repl/is_master.h"
 #include "mongo/db/repl/rs.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/sort_phase_one.h"
+#include "mongo/db/structure/collection.h"
 #include "mongo/util/processinfo.h"
+#include "mongo/util/queue.h"
 
 namespace mongo {
 
@@ -153,6 +161,162 @@ namespace mongo {
         }
     }
 
+    // Threads generating keys for a foreground index build.  0 means one per core, up to 8.
+    MONGO_EXPORT_SERVER_PARAMETER(indexBuildKeyGenerationThreads, int, 0);
+
+    /**
+     * Generates the keys for phase one of a foreground build on several threads.  The caller
+     * scans the collection and hands over the documents in batches.  Each worker generates the
+     * keys for a batch with its own access methods and adds them to its own run of each index's
+     * phase one sorter; iterating a sorter merges its runs.  The caller holds the collection's
+     * write lock throughout, so the documents stay put while the workers read them.
+     */
+    class BtreeBasedBuilder::ParallelKeyGenerator : boost::noncopyable {
+    public:
+        ParallelKeyGenerator(NamespaceDetails* d, const vector<int>& idxNos,
+                             const vector<SortPhaseOne*>& phaseOnes, int nThreads)
+            : _phaseOnes(phaseOnes), _queue(4 * nThreads), _workers(nThreads), _failed(false),
+              _finished(false) {
+            for (size_t j = 0; j < phaseOnes.size(); ++j) {
+                verify(phaseOnes[j]->sorter->numRuns() == nThreads);
+            }
+            for (int i = 0; i < nThreads; ++i) {
+                Worker& w = _workers[i];
+                for (size_t j = 0; j < idxNos.size(); ++j) {
+                    w.desc.push_back(shared_ptr<IndexDescriptor>(
+                                         CatalogHack::getDescriptor(d, idxNos[j])));
+                    w.iam.push_back(shared_ptr<BtreeBasedAccessMethod>(
+                                        CatalogHack::getBtreeBasedIndex(w.desc.back().get())));
+                }
+                w.nkeys.resize(idxNos.size());
+                w.multi.resize(idxNos.size());
+            }
+            for (int i = 0; i < nThreads; ++i) {
+                _threads.create_thread(boost::bind(&ParallelKeyGenerator::work, this, i));
+            }
+            _batch.reset(new Batch());
+        }
+
+        ~ParallelKeyGenerator() {
+            if (!_finished) {
+                try {
+                    stop();
+                }
+                catch (...) {
+                }
+            }
+        }
+
+        void add(const BSONObj& obj, const DiskLoc& loc) {
+            _batch->push_back(make_pair(obj, loc));
+            if (_batch->size() >= BatchSize) {
+                if (_failed) {
+                    finish();
+                }
+                _queue.push(_batch);
+                _batch.reset(new Batch());
+            }
+        }
+
+        /**
+         * Waits for the workers to generate the keys for everything added and adds their counts
+         * to the phase ones.  Throws what a worker failed with, if one did.
+         */
+        void finish() {
+            _queue.push(_batch);
+            _batch.reset();
+            stop();
+            _finished = true;
+
+            for (size_t i = 0; i < _workers.size(); ++i) {
+                const Worker& w = _workers[i];
+                if (!w.error.empty()) {
+                    uasserted(w.errorCode, w.error);
+                }
+            }
+            for (size_t i = 0; i < _workers.size(); ++i) {
+                const Worker& w = _workers[i];
+                for (size_t j = 0; j < _phaseOnes.size(); ++j) {
+                    _phaseOnes[j]->n += w.n;
+                    _phaseOnes[j]->nkeys += w.nkeys[j];
+                    _phaseOnes[j]->multi = _phaseOnes[j]->multi || w.multi[j];
+                }
+            }
+        }
+
+    private:
+        typedef vector<pair<BSONObj, DiskLoc> > Batch;
+        static const size_t BatchSize = 256;
+
+        struct Worker {
+            Worker() : n(0), errorCode(0) { }
+            // Access methods' key generators aren't necessarily safe to share.
+            vector<shared_ptr<IndexDescriptor> > desc;
+            vector<shared_ptr<BtreeBasedAccessMethod> > iam;
+            unsigned long long n;
+            vector<unsigned long long> nkeys;
+            vector<bool> multi;
+            string error;
+            int errorCode;
+        };
+
+        /** Tells the workers there's no more to do, and waits for them. */
+        void stop() {
+            for (size_t i = 0; i < _workers.size(); ++i) {
+                _queue.push(shared_ptr<Batch>());
+            }
+            _threads.join_all();
+        }
+
+        void work(int run) {
+            Worker& w = _workers[run];
+            while (true) {
+                shared_ptr<Batch> batch = _queue.blockingPop();
+                if (!batch) {
+                    return;
+                }
+                if (_failed) {
+                    // Keep draining so the scan isn't left waiting on a full queue.
+                    continue;
+                }
+                try {
+                    for (Batch::const_iterator i = batch->begin(); i != batch->end(); ++i) {
+                        for (size_t j = 0; j < w.iam.size(); ++j) {
+                            BSONObjSet keys;
+                            w.iam[j]->getIndexedKeys(i->first, &keys);
+                            if (keys.size() > 1) {
+                                w.multi[j] = true;
+                            }
+                            for (BSONObjSet::iterator k = keys.begin(); k != keys.end(); ++k) {
+                                _phaseOnes[j]->sorter->addToRun(run, *k, i->second);
+                                ++w.nkeys[j];
+                            }
+                        }
+                        ++w.n;
+                    }
+                }
+                catch (DBException& e) {
+                    w.error = e.what();
+                    w.errorCode = e.getCode();
+                    _failed = true;
+                }
+                catch (std::exception& e) {
+                    w.error = e.what();
+                    w.errorCode = 17336;
+                    _failed = true;
+                }
+            }
+        }
+
+        const vector<SortPhaseOne*> _phaseOnes;
+        BlockingQueue<shared_ptr<Batch> > _queue;
+        vector<Worker> _workers;
+        boost::thread_group _threads;
+        shared_ptr<Batch> _batch;
+        volatile bool _failed;
+        bool _finished;
+    };
+
     void BtreeBasedBuilder::addKeysToPhaseOne(NamespaceDetails* d, const char* ns,
                            const IndexDetails& idx,
                            const BSONObj& order,
@@ -160,45 +324,91 @@ namespace mongo {
                            int64_t nrecords,
                            ProgressMeter* progressMeter,
                            bool mayInterrupt, int idxNo) {
+        addKeysToPhaseOnes(d, ns, vector<int>(1, idxNo), vector<SortPhaseOne*>(1, phaseOne),
+                           nrecords, progressMeter, mayInterrupt);
+    }
+
+    void BtreeBasedBuilder::addKeysToPhaseOnes(NamespaceDetails* d, const char* ns,
+                                               const vector<int>& idxNos,
+                                               const vector<SortPhaseOne*>& phaseOnes,
+                                               int64_t nrecords,
+                                               ProgressMeter* progressMeter,
+                                               bool mayInterrupt) {
+        int nThreads = indexBuildKeyGenerationThreads;
+        if (nThreads <= 0) {
+            nThreads = std::min(ProcessInfo().getNumCores(), 8U);
+        }
+        if (nrecords < 10000) {
+            // Not worth starting threads for.
+            nThreads = 1;
+        }
+
         auto_ptr<Runner> runner(InternalPlanner::collectionScan(ns));
-        phaseOne->sortCmp.reset(getComparison(idx.version(), idx.keyPattern()));
-        phaseOne->sorter.reset(new BSONObjExternalSorter(phaseOne->sortCmp.get()));
-        phaseOne->sorter->hintNumObjects( nrecords );
-        auto_ptr<IndexDescriptor> desc(CatalogHack::getDescriptor(d, idxNo));
-        auto_ptr<BtreeBasedAccessMethod> iam(CatalogHack::getBtreeBasedIndex(desc.get()));
+        OwnedPointerVector<IndexDescriptor> descs;
+        OwnedPointerVector<BtreeBasedAccessMethod> iams;
+        for (size_t j = 0; j < idxNos.size(); ++j) {
+            const IndexDetails& idx = d->idx(idxNos[j]);
+            SortPhaseOne* phaseOne = phaseOnes[j];
+            phaseOne->sortCmp.reset(getComparison(idx.version(), idx.keyPattern()));
+            // The indexes share the memory one build would have.
+            phaseOne->sorter.reset(new BSONObjExternalSorter(phaseOne->sortCmp.get(),
+                                                             100*1024*1024 / idxNos.size(),
+                                                             nThreads));
+            phaseOne->sorter->hintNumObjects( nrecords );
+            descs.mutableVector().push_back(CatalogHack::getDescriptor(d, idxNos[j]));
+            iams.mutableVector().push_back(CatalogHack::getBtreeBasedIndex(descs.vector().back()));
+        }
+        scoped_ptr<ParallelKeyGenerator> generator;
+        if (nThreads > 1) {
+            generator.reset(new ParallelKeyGenerator(d, idxNos, phaseOnes, nThreads));
+        }
         BSONObj o;
         DiskLoc loc;
         Runner::RunnerState state;
+        unsigned long long nScanned = 0;
         while (Runner::RUNNER_ADVANCED == (state = runner->getNext(&o, &loc))) {
             RARELY killCurrentOp.checkForInterrupt( !mayInterrupt );
-            BSONObjSet keys;
-            iam->getKeys(o, &keys);
-            phaseOne->addKeys(keys, loc, mayInterrupt);
+            if (generator) {
+                generator->add(o, loc);
+            }
+            else {
+                for (size_t j = 0; j < idxNos.size(); ++j) {
+                    BSONObjSet keys;
+                    iams.vector()[j]->getIndexedKeys(o, &keys);
+                    phaseOnes[j]->addKeys(keys, loc, mayInterrupt);
+                }
+            }
             progressMeter->hit();
             if (logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(2))
-                && phaseOne->n % 10000 == 0 ) {
+                && ++nScanned % 10000 == 0 ) {
                 printMemInfo( "\t iterating objects" );
             }
         }
 
         uassert(17050, "Internal error reading docs from collection", Runner::RUNNER_EOF == state);
 
+        if (generator) {
+            generator->finish();
+        }
     }
 
     uint64_t BtreeBasedBuilder::fastBuildIndex(const char* ns, NamespaceDetails* d,
                                                IndexDetails& idx, bool mayInterrupt,
                                                int idxNo) {
+        return fastBuildIndexes(ns, d, vector<int>(1, idxNo), mayInterrupt);
+    }
+
+    uint64_t BtreeBasedBuilder::fastBuildIndexes(const char* ns, NamespaceDetails* d,
+                                                 const vector<int>& idxNos, bool mayInterrupt) {
         CurOp * op = cc().curop();
 
         Timer t;
 
-        MONGO_TLOG(1) << "fastBuildIndex " << ns << ' ' << idx.info.obj().toString() << endl;
-
-        bool dupsAllowed = !idx.unique() || ignoreUniqueIndex(idx);
-        bool dropDups = idx.dropDups() || inDBRepair;
-        BSONObj order = idx.keyPattern();
-
-        getDur().writingDiskLoc(idx.head).Null();
+        for (size_t j = 0; j < idxNos.size(); ++j) {
+            IndexDetails& idx = d->idx(idxNos[j]);
+            MONGO_TLOG(1) << "fastBuildIndex " << ns << ' ' << idx.info.obj().toString() << endl;
+            getDur().writingDiskLoc(idx.head).Null();
+        }
 
         if ( logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(2) ) )
             printMemInfo( "before index start" );
@@ -208,58 +418,190 @@ namespace mongo {
                                               "Index: (1/3) External Sort Progress",
                                               d->numRecords(),
                                               10));
-        SortPhaseOne phase1;
-        addKeysToPhaseOne(d, ns, idx, order, &phase1, d->numRecords(), pm.get(),
-                          mayInterrupt, idxNo );
+        OwnedPointerVector<SortPhaseOne> phaseOnes;
+        for (size_t j = 0; j < idxNos.size(); ++j) {
+            phaseOnes.mutableVector().push_back(new SortPhaseOne());
+        }
+        addKeysToPhaseOnes(d, ns, idxNos, phaseOnes.vector(), d->numRecords(), pm.get(),
+                           mayInterrupt);
         pm.finished();
 
-        BSONObjExternalSorter& sorter = *(phase1.sorter);
+        uint64_t n = 0;
+        for (size_t j = 0; j < idxNos.size(); ++j) {
+            IndexDetails& idx = d->idx(idxNos[j]);
+            SortPhaseOne& phase1 = *phaseOnes.vector()[j];
+            n = phase1.n;
 
-        if( phase1.multi ) {
-            d->setIndexIsMultikey(ns, idxNo);
+            bool dupsAllowed = !idx.unique() || ignoreUniqueIndex(idx);
+            bool dropDups = idx.dropDups() || inDBRepair;
+
+            BSONObjExternalSorter& sorter = *(phase1.sorter);
+
+            if( phase1.multi ) {
+                d->setIndexIsMultikey(ns, idxNos[j]);
+            }
+
+            if ( logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(2) ) )
+                printMemInfo( "before final sort" );
+            phase1.sorter->sort( mayInterrupt );
+            if ( logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(2) ) )
+                printMemInfo( "after final sort" );
+
+            LOG(t.seconds() > 5 ? 0 : 1) << "\t external sort used : " << sorter.numFiles()
+                                         << " files " << " in " << t.seconds() << " secs" << endl;
+
+            set<DiskLoc> dupsToDrop;
+
+            /* build index --- */
+            if( idx.version() == 0 )
+                buildBottomUpPhases2And3<V0>(dupsAllowed,
+                                             idx,
+                                             sorter,
+                                             dropDups,
+                                             dupsToDrop,
+                                             op,
+                                             &phase1,
+                                             pm,
+                                             t,
+                                             mayInterrupt);
+            else if( idx.version() == 1 )
+                buildBottomUpPhases2And3<V1>(dupsAllowed,
+                                             idx,
+                                             sorter,
+                                             dropDups,
+                                             dupsToDrop,
+                                             op,
+                                             &phase1,
+                                             pm,
+                                             t,
+                                             mayInterrupt);
+            else
+                verify(false);
+
+            if( dropDups )
+                log() << "\t fastBuildIndex dupsToDrop:" << dupsToDrop.size() << endl;
+
+            // Deleting documents unindexes them from the indexes built so far, and only the
+            // one being built dropped duplicates, so the caller never shares a scan with it.
+            verify(dupsToDrop.empty() || idxNos.size() == 1);
+            BtreeBasedBuilder::doDropDups(ns, d, dupsToDrop, mayInterrupt);
         }
 
-        if ( logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(2) ) )
-            printMemInfo( "before final sort" );
-        phase1.sorter->sort( mayInterrupt );
-        if ( logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(2) ) )
-            printMemInfo( "after final sort" );
+        return n;
+    }
 
-        LOG(t.seconds() > 5 ? 0 : 1) << "\t external sort used : " << sorter.numFiles()
-                                     << " files " << " in " << t.seconds() << " secs" << endl;
+    uint64_t BtreeBasedBuilder::backgroundBuildIndex(Collection* collection,
+                                                     const string& idxName) {
+        CurOp * op = cc().curop();
+        string ns = collection->ns().ns();
+        NamespaceDetails* d = collection->details();
+
+        Timer t;
+
+        int idxNo = d->findIndexByName(idxName, true);
+        verify(idxNo >= 0);
+
+        // From here on writers log their changes to the index rather than make them.
+        BackgroundBuildChangeLog changeLog(d->idx(idxNo).indexNamespace());
+
+        ProgressMeterHolder pm(op->setMessage("index: (1/3) external sort",
+                                              "Index: (1/3) External Sort Progress",
+                                              collection->numRecords(),
+                                              10));
+
+        SortPhaseOne phase1;
+        phase1.sortCmp.reset(getComparison(d->idx(idxNo).version(),
+                                           d->idx(idxNo).keyPattern()));
+        phase1.sorter.reset(new BSONObjExternalSorter(phase1.sortCmp.get()));
+
+        auto_ptr<IndexDescriptor> desc(CatalogHack::getDescriptor(d, idxNo));
+        auto_ptr<BtreeBasedAccessMethod> iam(CatalogHack::getBtreeBasedIndex(desc.get()));
+
+        auto_ptr<Runner> runner(InternalPlanner::collectionScan(ns));
+
+        // We're not delegating yielding to the runner because we need to know when a yield
+        // happens.
+        RunnerYieldPolicy yieldPolicy;
+
+        BSONObj obj;
+        DiskLoc loc;
+        Runner::RunnerState state;
+        while (Runner::RUNNER_ADVANCED == (state = runner->getNext(&obj, &loc))) {
+            BSONObjSet keys;
+            iam->getIndexedKeys(obj, &keys);
+            phase1.addKeys(keys, loc, true);
+            pm.hit();
 
+            if (yieldPolicy.shouldYield()) {
+                if (!yieldPolicy.yieldAndCheckIfOK(runner.get())) {
+                    uasserted(17334, "cursor gone during bg index bulk load");
+                }
+
+                pm->setTotalWhileRunning(collection->numRecords());
+                // Indexes may have been renumbered while we yielded.
+                idxNo = d->findIndexByName(idxName, true);
+                verify(idxNo >= 0);
+                iam.reset();
+                desc.reset(CatalogHack::getDescriptor(d, idxNo));
+                iam.reset(CatalogHack::getBtreeBasedIndex(desc.get()));
+            }
+        }
+        uassert(17335, "Internal error reading docs from collection", Runner::RUNNER_EOF == state);
+        pm.finished();
+
+        // There's no yielding from here on, so idx stays put, and writers can't see the half
+        // built btree.
+        IndexDetails& idx = d->idx(idxNo);
+        if (phase1.multi) {
+            d->setIndexIsMultikey(ns.c_str(), idxNo);
+        }
+
+        LOG(t.seconds() > 5 ? 0 : 1) << "\t background external sort used : "
+                                     << phase1.sorter->numFiles() << " files "
+                                     << " in " << t.seconds() << " secs" << endl;
+
+        // The builder points the index at its own btree, leaving the empty one writers were
+        // kept away from.
+        DiskLoc emptyHead = idx.head;
         set<DiskLoc> dupsToDrop;
+        if (0 == idx.version()) {
+            buildBottomUpPhases2And3<V0>(true, idx, *phase1.sorter, false, dupsToDrop, op,
+                                         &phase1, pm, t, true);
+            emptyHead.btreemod<V0>()->deallocBucket(emptyHead, idx);
+        }
+        else {
+            verify(1 == idx.version());
+            buildBottomUpPhases2And3<V1>(true, idx, *phase1.sorter, false, dupsToDrop, op,
+                                         &phase1, pm, t, true);
+            emptyHead.btreemod<V1>()->deallocBucket(emptyHead, idx);
+        }
 
-        /* build index --- */
-        if( idx.version() == 0 )
-            buildBottomUpPhases2And3<V0>(dupsAllowed,
-                                         idx,
-                                         sorter,
-                                         dropDups,
-                                         dupsToDrop,
-                                         op,
-                                         &phase1,
-                                         pm,
-                                         t,
-                                         mayInterrupt);
-        else if( idx.version() == 1 ) 
-            buildBottomUpPhases2And3<V1>(dupsAllowed,
-                                         idx,
-                                         sorter,
-                                         dropDups,
-                                         dupsToDrop,
-                                         op,
-                                         &phase1,
-                                         pm,
-                                         t,
-                                         mayInterrupt);
-        else
-            verify(false);
-
-        if( dropDups ) 
-            log() << "\t fastBuildIndex dupsToDrop:" << dupsToDrop.size() << endl;
-
-        BtreeBasedBuilder::doDropDups(ns, d, dupsToDrop, mayInterrupt);
+        // Catch up with what writers did while we sorted.  Inserts of documents the scan also
+        // saw are already in the btree; removes of documents it never saw find nothing.
+        const BackgroundBuildChangeLog::Changes& changes = changeLog.stop();
+        LOG(t.seconds() > 5 ? 0 : 1) << "\t background index build replaying "
+                                     << changes.size() << " logged changes" << endl;
+        const BtreeInterface* bt = BtreeInterface::interfaces[idx.version()];
+        Ordering ordering = Ordering::make(idx.keyPattern());
+        for (BackgroundBuildChangeLog::Changes::const_iterator i = changes.begin();
+             i != changes.end(); ++i) {
+            RARELY killCurrentOp.checkForInterrupt();
+            if (i->insert) {
+                try {
+                    bt->bt_insert(idx.head, i->loc, i->key, ordering, true, idx, true);
+                }
+                catch (AssertionException& e) {
+                    // 10287 is the key already being in the index.
+                    if (10287 != e.getCode()) {
+                        throw;
+                    }
+                }
+            }
+            else {
+                bt->unindex(idx.head, idx, i->key, i->loc);
+            }
+            getDur().commitIfNeeded();
+        }
 
         return phase1.n;
     }
@@ -280,4 +622,34 @@ namespace mongo {
         }
     }
 
+    SimpleMutex BackgroundBuildChangeLog::_mutex("BackgroundBuildChangeLog");
+    std::map<string, BackgroundBuildChangeLog*> BackgroundBuildChangeLog::_logs;
+
+    BackgroundBuildChangeLog::BackgroundBuildChangeLog(const string& indexNamespace)
+        : _indexNamespace(indexNamespace), _logging(true) {
+        SimpleMutex::scoped_lock lk(_mutex);
+        verify(_logs.find(_indexNamespace) == _logs.end());
+        _logs[_indexNamespace] = this;
+    }
+
+    BackgroundBuildChangeLog::~BackgroundBuildChangeLog() {
+        stop();
+    }
+
+    // static
+    BackgroundBuildChangeLog* BackgroundBuildChangeLog::get(const string& indexNamespace) {
+        SimpleMutex::scoped_lock lk(_mutex);
+        std::map<string, BackgroundBuildChangeLog*>::const_iterator i = _logs.find(indexNamespace);
+        return i == _logs.end() ? NULL : i->second;
+    }
+
+    const BackgroundBuildChangeLog::Changes& BackgroundBuildChangeLog::stop() {
+        if (_logging) {
+            SimpleMutex::scoped_lock lk(_mutex);
+            _logs.erase(_indexNamespace);
+            _logging = false;
+        }
+        return _changes;
+    }
+
 }  // namespace mongo
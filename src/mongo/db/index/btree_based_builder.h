@@ -28,13 +28,18 @@
 
 #pragma once
 
+#include <deque>
+#include <map>
 #include <set>
+#include <vector>
 
 #include "mongo/db/jsobj.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/util/concurrency/mutex.h"
 
 namespace IndexUpdateTests {
     class AddKeysToPhaseOne;
+    class AddKeysToPhaseOneInParallel;
     class InterruptAddKeysToPhaseOne;
     class DoDropDups;
     class InterruptDoDropDups;
@@ -43,6 +48,7 @@ namespace IndexUpdateTests {
 namespace mongo {
 
     class BSONObjExternalSorter;
+    class Collection;
     class ExternalSortComparison;
     class IndexDetails;
     class NamespaceDetails;
@@ -57,11 +63,28 @@ namespace mongo {
          */
         static uint64_t fastBuildIndex(const char* ns, NamespaceDetails* d, IndexDetails& idx,
                                        bool mayInterrupt, int idxNo);
+
+        /**
+         * Builds the indexes numbered 'idxNos' from a single scan of the collection.  None may
+         * drop duplicates unless it's alone.  Throws DBException.
+         */
+        static uint64_t fastBuildIndexes(const char* ns, NamespaceDetails* d,
+                                         const vector<int>& idxNos, bool mayInterrupt);
+        /**
+         * Background builds of indexes that allow duplicate keys call this instead of inserting
+         * the collection's documents into the index one at a time.  Scans the collection into an
+         * external sort, yielding as the insert path does, then bulk loads a new btree from the
+         * sorted keys and replays onto it the changes writers logged meanwhile (see
+         * BackgroundBuildChangeLog).  The index's head must be an empty bucket, which is freed.
+         * Throws DBException.
+         */
+        static uint64_t backgroundBuildIndex(Collection* collection, const string& idxName);
         static DiskLoc makeEmptyIndex(const IndexDetails& idx);
         static ExternalSortComparison* getComparison(int version, const BSONObj& keyPattern);
 
     private:
         friend class IndexUpdateTests::AddKeysToPhaseOne;
+        friend class IndexUpdateTests::AddKeysToPhaseOneInParallel;
         friend class IndexUpdateTests::InterruptAddKeysToPhaseOne;
         friend class IndexUpdateTests::DoDropDups;
         friend class IndexUpdateTests::InterruptDoDropDups;
@@ -73,8 +96,61 @@ namespace mongo {
                                       bool mayInterrupt,
                                       int idxNo);
 
+        static void addKeysToPhaseOnes(NamespaceDetails* d, const char* ns,
+                                       const vector<int>& idxNos,
+                                       const vector<SortPhaseOne*>& phaseOnes,
+                                       int64_t nrecords, ProgressMeter* progressMeter,
+                                       bool mayInterrupt);
+
         static void doDropDups(const char* ns, NamespaceDetails* d, const set<DiskLoc>& dupsToDrop,
                                bool mayInterrupt );
+
+        // Generates phase one keys on several threads, see the .cpp.
+        class ParallelKeyGenerator;
+    };
+
+    /**
+     * Changes writers make to an index while a background build bulk loads it.  The btree the
+     * build will install doesn't exist yet, so BtreeBasedAccessMethod records each key it would
+     * have inserted or removed here, and the build replays them once its btree is in place.
+     *
+     * Logging starts when the log is constructed and stops at stop() or destruction.  All access
+     * to a log's changes is under the write lock of the collection's database.
+     */
+    class BackgroundBuildChangeLog : boost::noncopyable {
+    public:
+        struct Change {
+            Change(bool insert_, const BSONObj& key_, const DiskLoc& loc_)
+                : insert(insert_), key(key_.getOwned()), loc(loc_) { }
+            bool insert;
+            BSONObj key;
+            DiskLoc loc;
+        };
+        typedef std::deque<Change> Changes;
+
+        explicit BackgroundBuildChangeLog(const string& indexNamespace);
+        ~BackgroundBuildChangeLog();
+
+        /** @return the log for 'indexNamespace', or NULL if no build is logging its changes. */
+        static BackgroundBuildChangeLog* get(const string& indexNamespace);
+
+        void noteInsert(const BSONObj& key, const DiskLoc& loc) {
+            _changes.push_back(Change(true, key, loc));
+        }
+        void noteRemove(const BSONObj& key, const DiskLoc& loc) {
+            _changes.push_back(Change(false, key, loc));
+        }
+
+        /** Stops logging.  @return the changes logged, oldest first. */
+        const Changes& stop();
+
+    private:
+        const string _indexNamespace;
+        bool _logging;
+        Changes _changes;
+
+        static SimpleMutex _mutex;
+        static std::map<string, BackgroundBuildChangeLog*> _logs;
     };
 
     // Exposed for testing purposes.
@@ -29,6 +29,7 @@
 #pragma once
 
 #include "mongo/db/jsobj.h"
+#include "mongo/db/geo/s2_covering_cache.h"
 #include "mongo/db/hasher.h"
 #include "mongo/db/query/index_bounds_builder.h"
 
@@ -48,22 +49,67 @@ namespace mongo {
         }
 
         static void cover2dsphere(const S2Region& region, OrderedIntervalList* oilOut) {
+            S2RegionCoverer coverer;
+            int coarsestIndexedLevel = configure2dsphereCoverer(region, &coverer);
+            vector<S2CellId> cover;
+            coverer.GetCovering(region, &cover);
+            coverAsIntervals(cover, coarsestIndexedLevel, oilOut);
+        }
+
+        /**
+         * As above, but the covering comes from the covering cache when 'query' was covered
+         * before.
+         */
+        static void cover2dsphere(const GeoQuery& query, OrderedIntervalList* oilOut) {
+            S2RegionCoverer coverer;
+            int coarsestIndexedLevel = configure2dsphereCoverer(query.getRegion(), &coverer);
+            vector<S2CellId> cover;
+            S2CoveringCache::global()->getCovering(query, &coverer, &cover);
+            coverAsIntervals(cover, coarsestIndexedLevel, oilOut);
+        }
+
+        /**
+         * As the first, but leaves out the cells of the covering that lie entirely within
+         * 'excluded'.  Every document indexed under such a cell has a point inside 'excluded',
+         * so callers that don't want anything from there can skip reading those keys.
+         */
+        static void cover2dsphere(const S2Region& region, const S2Region& excluded,
+                                  OrderedIntervalList* oilOut) {
+            S2RegionCoverer coverer;
+            int coarsestIndexedLevel = configure2dsphereCoverer(region, &coverer);
+            vector<S2CellId> cover;
+            coverer.GetCovering(region, &cover);
+
+            vector<S2CellId> kept;
+            for (size_t i = 0; i < cover.size(); ++i) {
+                if (!excluded.Contains(S2Cell(cover[i]))) {
+                    kept.push_back(cover[i]);
+                }
+            }
+            coverAsIntervals(kept, coarsestIndexedLevel, oilOut);
+        }
+
+    private:
+        /**
+         * Sets the levels 'coverer' covers 'region' at, and returns the coarsest indexed level.
+         */
+        static int configure2dsphereCoverer(const S2Region& region, S2RegionCoverer* coverer) {
             // XXX: should grab coarsest level from the index since the user can possibly change it.
             int coarsestIndexedLevel = 
                         S2::kAvgEdge.GetClosestLevel(100 * 1000.0 / kRadiusOfEarthInMeters);
 
-
             // The min level of our covering is the level whose cells are the closest match to the
             // *area* of the region (or the max indexed level, whichever is smaller) The max level
             // is 4 sizes larger.
             double edgeLen = sqrt(region.GetRectBound().Area());
-            S2RegionCoverer coverer;
-            coverer.set_min_level(min(coarsestIndexedLevel,
-                                      2 + S2::kAvgEdge.GetClosestLevel(edgeLen)));
-            coverer.set_max_level(4 + coverer.min_level());
+            coverer->set_min_level(min(coarsestIndexedLevel,
+                                       2 + S2::kAvgEdge.GetClosestLevel(edgeLen)));
+            coverer->set_max_level(4 + coverer->min_level());
+            return coarsestIndexedLevel;
+        }
 
-            vector<S2CellId> cover;
-            coverer.GetCovering(region, &cover);
+        static void coverAsIntervals(const vector<S2CellId>& cover, int coarsestIndexedLevel,
+                                     OrderedIntervalList* oilOut) {
 
             // Look at the cells we cover and all cells that are within our covering and finer.
             // Anything with our cover as a strict prefix is contained within the cover and should
@@ -45,9 +45,6 @@ namespace mongo {
 
         const string HASHED_INDEX_TYPE_IDENTIFIER = "hashed";
 
-        //change these if single-field limitation lifted later
-        uassert(16763, "Currently only single field hashed index supported." ,
-                1 == descriptor->getNumFields());
         uassert(16764, "Currently hashed indexes cannot guarantee uniqueness. Use a regular index.",
                 !descriptor->unique());
 
@@ -74,9 +71,20 @@ namespace mongo {
 
         //Get the hashfield name
         BSONElement firstElt = descriptor->keyPattern().firstElement();
-        massert(16765, "error: no hashed index field",
+        uassert(16765, "error: no hashed index field",
                 firstElt.str().compare(HASHED_INDEX_TYPE_IDENTIFIER) == 0);
         _hashedField = firstElt.fieldName();
+
+        // Any other fields must be plain ascending or descending ones.
+        BSONObjIterator it(descriptor->keyPattern());
+        it.next();
+        while (it.more()) {
+            BSONElement e = it.next();
+            uassert(17340, "Only the first field of a hashed index may be hashed, the others must "
+                           "be ascending or descending.",
+                    e.isNumber() && (e.numberInt() == 1 || e.numberInt() == -1));
+            _rangeFields.push_back(e.fieldName());
+        }
     }
 
     Status HashAccessMethod::newCursor(IndexCursor** out) {
@@ -85,25 +93,53 @@ namespace mongo {
     }
 
     void HashAccessMethod::getKeys(const BSONObj& obj, BSONObjSet* keys) {
-        getKeysImpl(obj, _hashedField, _seed, _hashVersion, _descriptor->isSparse(), keys);
+        getKeysImpl(obj, _hashedField, _rangeFields, _seed, _hashVersion, _descriptor->isSparse(),
+                    keys);
     }
 
     // static
     void HashAccessMethod::getKeysImpl(const BSONObj& obj, const string& hashedField, HashSeed seed,
                                        int hashVersion, bool isSparse, BSONObjSet* keys) {
+        getKeysImpl(obj, hashedField, vector<string>(), seed, hashVersion, isSparse, keys);
+    }
+
+    // static
+    void HashAccessMethod::getKeysImpl(const BSONObj& obj, const string& hashedField,
+                                       const vector<string>& rangeFields, HashSeed seed,
+                                       int hashVersion, bool isSparse, BSONObjSet* keys) {
         const char* cstr = hashedField.c_str();
         BSONElement fieldVal = obj.getFieldDottedOrArray(cstr);
         uassert(16766, "Error: hashed indexes do not currently support array values",
                 fieldVal.type() != Array );
 
-        if (!fieldVal.eoo()) {
-            BSONObj key = BSON( "" << makeSingleKey(fieldVal, seed, hashVersion));
-            keys->insert(key);
+        vector<BSONElement> rangeVals;
+        bool allMissing = fieldVal.eoo();
+        for (size_t i = 0; i < rangeFields.size(); ++i) {
+            const char* rangeField = rangeFields[i].c_str();
+            BSONElement e = obj.getFieldDottedOrArray(rangeField);
+            uassert(17341, "Error: hashed indexes do not currently support array values",
+                    e.type() != Array);
+            allMissing = allMissing && e.eoo();
+            rangeVals.push_back(e);
+        }
+
+        if (allMissing && isSparse) {
+            return;
         }
-        else if (!isSparse) {
-            BSONObj nullObj = BSON("" << BSONNULL);
-            keys->insert(BSON("" << makeSingleKey(nullObj.firstElement(), seed, hashVersion)));
+
+        BSONObj nullObj = BSON("" << BSONNULL);
+        BSONObjBuilder b;
+        b.append("", makeSingleKey(fieldVal.eoo() ? nullObj.firstElement() : fieldVal, seed,
+                                   hashVersion));
+        for (size_t i = 0; i < rangeVals.size(); ++i) {
+            if (rangeVals[i].eoo()) {
+                b.appendNull("");
+            }
+            else {
+                b.appendAs(rangeVals[i], "");
+            }
         }
+        keys->insert(b.obj());
     }
 
 }  // namespace mongo
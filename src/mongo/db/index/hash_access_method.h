@@ -29,6 +29,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "mongo/base/status.h"
 #include "mongo/db/hasher.h"  // For HashSeed.
@@ -40,6 +41,12 @@ namespace mongo {
 
     /**
      * This is the access method for "hashed" indices.
+     *
+     * The first field of the key pattern is hashed.  It may be followed by ordinary ascending or
+     * descending fields, e.g. {device: "hashed", ts: 1}, whose values are stored as they are.  The
+     * hash spreads the documents over the key space in buckets, one per hashed value, and the
+     * documents within a bucket stay in the order of the remaining fields so that ranges over
+     * them can be scanned.
      */
     class HashAccessMethod : public BtreeBasedAccessMethod {
     public:
@@ -67,12 +74,22 @@ namespace mongo {
         static void getKeysImpl(const BSONObj& obj, const string& hashedField, HashSeed seed,
                                 int hashVersion, bool isSparse, BSONObjSet* keys);
 
+        /**
+         * As above, with the values of 'rangeFields' following the hash in each key.
+         */
+        static void getKeysImpl(const BSONObj& obj, const string& hashedField,
+                                const vector<string>& rangeFields, HashSeed seed,
+                                int hashVersion, bool isSparse, BSONObjSet* keys);
+
     private:
         virtual void getKeys(const BSONObj& obj, BSONObjSet* keys);
 
         // Only one of our fields is hashed.  This is the field name for it.
         string _hashedField;
 
+        // The ordered fields following the hashed one, if any.
+        vector<string> _rangeFields;
+
         // _seed defaults to zero.
         HashSeed _seed;
 
@@ -64,11 +64,25 @@ namespace mongo {
         vector<FieldInterval>::const_iterator i;
         for( i = intervals.begin(); i != intervals.end(); ++i ){
             if ( ! i->equality() ){
+                BSONObjBuilder startKey;
+                BSONObjBuilder endKey;
+                BSONObjIterator it(_descriptor->keyPattern());
+                while (it.more()) {
+                    BSONElement e = it.next();
+                    if (e.isNumber() && e.numberInt() < 0) {
+                        startKey.appendMaxKey("");
+                        endKey.appendMinKey("");
+                    }
+                    else {
+                        startKey.appendMinKey("");
+                        endKey.appendMaxKey("");
+                    }
+                }
                 _oldCursor.reset(
                         BtreeCursor::make( nsdetails( _descriptor->parentNS()),
                             _descriptor->getOnDisk(),
-                            BSON( "" << MINKEY ) ,
-                            BSON( "" << MAXKEY ) ,
+                            startKey.obj() ,
+                            endKey.obj() ,
                             true ,
                             1 ) );
                 return Status::OK();
@@ -77,15 +91,23 @@ namespace mongo {
         }
         inArray.done();
         inObj.done();
-        BSONObj newQuery = newQueryBuilder.obj();
 
+        //Any fields after the hashed one hold their own values, so the query's constraints on
+        //them bound the scan within each hashed bucket, e.g. {a : ..., b : {$gte : 5}}
         BSONObjBuilder specBuilder;
         BSONObjIterator it(_descriptor->keyPattern());
         while (it.more()) {
             BSONElement e = it.next();
-            specBuilder.append(e.fieldName(), 1);
+            if (_hashedField != e.fieldName()) {
+                BSONElement constraint = position.getField(e.fieldName());
+                if (!constraint.eoo()) {
+                    newQueryBuilder.append(constraint);
+                }
+            }
+            specBuilder.append(e.fieldName(), (e.isNumber() && e.numberInt() < 0) ? -1 : 1);
         }
         BSONObj spec = specBuilder.obj();
+        BSONObj newQuery = newQueryBuilder.obj();
 
         //Use the point-intervals of the new query to create a Btree cursor
         FieldRangeSet newfrs( "" , newQuery , true, true );
@@ -36,6 +36,7 @@
 
 namespace mongo {
 
+    class MatchExpression;
     class UpdateTicket;
     struct InsertDeleteOptions;
 
@@ -130,6 +131,12 @@ namespace mongo {
          */
         virtual Status validate(int64_t* numKeys) = 0;
 
+        /**
+         * A partial index only holds the documents matching its filter.  Return that filter, or
+         * NULL if the index holds every document.  The access method owns the expression.
+         */
+        virtual const MatchExpression* getFilterExpression() const { return NULL; }
+
         //
         // Bulk operations support (TODO)
         //
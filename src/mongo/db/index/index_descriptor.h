@@ -125,6 +125,14 @@ namespace mongo {
         // Is this index sparse?
         bool isSparse() const { return _infoObj["sparse"].trueValue(); }
 
+        // Return the filter of a partial index, which holds only the documents it matches.
+        BSONObj partialFilterExpression() const {
+            return _infoObj.getObjectField("partialFilterExpression");
+        }
+
+        // Is this a partial index?
+        bool isPartial() const { return _infoObj["partialFilterExpression"].isABSONObj(); }
+
         // Is this index multikey?
         bool isMultikey() const { return _namespaceDetails->isMultikey(_indexNumber); }
 
@@ -30,6 +30,7 @@
 #include "mongo/db/index/s2_near_cursor.h"
 
 #include "mongo/db/btreecursor.h"
+#include "mongo/db/geo/s2_covering_cache.h"
 #include "mongo/db/index/index_cursor.h"
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/pdfile.h"
@@ -187,7 +188,7 @@ namespace mongo {
         // Cover the indexed geo components of the query.
         for (size_t i = 0; i < _indexedGeoFields.size(); ++i) {
             vector<S2CellId> cover;
-            coverer.GetCovering(_indexedGeoFields[i].getRegion(), &cover);
+            S2CoveringCache::global()->getCovering(_indexedGeoFields[i], &coverer, &cover);
             uassert(16761, "Couldn't generate index keys for geo field "
                     + _indexedGeoFields[i].getField(),
                     cover.size() > 0);
@@ -30,6 +30,7 @@
 #include "mongo/db/index/s2_simple_cursor.h"
 
 #include "mongo/db/btreecursor.h"
+#include "mongo/db/geo/s2_covering_cache.h"
 #include "mongo/db/index/index_cursor.h"
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/pdfile.h"
@@ -80,7 +81,7 @@ namespace mongo {
             vector<S2CellId> cover;
             double area = _fields[i].getRegion().GetRectBound().Area();
             S2SearchUtil::setCoverLimitsBasedOnArea(area, &coverer, _params.coarsestIndexedLevel);
-            coverer.GetCovering(_fields[i].getRegion(), &cover);
+            S2CoveringCache::global()->getCovering(_fields[i], &coverer, &cover);
             uassert(16759, "No cover ARGH?!", cover.size() > 0);
             _cellsInCover = cover.size();
             BSONObj fieldRange = S2SearchUtil::coverAsBSON(cover, _fields[i].getField(),
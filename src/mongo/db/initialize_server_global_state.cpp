@@ -44,6 +44,8 @@
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/authorization_manager_global.h"
 #include "mongo/db/auth/security_key.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/logger/async_appender.h"
 #include "mongo/logger/logger.h"
 #include "mongo/logger/console_appender.h"
 #include "mongo/logger/message_event.h"
@@ -186,6 +188,17 @@ namespace mongo {
             _exit(EXIT_FAILURE);
     }
 
+    // when positive, log files and syslog are written on a thread of their own, with up to this
+    // many messages waiting; see logger/async_appender.h
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(logAsyncQueueSize, int, 0);
+
+    static logger::MessageLogDomain::AppenderAutoPtr makeLogAppender(
+            logger::MessageLogDomain::EventAppender* appender) {
+        if (logAsyncQueueSize > 0)
+            appender = new logger::AsyncAppender(appender, logAsyncQueueSize);
+        return logger::MessageLogDomain::AppenderAutoPtr(appender);
+    }
+
     MONGO_INITIALIZER_GENERAL(ServerLogRedirection,
                               ("GlobalLogManager", "EndStartupOptionHandling", "ForkServer"),
                               ("default"))(
@@ -214,11 +227,11 @@ namespace mongo {
             LogManager* manager = logger::globalLogManager();
             manager->getGlobalDomain()->clearAppenders();
             manager->getGlobalDomain()->attachAppender(
-                    MessageLogDomain::AppenderAutoPtr(
+                    makeLogAppender(
                             new SyslogAppender<MessageEventEphemeral>(
                                     new logger::MessageEventWithContextEncoder)));
             manager->getNamedDomain("javascriptOutput")->attachAppender(
-                    MessageLogDomain::AppenderAutoPtr(
+                    makeLogAppender(
                             new SyslogAppender<MessageEventEphemeral>(
                                     new logger::MessageEventWithContextEncoder)));
 #endif // defined(_WIN32)
@@ -272,11 +285,11 @@ namespace mongo {
             LogManager* manager = logger::globalLogManager();
             manager->getGlobalDomain()->clearAppenders();
             manager->getGlobalDomain()->attachAppender(
-                    MessageLogDomain::AppenderAutoPtr(
+                    makeLogAppender(
                             new RotatableFileAppender<MessageEventEphemeral>(
                                     new MessageEventDetailsEncoder, writer.getValue())));
             manager->getNamedDomain("javascriptOutput")->attachAppender(
-                    MessageLogDomain::AppenderAutoPtr(
+                    makeLogAppender(
                             new RotatableFileAppender<MessageEventEphemeral>(
                                     new MessageEventDetailsEncoder, writer.getValue())));
 
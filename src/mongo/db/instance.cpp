@@ -46,6 +46,8 @@
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/background.h"
+#include "mongo/db/capped_insert_notifier.h"
+#include "mongo/db/catalog/index_catalog.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/commands/fsync.h"
 #include "mongo/db/d_concurrency.h"
@@ -67,10 +69,13 @@
 #include "mongo/db/ops/update.h"
 #include "mongo/db/ops/update_driver.h"
 #include "mongo/db/pagefault.h"
+#include "mongo/db/repl/flow_control.h"
 #include "mongo/db/repl/is_master.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/stats/counters.h"
+#include "mongo/db/stats/op_latency.h"
 #include "mongo/db/storage_options.h"
+#include "mongo/db/structure/collection.h"
 #include "mongo/platform/process_id.h"
 #include "mongo/s/d_logic.h"
 #include "mongo/s/stale_exception.h" // for SendStaleConfigException
@@ -351,6 +356,23 @@ namespace mongo {
         ::abort();
     }
 
+    static void recordOpLatency(int op, bool isCommand, const char* ns,
+                                unsigned long long micros) {
+        OpLatencyStats::OpType type;
+        switch (op) {
+        case dbQuery:
+            type = isCommand ? OpLatencyStats::OP_COMMAND : OpLatencyStats::OP_QUERY;
+            break;
+        case dbGetMore: type = OpLatencyStats::OP_GETMORE; break;
+        case dbInsert: type = OpLatencyStats::OP_INSERT; break;
+        case dbUpdate: type = OpLatencyStats::OP_UPDATE; break;
+        case dbDelete: type = OpLatencyStats::OP_DELETE; break;
+        // killCursors and the deprecated dbMsg have no namespace.
+        default: return;
+        }
+        OpLatencyStats::global.record(type, ns, micros);
+    }
+
     // Returns false when request includes 'end'
     void assembleResponse( Message &m, DbResponse &dbresponse, const HostAndPort& remote ) {
 
@@ -509,6 +531,7 @@ namespace mongo {
         currentOp.ensureStarted();
         currentOp.done();
         debug.executionTime = currentOp.totalTimeMillis();
+        recordOpLatency(op, isCommand, ns, currentOp.totalTimeMicros());
 
         logThreshold += currentOp.getExpectedLatencyMs();
 
@@ -639,10 +662,12 @@ namespace mongo {
             uasserted( 17009, status.reason() );
         }
 
+        waitForFlowControlTicket( ns.ns(), op );
+
         PageFaultRetryableSection s;
         while ( 1 ) {
             try {
-                Lock::DBWrite lk(ns.ns());
+                Lock::CollectionWrite lk(ns.ns());
 
                 // void ReplSetImpl::relinquish() uses big write lock so this is thus
                 // synchronized given our lock above.
@@ -705,10 +730,12 @@ namespace mongo {
         op.debug().query = pattern;
         op.setQuery(pattern);
 
+        waitForFlowControlTicket( ns.ns(), op );
+
         PageFaultRetryableSection s;
         while ( 1 ) {
             try {
-                Lock::DBWrite lk(ns.ns());
+                Lock::CollectionWrite lk(ns.ns());
                 
                 // writelock is used to synchronize stepdowns w/ writes
                 uassert( 10056 ,  "not master", isMasterNs( ns.ns().c_str() ) );
@@ -752,8 +779,15 @@ namespace mongo {
         bool exhaust = false;
         QueryResult* msgdata = 0;
         OpTime last;
+        // set up the first time an awaitData getMore finds nothing
+        scoped_ptr<CappedInsertNotifier> notifier;
+        unsigned long long notifierVersion = 0;
         while( 1 ) {
             bool isCursorAuthorized = false;
+            if ( notifier ) {
+                // read before looking for documents, so an insert after that wakes us
+                notifierVersion = notifier->version();
+            }
             try {
                 const NamespaceString nsString( ns );
                 uassert( 16258, str::stream() << "Invalid ns [" << ns << "]", nsString.isValid() );
@@ -814,10 +848,15 @@ namespace mongo {
                     }
                 }
                 pass++;
-                if (debug)
-                    sleepmillis(20);
-                else
-                    sleepmillis(2);
+                if ( !notifier ) {
+                    // look once more before waiting, since whatever was inserted before the
+                    // notifier existed didn't signal it
+                    notifier.reset( new CappedInsertNotifier( ns ) );
+                }
+                else if ( pass < 10000 ) {
+                    if ( !notifier->waitForInsert( notifierVersion, 4000 - timer->millis() ) )
+                        pass = 10000;
+                }
                 
                 // note: the 1100 is beacuse of the waitForDifferent above
                 // should eventually clean this up a bit
@@ -893,11 +932,50 @@ namespace mongo {
         logOp("i", ns, js);
     }
 
+    /**
+     * Keeps a collection's index catalog batching inserts (see IndexCatalog::beginBatchInsert)
+     * while in scope.
+     */
+    class BatchInsertScope : boost::noncopyable {
+    public:
+        BatchInsertScope(const char* ns) : _ns(ns), _catalog(NULL) { }
+        ~BatchInsertScope() { finish(); }
+
+        /** Start batching, if not already, once the collection exists. */
+        void begin() {
+            if (_catalog) {
+                return;
+            }
+            Collection* collection = cc().database()->getCollection(_ns);
+            if (collection) {
+                _catalog = collection->getIndexCatalog();
+                _catalog->beginBatchInsert();
+            }
+        }
+
+        void finish() {
+            if (_catalog) {
+                _catalog->finishBatchInsert();
+                _catalog = NULL;
+            }
+        }
+
+    private:
+        const char* _ns;
+        IndexCatalog* _catalog;
+    };
+
     NOINLINE_DECL void insertMulti(bool keepGoing, const char *ns, vector<BSONObj>& objs, CurOp& op) {
+        BatchInsertScope batch(ns);
         size_t i;
         for (i=0; i<objs.size(); i++){
             try {
+                batch.begin();
                 checkAndInsert(ns, objs[i]);
+                // A document and its keys must go to the journal in the same group commit.
+                if (getDur().aCommitIsNeeded()) {
+                    batch.finish();
+                }
                 getDur().commitIfNeeded();
             } catch (const UserException&) {
                 if (!keepGoing || i == objs.size()-1){
@@ -935,10 +1013,12 @@ namespace mongo {
             uassertStatusOK(status);
         }
 
+        waitForFlowControlTicket( ns, op );
+
         PageFaultRetryableSection s;
         while ( true ) {
             try {
-                Lock::DBWrite lk(ns);
+                Lock::CollectionWrite lk(ns);
                 
                 // CONCURRENCY TODO: is being read locked in big log sufficient here?
                 // writelock is used to synchronize stepdowns w/ writes
@@ -1148,6 +1228,17 @@ namespace {
             MemoryMappedFile::flushAll(true);
         }
 
+        log() << "shutdown: saving extent heat..." << endl;
+        {
+            set<string> dbs;
+            dbHolderUnchecked().getAllShortNames( dbs );
+            for ( set<string>::const_iterator i = dbs.begin(); i != dbs.end(); ++i ) {
+                Database* db = dbHolderUnchecked().get( *i, storageGlobalParams.dbpath );
+                if ( db )
+                    db->getExtentManager().saveHeat();
+            }
+        }
+
         log() << "shutdown: closing all files..." << endl;
         stringstream ss3;
         MemoryMappedFile::closeAllFiles( ss3 );
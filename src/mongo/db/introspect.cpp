@@ -30,16 +30,24 @@
 
 #include "mongo/pch.h"
 
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "mongo/base/counter.h"
 #include "mongo/bson/util/builder.h"
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/auth/user_set.h"
+#include "mongo/db/commands/server_status.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/database_holder.h"
 #include "mongo/db/introspect.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/background.h"
 #include "mongo/util/goodies.h"
 
 namespace {
@@ -76,13 +84,187 @@ namespace {
         builder.append("user", bestUser.getUser().empty() ? "" : bestUser.getFullName());
 
     }
-} // namespace
 
-    static void _profile(const Client& c, CurOp& currentOp, BufBuilder& profileBufBuilder) {
-        Database *db = c.database();
-        DEV verify( db );
-        const char *ns = db->getProfilingNS();
+    // With profileAsync set, profile() only builds the entry and queues it for a background
+    // thread to write, so the operation doesn't take its database's write lock again.  An
+    // entry that finds the queue full is dropped and counted.
+    MONGO_EXPORT_SERVER_PARAMETER(profileAsync, bool, false);
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(profileQueueSize, int, 4096);
+
+    Counter64 profileDroppedCounter;
+    ServerStatusMetricField<Counter64> displayProfileDropped("profiler.dropped",
+                                                             &profileDroppedCounter);
+
+    void _insertEntry(NamespaceDetails* details, const char* ns, const BSONObj& p) {
+        int len = p.objsize();
+        Record *r = theDataFileMgr.fast_oplog_insert(details, ns, len);
+        memcpy(getDur().writingPtr(r->data(), len), p.objdata(), len);
+    }
+
+    /**
+     * Writes queued profile entries to the system.profile of their databases.  Operations claim
+     * slots of a fixed ring without taking a lock; the writer takes what is ready in batches
+     * and writes each database's entries under one acquisition of its lock.
+     */
+    class ProfileWriter : public BackgroundJob {
+    public:
+        ProfileWriter() : _mask(0) {}
+
+        virtual string name() const { return "ProfileWriter"; }
+
+        void start() {
+            unsigned long long capacity = 1;
+            while (capacity < static_cast<unsigned long long>(std::max(1, profileQueueSize)))
+                capacity <<= 1;
+            _mask = capacity - 1;
+            _slots.reset(new Slot[capacity]);
+            for (unsigned long long i = 0; i < capacity; i++)
+                _slots[i].sequence.store(i);
+            _started.store(1);
+            go();
+        }
+
+        bool started() const { return _started.load(); }
+
+        /** @return false if the queue was full and the entry was dropped */
+        bool enqueue(const string& db, const BSONObj& entry) {
+            unsigned long long pos = _enqueuePos.load();
+            Slot* slot;
+            while (true) {
+                slot = &_slots[pos & _mask];
+                const unsigned long long sequence = slot->sequence.load();
+                if (sequence == pos) {
+                    const unsigned long long claimed = _enqueuePos.compareAndSwap(pos, pos + 1);
+                    if (claimed == pos)
+                        break;
+                    pos = claimed;
+                }
+                else if (sequence < pos) {
+                    // the entry from a lap ago hasn't been written yet
+                    return false;
+                }
+                else {
+                    pos = _enqueuePos.load();
+                }
+            }
+
+            slot->db = db;
+            slot->entry = entry.getOwned();
+            slot->sequence.store(pos + 1);
+
+            if (_idle.load() && _idle.swap(0))
+                _wakeWriter.notify_one();
+            return true;
+        }
+
+        virtual void run() {
+            Client::initThread("profileWriter");
+            while (!inShutdown()) {
+                vector< pair<string, BSONObj> > batch;
+                while (batch.size() < MaxBatch && takeNext(&batch))
+                    ;
+
+                if (batch.empty()) {
+                    // operations only wake us up once they see _idle set, so look at the ring
+                    // again after setting it.  an entry that still slips past waits out the
+                    // timeout.
+                    boost::unique_lock<boost::mutex> lk(_mutex);
+                    _idle.store(1);
+                    if (!hasNext())
+                        _wakeWriter.timed_wait(lk, boost::posix_time::milliseconds(100));
+                    _idle.store(0);
+                    continue;
+                }
+
+                std::stable_sort(batch.begin(), batch.end(), dbLess);
+                size_t begin = 0;
+                while (begin < batch.size()) {
+                    size_t end = begin + 1;
+                    while (end < batch.size() && batch[end].first == batch[begin].first)
+                        end++;
+                    write(batch, begin, end);
+                    begin = end;
+                }
+            }
+            cc().shutdown();
+        }
+
+    private:
+        struct Slot {
+            // Position of the entry in the slot plus one once it is ready to be written, or the
+            // position the next entry in the slot may take once it's free.
+            AtomicUInt64 sequence;
+            string db;
+            BSONObj entry;
+        };
+
+        static const size_t MaxBatch = 256;
+
+        static bool dbLess(const pair<string, BSONObj>& a, const pair<string, BSONObj>& b) {
+            return a.first < b.first;
+        }
 
+        bool hasNext() const {
+            const unsigned long long pos = _dequeuePos.load();
+            return _slots[pos & _mask].sequence.load() == pos + 1;
+        }
+
+        bool takeNext(vector< pair<string, BSONObj> >* batch) {
+            if (!hasNext())
+                return false;
+            const unsigned long long pos = _dequeuePos.load();
+            Slot& slot = _slots[pos & _mask];
+            batch->push_back(make_pair(slot.db, slot.entry));
+            slot.entry = BSONObj();
+            slot.sequence.store(pos + _mask + 1);
+            _dequeuePos.store(pos + 1);
+            return true;
+        }
+
+        void write(const vector< pair<string, BSONObj> >& batch, size_t begin, size_t end) {
+            const string ns = batch[begin].first + ".system.profile";
+            try {
+                Lock::DBWrite lk(ns);
+                if (!dbHolder()._isLoaded(ns, storageGlobalParams.dbpath)) {
+                    // dropped or closed since; don't open it again just to profile
+                    return;
+                }
+                Client::Context cx(ns, storageGlobalParams.dbpath);
+                NamespaceDetails* details = getOrCreateProfileCollection(cx.db());
+                if (!details)
+                    return;
+                for (size_t i = begin; i < end; i++)
+                    _insertEntry(details, ns.c_str(), batch[i].second);
+            }
+            catch (const DBException& e) {
+                warning() << "Caught Assertion while writing " << (end - begin)
+                          << " profile entries to " << ns << ": " << e.toString() << endl;
+            }
+        }
+
+        unsigned long long _mask;
+        boost::scoped_array<Slot> _slots;
+
+        // Position of the next entry to queue.
+        AtomicUInt64 _enqueuePos;
+
+        // Position of the next entry to write.  Only the writer changes it.
+        AtomicUInt64 _dequeuePos;
+
+        AtomicUInt32 _started;
+
+        // Set while the writer waits for entries, so that an operation knows to wake it up.
+        AtomicUInt32 _idle;
+
+        boost::mutex _mutex;
+        boost::condition_variable _wakeWriter;
+    };
+
+    ProfileWriter profileWriter;
+} // namespace
+
+    static BSONObj _buildEntry(const Client& c, CurOp& currentOp,
+                               BufBuilder& profileBufBuilder) {
         // build object
         BSONObjBuilder b(profileBufBuilder);
 
@@ -118,22 +300,41 @@ namespace {
             p = b.done();
         }
 
+        return p;
+    }
+
+    static void _profile(const Client& c, CurOp& currentOp, BufBuilder& profileBufBuilder) {
+        Database *db = c.database();
+        DEV verify( db );
+        const char *ns = db->getProfilingNS();
+
+        BSONObj p = _buildEntry(c, currentOp, profileBufBuilder);
+
         // write: not replicated
         // get or create the profiling collection
         NamespaceDetails *details = getOrCreateProfileCollection(db);
         if (details) {
-            int len = p.objsize();
-            Record *r = theDataFileMgr.fast_oplog_insert(details, ns, len);
-            memcpy(getDur().writingPtr(r->data(), len), p.objdata(), len);
+            _insertEntry(details, ns, p);
         }
     }
 
+    void startProfileWriter() {
+        profileWriter.start();
+    }
+
     void profile(const Client& c, int op, CurOp& currentOp) {
         // initialize with 1kb to start, to avoid realloc later
         // doing this outside the dblock to improve performance
         BufBuilder profileBufBuilder(1024);
 
         try {
+            if (profileAsync && profileWriter.started()) {
+                BSONObj p = _buildEntry(c, currentOp, profileBufBuilder);
+                if (!profileWriter.enqueue(nsToDatabase(currentOp.getNS()), p))
+                    profileDroppedCounter.increment();
+                return;
+            }
+
             Lock::DBWrite lk( currentOp.getNS() );
             if (dbHolder()._isLoaded(nsToDatabase(currentOp.getNS()), storageGlobalParams.dbpath)) {
                 Client::Context cx(currentOp.getNS(), storageGlobalParams.dbpath);
@@ -43,6 +43,12 @@ namespace mongo {
 
     void profile(const Client& c, int op, CurOp& currentOp);
 
+    /**
+     * Starts the thread that writes the entries profile() queues when profileAsync is set.
+     * Until it runs they are written as the operation finishes.
+     */
+    void startProfileWriter();
+
     /**
      * Get (or create) the profile collection
      *
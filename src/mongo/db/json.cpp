@@ -41,8 +41,7 @@ namespace mongo {
         ID_RESERVE_SIZE = 64,
         PAT_RESERVE_SIZE = 4096,
         OPT_RESERVE_SIZE = 64,
-        FIELD_RESERVE_SIZE = 4096,
-        STRINGVAL_RESERVE_SIZE = 4096,
+        FIELD_RESERVE_SIZE = 64,
         BINDATA_RESERVE_SIZE = 4096,
         BINDATATYPE_RESERVE_SIZE = 4096,
         NS_RESERVE_SIZE = 64,
@@ -76,7 +75,34 @@ namespace mongo {
 
     Status JParse::value(const StringData& fieldName, BSONObjBuilder& builder) {
         MONGO_JSON_DEBUG("fieldName: " << fieldName);
-        if (peekToken(LBRACE)) {
+
+        // Strings and numbers, by far the most common values, are told apart by their first
+        // character instead of after trying every keyword.
+        const char* first = _input;
+        while (first < _input_end && isspace(*reinterpret_cast<const unsigned char*>(first))) {
+            ++first;
+        }
+        const bool startsString = first < _input_end && (*first == '"' || *first == '\'');
+        const bool startsNumber = first < _input_end &&
+            (isdigit(*reinterpret_cast<const unsigned char*>(first)) ||
+             (*first == '-' && first + 1 < _input_end &&
+              isdigit(*reinterpret_cast<const unsigned char*>(first + 1))));
+
+        if (startsString) {
+            _stringValue.clear();
+            Status ret = quotedString(&_stringValue);
+            if (ret != Status::OK()) {
+                return ret;
+            }
+            builder.append(fieldName, _stringValue);
+        }
+        else if (startsNumber) {
+            Status ret = number(fieldName, builder);
+            if (ret != Status::OK()) {
+                return ret;
+            }
+        }
+        else if (peekToken(LBRACE)) {
             Status ret = object(fieldName, builder);
             if (ret != Status::OK()) {
                 return ret;
@@ -136,15 +162,6 @@ namespace mongo {
                 return ret;
             }
         }
-        else if (peekToken(DOUBLEQUOTE) || peekToken(SINGLEQUOTE)) {
-            std::string valueString;
-            valueString.reserve(STRINGVAL_RESERVE_SIZE);
-            Status ret = quotedString(&valueString);
-            if (ret != Status::OK()) {
-                return ret;
-            }
-            builder.append(fieldName, valueString);
-        }
         else if (readToken("true")) {
             builder.append(fieldName, true);
         }
@@ -279,17 +296,18 @@ namespace mongo {
             if (valueRet != Status::OK()) {
                 return valueRet;
             }
+            std::string nextField;
+            nextField.reserve(FIELD_RESERVE_SIZE);
             while (readToken(COMMA)) {
-                std::string fieldName;
-                fieldName.reserve(FIELD_RESERVE_SIZE);
-                Status fieldRet = field(&fieldName);
+                nextField.clear();
+                Status fieldRet = field(&nextField);
                 if (fieldRet != Status::OK()) {
                     return fieldRet;
                 }
                 if (!readToken(COLON)) {
                     return parseError("Expecting ':'");
                 }
-                Status valueRet = value(fieldName, *objBuilder);
+                Status valueRet = value(nextField, *objBuilder);
                 if (valueRet != Status::OK()) {
                     return valueRet;
                 }
@@ -903,8 +921,23 @@ namespace mongo {
             return parseError("Unexpected end of input");
         }
         const char* q = _input;
+        // With a single terminal and no allowed set (a quoted string), plain characters are
+        // appended a run at a time.
+        const char terminal = terminalSet[0] != '\0' && terminalSet[1] == '\0' ?
+                terminalSet[0] : '\0';
         while (q < _input_end && !match(*q, terminalSet)) {
             MONGO_JSON_DEBUG("q: " << q);
+            if (terminal != '\0' && allowedSet == NULL) {
+                const char* run = q;
+                while (q < _input_end && *q != terminal && *q != '\\' &&
+                       !(0x00 <= *q && *q <= 0x1F)) {
+                    ++q;
+                }
+                result->append(run, q - run);
+                if (q >= _input_end || *q == terminal) {
+                    break;
+                }
+            }
             if (allowedSet != NULL) {
                 if (!match(*q, allowedSet)) {
                     _input = q;
@@ -418,6 +418,11 @@ namespace mongo {
             const char* const _buf;
             const char* _input;
             const char* const _input_end;
+
+            /*
+             * _stringValue - the last string value read, kept so that its buffer is reused
+             */
+            std::string _stringValue;
     };
 
 } // namespace mongo
@@ -373,6 +373,22 @@ namespace mongo {
             return bson();
 
         BSONObjBuilder b(512);
+        appendCompactTo(b);
+        return b.obj();
+    }
+
+    BSONObj KeyV1::toBson(BufBuilder& scratch) const { 
+        verify( _keyData != 0 );
+        if( !isCompactFormat() )
+            return bson();
+
+        scratch.reset();
+        BSONObjBuilder b(scratch);
+        appendCompactTo(b);
+        return b.done();
+    }
+
+    void KeyV1::appendCompactTo(BSONObjBuilder& b) const { 
         const unsigned char *p = _keyData;
         while( 1 ) { 
             unsigned bits = *p++;
@@ -436,7 +452,6 @@ namespace mongo {
             if( (bits & cHASMORE) == 0 )
                 break;
         }
-        return b.obj();
     }
 
     static int compare(const unsigned char *&l, const unsigned char *&r) { 
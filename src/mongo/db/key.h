@@ -47,6 +47,7 @@ namespace mongo {
         explicit KeyBson(const BSONObj& obj) : _o(obj) { }
         int woCompare(const KeyBson& r, const Ordering &o) const;
         BSONObj toBson() const { return _o; }
+        BSONObj toBson(BufBuilder&) const { return _o; }
         string toString() const { return _o.toString(); }
         int dataSize() const { return _o.objsize(); }
         const char * data() const { return _o.objdata(); }
@@ -86,6 +87,12 @@ namespace mongo {
         int woCompare(const KeyV1& r, const Ordering &o) const;
         bool woEqual(const KeyV1& r) const;
         BSONObj toBson() const;
+
+        /** like toBson(), but a compact key is decoded into 'scratch' instead of a new buffer.
+            the result is only good until 'scratch' is next written to.
+        */
+        BSONObj toBson(BufBuilder& scratch) const;
+
         string toString() const { return toBson().toString(); }
 
         /** get the key data we want to store in the btree bucket */
@@ -108,6 +115,7 @@ namespace mongo {
         }
     private:
         int compareHybrid(const KeyV1& right, const Ordering& order) const;
+        void appendCompactTo(BSONObjBuilder& b) const;
     };
 
     class KeyV1Owned : public KeyV1 { 
@@ -69,9 +69,21 @@ namespace mongo {
 
         if ( mongoutils::str::equals( _pattern.firstElement().valuestrsafe() , "hashed" ) ){
             BSONElement fieldVal = doc.getFieldDotted( _pattern.firstElementFieldName() );
-            return BSON( _pattern.firstElementFieldName() <<
-                         BSONElementHasher::hash64( fieldVal ,
-                                                    BSONElementHasher::DEFAULT_HASH_SEED ) );
+            BSONObjBuilder key;
+            key.append( _pattern.firstElementFieldName() ,
+                        BSONElementHasher::hash64( fieldVal ,
+                                                   BSONElementHasher::DEFAULT_HASH_SEED ) );
+
+            // any fields after the hashed one are taken as they are
+            BSONObjIterator it( _pattern );
+            it.next();
+            while ( it.more() ) {
+                BSONElement patElt = it.next();
+                BSONElement e = doc.getFieldDotted( patElt.fieldName() );
+                if ( ! e.eoo() )
+                    key.appendAs( e , patElt.fieldName() );
+            }
+            return key.obj();
         }
 
         return doc.extractFields( _pattern );
@@ -152,6 +152,9 @@ namespace mongo {
          *
          *  If 'this' KeyPattern is { a  : "hashed" }
          *   { a: 1 } --> returns { a : NumberLong("5902408780260971510")  }
+         *
+         *  If 'this' KeyPattern is { a  : "hashed" , b : 1 }
+         *   { a: 1 , b : 4 } --> returns { a : NumberLong("5902408780260971510") , b : 4 }
          */
         BSONObj extractSingleKey( const BSONObj& doc ) const;
 
@@ -109,10 +109,72 @@ namespace mongo {
         timeLocked[mapNo(type)].fetchAndAdd( micros );
     }
 
+    long long LockStat::getTotalTimeAcquiring() const {
+        long long total = 0;
+        for ( int i = 0; i < N; i++ )
+            total += timeAcquiring[i].load();
+        return total;
+    }
+
     void LockStat::reset() {
         for ( int i = 0; i < N; i++ ) {
             timeAcquiring[i].store(0);
             timeLocked[i].store(0);
         }
     }
+
+    LockAcquisitions::LockAcquisitions() : _m( "LockAcquisitions" ), _n(0), _dropped(0) { }
+
+    void LockAcquisitions::record( char type , const StringData& resource , long long waitMicros ) {
+        SimpleMutex::scoped_lock lk( _m );
+        Entry* e = 0;
+        for ( int i = 0; i < _n; i++ ) {
+            if ( _entries[i].type == type && resource == _entries[i].resource ) {
+                e = &_entries[i];
+                break;
+            }
+        }
+        if ( !e ) {
+            if ( _n == N ) {
+                _dropped++;
+                return;
+            }
+            e = &_entries[_n++];
+            e->type = type;
+            e->resource = resource.toString();
+            e->count = 0;
+            e->waitMicros = 0;
+            e->maxWaitMicros = 0;
+        }
+        e->count++;
+        e->waitMicros += waitMicros;
+        if ( waitMicros > e->maxWaitMicros )
+            e->maxWaitMicros = waitMicros;
+    }
+
+    void LockAcquisitions::reset() {
+        SimpleMutex::scoped_lock lk( _m );
+        _n = 0;
+        _dropped = 0;
+    }
+
+    void LockAcquisitions::append( BSONArrayBuilder& b ) const {
+        SimpleMutex::scoped_lock lk( _m );
+        for ( int i = 0; i < _n; i++ ) {
+            const Entry& e = _entries[i];
+            BSONObjBuilder o( b.subobjStart() );
+            o.append( "mode" , string( 1 , e.type ) );
+            o.append( "ns" , e.resource );
+            o.append( "count" , e.count );
+            o.appendNumber( "waitMicros" , e.waitMicros );
+            o.appendNumber( "maxWaitMicros" , e.maxWaitMicros );
+            o.done();
+        }
+        if ( _dropped ) {
+            BSONObjBuilder o( b.subobjStart() );
+            o.append( "ns" , "..." );
+            o.append( "count" , _dropped );
+            o.done();
+        }
+    }
 }
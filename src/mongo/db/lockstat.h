@@ -31,12 +31,17 @@
 
 #pragma once
 
+#include <string>
+
+#include "mongo/base/string_data.h"
 #include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/timer.h"
 
 namespace mongo { 
 
     class BSONObj;
+    class BSONArrayBuilder;
 
     class LockStat { 
         enum { N = 4 };
@@ -50,6 +55,8 @@ namespace mongo {
         void report( StringBuilder& builder ) const;
 
         long long getTimeLocked( char type ) const { return timeLocked[mapNo(type)].load(); }
+        /** @return the time spent acquiring locks of every type */
+        long long getTotalTimeAcquiring() const;
     private:
         static void _append( BSONObjBuilder& builder, const AtomicInt64* data );
         
@@ -62,4 +69,36 @@ namespace mongo {
         static char nameFor(unsigned offset);
     };
 
+    /**
+     * the locks a single operation acquired: for each mode and resource (a database, a
+     * collection, or "." for the global lock), how many times, which counts reacquiring after
+     * yields, and how long it waited.  only the first few resources are kept.
+     * read from other threads for currentOp, thus the mutex.
+     */
+    class LockAcquisitions {
+    public:
+        LockAcquisitions();
+
+        void record( char type , const StringData& resource , long long waitMicros );
+        void reset();
+
+        /** appends [ { mode, ns, count, waitMicros, maxWaitMicros }, ... ] */
+        void append( BSONArrayBuilder& b ) const;
+
+    private:
+        enum { N = 8 };
+        struct Entry {
+            char type;
+            std::string resource;
+            int count;
+            long long waitMicros;
+            long long maxWaitMicros;
+        };
+
+        mutable SimpleMutex _m;
+        Entry _entries[N];
+        int _n;
+        int _dropped;  // acquisitions of resources past the first N
+    };
+
 }
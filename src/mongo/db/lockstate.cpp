@@ -48,9 +48,11 @@ namespace mongo {
           _nestableCount(0), 
           _otherCount(0), 
           _otherLock(NULL),
+          _collectionLock(NULL),
           _scopedLk(NULL),
           _lockPending(false),
-          _lockPendingParallelWriter(false)
+          _lockPendingParallelWriter(false),
+          _admissionPriority( Lock::priorityUser )
     {
     }
 
@@ -75,8 +77,15 @@ namespace mongo {
         nsToDatabase(ns, db);
         
         DEV verify( _otherName.find( '.' ) == string::npos ); // XXX this shouldn't be here, but somewhere
-        if ( _otherCount && db == _otherName )
-            return true;
+        if ( _otherCount && db == _otherName ) {
+            if ( !_collectionLock )
+                return true;
+            // just the one collection, and its indexes' namespaces, are ours
+            if ( !ns.startsWith( _collectionName ) )
+                return false;
+            StringData rest = ns.substr( _collectionName.size() );
+            return rest.empty() || rest.startsWith( ".$" );
+        }
 
         if ( _nestableCount ) {
             if ( mongoutils::str::equals( db , "local" ) )
@@ -136,10 +145,16 @@ namespace mongo {
         }
         if( _otherCount ) { 
             WrapperForRWLock *k = _otherLock;
+            WrapperForRWLock *c = _collectionLock;
             if( k ) {
                 string s = "^";
                 s += k->name();
-                b.append(s, kind(_otherCount));
+                b.append(s, c ? "w" : kind(_otherCount));
+            }
+            if( c ) {
+                string s = "^";
+                s += c->name();
+                b.append(s, "W");
             }
         }
         BSONObj o = b.obj();
@@ -166,6 +181,8 @@ namespace mongo {
             ss << " otherCount:" << _otherCount;
             if( _otherCount ) {
                 ss << " otherdb:" << _otherName;
+                if( _collectionLock )
+                    ss << " collection:" << _collectionName;
             }
             if( _nestableCount ) {
                 ss << " nestableCount:" << _nestableCount << " which:";
@@ -230,10 +247,36 @@ namespace mongo {
         _otherCount = 0;
     }
 
+    void LockState::lockedCollection( const StringData& ns , WrapperForRWLock* lock ) {
+        fassert( 17343 , _otherCount > 0 && _collectionLock == NULL );
+        _collectionName = ns.toString();
+        _collectionLock = lock;
+    }
+
+    void LockState::unlockedCollection() {
+        _collectionLock = NULL;
+    }
+
+    StringData LockState::getRelevantResource() const {
+        if ( _whichNestable )
+            return _whichNestable == Lock::local ? "local" : "admin";
+
+        if ( _collectionLock )
+            return _collectionName;
+
+        if ( _otherCount && _otherLock )
+            return _otherName;
+
+        return ".";
+    }
+
     LockStat* LockState::getRelevantLockStat() {
         if ( _whichNestable )
             return Lock::nestableLockStat( _whichNestable );
 
+        if ( _collectionLock )
+            return &_collectionLock->stats;
+
         if ( _otherCount && _otherLock )
             return &_otherLock->stats;
         
@@ -244,24 +287,48 @@ namespace mongo {
     }
 
 
+    static AtomicInt32 queuedReaders;
+    static AtomicInt32 queuedWriters;
+    static AtomicInt64 acquireMicrosAverage;
+
+    void LockState::queuedRequests( int* writers , int* readers ) {
+        *writers = queuedWriters.load();
+        *readers = queuedReaders.load();
+    }
+
+    long long LockState::recentAcquireMicros() {
+        return acquireMicrosAverage.loadRelaxed();
+    }
+
     Acquiring::Acquiring( Lock::ScopedLock* lock,  LockState& ls )
-        : _lock( lock ), _ls( ls ){
+        : _lock( lock ), _ls( ls ),
+          _writer( lock && ( lock->type() == 'w' || lock->type() == 'W' ) ) {
         _ls._lockPending = true;
+        ( _writer ? queuedWriters : queuedReaders ).fetchAndAdd( 1 );
     }
 
     Acquiring::~Acquiring() {
+        ( _writer ? queuedWriters : queuedReaders ).fetchAndSubtract( 1 );
         _ls._lockPending = false;
         LockStat* stat = _ls.getRelevantLockStat();
-        if ( stat && _lock )
-            stat->recordAcquireTimeMicros( _ls.threadState(), _lock->acquireFinished( stat ) );
+        if ( stat && _lock ) {
+            long long micros = _lock->acquireFinished( stat );
+            stat->recordAcquireTimeMicros( _ls.threadState(), micros );
+
+            // racy, but it's only a hint for yielding; weighs the last ~16 acquisitions
+            long long avg = acquireMicrosAverage.loadRelaxed();
+            acquireMicrosAverage.store( avg + ( micros - avg ) / 16 );
+        }
     }
     
     AcquiringParallelWriter::AcquiringParallelWriter( LockState& ls )
         : _ls( ls ) {
         _ls._lockPendingParallelWriter = true;
+        queuedReaders.fetchAndAdd( 1 );
     }
     
     AcquiringParallelWriter::~AcquiringParallelWriter() {
+        queuedReaders.fetchAndSubtract( 1 );
         _ls._lockPendingParallelWriter = false;
     }
 
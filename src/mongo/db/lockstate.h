@@ -32,6 +32,8 @@
 #pragma once
 
 #include "mongo/db/d_concurrency.h"
+#include "mongo/util/concurrency/intentlock.h"
+#include "mongo/util/concurrency/priority_gate.h"
 
 namespace mongo {
 
@@ -64,6 +66,11 @@ namespace mongo {
         /** pending means we are currently trying to get a lock */
         bool hasLockPending() const { return _lockPending || _lockPendingParallelWriter; }
 
+        /** how many threads are trying to get a lock right now, without walking the clients */
+        static void queuedRequests( int* writers , int* readers );
+        /** a moving average of how long recent lock acquisitions waited, in micros */
+        static long long recentAcquireMicros();
+
         // ----
 
 
@@ -82,6 +89,10 @@ namespace mongo {
         int otherCount() const { return _otherCount; }
         const string& otherName() const { return _otherName; }
         WrapperForRWLock* otherLock() const { return _otherLock; }
+
+        /** true if the other db is locked intent exclusive, with one of its collections locked */
+        bool otherIsIntent() const { return _otherCount && _collectionLock; }
+        const string& collectionName() const { return _collectionName; }
         
         void enterScopedLock( Lock::ScopedLock* lock );
         Lock::ScopedLock* leaveScopedLock();
@@ -91,9 +102,16 @@ namespace mongo {
         void lockedOther( const StringData& db , int type , WrapperForRWLock* lock );
         void lockedOther( int type );  // "same lock as last time" case 
         void unlockedOther();
+        void lockedCollection( const StringData& ns , WrapperForRWLock* lock );
+        void unlockedCollection();
         bool _batchWriter;
 
+        Lock::Priority admissionPriority() const { return _admissionPriority; }
+        void setAdmissionPriority( Lock::Priority p ) { _admissionPriority = p; }
+
         LockStat* getRelevantLockStat();
+        /** what getRelevantLockStat is for: a db, a collection, or "." for the global lock */
+        StringData getRelevantResource() const;
         void recordLockTime() { _scopedLk->recordTime(); }
         void resetLockTime() { _scopedLk->resetTime(); }
         
@@ -111,6 +129,10 @@ namespace mongo {
         string _otherName;             // which database are we locking and working with (besides local/admin) 
         WrapperForRWLock* _otherLock;  // so we don't have to check the map too often (the map has a mutex)
 
+        // collection level locking related
+        string _collectionName;        // the one collection of the other db we have write locked
+        WrapperForRWLock* _collectionLock; // its lock, set only while held
+
         // for temprelease
         // for the nonrecursive case. otherwise there would be many
         // the first lock goes here, which is ok since we can't yield recursive locks
@@ -119,20 +141,34 @@ namespace mongo {
         bool _lockPending;
         bool _lockPendingParallelWriter;
 
+        Lock::Priority _admissionPriority;
+
         friend class Acquiring;
         friend class AcquiringParallelWriter;
     };
 
     class WrapperForRWLock : boost::noncopyable { 
         SimpleRWLock r;
+        IntentLock i; // with collection level locking, keeps readers and collection writers apart
     public:
         string name() const { return r.name; }
         LockStat stats;
+        PriorityGate gate;
         WrapperForRWLock(const StringData& name) : r(name) { }
         void lock()          { r.lock(); }
-        void lock_shared()   { r.lock_shared(); }
         void unlock()        { r.unlock(); }
-        void unlock_shared() { r.unlock_shared(); }
+        void lock_shared() {
+            r.lock_shared();
+            if ( Lock::collectionLockingEnabled() )
+                i.lock_S();
+        }
+        void unlock_shared() {
+            if ( Lock::collectionLockingEnabled() )
+                i.unlock_S();
+            r.unlock_shared();
+        }
+        void lock_intent()   { r.lock_shared(); i.lock_IX(); }
+        void unlock_intent() { i.unlock_IX(); r.unlock_shared(); }
     };
 
     class ScopedLock;
@@ -144,6 +180,7 @@ namespace mongo {
     private:
         Lock::ScopedLock* _lock;
         LockState& _ls;
+        bool _writer;
     };
         
     class AcquiringParallelWriter {
@@ -0,0 +1,324 @@
+// expression_compiled.cpp
+
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/matcher/expression_compiled.h"
+
+#include <algorithm>
+
+#include "mongo/bson/bsonobjiterator.h"
+#include "mongo/db/matcher/matchable.h"
+#include "mongo/db/matcher/path.h"
+
+namespace mongo {
+
+    /**
+     * Hands out iterators positioned on elements found through the trie.  Each node's element is
+     * looked up at most once per document, along with those of its siblings.
+     */
+    class CompiledMatchExpression::Document : public MatchableDocument {
+    public:
+        Document( const CompiledMatchExpression* compiled, const BSONObj& obj )
+            : _compiled( compiled ), _obj( obj ), _resolvedNodes( 0 ), _iteratorUsed( false ) {
+        }
+
+        virtual ~Document() {}
+
+        virtual BSONObj toBSON() const { return _obj; }
+
+        virtual ElementIterator* allocateIterator( const ElementPath* path ) const {
+            BSONElementIterator* iterator;
+            if ( _iteratorUsed ) {
+                iterator = new BSONElementIterator();
+            }
+            else {
+                _iteratorUsed = true;
+                iterator = &_iterator;
+            }
+
+            if ( _compiled->_nodes.empty() ) {
+                iterator->reset( path, _obj );
+                return iterator;
+            }
+
+            const std::vector<int>& nodes = _compiled->_resolvePath( path ).nodes;
+            if ( nodes.empty() ) {
+                iterator->reset( path, _obj );
+                return iterator;
+            }
+
+            size_t idxPath = 0;
+            BSONElement e = _find( nodes, &idxPath );
+            iterator->reset( path, e, idxPath );
+            return iterator;
+        }
+
+        virtual void releaseIterator( ElementIterator* iterator ) const {
+            if ( iterator == &_iterator ) {
+                _iteratorUsed = false;
+            }
+            else {
+                delete iterator;
+            }
+        }
+
+    private:
+        /** The same element and stopping part as getFieldDottedOrArray(). */
+        BSONElement _find( const std::vector<int>& nodes, size_t* idxPath ) const {
+            BSONElement res;
+            size_t part = 0;
+            while ( part < nodes.size() ) {
+                res = _element( nodes[part] );
+                if ( res.type() == Object ) {
+                    ++part;
+                    continue;
+                }
+                if ( res.type() != EOO && res.type() != Array && part + 1 < nodes.size() )
+                    res = BSONElement();
+                break;
+            }
+            *idxPath = part;
+            return res;
+        }
+
+        BSONElement _element( int node ) const {
+            if ( !( _resolvedNodes & ( 1u << node ) ) )
+                _resolveChildren( _compiled->_nodes[node].parent );
+            return _elements[node];
+        }
+
+        /** Only called for the root or a node whose element is an Object. */
+        void _resolveChildren( int parent ) const {
+            const std::vector<int>& children = _compiled->_children( parent );
+            BSONObj obj = parent < 0 ? _obj : _elements[parent].embeddedObject();
+
+            // the first field of each name is the one getField() would return
+            size_t remaining = children.size();
+            BSONObjIterator i( obj );
+            while ( remaining > 0 && i.more() ) {
+                BSONElement e = i.next();
+                StringData fieldName = e.fieldNameStringData();
+                for ( size_t j = 0; j < children.size(); ++j ) {
+                    int child = children[j];
+                    if ( _resolvedNodes & ( 1u << child ) )
+                        continue;
+                    if ( _compiled->_nodes[child].name == fieldName ) {
+                        _elements[child] = e;
+                        _resolvedNodes |= 1u << child;
+                        --remaining;
+                        break;
+                    }
+                }
+            }
+
+            // the rest aren't there and keep their EOO
+            for ( size_t j = 0; j < children.size(); ++j ) {
+                _resolvedNodes |= 1u << children[j];
+            }
+        }
+
+        const CompiledMatchExpression* _compiled;
+        BSONObj _obj;
+
+        mutable BSONElement _elements[MaxPathNodes];
+        mutable unsigned _resolvedNodes;
+
+        mutable BSONElementIterator _iterator;
+        mutable bool _iteratorUsed;
+    };
+
+    namespace {
+
+        struct ClauseOrder {
+            ClauseOrder( const std::vector<double>& scores ) : _scores( scores ) {}
+            bool operator()( size_t a, size_t b ) const { return _scores[a] < _scores[b]; }
+            const std::vector<double>& _scores;
+        };
+
+    }
+
+    CompiledMatchExpression::CompiledMatchExpression( const MatchExpression* root )
+        : _root( root ), _numPaths( 0 ), _sinceReorder( 0 ) {
+
+        _addPaths( root );
+        if ( _numPaths < 2 || _nodes.size() > MaxPathNodes ) {
+            _nodes.clear();
+            _rootChildren.clear();
+        }
+
+        if ( root->matchType() == MatchExpression::AND && root->numChildren() > 1 ) {
+            for ( size_t i = 0; i < root->numChildren(); ++i ) {
+                _order.push_back( i );
+                _stats.push_back( ClauseStats() );
+                _stats.back().cost = _cost( root->getChild( i ) );
+            }
+            _reorder();
+        }
+    }
+
+    void CompiledMatchExpression::_addPaths( const MatchExpression* expression ) {
+        if ( expression->isLogical() ) {
+            for ( size_t i = 0; i < expression->numChildren(); ++i ) {
+                _addPaths( expression->getChild( i ) );
+            }
+            return;
+        }
+
+        // array operators match their children against the array's elements, not the document
+        FieldRef path;
+        path.parse( expression->path() );
+        if ( path.numParts() == 0 )
+            return;
+
+        int node = -1;
+        for ( size_t i = 0; i < path.numParts(); ++i ) {
+            node = _addNode( node, path.getPart( i ) );
+        }
+        ++_numPaths;
+    }
+
+    int CompiledMatchExpression::_addNode( int parent, const StringData& name ) {
+        int node = _findChild( parent, name );
+        if ( node >= 0 )
+            return node;
+
+        node = _nodes.size();
+        _nodes.push_back( PathNode() );
+        _nodes.back().name = name.toString();
+        _nodes.back().parent = parent;
+        if ( parent < 0 )
+            _rootChildren.push_back( node );
+        else
+            _nodes[parent].children.push_back( node );
+        return node;
+    }
+
+    int CompiledMatchExpression::_findChild( int parent, const StringData& name ) const {
+        const std::vector<int>& children = _children( parent );
+        for ( size_t i = 0; i < children.size(); ++i ) {
+            if ( _nodes[children[i]].name == name )
+                return children[i];
+        }
+        return -1;
+    }
+
+    const std::vector<int>& CompiledMatchExpression::_children( int parent ) const {
+        return parent < 0 ? _rootChildren : _nodes[parent].children;
+    }
+
+    const CompiledMatchExpression::ResolvedPath&
+    CompiledMatchExpression::_resolvePath( const ElementPath* path ) const {
+        for ( size_t i = 0; i < _resolved.size(); ++i ) {
+            if ( _resolved[i].path == path )
+                return _resolved[i];
+        }
+
+        _resolved.push_back( ResolvedPath() );
+        ResolvedPath& resolved = _resolved.back();
+        resolved.path = path;
+
+        const FieldRef& fieldRef = path->fieldRef();
+        int node = -1;
+        for ( size_t i = 0; i < fieldRef.numParts(); ++i ) {
+            node = _findChild( node, fieldRef.getPart( i ) );
+            if ( node < 0 ) {
+                resolved.nodes.clear();
+                break;
+            }
+            resolved.nodes.push_back( node );
+        }
+        return resolved;
+    }
+
+    int CompiledMatchExpression::_cost( const MatchExpression* expression ) {
+        switch ( expression->matchType() ) {
+        case MatchExpression::AND:
+        case MatchExpression::OR:
+        case MatchExpression::NOR:
+        case MatchExpression::NOT: {
+            int cost = 0;
+            for ( size_t i = 0; i < expression->numChildren(); ++i ) {
+                cost += _cost( expression->getChild( i ) );
+            }
+            return std::max( cost, 1 );
+        }
+        case MatchExpression::WHERE:
+            return 100;
+        case MatchExpression::GEO:
+            return 10;
+        case MatchExpression::REGEX:
+        case MatchExpression::ALL:
+        case MatchExpression::ELEM_MATCH_OBJECT:
+        case MatchExpression::ELEM_MATCH_VALUE:
+            return 5;
+        case MatchExpression::MATCH_IN:
+        case MatchExpression::NIN:
+            return 2;
+        default:
+            return 1;
+        }
+    }
+
+    void CompiledMatchExpression::_reorder() const {
+        // cost per rejected document, with one success and one failure assumed up front
+        std::vector<double> scores( _stats.size() );
+        for ( size_t i = 0; i < _stats.size(); ++i ) {
+            const ClauseStats& stats = _stats[i];
+            scores[i] = stats.cost * double( stats.tried + 2 ) / double( stats.failed + 1 );
+        }
+        std::stable_sort( _order.begin(), _order.end(), ClauseOrder( scores ) );
+        _sinceReorder = 0;
+    }
+
+    bool CompiledMatchExpression::matchesBSON( const BSONObj& doc, MatchDetails* details ) const {
+        if ( _nodes.empty() && _order.empty() )
+            return _root->matchesBSON( doc, details );
+
+        Document mydoc( this, doc );
+        if ( _order.empty() || ( details && details->needRecord() ) )
+            return _root->matches( &mydoc, details );
+
+        if ( ++_sinceReorder >= ReorderInterval )
+            _reorder();
+
+        for ( size_t i = 0; i < _order.size(); ++i ) {
+            size_t clause = _order[i];
+            ClauseStats& stats = _stats[clause];
+            ++stats.tried;
+            if ( !_root->getChild( clause )->matches( &mydoc, details ) ) {
+                ++stats.failed;
+                if ( details )
+                    details->resetOutput();
+                return false;
+            }
+        }
+        return true;
+    }
+
+}
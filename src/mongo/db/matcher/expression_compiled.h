@@ -0,0 +1,124 @@
+// expression_compiled.h
+
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/match_details.h"
+
+namespace mongo {
+
+    class ElementPath;
+
+    /**
+     * A MatchExpression prepared for matching many documents.
+     *
+     * The paths of the expression's leaves are merged into a trie, so "a.b.c" and "a.b.d" share
+     * the nodes for "a" and "a.b".  The first leaf that looks for a field of a document makes one
+     * pass over the object holding it, which finds that field for every other leaf too.  Arrays
+     * along a path are still walked by BSONElementIterator.
+     *
+     * The clauses of a top level $and are tried cheapest and most often failing first: each has
+     * a static cost, and the order is revised from how often each clause has failed so far.  The
+     * order is kept when an elemMatchKey is requested, as the clause recording it then matters.
+     *
+     * The counters make it unsafe to share between threads, like the cursor owning it.
+     */
+    class CompiledMatchExpression {
+        MONGO_DISALLOW_COPYING( CompiledMatchExpression );
+    public:
+        /** Most nodes in a path trie; expressions with more match without one. */
+        static const size_t MaxPathNodes = 32;
+
+        /** Documents matched between revisions of the $and order. */
+        static const long long ReorderInterval = 1000;
+
+        /** @param root is not owned and must outlive this */
+        explicit CompiledMatchExpression( const MatchExpression* root );
+
+        bool matchesBSON( const BSONObj& doc, MatchDetails* details = 0 ) const;
+
+        /** @return the number of nodes in the path trie, 0 if documents are matched without one */
+        size_t numPathNodes() const { return _nodes.size(); }
+
+        /** @return the indexes of the top level $and's clauses in the order they are tried */
+        std::vector<size_t> clauseOrder() const { return _order; }
+
+    private:
+        class Document;
+
+        struct PathNode {
+            std::string name;
+            int parent;
+            std::vector<int> children;
+        };
+
+        /** a leaf's path, by the trie node of each of its parts; empty if the path isn't known */
+        struct ResolvedPath {
+            const ElementPath* path;
+            std::vector<int> nodes;
+        };
+
+        struct ClauseStats {
+            ClauseStats() : cost( 1 ), tried( 0 ), failed( 0 ) {}
+            int cost;
+            long long tried;
+            long long failed;
+        };
+
+        void _addPaths( const MatchExpression* expression );
+        int _addNode( int parent, const StringData& name );
+        int _findChild( int parent, const StringData& name ) const;
+        const std::vector<int>& _children( int parent ) const;
+        const ResolvedPath& _resolvePath( const ElementPath* path ) const;
+
+        static int _cost( const MatchExpression* expression );
+        void _reorder() const;
+
+        const MatchExpression* _root;
+
+        std::vector<PathNode> _nodes;
+        std::vector<int> _rootChildren;
+        size_t _numPaths;
+
+        // ElementPaths are owned by the leaves, so their addresses identify them
+        mutable std::vector<ResolvedPath> _resolved;
+
+        mutable std::vector<size_t> _order;
+        mutable std::vector<ClauseStats> _stats;
+        mutable long long _sinceReorder;
+    };
+
+}
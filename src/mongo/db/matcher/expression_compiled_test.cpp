@@ -0,0 +1,152 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/** Unit tests for CompiledMatchExpression in expression_compiled.{h,cpp}. */
+
+#include "mongo/unittest/unittest.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/json.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/expression_compiled.h"
+#include "mongo/db/matcher/expression_parser.h"
+
+namespace mongo {
+
+    namespace {
+
+        MatchExpression* parse( const BSONObj& query ) {
+            StatusWithMatchExpression result = MatchExpressionParser::parse( query );
+            ASSERT_TRUE( result.isOK() );
+            return result.getValue();
+        }
+
+        /** The compiled expression must agree with the expression on every document. */
+        void assertSameMatches( const char* query, const char* docs ) {
+            auto_ptr<MatchExpression> expression( parse( fromjson( query ) ) );
+            CompiledMatchExpression compiled( expression.get() );
+            BSONObjIterator i( fromjson( docs ) );
+            while ( i.more() ) {
+                BSONObj doc = i.next().Obj();
+                ASSERT_EQUALS( expression->matchesBSON( doc ), compiled.matchesBSON( doc ) );
+            }
+        }
+
+    }
+
+    TEST( CompiledMatchExpression, SharedPrefix ) {
+        auto_ptr<MatchExpression> expression( parse( fromjson( "{'a.b':1,'a.c':2,d:3}" ) ) );
+        CompiledMatchExpression compiled( expression.get() );
+        // a, a.b, a.c and d
+        ASSERT_EQUALS( 4U, compiled.numPathNodes() );
+        ASSERT( compiled.matchesBSON( fromjson( "{a:{b:1,c:2},d:3}" ) ) );
+        ASSERT( compiled.matchesBSON( fromjson( "{d:3,a:{c:2,b:1}}" ) ) );
+        ASSERT( !compiled.matchesBSON( fromjson( "{a:{b:1},d:3}" ) ) );
+        ASSERT( !compiled.matchesBSON( fromjson( "{a:{b:1,c:2}}" ) ) );
+        ASSERT( !compiled.matchesBSON( fromjson( "{a:1,d:3}" ) ) );
+    }
+
+    TEST( CompiledMatchExpression, SinglePathNoTrie ) {
+        auto_ptr<MatchExpression> expression( parse( fromjson( "{'a.b':1}" ) ) );
+        CompiledMatchExpression compiled( expression.get() );
+        ASSERT_EQUALS( 0U, compiled.numPathNodes() );
+        ASSERT( compiled.matchesBSON( fromjson( "{a:{b:1}}" ) ) );
+        ASSERT( !compiled.matchesBSON( fromjson( "{a:{b:2}}" ) ) );
+    }
+
+    TEST( CompiledMatchExpression, TooManyPaths ) {
+        BSONObjBuilder query;
+        for ( size_t i = 0; i <= CompiledMatchExpression::MaxPathNodes; ++i ) {
+            query.append( BSONObjBuilder::numStr( i ), 1 );
+        }
+        auto_ptr<MatchExpression> expression( parse( query.obj() ) );
+        CompiledMatchExpression compiled( expression.get() );
+        ASSERT_EQUALS( 0U, compiled.numPathNodes() );
+        ASSERT( !compiled.matchesBSON( BSON( "0" << 1 ) ) );
+    }
+
+    TEST( CompiledMatchExpression, SameAsUncompiled ) {
+        const char* docs =
+            "{0:{a:{b:1,c:2}},"
+            " 1:{a:[{b:1},{c:2}]},"
+            " 2:{a:[{b:1,c:2}]},"
+            " 3:{a:{b:[1,3],c:[2]}},"
+            " 4:{a:[[{b:1}]],x:5},"
+            " 5:{a:{b:1,b:2,c:2}},"
+            " 6:{a:{b:2,c:2},a:{b:1,c:2}},"
+            " 7:{a:5,x:5},"
+            " 8:{'a.b':1,a:{c:2}},"
+            " 9:{a:{'0':{b:1},c:2}},"
+            " 10:{a:[{b:1,c:2},{b:3}],x:[5,6]},"
+            " 11:{a:null},"
+            " 12:{}}";
+
+        assertSameMatches( "{'a.b':1,'a.c':2}", docs );
+        assertSameMatches( "{'a.b':{$gt:0},'a.c':{$exists:true}}", docs );
+        assertSameMatches( "{'a.b':{$exists:false},x:5}", docs );
+        assertSameMatches( "{'a.0.b':1,'a.c':2}", docs );
+        assertSameMatches( "{a:{$elemMatch:{b:1}},'a.c':2}", docs );
+        assertSameMatches( "{'a.b':{$all:[1,3]},'a.c':{$size:1}}", docs );
+        assertSameMatches( "{$or:[{'a.b':1},{x:{$in:[6]}}],'a.c':{$ne:2}}", docs );
+        assertSameMatches( "{$nor:[{'a.b':null},{'a.c':null}]}", docs );
+        assertSameMatches( "{'a.b':{$type:4},x:{$not:{$gt:5}}}", docs );
+        assertSameMatches( "{a:null,'a.b':null}", docs );
+    }
+
+    TEST( CompiledMatchExpression, ReordersAnd ) {
+        auto_ptr<MatchExpression> expression( parse( fromjson( "{a:1,b:1}" ) ) );
+        CompiledMatchExpression compiled( expression.get() );
+        ASSERT_EQUALS( 0U, compiled.clauseOrder()[0] );
+
+        // b rejects every document, so it should be tried first
+        for ( long long i = 0; i < CompiledMatchExpression::ReorderInterval; ++i ) {
+            ASSERT( !compiled.matchesBSON( BSON( "a" << 1 << "b" << 2 ) ) );
+        }
+        ASSERT( !compiled.matchesBSON( BSON( "a" << 1 << "b" << 2 ) ) );
+        ASSERT_EQUALS( 1U, compiled.clauseOrder()[0] );
+        ASSERT( compiled.matchesBSON( BSON( "a" << 1 << "b" << 1 ) ) );
+        ASSERT( !compiled.matchesBSON( BSON( "a" << 2 << "b" << 1 ) ) );
+    }
+
+    TEST( CompiledMatchExpression, CheapClausesFirst ) {
+        auto_ptr<MatchExpression> expression( parse( fromjson( "{a:/x/,b:1}" ) ) );
+        CompiledMatchExpression compiled( expression.get() );
+        ASSERT_EQUALS( 1U, compiled.clauseOrder()[0] );
+    }
+
+    TEST( CompiledMatchExpression, ElemMatchKey ) {
+        auto_ptr<MatchExpression> expression( parse( fromjson( "{'a.b':1,'a.c':2}" ) ) );
+        CompiledMatchExpression compiled( expression.get() );
+        MatchDetails details;
+        details.requestElemMatchKey();
+        ASSERT( compiled.matchesBSON( fromjson( "{a:[{b:5},{b:1,c:2}]}" ), &details ) );
+        ASSERT( details.hasElemMatchKey() );
+        ASSERT_EQUALS( "1", details.elemMatchKey() );
+    }
+
+}
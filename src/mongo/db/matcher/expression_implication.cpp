@@ -0,0 +1,165 @@
+// expression_implication.cpp
+
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/db/matcher/expression_implication.h"
+
+#include "mongo/db/matcher/expression_leaf.h"
+
+namespace mongo {
+
+    namespace {
+
+        bool isComparison(MatchExpression::MatchType type) {
+            return MatchExpression::LT == type || MatchExpression::LTE == type ||
+                MatchExpression::GT == type || MatchExpression::GTE == type;
+        }
+
+        // The types implemented by a LeafMatchExpression.
+        bool isLeafMatch(MatchExpression::MatchType type) {
+            switch (type) {
+            case MatchExpression::LTE:
+            case MatchExpression::LT:
+            case MatchExpression::EQ:
+            case MatchExpression::GT:
+            case MatchExpression::GTE:
+            case MatchExpression::REGEX:
+            case MatchExpression::MOD:
+            case MatchExpression::EXISTS:
+            case MatchExpression::MATCH_IN:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        bool isLowerBound(MatchExpression::MatchType type) {
+            return MatchExpression::GT == type || MatchExpression::GTE == type;
+        }
+
+        // Values a range can be compared against without bracketing surprises.
+        bool isPlainBound(const BSONElement& e) {
+            return e.type() != MinKey && e.type() != MaxKey && e.type() != Array &&
+                e.type() != jstNULL && e.type() != Undefined;
+        }
+
+        bool rangeImplies(const ComparisonMatchExpression* premise,
+                          const ComparisonMatchExpression* conclusion) {
+            if (isLowerBound(premise->matchType()) != isLowerBound(conclusion->matchType()))
+                return false;
+
+            const BSONElement& p = premise->getData();
+            const BSONElement& c = conclusion->getData();
+            if (!isPlainBound(p) || !isPlainBound(c) || p.canonicalType() != c.canonicalType())
+                return false;
+
+            int cmp = compareElementValues(p, c);
+            if (!isLowerBound(premise->matchType()))
+                cmp = -cmp;
+
+            // premise is now at least as tight as conclusion if its bound is further in
+            if (cmp > 0)
+                return true;
+            if (cmp < 0)
+                return false;
+            bool premiseStrict = MatchExpression::GT == premise->matchType() ||
+                MatchExpression::LT == premise->matchType();
+            bool conclusionStrict = MatchExpression::GT == conclusion->matchType() ||
+                MatchExpression::LT == conclusion->matchType();
+            return premiseStrict || !conclusionStrict;
+        }
+
+        bool leafImplies(const MatchExpression* premise, const MatchExpression* conclusion) {
+            if (premise->path() != conclusion->path())
+                return false;
+
+            if (premise->equivalent(conclusion))
+                return true;
+
+            if (MatchExpression::EQ == premise->matchType()) {
+                const BSONElement& value =
+                    static_cast<const ComparisonMatchExpression*>(premise)->getData();
+                // null matches missing fields, and arrays match as elements as well as wholes
+                if (value.type() == jstNULL || value.type() == Undefined || value.type() == Array)
+                    return false;
+                if (MatchExpression::TYPE_OPERATOR == conclusion->matchType()) {
+                    return static_cast<const TypeMatchExpression*>(conclusion)
+                        ->matchesSingleElement(value);
+                }
+                if (!isLeafMatch(conclusion->matchType()))
+                    return false;
+                return static_cast<const LeafMatchExpression*>(conclusion)
+                    ->matchesSingleElement(value);
+            }
+
+            if (isComparison(premise->matchType()) && isComparison(conclusion->matchType())) {
+                return rangeImplies(static_cast<const ComparisonMatchExpression*>(premise),
+                                    static_cast<const ComparisonMatchExpression*>(conclusion));
+            }
+
+            return false;
+        }
+
+    }  // namespace
+
+    bool expressionImplies(const MatchExpression* premise, const MatchExpression* conclusion) {
+        if (MatchExpression::AND == conclusion->matchType()) {
+            for (size_t i = 0; i < conclusion->numChildren(); ++i) {
+                if (!expressionImplies(premise, conclusion->getChild(i)))
+                    return false;
+            }
+            return true;
+        }
+
+        if (MatchExpression::AND == premise->matchType()) {
+            for (size_t i = 0; i < premise->numChildren(); ++i) {
+                if (expressionImplies(premise->getChild(i), conclusion))
+                    return true;
+            }
+            return false;
+        }
+
+        if (MatchExpression::OR == premise->matchType()) {
+            if (0 == premise->numChildren())
+                return false;
+            for (size_t i = 0; i < premise->numChildren(); ++i) {
+                if (!expressionImplies(premise->getChild(i), conclusion))
+                    return false;
+            }
+            return true;
+        }
+
+        if (!premise->isLeaf() || !conclusion->isLeaf())
+            return false;
+
+        return leafImplies(premise, conclusion);
+    }
+
+}  // namespace mongo
@@ -0,0 +1,51 @@
+// expression_implication.h
+
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include "mongo/db/matcher/expression.h"
+
+namespace mongo {
+
+    /**
+     * @return true if every document matching 'premise' is known to match 'conclusion'.  Only the
+     * simple cases are recognised, so false means "not known" rather than "doesn't":
+     *
+     *  - a conjunction in 'conclusion' is implied clause by clause, a conjunction in 'premise' when
+     *    any one clause implies, and a disjunction in 'premise' when every clause does;
+     *  - a predicate implies an equivalent predicate on the same path;
+     *  - an equality implies any predicate on its path its value satisfies, except that equality
+     *    to null (which matches missing fields) only implies equivalent predicates;
+     *  - a range implies a looser range in the same direction over values of the same type.
+     */
+    bool expressionImplies(const MatchExpression* premise, const MatchExpression* conclusion);
+
+}  // namespace mongo
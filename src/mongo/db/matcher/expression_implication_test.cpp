@@ -0,0 +1,96 @@
+// expression_implication_test.cpp
+
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/unittest/unittest.h"
+
+#include "mongo/db/matcher/expression_implication.h"
+
+#include <boost/scoped_ptr.hpp>
+
+#include "mongo/db/json.h"
+#include "mongo/db/matcher/expression_parser.h"
+
+namespace mongo {
+
+    namespace {
+        bool implies( const char* premise, const char* conclusion ) {
+            BSONObj p = fromjson( premise );
+            BSONObj c = fromjson( conclusion );
+            StatusWithMatchExpression ps = MatchExpressionParser::parse( p );
+            StatusWithMatchExpression cs = MatchExpressionParser::parse( c );
+            ASSERT_TRUE( ps.isOK() );
+            ASSERT_TRUE( cs.isOK() );
+            boost::scoped_ptr<MatchExpression> pe( ps.getValue() );
+            boost::scoped_ptr<MatchExpression> ce( cs.getValue() );
+            return expressionImplies( pe.get(), ce.get() );
+        }
+    }
+
+    TEST( ExpressionImplicationTest, Equality ) {
+        ASSERT( implies( "{status: 'open'}", "{status: 'open'}" ) );
+        ASSERT( implies( "{status: 'open', n: 3}", "{status: 'open'}" ) );
+        ASSERT( !implies( "{status: 'closed'}", "{status: 'open'}" ) );
+        ASSERT( !implies( "{other: 'open'}", "{status: 'open'}" ) );
+        ASSERT( !implies( "{}", "{status: 'open'}" ) );
+        ASSERT( implies( "{n: 5}", "{n: {$gt: 3}}" ) );
+        ASSERT( implies( "{n: 5}", "{n: {$exists: true}}" ) );
+        ASSERT( implies( "{n: 5}", "{n: {$type: 16}}" ) );
+        ASSERT( !implies( "{n: 2}", "{n: {$gt: 3}}" ) );
+    }
+
+    TEST( ExpressionImplicationTest, NullAndArrays ) {
+        // {n: null} also matches documents without n
+        ASSERT( !implies( "{n: null}", "{n: {$exists: true}}" ) );
+        ASSERT( implies( "{n: null}", "{n: null}" ) );
+        ASSERT( !implies( "{n: [1, 2]}", "{n: {$exists: true}}" ) );
+    }
+
+    TEST( ExpressionImplicationTest, Ranges ) {
+        ASSERT( implies( "{n: {$gt: 5}}", "{n: {$gt: 3}}" ) );
+        ASSERT( implies( "{n: {$gt: 5}}", "{n: {$gte: 5}}" ) );
+        ASSERT( implies( "{n: {$gte: 5}}", "{n: {$gte: 5}}" ) );
+        ASSERT( !implies( "{n: {$gte: 5}}", "{n: {$gt: 5}}" ) );
+        ASSERT( implies( "{n: {$lt: 3}}", "{n: {$lte: 4}}" ) );
+        ASSERT( !implies( "{n: {$lt: 5}}", "{n: {$lt: 3}}" ) );
+        ASSERT( !implies( "{n: {$lt: 5}}", "{n: {$gt: 3}}" ) );
+        ASSERT( !implies( "{n: {$gt: 'a'}}", "{n: {$gt: 3}}" ) );
+        ASSERT( implies( "{n: {$gt: 5, $lt: 7}}", "{n: {$gt: 3}}" ) );
+    }
+
+    TEST( ExpressionImplicationTest, Logical ) {
+        ASSERT( implies( "{a: 1, b: 2}", "{a: 1, b: {$gt: 0}}" ) );
+        ASSERT( !implies( "{a: 1}", "{a: 1, b: 2}" ) );
+        ASSERT( implies( "{$or: [{a: 1}, {a: 2}]}", "{a: {$gte: 1}}" ) );
+        ASSERT( !implies( "{$or: [{a: 1}, {b: 2}]}", "{a: 1}" ) );
+        ASSERT( !implies( "{a: {$ne: 1}}", "{a: {$exists: true}}" ) );
+    }
+
+}  // namespace mongo
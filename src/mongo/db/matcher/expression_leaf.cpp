@@ -36,6 +36,7 @@
 #include "mongo/db/field_ref.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/path.h"
+#include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/log.h"
 
 namespace mongo {
@@ -186,6 +187,43 @@ namespace mongo {
         return options;
     }
 
+    namespace {
+
+        // Compiled regexes by flags and pattern.  A query's expression is cloned for every plan
+        // tried and queries of a shape repeat their regexes, so each is compiled once instead.
+        // A pcrecpp::RE doesn't change once compiled, so threads can share it.
+        typedef map<string, boost::shared_ptr<const pcrecpp::RE> > RegexCache;
+
+        const size_t MaxCachedRegexes = 1000;
+
+        SimpleMutex regexCacheMutex( "regexCache" );
+        RegexCache regexCache;
+
+        boost::shared_ptr<const pcrecpp::RE> compileRegex( const string& regex,
+                                                           const string& flags ) {
+            // Flags never contain a '/'.
+            string key = flags + '/' + regex;
+            {
+                SimpleMutex::scoped_lock lk( regexCacheMutex );
+                RegexCache::const_iterator it = regexCache.find( key );
+                if ( it != regexCache.end() )
+                    return it->second;
+            }
+
+            boost::shared_ptr<const pcrecpp::RE> re( new pcrecpp::RE( regex.c_str(),
+                                                                      flags2options( flags.c_str() ) ) );
+
+            SimpleMutex::scoped_lock lk( regexCacheMutex );
+            if ( regexCache.size() >= MaxCachedRegexes ) {
+                // Rather than track which are in use, start over; callers hold their own.
+                regexCache.clear();
+            }
+            regexCache[key] = re;
+            return re;
+        }
+
+    }
+
     bool RegexMatchExpression::equivalent( const MatchExpression* other ) const {
         if ( matchType() != other->matchType() )
             return false;
@@ -212,7 +250,7 @@ namespace mongo {
 
         _regex = regex.toString();
         _flags = options.toString();
-        _re.reset( new pcrecpp::RE( _regex.c_str(), flags2options( _flags.c_str() ) ) );
+        _re = compileRegex( _regex, _flags );
 
         return initPath( path );
     }
@@ -33,6 +33,7 @@
 #include <pcrecpp.h>
 
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include "mongo/bson/bsonobj.h"
 #include "mongo/bson/bsonmisc.h"
@@ -212,7 +213,9 @@ namespace mongo {
     private:
         std::string _regex;
         std::string _flags;
-        boost::scoped_ptr<pcrecpp::RE> _re;
+
+        // Shared with every expression using the same pattern and flags.
+        boost::shared_ptr<const pcrecpp::RE> _re;
     };
 
     class ModMatchExpression : public LeafMatchExpression {
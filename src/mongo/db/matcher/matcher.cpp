@@ -105,6 +105,7 @@ namespace mongo {
                  result.isOK() );
 
         _expression.reset( result.getValue() );
+        _compiled.reset( new CompiledMatchExpression( _expression.get() ) );
     }
 
     Matcher2::Matcher2( const Matcher2 &docMatcher, const BSONObj &constrainIndexKey )
@@ -123,7 +124,7 @@ namespace mongo {
             return true;
 
         if ( _indexKey.isEmpty() )
-            return _expression->matchesBSON( doc, details );
+            return _compiled->matchesBSON( doc, details );
 
         if ( !doc.isEmpty() && doc.firstElement().fieldName()[0] )
             return _expression->matchesBSON( doc, details );
@@ -36,6 +36,7 @@
 #include "mongo/base/status.h"
 #include "mongo/bson/bsonobj.h"
 #include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/expression_compiled.h"
 #include "mongo/db/matcher/match_details.h"
 
 namespace mongo {
@@ -93,6 +94,9 @@ namespace mongo {
 
         boost::scoped_ptr<MatchExpression> _expression;
 
+        // _expression prepared for whole documents; not set when matching index keys
+        boost::scoped_ptr<CompiledMatchExpression> _compiled;
+
         IndexSpliceInfo _spliceInfo;
 
         static MatchExpression* _spliceForIndex( const set<std::string>& keys,
@@ -87,10 +87,11 @@ namespace mongo {
     // ------
     BSONElementIterator::BSONElementIterator() {
         _path = NULL;
+        _hasResolved = false;
     }
 
     BSONElementIterator::BSONElementIterator( const ElementPath* path, const BSONObj& context )
-        : _path( path ), _context( context ) {
+        : _path( path ), _context( context ), _hasResolved( false ) {
         _state = BEGIN;
         //log() << "path: " << path.fieldRef().dottedField() << " context: " << context << endl;
     }
@@ -101,6 +102,22 @@ namespace mongo {
     void BSONElementIterator::reset( const ElementPath* path, const BSONObj& context ) {
         _path = path;
         _context = context;
+        _hasResolved = false;
+        _state = BEGIN;
+        _next.reset();
+
+        _subCursor.reset();
+        _subCursorPath.reset();
+    }
+
+    void BSONElementIterator::reset( const ElementPath* path,
+                                     BSONElement resolved,
+                                     size_t idxPath ) {
+        _path = path;
+        _context = BSONObj();
+        _hasResolved = true;
+        _resolved = resolved;
+        _resolvedIdxPath = idxPath;
         _state = BEGIN;
         _next.reset();
 
@@ -177,7 +194,14 @@ namespace mongo {
 
         if ( _state == BEGIN ) {
             size_t idxPath = 0;
-            BSONElement e = getFieldDottedOrArray( _context, _path->fieldRef(), &idxPath );
+            BSONElement e;
+            if ( _hasResolved ) {
+                e = _resolved;
+                idxPath = _resolvedIdxPath;
+            }
+            else {
+                e = getFieldDottedOrArray( _context, _path->fieldRef(), &idxPath );
+            }
 
             if ( e.type() != Array ) {
                 _next.reset( e, BSONElement(), false );
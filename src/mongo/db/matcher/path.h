@@ -122,6 +122,12 @@ namespace mongo {
 
         void reset( const ElementPath* path, const BSONObj& context );
 
+        /**
+         * Like reset() for a context whose element for 'path' is already known: 'resolved' and
+         * 'idxPath' as getFieldDottedOrArray() would have returned them.
+         */
+        void reset( const ElementPath* path, BSONElement resolved, size_t idxPath );
+
         bool more();
         Context next();
 
@@ -129,6 +135,10 @@ namespace mongo {
         const ElementPath* _path;
         BSONObj _context;
 
+        bool _hasResolved;
+        BSONElement _resolved;
+        size_t _resolvedIdxPath;
+
         enum State { BEGIN, IN_ARRAY, DONE } _state;
         Context _next;
 
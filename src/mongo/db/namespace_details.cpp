@@ -146,11 +146,142 @@ namespace mongo {
             }
         }
         else {
+            _coalesceFollowing(dloc);
+
             int b = bucket(d->lengthWithHeaders());
             DiskLoc& list = _deletedList[b];
             DiskLoc oldHead = list;
             getDur().writingDiskLoc(list) = dloc;
             d->nextDeleted() = oldHead;
+
+            // the prev hint replaces the defensive marker above.
+            getDur().writingDiskLoc(d->prevDeleted()) = DiskLoc();
+            if ( !oldHead.isNull() )
+                getDur().writingDiskLoc(oldHead.drec()->prevDeleted()) = dloc;
+        }
+    }
+
+    /* walking a list to find a record whose prev hint is stale stops after this many links.  the
+       walk repairs the hints it passes, so this is only hit by long lists freed by older versions.
+    */
+    static const int MaxPrevDeletedWalk = 1000;
+
+    /* find the record before 'dloc' in deleted list 'b', setting *prev to it or to null if 'dloc'
+       is the head.
+       @return false if 'dloc' couldn't be found
+    */
+    bool NamespaceDetails::_findPrevDeleted(int b, const DiskLoc& dloc, DiskLoc* prev) {
+        // _unlinkDeletedRec marks what it unlinks, so an orphaned record isn't searched for.
+        if ( !dloc.drec()->nextDeleted().isValid() )
+            return false;
+
+        DiskLoc hint = dloc.drec()->prevDeleted();
+        if ( hint.isNull() ) {
+            if ( _deletedList[b] == dloc ) {
+                *prev = DiskLoc();
+                return true;
+            }
+        }
+        else if ( hint.a() >= 0 &&
+                  static_cast<size_t>(hint.a()) < cc().database()->getExtentManager().numFiles() &&
+                  hint.getOfs() >= DataFileHeader::HeaderSize &&
+                  static_cast<unsigned long long>(hint.getOfs()) + Record::HeaderSize <=
+                      cc().database()->getExtentManager().getFile(hint.a())->length() &&
+                  hint.drec()->nextDeleted() == dloc ) {
+            *prev = hint;
+            return true;
+        }
+
+        // the hint is stale: the record was freed by an older version, which leaves the 0xeeeeeeee
+        // marker in its place.
+        DiskLoc p;
+        DiskLoc cur = _deletedList[b];
+        for ( int chain = 0; !cur.isNull() && chain < MaxPrevDeletedWalk; ++chain ) {
+            DeletedRecord* r = cur.drec();
+            if ( r->prevDeleted() != p )
+                getDur().writingDiskLoc(r->prevDeleted()) = p;
+            if ( cur == dloc ) {
+                *prev = p;
+                return true;
+            }
+            p = cur;
+            cur = r->nextDeleted();
+        }
+        return false;
+    }
+
+    /* remove 'dloc' from deleted list 'b', given the record before it (null if it's the head). */
+    void NamespaceDetails::_unlinkDeletedRec(int b, const DiskLoc& dloc, const DiskLoc& prev) {
+        DeletedRecord* d = dloc.drec();
+        DiskLoc next = d->nextDeleted();
+        if ( prev.isNull() )
+            getDur().writingDiskLoc(_deletedList[b]) = next;
+        else
+            getDur().writingDiskLoc(prev.drec()->nextDeleted()) = next;
+        if ( !next.isNull() )
+            getDur().writingDiskLoc(next.drec()->prevDeleted()) = prev;
+        d->nextDeleted().writing().setInvalid(); // defensive.
+    }
+
+    /* @return true if 'loc', which must lie within extent 'e', is in the extent's list of records.
+       a live record's neighbours in that list always point back at it; a deleted record's header
+       holds its nextDeleted link instead, which can't pass for that.
+    */
+    // static
+    bool NamespaceDetails::_isLiveRecord(Extent* e, const DiskLoc& loc) {
+        const int startOfRecords = e->myLoc.getOfs() + Extent::HeaderSize();
+        const int endOfExtent = e->myLoc.getOfs() + e->length;
+        Record* r = loc.rec();
+
+        int prevOfs = r->prevOfs();
+        if ( prevOfs == DiskLoc::NullOfs ) {
+            if ( e->firstRecord != loc )
+                return false;
+        }
+        else if ( prevOfs < startOfRecords || prevOfs + Record::HeaderSize > endOfExtent ||
+                  DiskLoc(loc.a(), prevOfs).rec()->nextOfs() != loc.getOfs() ) {
+            return false;
+        }
+
+        int nextOfs = r->nextOfs();
+        if ( nextOfs == DiskLoc::NullOfs ) {
+            if ( e->lastRecord != loc )
+                return false;
+        }
+        else if ( nextOfs < startOfRecords || nextOfs + Record::HeaderSize > endOfExtent ||
+                  DiskLoc(loc.a(), nextOfs).rec()->prevOfs() != loc.getOfs() ) {
+            return false;
+        }
+
+        return true;
+    }
+
+    void NamespaceDetails::_coalesceFollowing(const DiskLoc& dloc) {
+        DeletedRecord* d = dloc.drec();
+        Extent* e = d->myExtent(dloc);
+        const int endOfExtent = e->myLoc.getOfs() + e->length;
+        const int minLength = Record::HeaderSize + sizeof(DiskLoc);
+
+        while ( 1 ) {
+            DiskLoc nextLoc = dloc;
+            nextLoc.inc(d->lengthWithHeaders());
+            if ( nextLoc.getOfs() + minLength > endOfExtent )
+                return;
+
+            // the space between live records is tiled by deleted records, so anything here that
+            // isn't live is in our deleted lists.  check that it is before taking it, though.
+            Record* next = nextLoc.rec();
+            int nextLen = next->lengthWithHeaders();
+            if ( nextLen < minLength || nextLoc.getOfs() + nextLen > endOfExtent ||
+                 next->extentOfs() != d->extentOfs() || _isLiveRecord(e, nextLoc) )
+                return;
+
+            int b = bucket(nextLen);
+            DiskLoc prev;
+            if ( !_findPrevDeleted(b, nextLoc, &prev) )
+                return;
+            _unlinkDeletedRec(b, nextLoc, prev);
+            getDur().writingInt(d->lengthWithHeaders()) += nextLen;
         }
     }
 
@@ -212,6 +343,11 @@ namespace mongo {
         DeletedRecord *r = loc.drec();
         //r = getDur().writing(r);
 
+        if ( ! isCapped() ) {
+            // pick up any free space freed after this record was, before deciding how much to use.
+            _coalesceFollowing(loc);
+        }
+
         /* note we want to grab from the front so our next pointers on disk tend
         to go in a forward direction which is important for performance. */
         int regionlen = r->lengthWithHeaders();
@@ -263,15 +399,22 @@ namespace mongo {
        returned item is out of the deleted list upon return
     */
     DiskLoc NamespaceDetails::__stdAlloc(int len, bool peekOnly) {
-        DiskLoc *prev;
-        DiskLoc *bestprev = 0;
+        DiskLoc prev; // the record before cur in its list, null if cur is the head
+        DiskLoc bestprev;
         DiskLoc bestmatch;
         int bestmatchlen = 0x7fffffff;
         int b = bucket(len);
+        int bestb = b;
         DiskLoc cur = _deletedList[b];
-        prev = &_deletedList[b];
         int extra = 5; // look for a better fit, a little.
         int chain = 0;
+
+        // if we stop searching the first bucket for being too long, where to pick it back up.
+        const int firstBucket = b;
+        DiskLoc resumeAt;
+        DiskLoc resumePrev;
+        bool searchedLarger = false;
+
         while ( 1 ) {
             { // defensive check
                 int fileNumber = cur.a();
@@ -292,11 +435,20 @@ namespace mongo {
                     break;
                 b++;
                 if ( b > MaxBucket ) {
-                    // out of space. alloc a new extent.
-                    return DiskLoc();
+                    if ( resumeAt.isNull() || searchedLarger ) {
+                        // out of space. alloc a new extent.
+                        return DiskLoc();
+                    }
+                    // nothing larger is free, so rather than grow the file finish searching the
+                    // bucket we gave up on.
+                    searchedLarger = true;
+                    b = firstBucket;
+                    cur = resumeAt;
+                    prev = resumePrev;
+                    continue;
                 }
                 cur = _deletedList[b];
-                prev = &_deletedList[b];
+                prev = DiskLoc();
                 continue;
             }
             DeletedRecord *r = cur.drec();
@@ -305,16 +457,20 @@ namespace mongo {
                 bestmatchlen = r->lengthWithHeaders();
                 bestmatch = cur;
                 bestprev = prev;
+                bestb = b;
                 if (r->lengthWithHeaders() == len)
                     // exact match, stop searching
                     break;
             }
             if ( bestmatchlen < 0x7fffffff && --extra <= 0 )
                 break;
-            if ( ++chain > 30 && b < MaxBucket ) {
+            if ( !searchedLarger && ++chain > 30 && b < MaxBucket ) {
                 // too slow, force move to next bucket to grab a big chunk
-                //b++;
                 chain = 0;
+                if ( b == firstBucket ) {
+                    resumeAt = r->nextDeleted();
+                    resumePrev = cur;
+                }
                 cur.Null();
             }
             else {
@@ -324,17 +480,15 @@ namespace mongo {
                     " b:" << b << " chain:" << chain << ", fixing.\n";
                     r->nextDeleted.Null();
                 }*/
+                prev = cur;
                 cur = r->nextDeleted();
-                prev = &r->nextDeleted();
             }
         }
 
         /* unlink ourself from the deleted list */
         if( !peekOnly ) {
-            DeletedRecord *bmr = bestmatch.drec();
-            *getDur().writing(bestprev) = bmr->nextDeleted();
-            bmr->nextDeleted().writing().setInvalid(); // defensive.
-            verify(bmr->extentOfs() < bestmatch.getOfs());
+            _unlinkDeletedRec(bestb, bestmatch, bestprev);
+            verify(bestmatch.drec()->extentOfs() < bestmatch.getOfs());
         }
 
         return bestmatch;
@@ -772,6 +926,41 @@ namespace mongo {
         }
     }
 
+    bool NamespaceDetails::orphanDeletedRecord( const DiskLoc& dloc ) {
+        verify( !isCapped() );
+        int b = bucket(dloc.drec()->lengthWithHeaders());
+        DiskLoc prev;
+        if ( !_findPrevDeleted(b, dloc, &prev) )
+            return false;
+        _unlinkDeletedRec(b, dloc, prev);
+        return true;
+    }
+
+    int NamespaceDetails::orphanDeletedRecordsInExtent( const DiskLoc& extentLoc ) {
+        verify( !isCapped() );
+        Extent *e = extentLoc.ext();
+        const int endOfExtent = extentLoc.getOfs() + e->length;
+        const int minLength = Record::HeaderSize + sizeof(DiskLoc);
+
+        /* the extent is tiled by its live and deleted records, so walk it in physical order.
+           stop if that doesn't hold up, rather than wander off on a bad length.
+        */
+        int n = 0;
+        DiskLoc loc = extentLoc;
+        loc.inc( Extent::HeaderSize() );
+        while ( loc.getOfs() + minLength <= endOfExtent ) {
+            Record *r = loc.rec();
+            int len = r->lengthWithHeaders();
+            if ( len < minLength || loc.getOfs() + len > endOfExtent ||
+                 r->extentOfs() != extentLoc.getOfs() )
+                break;
+            if ( !_isLiveRecord(e, loc) && orphanDeletedRecord(loc) )
+                n++;
+            loc.inc( len );
+        }
+        return n;
+    }
+
     /* ------------------------------------------------------------------------- */
 
     bool legalClientSystemNS( const StringData& ns , bool write ) {
@@ -215,6 +215,21 @@ namespace mongo {
 
         void orphanDeletedList();
 
+        /**
+         * Takes the deleted record at 'dloc' off its deleted list without reusing it, leaving it
+         * orphaned in its extent.  Background compaction does this to the space it frees in an
+         * extent it is emptying, so nothing it moves lands there again.
+         * @return false if 'dloc' wasn't on a deleted list
+         */
+        bool orphanDeletedRecord( const DiskLoc& dloc );
+
+        /**
+         * Orphans every deleted record in extent 'extentLoc' (see orphanDeletedRecord).  The
+         * collection must not be capped.
+         * @return the number of records orphaned
+         */
+        int orphanDeletedRecordsInExtent( const DiskLoc& extentLoc );
+
         /**
          * @param max in and out, will be adjusted
          * @return if the value is valid at all
@@ -254,7 +269,10 @@ namespace mongo {
         };
 
         enum UserFlags {
-            Flag_UsePowerOf2Sizes = 1 << 0
+            Flag_UsePowerOf2Sizes = 1 << 0,
+            Flag_CompressRecords = 1 << 1, // store documents snappy compressed where that's smaller
+            Flag_RecordChecksums = 1 << 2, // keep a checksum of each document after it
+            Flag_IdLookupCache = 1 << 3 // cache where documents are by _id for point lookups
         };
 
         IndexDetails& idx(int idxNo, bool missingExpected = false );
@@ -478,8 +496,26 @@ namespace mongo {
         DiskLoc _alloc(const StringData& ns, int len);
         void maybeComplain( const StringData& ns, int len ) const;
         DiskLoc __stdAlloc(int len, bool willBeAt);
+
+        /* non-capped deleted lists.  the on-disk lists are singly linked, with a prevDeleted()
+           hint in each record to unlink it without walking its list.
+        */
+        bool _findPrevDeleted(int b, const DiskLoc& dloc, DiskLoc* prev);
+        void _unlinkDeletedRec(int b, const DiskLoc& dloc, const DiskLoc& prev);
+
+        /* merge the free space that physically follows the unlinked deleted record at 'dloc' in
+           its extent into it, so that churn doesn't leave the extent in pieces too small to reuse.
+        */
+        void _coalesceFollowing(const DiskLoc& dloc);
+        static bool _isLiveRecord(Extent* e, const DiskLoc& loc);
         void compact(); // combine adjacent deleted records
 
+        /* after the oldest record of the cap extent has been freed, merge it into the free space
+           it borders when that is the extent's only other deleted record, which is the steady
+           state of a looped capped collection.  falls back to compact() otherwise.
+        */
+        void cappedMergeFreed();
+
         friend class NamespaceIndex;
         friend class IndexCatalog;
 
@@ -33,6 +33,7 @@
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/client.h"
 #include "mongo/db/clientcursor.h"   // XXX old sys
+#include "mongo/db/exec/count_scan.h"
 #include "mongo/db/query/new_find.h"
 #include "mongo/db/query_optimizer.h"   // XXX old sys
 #include "mongo/db/queryutil.h"   // XXX old sys
@@ -103,7 +104,8 @@ namespace mongo {
             }
 
             Runner* rawRunner;
-            if (!getRunner(cq, &rawRunner).isOK()) {
+            CountScan* countScan;
+            if (!getRunnerCount(cq, &rawRunner, &countScan).isOK()) {
                 uasserted(17221, "could not get runner " + query.toString());
                 return -2;
             }
@@ -119,6 +121,14 @@ namespace mongo {
             while (Runner::RUNNER_ADVANCED == (state = runner->getNext(NULL, NULL))) {
                 ++count;
             }
+
+            if (NULL != countScan) {
+                // The index keys were counted, skipped ones too.
+                count = std::max(0LL, countScan->getCount() - skip);
+                if (limit > 0) {
+                    count = std::min(count, limit);
+                }
+            }
             return count;
         }
         else {
@@ -208,6 +208,7 @@ namespace mongo {
 
             c->recoverFromYield();
             DiskLoc last;
+            const int batchBytesTarget = c->batchBytesTarget();
 
             // This metadata may be stale, but it's the state of chunking when the cursor was
             // created.
@@ -256,6 +257,13 @@ namespace mongo {
                         //out() << "  but it's a dup \n";
                     }
                     else {
+                        if ( batchBytesTarget && n > 0
+                                && b.len() + c->current().objsize() > batchBytesTarget ) {
+                            // current will be the first document of the next batch
+                            cc->incPos( n );
+                            break;
+                        }
+
                         last = c->currLoc();
                         n++;
 
@@ -34,10 +34,13 @@
 
 #include <cstring>  // for memcpy
 
+#include "third_party/murmurhash3/MurmurHash3.h"
+
 #include "mongo/bson/mutable/damage_vector.h"
 #include "mongo/bson/mutable/document.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/clientcursor.h"
+#include "mongo/db/dbhelpers.h"
 #include "mongo/db/index_set.h"
 #include "mongo/db/namespace_details.h"
 #include "mongo/db/ops/update_driver.h"
@@ -46,6 +49,7 @@
 #include "mongo/db/query_optimizer.h"
 #include "mongo/db/query_runner.h"
 #include "mongo/db/queryutil.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/record.h"
 #include "mongo/db/structure/collection.h"
 #include "mongo/db/repl/oplog.h"
@@ -53,8 +57,44 @@
 
 namespace mongo {
 
+    // Log updates made in place as the bytes they changed, when that is smaller than the $set
+    // form.  Only members that understand such ops (see applyDeltaUpdate) can sync from them.
+    MONGO_EXPORT_SERVER_PARAMETER(oplogDeltaUpdates, bool, false);
+
     namespace {
 
+        long long deltaHash( const BSONObj& obj ) {
+            uint64_t hash[2];
+            MurmurHash3_x64_128( obj.objdata(), obj.objsize(), 0, hash );
+            return static_cast<long long>( hash[0] );
+        }
+
+        /**
+         * The oplog form of 'damages', already applied to 'newObj', whose bytes hashed to
+         * 'preHash' before:
+         *   { $delta : { pre : <hash>, post : <hash>, d : [ <offset>, <bytes>, ... ] } }
+         */
+        BSONObj makeDeltaUpdate( long long preHash,
+                                 const BSONObj& newObj,
+                                 const mutablebson::DamageVector& damages ) {
+            BSONObjBuilder b;
+            BSONObjBuilder delta( b.subobjStart( "$delta" ) );
+            delta.append( "pre", preHash );
+            delta.append( "post", deltaHash( newObj ) );
+            BSONArrayBuilder d( delta.subarrayStart( "d" ) );
+            mutablebson::DamageVector::const_iterator where = damages.begin();
+            const mutablebson::DamageVector::const_iterator end = damages.end();
+            for( ; where != end; ++where ) {
+                d.append( static_cast<int>( where->targetOffset ) );
+                d.append( BSONBinData( newObj.objdata() + where->targetOffset,
+                                       where->size,
+                                       BinDataGeneral ) );
+            }
+            d.done();
+            delta.done();
+            return b.obj();
+        }
+
         // TODO: Make this a function on NamespaceString, or make it cleaner.
         inline void validateUpdate( const char* ns , const BSONObj& updateobj, const BSONObj& patternOrig ) {
             uassert( 10155 , "cannot update reserved $ collection", strchr(ns, '$') == 0 );
@@ -179,6 +219,10 @@ namespace mongo {
 
         mutablebson::Document doc;
         mutablebson::DamageVector damages;
+        BufBuilder inPlaceSource;
+
+        // The image of the first document updated that the request wants back, if any.
+        BSONObj returnDoc;
 
         // If we are going to be yielding, we will need a ClientCursor scoped to this loop. We
         // only loop as long as the underlying cursor is OK.
@@ -315,21 +359,33 @@ namespace mongo {
             // Found a matching document
             numMatched++;
 
+            // The record's bytes may be changed in place below, so take the old image now.
+            if ( request.getReturnDoc() == UpdateRequest::RETURN_OLD && returnDoc.isEmpty() )
+                returnDoc = oldObj.getOwned();
+
             // Ask the driver to apply the mods. It may be that the driver can apply those "in
             // place", that is, some values of the old document just get adjusted without any
             // change to the binary layout on the bson layer. It may be that a whole new
             // document is needed to accomodate the new bson layout of the resulting document.
-            doc.reset( oldObj, mutablebson::Document::kInPlaceEnabled );
+            //
+            // Counter-like updates, $inc's and $set's of numbers that are already there, the
+            // driver can work out straight from the old document, without the mutable one.
             BSONObj logObj;
+            const bool fastInPlace = !isCompressedRecord( record ) &&
+                driver->updateInPlace( oldObj, &damages, &inPlaceSource, &logObj );
+
+            if ( !fastInPlace ) {
+                doc.reset( oldObj, mutablebson::Document::kInPlaceEnabled );
 
-            // If there was a matched field, obtain it.
-            string matchedField;
-            if (matchDetails.hasElemMatchKey())
-                matchedField = matchDetails.elemMatchKey();
+                // If there was a matched field, obtain it.
+                string matchedField;
+                if (matchDetails.hasElemMatchKey())
+                    matchedField = matchDetails.elemMatchKey();
 
-            Status status = driver->update( matchedField, &doc, &logObj );
-            if ( !status.isOK() ) {
-                uasserted( 16837, status.reason() );
+                Status status = driver->update( matchedField, &doc, &logObj );
+                if ( !status.isOK() ) {
+                    uasserted( 16837, status.reason() );
+                }
             }
 
             // If the driver applied the mods in place, we can ask the mutable for what
@@ -345,19 +401,35 @@ namespace mongo {
             bool objectWasChanged = false;
             BSONObj newObj;
             const char* source = NULL;
-            bool inPlace = doc.getInPlaceUpdates(&damages, &source);
+            bool inPlace = true;
+            if ( fastInPlace )
+                source = inPlaceSource.buf();
+            else
+                inPlace = doc.getInPlaceUpdates(&damages, &source);
 
             // If something changed in the document, verify that no shard keys were altered.
             if ((!inPlace || !damages.empty()) && driver->modsAffectShardKeys())
                 uassertStatusOK( driver->checkShardKeysUnaltered (oldObj, doc ) );
 
+            // a compressed document's damages can't be applied to its record.
+            if ( inPlace && isCompressedRecord( record ) )
+                inPlace = false;
+
             if ( inPlace && !driver->modsAffectIndices() ) {
                 // If a set of modifiers were all no-ops, we are still 'in place', but there is
                 // no work to do, in which case we want to consider the object unchanged.
                 if (!damages.empty() ) {
                     collection->details()->paddingFits();
 
+                    const bool logDelta = oplogDeltaUpdates &&
+                        request.shouldUpdateOpLog() &&
+                        !driver->isDocReplacement() &&
+                        !logObj.isEmpty() &&
+                        !nsString.isSystem();
+                    const long long preHash = logDelta ? deltaHash( oldObj ) : 0;
+
                     // All updates were in place. Apply them via durability and writing pointer.
+                    collection->documentRemoved( oldObj );
                     mutablebson::DamageVector::const_iterator where = damages.begin();
                     const mutablebson::DamageVector::const_iterator end = damages.end();
                     for( ; where != end; ++where ) {
@@ -367,8 +439,16 @@ namespace mongo {
                             where->size);
                         std::memcpy(targetPtr, sourcePtr, where->size);
                     }
+                    refreshRecordChecksum(record);
+                    collection->documentAdded( oldObj );
                     objectWasChanged = true;
                     opDebug->fastmod = true;
+
+                    if ( logDelta ) {
+                        BSONObj delta = makeDeltaUpdate( preHash, oldObj, damages );
+                        if ( delta.objsize() < logObj.objsize() )
+                            logObj = delta;
+                    }
                 }
                 newObj = oldObj;
             }
@@ -382,7 +462,10 @@ namespace mongo {
                                                              loc,
                                                              newObj.objdata(),
                                                              newObj.objsize(),
-                                                             *opDebug);
+                                                             *opDebug,
+                                                             false,
+                                                             !driver->modsAffectIndices() &&
+                                                             !driver->isDocReplacement());
 
                 // If we've moved this object to a new location, make sure we don't apply
                 // that update again if our traversal picks the objecta again.
@@ -410,6 +493,9 @@ namespace mongo {
             if (!objectWasChanged)
                 opDebug->nupdateNoops++;
 
+            if ( request.getReturnDoc() == UpdateRequest::RETURN_NEW && returnDoc.isEmpty() )
+                returnDoc = newObj.getOwned();
+
             if (!request.isMulti()) {
                 break;
             }
@@ -427,10 +513,12 @@ namespace mongo {
         // TODO: Can this be simplified?
         if ((numMatched > 0) || (numMatched == 0 && !request.isUpsert()) ) {
             opDebug->nupdated = numMatched;
-            return UpdateResult( numMatched > 0 /* updated existing object(s) */,
+            UpdateResult result( numMatched > 0 /* updated existing object(s) */,
                                  !driver->isDocReplacement() /* $mod or obj replacement */,
                                  numMatched /* # of docments update, even no-ops */,
                                  BSONObj() );
+            result.doc = returnDoc;
+            return result;
         }
 
         //
@@ -487,10 +575,64 @@ namespace mongo {
         }
 
         opDebug->nupdated = 1;
-        return UpdateResult( false /* updated a non existing document */,
+        UpdateResult result( false /* updated a non existing document */,
                              !driver->isDocReplacement() /* $mod or obj replacement? */,
                              1 /* count of updated documents */,
                              newObj /* object that was upserted */ );
+        // There is no old image of an inserted document.
+        if ( request.getReturnDoc() == UpdateRequest::RETURN_NEW )
+            result.doc = newObj;
+        return result;
+    }
+
+    bool isDeltaUpdate( const BSONObj& updateobj ) {
+        return str::equals( updateobj.firstElementFieldName(), "$delta" );
+    }
+
+    bool applyDeltaUpdate( const char* ns,
+                           const BSONObj& query,
+                           const BSONObj& updateobj,
+                           OpDebug* opDebug ) {
+        Collection* collection = cc().database()->getCollection( ns );
+        if ( !collection )
+            return false;
+        NamespaceDetails* d = collection->details();
+        DiskLoc loc = ( query.nFields() == 1 && d->findIdIndex() >= 0 ) ?
+            Helpers::findById( d, query ) : Helpers::findOne( ns, query, false );
+        if ( loc.isNull() )
+            return false;
+
+        Record* record = loc.rec();
+        const BSONObj oldObj = BSONObj::make( record );
+        const BSONObj delta = updateobj.firstElement().Obj();
+        const long long hash = deltaHash( oldObj );
+        if ( hash == delta["post"].numberLong() )
+            return true; // replayed
+        if ( hash != delta["pre"].numberLong() ) {
+            // A later version of the document, on replay: later ops bring it up to date.
+            RARELY warning() << "skipping delta update whose document has changed since, ns: "
+                             << ns << " query: " << query << endl;
+            return true;
+        }
+
+        // Apply the bytes to a copy, and write it as any other update, which keeps the indexes
+        // and compressed records of this member right.
+        BufBuilder copy( oldObj.objsize() );
+        copy.appendBuf( oldObj.objdata(), oldObj.objsize() );
+        BSONObjIterator i( delta["d"].Obj() );
+        while ( i.more() ) {
+            const int offset = i.next().numberInt();
+            uassert( 17368, "bad delta update", i.more() );
+            int len;
+            const char* bytes = i.next().binData( len );
+            uassert( 17369, "delta update past the end of the document",
+                     offset >= 0 && len >= 0 && offset + len <= oldObj.objsize() );
+            memcpy( copy.buf() + offset, bytes, len );
+        }
+        const BSONObj newObj( copy.buf() );
+        theDataFileMgr.updateRecord( ns, collection, record, loc,
+                                     newObj.objdata(), newObj.objsize(), *opDebug );
+        return true;
     }
 
     BSONObj applyUpdateOperators( const BSONObj& from, const BSONObj& operators ) {
@@ -52,4 +52,19 @@ namespace mongo {
      *   returns: { x : 2 }
      */
     BSONObj applyUpdateOperators( const BSONObj& from, const BSONObj& operators );
+
+    /** @return true if 'updateobj' is a delta update, logged with oplogDeltaUpdates set */
+    bool isDeltaUpdate( const BSONObj& updateobj );
+
+    /**
+     * Applies a delta update, the bytes an in-place update changed, to the document of 'ns'
+     * matching 'query'.  A document no longer in the state the delta was made from, as on
+     * replay, is left for later ops to bring up to date.  Must hold the write lock, in a
+     * context for 'ns'.
+     * @return false if no document matches
+     */
+    bool applyDeltaUpdate( const char* ns,
+                           const BSONObj& query,
+                           const BSONObj& updateobj,
+                           OpDebug* opDebug );
 }  // namespace mongo
@@ -32,17 +32,41 @@
 #include "mongo/base/string_data.h"
 #include "mongo/bson/mutable/document.h"
 #include "mongo/db/field_ref.h"
+#include "mongo/db/ops/field_checker.h"
 #include "mongo/db/ops/log_builder.h"
 #include "mongo/db/ops/modifier_object_replace.h"
 #include "mongo/db/ops/modifier_table.h"
 #include "mongo/db/ops/path_support.h"
 #include "mongo/util/embedded_builder.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/safe_num.h"
 
 namespace mongo {
 
     namespace str = mongoutils::str;
 
+    namespace {
+
+        // Can updateInPlace() apply this mod? Values of these types take fixed room, so one
+        // can replace another of the same type without moving anything around it.
+        bool isInPlaceMod(modifiertable::ModifierType modType, const BSONElement& modExpr) {
+            if (modType == modifiertable::MOD_INC)
+                return true;
+            if (modType != modifiertable::MOD_SET)
+                return false;
+            switch (modExpr.type()) {
+            case NumberInt:
+            case NumberLong:
+            case NumberDouble:
+            case Bool:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+    } // namespace
+
     UpdateDriver::UpdateDriver(const Options& opts)
         : _multi(opts.multi)
         , _upsert(opts.upsert)
@@ -85,6 +109,8 @@ namespace mongo {
 
         // The update expression is made of mod operators, that is
         // { <$mod>: {...}, <$mod>: {...}, ...  }
+        FieldRefSet inPlacePaths;
+        bool inPlace = true;
         BSONObjIterator outerIter(updateExpr);
         while (outerIter.more()) {
             BSONElement outerModElem = outerIter.next();
@@ -134,9 +160,32 @@ namespace mongo {
                 }
 
                 _mods.push_back(mod.release());
+
+                // Keep what updateInPlace() needs while all the mods so far can be applied
+                // there. Conflicting paths are left to update() to report.
+                if (inPlace) {
+                    inPlace = false;
+                    if (isInPlaceMod(modType, innerModElem)) {
+                        auto_ptr<InPlaceMod> inPlaceMod(new InPlaceMod);
+                        inPlaceMod->isInc = (modType == modifiertable::MOD_INC);
+                        inPlaceMod->path.parse(innerModElem.fieldNameStringData());
+                        inPlaceMod->value = innerModElem;
+
+                        size_t pos;
+                        const FieldRef* other;
+                        if (!fieldchecker::isPositional(inPlaceMod->path, &pos) &&
+                            inPlacePaths.insert(&inPlaceMod->path, &other)) {
+                            _inPlaceMods.mutableVector().push_back(inPlaceMod.release());
+                            inPlace = true;
+                        }
+                    }
+                }
             }
         }
 
+        if (!inPlace)
+            _inPlaceMods.clear();
+
         // Register the fact that there will be only $mod's in this driver -- no object
         // replacement.
         _replacementMode = false;
@@ -296,6 +345,102 @@ namespace mongo {
         return Status::OK();
     }
 
+    bool UpdateDriver::updateInPlace(const BSONObj& original,
+                                     mutablebson::DamageVector* damages,
+                                     BufBuilder* source,
+                                     BSONObj* logOpRec) {
+        if (_inPlaceMods.empty())
+            return false;
+
+        damages->clear();
+        source->reset();
+        BSONObjBuilder values(*source);
+
+        BSONObjBuilder logBuilder;
+        BSONObjBuilder setBuilder(logBuilder.subobjStart("$set"));
+
+        for (vector<InPlaceMod*>::const_iterator it = _inPlaceMods.begin();
+             it != _inPlaceMods.end();
+             ++it) {
+            const InPlaceMod& mod = **it;
+
+            // The field must already be there, under embedded objects only.
+            BSONObj parent = original;
+            BSONElement elem;
+            for (size_t i = 0; i < mod.path.numParts(); ++i) {
+                if (i > 0) {
+                    if (elem.type() != Object)
+                        return false;
+                    parent = elem.embeddedObject();
+                }
+                elem = parent.getField(mod.path.getPart(i));
+                if (elem.eoo())
+                    return false;
+            }
+
+            // Work out the new value as ModifierInc and ModifierSet would, including
+            // whether they would see a no-op.
+            SafeNum newValue;
+            bool noOp;
+            if (mod.isInc) {
+                if (!elem.isNumber())
+                    return false;
+                SafeNum currentValue(elem);
+                newValue = currentValue + SafeNum(mod.value);
+                if (!newValue.isValid() || newValue.type() != elem.type())
+                    return false;
+                noOp = newValue.isIdentical(currentValue);
+            }
+            else {
+                noOp = elem.woCompare(mod.value, false) == 0;
+                if (!noOp && elem.type() != mod.value.type())
+                    return false;
+            }
+
+            if (!noOp) {
+                const StringData dottedField = mod.path.dottedField();
+                if (_indexedFields.mightBeIndexed(dottedField))
+                    return false;
+
+                if (_shardKeyState) {
+                    FieldRefSet conflicts;
+                    _shardKeyState->keySet.getConflicts(&mod.path, &conflicts);
+                    if (!conflicts.empty())
+                        return false;
+                }
+
+                // The value goes after a type byte and an empty field name.
+                mutablebson::DamageEvent damage;
+                damage.sourceOffset = source->len() + 2;
+                damage.targetOffset = elem.value() - original.objdata();
+                damage.size = elem.valuesize();
+                if (mod.isInc)
+                    newValue.toBSON(StringData(), &values);
+                else
+                    values.appendAs(mod.value, StringData());
+                damages->push_back(damage);
+            }
+
+            if (mod.isInc)
+                newValue.toBSON(mod.path.dottedField(), &setBuilder);
+            else
+                setBuilder.appendAs(mod.value, mod.path.dottedField());
+        }
+
+        values.done();
+        setBuilder.done();
+
+        // Nothing the mods touch can be indexed or part of the shard key.
+        _affectIndices = false;
+        if (_shardKeyState)
+            _shardKeyState->affectedKeySet.clear();
+
+        if (_logOp && logOpRec)
+            *logOpRec = logBuilder.obj();
+
+        return true;
+    }
+
     size_t UpdateDriver::numMods() const {
         return _mods.size();
     }
@@ -521,6 +666,7 @@ namespace mongo {
         for (vector<ModifierInterface*>::iterator it = _mods.begin(); it != _mods.end(); ++it) {
             delete *it;
         }
+        _inPlaceMods.clear();
         _indexedFields.clear();
         _replacementMode = false;
         _shardKeyState.reset();
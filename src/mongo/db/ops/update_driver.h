@@ -88,6 +88,22 @@ namespace mongo {
                       mutablebson::Document* doc,
                       BSONObj* logOpRec);
 
+        /**
+         * Returns true and fills in 'damages' and 'source' with the changes to make to
+         * 'original' if the mods can be applied to it without building a mutable document.
+         * That is the case when every mod is a non-positional $inc or $set of a number or a
+         * bool, over a field that 'original' reaches through embedded objects only, that
+         * keeps its type and is neither indexed nor part of the shard key. The damages are
+         * as Document::getInPlaceUpdates would report them, and 'logOpRec' is filled in as
+         * by update().
+         *
+         * Otherwise returns false, and 'update' should be used instead.
+         */
+        bool updateInPlace(const BSONObj& original,
+                           mutablebson::DamageVector* damages,
+                           BufBuilder* source,
+                           BSONObj* logOpRec);
+
         //
         // Accessors
         //
@@ -153,6 +169,15 @@ namespace mongo {
         // Collection of update mod instances. Owned here.
         vector<ModifierInterface*> _mods;
 
+        // One per mod in '_mods', if updateInPlace() may be able to apply them. The values
+        // point into the update expression, as the mods' own do.
+        struct InPlaceMod {
+            bool isInc;
+            FieldRef path;
+            BSONElement value;
+        };
+        OwnedPointerVector<InPlaceMod> _inPlaceMods;
+
         // What are the list of fields in the collection over which the update is going to be
         // applied that participate in indices?
         //
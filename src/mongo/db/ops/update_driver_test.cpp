@@ -28,6 +28,8 @@
 
 #include "mongo/db/ops/update_driver.h"
 
+#include <cstring>
+
 #include "mongo/db/field_ref_set.h"
 #include "mongo/db/index_set.h"
 #include "mongo/db/json.h"
@@ -36,10 +38,12 @@
 namespace {
 
     using mongo::BSONObj;
+    using mongo::BufBuilder;
     using mongo::FieldRef;
     using mongo::FieldRefSet;
     using mongo::fromjson;
     using mongo::IndexPathSet;
+    using mongo::mutablebson::DamageVector;
     using mongo::mutablebson::Document;
     using mongo::StringData;
     using mongo::UpdateDriver;
@@ -291,4 +295,71 @@ namespace {
         ASSERT_OK(_driver->checkShardKeysUnaltered(*_obj, *_doc));
     }
 
+    // Applies 'mod' to 'original' through updateInPlace(), if the driver takes it, and
+    // checks the document and the oplog entry against what update() makes.
+    bool checkUpdateInPlace(const char* original, const char* mod,
+                            const char* indexed = NULL) {
+        UpdateDriver::Options opts;
+        opts.logOp = true;
+        UpdateDriver driver(opts);
+        ASSERT_OK(driver.parse(fromjson(mod)));
+        if (indexed) {
+            IndexPathSet indexedFields;
+            indexedFields.addPath(indexed);
+            driver.refreshIndexKeys(indexedFields);
+        }
+
+        const BSONObj obj = fromjson(original);
+        DamageVector damages;
+        BufBuilder source;
+        BSONObj inPlaceLog;
+        if (!driver.updateInPlace(obj, &damages, &source, &inPlaceLog))
+            return false;
+
+        BSONObj updated = obj.copy();
+        char* data = const_cast<char*>(updated.objdata());
+        for (DamageVector::const_iterator it = damages.begin(); it != damages.end(); ++it)
+            std::memcpy(data + it->targetOffset, source.buf() + it->sourceOffset, it->size);
+
+        Document doc(obj);
+        BSONObj log;
+        ASSERT_OK(driver.update(StringData(), &doc, &log));
+        ASSERT_EQUALS(doc.getObject(), updated);
+        ASSERT_EQUALS(log, inPlaceLog);
+        ASSERT_FALSE(driver.modsAffectIndices());
+        return true;
+    }
+
+    TEST(UpdateInPlace, Counters) {
+        ASSERT_TRUE(checkUpdateInPlace("{a: 1, b: 2}", "{$inc: {a: 1}}"));
+        ASSERT_TRUE(checkUpdateInPlace("{a: {b: {c: 1.5}}}", "{$inc: {'a.b.c': -0.5}}"));
+        ASSERT_TRUE(checkUpdateInPlace("{a: NumberLong(5), b: 1.0, c: 0}",
+                                       "{$inc: {a: 1, b: 2}, $set: {c: 1}}"));
+        ASSERT_TRUE(checkUpdateInPlace("{a: true, b: {c: 3}}", "{$set: {a: false, 'b.c': 4}}"));
+    }
+
+    TEST(UpdateInPlace, NoOps) {
+        ASSERT_TRUE(checkUpdateInPlace("{a: 1}", "{$inc: {a: 0}}"));
+        ASSERT_TRUE(checkUpdateInPlace("{a: 1}", "{$set: {a: 1.0}}"));
+        ASSERT_TRUE(checkUpdateInPlace("{a: 1, b: 2}", "{$set: {a: 1, b: 3}}"));
+    }
+
+    TEST(UpdateInPlace, NotInPlace) {
+        // Missing fields and fields under arrays.
+        ASSERT_FALSE(checkUpdateInPlace("{a: 1}", "{$inc: {b: 1}}"));
+        ASSERT_FALSE(checkUpdateInPlace("{a: [1]}", "{$inc: {'a.0': 1}}"));
+        ASSERT_FALSE(checkUpdateInPlace("{a: [1]}", "{$inc: {'a.$': 1}}"));
+
+        // New types: an overflowing int, a double into an int, a bool over a number.
+        ASSERT_FALSE(checkUpdateInPlace("{a: 2147483647}", "{$inc: {a: 1}}"));
+        ASSERT_FALSE(checkUpdateInPlace("{a: 1}", "{$inc: {a: 0.5}}"));
+        ASSERT_FALSE(checkUpdateInPlace("{a: 1}", "{$set: {a: true}}"));
+
+        // Other mods and values, indexed fields, conflicting paths.
+        ASSERT_FALSE(checkUpdateInPlace("{a: 1}", "{$set: {a: 'x'}}"));
+        ASSERT_FALSE(checkUpdateInPlace("{a: 1, b: 1}", "{$inc: {a: 1}, $unset: {b: 1}}"));
+        ASSERT_FALSE(checkUpdateInPlace("{a: {b: 1}}", "{$inc: {'a.b': 1}}", "a"));
+        ASSERT_FALSE(checkUpdateInPlace("{a: {b: 1}}", "{$inc: {'a.b': 1}, $set: {a: 1}}"));
+    }
+
 } // unnamed namespace
@@ -40,6 +40,17 @@ namespace mongo {
 
     class UpdateRequest {
     public:
+        enum ReturnDocOption {
+            // Don't keep a copy of the updated document.
+            RETURN_NONE,
+
+            // Keep the matched document as it was before the update.
+            RETURN_OLD,
+
+            // Keep the document as it is after the update, or as it was inserted.
+            RETURN_NEW
+        };
+
         inline UpdateRequest(
             const NamespaceString& nsString,
             const QueryPlanSelectionPolicy& policy = QueryPlanSelectionPolicy::any() )
@@ -50,7 +61,8 @@ namespace mongo {
             , _multi(false)
             , _updateOpLog(false)
             , _fromMigration(false)
-            , _fromReplication(false) {}
+            , _fromReplication(false)
+            , _returnDoc(RETURN_NONE) {}
 
         const NamespaceString& getNamespaceString() const {
             return _nsString;
@@ -127,6 +139,14 @@ namespace mongo {
             return _fromReplication;
         }
 
+        inline void setReturnDoc(ReturnDocOption value) {
+            _returnDoc = value;
+        }
+
+        ReturnDocOption getReturnDoc() const {
+            return _returnDoc;
+        }
+
         const std::string toString() const {
             return str::stream()
                         << " query: " << _query
@@ -136,7 +156,8 @@ namespace mongo {
                         << " multi: " << _multi
                         << " logToOplog: " << _updateOpLog
                         << " fromMigration: " << _fromMigration
-                        << " fromReplications: " << _fromReplication;
+                        << " fromReplications: " << _fromReplication
+                        << " returnDoc: " << _returnDoc;
         }
     private:
 
@@ -169,6 +190,10 @@ namespace mongo {
 
         // True if this update is being applied during the application for the oplog.
         bool _fromReplication;
+
+        // Which image, if any, of the (first) document updated is handed back in the
+        // UpdateResult, e.g. for findAndModify.
+        ReturnDocOption _returnDoc;
     };
 
 } // namespace mongo
@@ -67,6 +67,9 @@ namespace mongo {
         // if something was upserted, the new _id of the object
         BSONObj upserted;
 
+        // an owned copy of the document updated, if the request asked for one
+        BSONObj doc;
+
         const std::string toString() const {
             return str::stream()
                         << " upserted: " << upserted
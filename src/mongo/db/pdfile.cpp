@@ -73,9 +73,12 @@ _ disallow system* manipulations from the database.
 #include "mongo/db/repl/is_master.h"
 #include "mongo/db/sort_phase_one.h"
 #include "mongo/db/repl/oplog.h"
+#include "mongo/db/storage/in_memory_files.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/db/structure/collection.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/checksum.h"
+#include "mongo/util/compress.h"
 #include "mongo/util/file.h"
 #include "mongo/util/file_allocator.h"
 #include "mongo/util/hashtab.h"
@@ -83,6 +86,7 @@ _ disallow system* manipulations from the database.
 #include "mongo/util/processinfo.h"
 #include "mongo/db/stats/timer_stats.h"
 #include "mongo/db/stats/counters.h"
+#include "mongo/db/stats/top.h"
 
 namespace mongo {
 
@@ -189,6 +193,8 @@ namespace mongo {
             }
         } deleter;
         _applyOpToDataFiles( database, deleter, true );
+        boost::filesystem::remove( boost::filesystem::path( storageGlobalParams.dbpath ) /
+                                   ( string( database ) + ".heat" ) );
     }
 
     bool _userCreateNS(const char *ns, const BSONObj& options, string& err, bool *deferIdIndex) {
@@ -507,6 +513,8 @@ namespace mongo {
 
         collection->getIndexCatalog()->unindexRecord( obj, dl, noWarn );
 
+        collection->documentRemoved( obj );
+
         _deleteRecord(d, ns, todelete, dl);
 
         collection->infoCache()->notifyOfWriteOp();
@@ -524,6 +532,86 @@ namespace mongo {
         }
     }
 
+    bool compressRecordData( const BSONObj& obj, std::string* out ) {
+        std::string compressed;
+        compress( obj.objdata(), obj.objsize(), &compressed );
+        if ( compressed.size() + sizeof(int) >= static_cast<size_t>( obj.objsize() ) )
+            return false;
+
+        int marker = -static_cast<int>( compressed.size() );
+        out->assign( reinterpret_cast<const char*>( &marker ), sizeof(int) );
+        out->append( compressed );
+        return true;
+    }
+
+    BSONObj uncompressRecordData( const Record* r ) {
+        int len = -*reinterpret_cast<const int*>( r->data() );
+        massert( 17310, "corrupt compressed record",
+                 len > 0 && len + static_cast<int>( sizeof(int) ) <= r->netLength() );
+        std::string doc;
+        massert( 17311, "compressed record doesn't uncompress",
+                 uncompress( r->data() + sizeof(int), len, &doc ) );
+        return BSONObj( doc.data() ).getOwned();
+    }
+
+    namespace {
+        const int RecordChecksumMarker = 0x6b686352;
+
+        struct RecordChecksumTrailer {
+            int marker;
+            unsigned sum;
+        };
+        BOOST_STATIC_ASSERT( sizeof(RecordChecksumTrailer) == RecordChecksumSize );
+
+        unsigned recordChecksum( const Record* r ) {
+            Checksum c;
+            c.genUnaligned( r->data(), storedDataSize( r ) );
+            unsigned long long w = c.words[0] ^ c.words[1];
+            return static_cast<unsigned>( w ^ ( w >> 32 ) );
+        }
+
+        /** @return where the checksum of 'r' is or would go, or NULL if there's no room */
+        RecordChecksumTrailer* checksumTrailer( const Record* r ) {
+            int size = storedDataSize( r );
+            if ( size <= 0 || size > r->netLength() - RecordChecksumSize )
+                return NULL;
+            return reinterpret_cast<RecordChecksumTrailer*>( const_cast<char*>( r->data() ) + size );
+        }
+    }
+
+    int storedDataSize( const Record* r ) {
+        int n = *reinterpret_cast<const int*>( r->data() );
+        return n < 0 ? static_cast<int>( sizeof(int) ) - n : n;
+    }
+
+    void updateRecordChecksum( const NamespaceDetails* d, Record* r ) {
+        RecordChecksumTrailer* t = checksumTrailer( r );
+        if ( !t )
+            return;
+        if ( d->isUserFlagSet( NamespaceDetails::Flag_RecordChecksums ) ) {
+            RecordChecksumTrailer sum;
+            sum.marker = RecordChecksumMarker;
+            sum.sum = recordChecksum( r );
+            *getDur().writing( t ) = sum;
+        }
+        else if ( t->marker == RecordChecksumMarker ) {
+            getDur().writingInt( t->marker ) = 0;
+        }
+    }
+
+    void refreshRecordChecksum( Record* r ) {
+        RecordChecksumTrailer* t = checksumTrailer( r );
+        if ( t && t->marker == RecordChecksumMarker )
+            getDur().writing( t )->sum = recordChecksum( r );
+    }
+
+    RecordChecksumState checkRecordChecksum( const Record* r ) {
+        const RecordChecksumTrailer* t = checksumTrailer( r );
+        if ( !t || t->marker != RecordChecksumMarker )
+            return NoRecordChecksum;
+        return t->sum == recordChecksum( r ) ? RecordChecksumOk : RecordChecksumBad;
+    }
+
     Counter64 moveCounter;
     ServerStatusMetricField<Counter64> moveCounterDisplay( "record.moves", &moveCounter );
 
@@ -533,7 +621,7 @@ namespace mongo {
         const char *ns,
         Collection* collection,
         Record *toupdate, const DiskLoc& dl,
-        const char *_buf, int _len, OpDebug& debug,  bool god) {
+        const char *_buf, int _len, OpDebug& debug,  bool god, bool indexKeysUnchanged) {
 
         dassert( toupdate == dl.rec() );
 
@@ -567,9 +655,13 @@ namespace mongo {
         /* duplicate key check. we descend the btree twice - once for this check, and once for the actual inserts, further
            below.  that is suboptimal, but it's pretty complicated to do it the other way without rollbacks...
         */
+        // With no indexed path changed every ticket would be empty: skip computing the old and
+        // new keys of each index, which is most of the cost of a multi-update on a collection
+        // with several indexes.
         OwnedPointerVector<UpdateTicket> updateTickets;
-        updateTickets.mutableVector().resize(collection->details()->getTotalIndexCount());
-        for (int i = 0; i < collection->details()->getTotalIndexCount(); ++i) {
+        const int nIndexes = indexKeysUnchanged ? 0 : collection->details()->getTotalIndexCount();
+        updateTickets.mutableVector().resize(nIndexes);
+        for (int i = 0; i < nIndexes; ++i) {
             IndexDescriptor* descriptor = collection->getIndexCatalog()->getDescriptor( i );
             verify( descriptor );
             IndexAccessMethod* iam = collection->getIndexCatalog()->getIndex( descriptor );
@@ -589,7 +681,16 @@ namespace mongo {
             }
         }
 
-        if ( toupdate->netLength() < objNew.objsize() ) {
+        std::string compressed;
+        const char* stored = objNew.objdata();
+        int storedSize = objNew.objsize();
+        if ( collection->details()->isUserFlagSet( NamespaceDetails::Flag_CompressRecords ) &&
+             compressRecordData( objNew, &compressed ) ) {
+            stored = compressed.data();
+            storedSize = compressed.size();
+        }
+
+        if ( toupdate->netLength() < storedSize ) {
             // doesn't fit.  reallocate -----------------------------------------------------
             moveCounter.increment();
             uassert( 10003,
@@ -612,7 +713,7 @@ namespace mongo {
 
         debug.keyUpdates = 0;
 
-        for (int i = 0; i < collection->details()->getTotalIndexCount(); ++i) {
+        for (int i = 0; i < nIndexes; ++i) {
             IndexDescriptor* descriptor = collection->getIndexCatalog()->getDescriptor( i );
             verify( descriptor );
             IndexAccessMethod* iam = collection->getIndexCatalog()->getIndex( descriptor );
@@ -628,8 +729,10 @@ namespace mongo {
         }
 
         //  update in place
-        int sz = objNew.objsize();
-        memcpy(getDur().writingPtr(toupdate->data(), sz), objNew.objdata(), sz);
+        collection->documentRemoved( objOld ); // objOld may be the record itself
+        memcpy(getDur().writingPtr(toupdate->data(), storedSize), stored, storedSize);
+        updateRecordChecksum( collection->details(), toupdate );
+        collection->documentAdded( objNew );
         return dl;
     }
 
@@ -855,7 +958,20 @@ namespace mongo {
             BSONElementManipulator::lookForTimestamps( io );
         }
 
-        int lenWHdr = d->getRecordAllocationSize( len + Record::HeaderSize );
+        std::string compressed;
+        if( !god && obuf && d->isUserFlagSet( NamespaceDetails::Flag_CompressRecords ) ) {
+            BSONObj doc( static_cast<const char*>( obuf ) );
+            if( idToInsert.needed() ) {
+                BSONObjBuilder b;
+                b.append( "_id", idToInsert.oid );
+                b.appendElements( doc );
+                doc = b.obj();
+            }
+            if( compressRecordData( doc, &compressed ) )
+                len = compressed.size();
+        }
+
+        int lenWHdr = d->getRecordAllocationSize( len + recordChecksumRoom( d ) + Record::HeaderSize );
         fassert( 16440, lenWHdr >= ( len + Record::HeaderSize ) );
 
         // If the collection is capped, check if the new object will violate a unique index
@@ -879,7 +995,10 @@ namespace mongo {
         {
             verify( r->lengthWithHeaders() >= lenWHdr );
             r = (Record*) getDur().writingPtr(r, lenWHdr);
-            if( idToInsert.needed() ) {
+            if( !compressed.empty() ) {
+                memcpy(r->data(), compressed.data(), len);
+            }
+            else if( idToInsert.needed() ) {
                 /* a little effort was made here to avoid a double copy when we add an ID */
                 int originalSize = *((int*) obuf);
                 ((int&)*r->data()) = originalSize + idToInsert.size();
@@ -890,6 +1009,8 @@ namespace mongo {
                 if( obuf ) // obuf can be null from internal callers
                     memcpy(r->data(), obuf, len);
             }
+            if( !god && obuf )
+                updateRecordChecksum( d, r );
         }
 
         addRecordToRecListInExtent(r, loc);
@@ -903,7 +1024,7 @@ namespace mongo {
         /* add this record to our indexes */
         if ( d->getTotalIndexCount() > 0 ) {
             try {
-                BSONObj obj(r->data());
+                BSONObj obj = BSONObj::make(r);
                 collection->getIndexCatalog()->indexRecord(obj, loc);
             }
             catch( AssertionException& e ) {
@@ -925,6 +1046,12 @@ namespace mongo {
 
         d->paddingFits();
 
+        // god inserts aren't necessarily documents
+        if ( !god )
+            collection->documentAdded( BSONObj::make( r ) );
+        else
+            collection->invalidateContentHash();
+
         return loc;
     }
 
@@ -1021,6 +1148,7 @@ namespace mongo {
 
         Database::closeDatabase( d->name(), d->path() );
         d = 0; // d is now deleted
+        Top::global.databaseDropped( db );
 
         _deleteDataFiles( db.c_str() );
     }
@@ -1130,6 +1258,11 @@ namespace mongo {
         dbNameS = nsToDatabase( dbNameS );
         const char * dbName = dbNameS.c_str();
 
+        if ( isInMemoryDatabase( dbNameS ) ) {
+            errmsg = "in memory databases have no files to repair";
+            return false;
+        }
+
         stringstream ss;
         ss << "localhost:" << serverGlobalParams.port;
         string localhost = ss.str();
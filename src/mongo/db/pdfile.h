@@ -80,11 +80,14 @@ namespace mongo {
 
         /** @return DiskLoc where item ends up */
         // changedId should be initialized to false
+        // indexKeysUnchanged promises that no indexed path differs between the old and new
+        // objects, so a record that fits is rewritten without reading any index.
         const DiskLoc updateRecord(
             const char *ns,
             Collection* collection,
             Record *toupdate, const DiskLoc& dl,
-            const char *buf, int len, OpDebug& debug, bool god=false);
+            const char *buf, int len, OpDebug& debug, bool god=false,
+            bool indexKeysUnchanged=false);
 
         // The object o may be updated if modified on insert.
         void insertAndLog( const char *ns, const BSONObj &o, bool god = false, bool fromMigrate = false );
@@ -171,6 +174,16 @@ namespace mongo {
         // TODO: we need to not const_cast here but problem is DiskLoc::writing
         DiskLoc& nextDeleted() const { _accessing(); return const_cast<DiskLoc&>(_nextDeleted); }
 
+        /* the record before this one in its deleted list, or null if this is the head.  kept in the
+           first bytes of the data, which every deleted record has room for, and only maintained
+           for non-capped collections.  records freed by older versions don't have it, so it is a
+           hint: see NamespaceDetails::_findPrevDeleted.
+        */
+        DiskLoc& prevDeleted() const {
+            _accessing();
+            return *reinterpret_cast<DiskLoc*>(const_cast<DeletedRecord*>(this) + 1);
+        }
+
         DiskLoc myExtentLoc(const DiskLoc& myLoc) const {
             _accessing();
             return DiskLoc(myLoc.a(), _extentOfs);
@@ -421,10 +434,57 @@ namespace mongo {
         return reinterpret_cast<DeletedRecord*>(getRecord(dl));
     }
 
+    /**
+     * Records in a collection with NamespaceDetails::Flag_CompressRecords set may hold their
+     * document snappy compressed.  Such a record starts with the negated length of the compressed
+     * bytes that follow, which no BSON size can be, so BSONObj::make tells the two apart.
+     */
+
+    /** @return false, leaving 'out' alone, if compressing 'obj' wouldn't make it smaller */
+    bool compressRecordData( const BSONObj& obj, std::string* out );
+
+    /** @return an owned copy of the document in compressed record 'r' */
+    BSONObj uncompressRecordData( const Record* r );
+
+    inline bool isCompressedRecord( const Record* r ) {
+        return *reinterpret_cast<const int*>( r->data() ) < 0;
+    }
+
     inline BSONObj BSONObj::make(const Record* r ) {
+        if ( isCompressedRecord( r ) )
+            return uncompressRecordData( r );
         return BSONObj( r->data() );
     }
 
+    /**
+     * Records in a collection with NamespaceDetails::Flag_RecordChecksums set keep a checksum of
+     * their stored document in the padding just after it, behind a marker.  Records written
+     * without the flag, or without room to spare, have none and can't be checked.
+     */
+
+    /** the room a record needs after its document for a checksum */
+    const int RecordChecksumSize = 8;
+
+    inline int recordChecksumRoom( const NamespaceDetails* d ) {
+        return d->isUserFlagSet( NamespaceDetails::Flag_RecordChecksums ) ? RecordChecksumSize : 0;
+    }
+
+    /** @return the size of the document as stored at the start of 'r', compressed or not */
+    int storedDataSize( const Record* r );
+
+    /**
+     * Brings the checksum of 'r', whose document was just written, up to date: sets one if 'd'
+     * keeps them, and otherwise clears any left behind by an earlier record in the same space.
+     */
+    void updateRecordChecksum( const NamespaceDetails* d, Record* r );
+
+    /** rewrites the checksum of 'r', if it has one, after its document was changed in place */
+    void refreshRecordChecksum( Record* r );
+
+    enum RecordChecksumState { NoRecordChecksum, RecordChecksumOk, RecordChecksumBad };
+
+    RecordChecksumState checkRecordChecksum( const Record* r );
+
     DiskLoc allocateSpaceForANewRecord(const char* ns,
                                        NamespaceDetails* d,
                                        int32_t lenWHdr,
@@ -80,7 +80,7 @@ namespace mongo {
 
         // Make room for new field (and padding at end for alignment)
         const unsigned newUsed = ValueElement::align(_usedBytes + sizeof(ValueElement) + nameSize);
-        if (_buffer + newUsed > _bufferEnd)
+        if (_buffer + newUsed > _bufferEnd || needHashTabSpace())
             alloc(newUsed);
         _usedBytes = newUsed;
 
@@ -130,12 +130,16 @@ namespace mongo {
         const bool doingRehash = needRehash();
         const size_t oldCapacity = _bufferEnd - _buffer;
 
+        // Documents too small to hash (most $group keys, for one) leave out the hash table and
+        // start small.  The table is added once the field that starts hashing is appended.
+        const bool hashing = _numFields + 1 >= HASH_TAB_MIN;
+
         // make new bucket count big enough
-        while (needRehash() || hashTabBuckets() < HASH_TAB_INIT_SIZE)
+        while (hashing && (needRehash() || hashTabBuckets() < HASH_TAB_INIT_SIZE))
             _hashTabMask = hashTabBuckets()*2 - 1;
 
-        // only allocate power-of-two sized space > 128 bytes
-        size_t capacity = 128;
+        // only allocate power-of-two sized space, > 128 bytes once hashing
+        size_t capacity = hashing ? 128 : SMALL_DOC_MIN_BYTES;
         while (capacity < newSize + hashTabBytes())
             capacity *= 2;
 
@@ -166,10 +170,12 @@ namespace mongo {
     void DocumentStorage::reserveFields(size_t expectedFields) {
         fassert(16487, !_buffer);
 
-        unsigned buckets = HASH_TAB_INIT_SIZE;
-        while (buckets < expectedFields)
-            buckets *= 2;
-        _hashTabMask = buckets - 1;
+        if (expectedFields >= HASH_TAB_MIN) {
+            unsigned buckets = HASH_TAB_INIT_SIZE;
+            while (buckets < expectedFields)
+                buckets *= 2;
+            _hashTabMask = buckets - 1;
+        }
 
         // Using expectedFields+1 to allow space for long field names
         const size_t newSize = (expectedFields+1) * ValueElement::align(sizeof(ValueElement));
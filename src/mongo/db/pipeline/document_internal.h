@@ -255,6 +255,11 @@ namespace mongo {
         /// rehash on buffer growth if load-factor > .5 (attempt to keep lf < 1 when full)
         bool needRehash() const { return _numFields*2 > hashTabBuckets(); }
 
+        /// true if the next field starts hashing but there is no room for a hash table yet
+        bool needHashTabSpace() const {
+            return _numFields + 1 == HASH_TAB_MIN && hashTabBuckets() < HASH_TAB_INIT_SIZE;
+        }
+
         /// Initialize empty hash table
         void hashTabInit() { memset(_hashTab, -1, hashTabBytes()); }
 
@@ -280,6 +285,7 @@ namespace mongo {
             HASH_TAB_INIT_SIZE = 8, // must be power of 2
             HASH_TAB_MIN = 4, // don't hash fields for docs smaller than this
                               // set to 1 to always hash
+            SMALL_DOC_MIN_BYTES = 32, // first allocation for docs smaller than HASH_TAB_MIN
         };
 
         // _buffer layout:
@@ -300,6 +306,7 @@ namespace mongo {
             // pointer to "end" of _buffer element space and start of hash table (same position)
             char* _bufferEnd;
             Position* _hashTab; // table lazily initialized once _numFields == HASH_TAB_MIN
+                                // (until then space is left for just one unused bucket)
         };
 
         unsigned _usedBytes; // position where next field would start
@@ -166,6 +166,12 @@ namespace mongo {
 
         /// Returns true if doesn't require an input source (most DocumentSources do).
         virtual bool isValidInitialSource() const { return false; }
+
+        /**
+         * Returns true if this buffers its input, and so takes a share of the pipeline's
+         * ExpressionContext::maxMemoryUsageBytes. Pipeline::stitch() counts these.
+         */
+        virtual bool usesMemoryBudget() const { return false; }
         
     protected:
         /**
@@ -466,6 +472,7 @@ namespace mongo {
         virtual GetDepsReturn getDependencies(set<string>& deps) const;
         virtual void dispose();
         virtual Value serialize(bool explain = false) const;
+        virtual bool usesMemoryBudget() const { return true; }
 
         /**
           Create a new grouping DocumentSource.
@@ -530,12 +537,31 @@ namespace mongo {
     private:
         DocumentSourceGroup(const intrusive_ptr<ExpressionContext> &pExpCtx);
 
-        /// Spill groups map to disk and returns an iterator to the file.
-        shared_ptr<Sorter<Value, Value>::Iterator> spill();
+        typedef vector<intrusive_ptr<Accumulator> > Accumulators;
+        typedef boost::unordered_map<Value, Accumulators, Value::Hash> GroupsMap;
+
+        /// Spill toSpill to disk, emptying it, and returns an iterator to the file.
+        shared_ptr<Sorter<Value, Value>::Iterator> spill(GroupsMap& toSpill);
 
         // Only used by spill. Would be function-local if that were legal in C++03.
         class SpillSTLComparator;
 
+        /**
+         * Runs the accumulators of id's group in toGroups on vars, adding the group if it's new.
+         * @return the change in the memory toGroups uses
+         */
+        int accumulate(GroupsMap& toGroups, const Value& id, const Variables& vars,
+                       bool* inserted);
+
+        /**
+         * With aggregationGroupThreads above one, populate() hands the input to that many
+         * Partitions by the hash of its _id, each grouping its share on a worker thread.
+         */
+        class Partition;
+        void populateInParallel(int numPartitions);
+        /// Sets up getNext() to merge the groups that populate() spilled to sortedFiles.
+        void startMergingSpills(vector<shared_ptr<Sorter<Value, Value>::Iterator> >& sortedFiles);
+
         /*
           Before returning anything, this source must fetch everything from
           the underlying source and group it.  populate() is used to do that
@@ -547,8 +573,6 @@ namespace mongo {
 
         intrusive_ptr<Expression> pIdExpression;
 
-        typedef vector<intrusive_ptr<Accumulator> > Accumulators;
-        typedef boost::unordered_map<Value, Accumulators, Value::Hash> GroupsMap;
         GroupsMap groups;
 
         /*
@@ -573,7 +597,7 @@ namespace mongo {
         bool _doingMerge;
         bool _spilled;
         const bool _extSortAllowed;
-        const int _maxMemoryUsageBytes;
+        SorterStats _spillStats; // what spill() wrote, reported by explain
 
         // only used when !_spilled
         GroupsMap::iterator groupsIterator;
@@ -593,6 +617,7 @@ namespace mongo {
         virtual const char *getSourceName() const;
         virtual bool coalesce(const intrusive_ptr<DocumentSource>& nextSource);
         virtual Value serialize(bool explain = false) const;
+        virtual GetDepsReturn getDependencies(set<string>& deps) const;
 
         /**
           Create a filter.
@@ -621,6 +646,13 @@ namespace mongo {
          */
         BSONObj redactSafePortion() const;
 
+        /**
+         * Returns this match rewritten to run before a $project that passes the top level fields
+         * of renames' keys through from its values' fields (see DocumentSourceProject::getRenames).
+         * Returns NULL if the match reads anything else.
+         */
+        intrusive_ptr<DocumentSource> beforeRenames(const map<string, string>& renames) const;
+
     private:
         DocumentSourceMatch(const BSONObj &query,
             const intrusive_ptr<ExpressionContext> &pExpCtx);
@@ -707,6 +739,10 @@ namespace mongo {
           This can be put anywhere in a pipeline and will store content as
           well as pass it on.
 
+          The argument is either the output collection's name, which is replaced by the
+          results, or {to: <name>, mode: "replace" | "merge"}. In merge mode each result is
+          upserted by _id into the output collection, leaving other documents in place.
+
           @param pBsonElement the raw BSON specification for the source
           @param pExpCtx the expression context for the pipeline
           @returns the newly created document source
@@ -717,16 +753,27 @@ namespace mongo {
 
         static const char outName[];
 
+        /// Whether results are upserted into the output collection rather than replacing it.
+        bool isMerging() const { return _merging; }
+
     private:
         DocumentSourceOut(const NamespaceString& outputNs,
+                          bool merging,
                           const intrusive_ptr<ExpressionContext> &pExpCtx);
 
+        // Checks that _outputNs can be written to with $out.
+        void checkOutputNs();
+
         // Sets _tempsNs and prepares it to receive data.
         void prepTempCollection();
 
         void spill(DBClientBase* conn, const vector<BSONObj>& toInsert);
 
+        // Upserts toMerge by its _id into _outputNs.
+        void merge(DBClientBase* conn, const BSONObj& toMerge);
+
         bool _done;
+        const bool _merging;
 
         NamespaceString _tempNs; // output goes here as it is being processed.
         const NamespaceString _outputNs; // output will go here after all data is processed.
@@ -763,6 +810,12 @@ namespace mongo {
         /** projection as specified by the user */
         BSONObj getRaw() const { return _raw; }
 
+        /**
+         * Returns the top level output fields that are just an input field, maybe under a new
+         * name, mapped to the input field they come from. _id is included unless it's excluded.
+         */
+        map<string, string> getRenames() const;
+
     private:
         DocumentSourceProject(const intrusive_ptr<ExpressionContext>& pExpCtx,
                               const intrusive_ptr<ExpressionObject>& exprObj);
@@ -816,6 +869,9 @@ namespace mongo {
         virtual intrusive_ptr<DocumentSource> getShardSource();
         virtual intrusive_ptr<DocumentSource> getMergeSource();
 
+        /// Merging presorted input streams it rather than buffering.
+        virtual bool usesMemoryBudget() const { return !_mergingPresorted; }
+
         /**
           Add sort key field.
 
@@ -911,6 +967,9 @@ namespace mongo {
 
         intrusive_ptr<DocumentSourceLimit> limitSrc;
 
+        // what the sorter wrote to disk, reported by explain
+        mutable SorterStats _spillStats;
+
         bool _done;
         bool _mergingPresorted;
         scoped_ptr<MySorter::Iterator> _output;
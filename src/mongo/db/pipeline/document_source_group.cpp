@@ -36,10 +36,15 @@
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/value.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/concurrency/thread_pool.h"
 
 namespace mongo {
     const char DocumentSourceGroup::groupName[] = "$group";
 
+    // Worker threads each $group runs on; 1 means it groups all its input on its own thread.
+    MONGO_EXPORT_SERVER_PARAMETER(aggregationGroupThreads, int, 1);
+
     const char *DocumentSourceGroup::getSourceName() const {
         return groupName;
     }
@@ -122,10 +127,10 @@ namespace mongo {
     }
 
     void DocumentSourceGroup::optimize() {
-        pIdExpression = pIdExpression->optimize();
+        pIdExpression = ExpressionCompiled::compile(pIdExpression->optimize());
 
         for (size_t i = 0; i < vFieldName.size(); i++) {
-             vpExpression[i] = vpExpression[i]->optimize();
+             vpExpression[i] = ExpressionCompiled::compile(vpExpression[i]->optimize());
         }
     }
 
@@ -150,6 +155,12 @@ namespace mongo {
             insides["$doingMerge"] = Value(true);
         }
 
+        if (explain && populated) {
+            insides["$spills"] = Value(static_cast<long long>(_spillStats.spills.load()));
+            insides["$spilledBytes"] =
+                Value(static_cast<long long>(_spillStats.bytesSpilled.load()));
+        }
+
         return Value(DOC(getSourceName() << insides.freeze()));
     }
 
@@ -179,7 +190,6 @@ namespace mongo {
         , _doingMerge(false)
         , _spilled(false)
         , _extSortAllowed(pExpCtx->extSortAllowed && !pExpCtx->inRouter)
-        , _maxMemoryUsageBytes(100*1024*1024)
     {}
 
     void DocumentSourceGroup::addAccumulator(
@@ -347,20 +357,68 @@ namespace mongo {
         };
     }
 
+    int DocumentSourceGroup::accumulate(GroupsMap& toGroups,
+                                        const Value& id,
+                                        const Variables& vars,
+                                        bool* inserted) {
+        const size_t numAccumulators = vpAccumulatorFactory.size();
+        int memoryUsageBytes = 0;
+
+        /*
+          Look for the _id value in the map; if it's not there, add a
+          new entry with a blank accumulator.
+        */
+        const size_t oldSize = toGroups.size();
+        vector<intrusive_ptr<Accumulator> >& group = toGroups[id];
+        *inserted = toGroups.size() != oldSize;
+
+        if (*inserted) {
+            memoryUsageBytes += id.getApproximateSize();
+
+            // Add the accumulators
+            group.reserve(numAccumulators);
+            for (size_t i = 0; i < numAccumulators; i++) {
+                group.push_back(vpAccumulatorFactory[i]());
+            }
+        } else {
+            for (size_t i = 0; i < numAccumulators; i++) {
+                // subtract old mem usage. New usage added back after processing.
+                memoryUsageBytes -= group[i]->memUsageForSorter();
+            }
+        }
+
+        /* tickle all the accumulators for the group we found */
+        dassert(numAccumulators == group.size());
+        for (size_t i = 0; i < numAccumulators; i++) {
+            group[i]->process(vpExpression[i]->evaluate(vars), _doingMerge);
+            memoryUsageBytes += group[i]->memUsageForSorter();
+        }
+
+        return memoryUsageBytes;
+    }
+
     void DocumentSourceGroup::populate() {
         const size_t numAccumulators = vpAccumulatorFactory.size();
         dassert(numAccumulators == vpExpression.size());
 
+        const int numPartitions = aggregationGroupThreads;
+        if (numPartitions > 1) {
+            populateInParallel(numPartitions);
+            populated = true;
+            return;
+        }
+
         // pushed to on spill()
         vector<shared_ptr<Sorter<Value, Value>::Iterator> > sortedFiles;
+        const int maxMemoryUsageBytes = pExpCtx->stageMemoryLimitBytes();
         int memoryUsageBytes = 0;
 
         // This loop consumes all input from pSource and buckets it based on pIdExpression.
         while (boost::optional<Document> input = pSource->getNext()) {
-            if (memoryUsageBytes > _maxMemoryUsageBytes) {
+            if (memoryUsageBytes > maxMemoryUsageBytes) {
                 uassert(16945, "Exceeded memory limit for $group, but didn't allow external sort",
                         _extSortAllowed);
-                sortedFiles.push_back(spill());
+                sortedFiles.push_back(spill(groups));
                 memoryUsageBytes = 0;
             }
 
@@ -373,35 +431,9 @@ namespace mongo {
             if (id.missing())
                 id = Value(BSONNULL);
 
-            /*
-              Look for the _id value in the map; if it's not there, add a
-              new entry with a blank accumulator.
-            */
-            const size_t oldSize = groups.size();
-            vector<intrusive_ptr<Accumulator> >& group = groups[id];
-            const bool inserted = groups.size() != oldSize;
-
-            if (inserted) {
-                memoryUsageBytes += id.getApproximateSize();
-
-                // Add the accumulators
-                group.reserve(numAccumulators);
-                for (size_t i = 0; i < numAccumulators; i++) {
-                    group.push_back(vpAccumulatorFactory[i]());
-                }
-            } else {
-                for (size_t i = 0; i < numAccumulators; i++) {
-                    // subtract old mem usage. New usage added back after processing.
-                    memoryUsageBytes -= group[i]->memUsageForSorter();
-                }
-            }
-
-            /* tickle all the accumulators for the group we found */
-            dassert(numAccumulators == group.size());
-            for (size_t i = 0; i < numAccumulators; i++) {
-                group[i]->process(vpExpression[i]->evaluate(vars), _doingMerge);
-                memoryUsageBytes += group[i]->memUsageForSorter();
-            }
+            bool inserted;
+            memoryUsageBytes += accumulate(groups, id, vars, &inserted);
+            pExpCtx->noteMemoryUsage(memoryUsageBytes);
 
             DEV {
                 // In debug mode, spill every time we have a duplicate id to stress merge logic.
@@ -410,39 +442,218 @@ namespace mongo {
                         && !_extSortAllowed // don't change behavior when testing external sort
                         && sortedFiles.size() < 20 // don't open too many FDs
                         ) {
-                    sortedFiles.push_back(spill());
+                    sortedFiles.push_back(spill(groups));
                 }
             }
         }
 
         // These blocks do any final steps necessary to prepare to output results.
         if (!sortedFiles.empty()) {
-            _spilled = true;
             if (!groups.empty()) {
-                sortedFiles.push_back(spill());
+                sortedFiles.push_back(spill(groups));
             }
+            startMergingSpills(sortedFiles);
+        } else {
+            // start the group iterator
+            groupsIterator = groups.begin();
+        }
 
-            // We won't be using groups again so free its memory.
-            GroupsMap().swap(groups);
+        populated = true;
+    }
 
-            _sorterIterator.reset(
-                    Sorter<Value,Value>::Iterator::merge(
-                        sortedFiles, SortOptions(), SorterComparator()));
+    void DocumentSourceGroup::startMergingSpills(
+            vector<shared_ptr<Sorter<Value, Value>::Iterator> >& sortedFiles) {
+        const size_t numAccumulators = vpAccumulatorFactory.size();
+        _spilled = true;
 
-            // prepare current to accumulate data
-            _currentAccumulators.reserve(numAccumulators);
-            for (size_t i = 0; i < numAccumulators; i++) {
-                _currentAccumulators.push_back(vpAccumulatorFactory[i]());
+        // We won't be using groups again so free its memory.
+        GroupsMap().swap(groups);
+
+        _sorterIterator.reset(
+                Sorter<Value,Value>::Iterator::merge(
+                    sortedFiles, SortOptions(), SorterComparator()));
+
+        // prepare current to accumulate data
+        _currentAccumulators.reserve(numAccumulators);
+        for (size_t i = 0; i < numAccumulators; i++) {
+            _currentAccumulators.push_back(vpAccumulatorFactory[i]());
+        }
+
+        verify(_sorterIterator->more()); // we put data in, we should get something out.
+        _firstPartOfNextGroup = _sorterIterator->next();
+    }
+
+    /**
+     * The groups whose _id hashes to one partition. Only one worker at a time groups a batch of
+     * its input, in input order, so $first, $last and $push see what they would on one thread.
+     * Each partition gets an equal share of the memory limit and spills on its own when over it.
+     */
+    class DocumentSourceGroup::Partition : boost::noncopyable {
+    public:
+        Partition(DocumentSourceGroup* owner, int maxMemoryUsageBytes)
+            : _owner(owner)
+            , _maxMemoryUsageBytes(maxMemoryUsageBytes)
+            , _memoryUsageBytes(0)
+            , peakMemoryUsageBytes(0)
+            , _mutex("DocumentSourceGroup::Partition")
+            , _busy(false)
+            , _errorCode(0)
+        {}
+
+        /// queues input, handing the queue to a worker once it makes a batch
+        void add(const Value& id, const Document& input, ThreadPool& workers) {
+            _queued.push_back(make_pair(id, input));
+            if (_queued.size() >= BatchSize)
+                handOff(workers);
+        }
+
+        /// hands off what's queued and waits for the worker; throws what the worker hit
+        void finish(ThreadPool& workers) {
+            if (!_queued.empty())
+                handOff(workers);
+            waitForWorker();
+            if (_errorCode != 0)
+                throw UserException(_errorCode, _errorMessage);
+        }
+
+        GroupsMap groups;
+        vector<shared_ptr<Sorter<Value, Value>::Iterator> > sortedFiles;
+        int peakMemoryUsageBytes; // the worker's, only read after finish()
+
+    private:
+        typedef vector<pair<Value, Document> > Batch;
+        static const size_t BatchSize = 256;
+
+        void handOff(ThreadPool& workers) {
+            waitForWorker();
+            _batch.swap(_queued);
+            {
+                scoped_lock lk(_mutex);
+                _busy = true;
             }
+            workers.schedule(&Partition::groupBatch, this);
+        }
 
-            verify(_sorterIterator->more()); // we put data in, we should get something out.
-            _firstPartOfNextGroup = _sorterIterator->next();
-        } else {
-            // start the group iterator
-            groupsIterator = groups.begin();
+        void waitForWorker() {
+            scoped_lock lk(_mutex);
+            while (_busy)
+                _workerDone.wait(lk.boost());
         }
 
-        populated = true;
+        /// on a worker
+        void groupBatch() {
+            if (_errorCode == 0) {
+                try {
+                    for (Batch::const_iterator it = _batch.begin(); it != _batch.end(); ++it) {
+                        if (_memoryUsageBytes > _maxMemoryUsageBytes) {
+                            uassert(16945, "Exceeded memory limit for $group, but didn't allow "
+                                           "external sort",
+                                    _owner->_extSortAllowed);
+                            sortedFiles.push_back(_owner->spill(groups));
+                            _memoryUsageBytes = 0;
+                        }
+
+                        bool inserted;
+                        _memoryUsageBytes += _owner->accumulate(groups, it->first,
+                                                                Variables(it->second),
+                                                                &inserted);
+                        peakMemoryUsageBytes = std::max(peakMemoryUsageBytes,
+                                                        _memoryUsageBytes);
+                    }
+                }
+                catch (const DBException& e) {
+                    _errorCode = e.getCode();
+                    _errorMessage = e.what();
+                }
+                catch (const std::exception& e) {
+                    _errorCode = 17355;
+                    _errorMessage = str::stream() << "$group worker failed: " << e.what();
+                }
+            }
+            _batch.clear();
+
+            scoped_lock lk(_mutex);
+            _busy = false;
+            _workerDone.notify_one();
+        }
+
+        DocumentSourceGroup* const _owner;
+        const int _maxMemoryUsageBytes;
+        int _memoryUsageBytes; // the worker's
+
+        Batch _queued; // filled by the thread running populate()
+        Batch _batch; // the worker's while _busy
+
+        mongo::mutex _mutex;
+        boost::condition _workerDone;
+        bool _busy;
+
+        // the first error the worker hit, after which it groups nothing more
+        int _errorCode;
+        string _errorMessage;
+    };
+
+    void DocumentSourceGroup::populateInParallel(int numPartitions) {
+        // Declared before the workers so that it outlives the tasks they run.
+        vector<shared_ptr<Partition> > partitions;
+        for (int i = 0; i < numPartitions; i++) {
+            partitions.push_back(boost::make_shared<Partition>(
+                    this, pExpCtx->stageMemoryLimitBytes() / numPartitions));
+        }
+
+        {
+            ThreadPool workers(numPartitions);
+            const Value::Hash hasher = Value::Hash();
+
+            // The _id is evaluated here to pick the partition; everything else is on the workers.
+            while (boost::optional<Document> input = pSource->getNext()) {
+                Value id = pIdExpression->evaluate(Variables(*input));
+
+                /* treat missing values the same as NULL SERVER-4674 */
+                if (id.missing())
+                    id = Value(BSONNULL);
+
+                partitions[hasher(id) % numPartitions]->add(id, *input, workers);
+            }
+
+            for (int i = 0; i < numPartitions; i++) {
+                partitions[i]->finish(workers);
+            }
+        }
+
+        // At most what every partition held at its peak.
+        long long peakMemoryUsageBytes = 0;
+        for (int i = 0; i < numPartitions; i++) {
+            peakMemoryUsageBytes += partitions[i]->peakMemoryUsageBytes;
+        }
+        pExpCtx->noteMemoryUsage(peakMemoryUsageBytes);
+
+        bool spilled = false;
+        for (int i = 0; i < numPartitions; i++) {
+            spilled = spilled || !partitions[i]->sortedFiles.empty();
+        }
+
+        if (spilled) {
+            // Every partition's groups go through the sorter, which merges by _id.
+            vector<shared_ptr<Sorter<Value, Value>::Iterator> > sortedFiles;
+            for (int i = 0; i < numPartitions; i++) {
+                Partition& partition = *partitions[i];
+                sortedFiles.insert(sortedFiles.end(),
+                                   partition.sortedFiles.begin(), partition.sortedFiles.end());
+                if (!partition.groups.empty())
+                    sortedFiles.push_back(spill(partition.groups));
+            }
+            startMergingSpills(sortedFiles);
+        }
+        else {
+            // No _id is in two partitions, so their groups just go together.
+            groups.swap(partitions[0]->groups);
+            for (int i = 1; i < numPartitions; i++) {
+                groups.insert(partitions[i]->groups.begin(), partitions[i]->groups.end());
+                GroupsMap().swap(partitions[i]->groups);
+            }
+            groupsIterator = groups.begin();
+        }
     }
 
     class DocumentSourceGroup::SpillSTLComparator {
@@ -452,16 +663,17 @@ namespace mongo {
         }
     };
 
-    shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill() {
+    shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill(GroupsMap& toSpill) {
         vector<const GroupsMap::value_type*> ptrs; // using pointers to speed sorting
-        ptrs.reserve(groups.size());
-        for (GroupsMap::const_iterator it=groups.begin(), end=groups.end(); it != end; ++it) {
+        ptrs.reserve(toSpill.size());
+        for (GroupsMap::const_iterator it=toSpill.begin(), end=toSpill.end(); it != end; ++it) {
             ptrs.push_back(&*it);
         }
 
         stable_sort(ptrs.begin(), ptrs.end(), SpillSTLComparator());
 
-        SortedFileWriter<Value, Value> writer(SortOptions().TempDir(pExpCtx->tempDir));
+        SortedFileWriter<Value, Value> writer(SortOptions().TempDir(pExpCtx->tempDir)
+                                                           .Stats(&_spillStats));
         switch (vpAccumulatorFactory.size()) { // same as ptrs[i]->second.size() for all i.
         case 0: // no values, essentially a distinct
             for (size_t i=0; i < ptrs.size(); i++) {
@@ -487,7 +699,7 @@ namespace mongo {
             break;
         }
 
-        groups.clear();
+        toSpill.clear();
 
         return shared_ptr<Sorter<Value, Value>::Iterator>(writer.done());
     }
@@ -271,6 +271,87 @@ namespace {
         return redactSafePortionTopLevel(getQuery()).toBson();
     }
 
+namespace {
+    /**
+     * Adds the fields query reads to deps.
+     * @return false if that can't be told from the query, as with $where.
+     */
+    bool addMatchDependencies(const BSONObj& query, set<string>& deps) {
+        BSONForEach(field, query) {
+            const StringData fieldName = field.fieldNameStringData();
+            if (fieldName[0] == '$') {
+                if (fieldName == "$and" || fieldName == "$or" || fieldName == "$nor") {
+                    BSONForEach(clause, field.Obj()) {
+                        if (!addMatchDependencies(clause.Obj(), deps))
+                            return false;
+                    }
+                }
+                else if (fieldName != "$comment" && fieldName != "$atomic"
+                         && fieldName != "$isolated") {
+                    return false;
+                }
+                continue;
+            }
+
+            // The whole top level field: below it, documents built from the dependencies drop
+            // array elements that aren't objects and can't be indexed into, both of which the
+            // matcher can see.
+            deps.insert(fieldName.substr(0, fieldName.find('.')).toString());
+        }
+        return true;
+    }
+
+    /// Renames the top level field of each path query reads. Every one must be in renames.
+    BSONObj renameMatchFields(const BSONObj& query, const map<string, string>& renames) {
+        BSONObjBuilder renamed;
+        BSONForEach(field, query) {
+            const StringData fieldName = field.fieldNameStringData();
+            if (fieldName == "$and" || fieldName == "$or" || fieldName == "$nor") {
+                BSONArrayBuilder clauses(renamed.subarrayStart(fieldName));
+                BSONForEach(clause, field.Obj()) {
+                    clauses.append(renameMatchFields(clause.Obj(), renames));
+                }
+                clauses.doneFast();
+            }
+            else if (fieldName[0] == '$') {
+                renamed.append(field);
+            }
+            else {
+                const size_t dot = fieldName.find('.');
+                const string top = fieldName.substr(0, dot).toString();
+                map<string, string>::const_iterator it = renames.find(top);
+                verify(it != renames.end());
+                renamed.appendAs(field, dot == string::npos
+                                            ? it->second
+                                            : it->second + fieldName.substr(dot).toString());
+            }
+        }
+        return renamed.obj();
+    }
+}
+
+    intrusive_ptr<DocumentSource> DocumentSourceMatch::beforeRenames(
+            const map<string, string>& renames) const {
+        const BSONObj query = getQuery();
+
+        set<string> deps;
+        if (!addMatchDependencies(query, deps))
+            return NULL;
+        for (set<string>::const_iterator it = deps.begin(); it != deps.end(); ++it) {
+            if (!renames.count(*it))
+                return NULL;
+        }
+
+        return createFromBson(BSON(matchName << renameMatchFields(query, renames)).firstElement(),
+                              pExpCtx);
+    }
+
+    DocumentSource::GetDepsReturn DocumentSourceMatch::getDependencies(set<string>& deps) const {
+        if (!addMatchDependencies(getQuery(), deps))
+            return NOT_SUPPORTED;
+        return SEE_NEXT;
+    }
+
     static void uassertNoDisallowedClauses(BSONObj query) {
         BSONForEach(e, query) {
             // can't use the Matcher API because this would segfault the constructor
@@ -114,6 +114,8 @@ namespace mongo {
             _cursors.push_back(boost::make_shared<CursorAndConnection>(
                         it->first, pExpCtx->ns, it->second));
             verify(_cursors.back()->connection->lazySupported());
+            // each shard works on its next batch while we merge the one we have
+            _cursors.back()->cursor.setPrefetch(true);
             _cursors.back()->cursor.initLazy(); // shouldn't block
         }
 
@@ -47,14 +47,9 @@ namespace mongo {
         return outName;
     }
 
-    static AtomicUInt32 aggOutCounter;
-    void DocumentSourceOut::prepTempCollection() {
+    void DocumentSourceOut::checkOutputNs() {
         verify(_mongod);
-        verify(_tempNs.size() == 0);
-
-        DBClientBase* conn = _mongod->directClient();
 
-        // Fail early by checking before we do any work.
         uassert(17017, str::stream() << "namespace '" << _outputNs.ns()
                                      << "' is sharded so it can't be used for $out'",
                 !_mongod->isSharded(_outputNs));
@@ -63,6 +58,17 @@ namespace mongo {
         uassert(17152, str::stream() << "namespace '" << _outputNs.ns()
                                      << "' is capped so it can't be used for $out",
                 !_mongod->isCapped(_outputNs));
+    }
+
+    static AtomicUInt32 aggOutCounter;
+    void DocumentSourceOut::prepTempCollection() {
+        verify(_mongod);
+        verify(_tempNs.size() == 0);
+
+        DBClientBase* conn = _mongod->directClient();
+
+        // Fail early by checking before we do any work.
+        checkOutputNs();
 
         _tempNs = StringData(str::stream() << _outputNs.db()
                                            << ".tmp.agg_out."
@@ -103,6 +109,18 @@ namespace mongo {
                 DBClientWithCommands::getLastErrorString(err).empty());
     }
 
+    void DocumentSourceOut::merge(DBClientBase* conn, const BSONObj& toMerge) {
+        BSONElement id = toMerge["_id"];
+        uassert(17360, str::stream() << "$out in merge mode needs an _id in every document: "
+                                     << toMerge,
+                !id.eoo());
+
+        conn->update(_outputNs.ns(), QUERY("_id" << id), toMerge, /*upsert=*/true);
+        BSONObj err = conn->getLastErrorDetailed();
+        uassert(17361, str::stream() << "upsert for $out failed: " << err,
+                DBClientWithCommands::getLastErrorString(err).empty());
+    }
+
     boost::optional<Document> DocumentSourceOut::getNext() {
         pExpCtx->checkForInterrupt();
 
@@ -114,6 +132,16 @@ namespace mongo {
         verify(_mongod);
         DBClientBase* conn = _mongod->directClient();
 
+        if (_merging) {
+            // Results go straight to the output collection, so there is nothing to rename. A
+            // failure part way leaves the documents merged so far, as a rerun would merge them.
+            checkOutputNs();
+            while (boost::optional<Document> next = pSource->getNext()) {
+                merge(conn, next->toBson());
+            }
+            return boost::none;
+        }
+
         prepTempCollection();
         verify(_tempNs.size() != 0);
 
@@ -156,9 +184,11 @@ namespace mongo {
     }
 
     DocumentSourceOut::DocumentSourceOut(const NamespaceString& outputNs,
+                                         bool merging,
                                          const intrusive_ptr<ExpressionContext>& pExpCtx)
         : DocumentSource(pExpCtx)
         , _done(false)
+        , _merging(merging)
         , _tempNs("") // filled in by prepTempCollection
         , _outputNs(outputNs)
     {}
@@ -166,18 +196,48 @@ namespace mongo {
     intrusive_ptr<DocumentSource> DocumentSourceOut::createFromBson(
             BSONElement elem,
             const intrusive_ptr<ExpressionContext> &pExpCtx) {
-        uassert(16990, str::stream() << "$out only supports a string argument, not "
+        uassert(16990, str::stream() << "$out only supports a string or object argument, not "
                                      << typeName(elem.type()),
-                elem.type() == String);
-        
-        NamespaceString outputNs(pExpCtx->ns.db().toString() + '.' + elem.str());
-        return new DocumentSourceOut(outputNs, pExpCtx);
+                elem.type() == String || elem.type() == Object);
+
+        if (elem.type() == String) {
+            NamespaceString outputNs(pExpCtx->ns.db().toString() + '.' + elem.str());
+            return new DocumentSourceOut(outputNs, false, pExpCtx);
+        }
+
+        string to;
+        bool merging = false;
+        BSONForEach(field, elem.Obj()) {
+            if (str::equals(field.fieldName(), "to")) {
+                uassert(17358, "$out's 'to' must be a string", field.type() == String);
+                to = field.str();
+            }
+            else if (str::equals(field.fieldName(), "mode")) {
+                uassert(17359, "$out's 'mode' must be \"replace\" or \"merge\"",
+                        field.type() == String
+                            && (field.str() == "replace" || field.str() == "merge"));
+                merging = (field.str() == "merge");
+            }
+            else {
+                uasserted(17357, str::stream() << "unrecognized field in $out: "
+                                               << field.fieldName());
+            }
+        }
+        uassert(17358, "$out's 'to' must be a string", !to.empty());
+
+        NamespaceString outputNs(pExpCtx->ns.db().toString() + '.' + to);
+        return new DocumentSourceOut(outputNs, merging, pExpCtx);
     }
 
     Value DocumentSourceOut::serialize(bool explain) const {
         massert(17000, "$out shouldn't have different db than input",
                 _outputNs.db() == pExpCtx->ns.db());
 
+        if (_merging)
+            return Value(DOC(getSourceName() << DOC("to" << _outputNs.coll()
+                                                 << "mode" << "merge")));
+
+        // The string form is what shards and routers without merge mode understand.
         return Value(DOC(getSourceName() << _outputNs.coll()));
     }
 }
@@ -92,6 +92,7 @@ namespace mongo {
     void DocumentSourceProject::optimize() {
         intrusive_ptr<Expression> pE(pEO->optimize());
         pEO = dynamic_pointer_cast<ExpressionObject>(pE);
+        pEO->compileFields();
     }
 
     Value DocumentSourceProject::serialize(bool explain) const {
@@ -135,6 +136,32 @@ namespace mongo {
         return pProject;
     }
 
+    map<string, string> DocumentSourceProject::getRenames() const {
+        map<string, string> renames;
+        if (!_raw.hasField("_id"))
+            renames["_id"] = "_id";
+
+        BSONForEach(field, _raw) {
+            const string name = field.fieldName();
+            if (name.find('.') != string::npos)
+                continue; // only builds part of a top level field
+
+            if (field.isBoolean() || field.isNumber()) {
+                if (field.trueValue())
+                    renames[name] = name;
+            }
+            else if (field.type() == String) {
+                // A dotted path gathers values out of arrays, which the matcher would see
+                // differently from the output, and $$ variables aren't input fields.
+                const StringData path = field.valuestr();
+                if (path.size() > 1 && path[0] == '$' && path[1] != '$'
+                        && path.find('.') == string::npos)
+                    renames[name] = path.substr(1).toString();
+            }
+        }
+        return renames;
+    }
+
     DocumentSource::GetDepsReturn DocumentSourceProject::getDependencies(set<string>& deps) const {
         vector<string> path; // empty == top-level
         pEO->addDependencies(deps, &path);
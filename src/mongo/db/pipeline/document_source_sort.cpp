@@ -57,10 +57,18 @@ namespace mongo {
 
     void DocumentSourceSort::serializeToArray(vector<Value>& array, bool explain) const {
         if (explain) { // always one Value for combined $sort + $limit
+            const bool reportSpills = populated && !_mergingPresorted;
             array.push_back(Value(DOC(getSourceName() <<
                 DOC("sortKey" << serializeSortKey()
                  << "mergePresorted" << (_mergingPresorted ? Value(true) : Value())
-                 << "limit" << (limitSrc ? Value(limitSrc->getLimit()) : Value())))));
+                 << "limit" << (limitSrc ? Value(limitSrc->getLimit()) : Value())
+                 << "spills" << (reportSpills
+                                 ? Value(static_cast<long long>(_spillStats.spills.load()))
+                                 : Value())
+                 << "spilledBytes" << (reportSpills
+                                       ? Value(static_cast<long long>(
+                                                   _spillStats.bytesSpilled.load()))
+                                       : Value())))));
         }
         else { // one Value for $sort and maybe a Value for $limit
             MutableDocument inner (serializeSortKey());
@@ -190,10 +198,11 @@ namespace mongo {
         if (limitSrc)
             opts.limit = limitSrc->getLimit();
 
-        opts.maxMemoryUsageBytes = 100*1024*1024;
+        opts.maxMemoryUsageBytes = pExpCtx->stageMemoryLimitBytes();
         if (pExpCtx->extSortAllowed && !pExpCtx->inRouter) {
             opts.extSortAllowed = true;
             opts.tempDir = pExpCtx->tempDir;
+            opts.stats = &_spillStats;
         }
 
         return opts;
@@ -214,6 +223,7 @@ namespace mongo {
             scoped_ptr<MySorter> sorter (MySorter::make(makeSortOptions(), Comparator(*this)));
             while (boost::optional<Document> next = pSource->getNext()) {
                 sorter->add(extractKey(*next), *next);
+                pExpCtx->noteMemoryUsage(sorter->memUsed());
             }
             _output.reset(sorter->done());
         }
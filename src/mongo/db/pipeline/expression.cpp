@@ -41,6 +41,7 @@
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/value.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/string_map.h"
 #include "mongo/util/mongoutils/str.h"
 
@@ -611,6 +612,311 @@ namespace {
         return cmpLookup[cmpOp].name;
     }
 
+    /* ------------------------- ExpressionCompiled ----------------------------- */
+
+    // Lets a workload that misbehaves compiled go back to evaluating the expression trees.
+    MONGO_EXPORT_SERVER_PARAMETER(aggregationCompileExpressions, bool, true);
+
+    namespace {
+        /// An instruction's operand holding the value an earlier instruction put in a register.
+        class ExpressionRegister : public Expression {
+        public:
+            explicit ExpressionRegister(int index) : _index(index) {}
+
+            virtual intrusive_ptr<Expression> optimize() { return this; }
+            virtual void addDependencies(set<string>& deps, vector<string>* path=NULL) const {
+                verify(false); // only ExpressionCompiled's instructions use these
+            }
+            virtual Value serialize(bool explain) const {
+                verify(false); // only ExpressionCompiled's instructions use these
+            }
+            virtual Value evaluateInternal(const Variables& vars) const {
+                return vars.registers[_index];
+            }
+
+            int getIndex() const { return _index; }
+
+        private:
+            const int _index;
+        };
+
+        /// Operators that evaluate all of their operands before anything else.
+        const char* const eagerOperators[] = {
+            "$cmp", "$eq", "$gt", "$gte", "$lt", "$lte", "$ne",
+            "$divide", "$mod", "$subtract", "$substr", "$strcasecmp",
+            "$setDifference", "$setIsSubset",
+        };
+
+        /// Operators that return null on the first nullish operand without evaluating the rest.
+        const char* const earlyExitOperators[] = {
+            "$add", "$multiply", "$concat", "$setUnion", "$setIntersection", "$setEquals",
+        };
+
+        bool isOneOf(StringData name, const char* const* names, size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                if (name == names[i])
+                    return true;
+            }
+            return false;
+        }
+
+        /// Constants and field paths are cheap and can't fail, so they stay in place as operands.
+        bool isLeaf(const Expression* expr) {
+            return dynamic_cast<const ExpressionConstant*>(expr)
+                || dynamic_cast<const ExpressionFieldPath*>(expr)
+                || dynamic_cast<const ExpressionRegister*>(expr);
+        }
+    }
+
+    class ExpressionCompiled::Compiler {
+    public:
+        explicit Compiler(ExpressionCompiled* target)
+            : _target(target)
+            , _conditional(0)
+        {}
+
+        /**
+         * Emits the instructions computing expr, returning what an instruction should use as its
+         * operand instead: expr itself, or the register now holding its value.
+         */
+        intrusive_ptr<Expression> operand(const intrusive_ptr<Expression>& expr) {
+            if (isLeaf(expr.get()))
+                return expr;
+
+            ExpressionNary* nary = dynamic_cast<ExpressionNary*>(expr.get());
+            if (!nary || !flattens(nary))
+                return expr; // evaluated as a tree by the instruction using it
+
+            // Only operators evaluated whatever the conditions can be shared, but anything can
+            // use them since they come first. The BSON keeps 1 and 1.0 apart.
+            const BSONObj serialized = toBson(nary);
+            const string key(serialized.objdata(), serialized.objsize());
+            map<string, int>::const_iterator common = _common.find(key);
+            if (common != _common.end())
+                return new ExpressionRegister(common->second);
+
+            int reg;
+            if (dynamic_cast<ExpressionCond*>(nary))
+                reg = compileCond(nary);
+            else if (dynamic_cast<ExpressionIfNull*>(nary))
+                reg = compileIfNull(nary);
+            else if (dynamic_cast<ExpressionAnd*>(nary))
+                reg = compileAndOr(nary, true);
+            else if (dynamic_cast<ExpressionOr*>(nary))
+                reg = compileAndOr(nary, false);
+            else
+                reg = compileOperator(nary, serialized);
+
+            if (_conditional == 0)
+                _common[key] = reg;
+            return new ExpressionRegister(reg);
+        }
+
+        /// Returns the register holding operand's value, emitting an EVAL if it isn't in one.
+        int toRegister(const intrusive_ptr<Expression>& operand) {
+            if (ExpressionRegister* reg = dynamic_cast<ExpressionRegister*>(operand.get()))
+                return reg->getIndex();
+
+            const int reg = newRegister();
+            emit(Instruction::EVAL, reg, operand);
+            return reg;
+        }
+
+    private:
+        /// {"": <nary serialized>}
+        static BSONObj toBson(const ExpressionNary* nary) {
+            BSONObjBuilder bob;
+            nary->serialize(false).addToBsonObj(&bob, "");
+            return bob.obj();
+        }
+
+        static bool flattens(const ExpressionNary* nary) {
+            if (dynamic_cast<const ExpressionCond*>(nary)
+                    || dynamic_cast<const ExpressionIfNull*>(nary)
+                    || dynamic_cast<const ExpressionAnd*>(nary)
+                    || dynamic_cast<const ExpressionOr*>(nary))
+                return true;
+
+            const ExpressionVector& operands = nary->vpOperand;
+            const StringData name = nary->getOpName();
+            if (operands.size() == 1
+                    || isOneOf(name, eagerOperators,
+                               sizeof(eagerOperators) / sizeof(eagerOperators[0])))
+                return true;
+
+            if (isOneOf(name, earlyExitOperators,
+                        sizeof(earlyExitOperators) / sizeof(earlyExitOperators[0]))) {
+                // Evaluating the operands the original would have skipped is only safe if they
+                // can't fail.
+                for (size_t i = 1; i < operands.size(); i++) {
+                    if (!isLeaf(operands[i].get()))
+                        return false;
+                }
+                return true;
+            }
+
+            return false;
+        }
+
+        int compileCond(ExpressionNary* cond) {
+            const ExpressionVector& operands = cond->vpOperand;
+            const int condition = toRegister(operand(operands[0]));
+            const size_t toElse = emit(Instruction::JUMP_IF_FALSE, condition);
+
+            _conditional++;
+            const int reg = newRegister();
+            emit(Instruction::EVAL, reg, operand(operands[1]));
+            const size_t toEnd = emit(Instruction::JUMP, -1);
+            patch(toElse);
+            emit(Instruction::EVAL, reg, operand(operands[2]));
+            patch(toEnd);
+            _conditional--;
+
+            return reg;
+        }
+
+        int compileIfNull(ExpressionNary* ifNull) {
+            const ExpressionVector& operands = ifNull->vpOperand;
+            const int reg = newRegister();
+            emit(Instruction::EVAL, reg, operand(operands[0]));
+            const size_t toEnd = emit(Instruction::JUMP_IF_NOT_NULLISH, reg);
+
+            _conditional++;
+            emit(Instruction::EVAL, reg, operand(operands[1]));
+            patch(toEnd);
+            _conditional--;
+
+            return reg;
+        }
+
+        /// $and stops at the first false operand, $or at the first true one.
+        int compileAndOr(ExpressionNary* nary, bool isAnd) {
+            const ExpressionVector& operands = nary->vpOperand;
+            const Instruction::Op stop = isAnd ? Instruction::JUMP_IF_FALSE
+                                               : Instruction::JUMP_IF_TRUE;
+            vector<size_t> toStopped;
+            for (size_t i = 0; i < operands.size(); i++) {
+                if (i == 1)
+                    _conditional++; // only the first operand is always evaluated
+                toStopped.push_back(emit(stop, toRegister(operand(operands[i]))));
+            }
+            if (operands.size() > 1)
+                _conditional--;
+
+            const int reg = newRegister();
+            emit(Instruction::EVAL, reg, ExpressionConstant::create(Value(isAnd)));
+            const size_t toEnd = emit(Instruction::JUMP, -1);
+            for (size_t i = 0; i < toStopped.size(); i++)
+                patch(toStopped[i]);
+            emit(Instruction::EVAL, reg, ExpressionConstant::create(Value(!isAnd)));
+            patch(toEnd);
+
+            return reg;
+        }
+
+        /// Emits an EVAL of a copy of nary, parsed from its serialized form, with leaf operands.
+        int compileOperator(ExpressionNary* nary, const BSONObj& serialized) {
+            // Round tripping through serialize() copies the operator without a clone() on every
+            // Expression. Only done once per operator per pipeline.
+            intrusive_ptr<Expression> parsed = parseOperand(serialized.firstElement());
+            ExpressionNary* copy = dynamic_cast<ExpressionNary*>(parsed.get());
+            verify(copy && str::equals(copy->getOpName(), nary->getOpName()));
+
+            const ExpressionVector& operands = nary->vpOperand;
+            copy->vpOperand.resize(operands.size());
+            for (size_t i = 0; i < operands.size(); i++) {
+                copy->vpOperand[i] = operand(operands[i]);
+            }
+
+            const int reg = newRegister();
+            emit(Instruction::EVAL, reg, parsed);
+            return reg;
+        }
+
+        int newRegister() { return _target->_numRegisters++; }
+
+        /// @return the index of the new instruction, for patch()
+        size_t emit(Instruction::Op op, int reg,
+                    const intrusive_ptr<Expression>& expr = intrusive_ptr<Expression>()) {
+            _target->_program.push_back(Instruction(op, reg, expr));
+            return _target->_program.size() - 1;
+        }
+
+        /// Points the jump at index at the next instruction to be emitted.
+        void patch(size_t jump) {
+            _target->_program[jump].target = _target->_program.size();
+        }
+
+        ExpressionCompiled* const _target;
+        int _conditional; // how many $cond branches, $ifNull or $and / $or tails we are within
+        map<string, int> _common; // serialized operator -> its register
+    };
+
+    ExpressionCompiled::ExpressionCompiled(const intrusive_ptr<Expression>& original)
+        : _original(original)
+        , _numRegisters(0)
+        , _result(-1)
+    {}
+
+    intrusive_ptr<Expression> ExpressionCompiled::compile(const intrusive_ptr<Expression>& expr) {
+        if (ExpressionObject* object = dynamic_cast<ExpressionObject*>(expr.get())) {
+            object->compileFields();
+            return expr;
+        }
+
+        if (!aggregationCompileExpressions)
+            return expr;
+
+        intrusive_ptr<ExpressionCompiled> compiled = new ExpressionCompiled(expr);
+        Compiler compiler(compiled.get());
+        compiled->_result = compiler.toRegister(compiler.operand(expr));
+
+        // A single instruction is just the original with extra steps.
+        if (compiled->_program.size() <= 1 || compiled->_numRegisters > MaxRegisters)
+            return expr;
+
+        return compiled;
+    }
+
+    void ExpressionCompiled::addDependencies(set<string>& deps, vector<string>* path) const {
+        _original->addDependencies(deps, path);
+    }
+
+    Value ExpressionCompiled::serialize(bool explain) const {
+        return _original->serialize(explain);
+    }
+
+    Value ExpressionCompiled::evaluateInternal(const Variables& vars) const {
+        Value registers[MaxRegisters];
+        Variables withRegisters(vars);
+        withRegisters.registers = registers;
+
+        const size_t n = _program.size();
+        for (size_t pc = 0; pc < n; ) {
+            const Instruction& instruction = _program[pc];
+            switch (instruction.op) {
+            case Instruction::EVAL:
+                registers[instruction.reg] = instruction.expr->evaluateInternal(withRegisters);
+                pc++;
+                break;
+            case Instruction::JUMP:
+                pc = instruction.target;
+                break;
+            case Instruction::JUMP_IF_FALSE:
+                pc = registers[instruction.reg].coerceToBool() ? pc + 1 : instruction.target;
+                break;
+            case Instruction::JUMP_IF_TRUE:
+                pc = registers[instruction.reg].coerceToBool() ? instruction.target : pc + 1;
+                break;
+            case Instruction::JUMP_IF_NOT_NULLISH:
+                pc = registers[instruction.reg].nullish() ? pc + 1 : instruction.target;
+                break;
+            }
+        }
+
+        return registers[_result];
+    }
+
     /* ------------------------- ExpressionConcat ----------------------------- */
 
     Value ExpressionConcat::evaluateInternal(const Variables& vars) const {
@@ -814,6 +1120,13 @@ namespace {
         return intrusive_ptr<Expression>(this);
     }
 
+    void ExpressionObject::compileFields() {
+        for (FieldMap::iterator it(_expressions.begin()); it!=_expressions.end(); ++it) {
+            if (it->second)
+                it->second = ExpressionCompiled::compile(it->second);
+        }
+    }
+
     bool ExpressionObject::isSimple() {
         for (FieldMap::iterator it(_expressions.begin()); it!=_expressions.end(); ++it) {
             if (it->second && !it->second->isSimple())
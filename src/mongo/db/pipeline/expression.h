@@ -47,17 +47,19 @@ namespace mongo {
     /// The state used as input to Expressions
     class Variables {
     public:
-        Variables() {}
+        Variables() : registers(NULL) {}
 
         explicit Variables(const Document& rootAndCurrent)
             : root(rootAndCurrent)
             , current(rootAndCurrent)
+            , registers(NULL)
         {}
 
         Variables(const Document& root, const Value& current, const Document& rest = Document())
             : root(root)
             , current(current)
             , rest(rest)
+            , registers(NULL)
         {}
 
         static void uassertValidNameForUserWrite(StringData varName);
@@ -66,6 +68,9 @@ namespace mongo {
         Value root;
         Value current;
         Document rest;
+
+        /// While an ExpressionCompiled runs, the registers its instructions read their operands from.
+        const Value* registers;
     };
 
     class Expression :
@@ -225,6 +230,9 @@ namespace mongo {
         ExpressionNary() {}
 
         ExpressionVector vpOperand;
+
+        // Flattens operator trees, replacing operands with the registers that hold them.
+        friend class ExpressionCompiled;
     };
 
     /// Inherit from ExpressionVariadic or ExpressionFixedArity instead of directly from this class.
@@ -342,6 +350,66 @@ namespace mongo {
     };
 
 
+    /**
+     * An Expression flattened into a sequence of instructions, each evaluating one operator of the
+     * original tree into a register. Operands are constants, field paths or the registers earlier
+     * instructions filled, so evaluating doesn't recurse through the operator tree. $cond, $ifNull,
+     * $and and $or become jumps, keeping their short-circuiting, and an operator that appears more
+     * than once outside of those is only evaluated once.
+     *
+     * Subtrees that can't be flattened ($let, $map, and operators that stop evaluating their
+     * operands early) are evaluated as before by the instruction using them.
+     */
+    class ExpressionCompiled : public Expression {
+    public:
+        // virtuals from Expression
+        virtual intrusive_ptr<Expression> optimize() { return this; }
+        virtual void addDependencies(set<string>& deps, vector<string>* path=NULL) const;
+        virtual Value serialize(bool explain) const;
+        virtual Value evaluateInternal(const Variables& vars) const;
+
+        /**
+         * Compiles an optimized expression. Returns expr itself if there is nothing to gain, and
+         * compiles the fields of an ExpressionObject in place.
+         */
+        static intrusive_ptr<Expression> compile(const intrusive_ptr<Expression>& expr);
+
+        /// The number of instructions, for tests.
+        size_t getProgramSize() const { return _program.size(); }
+
+    private:
+        explicit ExpressionCompiled(const intrusive_ptr<Expression>& original);
+
+        struct Instruction {
+            enum Op {
+                EVAL, // registers[reg] = expr->evaluateInternal()
+                JUMP, // continue at target
+                JUMP_IF_FALSE, // continue at target unless registers[reg].coerceToBool()
+                JUMP_IF_TRUE, // continue at target if registers[reg].coerceToBool()
+                JUMP_IF_NOT_NULLISH // continue at target unless registers[reg].nullish()
+            };
+
+            Instruction(Op op, int reg, const intrusive_ptr<Expression>& expr)
+                : op(op), reg(reg), target(0), expr(expr) {}
+
+            Op op;
+            int reg;
+            size_t target;
+            intrusive_ptr<Expression> expr;
+        };
+
+        // Registers live on the stack while evaluating, so programs needing more aren't compiled.
+        static const int MaxRegisters = 32;
+
+        class Compiler;
+
+        intrusive_ptr<Expression> _original; // what serialize() and addDependencies() report
+        vector<Instruction> _program;
+        int _numRegisters;
+        int _result; // the register holding the value of the whole expression
+    };
+
+
     class ExpressionConcat : public ExpressionVariadic<ExpressionConcat> {
     public:
         // virtuals from ExpressionNary
@@ -678,6 +746,9 @@ namespace mongo {
 
         void excludeId(bool b) { _excludeId = b; }
 
+        /// Replaces each computed field's expression with ExpressionCompiled::compile() of it.
+        void compileFields();
+
     private:
         ExpressionObject(bool atRoot);
 
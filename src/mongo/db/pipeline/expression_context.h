@@ -32,6 +32,7 @@
 
 #include "mongo/db/interrupt_status.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/intrusive_counter.h"
 
 namespace mongo {
@@ -42,6 +43,10 @@ namespace mongo {
             : inShard(false)
             , inRouter(false)
             , extSortAllowed(false)
+            , maxMemoryUsageBytes(100*1024*1024)
+            , memoryUsers(0)
+            , peakMemoryBytes(0)
+            , reportPeakMemoryBytes(NULL)
             , interruptStatus(status)
             , ns(ns)
         {}
@@ -52,10 +57,28 @@ namespace mongo {
             // The check could be expensive, at least in relative terms.
             RARELY interruptStatus.checkForInterrupt();
         }
+
+        /** The share of maxMemoryUsageBytes each stage that buffers its input may hold. */
+        size_t stageMemoryLimitBytes() const {
+            return maxMemoryUsageBytes / (memoryUsers > 0 ? memoryUsers : 1);
+        }
+
+        /** Called by stages that buffer their input with the bytes they hold now. */
+        void noteMemoryUsage(long long bytes) {
+            if (bytes > peakMemoryBytes) {
+                peakMemoryBytes = bytes;
+                if (reportPeakMemoryBytes)
+                    reportPeakMemoryBytes->store(bytes);
+            }
+        }
         
         bool inShard;
         bool inRouter;
         bool extSortAllowed;
+        size_t maxMemoryUsageBytes; // for the whole pipeline, split among the memoryUsers
+        int memoryUsers; // stages counted by Pipeline::stitch() as usesMemoryBudget()
+        long long peakMemoryBytes; // the most any one stage has held, from noteMemoryUsage()
+        AtomicInt64* reportPeakMemoryBytes; // if set, also kept at peakMemoryBytes, eg. for curop
         const InterruptStatus& interruptStatus;
         NamespaceString ns;
         std::string tempDir; // Defaults to empty to prevent external sorting in mongos.
@@ -142,9 +142,10 @@ namespace mongo {
                 continue;
             }
 
-            if (str::equals(pFieldName, "allowDiskUsage")) {
+            if (str::equals(pFieldName, "allowDiskUsage")
+                    || str::equals(pFieldName, "allowDiskUse")) {
                 uassert(16949,
-                        str::stream() << "allowDiskUsage must be a bool, not a "
+                        str::stream() << pFieldName << " must be a bool, not a "
                                       << typeName(cmdElement.type()),
                         cmdElement.type() == Bool);
                 pCtx->extSortAllowed = cmdElement.Bool();
@@ -203,6 +204,7 @@ namespace mongo {
 
         // The order in which optimizations are applied can have significant impact on the
         // efficiency of the final pipeline. Be Careful!
+        Optimizations::Local::moveMatchBeforeRenamingProject(pPipeline.get());
         Optimizations::Local::moveMatchBeforeSort(pPipeline.get());
         Optimizations::Local::moveLimitBeforeSkip(pPipeline.get());
         Optimizations::Local::coalesceAdjacent(pPipeline.get());
@@ -228,6 +230,28 @@ namespace mongo {
         }
     }
 
+    void Pipeline::Optimizations::Local::moveMatchBeforeRenamingProject(Pipeline* pipeline) {
+        SourceContainer& sources = pipeline->sources;
+        for (size_t srci = 1; srci < sources.size(); ++srci) {
+            DocumentSourceMatch* match = dynamic_cast<DocumentSourceMatch*>(sources[srci].get());
+            DocumentSourceProject* project =
+                dynamic_cast<DocumentSourceProject*>(sources[srci - 1].get());
+            if (!match || !project)
+                continue;
+
+            intrusive_ptr<DocumentSource> moved = match->beforeRenames(project->getRenames());
+            if (!moved)
+                continue;
+
+            sources[srci] = sources[srci - 1];
+            sources[srci - 1] = moved;
+
+            // look at the moved match again, in case another $project precedes it
+            if (srci >= 2)
+                srci -= 2;
+        }
+    }
+
     void Pipeline::Optimizations::Local::moveLimitBeforeSkip(Pipeline* pipeline) {
         SourceContainer& sources = pipeline->sources;
         if (sources.empty())
@@ -329,22 +353,34 @@ namespace mongo {
             if (str::equals(stage.firstElementFieldName(), "$out")) {
                 // TODO Figure out how to handle temp collection privileges. For now, using the
                 // output ns is ok since we only do db-level privilege checks.
-                NamespaceString outputNs(db, stage.firstElement().str());
+                BSONElement outSpec = stage.firstElement();
+                const bool merging = outSpec.type() == Object
+                                  && str::equals(outSpec.Obj()["mode"].valuestrsafe(), "merge");
+                NamespaceString outputNs(db, outSpec.type() == Object
+                                                ? outSpec.Obj()["to"].str()
+                                                : outSpec.str());
                 uassert(17139,
                         mongoutils::str::stream() << "Invalid $out target namespace, " <<
                         outputNs.ns(),
                         outputNs.isValid());
 
                 ActionSet actions;
-                // logically on output ns
-                actions.addAction(ActionType::remove);
-                actions.addAction(ActionType::insert);
-
-                // on temp ns due to implementation, but not logically on output ns
-                actions.addAction(ActionType::createCollection);
-                actions.addAction(ActionType::createIndex);
-                actions.addAction(ActionType::dropCollection);
-                actions.addAction(ActionType::renameCollectionSameDB);
+                if (merging) {
+                    // upserts straight into the output ns
+                    actions.addAction(ActionType::insert);
+                    actions.addAction(ActionType::update);
+                }
+                else {
+                    // logically on output ns
+                    actions.addAction(ActionType::remove);
+                    actions.addAction(ActionType::insert);
+
+                    // on temp ns due to implementation, but not logically on output ns
+                    actions.addAction(ActionType::createCollection);
+                    actions.addAction(ActionType::createIndex);
+                    actions.addAction(ActionType::dropCollection);
+                    actions.addAction(ActionType::renameCollectionSameDB);
+                }
 
                 out->push_back(Privilege(ResourcePattern::forExactNamespace(outputNs), actions));
                 out->push_back(Privilege(ResourcePattern::forExactNamespace(
@@ -437,6 +473,13 @@ namespace mongo {
         massert(16600, "should not have an empty pipeline",
                 !sources.empty());
 
+        // the stages that buffer their input split the pipeline's memory budget between them
+        pCtx->memoryUsers = 0;
+        for (SourceContainer::const_iterator it(sources.begin()); it != sources.end(); ++it) {
+            if ((*it)->usesMemoryBudget())
+                pCtx->memoryUsers++;
+        }
+
         /* chain together the sources we found */
         DocumentSource* prevSource = sources.front().get();
         for(SourceContainer::iterator iter(sources.begin() + 1),
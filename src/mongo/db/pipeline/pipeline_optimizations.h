@@ -51,6 +51,15 @@ namespace mongo {
          */
         static void moveMatchBeforeSort(Pipeline* pipeline);
 
+        /**
+         * Moves matches before any adjacent $project that only includes or renames the fields
+         * they read, rewriting them in terms of the fields before the $project.
+         *
+         * This lets a match that follows such a $project be pushed into the query, and so use
+         * indexes.
+         */
+        static void moveMatchBeforeRenamingProject(Pipeline* pipeline);
+
         /**
          * Moves limits before any adjacent skip phases.
          *
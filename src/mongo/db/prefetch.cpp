@@ -32,6 +32,7 @@
 
 #include "mongo/db/dbhelpers.h"
 #include "mongo/db/diskloc.h"
+#include "mongo/db/index/btree_access_method_internal.h"
 #include "mongo/db/index/index_access_method.h"
 #include "mongo/db/storage/index_details.h"
 #include "mongo/db/structure/collection.h"
@@ -57,8 +58,46 @@ namespace mongo {
                                                     "repl.preload.docs",
                                                     &prefetchDocStats );
 
+    bool PrefetchBatch::claim(const std::string& target) {
+        SimpleMutex::scoped_lock lk(_mutex);
+        return _claimed.insert(target).second;
+    }
+
+    // What PrefetchBatch tracks: a key in an index, or a document by _id in a collection.
+    static std::string prefetchTarget(const StringData& ns, const char* data, int size) {
+        std::string target = ns.toString();
+        target += '\0';
+        target.append(data, size);
+        return target;
+    }
+
+    // page in what lookups of obj's keys in one index need, less the keys already done for
+    // other ops of the batch
+    static void touchIndex(Collection* collection, int indexNo, const BSONObj& obj,
+                           PrefetchBatch* batch) {
+        IndexDescriptor* desc = collection->getIndexCatalog()->getDescriptor(indexNo);
+        verify( desc );
+        IndexAccessMethod* iam = collection->getIndexCatalog()->getIndex( desc );
+        verify( iam );
+        if ( !batch ) {
+            iam->touch(obj);
+            return;
+        }
+
+        // all access methods are btree based
+        BtreeBasedAccessMethod* btree = static_cast<BtreeBasedAccessMethod*>( iam );
+        BSONObjSet keys;
+        btree->getIndexedKeys(obj, &keys);
+        const string indexNs = desc->indexNamespace();
+        for (BSONObjSet::const_iterator i = keys.begin(); i != keys.end(); ++i) {
+            if (batch->claim(prefetchTarget(indexNs, i->objdata(), i->objsize()))) {
+                btree->touchKey(*i);
+            }
+        }
+    }
+
     // prefetch for an oplog operation
-    void prefetchPagesForReplicatedOp(const BSONObj& op) {
+    void prefetchPagesForReplicatedOp(const BSONObj& op, PrefetchBatch* batch) {
         const char *opField;
         const char *opType = op.getStringField("op");
         switch (*opType) {
@@ -104,7 +143,7 @@ namespace mongo {
         // a way to achieve that would be to prefetch the record first, and then afterwards do 
         // this part.
         //
-        prefetchIndexPages(collection, obj);
+        prefetchIndexPages(collection, obj, batch);
 
         // do not prefetch the data for inserts; it doesn't exist yet
         // 
@@ -116,13 +155,11 @@ namespace mongo {
             // do not prefetch the data for capped collections because
             // they typically do not have an _id index for findById() to use.
             !collection->details()->isCapped()) {
-            prefetchRecordPages(ns, obj);
+            prefetchRecordPages(ns, obj, batch);
         }
     }
 
-    void prefetchIndexPages(Collection* collection, const BSONObj& obj) {
-        DiskLoc unusedDl; // unused
-        BSONObjSet unusedKeys;
+    void prefetchIndexPages(Collection* collection, const BSONObj& obj, PrefetchBatch* batch) {
         ReplSetImpl::IndexPrefetchConfig prefetchConfig = theReplSet->getIndexPrefetchConfig();
 
         // do we want prefetchConfig to be (1) as-is, (2) for update ops only, or (3) configured per op type?  
@@ -139,11 +176,7 @@ namespace mongo {
             int indexNo = collection->details()->findIdIndex();
             if (indexNo == -1) return;
             try {
-                IndexDescriptor* desc = collection->getIndexCatalog()->getDescriptor(indexNo);
-                verify( desc );
-                IndexAccessMethod* iam = collection->getIndexCatalog()->getIndex( desc );
-                verify( iam );
-                iam->touch(obj);
+                touchIndex(collection, indexNo, obj, batch);
             }
             catch (const DBException& e) {
                 LOG(2) << "ignoring exception in prefetchIndexPages(): " << e.what() << endl;
@@ -159,16 +192,11 @@ namespace mongo {
                 TimerHolder timer( &prefetchIndexStats);
                 // This will page in all index pages for the given object.
                 try {
-                    IndexDescriptor* desc = collection->getIndexCatalog()->getDescriptor(indexNo);
-                    verify( desc );
-                    IndexAccessMethod* iam = collection->getIndexCatalog()->getIndex( desc );
-                    verify( iam );
-                    iam->touch(obj);
+                    touchIndex(collection, indexNo, obj, batch);
                 }
                 catch (const DBException& e) {
                     LOG(2) << "ignoring exception in prefetchIndexPages(): " << e.what() << endl;
                 }
-                unusedKeys.clear();
             }
             break;
         }
@@ -178,9 +206,12 @@ namespace mongo {
     }
 
 
-    void prefetchRecordPages(const char* ns, const BSONObj& obj) {
+    void prefetchRecordPages(const char* ns, const BSONObj& obj, PrefetchBatch* batch) {
         BSONElement _id;
         if( obj.getObjectID(_id) ) {
+            // several updates of one document in a batch only need to page it in once
+            if ( batch && !batch->claim(prefetchTarget(ns, _id.rawdata(), _id.size())) )
+                return;
             TimerHolder timer(&prefetchDocStats);
             BSONObjBuilder builder;
             builder.append(_id);
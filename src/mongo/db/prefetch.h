@@ -27,17 +27,40 @@
 */
 #pragma once
 
+#include <set>
+#include <string>
+
 #include "mongo/db/jsobj.h"
 #include "mongo/db/diskloc.h"
+#include "mongo/util/concurrency/mutex.h"
 
 namespace mongo {
     class Collection;
-    // page in both index and data pages for an op from the oplog
-    void prefetchPagesForReplicatedOp(const BSONObj& op);
+
+    /**
+     * The index keys and documents already paged in for one batch of oplog ops, so that ops on
+     * the same document, or with the same key in an index, only page it in once.  Shared by the
+     * prefetcher threads working on the batch.
+     */
+    class PrefetchBatch : boost::noncopyable {
+    public:
+        PrefetchBatch() : _mutex("PrefetchBatch") { }
+
+        /** @return true if 'target' hadn't been claimed yet in this batch; now it has. */
+        bool claim(const std::string& target);
+
+    private:
+        SimpleMutex _mutex;
+        std::set<std::string> _claimed;
+    };
+
+    // page in both index and data pages for an op from the oplog, skipping what other ops of
+    // 'batch', if given, have paged in already
+    void prefetchPagesForReplicatedOp(const BSONObj& op, PrefetchBatch* batch = NULL);
 
     // page in pages needed for all index lookups on a given object
-    void prefetchIndexPages(Collection *nsd, const BSONObj& obj);
+    void prefetchIndexPages(Collection *nsd, const BSONObj& obj, PrefetchBatch* batch = NULL);
 
     // page in the data pages for a record associated with an object
-    void prefetchRecordPages(const char *ns, const BSONObj& obj);
+    void prefetchRecordPages(const char *ns, const BSONObj& obj, PrefetchBatch* batch = NULL);
 }
@@ -36,6 +36,7 @@
 #include "mongo/db/query/explain_plan.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/qlog.h"
 #include "mongo/db/query/type_explain.h"
 
 namespace mongo {
@@ -47,17 +48,29 @@ namespace mongo {
         : _canonicalQuery(canonicalQuery),
           _cachedQuery(cached),
           _exec(new PlanExecutor(ws, root)),
-          _updatedCache(false) {
+          _updatedCache(false),
+          _evicted(false),
+          _numResults(0) {
     }
 
     CachedPlanRunner::~CachedPlanRunner() {
     }
 
+    // How many results we produce between checks of how our plan is doing.
+    static const size_t kResultsBetweenRegressionChecks = 1024;
+
     Runner::RunnerState CachedPlanRunner::getNext(BSONObj* objOut, DiskLoc* dlOut) {
         Runner::RunnerState state = _exec->getNext(objOut, dlOut);
         if (Runner::RUNNER_EOF == state && !_updatedCache) {
             updateCache();
         }
+        else if (Runner::RUNNER_ADVANCED == state && !_evicted
+                 && 0 == (++_numResults % kResultsBetweenRegressionChecks)) {
+            scoped_ptr<PlanStageStats> stats(_exec->getStats());
+            if (NULL != stats.get()) {
+                evictIfRegressed(*stats);
+            }
+        }
         return state;
     }
 
@@ -117,27 +130,39 @@ namespace mongo {
     void CachedPlanRunner::updateCache() {
         _updatedCache = true;
 
-        // We're done.  Update the cache.
+        // We're done running.  Update the cache.
+        auto_ptr<CachedSolutionFeedback> feedback(new CachedSolutionFeedback());
+        feedback->stats = _exec->getStats();
+        if (NULL == feedback->stats) { return; }
+
+        if (_evicted || evictIfRegressed(*feedback->stats)) { return; }
+
         PlanCache* cache = PlanCache::get(_canonicalQuery->ns());
 
         // TODO: Is this an error?
         if (NULL == cache) { return; }
 
-        // TODO: How do we decide this?
-        bool shouldRemovePlan = false;
+        cache->feedback(*_canonicalQuery, *_cachedQuery->solution, feedback.release());
+    }
 
-        if (shouldRemovePlan) {
-            if (!cache->remove(*_canonicalQuery, *_cachedQuery->solution)) {
-                warning() << "Cached plan runner couldn't remove plan from cache.  Maybe"
-                    " somebody else did already?";
-                return;
-            }
-        }
+    bool CachedPlanRunner::evictIfRegressed(const PlanStageStats& stats) {
+        if (!PlanCache::hasRegressed(*_cachedQuery, stats)) { return false; }
 
-        // We're done running.  Update cache.
-        auto_ptr<CachedSolutionFeedback> feedback(new CachedSolutionFeedback());
-        feedback->stats = _exec->getStats();
-        cache->feedback(*_canonicalQuery, *_cachedQuery->solution, feedback.release());
+        _evicted = true;
+
+        PlanCache* cache = PlanCache::get(_canonicalQuery->ns());
+        if (NULL == cache) { return true; }
+
+        QLOG() << "Cached plan regressed, evicting it: " << _cachedQuery->planShape
+               << " works " << stats.common.works << " advanced " << stats.common.advanced
+               << " score at selection " << _cachedQuery->scoreOfWinner << endl;
+
+        // The next query of this shape races its candidates again.
+        if (!cache->remove(*_canonicalQuery)) {
+            warning() << "Cached plan runner couldn't remove plan from cache.  Maybe"
+                " somebody else did already?";
+        }
+        return true;
     }
 
 } // namespace mongo
@@ -42,6 +42,7 @@ namespace mongo {
     class DiskLoc;
     class PlanExecutor;
     class PlanStage;
+    struct PlanStageStats;
     class TypeExplain;
     class WorkingSet;
 
@@ -88,12 +89,25 @@ namespace mongo {
     private:
         void updateCache();
 
+        /**
+         * Evicts our plan from the cache if it has done much worse than when it was picked.
+         * Returns true if it was evicted.
+         */
+        bool evictIfRegressed(const PlanStageStats& stats);
+
         boost::scoped_ptr<CanonicalQuery> _canonicalQuery;
         boost::scoped_ptr<CachedSolution> _cachedQuery;
         boost::scoped_ptr<PlanExecutor> _exec;
 
         // Have we updated the cache with our plan stats yet?
         bool _updatedCache;
+
+        // Did we evict our plan from the cache?
+        bool _evicted;
+
+        // How many results we've produced.  Plans are checked for regression every so often
+        // while running, so that a bad plan is evicted even if it doesn't run to EOF.
+        size_t _numResults;
     };
 
 }  // namespace mongo
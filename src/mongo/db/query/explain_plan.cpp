@@ -48,6 +48,56 @@ namespace mongo {
             }
         }
 
+        const char* stageTypeString(StageType stageType) {
+            switch (stageType) {
+            case STAGE_AND_HASH:          return "AND_HASH";
+            case STAGE_AND_SORTED:        return "AND_SORTED";
+            case STAGE_COLLSCAN:          return "COLLSCAN";
+            case STAGE_FETCH:             return "FETCH";
+            case STAGE_GEO_2D:            return "GEO_2D";
+            case STAGE_GEO_NEAR_2D:       return "GEO_NEAR_2D";
+            case STAGE_GEO_NEAR_2DSPHERE: return "GEO_NEAR_2DSPHERE";
+            case STAGE_IXSCAN:            return "IXSCAN";
+            case STAGE_LIMIT:             return "LIMIT";
+            case STAGE_OR:                return "OR";
+            case STAGE_PROJECTION:        return "PROJECTION";
+            case STAGE_SKIP:              return "SKIP";
+            case STAGE_SORT:              return "SORT";
+            case STAGE_SORT_MERGE:        return "SORT_MERGE";
+            case STAGE_TEXT:              return "TEXT";
+            default:                      return "UNKNOWN";
+            }
+        }
+
+    }
+
+    void statsToBSON(const PlanStageStats& stats, BSONObjBuilder* bob) {
+        const CommonStats& common = stats.common;
+        bob->append("type", stageTypeString(stats.stageType));
+        bob->appendNumber("works", static_cast<long long>(common.works));
+        bob->appendNumber("yields", static_cast<long long>(common.yields));
+        bob->appendNumber("unyields", static_cast<long long>(common.unyields));
+        bob->appendNumber("invalidates", static_cast<long long>(common.invalidates));
+        bob->appendNumber("advanced", static_cast<long long>(common.advanced));
+        bob->appendNumber("needTime", static_cast<long long>(common.needTime));
+        bob->appendNumber("needFetch", static_cast<long long>(common.needFetch));
+        bob->appendBool("isEOF", common.isEOF);
+        bob->appendNumber("executionTimeMicros",
+                          static_cast<long long>(common.executionTimeMicros));
+        bob->appendNumber("cpuTimeMicros", static_cast<long long>(common.cpuTimeMicros));
+        bob->appendNumber("majorFaults", static_cast<long long>(common.majorFaults));
+
+        if (stats.workingSetPeak > 0) {
+            bob->appendNumber("workingSetPeak", static_cast<long long>(stats.workingSetPeak));
+        }
+
+        BSONArrayBuilder childrenBob(bob->subarrayStart("children"));
+        for (size_t i = 0; i < stats.children.size(); ++i) {
+            BSONObjBuilder childBob(childrenBob.subobjStart());
+            statsToBSON(*stats.children[i], &childBob);
+            childBob.doneFast();
+        }
+        childrenBob.doneFast();
     }
 
     Status explainPlan(const PlanStageStats& stats, TypeExplain** explain, bool fullDetails) {
@@ -182,6 +232,10 @@ namespace mongo {
         // TODO: if we can get this from the runner, we can kill "detailed mode"
         if (fullDetails) {
             res->setNYields(root->common.yields);
+
+            BSONObjBuilder statsBob;
+            statsToBSON(*root, &statsBob);
+            res->setStats(statsBob.obj());
         }
 
         *explain = res.release();
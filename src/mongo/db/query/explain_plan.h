@@ -52,4 +52,12 @@ namespace mongo {
      */
     Status explainPlan(const PlanStageStats& stats, TypeExplain** explain, bool fullDetails);
 
+    /**
+     * Appends the 'stats' tree to 'bob': for each stage, its type, its CommonStats (including
+     * the timings, which are zero unless internalQueryExecStageTiming is set), and the stats of
+     * its children under 'children'.  This is the 'stats' field of a detailed explain, and what
+     * the profiler records as 'execStats'.
+     */
+    void statsToBSON(const PlanStageStats& stats, BSONObjBuilder* bob);
+
 } // namespace mongo
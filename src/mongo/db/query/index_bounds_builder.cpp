@@ -34,6 +34,7 @@
 #include "mongo/db/matcher/expression_geo.h"
 #include "mongo/db/query/indexability.h"
 #include "mongo/db/query/qlog.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/mongoutils/str.h"
 #include "third_party/s2/s2.h"
 #include "third_party/s2/s2cell.h"
@@ -41,9 +42,17 @@
 
 namespace mongo {
 
-    string IndexBoundsBuilder::simpleRegex(const char* regex, const char* flags, bool* exact) {
+    // The most intervals a case-insensitive regex prefix is spelled out into.  Each ASCII letter
+    // doubles them, so the prefix used is cut short after log2 of this many letters.
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryMaxCaseInsensitiveRegexIntervals, int, 64);
+
+    string IndexBoundsBuilder::simpleRegex(const char* regex, const char* flags, bool* exact,
+                                           bool* caseInsensitive) {
         string r = "";
         *exact = false;
+        if (NULL != caseInsensitive) {
+            *caseInsensitive = false;
+        }
 
         bool multilineOK;
         if ( regex[0] == '\\' && regex[1] == 'A') {
@@ -69,6 +78,11 @@ namespace mongo {
             case 'x': // extended
                 extended = true;
                 break;
+            case 'i': // case insensitive, if the caller spells out the cases
+                if (NULL == caseInsensitive)
+                    return r;
+                *caseInsensitive = true;
+                break;
             default:
                 return r; // cant use index
             }
@@ -389,8 +403,7 @@ namespace mongo {
                 verify(0);
             }
 
-            const S2Region& region = gme->getGeoQuery().getRegion();
-            ExpressionMapping::cover2dsphere(region, oilOut);
+            ExpressionMapping::cover2dsphere(gme->getGeoQuery(), oilOut);
             *exactOut = false;
         }
         else {
@@ -578,16 +591,24 @@ namespace mongo {
     void IndexBoundsBuilder::translateRegex(const RegexMatchExpression* rme,
                                             OrderedIntervalList* oilOut, bool* exact) {
 
-        const string start = simpleRegex(rme->getString().c_str(), rme->getFlags().c_str(), exact);
+        bool caseInsensitive;
+        const string start = simpleRegex(rme->getString().c_str(), rme->getFlags().c_str(), exact,
+                                         &caseInsensitive);
 
         // QLOG() << "regex bounds start is " << start << endl;
         // Note that 'exact' is set by simpleRegex above.
-        if (!start.empty()) {
+        size_t numIntervals = oilOut->intervals.size();
+        if (!start.empty() && caseInsensitive) {
+            translateCaseInsensitivePrefix(start, oilOut, exact);
+        }
+        else if (!start.empty()) {
             string end = start;
             end[end.size() - 1]++;
             oilOut->intervals.push_back(makeRangeInterval(start, end, true, false));
         }
-        else {
+
+        if (oilOut->intervals.size() == numIntervals) {
+            *exact = false;
             BSONObjBuilder bob;
             bob.appendMinForType("", String);
             bob.appendMaxForType("", String);
@@ -602,6 +623,49 @@ namespace mongo {
         oilOut->intervals.push_back(makePointInterval(bob.obj()));
     }
 
+    // static
+    void IndexBoundsBuilder::translateCaseInsensitivePrefix(const string& prefix,
+                                                            OrderedIntervalList* oil,
+                                                            bool* exact) {
+        // PCRE folds the case of ASCII characters only by table, so other spellings of them
+        // can't match.  A non-ASCII character could match several others; stop before it.
+        size_t maxIntervals = std::max(1, internalQueryMaxCaseInsensitiveRegexIntervals);
+        vector<string> spellings(1, string());
+        size_t used = 0;
+        for (; used < prefix.size(); ++used) {
+            unsigned char c = prefix[used];
+            if (c >= 0x80) { break; }
+            bool letter = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+            if (letter && spellings.size() * 2 > maxIntervals) { break; }
+
+            size_t n = spellings.size();
+            for (size_t i = 0; i < n; ++i) {
+                if (letter) {
+                    spellings.push_back(spellings[i] + static_cast<char>(c & ~0x20));
+                    spellings[i] += static_cast<char>(c | 0x20);
+                }
+                else {
+                    spellings[i] += static_cast<char>(c);
+                }
+            }
+        }
+
+        if (used < prefix.size()) {
+            *exact = false;
+        }
+        if (0 == used) {
+            return;
+        }
+
+        // Upper case sorts before lower case, but order the spellings as strings anyway.
+        std::sort(spellings.begin(), spellings.end());
+        for (size_t i = 0; i < spellings.size(); ++i) {
+            string end = spellings[i];
+            end[end.size() - 1]++;
+            oil->intervals.push_back(makeRangeInterval(spellings[i], end, true, false));
+        }
+    }
+
     // static
     void IndexBoundsBuilder::translateEquality(const BSONElement& data, bool isHashed,
                                                OrderedIntervalList* oil, bool* exact) {
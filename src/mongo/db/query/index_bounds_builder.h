@@ -110,14 +110,27 @@ namespace mongo {
          *  returns "" for complex regular expressions
          *
          *  used to optimize queries in some simple regex cases that start with '^'
+         *
+         *  If 'caseInsensitive' isn't NULL, the 'i' flag is allowed and *caseInsensitive says
+         *  whether it was given; the prefix returned is then as written in the regex.
          */
-        static string simpleRegex(const char* regex, const char* flags, bool* exact);
+        static string simpleRegex(const char* regex, const char* flags, bool* exact,
+                                  bool* caseInsensitive = NULL);
 
         static Interval allValues();
 
         static void translateRegex(const RegexMatchExpression* rme, OrderedIntervalList* oil,
                                    bool* exact);
 
+        /**
+         * Appends an interval for each spelling of 'prefix' with its ASCII letters in either
+         * case, in order.  Only as much of the prefix is used as keeps the intervals within
+         * internalQueryMaxCaseInsensitiveRegexIntervals and before any non-ASCII character,
+         * clearing *exact if it stops short.  Appends nothing if none of it can be used.
+         */
+        static void translateCaseInsensitivePrefix(const string& prefix,
+                                                   OrderedIntervalList* oil, bool* exact);
+
         static void translateEquality(const BSONElement& data, bool isHashed,
                                       OrderedIntervalList* oil, bool* exact);
 
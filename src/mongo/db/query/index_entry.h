@@ -35,18 +35,22 @@
 
 namespace mongo {
 
+    class MatchExpression;
+
     /**
      * This name sucks, but every name involving 'index' is used somewhere.
      */
     struct IndexEntry {
-        IndexEntry(const BSONObj& kp, bool mk, bool sp, const string& n)
-            : keyPattern(kp), multikey(mk), sparse(sp), name(n) { }
+        IndexEntry(const BSONObj& kp, bool mk, bool sp, const string& n,
+                   const MatchExpression* fe = NULL)
+            : keyPattern(kp), multikey(mk), sparse(sp), name(n), filterExpr(fe) { }
 
         IndexEntry(const IndexEntry& other) {
             keyPattern = other.keyPattern;
             multikey = other.multikey;
             sparse = other.sparse;
             name = other.name;
+            filterExpr = other.filterExpr;
         }
 
         BSONObj keyPattern;
@@ -57,6 +61,9 @@ namespace mongo {
 
         string name;
 
+        // If the index is partial, the filter its documents match.  Not owned.
+        const MatchExpression* filterExpr;
+
         std::string toString() const {
             stringstream ss;
             ss << keyPattern.toString();
@@ -66,6 +73,9 @@ namespace mongo {
             if (sparse) {
                 ss << " sparse";
             }
+            if (NULL != filterExpr) {
+                ss << " partial";
+            }
             return ss.str();
         }
     };
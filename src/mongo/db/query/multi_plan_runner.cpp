@@ -28,12 +28,15 @@
 
 #include "mongo/db/query/multi_plan_runner.h"
 
+#include <cstdlib>
+
 #include "mongo/db/diskloc.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/query/canonical_query.h"
 #include "mongo/db/query/explain_plan.h"
+#include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/plan_executor.h"
 #include "mongo/db/query/qlog.h"
 #include "mongo/db/query/query_solution.h"
@@ -43,7 +46,7 @@ namespace mongo {
 
     MultiPlanRunner::MultiPlanRunner(CanonicalQuery* query)
         : _killed(false), _failure(false), _failureCount(0), _policy(Runner::YIELD_MANUAL),
-          _query(query) { }
+          _raceCutShort(false), _query(query) { }
 
     MultiPlanRunner::~MultiPlanRunner() {
         for (size_t i = 0; i < _candidates.size(); ++i) {
@@ -213,7 +216,8 @@ namespace mongo {
 
         if (_failure || _killed) { return false; }
 
-        size_t bestChild = PlanRanker::pickBestPlan(_candidates, NULL);
+        auto_ptr<PlanRankingDecision> why(new PlanRankingDecision());
+        size_t bestChild = PlanRanker::pickBestPlan(_candidates, why.get());
 
         // Run the best plan.  Store it.
         _bestPlan.reset(new PlanExecutor(_candidates[bestChild].ws,
@@ -224,11 +228,14 @@ namespace mongo {
 
         QLOG() << "Winning solution:\n" << _bestSolution->toString() << endl;
 
-        // TODO:
-        // Store the choice we just made in the cache.
-        // QueryPlanCache* cache = PlanCache::get(somenamespace);
-        // cache->add(_query, *_candidates[bestChild]->solution, decision->bestPlanStats);
-        // delete decision;
+        // Store the choice we just made in the cache.  A race stopped after a handful of results
+        // says little about how the plans compare on the same query with another limit.
+        if (!_raceCutShort && PlanCache::shouldCacheQuery(*_query)) {
+            PlanCache* cache = PlanCache::get(_query->ns());
+            if (NULL != cache) {
+                cache->add(*_query, *_bestSolution, why.release());
+            }
+        }
 
         // Clear out the candidate plans, leaving only stats as we're all done w/them.
         for (size_t i = 0; i < _candidates.size(); ++i) {
@@ -256,6 +263,11 @@ namespace mongo {
     bool MultiPlanRunner::workAllPlans() {
         bool planHitEOF = false;
 
+        // There's no point in racing the candidates past the point where one of them has
+        // produced as many results as the client asked for.
+        const size_t numToReturn = std::abs(_query->getParsed().getNumToReturn());
+        bool planProducedEnough = false;
+
         for (size_t i = 0; i < _candidates.size(); ++i) {
             CandidatePlan& candidate = _candidates[i];
             if (candidate.failed) { continue; }
@@ -274,6 +286,12 @@ namespace mongo {
             if (PlanStage::ADVANCED == state) {
                 // Save result for later.
                 candidate.results.push_back(id);
+
+                // The losers are cancelled at the end of this round.
+                if (0 != numToReturn && candidate.results.size() >= numToReturn) {
+                    planProducedEnough = true;
+                    _raceCutShort = true;
+                }
             }
             else if (PlanStage::NEED_TIME == state) {
                 // Fall through to yield check at end of large conditional.
@@ -331,7 +349,7 @@ namespace mongo {
             }
         }
 
-        return !planHitEOF;
+        return !planHitEOF && !planProducedEnough;
     }
 
     void MultiPlanRunner::allPlansSaveState() {
@@ -104,7 +104,9 @@ namespace mongo {
 
     private:
         /**
-         * Have all our candidate plans do something.
+         * Have all our candidate plans do something.  Returns false once there's no more to
+         * learn from running them: one hit EOF or produced all the results asked for, or all
+         * failed.
          */
         bool workAllPlans();
         void allPlansSaveState();
@@ -129,6 +131,10 @@ namespace mongo {
         // PlanExecutor, we can set the right yielding policy on it.
         Runner::YieldPolicy _policy;
 
+        // Did a candidate produce all the results the query asked for before the competition
+        // was over?  If so the choice isn't cached.
+        bool _raceCutShort;
+
         // The winner of the plan competition...
         boost::scoped_ptr<PlanExecutor> _bestPlan;
 
@@ -31,9 +31,12 @@
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/commands.h"
+#include "mongo/db/exec/count_scan.h"
 #include "mongo/db/exec/filter.h"
 #include "mongo/db/exec/oplogstart.h"
+#include "mongo/db/catalog/index_catalog.h"
 #include "mongo/db/index/catalog_hack.h"
+#include "mongo/db/index/index_access_method.h"
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/keypattern.h"
 #include "mongo/db/kill_current_op.h"
@@ -43,6 +46,7 @@
 #include "mongo/db/query/canonical_query.h"
 #include "mongo/db/query/eof_runner.h"
 #include "mongo/db/query/internal_plans.h"
+#include "mongo/db/query/internal_runner.h"
 #include "mongo/db/query/multi_plan_runner.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/qlog.h"
@@ -54,6 +58,7 @@
 #include "mongo/db/repl/repl_reads_ok.h"
 #include "mongo/db/server_options.h"
 #include "mongo/db/server_parameters.h"
+#include "mongo/db/stats/query_shape_stats.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/db/structure/collection.h"
 #include "mongo/s/chunk_version.h"
@@ -153,6 +158,37 @@ namespace mongo {
         return true;
     }
 
+    /**
+     * The indices the planner may use for a query over 'collection', and the options to plan
+     * it with.
+     */
+    static void fillOutPlannerParams(Collection* collection, const CanonicalQuery& canonicalQuery,
+                                     vector<IndexEntry>* indices, size_t* options) {
+        NamespaceDetails* nsd = collection->details();
+        for (int i = 0; i < nsd->getCompletedIndexCount(); ++i) {
+            IndexDescriptor* desc = collection->getIndexCatalog()->getDescriptor( i );
+            const MatchExpression* filter =
+                collection->getIndexCatalog()->getIndex(desc)->getFilterExpression();
+            indices->push_back(IndexEntry(desc->keyPattern(), desc->isMultikey(),
+                                          desc->isSparse(), desc->indexName(), filter));
+        }
+
+        *options = QueryPlanner::DEFAULT;
+        if (storageGlobalParams.noTableScan) {
+            const string& ns = canonicalQuery.ns();
+            // There are certain cases where we ignore this restriction:
+            bool ignore = canonicalQuery.getQueryObj().isEmpty()
+                          || (string::npos != ns.find(".system."))
+                          || (0 == ns.find("local."));
+            if (!ignore) {
+                *options |= QueryPlanner::NO_TABLE_SCAN;
+            }
+        }
+        else {
+            *options |= QueryPlanner::INCLUDE_COLLSCAN;
+        }
+    }
+
     /**
      * For a given query, get a runner.  The runner could be a SingleSolutionRunner, a
      * CachedQueryRunner, or a MultiPlanRunner, depending on the cache/query solver/etc.
@@ -161,35 +197,15 @@ namespace mongo {
         verify(rawCanonicalQuery);
         auto_ptr<CanonicalQuery> canonicalQuery(rawCanonicalQuery);
 
-        // Try to look up a cached solution for the query.
-        // TODO: Can the cache have negative data about a solution?
-        PlanCache* localCache = PlanCache::get(canonicalQuery->ns());
-        if (NULL != localCache) {
-            CachedSolution* cs = localCache->get(*canonicalQuery);
-            if (NULL != cs) {
-                // We have a cached solution.  Hand the canonical query and cached solution off to
-                // the cached plan runner, which takes ownership of both.
-                WorkingSet* ws;
-                PlanStage* root;
-                verify(StageBuilder::build(*cs->solution, &root, &ws));
-                *out = new CachedPlanRunner(canonicalQuery.release(), cs, root, ws);
-                return Status::OK();
-            }
-        }
-
-        // No entry in cache for the query.  We have to solve the query ourself.
-
         // Get the indices that we could possibly use.
         Database* db = cc().database();
         verify( db );
         Collection* collection = db->getCollection( canonicalQuery->ns() );
         verify( collection );
 
-        NamespaceDetails* nsd = collection->details();
-
         // Tailable: If the query requests tailable the collection must be capped.
         if (canonicalQuery->getParsed().hasOption(QueryOption_CursorTailable)) {
-            if (!nsd->isCapped()) {
+            if (!collection->details()->isCapped()) {
                 return Status(ErrorCodes::BadValue,
                               "tailable cursor requested on non capped collection");
             }
@@ -204,28 +220,11 @@ namespace mongo {
             }
         }
 
-        // If it's not NULL, we may have indices.
         vector<IndexEntry> indices;
-        for (int i = 0; i < nsd->getCompletedIndexCount(); ++i) {
-            IndexDescriptor* desc = collection->getIndexCatalog()->getDescriptor( i );
-            indices.push_back(IndexEntry(desc->keyPattern(), desc->isMultikey(), desc->isSparse(), desc->indexName()));
-        }
+        size_t options;
+        fillOutPlannerParams(collection, *canonicalQuery, &indices, &options);
 
         vector<QuerySolution*> solutions;
-        size_t options = QueryPlanner::DEFAULT;
-        if (storageGlobalParams.noTableScan) {
-            const string& ns = canonicalQuery->ns();
-            // There are certain cases where we ignore this restriction:
-            bool ignore = canonicalQuery->getQueryObj().isEmpty()
-                          || (string::npos != ns.find(".system."))
-                          || (0 == ns.find("local."));
-            if (!ignore) {
-                options |= QueryPlanner::NO_TABLE_SCAN;
-            }
-        }
-        else {
-            options |= QueryPlanner::INCLUDE_COLLSCAN;
-        }
         QueryPlanner::plan(*canonicalQuery, indices, options, &solutions);
 
         /*
@@ -239,6 +238,43 @@ namespace mongo {
             return Status(ErrorCodes::BadValue, "No query solutions");
         }
 
+        // Try to look up a cached solution for the query.  The cache tells us which of the
+        // candidate solutions won the last plan competition for this query shape; if it's still
+        // among the candidates we run it directly rather than racing the candidates again.
+        if (solutions.size() > 1) {
+            PlanCache* planCache = collection->infoCache()->getPlanCache();
+            auto_ptr<CachedSolution> cs(planCache->get(*canonicalQuery));
+            if (NULL != cs.get()) {
+                size_t cachedIdx = solutions.size();
+                for (size_t i = 0; i < solutions.size(); ++i) {
+                    if (PlanCache::getPlanShape(*solutions[i]) == cs->planShape) {
+                        cachedIdx = i;
+                        break;
+                    }
+                }
+
+                if (cachedIdx < solutions.size()) {
+                    for (size_t i = 0; i < solutions.size(); ++i) {
+                        if (i != cachedIdx) { delete solutions[i]; }
+                    }
+                    cs->solution.reset(solutions[cachedIdx]);
+                    QLOG() << "Using cached solution:\n" << cs->solution->toString() << endl;
+
+                    // Hand the canonical query and cached solution off to the cached plan runner,
+                    // which takes ownership of both.
+                    WorkingSet* ws;
+                    PlanStage* root;
+                    verify(StageBuilder::build(*cs->solution, &root, &ws));
+                    *out = new CachedPlanRunner(canonicalQuery.release(), cs.release(), root, ws);
+                    return Status::OK();
+                }
+
+                // The cached plan isn't a candidate any more.  Drop the entry and race the
+                // candidates as if there were no entry.
+                planCache->remove(*canonicalQuery);
+            }
+        }
+
         if (1 == solutions.size()) {
             // Only one possible plan.  Run it.  Build the stages from the solution.
             WorkingSet* ws;
@@ -264,6 +300,92 @@ namespace mongo {
         }
     }
 
+    /**
+     * Returns the index scan of a solution whose results are exactly the keys within its bounds:
+     * an unfiltered Btree scan, under nothing but an unfiltered fetch, a skip and a limit.
+     * Returns NULL if there isn't one.
+     */
+    static const IndexScanNode* getExactIndexScan(const QuerySolutionNode* node) {
+        for (;;) {
+            if (STAGE_LIMIT == node->getType()) {
+                node = static_cast<const LimitNode*>(node)->child.get();
+            }
+            else if (STAGE_SKIP == node->getType()) {
+                node = static_cast<const SkipNode*>(node)->child.get();
+            }
+            else if (STAGE_FETCH == node->getType()) {
+                const FetchNode* fn = static_cast<const FetchNode*>(node);
+                if (NULL != fn->filter.get()) { return NULL; }
+                node = fn->child.get();
+            }
+            else {
+                break;
+            }
+        }
+
+        if (STAGE_IXSCAN != node->getType()) { return NULL; }
+        const IndexScanNode* isn = static_cast<const IndexScanNode*>(node);
+        if (NULL != isn->filter.get()) { return NULL; }
+        if (!CatalogHack::getAccessMethodName(isn->indexKeyPattern).empty()) { return NULL; }
+        return isn;
+    }
+
+    Status getRunnerCount(CanonicalQuery* rawCanonicalQuery, Runner** out, CountScan** countOut) {
+        verify(rawCanonicalQuery);
+        auto_ptr<CanonicalQuery> canonicalQuery(rawCanonicalQuery);
+        *countOut = NULL;
+
+        Database* db = cc().database();
+        verify( db );
+        Collection* collection = db->getCollection( canonicalQuery->ns() );
+        verify( collection );
+
+        vector<IndexEntry> indices;
+        size_t options;
+        fillOutPlannerParams(collection, *canonicalQuery, &indices, &options);
+
+        vector<QuerySolution*> solutions;
+        QueryPlanner::plan(*canonicalQuery, indices, options, &solutions);
+
+        const IndexScanNode* isn = NULL;
+        for (size_t i = 0; i < solutions.size() && NULL == isn; ++i) {
+            isn = getExactIndexScan(solutions[i]->root.get());
+        }
+
+        int idxNo = -1;
+        if (NULL != isn) {
+            idxNo = collection->details()->findIndexByKeyPattern(isn->indexKeyPattern);
+        }
+
+        if (-1 == idxNo) {
+            for (size_t i = 0; i < solutions.size(); ++i) {
+                delete solutions[i];
+            }
+            return getRunner(canonicalQuery.release(), out);
+        }
+
+        const LiteParsedQuery& pq = canonicalQuery->getParsed();
+        CountScanParams params;
+        params.descriptor = collection->getIndexCatalog()->getDescriptor(idxNo);
+        params.bounds = isn->bounds;
+        params.direction = isn->direction;
+        if (0 != pq.getNumToReturn() && !pq.wantMore()) {
+            params.limit = static_cast<long long>(pq.getSkip()) + pq.getNumToReturn();
+        }
+
+        for (size_t i = 0; i < solutions.size(); ++i) {
+            delete solutions[i];
+        }
+
+        QLOG() << "Counting keys of " << params.descriptor->indexName() << " within "
+               << params.bounds.toString() << endl;
+
+        CountScan* countScan = new CountScan(params);
+        *countOut = countScan;
+        *out = new InternalRunner(canonicalQuery->ns(), countScan, new WorkingSet());
+        return Status::OK();
+    }
+
     /**
      * Also called by db/ops/query.cpp.  This is the new getMore entry point.
      */
@@ -498,6 +620,12 @@ namespace mongo {
         // cq is in a consistent state.
         string cqStr = cq->toString();
 
+        // Same for the shape, which the query's execution statistics are aggregated under.
+        PlanCacheKey shape;
+        if (QueryShapeStats::global.enabled()) {
+            shape = PlanCache::getPlanCacheKey(*cq);
+        }
+
         // We'll now try to get the query runner that will execute this query for us. There
         // are a few cases in which we know upfront which runner we should get and, therefore,
         // we shortcut the selection process here.
@@ -726,6 +854,43 @@ namespace mongo {
             }
         }
 
+        // If the query is going to be profiled, record the per-stage stats of its plan.
+        if (!isExplain && curop.shouldDBProfile(curop.elapsedMillis())) {
+            TypeExplain* bareExplain;
+            if (runner->getExplainPlan(&bareExplain).isOK()) {
+                boost::scoped_ptr<TypeExplain> explain(bareExplain);
+                if (explain->isStatsSet()) {
+                    curop.debug().execStats = explain->getStats();
+                }
+            }
+        }
+
+        // Fold the query into the statistics of its shape.
+        if (!isExplain && !shape.empty()) {
+            QueryShapeStats::Execution execution;
+            execution.micros = curop.elapsedMicros();
+            execution.nReturned = numResults;
+            TypeExplain* bareExplain;
+            if (runner->getExplainPlan(&bareExplain).isOK()) {
+                boost::scoped_ptr<TypeExplain> explain(bareExplain);
+                if (explain->isNScannedObjectsSet()) {
+                    execution.docsExamined = explain->getNScannedObjects();
+                }
+                if (explain->isCursorSet()) {
+                    execution.plan = explain->getCursor();
+                }
+                // A collection scan's nscanned counts documents rather than keys.
+                if (explain->isNScannedSet() && execution.plan != "BasicCursor") {
+                    execution.keysExamined = explain->getNScanned();
+                }
+            }
+            QueryShapeStats::global.record(pq.ns(), shape,
+                                           BSON("filter" << pq.getFilter()
+                                                << "sort" << pq.getSort()
+                                                << "projection" << pq.getProj()),
+                                           execution);
+        }
+
         long long ccId = 0;
         if (saveClientCursor) {
             // We won't use the runner until it's getMore'd.
@@ -39,6 +39,8 @@
 
 namespace mongo {
 
+    class CountScan;
+
     /**
      * Get a runner for a query.  Takes ownership of rawCanonicalQuery.
      *
@@ -50,6 +52,16 @@ namespace mongo {
      */
     Status getRunner(CanonicalQuery* rawCanonicalQuery, Runner** out);
 
+    /**
+     * Get a runner for counting the results of a query, as getRunner() does.
+     *
+     * If a plan's index bounds capture the query exactly, the runner counts the keys within them
+     * and produces no results: *countOut is set to the CountScan stage doing it, which the runner
+     * owns, and the count (before the query's skip is taken off) is read from it once the runner
+     * is done.  Otherwise *countOut is NULL and the runner's results are to be counted.
+     */
+    Status getRunnerCount(CanonicalQuery* rawCanonicalQuery, Runner** out, CountScan** countOut);
+
     /**
      * A switch to choose between old Cursor-based code and new Runner-based code.
      */
@@ -30,6 +30,7 @@
 
 #include <string>
 #include <vector>
+#include "mongo/base/string_data.h"
 #include "mongo/platform/unordered_set.h"
 
 namespace mongo {
@@ -106,6 +107,14 @@ namespace mongo {
         // ...or you include other fields, which can be ordered.
         // UNITTEST 11738048
         vector<string> _includedFields;
+
+        // True if we include fields and none of them is dotted, in which case the names in
+        // _includedFields (_id too, if included) are also in _includedTopLevel.  The executor
+        // can then copy the elements it wants from the document in one pass.
+        bool _includeTopLevelOnly;
+
+        // Points into _includedFields.
+        unordered_set<StringData, StringData::Hasher> _includedTopLevel;
     };
 
 }  // namespace mongo
@@ -0,0 +1,364 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/query/plan_cache.h"
+
+#include "mongo/client/dbclientinterface.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/query/qlog.h"
+#include "mongo/db/server_parameters.h"
+
+namespace {
+
+    using namespace mongo;
+
+    /**
+     * Appends the shape of the match expression tree rooted at 'node' to 'sb'.  The values in
+     * the leaves are left out so that queries differing only by those values share a key.
+     */
+    void appendMatchShape(const MatchExpression* node, StringBuilder* sb) {
+        *sb << static_cast<int>(node->matchType());
+        if (!node->path().empty()) {
+            *sb << '[' << node->path() << ']';
+        }
+        if (node->numChildren() > 0) {
+            *sb << '(';
+            for (size_t i = 0; i < node->numChildren(); ++i) {
+                if (i > 0) { *sb << ','; }
+                appendMatchShape(node->getChild(i), sb);
+            }
+            *sb << ')';
+        }
+    }
+
+    void appendChildShapes(const vector<QuerySolutionNode*>& children, StringBuilder* sb);
+
+    /**
+     * Appends the shape of the solution tree rooted at 'node' to 'sb'.
+     */
+    void appendSolutionShape(const QuerySolutionNode* node, StringBuilder* sb) {
+        *sb << static_cast<int>(node->getType());
+
+        switch (node->getType()) {
+        case STAGE_AND_HASH:
+            appendChildShapes(static_cast<const AndHashNode*>(node)->children, sb);
+            break;
+        case STAGE_AND_SORTED:
+            appendChildShapes(static_cast<const AndSortedNode*>(node)->children, sb);
+            break;
+        case STAGE_COLLSCAN:
+            *sb << '[' << static_cast<const CollectionScanNode*>(node)->direction << ']';
+            break;
+        case STAGE_FETCH:
+            *sb << '(';
+            appendSolutionShape(static_cast<const FetchNode*>(node)->child.get(), sb);
+            *sb << ')';
+            break;
+        case STAGE_GEO_2D:
+            *sb << static_cast<const Geo2DNode*>(node)->indexKeyPattern.toString();
+            break;
+        case STAGE_GEO_NEAR_2D:
+            *sb << static_cast<const GeoNear2DNode*>(node)->indexKeyPattern.toString();
+            break;
+        case STAGE_GEO_NEAR_2DSPHERE:
+            *sb << static_cast<const GeoNear2DSphereNode*>(node)->indexKeyPattern.toString();
+            break;
+        case STAGE_IXSCAN: {
+            const IndexScanNode* isn = static_cast<const IndexScanNode*>(node);
+            *sb << isn->indexKeyPattern.toString() << '[' << isn->direction << ']';
+            break;
+        }
+        case STAGE_LIMIT:
+            *sb << '(';
+            appendSolutionShape(static_cast<const LimitNode*>(node)->child.get(), sb);
+            *sb << ')';
+            break;
+        case STAGE_OR:
+            appendChildShapes(static_cast<const OrNode*>(node)->children, sb);
+            break;
+        case STAGE_PROJECTION:
+            *sb << '(';
+            appendSolutionShape(static_cast<const ProjectionNode*>(node)->child.get(), sb);
+            *sb << ')';
+            break;
+        case STAGE_SKIP:
+            *sb << '(';
+            appendSolutionShape(static_cast<const SkipNode*>(node)->child.get(), sb);
+            *sb << ')';
+            break;
+        case STAGE_SORT: {
+            const SortNode* sn = static_cast<const SortNode*>(node);
+            *sb << sn->pattern.toString() << '(';
+            appendSolutionShape(sn->child.get(), sb);
+            *sb << ')';
+            break;
+        }
+        case STAGE_SORT_MERGE: {
+            const MergeSortNode* msn = static_cast<const MergeSortNode*>(node);
+            *sb << msn->sort.toString();
+            appendChildShapes(msn->children, sb);
+            break;
+        }
+        case STAGE_TEXT:
+            *sb << static_cast<const TextNode*>(node)->_indexKeyPattern.toString();
+            break;
+        default:
+            break;
+        }
+    }
+
+    void appendChildShapes(const vector<QuerySolutionNode*>& children, StringBuilder* sb) {
+        *sb << '(';
+        for (size_t i = 0; i < children.size(); ++i) {
+            if (i > 0) { *sb << ','; }
+            appendSolutionShape(children[i], sb);
+        }
+        *sb << ')';
+    }
+
+}  // namespace
+
+namespace mongo {
+
+    // How many query shapes we cache per collection.
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheSize, int, 5000);
+
+    // How many writes to a collection flush its plan cache.
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheWriteOpsBetweenFlush, int, 1000);
+
+    // A cached plan is evicted once its productivity drops below the productivity it won its
+    // plan competition with, divided by this.
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheEvictionRatio, double, 10.0);
+
+    // How much feedback we keep per cache entry.
+    static const size_t kMaxFeedback = 20;
+
+    PlanCache::PlanCacheEntry::~PlanCacheEntry() {
+        for (size_t i = 0; i < feedback.size(); ++i) {
+            delete feedback[i];
+        }
+    }
+
+    PlanCache::PlanCache() : _mutex("PlanCache"), _writeOperations(0) { }
+
+    PlanCache::~PlanCache() {
+        _clear_inlock();
+    }
+
+    // static
+    bool PlanCache::shouldCacheQuery(const CanonicalQuery& query) {
+        const LiteParsedQuery& pq = query.getParsed();
+        return pq.getHint().isEmpty()
+            && !pq.isSnapshot()
+            && pq.getMin().isEmpty()
+            && pq.getMax().isEmpty()
+            && !pq.hasOption(QueryOption_CursorTailable);
+    }
+
+    // static
+    PlanCacheKey PlanCache::getPlanCacheKey(const CanonicalQuery& query) {
+        StringBuilder sb;
+        appendMatchShape(query.root(), &sb);
+        sb << "|s" << query.getParsed().getSort().toString();
+        sb << "|p" << query.getParsed().getProj().toString();
+        return sb.str();
+    }
+
+    // static
+    std::string PlanCache::getPlanShape(const QuerySolution& solution) {
+        if (NULL == solution.root) {
+            return "";
+        }
+        StringBuilder sb;
+        appendSolutionShape(solution.root.get(), &sb);
+        return sb.str();
+    }
+
+    // static
+    bool PlanCache::hasRegressed(const CachedSolution& cs, const PlanStageStats& stats) {
+        if (0 == stats.common.works || stats.common.works < cs.statsOfWinner.works) {
+            return false;
+        }
+
+        // Scores start at 1.  The part above that is what measures productivity.
+        double productivityOfWinner = cs.scoreOfWinner - 1;
+        double productivity = PlanRanker::scoreTree(&stats) - 1;
+        return productivity * internalQueryCacheEvictionRatio < productivityOfWinner;
+    }
+
+    bool PlanCache::add(const CanonicalQuery& query, const QuerySolution& solution,
+                        PlanRankingDecision* why) {
+        auto_ptr<PlanRankingDecision> decision(why);
+
+        if (!shouldCacheQuery(query) || NULL == solution.root || internalQueryCacheSize <= 0) {
+            return false;
+        }
+
+        PlanCacheKey key = getPlanCacheKey(query);
+
+        scoped_lock lk(_mutex);
+        if (_entries.end() != _entries.find(key)) {
+            return false;
+        }
+
+        // Make room for the new entry.
+        while (!_lru.empty() && _lru.size() >= static_cast<size_t>(internalQueryCacheSize)) {
+            EntryMap::iterator victim = _entries.find(_lru.back());
+            verify(_entries.end() != victim);
+            delete victim->second;
+            _entries.erase(victim);
+            _lru.pop_back();
+        }
+
+        PlanCacheEntry* entry = new PlanCacheEntry();
+        entry->planShape = getPlanShape(solution);
+        entry->decision.reset(decision.release());
+        _lru.push_front(key);
+        entry->lruPosition = _lru.begin();
+        _entries[key] = entry;
+
+        QLOG() << "PlanCache: added " << key << " -> " << entry->planShape << endl;
+        return true;
+    }
+
+    CachedSolution* PlanCache::get(const CanonicalQuery& query) {
+        if (!shouldCacheQuery(query)) {
+            return NULL;
+        }
+
+        PlanCacheKey key = getPlanCacheKey(query);
+
+        scoped_lock lk(_mutex);
+        EntryMap::const_iterator it = _entries.find(key);
+        if (_entries.end() == it) {
+            return NULL;
+        }
+
+        PlanCacheEntry* entry = it->second;
+
+        // Move the entry to the front of the LRU list.
+        _lru.splice(_lru.begin(), _lru, entry->lruPosition);
+
+        CachedSolution* cs = new CachedSolution();
+        cs->key = key;
+        cs->planShape = entry->planShape;
+        if (NULL != entry->decision && NULL != entry->decision->statsOfWinner) {
+            cs->statsOfWinner = entry->decision->statsOfWinner->common;
+            cs->scoreOfWinner = entry->decision->scoreOfWinner;
+        }
+        return cs;
+    }
+
+    bool PlanCache::feedback(const CanonicalQuery& query, const QuerySolution& solution,
+                             CachedSolutionFeedback* feedback) {
+        auto_ptr<CachedSolutionFeedback> autoFeedback(feedback);
+
+        PlanCacheKey key = getPlanCacheKey(query);
+        std::string planShape = getPlanShape(solution);
+
+        scoped_lock lk(_mutex);
+        EntryMap::const_iterator it = _entries.find(key);
+        if (_entries.end() == it || it->second->planShape != planShape) {
+            return false;
+        }
+
+        PlanCacheEntry* entry = it->second;
+        if (entry->feedback.size() >= kMaxFeedback) {
+            delete entry->feedback.front();
+            entry->feedback.erase(entry->feedback.begin());
+        }
+        entry->feedback.push_back(autoFeedback.release());
+        return true;
+    }
+
+    bool PlanCache::remove(const CanonicalQuery& query) {
+        PlanCacheKey key = getPlanCacheKey(query);
+
+        scoped_lock lk(_mutex);
+        EntryMap::iterator it = _entries.find(key);
+        if (_entries.end() == it) {
+            return false;
+        }
+
+        _lru.erase(it->second->lruPosition);
+        delete it->second;
+        _entries.erase(it);
+        return true;
+    }
+
+    void PlanCache::clear() {
+        scoped_lock lk(_mutex);
+        _clear_inlock();
+    }
+
+    void PlanCache::_clear_inlock() {
+        for (EntryMap::iterator it = _entries.begin(); it != _entries.end(); ++it) {
+            delete it->second;
+        }
+        _entries.clear();
+        _lru.clear();
+        _writeOperations = 0;
+    }
+
+    void PlanCache::notifyOfWriteOp() {
+        scoped_lock lk(_mutex);
+        if (_entries.empty()) {
+            return;
+        }
+        if (++_writeOperations >= internalQueryCacheWriteOpsBetweenFlush) {
+            _clear_inlock();
+        }
+    }
+
+    void PlanCache::getEntries(std::vector<BSONObj>* out) const {
+        scoped_lock lk(_mutex);
+        for (std::list<PlanCacheKey>::const_iterator it = _lru.begin(); it != _lru.end(); ++it) {
+            EntryMap::const_iterator entryIt = _entries.find(*it);
+            verify(_entries.end() != entryIt);
+            const PlanCacheEntry* entry = entryIt->second;
+
+            BSONObjBuilder bob;
+            bob.append("shape", *it);
+            bob.append("plan", entry->planShape);
+            if (NULL != entry->decision && NULL != entry->decision->statsOfWinner) {
+                const CommonStats& common = entry->decision->statsOfWinner->common;
+                bob.appendNumber("works", static_cast<long long>(common.works));
+                bob.appendNumber("advanced", static_cast<long long>(common.advanced));
+                bob.append("score", entry->decision->scoreOfWinner);
+            }
+            bob.appendNumber("feedback", static_cast<long long>(entry->feedback.size()));
+            out->push_back(bob.obj());
+        }
+    }
+
+    size_t PlanCache::size() const {
+        scoped_lock lk(_mutex);
+        return _entries.size();
+    }
+
+}  // namespace mongo
@@ -28,86 +28,146 @@
 
 #pragma once
 
+#include <boost/scoped_ptr.hpp>
+#include <list>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
 #include "mongo/db/exec/plan_stats.h"
+#include "mongo/db/query/canonical_query.h"
 #include "mongo/db/query/plan_ranker.h"
 #include "mongo/db/query/query_solution.h"
+#include "mongo/platform/unordered_map.h"
+#include "mongo/util/concurrency/mutex.h"
 
 namespace mongo {
 
     /**
-     * TODO: Debug commands:
-     * 1. show canonical form of query
-     * 2. show plans generated for query without (and with) cache
-     * 3. print out cache.
-     * 4. clear all elements from cache / otherwise manipulate cache.
+     * The shape of a query: the structure of its predicate tree (match types and paths but not
+     * the values compared against), its sort, and its projection.  Queries of the same shape are
+     * answered by the same plan, so this is what the cache is keyed on.
      */
+    typedef std::string PlanCacheKey;
 
     /**
      * When the CachedPlanRunner runs a cached query, it can provide feedback to the cache.  This
      * feedback is available to anyone who retrieves that query in the future.
      */
     struct CachedSolutionFeedback {
+        CachedSolutionFeedback() : stats(NULL) { }
+        ~CachedSolutionFeedback() { delete stats; }
+
+        // Owned here.
         PlanStageStats* stats;
+
+    private:
+        MONGO_DISALLOW_COPYING(CachedSolutionFeedback);
     };
 
     /**
-     * A cached solution to a query.
+     * A cached solution to a query.  PlanCache::get hands out one of these for the caller to own.
+     *
+     * The cache doesn't store QuerySolutions, as index bounds depend on the values in the query.
+     * The caller re-plans the query and keeps the candidate whose plan shape (see
+     * PlanCache::getPlanShape) matches 'planShape', placing it in 'solution'.
      */
     struct CachedSolution {
-        ~CachedSolution() {
-            for (size_t i = 0; i < feedback.size(); ++i) {
-                delete feedback[i];
-            }
-        }
+        CachedSolution() : scoreOfWinner(0) { }
 
-        // The best solution for the CanonicalQuery.
-        scoped_ptr<QuerySolution> solution;
+        // The shape of the query this solution answers.
+        PlanCacheKey key;
+
+        // The shape of the winning plan.
+        std::string planShape;
 
-        // Why the best solution was picked.
-        scoped_ptr<PlanRankingDecision> decision;
+        // The stats of the winning plan's root at the time it was picked...
+        CommonStats statsOfWinner;
+
+        // ...and the score PlanRanker gave it.
+        double scoreOfWinner;
+
+        // The best solution for the CanonicalQuery.  Filled in by whoever re-plans the query.
+        scoped_ptr<QuerySolution> solution;
 
-        // Annotations from cached runs.
-        // TODO: How many of these do we really want to keep?
-        vector<CachedSolutionFeedback*> feedback;
     private:
         MONGO_DISALLOW_COPYING(CachedSolution);
     };
 
     /**
-     * Caches the best solution to a query.  Aside from the (CanonicalQuery -> QuerySolution)
+     * Caches the best solution to a query shape.  Aside from the (query shape -> plan shape)
      * mapping, the cache contains information on why that mapping was made, and statistics on the
      * cache entry's actual performance on subsequent runs.
+     *
+     * There is one PlanCache per collection, owned by its CollectionInfoCache.  Readers of the
+     * collection share it, so all methods are thread-safe.
+     *
+     * Entries are evicted in LRU order once the cache is full, and the whole cache is flushed
+     * after a number of writes to the collection, as the data distribution may have changed
+     * enough to make a different plan the winner.
      */
     class PlanCache {
+        MONGO_DISALLOW_COPYING(PlanCache);
     public:
+        PlanCache();
+        ~PlanCache();
+
+        /**
+         * Get the cache for the collection 'ns' in the current client's database, or NULL if
+         * there is no such collection.  The caller must hold a lock on the database and must not
+         * hold the returned cache across yields.
+         *
+         * Defined alongside CollectionInfoCache, which owns the cache.
+         */
+        static PlanCache* get(const string& ns);
+
+        /**
+         * Returns true if the winner of a plan competition for 'query' may be cached.  Queries
+         * that force a plan (hint, snapshot, tailable, min/max) are never cached.
+         */
+        static bool shouldCacheQuery(const CanonicalQuery& query);
+
+        /**
+         * Returns the shape of 'query'.  Queries differing only in the values they compare
+         * against map to the same key.
+         */
+        static PlanCacheKey getPlanCacheKey(const CanonicalQuery& query);
+
+        /**
+         * Returns a string identifying the access plan of 'solution': the tree of stage types
+         * and the indices and directions of any index scans, but not the index bounds.
+         */
+        static std::string getPlanShape(const QuerySolution& solution);
+
         /**
-         * Get the (global) cache for the provided namespace.  Must not be held across yields.
-         * As such, there is no locking required.
+         * Returns true if 'stats', collected from a run of the plan in 'cs', show the plan doing
+         * so much worse than when it won its plan competition that it should be evicted.  A plan
+         * picked on a skewed first run, or whose data has since changed distribution, is
+         * otherwise stuck in the cache until the next flush.
+         *
+         * A run that did less work than the competition did isn't judged.
          */
-        static PlanCache* get(const string& ns) { return NULL; }
+        static bool hasRegressed(const CachedSolution& cs, const PlanStageStats& stats);
 
         /**
          * Record 'solution' as the best plan for 'query' which was picked for reasons detailed in
          * 'why'.
          *
-         * Takes ownership of all arguments.
+         * Takes ownership of 'why'.
          *
          * If the mapping was added successfully, returns true.
-         * If the mapping already existed or some other error occurred, returns false;
+         * If the mapping already existed or the query isn't cacheable, returns false.
          */
-        bool add(CanonicalQuery* query, QuerySolution* solution, PlanRankingDecision* why) {
-            return false;
-        }
+        bool add(const CanonicalQuery& query, const QuerySolution& solution,
+                 PlanRankingDecision* why);
 
         /**
          * Look up the cached solution for the provided query.  If a cached solution exists, return
          * a copy of it which the caller then owns.  If no cached solution exists, returns NULL.
          *
-         * TODO: Allow querying for exact query and querying for the shape of the query.
+         * The returned CachedSolution has no QuerySolution; see CachedSolution.
          */
-        CachedSolution* get(const CanonicalQuery& query) {
-            return NULL;
-        }
+        CachedSolution* get(const CanonicalQuery& query);
 
         /**
          * When the CachedPlanRunner runs a plan out of the cache, we want to record data about the
@@ -117,17 +177,68 @@ namespace mongo {
          * false.  Otherwise, returns true.
          */
         bool feedback(const CanonicalQuery& query, const QuerySolution& solution,
-                      const CachedSolutionFeedback* feedback) {
-            return false;
-        }
+                      CachedSolutionFeedback* feedback);
 
         /**
-         * Remove the (query, solution) pair from our cache.  Returns true if the plan was removed,
-         * false if it wasn't found.
+         * Remove the entry for the shape of 'query' from our cache.  Returns true if the entry
+         * was removed, false if it wasn't found.
          */
-        bool remove(const CanonicalQuery& query, const QuerySolution& solution) {
-            return false;
-        }
+        bool remove(const CanonicalQuery& query);
+
+        /**
+         * Remove every entry from the cache.
+         */
+        void clear();
+
+        /**
+         * Called for every write to the collection.  Clears the cache once enough writes have
+         * happened since the last flush.
+         */
+        void notifyOfWriteOp();
+
+        /**
+         * Appends one object per cache entry, most recently used first, describing the query
+         * shape and the plan it maps to.
+         */
+        void getEntries(std::vector<BSONObj>* out) const;
+
+        size_t size() const;
+
+    private:
+        struct PlanCacheEntry {
+            PlanCacheEntry() { }
+            ~PlanCacheEntry();
+
+            std::string planShape;
+
+            // Why the plan in this entry was picked.
+            boost::scoped_ptr<PlanRankingDecision> decision;
+
+            // Annotations from cached runs, oldest first.
+            std::vector<CachedSolutionFeedback*> feedback;
+
+            // Where this entry's key lives in '_lru'.
+            std::list<PlanCacheKey>::iterator lruPosition;
+
+        private:
+            MONGO_DISALLOW_COPYING(PlanCacheEntry);
+        };
+
+        typedef unordered_map<PlanCacheKey, PlanCacheEntry*> EntryMap;
+
+        void _clear_inlock();
+
+        // Protects everything below.
+        mutable mongo::mutex _mutex;
+
+        // Owns the entries.
+        EntryMap _entries;
+
+        // Keys of '_entries', most recently used at the front.
+        std::list<PlanCacheKey> _lru;
+
+        // Writes to the collection since the cache was last flushed.
+        int _writeOperations;
     };
 
 }  // namespace mongo
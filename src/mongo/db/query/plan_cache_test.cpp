@@ -0,0 +1,241 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * This file contains tests for mongo/db/query/plan_cache.cpp
+ */
+
+#include "mongo/db/query/plan_cache.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/json.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/unittest/unittest.h"
+
+using namespace mongo;
+
+namespace {
+
+    static const char* ns = "somebogusns";
+
+    CanonicalQuery* canonicalize(const char* queryStr, const char* sortStr = "{}",
+                                 const char* projStr = "{}") {
+        CanonicalQuery* cq;
+        Status result = CanonicalQuery::canonicalize(ns, fromjson(queryStr), fromjson(sortStr),
+                                                     fromjson(projStr), &cq);
+        ASSERT_OK(result);
+        return cq;
+    }
+
+    QuerySolution* makeIndexedSolution(const BSONObj& keyPattern) {
+        IndexScanNode* isn = new IndexScanNode();
+        isn->indexKeyPattern = keyPattern;
+        isn->direction = 1;
+        FetchNode* fetch = new FetchNode();
+        fetch->child.reset(isn);
+        QuerySolution* soln = new QuerySolution();
+        soln->root.reset(fetch);
+        return soln;
+    }
+
+    void setServerParameter(const char* name, int value) {
+        ServerParameter* param = ServerParameterSet::getGlobal()->getMap().find(name)->second;
+        ASSERT_OK(param->set(BSON("" << value).firstElement()));
+    }
+
+    TEST(PlanCacheKeyTest, ValuesDontMatter) {
+        scoped_ptr<CanonicalQuery> first(canonicalize("{a: 1, b: {$gt: 5}}"));
+        scoped_ptr<CanonicalQuery> second(canonicalize("{a: 'foo', b: {$gt: 99}}"));
+        ASSERT_EQUALS(PlanCache::getPlanCacheKey(*first), PlanCache::getPlanCacheKey(*second));
+    }
+
+    TEST(PlanCacheKeyTest, PredicatesMatter) {
+        scoped_ptr<CanonicalQuery> first(canonicalize("{a: 1, b: {$gt: 5}}"));
+        scoped_ptr<CanonicalQuery> second(canonicalize("{a: 1, b: {$lt: 5}}"));
+        scoped_ptr<CanonicalQuery> third(canonicalize("{a: 1, c: {$gt: 5}}"));
+        ASSERT_NOT_EQUALS(PlanCache::getPlanCacheKey(*first), PlanCache::getPlanCacheKey(*second));
+        ASSERT_NOT_EQUALS(PlanCache::getPlanCacheKey(*first), PlanCache::getPlanCacheKey(*third));
+    }
+
+    TEST(PlanCacheKeyTest, SortAndProjectionMatter) {
+        scoped_ptr<CanonicalQuery> plain(canonicalize("{a: 1}"));
+        scoped_ptr<CanonicalQuery> sorted(canonicalize("{a: 1}", "{b: 1}"));
+        scoped_ptr<CanonicalQuery> projected(canonicalize("{a: 1}", "{}", "{b: 1}"));
+        ASSERT_NOT_EQUALS(PlanCache::getPlanCacheKey(*plain), PlanCache::getPlanCacheKey(*sorted));
+        ASSERT_NOT_EQUALS(PlanCache::getPlanCacheKey(*plain),
+                          PlanCache::getPlanCacheKey(*projected));
+    }
+
+    TEST(PlanCacheKeyTest, HintedQueriesAreNotCached) {
+        CanonicalQuery* cq;
+        ASSERT_OK(CanonicalQuery::canonicalize(ns, fromjson("{$query: {a: 1}, $hint: {a: 1}}"),
+                                               &cq));
+        scoped_ptr<CanonicalQuery> hinted(cq);
+        ASSERT_FALSE(PlanCache::shouldCacheQuery(*hinted));
+
+        scoped_ptr<CanonicalQuery> plain(canonicalize("{a: 1}"));
+        ASSERT_TRUE(PlanCache::shouldCacheQuery(*plain));
+    }
+
+    TEST(PlanCacheTest, AddGetRemove) {
+        PlanCache cache;
+        scoped_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+        scoped_ptr<QuerySolution> soln(makeIndexedSolution(BSON("a" << 1)));
+
+        ASSERT(NULL == cache.get(*cq));
+        ASSERT_TRUE(cache.add(*cq, *soln, new PlanRankingDecision()));
+        ASSERT_FALSE(cache.add(*cq, *soln, new PlanRankingDecision()));
+        ASSERT_EQUALS(1U, cache.size());
+
+        // A query of the same shape finds the entry.
+        scoped_ptr<CanonicalQuery> sameShape(canonicalize("{a: 7}"));
+        scoped_ptr<CachedSolution> cs(cache.get(*sameShape));
+        ASSERT(NULL != cs.get());
+        ASSERT_EQUALS(PlanCache::getPlanShape(*soln), cs->planShape);
+
+        ASSERT_TRUE(cache.remove(*sameShape));
+        ASSERT_FALSE(cache.remove(*cq));
+        ASSERT(NULL == cache.get(*cq));
+    }
+
+    TEST(PlanCacheTest, PlanShapeIgnoresBounds) {
+        scoped_ptr<QuerySolution> first(makeIndexedSolution(BSON("a" << 1)));
+        scoped_ptr<QuerySolution> second(makeIndexedSolution(BSON("a" << 1)));
+        scoped_ptr<QuerySolution> other(makeIndexedSolution(BSON("b" << 1)));
+        IndexScanNode* isn = static_cast<IndexScanNode*>(
+            static_cast<FetchNode*>(second->root.get())->child.get());
+        isn->bounds.isSimpleRange = true;
+        isn->bounds.startKey = BSON("" << 5);
+        isn->bounds.endKey = BSON("" << 5);
+
+        ASSERT_EQUALS(PlanCache::getPlanShape(*first), PlanCache::getPlanShape(*second));
+        ASSERT_NOT_EQUALS(PlanCache::getPlanShape(*first), PlanCache::getPlanShape(*other));
+    }
+
+    TEST(PlanCacheTest, EvictsLeastRecentlyUsed) {
+        setServerParameter("internalQueryCacheSize", 2);
+
+        PlanCache cache;
+        scoped_ptr<CanonicalQuery> a(canonicalize("{a: 1}"));
+        scoped_ptr<CanonicalQuery> b(canonicalize("{b: 1}"));
+        scoped_ptr<CanonicalQuery> c(canonicalize("{c: 1}"));
+        scoped_ptr<QuerySolution> soln(makeIndexedSolution(BSON("a" << 1)));
+
+        ASSERT_TRUE(cache.add(*a, *soln, new PlanRankingDecision()));
+        ASSERT_TRUE(cache.add(*b, *soln, new PlanRankingDecision()));
+
+        // Touch 'a' so that 'b' is the least recently used entry.
+        delete cache.get(*a);
+        ASSERT_TRUE(cache.add(*c, *soln, new PlanRankingDecision()));
+
+        ASSERT_EQUALS(2U, cache.size());
+        scoped_ptr<CachedSolution> csA(cache.get(*a));
+        scoped_ptr<CachedSolution> csB(cache.get(*b));
+        scoped_ptr<CachedSolution> csC(cache.get(*c));
+        ASSERT(NULL != csA.get());
+        ASSERT(NULL == csB.get());
+        ASSERT(NULL != csC.get());
+
+        setServerParameter("internalQueryCacheSize", 5000);
+    }
+
+    TEST(PlanCacheTest, FlushedByWrites) {
+        setServerParameter("internalQueryCacheWriteOpsBetweenFlush", 3);
+
+        PlanCache cache;
+        scoped_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+        scoped_ptr<QuerySolution> soln(makeIndexedSolution(BSON("a" << 1)));
+        ASSERT_TRUE(cache.add(*cq, *soln, new PlanRankingDecision()));
+
+        cache.notifyOfWriteOp();
+        cache.notifyOfWriteOp();
+        ASSERT_EQUALS(1U, cache.size());
+        cache.notifyOfWriteOp();
+        ASSERT_EQUALS(0U, cache.size());
+
+        setServerParameter("internalQueryCacheWriteOpsBetweenFlush", 1000);
+    }
+
+    TEST(PlanCacheTest, FeedbackRequiresMatchingPlan) {
+        PlanCache cache;
+        scoped_ptr<CanonicalQuery> cq(canonicalize("{a: 1, b: 1}"));
+        scoped_ptr<QuerySolution> cached(makeIndexedSolution(BSON("a" << 1)));
+        scoped_ptr<QuerySolution> other(makeIndexedSolution(BSON("b" << 1)));
+        ASSERT_TRUE(cache.add(*cq, *cached, new PlanRankingDecision()));
+
+        ASSERT_TRUE(cache.feedback(*cq, *cached, new CachedSolutionFeedback()));
+        ASSERT_FALSE(cache.feedback(*cq, *other, new CachedSolutionFeedback()));
+    }
+
+    PlanStageStats* makeStats(uint64_t works, uint64_t advanced) {
+        CommonStats common;
+        common.works = works;
+        common.advanced = advanced;
+        return new PlanStageStats(common, STAGE_FETCH);
+    }
+
+    TEST(PlanCacheTest, RegressedPlansAreDetected) {
+        // Won with one result for every two works.
+        CachedSolution cs;
+        cs.statsOfWinner.works = 100;
+        cs.statsOfWinner.advanced = 50;
+        scoped_ptr<PlanStageStats> winnerStats(makeStats(100, 50));
+        cs.scoreOfWinner = PlanRanker::scoreTree(winnerStats.get());
+
+        // Doing about as well, or somewhat worse, is fine.
+        scoped_ptr<PlanStageStats> same(makeStats(1000, 500));
+        ASSERT_FALSE(PlanCache::hasRegressed(cs, *same));
+        scoped_ptr<PlanStageStats> worse(makeStats(1000, 100));
+        ASSERT_FALSE(PlanCache::hasRegressed(cs, *worse));
+
+        // One result for every thousand works is not.
+        scoped_ptr<PlanStageStats> regressed(makeStats(10000, 10));
+        ASSERT_TRUE(PlanCache::hasRegressed(cs, *regressed));
+
+        // Runs with less work than the competition did aren't judged.
+        scoped_ptr<PlanStageStats> shortRun(makeStats(50, 0));
+        ASSERT_FALSE(PlanCache::hasRegressed(cs, *shortRun));
+    }
+
+    TEST(PlanCacheTest, GetReturnsScoreOfWinner) {
+        PlanCache cache;
+        scoped_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+        scoped_ptr<QuerySolution> soln(makeIndexedSolution(BSON("a" << 1)));
+
+        PlanRankingDecision* why = new PlanRankingDecision();
+        why->statsOfWinner = makeStats(100, 50);
+        why->scoreOfWinner = 1.5;
+        ASSERT_TRUE(cache.add(*cq, *soln, why));
+
+        scoped_ptr<CachedSolution> cs(cache.get(*cq));
+        ASSERT(NULL != cs.get());
+        ASSERT_EQUALS(1.5, cs->scoreOfWinner);
+        ASSERT_EQUALS(100U, cs->statsOfWinner.works);
+    }
+
+}  // namespace
@@ -21,9 +21,13 @@
 #include "mongo/db/query/indexability.h"
 #include "mongo/db/query/index_tag.h"
 #include "mongo/db/query/qlog.h"
+#include "mongo/db/server_parameters.h"
 
 namespace mongo {
 
+    // Whether we enumerate plans that intersect the results of two index scans.
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerEnableIndexIntersection, bool, true);
+
     PlanEnumerator::PlanEnumerator(MatchExpression* root, const vector<IndexEntry>* indices)
         : _root(root), _indices(indices) { }
 
@@ -82,6 +86,9 @@ namespace mongo {
             else if (AndAssignment::PRED_CHOICES == newAnd->state) {
                 ss << "pred_choices";
             }
+            else if (AndAssignment::INTERSECTIONS == newAnd->state) {
+                ss << "intersections";
+            }
             else {
                 verify(AndAssignment::SUBNODES == newAnd->state);
                 ss << "subnodes";
@@ -102,6 +109,11 @@ namespace mongo {
                     ss << "\t" << oie.preds[j]->toString();
                 }
             }
+            for (size_t i = 0; i < newAnd->intersections.size(); ++i) {
+                ss << "intersect idx " << newAnd->predChoices[newAnd->intersections[i].first].index
+                   << " with idx " << newAnd->predChoices[newAnd->intersections[i].second].index
+                   << "\n";
+            }
             return ss.str();
         }
         else {
@@ -323,6 +335,21 @@ namespace mongo {
                 }
             }
 
+            // Two btree indices over disjoint predicates can be used together by intersecting
+            // the results of their scans.  Within an array operator the predicates apply to array
+            // elements rather than to the document, so we only do this for a plain AND.
+            if (internalQueryPlannerEnableIndexIntersection
+                && MatchExpression::AND == node->matchType()) {
+                const vector<OneIndexAssignment>& choices = newAndAssignment->predChoices;
+                for (size_t i = 0; i < choices.size(); ++i) {
+                    for (size_t j = i + 1; j < choices.size(); ++j) {
+                        if (canIntersect(choices[i], choices[j])) {
+                            newAndAssignment->intersections.push_back(make_pair(i, j));
+                        }
+                    }
+                }
+            }
+
             newAndAssignment->resetEnumeration();
 
             size_t myMemoID;
@@ -337,6 +364,35 @@ namespace mongo {
         return false;
     }
 
+    bool PlanEnumerator::canIntersect(const OneIndexAssignment& first,
+                                      const OneIndexAssignment& second) {
+        // Only intersect btree scans; geo and text stages don't produce plain index keys.
+        const IndexID indices[] = { first.index, second.index };
+        for (size_t i = 0; i < 2; ++i) {
+            BSONObjIterator kpIt((*_indices)[indices[i]].keyPattern);
+            while (kpIt.more()) {
+                if (!kpIt.next().isNumber()) { return false; }
+            }
+        }
+
+        // A predicate can only be tagged with one index.
+        for (size_t i = 0; i < first.preds.size(); ++i) {
+            for (size_t j = 0; j < second.preds.size(); ++j) {
+                if (first.preds[i] == second.preds[j]) { return false; }
+            }
+        }
+        return true;
+    }
+
+    // static
+    void PlanEnumerator::tagOneIndexAssignment(const OneIndexAssignment& assign) {
+        for (size_t i = 0; i < assign.preds.size(); ++i) {
+            MatchExpression* pred = assign.preds[i];
+            verify(NULL == pred->getTag());
+            pred->setTag(new IndexTag(assign.index, assign.positions[i]));
+        }
+    }
+
     void PlanEnumerator::tagMemo(size_t id) {
         QLOG() << "Tagging memoID " << id << endl;
         NodeAssignment* assign = _memo[id];
@@ -359,21 +415,16 @@ namespace mongo {
 
             if (AndAssignment::MANDATORY == aa->state) {
                 verify(aa->counter < aa->mandatory.size());
-                const OneIndexAssignment& assign = aa->mandatory[aa->counter];
-                for (size_t i = 0; i < assign.preds.size(); ++i) {
-                    MatchExpression* pred = assign.preds[i];
-                    verify(NULL == pred->getTag());
-                    pred->setTag(new IndexTag(assign.index, assign.positions[i]));
-                }
+                tagOneIndexAssignment(aa->mandatory[aa->counter]);
             }
             else if (AndAssignment::PRED_CHOICES == aa->state) {
                 verify(aa->counter < aa->predChoices.size());
-                const OneIndexAssignment& assign = aa->predChoices[aa->counter];
-                for (size_t i = 0; i < assign.preds.size(); ++i) {
-                    MatchExpression* pred = assign.preds[i];
-                    verify(NULL == pred->getTag());
-                    pred->setTag(new IndexTag(assign.index, assign.positions[i]));
-                }
+                tagOneIndexAssignment(aa->predChoices[aa->counter]);
+            }
+            else if (AndAssignment::INTERSECTIONS == aa->state) {
+                verify(aa->counter < aa->intersections.size());
+                tagOneIndexAssignment(aa->predChoices[aa->intersections[aa->counter].first]);
+                tagOneIndexAssignment(aa->predChoices[aa->intersections[aa->counter].second]);
             }
             else {
                 verify(AndAssignment::SUBNODES == aa->state);
@@ -441,7 +492,14 @@ namespace mongo {
                     return false;
                 }
 
-                // We (may) move to outputting PRED_CHOICES.
+                // Next output comes from the 0-th intersection, if there are any.
+                if (aa->intersections.size() > 0) {
+                    aa->counter = 0;
+                    aa->state = AndAssignment::INTERSECTIONS;
+                    return false;
+                }
+
+                // We (may) move to outputting SUBNODES.
                 if (0 == aa->subnodes.size()) {
                     aa->resetEnumeration();
                     return true;
@@ -454,6 +512,25 @@ namespace mongo {
                 }
             }
 
+            if (AndAssignment::INTERSECTIONS == aa->state) {
+                ++aa->counter;
+
+                // Still have an intersection to output.
+                if (aa->counter < aa->intersections.size()) {
+                    return false;
+                }
+
+                if (0 == aa->subnodes.size()) {
+                    aa->resetEnumeration();
+                    return true;
+                }
+                else {
+                    aa->counter = 0;
+                    aa->state = AndAssignment::SUBNODES;
+                    return false;
+                }
+            }
+
             verify(AndAssignment::SUBNODES == aa->state);
             verify(aa->subnodes.size() > 0);
             verify(aa->counter < aa->subnodes.size());
@@ -179,6 +179,8 @@ namespace mongo {
                 // Then this
                 PRED_CHOICES,
                 // Then this
+                INTERSECTIONS,
+                // Then this
                 SUBNODES,
                 // Then we have a carry and back to MANDATORY.
             };
@@ -189,6 +191,9 @@ namespace mongo {
             vector<OneIndexAssignment> mandatory;
             // TODO: We really want to consider the power set of the union of predChoices, subnodes.
             vector<OneIndexAssignment> predChoices;
+            // Pairs of predChoices (by position) that can be used together and have their results
+            // intersected.  The two choices in a pair share no predicates.
+            vector<pair<size_t, size_t> > intersections;
             vector<MemoID> subnodes;
 
             // In the simplest case, an AndAssignment picks indices like a PredicateAssignment.  To
@@ -223,9 +228,10 @@ namespace mongo {
             // If there are any mandatory indices, we assign them one at a time.  After we have
             // assigned all of them, we stop assigning indices.
             //
-            // Otherwise: We assign each index in predChoice.  When those are exhausted, we have
-            // each subtree enumerate its choices one at a time.  When the last subtree has
-            // enumerated its last choices, we are done.
+            // Otherwise: We assign each index in predChoice.  When those are exhausted, we assign
+            // each pair of indices in 'intersections', so that the planner intersects the results
+            // of the two scans.  Then we have each subtree enumerate its choices one at a time.
+            // When the last subtree has enumerated its last choices, we are done.
             //
             void resetEnumeration() {
                 if (mandatory.size() > 0) {
@@ -256,6 +262,17 @@ namespace mongo {
             string toString() const;
         };
 
+        /**
+         * Returns true if the index scans for 'first' and 'second' can be intersected: both
+         * indices are btrees and no predicate is in both assignments.
+         */
+        bool canIntersect(const OneIndexAssignment& first, const OneIndexAssignment& second);
+
+        /**
+         * Tags each predicate of 'assign' with its index and position in that index.
+         */
+        static void tagOneIndexAssignment(const OneIndexAssignment& assign);
+
         /**
          * Allocates a NodeAssignment and associates it with the provided 'expr'.
          *
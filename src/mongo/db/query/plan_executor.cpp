@@ -28,14 +28,20 @@
 
 #include "mongo/db/query/plan_executor.h"
 
+#include <algorithm>
+
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/db/server_parameters.h"
 
 namespace mongo {
 
+    // How many units of work the plan is asked for at a time.
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecBatchSize, int, 64);
+
     PlanExecutor::PlanExecutor(WorkingSet* ws, PlanStage* rt)
         : _workingSet(ws) , _root(rt) , _killed(false) {
     }
@@ -48,7 +54,9 @@ namespace mongo {
     }
 
     PlanStageStats* PlanExecutor::getStats() const {
-        return _root->getStats();
+        PlanStageStats* stats = _root->getStats();
+        stats->workingSetPeak = _workingSet->getPeakSize();
+        return stats;
     }
 
     void PlanExecutor::saveState() {
@@ -63,7 +71,19 @@ namespace mongo {
     }
 
     void PlanExecutor::invalidate(const DiskLoc& dl) {
-        if (!_killed) { _root->invalidate(dl); }
+        if (_killed) { return; }
+
+        _root->invalidate(dl);
+
+        // Results we haven't returned yet may refer to the DiskLoc too.  Fetch them now, as the
+        // stages do for results they're holding on to.
+        for (deque<WorkingSetID>::const_iterator it = _results.begin(); it != _results.end();
+             ++it) {
+            WorkingSetMember* member = _workingSet->get(*it);
+            if (member->hasLoc() && member->loc == dl) {
+                WorkingSetCommon::fetchAndInvalidateLoc(member);
+            }
+        }
     }
 
     void PlanExecutor::setYieldPolicy(Runner::YieldPolicy policy) {
@@ -79,6 +99,12 @@ namespace mongo {
         if (_killed) { return Runner::RUNNER_DEAD; }
 
         for (;;) {
+            if (!_results.empty()) {
+                WorkingSetID id = _results.front();
+                _results.pop_front();
+                return returnResult(id, objOut, dlOut);
+            }
+
             // Yield, if we can yield ourselves.
             if (NULL != _yieldPolicy.get() && _yieldPolicy->shouldYield()) {
                 saveState();
@@ -87,47 +113,23 @@ namespace mongo {
                 restoreState();
             }
 
-            WorkingSetID id;
-            PlanStage::StageState code = _root->work(&id);
-
-            if (PlanStage::ADVANCED == code) {
-                WorkingSetMember* member = _workingSet->get(id);
-
-                if (NULL != objOut) {
-                    if (WorkingSetMember::LOC_AND_IDX == member->state) {
-                        if (1 != member->keyData.size()) {
-                            _workingSet->free(id);
-                            return Runner::RUNNER_ERROR;
-                        }
-                        *objOut = member->keyData[0].keyData;
-                    }
-                    else if (member->hasObj()) {
-                        *objOut = member->obj;
-                    }
-                    else {
-                        _workingSet->free(id);
-                        return Runner::RUNNER_ERROR;
-                    }
-                }
+            size_t batchSize = std::max(1, internalQueryExecBatchSize);
+            vector<WorkingSetID> ids;
+            PlanStage::StageState code = _root->workBatch(batchSize, &ids);
 
-                if (NULL != dlOut) {
-                    if (member->hasLoc()) {
-                        *dlOut = member->loc;
-                    }
-                    else {
-                        _workingSet->free(id);
-                        return Runner::RUNNER_ERROR;
-                    }
-                }
-                _workingSet->free(id);
-                return Runner::RUNNER_ADVANCED;
+            WorkingSetID fetchId = WorkingSet::INVALID_ID;
+            if (PlanStage::NEED_FETCH == code) {
+                fetchId = ids.back();
+                ids.pop_back();
             }
-            else if (PlanStage::NEED_TIME == code) {
-                // Fall through to yield check at end of large conditional.
+            _results.insert(_results.end(), ids.begin(), ids.end());
+
+            if (PlanStage::ADVANCED == code || PlanStage::NEED_TIME == code) {
+                // Return what we have, if anything, or keep working.
             }
             else if (PlanStage::NEED_FETCH == code) {
-                // id has a loc and refers to an obj we need to fetch.
-                WorkingSetMember* member = _workingSet->get(id);
+                // fetchId has a loc and refers to an obj we need to fetch.
+                WorkingSetMember* member = _workingSet->get(fetchId);
 
                 // This must be true for somebody to request a fetch and can only change when an
                 // invalidation happens, which is when we give up a lock.  Don't give up the
@@ -157,23 +159,67 @@ namespace mongo {
                     }
                 }
 
-                // Note that we're not freeing id.  Fetch semantics say that we shouldn't.
+                // Note that we're not freeing fetchId.  Fetch semantics say that we shouldn't.
             }
             else if (PlanStage::IS_EOF == code) {
-                return Runner::RUNNER_EOF;
+                if (_results.empty()) { return Runner::RUNNER_EOF; }
             }
             else if (PlanStage::DEAD == code) {
+                freeResults();
                 return Runner::RUNNER_DEAD;
             }
             else {
                 verify(PlanStage::FAILURE == code);
+                freeResults();
+                return Runner::RUNNER_ERROR;
+            }
+        }
+    }
+
+    Runner::RunnerState PlanExecutor::returnResult(WorkingSetID id, BSONObj* objOut,
+                                                   DiskLoc* dlOut) {
+        WorkingSetMember* member = _workingSet->get(id);
+
+        if (NULL != objOut) {
+            if (WorkingSetMember::LOC_AND_IDX == member->state) {
+                if (1 != member->keyData.size()) {
+                    _workingSet->free(id);
+                    return Runner::RUNNER_ERROR;
+                }
+                *objOut = member->keyData[0].keyData;
+            }
+            else if (member->hasObj()) {
+                *objOut = member->obj;
+            }
+            else {
+                _workingSet->free(id);
                 return Runner::RUNNER_ERROR;
             }
         }
+
+        if (NULL != dlOut) {
+            if (member->hasLoc()) {
+                *dlOut = member->loc;
+            }
+            else {
+                _workingSet->free(id);
+                return Runner::RUNNER_ERROR;
+            }
+        }
+        _workingSet->free(id);
+        return Runner::RUNNER_ADVANCED;
+    }
+
+    void PlanExecutor::freeResults() {
+        for (deque<WorkingSetID>::const_iterator it = _results.begin(); it != _results.end();
+             ++it) {
+            _workingSet->free(*it);
+        }
+        _results.clear();
     }
 
     bool PlanExecutor::isEOF() {
-        return _killed || _root->isEOF();
+        return _killed || (_results.empty() && _root->isEOF());
     }
 
     void PlanExecutor::kill() {
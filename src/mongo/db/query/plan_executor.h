@@ -29,7 +29,9 @@
 #pragma once
 
 #include <boost/scoped_ptr.hpp>
+#include <deque>
 
+#include "mongo/db/exec/working_set.h"
 #include "mongo/base/status.h"
 #include "mongo/db/query/runner.h"
 #include "mongo/db/query/runner_yield_policy.h"
@@ -40,15 +42,15 @@ namespace mongo {
     class DiskLoc;
     class PlanStage;
     struct PlanStageStats;
-    class WorkingSet;
 
     /**
      * A PlanExecutor is the abstraction that knows how to crank a tree of stages into execution.
      * The executor is usually part of a larger abstraction that is interacting with the cache
      * and/or the query optimizer.
      *
-     * Executes a plan.  Used by a runner.  Calls work() on a plan until a result is produced.
-     * Stops when the plan is EOF or if the plan errors.
+     * Executes a plan.  Used by a runner.  Calls workBatch() on a plan until results are
+     * produced, then hands them out one at a time.  Stops when the plan is EOF or if the plan
+     * errors.
      */
     class PlanExecutor {
     public:
@@ -99,6 +101,16 @@ namespace mongo {
         void kill();
 
     private:
+        /**
+         * Extract the requested parts of the result 'id' and free it.
+         */
+        Runner::RunnerState returnResult(WorkingSetID id, BSONObj* objOut, DiskLoc* dlOut);
+
+        /**
+         * Drop any results we're holding on to.
+         */
+        void freeResults();
+
         boost::scoped_ptr<WorkingSet> _workingSet;
         boost::scoped_ptr<PlanStage> _root;
         boost::scoped_ptr<RunnerYieldPolicy> _yieldPolicy;
@@ -106,6 +118,9 @@ namespace mongo {
         // Did somebody drop an index we care about or the namespace we're looking at?  If so,
         // we'll be killed.
         bool _killed;
+
+        // The plan is worked in batches.  Results produced but not yet returned wait here.
+        std::deque<WorkingSetID> _results;
     };
 
 }  // namespace mongo
@@ -34,6 +34,7 @@
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/query/query_solution.h"
 #include "mongo/db/query/qlog.h"
+#include "mongo/db/stats/index_usage.h"
 
 namespace mongo {
 
@@ -63,9 +64,16 @@ namespace mongo {
         // Make sure we got something.
         verify(numeric_limits<size_t>::max() != bestChild);
 
+        // Count the win for the indexes the winner scans.
+        if (NULL != candidates[bestChild].solution) {
+            IndexUsageTracker::global.recordPlanWin(candidates[bestChild].solution->ns,
+                                                    statTrees[bestChild]);
+        }
+
         if (NULL != why) {
             // Record the stats of the winner.
             why->statsOfWinner = statTrees[bestChild];
+            why->scoreOfWinner = maxScore;
         }
 
         // Clean up stats of losers.
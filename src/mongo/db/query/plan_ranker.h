@@ -52,9 +52,13 @@ namespace mongo {
          */
         static size_t pickBestPlan(const vector<CandidatePlan>& candidates,
                                    PlanRankingDecision* why);
-    private:
+
         /**
-         * Assign the stats tree a 'goodness' score.  Used internally.
+         * Assign the stats tree a 'goodness' score.  Scores start at 1 so that every plan beats
+         * the "no plan selected" score of 0; the rest measures how productive the plan was.
+         *
+         * Also used by the plan cache to compare how a cached plan does on later runs with how it
+         * did when it was picked.
          */
         static double scoreTree(const PlanStageStats* stats);
     };
@@ -82,15 +86,22 @@ namespace mongo {
      * and used by the CachedPlanRunner to compare expected performance with actual.
      */
     struct PlanRankingDecision {
-        PlanRankingDecision() : statsOfWinner(NULL), onlyOneSolution(false) { }
+        PlanRankingDecision() : statsOfWinner(NULL), scoreOfWinner(0), onlyOneSolution(false) { }
+        ~PlanRankingDecision() { delete statsOfWinner; }
 
         // Owned by us.
         PlanStageStats* statsOfWinner;
 
+        // What PlanRanker::scoreTree made of 'statsOfWinner'.
+        double scoreOfWinner;
+
         bool onlyOneSolution;
 
         // TODO: We can place anything we want here.  What's useful to the cache?  What's useful to
         // planning and optimization?
+
+    private:
+        MONGO_DISALLOW_COPYING(PlanRankingDecision);
     };
 
 }  // namespace mongo
@@ -73,6 +73,18 @@ namespace mongo {
             qp->_includedFields.push_back(string("_id"));
         }
 
+        // _includedFields won't change now, so we can point into it.
+        qp->_includeTopLevelOnly = qp->_excludedFields.empty() && !qp->_includedFields.empty();
+        for (size_t i = 0; i < qp->_includedFields.size(); ++i) {
+            const string& field = qp->_includedFields[i];
+            if (string::npos != field.find('.')) {
+                qp->_includeTopLevelOnly = false;
+                qp->_includedTopLevel.clear();
+                break;
+            }
+            qp->_includedTopLevel.insert(StringData(field));
+        }
+
         *out = qp.release();
         return Status::OK();
     }
@@ -39,6 +39,7 @@
 #include "mongo/db/matcher/expression_array.h"
 #include "mongo/db/matcher/expression_geo.h"
 #include "mongo/db/matcher/expression_text.h"
+#include "mongo/db/matcher/expression_implication.h"
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/query/canonical_query.h"
 #include "mongo/db/query/index_bounds_builder.h"
@@ -656,6 +657,45 @@ namespace mongo {
         return true;
     }
 
+    // static
+    bool QueryPlanner::canFilterOnKeys(const MatchExpression* expr,
+                                       const QuerySolutionNode* node) {
+        if (STAGE_IXSCAN != node->getType()) { return false; }
+
+        // The keys of special indices (hashed, geo, text) aren't the values of the fields.
+        const IndexScanNode* isn = static_cast<const IndexScanNode*>(node);
+        BSONObjIterator kpIt(isn->indexKeyPattern);
+        while (kpIt.more()) {
+            if (!kpIt.next().isNumber()) { return false; }
+        }
+
+        switch (expr->matchType()) {
+        case MatchExpression::AND:
+        case MatchExpression::OR:
+        case MatchExpression::NOR:
+        case MatchExpression::NOT:
+            for (size_t i = 0; i < expr->numChildren(); ++i) {
+                if (!canFilterOnKeys(expr->getChild(i), node)) { return false; }
+            }
+            return true;
+        case MatchExpression::LTE:
+        case MatchExpression::LT:
+        case MatchExpression::EQ:
+        case MatchExpression::GT:
+        case MatchExpression::GTE:
+        case MatchExpression::REGEX:
+        case MatchExpression::MOD:
+        case MatchExpression::MATCH_IN:
+        case MatchExpression::NIN:
+            // hasField is false for multikey indices.
+            return node->hasField(expr->path().toString());
+        default:
+            // $exists and $type can tell a missing field from the null the index stores for it,
+            // and the rest need the document.
+            return false;
+        }
+    }
+
     // static
     QuerySolutionNode* QueryPlanner::buildIndexedAnd(MatchExpression* root,
                                                      bool inArrayOperator,
@@ -713,8 +753,15 @@ namespace mongo {
         }
 
         // If there are any nodes still attached to the AND, we can't answer them using the
-        // index, so we put a fetch with filter.
-        if (root->numChildren() > 0) {
+        // bounds.  If they're over fields in the (one) index we're scanning, apply them to the
+        // index keys.  Otherwise we put a fetch with filter.
+        if (root->numChildren() > 0 && canFilterOnKeys(root, andResult)) {
+            IndexScanNode* isn = static_cast<IndexScanNode*>(andResult);
+            verify(NULL == isn->filter.get());
+            verify(NULL != autoRoot.get());
+            isn->filter.reset(autoRoot.release());
+        }
+        else if (root->numChildren() > 0) {
             FetchNode* fetch = new FetchNode();
             verify(NULL != autoRoot.get());
             // Takes ownership.
@@ -785,7 +832,18 @@ namespace mongo {
                 orResult = msn;
             }
             else {
+                // If each child is sorted by DiskLoc (e.g. each is a point), we can merge them
+                // and dedup without remembering everything we've returned.
+                bool allSortedByDiskLoc = true;
+                for (size_t i = 0; i < ixscanNodes.size(); ++i) {
+                    if (!ixscanNodes[i]->sortedByDiskLoc()) {
+                        allSortedByDiskLoc = false;
+                        break;
+                    }
+                }
+
                 OrNode* orn = new OrNode();
+                orn->mergeByDiskLoc = allSortedByDiskLoc;
                 orn->children.swap(ixscanNodes);
                 orResult = orn;
             }
@@ -856,6 +914,14 @@ namespace mongo {
                     return soln;
                 }
 
+                // The predicate may still be answerable from the index keys without a fetch.
+                if (canFilterOnKeys(root, soln)) {
+                    IndexScanNode* isn = static_cast<IndexScanNode*>(soln);
+                    verify(NULL != autoRoot.get());
+                    isn->filter.reset(autoRoot.release());
+                    return soln;
+                }
+
                 FetchNode* fetch = new FetchNode();
                 verify(NULL != autoRoot.get());
                 fetch->filter.reset(autoRoot.release());
@@ -925,6 +991,9 @@ namespace mongo {
         // solnRoot finds all our results.  Let's see what transformations we must perform to the
         // data.
 
+        // The blocking sort we add, if any.
+        SortNode* sortNode = NULL;
+
         // Sort the results, if there is a sort specified.
         if (!query.getParsed().getSort().isEmpty()) {
             const BSONObj& sortObj = query.getParsed().getSort();
@@ -963,6 +1032,7 @@ namespace mongo {
                     sort->pattern = sortObj;
                     sort->child.reset(solnRoot);
                     solnRoot = sort;
+                    sortNode = sort;
                 }
             }
         }
@@ -1028,6 +1098,11 @@ namespace mongo {
             limit->limit = query.getParsed().getNumToReturn();
             limit->child.reset(solnRoot);
             solnRoot = limit;
+
+            // The sort only has to keep the results that make it past the skip and limit.
+            if (NULL != sortNode) {
+                sortNode->limit = query.getParsed().getSkip() + limit->limit;
+            }
         }
 
         soln->root.reset(solnRoot);
@@ -1059,7 +1134,7 @@ namespace mongo {
     }
 
     // static
-    void QueryPlanner::plan(const CanonicalQuery& query, const vector<IndexEntry>& indices,
+    void QueryPlanner::plan(const CanonicalQuery& query, const vector<IndexEntry>& allIndices,
                             size_t options, vector<QuerySolution*>* out) {
         QLOG() << "============================="
                << "Beginning planning.\n"
@@ -1067,6 +1142,19 @@ namespace mongo {
                << "============================="
                << endl;
 
+        // A partial index is missing the documents outside its filter, so it can only answer
+        // queries that imply the filter.  The others are invisible to this query, even if hinted.
+        vector<IndexEntry> indices;
+        for (size_t i = 0; i < allIndices.size(); ++i) {
+            if (NULL != allIndices[i].filterExpr
+                && !expressionImplies(query.root(), allIndices[i].filterExpr)) {
+                QLOG() << "query doesn't imply the filter of partial index "
+                       << allIndices[i].toString() << endl;
+                continue;
+            }
+            indices.push_back(allIndices[i]);
+        }
+
         for (size_t i = 0; i < indices.size(); ++i) {
             QLOG() << "idx " << i << " is " << indices[i].toString() << endl;
         }
@@ -181,6 +181,15 @@ namespace mongo {
         // Helpers for creating an index scan.
         //
 
+        /**
+         * Returns true if 'expr' can be evaluated on the keys that the index scan 'node' produces
+         * rather than on the documents they point to, so that no fetch is needed to apply it.
+         * That's the case when 'node' scans a non-multikey btree index that has every field 'expr'
+         * refers to, and 'expr' is made up of predicates that match missing fields and the null
+         * stored for them in the index alike.
+         */
+        static bool canFilterOnKeys(const MatchExpression* expr, const QuerySolutionNode* node);
+
         /**
          * Create a new data access node.
          *
@@ -357,6 +357,60 @@ namespace {
         cout << indexedSolution->toString() << endl;
     }
 
+    //
+    // Index intersection
+    //
+
+    TEST_F(IndexAssignmentTest, IntersectPointScansWithAndSorted) {
+        addIndex(BSON("a" << 1));
+        addIndex(BSON("b" << 1));
+        runQuery(fromjson("{a: 1, b: 1}"));
+        // Collscan, one per index, and the intersection of the two.
+        ASSERT_EQUALS(getNumSolutions(), 4U);
+
+        vector<QuerySolution*> fetches;
+        getAllPlans(STAGE_FETCH, &fetches);
+        ASSERT_EQUALS(fetches.size(), 3U);
+
+        size_t numIntersections = 0;
+        for (size_t i = 0; i < fetches.size(); ++i) {
+            FetchNode* fn = static_cast<FetchNode*>(fetches[i]->root.get());
+            ASSERT(STAGE_AND_HASH != fn->child->getType());
+            if (STAGE_AND_SORTED == fn->child->getType()) {
+                ++numIntersections;
+            }
+        }
+        ASSERT_EQUALS(numIntersections, 1U);
+    }
+
+    TEST_F(IndexAssignmentTest, IntersectRangeScansWithAndHash) {
+        addIndex(BSON("a" << 1));
+        addIndex(BSON("b" << 1));
+        runQuery(fromjson("{a: {$gt: 1}, b: 1}"));
+        ASSERT_EQUALS(getNumSolutions(), 4U);
+
+        vector<QuerySolution*> fetches;
+        getAllPlans(STAGE_FETCH, &fetches);
+
+        size_t numIntersections = 0;
+        for (size_t i = 0; i < fetches.size(); ++i) {
+            FetchNode* fn = static_cast<FetchNode*>(fetches[i]->root.get());
+            ASSERT(STAGE_AND_SORTED != fn->child->getType());
+            if (STAGE_AND_HASH == fn->child->getType()) {
+                ++numIntersections;
+            }
+        }
+        ASSERT_EQUALS(numIntersections, 1U);
+    }
+
+    TEST_F(IndexAssignmentTest, NoIntersectionSharingPredicates) {
+        // Both indices would answer {a: 1}, so intersecting them is pointless.
+        addIndex(BSON("a" << 1));
+        addIndex(BSON("a" << 1 << "b" << 1));
+        runQuery(fromjson("{a: 1}"));
+        ASSERT_EQUALS(getNumSolutions(), 3U);
+    }
+
     //
     // Tree operations that require simple tree rewriting.
     //
@@ -405,6 +459,76 @@ namespace {
         }
     }
 
+    TEST_F(IndexAssignmentTest, CoveredFilterOnKeys) {
+        addIndex(BSON("x" << 1));
+        // An unanchored regex doesn't give exact bounds, but can be checked against the keys.
+        runDetailedQuery(fromjson("{x: /foo/}"), BSONObj(), fromjson("{_id: 0, x: 1}"));
+
+        vector<QuerySolution*> solns;
+        getAllPlans(STAGE_PROJECTION, &solns);
+        ASSERT_EQUALS(solns.size(), 2U);
+
+        bool foundIndexed = false;
+        for (size_t i = 0; i < solns.size(); ++i) {
+            ProjectionNode* pn = static_cast<ProjectionNode*>(solns[i]->root.get());
+            if (STAGE_IXSCAN == pn->child->getType()) {
+                IndexScanNode* isn = static_cast<IndexScanNode*>(pn->child.get());
+                ASSERT(NULL != isn->filter.get());
+                foundIndexed = true;
+            }
+        }
+        ASSERT_TRUE(foundIndexed);
+    }
+
+    TEST_F(IndexAssignmentTest, CoveredFilterOnCompoundKeys) {
+        addIndex(BSON("x" << 1 << "y" << 1));
+        runDetailedQuery(fromjson("{x: 5, y: /foo/}"), BSONObj(), fromjson("{_id: 0, y: 1}"));
+
+        vector<QuerySolution*> solns;
+        getAllPlans(STAGE_PROJECTION, &solns);
+        ASSERT_EQUALS(solns.size(), 2U);
+
+        bool foundIndexed = false;
+        for (size_t i = 0; i < solns.size(); ++i) {
+            ProjectionNode* pn = static_cast<ProjectionNode*>(solns[i]->root.get());
+            ASSERT(STAGE_FETCH != pn->child->getType());
+            if (STAGE_IXSCAN == pn->child->getType()) {
+                foundIndexed = true;
+            }
+        }
+        ASSERT_TRUE(foundIndexed);
+    }
+
+    TEST_F(IndexAssignmentTest, NoCoveredFilterOnMultikey) {
+        // The keys of a multikey index don't tell us what the document looks like.
+        addIndex(BSON("x" << 1), true, false);
+        runDetailedQuery(fromjson("{x: /foo/}"), BSONObj(), fromjson("{_id: 0, x: 1}"));
+
+        vector<QuerySolution*> solns;
+        getAllPlans(STAGE_PROJECTION, &solns);
+        ASSERT_EQUALS(solns.size(), 2U);
+
+        for (size_t i = 0; i < solns.size(); ++i) {
+            ProjectionNode* pn = static_cast<ProjectionNode*>(solns[i]->root.get());
+            ASSERT(STAGE_COLLSCAN == pn->child->getType() || STAGE_FETCH == pn->child->getType());
+        }
+    }
+
+    TEST_F(IndexAssignmentTest, NoCoveredFilterForExists) {
+        // The index stores null for a missing field, so $exists must look at the document.
+        addIndex(BSON("x" << 1 << "y" << 1));
+        runDetailedQuery(fromjson("{x: 5, y: {$exists: true}}"), BSONObj(),
+                         fromjson("{_id: 0, x: 1}"));
+
+        vector<QuerySolution*> solns;
+        getAllPlans(STAGE_PROJECTION, &solns);
+
+        for (size_t i = 0; i < solns.size(); ++i) {
+            ProjectionNode* pn = static_cast<ProjectionNode*>(solns[i]->root.get());
+            ASSERT(STAGE_IXSCAN != pn->child->getType());
+        }
+    }
+
     //
     // Basic sort elimination
     //
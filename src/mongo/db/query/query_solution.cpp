@@ -187,7 +187,7 @@ namespace mongo {
     // OrNode
     //
 
-    OrNode::OrNode() : dedup(true), filter(NULL) { }
+    OrNode::OrNode() : dedup(true), mergeByDiskLoc(false), filter(NULL) { }
 
     OrNode::~OrNode() {
         for (size_t i = 0; i < children.size(); ++i) {
@@ -426,6 +426,8 @@ namespace mongo {
         addIndent(ss, indent + 1);
         *ss << "pattern = " << pattern.toString() << endl;
         addIndent(ss, indent + 1);
+        *ss << "limit = " << limit << endl;
+        addIndent(ss, indent + 1);
         *ss << "fetched = " << fetched() << endl;
         addIndent(ss, indent + 1);
         *ss << "sortedByDiskLoc = " << sortedByDiskLoc() << endl;
@@ -247,13 +247,15 @@ namespace mongo {
         bool fetched() const;
         bool hasField(const string& field) const;
         bool sortedByDiskLoc() const {
-            // Even if our children are sorted by their diskloc or other fields, we don't maintain
-            // any order on the output.
-            return false;
+            // Unless we merge our children by DiskLoc we don't maintain any order on the output,
+            // even if they are sorted by their diskloc or other fields.
+            return mergeByDiskLoc;
         }
         BSONObj getSort() const { return BSONObj(); }
 
         bool dedup;
+        // Every child is sorted by DiskLoc and we merge them.
+        bool mergeByDiskLoc;
         // XXX why is this here
         scoped_ptr<MatchExpression> filter;
         vector<QuerySolutionNode*> children;
@@ -382,7 +384,7 @@ namespace mongo {
     };
 
     struct SortNode : public QuerySolutionNode {
-        SortNode() { }
+        SortNode() : limit(0) { }
         virtual ~SortNode() { }
 
         virtual StageType getType() const { return STAGE_SORT; }
@@ -395,6 +397,10 @@ namespace mongo {
         BSONObj getSort() const { return pattern; }
 
         BSONObj pattern;
+
+        // If a limit sits above us, we only need to keep this many results.  0 for no limit.
+        int limit;
+
         scoped_ptr<QuerySolutionNode> child;
         // TODO: Filter
     };
@@ -29,13 +29,12 @@
 #pragma once
 
 #include "mongo/db/clientcursor.h"
-#include "mongo/util/elapsed_tracker.h"
 
 namespace mongo {
 
     class RunnerYieldPolicy {
     public:
-        RunnerYieldPolicy() : _elapsedTracker(128, 10), _runnerYielding(NULL) { }
+        RunnerYieldPolicy() : _runnerYielding(NULL) { }
 
         ~RunnerYieldPolicy() {
             if (NULL != _runnerYielding) {
@@ -46,7 +45,7 @@ namespace mongo {
         }
 
         bool shouldYield() {
-            return _elapsedTracker.intervalHasElapsed();
+            return _yieldTracker.intervalHasElapsed();
         }
 
         /**
@@ -68,7 +67,7 @@ namespace mongo {
             staticYield(micros, NULL);
             ClientCursor::deregisterRunner(_runnerYielding);
             _runnerYielding = NULL;
-            _elapsedTracker.resetLastTime();
+            _yieldTracker.resetLastTime();
             return runner->restoreState();
         }
 
@@ -82,7 +81,7 @@ namespace mongo {
             int micros = ClientCursor::suggestYieldMicros();
             if (micros > 0) {
                 staticYield(micros, rec);
-                _elapsedTracker.resetLastTime();
+                _yieldTracker.resetLastTime();
             }
         }
 
@@ -91,7 +90,7 @@ namespace mongo {
         }
 
     private:
-        ElapsedTracker _elapsedTracker;
+        YieldTracker _yieldTracker;
         Runner* _runnerYielding;
     };
 
@@ -100,6 +100,7 @@ namespace mongo {
             if (NULL == childStage) { return NULL; }
             SortStageParams params;
             params.pattern = sn->pattern;
+            params.limit = sn->limit;
             return new SortStage(params, ws, childStage);
         }
         else if (STAGE_PROJECTION == root->getType()) {
@@ -132,7 +133,8 @@ namespace mongo {
         }
         else if (STAGE_OR == root->getType()) {
             const OrNode * orn = static_cast<const OrNode*>(root);
-            auto_ptr<OrStage> ret(new OrStage(ws, orn->dedup, orn->filter.get()));
+            auto_ptr<OrStage> ret(new OrStage(ws, orn->dedup, orn->filter.get(),
+                                                  orn->mergeByDiskLoc));
             for (size_t i = 0; i < orn->children.size(); ++i) {
                 PlanStage* childStage = buildStages(ns, orn->children[i], ws);
                 if (NULL == childStage) { return NULL; }
@@ -37,6 +37,10 @@ namespace mongo {
         STAGE_AND_HASH,
         STAGE_AND_SORTED,
         STAGE_COLLSCAN,
+
+        // Counts index keys without producing results.  Never chosen by the planner.
+        STAGE_COUNT_SCAN,
+
         STAGE_FETCH,
 
         // TODO: This is probably an expression index, but would take even more time than
@@ -37,6 +37,7 @@ namespace mongo {
     const BSONField<long long> TypeExplain::nChunkSkips("nChunkSkips");
     const BSONField<long long> TypeExplain::millis("millis");
     const BSONField<BSONObj> TypeExplain::indexBounds("indexBounds");
+    const BSONField<BSONObj> TypeExplain::stats("stats");
     const BSONField<std::vector<TypeExplain*> > TypeExplain::allPlans("allPlans");
     const BSONField<TypeExplain*> TypeExplain::oldPlan("oldPlan");
     const BSONField<std::string> TypeExplain::server("server");
@@ -131,6 +132,8 @@ namespace mongo {
 
         if (_isIndexBoundsSet) builder.append(indexBounds(), _indexBounds);
 
+        if (_isStatsSet) builder.append(stats(), _stats);
+
         if (_allPlans.get()) {
             BSONArrayBuilder allPlansBuilder(builder.subarrayStart(allPlans()));
             for (std::vector<TypeExplain*>::const_iterator it = _allPlans->begin();
@@ -217,6 +220,10 @@ namespace mongo {
         if (fieldState == FieldParser::FIELD_INVALID) return false;
         _isIndexBoundsSet = fieldState == FieldParser::FIELD_SET;
 
+        fieldState = FieldParser::extract(source, stats, &_stats, errMsg);
+        if (fieldState == FieldParser::FIELD_INVALID) return false;
+        _isStatsSet = fieldState == FieldParser::FIELD_SET;
+
         std::vector<TypeExplain*>* bareAllPlans = NULL;
         fieldState = FieldParser::extract(source, allPlans, &bareAllPlans, errMsg);
         if (fieldState == FieldParser::FIELD_INVALID) return false;
@@ -276,6 +283,9 @@ namespace mongo {
         _indexBounds = BSONObj();
         _isIndexBoundsSet = false;
 
+        _stats = BSONObj();
+        _isStatsSet = false;
+
         unsetAllPlans();
 
         unsetOldPlan();
@@ -338,6 +348,9 @@ namespace mongo {
         other->_indexBounds = _indexBounds;
         other->_isIndexBoundsSet = _isIndexBoundsSet;
 
+        other->_stats = _stats;
+        other->_isStatsSet = _isStatsSet;
+
         other->unsetAllPlans();
         if (_allPlans.get()) {
             for(std::vector<TypeExplain*>::const_iterator it = _allPlans->begin();
@@ -647,6 +660,24 @@ namespace mongo {
         return _indexBounds;
     }
 
+    void TypeExplain::setStats(const BSONObj& stats) {
+        _stats = stats.getOwned();
+        _isStatsSet = true;
+    }
+
+    void TypeExplain::unsetStats() {
+        _isStatsSet = false;
+    }
+
+    bool TypeExplain::isStatsSet() const {
+        return _isStatsSet;
+    }
+
+    const BSONObj& TypeExplain::getStats() const {
+        dassert(_isStatsSet);
+        return _stats;
+    }
+
     void TypeExplain::setAllPlans(const std::vector<TypeExplain*>& allPlans) {
         unsetAllPlans();
         for (std::vector<TypeExplain*>::const_iterator it = allPlans.begin();
@@ -49,6 +49,7 @@ namespace mongo {
         static const BSONField<long long> nChunkSkips;
         static const BSONField<long long> millis;
         static const BSONField<BSONObj> indexBounds;
+        static const BSONField<BSONObj> stats;
         static const BSONField<std::vector<TypeExplain*> > allPlans;
         static const BSONField<TypeExplain*> oldPlan;
         static const BSONField<std::string> server;
@@ -150,6 +151,11 @@ namespace mongo {
         bool isIndexBoundsSet() const;
         const BSONObj& getIndexBounds() const;
 
+        void setStats(const BSONObj& stats);
+        void unsetStats();
+        bool isStatsSet() const;
+        const BSONObj& getStats() const;
+
         void setAllPlans(const std::vector<TypeExplain*>& allPlans);
         void addToAllPlans(TypeExplain* allPlans);
         void unsetAllPlans();
@@ -226,6 +232,10 @@ namespace mongo {
         BSONObj _indexBounds;
         bool _isIndexBoundsSet;
 
+        // (O)  per-stage execution stats of this plan, as a tree
+        BSONObj _stats;
+        bool _isStatsSet;
+
         // (O)  alternative plans considered
         boost::scoped_ptr<std::vector<TypeExplain*> > _allPlans;
 
@@ -35,6 +35,8 @@
 #include "mongo/db/index/index_access_method.h"
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/intervalbtreecursor.h"
+#include "mongo/db/matcher/expression_implication.h"
+#include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/pdfile.h"
 #include "mongo/db/parsed_query.h"
 #include "mongo/db/query_plan_summary.h"
@@ -246,6 +248,10 @@ doneCheckOrder:
             _utility = Disallowed;
         }
 
+        if ( _descriptor->isPartial() && !queryImpliesPartialFilter() ) {
+            _utility = Disallowed;
+        }
+
         if ( _parsedQuery && _parsedQuery->getFields() && !_d->isMultikey( _idxNo ) ) {
             // Does not check modifiedKeys()
             _keyFieldsOnly.reset( _parsedQuery->getFields()->checkKey( _index->keyPattern() ) );
@@ -410,6 +416,23 @@ doneCheckOrder:
         return matcher()->docMatcher().hasExistsFalse();
     }
     
+    bool QueryPlan::queryImpliesPartialFilter() const {
+        StatusWithMatchExpression query = MatchExpressionParser::parse( _originalQuery );
+        if ( !query.isOK() ) {
+            return false;
+        }
+        scoped_ptr<MatchExpression> queryExpr( query.getValue() );
+
+        StatusWithMatchExpression filter =
+                MatchExpressionParser::parse( _descriptor->partialFilterExpression() );
+        if ( !filter.isOK() ) {
+            return false;
+        }
+        scoped_ptr<MatchExpression> filterExpr( filter.getValue() );
+
+        return expressionImplies( queryExpr.get(), filterExpr.get() );
+    }
+
     bool QueryPlan::queryBoundsExactOrderSuffix() const {
         if ( !indexed() ||
              !_frs.matchPossible() ||
@@ -168,6 +168,8 @@ namespace mongo {
 
         /** @return true when the plan's query may contains an $exists:false predicate. */
         bool hasPossibleExistsFalsePredicate() const;
+        /** @return true if the query only matches documents a partial index holds. */
+        bool queryImpliesPartialFilter() const;
 
         NamespaceDetails* _d;
         int _idxNo;
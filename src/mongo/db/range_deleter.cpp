@@ -36,6 +36,7 @@
 #include "mongo/util/concurrency/synchronization.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/time_support.h"
+#include "mongo/util/timer.h"
 
 using std::auto_ptr;
 using std::set;
@@ -171,9 +172,14 @@ namespace mongo {
         }
     }
 
-    void RangeDeleter::startWorkers() {
-        if (!_worker) {
-            _worker.reset(new boost::thread(boost::bind(&RangeDeleter::doWork, this)));
+    void RangeDeleter::startWorkers(int numWorkers) {
+        if (!_workers.empty()) {
+            return;
+        }
+
+        for (int i = 0; i < numWorkers; i++) {
+            _workers.mutableVector().push_back(
+                    new boost::thread(boost::bind(&RangeDeleter::doWork, this)));
         }
     }
 
@@ -183,8 +189,8 @@ namespace mongo {
             _stopRequested = true;
         }
 
-        if (_worker) {
-            _worker->join();
+        for (size_t i = 0; i < _workers.size(); i++) {
+            _workers.vector()[i]->join();
         }
 
         scoped_lock sl(_queueMutex);
@@ -315,13 +321,17 @@ namespace mongo {
             sleepmillis(checkIntervalMillis);
         }
 
+        Timer deleteTime;
+        long long numDeleted = 0;
         bool result = _env->deleteRange(ns, min, max, shardKeyPattern,
-                                        secondaryThrottle, errMsg);
+                                        secondaryThrottle, &numDeleted, errMsg);
 
         {
             scoped_lock sl(_queueMutex);
             _deleteSet.erase(&deleteRange);
 
+            _stats->recordDelete_inlock(numDeleted, deleteTime.millis());
+
             _stats->decInProgressDeletes_inlock();
             _stats->decTotalDeletes_inlock();
 
@@ -458,11 +468,14 @@ namespace mongo {
                 _stats->incInProgressDeletes_inlock();
             }
 
+            Timer deleteTime;
+            long long numDeleted = 0;
             if (!_env->deleteRange(nextTask->ns,
                                    nextTask->min,
                                    nextTask->max,
                                    nextTask->shardKeyPattern,
                                    nextTask->secondaryThrottle,
+                                   &numDeleted,
                                    &errMsg)) {
                 warning() << "Error encountered while trying to delete range: "
                           << errMsg << endl;
@@ -473,6 +486,7 @@ namespace mongo {
 
                 NSMinMax setEntry(nextTask->ns, nextTask->min, nextTask->max);
                 deletePtrElement(&_deleteSet, &setEntry);
+                _stats->recordDelete_inlock(numDeleted, deleteTime.millis());
                 _stats->decInProgressDeletes_inlock();
                 _stats->decTotalDeletes_inlock();
 
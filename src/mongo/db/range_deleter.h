@@ -34,6 +34,7 @@
 #include <string>
 
 #include "mongo/base/disallow_copying.h"
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/base/string_data.h"
 #include "mongo/db/cc_by_loc.h" // for typedef CursorId
 #include "mongo/db/jsobj.h"
@@ -53,15 +54,16 @@ namespace mongo {
      *
      * Threading assumptions:
      *
-     *   This class has (currently) one worker thread attacking the queue, one
-     *   job at a time. If we want an immediate deletion, that job is going to
-     *   be performed on the thread that is requesting it.
+     *   This class has a configurable number of worker threads attacking the queue,
+     *   each working on one job at a time, so that a job waiting on replication or
+     *   on a busy database does not hold up the others. If we want an immediate
+     *   deletion, that job is going to be performed on the thread that is requesting it.
      *
      *   All calls regarding deletion are synchronized.
      *
      * Life cycle:
      *   RangeDeleter* deleter = new RangeDeleter(new ...);
-     *   deleter->startWorkers();
+     *   deleter->startWorkers(numWorkers);
      *   ...
      *   killCurrentOp.killAll(); // stop all deletes
      *   deleter->stopWorkers();
@@ -89,15 +91,15 @@ namespace mongo {
         //
 
         /**
-         * Starts the background thread to work on this queue. Does nothing if the worker
-         * thread is already active.
+         * Starts numWorkers background threads to work on this queue. Does nothing if the
+         * workers are already active.
          *
          * This call is _not_ thread safe and must be issued before any other call.
          */
-        void startWorkers();
+        void startWorkers(int numWorkers = 1);
 
         /**
-         * Stops the background thread working on this queue. This will block if there are
+         * Stops the background threads working on this queue. This will block if there are
          * tasks that are being deleted, but will leave the pending tasks in the queue.
          *
          * Steps:
@@ -110,7 +112,7 @@ namespace mongo {
          *
          * + restarting this deleter with startWorkers after stopping it is not supported.
          *
-         * + the worker thread could be running a call in the environment. The thread is
+         * + a worker thread could be running a call in the environment. The thread is
          *   only going to be returned when the environment decides so. In production,
          *   KillCurrentOp::killAll can be used to get the thread back from the environment.
          */
@@ -200,7 +202,7 @@ namespace mongo {
 
         typedef std::set<NSMinMax*, NSMinMaxCmp> NSMinMaxSet; // owned here
 
-        /** Body of the worker thread */
+        /** Body of the worker threads */
         void doWork();
 
         /** Returns true if range is blacklisted. Assumes _queueMutex is held */
@@ -221,7 +223,7 @@ namespace mongo {
         scoped_ptr<RangeDeleterEnv> _env;
 
         // Initially not active. Must be started explicitly.
-        scoped_ptr<boost::thread> _worker;
+        OwnedPointerVector<boost::thread> _workers;
 
         // Protects _stopRequested.
         mutable mutex _stopMutex;
@@ -281,12 +283,15 @@ namespace mongo {
          *
          * Must be a synchronous call. Docs should be deleted after call ends.
          * Must not throw Exceptions.
+         *
+         * Sets numDeleted to the number of documents removed.
          */
         virtual bool deleteRange(const StringData& ns,
                                  const BSONObj& inclusiveLower,
                                  const BSONObj& exclusiveUpper,
                                  const BSONObj& shardKeyPattern,
                                  bool secondaryThrottle,
+                                 long long* numDeleted,
                                  std::string* errMsg) = 0;
 
         /**
@@ -53,6 +53,7 @@ namespace mongo {
                                         const BSONObj& exclusiveUpper,
                                         const BSONObj& keyPattern,
                                         bool secondaryThrottle,
+                                        long long* deletedDocs,
                                         std::string* errMsg) {
         const bool initiallyHaveClient = haveClient();
 
@@ -62,6 +63,7 @@ namespace mongo {
 
         cc().getAuthorizationSession()->grantInternalAuthorization();
 
+        Lock::ScopedPriority priority(Lock::priorityBackground);
         ShardForceVersionOkModeBlock forceVersion;
         {
             Helpers::RemoveSaver removeSaver("moveChunk", ns.toString(), "post-cleanup");
@@ -97,6 +99,8 @@ namespace mongo {
                     return false;
                 }
 
+                *deletedDocs = numDeleted;
+
                 log() << "rangeDeleter deleted " << numDeleted
                       << " documents for " << ns
                       << " from " << inclusiveLower
@@ -53,6 +53,7 @@ namespace mongo {
                                  const BSONObj& exclusiveUpper,
                                  const BSONObj& keyPattern,
                                  bool secondaryThrottle,
+                                 long long* numDeleted,
                                  std::string* errMsg);
 
         /**
@@ -122,13 +122,14 @@ namespace mongo {
          * Basic implementation of delete that matches the signature for
          * RangeDeleterEnv::deleteRange. This does not actually perform the delete
          * but simply keeps a record of it. Can also be paused by pauseDeletes and
-         * resumed with resumeDeletes.
+         * resumed with resumeDeletes. Reports one document deleted per range.
          */
         bool deleteRange(const StringData& ns,
                          const BSONObj& min,
                          const BSONObj& max,
                          const BSONObj& shardKeyPattern,
                          bool secondaryThrottle,
+                         long long* numDeleted,
                          string* errMsg);
 
         /**
@@ -29,7 +29,9 @@
 #include "mongo/db/range_deleter_service.h"
 
 #include "mongo/base/init.h"
+#include "mongo/db/commands/server_status.h"
 #include "mongo/db/range_deleter_db_env.h"
+#include "mongo/db/server_parameters.h"
 
 namespace {
 
@@ -46,4 +48,21 @@ namespace mongo {
     RangeDeleter* getDeleter() {
         return _deleter;
     }
+
+    // Number of ranges a shard cleans up at once.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(rangeDeleterWorkers, int, 2);
+
+    void startDeleterWorkers() {
+        _deleter->startWorkers(std::max(1, rangeDeleterWorkers));
+    }
+
+    class RangeDeleterServerStats : public ServerStatusSection {
+    public:
+        RangeDeleterServerStats() : ServerStatusSection("rangeDeleter") {}
+        virtual bool includeByDefault() const { return true; }
+
+        BSONObj generateSection(const BSONElement& configElement) const {
+            return _deleter->getStats()->toBSON();
+        }
+    } rangeDeleterServerStats;
 }
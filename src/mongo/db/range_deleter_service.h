@@ -37,4 +37,10 @@ namespace mongo {
      * Gets the global instance of the deleter and starts it.
      */
     RangeDeleter* getDeleter();
+
+    /**
+     * Starts the workers of the global instance, as many as the rangeDeleterWorkers
+     * server parameter asks for.
+     */
+    void startDeleterWorkers();
 }
@@ -198,6 +198,17 @@ namespace {
                                          &inProgressCount, NULL /* don't care errMsg */));
         ASSERT_EQUALS(0, inProgressCount);
 
+        long long completedCount = 0;
+        ASSERT_TRUE(FieldParser::extract(stats, RangeDeleterStats::CompletedDeletesField,
+                                         &completedCount, NULL /* don't care errMsg */));
+        ASSERT_EQUALS(1, completedCount);
+
+        // the mock deletes one document per range
+        long long deletedDocs = 0;
+        ASSERT_TRUE(FieldParser::extract(stats, RangeDeleterStats::DeletedDocsField,
+                                         &deletedDocs, NULL /* don't care errMsg */));
+        ASSERT_EQUALS(1, deletedDocs);
+
         deleter.stopWorkers();
     }
 
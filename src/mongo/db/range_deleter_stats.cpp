@@ -32,6 +32,10 @@ namespace mongo {
     const BSONField<int> RangeDeleterStats::TotalDeletesField("totalDeletes");
     const BSONField<int> RangeDeleterStats::PendingDeletesField("pendingDeletes");
     const BSONField<int> RangeDeleterStats::InProgressDeletesField("inProgressDeletes");
+    const BSONField<long long> RangeDeleterStats::CompletedDeletesField("completedDeletes");
+    const BSONField<long long> RangeDeleterStats::DeletedDocsField("deletedDocs");
+    const BSONField<long long> RangeDeleterStats::DeleteMillisField("deleteMillis");
+    const BSONField<double> RangeDeleterStats::DocsPerSecField("docsPerSec");
 
     BSONObj RangeDeleterStats::toBSON() const {
         scoped_lock sl(*_lockPtr);
@@ -40,6 +44,11 @@ namespace mongo {
         builder << TotalDeletesField(_totalDeletes);
         builder << PendingDeletesField(_pendingDeletes);
         builder << InProgressDeletesField(_inProgressDeletes);
+        builder << CompletedDeletesField(_completedDeletes);
+        builder << DeletedDocsField(_deletedDocs);
+        builder << DeleteMillisField(_deleteMillis);
+        builder << DocsPerSecField(_deleteMillis > 0 ?
+                                   _deletedDocs * 1000.0 / _deleteMillis : 0.0);
 
         return builder.obj();
     }
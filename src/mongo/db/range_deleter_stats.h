@@ -52,6 +52,18 @@ namespace mongo {
         // Total number of deletes that are currently in progress.
         static const BSONField<int> InProgressDeletesField;
 
+        // Total number of deletes finished, successfully or not.
+        static const BSONField<long long> CompletedDeletesField;
+
+        // Total number of documents removed by the finished deletes.
+        static const BSONField<long long> DeletedDocsField;
+
+        // Total time spent in the finished deletes, summed over concurrent ones.
+        static const BSONField<long long> DeleteMillisField;
+
+        // Documents removed per second spent deleting.
+        static const BSONField<double> DocsPerSecField;
+
         /**
          * Creates a stat object given the mutex from the RangeDeleter object
          * that this instance is keeping track of.
@@ -60,7 +72,10 @@ namespace mongo {
             _lockPtr(lockPtr),
             _totalDeletes(0),
             _pendingDeletes(0),
-            _inProgressDeletes(0) {
+            _inProgressDeletes(0),
+            _completedDeletes(0),
+            _deletedDocs(0),
+            _deleteMillis(0) {
         }
 
         /**
@@ -104,6 +119,12 @@ namespace mongo {
             return _inProgressDeletes > 0;
         }
 
+        void recordDelete_inlock(long long numDeleted, long long millis) {
+            _completedDeletes++;
+            _deletedDocs += numDeleted;
+            _deleteMillis += millis;
+        }
+
     private:
         // Protects all data structures below this. Not owned here.
         mutable mutex* _lockPtr;
@@ -111,5 +132,9 @@ namespace mongo {
         int _totalDeletes;
         int _pendingDeletes;
         int _inProgressDeletes;
+
+        long long _completedDeletes;
+        long long _deletedDocs;
+        long long _deleteMillis;
     };
 }
@@ -339,6 +339,55 @@ namespace {
         deleter.stopWorkers();
     }
 
+    // Several workers should each take a delete, so that one waiting in the environment
+    // does not hold up the others.
+    TEST(MixedDeletes, ConcurrentWorkers) {
+        RangeDeleterMockEnv* env = new RangeDeleterMockEnv();
+        RangeDeleter deleter(env);
+        deleter.startWorkers(2);
+
+        env->pauseDeletes();
+
+        Notification notifyDone1;
+        ASSERT_TRUE(deleter.queueDelete("test.user",
+                                        BSON("x" << 10),
+                                        BSON("x" << 20),
+                                        BSON("x" << 1),
+                                        true,
+                                        &notifyDone1,
+                                        NULL /* don't care errMsg */));
+
+        Notification notifyDone2;
+        ASSERT_TRUE(deleter.queueDelete("foo.bar",
+                                        BSON("x" << 10),
+                                        BSON("x" << 20),
+                                        BSON("x" << 1),
+                                        true,
+                                        &notifyDone2,
+                                        NULL /* don't care errMsg */));
+
+        // Both deletes are in the environment at the same time.
+        env->waitForNthPausedDelete(2u);
+
+        const BSONObj stats(deleter.getStats()->toBSON());
+        int inProgressCount = 0;
+        ASSERT_TRUE(FieldParser::extract(stats, RangeDeleterStats::InProgressDeletesField,
+                                         &inProgressCount, NULL /* don't care errMsg */));
+        ASSERT_EQUALS(2, inProgressCount);
+
+        int pendingCount = 0;
+        ASSERT_TRUE(FieldParser::extract(stats, RangeDeleterStats::PendingDeletesField,
+                                         &pendingCount, NULL /* don't care errMsg */));
+        ASSERT_EQUALS(0, pendingCount);
+
+        env->resumeOneDelete();
+        env->resumeOneDelete();
+        notifyDone1.waitToBeNotified();
+        notifyDone2.waitToBeNotified();
+
+        deleter.stopWorkers();
+    }
+
     // Should not be able to delete ranges that overlaps with a black listed range.
     TEST(BlackList, CantDeleteBlackListed) {
         RangeDeleterMockEnv* env = new RangeDeleterMockEnv();
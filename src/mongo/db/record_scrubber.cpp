@@ -0,0 +1,175 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/db/record_scrubber.h"
+
+#include <deque>
+
+#include "mongo/base/counter.h"
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/database_holder.h"
+#include "mongo/db/instance.h"
+#include "mongo/db/pdfile.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/background.h"
+
+namespace mongo {
+
+    Counter64 scrubbedExtents;
+    Counter64 scrubbedRecords;
+    Counter64 scrubChecksumFailures;
+
+    ServerStatusMetricField<Counter64> scrubbedExtentsDisplay("record.scrub.extents",
+                                                              &scrubbedExtents);
+    ServerStatusMetricField<Counter64> scrubbedRecordsDisplay("record.scrub.records",
+                                                              &scrubbedRecords);
+    ServerStatusMetricField<Counter64> scrubChecksumFailuresDisplay("record.scrub.checksumFailures",
+                                                                    &scrubChecksumFailures);
+
+    // 0 leaves the scrubber idle
+    MONGO_EXPORT_SERVER_PARAMETER( recordScrubExtentsPerSecond, int, 0 );
+
+    /**
+     * Works through the collections that keep record checksums one extent at a time, each under
+     * its own read lock, so that corruption is found without the lock time of a full validate.
+     * When it has been through them all it starts over.
+     */
+    class RecordScrubber : public BackgroundJob {
+    public:
+        RecordScrubber() {}
+        virtual ~RecordScrubber() {}
+
+        virtual string name() const { return "RecordScrubber"; }
+
+        virtual void run() {
+            Client::initThread( name().c_str() );
+            cc().getAuthorizationSession()->grantInternalAuthorization();
+
+            while ( ! inShutdown() ) {
+                sleepsecs( 1 );
+
+                const int extents = recordScrubExtentsPerSecond;
+                for ( int i = 0; i < extents && ! inShutdown(); i++ ) {
+                    try {
+                        if ( ! scrubNextExtent() )
+                            break;
+                    }
+                    catch ( DBException& e ) {
+                        error() << "record scrubber stopped on " << _ns << ": " << e << endl;
+                        _ns.clear();
+                        break;
+                    }
+                }
+            }
+        }
+
+    private:
+        /** @return false if there is nothing to scrub */
+        bool scrubNextExtent() {
+            if ( _ns.empty() ) {
+                if ( _todo.empty() )
+                    findCollections();
+                if ( _todo.empty() )
+                    return false;
+                _ns = _todo.front();
+                _todo.pop_front();
+                _extent = DiskLoc();
+            }
+
+            Client::ReadContext ctx( _ns );
+            NamespaceDetails* d = nsdetails( _ns );
+            if ( ! d || ! d->isUserFlagSet( NamespaceDetails::Flag_RecordChecksums ) ) {
+                // dropped, or checksums turned off, since we found it
+                _ns.clear();
+                return true;
+            }
+
+            ExtentManager& em = cc().database()->getExtentManager();
+            Extent* e = _extent.isNull() ? NULL : em.getExtent( _extent, false );
+            if ( e && ( ! e->isOk() || e->nsDiagnostic.toString() != _ns ) ) {
+                // freed or given to another collection while we were unlocked: start over
+                e = NULL;
+            }
+            if ( ! e && ! d->firstExtent().isNull() )
+                e = em.getExtent( d->firstExtent() );
+            if ( ! e ) {
+                _ns.clear();
+                return true;
+            }
+
+            for ( DiskLoc loc = e->firstRecord; ! loc.isNull();
+                  loc = em.getNextRecordInExtent( loc ) ) {
+                scrubbedRecords.increment();
+                if ( checkRecordChecksum( loc.rec() ) == RecordChecksumBad ) {
+                    scrubChecksumFailures.increment();
+                    error() << "record checksum mismatch in " << _ns << " at " << loc.toString()
+                            << ", run validate with full:true on it" << endl;
+                }
+            }
+            scrubbedExtents.increment();
+
+            _extent = e->xnext;
+            if ( _extent.isNull() )
+                _ns.clear();
+            return true;
+        }
+
+        void findCollections() {
+            set<string> dbs;
+            {
+                Lock::DBRead lk( "local" );
+                dbHolder().getAllShortNames( dbs );
+            }
+
+            for ( set<string>::const_iterator i = dbs.begin(); i != dbs.end(); ++i ) {
+                Client::ReadContext ctx( *i );
+                list<string> collections;
+                cc().database()->namespaceIndex().getNamespaces( collections );
+                for ( list<string>::const_iterator j = collections.begin();
+                      j != collections.end(); ++j ) {
+                    NamespaceDetails* d = nsdetails( *j );
+                    if ( d && d->isUserFlagSet( NamespaceDetails::Flag_RecordChecksums ) )
+                        _todo.push_back( *j );
+                }
+            }
+        }
+
+        std::deque<string> _todo;
+        string _ns;         // being scrubbed, or empty between collections
+        DiskLoc _extent;    // the next extent of _ns to check
+    };
+
+    void startRecordScrubber() {
+        RecordScrubber* scrubber = new RecordScrubber();
+        scrubber->go();
+    }
+}
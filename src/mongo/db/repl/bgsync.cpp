@@ -35,6 +35,7 @@
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/rs_sync.h"
 #include "mongo/db/repl/rs.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/base/counter.h"
 #include "mongo/db/stats/timer_stats.h"
@@ -45,6 +46,10 @@ namespace replset {
     int SleepToAllowBatchingMillis = 2;
     const int BatchIsSmallish = 40000; // bytes
 
+    // Tail the sync source's oplog with an exhaust cursor, so batches arrive as fast as the
+    // link carries them rather than one per round trip.
+    MONGO_EXPORT_SERVER_PARAMETER(replOplogExhaustCursor, bool, true);
+
     MONGO_FP_DECLARE(rsBgSyncProduce);
 
     BackgroundSync* BackgroundSync::s_instance = 0;
@@ -134,6 +139,7 @@ namespace replset {
 
     void BackgroundSync::notifierThread() {
         Client::initThread("rsSyncNotifier");
+        Lock::setThreadPriority(Lock::priorityCritical);
         theReplSet->syncSourceFeedback.ensureMe();
         replLocalAuth();
 
@@ -259,6 +265,7 @@ namespace replset {
 
     void BackgroundSync::producerThread() {
         Client::initThread("rsBackgroundSync");
+        Lock::setThreadPriority(Lock::priorityCritical);
         replLocalAuth();
 
         while (!inShutdown()) {
@@ -350,6 +357,21 @@ namespace replset {
             return;
         }
 
+        if (replOplogExhaustCursor) {
+            // The rollback check may need the connection for other queries, so it is done over
+            // a cursor of its own; this one has the connection to itself from now on.
+            r.resetCursor();
+            r.exhaustTailingQueryGTE(rsoplog, lastOpTimeFetched);
+            if (!r.haveCursor() || !r.more()) {
+                return;
+            }
+            // the op isRollbackRequired() just checked
+            BSONObj o = r.nextSafe();
+            if (o["ts"]._opTime() != lastOpTimeFetched || o["h"].numberLong() != _lastH) {
+                return;
+            }
+        }
+
         while (!inShutdown()) {
             if (!r.moreInCurrentBatch()) {
                 // Check some things periodically
@@ -388,10 +410,12 @@ namespace replset {
                 {
                     //record time for each getmore
                     TimerHolder batchTimer(&getmoreReplStats);
+                    Timer fetchTimer;
                     
                     // This calls receiveMore() on the oplogreader cursor.
                     // It can wait up to five seconds for more data.
                     r.more();
+                    notePipelineStage(STAGE_FETCH, fetchTimer.micros());
                 }
                 networkByteStats.increment(r.currentBatchMessageSize());
 
@@ -418,9 +442,14 @@ namespace replset {
             }
 
             // At this point, we are guaranteed to have at least one thing to read out
-            // of the oplogreader cursor.
-            BSONObj o = r.nextSafe().getOwned();
-            opsReadStats.increment();
+            // of the oplogreader cursor.  The whole batch goes into the buffer at once.
+            std::vector<BSONObj> ops;
+            size_t opsSize = 0;
+            while (r.moreInCurrentBatch()) {
+                ops.push_back(r.nextSafe().getOwned());
+                opsSize += getSize(ops.back());
+            }
+            opsReadStats.increment(ops.size());
 
             {
                 boost::unique_lock<boost::mutex> lock(_mutex);
@@ -431,14 +460,17 @@ namespace replset {
                 LOG(2) << "bgsync buffer has " << _buffer.size() << " bytes" << rsLog;
             }
             // the blocking queue will wait (forever) until there's room for us to push
-            _buffer.push(o);
-            bufferCountGauge.increment();
-            bufferSizeGauge.increment(getSize(o));
+            Timer pushTimer;
+            _buffer.pushAll(ops.begin(), ops.end());
+            notePipelineStage(STAGE_BUFFER_FULL, pushTimer.micros());
+            bufferCountGauge.increment(ops.size());
+            bufferSizeGauge.increment(opsSize);
 
             {
                 boost::unique_lock<boost::mutex> lock(_mutex);
-                _lastH = o["h"].numberLong();
-                _lastOpTimeFetched = o["ts"]._opTime();
+                const BSONObj& last = ops.back();
+                _lastH = last["h"].numberLong();
+                _lastOpTimeFetched = last["ts"]._opTime();
             }
         }
     }
@@ -469,6 +501,12 @@ namespace replset {
         return _buffer.peek(*op);
     }
 
+    void BackgroundSync::appendBufferStats(BSONObjBuilder& b) {
+        b.appendNumber("bufferOps", bufferCountGauge.get());
+        b.appendNumber("bufferBytes", bufferSizeGauge.get());
+        b.append("bufferMaxBytes", bufferMaxSizeGauge);
+    }
+
     void BackgroundSync::waitForMore() {
         BSONObj op;
         // Block for one second before timing out.
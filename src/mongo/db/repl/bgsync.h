@@ -153,6 +153,9 @@ namespace replset {
         // For monitoring
         BSONObj getCounters();
 
+        /** Appends how many ops and bytes wait in the buffer for the sync thread. */
+        static void appendBufferStats(BSONObjBuilder& b);
+
         // Wait for replication to finish and buffer to be applied so that the member can become
         // primary.
         void stopReplicationAndFlushBuffer();
@@ -73,29 +73,19 @@ namespace mongo {
                 RARELY {
                     if ( _findingStartTimer.seconds() >= _initialTimeout ) {
                         // If we've scanned enough, switch to find extent mode.
-                        createClientCursor( extentFirstLoc( _findingStartCursor->currLoc() ) );
                         _findingStartMode = FindExtent;
                         return;
                     }
                 }
                 return;
             }
-            // FindExtent mode: moving backwards through extents, check first
-            // document of each extent.
+            // FindExtent mode: binary search the extents before this one for the newest whose
+            // first document is out of the query range.
             case FindExtent: {
-                if ( !_matcher->matchesCurrent( _findingStartCursor->c() ) ) {
-                    _findingStartMode = InExtent;
-                    return;
-                }
-                DiskLoc prev = prevExtentFirstLoc( _findingStartCursor->currLoc() );
-                if ( prev.isNull() ) { // hit beginning, so start scanning from here
-                    createClientCursor();
-                    _findingStartMode = InExtent;
-                    return;
-                }
-                // There might be a more efficient implementation than creating new cursor & client cursor each time,
-                // not worrying about that for now
-                createClientCursor( prev );
+                DiskLoc start = findStartExtent( extentFirstLoc( _findingStartCursor->currLoc() ) );
+                // if every extent is in range, start scanning from the beginning
+                createClientCursor( start );
+                _findingStartMode = InExtent;
                 return;
             }
             // InExtent mode: once an extent is chosen, find starting doc in the extent.
@@ -161,6 +151,29 @@ namespace mongo {
         }
     }
     
+    DiskLoc FindingStartCursor::findStartExtent( const DiskLoc& rec ) const {
+        // First documents of extents further back have older timestamps, so the ones in range
+        // all come before the ones out of range.
+        vector<DiskLoc> extentStarts;
+        for( DiskLoc loc = rec; !loc.isNull(); loc = prevExtentFirstLoc( loc ) ) {
+            extentStarts.push_back( loc );
+        }
+
+        size_t lo = 0;
+        size_t hi = extentStarts.size();
+        while( lo < hi ) {
+            size_t mid = lo + ( hi - lo ) / 2;
+            shared_ptr<Cursor> c = _qp.newCursor( extentStarts[ mid ] );
+            if ( _matcher->matchesCurrent( c.get() ) ) {
+                lo = mid + 1;
+            }
+            else {
+                hi = mid;
+            }
+        }
+        return lo == extentStarts.size() ? DiskLoc() : extentStarts[ lo ];
+    }
+
     void FindingStartCursor::createClientCursor( const DiskLoc &startLoc ) {
         shared_ptr<Cursor> c = _qp.newCursor( startLoc );
         _findingStartCursor.reset( new ClientCursor(QueryOption_NoCursorTimeout, c, _qp.ns()) );
@@ -115,6 +115,13 @@ namespace mongo {
         /** @return the first record of the extent containing @param rec. */
         DiskLoc extentFirstLoc( const DiskLoc &rec );
 
+        /**
+         * @return the first record of the newest extent, among the one starting at @param rec
+         *     and those preceding it, whose first record doesn't match, or DiskLoc() if they all
+         *     match.
+         */
+        DiskLoc findStartExtent( const DiskLoc& rec ) const;
+
         void createClientCursor( const DiskLoc &startLoc = DiskLoc() );
         void destroyClientCursor() {
             _findingStartCursor.reset( 0 );
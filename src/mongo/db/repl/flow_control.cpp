@@ -0,0 +1,206 @@
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/repl/flow_control.h"
+
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/curop.h"
+#include "mongo/db/d_concurrency.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/db/repl/rs.h"
+#include "mongo/db/repl/write_concern.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    MONGO_EXPORT_SERVER_PARAMETER(flowControl, bool, false);
+
+    int flowControlTargetLagSeconds = 10;
+    int flowControlMinTicketsPerSecond = 100;
+
+namespace {
+
+    BoundedIntParameter flowControlTargetLagSecondsParameter(
+            ServerParameterSet::getGlobal(), "flowControlTargetLagSeconds",
+            &flowControlTargetLagSeconds, 1, 24 * 60 * 60);
+    BoundedIntParameter flowControlMinTicketsPerSecondParameter(
+            ServerParameterSet::getGlobal(), "flowControlMinTicketsPerSecond",
+            &flowControlMinTicketsPerSecond, 1, 1000 * 1000);
+
+    /**
+     * Paces writes with a token bucket whose rate is adjusted once a second from the majority's
+     * lag.  While the lag is over the target and not shrinking the rate is cut, in proportion
+     * to how far over it is, from what was actually let through; once the lag is back under
+     * half the target the rate grows again, and throttling stops when the rate is well above
+     * what the writers ask for.
+     */
+    class FlowControl {
+    public:
+        FlowControl() : _mutex("FlowControl"), _ticketsPerSecond(0), _tickets(0),
+                        _lastRefill(0), _lastAdjust(0), _admitted(0), _lagSecs(-1),
+                        _throttledOps(0), _throttledMicros(0) {
+        }
+
+        /** @return how long, in microseconds, it took to get a ticket */
+        long long acquire() {
+            long long waited = 0;
+            while (true) {
+                long long wait;
+                {
+                    scoped_lock lk(_mutex);
+                    const unsigned long long now = curTimeMicros64();
+                    _adjust(now);
+                    if (_ticketsPerSecond == 0 || _refill(now) >= 1) {
+                        if (_ticketsPerSecond != 0)
+                            _tickets -= 1;
+                        _admitted++;
+                        if (waited > 0) {
+                            _throttledOps++;
+                            _throttledMicros += waited;
+                        }
+                        return waited;
+                    }
+                    wait = static_cast<long long>((1 - _tickets) * 1000 * 1000 /
+                                                  _ticketsPerSecond) + 1;
+                }
+                // the rate is looked at again at least every 100ms
+                wait = std::min(wait, 100 * 1000LL);
+                sleepmicros(wait);
+                waited += wait;
+            }
+        }
+
+        void append(BSONObjBuilder& b) {
+            scoped_lock lk(_mutex);
+            b.append("enabled", flowControl);
+            b.append("targetLagSecs", flowControlTargetLagSeconds);
+            b.append("lagSecs", _lagSecs);
+            b.append("isThrottling", flowControl && _ticketsPerSecond != 0);
+            b.append("ticketsPerSecond", _ticketsPerSecond);
+            b.appendNumber("throttledOps", _throttledOps);
+            b.appendNumber("throttledMicros", _throttledMicros);
+        }
+
+    private:
+        /** @return the majority's lag behind this primary, or -1 if it isn't known */
+        static int majorityLagSecs() {
+            if (!theReplSet || !theReplSet->isPrimary())
+                return -1;
+            const OpTime majority = getMajorityReplicatedOpTime();
+            if (majority.isNull())
+                return -1;
+            const unsigned last = theReplSet->lastOpTimeWritten.getSecs();
+            return last > majority.getSecs() ? last - majority.getSecs() : 0;
+        }
+
+        void _adjust(unsigned long long now) {
+            if (now - _lastAdjust < 1000 * 1000)
+                return;
+            const double admittedPerSecond = _admitted * 1000.0 * 1000 / (now - _lastAdjust);
+            const int previousLagSecs = _lagSecs;
+            _lagSecs = majorityLagSecs();
+            _lastAdjust = now;
+            _admitted = 0;
+
+            if (!flowControl || _lagSecs < 0) {
+                _ticketsPerSecond = 0;
+                return;
+            }
+
+            const int target = flowControlTargetLagSeconds;
+            const double minRate = flowControlMinTicketsPerSecond;
+            if (_lagSecs > target && _lagSecs >= previousLagSecs) {
+                double rate = _ticketsPerSecond == 0 ? admittedPerSecond
+                                                     : std::min(_ticketsPerSecond,
+                                                                admittedPerSecond);
+                rate *= std::max(0.5, static_cast<double>(target) / _lagSecs);
+                if (_ticketsPerSecond == 0) {
+                    _tickets = 0;
+                    _lastRefill = now;
+                }
+                _ticketsPerSecond = std::max(minRate, rate);
+            }
+            else if (_ticketsPerSecond != 0 && _lagSecs * 2 <= target) {
+                if (_ticketsPerSecond > 2 * std::max(minRate, admittedPerSecond))
+                    _ticketsPerSecond = 0;
+                else
+                    _ticketsPerSecond *= 1.25;
+            }
+        }
+
+        /** @return the tickets there are now, up to a second's worth */
+        double _refill(unsigned long long now) {
+            _tickets = std::min(_ticketsPerSecond,
+                                _tickets + (now - _lastRefill) * _ticketsPerSecond / 1000000);
+            _lastRefill = now;
+            return _tickets;
+        }
+
+        mongo::mutex _mutex;
+        double _ticketsPerSecond; // 0 when not throttling
+        double _tickets;
+        unsigned long long _lastRefill;
+        unsigned long long _lastAdjust;
+        long long _admitted; // since the last adjustment
+        int _lagSecs;
+        long long _throttledOps;
+        long long _throttledMicros;
+    } flowControlTickets;
+
+    class FlowControlServerStatusSection : public ServerStatusSection {
+    public:
+        FlowControlServerStatusSection() : ServerStatusSection("flowControl") {}
+        bool includeByDefault() const { return true; }
+
+        BSONObj generateSection(const BSONElement& configElement) const {
+            if (!theReplSet)
+                return BSONObj();
+            BSONObjBuilder b;
+            flowControlTickets.append(b);
+            return b.obj();
+        }
+    } flowControlServerStatusSection;
+
+} // namespace
+
+    void waitForFlowControlTicket(const StringData& ns, CurOp& op) {
+        // writes made while already holding a lock, as through DBDirectClient, can't wait
+        if (!flowControl || !theReplSet || Lock::isLocked())
+            return;
+        if (nsToDatabaseSubstring(ns) == "local")
+            return;
+
+        const long long waited = flowControlTickets.acquire();
+        if (waited > 0)
+            op.debug().flowControlMicros = waited;
+    }
+
+} // namespace mongo
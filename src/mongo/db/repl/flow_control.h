@@ -0,0 +1,49 @@
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include "mongo/base/string_data.h"
+
+namespace mongo {
+
+    class CurOp;
+
+    /**
+     * Flow control: while the flowControl server parameter is set, a primary hands out write
+     * tickets at a rate that keeps a majority of the set within flowControlTargetLagSeconds of
+     * it, going by the optimes the secondaries report (see updateSlaveLocations).  Without it a
+     * bulk load can leave the secondaries hours behind, timing out w:majority writes and
+     * putting whatever a failover would roll back at risk.
+     *
+     * Waits, if writes to 'ns' are being throttled, for a ticket, and notes the time waited in
+     * the op's debug info.  Must be called without any lock held.
+     */
+    void waitForFlowControlTicket(const StringData& ns, CurOp& op);
+
+} // namespace mongo
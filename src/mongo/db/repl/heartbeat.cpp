@@ -92,6 +92,9 @@ namespace mongo {
             out->push_back(Privilege(ResourcePattern::forClusterResource(), actions));
         }
         virtual bool run(const string& , BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl) {
+            // heartbeats mustn't queue behind user operations, or members get marked down
+            Lock::ScopedPriority priority(Lock::priorityCritical);
+
             if( replSetBlind ) {
                 if (theReplSet) {
                     errmsg = str::stream() << theReplSet->selfFullName() << " is blind";
@@ -567,48 +567,58 @@ namespace mongo {
             BSONObj updateCriteria = o2;
             const bool upsert = valueB || convertUpdateToUpsert;
 
-            const NamespaceString requestNs(ns);
-            UpdateRequest request(requestNs, QueryPlanSelectionPolicy::idElseNatural());
-
-            request.setQuery(updateCriteria);
-            request.setUpdates(o);
-            request.setUpsert(upsert);
-            request.setFromReplication();
-
-            UpdateResult ur = update(request, &debug);
-
-            if( ur.numMatched == 0 ) {
-                if( ur.modifiers ) {
-                    if( updateCriteria.nFields() == 1 ) {
-                        // was a simple { _id : ... } update criteria
-                        failedUpdate = true;
-                        log() << "replication failed to apply update: " << op.toString() << endl;
-                    }
-                    // need to check to see if it isn't present so we can set failedUpdate correctly.
-                    // note that adds some overhead for this extra check in some cases, such as an updateCriteria
-                    // of the form
-                    //   { _id:..., { x : {$size:...} }
-                    // thus this is not ideal.
-                    else {
-                        if (nsd == NULL ||
-                            (nsd->findIdIndex() >= 0 && Helpers::findById(nsd, updateCriteria).isNull()) ||
-                            // capped collections won't have an _id index
-                            (nsd->findIdIndex() < 0 && Helpers::findOne(ns, updateCriteria, false).isNull())) {
+            if ( isDeltaUpdate(o) ) {
+                // a missing document matters to initial sync, which fetches it and retries;
+                // otherwise it is a replay after the document was deleted, like an upsert
+                if ( !applyDeltaUpdate(ns, updateCriteria, o, &debug) && !upsert ) {
+                    failedUpdate = true;
+                    log() << "replication couldn't find doc: " << op.toString() << endl;
+                }
+            }
+            else {
+                const NamespaceString requestNs(ns);
+                UpdateRequest request(requestNs, QueryPlanSelectionPolicy::idElseNatural());
+
+                request.setQuery(updateCriteria);
+                request.setUpdates(o);
+                request.setUpsert(upsert);
+                request.setFromReplication();
+
+                UpdateResult ur = update(request, &debug);
+
+                if( ur.numMatched == 0 ) {
+                    if( ur.modifiers ) {
+                        if( updateCriteria.nFields() == 1 ) {
+                            // was a simple { _id : ... } update criteria
                             failedUpdate = true;
-                            log() << "replication couldn't find doc: " << op.toString() << endl;
+                            log() << "replication failed to apply update: " << op.toString() << endl;
+                        }
+                        // need to check to see if it isn't present so we can set failedUpdate correctly.
+                        // note that adds some overhead for this extra check in some cases, such as an updateCriteria
+                        // of the form
+                        //   { _id:..., { x : {$size:...} }
+                        // thus this is not ideal.
+                        else {
+                            if (nsd == NULL ||
+                                (nsd->findIdIndex() >= 0 && Helpers::findById(nsd, updateCriteria).isNull()) ||
+                                // capped collections won't have an _id index
+                                (nsd->findIdIndex() < 0 && Helpers::findOne(ns, updateCriteria, false).isNull())) {
+                                failedUpdate = true;
+                                log() << "replication couldn't find doc: " << op.toString() << endl;
+                            }
+
+                            // Otherwise, it's present; zero objects were updated because of additional specifiers
+                            // in the query for idempotence
                         }
-
-                        // Otherwise, it's present; zero objects were updated because of additional specifiers
-                        // in the query for idempotence
                     }
-                }
-                else { 
-                    // this could happen benignly on an oplog duplicate replay of an upsert
-                    // (because we are idempotent), 
-                    // if an regular non-mod update fails the item is (presumably) missing.
-                    if( !upsert ) {
-                        failedUpdate = true;
-                        log() << "replication update of non-mod failed: " << op.toString() << endl;
+                    else { 
+                        // this could happen benignly on an oplog duplicate replay of an upsert
+                        // (because we are idempotent), 
+                        // if an regular non-mod update fails the item is (presumably) missing.
+                        if( !upsert ) {
+                            failedUpdate = true;
+                            log() << "replication update of non-mod failed: " << op.toString() << endl;
+                        }
                     }
                 }
             }
@@ -188,4 +188,12 @@ namespace mongo {
         tailingQuery(ns, query.done(), fields);
     }
 
+    void OplogReader::exhaustTailingQueryGTE(const char *ns, OpTime optime) {
+        int options = _tailingQueryOptions;
+        if (_conn->availableOptions() & QueryOption_Exhaust)
+            _tailingQueryOptions |= QueryOption_Exhaust;
+        tailingQueryGTE(ns, optime);
+        _tailingQueryOptions = options;
+    }
+
 }
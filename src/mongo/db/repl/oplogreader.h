@@ -119,6 +119,13 @@ namespace mongo {
 
         void tailingQueryGTE(const char *ns, OpTime t, const BSONObj* fields=0);
 
+        /**
+         * Like tailingQueryGTE, but with an exhaust cursor if the source supports them, so it
+         * streams batches as it has them instead of waiting for a getMore each.  Nothing else
+         * may use the connection afterwards; reset it when done.
+         */
+        void exhaustTailingQueryGTE(const char *ns, OpTime t);
+
         /* Do a tailing query, but only send the ts field back. */
         void ghostQueryGTE(const char *ns, OpTime t) {
             const BSONObj fields = BSON("ts" << 1 << "_id" << 0);
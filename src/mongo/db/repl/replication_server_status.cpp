@@ -42,6 +42,7 @@
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/db/wire_version.h"
+#include "mongo/util/net/message_compression.h"
 
 namespace mongo {
 
@@ -148,10 +149,30 @@ namespace mongo {
             
             BSONObjBuilder result;
             appendReplicationInfo(result, level);
+            if ( theReplSet ) {
+                BSONObjBuilder applier( result.subobjStart( "applier" ) );
+                replset::appendApplierStats( applier );
+                applier.done();
+            }
             return result.obj();
         }
     } replicationInfoServerStatus;
 
+    class ReplicationPipelineServerStatus : public ServerStatusSection {
+    public:
+        ReplicationPipelineServerStatus() : ServerStatusSection( "replPipeline" ){}
+        bool includeByDefault() const { return false; }
+
+        BSONObj generateSection(const BSONElement& configElement) const {
+            if ( ! theReplSet )
+                return BSONObj();
+
+            BSONObjBuilder result;
+            replset::appendPipelineStats( result );
+            return result.obj();
+        }
+    } replicationPipelineServerStatus;
+
     class CmdIsMaster : public Command {
     public:
         virtual bool requiresAuth() { return false; }
@@ -181,6 +202,7 @@ namespace mongo {
             result.appendDate("localTime", jsTime());
             result.append("maxWireVersion", maxWireVersion);
             result.append("minWireVersion", minWireVersion);
+            negotiateMessageCompression(cmdObj, cc().port(), result);
             return true;
         }
     } cmdismaster;
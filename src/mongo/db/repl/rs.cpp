@@ -52,14 +52,6 @@ namespace mongo {
     
     using namespace bson;
 
-#ifdef MONGO_PLATFORM_64
-    const int ReplSetImpl::replWriterThreadCount = 16;
-    const int ReplSetImpl::replPrefetcherThreadCount = 16;
-#else
-    const int ReplSetImpl::replWriterThreadCount = 2;
-    const int ReplSetImpl::replPrefetcherThreadCount = 2;
-#endif
-
     bool replSet = false;
     ReplSet *theReplSet = 0;
 
@@ -485,12 +477,29 @@ namespace {
         _maintenanceMode(0),
         mgr(0),
         ghost(0),
-        _writerPool(replWriterThreadCount),
-        _prefetcherPool(replPrefetcherThreadCount),
+        _writerPool(new threadpool::ThreadPool(replset::replWriterThreadCount)),
+        _writerThreads(replset::replWriterThreadCount),
+        _prefetcherPool(new threadpool::ThreadPool(replset::replPrefetcherThreadCount)),
+        _prefetcherThreads(replset::replPrefetcherThreadCount),
         oplogVersion(0),
         _indexPrefetchConfig(PREFETCH_ALL) {
     }
 
+    void ReplSetImpl::resizeReplPools(int writerThreads, int prefetcherThreads) {
+        if (writerThreads != _writerThreads) {
+            log() << "replSet resizing writer pool from " << _writerThreads << " to "
+                  << writerThreads << " threads" << rsLog;
+            _writerPool.reset(new threadpool::ThreadPool(writerThreads));
+            _writerThreads = writerThreads;
+        }
+        if (prefetcherThreads != _prefetcherThreads) {
+            log() << "replSet resizing prefetcher pool from " << _prefetcherThreads << " to "
+                  << prefetcherThreads << " threads" << rsLog;
+            _prefetcherPool.reset(new threadpool::ThreadPool(prefetcherThreads));
+            _prefetcherThreads = prefetcherThreads;
+        }
+    }
+
     ReplSet::ReplSet() {
     }
 
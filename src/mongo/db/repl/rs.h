@@ -30,6 +30,8 @@
 
 #pragma once
 
+#include <boost/scoped_ptr.hpp>
+
 #include "mongo/db/commands.h"
 #include "mongo/db/storage/index_details.h"
 #include "mongo/db/repl/oplogreader.h"
@@ -59,7 +61,6 @@
 
 namespace mongo {
 
-    class Cloner;
     class DBClientConnection;
     struct HowToFixUp;
     class ReplSetImpl;
@@ -543,7 +544,7 @@ namespace mongo {
         friend class Consensus;
 
     private:
-        bool _syncDoInitialSync_clone(Cloner &cloner, const char *master,
+        bool _syncDoInitialSync_clone(DBClientBase* source, const char *master,
                                       const list<string>& dbs, bool dataPass);
         bool _syncDoInitialSync_applyToHead( replset::SyncTail& syncer, OplogReader* r ,
                                              const Member* source, const BSONObj& lastOp,
@@ -558,9 +559,11 @@ namespace mongo {
         // keep a list of hosts that we've tried recently that didn't work
         map<string,time_t> _veto;
         // persistent pool of worker threads for writing ops to the databases
-        threadpool::ThreadPool _writerPool;
+        boost::scoped_ptr<threadpool::ThreadPool> _writerPool;
+        int _writerThreads;
         // persistent pool of worker threads for prefetching
-        threadpool::ThreadPool _prefetcherPool;
+        boost::scoped_ptr<threadpool::ThreadPool> _prefetcherPool;
+        int _prefetcherThreads;
 
     public:
         // Allow index prefetching to be turned on/off
@@ -575,10 +578,16 @@ namespace mongo {
             return _indexPrefetchConfig;
         }
             
-        static const int replWriterThreadCount;
-        static const int replPrefetcherThreadCount;
-        threadpool::ThreadPool& getPrefetchPool() { return _prefetcherPool; }
-        threadpool::ThreadPool& getWriterPool() { return _writerPool; }
+        int replWriterThreadCount() const { return _writerThreads; }
+        int replPrefetcherThreadCount() const { return _prefetcherThreads; }
+        threadpool::ThreadPool& getPrefetchPool() { return *_prefetcherPool; }
+        threadpool::ThreadPool& getWriterPool() { return *_writerPool; }
+
+        /**
+         * Replaces the pools whose size differs from the one given.  Only called by the sync
+         * thread between batches, when neither pool has work.
+         */
+        void resizeReplPools(int writerThreads, int prefetcherThreads);
 
         static const int maxSyncSourceLagSecs;
 
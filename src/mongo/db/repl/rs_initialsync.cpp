@@ -35,12 +35,15 @@
 #include "mongo/db/client.h"
 #include "mongo/db/cloner.h"
 #include "mongo/db/dbhelpers.h"
+#include "mongo/db/namespace_string.h"
 #include "mongo/db/repl/bgsync.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/oplogreader.h"
 #include "mongo/bson/optime.h"
 #include "mongo/db/repl/replication_server_status.h"  // replSettings
 #include "mongo/db/repl/rs_sync.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
@@ -81,44 +84,174 @@ namespace mongo {
         fassert( 16233, failedAttempts < maxFailedAttempts);
     }
 
-    bool ReplSetImpl::_syncDoInitialSync_clone(Cloner& cloner, const char *master,
-                                               const list<string>& dbs, bool dataPass) {
-
-        for( list<string>::const_iterator i = dbs.begin(); i != dbs.end(); i++ ) {
-            string db = *i;
-            if( db == "local" ) 
-                continue;
-            
-            if ( dataPass )
-                sethbmsg( str::stream() << "initial sync cloning db: " << db , 0);
-            else
-                sethbmsg( str::stream() << "initial sync cloning indexes for : " << db , 0);
-
-            Client::WriteContext ctx(db);
-
-            string err;
-            int errCode;
-            CloneOptions options;
-            options.fromDB = db;
-            options.logForRepl = false;
-            options.slaveOk = true;
-            options.useReplAuth = true;
-            options.snapshot = false;
-            options.mayYield = true;
-            options.mayBeInterrupted = false;
-            options.syncData = dataPass;
-            options.syncIndexes = ! dataPass;
-
-            if (!cloner.go(master, options, err, &errCode)) {
-                sethbmsg(str::stream() << "initial sync: error while "
-                                       << (dataPass ? "cloning " : "indexing ") << db
-                                       << ".  " << (err.empty() ? "" : err + ".  ")
-                                       << "sleeping 5 minutes" ,0);
-                return false;
+    // How many collections (for the data) or databases (for the indexes) initial sync clones at
+    // once, each over its own connection to the sync source.
+    MONGO_EXPORT_SERVER_PARAMETER(initialSyncCloneThreads, int, 1);
+
+    namespace {
+
+        /** What one Cloner::go() of initial sync copies: a database, or one collection of it. */
+        struct CloneItem {
+            CloneItem() {}
+            CloneItem(const string& db, const string& ns = "") : db(db), ns(ns) {}
+            string db;
+            string ns; // empty for the whole database
+        };
+
+        /**
+         * Lists the work of one pass of the clone.  The data pass is split by collection when there
+         * is more than one thread to share it, the index pass always by database.
+         */
+        list<CloneItem> cloneItems(DBClientBase* source, const list<string>& dbs,
+                                   bool byCollection) {
+            list<CloneItem> items;
+            for (list<string>::const_iterator i = dbs.begin(); i != dbs.end(); i++) {
+                if (*i == "local")
+                    continue;
+                if (!byCollection) {
+                    items.push_back(CloneItem(*i));
+                    continue;
+                }
+                auto_ptr<DBClientCursor> c = source->query(*i + ".system.namespaces", BSONObj(),
+                                                           0, 0, 0, QueryOption_SlaveOk);
+                isyncassert("couldn't list the collections of " + *i, c.get());
+                while (c->more()) {
+                    BSONObj o = c->nextSafe();
+                    string ns = o.getStringField("name");
+                    if (NamespaceString::normal(ns))
+                        items.push_back(CloneItem(*i, ns));
+                }
             }
+            return items;
         }
 
-        return true;
+        /**
+         * Clones items one after another on the calling thread, or on several threads each with a
+         * Cloner, and so a connection, of its own.  New items aren't started once one has failed.
+         */
+        class ParallelClone : boost::noncopyable {
+        public:
+            ParallelClone(const char* master, bool dataPass, const list<CloneItem>& items)
+                : _master(master), _dataPass(dataPass), _items(items), _mutex("ParallelClone"),
+                  _failed(false), _errorCode(0) {
+            }
+
+            bool run(int numThreads) {
+                if (numThreads <= 1) {
+                    Cloner cloner;
+                    for (list<CloneItem>::const_iterator i = _items.begin();
+                         i != _items.end();
+                         i++) {
+                        if (!cloneItem(cloner, *i))
+                            return false;
+                    }
+                    return true;
+                }
+
+                {
+                    ThreadPool threads(numThreads);
+                    for (int i = 0; i < numThreads; i++)
+                        threads.schedule(&ParallelClone::work, this);
+                } // joins
+
+                if (_errorCode != 0)
+                    throw UserException(_errorCode, _errorMessage);
+                return !_failed;
+            }
+
+        private:
+            /** on a pool thread */
+            void work() {
+                Client::initThread("initialSyncClone");
+                replLocalAuth();
+                try {
+                    Cloner cloner;
+                    CloneItem item;
+                    while (next(&item)) {
+                        if (!cloneItem(cloner, item)) {
+                            scoped_lock lk(_mutex);
+                            _failed = true;
+                        }
+                    }
+                }
+                catch (const DBException& e) {
+                    scoped_lock lk(_mutex);
+                    if (!_failed) {
+                        _errorCode = e.getCode();
+                        _errorMessage = e.what();
+                    }
+                    _failed = true;
+                }
+                Client::resetThread("initialSyncClonePool");
+            }
+
+            bool next(CloneItem* item) {
+                scoped_lock lk(_mutex);
+                if (_failed || _items.empty())
+                    return false;
+                *item = _items.front();
+                _items.pop_front();
+                return true;
+            }
+
+            void hbmsg(const string& s) {
+                scoped_lock lk(_mutex);
+                theReplSet->sethbmsg(s, 0);
+            }
+
+            bool cloneItem(Cloner& cloner, const CloneItem& item) {
+                string what = item.ns.empty() ? item.db : item.ns;
+                if (_dataPass)
+                    hbmsg(str::stream() << "initial sync cloning "
+                                        << (item.ns.empty() ? "db" : "collection") << ": " << what);
+                else
+                    hbmsg(str::stream() << "initial sync cloning indexes for : " << what);
+
+                Client::WriteContext ctx(item.db);
+
+                string err;
+                int errCode;
+                CloneOptions options;
+                options.fromDB = item.db;
+                if (!item.ns.empty())
+                    options.collsToClone.insert(item.ns);
+                options.logForRepl = false;
+                options.slaveOk = true;
+                options.useReplAuth = true;
+                options.snapshot = false;
+                options.mayYield = true;
+                options.mayBeInterrupted = false;
+                options.syncData = _dataPass;
+                options.syncIndexes = ! _dataPass;
+
+                if (!cloner.go(_master, options, err, &errCode)) {
+                    hbmsg(str::stream() << "initial sync: error while "
+                                        << (_dataPass ? "cloning " : "indexing ") << what
+                                        << ".  " << (err.empty() ? "" : err + ".  ")
+                                        << "sleeping 5 minutes");
+                    return false;
+                }
+                return true;
+            }
+
+            const char* _master;
+            const bool _dataPass;
+            list<CloneItem> _items;
+            mongo::mutex _mutex; // guards the below, and sethbmsg
+            bool _failed;
+            int _errorCode;
+            string _errorMessage;
+        };
+
+    } // namespace
+
+    bool ReplSetImpl::_syncDoInitialSync_clone(DBClientBase* source, const char *master,
+                                               const list<string>& dbs, bool dataPass) {
+        int threads = initialSyncCloneThreads;
+        list<CloneItem> items = cloneItems(source, dbs, dataPass && threads > 1);
+        if (threads > static_cast<int>(items.size()))
+            threads = items.size();
+        return ParallelClone(master, dataPass, items).run(threads);
     }
 
     void _logOpObjRS(const BSONObj& op);
@@ -410,8 +543,7 @@ namespace mongo {
 
             list<string> dbs = r.conn()->getDatabaseNames();
 
-            Cloner cloner;
-            if (!_syncDoInitialSync_clone(cloner, sourceHostname.c_str(), dbs, true)) {
+            if (!_syncDoInitialSync_clone(r.conn(), sourceHostname.c_str(), dbs, true)) {
                 veto(source->fullName(), 600);
                 sleepsecs(300);
                 return;
@@ -438,7 +570,7 @@ namespace mongo {
             lastOp = minValid;
 
             sethbmsg("initial sync building indexes",0);
-            if (!_syncDoInitialSync_clone(cloner, sourceHostname.c_str(), dbs, false)) {
+            if (!_syncDoInitialSync_clone(r.conn(), sourceHostname.c_str(), dbs, false)) {
                 veto(source->fullName(), 600);
                 sleepsecs(300);
                 return;
@@ -35,7 +35,10 @@
 #include "mongo/db/ops/update_request.h"
 #include "mongo/db/ops/delete.h"
 #include "mongo/db/repl/oplog.h"
+#include "mongo/db/repl/oplogreader.h"
 #include "mongo/db/repl/rs.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/concurrency/thread_pool.h"
 
 /* Scenarios
 
@@ -209,6 +212,166 @@ namespace mongo {
 
     int getRBID(DBClientConnection*);
 
+    // How many connections to the sync source refetch documents at once.
+    int rollbackRefetchThreads = 4;
+    BoundedIntParameter rollbackRefetchThreadsParameter(
+            ServerParameterSet::getGlobal(), "rollbackRefetchThreads", &rollbackRefetchThreads,
+            1, 64);
+
+namespace {
+
+    /** _ids of documents in one collection to refetch with one query. */
+    struct RefetchBatch {
+        RefetchBatch() : ns(NULL) {}
+        const char* ns;
+        vector<be> ids;
+    };
+
+    /**
+     * Refetches the documents of HowToFixUp::toRefetch from the sync source with one $in query
+     * per batch of _ids of a collection, rather than a findOne per document, running the
+     * queries on several connections to the source at once.
+     */
+    class ParallelRefetch : boost::noncopyable {
+    public:
+        static const size_t maxBatchIds = 1000;
+        static const int maxBatchIdBytes = 1024 * 1024;
+
+        ParallelRefetch(DBClientConnection* them, const set<DocID>& toRefetch)
+            : _them(them), _toRefetch(toRefetch), _mutex("ParallelRefetch"), _totSize(0),
+              _failed(false), _errorCode(0) {
+            RefetchBatch batch;
+            int idBytes = 0;
+            for (set<DocID>::const_iterator i = toRefetch.begin(); i != toRefetch.end(); i++) {
+                verify( !i->_id.eoo() );
+                if (batch.ns &&
+                    (strcmp(batch.ns, i->ns) != 0 ||
+                     batch.ids.size() >= maxBatchIds ||
+                     idBytes >= maxBatchIdBytes ||
+                     i->_id.type() == RegEx)) {
+                    _batches.push_back(batch);
+                    batch = RefetchBatch();
+                    idBytes = 0;
+                }
+                batch.ns = i->ns;
+                batch.ids.push_back(i->_id);
+                idBytes += i->_id.size();
+                // a regex in $in matches by pattern, so that _id is fetched on its own
+                if (i->_id.type() == RegEx) {
+                    _batches.push_back(batch);
+                    batch = RefetchBatch();
+                    idBytes = 0;
+                }
+            }
+            if (batch.ns)
+                _batches.push_back(batch);
+        }
+
+        /**
+         * Fills 'goodVersions' with every document's version on the source, or an empty
+         * object for those the source doesn't have.
+         */
+        void run(int numThreads, map<DocID,bo>* goodVersions) {
+            _goodVersions = goodVersions;
+            for (set<DocID>::const_iterator i = _toRefetch.begin(); i != _toRefetch.end(); i++)
+                (*goodVersions)[*i] = bo();
+
+            if (numThreads > static_cast<int>(_batches.size()))
+                numThreads = _batches.size();
+            if (numThreads <= 1) {
+                RefetchBatch batch;
+                while (next(&batch))
+                    fetch(_them, batch);
+                return;
+            }
+
+            {
+                ThreadPool threads(numThreads);
+                for (int i = 0; i < numThreads; i++)
+                    threads.schedule(&ParallelRefetch::work, this);
+            } // joins
+
+            if (_failed)
+                throw UserException(_errorCode, _errorMessage);
+        }
+
+    private:
+        /** on a pool thread */
+        void work() {
+            try {
+                OplogReader source;
+                uassert(17366, str::stream() << "replSet rollback couldn't connect to "
+                                             << _them->getServerAddress(),
+                        source.connect(_them->getServerAddress()));
+                RefetchBatch batch;
+                while (next(&batch))
+                    fetch(source.conn(), batch);
+            }
+            catch (const DBException& e) {
+                scoped_lock lk(_mutex);
+                if (!_failed) {
+                    _errorCode = e.getCode();
+                    _errorMessage = e.what();
+                }
+                _failed = true;
+            }
+        }
+
+        bool next(RefetchBatch* batch) {
+            scoped_lock lk(_mutex);
+            if (_failed || _batches.empty())
+                return false;
+            *batch = _batches.front();
+            _batches.pop_front();
+            return true;
+        }
+
+        void fetch(DBClientBase* conn, const RefetchBatch& batch) {
+            BSONObjBuilder query;
+            if (batch.ids.size() == 1) {
+                query.appendAs(batch.ids[0], "_id");
+            }
+            else {
+                BSONObjBuilder id(query.subobjStart("_id"));
+                BSONArrayBuilder in(id.subarrayStart("$in"));
+                for (vector<be>::const_iterator i = batch.ids.begin(); i != batch.ids.end(); i++)
+                    in.append(*i);
+                in.done();
+                id.done();
+            }
+
+            auto_ptr<DBClientCursor> cursor =
+                conn->query(batch.ns, query.obj(), 0, 0, NULL, QueryOption_SlaveOk);
+            uassert(17367, str::stream() << "replSet rollback couldn't query " << batch.ns,
+                    cursor.get());
+            while (cursor->more()) {
+                bo good = cursor->nextSafe().getOwned();
+                DocID d;
+                d.ns = batch.ns;
+                d._id = good["_id"];
+
+                scoped_lock lk(_mutex);
+                _totSize += good.objsize();
+                uassert( 13410, "replSet too much data to roll back", _totSize < 300 * 1024 * 1024 );
+                map<DocID,bo>::iterator i = _goodVersions->find(d);
+                if (i != _goodVersions->end())
+                    i->second = good;
+            }
+        }
+
+        DBClientConnection* _them;
+        const set<DocID>& _toRefetch;
+        list<RefetchBatch> _batches;
+        map<DocID,bo>* _goodVersions;
+        mongo::mutex _mutex; // guards the above and the below
+        unsigned long long _totSize;
+        bool _failed;
+        int _errorCode;
+        string _errorMessage;
+    };
+
+} // namespace
+
     static void syncRollbackFindCommonPoint(DBClientConnection *them, HowToFixUp& h) {
         verify( Lock::isLocked() );
         Client::Context c(rsoplog);
@@ -322,32 +485,18 @@ namespace mongo {
 
         // fetch all first so we needn't handle interruption in a fancy way
 
-        unsigned long long totSize = 0;
-
-        list< pair<DocID,bo> > goodVersions;
+        // ordered like toRefetch, so by collection
+        map<DocID,bo> goodVersions;
 
         bo newMinValid;
 
         /* fetch all the goodVersions of each document from current primary */
-        DocID d;
-        unsigned long long n = 0;
         try {
-            for( set<DocID>::iterator i = h.toRefetch.begin(); i != h.toRefetch.end(); i++ ) {
-                d = *i;
-
-                verify( !d._id.eoo() );
-
-                {
-                    /* TODO : slow.  lots of round trips. */
-                    n++;
-                    bo good= them->findOne(d.ns, d._id.wrap(), NULL, QueryOption_SlaveOk).getOwned();
-                    totSize += good.objsize();
-                    uassert( 13410, "replSet too much data to roll back", totSize < 300 * 1024 * 1024 );
-
-                    // note good might be eoo, indicating we should delete it
-                    goodVersions.push_back(pair<DocID,bo>(d,good));
-                }
-            }
+            sethbmsg(str::stream() << "rollback 3 refetching " << h.toRefetch.size()
+                                   << " documents");
+            ParallelRefetch refetcher(them, h.toRefetch);
+            // note a good version might be empty, indicating we should delete it
+            refetcher.run(rollbackRefetchThreads, &goodVersions);
             newMinValid = r.getLastOp(rsoplog);
             if( newMinValid.isEmpty() ) {
                 sethbmsg("rollback error newMinValid empty?");
@@ -356,7 +505,7 @@ namespace mongo {
         }
         catch(DBException& e) {
             sethbmsg(str::stream() << "rollback re-get objects: " << e.toString(),0);
-            log() << "rollback couldn't re-get ns:" << d.ns << " _id:" << d._id << ' ' << n << '/' << h.toRefetch.size() << rsLog;
+            log() << "rollback couldn't re-get " << h.toRefetch.size() << " documents" << rsLog;
             throw e;
         }
 
@@ -455,8 +604,12 @@ namespace mongo {
 
         map<string,shared_ptr<Helpers::RemoveSaver> > removeSavers;
 
+        // one context for each collection's run of documents
+        boost::scoped_ptr<Client::Context> collectionContext;
+        const char* contextNs = NULL;
+
         unsigned deletes = 0, updates = 0;
-        for( list<pair<DocID,bo> >::iterator i = goodVersions.begin(); i != goodVersions.end(); i++ ) {
+        for( map<DocID,bo>::iterator i = goodVersions.begin(); i != goodVersions.end(); i++ ) {
             const DocID& d = i->first;
             bo pattern = d._id.wrap(); // { _id : ... }
             try {
@@ -473,8 +626,12 @@ namespace mongo {
                 if ( ! rs )
                     rs.reset( new Helpers::RemoveSaver( "rollback" , "" , d.ns ) );
 
-                // todo: lots of overhead in context, this can be faster
-                Client::Context c(d.ns);
+                if( !contextNs || strcmp(contextNs, d.ns) != 0 ) {
+                    collectionContext.reset();
+                    contextNs = NULL;
+                    collectionContext.reset(new Client::Context(d.ns));
+                    contextNs = d.ns;
+                }
 
                 // Add the doc to our rollback file
                 BSONObj obj;
@@ -576,6 +733,7 @@ namespace mongo {
             }
         }
 
+        collectionContext.reset();
         removeSavers.clear(); // this effectively closes all of them
 
         sethbmsg(str::stream() << "rollback 5 d:" << deletes << " u:" << updates);
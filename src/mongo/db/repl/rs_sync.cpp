@@ -37,13 +37,21 @@
 #include "mongo/db/client.h"
 #include "mongo/db/commands/fsync.h"
 #include "mongo/db/d_concurrency.h"
+#include "mongo/db/database.h"
+#include "mongo/db/database_holder.h"
+#include "mongo/db/hasher.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/prefetch.h"
 #include "mongo/db/repl/bgsync.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/repl/rs_sync.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/stats/counters.h"
+#include "mongo/db/stats/op_latency.h"
 #include "mongo/db/storage_options.h"
+#include "mongo/db/structure/collection.h"
+#include "mongo/platform/bits.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/stats/timer_stats.h"
@@ -66,6 +74,8 @@ namespace mongo {
 namespace replset {
 
     MONGO_FP_DECLARE(rsSyncApplyStop);
+    // holds each batch open once its readers are blocked, for tests
+    MONGO_FP_DECLARE(rsSyncHoldBatch);
 
     // Number and time of each ApplyOps worker pool round
     static TimerStats applyBatchStats;
@@ -77,6 +87,180 @@ namespace replset {
     static ServerStatusMetricField<Counter64> displayOpsApplied( "repl.apply.ops",
                                                                 &opsAppliedStats );
 
+#ifdef MONGO_PLATFORM_64
+    int replWriterThreadCount = 16;
+    int replPrefetcherThreadCount = 16;
+#else
+    int replWriterThreadCount = 2;
+    int replPrefetcherThreadCount = 2;
+#endif
+    // Cap the batches using the limit on journal commits.
+    // This works out to be 100 MB (64 bit) or 50 MB (32 bit)
+    int replBatchLimitBytes = dur::UncommittedBytesLimit;
+    int replBatchLimitSeconds = 1;
+    int replBatchLimitOperations = 5000;
+
+    // Sizes the writer pool from what the batches take, up to replWriterThreadCount.
+    MONGO_EXPORT_SERVER_PARAMETER(replWriterThreadCountAuto, bool, false);
+
+namespace {
+
+    const int maxReplThreadCount = 256;
+
+    BoundedIntParameter writerThreadCountParameter(
+            ServerParameterSet::getGlobal(), "replWriterThreadCount", &replWriterThreadCount,
+            1, maxReplThreadCount);
+    BoundedIntParameter prefetcherThreadCountParameter(
+            ServerParameterSet::getGlobal(), "replPrefetcherThreadCount",
+            &replPrefetcherThreadCount, 1, maxReplThreadCount);
+    BoundedIntParameter batchLimitBytesParameter(
+            ServerParameterSet::getGlobal(), "replBatchLimitBytes", &replBatchLimitBytes,
+            1024 * 1024, dur::UncommittedBytesLimit);
+    BoundedIntParameter batchLimitSecondsParameter(
+            ServerParameterSet::getGlobal(), "replBatchLimitSeconds", &replBatchLimitSeconds,
+            1, 60);
+    BoundedIntParameter batchLimitOperationsParameter(
+            ServerParameterSet::getGlobal(), "replBatchLimitOperations",
+            &replBatchLimitOperations, 1, 1000 * 1000);
+
+    /**
+     * Keeps what the last batch took, and picks the writer pool size from it when
+     * replWriterThreadCountAuto is set.  The pool doubles, up to replWriterThreadCount, while
+     * this member falls behind with applying, rather than fetching, holding it back and most
+     * writers busy.  It halves once batches have arrived current for a while without needing
+     * half of their writers.
+     */
+    class ApplierStats {
+    public:
+        ApplierStats() : _mutex("replApplierStats"), _autoWriters(0), _quietBatches(0),
+                         _lastOps(0), _lastWritersUsed(0), _lastApplyMillis(0), _lastLagSecs(0) {
+        }
+
+        /** for the next batch; sync thread only */
+        int writerThreads() {
+            scoped_lock lk(_mutex);
+            if (!replWriterThreadCountAuto) {
+                _autoWriters = 0;
+                return replWriterThreadCount;
+            }
+            if (_autoWriters == 0 || _autoWriters > replWriterThreadCount)
+                _autoWriters = replWriterThreadCount;
+            return _autoWriters;
+        }
+
+        void noteBatch(const std::deque<BSONObj>& ops,
+                       const std::vector< std::vector<BSONObj> >& writerVectors,
+                       int applyMillis) {
+            int writers = writerVectors.size();
+            int writersUsed = 0;
+            for (size_t i = 0; i < writerVectors.size(); i++) {
+                if (!writerVectors[i].empty())
+                    writersUsed++;
+            }
+            int lagSecs = static_cast<int>(time(0)) - theReplSet->myConfig().slaveDelay -
+                    static_cast<int>(ops.back()["ts"]._opTime().getSecs());
+            if (lagSecs < 0)
+                lagSecs = 0;
+
+            scoped_lock lk(_mutex);
+            _lastOps = ops.size();
+            _lastWritersUsed = writersUsed;
+            _lastApplyMillis = applyMillis;
+            _lastLagSecs = lagSecs;
+            if (_autoWriters == 0)
+                return;
+
+            if (lagSecs >= behindSecs && applyMillis >= slowApplyMillis &&
+                writersUsed * 4 >= writers * 3 && writers < replWriterThreadCount) {
+                _autoWriters = std::min(writers * 2, replWriterThreadCount);
+                _quietBatches = 0;
+            }
+            else if (lagSecs == 0 && writersUsed * 2 <= writers && writers > 1) {
+                if (++_quietBatches >= quietBatchesToShrink) {
+                    _autoWriters = writers / 2;
+                    _quietBatches = 0;
+                }
+            }
+            else {
+                _quietBatches = 0;
+            }
+        }
+
+        void append(BSONObjBuilder& b) {
+            scoped_lock lk(_mutex);
+            b.append("writerThreads", theReplSet->replWriterThreadCount());
+            b.append("prefetcherThreads", theReplSet->replPrefetcherThreadCount());
+            b.appendBool("writerThreadCountAuto", _autoWriters != 0);
+            {
+                BSONObjBuilder limits(b.subobjStart("batchLimits"));
+                limits.append("operations", replBatchLimitOperations);
+                limits.append("bytes", replBatchLimitBytes);
+                limits.append("seconds", replBatchLimitSeconds);
+                limits.done();
+            }
+            BSONObjBuilder last(b.subobjStart("lastBatch"));
+            last.appendNumber("ops", static_cast<long long>(_lastOps));
+            last.append("writersUsed", _lastWritersUsed);
+            last.append("applyMillis", _lastApplyMillis);
+            last.append("lagSecs", _lastLagSecs);
+            last.done();
+        }
+
+    private:
+        static const int behindSecs = 2;
+        static const int slowApplyMillis = 100;
+        static const int quietBatchesToShrink = 50;
+
+        mongo::mutex _mutex;
+        int _autoWriters; // 0 unless sized automatically
+        int _quietBatches;
+        size_t _lastOps;
+        int _lastWritersUsed;
+        int _lastApplyMillis;
+        int _lastLagSecs;
+    } applierStats;
+
+    const char* const pipelineStageNames[NUM_PIPELINE_STAGES] = {
+        "fetch", "bufferFullWait", "bufferEmptyWait", "prefetch", "apply", "oplogWrite"
+    };
+
+    LatencyHistogram pipelineStageLatencies[NUM_PIPELINE_STAGES];
+
+    // ops of the batch the sync thread is working on; 0 between batches
+    AtomicUInt64 pipelineBatchOps;
+
+    /** Records the time from construction to destruction against a pipeline stage. */
+    class PipelineStageTimer {
+    public:
+        explicit PipelineStageTimer(PipelineStage stage) : _stage(stage) { }
+        ~PipelineStageTimer() { notePipelineStage(_stage, _timer.micros()); }
+    private:
+        const PipelineStage _stage;
+        Timer _timer;
+    };
+
+} // namespace
+
+    void appendApplierStats(BSONObjBuilder& b) {
+        applierStats.append(b);
+    }
+
+    void notePipelineStage(PipelineStage stage, unsigned long long micros) {
+        pipelineStageLatencies[stage].record(micros);
+    }
+
+    void appendPipelineStats(BSONObjBuilder& b) {
+        for (int i = 0; i < NUM_PIPELINE_STAGES; i++) {
+            BSONObjBuilder stage(b.subobjStart(pipelineStageNames[i]));
+            pipelineStageLatencies[i].append(stage);
+            stage.done();
+        }
+        BSONObjBuilder queued(b.subobjStart("queued"));
+        BackgroundSync::appendBufferStats(queued);
+        queued.appendNumber("batchOps", static_cast<long long>(pipelineBatchOps.load()));
+        queued.done();
+    }
+
 
     SyncTail::SyncTail(BackgroundSyncInterface *q) :
         Sync(""), oplogVersion(0), _networkQueue(q)
@@ -128,9 +312,71 @@ namespace replset {
         return ok;
     }
 
+    void SyncTail::syncApplyInserts(std::vector<BSONObj>::const_iterator begin,
+                                    std::vector<BSONObj>::const_iterator end,
+                                    bool convertUpdateToUpsert) {
+        const char* ns = begin->getStringField("ns");
+        Lock::DBWrite lk(ns);
+        Client::Context ctx(ns, storageGlobalParams.dbpath);
+        ctx.getClient()->curop()->reset();
+
+        IndexCatalog* batch = NULL;
+        try {
+            for (std::vector<BSONObj>::const_iterator it = begin; it != end; ++it) {
+                bool inserted = false;
+                // The first op may create the collection, so look for it every time.
+                Collection* collection = ctx.db()->getCollection(ns);
+                if (collection &&
+                    !collection->details()->isCapped() &&
+                    collection->details()->findIdIndex() >= 0) {
+                    if (!batch) {
+                        batch = collection->getIndexCatalog();
+                        batch->beginBatchInsert();
+                    }
+                    try {
+                        inserted = collection->insertDocument(it->getObjectField("o"), false).isOK();
+                    }
+                    catch (const UserException& e) {
+                        if (e.getCode() != ASSERT_ID_DUPKEY)
+                            throw;
+                        // replayed; the upsert below replaces what is there
+                    }
+                }
+
+                if (inserted) {
+                    replOpCounters.gotInsert();
+                }
+                else {
+                    // The upsert must see every key inserted so far.
+                    if (batch) {
+                        batch->finishBatchInsert();
+                        batch = NULL;
+                    }
+                    applyOperation_inlock(*it, true, convertUpdateToUpsert);
+                }
+                opsAppliedStats.increment();
+
+                // A document and its keys must go to the journal in the same group commit.
+                if (batch && getDur().aCommitIsNeeded()) {
+                    batch->finishBatchInsert();
+                    batch = NULL;
+                }
+                getDur().commitIfNeeded();
+            }
+        }
+        catch (...) {
+            if (batch)
+                batch->finishBatchInsert();
+            throw;
+        }
+        if (batch)
+            batch->finishBatchInsert();
+    }
+
     void initializePrefetchThread() {
         if (!ClientBasic::getCurrent()) {
             Client::initThread("repl prefetch worker");
+            Lock::setThreadPriority(Lock::priorityCritical);
             replLocalAuth();
         }
     }
@@ -143,10 +389,35 @@ namespace replset {
             Client::initThread( threadName.c_str() );
             // allow us to get through the magic barrier
             Lock::ParallelBatchWriterMode::iAmABatchParticipant();
+            Lock::setThreadPriority(Lock::priorityCritical);
             replLocalAuth();
         }
     }
 
+    /**
+     * @return the end of the run of inserts starting at 'it' that go to the same collection
+     * and can be applied together by SyncTail::syncApplyInserts, which is 'it' itself if
+     * that op can't start one.
+     */
+    static std::vector<BSONObj>::const_iterator insertRunEnd(
+            std::vector<BSONObj>::const_iterator it,
+            std::vector<BSONObj>::const_iterator end) {
+        const std::vector<BSONObj>::const_iterator begin = it;
+        const StringData ns = it->getStringField("ns");
+        if (strcmp(it->getStringField("op"), "i") != 0 ||
+            ns.find('.') == std::string::npos ||
+            !NamespaceString::normal(ns) ||
+            nsToCollectionSubstring(ns) == "system.indexes")
+            return begin;
+        for (; it != end; ++it) {
+            if (strcmp(it->getStringField("op"), "i") != 0 ||
+                ns != it->getStringField("ns") ||
+                !it->getObjectField("o").hasField("_id"))
+                break;
+        }
+        return it;
+    }
+
     // This free function is used by the writer threads to apply each op
     void multiSyncApply(const std::vector<BSONObj>& ops, SyncTail* st) {
         initializeWriterThread();
@@ -159,6 +430,13 @@ namespace replset {
              it != ops.end();
              ++it) {
             try {
+                // Consecutive inserts into one collection go in as a batch.
+                std::vector<BSONObj>::const_iterator runEnd = insertRunEnd(it, ops.end());
+                if (runEnd - it > 1) {
+                    st->syncApplyInserts(it, runEnd, convertUpdatesToUpserts);
+                    it = runEnd - 1;
+                    continue;
+                }
                 if (!st->syncApply(*it, convertUpdatesToUpserts)) {
                     fassertFailedNoTrace(16359);
                 }
@@ -203,7 +481,7 @@ namespace replset {
 
 
     // The pool threads call this to prefetch each op
-    void SyncTail::prefetchOp(const BSONObj& op) {
+    void SyncTail::prefetchOp(const BSONObj& op, PrefetchBatch* batch) {
         initializePrefetchThread();
 
         const char *ns = op.getStringField("ns");
@@ -212,7 +490,7 @@ namespace replset {
                 // one possible tweak here would be to stay in the read lock for this database 
                 // for multiple prefetches if they are for the same database.
                 Client::ReadContext ctx(ns);
-                prefetchPagesForReplicatedOp(op);
+                prefetchPagesForReplicatedOp(op, batch);
             }
             catch (const DBException& e) {
                 LOG(2) << "ignoring exception in prefetchOp(): " << e.what() << endl;
@@ -226,11 +504,13 @@ namespace replset {
 
     // Doles out all the work to the reader pool threads and waits for them to complete
     void SyncTail::prefetchOps(const std::deque<BSONObj>& ops) {
+        PipelineStageTimer timer(STAGE_PREFETCH);
         threadpool::ThreadPool& prefetcherPool = theReplSet->getPrefetchPool();
+        PrefetchBatch batch;
         for (std::deque<BSONObj>::const_iterator it = ops.begin();
              it != ops.end();
              ++it) {
-            prefetcherPool.schedule(&prefetchOp, *it);
+            prefetcherPool.schedule(&prefetchOp, *it, &batch);
         }
         prefetcherPool.join();
     }
@@ -251,28 +531,123 @@ namespace replset {
     }
 
     // Doles out all the work to the writer pool threads and waits for them to complete
+    /**
+     * Collects the databases the ops of a batch write.  @return false if the batch could write
+     * others too: commands can reach across databases.
+     */
+    static bool batchDatabases(const std::deque<BSONObj>& ops, std::set<std::string>* dbs) {
+        for (std::deque<BSONObj>::const_iterator it = ops.begin(); it != ops.end(); ++it) {
+            const char* opType = it->getStringField("op");
+            if (*opType == 'c')
+                return false;
+            if (*opType == 'n')
+                continue;
+            StringData ns = it->getStringField("ns");
+            if (ns.empty())
+                return false;
+            dbs->insert(nsToDatabase(ns));
+        }
+        return true;
+    }
+
     void SyncTail::multiApply( std::deque<BSONObj>& ops, MultiSyncApplyFunc applyFunc ) {
+        pipelineBatchOps.store(ops.size());
+
+        // Both pools are idle between batches, so this is where they change size.
+        theReplSet->resizeReplPools(applierStats.writerThreads(), replPrefetcherThreadCount);
 
         // Use a ThreadPool to prefetch all the operations in a batch.
         prefetchOps(ops);
         
-        std::vector< std::vector<BSONObj> > writerVectors(theReplSet->replWriterThreadCount);
+        std::vector< std::vector<BSONObj> > writerVectors(theReplSet->replWriterThreadCount());
         fillWriterVectors(ops, &writerVectors);
         LOG(2) << "replication batch size is " << ops.size() << endl;
         // We must grab this because we're going to grab write locks later.
         // We hold this mutex the entire time we're writing; it doesn't matter
-        // because all readers are blocked anyway.
+        // because readers don't need it.
         SimpleMutex::scoped_lock fsynclk(filesLockedFsync);
 
-        // stop all readers until we're done
-        Lock::ParallelBatchWriterMode pbwm;
+        // stop the readers of what we write until we're done
+        std::set<std::string> dbs;
+        scoped_ptr<Lock::ParallelBatchWriterMode> pbwm;
+        if (batchDatabases(ops, &dbs))
+            pbwm.reset(new Lock::ParallelBatchWriterMode(dbs));
+        else
+            pbwm.reset(new Lock::ParallelBatchWriterMode());
+
+        while (MONGO_FAIL_POINT(rsSyncHoldBatch)) {
+            sleepmillis(10);
+        }
 
+        Timer applyTimer;
         applyOps(writerVectors, applyFunc);
+        notePipelineStage(STAGE_APPLY, applyTimer.micros());
+        applierStats.noteBatch(ops, writerVectors, applyTimer.millis());
     }
 
 
+namespace {
+
+    /** The _id of the one document an insert, update or delete writes, or eoo. */
+    BSONElement opDocumentId(const BSONObj& op) {
+        const char* opType = op.getStringField("op");
+        if (opType[0] == '\0' || opType[1] != '\0')
+            return BSONElement();
+        switch (opType[0]) {
+        case 'i':
+        case 'd':
+            return op.getObjectField("o")["_id"];
+        case 'u':
+            return op.getObjectField("o2")["_id"];
+        default:
+            return BSONElement();
+        }
+    }
+
+    /**
+     * Whether the ops of one collection can be spread over the writers by document.  Capped
+     * collections have to keep their insertion order, and a unique index other than _id could
+     * see two documents transiently collide if their ops are applied out of order.
+     */
+    bool canSplitByDocument(const string& ns) {
+        if (ns.empty() || !NamespaceString::normal(ns) || NamespaceString(ns).isSystem())
+            return false;
+        Lock::DBRead lk(ns);
+        Database* db = dbHolder().get(ns, storageGlobalParams.dbpath);
+        Collection* collection = db ? db->getCollection(ns) : NULL;
+        if (!collection)
+            return true; // to be created by an insert of this batch
+        NamespaceDetails* d = collection->details();
+        if (d->isCapped())
+            return false;
+        NamespaceDetails::IndexIterator i = d->ii(true);
+        while (i.more()) {
+            IndexDetails& idx = i.next();
+            if (idx.unique() && !idx.isIdIndex())
+                return false;
+        }
+        return true;
+    }
+
+} // namespace
+
     void SyncTail::fillWriterVectors(const std::deque<BSONObj>& ops, 
                                               std::vector< std::vector<BSONObj> >* writerVectors) {
+        // Ops on the same document keep their order by landing on the same writer.  A
+        // collection with an op that doesn't name its document, or that can't be split, has all
+        // of its ops go to one writer, in order, as if by namespace alone.
+        std::map<string, bool> splitByDocument;
+        for (std::deque<BSONObj>::const_iterator it = ops.begin();
+             it != ops.end();
+             ++it) {
+            string ns = it->getStringField("ns");
+            std::map<string, bool>::iterator split = splitByDocument.find(ns);
+            if (split == splitByDocument.end())
+                split = splitByDocument.insert(make_pair(ns, canSplitByDocument(ns))).first;
+            if (split->second && opDocumentId(*it).eoo())
+                split->second = false;
+        }
+
         for (std::deque<BSONObj>::const_iterator it = ops.begin();
              it != ops.end();
              ++it) {
@@ -283,6 +658,14 @@ namespace replset {
             uint32_t hash = 0;
             MurmurHash3_x86_32( ns, len, 0, &hash);
 
+            if (splitByDocument[ns]) {
+                // hashed by canonical type, so _ids that compare equal go together
+                unsigned long long docHash =
+                        BSONElementHasher::hash64(opDocumentId(*it), hash);
+                (*writerVectors)[docHash % writerVectors->size()].push_back(*it);
+                continue;
+            }
+
             (*writerVectors)[hash % writerVectors->size()].push_back(*it);
         }
     }
@@ -312,7 +695,7 @@ namespace replset {
         while( ts < minValid ) {
             OpQueue ops;
 
-            while (ops.getSize() < replBatchLimitBytes) {
+            while (ops.getSize() < static_cast<size_t>(replBatchLimitBytes)) {
                 if (tryPopAndWaitForMore(&ops)) {
                     break;
                 }
@@ -322,7 +705,7 @@ namespace replset {
                 if (!ops.empty()) {
                     if (now > replBatchLimitSeconds)
                         break;
-                    if (ops.getDeque().size() > replBatchLimitOperations)
+                    if (ops.getDeque().size() > static_cast<size_t>(replBatchLimitOperations))
                         break;
                 }
             }
@@ -408,7 +791,7 @@ namespace replset {
                 if (!ops.empty()) {
                     if (now > replBatchLimitSeconds)
                         break;
-                    if (ops.getDeque().size() > replBatchLimitOperations)
+                    if (ops.getDeque().size() > static_cast<size_t>(replBatchLimitOperations))
                         break;
                 }
                 // occasionally check some things
@@ -457,7 +840,7 @@ namespace replset {
                 // keep fetching more ops as long as we haven't filled up a full batch yet
             } while (!tryPopAndWaitForMore(&ops) && // tryPopAndWaitForMore returns true 
                                                     // when we need to end a batch early
-                   (ops.getSize() < replBatchLimitBytes));
+                   (ops.getSize() < static_cast<size_t>(replBatchLimitBytes)));
 
             // For pausing replication in tests
             while (MONGO_FAIL_POINT(rsSyncApplyStop)) {
@@ -503,6 +886,7 @@ namespace replset {
             // if we don't have anything in the queue, wait a bit for something to appear
             if (ops->empty()) {
                 // block up to 1 second
+                PipelineStageTimer timer(STAGE_BUFFER_EMPTY);
                 _networkQueue->waitForMore();
                 return false;
             }
@@ -561,6 +945,7 @@ namespace replset {
 
     void SyncTail::applyOpsToOplog(std::deque<BSONObj>* ops) {
         {
+            PipelineStageTimer timer(STAGE_OPLOG_WRITE);
             Lock::DBWrite lk("local");
             while (!ops->empty()) {
                 const BSONObj& op = ops->front();
@@ -569,6 +954,7 @@ namespace replset {
                 ops->pop_front();
              }
         }
+        pipelineBatchOps.store(0);
 
         // Update write concern on primary
         BackgroundSync::notify();
@@ -802,6 +1188,7 @@ namespace replset {
         n++;
 
         Client::initThread("rsSync");
+        Lock::setThreadPriority(Lock::priorityCritical);
         replLocalAuth();
         theReplSet->syncThread();
         cc().shutdown();
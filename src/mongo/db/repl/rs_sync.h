@@ -38,10 +38,49 @@
 #include "mongo/util/concurrency/thread_pool.h"
 
 namespace mongo {
+
+    class PrefetchBatch;
+
 namespace replset {
 
     class BackgroundSyncInterface;
 
+    // Server parameters sizing the writer and prefetcher pools and limiting each batch of ops.
+    // All can be changed at runtime and take effect from the next batch.
+    extern int replWriterThreadCount;
+    extern int replPrefetcherThreadCount;
+    extern bool replWriterThreadCountAuto;
+    extern int replBatchLimitOperations;
+    extern int replBatchLimitBytes;
+    extern int replBatchLimitSeconds;
+
+    /** Appends the pool sizes and what the last batch took, for serverStatus. */
+    void appendApplierStats(BSONObjBuilder& b);
+
+    /**
+     * The stages a batch of ops goes through on a secondary, in order.  The producer fetches
+     * batches from the sync source and waits for room in the buffer; the sync thread waits for
+     * ops in the buffer, then prefetches, applies and writes each batch to the local oplog.
+     */
+    enum PipelineStage {
+        STAGE_FETCH,
+        STAGE_BUFFER_FULL,
+        STAGE_BUFFER_EMPTY,
+        STAGE_PREFETCH,
+        STAGE_APPLY,
+        STAGE_OPLOG_WRITE,
+        NUM_PIPELINE_STAGES
+    };
+
+    /** Records that a batch spent 'micros' in 'stage'. */
+    void notePipelineStage(PipelineStage stage, unsigned long long micros);
+
+    /**
+     * Appends a latency histogram for each stage and the ops queued between them, so a lagging
+     * member shows whether the network, the buffer, disk or the writers hold it back.
+     */
+    void appendPipelineStats(BSONObjBuilder& b);
+
     /**
      * "Normal" replica set syncing
      */
@@ -52,6 +91,17 @@ namespace replset {
         virtual ~SyncTail();
         virtual bool syncApply(const BSONObj &o, bool convertUpdateToUpsert = false);
 
+        /**
+         * Applies a run of inserts into one collection under a single lock, putting the
+         * documents in directly with the collection's index maintenance batched, and falling
+         * back to syncApply's upsert for any whose _id is already there.  Every op in
+         * [begin, end) must be an insert with an _id into the same, non system.indexes,
+         * namespace.
+         */
+        void syncApplyInserts(std::vector<BSONObj>::const_iterator begin,
+                              std::vector<BSONObj>::const_iterator end,
+                              bool convertUpdateToUpsert);
+
         /**
          * Apply ops from applyGTEObj's ts to at least minValidObj's ts.  Note that, due to
          * batching, this may end up applying ops beyond minValidObj's ts.
@@ -107,12 +157,6 @@ namespace replset {
         void applyOpsToOplog(std::deque<BSONObj>* ops);
 
     protected:
-        // Cap the batches using the limit on journal commits.
-        // This works out to be 100 MB (64 bit) or 50 MB (32 bit)
-        static const unsigned int replBatchLimitBytes = dur::UncommittedBytesLimit;
-        static const int replBatchLimitSeconds = 1;
-        static const unsigned int replBatchLimitOperations = 5000;
-
         // Prefetch and write a deque of operations, using the supplied function.
         // Initial Sync and Sync Tail each use a different function.
         void multiApply(std::deque<BSONObj>& ops, MultiSyncApplyFunc applyFunc);
@@ -120,20 +164,22 @@ namespace replset {
         // The version of the last op to be read
         int oplogVersion;
 
+        // Splits a batch over the writers, keeping each document's ops in order.
+        void fillWriterVectors(const std::deque<BSONObj>& ops,
+                               std::vector< std::vector<BSONObj> >* writerVectors);
+
     private:
         BackgroundSyncInterface* _networkQueue;
 
         // Doles out all the work to the reader pool threads and waits for them to complete
         void prefetchOps(const std::deque<BSONObj>& ops);
         // Used by the thread pool readers to prefetch an op
-        static void prefetchOp(const BSONObj& op);
+        static void prefetchOp(const BSONObj& op, PrefetchBatch* batch);
 
         // Doles out all the work to the writer pool threads and waits for them to complete
         void applyOps(const std::vector< std::vector<BSONObj> >& writerVectors, 
                       MultiSyncApplyFunc applyFunc);
 
-        void fillWriterVectors(const std::deque<BSONObj>& ops, 
-                               std::vector< std::vector<BSONObj> >* writerVectors);
         void handleSlaveDelay(const BSONObj& op);
         void setOplogVersion(const BSONObj& op);
     };
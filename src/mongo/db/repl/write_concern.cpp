@@ -30,6 +30,9 @@
 
 #include "mongo/db/repl/write_concern.h"
 
+#include <algorithm>
+#include <functional>
+
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/auth/user_name.h"
 #include "mongo/db/client.h"
@@ -254,6 +257,33 @@ namespace mongo {
             return result;
         }
 
+        OpTime majorityReplicatedOpTime() {
+            if (!theReplSet) {
+                return OpTime();
+            }
+
+            // as with w:majority, the entire set counts, arbiters included
+            const int slavesNeeded = theReplSet->config().getMajority() - 1;
+            if (slavesNeeded <= 0) {
+                return theReplSet->lastOpTimeWritten;
+            }
+
+            std::vector<OpTime> optimes;
+            {
+                scoped_lock mylk(_mutex);
+                for (map<Ident,OpTime>::iterator i = _slaves.begin(); i != _slaves.end(); i++) {
+                    optimes.push_back(i->second);
+                }
+            }
+            if (optimes.size() < static_cast<size_t>(slavesNeeded)) {
+                return OpTime();
+            }
+
+            std::nth_element(optimes.begin(), optimes.begin() + (slavesNeeded - 1), optimes.end(),
+                             std::greater<OpTime>());
+            return optimes[slavesNeeded - 1];
+        }
+
         unsigned getSlaveCount() const {
             scoped_lock mylk(_mutex);
 
@@ -345,6 +375,10 @@ namespace mongo {
         return slaveTracking.getHostsAtOp(op);
     }
 
+    OpTime getMajorityReplicatedOpTime() {
+        return slaveTracking.majorityReplicatedOpTime();
+    }
+
     void resetSlaveCache() {
         slaveTracking.reset();
     }
@@ -53,6 +53,12 @@ namespace mongo {
 
     std::vector<BSONObj> getHostsWrittenTo(OpTime& op);
 
+    /**
+     * @return the newest op a majority of the set, counting this primary, is known to have, or
+     * a null OpTime if too few members have reported where they are
+     */
+    OpTime getMajorityReplicatedOpTime();
+
     void resetSlaveCache();
     unsigned getSlaveCount();
 }
@@ -32,6 +32,7 @@
 
 #include "mongo/base/parse_number.h"
 #include "mongo/db/server_parameters.h"
+#include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
 
@@ -112,4 +113,13 @@ namespace mongo {
         return set( v );
     }
 
+    Status BoundedIntParameter::validate( const int& potentialNewValue ) {
+        if ( potentialNewValue < _min || potentialNewValue > _max ) {
+            return Status( ErrorCodes::BadValue,
+                           mongoutils::str::stream() << name() << " must be between " << _min
+                                                     << " and " << _max );
+        }
+        return Status::OK();
+    }
+
 }  // namespace mongo
@@ -131,6 +131,24 @@ namespace mongo {
 
         T* _value; // owned elsewhere
     };
+
+    /**
+     * An int parameter, settable at startup and at runtime, that has to stay within [min, max].
+     */
+    class BoundedIntParameter : public ExportedServerParameter<int> {
+    public:
+        BoundedIntParameter( ServerParameterSet* sps, const std::string& name, int* value,
+                             int min, int max )
+            : ExportedServerParameter<int>( sps, name, value, true, true ),
+              _min( min ), _max( max ) {}
+
+    protected:
+        virtual Status validate( const int& potentialNewValue );
+
+    private:
+        const int _min;
+        const int _max;
+    };
 }
 
 #define MONGO_EXPORT_SERVER_PARAMETER_IMPL( NAME, TYPE, INITIAL_VALUE, \
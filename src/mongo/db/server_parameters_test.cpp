@@ -79,4 +79,18 @@ namespace mongo {
         ASSERT_EQUALS( "e", v[1] );
     }
 
+    TEST( ServerParameters, Bounded1 ) {
+        int b = 5;
+        BoundedIntParameter bb( NULL, "bb", &b, 1, 10 );
+
+        ASSERT_OK( bb.set( 10 ) );
+        ASSERT_EQUALS( 10, b );
+        ASSERT_NOT_OK( bb.set( 11 ) );
+        ASSERT_NOT_OK( bb.setFromString( "0" ) );
+        ASSERT_NOT_OK( bb.set( BSON( "x" << -1 ).firstElement() ) );
+        ASSERT_EQUALS( 10, b );
+        ASSERT_OK( bb.setFromString( "1" ) );
+        ASSERT_EQUALS( 1, b );
+    }
+
 }
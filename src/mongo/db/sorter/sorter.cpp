@@ -47,7 +47,10 @@
 
 #include "mongo/db/sorter/sorter.h"
 
+#include <boost/bind.hpp>
 #include <boost/filesystem/operations.hpp>
+#include <boost/function.hpp>
+#include <boost/thread/thread.hpp>
 #include <snappy.h>
 
 #include "mongo/base/string_data.h"
@@ -107,6 +110,96 @@ namespace mongo {
 #endif
         }
 
+        /** Runs a job of runInParallel(), keeping what it threw for the caller */
+        inline void runJob(const boost::function<void()>& job, int* code, std::string* error) {
+            try {
+                job();
+            }
+            catch (const DBException& e) {
+                *code = e.getCode();
+                *error = e.what();
+            }
+            catch (const std::exception& e) {
+                *code = 17387;
+                *error = e.what();
+            }
+        }
+
+        /**
+         * Runs the jobs, at most 'threads' at a time, and returns once all have finished.
+         * With one thread they run on the caller's.  Rethrows the first job's exception.
+         */
+        inline void runInParallel(const std::vector<boost::function<void()> >& jobs,
+                                  unsigned threads) {
+            if (threads <= 1 || jobs.size() <= 1) {
+                for (size_t i = 0; i < jobs.size(); i++)
+                    jobs[i]();
+                return;
+            }
+
+            std::vector<int> codes(jobs.size(), 0);
+            std::vector<std::string> errors(jobs.size());
+            for (size_t begin = 0; begin < jobs.size(); begin += threads) {
+                const size_t end = std::min(jobs.size(), begin + threads);
+                boost::thread_group group;
+                for (size_t i = begin; i < end; i++)
+                    group.create_thread(boost::bind(&runJob, jobs[i], &codes[i], &errors[i]));
+                group.join_all();
+            }
+
+            for (size_t i = 0; i < jobs.size(); i++) {
+                if (codes[i])
+                    msgasserted(codes[i], errors[i]);
+            }
+        }
+
+        template <typename Iterator, typename Less>
+        void stableSortRange(Iterator begin, Iterator end, Less less) {
+            std::stable_sort(begin, end, less);
+        }
+
+        template <typename Iterator, typename Less>
+        void mergeRanges(Iterator begin, Iterator middle, Iterator end, Less less) {
+            std::inplace_merge(begin, middle, end, less);
+        }
+
+        /**
+         * std::stable_sort, with 'threads' threads each sorting a slice and then merging
+         * neighbouring slices so that equal elements keep their order.
+         */
+        template <typename Iterator, typename Less>
+        void parallelStableSort(Iterator begin, Iterator end, Less less, unsigned threads) {
+            const size_t size = end - begin;
+            if (threads <= 1 || size < 16 * 1024) {
+                // not worth starting threads for
+                std::stable_sort(begin, end, less);
+                return;
+            }
+
+            std::vector<Iterator> bounds;
+            for (size_t i = 0; i <= threads; i++)
+                bounds.push_back(begin + size * i / threads);
+
+            std::vector<boost::function<void()> > jobs;
+            for (size_t i = 0; i < threads; i++) {
+                jobs.push_back(boost::bind(&stableSortRange<Iterator, Less>,
+                                           bounds[i], bounds[i + 1], less));
+            }
+            runInParallel(jobs, threads);
+
+            for (size_t width = 1; width < threads; width *= 2) {
+                jobs.clear();
+                for (size_t i = 0; i + width < threads; i += 2 * width) {
+                    jobs.push_back(boost::bind(&mergeRanges<Iterator, Less>,
+                                               bounds[i],
+                                               bounds[i + width],
+                                               bounds[std::min<size_t>(i + 2 * width, threads)],
+                                               less));
+                }
+                runInParallel(jobs, threads);
+            }
+        }
+
         /** Ensures a named file is deleted when this object goes out of scope */
         class FileDeleter {
         public:
@@ -381,6 +474,60 @@ namespace mongo {
             STLComparator _greater; // named so calls make sense
         };
 
+        /** Merges 'inputs' into a single new file */
+        template <typename Key, typename Value, typename Comparator>
+        void mergeToFile(const std::vector<boost::shared_ptr<SortIteratorInterface<Key, Value> > >&
+                             inputs,
+                         const SortOptions& opts,
+                         const Comparator& comp,
+                         const typename FileIterator<Key, Value>::Settings& settings,
+                         boost::shared_ptr<SortIteratorInterface<Key, Value> >* output) {
+            typedef SortIteratorInterface<Key, Value> Iterator;
+            boost::scoped_ptr<Iterator> merged(Iterator::merge(inputs, opts, comp));
+            SortedFileWriter<Key, Value> writer(opts, settings);
+            while (merged->more()) {
+                const std::pair<Key, Value> data = merged->next();
+                writer.addAlreadySorted(data.first, data.second);
+            }
+            output->reset(writer.done());
+        }
+
+        /**
+         * Merges neighbouring groups of at most opts.maxMergeFanIn spilled files into new files,
+         * a tier at a time, until the final merge has no more inputs than that.  Merging a
+         * few hundred files at once means a heap of as many streams, each reading its own file.
+         */
+        template <typename Key, typename Value, typename Comparator>
+        void mergeInTiers(std::vector<boost::shared_ptr<SortIteratorInterface<Key, Value> > >* iters,
+                          const SortOptions& opts,
+                          const Comparator& comp,
+                          const typename FileIterator<Key, Value>::Settings& settings) {
+            typedef std::vector<boost::shared_ptr<SortIteratorInterface<Key, Value> > > Iterators;
+            const size_t fanIn = std::max<size_t>(2, opts.maxMergeFanIn);
+
+            while (iters->size() > fanIn) {
+                const size_t numGroups = (iters->size() + fanIn - 1) / fanIn;
+                std::vector<Iterators> groups(numGroups);
+                for (size_t i = 0; i < iters->size(); i++)
+                    groups[i / fanIn].push_back((*iters)[i]);
+                iters->clear();
+
+                // groups stay in order, so equal values from earlier files still come first
+                Iterators merged(numGroups);
+                std::vector<boost::function<void()> > jobs;
+                for (size_t i = 0; i < numGroups; i++) {
+                    jobs.push_back(boost::bind(&mergeToFile<Key, Value, Comparator>,
+                                               boost::cref(groups[i]),
+                                               boost::cref(opts),
+                                               boost::cref(comp),
+                                               boost::cref(settings),
+                                               &merged[i]));
+                }
+                runInParallel(jobs, opts.sortThreads);
+                iters->swap(merged);
+            }
+        }
+
         template <typename Key, typename Value, typename Comparator>
         class NoLimitSorter : public Sorter<Key, Value> {
         public:
@@ -416,6 +563,7 @@ namespace mongo {
                 }
 
                 spill();
+                mergeInTiers(&_iters, _opts, _comp, _settings);
                 return Iterator::merge(_iters, _opts, _comp);
             }
 
@@ -437,7 +585,7 @@ namespace mongo {
 
             void sort() {
                 STLComparator less(_comp);
-                std::stable_sort(_data.begin(), _data.end(), less);
+                parallelStableSort(_data.begin(), _data.end(), less, _opts.sortThreads);
 
                 // Does 2x more compares than stable_sort
                 // TODO test on windows
@@ -601,6 +749,7 @@ namespace mongo {
                 }
 
                 spill();
+                mergeInTiers(&_iters, _opts, _comp, _settings);
                 return Iterator::merge(_iters, _opts, _comp);
             }
 
@@ -626,7 +775,7 @@ namespace mongo {
                 if (_data.size() == _opts.limit) {
                     std::sort_heap(_data.begin(), _data.end(), less);
                 } else {
-                    std::stable_sort(_data.begin(), _data.end(), less);
+                    parallelStableSort(_data.begin(), _data.end(), less, _opts.sortThreads);
                 }
             }
 
@@ -767,6 +916,7 @@ namespace mongo {
     SortedFileWriter<Key, Value>::SortedFileWriter(const SortOptions& opts,
                                                    const Settings& settings)
         : _settings(settings)
+        , _stats(opts.stats)
     {
         namespace str = mongoutils::str;
 
@@ -794,6 +944,9 @@ namespace mongo {
 
         // throw on failure
         _file.exceptions(std::ios::failbit | std::ios::badbit | std::ios::eofbit);
+
+        if (_stats)
+            _stats->spills.fetchAndAdd(1);
     }
 
     template <typename Key, typename Value>
@@ -816,21 +969,27 @@ namespace mongo {
         snappy::Compress(_buffer.buf(), _buffer.len(), &compressed);
         verify(compressed.size() <= size_t(std::numeric_limits<int32_t>::max()));
 
+        size_t written = sizeof(int32_t);
         try {
             if (compressed.size() < size_t(_buffer.len()/10*9)) {
                 const int32_t size = -int32_t(compressed.size()); // negative means compressed
                 _file.write(reinterpret_cast<const char*>(&size), sizeof(size));
                 _file.write(compressed.data(), compressed.size());
+                written += compressed.size();
             } else {
                 const int32_t size = _buffer.len();
                 _file.write(reinterpret_cast<const char*>(&size), sizeof(size));
                 _file.write(_buffer.buf(), _buffer.len());
+                written += _buffer.len();
             }
         } catch (const std::exception&) {
             msgasserted(16821, str::stream() << "error writing to file \"" << _fileName << "\": "
                                              << sorter::myErrnoWithDescription());
         }
 
+        if (_stats)
+            _stats->bytesSpilled.fetchAndAdd(written);
+
         _buffer.reset();
     }
 
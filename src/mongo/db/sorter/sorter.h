@@ -37,6 +37,7 @@
 
 #include "mongo/base/disallow_copying.h"
 #include "mongo/bson/util/builder.h"
+#include "mongo/platform/atomic_word.h"
 
 /**
  * This is the public API for the Sorter (both in-memory and external)
@@ -92,17 +93,32 @@ namespace mongo {
     /**
      * Runtime options that control the Sorter's behavior
      */
+    /**
+     * Counts what the sorters sharing it wrote to disk. Safe to update from several threads.
+     */
+    struct SorterStats {
+        AtomicUInt64 spills; /// number of files written
+        AtomicUInt64 bytesSpilled; /// bytes written to those files, after compression
+    };
+
     struct SortOptions {
         unsigned long long limit; /// number of KV pairs to be returned. 0 for no limit.
         size_t maxMemoryUsageBytes; /// Approximate.
         bool extSortAllowed; /// If false, uassert if more mem needed than allowed.
         std::string tempDir; /// Directory to directly place files in.
                              /// Must be explicitly set if extSortAllowed is true.
+        SorterStats* stats; /// If set, spills are counted here. Must outlive the sorter.
+        size_t maxMergeFanIn; /// Spilled files merged at once. More are merged in tiers first.
+        unsigned sortThreads; /// Threads sorting a batch or merging a tier. Only set above 1 if
+                              /// the comparator may be called from threads without a Client.
 
         SortOptions()
             : limit(0)
             , maxMemoryUsageBytes(64*1024*1024)
             , extSortAllowed(false)
+            , stats(NULL)
+            , maxMergeFanIn(64)
+            , sortThreads(1)
         {}
 
         /// Fluent API to support expressions like SortOptions().Limit(1000).ExtSortAllowed(true)
@@ -126,6 +142,21 @@ namespace mongo {
             tempDir = newTempDir;
             return *this;
         }
+
+        SortOptions& Stats(SorterStats* newStats) {
+            stats = newStats;
+            return *this;
+        }
+
+        SortOptions& MaxMergeFanIn(size_t newMaxMergeFanIn) {
+            maxMergeFanIn = newMaxMergeFanIn;
+            return *this;
+        }
+
+        SortOptions& SortThreads(unsigned newSortThreads) {
+            sortThreads = newSortThreads;
+            return *this;
+        }
     };
 
     /// This is the output from the sorting framework
@@ -201,6 +232,7 @@ namespace mongo {
         void spill();
 
         const Settings _settings;
+        SorterStats* const _stats;
         std::string _fileName;
         boost::shared_ptr<sorter::FileDeleter> _fileDeleter; // Must outlive _file
         std::ofstream _file;
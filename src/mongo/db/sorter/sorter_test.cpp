@@ -486,6 +486,15 @@ namespace mongo {
         };
 
 
+        // more files than are merged at once, with batches and tiers sorted on several threads
+        class LotsOfDataInTiers : public LotsOfDataLittleMemory</*random=*/true> {
+            SortOptions adjustSortOptions(SortOptions opts) {
+                return LotsOfDataLittleMemory</*random=*/true>::adjustSortOptions(opts)
+                    .MaxMergeFanIn(8)
+                    .SortThreads(4);
+            }
+        };
+
         template <long long Limit, bool Random=true>
         class LotsOfDataWithLimit : public LotsOfDataLittleMemory<Random> {
             typedef LotsOfDataLittleMemory<Random> Parent;
@@ -525,6 +534,7 @@ namespace mongo {
             add<SorterTests::Dupes>();
             add<SorterTests::LotsOfDataLittleMemory</*random=*/false> >();
             add<SorterTests::LotsOfDataLittleMemory</*random=*/true> >();
+            add<SorterTests::LotsOfDataInTiers>();
             add<SorterTests::LotsOfDataWithLimit<1,/*random=*/false> >(); // limit=1 is special case
             add<SorterTests::LotsOfDataWithLimit<1,/*random=*/true> >();  // limit=1 is special case
             add<SorterTests::LotsOfDataWithLimit<100,/*random=*/false> >(); // fits in mem
@@ -0,0 +1,197 @@
+// index_usage.cpp
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/db/stats/index_usage.h"
+
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/exec/plan_stats.h"
+#include "mongo/db/namespace_details.h"
+#include "mongo/db/pdfile.h"
+#include "mongo/db/storage/index_details.h"
+
+namespace mongo {
+
+    IndexUsageTracker IndexUsageTracker::global;
+
+    void IndexUsageTracker::UsageData::append(BSONObjBuilder& b) const {
+        b.appendNumber("ops", ops);
+        b.appendNumber("keysExamined", keysExamined);
+        b.appendNumber("planWins", planWins);
+        if (lastUsed.millis) {
+            b.appendDate("lastUsed", lastUsed);
+        }
+        else {
+            b.appendNull("lastUsed");
+        }
+    }
+
+    void IndexUsageTracker::recordScan(const StringData& indexNs, long long keysExamined) {
+        Date_t now = jsTime();
+        SimpleMutex::scoped_lock lk(_lock);
+        UsageData& usage = _usage[indexNs];
+        usage.ops++;
+        usage.keysExamined += keysExamined;
+        usage.lastUsed = now;
+    }
+
+    void IndexUsageTracker::recordPlanWin(const StringData& ns, const PlanStageStats* winnerStats) {
+        if (NULL == winnerStats) {
+            return;
+        }
+        SimpleMutex::scoped_lock lk(_lock);
+        _recordPlanWin(ns.toString(), winnerStats);
+    }
+
+    void IndexUsageTracker::_recordPlanWin(const string& ns, const PlanStageStats* stats) {
+        if (STAGE_IXSCAN == stats->stageType && NULL != stats->specific.get()) {
+            const IndexScanStats* ixStats = static_cast<const IndexScanStats*>(stats->specific.get());
+            _usage[ns + ".$" + ixStats->indexName].planWins++;
+        }
+        for (size_t i = 0; i < stats->children.size(); ++i) {
+            _recordPlanWin(ns, stats->children[i]);
+        }
+    }
+
+    IndexUsageTracker::UsageData IndexUsageTracker::get(const StringData& indexNs) const {
+        SimpleMutex::scoped_lock lk(_lock);
+        UsageMap::const_iterator it = _usage.find(indexNs);
+        if (it == _usage.end()) {
+            return UsageData();
+        }
+        return it->second;
+    }
+
+    void IndexUsageTracker::append(BSONObjBuilder& b) const {
+        SimpleMutex::scoped_lock lk(_lock);
+
+        // pull all the names into a vector so we can sort them for the user
+        vector<string> names;
+        for (UsageMap::const_iterator i = _usage.begin(); i != _usage.end(); ++i) {
+            names.push_back(i->first);
+        }
+        std::sort(names.begin(), names.end());
+
+        for (size_t i = 0; i < names.size(); ++i) {
+            BSONObjBuilder bb(b.subobjStart(names[i]));
+            _usage.find(names[i])->second.append(bb);
+            bb.done();
+        }
+    }
+
+    void IndexUsageTracker::indexDropped(const StringData& indexNs) {
+        SimpleMutex::scoped_lock lk(_lock);
+        _usage.erase(indexNs);
+    }
+
+    void IndexUsageTracker::collectionDropped(const StringData& ns) {
+        string prefix = ns.toString() + ".$";
+        SimpleMutex::scoped_lock lk(_lock);
+        vector<string> dropped;
+        for (UsageMap::const_iterator i = _usage.begin(); i != _usage.end(); ++i) {
+            if (StringData(i->first).startsWith(prefix)) {
+                dropped.push_back(i->first);
+            }
+        }
+        for (size_t i = 0; i < dropped.size(); ++i) {
+            _usage.erase(dropped[i]);
+        }
+    }
+
+    /**
+     * { indexUsage: <collection> } lists every index of the collection with how it has been used
+     * since the server started.  An index with no ops hasn't been read by any query.
+     */
+    class IndexUsageCmd : public Command {
+    public:
+        IndexUsageCmd() : Command("indexUsage") {}
+
+        virtual bool slaveOk() const { return true; }
+
+        virtual LockType locktype() const { return READ; }
+
+        virtual void help(stringstream& h) const {
+            h << "Reports how often each index of a collection has been scanned since the server "
+              << "started, how many keys those scans examined, how many times a plan using it "
+              << "won plan ranking, and when it was last scanned.  "
+              << "For example, {indexUsage: 'collection'}.";
+        }
+
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::indexStats);
+            out->push_back(Privilege(parseResourcePattern(dbname, cmdObj), actions));
+        }
+
+        bool run(const string& dbname, BSONObj& cmdObj, int, string& errmsg,
+                 BSONObjBuilder& result, bool fromRepl) {
+            string ns = dbname + "." + cmdObj.firstElement().valuestrsafe();
+            NamespaceDetails* nsd = nsdetails(ns);
+            if (!nsd) {
+                errmsg = "ns not found";
+                return false;
+            }
+
+            BSONArrayBuilder indexes(result.subarrayStart("indexes"));
+            for (int i = 0; i < nsd->getCompletedIndexCount(); ++i) {
+                IndexDetails& id = nsd->idx(i);
+                BSONObjBuilder b(indexes.subobjStart());
+                b.append("name", id.indexName());
+                b.append("key", id.keyPattern());
+                IndexUsageTracker::global.get(id.indexNamespace()).append(b);
+                b.done();
+            }
+            indexes.done();
+            return true;
+        }
+
+    } indexUsageCmd;
+
+    class IndexUsageServerStatusSection : public ServerStatusSection {
+    public:
+        IndexUsageServerStatusSection() : ServerStatusSection("indexUsage") {}
+
+        // One entry for every index that has been used, so only on request.
+        virtual bool includeByDefault() const { return false; }
+
+        BSONObj generateSection(const BSONElement& configElement) const {
+            BSONObjBuilder b;
+            IndexUsageTracker::global.append(b);
+            return b.obj();
+        }
+
+    } indexUsageServerStatusSection;
+
+}  // namespace mongo
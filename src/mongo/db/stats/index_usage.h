@@ -0,0 +1,96 @@
+// index_usage.h
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include "mongo/base/string_data.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/string_map.h"
+
+namespace mongo {
+
+    struct PlanStageStats;
+
+    /**
+     * Tracks how each index is used by the query system, so that indexes nothing reads from can
+     * be found and dropped.  Indexes are keyed by their index namespace, e.g. "test.foo.$a_1".
+     * Counts start from zero when the server starts and are dropped along with the index.
+     */
+    class IndexUsageTracker {
+    public:
+        IndexUsageTracker() : _lock("IndexUsageTracker") { }
+
+        struct UsageData {
+            UsageData() : ops(0), keysExamined(0), planWins(0), lastUsed(0) { }
+
+            // Index scans over the index, including those of plans tried and rejected.
+            long long ops;
+
+            // Keys those scans looked at.
+            long long keysExamined;
+
+            // Times a plan using the index won a plan ranking.
+            long long planWins;
+
+            // When the index was last scanned.
+            Date_t lastUsed;
+
+            void append(BSONObjBuilder& b) const;
+        };
+
+        typedef StringMap<UsageData> UsageMap;
+
+        /** Records one index scan over 'indexNs' that examined 'keysExamined' keys. */
+        void recordScan(const StringData& indexNs, long long keysExamined);
+
+        /** Records a win for each index scanned by the plan whose stats are 'winnerStats'. */
+        void recordPlanWin(const StringData& ns, const PlanStageStats* winnerStats);
+
+        /** Returns a copy of the usage of 'indexNs', which is all zero if it hasn't been used. */
+        UsageData get(const StringData& indexNs) const;
+
+        void append(BSONObjBuilder& b) const;
+
+        void indexDropped(const StringData& indexNs);
+
+        /** Forgets the usage of every index on 'ns'. */
+        void collectionDropped(const StringData& ns);
+
+        static IndexUsageTracker global;
+
+    private:
+        void _recordPlanWin(const string& ns, const PlanStageStats* stats);
+
+        mutable SimpleMutex _lock;
+        UsageMap _usage;
+    };
+
+}  // namespace mongo
@@ -0,0 +1,211 @@
+// op_latency.cpp
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/db/stats/op_latency.h"
+
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/server_parameters.h"
+
+namespace mongo {
+
+    // Whether to keep latency histograms for each namespace as well as for each op type.
+    MONGO_EXPORT_SERVER_PARAMETER(opLatencyPerNamespace, bool, false);
+
+    // static
+    int LatencyHistogram::bucketFor(unsigned long long micros) {
+        if (micros < 4) {
+            return static_cast<int>(micros);
+        }
+        int log2 = 2;
+        while (micros >> (log2 + 1)) {
+            ++log2;
+        }
+        int bucket = 4 * (log2 - 1) + static_cast<int>((micros >> (log2 - 2)) & 3);
+        return std::min(bucket, kNumBuckets - 1);
+    }
+
+    // static
+    unsigned long long LatencyHistogram::upperBound(int bucket) {
+        if (bucket < 4) {
+            return bucket;
+        }
+        int log2 = bucket / 4 + 1;
+        unsigned long long lower = static_cast<unsigned long long>(4 + bucket % 4) << (log2 - 2);
+        return lower + (1ULL << (log2 - 2)) - 1;
+    }
+
+    void LatencyHistogram::record(unsigned long long micros) {
+        _buckets[bucketFor(micros)].fetchAndAdd(1);
+        _totalMicros.fetchAndAdd(micros);
+        _count.fetchAndAdd(1);
+    }
+
+    void LatencyHistogram::append(BSONObjBuilder& b) const {
+        unsigned long long counts[kNumBuckets];
+        unsigned long long total = 0;
+        for (int i = 0; i < kNumBuckets; ++i) {
+            counts[i] = _buckets[i].load();
+            total += counts[i];
+        }
+
+        b.appendNumber("count", static_cast<long long>(total));
+        b.appendNumber("totalMicros", static_cast<long long>(_totalMicros.load()));
+
+        static const struct { const char* name; double fraction; } percentiles[] = {
+            { "p50", 0.5 }, { "p95", 0.95 }, { "p99", 0.99 }, { "p999", 0.999 }
+        };
+        int bucket = 0;
+        unsigned long long seen = 0;
+        for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); ++i) {
+            if (0 == total) {
+                b.appendNull(percentiles[i].name);
+                continue;
+            }
+            // The rank of the percentile, counting from 1.
+            unsigned long long rank =
+                static_cast<unsigned long long>(ceil(percentiles[i].fraction * total));
+            rank = std::max(rank, 1ULL);
+            while (seen + counts[bucket] < rank) {
+                seen += counts[bucket];
+                ++bucket;
+            }
+            b.appendNumber(percentiles[i].name, static_cast<long long>(upperBound(bucket)));
+        }
+
+        BSONArrayBuilder buckets(b.subarrayStart("buckets"));
+        for (int i = 0; i < kNumBuckets; ++i) {
+            if (0 == counts[i]) {
+                continue;
+            }
+            BSONObjBuilder bucketBuilder(buckets.subobjStart());
+            bucketBuilder.appendNumber("lte", static_cast<long long>(upperBound(i)));
+            bucketBuilder.appendNumber("count", static_cast<long long>(counts[i]));
+            bucketBuilder.done();
+        }
+        buckets.done();
+    }
+
+    OpLatencyStats OpLatencyStats::global;
+
+    OpLatencyStats::~OpLatencyStats() {
+        for (NamespaceMap::const_iterator i = _namespaces.begin(); i != _namespaces.end(); ++i) {
+            delete i->second;
+        }
+    }
+
+    // static
+    const char* OpLatencyStats::opTypeName(OpType type) {
+        switch (type) {
+        case OP_QUERY: return "query";
+        case OP_GETMORE: return "getmore";
+        case OP_INSERT: return "insert";
+        case OP_UPDATE: return "update";
+        case OP_DELETE: return "delete";
+        case OP_COMMAND: return "command";
+        default: verify(0); return "";
+        }
+    }
+
+    void OpLatencyStats::record(OpType type, const StringData& ns, unsigned long long micros) {
+        _total.histograms[type].record(micros);
+
+        if (!opLatencyPerNamespace || ns.empty()) {
+            return;
+        }
+
+        PerType* perType;
+        {
+            SimpleMutex::scoped_lock lk(_lock);
+            PerType*& entry = _namespaces[ns];
+            if (NULL == entry) {
+                entry = new PerType();
+            }
+            perType = entry;
+        }
+        perType->histograms[type].record(micros);
+    }
+
+    void OpLatencyStats::append(BSONObjBuilder& b, bool namespaces) const {
+        for (int i = 0; i < NUM_OP_TYPES; ++i) {
+            BSONObjBuilder bb(b.subobjStart(opTypeName(static_cast<OpType>(i))));
+            _total.histograms[i].append(bb);
+            bb.done();
+        }
+
+        if (!namespaces) {
+            return;
+        }
+
+        // Sorted for the user.  The entries outlive the lock since they are never removed.
+        vector<pair<string, const PerType*> > entries;
+        {
+            SimpleMutex::scoped_lock lk(_lock);
+            for (NamespaceMap::const_iterator i = _namespaces.begin(); i != _namespaces.end();
+                 ++i) {
+                entries.push_back(make_pair(i->first, i->second));
+            }
+        }
+        std::sort(entries.begin(), entries.end());
+
+        BSONObjBuilder nsBuilder(b.subobjStart("namespaces"));
+        for (size_t i = 0; i < entries.size(); ++i) {
+            BSONObjBuilder perNs(nsBuilder.subobjStart(entries[i].first));
+            for (int j = 0; j < NUM_OP_TYPES; ++j) {
+                const LatencyHistogram& histogram = entries[i].second->histograms[j];
+                if (0 == histogram.count()) {
+                    continue;
+                }
+                BSONObjBuilder bb(perNs.subobjStart(opTypeName(static_cast<OpType>(j))));
+                histogram.append(bb);
+                bb.done();
+            }
+            perNs.done();
+        }
+        nsBuilder.done();
+    }
+
+    class OpLatencyServerStatusSection : public ServerStatusSection {
+    public:
+        OpLatencyServerStatusSection() : ServerStatusSection("opLatencies") {}
+
+        virtual bool includeByDefault() const { return true; }
+
+        // { opLatencies: { namespaces: true } } adds the histograms of each namespace.
+        BSONObj generateSection(const BSONElement& configElement) const {
+            bool namespaces = configElement.isABSONObj() &&
+                configElement.Obj()["namespaces"].trueValue();
+            BSONObjBuilder b;
+            OpLatencyStats::global.append(b, namespaces);
+            return b.obj();
+        }
+
+    } opLatencyServerStatusSection;
+
+}  // namespace mongo
@@ -0,0 +1,122 @@
+// op_latency.h
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/string_map.h"
+
+namespace mongo {
+
+    /**
+     * Counts latencies in buckets that grow exponentially, four to each power of two
+     * microseconds, so percentiles are known to within a quarter of their value.  Recording is
+     * lock-free and may race with reading; a read sees each bucket at some point in time.
+     */
+    class LatencyHistogram {
+        MONGO_DISALLOW_COPYING(LatencyHistogram);
+    public:
+        // Enough for latencies up to 2^40 micros, about twelve days.
+        static const int kNumBuckets = 160;
+
+        LatencyHistogram() { }
+
+        void record(unsigned long long micros);
+
+        /**
+         * Appends the count, the total time, the 50th, 95th, 99th and 99.9th percentile and the
+         * non-empty buckets as [upper bound in micros, count] pairs.  Percentiles are reported
+         * as the upper bound of the bucket they fall in.
+         */
+        void append(BSONObjBuilder& b) const;
+
+        unsigned long long count() const { return _count.load(); }
+
+        /** The bucket 'micros' falls in. */
+        static int bucketFor(unsigned long long micros);
+
+        /** The largest latency counted in 'bucket'. */
+        static unsigned long long upperBound(int bucket);
+
+    private:
+        AtomicUInt64 _count;
+        AtomicUInt64 _totalMicros;
+        AtomicUInt64 _buckets[kNumBuckets];
+    };
+
+    /**
+     * Latency histograms per operation type, and per namespace as well when
+     * opLatencyPerNamespace is set.  Reported by the opLatencies section of serverStatus.
+     */
+    class OpLatencyStats {
+        MONGO_DISALLOW_COPYING(OpLatencyStats);
+    public:
+        enum OpType {
+            OP_QUERY,
+            OP_GETMORE,
+            OP_INSERT,
+            OP_UPDATE,
+            OP_DELETE,
+            OP_COMMAND,
+            NUM_OP_TYPES
+        };
+
+        OpLatencyStats() : _lock("OpLatencyStats") { }
+        ~OpLatencyStats();
+
+        /** Records an operation of 'type' on 'ns' that took 'micros'. */
+        void record(OpType type, const StringData& ns, unsigned long long micros);
+
+        /** Appends the histograms of every op type, and of every namespace if 'namespaces'. */
+        void append(BSONObjBuilder& b, bool namespaces) const;
+
+        static const char* opTypeName(OpType type);
+
+        static OpLatencyStats global;
+
+    private:
+        struct PerType {
+            LatencyHistogram histograms[NUM_OP_TYPES];
+        };
+
+        typedef StringMap<PerType*> NamespaceMap;
+
+        PerType _total;
+
+        // Protects _namespaces, not the histograms in it.  Entries are never removed.
+        mutable SimpleMutex _lock;
+        NamespaceMap _namespaces;
+    };
+
+}  // namespace mongo
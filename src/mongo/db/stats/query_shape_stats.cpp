@@ -0,0 +1,242 @@
+// query_shape_stats.cpp
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/db/stats/query_shape_stats.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/server_parameters.h"
+
+namespace mongo {
+
+    // how many query shapes to keep statistics for; 0 turns them off
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryShapeStatsSize, int, 1000);
+
+    QueryShapeStats QueryShapeStats::global;
+
+    namespace {
+
+        const char* const sortFields[] = {
+            "count", "totalMicros", "maxMicros", "avgMicros", "docsExamined", "keysExamined",
+            "nReturned"
+        };
+
+        long long sortValue(const QueryShapeStats::ShapeData& data, const StringData& field) {
+            if (field == "count") return data.count;
+            if (field == "totalMicros") return data.totalMicros;
+            if (field == "maxMicros") return data.maxMicros;
+            if (field == "avgMicros") return data.count ? data.totalMicros / data.count : 0;
+            if (field == "docsExamined") return data.docsExamined;
+            if (field == "keysExamined") return data.keysExamined;
+            verify(field == "nReturned");
+            return data.nReturned;
+        }
+
+        class LargerFirst {
+        public:
+            explicit LargerFirst(const StringData& field) : _field(field) { }
+            bool operator()(const QueryShapeStats::ShapeData* a,
+                            const QueryShapeStats::ShapeData* b) const {
+                return sortValue(*a, _field) > sortValue(*b, _field);
+            }
+        private:
+            StringData _field;
+        };
+
+    }  // namespace
+
+    void QueryShapeStats::ShapeData::append(BSONObjBuilder& b) const {
+        b.append("ns", ns);
+        b.append("shape", shape);
+        b.append("example", example);
+        b.appendNumber("count", count);
+        b.appendNumber("totalMicros", totalMicros);
+        b.appendNumber("maxMicros", maxMicros);
+        b.appendNumber("avgMicros", count ? totalMicros / count : 0);
+        b.appendNumber("docsExamined", docsExamined);
+        b.appendNumber("keysExamined", keysExamined);
+        b.appendNumber("nReturned", nReturned);
+        b.append("plan", plan);
+        b.appendDate("lastRun", lastRun);
+    }
+
+    bool QueryShapeStats::enabled() const {
+        return internalQueryShapeStatsSize > 0;
+    }
+
+    void QueryShapeStats::record(const StringData& ns, const StringData& shape,
+                                 const BSONObj& example, const Execution& execution) {
+        int maxSize = internalQueryShapeStatsSize;
+        if (maxSize <= 0) {
+            return;
+        }
+
+        std::string key = ns.toString() + '|' + shape.toString();
+        Date_t now = jsTime();
+
+        SimpleMutex::scoped_lock lk(_lock);
+        EntryMap::iterator it = _entries.find(key);
+        if (_entries.end() == it) {
+            while (!_lru.empty() && _entries.size() >= static_cast<size_t>(maxSize)) {
+                _entries.erase(_lru.back());
+                _lru.pop_back();
+            }
+            _lru.push_front(key);
+            it = _entries.insert(make_pair(key, Entry())).first;
+            it->second.data.ns = ns.toString();
+            it->second.data.shape = shape.toString();
+            it->second.data.example = example.getOwned();
+        }
+        else {
+            _lru.erase(it->second.lruPosition);
+            _lru.push_front(key);
+        }
+        it->second.lruPosition = _lru.begin();
+
+        ShapeData& data = it->second.data;
+        data.count++;
+        data.totalMicros += execution.micros;
+        data.maxMicros = std::max(data.maxMicros, execution.micros);
+        data.docsExamined += execution.docsExamined;
+        data.keysExamined += execution.keysExamined;
+        data.nReturned += execution.nReturned;
+        data.plan = execution.plan;
+        data.lastRun = now;
+    }
+
+    // static
+    bool QueryShapeStats::canSortBy(const StringData& field) {
+        const char* const* end = sortFields + sizeof(sortFields) / sizeof(sortFields[0]);
+        return std::find(sortFields, end, field) != end;
+    }
+
+    void QueryShapeStats::appendTop(BSONArrayBuilder& b, const StringData& sortBy,
+                                    int limit) const {
+        verify(canSortBy(sortBy));
+
+        SimpleMutex::scoped_lock lk(_lock);
+        std::vector<const ShapeData*> shapes;
+        for (EntryMap::const_iterator i = _entries.begin(); i != _entries.end(); ++i) {
+            shapes.push_back(&i->second.data);
+        }
+
+        size_t n = std::min(shapes.size(), static_cast<size_t>(std::max(limit, 0)));
+        std::partial_sort(shapes.begin(), shapes.begin() + n, shapes.end(), LargerFirst(sortBy));
+        for (size_t i = 0; i < n; ++i) {
+            BSONObjBuilder bb(b.subobjStart());
+            shapes[i]->append(bb);
+            bb.done();
+        }
+    }
+
+    void QueryShapeStats::reset() {
+        SimpleMutex::scoped_lock lk(_lock);
+        _entries.clear();
+        _lru.clear();
+    }
+
+    size_t QueryShapeStats::size() const {
+        SimpleMutex::scoped_lock lk(_lock);
+        return _entries.size();
+    }
+
+    /**
+     * { queryShapeStats: 1, sortBy: 'totalMicros', limit: 10 } lists the query shapes that have
+     * cost the most, by the given measure, since the server started or the statistics were
+     * reset with { queryShapeStats: 1, reset: true }.
+     */
+    class QueryShapeStatsCmd : public Command {
+    public:
+        QueryShapeStatsCmd() : Command("queryShapeStats") {}
+
+        virtual bool slaveOk() const { return true; }
+        virtual bool adminOnly() const { return true; }
+        virtual LockType locktype() const { return NONE; }
+
+        virtual void help(stringstream& h) const {
+            h << "Reports the query shapes with the largest count, totalMicros, maxMicros, "
+              << "avgMicros, docsExamined, keysExamined or nReturned.  "
+              << "For example, {queryShapeStats: 1, sortBy: 'totalMicros', limit: 10}.  "
+              << "{queryShapeStats: 1, reset: true} forgets every shape.";
+        }
+
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::top);
+            out->push_back(Privilege(ResourcePattern::forClusterResource(), actions));
+        }
+
+        bool run(const string& dbname, BSONObj& cmdObj, int, string& errmsg,
+                 BSONObjBuilder& result, bool fromRepl) {
+            if (cmdObj["reset"].trueValue()) {
+                QueryShapeStats::global.reset();
+                return true;
+            }
+
+            string sortBy = "totalMicros";
+            if (!cmdObj["sortBy"].eoo()) {
+                if (String != cmdObj["sortBy"].type()) {
+                    errmsg = "sortBy must be a string";
+                    return false;
+                }
+                sortBy = cmdObj["sortBy"].String();
+            }
+            if (!QueryShapeStats::canSortBy(sortBy)) {
+                errmsg = "can't sort by " + sortBy;
+                return false;
+            }
+
+            int limit = 10;
+            if (!cmdObj["limit"].eoo()) {
+                if (!cmdObj["limit"].isNumber() || cmdObj["limit"].numberInt() < 0) {
+                    errmsg = "limit must be a non-negative number";
+                    return false;
+                }
+                limit = cmdObj["limit"].numberInt();
+            }
+
+            result.appendNumber("numShapes",
+                                static_cast<long long>(QueryShapeStats::global.size()));
+            BSONArrayBuilder shapes(result.subarrayStart("shapes"));
+            QueryShapeStats::global.appendTop(shapes, sortBy, limit);
+            shapes.done();
+            return true;
+        }
+
+    } queryShapeStatsCmd;
+
+}  // namespace mongo
@@ -0,0 +1,125 @@
+// query_shape_stats.h
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include <list>
+#include <string>
+
+#include "mongo/base/string_data.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/unordered_map.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    /**
+     * Aggregates the executions of queries by namespace and query shape (see
+     * PlanCache::getPlanCacheKey), so the shapes that cost the most overall can be found without
+     * profiling every query.  Holds at most internalQueryShapeStatsSize shapes, dropping the
+     * least recently run when full.  Only the initial batch of a query is counted; its getMores
+     * are not.
+     */
+    class QueryShapeStats {
+    public:
+        QueryShapeStats() : _lock("QueryShapeStats") { }
+
+        struct ShapeData {
+            ShapeData() : count(0), totalMicros(0), maxMicros(0), docsExamined(0),
+                          keysExamined(0), nReturned(0) { }
+
+            std::string ns;
+            std::string shape;
+
+            // The filter, sort and projection of the first query seen with this shape.
+            BSONObj example;
+
+            long long count;
+            long long totalMicros;
+            long long maxMicros;
+            long long docsExamined;
+            long long keysExamined;
+            long long nReturned;
+
+            // The plan the most recent query of this shape ran with.
+            std::string plan;
+            Date_t lastRun;
+
+            void append(BSONObjBuilder& b) const;
+        };
+
+        struct Execution {
+            Execution() : micros(0), docsExamined(0), keysExamined(0), nReturned(0) { }
+
+            long long micros;
+            long long docsExamined;
+            long long keysExamined;
+            long long nReturned;
+            std::string plan;
+        };
+
+        /** Whether record() keeps anything, so callers can skip gathering an Execution. */
+        bool enabled() const;
+
+        /**
+         * Adds 'execution' to the statistics of 'shape' on 'ns'.  'example' is only copied if the
+         * shape is new.
+         */
+        void record(const StringData& ns, const StringData& shape, const BSONObj& example,
+                    const Execution& execution);
+
+        /** Whether appendTop() can sort by 'field': a number in ShapeData, or avgMicros. */
+        static bool canSortBy(const StringData& field);
+
+        /** Appends up to 'limit' shapes, those with the largest 'sortBy' first. */
+        void appendTop(BSONArrayBuilder& b, const StringData& sortBy, int limit) const;
+
+        void reset();
+
+        size_t size() const;
+
+        static QueryShapeStats global;
+
+    private:
+        struct Entry {
+            ShapeData data;
+            std::list<std::string>::iterator lruPosition;
+        };
+
+        typedef unordered_map<std::string, Entry> EntryMap;
+
+        mutable SimpleMutex _lock;
+        EntryMap _entries;
+
+        // Keys of '_entries', most recently run at the front.
+        std::list<std::string> _lru;
+    };
+
+}  // namespace mongo
@@ -0,0 +1,238 @@
+// residency.cpp
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/db/stats/residency.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/namespace_details.h"
+#include "mongo/db/pdfile.h"
+#include "mongo/db/storage/extent.h"
+#include "mongo/db/storage/index_details.h"
+#include "mongo/util/processinfo.h"
+
+namespace mongo {
+
+    ResidencyTracker ResidencyTracker::global;
+
+    void ResidencyTracker::FaultData::append(BSONObjBuilder& b) const {
+        b.appendNumber("accessesNotInMemory", accessesNotInMemory);
+        b.appendNumber("pageFaultExceptionsThrown", pageFaultExceptionsThrown);
+    }
+
+    void ResidencyTracker::recordNotInMemory(const StringData& ns, bool threwPageFaultException) {
+        SimpleMutex::scoped_lock lk(_lock);
+        FaultData& faults = _faults[ns];
+        faults.accessesNotInMemory++;
+        if (threwPageFaultException) {
+            faults.pageFaultExceptionsThrown++;
+        }
+    }
+
+    ResidencyTracker::FaultData ResidencyTracker::get(const StringData& ns) const {
+        SimpleMutex::scoped_lock lk(_lock);
+        FaultMap::const_iterator it = _faults.find(ns);
+        if (it == _faults.end()) {
+            return FaultData();
+        }
+        return it->second;
+    }
+
+    void ResidencyTracker::append(BSONObjBuilder& b) const {
+        SimpleMutex::scoped_lock lk(_lock);
+
+        vector<string> names;
+        for (FaultMap::const_iterator i = _faults.begin(); i != _faults.end(); ++i) {
+            names.push_back(i->first);
+        }
+        std::sort(names.begin(), names.end());
+
+        for (size_t i = 0; i < names.size(); ++i) {
+            BSONObjBuilder bb(b.subobjStart(names[i]));
+            _faults.find(names[i])->second.append(bb);
+            bb.done();
+        }
+    }
+
+    void ResidencyTracker::collectionDropped(const StringData& ns) {
+        string prefix = ns.toString() + ".$";
+        SimpleMutex::scoped_lock lk(_lock);
+        vector<string> dropped;
+        for (FaultMap::const_iterator i = _faults.begin(); i != _faults.end(); ++i) {
+            if (i->first == ns || StringData(i->first).startsWith(prefix)) {
+                dropped.push_back(i->first);
+            }
+        }
+        for (size_t i = 0; i < dropped.size(); ++i) {
+            _faults.erase(dropped[i]);
+        }
+    }
+
+    void ResidencyTracker::indexDropped(const StringData& indexNs) {
+        SimpleMutex::scoped_lock lk(_lock);
+        _faults.erase(indexNs);
+    }
+
+    void ResidencyTracker::Residency::append(BSONObjBuilder& b) const {
+        b.appendNumber("extents", extents);
+        b.appendNumber("bytes", bytes);
+        b.appendNumber("residentBytes", residentBytes);
+        b.append("residentFraction", bytes ? static_cast<double>(residentBytes) / bytes : 0.0);
+    }
+
+    // static
+    ResidencyTracker::Residency ResidencyTracker::residencyOf(const NamespaceDetails* nsd) {
+        // mincore() fills in a byte per page, so ask about a bounded number at a time
+        const size_t maxPagesPerCall = 64 * 1024;
+        const unsigned long long pageSize = ProcessInfo::getPageSize();
+
+        Residency residency;
+        vector<char> inMemory;
+        for (DiskLoc extLoc = nsd->firstExtent(); !extLoc.isNull(); ) {
+            const Extent* e = extLoc.ext();
+            residency.extents++;
+            residency.bytes += e->length;
+
+            const char* start = reinterpret_cast<const char*>(e);
+            const char* end = start + e->length;
+            const char* page = static_cast<const char*>(ProcessInfo::alignToStartOfPage(start));
+            while (page < end) {
+                size_t numPages = std::min(maxPagesPerCall,
+                                           static_cast<size_t>((end - page + pageSize - 1) /
+                                                               pageSize));
+                if (!ProcessInfo::pagesInMemory(page, numPages, &inMemory)) {
+                    break;
+                }
+                for (size_t i = 0; i < numPages; ++i) {
+                    if (!inMemory[i]) {
+                        continue;
+                    }
+                    // count only the part of the first and last pages inside the extent
+                    const char* from = std::max(page + i * pageSize, start);
+                    const char* to = std::min(page + (i + 1) * pageSize, end);
+                    residency.residentBytes += to - from;
+                }
+                page += numPages * pageSize;
+            }
+
+            extLoc = e->xnext;
+        }
+        return residency;
+    }
+
+    /**
+     * { residency: <collection> } reports how much of the collection and each of its indexes the
+     * OS has in memory right now, and how often accesses to them missed memory since the server
+     * started.  A collection or index that is mostly not resident, yet faults often, has a
+     * working set that doesn't fit.
+     */
+    class ResidencyCmd : public Command {
+    public:
+        ResidencyCmd() : Command("residency") {}
+
+        virtual bool slaveOk() const { return true; }
+
+        virtual LockType locktype() const { return READ; }
+
+        virtual void help(stringstream& h) const {
+            h << "Reports the resident bytes of a collection and of each of its indexes, and "
+              << "their accesses that weren't in memory.  For example, {residency: 'collection'}.";
+        }
+
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::collStats);
+            out->push_back(Privilege(parseResourcePattern(dbname, cmdObj), actions));
+        }
+
+        bool run(const string& dbname, BSONObj& cmdObj, int, string& errmsg,
+                 BSONObjBuilder& result, bool fromRepl) {
+            if (!ProcessInfo::blockCheckSupported()) {
+                errmsg = "residency is not supported on this platform";
+                return false;
+            }
+
+            string ns = dbname + "." + cmdObj.firstElement().valuestrsafe();
+            NamespaceDetails* nsd = nsdetails(ns);
+            if (!nsd) {
+                errmsg = "ns not found";
+                return false;
+            }
+
+            result.append("ns", ns);
+            {
+                BSONObjBuilder b(result.subobjStart("collection"));
+                ResidencyTracker::residencyOf(nsd).append(b);
+                ResidencyTracker::global.get(ns).append(b);
+                b.done();
+            }
+
+            BSONObjBuilder indexes(result.subobjStart("indexes"));
+            for (int i = 0; i < nsd->getCompletedIndexCount(); ++i) {
+                IndexDetails& id = nsd->idx(i);
+                NamespaceDetails* indexNsd = nsdetails(id.indexNamespace());
+                if (!indexNsd) {
+                    continue;
+                }
+                BSONObjBuilder b(indexes.subobjStart(id.indexName()));
+                ResidencyTracker::residencyOf(indexNsd).append(b);
+                ResidencyTracker::global.get(id.indexNamespace()).append(b);
+                b.done();
+            }
+            indexes.done();
+            return true;
+        }
+
+    } residencyCmd;
+
+    class ResidencyServerStatusSection : public ServerStatusSection {
+    public:
+        ResidencyServerStatusSection() : ServerStatusSection("pageFaultsByNamespace") {}
+
+        // One entry for every namespace that has missed memory, so only on request.
+        virtual bool includeByDefault() const { return false; }
+
+        BSONObj generateSection(const BSONElement& configElement) const {
+            BSONObjBuilder b;
+            ResidencyTracker::global.append(b);
+            return b.obj();
+        }
+
+    } residencyServerStatusSection;
+
+}  // namespace mongo
@@ -0,0 +1,98 @@
+// residency.h
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include "mongo/base/string_data.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/string_map.h"
+
+namespace mongo {
+
+    class NamespaceDetails;
+
+    /**
+     * Attributes the accesses to records that weren't in memory, and the PageFaultExceptions
+     * they caused, to the collection or index whose extent holds the record, e.g. "test.foo" or
+     * "test.foo.$a_1".  These are the per-namespace counterparts of RecordStats.
+     */
+    class ResidencyTracker {
+    public:
+        ResidencyTracker() : _lock("ResidencyTracker") { }
+
+        struct FaultData {
+            FaultData() : accessesNotInMemory(0), pageFaultExceptionsThrown(0) { }
+
+            long long accessesNotInMemory;
+            long long pageFaultExceptionsThrown;
+
+            void append(BSONObjBuilder& b) const;
+        };
+
+        typedef StringMap<FaultData> FaultMap;
+
+        /** Records an access to a record of 'ns' that wasn't in memory. */
+        void recordNotInMemory(const StringData& ns, bool threwPageFaultException);
+
+        /** Returns a copy of the faults of 'ns', which is all zero if there were none. */
+        FaultData get(const StringData& ns) const;
+
+        void append(BSONObjBuilder& b) const;
+
+        /** Forgets the faults of 'ns' and of its indexes. */
+        void collectionDropped(const StringData& ns);
+
+        void indexDropped(const StringData& indexNs);
+
+        struct Residency {
+            Residency() : extents(0), bytes(0), residentBytes(0) { }
+
+            long long extents;
+            long long bytes;
+            long long residentBytes;
+
+            void append(BSONObjBuilder& b) const;
+        };
+
+        /**
+         * Adds up how much of the extents of 'nsd' the OS has in memory, asking for every page of
+         * them.  Requires ProcessInfo::blockCheckSupported() and a read lock.
+         */
+        static Residency residencyOf(const NamespaceDetails* nsd);
+
+        static ResidencyTracker global;
+
+    private:
+        mutable SimpleMutex _lock;
+        FaultMap _faults;
+    };
+
+}  // namespace mongo
@@ -32,15 +32,25 @@
 
 #include "mongo/db/stats/top.h"
 
+#include "mongo/base/counter.h"
 #include "mongo/db/auth/action_set.h"
 #include "mongo/db/auth/action_type.h"
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/privilege.h"
 #include "mongo/util/net/message.h"
 #include "mongo/db/commands.h"
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/server_parameters.h"
 
 namespace mongo {
 
+    // Bounds the memory used by collections that are never dropped.
+    MONGO_EXPORT_SERVER_PARAMETER(topMaxNamespaces, int, 100000);
+
+    static Counter64 untrackedOps;
+    static ServerStatusMetricField<Counter64> displayUntrackedOps( "top.untrackedOps",
+                                                                   &untrackedOps );
+
     Top::UsageData::UsageData( const UsageData& older , const UsageData& newer ) {
         // this won't be 100% accurate on rollovers and drop(), but at least it won't be negative
         time  = (newer.time  >= older.time)  ? (newer.time  - older.time)  : newer.time;
@@ -51,6 +61,7 @@ namespace mongo {
         : total( older.total , newer.total ) ,
           readLock( older.readLock , newer.readLock ) ,
           writeLock( older.writeLock , newer.writeLock ) ,
+          lockWait( older.lockWait , newer.lockWait ) ,
           queries( older.queries , newer.queries ) ,
           getmore( older.getmore , newer.getmore ) ,
           insert( older.insert , newer.insert ) ,
@@ -60,24 +71,54 @@ namespace mongo {
 
     }
 
-    void Top::record( const StringData& ns , int op , int lockType , long long micros , bool command ) {
+    void Top::CollectionData::add( const CollectionData& other ) {
+        total.add( other.total );
+        readLock.add( other.readLock );
+        writeLock.add( other.writeLock );
+        lockWait.add( other.lockWait );
+        queries.add( other.queries );
+        getmore.add( other.getmore );
+        insert.add( other.insert );
+        update.add( other.update );
+        remove.add( other.remove );
+        commands.add( other.commands );
+    }
+
+    Top::Stripe& Top::_stripeFor( const StringData& ns ) {
+        return _stripes[ StringData::Hasher()( ns ) % numStripes ];
+    }
+
+    void Top::record( const StringData& ns , int op , int lockType , long long micros , bool command ,
+                      long long lockWaitMicros ) {
         if ( ns[0] == '?' )
             return;
 
         //cout << "record: " << ns << "\t" << op << "\t" << command << endl;
-        SimpleMutex::scoped_lock lk(_lock);
+        Stripe& stripe = _stripeFor( ns );
+        SimpleMutex::scoped_lock lk( stripe.lock );
 
-        if ( ( command || op == dbQuery ) && ns == _lastDropped ) {
-            _lastDropped = "";
+        if ( ( command || op == dbQuery ) && ns == stripe.lastDropped ) {
+            stripe.lastDropped = "";
             return;
         }
 
-        CollectionData& coll = _usage[ns];
-        _record( coll , op , lockType , micros , command );
-        _record( _global , op , lockType , micros , command );
+        _record( stripe.global , op , lockType , micros , command , lockWaitMicros );
+
+        if ( stripe.usage.find( ns ) == stripe.usage.end() ) {
+            // the limit can be overshot by a few racing inserts into different stripes
+            if ( _numNamespaces.load() >= static_cast<unsigned>( topMaxNamespaces ) ) {
+                untrackedOps.increment();
+                return;
+            }
+            _numNamespaces.fetchAndAdd( 1 );
+        }
+
+        CollectionData& coll = stripe.usage[ns];
+        _record( coll , op , lockType , micros , command , lockWaitMicros );
     }
 
-    void Top::_record( CollectionData& c , int op , int lockType , long long micros , bool command ) {
+    void Top::_record( CollectionData& c , int op , int lockType , long long micros , bool command ,
+                       long long lockWaitMicros ) {
         c.total.inc( micros );
 
         if ( lockType > 0 )
@@ -85,6 +126,9 @@ namespace mongo {
         else if ( lockType < 0 )
             c.readLock.inc( micros );
 
+        if ( lockWaitMicros > 0 )
+            c.lockWait.inc( lockWaitMicros );
+
         switch ( op ) {
         case 0:
             // use 0 for unknown, non-specific
@@ -120,19 +164,57 @@ namespace mongo {
     }
 
     void Top::collectionDropped( const StringData& ns ) {
-        SimpleMutex::scoped_lock lk(_lock);
-        _usage.erase(ns);
-        _lastDropped = ns.toString();
+        Stripe& stripe = _stripeFor( ns );
+        SimpleMutex::scoped_lock lk( stripe.lock );
+        if ( stripe.usage.erase( ns ) ) {
+            _numNamespaces.fetchAndSubtract( 1 );
+        }
+        stripe.lastDropped = ns.toString();
+    }
+
+    void Top::databaseDropped( const StringData& db ) {
+        string prefix = db.toString() + ".";
+        for ( size_t s = 0; s < numStripes; s++ ) {
+            Stripe& stripe = _stripes[s];
+            SimpleMutex::scoped_lock lk( stripe.lock );
+            vector<string> dropped;
+            for ( UsageMap::const_iterator i = stripe.usage.begin(); i != stripe.usage.end(); ++i ) {
+                if ( StringData( i->first ).startsWith( prefix ) ) {
+                    dropped.push_back( i->first );
+                }
+            }
+            for ( size_t i = 0; i < dropped.size(); i++ ) {
+                stripe.usage.erase( dropped[i] );
+            }
+            _numNamespaces.fetchAndSubtract( dropped.size() );
+        }
+    }
+
+    Top::CollectionData Top::getGlobalData() const {
+        CollectionData global;
+        for ( size_t s = 0; s < numStripes; s++ ) {
+            SimpleMutex::scoped_lock lk( _stripes[s].lock );
+            global.add( _stripes[s].global );
+        }
+        return global;
     }
 
     void Top::cloneMap(Top::UsageMap& out) const {
-        SimpleMutex::scoped_lock lk(_lock);
-        out = _usage;
+        out = UsageMap();
+        for ( size_t s = 0; s < numStripes; s++ ) {
+            SimpleMutex::scoped_lock lk( _stripes[s].lock );
+            const UsageMap& usage = _stripes[s].usage;
+            for ( UsageMap::const_iterator i = usage.begin(); i != usage.end(); ++i ) {
+                out[i->first] = i->second;
+            }
+        }
     }
 
     void Top::append( BSONObjBuilder& b ) {
-        SimpleMutex::scoped_lock lk( _lock );
-        _appendToUsageMap( b , _usage );
+        // copy out so the stripes aren't held while the response is built
+        UsageMap usage;
+        cloneMap( usage );
+        _appendToUsageMap( b , usage );
     }
 
     void Top::_appendToUsageMap( BSONObjBuilder& b , const UsageMap& map ) const {
@@ -154,6 +236,7 @@ namespace mongo {
 
             _appendStatsEntry( b , "readLock" , coll.readLock );
             _appendStatsEntry( b , "writeLock" , coll.writeLock );
+            _appendStatsEntry( b , "lockWait" , coll.lockWait );
 
             _appendStatsEntry( b , "queries" , coll.queries );
             _appendStatsEntry( b , "getmore" , coll.getmore );
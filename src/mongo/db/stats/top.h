@@ -19,6 +19,7 @@
 
 #include <boost/date_time/posix_time/posix_time.hpp>
 
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/string_map.h"
 
@@ -26,11 +27,15 @@ namespace mongo {
 
     /**
      * tracks usage by collection
+     *
+     * Namespaces are spread over a fixed number of stripes, each with its own mutex, so ops on
+     * different collections rarely contend.  Totals are summed over the stripes when read.  At
+     * most topMaxNamespaces namespaces are tracked; ops on others only count toward the totals.
      */
     class Top {
 
     public:
-        Top() : _lock("Top") { }
+        Top() { }
 
         struct UsageData {
             UsageData() : time(0) , count(0) {}
@@ -42,6 +47,11 @@ namespace mongo {
                 count++;
                 time += micros;
             }
+
+            void add( const UsageData& other ) {
+                count += other.count;
+                time += other.time;
+            }
         };
 
         struct CollectionData {
@@ -55,6 +65,7 @@ namespace mongo {
 
             UsageData readLock;
             UsageData writeLock;
+            UsageData lockWait; // time spent acquiring locks, by the operations that waited
 
             UsageData queries;
             UsageData getmore;
@@ -62,16 +73,21 @@ namespace mongo {
             UsageData update;
             UsageData remove;
             UsageData commands;
+
+            void add( const CollectionData& other );
         };
 
         typedef StringMap<CollectionData> UsageMap;
 
     public:
-        void record( const StringData& ns , int op , int lockType , long long micros , bool command );
+        void record( const StringData& ns , int op , int lockType , long long micros , bool command ,
+                     long long lockWaitMicros = 0 );
         void append( BSONObjBuilder& b );
         void cloneMap(UsageMap& out) const;
-        CollectionData getGlobalData() const { return _global; }
+        CollectionData getGlobalData() const;
         void collectionDropped( const StringData& ns );
+        /** Forgets the usage of every collection in 'db'. */
+        void databaseDropped( const StringData& db );
 
     public: // static stuff
         static Top global;
@@ -79,12 +95,25 @@ namespace mongo {
     private:
         void _appendToUsageMap( BSONObjBuilder& b , const UsageMap& map ) const;
         void _appendStatsEntry( BSONObjBuilder& b , const char * statsName , const UsageData& map ) const;
-        void _record( CollectionData& c , int op , int lockType , long long micros , bool command );
+        void _record( CollectionData& c , int op , int lockType , long long micros , bool command ,
+                      long long lockWaitMicros );
+
+        struct Stripe {
+            Stripe() : lock("Top") { }
+            mutable SimpleMutex lock;
+            CollectionData global;
+            UsageMap usage;
+            string lastDropped;
+        };
+
+        static const size_t numStripes = 16;
+
+        Stripe& _stripeFor( const StringData& ns );
+
+        Stripe _stripes[numStripes];
 
-        mutable SimpleMutex _lock;
-        CollectionData _global;
-        UsageMap _usage;
-        string _lastDropped;
+        // namespaces in all stripes' usage maps
+        AtomicUInt32 _numNamespaces;
     };
 
 } // namespace mongo
@@ -37,6 +37,7 @@
 #include "mongo/db/d_concurrency.h"
 #include "mongo/db/dur.h"
 #include "mongo/db/lockstate.h"
+#include "mongo/db/storage/in_memory_files.h"
 #include "mongo/util/file_allocator.h"
 
 namespace mongo {
@@ -86,9 +87,15 @@ namespace mongo {
         return size;
     }
 
+    DataFile::~DataFile() {
+        if ( _inMemory && _mb )
+            InMemoryFiles::release( _mb );
+    }
+
     /** @return true if found and opened. if uninitialized (prealloc only) does not open. */
     Status DataFile::openExisting( const char *filename ) {
         verify( _mb == 0 );
+        verify( !_inMemory );
         if( !boost::filesystem::exists(filename) )
             return Status( ErrorCodes::InvalidPath, "DataFile::openExisting - file does not exist" );
 
@@ -132,6 +139,17 @@ namespace mongo {
         verify(size >= 64*1024*1024 || storageGlobalParams.smallfiles);
         verify( size % 4096 == 0 );
 
+        if ( _inMemory ) {
+            if ( preallocateOnly )
+                return;
+            verify( _mb == 0 );
+            _mb = InMemoryFiles::allocate( size );
+            data_file_check(_mb);
+            _inMemoryLength = size;
+            header()->init(fileNo, size, filename, false);
+            return;
+        }
+
         if ( preallocateOnly ) {
             if (storageGlobalParams.prealloc) {
                 FileAllocator::get()->requestAllocation( filename, size );
@@ -152,7 +170,8 @@ namespace mongo {
     }
 
     void DataFile::flush( bool sync ) {
-        mmf.flush( sync );
+        if ( !_inMemory )
+            mmf.flush( sync );
     }
 
     DiskLoc DataFile::allocExtentArea( int size ) {
@@ -173,7 +192,7 @@ namespace mongo {
 
     // -------------------------------------------------------------------------------
 
-    void DataFileHeader::init(int fileno, int filelength, const char* filename) {
+    void DataFileHeader::init(int fileno, int filelength, const char* filename, bool journal) {
         if ( uninitialized() ) {
             DEV log() << "datafileheader::init initializing " << filename << " n:" << fileno << endl;
             if( !(filelength > 32768 ) ) {
@@ -195,7 +214,8 @@ namespace mongo {
                 }
             }
 
-            getDur().createdFile(filename, filelength);
+            if ( journal )
+                getDur().createdFile(filename, filelength);
             verify( HeaderSize == 8192 );
             DataFileHeader *h = getDur().writing(this);
             h->fileLength = filelength;
@@ -73,7 +73,8 @@ namespace mongo {
 
         bool uninitialized() const { return version == 0; }
 
-        void init(int fileno, int filelength, const char* filename);
+        /** @param journal - false for a file in memory only, whose creation needn't be replayed */
+        void init(int fileno, int filelength, const char* filename, bool journal = true);
 
         bool isEmpty() const {
             return uninitialized() || ( unusedLength == fileLength - HeaderSize - 16 );
@@ -87,7 +88,9 @@ namespace mongo {
         friend class BasicCursor;
         friend class ExtentManager;
     public:
-        DataFile(int fn) : _mb(0), fileNo(fn) { }
+        /** @param inMemory - hold the file in memory only, with no journaling; see InMemoryFiles */
+        DataFile(int fn, bool inMemory = false) : _mb(0), fileNo(fn), _inMemory(inMemory), _inMemoryLength(0) { }
+        ~DataFile();
 
         /** @return true if found and opened. if uninitialized (prealloc only) does not open. */
         Status openExisting( const char *filename );
@@ -99,7 +102,7 @@ namespace mongo {
 
         DataFileHeader *getHeader() { return header(); }
         HANDLE getFd() { return mmf.getFd(); }
-        unsigned long long length() const { return mmf.length(); }
+        unsigned long long length() const { return _inMemory ? _inMemoryLength : mmf.length(); }
 
         /* return max size an extent may be */
         static int maxSize();
@@ -120,6 +123,8 @@ namespace mongo {
         DurableMappedFile mmf;
         void *_mb; // the memory mapped view
         int fileNo;
+        bool _inMemory;
+        unsigned long long _inMemoryLength;
     };
 
 
@@ -41,6 +41,7 @@
 #include "mongo/db/dur.h"
 #include "mongo/db/dur_journalformat.h"
 #include "mongo/db/memconcept.h"
+#include "mongo/server.h"
 #include "mongo/util/mongoutils/str.h"
 
 using namespace mongoutils;
@@ -59,6 +60,47 @@ namespace mongo {
         fassert( 16112, _view_private == old );
     }
 
+    void DurableMappedFile::noteWritten(size_t ofs, size_t len) {
+        if( unlikely(!_willNeedRemap) ) {
+            // usually it will already be set, so we test first to avoid cache line contention
+            _willNeedRemap = true;
+        }
+        if( len == 0 )
+            return;
+        if( _writtenChunks.empty() )
+            _writtenChunks.resize((length() + RemapChunkSize - 1) / RemapChunkSize);
+        size_t last = std::min((ofs + len - 1) / RemapChunkSize, _writtenChunks.size() - 1);
+        for( size_t c = ofs / RemapChunkSize; c <= last; c++ ) {
+            if( !_writtenChunks[c] ) {
+                _writtenChunks[c] = true;
+                _nWrittenChunks++;
+            }
+        }
+    }
+
+    void DurableMappedFile::remapWrittenChunks() {
+        _willNeedRemap = false;
+#if !defined(_WIN32) && !defined(__sunos__)
+        // one mmap for the whole view is cheaper once most of it has been written
+        if( _nWrittenChunks <= _writtenChunks.size() / 2 ) {
+            verify(storageGlobalParams.dur);
+            for( size_t c = 0; c < _writtenChunks.size() && _nWrittenChunks; c++ ) {
+                if( !_writtenChunks[c] )
+                    continue;
+                size_t ofs = c * RemapChunkSize;
+                size_t len = std::min((unsigned long long) RemapChunkSize, length() - ofs);
+                remapPrivateViewRange(_view_private, ofs, len);
+                _writtenChunks[c] = false;
+                _nWrittenChunks--;
+            }
+            return;
+        }
+#endif
+        remapThePrivateView();
+        _writtenChunks.assign(_writtenChunks.size(), false);
+        _nWrittenChunks = 0;
+    }
+
     /** register view. threadsafe */
     void PointerToDurableMappedFile::add(void *view, DurableMappedFile *f) {
         verify(view);
@@ -170,7 +212,7 @@ namespace mongo {
         return false;
     }
 
-    DurableMappedFile::DurableMappedFile() : _willNeedRemap(false) {
+    DurableMappedFile::DurableMappedFile() : _willNeedRemap(false), _nWrittenChunks(0) {
         _view_write = _view_private = 0;
     }
 
@@ -95,6 +95,17 @@ namespace mongo {
         */
         bool& willNeedRemap() { return _willNeedRemap; }
 
+        /** the private view is remapped in chunks of this size, just those written to */
+        enum { RemapChunkSize = 1024 * 1024 };
+
+        /** notes a journaled write to [ofs, ofs+len), which must be remapped later.  in PREPLOGBUFFER */
+        void noteWritten(size_t ofs, size_t len);
+
+        /** remaps the chunks written to since the last remap, or all of the private view if
+            most of it was.  clears willNeedRemap().
+        */
+        void remapWrittenChunks();
+
         void remapThePrivateView();
 
         virtual bool isDurableMappedFile() { return true; }
@@ -104,6 +115,8 @@ namespace mongo {
         void *_view_write;
         void *_view_private;
         bool _willNeedRemap;
+        std::vector<bool> _writtenChunks;   // by RemapChunkSize, since the last remap
+        unsigned _nWrittenChunks;
         RelativePath _p;   // e.g. "somepath/dbname"
         int _fileSuffixNo;  // e.g. 3.  -1="ns"
 
@@ -0,0 +1,144 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/db/storage/extent_heat.h"
+
+#include <algorithm>
+#include <boost/filesystem/operations.hpp>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/util/file.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    using namespace mongoutils;
+
+    namespace {
+        // bounds the saved file, and the time spent reading it back, on databases with huge
+        // numbers of extents; the coldest add little once the rest are warm
+        const size_t MaxSavedExtents = 100 * 1000;
+
+        bool hotter( const ExtentHeat::Entry& a, const ExtentHeat::Entry& b ) {
+            return a.heat > b.heat;
+        }
+    }
+
+    ExtentHeat::ExtentHeat() : _mutex( "ExtentHeat" ) {
+    }
+
+    void ExtentHeat::noteAccess( const DiskLoc& extentLoc, int extentLength ) {
+        SimpleMutex::scoped_lock lk( _mutex );
+        Entry& e = _extents[extentLoc];
+        e.extent = extentLoc;
+        e.length = extentLength;
+        e.heat++;
+    }
+
+    std::vector<ExtentHeat::Entry> ExtentHeat::hottest() const {
+        std::vector<Entry> all;
+        {
+            SimpleMutex::scoped_lock lk( _mutex );
+            all.reserve( _extents.size() );
+            for ( Map::const_iterator i = _extents.begin(); i != _extents.end(); ++i )
+                all.push_back( i->second );
+        }
+        std::sort( all.begin(), all.end(), hotter );
+        return all;
+    }
+
+    Status ExtentHeat::load( const std::string& fileName ) {
+        if ( !boost::filesystem::exists( fileName ) )
+            return Status::OK();
+
+        File f;
+        f.open( fileName.c_str(), true );
+        fileofs len = f.len();
+        if ( f.bad() || len < 5 || len > BSONObjMaxInternalSize )
+            return Status( ErrorCodes::BadValue, str::stream() << "can't read " << fileName );
+        boost::scoped_array<char> buf( new char[len] );
+        f.read( 0, buf.get(), len );
+        if ( f.bad() || *reinterpret_cast<int*>( buf.get() ) != len )
+            return Status( ErrorCodes::BadValue, str::stream() << "can't read " << fileName );
+        BSONObj saved( buf.get() );
+        if ( !saved.valid() || saved["v"].numberInt() != 1 )
+            return Status( ErrorCodes::BadValue, str::stream() << "bad extent heat in " << fileName );
+
+        SimpleMutex::scoped_lock lk( _mutex );
+        BSONObjIterator i( saved["extents"].Obj() );
+        while ( i.more() ) {
+            BSONObj e = i.next().Obj();
+            DiskLoc loc( e["f"].numberInt(), e["o"].numberInt() );
+            Entry& entry = _extents[loc];
+            entry.extent = loc;
+            entry.length = e["len"].numberInt();
+            entry.heat += static_cast<unsigned>( e["h"].numberLong() / 2 );
+        }
+        return Status::OK();
+    }
+
+    Status ExtentHeat::save( const std::string& fileName ) const {
+        std::vector<Entry> all = hottest();
+        if ( all.size() > MaxSavedExtents )
+            all.resize( MaxSavedExtents );
+
+        BSONObjBuilder b;
+        b.append( "v", 1 );
+        BSONArrayBuilder extents( b.subarrayStart( "extents" ) );
+        for ( size_t i = 0; i < all.size(); i++ ) {
+            if ( all[i].heat == 0 )
+                break;
+            extents.append( BSON( "f" << all[i].extent.a() << "o" << all[i].extent.getOfs()
+                                  << "len" << all[i].length
+                                  << "h" << static_cast<long long>( all[i].heat ) ) );
+        }
+        extents.done();
+        BSONObj obj = b.obj();
+
+        // write aside and rename, so a crash can't leave a torn file
+        std::string tmp = fileName + ".tmp";
+        {
+            File f;
+            f.open( tmp.c_str() );
+            f.truncate( 0 );
+            f.write( 0, obj.objdata(), obj.objsize() );
+            if ( f.bad() )
+                return Status( ErrorCodes::InternalError, str::stream() << "can't write " << tmp );
+        }
+        try {
+            boost::filesystem::rename( tmp, fileName );
+        }
+        catch ( const boost::filesystem::filesystem_error& e ) {
+            return Status( ErrorCodes::InternalError, e.what() );
+        }
+        return Status::OK();
+    }
+
+} // namespace mongo
@@ -0,0 +1,80 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "mongo/base/status.h"
+#include "mongo/db/diskloc.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    /**
+     * How much each extent of a database has been used, sampled as records are looked up.  It is
+     * saved beside the data files when the database is closed, so that after a restart the hottest
+     * extents can be read back into memory up front instead of being faulted in a page at a time.
+     *
+     * Counts loaded from a previous run are halved, so that old heat fades.
+     */
+    class ExtentHeat {
+    public:
+        /** one in this many record lookups is counted.  must be a power of two */
+        static const unsigned SampleRate = 128;
+
+        struct Entry {
+            Entry() : length( 0 ), heat( 0 ) { }
+            DiskLoc extent;
+            int length;
+            unsigned heat;
+        };
+
+        ExtentHeat();
+
+        void noteAccess( const DiskLoc& extentLoc, int extentLength );
+
+        /** @return the extents seen, hottest first */
+        std::vector<Entry> hottest() const;
+
+        /** adds the heat saved by save(), halved.  a missing file is not an error */
+        Status load( const std::string& fileName );
+
+        /** writes the hottest extents to 'fileName', replacing it whole */
+        Status save( const std::string& fileName ) const;
+
+    private:
+        typedef std::map<DiskLoc, Entry> Map;
+
+        mutable SimpleMutex _mutex;
+        Map _extents;
+    };
+
+} // namespace mongo
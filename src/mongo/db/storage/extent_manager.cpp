@@ -31,6 +31,7 @@
 #include "mongo/pch.h"
 
 #include <boost/filesystem/operations.hpp>
+#include <boost/thread/thread.hpp>
 
 #include "mongo/db/client.h"
 #include "mongo/db/d_concurrency.h"
@@ -41,20 +42,42 @@
 #include "mongo/db/storage/extent_manager.h"
 
 #include "mongo/db/pdfile.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/file.h"
+#include "mongo/util/processinfo.h"
+#include "mongo/util/time_support.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
+    // the most files to keep preallocated ahead of need when a database is growing quickly
+    MONGO_EXPORT_SERVER_PARAMETER(dataFilesPreallocatedAhead, int, 1);
+
+    // whether opening a database reads the extents that were hottest when it was closed back in
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(warmDataFilesOnOpen, bool, true);
+
     ExtentManager::ExtentManager( const StringData& dbname,
                                   const StringData& path,
                                   NamespaceDetails* freeListDetails,
-                                  bool directoryPerDB )
+                                  bool directoryPerDB,
+                                  bool inMemory )
         : _dbname( dbname.toString() ),
           _path( path.toString() ),
           _freeListDetails( freeListDetails ),
-          _directoryPerDB( directoryPerDB ) {
+          _directoryPerDB( directoryPerDB ),
+          _inMemory( inMemory ),
+          _nFilesFoundByInit( 0 ),
+          _mapMutex( "ExtentManager::_mapMutex" ),
+          _allocMutex( "ExtentManager::_allocMutex" ),
+          _lastFileAddedMillis( 0 ),
+          _filesAhead( 1 ),
+          _heatTick( 0 ) {
     }
 
     ExtentManager::~ExtentManager() {
+        if ( !_files.empty() )
+            saveHeat();
         reset();
     }
 
@@ -63,6 +86,7 @@ namespace mongo {
             delete _files[i];
         }
         _files.clear();
+        _nFilesFoundByInit = 0;
     }
 
     boost::filesystem::path ExtentManager::fileName( int n ) const {
@@ -75,42 +99,181 @@ namespace mongo {
         return fullName;
     }
 
+    boost::filesystem::path ExtentManager::_heatFileName() const {
+        boost::filesystem::path fullName( _path );
+        if ( _directoryPerDB )
+            fullName /= _dbname;
+        fullName /= _dbname + ".heat";
+        return fullName;
+    }
+
 
     Status ExtentManager::init() {
         verify( _files.size() == 0 );
 
-        for ( int n = 0; n < DiskLoc::MaxFiles; n++ ) {
-            boost::filesystem::path fullName = fileName( n );
-            if ( !boost::filesystem::exists( fullName ) )
-                break;
-
-            string fullNameString = fullName.string();
-
-            auto_ptr<DataFile> df( new DataFile(n) );
+        if ( _inMemory )
+            return Status::OK(); // files in memory don't outlive the database
 
-            Status s = df->openExisting( fullNameString.c_str() );
+        int n = 0;
+        while ( n < DiskLoc::MaxFiles && boost::filesystem::exists( fileName( n ) ) )
+            n++;
+
+        // files are allocated in order, ahead of need, so only the last few may be unused
+        while ( n > 0 && _isPreallocatedOnly( fileName( n - 1 ) ) )
+            n--;
+
+        if ( Lock::collectionLockingEnabled() )
+            _files.reserve( DiskLoc::MaxFiles );
+        _files.resize( n, NULL );
+        _nFilesFoundByInit = n;
+
+        // the first file is always needed, and a bad one should be found now rather than later
+        if ( n > 0 ) {
+            boost::filesystem::path fullName = fileName( 0 );
+            auto_ptr<DataFile> df( new DataFile(0) );
+            Status s = df->openExisting( fullName.string().c_str() );
             if ( !s.isOK() ) {
+                _files.clear();
+                _nFilesFoundByInit = 0;
                 return s;
             }
+            _files[0] = df.release();
 
-            if ( df->getHeader()->uninitialized() ) {
-                // pre-alloc only, so we're done
-                break;
-            }
-
-            _files.push_back( df.release() );
+            Status heat = _heat.load( _heatFileName().string() );
+            if ( !heat.isOK() )
+                warning() << "ignoring saved extent heat: " << heat.toString() << endl;
+            else if ( warmDataFilesOnOpen )
+                _startWarmup();
         }
 
         return Status::OK();
     }
 
+    namespace {
+        struct WarmupRange {
+            std::string file;
+            fileofs ofs;
+            int len;
+        };
+
+        void warmUp( const std::string& dbname, const std::vector<WarmupRange>& ranges ) {
+            setThreadName( "warmDataFiles" );
+            Timer t;
+            const unsigned ChunkSize = 1024 * 1024;
+            boost::scoped_array<char> buf( new char[ChunkSize] );
+            long long bytes = 0;
+            try {
+                std::string openName;
+                scoped_ptr<File> f;
+                fileofs fileLen = 0;
+                for ( size_t i = 0; i < ranges.size(); i++ ) {
+                    const WarmupRange& r = ranges[i];
+                    if ( r.file != openName ) {
+                        f.reset( new File() );
+                        openName = r.file;
+                        if ( !boost::filesystem::exists( openName ) )
+                            continue;
+                        f->open( openName.c_str(), true );
+                        fileLen = f->bad() ? 0 : f->len();
+                    }
+                    // reading puts the pages in the cache the data file mapping is backed by
+                    fileofs end = std::min( r.ofs + r.len, fileLen );
+                    for ( fileofs o = r.ofs; o < end && !f->bad(); o += ChunkSize ) {
+                        unsigned n = static_cast<unsigned>( std::min<fileofs>( ChunkSize, end - o ) );
+                        f->read( o, buf.get(), n );
+                        bytes += n;
+                    }
+                }
+            }
+            catch ( const std::exception& e ) {
+                warning() << "warming data files of " << dbname << " stopped: " << e.what() << endl;
+            }
+            log() << "read " << bytes / 1024 / 1024 << "MB of the hottest extents of " << dbname
+                  << " into memory in " << t.millis() << "ms" << endl;
+        }
+    }
+
+    void ExtentManager::_startWarmup() {
+        std::vector<ExtentHeat::Entry> hottest = _heat.hottest();
+        if ( hottest.empty() )
+            return;
+
+        // leave room for everything else: half of memory is plenty to take the faults out of
+        // the first minutes after a restart
+        const long long budget = ProcessInfo().getMemSizeMB() * 1024 * 1024 / 2;
+        std::vector<WarmupRange> ranges;
+        long long total = 0;
+        for ( size_t i = 0; i < hottest.size() && total < budget; i++ ) {
+            if ( hottest[i].length <= 0 || hottest[i].extent.a() < 0 ||
+                 hottest[i].extent.a() >= static_cast<int>( _nFilesFoundByInit ) )
+                continue;
+            WarmupRange r;
+            r.file = fileName( hottest[i].extent.a() ).string();
+            r.ofs = hottest[i].extent.getOfs();
+            r.len = hottest[i].length;
+            ranges.push_back( r );
+            total += r.len;
+        }
+        boost::thread t( boost::bind( &warmUp, _dbname, ranges ) );
+    }
+
+    void ExtentManager::saveHeat() const {
+        if ( _inMemory )
+            return; // nothing to warm at the next open
+        Status s = _heat.save( _heatFileName().string() );
+        if ( !s.isOK() )
+            warning() << "couldn't save extent heat of " << _dbname << ": " << s.toString() << endl;
+    }
+
+    void ExtentManager::_noteAccess( const DataFile* df, const DiskLoc& loc ) const {
+        const Record* r = reinterpret_cast<const Record*>( df->p() + loc.getOfs() );
+        int extentOfs = r->extentOfs();
+        if ( extentOfs < DataFileHeader::HeaderSize ||
+             static_cast<unsigned long long>( extentOfs ) >= df->length() )
+            return; // not a record we know the extent of
+        const Extent* e = reinterpret_cast<const Extent*>( df->p() + extentOfs );
+        if ( !e->isOk() )
+            return;
+        _heat.noteAccess( DiskLoc( loc.a(), extentOfs ), e->length );
+    }
+
+    // static
+    bool ExtentManager::_isPreallocatedOnly( const boost::filesystem::path& fullName ) {
+        File f;
+        f.open( fullName.string().c_str(), true );
+        if ( !f.is_open() || f.bad() || f.len() < static_cast<fileofs>( sizeof(int) ) )
+            return true;
+        int version = 0;
+        f.read( 0, reinterpret_cast<char*>( &version ), sizeof(version) );
+        return f.bad() || version == 0; // see DataFileHeader::uninitialized()
+    }
+
+    DataFile* ExtentManager::_mapFile( int n ) const {
+        SimpleMutex::scoped_lock lk( _mapMutex );
+        if ( _files[n] )
+            return _files[n]; // mapped by another reader while we waited
+
+        boost::filesystem::path fullName = fileName( n );
+        auto_ptr<DataFile> df( new DataFile(n) );
+        Status s = df->openExisting( fullName.string().c_str() );
+        massert( 17320, str::stream() << "couldn't open data file " << fullName.string()
+                        << ": " << s.toString(),
+                 s.isOK() );
+        LOG(1) << "mapped " << fullName.string() << " on first use" << endl;
+        _files[n] = df.release();
+        return _files[n];
+    }
+
     const DataFile* ExtentManager::_getOpenFile( int n ) const {
         verify(this);
         DEV Lock::assertAtLeastReadLocked( _dbname );
         if ( n < 0 || n >= static_cast<int>(_files.size()) )
             log() << "uh oh: " << n;
         verify( n >= 0 && n < static_cast<int>(_files.size()) );
-        return _files[n];
+        DataFile* p = _files[n];
+        if ( !p && static_cast<size_t>(n) < _nFilesFoundByInit )
+            p = _mapFile( n );
+        return p;
     }
 
 
@@ -132,7 +295,7 @@ namespace mongo {
         if ( !preallocateOnly ) {
             while ( n >= (int) _files.size() ) {
                 verify(this);
-                if( !Lock::isWriteLocked(_dbname) ) {
+                if( !Lock::isWriteLocked(_dbname) && !Lock::isIntentWriteLocked(_dbname) ) {
                     log() << "error: getFile() called in a read lock, yet file to return is not yet open" << endl;
                     log() << "       getFile(" << n << ") _files.size:" <<_files.size() << ' ' << fileName(n).string() << endl;
                     log() << "       context ns: " << cc().ns() << endl;
@@ -141,15 +304,18 @@ namespace mongo {
                 _files.push_back(0);
             }
             p = _files[n];
+            if ( p == 0 && static_cast<size_t>(n) < _nFilesFoundByInit )
+                p = _mapFile( n );
         }
         if ( p == 0 ) {
-            DEV Lock::assertWriteLocked( _dbname );
+            DEV _assertCanAllocate();
             boost::filesystem::path fullName = fileName( n );
             string fullNameString = fullName.string();
-            p = new DataFile(n);
+            p = new DataFile(n, _inMemory);
             int minSize = 0;
-            if ( n != 0 && _files[ n - 1 ] )
-                minSize = _files[ n - 1 ]->getHeader()->fileLength;
+            if ( n != 0 && static_cast<size_t>(n - 1) < _files.size() &&
+                 ( _files[ n - 1 ] || static_cast<size_t>(n - 1) < _nFilesFoundByInit ) )
+                minSize = getFile( n - 1 )->getHeader()->fileLength;
             if ( sizeNeeded + DataFileHeader::HeaderSize > minSize )
                 minSize = sizeNeeded + DataFileHeader::HeaderSize;
             try {
@@ -167,15 +333,38 @@ namespace mongo {
         return preallocateOnly ? 0 : p;
     }
 
+    void ExtentManager::_assertCanAllocate() const {
+        if ( Lock::isIntentWriteLocked( _dbname ) )
+            _allocMutex.dassertLocked();
+        else
+            Lock::assertWriteLocked( _dbname );
+    }
+
     DataFile* ExtentManager::addAFile( int sizeNeeded, bool preallocateNextFile ) {
-        DEV Lock::assertWriteLocked( _dbname );
+        DEV _assertCanAllocate();
         int n = (int) _files.size();
         DataFile *ret = getFile( n, sizeNeeded );
-        if ( preallocateNextFile )
-            preallocateAFile();
+        if ( preallocateNextFile && !_inMemory )
+            _preallocateAhead();
         return ret;
     }
 
+    void ExtentManager::_preallocateAhead() {
+        // a file filled within a minute means the next would likely be needed before a single
+        // preallocated one is ready, so keep one more ahead each time, up to the limit
+        unsigned long long now = curTimeMillis64();
+        const int most = std::max( 1, static_cast<int>( dataFilesPreallocatedAhead ) );
+        if ( _lastFileAddedMillis != 0 && now - _lastFileAddedMillis < 60 * 1000 )
+            _filesAhead = std::min( _filesAhead + 1, most );
+        else
+            _filesAhead = 1;
+        _lastFileAddedMillis = now;
+
+        int n = numFiles();
+        for ( int i = 0; i < _filesAhead && n + i < DiskLoc::MaxFiles; i++ )
+            getFile( n + i, 0, true );
+    }
+
     size_t ExtentManager::numFiles() const {
         DEV Lock::assertAtLeastReadLocked( _dbname );
         return _files.size();
@@ -183,6 +372,11 @@ namespace mongo {
 
     long long ExtentManager::fileSize() const {
         long long size=0;
+        if ( _inMemory ) {
+            for ( size_t n = 0; n < _files.size(); n++ )
+                size += _files[n] ? _files[n]->length() : 0;
+            return size;
+        }
         for ( int n = 0; boost::filesystem::exists( fileName(n) ); n++)
             size += boost::filesystem::file_size( fileName(n) );
         return size;
@@ -192,6 +386,8 @@ namespace mongo {
         DEV Lock::assertAtLeastReadLocked( _dbname );
         for( vector<DataFile*>::iterator i = _files.begin(); i != _files.end(); i++ ) {
             DataFile *f = *i;
+            if ( !f )
+                continue; // never mapped, so nothing to flush
             f->flush(sync);
         }
     }
@@ -205,6 +401,10 @@ namespace mongo {
             df->badOfs(ofs); // will uassert - external call to keep out of the normal code path
         }
 
+        // racy, as RARELY is: a lost count only makes the sampling a little uneven
+        if ( MONGO_unlikely( ( ++_heatTick & ( ExtentHeat::SampleRate - 1 ) ) == 0 ) )
+            _noteAccess( df, loc );
+
         return reinterpret_cast<Record*>( df->p() + ofs );
     }
 
@@ -374,7 +574,7 @@ namespace mongo {
         // no space in an existing file
         // allocate files until we either get one big enough or hit maxSize
         for ( int i = 0; i < 8; i++ ) {
-            DataFile* f = addAFile( size, false );
+            DataFile* f = addAFile( size, true );
 
             if ( f->getHeader()->unusedLength >= size ) {
                 return _createExtentInFile( numFiles() - 1, f, size, maxFileNoForQuota );
@@ -487,6 +687,7 @@ namespace mongo {
                                                 NamespaceDetails* details,
                                                 int size,
                                                 int quotaMax ) {
+        SimpleMutex::scoped_lock lk( _allocMutex );
 
         bool fromFreeList = true;
         DiskLoc eloc = allocFromFreeList( size, details->isCapped() );
@@ -537,6 +738,8 @@ namespace mongo {
         if ( firstExt.isNull() && lastExt.isNull() )
             return;
 
+        SimpleMutex::scoped_lock lk( _allocMutex );
+
         {
             verify( !firstExt.isNull() && !lastExt.isNull() );
             Extent *f = getExtent( firstExt );
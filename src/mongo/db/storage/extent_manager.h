@@ -38,6 +38,8 @@
 #include "mongo/base/status.h"
 #include "mongo/base/string_data.h"
 #include "mongo/db/diskloc.h"
+#include "mongo/db/storage/extent_heat.h"
+#include "mongo/util/concurrency/mutex.h"
 
 namespace mongo {
 
@@ -67,9 +69,14 @@ namespace mongo {
          *        while a bit odd, this is not a layer violation as extents
          *        are a peer to the .ns file, without any layering
          */
+        /**
+         * @param inMemory - keep the files in memory only: nothing is read or written on disk, and
+         *                   nothing journaled
+         */
         ExtentManager( const StringData& dbname, const StringData& path,
                        NamespaceDetails* freeListDetails,
-                       bool directoryPerDB );
+                       bool directoryPerDB,
+                       bool inMemory = false );
 
         ~ExtentManager();
 
@@ -84,7 +91,8 @@ namespace mongo {
         void init( NamespaceDetails* freeListDetails );
 
         /**
-         * opens all current files
+         * finds all current files.  each is mapped the first time it's used, so that opening a
+         * database with thousands of files doesn't have to map them all first.
          */
         Status init();
 
@@ -99,6 +107,9 @@ namespace mongo {
 
         void flushFiles( bool sync );
 
+        /** writes how hot each extent has been beside the data files, for the next open to warm */
+        void saveHeat() const;
+
         /* allocate a new Extent, does not check free list
            @param capped - true if capped collection
         */
@@ -168,9 +179,32 @@ namespace mongo {
 
         const DataFile* _getOpenFile( int n ) const;
 
+        /** map existing file 'n', found by init() but not used since */
+        DataFile* _mapFile( int n ) const;
+
+        /**
+         * asks the FileAllocator for the files after the last, more of them the faster the
+         * database has been growing, so that inserts don't wait at each file boundary
+         */
+        void _preallocateAhead();
+
+        /** counts a sampled lookup of the record at 'loc' towards the heat of its extent */
+        void _noteAccess( const DataFile* df, const DiskLoc& loc ) const;
+
+        /** reads the extents that were hottest at the last close into memory, in the background */
+        void _startWarmup();
+
+        boost::filesystem::path _heatFileName() const;
+
+        /** @return true if 'fullName' has only been preallocated, and so isn't in use yet */
+        static bool _isPreallocatedOnly( const boost::filesystem::path& fullName );
+
         DiskLoc _createExtentInFile( int fileNo, DataFile* f,
                                      int size, int maxFileNoForQuota );
 
+        /** asserts we may add files or extents: db write locked, or allocating under _allocMutex */
+        void _assertCanAllocate() const;
+
         boost::filesystem::path fileName( int n ) const;
 
 // -----
@@ -179,11 +213,29 @@ namespace mongo {
         std::string _path; // i.e. "/data/db"
         NamespaceDetails* _freeListDetails;
         bool _directoryPerDB;
+        bool _inMemory;
 
         // must be in the dbLock when touching this (and write locked when writing to of course)
         // however during Database object construction we aren't, which is ok as it isn't yet visible
         //   to others and we are in the dbholder lock then.
-        std::vector<DataFile*> _files;
+        //
+        // files found by init() are left null here until _mapFile opens them.  the slots are
+        // filled in under _mapMutex, as that may happen in a read lock.
+        mutable std::vector<DataFile*> _files;
+        size_t _nFilesFoundByInit;
+        mutable SimpleMutex _mapMutex;
+
+        // with collection level locking, writers of different collections may allocate at once.
+        // files, extents and the free list are changed only under this then, and _files is
+        // reserved in full so that adding a file doesn't move it under the other writers.
+        SimpleMutex _allocMutex;
+
+        // when the last file was added, and how many are now kept preallocated after it
+        unsigned long long _lastFileAddedMillis;
+        int _filesAhead;
+
+        mutable ExtentHeat _heat;
+        mutable unsigned _heatTick;
 
     };
 
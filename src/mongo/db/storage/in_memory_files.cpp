@@ -0,0 +1,124 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/db/storage/in_memory_files.h"
+
+#include <map>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    using namespace mongoutils;
+
+    // comma separated names of the databases to keep only in memory, with no files or journaling.
+    // their contents don't survive a restart.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(inMemoryDatabases, std::string, "");
+
+    bool isInMemoryDatabase( const StringData& dbname ) {
+        const std::string& names = inMemoryDatabases;
+        std::string::size_type pos = 0;
+        while ( pos <= names.size() ) {
+            std::string::size_type end = names.find( ',', pos );
+            if ( end == std::string::npos )
+                end = names.size();
+            if ( dbname == StringData( names ).substr( pos, end - pos ) )
+                return true;
+            pos = end + 1;
+        }
+        return false;
+    }
+
+    namespace {
+        SimpleMutex inMemoryMutex( "InMemoryFiles" );
+
+        // start -> length of each allocation
+        typedef std::map<const char*, size_t> Allocations;
+        Allocations& allocations() {
+            static Allocations* a = new Allocations();
+            return *a;
+        }
+    }
+
+    // static
+    void* InMemoryFiles::allocate( size_t len ) {
+#if defined(_WIN32)
+        void* p = VirtualAlloc( 0, len, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE );
+#else
+        // anonymous memory is zeroed, and only takes up room as it's touched
+        void* p = mmap( NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0 );
+        if ( p == MAP_FAILED )
+            p = NULL;
+#endif
+        if ( !p ) {
+            log() << "couldn't allocate " << len << " bytes for an in memory database: "
+                  << errnoWithDescription() << endl;
+            return NULL;
+        }
+        SimpleMutex::scoped_lock lk( inMemoryMutex );
+        allocations()[static_cast<const char*>( p )] = len;
+        return p;
+    }
+
+    // static
+    void InMemoryFiles::release( void* p ) {
+        size_t len;
+        {
+            SimpleMutex::scoped_lock lk( inMemoryMutex );
+            Allocations::iterator i = allocations().find( static_cast<const char*>( p ) );
+            verify( i != allocations().end() );
+            len = i->second;
+            allocations().erase( i );
+        }
+#if defined(_WIN32)
+        VirtualFree( p, 0, MEM_RELEASE );
+#else
+        munmap( p, len );
+#endif
+    }
+
+    // static
+    bool InMemoryFiles::contains( const void* p ) {
+        const char* c = static_cast<const char*>( p );
+        SimpleMutex::scoped_lock lk( inMemoryMutex );
+        Allocations::const_iterator i = allocations().upper_bound( c );
+        if ( i == allocations().begin() )
+            return false;
+        --i;
+        return c < i->first + i->second;
+    }
+
+} // namespace mongo
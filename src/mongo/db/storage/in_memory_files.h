@@ -0,0 +1,56 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "mongo/base/string_data.h"
+
+namespace mongo {
+
+    /** @return true if 'dbname' is one of the inMemoryDatabases, kept only in memory */
+    bool isInMemoryDatabase( const StringData& dbname );
+
+    /**
+     * The memory that stands in for the data and .ns files of in memory databases.  It is zeroed
+     * when allocated, as a new file would be.  Nothing written to it is journaled or reaches disk,
+     * and it is gone when the database is closed.
+     */
+    class InMemoryFiles {
+    public:
+        /** @return NULL if the memory can't be had */
+        static void* allocate( size_t len );
+
+        static void release( void* p );
+
+        /** @return true if 'p' is within memory from allocate(), so needs no journaling */
+        static bool contains( const void* p );
+    };
+
+} // namespace mongo
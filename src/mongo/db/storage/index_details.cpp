@@ -74,6 +74,11 @@ namespace mongo {
             return false;
         }
 
+        if ( info.obj().getObjectField("partialFilterExpression").woCompare(
+                 newSpec.getObjectField("partialFilterExpression") ) != 0 ) {
+            return false;
+        }
+
         // Note: { _id: 1 } or { _id: -1 } implies unique: true.
         if ( !isIdIndex() &&
              unique() != newSpec["unique"].trueValue() ) {
@@ -33,10 +33,16 @@
 #include <boost/filesystem/operations.hpp>
 
 #include "mongo/db/namespace_details.h"
+#include "mongo/db/storage/in_memory_files.h"
 
 
 namespace mongo {
 
+    NamespaceIndex::~NamespaceIndex() {
+        if ( _memory )
+            InMemoryFiles::release( _memory );
+    }
+
     NamespaceDetails* NamespaceIndex::details(const StringData& ns) {
         Namespace n(ns);
         return details(n);
@@ -86,6 +92,8 @@ namespace mongo {
     }
 
     bool NamespaceIndex::exists() const {
+        if ( _inMemory )
+            return _memory == 0;
         return !boost::filesystem::exists(path());
     }
 
@@ -140,7 +148,13 @@ namespace mongo {
         boost::filesystem::path nsPath = path();
         string pathString = nsPath.string();
         void *p = 0;
-        if ( boost::filesystem::exists(nsPath) ) {
+        if ( _inMemory ) {
+            len = storageGlobalParams.lenForNewNsFiles;
+            _memory = InMemoryFiles::allocate( len );
+            _memoryLength = len;
+            p = _memory;
+        }
+        else if ( boost::filesystem::exists(nsPath) ) {
             if( _f.open(pathString, true) ) {
                 len = _f.length();
                 if ( len % (1024*1024) != 0 ) {
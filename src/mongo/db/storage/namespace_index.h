@@ -46,8 +46,11 @@ namespace mongo {
     */
     class NamespaceIndex {
     public:
-        NamespaceIndex(const std::string &dir, const std::string &database) :
-            _ht( 0 ), _dir( dir ), _database( database ) {}
+        /** @param inMemory - keep the index in memory only, as an in memory database does */
+        NamespaceIndex(const std::string &dir, const std::string &database, bool inMemory = false) :
+            _ht( 0 ), _dir( dir ), _database( database ),
+            _inMemory( inMemory ), _memory( 0 ), _memoryLength( 0 ) {}
+        ~NamespaceIndex();
 
         /* returns true if new db will be created if we init lazily */
         bool exists() const;
@@ -72,7 +75,7 @@ namespace mongo {
 
         boost::filesystem::path path() const;
 
-        unsigned long long fileLength() const { return _f.length(); }
+        unsigned long long fileLength() const { return _inMemory ? _memoryLength : _f.length(); }
 
     private:
         void _init();
@@ -82,6 +85,9 @@ namespace mongo {
         HashTable<Namespace,NamespaceDetails> *_ht;
         std::string _dir;
         std::string _database;
+        bool _inMemory;
+        void* _memory; // stands in for the file when _inMemory
+        unsigned long long _memoryLength;
     };
 
 }
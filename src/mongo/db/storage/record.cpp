@@ -38,6 +38,9 @@
 #include "mongo/db/database_holder.h"
 #include "mongo/db/pagefault.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/db/stats/residency.h"
+#include "mongo/db/storage/data_file.h"
+#include "mongo/db/storage/extent.h"
 #include "mongo/platform/bits.h"
 #include "mongo/platform/unordered_set.h"
 #include "mongo/util/net/listen.h"
@@ -529,6 +532,30 @@ namespace mongo {
         return r;
     }
 
+    namespace {
+        /**
+         * The namespace of the extent at 'extentOfs' in the file of 'db' holding 'data', or ""
+         * if 'data' isn't in a file of 'db'.  This is the extent's nsDiagnostic, so a collection
+         * renamed since the extent was allocated shows up under its old name.
+         */
+        string extentNamespace( Database* db, const char* data, int extentOfs ) {
+            for ( int n = 0; n < db->numFiles(); n++ ) {
+                DataFile* f = db->getFile( n );
+                if ( ! f )
+                    continue;
+                // the header is at the start of the mapped file
+                const char* base = reinterpret_cast<const char*>( f->getHeader() );
+                if ( data < base || data >= base + f->length() )
+                    continue;
+                if ( extentOfs <= 0 || static_cast<unsigned long long>( extentOfs ) >= f->length() )
+                    return "";
+                const Extent* e = reinterpret_cast<const Extent*>( base + extentOfs );
+                return e->isOk() ? e->nsDiagnostic.toString() : "";
+            }
+            return "";
+        }
+    }
+
     void Record::_accessing() const {
         if ( likelyInPhysicalMemory() )
             return;
@@ -539,19 +566,23 @@ namespace mongo {
         recordStats.accessesNotInMemory.fetchAndAdd(1);
         if ( db )
             db->recordStats().accessesNotInMemory.fetchAndAdd(1);
+
+        const string ns = db ? extentNamespace( db, _data, _extentOfs ) : "";
         
-        if ( ! client.allowedToThrowPageFaultException() )
-            return;
-        
-        if ( client.curop() && client.curop()->elapsedMillis() > 50 ) {
-            // this means we've been going too long to restart
+        if ( ! client.allowedToThrowPageFaultException() ||
+             ( client.curop() && client.curop()->elapsedMillis() > 50 ) ) {
+            // in the second case we've been going too long to restart
             // we should track how often this happens
+            if ( ! ns.empty() )
+                ResidencyTracker::global.recordNotInMemory( ns, false );
             return;
         }
 
         recordStats.pageFaultExceptionsThrown.fetchAndAdd(1);
         if ( db )
             db->recordStats().pageFaultExceptionsThrown.fetchAndAdd(1);
+        if ( ! ns.empty() )
+            ResidencyTracker::global.recordNotInMemory( ns, true );
 
         DEV fassert( 16236 , ! inConstructorChain(true) );
         throw PageFaultException(this);
@@ -30,6 +30,9 @@
 
 #include "mongo/bson/util/builder.h"
 #include "mongo/db/server_parameters.h"
+#include "mongo/util/alignedbuilder.h"
+#include "mongo/util/logfile.h"
+#include "mongo/util/numa.h"
 
 namespace mongo {
 
@@ -59,4 +62,45 @@ namespace mongo {
                                                      true,
                                                      true);
 
+    namespace {
+        std::string dataFileNumaPolicy = "default";
+
+        /** applies the policy as it's set, before any threads that would inherit it are started */
+        class DataFileNumaPolicySetting : public ExportedServerParameter<std::string> {
+        public:
+            DataFileNumaPolicySetting() :
+                ExportedServerParameter<std::string>(ServerParameterSet::getGlobal(),
+                                                     "dataFileNumaPolicy",
+                                                     &dataFileNumaPolicy,
+                                                     true,
+                                                     false) {
+            }
+
+            virtual Status set(const std::string& newValue) {
+                Status status = setProcessNumaPolicy(newValue);
+                if (!status.isOK())
+                    return status;
+                return ExportedServerParameter<std::string>::set(newValue);
+            }
+        } dataFileNumaPolicySetting;
+    }
+
+    ExportedServerParameter<bool> JournalBuffersNodeLocalSetting(ServerParameterSet::getGlobal(),
+                                                                 "journalBuffersNodeLocal",
+                                                                 &AlignedBuilder::nodeLocal,
+                                                                 true,
+                                                                 false);
+
+    ExportedServerParameter<bool> JournalBuffersHugePagesSetting(ServerParameterSet::getGlobal(),
+                                                                 "journalBuffersHugePages",
+                                                                 &AlignedBuilder::hugePages,
+                                                                 true,
+                                                                 false);
+
+    ExportedServerParameter<bool> JournalAsyncAppendsSetting(ServerParameterSet::getGlobal(),
+                                                             "journalAsyncAppends",
+                                                             &LogFile::asyncAppends,
+                                                             true,
+                                                             false);
+
 } // namespace mongo
@@ -36,6 +36,7 @@
 #include "mongo/db/storage/extent.h"
 #include "mongo/db/storage/extent_manager.h"
 #include "mongo/db/structure/collection_iterator.h"
+#include "mongo/util/md5.hpp"
 
 #include "mongo/db/pdfile.h" // XXX-ERH
 
@@ -47,7 +48,10 @@ namespace mongo {
         : _ns( fullNS ),
           _recordStore( _ns.ns() ),
           _infoCache( this ),
-          _indexCatalog( this, details ) {
+          _indexCatalog( this, details ),
+          _contentHashKnown( false ),
+          _contentHash( 0 ),
+          _contentHashCount( 0 ) {
         _details = details;
         _database = database;
         _recordStore.init( _details,
@@ -69,14 +73,31 @@ namespace mongo {
         return new FlatIterator( this, start, dir );
     }
 
+    CollectionIterator* Collection::getExtentRangeIterator( const DiskLoc& firstExtent,
+                                                            const DiskLoc& lastExtent ) const {
+        verify( ok() );
+        verify( !_details->isCapped() );
+        return new FlatIterator( this, firstExtent, lastExtent );
+    }
+
     BSONObj Collection::docFor( const DiskLoc& loc ) {
         Record* rec = getExtentManager()->recordFor( loc );
         return BSONObj::make( rec->accessed() );
     }
 
     StatusWith<DiskLoc> Collection::insertDocument( const BSONObj& docToInsert, bool enforceQuota ) {
-        int lenWHdr = _details->getRecordAllocationSize( docToInsert.objsize() + Record::HeaderSize );
-        fassert( 17208, lenWHdr >= ( docToInsert.objsize() + Record::HeaderSize ) );
+        std::string compressed;
+        const char* stored = docToInsert.objdata();
+        int storedSize = docToInsert.objsize();
+        if ( _details->isUserFlagSet( NamespaceDetails::Flag_CompressRecords ) &&
+             compressRecordData( docToInsert, &compressed ) ) {
+            stored = compressed.data();
+            storedSize = compressed.size();
+        }
+
+        int lenWHdr = _details->getRecordAllocationSize( storedSize + recordChecksumRoom( _details ) +
+                                                         Record::HeaderSize );
+        fassert( 17208, lenWHdr >= ( storedSize + Record::HeaderSize ) );
 
         if ( _details->isCapped() ) {
             // TOOD: old god not done
@@ -97,12 +118,16 @@ namespace mongo {
 
         // copy the data
         r = reinterpret_cast<Record*>( getDur().writingPtr(r, lenWHdr) );
-        memcpy( r->data(), docToInsert.objdata(), docToInsert.objsize() );
+        memcpy( r->data(), stored, storedSize );
+        updateRecordChecksum( _details, r );
 
         addRecordToRecListInExtent(r, loc.getValue()); // XXX move down into record store
 
         _details->incrementStats( r->netLength(), 1 );
 
+        // before the indexing, as a failure there deletes the document again
+        documentAdded( docToInsert );
+
         // TOOD: old god not done
         _infoCache.notifyOfWriteOp();
 
@@ -153,11 +178,43 @@ namespace mongo {
 
         _indexCatalog.unindexRecord( doc, loc, noWarn);
 
+        documentRemoved( doc );
+
         _recordStore.deallocRecord( loc, rec );
 
         _infoCache.notifyOfWriteOp();
     }
 
+    StatusWith<DiskLoc> Collection::moveDocument( const DiskLoc& loc ) {
+        verify( !_details->isCapped() );
+
+        BSONObj doc = docFor( loc );
+
+        /* check if any cursors point to us.  if so, advance them. */
+        ClientCursor::aboutToDelete(_ns.ns(), _details, loc);
+
+        // unique indexes would reject the copy while the original is indexed.
+        _indexCatalog.unindexRecord( doc, loc, true );
+
+        StatusWith<DiskLoc> newLoc( ErrorCodes::InternalError, "document wasn't moved" );
+        try {
+            newLoc = insertDocument( doc, false );
+        }
+        catch ( AssertionException& ) {
+            _indexCatalog.indexRecord( doc, loc );
+            throw;
+        }
+
+        if ( !newLoc.isOK() ) {
+            _indexCatalog.indexRecord( doc, loc );
+            return newLoc;
+        }
+
+        _recordStore.deallocRecord( loc, getExtentManager()->recordFor( loc ) );
+        // insertDocument added the copy; the original is gone without a deleteDocument
+        documentRemoved( doc );
+        return newLoc;
+    }
 
     ExtentManager* Collection::getExtentManager() {
         verify( ok() );
@@ -193,4 +250,45 @@ namespace mongo {
         return _details->numRecords();
     }
 
+    uint64_t Collection::documentHash( const BSONObj& doc ) {
+        md5_state_t st;
+        md5_init( &st );
+        md5_append( &st, reinterpret_cast<const md5_byte_t*>( doc.objdata() ), doc.objsize() );
+        md5digest d;
+        md5_finish( &st, d );
+        uint64_t h;
+        memcpy( &h, d, sizeof(h) );
+        return h;
+    }
+
+    bool Collection::getContentHash( uint64_t* hash, long long* count ) const {
+        if ( !_contentHashKnown || _details->isCapped() )
+            return false;
+        *hash = _contentHash;
+        *count = _contentHashCount;
+        return true;
+    }
+
+    void Collection::setContentHash( uint64_t hash, long long count ) {
+        if ( _details->isCapped() )
+            return;
+        _contentHash = hash;
+        _contentHashCount = count;
+        _contentHashKnown = true;
+    }
+
+    void Collection::documentAdded( const BSONObj& doc ) {
+        if ( !_contentHashKnown )
+            return;
+        _contentHash += documentHash( doc );
+        _contentHashCount++;
+    }
+
+    void Collection::documentRemoved( const BSONObj& doc ) {
+        if ( !_contentHashKnown )
+            return;
+        _contentHash -= documentHash( doc );
+        _contentHashCount--;
+    }
+
 }
@@ -82,6 +82,13 @@ namespace mongo {
         CollectionIterator* getIterator( const DiskLoc& start, bool tailable,
                                          const CollectionScanParams::Direction& dir) const;
 
+        /**
+         * Iterates forward over the records in the extents from 'firstExtent' through
+         * 'lastExtent'.  The collection must not be capped.
+         */
+        CollectionIterator* getExtentRangeIterator( const DiskLoc& firstExtent,
+                                                    const DiskLoc& lastExtent ) const;
+
         void deleteDocument( const DiskLoc& loc,
                              bool cappedOK = false,
                              bool noWarn = false,
@@ -89,6 +96,14 @@ namespace mongo {
 
         StatusWith<DiskLoc> insertDocument( const BSONObj& doc, bool enforceQuota );
 
+        /**
+         * Copies the document at 'loc' into a newly allocated record, moves its index entries
+         * over, and frees the old record.  Cursors on 'loc' are advanced as for a delete.  If the
+         * copy can't be made the document is left where it was.
+         * @return the document's new location
+         */
+        StatusWith<DiskLoc> moveDocument( const DiskLoc& loc );
+
         // this is temporary, moving up from DB for now
         // this will add a new extent the collection
         // the new extent will be returned
@@ -101,6 +116,23 @@ namespace mongo {
 
         uint64_t numRecords() const;
 
+        //
+        // Content hash: an order-independent hash of the documents, the sum of a 64 bit hash
+        // of each, so that writes can keep it current without a rescan once it's been
+        // computed.  Capped collections don't keep one.
+        //
+
+        static uint64_t documentHash( const BSONObj& doc );
+
+        /** @return false if the hash isn't known, and has to be computed by a scan */
+        bool getContentHash( uint64_t* hash, long long* count ) const;
+        void setContentHash( uint64_t hash, long long count );
+        void invalidateContentHash() { _contentHashKnown = false; }
+
+        /** for writers to keep the content hash current; no-ops while it isn't known */
+        void documentAdded( const BSONObj& doc );
+        void documentRemoved( const BSONObj& doc );
+
     private:
 
         // @return 0 for inf., otherwise a number of files
@@ -118,6 +150,10 @@ namespace mongo {
         CollectionInfoCache _infoCache;
         IndexCatalog _indexCatalog;
 
+        bool _contentHashKnown;
+        uint64_t _contentHash;
+        long long _contentHashCount;
+
         friend class Database;
         friend class FlatIterator;
         friend class CappedIterator;
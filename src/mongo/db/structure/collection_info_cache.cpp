@@ -30,9 +30,12 @@
 
 #include "mongo/db/structure/collection_info_cache.h"
 
+#include "mongo/db/client.h"
 #include "mongo/db/d_concurrency.h"
+#include "mongo/db/database.h"
 #include "mongo/db/namespace_details.h"
 #include "mongo/db/namespace_details-inl.h"
+#include "mongo/db/query/plan_cache.h"
 #include "mongo/db/structure/collection.h"
 #include "mongo/util/debug_util.h"
 
@@ -41,16 +44,43 @@
 
 namespace mongo {
 
+    namespace {
+        // A partial index's filter decides whether a document has keys at all, so an update to
+        // one of its fields changes the index as surely as one to a key field.
+        void addFilterPaths( const BSONObj& filter, IndexPathSet* paths ) {
+            BSONObjIterator i( filter );
+            while ( i.more() ) {
+                BSONElement e = i.next();
+                if ( e.fieldName()[0] != '$' ) {
+                    paths->addPath( e.fieldName() );
+                    continue;
+                }
+                if ( e.type() != Array )
+                    continue;
+                BSONObjIterator j( e.Obj() );
+                while ( j.more() ) {
+                    BSONElement clause = j.next();
+                    if ( clause.isABSONObj() )
+                        addFilterPaths( clause.Obj(), paths );
+                }
+            }
+        }
+    }
+
     CollectionInfoCache::CollectionInfoCache( Collection* collection )
         : _collection( collection ),
           _keysComputed( false ),
           _qcCacheMutex( "_qcCacheMutex" ),
-          _qcWriteCount( 0 ) {}
+          _qcWriteCount( 0 ),
+          _planCache( new PlanCache() ) {}
+
+    CollectionInfoCache::~CollectionInfoCache() {}
 
     void CollectionInfoCache::reset() {
         Lock::assertWriteLocked( _collection->ns().ns() );
         clearQueryCache();
         _keysComputed = false;
+        _idLookupCache.clear();
     }
 
     void CollectionInfoCache::computeIndexKeys() {
@@ -60,12 +90,15 @@ namespace mongo {
 
         NamespaceDetails::IndexIterator i = _collection->details()->ii( true );
         while( i.more() ) {
-            BSONObj key = i.next().keyPattern();
+            IndexDetails& id = i.next();
+            BSONObj key = id.keyPattern();
             BSONObjIterator j( key );
             while ( j.more() ) {
                 BSONElement e = j.next();
                 _indexedPaths.addPath( e.fieldName() );
             }
+            addFilterPaths( id.info.obj().getObjectField( "partialFilterExpression" ),
+                            &_indexedPaths );
         }
 
         _keysComputed = true;
@@ -73,6 +106,8 @@ namespace mongo {
     }
 
     void CollectionInfoCache::notifyOfWriteOp() {
+        _planCache->notifyOfWriteOp();
+
         scoped_lock lk( _qcCacheMutex );
         if ( _qcCache.empty() )
             return;
@@ -81,6 +116,8 @@ namespace mongo {
     }
 
     void CollectionInfoCache::clearQueryCache() {
+        _planCache->clear();
+
         scoped_lock lk( _qcCacheMutex );
         _clearQueryCache_inlock();
     }
@@ -102,4 +139,15 @@ namespace mongo {
         _qcCache[ pattern ] = cachedQueryPlan;
     }
 
+    // static
+    PlanCache* PlanCache::get( const string& ns ) {
+        Database* db = cc().database();
+        if ( !db || db->name() != nsToDatabaseSubstring( ns ) )
+            return NULL;
+        Collection* collection = db->getCollection( ns );
+        if ( !collection )
+            return NULL;
+        return collection->infoCache()->getPlanCache();
+    }
+
 }
@@ -30,13 +30,17 @@
 
 #pragma once
 
+#include <boost/scoped_ptr.hpp>
+
 #include "mongo/db/index_set.h"
 #include "mongo/db/querypattern.h"
+#include "mongo/db/structure/id_lookup_cache.h"
 
 
 namespace mongo {
 
     class Collection;
+    class PlanCache;
 
     /**
      * this is for storing things that you want to cache about a single collection
@@ -46,6 +50,7 @@ namespace mongo {
     public:
 
         CollectionInfoCache( Collection* collection );
+        ~CollectionInfoCache();
 
         /*
          * resets entire cache state
@@ -72,6 +77,12 @@ namespace mongo {
         /* you must notify the cache if you are doing writes, as query plan utility will change */
         void notifyOfWriteOp();
 
+        /* the cache of winning plans for the new query framework.  see query/plan_cache.h */
+        PlanCache* getPlanCache() { return _planCache.get(); }
+
+        /* where documents are by _id, for collections with Flag_IdLookupCache set */
+        IdLookupCache* idLookupCache() { return &_idLookupCache; }
+
         CachedQueryPlan cachedQueryPlanForPattern( const QueryPattern &pattern );
 
         void registerCachedQueryPlanForPattern( const QueryPattern &pattern,
@@ -95,6 +106,14 @@ namespace mongo {
         int _qcWriteCount;
         std::map<QueryPattern,CachedQueryPlan> _qcCache;
 
+        // --- for new query framework
+
+        boost::scoped_ptr<PlanCache> _planCache;
+
+        // --- for _id point lookups
+
+        IdLookupCache _idLookupCache;
+
     };
 
 }
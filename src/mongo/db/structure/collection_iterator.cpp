@@ -83,6 +83,26 @@ namespace mongo {
         }
     }
 
+    FlatIterator::FlatIterator(const Collection* collection,
+                               const DiskLoc& firstExtent,
+                               const DiskLoc& lastExtent)
+        : _collection(collection), _direction(CollectionScanParams::FORWARD),
+          _lastExtent(lastExtent) {
+
+        verify( !firstExtent.isNull() && !lastExtent.isNull() );
+
+        // Find a non-empty extent in the range and start with the first record in it.
+        const ExtentManager* em = _collection->getExtentManager();
+        Extent* e = em->getExtent( firstExtent );
+
+        while (e->firstRecord.isNull() && e->myLoc != _lastExtent && !e->xnext.isNull()) {
+            e = em->getNextExtent( e );
+        }
+
+        // _curr may be set to DiskLoc() here if every extent in the range is empty.
+        _curr = e->firstRecord;
+    }
+
     bool FlatIterator::isEOF() {
         return _curr.isNull();
     }
@@ -92,7 +112,20 @@ namespace mongo {
 
         // Move to the next thing.
         if (!isEOF()) {
-            if (CollectionScanParams::FORWARD == _direction) {
+            if (!_lastExtent.isNull()) {
+                // Stay within our range of extents, skipping empty ones.
+                const ExtentManager* em = _collection->getExtentManager();
+                DiskLoc next = em->getNextRecordInExtent( _curr );
+                if (next.isNull()) {
+                    Extent* e = em->extentFor( _curr );
+                    while (next.isNull() && e->myLoc != _lastExtent && !e->xnext.isNull()) {
+                        e = em->getNextExtent( e );
+                        next = e->firstRecord;
+                    }
+                }
+                _curr = next;
+            }
+            else if (CollectionScanParams::FORWARD == _direction) {
                 _curr = _collection->getExtentManager()->getNextRecord( _curr );
             }
             else {
@@ -67,11 +67,17 @@ namespace mongo {
      * The collection must exist when the constructor is called.
      *
      * If start is not DiskLoc(), the iteration begins at that DiskLoc.
+     *
+     * Alternatively, the iteration can be bounded to a range of the collection's extents.  It
+     * then goes forward from the first record of 'firstExtent' through the last record of
+     * 'lastExtent'.
      */
     class FlatIterator : public CollectionIterator {
     public:
         FlatIterator(const Collection* collection, const DiskLoc& start,
                      const CollectionScanParams::Direction& dir);
+        FlatIterator(const Collection* collection, const DiskLoc& firstExtent,
+                     const DiskLoc& lastExtent);
         virtual ~FlatIterator() { }
 
         virtual bool isEOF();
@@ -88,6 +94,9 @@ namespace mongo {
         const Collection* _collection;
 
         CollectionScanParams::Direction _direction;
+
+        // If not null, we stop after the last record in this extent.
+        DiskLoc _lastExtent;
     };
 
     /**
@@ -0,0 +1,156 @@
+// id_lookup_cache.cpp
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/db/structure/id_lookup_cache.h"
+
+#include "mongo/db/hasher.h"
+#include "mongo/db/server_parameters.h"
+
+namespace mongo {
+
+    // Per collection.
+    MONGO_EXPORT_SERVER_PARAMETER(idLookupCacheSizeMB, int, 16);
+
+    namespace {
+        long long hashId(const BSONElement& id) {
+            return BSONElementHasher::hash64(id, BSONElementHasher::DEFAULT_HASH_SEED);
+        }
+    }
+
+    IdLookupCache::IdLookupCache()
+        : _mutex("IdLookupCache"),
+          _hand(0),
+          _bytes(0) {
+    }
+
+    bool IdLookupCache::find(const BSONElement& id, DiskLoc* loc) {
+        long long hash = hashId(id);
+        SimpleMutex::scoped_lock lk(_mutex);
+        Slots::const_iterator i = _slots.find(hash);
+        if (i == _slots.end())
+            return false;
+        Entry& e = _entries[i->second];
+        if (e.id.firstElement().woCompare(id, false) != 0)
+            return false;
+        e.referenced = true;
+        *loc = e.loc;
+        return true;
+    }
+
+    void IdLookupCache::add(const BSONElement& id, const DiskLoc& loc) {
+        long long hash = hashId(id);
+        BSONObj owned = id.wrap("");
+        size_t bytes = _entryBytes(owned);
+        if (static_cast<long long>(bytes) > idLookupCacheSizeMB * 1024LL * 1024)
+            return;
+
+        SimpleMutex::scoped_lock lk(_mutex);
+        Slots::iterator i = _slots.find(hash);
+        if (i != _slots.end())
+            _free(i->second);
+
+        size_t slot = _claimSlot(bytes);
+        Entry& e = _entries[slot];
+        e.id = owned;
+        e.loc = loc;
+        e.hash = hash;
+        e.referenced = false;
+        _slots[hash] = slot;
+        _bytes += bytes;
+    }
+
+    void IdLookupCache::invalidate(const BSONElement& id) {
+        if (id.eoo())
+            return;
+        SimpleMutex::scoped_lock lk(_mutex);
+        if (_slots.empty())
+            return;
+        Slots::iterator i = _slots.find(hashId(id));
+        if (i != _slots.end())
+            _free(i->second);
+    }
+
+    void IdLookupCache::clear() {
+        SimpleMutex::scoped_lock lk(_mutex);
+        _entries.clear();
+        _freeSlots.clear();
+        _slots.clear();
+        _hand = 0;
+        _bytes = 0;
+    }
+
+    size_t IdLookupCache::sizeBytes() const {
+        SimpleMutex::scoped_lock lk(_mutex);
+        return _bytes;
+    }
+
+    void IdLookupCache::_free(size_t i) {
+        Entry& e = _entries[i];
+        dassert(!e.id.isEmpty());
+        _slots.erase(e.hash);
+        _bytes -= _entryBytes(e.id);
+        e.id = BSONObj();
+        e.loc = DiskLoc();
+        _freeSlots.push_back(i);
+    }
+
+    size_t IdLookupCache::_claimSlot(size_t bytesNeeded) {
+        const size_t budget = static_cast<size_t>(idLookupCacheSizeMB) * 1024 * 1024;
+
+        // Sweep the clock, giving each referenced entry a second chance, until there's room.
+        while (_bytes + bytesNeeded > budget && _slots.size() > 0) {
+            if (_hand >= _entries.size())
+                _hand = 0;
+            Entry& e = _entries[_hand];
+            if (!e.id.isEmpty()) {
+                if (e.referenced)
+                    e.referenced = false;
+                else
+                    _free(_hand);
+            }
+            ++_hand;
+        }
+
+        if (!_freeSlots.empty()) {
+            size_t slot = _freeSlots.back();
+            _freeSlots.pop_back();
+            return slot;
+        }
+        _entries.push_back(Entry());
+        return _entries.size() - 1;
+    }
+
+    // static
+    size_t IdLookupCache::_entryBytes(const BSONObj& id) {
+        // the entry, its slot in the hash table and the owned _id
+        return sizeof(Entry) + 4 * sizeof(void*) + id.objsize();
+    }
+
+}  // namespace mongo
@@ -0,0 +1,98 @@
+// id_lookup_cache.h
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include <boost/noncopyable.hpp>
+#include <vector>
+
+#include "mongo/db/diskloc.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/unordered_map.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    /**
+     * An in-memory map from _id to DiskLoc for a collection's point lookups, so a hit skips the
+     * descent of the _id btree.  Used for collections with Flag_IdLookupCache set.
+     *
+     * Entries are added as lookups find documents and must be invalidated whenever the document
+     * with an _id is inserted, deleted or moved; IndexCatalog does that as it indexes and unindexes
+     * records.  The cache is kept within idLookupCacheSizeMB by second chance (clock) eviction.
+     *
+     * Lookups run under a read lock, possibly many at once, so the cache has a mutex of its own.
+     */
+    class IdLookupCache : boost::noncopyable {
+    public:
+        IdLookupCache();
+
+        /** @return true, setting *loc, if the document with _id 'id' is cached. */
+        bool find(const BSONElement& id, DiskLoc* loc);
+
+        /** Notes that the document with _id 'id' is at 'loc'. */
+        void add(const BSONElement& id, const DiskLoc& loc);
+
+        /** Forgets where the document with _id 'id' is, if the cache knows. */
+        void invalidate(const BSONElement& id);
+
+        void clear();
+
+        /** @return an estimate of the memory used by the cached entries. */
+        size_t sizeBytes() const;
+
+    private:
+        struct Entry {
+            BSONObj id;            // owned, with an empty field name; empty if the slot is free
+            DiskLoc loc;
+            long long hash;
+            bool referenced;
+        };
+
+        // Keyed by the hash of the _id alone.  Two _ids with the same hash can't both be cached.
+        typedef unordered_map<long long, size_t> Slots;
+
+        /** Frees slot 'i' for reuse.  Caller holds _mutex. */
+        void _free(size_t i);
+
+        /** @return a slot to fill, evicting entries while the cache is over budget. */
+        size_t _claimSlot(size_t bytesNeeded);
+
+        static size_t _entryBytes(const BSONObj& id);
+
+        mutable SimpleMutex _mutex;
+        std::vector<Entry> _entries;
+        std::vector<size_t> _freeSlots;
+        Slots _slots;
+        size_t _hand;
+        size_t _bytes;
+    };
+
+}  // namespace mongo
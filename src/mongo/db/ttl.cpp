@@ -49,100 +49,243 @@ namespace mongo {
 
     Counter64 ttlPasses;
     Counter64 ttlDeletedDocuments;
+    Counter64 ttlDeleteBatches;
 
     ServerStatusMetricField<Counter64> ttlPassesDisplay("ttl.passes", &ttlPasses);
     ServerStatusMetricField<Counter64> ttlDeletedDocumentsDisplay("ttl.deletedDocuments", &ttlDeletedDocuments);
+    ServerStatusMetricField<Counter64> ttlDeleteBatchesDisplay("ttl.deleteBatches", &ttlDeleteBatches);
 
     MONGO_EXPORT_SERVER_PARAMETER( ttlMonitorEnabled, bool, true );
-    
+
+    // how often every database is checked for expired documents
+    MONGO_EXPORT_SERVER_PARAMETER( ttlMonitorSleepSecs, int, 10 );
+
+    // documents deleted under one hold of the write lock
+    MONGO_EXPORT_SERVER_PARAMETER( ttlDeleteBatchSize, int, 500 );
+
+    // time an index may spend deleting before the next gets a turn; what's left of its
+    // backlog is taken up again a second later rather than at the next check
+    MONGO_EXPORT_SERVER_PARAMETER( ttlMaxMillisPerIndex, int, 1000 );
+
     class TTLMonitor : public BackgroundJob {
     public:
-        TTLMonitor(){}
+        TTLMonitor() : _mutex( "TTLMonitor" ) , _nextCheck( 0 ) {}
         virtual ~TTLMonitor(){}
 
         virtual string name() const { return "TTLMonitor"; }
         
         static string secondsExpireField;
-        
-        void doTTLForDB( const string& dbName ) {
 
-            bool isMaster = isMasterNs( dbName.c_str() );
-            vector<BSONObj> indexes;
+        /** what each ttl index was last doing, for serverStatus */
+        void appendStats( BSONObjBuilder& b ) {
+            scoped_lock lk( _mutex );
+            long long backlog = 0;
+            BSONArrayBuilder indexes( b.subarrayStart( "indexes" ) );
+            for ( map<string,IndexState>::const_iterator i = _indexes.begin(); i != _indexes.end(); ++i ) {
+                const IndexState& state = i->second;
+                BSONObjBuilder idx( indexes.subobjStart() );
+                idx.append( "ns" , state.spec["ns"].str() );
+                idx.append( "name" , state.spec["name"].str() );
+                idx.append( "backlog" , state.backlog );
+                idx.append( "lastPassDeleted" , state.lastPassDeleted );
+                idx.append( "lastPassMillis" , state.lastPassMillis );
+                idx.append( "deletesPerSec" , state.lastPassMillis ?
+                            state.lastPassDeleted * 1000 / state.lastPassMillis : 0 );
+                idx.done();
+                backlog += state.backlog;
+            }
+            indexes.done();
+            b.append( "backlog" , backlog );
+        }
+
+    private:
+        struct IndexState {
+            IndexState() : due( 0 ) , backlog( 0 ) , lastPassDeleted( 0 ) , lastPassMillis( 0 ) {}
+            BSONObj spec;
+            long long due; // millis
+            long long backlog; // expired documents its last pass left, estimated
+            long long lastPassDeleted;
+            long long lastPassMillis;
+        };
+
+        /** highest backlog first */
+        static bool moreBacklog( const pair<long long,string>& a, const pair<long long,string>& b ) {
+            return a.first > b.first;
+        }
+
+        /** finds the ttl indexes of every database, all of which are then due */
+        void checkIndexes() {
+            set<string> dbs;
             {
-                auto_ptr<DBClientCursor> cursor =
+                Lock::DBRead lk( "local" );
+                dbHolder().getAllShortNames( dbs );
+            }
+
+            map<string,BSONObj> found;
+            for ( set<string>::const_iterator i=dbs.begin(); i!=dbs.end(); ++i ) {
+                string dbName = *i;
+                try {
+                    auto_ptr<DBClientCursor> cursor =
                                 db.query( dbName + ".system.indexes" ,
                                           BSON( secondsExpireField << BSON( "$exists" << true ) ) ,
                                           0 , /* default nToReturn */
                                           0 , /* default nToSkip */
                                           0 , /* default fieldsToReturn */
                                           QueryOption_SlaveOk ); /* perform on secondaries too */
-                if ( cursor.get() ) {
-                    while ( cursor->more() ) {
-                        indexes.push_back( cursor->next().getOwned() );
+                    if ( cursor.get() ) {
+                        while ( cursor->more() ) {
+                            BSONObj idx = cursor->next().getOwned();
+                            found[ idx["ns"].str() + ".$" + idx["name"].str() ] = idx;
+                        }
                     }
                 }
+                catch ( DBException& e ) {
+                    error() << "error processing ttl for db: " << dbName << " " << e << endl;
+                }
             }
-            
-            for ( unsigned i=0; i<indexes.size(); i++ ) {
-                BSONObj idx = indexes[i];
-                
 
-                BSONObj key = idx["key"].Obj();
-                if ( key.nFields() != 1 ) {
-                    error() << "key for ttl index can only have 1 field" << endl;
-                    continue;
+            scoped_lock lk( _mutex );
+            for ( map<string,IndexState>::iterator i = _indexes.begin(); i != _indexes.end(); ) {
+                if ( found.count( i->first ) )
+                    ++i;
+                else
+                    _indexes.erase( i++ );
+            }
+            for ( map<string,BSONObj>::const_iterator i = found.begin(); i != found.end(); ++i ) {
+                IndexState& state = _indexes[ i->first ];
+                state.spec = i->second;
+                state.due = 0;
+            }
+        }
+
+        void doTTLForIndex( const string& indexNs, const BSONObj& idx ) {
+            long long start = curTimeMillis64();
+            long long n = 0;
+            long long backlog = 0;
+            bool caughtUp = deleteExpired( idx , &n , &backlog );
+
+            LOG(1) << "\tTTL deleted: " << n << endl;
+
+            scoped_lock lk( _mutex );
+            map<string,IndexState>::iterator i = _indexes.find( indexNs );
+            if ( i == _indexes.end() )
+                return;
+            IndexState& state = i->second;
+            long long now = curTimeMillis64();
+            state.backlog = backlog;
+            state.lastPassDeleted = n;
+            state.lastPassMillis = now - start;
+            // an index that's behind goes again at the next second, ahead of the rest
+            state.due = caughtUp ? _nextCheck : now;
+        }
+
+        /**
+         * Deletes the index's expired documents a batch at a time, letting go of the write
+         * lock after each, until there are none or the index has had its turn.
+         * @return false if it ran out of time, with *backlog what's left
+         */
+        bool deleteExpired( const BSONObj& idx, long long* n, long long* backlog ) {
+            long long start = curTimeMillis64();
+
+            BSONObj key = idx["key"].Obj();
+            if ( key.nFields() != 1 ) {
+                error() << "key for ttl index can only have 1 field" << endl;
+                return true;
+            }
+            if (!idx[secondsExpireField].isNumber()) {
+                log() << "ttl indexes require the " << secondsExpireField << " field to be "
+                      << "numeric but received a type of: "
+                      << typeName(idx[secondsExpireField].type());
+                return true;
+            }
+
+            string ns = idx["ns"].String();
+            const char* field = key.firstElement().fieldName();
+
+            BSONObj query;
+            {
+                BSONObjBuilder b;
+                b.appendDate( "$lt" , curTimeMillis64() - ( 1000 * idx[secondsExpireField].numberLong() ) );
+                query = BSON( field << b.obj() );
+            }
+
+            LOG(1) << "TTL: " << key << " \t " << query << endl;
+
+            {
+                Client::WriteContext ctx( ns );
+                NamespaceDetails* nsd = nsdetails( ns );
+                if ( ! nsd ) {
+                    // collection was dropped
+                    return true;
                 }
-                if (!idx[secondsExpireField].isNumber()) {
-                    log() << "ttl indexes require the " << secondsExpireField << " field to be "
-                          << "numeric but received a type of: "
-                          << typeName(idx[secondsExpireField].type());
-                    continue;
+                if ( nsd->setUserFlag( NamespaceDetails::Flag_UsePowerOf2Sizes ) ) {
+                    nsd->syncUserFlags( ns );
                 }
+            }
+            // only do deletes if on master
+            if ( ! isMasterNs( ns.c_str() ) ) {
+                return true;
+            }
 
-                BSONObj query;
+            const int batchSize = ttlDeleteBatchSize > 0 ? ttlDeleteBatchSize : 1;
+            BSONObj idOnly = BSON( "_id" << 1 );
+            while ( ! inShutdown() ) {
+                // the expired _ids, walking the ttl index, then deleted by _id so the
+                // write lock is held only for the deletes themselves
+                BSONArrayBuilder ids;
+                int found = 0;
                 {
-                    BSONObjBuilder b;
-                    b.appendDate( "$lt" , curTimeMillis64() - ( 1000 * idx[secondsExpireField].numberLong() ) );
-                    query = BSON( key.firstElement().fieldName() << b.obj() );
+                    auto_ptr<DBClientCursor> cursor =
+                        db.query( ns , Query( query ).hint( key ) , -batchSize , 0 , &idOnly );
+                    if ( ! cursor.get() )
+                        break;
+                    while ( cursor->more() ) {
+                        BSONObj o = cursor->next();
+                        found++;
+                        if ( o.hasField( "_id" ) )
+                            ids.append( o["_id"] );
+                    }
                 }
-                
-                LOG(1) << "TTL: " << key << " \t " << query << endl;
-                
-                long long n = 0;
+                if ( ids.arrSize() == 0 )
+                    break;
+
+                BSONObjBuilder pattern;
+                pattern.append( "_id" , BSON( "$in" <<  ids.arr() ) );
+                pattern.appendElements( query );
+
+                long long deleted;
                 {
-                    string ns = idx["ns"].String();
                     Client::WriteContext ctx( ns );
-                    NamespaceDetails* nsd = nsdetails( ns );
-                    if ( ! nsd ) {
-                        // collection was dropped
-                        continue;
-                    }
-                    if ( nsd->setUserFlag( NamespaceDetails::Flag_UsePowerOf2Sizes ) ) {
-                        nsd->syncUserFlags( ns );
-                    }
-                    // only do deletes if on master
-                    if ( ! isMaster ) {
-                        continue;
-                    }
-
-                    n = deleteObjects( ns , query , false , true );
-                    ttlDeletedDocuments.increment( n );
+                    if ( ! nsdetails( ns ) || ! isMasterNs( ns.c_str() ) )
+                        break;
+                    deleted = deleteObjects( ns , pattern.obj() , false , true );
                 }
+                ttlDeletedDocuments.increment( deleted );
+                ttlDeleteBatches.increment();
+                *n += deleted;
+
+                if ( found < batchSize )
+                    break;
 
-                LOG(1) << "\tTTL deleted: " << n << endl;
+                if ( curTimeMillis64() - start >= ttlMaxMillisPerIndex ) {
+                    // a bounded count, so a huge backlog doesn't cost a long scan
+                    *backlog = db.count( ns , query , QueryOption_SlaveOk , 100 * batchSize );
+                    return false;
+                }
             }
-            
-            
+            return true;
         }
 
+    public:
         virtual void run() {
             Client::initThread( name().c_str() );
             cc().getAuthorizationSession()->grantInternalAuthorization();
+            Lock::setThreadPriority( Lock::priorityBackground );
 
             while ( ! inShutdown() ) {
-                sleepsecs( 60 );
+                sleepsecs( 1 );
                 
-                LOG(3) << "TTLMonitor thread awake" << endl;
+                LOG(5) << "TTLMonitor thread awake" << endl;
 
                 if ( !ttlMonitorEnabled ) {
                    LOG(1) << "TTLMonitor is disabled" << endl;
@@ -160,33 +303,75 @@ namespace mongo {
                 if ( theReplSet && !theReplSet->state().readable() )
                     continue;
 
-                set<string> dbs;
+                long long now = curTimeMillis64();
+                if ( now >= _nextCheck ) {
+                    _nextCheck = now + 1000LL * ttlMonitorSleepSecs;
+                    ttlPasses.increment();
+                    checkIndexes();
+                }
+
+                vector< pair<long long,string> > due; // backlog, index ns
                 {
-                    Lock::DBRead lk( "local" );
-                    dbHolder().getAllShortNames( dbs );
+                    scoped_lock lk( _mutex );
+                    for ( map<string,IndexState>::const_iterator i = _indexes.begin(); i != _indexes.end(); ++i ) {
+                        if ( i->second.due <= now )
+                            due.push_back( make_pair( i->second.backlog , i->first ) );
+                    }
                 }
-                
-                ttlPasses.increment();
+                std::stable_sort( due.begin() , due.end() , moreBacklog );
 
-                for ( set<string>::const_iterator i=dbs.begin(); i!=dbs.end(); ++i ) {
-                    string db = *i;
+                for ( unsigned i=0; i<due.size() && ! inShutdown(); i++ ) {
+                    const string& indexNs = due[i].second;
+                    BSONObj idx;
+                    {
+                        scoped_lock lk( _mutex );
+                        map<string,IndexState>::const_iterator it = _indexes.find( indexNs );
+                        if ( it == _indexes.end() )
+                            continue;
+                        idx = it->second.spec;
+                    }
                     try {
-                        doTTLForDB( db );
+                        doTTLForIndex( indexNs , idx );
                     }
                     catch ( DBException& e ) {
-                        error() << "error processing ttl for db: " << db << " " << e << endl;
+                        error() << "error processing ttl for index: " << indexNs << " " << e << endl;
+                        scoped_lock lk( _mutex );
+                        map<string,IndexState>::iterator it = _indexes.find( indexNs );
+                        if ( it != _indexes.end() )
+                            it->second.due = _nextCheck;
                     }
                 }
 
             }
         }
 
+    private:
         DBDirectClient db;
+
+        mongo::mutex _mutex; // guards _indexes, which serverStatus reads
+        map<string,IndexState> _indexes; // by index namespace
+        long long _nextCheck; // millis
     };
 
+    static TTLMonitor* ttlMonitor = 0;
+
+    class TTLServerStatusSection : public ServerStatusSection {
+    public:
+        TTLServerStatusSection() : ServerStatusSection( "ttl" ){}
+        virtual bool includeByDefault() const { return false; }
+
+        BSONObj generateSection( const BSONElement& configElement ) const {
+            BSONObjBuilder b;
+            if ( ttlMonitor )
+                ttlMonitor->appendStats( b );
+            return b.obj();
+        }
+
+    } ttlServerStatusSection;
+
     void startTTLBackgroundJob() {
-        TTLMonitor* ttl = new TTLMonitor();
-        ttl->go();
+        ttlMonitor = new TTLMonitor();
+        ttlMonitor->go();
     }    
     
     string TTLMonitor::secondsExpireField = "expireAfterSeconds";
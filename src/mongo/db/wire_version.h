@@ -51,12 +51,15 @@ namespace mongo {
         AGG_RETURNS_CURSORS = 1,
 
         // insert, update, and delele batch command
-        BATCH_COMMANDS = 2
+        BATCH_COMMANDS = 2,
+
+        // isMaster may negotiate dbCompressed messages, see message_compression.h
+        MESSAGE_COMPRESSION = 3
     };
 
     // Latest version that the server accepts. This should always be at the latest entry in
     // WireVersion.
-    static const int maxWireVersion = BATCH_COMMANDS;
+    static const int maxWireVersion = MESSAGE_COMPRESSION;
 
     // Minimum version that the server accepts. We should bump this whenever we don't want
     // to allow communication with too old agents.
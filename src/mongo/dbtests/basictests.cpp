@@ -499,6 +499,14 @@ namespace BasicTests {
             ASSERT( ! q.blockingPop( x , 5 ) );
             ASSERT( t.seconds() > 3 && t.seconds() < 9 );
 
+            int batch[] = { 3, 1, 2 };
+            q.pushAll( batch , batch + 3 );
+            ASSERT_EQUALS( 3u , q.size() );
+            for ( int i = 0; i < 3; i++ ) {
+                ASSERT( q.blockingPop( x , 1 ) );
+                ASSERT_EQUALS( batch[i] , x );
+            }
+            ASSERT( q.empty() );
         }
     };
 
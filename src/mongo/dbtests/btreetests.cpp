@@ -22,6 +22,7 @@
 #include "mongo/db/btree.h"
 #include "mongo/db/btreecursor.h"
 #include "mongo/db/db.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/json.h"
 #include "mongo/dbtests/dbtests.h"
 
@@ -45,6 +45,16 @@
             return val;
         }
     protected:
+        int countBuckets( const BtreeBucket* b ) {
+            int count = 1;
+            for ( int i = 0; i <= b->nKeys(); ++i ) {
+                DiskLoc d = i == b->nKeys() ? b->getNextChild() : b->keyNode( i ).prevChildBucket;
+                if ( !d.isNull() ) {
+                    count += countBuckets( d.btree() );
+                }
+            }
+            return count;
+        }
         const BtreeBucket* bt() {
             return id().head.btree();
         }
@@ -153,6 +163,32 @@
         }
     };
 
+    class LatchedReads : public Base {
+    public:
+        void run() {
+            BSONObj key = simpleKey( 'z' );
+            insert( key );
+
+            // a write invalidates optimistic reads of the bucket
+            unsigned version = BtreeLatches::readBegin( dl() );
+            ASSERT( BtreeLatches::validate( dl(), version ) );
+            BSONObj other = simpleKey( 'y' );
+            insert( other );
+            ASSERT( !BtreeLatches::validate( dl(), version ) );
+
+            // while an operation holds the bucket latched, its own reads still work
+            {
+                BtreeLatches::WriteScope latches;
+                dl().btreemod();
+                version = BtreeLatches::readBegin( dl() );
+                locate( key, 1, true, dl() );
+                ASSERT( BtreeLatches::validate( dl(), version ) );
+            }
+            ASSERT( !BtreeLatches::validate( dl(), version ) );
+            checkValid( 2 );
+        }
+    };
+
     class SplitUnevenBucketBase : public Base {
     public:
         virtual ~SplitUnevenBucketBase() {}
@@ -286,6 +322,87 @@
         }
     };
 
+    /**
+     * Mostly ascending inserts that aren't strictly ascending leave buckets nearly full once the
+     * index's splits show the pattern, rather than splitting them evenly.
+     */
+    class SplitMostlyAscending : public Base {
+    public:
+        void run() {
+            int adaptiveBuckets = insertMostlyAscending( 0 );
+            setAdaptiveSplits( false );
+            int evenBuckets = insertMostlyAscending( 1000000 );
+            setAdaptiveSplits( true );
+            checkValid( 2 * nKeys );
+            ASSERT_LESS_THAN( adaptiveBuckets * 10, evenBuckets * 8 );
+        }
+    private:
+        static const int nKeys = 4000;
+        /** Inserts keys ascending in blocks of four that are each descending. */
+        int insertMostlyAscending( long long first ) {
+            int before = countBuckets( bt() );
+            for ( int i = 0; i < nKeys; i += 4 ) {
+                for ( int j = 3; j >= 0; --j ) {
+                    BSONObj k = BSON( "a" << bigNumString( first + i + j, 100 ) );
+                    insert( k );
+                }
+            }
+            return countBuckets( bt() ) - before;
+        }
+        void setAdaptiveSplits( bool on ) {
+            ServerParameter* param =
+                    ServerParameterSet::getGlobal()->getMap().find( "btreeAdaptiveSplits" )->second;
+            ASSERT_OK( param->set( BSON( "" << on ).firstElement() ) );
+        }
+    };
+
+    /**
+     * Removing every other key leaves the buckets about half full but above lowWaterMark, so
+     * only defragmentation merges them.
+     */
+    class DefragHalfEmptyBuckets : public Base {
+    public:
+        void run() {
+            for ( int i = 0; i < nKeys; ++i ) {
+                BSONObj k = key( i );
+                insert( k );
+            }
+            for ( int i = 0; i < nKeys; i += 2 ) {
+                BSONObj k = key( i );
+                ASSERT( unindex( k ) );
+            }
+            checkValid( nKeys / 2 );
+            int before = countBuckets( bt() );
+
+            BSONObj resumeKey;
+            DiskLoc resumeLoc;
+            int merged = 0;
+            for ( int steps = 0; ; ++steps ) {
+                ASSERT_LESS_THAN( steps, 10 * before );
+                BtreeDefragResult result = bt()->defragStep( dl(), id(), resumeKey, resumeLoc );
+                if ( result == DefragDone ) {
+                    break;
+                }
+                if ( result == DefragMerged ) {
+                    ++merged;
+                }
+            }
+
+            checkValid( nKeys / 2 );
+            ASSERT_LESS_THAN( 0, merged );
+            ASSERT_LESS_THAN( countBuckets( bt() ) * 10, before * 7 );
+            for ( int i = 1; i < nKeys; i += 2 ) {
+                BSONObj k = key( i );
+                ASSERT( present( k, 1 ) );
+            }
+        }
+    private:
+        static const int nKeys = 2000;
+        BSONObj key( int i ) {
+            return BSON( "a" << bigNumString( i, 100 ) );
+        }
+    };
+
     class DontReuseUnused : public Base {
     public:
         void run() {
@@ -1636,11 +1753,14 @@
         void setupTests() {
             add< Create >();
             add< SimpleInsertDelete >();
+            add< LatchedReads >();
             add< SplitRightHeavyBucket >();
             add< SplitLeftHeavyBucket >();
             add< MissingLocate >();
             add< MissingLocateMultiBucket >();
             add< SERVER983 >();
+            add< SplitMostlyAscending >();
+            add< DefragHalfEmptyBuckets >();
             add< DontReuseUnused >();
             add< PackUnused >();
             add< DontDropReferenceKey >();
@@ -45,7 +45,7 @@ namespace mongo {
                 
                 ChunkPtr chunk( new Chunk( this, mySplitPoints[ i-1 ], mySplitPoints[ i ],
                                           shard ) );
-                chunkMap[ mySplitPoints[ i ] ] = chunk;
+                chunkMap.insert( make_pair( mySplitPoints[ i ], chunk ) );
             }
             
             chunkRanges.reloadAll( chunkMap );
@@ -228,13 +228,92 @@ namespace ChunkTests {
                 return BSON( "a" << BSON( "$in" << BSON_ARRAY( 0 << 5 << 10 ) ) <<
                              "b" << BSON( "$in" << BSON_ARRAY( 0 << 5 << 25 ) ) );
             }
-            // If we were to send this query to just the shards it actually needed to hit, it would only hit shards 0 and 2
-            // Because of the optimization from SERVER-4745, however, we'll also hit shard 1.
+            // every combination of the $in values is a point, so only the shards with one are hit
+            virtual BSONArray expectedShardNames() const {
+                return BSON_ARRAY( "0" << "2" );
+            }
+        };
+
+        class InRangeMultiShard : public CompoundKeyBase {
+            virtual BSONObj query() const {
+                return BSON( "a" << BSON( "$in" << BSON_ARRAY( 0 << 5 ) ) <<
+                             "b" << GT << 12 << LT << 15 );
+            }
+            virtual BSONArray expectedShardNames() const { return BSON_ARRAY( "0" << "1" ); }
+        };
+
+        class LargeInSingleShard : public MultiShardBase {
+            virtual BSONObj query() const {
+                BSONArrayBuilder values;
+                for ( int i = 0; i < 10000; i++ ) {
+                    values << i;
+                }
+                values << "u";
+                return BSON( "a" << BSON( "$in" << values.arr() ) );
+            }
+        };
+
+        class NestedOr : public MultiShardBase {
+            virtual BSONObj query() const {
+                return fromjson( "{$and:[{b:1},{$or:[{a:'u'},{$or:[{c:1},{a:'y'}]}]}]}" );
+            }
+            virtual BSONArray expectedShardNames() const {
+                return BSON_ARRAY( "0" << "1" << "2" << "3" );
+            }
+        };
+
+        class NestedOrEqualities : public MultiShardBase {
+            virtual BSONObj query() const {
+                return fromjson( "{$and:[{b:1},{$or:[{a:'u'},{$or:[{a:'x'},{a:'y'}]}]}]}" );
+            }
             virtual BSONArray expectedShardNames() const {
                 return BSON_ARRAY( "0" << "1" << "2" );
             }
         };
 
+        class OrWithinRange : public MultiShardBase {
+            virtual BSONObj query() const {
+                return fromjson( "{a:{$gte:'x'},$or:[{a:'u'},{a:'y'}]}" );
+            }
+            virtual BSONArray expectedShardNames() const { return BSON_ARRAY( "2" ); }
+        };
+
+        class TwoOrs : public MultiShardBase {
+            virtual BSONObj query() const {
+                return fromjson( "{$and:[{$or:[{a:'u'},{a:'y'}]},{$or:[{a:'y'},{a:'z'}]}]}" );
+            }
+            virtual BSONArray expectedShardNames() const { return BSON_ARRAY( "2" ); }
+        };
+
+        class FindIntersectingChunks {
+        public:
+            void run() {
+                ChunkManager chunkManager;
+                chunkManager.setShardKey( BSON( "a" << 1 ) );
+                vector<BSONObj> splitPoints;
+                for ( int i = 10; i < 100; i += 10 ) {
+                    splitPoints.push_back( BSON( "a" << i ) );
+                }
+                chunkManager.setSingleChunkForShards( splitPoints );
+
+                // unsorted, with repeats, chunk bounds and points far apart
+                int values[] = { 25, 5, 95, 10, 15, 5, 29, 30, -1000, 1000, 31, 55 };
+                vector<BSONObj> points;
+                for ( size_t i = 0; i < sizeof( values ) / sizeof( values[0] ); ++i ) {
+                    points.push_back( BSON( "a" << values[i] ) );
+                }
+                points.push_back( BSON( "a" << MINKEY ) );
+
+                vector<ChunkPtr> chunks;
+                chunkManager.findIntersectingChunks( points, &chunks );
+
+                ASSERT_EQUALS( points.size(), chunks.size() );
+                for ( size_t i = 0; i < points.size(); ++i ) {
+                    ASSERT( chunks[i] == chunkManager.findIntersectingChunk( points[i] ) );
+                }
+            }
+        };
+
     } // namespace ChunkManagerTests
     
     class All : public Suite {
@@ -263,6 +342,13 @@ namespace ChunkTests {
             add<ChunkManagerTests::InequalityThenUnsatisfiable>();
             add<ChunkManagerTests::OrEqualityUnsatisfiableInequality>();
             add<ChunkManagerTests::InMultiShard>();
+            add<ChunkManagerTests::InRangeMultiShard>();
+            add<ChunkManagerTests::LargeInSingleShard>();
+            add<ChunkManagerTests::NestedOr>();
+            add<ChunkManagerTests::NestedOrEqualities>();
+            add<ChunkManagerTests::OrWithinRange>();
+            add<ChunkManagerTests::TwoOrs>();
+            add<ChunkManagerTests::FindIntersectingChunks>();
         }
     } myall;
     
@@ -192,6 +192,44 @@ namespace ClientTests {
         }
     };
 
+    class NextBatch : public Base {
+    public:
+        NextBatch() : Base( "NextBatch" ) {}
+        void run() {
+            for( int i = 0; i < 100; ++i )
+                db.insert( ns(), BSON( "i" << i ) );
+            auto_ptr< DBClientCursor > c =
+                    db.query( ns(), Query().sort( BSON( "i" << 1 ) ), 0, 0, 0, 0, 30 );
+
+            // a batch taken with the cursor part way through has the rest of it
+            BSONObj o = c->next();
+            ASSERT_EQUALS( 0, o[ "i" ].number() );
+            vector< DBClientBatch > batches;
+            DBClientBatch b;
+            while( c->nextBatch( &b ) )
+                batches.push_back( b );
+            ASSERT( !c->more() );
+            ASSERT( !c->nextBatch( &b ) );
+            ASSERT_EQUALS( 29, batches[ 0 ].size() );
+
+            // every batch is still readable after the cursor has moved past it
+            int i = 1;
+            for( vector< DBClientBatch >::iterator it = batches.begin(); it != batches.end(); ++it ) {
+                DBClientBatch::Iterator docs = it->iterator();
+                while( docs.more() )
+                    ASSERT_EQUALS( i++, docs.next()[ "i" ].number() );
+            }
+            ASSERT_EQUALS( 100, i );
+
+            // a limit ends the last batch
+            c = db.query( ns(), Query().sort( BSON( "i" << 1 ) ), 45, 0, 0, 0, 20 );
+            int n = 0;
+            while( c->nextBatch( &b ) )
+                n += b.size();
+            ASSERT_EQUALS( 45, n );
+        }
+    };
+
     class Create : public Base {
     public:
         Create() : Base( "Create" ) {}
@@ -230,6 +268,7 @@ namespace ClientTests {
             add<BuildIndex>();
             add<CS_10>();
             add<PushBack>();
+            add<NextBatch>();
             add<Create>();
             add<ConnectionStringTests>();
         }
@@ -768,6 +768,22 @@ namespace CursorTests {
             
         } // namespace Pin
 
+        /** With nobody queued for a lock, a YieldTracker only fires now and then. */
+        class YieldTrackerIdle {
+        public:
+            void run() {
+                YieldTracker tracker;
+                int fired = 0;
+                for( int i = 0; i < 4096; ++i ) {
+                    if ( tracker.intervalHasElapsed() ) {
+                        ++fired;
+                    }
+                }
+                ASSERT_EQUALS( 4, fired );
+                ASSERT_LESS_THAN_OR_EQUALS( 1, YieldTracker::currentIntervalMillis() );
+            }
+        };
+
     } // namespace ClientCursor
     
     class All : public Suite {
@@ -797,6 +813,7 @@ namespace CursorTests {
             add<ClientCursor::Pin::PinCursor>();
             add<ClientCursor::Pin::PinTwice>();
             add<ClientCursor::Pin::CursorDeleted>();
+            add<ClientCursor::YieldTrackerIdle>();
         }
     } myall;
 } // namespace CursorTests
@@ -17,6 +17,8 @@
 #include "mongo/db/dbhelpers.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/client/dbclientcursor.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/structure/id_lookup_cache.h"
 #include "mongo/unittest/unittest.h"
 
 namespace mongo {
@@ -218,4 +220,43 @@ namespace mongo {
         }
     }
 
+    //
+    // Tests the _id lookup cache keeps to its budget, evicting unreferenced entries first
+    //
+
+    TEST(DBHelperTests, IdLookupCacheEviction) {
+
+        ServerParameter* sizeMB =
+            ServerParameterSet::getGlobal()->getMap().find( "idLookupCacheSizeMB" )->second;
+        sizeMB->set( BSON( "" << 1 ).firstElement() );
+
+        IdLookupCache cache;
+        BSONObj hot = BSON( "" << -1 );
+        cache.add( hot.firstElement(), DiskLoc( 0, 8 ) );
+
+        DiskLoc loc;
+        for ( int i = 0; i < 50000; ++i ) {
+            BSONObj id = BSON( "" << i );
+            cache.add( id.firstElement(), DiskLoc( 1, i * 8 ) );
+            ASSERT( cache.find( hot.firstElement(), &loc ) );
+        }
+        ASSERT_LESS_THAN_OR_EQUALS( cache.sizeBytes(), 1024U * 1024 );
+        ASSERT_EQUALS( DiskLoc( 0, 8 ), loc );
+
+        // the oldest entries were evicted, the newest is there under any numeric type
+        BSONObj oldest = BSON( "" << 0 );
+        ASSERT( !cache.find( oldest.firstElement(), &loc ) );
+        BSONObj newest = BSON( "" << 49999.0 );
+        ASSERT( cache.find( newest.firstElement(), &loc ) );
+        ASSERT_EQUALS( DiskLoc( 1, 49999 * 8 ), loc );
+
+        cache.invalidate( newest.firstElement() );
+        ASSERT( !cache.find( newest.firstElement(), &loc ) );
+
+        cache.clear();
+        ASSERT_EQUALS( 0U, cache.sizeBytes() );
+
+        sizeMB->set( BSON( "" << 16 ).firstElement() );
+    }
+
 } // namespace RemoveTests
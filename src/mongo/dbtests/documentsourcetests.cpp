@@ -1358,6 +1358,48 @@ namespace DocumentSourceTests {
                 ASSERT_EQUALS( 1U, dependencies.count( "b.c" ) );
             }
         };
+
+        /** Over its share of the memory budget, the sort spills and explain reports it. */
+        class SpillsToDisk : public Base {
+        public:
+            void run() {
+                for ( int i = 0; i < 100; ++i ) {
+                    client.insert( ns, BSON( "_id" << i << "a" << ( i * 37 ) % 100
+                                             << "s" << string( 1000, 'x' ) ) );
+                }
+                ctx()->extSortAllowed = true;
+                ctx()->maxMemoryUsageBytes = 20 * 1000;
+                createSource();
+                createSort();
+
+                for ( int i = 0; i < 100; ++i ) {
+                    boost::optional<Document> next = sort()->getNext();
+                    ASSERT( next );
+                    ASSERT_EQUALS( i, next->getField( "a" ).getInt() );
+                }
+                assertExhausted();
+
+                vector<Value> arr;
+                sort()->serializeToArray( arr, true );
+                const Document explained = arr[0].getDocument()[ "$sort" ].getDocument();
+                ASSERT_LESS_THAN( 1, explained[ "spills" ].getLong() );
+                ASSERT_LESS_THAN( 0, explained[ "spilledBytes" ].getLong() );
+            }
+        };
+
+        /** Without allowDiskUse, the same sort fails once over its share. */
+        class MemoryLimitWithoutDisk : public Base {
+        public:
+            void run() {
+                for ( int i = 0; i < 100; ++i ) {
+                    client.insert( ns, BSON( "_id" << i << "s" << string( 1000, 'x' ) ) );
+                }
+                ctx()->maxMemoryUsageBytes = 20 * 1000;
+                createSource();
+                createSort( BSON( "s" << 1 ) );
+                ASSERT_THROWS( sort()->getNext(), UserException );
+            }
+        };
         
     } // namespace DocumentSourceSort
 
@@ -1854,6 +1896,22 @@ namespace DocumentSourceTests {
                                                                      "{c:1}]}"));
             }
         };
+
+        class Dependencies {
+        public:
+            void run() {
+                set<string> dependencies;
+                ASSERT_EQUALS(DocumentSource::SEE_NEXT,
+                              makeMatch("{a: 1, 'b.c': {$gt: 1}, $or: [{d: 1}, {'e.0.f': 1}],"
+                                        " $comment: 'x', $atomic: true}")->getDependencies(
+                                                                                dependencies));
+                ASSERT_EQUALS(4U, dependencies.size());
+                ASSERT_EQUALS(1U, dependencies.count("a"));
+                ASSERT_EQUALS(1U, dependencies.count("b"));
+                ASSERT_EQUALS(1U, dependencies.count("d"));
+                ASSERT_EQUALS(1U, dependencies.count("e"));
+            }
+        };
     } // namespace DocumentSourceMatch
 
     class All : public Suite {
@@ -1938,6 +1996,8 @@ namespace DocumentSourceTests {
             add<DocumentSourceSort::MissingObjectWithinArray>();
             add<DocumentSourceSort::ExtractArrayValues>();
             add<DocumentSourceSort::Dependencies>();
+            add<DocumentSourceSort::SpillsToDisk>();
+            add<DocumentSourceSort::MemoryLimitWithoutDisk>();
 
             add<DocumentSourceUnwind::Empty>();
             add<DocumentSourceUnwind::MissingField>();
@@ -1962,6 +2022,7 @@ namespace DocumentSourceTests {
 
             add<DocumentSourceMatch::RedactSafePortion>();
             add<DocumentSourceMatch::Coalesce>();
+            add<DocumentSourceMatch::Dependencies>();
         }
     } myall;
 
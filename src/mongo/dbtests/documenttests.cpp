@@ -98,6 +98,35 @@ namespace DocumentTests {
             }
         };
 
+        /** Documents keep every field as they grow past the size where fields are hashed. */
+        class AddManyFields {
+        public:
+            void run() {
+                // with and without space reserved up front
+                for ( size_t reserved = 0; reserved < 6; reserved += 5 ) {
+                    for ( int n = 1; n <= 20; ++n ) {
+                        MutableDocument md( reserved );
+                        for ( int i = 0; i < n; ++i ) {
+                            md.addField( string( str::stream() << "field" << i ), Value( i ) );
+                        }
+                        Document doc = md.freeze();
+                        ASSERT_EQUALS( size_t( n ), doc.size() );
+                        for ( int i = 0; i < n; ++i ) {
+                            ASSERT_EQUALS( i, doc[ string( str::stream() << "field" << i ) ].getInt() );
+                        }
+                        ASSERT( doc["field"].missing() );
+                        assertRoundTrips( doc );
+                    }
+                }
+
+                // a small document gets less than the smallest buffer of a hashed one
+                MutableDocument small;
+                small.addField( "_id", Value( 1 ) );
+                ASSERT_LESS_THAN( small.peek().getApproximateSize(),
+                                  sizeof( DocumentStorage ) + 128 );
+            }
+        };
+
         /** Get Document values. */
         class GetValue {
         public:
@@ -1406,6 +1435,7 @@ namespace DocumentTests {
             add<Document::Create>();
             add<Document::CreateFromBsonObj>();
             add<Document::AddField>();
+            add<Document::AddManyFields>();
             add<Document::GetValue>();
             add<Document::SetField>();
             add<Document::Compare>();
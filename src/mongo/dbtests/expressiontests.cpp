@@ -855,6 +855,155 @@ namespace ExpressionTests {
         
     } // namespace Compare
     
+    namespace Compiled {
+
+        /** Compiling expression() changes neither what it evaluates to nor how it serializes. */
+        class Base {
+        public:
+            virtual ~Base() {}
+            void run() {
+                BSONObj spec = expression();
+                intrusive_ptr<Expression> tree =
+                        Expression::parseOperand( spec.firstElement() )->optimize();
+                intrusive_ptr<Expression> compiled = ExpressionCompiled::compile( tree );
+                ExpressionCompiled* program = dynamic_cast<ExpressionCompiled*>( compiled.get() );
+                ASSERT( program );
+                ASSERT_EQUALS( expectedProgramSize(), program->getProgramSize() );
+                assertBinaryEqual( expressionToBson( tree ), expressionToBson( compiled ) );
+
+                BSONObj docs = inputs();
+                BSONForEach( doc, docs ) {
+                    Document input( doc.Obj() );
+                    assertBinaryEqual( toBson( tree->evaluate( input ) ),
+                                       toBson( compiled->evaluate( input ) ) );
+                }
+            }
+        protected:
+            virtual BSONObj expression() = 0;
+            virtual BSONObj inputs() = 0;
+            virtual size_t expectedProgramSize() = 0;
+        };
+
+        /** Nested arithmetic is evaluated bottom up, one operator per instruction. */
+        class Arithmetic : public Base {
+            BSONObj expression() {
+                return fromjson( "{'':{$subtract:[{$multiply:['$a',2]},"
+                                                "{$divide:['$b',{$subtract:['$c',1]}]}]}}" );
+            }
+            BSONObj inputs() {
+                return fromjson( "{'':[{a:1,b:4,c:3},{a:2.5,b:1,c:5},{a:null,b:1,c:3},"
+                                      "{b:6,c:4},{a:NumberLong(7),b:9,c:10}]}" )
+                        .firstElement().embeddedObject().getOwned();
+            }
+            size_t expectedProgramSize() { return 4; }
+        };
+
+        /** The $cond branch not taken isn't evaluated, so it can't fail. */
+        class CondBranches : public Base {
+            BSONObj expression() {
+                return fromjson( "{'':{$cond:[{$eq:['$b',0]},null,{$divide:['$a','$b']}]}}" );
+            }
+            BSONObj inputs() {
+                return fromjson( "{'':[{a:1,b:0},{a:3,b:2},{a:3,b:null}]}" )
+                        .firstElement().embeddedObject().getOwned();
+            }
+            size_t expectedProgramSize() { return 6; }
+        };
+
+        /** $and stops at its first false operand, before the $mod by zero. */
+        class AndShortCircuits : public Base {
+            BSONObj expression() {
+                return fromjson( "{'':{$and:[{$gt:['$a',0]},{$eq:[{$mod:[10,'$a']},0]}]}}" );
+            }
+            BSONObj inputs() {
+                return fromjson( "{'':[{a:0},{a:-1},{a:5},{a:3}]}" )
+                        .firstElement().embeddedObject().getOwned();
+            }
+            size_t expectedProgramSize() { return 8; }
+        };
+
+        /** $or stops at its first true operand. */
+        class OrShortCircuits : public Base {
+            BSONObj expression() {
+                return fromjson( "{'':{$or:[{$lte:['$a',0]},{$eq:[{$mod:[10,'$a']},0]}]}}" );
+            }
+            BSONObj inputs() {
+                return fromjson( "{'':[{a:0},{a:-1},{a:5},{a:3}]}" )
+                        .firstElement().embeddedObject().getOwned();
+            }
+            size_t expectedProgramSize() { return 8; }
+        };
+
+        /** $ifNull only evaluates its replacement for nullish values. */
+        class IfNull : public Base {
+            BSONObj expression() {
+                return fromjson( "{'':{$ifNull:[{$toUpper:'$s'},{$multiply:['$b',2]}]}}" );
+            }
+            BSONObj inputs() {
+                return fromjson( "{'':[{s:'abc',b:1},{b:3},{s:null,b:'x'}]}" )
+                        .firstElement().embeddedObject().getOwned();
+            }
+            size_t expectedProgramSize() { return 5; }
+        };
+
+        /** An operator repeated outside of any condition is evaluated once. */
+        class CommonSubexpression : public Base {
+            BSONObj expression() {
+                return fromjson( "{'':{$subtract:[{$multiply:['$a','$b']},"
+                                                "{$multiply:['$a','$b']}]}}" );
+            }
+            BSONObj inputs() {
+                return fromjson( "{'':[{a:2,b:3},{a:1.5,b:2}]}" )
+                        .firstElement().embeddedObject().getOwned();
+            }
+            size_t expectedProgramSize() { return 2; }
+        };
+
+        /** Operators differing only in numeric type are kept apart. */
+        class NumericTypesNotShared : public Base {
+            BSONObj expression() {
+                return fromjson( "{'':{$subtract:[{$multiply:['$a',1]},"
+                                                "{$multiply:['$a',1.0]}]}}" );
+            }
+            BSONObj inputs() {
+                return fromjson( "{'':[{a:2},{a:NumberLong(3)}]}" )
+                        .firstElement().embeddedObject().getOwned();
+            }
+            size_t expectedProgramSize() { return 3; }
+        };
+
+        /** Operators that stop at a null operand keep their trees unless the rest are leaves. */
+        class EarlyExitOperands : public Base {
+            BSONObj expression() {
+                return fromjson( "{'':{$subtract:[{$add:['$a',{$divide:[1,'$b']}]},"
+                                                "{$add:[{$multiply:['$a',2]},'$b',1]}]}}" );
+            }
+            BSONObj inputs() {
+                return fromjson( "{'':[{a:null,b:0},{a:1,b:2}]}" )
+                        .firstElement().embeddedObject().getOwned();
+            }
+            size_t expectedProgramSize() { return 3; }
+        };
+
+        /** There's nothing to gain compiling a lone operator or a $let. */
+        class NotCompiled {
+        public:
+            void run() {
+                assertNotCompiled( fromjson( "{'':{$add:['$a',1]}}" ) );
+                assertNotCompiled( fromjson( "{'':{$let:{vars:{x:{$add:['$a',1]}},"
+                                                       "in:{$multiply:['$$x','$$x']}}}}" ) );
+                assertNotCompiled( fromjson( "{'':'$a'}" ) );
+            }
+        private:
+            static void assertNotCompiled( const BSONObj& spec ) {
+                intrusive_ptr<Expression> tree =
+                        Expression::parseOperand( spec.firstElement() )->optimize();
+                ASSERT_EQUALS( tree, ExpressionCompiled::compile( tree ) );
+            }
+        };
+
+    } // namespace Compiled
+
     namespace Constant {
 
         /** Create an ExpressionConstant from a Value. */
@@ -3457,6 +3606,15 @@ namespace ExpressionTests {
             add<Compare::OptimizeGte>();
             add<Compare::OptimizeGteReverse>();
 
+            add<Compiled::Arithmetic>();
+            add<Compiled::CondBranches>();
+            add<Compiled::AndShortCircuits>();
+            add<Compiled::OrShortCircuits>();
+            add<Compiled::IfNull>();
+            add<Compiled::CommonSubexpression>();
+            add<Compiled::NumericTypesNotShared>();
+            add<Compiled::EarlyExitOperands>();
+            add<Compiled::NotCompiled>();
             add<Constant::Create>();
             add<Constant::CreateFromBsonElement>();
             add<Constant::Optimize>();
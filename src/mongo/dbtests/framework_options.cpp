@@ -68,6 +68,9 @@ namespace mongo {
         options->addOptionChaining("perfHist", "perfHist", moe::Unsigned,
                 "number of back runs of perf stats to display");
 
+        options->addOptionChaining("perfOutput", "perfOutput", moe::String,
+                "file to append perf results to, one json document per line");
+
 
         options->addOptionChaining("suites", "suites", moe::StringVector, "test suites to run")
                                   .hidden()
@@ -131,6 +134,10 @@ namespace mongo {
             frameworkGlobalParams.perfHist = params["perfHist"].as<unsigned>();
         }
 
+        if (params.count("perfOutput")) {
+            frameworkGlobalParams.perfOutput = params["perfOutput"].as<string>();
+        }
+
         bool nodur = false;
         if( params.count("nodur") ) {
             nodur = true;
@@ -32,6 +32,7 @@ namespace mongo {
 
     struct FrameworkGlobalParams {
         unsigned perfHist;
+        std::string perfOutput;
         unsigned long long seed;
         int runsPerTest;
         std::string dbpathSpec;
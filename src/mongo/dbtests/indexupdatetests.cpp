@@ -23,6 +23,7 @@
 #include "mongo/db/index/btree_based_builder.h"
 #include "mongo/db/kill_current_op.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/sort_phase_one.h"
 #include "mongo/db/structure/collection.h"
 #include "mongo/platform/cstdint.h"
@@ -104,6 +105,46 @@ namespace IndexUpdateTests {
         }
     };
 
+    /** addKeysToPhaseOne() generates keys on several threads for larger collections. */
+    class AddKeysToPhaseOneInParallel : public IndexBuildBase {
+    public:
+        void run() {
+            setThreads( 4 );
+            // Enough documents to be worth threads, each with two keys.
+            int32_t nDocs = 20000;
+            for( int32_t i = 0; i < nDocs; ++i ) {
+                _client.insert( _ns, BSON( "a" << BSON_ARRAY( i << nDocs + i ) ) );
+            }
+            IndexDetails& id = addIndexWithInfo();
+            SortPhaseOne phaseOne;
+            ProgressMeterHolder pm (cc().curop()->setMessage("AddKeysToPhaseOneInParallel",
+                                                             "AddKeysToPhaseOneInParallel Progress",
+                                                             nDocs,
+                                                             nDocs));
+            BtreeBasedBuilder::addKeysToPhaseOne( nsdetails(_ns), _ns, id, BSON( "a" << 1 ),
+                                                  &phaseOne, nDocs, pm.get(), true,
+                                                  nsdetails(_ns)->idxNo(id) );
+            setThreads( 0 );
+            ASSERT_EQUALS( 4, phaseOne.sorter->numRuns() );
+            ASSERT_EQUALS( static_cast<uint64_t>( nDocs ), phaseOne.n );
+            ASSERT_EQUALS( static_cast<uint64_t>( 2 * nDocs ), phaseOne.nkeys );
+            ASSERT( phaseOne.multi );
+            // The runs merge back into a single sorted stream.
+            auto_ptr<BSONObjExternalSorter::Iterator> i = phaseOne.sorter->iterator();
+            for( int32_t expected = 0; expected < 2 * nDocs; ++expected ) {
+                ASSERT( i->more() );
+                ASSERT_EQUALS( expected, i->next().first.firstElement().numberInt() );
+            }
+            ASSERT( !i->more() );
+        }
+    private:
+        void setThreads( int n ) {
+            ServerParameter* param = ServerParameterSet::getGlobal()->getMap().find(
+                    "indexBuildKeyGenerationThreads" )->second;
+            ASSERT_OK( param->set( BSON( "" << n ).firstElement() ) );
+        }
+    };
+
     /** addKeysToPhaseOne() aborts if the current operation is killed. */
     class InterruptAddKeysToPhaseOne : public IndexBuildBase {
     public:
@@ -752,6 +793,7 @@ namespace IndexUpdateTests {
 
         void setupTests() {
             add<AddKeysToPhaseOne>();
+            add<AddKeysToPhaseOneInParallel>();
             add<InterruptAddKeysToPhaseOne>( false );
             add<InterruptAddKeysToPhaseOne>( true );
             add<BuildBottomUp>();
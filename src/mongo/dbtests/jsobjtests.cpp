@@ -19,6 +19,8 @@
 
 #include "mongo/pch.h"
 
+#include <boost/thread/thread.hpp>
+
 #include "mongo/bson/util/builder.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/jsobjmanipulator.h"
@@ -52,6 +54,13 @@ namespace JsobjTests {
         ASSERT( k.woEqual(k) );
         ASSERT( !k.isCompactFormat() || k.dataSize() < o.objsize() );
 
+        {
+            // decoding into a reused buffer gives the same object
+            static BufBuilder scratch;
+            ASSERT( o.woCompare(k.toBson(scratch), BSONObj(), false) == 0 );
+            ASSERT( x.binaryEqual(k.toBson(scratch)) );
+        }
+
         {
             // check BSONObj::equal.  this part not a KeyV1 test.
             int res = o.woCompare(last);
@@ -1183,6 +1192,30 @@ namespace JsobjTests {
             }
         };
 
+        // ids made on several threads at once are all different
+        class initManyThreads {
+        public:
+            void run() {
+                vector<OID> oids[4];
+                boost::thread_group threads;
+                for ( int i = 0; i < 4; i++ )
+                    threads.create_thread( boost::bind( &initManyThreads::gen, &oids[i] ) );
+                threads.join_all();
+
+                set<OID> all;
+                for ( int i = 0; i < 4; i++ ) {
+                    for ( size_t j = 0; j < oids[i].size(); j++ )
+                        ASSERT( all.insert( oids[i][j] ).second );
+                }
+                ASSERT_EQUALS( 40000U, all.size() );
+            }
+        private:
+            static void gen( vector<OID>* oids ) {
+                for ( int i = 0; i < 10000; i++ )
+                    oids->push_back( OID::gen() );
+            }
+        };
+
         class initParse1 {
         public:
             void run() {
@@ -2215,6 +2248,7 @@ namespace JsobjTests {
             add< BSONObjTests::Validation::NoSize >( Array );
             add< BSONObjTests::Validation::NoSize >( BinData );
             add< OIDTests::init1 >();
+            add< OIDTests::initManyThreads >();
             add< OIDTests::initParse1 >();
             add< OIDTests::append >();
             add< OIDTests::increasing >();
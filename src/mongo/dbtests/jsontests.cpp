@@ -2462,6 +2462,38 @@ namespace JsonTests {
             }
         };
 
+        class ManyStringsAndNumbers : public Base {
+            virtual BSONObj bson() const {
+                BSONObjBuilder b;
+                b.append( "a" , string( 5000 , 'x' ) + "\"" + string( 10 , 'y' ) );
+                b.append( "b" , "short" );
+                b.append( "c" , -12 );
+                b.append( "d" , "" );
+                b.append( "e" , 3.5 );
+                b.append( "f" , BSON( "g" << "it's" << "h" << -7000000000LL ) );
+                b.append( "i" , "tab\tand\nnewline" );
+                return b.obj();
+            }
+            virtual string json() const {
+                return "{ \"a\" : \"" + string( 5000 , 'x' ) + "\\\"" + string( 10 , 'y' ) + "\", "
+                       "\"b\" : \"short\", \"c\" :  -12, \"d\" : '', e : 3.5, "
+                       "\"f\" : { \"g\" : \"it's\", \"h\" : -7000000000 }, "
+                       "\"i\" : \"tab\\tand\\nnewline\" }";
+            }
+        };
+
+        class UnterminatedString : public Bad {
+            virtual string json() const {
+                return "{ \"a\" : \"" + string( 100 , 'x' );
+            }
+        };
+
+        class ControlCharacterInString : public Bad {
+            virtual string json() const {
+                return "{ \"a\" : \"xx\nxx\" }";
+            }
+        };
+
     } // namespace FromJsonTests
 
     class All : public Suite {
@@ -2709,6 +2741,9 @@ namespace JsonTests {
             add< FromJsonTests::EmbeddedDatesFormat3 >();
             add< FromJsonTests::NullString >();
             add< FromJsonTests::NullFieldUnquoted >();
+            add< FromJsonTests::ManyStringsAndNumbers >();
+            add< FromJsonTests::UnterminatedString >();
+            add< FromJsonTests::ControlCharacterInString >();
         }
     } myall;
 
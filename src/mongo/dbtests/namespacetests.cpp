@@ -1541,6 +1541,47 @@ namespace NamespaceTests {
                 ASSERT_EQUALS( nullFieldFromKey, missingField.firstElement());
             }
         };
+
+        /**
+         * Only the first field of a compound hashed index is hashed.  A missing field after it is
+         * represented as null, and a sparse index skips documents missing every field.
+         */
+        class CompoundHashedIndexMissingField {
+        public:
+            void run() {
+                vector<string> rangeFields;
+                rangeFields.push_back( "b" );
+                BSONObj nullObj = BSON( "a" << BSONNULL );
+
+                BSONObjSet keys;
+                HashAccessMethod::getKeysImpl( BSON( "a" << 3 << "b" << 4 ), "a", rangeFields, 0,
+                                               0, false, &keys );
+                ASSERT_EQUALS( 1U, keys.size() );
+                ASSERT_EQUALS( BSON( "" << HashAccessMethod::makeSingleKey( BSON( "" << 3 )
+                                                                            .firstElement(), 0, 0 )
+                                     << "" << 4 ),
+                               *keys.begin() );
+
+                keys.clear();
+                HashAccessMethod::getKeysImpl( BSON( "a" << 3 ), "a", rangeFields, 0, 0, false,
+                                               &keys );
+                BSONObjIterator it( *keys.begin() );
+                ASSERT_EQUALS( NumberLong, it.next().type() );
+                ASSERT_EQUALS( jstNULL, it.next().type() );
+
+                keys.clear();
+                HashAccessMethod::getKeysImpl( BSON( "b" << 4 ), "a", rangeFields, 0, 0, true,
+                                               &keys );
+                ASSERT_EQUALS( 1U, keys.size() );
+                ASSERT_EQUALS( HashAccessMethod::makeSingleKey( nullObj.firstElement(), 0, 0 ),
+                               keys.begin()->firstElement().Long() );
+
+                keys.clear();
+                HashAccessMethod::getKeysImpl( BSON( "c" << 4 ), "a", rangeFields, 0, 0, true,
+                                               &keys );
+                ASSERT( keys.empty() );
+            }
+        };
         
     } // namespace MissingFieldTests
     
@@ -2104,6 +2145,48 @@ namespace NamespaceTests {
             }
             virtual string spec() const { return ""; }
         };
+
+        /** Freeing a record merges it with the free space that follows it. */
+        class DeletedRecordsCoalesce : public Base {
+        public:
+            void run() {
+                create();
+                DiskLoc l[ 3 ];
+                for ( int i = 0; i < 3; ++i ) {
+                    BSONObj b = bigObj(true);
+                    l[ i ] = theDataFileMgr.insert( ns(), b.objdata(), b.objsize() );
+                }
+                int len = l[ 0 ].rec()->lengthWithHeaders();
+                ASSERT_EQUALS( l[ 0 ].getOfs() + len, l[ 1 ].getOfs() );
+
+                // The last record is followed by live data, so stays as it is...
+                theDataFileMgr.deleteRecord( ns(), l[ 1 ].rec(), l[ 1 ] );
+                ASSERT_EQUALS( len, l[ 1 ].drec()->lengthWithHeaders() );
+                ASSERT( inDeletedList( l[ 1 ] ) );
+
+                // ...until the record before it is freed and takes it over.
+                theDataFileMgr.deleteRecord( ns(), l[ 0 ].rec(), l[ 0 ] );
+                ASSERT_EQUALS( 2 * len, l[ 0 ].drec()->lengthWithHeaders() );
+                ASSERT( inDeletedList( l[ 0 ] ) );
+                ASSERT( !inDeletedList( l[ 1 ] ) );
+
+                // The merged space is reused.
+                BSONObj b = bigObj(true);
+                ASSERT_EQUALS( l[ 0 ], theDataFileMgr.insert( ns(), b.objdata(), b.objsize() ) );
+            }
+            virtual string spec() const { return ""; }
+        private:
+            bool inDeletedList( const DiskLoc& loc ) {
+                for ( int i = 0; i < Buckets; ++i ) {
+                    for ( DiskLoc cur = nsd()->deletedListEntry( i ); !cur.isNull();
+                          cur = cur.drec()->nextDeleted() ) {
+                        if ( cur == loc )
+                            return true;
+                    }
+                }
+                return false;
+            }
+        };
         
         /* test  NamespaceDetails::cappedTruncateAfter(const char *ns, DiskLoc loc)
         */
@@ -2436,6 +2519,7 @@ namespace NamespaceTests {
             add< NamespaceDetailsTests::AllocQuantizedWithoutExtra >();
             add< NamespaceDetailsTests::AllocNotQuantizedNearDeletedSize >();
             add< NamespaceDetailsTests::AllocFailsWithTooSmallDeletedRecord >();
+            add< NamespaceDetailsTests::DeletedRecordsCoalesce >();
             add< NamespaceDetailsTests::TwoExtent >();
             add< NamespaceDetailsTests::TruncateCapped >();
             add< NamespaceDetailsTests::Migrate >();
@@ -2448,6 +2532,7 @@ namespace NamespaceTests {
             add< MissingFieldTests::TwoDIndexMissingField >();
             add< MissingFieldTests::HashedIndexMissingField >();
             add< MissingFieldTests::HashedIndexMissingFieldAlternateSeed >();
+            add< MissingFieldTests::CompoundHashedIndexMissingField >();
         }
     } myall;
 } // namespace NamespaceTests
@@ -28,12 +28,17 @@
 #include <boost/thread/thread.hpp>
 #include <fstream>
 
+#include "mongo/client/dbclientcursor.h"
+#include "mongo/db/btree.h"
 #include "mongo/db/db.h"
 #include "mongo/db/dur_stats.h"
+#include "mongo/db/exec/index_scan.h"
+#include "mongo/db/index/btree_key_generator.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/json.h"
 #include "mongo/db/key.h"
 #include "mongo/db/lasterror.h"
+#include "mongo/db/structure/collection.h"
 #include "mongo/db/taskqueue.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/dbtests/framework_options.h"
@@ -209,16 +214,29 @@ namespace PerfTests {
         /* override if your test output doesn't need that */
         virtual bool showDurStats() { return true; }
 
+        // how many operations each call of timed() does, for tests that loop within it.
+        virtual unsigned opsPerCall() { return 1; }
+
     public:
         virtual unsigned batchSize() { return 50; }
 
         void say(unsigned long long n, int ms, string s) {
-            unsigned long long rps = n*1000/ms;
+            unsigned long long rps = n*1000/max(ms, 1);
             cout << "stats " << setw(42) << left << s << ' ' << right << setw(9) << rps << ' ' << right << setw(5) << ms << "ms ";
             if( showDurStats() )
                 cout << dur::stats.curr->_asCSV();
             cout << endl;
 
+            if( !frameworkGlobalParams.perfOutput.empty() ) {
+                // one document per line, for tools tracking results across commits
+                static ofstream out( frameworkGlobalParams.perfOutput.c_str(), ios::app );
+                bool debug = false;
+                DEV debug = true;
+                out << BSON( "test" << s << "rps" << (long long) rps << "millis" << ms <<
+                             "ops" << (long long) n << "dur" << storageGlobalParams.dur <<
+                             "debug" << debug << "git" << gitVersion() ).jsonString() << endl;
+            }
+
             if( conn && !conn->isFailed() ) {
                 const char *ns = "perf.pstats";
                 if(frameworkGlobalParams.perfHist) {
@@ -325,6 +343,7 @@ namespace PerfTests {
             if( hlm == 0 ) {
                 // means just do once
                 timed();
+                n = 1;
             }
             else {
                 do {
@@ -338,7 +357,7 @@ namespace PerfTests {
             client().getLastError(); // block until all ops are finished
             int ms = t.millis();
 
-            say(n, ms, name());
+            say(n * opsPerCall(), ms, name());
 
             post();
 
@@ -1331,6 +1350,550 @@ namespace PerfTests {
     };
 #endif
 
+    /** The btree's hot paths, worked directly rather than through a client so the time is spent
+        in the btree itself.  Run on their own with "test btreeperf".
+    */
+    namespace BtreePerf {
+
+        class BtreeTest : public NonDurTest {
+        public:
+            virtual int howLongMillis() { return 1000; }
+        };
+
+        /** compact keys differing in their last field, their middle one, and not at all */
+        class KeyCompare : public BtreeTest {
+        public:
+            KeyV1Owned a, b, c;
+            Ordering o;
+            string name() { return "btree-Key-woCompare"; }
+            KeyCompare() :
+                a(BSON("" << 12345 << "" << "someone@example.com" << "" << 3.5)),
+                b(BSON("" << 12345 << "" << "someone@example.com" << "" << 4.5)),
+                c(BSON("" << 12345 << "" << "someone@example.org" << "" << 3.5)),
+                o(Ordering::make(BSON("a" << 1 << "b" << 1 << "c" << -1)))
+                {}
+            virtual unsigned opsPerCall() { return 3; }
+            void timed() {
+                verify( a.woCompare(b, o) > 0 );
+                verify( a.woCompare(c, o) < 0 );
+                verify( a.woCompare(a, o) == 0 );
+            }
+        };
+
+        /** an index on { a: 1 }, with keys added straight to its btree */
+        class IndexTest : public BtreeTest {
+        public:
+            IndexTest() : _order(Ordering::make(BSON("a" << 1))), _inserted(0) { }
+        protected:
+            void prep() {
+                client().ensureIndex(ns(), BSON("a" << 1));
+                Client::ReadContext ctx(ns());
+                verify( idx().version() == 1 );
+            }
+            IndexDetails& idx() {
+                NamespaceDetails* nsd = nsdetails(ns());
+                verify( nsd && nsd->getTotalIndexCount() == 2 );
+                return nsd->idx(1);
+            }
+            /** call with the write lock held */
+            void insertKey(long long k) {
+                IndexDetails& id = idx();
+                // the record locations are never followed, they only have to be distinct
+                DiskLoc recordLoc(0, (int) (_inserted++ % 0x8000000) * 16);
+                id.head.btree<V1>()->bt_insert(id.head, recordLoc, BSON("" << k), _order, true, id);
+            }
+            const Ordering _order;
+        private:
+            unsigned long long _inserted;
+        };
+
+        /** inserts, and the splits they cause, for each key pattern */
+        template< class Keys >
+        class Insert : public IndexTest {
+        public:
+            string name() { return string("btree-insert-") + Keys::name(); }
+            virtual unsigned opsPerCall() { return 100; }
+            void timed() {
+                Client::WriteContext ctx(ns());
+                for( unsigned i = 0; i < opsPerCall(); i++ )
+                    insertKey(_keys.next());
+                getDur().commitIfNeeded();
+            }
+        private:
+            Keys _keys;
+        };
+
+        struct AscendingKeys {
+            AscendingKeys() : _n(0) { }
+            static const char* name() { return "ascending"; }
+            long long next() { return _n++; }
+            long long _n;
+        };
+
+        struct DescendingKeys {
+            DescendingKeys() : _n(0) { }
+            static const char* name() { return "descending"; }
+            long long next() { return _n--; }
+            long long _n;
+        };
+
+        struct RandomKeys {
+            static const char* name() { return "random"; }
+            long long next() { return ((long long) rand() << 31) ^ rand(); }
+        };
+
+        /** lookups of random keys among 100000 */
+        class Find : public IndexTest {
+        public:
+            enum { NKeys = 100000 };
+            Find() : _n(0) { }
+            string name() { return "btree-find"; }
+            virtual unsigned opsPerCall() { return 100; }
+            void prep() {
+                IndexTest::prep();
+                Client::WriteContext ctx(ns());
+                for( int i = 0; i < NKeys; i++ )
+                    insertKey(i);
+                getDur().commitIfNeeded();
+                for( int i = 0; i < 1024; i++ )
+                    _keys.push_back(BSON("" << rand() % NKeys));
+            }
+            void timed() {
+                Client::ReadContext ctx(ns());
+                IndexDetails& id = idx();
+                for( unsigned i = 0; i < opsPerCall(); i++ ) {
+                    int pos;
+                    bool found;
+                    DiskLoc bucket = id.head.btree<V1>()->locate(id, id.head, _keys[_n++ % 1024],
+                                                                    _order, pos, found, minDiskLoc);
+                    verify( !bucket.isNull() );
+                }
+            }
+        private:
+            vector<BSONObj> _keys;
+            unsigned _n;
+        };
+
+        /** key generation for a document with a 20 element array */
+        class KeyGenMultikey : public BtreeTest {
+        public:
+            string name() { return "btree-BtreeKeyGenerator-multikey"; }
+            KeyGenMultikey() : _gen(fieldNames(), vector<BSONElement>(2), false) {
+                BSONArrayBuilder tags;
+                for( int i = 0; i < 20; i++ )
+                    tags.append(str::stream() << "tag" << i);
+                _doc = BSON("_id" << OID::gen() << "tags" << tags.arr() << "n" << 5);
+            }
+            void timed() {
+                BSONObjSet keys;
+                _gen.getKeys(_doc, &keys);
+                verify( keys.size() == 20 );
+            }
+        private:
+            static vector<const char*> fieldNames() {
+                vector<const char*> names;
+                names.push_back("tags");
+                names.push_back("n");
+                return names;
+            }
+            BtreeKeyGeneratorV1 _gen;
+            BSONObj _doc;
+        };
+
+        /** a full scan of an index of 10000 documents, counted per key */
+        class Scan : public BtreeTest {
+        public:
+            enum { NDocs = 10000 };
+            string name() { return "btree-IndexScan"; }
+            virtual unsigned opsPerCall() { return NDocs; }
+            virtual unsigned batchSize() { return 1; }
+            void prep() {
+                client().ensureIndex(ns(), BSON("a" << 1));
+                for( int i = 0; i < NDocs; i++ )
+                    client().insert(ns(), BSON("a" << i));
+                client().getLastError();
+            }
+            void timed() {
+                Client::ReadContext ctx(ns());
+                Collection* collection = ctx.ctx().db()->getCollection(ns());
+                int idxNo = collection->details()->findIndexByKeyPattern(BSON("a" << 1));
+
+                IndexScanParams params;
+                params.descriptor = collection->getIndexCatalog()->getDescriptor(idxNo);
+                params.bounds.isSimpleRange = true;
+                params.bounds.startKey = BSON("" << 0);
+                params.bounds.endKey = BSON("" << (int) NDocs);
+                params.bounds.endKeyInclusive = true;
+
+                WorkingSet ws;
+                IndexScan scan(params, &ws, NULL);
+                unsigned n = 0;
+                while( !scan.isEOF() ) {
+                    WorkingSetID id;
+                    if( PlanStage::ADVANCED == scan.work(&id) ) {
+                        ws.free(id);
+                        n++;
+                    }
+                }
+                verify( n == NDocs );
+            }
+        };
+
+        class All : public Suite {
+        public:
+            All() : Suite( "btreeperf" ) { }
+
+            void setupTests() {
+                add< KeyCompare >();
+                add< Insert< AscendingKeys > >();
+                add< Insert< DescendingKeys > >();
+                add< Insert< RandomKeys > >();
+                add< Find >();
+                add< KeyGenMultikey >();
+                add< Scan >();
+            }
+        } myall;
+
+    } // namespace BtreePerf
+
+    /** end to end workloads through DBDirectClient, each a fixed number of operations so that
+        results are comparable from run to run and across releases.  Run on their own with
+        "test workloadperf", once with --dur and once with --nodur to compare journaling, and
+        with --perfOutput to append one JSON document per test to a file.
+    */
+    namespace WorkloadPerf {
+
+        enum { NDocs = 10000 };
+
+        class WorkloadTest : public B {
+        public:
+            // timed() does all opsPerCall() operations in one go
+            virtual int howLongMillis() { return 0; }
+            virtual unsigned opsPerCall() { return NDocs; }
+        protected:
+            static BSONObj doc(int i) {
+                return BSON( "_id" << i << "a" << i % 1000 << "b" << i % 100 << "c" << i <<
+                             "d" << i % 7 << "e" << -i << "f" << i % 13 << "g" << i % 17 <<
+                             "h" << i % 19 << "s" << "some string" << "n" << i <<
+                             "arr" << BSON_ARRAY( 1 << 2 << 3 ) );
+            }
+            void insertDocs() {
+                vector<BSONObj> batch;
+                for( int i = 0; i < NDocs; i++ ) {
+                    batch.push_back(doc(i));
+                    if( batch.size() == 1000 ) {
+                        client().insert(ns(), batch);
+                        batch.clear();
+                    }
+                }
+                client().getLastError();
+            }
+            /** the numbers 0 to NDocs - 1, shuffled the same way every run */
+            static const vector<int>& shuffledIds() {
+                static vector<int> ids;
+                if( ids.empty() ) {
+                    for( int i = 0; i < NDocs; i++ )
+                        ids.push_back(i);
+                    unsigned x = 12345;
+                    for( int i = NDocs - 1; i > 0; i-- ) {
+                        x = x * 1103515245 + 12345;
+                        std::swap(ids[i], ids[(x >> 8) % (i + 1)]);
+                    }
+                }
+                return ids;
+            }
+        };
+
+        /** inserts with 0 to 8 secondary indexes, one document or 100 at a time */
+        template< int NIndexes, int BatchSize >
+        class Insert : public WorkloadTest {
+        public:
+            string name() {
+                return str::stream() << "workload-insert-" << NIndexes << "-indexes-batch-"
+                                     << BatchSize;
+            }
+            void prep() {
+                static const char* const fields[] = { "a", "b", "c", "d", "e", "f", "g", "h" };
+                for( int i = 0; i < NIndexes; i++ )
+                    client().ensureIndex(ns(), BSON(fields[i] << 1));
+            }
+            void timed() {
+                vector<BSONObj> batch;
+                for( int i = 0; i < NDocs; i++ ) {
+                    batch.push_back(doc(i));
+                    if( batch.size() == static_cast<size_t>(BatchSize) ) {
+                        client().insert(ns(), batch);
+                        batch.clear();
+                    }
+                }
+                if( !batch.empty() )
+                    client().insert(ns(), batch);
+            }
+            void post() {
+                verify( client().count(ns()) == NDocs );
+            }
+        };
+
+        class FindById : public WorkloadTest {
+        public:
+            string name() { return "workload-find-by-_id"; }
+            void prep() { insertDocs(); }
+            void timed() {
+                const vector<int>& ids = shuffledIds();
+                for( int i = 0; i < NDocs; i++ )
+                    verify( !client().findOne(ns(), QUERY("_id" << ids[i])).isEmpty() );
+            }
+        };
+
+        /** 1000 queries for 10 documents each by an index range */
+        class RangeQuery : public WorkloadTest {
+        public:
+            string name() { return "workload-range-query"; }
+            virtual unsigned opsPerCall() { return 1000; }
+            void prep() {
+                client().ensureIndex(ns(), BSON("c" << 1));
+                insertDocs();
+            }
+            void timed() {
+                const vector<int>& ids = shuffledIds();
+                for( unsigned i = 0; i < opsPerCall(); i++ ) {
+                    int low = std::min(ids[i], NDocs - 10);
+                    auto_ptr<DBClientCursor> c =
+                        client().query(ns(), QUERY("c" << GTE << low << LT << low + 10));
+                    verify( c->itcount() == 10 );
+                }
+            }
+        };
+
+        /** the same range queries, answered from the index alone */
+        class CoveredQuery : public WorkloadTest {
+        public:
+            string name() { return "workload-covered-query"; }
+            virtual unsigned opsPerCall() { return 1000; }
+            void prep() {
+                client().ensureIndex(ns(), BSON("c" << 1 << "n" << 1));
+                insertDocs();
+            }
+            void timed() {
+                const vector<int>& ids = shuffledIds();
+                BSONObj fields = BSON("_id" << 0 << "c" << 1 << "n" << 1);
+                for( unsigned i = 0; i < opsPerCall(); i++ ) {
+                    int low = std::min(ids[i], NDocs - 10);
+                    auto_ptr<DBClientCursor> c =
+                        client().query(ns(), QUERY("c" << GTE << low << LT << low + 10),
+                                       0, 0, &fields);
+                    verify( c->itcount() == 10 );
+                }
+            }
+        };
+
+        /** one update by _id of each document, with the modifier described by 'Mod' */
+        template< class Mod >
+        class Update : public WorkloadTest {
+        public:
+            string name() { return string("workload-update-") + Mod::name(); }
+            void prep() {
+                client().ensureIndex(ns(), BSON("a" << 1));
+                insertDocs();
+            }
+            void timed() {
+                const vector<int>& ids = shuffledIds();
+                for( int i = 0; i < NDocs; i++ ) {
+                    client().update(ns(), QUERY("_id" << Mod::id(ids[i])), Mod::update(ids[i]),
+                                    Mod::upsert());
+                }
+            }
+            void post() {
+                verify( client().count(ns()) == Mod::expectedCount() );
+            }
+        };
+
+        struct ModBase {
+            static int id(int i) { return i; }
+            static bool upsert() { return false; }
+            static int expectedCount() { return NDocs; }
+        };
+
+        struct ModSet : ModBase {
+            static const char* name() { return "$set"; }
+            static BSONObj update(int i) { return BSON("$set" << BSON("s" << "other string")); }
+        };
+        struct ModSetIndexed : ModBase {
+            static const char* name() { return "$set-indexed"; }
+            static BSONObj update(int i) { return BSON("$set" << BSON("a" << i % 1000 + 1)); }
+        };
+        struct ModUnset : ModBase {
+            static const char* name() { return "$unset"; }
+            static BSONObj update(int i) { return BSON("$unset" << BSON("s" << 1)); }
+        };
+        struct ModInc : ModBase {
+            static const char* name() { return "$inc"; }
+            static BSONObj update(int i) { return BSON("$inc" << BSON("n" << 1)); }
+        };
+        struct ModMul : ModBase {
+            static const char* name() { return "$mul"; }
+            static BSONObj update(int i) { return BSON("$mul" << BSON("n" << 2)); }
+        };
+        struct ModMin : ModBase {
+            static const char* name() { return "$min"; }
+            static BSONObj update(int i) { return BSON("$min" << BSON("n" << i / 2)); }
+        };
+        struct ModMax : ModBase {
+            static const char* name() { return "$max"; }
+            static BSONObj update(int i) { return BSON("$max" << BSON("n" << i * 2)); }
+        };
+        struct ModBit : ModBase {
+            static const char* name() { return "$bit"; }
+            static BSONObj update(int i) { return BSON("$bit" << BSON("n" << BSON("or" << 5))); }
+        };
+        struct ModRename : ModBase {
+            static const char* name() { return "$rename"; }
+            static BSONObj update(int i) { return BSON("$rename" << BSON("s" << "t")); }
+        };
+        struct ModCurrentDate : ModBase {
+            static const char* name() { return "$currentDate"; }
+            static BSONObj update(int i) { return BSON("$currentDate" << BSON("when" << true)); }
+        };
+        struct ModPush : ModBase {
+            static const char* name() { return "$push"; }
+            static BSONObj update(int i) { return BSON("$push" << BSON("arr" << i)); }
+        };
+        struct ModPushAll : ModBase {
+            static const char* name() { return "$pushAll"; }
+            static BSONObj update(int i) {
+                return BSON("$pushAll" << BSON("arr" << BSON_ARRAY(i << i + 1)));
+            }
+        };
+        struct ModAddToSet : ModBase {
+            static const char* name() { return "$addToSet"; }
+            static BSONObj update(int i) { return BSON("$addToSet" << BSON("arr" << i % 5)); }
+        };
+        struct ModPop : ModBase {
+            static const char* name() { return "$pop"; }
+            static BSONObj update(int i) { return BSON("$pop" << BSON("arr" << 1)); }
+        };
+        struct ModPull : ModBase {
+            static const char* name() { return "$pull"; }
+            static BSONObj update(int i) { return BSON("$pull" << BSON("arr" << 2)); }
+        };
+        struct ModPullAll : ModBase {
+            static const char* name() { return "$pullAll"; }
+            static BSONObj update(int i) {
+                return BSON("$pullAll" << BSON("arr" << BSON_ARRAY(1 << 3)));
+            }
+        };
+        /** upserts of new documents, which is the only time $setOnInsert does anything */
+        struct ModSetOnInsert : ModBase {
+            static const char* name() { return "$setOnInsert"; }
+            static int id(int i) { return NDocs + i; }
+            static bool upsert() { return true; }
+            static int expectedCount() { return 2 * NDocs; }
+            static BSONObj update(int i) {
+                return BSON("$set" << BSON("n" << i) << "$setOnInsert" << BSON("s" << "new"));
+            }
+        };
+        struct ModReplace : ModBase {
+            static const char* name() { return "replacement"; }
+            static BSONObj update(int i) { return BSON("a" << i % 1000 << "n" << i); }
+        };
+
+        /** 10 runs of an aggregation pipeline over the whole collection */
+        template< class Pipeline >
+        class Aggregate : public WorkloadTest {
+        public:
+            string name() { return string("workload-aggregate-") + Pipeline::name(); }
+            virtual unsigned opsPerCall() { return 10; }
+            void prep() { insertDocs(); }
+            void timed() {
+                const string coll = nsToCollectionSubstring(ns()).toString();
+                for( unsigned i = 0; i < opsPerCall(); i++ ) {
+                    BSONObj result;
+                    verify( client().runCommand(nsToDatabase(ns()),
+                                                BSON("aggregate" << coll <<
+                                                     "pipeline" << Pipeline::pipeline()),
+                                                result) );
+                }
+            }
+        };
+
+        struct PipelineMatch {
+            static const char* name() { return "$match"; }
+            static BSONArray pipeline() { return BSON_ARRAY(BSON("$match" << BSON("b" << 5))); }
+        };
+        struct PipelineProject {
+            static const char* name() { return "$project-$limit"; }
+            static BSONArray pipeline() {
+                return BSON_ARRAY(BSON("$project" << BSON("a" << 1 << "n" << 1)) <<
+                                  BSON("$limit" << 1));
+            }
+        };
+        struct PipelineGroup {
+            static const char* name() { return "$group"; }
+            static BSONArray pipeline() {
+                return BSON_ARRAY(BSON("$group" << BSON("_id" << "$b" <<
+                                                           "total" << BSON("$sum" << "$n"))));
+            }
+        };
+        struct PipelineSort {
+            static const char* name() { return "$sort-$skip-$limit"; }
+            static BSONArray pipeline() {
+                return BSON_ARRAY(BSON("$sort" << BSON("e" << 1)) << BSON("$skip" << 100) <<
+                                  BSON("$limit" << 10));
+            }
+        };
+        struct PipelineUnwind {
+            static const char* name() { return "$unwind-$group"; }
+            static BSONArray pipeline() {
+                return BSON_ARRAY(BSON("$unwind" << "$arr") <<
+                                  BSON("$group" << BSON("_id" << "$arr" <<
+                                                           "count" << BSON("$sum" << 1))));
+            }
+        };
+
+        class All : public Suite {
+        public:
+            All() : Suite( "workloadperf" ) { }
+
+            void setupTests() {
+                add< Insert< 0, 1 > >();
+                add< Insert< 0, 100 > >();
+                add< Insert< 1, 1 > >();
+                add< Insert< 1, 100 > >();
+                add< Insert< 4, 1 > >();
+                add< Insert< 4, 100 > >();
+                add< Insert< 8, 1 > >();
+                add< Insert< 8, 100 > >();
+                add< FindById >();
+                add< RangeQuery >();
+                add< CoveredQuery >();
+                add< Update< ModSet > >();
+                add< Update< ModSetIndexed > >();
+                add< Update< ModUnset > >();
+                add< Update< ModInc > >();
+                add< Update< ModMul > >();
+                add< Update< ModMin > >();
+                add< Update< ModMax > >();
+                add< Update< ModBit > >();
+                add< Update< ModRename > >();
+                add< Update< ModCurrentDate > >();
+                add< Update< ModPush > >();
+                add< Update< ModPushAll > >();
+                add< Update< ModAddToSet > >();
+                add< Update< ModPop > >();
+                add< Update< ModPull > >();
+                add< Update< ModPullAll > >();
+                add< Update< ModSetOnInsert > >();
+                add< Update< ModReplace > >();
+                add< Aggregate< PipelineMatch > >();
+                add< Aggregate< PipelineProject > >();
+                add< Aggregate< PipelineGroup > >();
+                add< Aggregate< PipelineSort > >();
+                add< Aggregate< PipelineUnwind > >();
+            }
+        } myall;
+
+    } // namespace WorkloadPerf
+
     class All : public Suite {
     public:
         All() : Suite( "perf" ) { }
@@ -130,12 +130,74 @@ namespace QueryMultiPlanRunner {
         }
     };
 
+    // With a limit the competition stops as soon as one plan has produced that many results.
+    // The winner still hands back what it produced while competing, and then the rest.
+    class MPRStopsOnceLimitProduced : public MultiPlanRunnerBase {
+    public:
+        void run() {
+            Client::WriteContext ctx(ns());
+
+            const int N = 5000;
+            for (int i = 0; i < N; ++i) {
+                insert(BSON("foo" << (i % 10)));
+            }
+
+            addIndex(BSON("foo" << 1));
+
+            // Plan 0: IXScan over foo == 7, a result per work().
+            IndexScanParams ixparams;
+            ixparams.descriptor = getIndex(BSON("foo" << 1));
+            ixparams.bounds.isSimpleRange = true;
+            ixparams.bounds.startKey = BSON("" << 7);
+            ixparams.bounds.endKey = BSON("" << 7);
+            ixparams.bounds.endKeyInclusive = true;
+            ixparams.direction = 1;
+            auto_ptr<WorkingSet> firstWs(new WorkingSet());
+            IndexScan* ix = new IndexScan(ixparams, firstWs.get(), NULL);
+            auto_ptr<PlanStage> firstRoot(new FetchStage(firstWs.get(), ix, NULL));
+
+            // Plan 1: CollScan with matcher, a result every 10 work()s.
+            CollectionScanParams csparams;
+            csparams.ns = ns();
+            csparams.direction = CollectionScanParams::FORWARD;
+            auto_ptr<WorkingSet> secondWs(new WorkingSet());
+            BSONObj filterObj = BSON("foo" << 7);
+            StatusWithMatchExpression swme = MatchExpressionParser::parse(filterObj);
+            verify(swme.isOK());
+            auto_ptr<MatchExpression> filter(swme.getValue());
+            auto_ptr<PlanStage> secondRoot(new CollectionScan(csparams, secondWs.get(),
+                                                              filter.get()));
+
+            CanonicalQuery* cq = NULL;
+            verify(CanonicalQuery::canonicalize(ns(), BSON("foo" << 7), 0, 5, &cq).isOK());
+            verify(NULL != cq);
+            MultiPlanRunner mpr(cq);
+            mpr.addPlan(new QuerySolution(), firstRoot.release(), firstWs.release());
+            mpr.addPlan(new QuerySolution(), secondRoot.release(), secondWs.release());
+
+            size_t best;
+            ASSERT(mpr.pickBestPlan(&best));
+            ASSERT_EQUALS(size_t(0), best);
+
+            // The runner doesn't apply the limit itself.
+            int results = 0;
+            BSONObj obj;
+            while (Runner::RUNNER_ADVANCED == mpr.getNext(&obj, NULL)) {
+                ASSERT_EQUALS(obj["foo"].numberInt(), 7);
+                ++results;
+            }
+
+            ASSERT_EQUALS(results, N / 10);
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "query_multi_plan_runner" ) { }
 
         void setupTests() {
             add<MPRCollectionScanVsHighlySelectiveIXScan>();
+            add<MPRStopsOnceLimitProduced>();
         }
     }  queryMultiPlanRunnerAll;
 
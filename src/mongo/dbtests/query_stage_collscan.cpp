@@ -26,6 +26,9 @@
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/pdfile.h"
 #include "mongo/db/query/plan_executor.h"
+#include "mongo/db/storage/extent.h"
+#include "mongo/db/storage/extent_manager.h"
+#include "mongo/db/structure/collection.h"
 #include "mongo/dbtests/dbtests.h"
 
 namespace QueryStageCollectionScan {
@@ -430,6 +433,122 @@ namespace QueryStageCollectionScan {
         }
     };
 
+    //
+    // Pull matching objects out in batches and make sure we get them all, in order.
+    //
+
+    class QueryStageCollscanWorkBatch : public QueryStageCollectionScanBase {
+    public:
+        void run() {
+            Client::ReadContext ctx(ns());
+
+            CollectionScanParams params;
+            params.ns = ns();
+            params.direction = CollectionScanParams::FORWARD;
+            params.tailable = false;
+
+            BSONObj filterObj = BSON("foo" << BSON("$lt" << 25));
+            StatusWithMatchExpression swme = MatchExpressionParser::parse(filterObj);
+            verify(swme.isOK());
+            auto_ptr<MatchExpression> filterExpr(swme.getValue());
+
+            WorkingSet ws;
+            scoped_ptr<CollectionScan> scan(new CollectionScan(params, &ws, filterExpr.get()));
+
+            int count = 0;
+            while (!scan->isEOF()) {
+                vector<WorkingSetID> ids;
+                PlanStage::StageState state = scan->workBatch(7, &ids);
+                ASSERT_NOT_EQUALS(PlanStage::NEED_FETCH, state);
+                ASSERT_LESS_THAN_OR_EQUALS(ids.size(), 7U);
+                for (size_t i = 0; i < ids.size(); ++i) {
+                    WorkingSetMember* member = ws.get(ids[i]);
+                    ASSERT_EQUALS(count, member->obj["foo"].numberInt());
+                    ws.free(ids[i]);
+                    ++count;
+                }
+            }
+
+            ASSERT_EQUALS(25, count);
+        }
+    };
+
+    //
+    // Scans bounded to disjoint ranges of extents return every object exactly once between them.
+    //
+
+    class QueryStageCollscanExtentRanges {
+    public:
+        QueryStageCollscanExtentRanges() : _context(ns()) { }
+
+        virtual ~QueryStageCollscanExtentRanges() {
+            _context.db()->dropCollection( ns() );
+        }
+
+        void run() {
+            string err;
+            ASSERT( userCreateNS( ns(), fromjson( "{size: 4096, $nExtents: 5}" ), err, false ) );
+
+            const int numObj = 100;
+            for (int i = 0; i < numObj; ++i) {
+                _client.insert(ns(), BSON("foo" << i << "pad" << string(50, 'x')));
+            }
+
+            const Collection* collection = _context.db()->getCollection( ns() );
+            const ExtentManager& em = _context.db()->getExtentManager();
+
+            vector<DiskLoc> extents;
+            for (Extent* e = em.getExtent( collection->details()->firstExtent() ); NULL != e;
+                 e = em.getNextExtent( e )) {
+                extents.push_back( e->myLoc );
+            }
+            ASSERT_GREATER_THAN( extents.size(), 1U );
+
+            // One extent at a time.
+            set<int> seen;
+            for (size_t i = 0; i < extents.size(); ++i) {
+                vector<int> foos;
+                scanRange( extents[i], extents[i], &foos );
+                for (size_t j = 0; j < foos.size(); ++j) {
+                    ASSERT( seen.insert( foos[j] ).second );
+                }
+            }
+            ASSERT_EQUALS( static_cast<size_t>(numObj), seen.size() );
+
+            // All of them at once.
+            vector<int> foos;
+            scanRange( extents.front(), extents.back(), &foos );
+            ASSERT_EQUALS( static_cast<size_t>(numObj), foos.size() );
+
+            // The extents in the middle.
+            foos.clear();
+            scanRange( extents[1], extents[extents.size() - 2], &foos );
+            ASSERT_LESS_THAN_OR_EQUALS( foos.size(), static_cast<size_t>(numObj) );
+        }
+
+        void scanRange(const DiskLoc& firstExtent, const DiskLoc& lastExtent, vector<int>* out) {
+            CollectionScanParams params;
+            params.ns = ns();
+            params.direction = CollectionScanParams::FORWARD;
+            params.firstExtent = firstExtent;
+            params.lastExtent = lastExtent;
+
+            WorkingSet* ws = new WorkingSet();
+            PlanExecutor runner(ws, new CollectionScan(params, ws, NULL));
+            for (BSONObj obj; Runner::RUNNER_ADVANCED == runner.getNext(&obj, NULL); ) {
+                out->push_back(obj["foo"].numberInt());
+            }
+        }
+
+        static const char* ns() { return "unittests.QueryStageCollscanExtentRanges"; }
+
+    private:
+        Client::Context _context;
+        static DBDirectClient _client;
+    };
+
+    DBDirectClient QueryStageCollscanExtentRanges::_client;
+
     //
     // Get objects in the reverse order we inserted them when we go backwards.
     //
@@ -604,6 +723,8 @@ namespace QueryStageCollectionScan {
             add<QueryStageCollscanBasicBackwardWithMatch>();
             add<QueryStageCollscanObjectsInOrderForward>();
             add<QueryStageCollscanObjectsInOrderBackward>();
+            add<QueryStageCollscanWorkBatch>();
+            add<QueryStageCollscanExtentRanges>();
             add<QueryStageCollscanInvalidateUpcomingObject>();
             add<QueryStageCollscanInvalidateUpcomingObjectBackward>();
         }
@@ -381,6 +381,68 @@ namespace QueryStageFetch {
         }
     };
 
+    //
+    // Test that records not in memory are read ahead when working in batches, and that the batch
+    // still comes out whole and in order.
+    //
+    class FetchStageReadAhead : public QueryStageFetchBase {
+    public:
+        void run() {
+            Client::WriteContext ctx(ns());
+            WorkingSet ws;
+
+            const int numObj = 20;
+            for (int i = 0; i < numObj; ++i) {
+                insert(BSON("foo" << i));
+            }
+            set<DiskLoc> locs;
+            getLocs(&locs);
+            ASSERT_EQUALS(size_t(numObj), locs.size());
+
+            auto_ptr<MockStage> mockStage(new MockStage(&ws));
+            for (set<DiskLoc>::const_iterator it = locs.begin(); it != locs.end(); ++it) {
+                WorkingSetMember mockMember;
+                mockMember.state = WorkingSetMember::LOC_AND_IDX;
+                mockMember.loc = *it;
+                mockStage->pushBack(mockMember);
+            }
+
+            auto_ptr<FetchStage> fetchStage(new FetchStage(&ws, mockStage.release(), NULL));
+
+            // Nothing is in memory.
+            FailPointRegistry* reg = getGlobalFailPointRegistry();
+            FailPoint* fetchInMemoryFail = reg->getFailPoint("fetchInMemoryFail");
+            fetchInMemoryFail->setMode(FailPoint::alwaysOn);
+
+            // The first record needs a page-in, and the rest have been read ahead of it.
+            vector<WorkingSetID> ids;
+            PlanStage::StageState state = fetchStage->workBatch(64, &ids);
+            ASSERT_EQUALS(PlanStage::NEED_FETCH, state);
+            ASSERT_EQUALS(size_t(1), ids.size());
+            ws.get(ids[0])->loc.rec()->touch();
+
+            scoped_ptr<PlanStageStats> stats(fetchStage->getStats());
+            const FetchStats* fetchStats = static_cast<const FetchStats*>(stats->specific.get());
+            ASSERT_EQUALS(16U, fetchStats->readAheads);
+
+            // Now everything is in memory.
+            fetchInMemoryFail->setMode(FailPoint::off);
+
+            set<DiskLoc>::const_iterator expected = locs.begin();
+            ids.clear();
+            while (!fetchStage->isEOF()) {
+                state = fetchStage->workBatch(64, &ids);
+                ASSERT_NOT_EQUALS(PlanStage::NEED_FETCH, state);
+            }
+            ASSERT_EQUALS(size_t(numObj), ids.size());
+            for (size_t i = 0; i < ids.size(); ++i, ++expected) {
+                WorkingSetMember* member = ws.get(ids[i]);
+                ASSERT_EQUALS(WorkingSetMember::LOC_AND_UNOWNED_OBJ, member->state);
+                ASSERT_EQUALS(*expected, member->loc);
+            }
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "query_stage_fetch" ) { }
@@ -391,6 +453,7 @@ namespace QueryStageFetch {
             add<FetchStageAlreadyFetched>();
             add<FetchStageInvalidation>();
             add<FetchStageFilter>();
+            add<FetchStageReadAhead>();
         }
     }  queryStageFetchAll;
 
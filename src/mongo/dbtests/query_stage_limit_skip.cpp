@@ -62,6 +62,18 @@ namespace {
         return count;
     }
 
+    int countBatchedResults(PlanStage* stage, size_t batchSize) {
+        int count = 0;
+        while (!stage->isEOF()) {
+            vector<WorkingSetID> ids;
+            PlanStage::StageState status = stage->workBatch(batchSize, &ids);
+            count += ids.size();
+            // The last id is a fetch request, not a result.
+            if (PlanStage::NEED_FETCH == status) { --count; }
+        }
+        return count;
+    }
+
     //
     // Insert 50 objects.  Filter/skip 0, 1, 2, ..., 100 objects and expect the right # of results.
     //
@@ -80,12 +92,34 @@ namespace {
         }
     };
 
+    //
+    // Same as above, but pull results out in batches of various sizes.
+    //
+    class QueryStageLimitSkipBatchTest {
+    public:
+        void run() {
+            size_t batchSizes[] = {1, 3, 7, 64};
+            for (size_t b = 0; b < sizeof(batchSizes) / sizeof(batchSizes[0]); ++b) {
+                for (int i = 0; i < 2 * N; ++i) {
+                    WorkingSet ws;
+
+                    scoped_ptr<PlanStage> skip(new SkipStage(i, &ws, getMS(&ws)));
+                    ASSERT_EQUALS(max(0, N - i), countBatchedResults(skip.get(), batchSizes[b]));
+
+                    scoped_ptr<PlanStage> limit(new LimitStage(i, &ws, getMS(&ws)));
+                    ASSERT_EQUALS(min(N, i), countBatchedResults(limit.get(), batchSizes[b]));
+                }
+            }
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "query_stage_limit_skip" ) { }
 
         void setupTests() {
             add<QueryStageLimitSkipBasicTest>();
+            add<QueryStageLimitSkipBatchTest>();
         }
     }  queryStageLimitSkipAll;
 
@@ -23,6 +23,7 @@
 #include "mongo/db/instance.h"
 #include "mongo/db/json.h"
 #include "mongo/db/query/plan_executor.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/dbtests/dbtests.h"
 
 /**
@@ -111,7 +112,7 @@ namespace QueryStageSortTests {
          * If extAllowed is true, sorting will use use external sorting if available.
          * If limit is not zero, we limit the output of the sort stage to 'limit' results.
          */
-        void sortAndCheck(int direction) {
+        void sortAndCheck(int direction, int limit = 0) {
             WorkingSet* ws = new WorkingSet();
             MockStage* ms = new MockStage(ws);
 
@@ -120,6 +121,7 @@ namespace QueryStageSortTests {
 
             SortStageParams params;
             params.pattern = BSON("foo" << direction);
+            params.limit = limit;
 
             // Must fetch so we can look at the doc as a BSONObj.
             PlanExecutor runner(ws, new FetchStage(ws, new SortStage(params, ws, ms), NULL));
@@ -129,6 +131,9 @@ namespace QueryStageSortTests {
             BSONObj last;
             ASSERT_EQUALS(Runner::RUNNER_ADVANCED, runner.getNext(&last, NULL));
 
+            // Whether or not there's a limit, the first result is the best.
+            ASSERT_EQUALS(1 == direction ? 0 : numObj() - 1, last["foo"].numberInt());
+
             // Count 'last'.
             int count = 1;
 
@@ -142,8 +147,13 @@ namespace QueryStageSortTests {
                 last = current;
             }
 
-            // No limit, should get all objects back.
-            ASSERT_EQUALS(numObj(), count);
+            // With no limit, should get all objects back.
+            ASSERT_EQUALS(0 == limit ? numObj() : std::min(limit, numObj()), count);
+        }
+
+        void setServerParameter(const char* name, const BSONObj& value) {
+            ServerParameter* param = ServerParameterSet::getGlobal()->getMap().find(name)->second;
+            ASSERT_OK(param->set(value.firstElement()));
         }
 
         virtual int numObj() = 0;
@@ -191,6 +201,64 @@ namespace QueryStageSortTests {
         }
     };
 
+    // Keep only the best few results.
+    class QueryStageSortLimit : public QueryStageSortTestBase {
+    public:
+        virtual int numObj() { return 1000; }
+
+        void run() {
+            Client::WriteContext ctx(ns());
+            fillData();
+            sortAndCheck(1, 10);
+            sortAndCheck(-1, 1);
+            sortAndCheck(1, 5000);
+        }
+    };
+
+    // Sort more than fits in the memory budget, with and without a limit.
+    class QueryStageSortSpill : public QueryStageSortTestBase {
+    public:
+        virtual int numObj() { return 2000; }
+
+        void run() {
+            Client::WriteContext ctx(ns());
+            fillData();
+            setServerParameter("internalQueryExecMaxBlockingSortBytes", BSON("" << 10 * 1024));
+            sortAndCheck(1);
+            sortAndCheck(-1, 1500);
+            setServerParameter("internalQueryExecMaxBlockingSortBytes",
+                               BSON("" << 32 * 1024 * 1024));
+        }
+    };
+
+    // Without spilling, a sort over the memory budget fails.
+    class QueryStageSortTooBig : public QueryStageSortTestBase {
+    public:
+        virtual int numObj() { return 2000; }
+
+        void run() {
+            Client::WriteContext ctx(ns());
+            fillData();
+            setServerParameter("internalQueryExecMaxBlockingSortBytes", BSON("" << 10 * 1024));
+            setServerParameter("internalQueryExecAllowExternalSort", BSON("" << false));
+
+            WorkingSet* ws = new WorkingSet();
+            MockStage* ms = new MockStage(ws);
+            insertVarietyOfObjects(ms);
+
+            SortStageParams params;
+            params.pattern = BSON("foo" << 1);
+            PlanExecutor runner(ws, new FetchStage(ws, new SortStage(params, ws, ms), NULL));
+
+            BSONObj obj;
+            ASSERT_EQUALS(Runner::RUNNER_ERROR, runner.getNext(&obj, NULL));
+
+            setServerParameter("internalQueryExecMaxBlockingSortBytes",
+                               BSON("" << 32 * 1024 * 1024));
+            setServerParameter("internalQueryExecAllowExternalSort", BSON("" << true));
+        }
+    };
+
     // Invalidation of everything fed to sort.
     class QueryStageSortInvalidation : public QueryStageSortTestBase {
     public:
@@ -268,6 +336,9 @@ namespace QueryStageSortTests {
             add<QueryStageSortInc>();
             add<QueryStageSortDec>();
             add<QueryStageSortExt>();
+            add<QueryStageSortLimit>();
+            add<QueryStageSortSpill>();
+            add<QueryStageSortTooBig>();
             add<QueryStageSortInvalidation>();
         }
     }  queryStageSortTest;
@@ -21,6 +21,7 @@
 #include "mongo/db/instance.h"
 #include "mongo/db/json.h"
 #include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/query/index_bounds_builder.h"
 #include "mongo/db/query/plan_executor.h"
 #include "mongo/db/structure/collection.h"
 #include "mongo/dbtests/dbtests.h"
@@ -58,6 +59,11 @@ namespace QueryStageTests {
             _client.ensureIndex(ns(), obj);
         }
 
+        void insert(const BSONObj& obj) {
+            Client::WriteContext ctx(ns());
+            _client.insert(ns(), obj);
+        }
+
         int countResults(const IndexScanParams& params, BSONObj filterObj = BSONObj()) {
             Client::ReadContext ctx(ns());
 
@@ -195,6 +201,46 @@ namespace QueryStageTests {
         }
     };
 
+    class QueryStageIXScanSkipPrefix : public IndexScanBase {
+    public:
+        virtual ~QueryStageIXScanSkipPrefix() { }
+
+        void run() {
+            for (int i = 0; i < 10; ++i) {
+                insert(BSON("foo" << 3 << "baz" << 100 + i));
+            }
+
+            // Every key, but only the first of each foo value.
+            IndexScanParams params;
+            params.descriptor = getIndex(BSON("foo" << 1 << "baz" << 1));
+            params.bounds.isSimpleRange = false;
+            OrderedIntervalList foo("foo");
+            foo.intervals.push_back(IndexBoundsBuilder::allValues());
+            params.bounds.fields.push_back(foo);
+            OrderedIntervalList baz("baz");
+            baz.intervals.push_back(IndexBoundsBuilder::allValues());
+            params.bounds.fields.push_back(baz);
+            params.direction = 1;
+            params.skipPrefixLen = 1;
+
+            ASSERT_EQUALS(countResults(params), numObj());
+
+            IndexScanParams backward = params;
+            backward.direction = -1;
+            for (size_t i = 0; i < backward.bounds.fields.size(); ++i) {
+                IndexBoundsBuilder::reverseInterval(&backward.bounds.fields[i].intervals[0]);
+            }
+            ASSERT_EQUALS(countResults(backward), numObj());
+
+            // A prefix is only skipped once one of its keys passes the filter.
+            ASSERT_EQUALS(countResults(params, BSON("baz" << GTE << 105)), 1);
+
+            // Without skipping, each key is returned.
+            params.skipPrefixLen = 0;
+            ASSERT_EQUALS(countResults(params, BSON("baz" << GTE << 105)), 5);
+        }
+    };
+
     class QueryStageIXScan2dSphere : public IndexScanBase {
     public:
         virtual ~QueryStageIXScan2dSphere() { }
@@ -249,6 +295,7 @@ namespace QueryStageTests {
             add<QueryStageIXScanLowerUpperIncl>();
             add<QueryStageIXScanLowerUpperInclFilter>();
             add<QueryStageIXScanCantMatch>();
+            add<QueryStageIXScanSkipPrefix>();
             add<QueryStageIXScan2dSphere>();
             add<QueryStageIXScan2d>();
         }
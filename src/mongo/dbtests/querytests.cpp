@@ -1307,6 +1307,41 @@ namespace QueryTests {
         ZeroFindingStartTimeout _zeroTimeout;
     };
     
+    /** Binary searching many extents, wrapped around, finds the same start as walking them. */
+    class FindingStartManyExtents : public CollectionBase {
+    public:
+        FindingStartManyExtents() : CollectionBase( "findingstart" ) {
+        }
+
+        void run() {
+            BSONObj info;
+            ASSERT( client().runCommand( "unittests", BSON( "create" << "querytests.findingstart" << "capped" << true << "$nExtents" << 33 << "autoIndexId" << false ), info ) );
+
+            int i = 0;
+            for( int oldCount = -1;
+                    count() != oldCount;
+                    oldCount = count(), client().insert( ns(), BSON( "ts" << i++ ) ) );
+
+            for( int k = 0; k < 3; ++k ) {
+                // wrap around by about a third of the collection each time
+                for( int n = count() / 3; n > 0; --n ) {
+                    client().insert( ns(), BSON( "ts" << i++ ) );
+                }
+                int min = client().query( ns(), Query().sort( BSON( "$natural" << 1 ) ) )->next()[ "ts" ].numberInt();
+                for( int j = -1; j < i; j += 1 + i / 200 ) {
+                    auto_ptr< DBClientCursor > c = client().query( ns(), QUERY( "ts" << GTE << j ), 0, 0, 0, QueryOption_OplogReplay );
+                    ASSERT( c->more() );
+                    BSONObj next = c->next();
+                    ASSERT( !next[ "ts" ].eoo() );
+                    ASSERT_EQUALS( ( j > min ? j : min ), next[ "ts" ].numberInt() );
+                }
+            }
+        }
+
+    private:
+        ZeroFindingStartTimeout _zeroTimeout;
+    };
+
     /**
      * Check OplogReplay mode where query timestamp is earlier than the earliest
      * entry in the collection.
@@ -1720,6 +1755,7 @@ namespace QueryTests {
             add< HelperByIdTest >();
             add< FindingStartPartiallyFull >();
             add< FindingStartStale >();
+            add< FindingStartManyExtents >();
             add< WhatsMyUri >();
             add< Exhaust >();
             add< QueryCursorTimeout >();
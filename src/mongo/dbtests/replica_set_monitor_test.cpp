@@ -584,6 +584,86 @@ namespace mongo_test {
         ASSERT(!host.empty());
     }
 
+    TEST(ReplSetMonitorReadPref, SecOnlyEquallyLoaded) {
+        vector<ReplicaSetMonitor::Node> nodes =
+                NodeSetFixtures::getThreeMemberWithTags();
+        TagSet tags(TagSetFixtures::getDefaultSet());
+        HostAndPort lastHost = nodes[0].addr;
+
+        nodes[0].latencyMicros = 1000;
+        nodes[0].inFlight = 1;
+        nodes[2].latencyMicros = 1000;
+        nodes[2].inFlight = 1;
+
+        bool isPrimarySelected = true;
+        HostAndPort host = ReplicaSetMonitor::selectNode(nodes,
+            mongo::ReadPreference_SecondaryOnly, &tags, 1, &lastHost,
+            &isPrimarySelected);
+
+        // round robin
+        ASSERT(!isPrimarySelected);
+        ASSERT_EQUALS("c", host.host());
+        ASSERT_EQUALS("c", lastHost.host());
+    }
+
+    TEST(ReplSetMonitorReadPref, SecOnlyAvoidsRequestsInFlight) {
+        vector<ReplicaSetMonitor::Node> nodes =
+                NodeSetFixtures::getThreeMemberWithTags();
+        TagSet tags(TagSetFixtures::getDefaultSet());
+        HostAndPort lastHost = nodes[0].addr;
+
+        nodes[0].latencyMicros = 1000;
+        nodes[2].latencyMicros = 1000;
+        nodes[2].inFlight = 5;
+
+        bool isPrimarySelected = true;
+        HostAndPort host = ReplicaSetMonitor::selectNode(nodes,
+            mongo::ReadPreference_SecondaryOnly, &tags, 1, &lastHost,
+            &isPrimarySelected);
+
+        ASSERT(!isPrimarySelected);
+        ASSERT_EQUALS("a", host.host());
+        ASSERT_EQUALS("a", lastHost.host());
+    }
+
+    TEST(ReplSetMonitorReadPref, SecPrefAvoidsSlowNode) {
+        vector<ReplicaSetMonitor::Node> nodes =
+                NodeSetFixtures::getThreeMemberWithTags();
+        TagSet tags(TagSetFixtures::getDefaultSet());
+        HostAndPort lastHost = nodes[0].addr;
+
+        nodes[0].latencyMicros = 1000;
+        nodes[2].latencyMicros = 50000;
+
+        bool isPrimarySelected = true;
+        HostAndPort host = ReplicaSetMonitor::selectNode(nodes,
+            mongo::ReadPreference_SecondaryPreferred, &tags, 1, &lastHost,
+            &isPrimarySelected);
+
+        ASSERT(!isPrimarySelected);
+        ASSERT_EQUALS("a", host.host());
+    }
+
+    TEST(ReplSetMonitorReadPref, SecOnlyLoadedNodeNotLocal) {
+        vector<ReplicaSetMonitor::Node> nodes =
+                NodeSetFixtures::getThreeMemberWithTags();
+        TagSet tags(TagSetFixtures::getDefaultSet());
+        HostAndPort lastHost = nodes[2].addr;
+
+        // only local nodes are compared
+        nodes[0].latencyMicros = 1000;
+        nodes[0].inFlight = 10;
+        nodes[2].pingTimeMillis = 10;
+
+        bool isPrimarySelected = true;
+        HostAndPort host = ReplicaSetMonitor::selectNode(nodes,
+            mongo::ReadPreference_SecondaryOnly, &tags, 3, &lastHost,
+            &isPrimarySelected);
+
+        ASSERT(!isPrimarySelected);
+        ASSERT_EQUALS("a", host.host());
+    }
+
     TEST(ReplSetMonitorReadPref, PriOnlyWithTagsNoMatch) {
         vector<ReplicaSetMonitor::Node> nodes =
                 NodeSetFixtures::getThreeMemberWithTags();
@@ -1130,6 +1130,150 @@ namespace ReplSetTests {
         }
     };
 
+    class WriterVectorsTail : public replset::SyncTail {
+    public:
+        WriterVectorsTail() : replset::SyncTail(NULL) {}
+        void fill(const std::deque<BSONObj>& ops, std::vector< std::vector<BSONObj> >* vectors) {
+            fillWriterVectors(ops, vectors);
+        }
+    };
+
+    class TestFillWriterVectors : public Base {
+        static BSONObj op(const string& type, const BSONObj& o, const BSONObj& o2 = BSONObj()) {
+            BSONObjBuilder b;
+            b.append("op", type);
+            b.append("ns", ns());
+            b.append("o", o);
+            if (!o2.isEmpty())
+                b.append("o2", o2);
+            return b.obj();
+        }
+
+        static int writerOf(const std::vector< std::vector<BSONObj> >& vectors,
+                            const BSONObj& o) {
+            for (size_t i = 0; i < vectors.size(); i++) {
+                for (size_t j = 0; j < vectors[i].size(); j++) {
+                    if (vectors[i][j].woCompare(o) == 0)
+                        return i;
+                }
+            }
+            return -1;
+        }
+
+        static int writersUsed(const std::vector< std::vector<BSONObj> >& vectors) {
+            int n = 0;
+            for (size_t i = 0; i < vectors.size(); i++) {
+                if (!vectors[i].empty())
+                    n++;
+            }
+            return n;
+        }
+
+    public:
+        void run() {
+            drop();
+            WriterVectorsTail tail;
+
+            // One collection is spread over the writers by document, each document's ops in
+            // order on one writer.
+            std::deque<BSONObj> ops;
+            for (int i = 0; i < 100; i++)
+                ops.push_back(op("i", BSON("_id" << i)));
+            for (int i = 0; i < 100; i++)
+                ops.push_back(op("u", BSON("$set" << BSON("x" << i)), BSON("_id" << i)));
+            ops.push_back(op("d", BSON("_id" << 7)));
+            std::vector< std::vector<BSONObj> > vectors(8);
+            tail.fill(ops, &vectors);
+            ASSERT(writersUsed(vectors) > 1);
+            for (int i = 0; i < 100; i++) {
+                BSONObj insert = op("i", BSON("_id" << i));
+                BSONObj update = op("u", BSON("$set" << BSON("x" << i)), BSON("_id" << i));
+                int writer = writerOf(vectors, insert);
+                ASSERT_EQUALS(writer, writerOf(vectors, update));
+                const std::vector<BSONObj>& v = vectors[writer];
+                size_t insertAt = 0, updateAt = 0;
+                for (size_t j = 0; j < v.size(); j++) {
+                    if (v[j].woCompare(insert) == 0)
+                        insertAt = j;
+                    if (v[j].woCompare(update) == 0)
+                        updateAt = j;
+                }
+                ASSERT(insertAt < updateAt);
+            }
+            ASSERT_EQUALS(vectors[writerOf(vectors, op("d", BSON("_id" << 7)))].back(),
+                          op("d", BSON("_id" << 7)));
+
+            // _ids that compare equal go together whatever their numeric type.
+            ops.clear();
+            ops.push_back(op("i", BSON("_id" << 5)));
+            ops.push_back(op("u", BSON("$set" << BSON("x" << 1)), BSON("_id" << 5.0)));
+            ops.push_back(op("d", BSON("_id" << 5LL)));
+            ops.push_back(op("i", BSON("_id" << 6)));
+            vectors.assign(8, std::vector<BSONObj>());
+            tail.fill(ops, &vectors);
+            int writer = writerOf(vectors, ops[0]);
+            ASSERT_EQUALS(writer, writerOf(vectors, ops[1]));
+            ASSERT_EQUALS(writer, writerOf(vectors, ops[2]));
+
+            // An op that doesn't name its document keeps the collection on one writer.
+            ops.clear();
+            for (int i = 0; i < 50; i++)
+                ops.push_back(op("i", BSON("_id" << i)));
+            ops.push_back(op("d", BSON("x" << 1)));
+            vectors.assign(8, std::vector<BSONObj>());
+            tail.fill(ops, &vectors);
+            ASSERT_EQUALS(1, writersUsed(vectors));
+            ASSERT_EQUALS(op("d", BSON("x" << 1)), vectors[writerOf(vectors, ops.back())].back());
+
+            // As does a unique index, which documents could transiently collide on.
+            client()->ensureIndex(ns(), BSON("x" << 1), true);
+            ops.pop_back();
+            vectors.assign(8, std::vector<BSONObj>());
+            tail.fill(ops, &vectors);
+            ASSERT_EQUALS(1, writersUsed(vectors));
+
+            drop();
+        }
+    };
+
+    class TestSyncApplyInserts : public Base {
+        static BSONObj op(const string& type, const BSONObj& o, const BSONObj& o2 = BSONObj()) {
+            BSONObjBuilder b;
+            b.append("op", type);
+            b.append("ns", ns());
+            b.append("o", o);
+            if (!o2.isEmpty())
+                b.append("o2", o2);
+            return b.obj();
+        }
+
+    public:
+        void run() {
+            drop();
+            client()->ensureIndex(ns(), BSON("x" << 1));
+            // Already applied before a restart, so replayed below.
+            insert(BSON("_id" << 3 << "x" << -1));
+
+            std::vector<BSONObj> ops;
+            for (int i = 0; i < 100; i++)
+                ops.push_back(op("i", BSON("_id" << i << "x" << i)));
+            ops.push_back(op("u", BSON("$set" << BSON("x" << 1000)), BSON("_id" << 99)));
+            ops.push_back(op("i", BSON("_id" << 100 << "x" << 100)));
+            replset::multiSyncApply(ops, _tailer);
+
+            ASSERT_EQUALS(101U, client()->count(ns()));
+            ASSERT_EQUALS(3, findOne(BSON("_id" << 3))["x"].numberInt());
+            ASSERT_EQUALS(1000, findOne(BSON("_id" << 99))["x"].numberInt());
+            // Every key held back by the batch made it into the index.
+            Query byX = Query(BSON("x" << GTE << 0)).hint(BSON("x" << 1));
+            ASSERT_EQUALS(101, client()->query(ns(), byX)->itcount());
+            ASSERT_EQUALS(0, client()->query(ns(), Query(BSON("x" << -1)).hint(BSON("x" << 1)))
+                             ->itcount());
+
+            drop();
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "replset" ) {
@@ -1143,6 +1287,8 @@ namespace ReplSetTests {
             add< CappedUpdate >();
             add< CappedInsert >();
             add< TestRSSync >();
+            add< TestFillWriterVectors >();
+            add< TestSyncApplyInserts >();
             add< TestDropDB >();
             add< TestDrop >();
             add< TestDropIndexes >();
@@ -31,6 +31,7 @@
 #include "mongo/util/concurrency/list.h"
 #include "mongo/util/timer.h"
 #include "mongo/util/concurrency/synchronization.h"
+#include "mongo/util/concurrency/priority_gate.h"
 #include "mongo/util/concurrency/qlock.h"
 #include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/server.h"
@@ -895,6 +896,44 @@ namespace ThreadedTests {
         }
     };
 
+    // lower classes hold off while a higher class's request is pending, for up to their max wait
+    class PriorityGateTest : public ThreadedTest<4> {
+    private:
+        PriorityGate g;
+        virtual void validate() {
+            for( int i = 0; i < PriorityGate::NumClasses; i++ )
+                ASSERT_EQUALS( 0U, g.pending(i) );
+        }
+        virtual void subthread(int x) {
+            if( x == 1 ) {
+                // the highest class never waits
+                ASSERT( g.arrive(2, 0) );
+                sleepmillis(300);
+                g.leave(2);
+            }
+            if( x == 2 ) {
+                sleepmillis(100);
+                Timer t;
+                ASSERT( g.arrive(1, 5000) );
+                ASSERT( t.millis() > 100 );
+                g.leave(1);
+            }
+            if( x == 3 ) {
+                sleepmillis(100);
+                Timer t;
+                ASSERT( !g.arrive(0, 50) );
+                ASSERT( t.millis() >= 50 );
+                ASSERT( t.millis() < 250 );
+                g.leave(0);
+            }
+            if( x == 4 ) {
+                sleepmillis(400);
+                ASSERT( g.arrive(0, 0) );
+                g.leave(0);
+            }
+        }
+    };
+
     // Tests waiting on the TicketHolder by running many more threads than can fit into the "hotel", but only
     // max _nRooms threads should ever get in at once
     class TicketHolderWaits : public ThreadedTest<10> {
@@ -977,6 +1016,7 @@ namespace ThreadedTests {
             add< WriteLocksAreGreedy >();
             add< QLockTest >();
             add< QLockTest >();
+            add< PriorityGateTest >();
 
             // Slack is a test to see how long it takes for another thread to pick up
             // and begin work after another relinquishes the lock.  e.g. a spin lock 
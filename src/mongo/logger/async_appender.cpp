@@ -0,0 +1,182 @@
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/logger/async_appender.h"
+
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+namespace logger {
+
+namespace {
+
+    unsigned long long roundUpToPowerOfTwo(size_t capacity) {
+        unsigned long long result = 2;
+        while (result < capacity)
+            result <<= 1;
+        return result;
+    }
+
+}  // namespace
+
+    AsyncAppender::AsyncAppender(EventAppender* target, size_t capacity) :
+        _target(target),
+        _mask(roundUpToPowerOfTwo(capacity) - 1),
+        _slots(new Slot[_mask + 1]),
+        _droppedReported(0) {
+
+        for (unsigned long long i = 0; i <= _mask; ++i)
+            _slots[i].sequence.store(i);
+
+        _thread.reset(new boost::thread(boost::bind(&AsyncAppender::run, this)));
+    }
+
+    AsyncAppender::~AsyncAppender() {
+        _shutdown.store(1);
+        _wakeWriter.notify_one();
+        _thread->join();
+    }
+
+    Status AsyncAppender::append(const MessageEventEphemeral& event) {
+        const bool severe = event.getSeverity() >= LogSeverity::Severe();
+
+        // Claim the slot at the end of the ring, unless the event from a lap ago is still
+        // waiting to be written there.
+        unsigned long long pos = _enqueuePos.load();
+        Slot* slot;
+        while (true) {
+            slot = &_slots[pos & _mask];
+            const unsigned long long sequence = slot->sequence.load();
+            if (sequence == pos) {
+                const unsigned long long claimed = _enqueuePos.compareAndSwap(pos, pos + 1);
+                if (claimed == pos)
+                    break;
+                pos = claimed;
+            }
+            else if (sequence < pos) {
+                if (!severe) {
+                    _dropped.fetchAndAdd(1);
+                    return Status(ErrorCodes::LogWriteFailed, "log queue is full");
+                }
+                waitWritten(pos - _mask);
+                pos = _enqueuePos.load();
+            }
+            else {
+                pos = _enqueuePos.load();
+            }
+        }
+
+        slot->date = event.getDate();
+        slot->severity = event.getSeverity();
+        slot->contextName.assign(event.getContextName().rawData(),
+                                 event.getContextName().size());
+        slot->message.assign(event.getMessage().rawData(), event.getMessage().size());
+        slot->sequence.store(pos + 1);
+
+        if (_idle.load() && _idle.swap(0))
+            _wakeWriter.notify_one();
+
+        if (severe)
+            waitWritten(pos + 1);
+
+        return Status::OK();
+    }
+
+    void AsyncAppender::flush() {
+        waitWritten(_enqueuePos.load());
+    }
+
+    void AsyncAppender::run() {
+        setThreadName("logAppender");
+
+        while (true) {
+            bool wrote = false;
+            while (writeNext())
+                wrote = true;
+
+            if (wrote) {
+                reportDropped();
+                _written.notify_all();
+                continue;
+            }
+
+            if (_shutdown.load())
+                break;
+
+            // Appending threads only wake us up once they see _idle set, so look at the ring
+            // again after setting it. An event that still slips past waits out the timeout.
+            boost::unique_lock<boost::mutex> lk(_mutex);
+            _idle.store(1);
+            if (!hasNext())
+                _wakeWriter.timed_wait(lk, boost::posix_time::milliseconds(100));
+            _idle.store(0);
+        }
+
+        reportDropped();
+    }
+
+    bool AsyncAppender::hasNext() const {
+        const unsigned long long pos = _dequeuePos.load();
+        return _slots[pos & _mask].sequence.load() == pos + 1;
+    }
+
+    bool AsyncAppender::writeNext() {
+        if (!hasNext())
+            return false;
+
+        const unsigned long long pos = _dequeuePos.load();
+        Slot& slot = _slots[pos & _mask];
+
+        _target->append(MessageEventEphemeral(slot.date,
+                                              slot.severity,
+                                              slot.contextName,
+                                              slot.message));
+        slot.sequence.store(pos + _mask + 1);
+        _dequeuePos.store(pos + 1);
+        return true;
+    }
+
+    void AsyncAppender::reportDropped() {
+        const unsigned long long dropped = _dropped.load();
+        if (dropped == _droppedReported)
+            return;
+
+        const std::string message = mongoutils::str::stream() <<
+            "dropped " << (dropped - _droppedReported) <<
+            " log messages because the log queue was full";
+        _droppedReported = dropped;
+        _target->append(MessageEventEphemeral(curTimeMillis64(),
+                                              LogSeverity::Warning(),
+                                              "logAppender",
+                                              message));
+    }
+
+    void AsyncAppender::waitWritten(unsigned long long position) {
+        boost::unique_lock<boost::mutex> lk(_mutex);
+        while (_dequeuePos.load() < position) {
+            _wakeWriter.notify_one();
+            _written.timed_wait(lk, boost::posix_time::milliseconds(10));
+        }
+    }
+
+}  // namespace logger
+}  // namespace mongo
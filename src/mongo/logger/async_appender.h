@@ -0,0 +1,136 @@
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <boost/scoped_array.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <string>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/status.h"
+#include "mongo/logger/appender.h"
+#include "mongo/logger/log_severity.h"
+#include "mongo/logger/message_event.h"
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+namespace logger {
+
+    /**
+     * Appender that hands events to another appender on a thread of its own, so that threads
+     * logging never wait on a slow file or syslog.
+     *
+     * Events are copied into a fixed ring of slots that appending threads claim without taking
+     * a lock.  When the ring is full, an event is dropped and counted, and the background
+     * thread reports the count through the wrapped appender once it catches up.  Severe()
+     * events are never dropped, and their append does not return until they are written, as
+     * they are often the last words before the process exits.
+     */
+    class AsyncAppender : public Appender<MessageEventEphemeral> {
+        MONGO_DISALLOW_COPYING(AsyncAppender);
+
+    public:
+        typedef Appender<MessageEventEphemeral> EventAppender;
+
+        /**
+         * Constructs an appender that owns "target" and holds up to "capacity" events,
+         * rounded up to a power of two, not yet written to it.
+         */
+        AsyncAppender(EventAppender* target, size_t capacity);
+
+        /**
+         * Writes the events still queued and stops the background thread.  No other thread
+         * may be appending.
+         */
+        virtual ~AsyncAppender();
+
+        virtual Status append(const MessageEventEphemeral& event);
+
+        /**
+         * Waits until every event appended before the call has been written.
+         */
+        void flush();
+
+        /**
+         * Returns how many events were dropped because the ring was full.
+         */
+        unsigned long long getDroppedCount() const { return _dropped.load(); }
+
+    private:
+        struct Slot {
+            Slot() : date(0), severity(LogSeverity::Log()) {}
+
+            // Position of the event in the slot plus one once it is ready to be written, or
+            // the position the next event in the slot may take once it's free.
+            AtomicUInt64 sequence;
+
+            unsigned long long date;
+            LogSeverity severity;
+            std::string contextName;
+            std::string message;
+        };
+
+        void run();
+
+        /**
+         * Returns true if the next event to write is ready.
+         */
+        bool hasNext() const;
+
+        /**
+         * Writes the next event to the target, if there is one ready.  Returns false if not.
+         */
+        bool writeNext();
+
+        /**
+         * Writes a message with the number of events dropped since the last one, if any.
+         */
+        void reportDropped();
+
+        /**
+         * Waits until the events before "position" have been written.
+         */
+        void waitWritten(unsigned long long position);
+
+        boost::scoped_ptr<EventAppender> _target;
+        const unsigned long long _mask;
+        boost::scoped_array<Slot> _slots;
+
+        // Position of the next event to append.
+        AtomicUInt64 _enqueuePos;
+
+        // Position of the next event to write.  Only the background thread changes it.
+        AtomicUInt64 _dequeuePos;
+
+        AtomicUInt64 _dropped;
+        unsigned long long _droppedReported;
+
+        // Set while the background thread is waiting for events, so that an appending
+        // thread knows to wake it up.
+        AtomicUInt32 _idle;
+        AtomicUInt32 _shutdown;
+
+        boost::mutex _mutex;
+        boost::condition_variable _wakeWriter;
+        boost::condition_variable _written;
+        boost::scoped_ptr<boost::thread> _thread;
+    };
+
+}  // namespace logger
+}  // namespace mongo
@@ -20,6 +20,7 @@
 #include <vector>
 
 #include "mongo/logger/appender.h"
+#include "mongo/logger/async_appender.h"
 #include "mongo/logger/encoder.h"
 #include "mongo/logger/message_event_utf8_encoder.h"
 #include "mongo/logger/message_log_domain.h"
@@ -29,6 +30,7 @@
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/concurrency/thread_name.h"
 #include "mongo/util/log.h"
+#include "mongo/util/time_support.h"
 
 using namespace mongo::logger;
 
@@ -118,6 +120,80 @@ namespace {
         ASSERT_EQUALS(1, dynamic_cast<CountAppender*>(countAppender.get())->getCount());
     }
 
+    // Keeps the messages appended to it, and holds up the thread appending while "gate" is
+    // locked.
+    class GatedAppender : public Appender<MessageEventEphemeral> {
+    public:
+        GatedAppender(boost::mutex* gate, std::vector<std::string>* messages) :
+            _gate(gate), _messages(messages) {}
+
+        virtual Status append(const MessageEventEphemeral& event) {
+            entered.store(1);
+            boost::lock_guard<boost::mutex> lk(*_gate);
+            _messages->push_back(event.getMessage().toString());
+            return Status::OK();
+        }
+
+        static AtomicUInt32 entered;
+
+    private:
+        boost::mutex* _gate;
+        std::vector<std::string>* _messages;
+    };
+
+    AtomicUInt32 GatedAppender::entered;
+
+    TEST(AsyncAppender, WritesEventsInOrder) {
+        boost::mutex gate;
+        std::vector<std::string> messages;
+        AsyncAppender appender(new GatedAppender(&gate, &messages), 16);
+
+        for (int i = 0; i < 1000; ++i) {
+            std::string message = mongoutils::str::stream() << i;
+            appender.append(MessageEventEphemeral(0ULL, LogSeverity::Log(), "", message));
+            if (i % 10 == 0)
+                appender.flush();
+        }
+        appender.flush();
+
+        ASSERT_EQUALS(0U, appender.getDroppedCount());
+        ASSERT_EQUALS(1000U, messages.size());
+        for (int i = 0; i < 1000; ++i)
+            ASSERT_EQUALS(std::string(mongoutils::str::stream() << i), messages[i]);
+    }
+
+    TEST(AsyncAppender, DropsEventsWhenFull) {
+        boost::mutex gate;
+        std::vector<std::string> messages;
+        {
+            boost::unique_lock<boost::mutex> lk(gate);
+            AsyncAppender appender(new GatedAppender(&gate, &messages), 4);
+
+            // The first event holds up the background thread, and keeps its slot until
+            // written, leaving room in the ring for three more.
+            GatedAppender::entered.store(0);
+            ASSERT_OK(appender.append(MessageEventEphemeral(0ULL, LogSeverity::Log(), "", "0")));
+            while (!GatedAppender::entered.load())
+                sleepmillis(1);
+
+            ASSERT_OK(appender.append(MessageEventEphemeral(0ULL, LogSeverity::Log(), "", "1")));
+            ASSERT_OK(appender.append(MessageEventEphemeral(0ULL, LogSeverity::Log(), "", "2")));
+            ASSERT_OK(appender.append(MessageEventEphemeral(0ULL, LogSeverity::Log(), "", "3")));
+            ASSERT_NOT_OK(appender.append(
+                    MessageEventEphemeral(0ULL, LogSeverity::Log(), "", "4")));
+            ASSERT_NOT_OK(appender.append(
+                    MessageEventEphemeral(0ULL, LogSeverity::Log(), "", "5")));
+            ASSERT_EQUALS(2U, appender.getDroppedCount());
+
+            lk.unlock();
+        }
+
+        // The queued events, then the count of the dropped ones.
+        ASSERT_EQUALS(5U, messages.size());
+        ASSERT_EQUALS("3", messages[3]);
+        ASSERT_NOT_EQUALS(messages[4].find("dropped 2 "), std::string::npos);
+    }
+
     class A {
     public:
         std::string toString() const {
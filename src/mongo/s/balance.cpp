@@ -30,9 +30,12 @@
 
 #include "mongo/s/balance.h"
 
+#include <boost/thread/thread.hpp>
+
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/client/distlock.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/namespace_string.h"
 #include "mongo/s/chunk.h"
 #include "mongo/s/config.h"
 #include "mongo/s/config_server_checker_service.h"
@@ -55,80 +58,127 @@ namespace mongo {
     Balancer::~Balancer() {
     }
 
-    int Balancer::_moveChunks(const vector<CandidateChunkPtr>* candidateChunks,
+    bool Balancer::_moveChunk(const CandidateChunk& chunkInfo,
                               bool secondaryThrottle,
                               bool waitForDelete)
     {
-        int movedCount = 0;
+        // Changes to metadata, borked metadata, and connectivity problems should cause us to
+        // abort this chunk move, but shouldn't cause us to abort the entire round of chunks.
+        // TODO: Handle all these things more cleanly, since they're expected problems
+        try {
 
-        for ( vector<CandidateChunkPtr>::const_iterator it = candidateChunks->begin(); it != candidateChunks->end(); ++it ) {
-            const CandidateChunk& chunkInfo = *it->get();
+            DBConfigPtr cfg = grid.getDBConfig( chunkInfo.ns );
+            verify( cfg );
 
-            // Changes to metadata, borked metadata, and connectivity problems should cause us to
-            // abort this chunk move, but shouldn't cause us to abort the entire round of chunks.
-            // TODO: Handle all these things more cleanly, since they're expected problems
-            try {
+            // NOTE: We purposely do not reload metadata here, since _doBalanceRound already
+            // tried to do so once.
+            ChunkManagerPtr cm = cfg->getChunkManager( chunkInfo.ns );
+            verify( cm );
 
-                DBConfigPtr cfg = grid.getDBConfig( chunkInfo.ns );
-                verify( cfg );
-
-                // NOTE: We purposely do not reload metadata here, since _doBalanceRound already
-                // tried to do so once.
-                ChunkManagerPtr cm = cfg->getChunkManager( chunkInfo.ns );
+            ChunkPtr c = cm->findIntersectingChunk( chunkInfo.chunk.min );
+            if ( c->getMin().woCompare( chunkInfo.chunk.min ) || c->getMax().woCompare( chunkInfo.chunk.max ) ) {
+                // likely a split happened somewhere
+                cm = cfg->getChunkManager( chunkInfo.ns , true /* reload */);
                 verify( cm );
 
-                ChunkPtr c = cm->findIntersectingChunk( chunkInfo.chunk.min );
+                c = cm->findIntersectingChunk( chunkInfo.chunk.min );
                 if ( c->getMin().woCompare( chunkInfo.chunk.min ) || c->getMax().woCompare( chunkInfo.chunk.max ) ) {
-                    // likely a split happened somewhere
-                    cm = cfg->getChunkManager( chunkInfo.ns , true /* reload */);
-                    verify( cm );
-
-                    c = cm->findIntersectingChunk( chunkInfo.chunk.min );
-                    if ( c->getMin().woCompare( chunkInfo.chunk.min ) || c->getMax().woCompare( chunkInfo.chunk.max ) ) {
-                        log() << "chunk mismatch after reload, ignoring will retry issue " << chunkInfo.chunk.toString() << endl;
-                        continue;
-                    }
-                }
-
-                BSONObj res;
-                if (c->moveAndCommit(Shard::make(chunkInfo.to),
-                                     Chunk::MaxChunkSize,
-                                     secondaryThrottle,
-                                     waitForDelete,
-                                     res)) {
-                    movedCount++;
-                    continue;
+                    log() << "chunk mismatch after reload, ignoring will retry issue " << chunkInfo.chunk.toString() << endl;
+                    return false;
                 }
+            }
 
-                // the move requires acquiring the collection metadata's lock, which can fail
-                log() << "balancer move failed: " << res << " from: " << chunkInfo.from << " to: " << chunkInfo.to
-                      << " chunk: " << chunkInfo.chunk << endl;
+            BSONObj res;
+            if (c->moveAndCommit(Shard::make(chunkInfo.to),
+                                 Chunk::MaxChunkSize,
+                                 secondaryThrottle,
+                                 waitForDelete,
+                                 res)) {
+                return true;
+            }
 
-                if ( res["chunkTooBig"].trueValue() ) {
-                    // reload just to be safe
-                    cm = cfg->getChunkManager( chunkInfo.ns );
-                    verify( cm );
-                    c = cm->findIntersectingChunk( chunkInfo.chunk.min );
+            // the move requires acquiring the collection metadata's lock, which can fail
+            log() << "balancer move failed: " << res << " from: " << chunkInfo.from << " to: " << chunkInfo.to
+                  << " chunk: " << chunkInfo.chunk << endl;
 
-                    log() << "forcing a split because migrate failed for size reasons" << endl;
+            if ( res["chunkTooBig"].trueValue() ) {
+                // reload just to be safe
+                cm = cfg->getChunkManager( chunkInfo.ns );
+                verify( cm );
+                c = cm->findIntersectingChunk( chunkInfo.chunk.min );
 
-                    res = BSONObj();
-                    c->singleSplit( true , res );
-                    log() << "forced split results: " << res << endl;
+                log() << "forcing a split because migrate failed for size reasons" << endl;
 
-                    if ( ! res["ok"].trueValue() ) {
-                        log() << "marking chunk as jumbo: " << c->toString() << endl;
-                        c->markAsJumbo();
-                        // we increment moveCount so we do another round right away
-                        movedCount++;
-                    }
+                res = BSONObj();
+                c->singleSplit( true , res );
+                log() << "forced split results: " << res << endl;
 
+                if ( ! res["ok"].trueValue() ) {
+                    log() << "marking chunk as jumbo: " << c->toString() << endl;
+                    c->markAsJumbo();
+                    // we count it as moved so we do another round right away
+                    return true;
                 }
+
+            }
+        }
+        catch( const DBException& ex ) {
+            warning() << "could not move chunk " << chunkInfo.chunk.toString()
+                      << ", continuing balancing round" << causedBy( ex ) << endl;
+        }
+        return false;
+    }
+
+    void Balancer::_moveChunkInThread(const CandidateChunk* chunkInfo,
+                                      bool secondaryThrottle,
+                                      bool waitForDelete,
+                                      AtomicUInt32* movedCount)
+    {
+        setThreadName( "BalancerMigrate" );
+        try {
+            if ( _moveChunk( *chunkInfo, secondaryThrottle, waitForDelete ) )
+                movedCount->addAndFetch( 1 );
+        }
+        catch ( std::exception& e ) {
+            warning() << "could not move chunk " << chunkInfo->chunk.toString()
+                      << ", continuing balancing round" << causedBy( e ) << endl;
+        }
+    }
+
+    int Balancer::_moveChunks(const vector<CandidateChunkPtr>* candidateChunks,
+                              int maxConcurrentMigrations,
+                              bool secondaryThrottle,
+                              bool waitForDelete)
+    {
+        vector<const CandidateChunk*> migrations;
+        for ( vector<CandidateChunkPtr>::const_iterator it = candidateChunks->begin(); it != candidateChunks->end(); ++it ) {
+            migrations.push_back( it->get() );
+        }
+
+        vector< vector<const CandidateChunk*> > waves;
+        BalancerPolicy::scheduleMigrations( migrations, maxConcurrentMigrations, &waves );
+
+        int movedCount = 0;
+        for ( unsigned w = 0; w < waves.size(); w++ ) {
+            const vector<const CandidateChunk*>& wave = waves[w];
+            if ( wave.size() == 1 ) {
+                if ( _moveChunk( *wave[0], secondaryThrottle, waitForDelete ) )
+                    movedCount++;
+                continue;
             }
-            catch( const DBException& ex ) {
-                warning() << "could not move chunk " << chunkInfo.chunk.toString()
-                          << ", continuing balancing round" << causedBy( ex ) << endl;
+
+            // the migrations of a wave involve distinct shards, so they run side by side; the
+            // wave ends when its slowest migration does
+            LOG(1) << "running " << wave.size() << " migrations at once" << endl;
+            AtomicUInt32 waveMoved;
+            boost::thread_group threads;
+            for ( unsigned i = 0; i < wave.size(); i++ ) {
+                threads.create_thread( boost::bind( &Balancer::_moveChunkInThread, this, wave[i],
+                                                    secondaryThrottle, waitForDelete,
+                                                    &waveMoved ) );
             }
+            threads.join_all();
+            movedCount += waveMoved.load();
         }
 
         return movedCount;
@@ -200,7 +250,88 @@ namespace mongo {
         }        
     }
 
-    void Balancer::_doBalanceRound( DBClientBase& conn, vector<CandidateChunkPtr>* candidateChunks ) {
+    bool Balancer::_getShardLoad( const string& ns,
+                                  const vector<Shard>& allShards,
+                                  const map<string,BSONObj>& opTotals,
+                                  const ShardToChunksMap& shardToChunksMap,
+                                  ShardLoadMap* shardLoad ) {
+        NamespaceString nss( ns );
+        long long now = curTimeMillis64();
+
+        for ( vector<Shard>::const_iterator it = allShards.begin(); it != allShards.end(); ++it ) {
+            const Shard& s = *it;
+
+            ShardToChunksMap::const_iterator chunks = shardToChunksMap.find( s.getName() );
+            if ( chunks == shardToChunksMap.end() || chunks->second.empty() ) {
+                (*shardLoad)[s.getName()] = ShardLoad();
+                continue;
+            }
+
+            long long dataSize;
+            try {
+                BSONObj res = s.runCommand( nss.db().toString(),
+                                            BSON( "dataSize" << ns << "estimate" << true ) );
+                dataSize = res["size"].numberLong();
+            }
+            catch ( const DBException& e ) {
+                warning() << "could not get the data size of " << ns << " on " << s.getName()
+                          << causedBy( e ) << endl;
+                return false;
+            }
+
+            double opsPerSec = 0;
+            map<string,BSONObj>::const_iterator totals = opTotals.find( s.getName() );
+            if ( totals != opTotals.end() ) {
+                // the namespace is the field name, dots and all
+                long long count =
+                    totals->second.getObjectField( ns ).getObjectField( "total" )["count"].numberLong();
+
+                pair<string,string> key( s.getName(), ns );
+                OpCountMap::const_iterator last = _lastOpCounts.find( key );
+                if ( last != _lastOpCounts.end() && count >= last->second.first &&
+                     now > last->second.second ) {
+                    opsPerSec = ( count - last->second.first ) * 1000.0 /
+                                ( now - last->second.second );
+                }
+                _lastOpCounts[key] = make_pair( count, now );
+            }
+
+            (*shardLoad)[s.getName()] = ShardLoad( dataSize, opsPerSec );
+        }
+
+        return true;
+    }
+
+    void Balancer::_estimateChunkSizes( const string& ns,
+                                        const BSONObj& keyPattern,
+                                        const Shard& shard,
+                                        const vector<BSONObj>& chunks,
+                                        ChunkSizeMap* chunkSizes ) {
+        const unsigned maxEstimates = 16;
+        const unsigned step = std::max( 1U, static_cast<unsigned>( chunks.size() ) / maxEstimates );
+        NamespaceString nss( ns );
+
+        for ( unsigned j = 0; j < chunks.size(); j += step ) {
+            BSONObj min = chunks[j][ChunkType::min()].Obj();
+            try {
+                BSONObj res = shard.runCommand( nss.db().toString(),
+                                                BSON( "dataSize" << ns <<
+                                                      "keyPattern" << keyPattern <<
+                                                      "min" << min <<
+                                                      "max" << chunks[j][ChunkType::max()].Obj() <<
+                                                      "estimate" << true ) );
+                (*chunkSizes)[min] = res["size"].numberLong();
+            }
+            catch ( const DBException& e ) {
+                LOG(1) << "could not estimate the size of chunk " << chunks[j] << causedBy( e )
+                       << endl;
+            }
+        }
+    }
+
+    void Balancer::_doBalanceRound( DBClientBase& conn,
+                                    vector<CandidateChunkPtr>* candidateChunks,
+                                    bool balanceByLoad ) {
         verify( candidateChunks );
 
         //
@@ -261,6 +392,21 @@ namespace mongo {
 
         OCCASIONALLY warnOnMultiVersion( shardInfo );
 
+        // Each shard's operation counts by collection, for balancing by load
+        map<string,BSONObj> opTotals;
+        if ( balanceByLoad ) {
+            for ( vector<Shard>::const_iterator it = allShards.begin(); it != allShards.end(); ++it ) {
+                try {
+                    opTotals[it->getName()] =
+                        it->runCommand( "admin", "top" )["totals"].Obj().getOwned();
+                }
+                catch ( const DBException& e ) {
+                    warning() << "could not get operation counts of " << it->getName()
+                              << causedBy( e ) << endl;
+                }
+            }
+        }
+
         //
         // 3. For each collection, check if the balancing policy recommends moving anything around.
         //
@@ -367,6 +513,23 @@ namespace mongo {
                 continue;
             }
 
+            // Balancing by load doesn't weigh tags, so collections with tags keep to chunk counts
+            ShardLoadMap shardLoad;
+            ChunkSizeMap chunkSizes;
+            if ( balanceByLoad && ranges.empty() &&
+                 _getShardLoad( ns, allShards, opTotals, shardToChunksMap, &shardLoad ) ) {
+
+                status.setLoad( &shardLoad, &chunkSizes );
+
+                if ( status.hasLoad() ) {
+                    string donor = status.getMostLoadedShard();
+                    if ( donor.size() ) {
+                        _estimateChunkSizes( ns, cm->getShardKey().key(), Shard::make( donor ),
+                                             shardToChunksMap[donor], &chunkSizes );
+                    }
+                }
+            }
+
             CandidateChunk* p = _policy->balance( ns, status, _balancedLastTime );
             if ( p ) candidateChunks->push_back( CandidateChunkPtr( p ) );
         }
@@ -491,17 +654,30 @@ namespace mongo {
                         secondaryThrottle = balancerConfig[SettingsType::secondaryThrottle()].trueValue();
                     }
 
+                    int maxConcurrentMigrations = 1;
+                    BSONElement maxConcurrent =
+                        balancerConfig[SettingsType::maxConcurrentMigrations()];
+                    if ( maxConcurrent.isNumber() && maxConcurrent.numberInt() > 0 ) {
+                        maxConcurrentMigrations = maxConcurrent.numberInt();
+                    }
+
                     LOG(1) << "waitForDelete: " << waitForDelete << endl;
                     LOG(1) << "secondaryThrottle: " << secondaryThrottle << endl;
+                    bool balanceByLoad =
+                        balancerConfig[SettingsType::balanceByLoad()].trueValue();
+
+                    LOG(1) << "maxConcurrentMigrations: " << maxConcurrentMigrations << endl;
+                    LOG(1) << "balanceByLoad: " << balanceByLoad << endl;
 
                     vector<CandidateChunkPtr> candidateChunks;
-                    _doBalanceRound( conn.conn() , &candidateChunks );
+                    _doBalanceRound( conn.conn() , &candidateChunks , balanceByLoad );
                     if ( candidateChunks.size() == 0 ) {
                         LOG(1) << "no need to move any chunk" << endl;
                         _balancedLastTime = 0;
                     }
                     else {
                         _balancedLastTime = _moveChunks(&candidateChunks,
+                                                        maxConcurrentMigrations,
                                                         secondaryThrottle,
                                                         waitForDelete );
                     }
@@ -33,11 +33,14 @@
 #include "mongo/pch.h"
 
 #include "mongo/client/dbclientinterface.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/s/balancer_policy.h"
 #include "mongo/util/background.h"
 
 namespace mongo {
 
+    class Shard;
+
     /**
      * The balancer is a background task that tries to keep the number of chunks across all servers of the cluster even. Although
      * every mongos will have one balancer running, only one of them will be active at the any given point in time. The balancer
@@ -45,7 +48,11 @@ namespace mongo {
      *
      * The balancer does act continuously but in "rounds". At a given round, it would decide if there is an imbalance by
      * checking the difference in chunks between the most and least loaded shards. It would issue a request for a chunk
-     * migration per round, if it found so.
+     * migration per collection per round, if it found so. Migrations between distinct shards may run at once, up to
+     * the balancer setting maxConcurrentMigrations.
+     *
+     * With the balancer setting balanceByLoad, collections without tags are balanced by how much of
+     * their data each shard has and how many operations a second it serves on them instead.
      */
     class Balancer : public BackgroundJob {
     public:
@@ -73,6 +80,11 @@ namespace mongo {
 
         // decide which chunks to move; owned here.
         scoped_ptr<BalancerPolicy> _policy;
+
+        // the operation count each shard last reported for a collection, and when, by shard and
+        // collection
+        typedef map< pair<string,string>, pair<long long,long long> > OpCountMap;
+        OpCountMap _lastOpCounts;
         
         /**
          * Checks that the balancer can connect to all servers it needs to do its job.
@@ -89,21 +101,66 @@ namespace mongo {
          *
          * @param conn is the connection with the config server(s)
          * @param candidateChunks (IN/OUT) filled with candidate chunks, one per collection, that could possibly be moved
+         * @param balanceByLoad balance collections without tags by the shards' load rather than chunk counts
          */
-        void _doBalanceRound( DBClientBase& conn, vector<CandidateChunkPtr>* candidateChunks );
+        void _doBalanceRound( DBClientBase& conn,
+                              vector<CandidateChunkPtr>* candidateChunks,
+                              bool balanceByLoad );
 
         /**
-         * Issues chunk migration request, one at a time.
+         * Asks each shard with chunks of the collection for its data size and uses its operation
+         * count against the last round's to tell its operation rate; the first round for a
+         * collection only weighs data size.
+         *
+         * @param opTotals the "totals" of each shard's top command
+         * @return false if some shard couldn't tell its load
+         */
+        bool _getShardLoad( const string& ns,
+                            const vector<Shard>& allShards,
+                            const map<string,BSONObj>& opTotals,
+                            const ShardToChunksMap& shardToChunksMap,
+                            ShardLoadMap* shardLoad );
+
+        /**
+         * Estimates the data size of a sample of the chunks the shard has, as that scans each
+         * chunk's index keys.
+         */
+        void _estimateChunkSizes( const string& ns,
+                                  const BSONObj& keyPattern,
+                                  const Shard& shard,
+                                  const vector<BSONObj>& chunks,
+                                  ChunkSizeMap* chunkSizes );
+
+        /**
+         * Issues chunk migration requests, up to maxConcurrentMigrations at once between distinct
+         * shards, see BalancerPolicy::scheduleMigrations.
          *
          * @param candidateChunks possible chunks to move
+         * @param maxConcurrentMigrations the most migrations to run at once, at least 1
          * @param secondaryThrottle wait for secondaries to catch up before pushing more deletes
          * @param waitForDelete wait for deletes to complete after each chunk move
          * @return number of chunks effectively moved
          */
         int _moveChunks(const vector<CandidateChunkPtr>* candidateChunks,
+                        int maxConcurrentMigrations,
+                        bool secondaryThrottle,
+                        bool waitForDelete);
+
+        /**
+         * Issues one chunk migration request.
+         *
+         * @return true if the chunk moved, or was marked jumbo
+         */
+        bool _moveChunk(const CandidateChunk& chunkInfo,
                         bool secondaryThrottle,
                         bool waitForDelete);
 
+        /** _moveChunk on a thread of its own, counting the chunk in movedCount if it moved */
+        void _moveChunkInThread(const CandidateChunk* chunkInfo,
+                                bool secondaryThrottle,
+                                bool waitForDelete,
+                                AtomicUInt32* movedCount);
+
         /**
          * Marks this balancer as being live on the config server(s).
          *
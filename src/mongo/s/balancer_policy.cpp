@@ -45,7 +45,8 @@ namespace mongo {
 
     DistributionStatus::DistributionStatus( const ShardInfoMap& shardInfo,
                                             const ShardToChunksMap& shardToChunksMap )
-        : _shardInfo( shardInfo ), _shardChunks( shardToChunksMap ) {
+        : _shardInfo( shardInfo ), _shardChunks( shardToChunksMap ),
+          _shardLoad( NULL ), _chunkSizes( NULL ), _totalDataSize( 0 ), _totalOpsPerSec( 0 ) {
 
         for ( ShardInfoMap::const_iterator i = _shardInfo.begin(); i != _shardInfo.end(); ++i ) {
             _shards.insert( i->first );
@@ -85,30 +86,39 @@ namespace mongo {
         return total;
     }
 
+    bool DistributionStatus::_canReceive( const string& shard,
+                                          const ShardInfo& info,
+                                          const string& tag ) const {
+        if ( info.isSizeMaxed() ) {
+            LOG(1) << shard << " has already reached the maximum total chunk size." << endl;
+            return false;
+        }
+
+        if ( info.isDraining() ) {
+            LOG(1) << shard << " is currently draining." << endl;
+            return false;
+        }
+
+        if ( info.hasOpsQueued() ) {
+            LOG(1) << shard << " has writebacks queued." << endl;
+            return false;
+        }
+
+        if ( ! info.hasTag( tag ) ) {
+            LOG(1) << shard << " doesn't have right tag" << endl;
+            return false;
+        }
+
+        return true;
+    }
+
     string DistributionStatus::getBestReceieverShard( const string& tag ) const {
         string best;
         unsigned minChunks = numeric_limits<unsigned>::max();
 
         for ( ShardInfoMap::const_iterator i = _shardInfo.begin(); i != _shardInfo.end(); ++i ) {
-            if ( i->second.isSizeMaxed() ) {
-                LOG(1) << i->first << " has already reached the maximum total chunk size." << endl;
+            if ( ! _canReceive( i->first, i->second, tag ) )
                 continue;
-            }
-
-            if ( i->second.isDraining() ) {
-                LOG(1) << i->first << " is currently draining." << endl;
-                continue;
-            }
-
-            if ( i->second.hasOpsQueued() ) {
-                LOG(1) << i->first << " has writebacks queued." << endl;
-                continue;
-            }
-
-            if ( ! i->second.hasTag( tag ) ) {
-                LOG(1) << i->first << " doesn't have right tag" << endl;
-                continue;
-            }
 
             unsigned myChunks = numberOfChunksInShard( i->first );
             if ( myChunks >= minChunks ) {
@@ -145,6 +155,111 @@ namespace mongo {
         return worst;
     }
 
+    const double DistributionStatus::minOpsPerSec = 10;
+
+    void DistributionStatus::setLoad( const ShardLoadMap* shardLoad,
+                                      const ChunkSizeMap* chunkSizes ) {
+        _shardLoad = shardLoad;
+        _chunkSizes = chunkSizes;
+        _totalDataSize = 0;
+        _totalOpsPerSec = 0;
+
+        for ( ShardLoadMap::const_iterator i = _shardLoad->begin(); i != _shardLoad->end(); ++i ) {
+            if ( ! _shards.count( i->first ) )
+                continue;
+            _totalDataSize += i->second.dataSize;
+            _totalOpsPerSec += i->second.opsPerSec;
+        }
+
+        if ( _totalOpsPerSec < minOpsPerSec )
+            _totalOpsPerSec = 0;
+    }
+
+    bool DistributionStatus::hasLoad() const {
+        return _shardLoad && _totalDataSize > 0;
+    }
+
+    static ShardLoad loadFor( const ShardLoadMap& shardLoad, const string& shard ) {
+        ShardLoadMap::const_iterator i = shardLoad.find( shard );
+        return i == shardLoad.end() ? ShardLoad() : i->second;
+    }
+
+    double DistributionStatus::shardLoad( const string& shard ) const {
+        verify( hasLoad() );
+        ShardLoad load = loadFor( *_shardLoad, shard );
+
+        double data = static_cast<double>( load.dataSize ) / _totalDataSize;
+        if ( _totalOpsPerSec <= 0 )
+            return _shards.size() * data;
+        return _shards.size() * ( data + load.opsPerSec / _totalOpsPerSec ) / 2;
+    }
+
+    double DistributionStatus::chunkLoad( const string& shard, const BSONObj& chunk ) const {
+        verify( hasLoad() );
+        ShardLoad load = loadFor( *_shardLoad, shard );
+        unsigned numChunks = numberOfChunksInShard( shard );
+        if ( load.dataSize <= 0 || numChunks == 0 )
+            return 0;
+
+        long long size = load.dataSize / numChunks;
+        if ( _chunkSizes ) {
+            ChunkSizeMap::const_iterator i = _chunkSizes->find( chunk[ChunkType::min()].Obj() );
+            if ( i != _chunkSizes->end() )
+                size = std::min( i->second, load.dataSize );
+        }
+
+        double data = static_cast<double>( size ) / _totalDataSize;
+        if ( _totalOpsPerSec <= 0 )
+            return _shards.size() * data;
+
+        double ops = load.opsPerSec * size / load.dataSize;
+        return _shards.size() * ( data + ops / _totalOpsPerSec ) / 2;
+    }
+
+    string DistributionStatus::getMostLoadedShard() const {
+        string worst;
+        double maxLoad = 0;
+
+        for ( ShardInfoMap::const_iterator i = _shardInfo.begin(); i != _shardInfo.end(); ++i ) {
+
+            if ( i->second.hasOpsQueued() ) {
+                // we can't move stuff off anyway
+                continue;
+            }
+
+            if ( numberOfChunksInShard( i->first ) == 0 )
+                continue;
+
+            double myLoad = shardLoad( i->first );
+            if ( myLoad <= maxLoad )
+                continue;
+
+            worst = i->first;
+            maxLoad = myLoad;
+        }
+
+        return worst;
+    }
+
+    string DistributionStatus::getLeastLoadedReceiverShard() const {
+        string best;
+        double minLoad = numeric_limits<double>::max();
+
+        for ( ShardInfoMap::const_iterator i = _shardInfo.begin(); i != _shardInfo.end(); ++i ) {
+            if ( ! _canReceive( i->first, i->second, "" ) )
+                continue;
+
+            double myLoad = shardLoad( i->first );
+            if ( myLoad >= minLoad )
+                continue;
+
+            best = i->first;
+            minLoad = myLoad;
+        }
+
+        return best;
+    }
+
     const vector<BSONObj>& DistributionStatus::getChunks( const string& shard ) const {
         ShardToChunksMap::const_iterator i = _shardChunks.find(shard);
         verify( i != _shardChunks.end() );
@@ -224,6 +339,98 @@ namespace mongo {
         }
     }
 
+    void BalancerPolicy::scheduleMigrations( const vector<const MigrateInfo*>& migrations,
+                                             int maxConcurrent,
+                                             vector< vector<const MigrateInfo*> >* waves ) {
+        verify( maxConcurrent >= 1 );
+        waves->clear();
+
+        // what each wave already holds
+        vector< set<string> > busyShards;
+        vector< set<string> > busyCollections;
+
+        for ( unsigned i = 0; i < migrations.size(); i++ ) {
+            const MigrateInfo* m = migrations[i];
+
+            unsigned w = 0;
+            for ( ; w < waves->size(); w++ ) {
+                if ( (*waves)[w].size() < static_cast<unsigned>( maxConcurrent ) &&
+                     !busyShards[w].count( m->from ) && !busyShards[w].count( m->to ) &&
+                     !busyCollections[w].count( m->ns ) )
+                    break;
+            }
+
+            if ( w == waves->size() ) {
+                waves->push_back( vector<const MigrateInfo*>() );
+                busyShards.push_back( set<string>() );
+                busyCollections.push_back( set<string>() );
+            }
+
+            (*waves)[w].push_back( m );
+            busyShards[w].insert( m->from );
+            busyShards[w].insert( m->to );
+            busyCollections[w].insert( m->ns );
+        }
+    }
+
+    const double BalancerPolicy::loadImbalanceThreshold = 0.2;
+
+    MigrateInfo* BalancerPolicy::_balanceLoad( const string& ns,
+                                               const DistributionStatus& distribution ) {
+        string from = distribution.getMostLoadedShard();
+        if ( from.size() == 0 )
+            return NULL;
+
+        string to = distribution.getLeastLoadedReceiverShard();
+        if ( to.size() == 0 ) {
+            log() << "no available shards to take load of " << ns << endl;
+            return NULL;
+        }
+
+        if ( to == from )
+            return NULL;
+
+        const double gap = distribution.shardLoad( from ) - distribution.shardLoad( to );
+
+        LOG(1) << "collection : " << ns << endl;
+        LOG(1) << "donor      : " << from << " load " << distribution.shardLoad( from ) << endl;
+        LOG(1) << "receiver   : " << to << " load " << distribution.shardLoad( to ) << endl;
+        LOG(1) << "threshold  : " << loadImbalanceThreshold << endl;
+
+        if ( gap < loadImbalanceThreshold )
+            return NULL;
+
+        // Moving a chunk of load c leaves the two shards |gap - 2c| apart, so the best chunk is
+        // the one closest to half the gap, and one of gap or more would only swap them around
+        const vector<BSONObj>& chunks = distribution.getChunks( from );
+        int best = -1;
+        double bestDistance = 0;
+        for ( unsigned j = 0; j < chunks.size(); j++ ) {
+            if ( _isJumbo( chunks[j] ) )
+                continue;
+
+            double load = distribution.chunkLoad( from, chunks[j] );
+            if ( load <= 0 || load >= gap )
+                continue;
+
+            double distance = fabs( load - gap / 2 );
+            if ( best < 0 || distance < bestDistance ) {
+                best = j;
+                bestDistance = distance;
+            }
+        }
+
+        if ( best < 0 ) {
+            log() << "ns: " << ns << " shard " << from << " is overloaded, but it has no chunk "
+                  << "that can be moved to " << to << " to even out the load" << endl;
+            return NULL;
+        }
+
+        log() << " ns: " << ns << " going to move " << chunks[best]
+              << " from: " << from << " to: " << to << " to even out load" << endl;
+        return new MigrateInfo( ns, to, from, chunks[best].getOwned() );
+    }
+
     bool BalancerPolicy::_isJumbo( const BSONObj& chunk ) {
         if ( chunk[ChunkType::jumbo()].trueValue() ) {
             LOG(1) << "chunk: " << chunk << "is marked as jumbo" << endl;
@@ -335,6 +542,9 @@ namespace mongo {
 
         // 3) for each tag balance
 
+        if ( distribution.hasLoad() && distribution.tags().empty() )
+            return _balanceLoad( ns, distribution );
+
         int threshold = 8;
         if ( balancedLastTime || distribution.totalChunks() < 20 )
             threshold = 2;
@@ -124,8 +124,24 @@ namespace mongo {
 
     };
 
+    /**
+     * What a shard reports of its load with one collection: how much of the collection's data it
+     * has, in bytes, and how many operations a second it serves on it.
+     */
+    struct ShardLoad {
+        long long dataSize;
+        double opsPerSec;
+
+        ShardLoad() : dataSize( 0 ), opsPerSec( 0 ) {}
+        ShardLoad( long long a_dataSize, double a_opsPerSec )
+            : dataSize( a_dataSize ), opsPerSec( a_opsPerSec ) {}
+    };
+
     typedef map< string,ShardInfo > ShardInfoMap;
     typedef map< string,vector<BSONObj> > ShardToChunksMap;
+    typedef map< string,ShardLoad > ShardLoadMap;
+    // estimated data size of chunks, by the chunk's min
+    typedef map< BSONObj,long long > ChunkSizeMap;
 
     class DistributionStatus : boost::noncopyable {
     public:
@@ -139,6 +155,19 @@ namespace mongo {
          */
         bool addTagRange( const TagRange& range );
 
+        /**
+         * Makes the collection balanced by load rather than by chunk count, given the shards'
+         * load and estimates of the size of some chunks.  Chunks without an estimate are taken to
+         * be their shard's average.  Both maps must outlive this.
+         */
+        void setLoad( const ShardLoadMap* shardLoad, const ChunkSizeMap* chunkSizes );
+
+        /**
+         * With fewer operations a second than this across the shards, load is only data size, so
+         * a quiet collection isn't moved around by migrations' and monitoring's operations.
+         */
+        static const double minOpsPerSec;
+
         // ---- these methods might be better suiting in BalancerPolicy
         
         /**
@@ -153,6 +182,29 @@ namespace mongo {
          */
         string getMostOverloadedShard( const string& forTag ) const;
 
+        // ---- load, when setLoad() was called
+
+        /** @return true if the collection is balanced by load */
+        bool hasLoad() const;
+
+        /**
+         * @return the shard's load with the collection, weighing data size and operation rate
+         *         alike.  A shard with an even share of both has a load of 1.
+         */
+        double shardLoad( const string& shard ) const;
+
+        /**
+         * @return the load moving the chunk off the shard would take away, in the units of
+         *         shardLoad.  A chunk is taken to get operations in proportion to its data.
+         */
+        double chunkLoad( const string& shard, const BSONObj& chunk ) const;
+
+        /** @return the most loaded shard that can donate chunks */
+        string getMostLoadedShard() const;
+
+        /** @return the least loaded shard that can receive a chunk */
+        string getLeastLoadedReceiverShard() const;
+
 
         // ---- basic accessors, counters, etc...
 
@@ -184,11 +236,19 @@ namespace mongo {
         void dump() const;
         
     private:
+        /** @return true if the shard may receive a chunk with the tag */
+        bool _canReceive( const string& shard, const ShardInfo& info, const string& tag ) const;
+
         const ShardInfoMap& _shardInfo;
         const ShardToChunksMap& _shardChunks;
         map<BSONObj,TagRange> _tagRanges;
         set<string> _allTags;
         set<string> _shards;
+
+        const ShardLoadMap* _shardLoad;
+        const ChunkSizeMap* _chunkSizes;
+        long long _totalDataSize;
+        double _totalOpsPerSec;
     };
 
     class BalancerPolicy {
@@ -197,7 +257,8 @@ namespace mongo {
         /**
          * Returns a suggested chunk to move whithin a collection's shards, given information about
          * space usage and number of chunks for that collection. If the policy doesn't recommend
-         * moving, it returns NULL.
+         * moving, it returns NULL.  Collections with load and no tags are balanced by load
+         * instead of chunk counts, once nothing has to move off draining shards.
          *
          * @param ns is the collections namepace.
          * @param DistributionStatus holds all the info about the current state of the cluster/namespace
@@ -209,8 +270,32 @@ namespace mongo {
                                      const DistributionStatus& distribution,
                                      int balancedLastTime );
 
+        /**
+         * Groups a round's migrations into waves of migrations that can run at once. A shard
+         * takes part in at most one migration of a wave, as it only donates one chunk and
+         * receives one chunk at a time, and a collection too, as a migration holds its
+         * collection's distributed lock. Migrations keep their order, each going in the first
+         * wave that has room for it.
+         *
+         * @param maxConcurrent is the most migrations a wave may hold, at least 1
+         * @param waves (OUT) the migrations, by wave
+         */
+        static void scheduleMigrations( const vector<const MigrateInfo*>& migrations,
+                                        int maxConcurrent,
+                                        vector< vector<const MigrateInfo*> >* waves );
+
+        /**
+         * A donor's load must be this far above the receiver's, in units of
+         * DistributionStatus::shardLoad, before load balancing moves a chunk.
+         */
+        static const double loadImbalanceThreshold;
+
     private:
         static bool _isJumbo( const BSONObj& chunk );
+
+        /** the move, if any, that best evens out the shards' load */
+        static MigrateInfo* _balanceLoad( const string& ns,
+                                          const DistributionStatus& distribution );
     };
 
 
@@ -517,5 +517,137 @@ namespace mongo {
                 }
             }
         }
+
+        TEST( BalancerPolicyTests, ScheduleMigrations ) {
+            BSONObj chunk = BSON( "min" << BSON( "x" << 0 ) << "max" << BSON( "x" << 1 ) );
+            MigrateInfo a( "db.a", "shard1", "shard0", chunk );
+            MigrateInfo b( "db.b", "shard3", "shard2", chunk );
+            MigrateInfo c( "db.c", "shard0", "shard4", chunk ); // shares shard0 with a
+            MigrateInfo d( "db.a", "shard6", "shard5", chunk ); // shares the collection of a
+            MigrateInfo e( "db.e", "shard8", "shard7", chunk );
+
+            vector<const MigrateInfo*> migrations;
+            migrations.push_back( &a );
+            migrations.push_back( &b );
+            migrations.push_back( &c );
+            migrations.push_back( &d );
+            migrations.push_back( &e );
+
+            vector< vector<const MigrateInfo*> > waves;
+            BalancerPolicy::scheduleMigrations( migrations, 10, &waves );
+            ASSERT_EQUALS( waves.size(), 2U );
+            ASSERT_EQUALS( waves[0].size(), 3U );
+            ASSERT_EQUALS( waves[0][0], &a );
+            ASSERT_EQUALS( waves[0][1], &b );
+            ASSERT_EQUALS( waves[0][2], &e );
+            ASSERT_EQUALS( waves[1].size(), 2U );
+            ASSERT_EQUALS( waves[1][0], &c );
+            ASSERT_EQUALS( waves[1][1], &d );
+
+            // at most two at once
+            BalancerPolicy::scheduleMigrations( migrations, 2, &waves );
+            ASSERT_EQUALS( waves.size(), 3U );
+            ASSERT_EQUALS( waves[0].size(), 2U );
+            ASSERT_EQUALS( waves[1][0], &c );
+            ASSERT_EQUALS( waves[1][1], &d );
+            ASSERT_EQUALS( waves[2][0], &e );
+
+            // one at a time is the old behavior
+            BalancerPolicy::scheduleMigrations( migrations, 1, &waves );
+            ASSERT_EQUALS( waves.size(), 5U );
+            ASSERT_EQUALS( waves[3][0], &d );
+        }
+
+        // chunks [0, 1), [1, 2), ... of the given shard
+        void addChunks( ShardToChunksMap* chunkMap, const string& shard, int from, int to ) {
+            vector<BSONObj>& chunks = (*chunkMap)[shard];
+            for ( int i = from; i < to; i++ ) {
+                chunks.push_back( BSON( ChunkType::min( BSON( "x" << i ) ) <<
+                                        ChunkType::max( BSON( "x" << i + 1 ) ) ) );
+            }
+        }
+
+        TEST( BalancerPolicyTests, BalanceByLoadMovesOffHotShard ) {
+            // as many chunks on each shard, but shard0 has most of the data and all the ops
+            ShardToChunksMap chunkMap;
+            addChunks( &chunkMap, "shard0", 0, 3 );
+            addChunks( &chunkMap, "shard1", 3, 6 );
+
+            ShardInfoMap info;
+            info["shard0"] = ShardInfo( 0, 0, false, false );
+            info["shard1"] = ShardInfo( 0, 0, false, false );
+
+            ShardLoadMap load;
+            load["shard0"] = ShardLoad( 900, 100 );
+            load["shard1"] = ShardLoad( 100, 0 );
+
+            ChunkSizeMap sizes;
+            sizes[BSON( "x" << 0 )] = 400;
+            sizes[BSON( "x" << 1 )] = 450;
+            sizes[BSON( "x" << 2 )] = 50;
+
+            DistributionStatus status( info, chunkMap );
+            status.setLoad( &load, &sizes );
+            ASSERT( status.hasLoad() );
+            ASSERT_APPROX_EQUAL( 1.9, status.shardLoad( "shard0" ), 0.001 );
+            ASSERT_APPROX_EQUAL( 0.1, status.shardLoad( "shard1" ), 0.001 );
+
+            // [1, 2) has closest to half the gap in load
+            scoped_ptr<MigrateInfo> c( BalancerPolicy::balance( "ns", status, 0 ) );
+            ASSERT( c );
+            ASSERT_EQUALS( "shard0", c->from );
+            ASSERT_EQUALS( "shard1", c->to );
+            ASSERT_EQUALS( 1, c->chunk.min["x"].numberInt() );
+        }
+
+        TEST( BalancerPolicyTests, BalanceByLoadIgnoresChunkCounts ) {
+            // the chunk counts are far apart, but the load is even
+            ShardToChunksMap chunkMap;
+            addChunks( &chunkMap, "shard0", 0, 10 );
+            addChunks( &chunkMap, "shard1", 10, 12 );
+
+            ShardInfoMap info;
+            info["shard0"] = ShardInfo( 0, 0, false, false );
+            info["shard1"] = ShardInfo( 0, 0, false, false );
+
+            ShardLoadMap load;
+            load["shard0"] = ShardLoad( 500, 40 );
+            load["shard1"] = ShardLoad( 500, 50 );
+
+            DistributionStatus status( info, chunkMap );
+            scoped_ptr<MigrateInfo> c( BalancerPolicy::balance( "ns", status, 1 ) );
+            ASSERT( c );
+
+            ChunkSizeMap sizes;
+            status.setLoad( &load, &sizes );
+            c.reset( BalancerPolicy::balance( "ns", status, 1 ) );
+            ASSERT( ! c );
+        }
+
+        TEST( BalancerPolicyTests, BalanceByLoadNoOvershoot ) {
+            // moving the only chunk would just put all the load on shard1
+            ShardToChunksMap chunkMap;
+            addChunks( &chunkMap, "shard0", 0, 1 );
+            chunkMap["shard1"];
+
+            ShardInfoMap info;
+            info["shard0"] = ShardInfo( 0, 0, false, false );
+            info["shard1"] = ShardInfo( 0, 0, false, false );
+
+            ShardLoadMap load;
+            load["shard0"] = ShardLoad( 1000, 10 );
+
+            DistributionStatus status( info, chunkMap );
+            status.setLoad( &load, NULL );
+            ASSERT_APPROX_EQUAL( 2.0, status.chunkLoad( "shard0", chunkMap["shard0"][0] ), 0.001 );
+            scoped_ptr<MigrateInfo> c( BalancerPolicy::balance( "ns", status, 0 ) );
+            ASSERT( ! c );
+
+            // but a draining shard still has to be emptied
+            info["shard0"] = ShardInfo( 0, 0, true, false );
+            c.reset( BalancerPolicy::balance( "ns", status, 0 ) );
+            ASSERT( c );
+            ASSERT_EQUALS( "shard1", c->to );
+        }
     }
 }
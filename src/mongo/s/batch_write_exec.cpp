@@ -77,157 +77,163 @@ namespace mongo {
         int numTargetErrors = 0;
         int numStaleBatches = 0;
 
-        for ( int rounds = 0; !batchOp.isFinished(); rounds++ ) {
+        // Ordered batches must finish each round of child batches before targeting the next
+        // ops.  Unordered ones keep other shards busy while stale children are retargeted.
+        bool ordered = clientRequest.getOrdered();
+        bool retarget = true;
 
-            //
-            // Refresh the targeter if we need to (no-op if nothing stale)
-            //
+        // Child batches waiting for their host's previous batch to come back, and the batches
+        // out on the network, one per host.  Both own their batches.
+        OwnedPointerVector<TargetedWriteBatch> queuedOwned;
+        vector<TargetedWriteBatch*>& queued = queuedOwned.mutableVector();
+        EndpointBatchMap pendingBatches;
 
-            Status refreshStatus = _targeter->refreshIfNeeded();
+        while ( !batchOp.isFinished() ) {
 
-            if ( !refreshStatus.isOK() ) {
+            if ( pendingBatches.empty() || ( retarget && !ordered ) ) {
 
-                // It's okay if we can't refresh, we'll just record errors for the ops if
-                // needed.
-                warning() << "could not refresh targeter" << causedBy( refreshStatus.reason() )
-                          << endl;
-            }
+                retarget = false;
 
-            //
-            // Get child batches to send
-            //
+                //
+                // Refresh the targeter if we need to (no-op if nothing stale)
+                //
 
-            vector<TargetedWriteBatch*> childBatches;
+                Status refreshStatus = _targeter->refreshIfNeeded();
 
-            //
-            // Targeting errors can be caused by remote metadata changing (the collection could have
-            // been dropped and recreated, for example with a new shard key).  If a remote metadata
-            // change occurs *before* a client sends us a batch, we need to make sure that we don't
-            // error out just because we're staler than the client - otherwise mongos will be have
-            // unpredictable behavior.
-            //
-            // (If a metadata change happens *during* or *after* a client sends us a batch, however,
-            // we make no guarantees about delivery.)
-            //
-            // For this reason, we don't record targeting errors until we've refreshed our targeting
-            // metadata at least once *after* receiving the client batch - at that point, we know:
-            //
-            // 1) our new metadata is the same as the metadata when the client sent a batch, and so
-            //    targeting errors are real.
-            // OR
-            // 2) our new metadata is a newer version than when the client sent a batch, and so
-            //    the metadata must have changed after the client batch was sent.  We don't need to
-            //    deliver in this case, since for all the client knows we may have gotten the batch
-            //    exactly when the metadata changed.
-            //
-            // If we've had a targeting error or stale error, we've refreshed the metadata once and
-            // can record target errors.
-            bool recordTargetErrors = numTargetErrors > 0 || numStaleBatches > 0;
-
-            Status targetStatus = batchOp.targetBatch( *_targeter,
-                                                       recordTargetErrors,
-                                                       &childBatches );
-            if ( !targetStatus.isOK() ) {
-                _targeter->noteCouldNotTarget();
-                ++numTargetErrors;
-                continue;
-            }
+                if ( !refreshStatus.isOK() ) {
 
-            //
-            // Send all child batches
-            //
+                    // It's okay if we can't refresh, we'll just record errors for the ops if
+                    // needed.
+                    warning() << "could not refresh targeter" << causedBy( refreshStatus.reason() )
+                              << endl;
+                }
 
-            size_t numSent = 0;
-            while ( numSent != childBatches.size() ) {
+                //
+                // Get child batches to send
+                //
 
-                // Collect batches out on the network, mapped by endpoint
-                EndpointBatchMap pendingBatches;
+                vector<TargetedWriteBatch*> childBatches;
 
                 //
-                // Send side
+                // Targeting errors can be caused by remote metadata changing (the collection
+                // could have been dropped and recreated, for example with a new shard key).  If a
+                // remote metadata change occurs *before* a client sends us a batch, we need to
+                // make sure that we don't error out just because we're staler than the client -
+                // otherwise mongos will be have unpredictable behavior.
                 //
+                // (If a metadata change happens *during* or *after* a client sends us a batch,
+                // however, we make no guarantees about delivery.)
+                //
+                // For this reason, we don't record targeting errors until we've refreshed our
+                // targeting metadata at least once *after* receiving the client batch - at that
+                // point, we know:
+                //
+                // 1) our new metadata is the same as the metadata when the client sent a batch,
+                //    and so targeting errors are real.
+                // OR
+                // 2) our new metadata is a newer version than when the client sent a batch, and
+                //    so the metadata must have changed after the client batch was sent.  We don't
+                //    need to deliver in this case, since for all the client knows we may have
+                //    gotten the batch exactly when the metadata changed.
+                //
+                // If we've had a targeting error or stale error, we've refreshed the metadata
+                // once and can record target errors.
+                bool recordTargetErrors = numTargetErrors > 0 || numStaleBatches > 0;
+
+                Status targetStatus = batchOp.targetBatch( *_targeter,
+                                                           recordTargetErrors,
+                                                           &childBatches );
+                if ( !targetStatus.isOK() ) {
+                    _targeter->noteCouldNotTarget();
+                    ++numTargetErrors;
+                    // Try again once what's out on the network is back
+                    if ( pendingBatches.empty() ) continue;
+                }
 
-                // Get as many batches as we can at once
-                for ( vector<TargetedWriteBatch*>::iterator it = childBatches.begin();
-                    it != childBatches.end(); ++it ) {
+                queued.insert( queued.end(), childBatches.begin(), childBatches.end() );
+            }
 
-                    TargetedWriteBatch* nextBatch = *it;
-                    // If the batch is NULL, we sent it previously, so skip
-                    if ( nextBatch == NULL ) continue;
-                    const ConnectionString& hostEndpoint = nextBatch->getEndpoint().shardHost;
+            //
+            // Send side
+            //
 
-                    EndpointBatchMap::iterator pendingIt = pendingBatches.find( &hostEndpoint );
+            // Send every queued batch whose host has nothing in flight
+            for ( vector<TargetedWriteBatch*>::iterator it = queued.begin(); it != queued.end(); ) {
 
-                    // If we already have a batch for this endpoint, continue
-                    if ( pendingIt != pendingBatches.end() ) continue;
+                TargetedWriteBatch* nextBatch = *it;
+                const ConnectionString& hostEndpoint = nextBatch->getEndpoint().shardHost;
 
-                    // Otherwise send it out to the endpoint via a command to a database
+                // If we already have a batch for this endpoint, it waits.  We'll only get
+                // duplicate hostEndpoints if we have broadcast and non-broadcast endpoints for
+                // the same host, or retargeted ops, so this should be pretty efficient.
+                if ( pendingBatches.find( &hostEndpoint ) != pendingBatches.end() ) {
+                    ++it;
+                    continue;
+                }
 
-                    BatchedCommandRequest request( clientRequest.getBatchType() );
-                    batchOp.buildBatchRequest( *nextBatch, &request );
+                // Otherwise send it out to the endpoint via a command to a database
 
-                    // Internally we use full namespaces for request/response, but we send the
-                    // command to a database with the collection name in the request.
-                    NamespaceString nss( request.getNS() );
-                    request.setNS( nss.coll() );
+                BatchedCommandRequest request( clientRequest.getBatchType() );
+                batchOp.buildBatchRequest( *nextBatch, &request );
 
-                    _dispatcher->addCommand( hostEndpoint, nss.db(), request );
+                // Internally we use full namespaces for request/response, but we send the
+                // command to a database with the collection name in the request.
+                NamespaceString nss( request.getNS() );
+                request.setNS( nss.coll() );
 
-                    // Indicate we're done by setting the batch to NULL
-                    // We'll only get duplicate hostEndpoints if we have broadcast and non-broadcast
-                    // endpoints for the same host, so this should be pretty efficient without
-                    // moving stuff around.
-                    *it = NULL;
+                _dispatcher->addCommand( hostEndpoint, nss.db(), request );
 
-                    // Recv-side is responsible for cleaning up the nextBatch when used
-                    pendingBatches.insert( make_pair( &hostEndpoint, nextBatch ) );
-                }
-
-                // Send them all out
-                _dispatcher->sendAll();
-                numSent += pendingBatches.size();
+                // Recv-side is responsible for cleaning up the nextBatch when used
+                pendingBatches.insert( make_pair( &hostEndpoint, nextBatch ) );
+                it = queued.erase( it );
+            }
 
-                //
-                // Recv side
-                //
+            // Send them all out
+            _dispatcher->sendAll();
 
-                while ( _dispatcher->numPending() > 0 ) {
+            if ( pendingBatches.empty() ) continue;
 
-                    // Get the response
-                    ConnectionString endpoint;
-                    BatchedCommandResponse response;
-                    Status dispatchStatus = _dispatcher->recvAny( &endpoint, &response );
+            //
+            // Recv side
+            //
 
-                    // Get the TargetedWriteBatch to find where to put the response
-                    TargetedWriteBatch* batchRaw = pendingBatches.find( &endpoint )->second;
-                    scoped_ptr<TargetedWriteBatch> batch( batchRaw );
+            // Take whichever response comes back first, so the next batch for that host can go
+            // out while the others are still working
+            ConnectionString endpoint;
+            BatchedCommandResponse response;
+            Status dispatchStatus = _dispatcher->recvAny( &endpoint, &response );
 
-                    if ( dispatchStatus.isOK() ) {
+            // Get the TargetedWriteBatch to find where to put the response
+            EndpointBatchMap::iterator pendingIt = pendingBatches.find( &endpoint );
+            dassert( pendingIt != pendingBatches.end() );
+            scoped_ptr<TargetedWriteBatch> batch( pendingIt->second );
+            pendingBatches.erase( pendingIt );
 
-                        TrackedErrors trackedErrors;
-                        trackedErrors.startTracking( ErrorCodes::StaleShardVersion );
+            if ( dispatchStatus.isOK() ) {
 
-                        // Dispatch was ok, note response
-                        batchOp.noteBatchResponse( *batch, response, &trackedErrors );
+                TrackedErrors trackedErrors;
+                trackedErrors.startTracking( ErrorCodes::StaleShardVersion );
 
-                        // Note if anything was stale
-                        const vector<ShardError*>& staleErrors =
-                            trackedErrors.getErrors( ErrorCodes::StaleShardVersion );
+                // Dispatch was ok, note response
+                batchOp.noteBatchResponse( *batch, response, &trackedErrors );
 
-                        if ( staleErrors.size() > 0 ) {
-                            noteStaleResponses( staleErrors, _targeter );
-                            ++numStaleBatches;
-                        }
-                    }
-                    else {
+                // Note if anything was stale
+                const vector<ShardError*>& staleErrors =
+                    trackedErrors.getErrors( ErrorCodes::StaleShardVersion );
 
-                        // Error occurred dispatching, note it
-                        BatchedErrorDetail error;
-                        buildErrorFrom( dispatchStatus, &error );
-                        batchOp.noteBatchError( *batch, error );
-                    }
+                if ( staleErrors.size() > 0 ) {
+                    noteStaleResponses( staleErrors, _targeter );
+                    ++numStaleBatches;
+                    retarget = true;
                 }
             }
+            else {
+
+                // Error occurred dispatching, note it
+                BatchedErrorDetail error;
+                buildErrorFrom( dispatchStatus, &error );
+                batchOp.noteBatchError( *batch, error );
+            }
         }
 
         batchOp.buildClientResponse( clientResponse );
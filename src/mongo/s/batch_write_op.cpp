@@ -127,6 +127,28 @@ namespace mongo {
         TargetedBatchMap batchMap;
 
         size_t numWriteOps = _clientRequest->sizeWriteOps();
+
+        // Unordered inserts may all be sent at once, so target all their docs together, which
+        // the targeter can do more cheaply than one by one.  Ordered batches only send one op a
+        // round, so they keep targeting as they go.
+        bool targetInsertsTogether = !_clientRequest->getOrdered()
+            && _clientRequest->getBatchType() == BatchedCommandRequest::BatchType_Insert;
+
+        OwnedPointerVector<ShardEndpoint> insertEndpointsOwned;
+        vector<ShardEndpoint*>& insertEndpoints = insertEndpointsOwned.mutableVector();
+        vector<Status> insertStatuses;
+        size_t nextInsert = 0;
+
+        if ( targetInsertsTogether ) {
+            vector<BSONObj> docs;
+            for ( size_t i = 0; i < numWriteOps; ++i ) {
+                if ( _writeOps[i].getWriteState() == WriteOpState_Ready ) {
+                    docs.push_back( _clientRequest->getInsertRequest()->getDocumentsAt( i ) );
+                }
+            }
+            targeter.targetDocs( docs, &insertEndpoints, &insertStatuses );
+        }
+
         for ( size_t i = 0; i < numWriteOps; ++i ) {
 
             // Only do one-at-a-time ops if COE is false
@@ -145,7 +167,17 @@ namespace mongo {
             OwnedPointerVector<TargetedWrite> writesOwned;
             vector<TargetedWrite*>& writes = writesOwned.mutableVector();
 
-            Status targetStatus = writeOp.targetWrites( targeter, &writes );
+            Status targetStatus = Status::OK();
+            if ( targetInsertsTogether ) {
+                targetStatus = insertStatuses[nextInsert];
+                if ( targetStatus.isOK() ) {
+                    writeOp.targetInsert( *insertEndpoints[nextInsert], &writes );
+                }
+                ++nextInsert;
+            }
+            else {
+                targetStatus = writeOp.targetWrites( targeter, &writes );
+            }
 
             if ( !targetStatus.isOK() ) {
 
@@ -34,6 +34,8 @@
 
 #include "mongo/client/connpool.h"
 #include "mongo/client/dbclientcursor.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/query/index_bounds_builder.h"
 #include "mongo/db/queryutil.h"
 #include "mongo/platform/random.h"
 #include "mongo/s/chunk_diff.h"
@@ -69,7 +71,7 @@ namespace mongo {
     bool Chunk::ShouldAutoSplit = true;
 
     Chunk::Chunk(const ChunkManager * manager, BSONObj from)
-        : _manager(manager), _lastmod(0, OID()), _dataWritten(mkDataWritten())
+        : _shared(manager->_shared), _lastmod(0, OID()), _dataWritten(mkDataWritten())
     {
         string ns = from.getStringField(ChunkType::ns().c_str());
         _shard.reset(from.getStringField(ChunkType::shard().c_str()));
@@ -83,7 +85,7 @@ namespace mongo {
         _jumbo = from[ChunkType::jumbo()].trueValue();
 
         uassert( 10170 ,  "Chunk needs a ns" , ! ns.empty() );
-        uassert( 13327 ,  "Chunk ns must match server ns" , ns == _manager->getns() );
+        uassert( 13327 ,  "Chunk ns must match server ns" , ns == _shared->getns() );
 
         uassert( 10171 ,  "Chunk needs a server" , _shard.ok() );
 
@@ -92,17 +94,17 @@ namespace mongo {
     }
 
     Chunk::Chunk(const ChunkManager * info , const BSONObj& min, const BSONObj& max, const Shard& shard, ChunkVersion lastmod)
-        : _manager(info), _min(min), _max(max), _shard(shard), _lastmod(lastmod), _jumbo(false), _dataWritten(mkDataWritten())
+        : _shared(info->_shared), _min(min), _max(max), _shard(shard), _lastmod(lastmod), _jumbo(false), _dataWritten(mkDataWritten())
     {}
 
     int Chunk::mkDataWritten() {
         PseudoRandom r(static_cast<int64_t>(time(0)));
-        return r.nextInt32( MaxChunkSize / ChunkManager::SplitHeuristics::splitTestFactor );
+        return r.nextInt32( MaxChunkSize / ChunkManagerShared::SplitHeuristics::splitTestFactor );
     }
 
     string Chunk::getns() const {
-        verify( _manager );
-        return _manager->getns();
+        verify( _shared );
+        return _shared->getns();
     }
 
     bool Chunk::containsPoint( const BSONObj& point ) const {
@@ -115,23 +117,23 @@ namespace mongo {
     }
 
     bool Chunk::minIsInf() const {
-        return _manager->getShardKey().globalMin().woCompare( getMin() ) == 0;
+        return _shared->getShardKey().globalMin().woCompare( getMin() ) == 0;
     }
 
     bool Chunk::maxIsInf() const {
-        return _manager->getShardKey().globalMax().woCompare( getMax() ) == 0;
+        return _shared->getShardKey().globalMax().woCompare( getMax() ) == 0;
     }
 
     BSONObj Chunk::_getExtremeKey( int sort ) const {
         Query q;
         if ( sort == 1 ) {
-            q.sort( _manager->getShardKey().key() );
+            q.sort( _shared->getShardKey().key() );
         }
         else {
             // need to invert shard key pattern to sort backwards
             // TODO: make a helper in ShardKeyPattern?
 
-            BSONObj k = _manager->getShardKey().key();
+            BSONObj k = _shared->getShardKey().key();
             BSONObjBuilder r;
 
             BSONObjIterator i(k);
@@ -145,11 +147,56 @@ namespace mongo {
         }
         // find the extreme key
         ScopedDbConnection conn(getShard().getConnString());
-        BSONObj end = conn->findOne(_manager->getns(), q);
+        BSONObj end = conn->findOne(_shared->getns(), q);
         conn.done();
         if ( end.isEmpty() )
             return BSONObj();
-        return _manager->getShardKey().extractKey( end );
+        return _shared->getShardKey().extractKey( end );
+    }
+
+    BSONObj Chunk::_getKeyAfter( const BSONObj& key ) const {
+        if ( skey().isSpecial() )
+            return BSONObj();
+
+        vector<BSONElement> pattern;
+        vector<BSONElement> values;
+        BSONObjIterator pi( _shared->getShardKey().key() );
+        BSONObjIterator vi( key );
+        while ( pi.more() && vi.more() ) {
+            pattern.push_back( pi.next() );
+            values.push_back( vi.next() );
+        }
+        if ( pattern.empty() || pi.more() || vi.more() )
+            return BSONObj();
+
+        ScopedDbConnection conn(getShard().getConnString());
+
+        // the next key either shares the first i fields of 'key' and is past it on field i, or
+        // differs earlier; try the longest shared prefix first, each query stays on the index
+        BSONObj next;
+        for ( int i = static_cast<int>( pattern.size() ) - 1; i >= 0 && next.isEmpty(); i-- ) {
+            BSONObjBuilder b;
+            for ( int j = 0; j < i; j++ ) {
+                b.appendAs( values[j], pattern[j].fieldName() );
+            }
+            BSONObjBuilder past( b.subobjStart( pattern[i].fieldName() ) );
+            past.appendAs( values[i], pattern[i].number() < 0 ? "$lt" : "$gt" );
+            past.done();
+
+            Query q( b.obj() );
+            q.sort( _shared->getShardKey().key() );
+            q.hint( _shared->getShardKey().key() );
+
+            BSONObj doc = conn->findOne( _shared->getns(), q );
+            if ( ! doc.isEmpty() )
+                next = _shared->getShardKey().extractKey( doc );
+        }
+        conn.done();
+
+        if ( next.isEmpty() || next.woCompare( _max ) >= 0 )
+            return BSONObj();
+
+        return next;
     }
 
     void Chunk::pickMedianKey( BSONObj& medianKey ) const {
@@ -157,8 +204,8 @@ namespace mongo {
         ScopedDbConnection conn(getShard().getConnString());
         BSONObj result;
         BSONObjBuilder cmd;
-        cmd.append( "splitVector" , _manager->getns() );
-        cmd.append( "keyPattern" , _manager->getShardKey().key() );
+        cmd.append( "splitVector" , _shared->getns() );
+        cmd.append( "keyPattern" , _shared->getShardKey().key() );
         cmd.append( "min" , getMin() );
         cmd.append( "max" , getMax() );
         cmd.appendBool( "force" , true );
@@ -184,8 +231,8 @@ namespace mongo {
         ScopedDbConnection conn(getShard().getConnString());
         BSONObj result;
         BSONObjBuilder cmd;
-        cmd.append( "splitVector" , _manager->getns() );
-        cmd.append( "keyPattern" , _manager->getShardKey().key() );
+        cmd.append( "splitVector" , _shared->getns() );
+        cmd.append( "keyPattern" , _shared->getShardKey().key() );
         cmd.append( "min" , getMin() );
         cmd.append( "max" , getMax() );
         cmd.append( "maxChunkSizeBytes" , chunkSize );
@@ -216,7 +263,7 @@ namespace mongo {
         if ( ! force ) {
             vector<BSONObj> candidates;
             const int maxPoints = 2;
-            pickSplitVector( candidates , getManager()->getCurrentDesiredChunkSize() , maxPoints , MaxObjectPerChunk );
+            pickSplitVector( candidates , _shared->getCurrentDesiredChunkSize() , maxPoints , MaxObjectPerChunk );
             if ( candidates.size() <= 1 ) {
                 // no split points means there isn't enough data to split on
                 // 1 split point means we have between half the chunk size to full chunk size
@@ -260,6 +307,19 @@ namespace mongo {
             }
         }
 
+        // When most of a chunk shares the lowest shard key value the median is that value, so a
+        // forced split instead cuts right after it: the hot value gets a chunk of its own and the
+        // rest of the range can move.
+        if ( force && ( splitPoint.empty() || _min == splitPoint.front() ) ) {
+            BSONObj next = _getKeyAfter( _min );
+            if ( ! next.isEmpty() ) {
+                LOG(1) << "median of chunk " << toString() << " is its min key, splitting at next key "
+                       << next << " instead" << endl;
+                splitPoint.clear();
+                splitPoint.push_back( next );
+            }
+        }
+
         // Normally, we'd have a sound split point here if the chunk is not empty. It's also a good place to
         // sanity check.
         if ( splitPoint.empty() || _min == splitPoint.front() || _max == splitPoint.front() ) {
@@ -277,7 +337,7 @@ namespace mongo {
     bool Chunk::multiSplit( const vector<BSONObj>& m , BSONObj& res ) const {
         const size_t maxSplitPoints = 8192;
 
-        uassert( 10165 , "can't split as shard doesn't have a manager" , _manager );
+        uassert( 10165 , "can't split as shard doesn't have a manager" , _shared );
         uassert( 13332 , "need a split key to split chunk" , !m.empty() );
         uassert( 13333 , "can't split a chunk in that many parts", m.size() < maxSplitPoints );
         uassert( 13003 , "can't split a chunk with only one distinct value" , _min.woCompare(_max) );
@@ -285,8 +345,8 @@ namespace mongo {
         ScopedDbConnection conn(getShard().getConnString());
 
         BSONObjBuilder cmd;
-        cmd.append( "splitChunk" , _manager->getns() );
-        cmd.append( "keyPattern" , _manager->getShardKey().key() );
+        cmd.append( "splitChunk" , _shared->getns() );
+        cmd.append( "keyPattern" , _shared->getShardKey().key() );
         cmd.append( "min" , getMin() );
         cmd.append( "max" , getMax() );
         cmd.append( "from" , getShard().getName() );
@@ -300,7 +360,7 @@ namespace mongo {
             conn.done();
 
             // Mark the minor version for *eventual* reload
-            _manager->markMinorForReload( this->_lastmod );
+            _shared->_splitHeuristics.markMinorForReload( _shared->getns(), _lastmod );
 
             return false;
         }
@@ -308,7 +368,7 @@ namespace mongo {
         conn.done();
         
         // force reload of config
-        _manager->reload();
+        _shared->reload();
 
         return true;
     }
@@ -321,14 +381,14 @@ namespace mongo {
     {
         uassert( 10167 ,  "can't move shard to its current location!" , getShard() != to );
 
-        log() << "moving chunk ns: " << _manager->getns() << " moving ( " << toString() << ") " << _shard.toString() << " -> " << to.toString() << endl;
+        log() << "moving chunk ns: " << _shared->getns() << " moving ( " << toString() << ") " << _shard.toString() << " -> " << to.toString() << endl;
 
         Shard from = _shard;
 
         ScopedDbConnection fromconn(from.getConnString());
 
         bool worked = fromconn->runCommand( "admin" ,
-                                            BSON( "moveChunk" << _manager->getns() <<
+                                            BSON( "moveChunk" << _shared->getns() <<
                                                   "from" << from.getAddress().toString() <<
                                                   "to" << to.getAddress().toString() <<
                                                   // NEEDED FOR 2.0 COMPATIBILITY
@@ -351,7 +411,7 @@ namespace mongo {
         // if succeeded, needs to reload to pick up the new location
         // if failed, mongos may be stale
         // reload is excessive here as the failure could be simply because collection metadata is taken
-        _manager->reload();
+        _shared->reload();
 
         return worked;
     }
@@ -362,19 +422,19 @@ namespace mongo {
 
         try {
             _dataWritten += dataWritten;
-            int splitThreshold = getManager()->getCurrentDesiredChunkSize();
+            int splitThreshold = _shared->getCurrentDesiredChunkSize();
             if ( minIsInf() || maxIsInf() ) {
                 splitThreshold = (int) ((double)splitThreshold * .9);
             }
 
-            if ( _dataWritten < splitThreshold / ChunkManager::SplitHeuristics::splitTestFactor )
+            if ( _dataWritten < splitThreshold / ChunkManagerShared::SplitHeuristics::splitTestFactor )
                 return false;
             
-            if ( ! getManager()->_splitHeuristics._splitTickets.tryAcquire() ) {
-                LOG(1) << "won't auto split because not enough tickets: " << getManager()->getns() << endl;
+            if ( ! _shared->_splitHeuristics._splitTickets.tryAcquire() ) {
+                LOG(1) << "won't auto split because not enough tickets: " << _shared->getns() << endl;
                 return false;
             }
-            TicketHolderReleaser releaser( &(getManager()->_splitHeuristics._splitTickets) );
+            TicketHolderReleaser releaser( &(_shared->_splitHeuristics._splitTickets) );
 
             // this is a bit ugly
             // we need it so that mongos blocks for the writes to actually be committed
@@ -400,9 +460,9 @@ namespace mongo {
                 _dataWritten = 0; // we're splitting, so should wait a bit
             }
 
-            bool shouldBalance = grid.shouldBalance( _manager->getns() );
+            bool shouldBalance = grid.shouldBalance( _shared->getns() );
 
-            log() << "autosplitted " << _manager->getns() << " shard: " << toString()
+            log() << "autosplitted " << _shared->getns() << " shard: " << toString()
                   << " on: " << splitPoint << " (splitThreshold " << splitThreshold << ")"
 #ifdef _DEBUG
                   << " size: " << getPhysicalSize() // slow - but can be useful when debugging
@@ -426,7 +486,7 @@ namespace mongo {
                     return true; // we did split even if we didn't migrate
                 }
 
-                ChunkManagerPtr cm = _manager->reload(false/*just reloaded in mulitsplit*/);
+                ChunkManagerPtr cm = _shared->reload(false/*just reloaded in mulitsplit*/);
                 ChunkPtr toMove = cm->findIntersectingChunk(min);
 
                 if ( ! (toMove->getMin() == min && toMove->getMax() == max) ){
@@ -446,7 +506,7 @@ namespace mongo {
                                                 res ) );
                 
                 // update our config
-                _manager->reload();
+                _shared->reload();
             }
 
             return true;
@@ -459,7 +519,7 @@ namespace mongo {
             _dataWritten = mkDataWritten();
 
             // if the collection lock is taken (e.g. we're migrating), it is fine for the split to fail.
-            warning() << "could not autosplit collection " << _manager->getns() << causedBy( e ) << endl;
+            warning() << "could not autosplit collection " << _shared->getns() << causedBy( e ) << endl;
             return false;
         }
     }
@@ -469,8 +529,8 @@ namespace mongo {
 
         BSONObj result;
         uassert( 10169 ,  "datasize failed!" , conn->runCommand( "admin" ,
-                 BSON( "datasize" << _manager->getns()
-                       << "keyPattern" << _manager->getShardKey().key()
+                 BSON( "datasize" << _shared->getns()
+                       << "keyPattern" << _shared->getShardKey().key()
                        << "min" << getMin()
                        << "max" << getMax()
                        << "maxSize" << ( MaxChunkSize + 1 )
@@ -494,7 +554,7 @@ namespace mongo {
 
     void Chunk::serialize(BSONObjBuilder& to,ChunkVersion myLastMod) {
 
-        to.append( "_id" , genID( _manager->getns() , _min ) );
+        to.append( "_id" , genID( _shared->getns() , _min ) );
 
         if ( myLastMod.isSet() ) {
             myLastMod.addToBSON(to, ChunkType::DEPRECATED_lastmod());
@@ -506,7 +566,7 @@ namespace mongo {
             verify(0);
         }
 
-        to << ChunkType::ns(_manager->getns());
+        to << ChunkType::ns(_shared->getns());
         to << ChunkType::min(_min);
         to << ChunkType::max(_max);
         to << ChunkType::shard(_shard.getName());
@@ -527,7 +587,7 @@ namespace mongo {
 
     string Chunk::toString() const {
         stringstream ss;
-        ss << ChunkType::ns()                 << ": " << _manager->getns()   << ", "
+        ss << ChunkType::ns()                 << ": " << _shared->getns()   << ", "
            << ChunkType::shard()              << ": " << _shard.toString()   << ", "
            << ChunkType::DEPRECATED_lastmod() << ": " << _lastmod.toString() << ", "
            << ChunkType::min()                << ": " << _min                << ", "
@@ -536,7 +596,7 @@ namespace mongo {
     }
 
     ShardKeyPattern Chunk::skey() const {
-        return _manager->getShardKey();
+        return _shared->getShardKey();
     }
 
     void Chunk::markAsJumbo() const {
@@ -605,7 +665,8 @@ namespace mongo {
         _unique( unique ),
         _chunkRanges(),
         _mutex("ChunkManager"),
-        _sequenceNumber(++NextSequenceNumber)
+        _sequenceNumber(++NextSequenceNumber),
+        _shared( new ChunkManagerShared( _ns, _key ) )
     {
         //
         // Sets up a chunk manager from new data
@@ -627,7 +688,8 @@ namespace mongo {
         // The shard versioning mechanism hinges on keeping track of the number of times we reloaded ChunkManager's.
         // Increasing this number here will prompt checkShardVersion() to refresh the connection-level versions to
         // the most up to date value.
-        _sequenceNumber(++NextSequenceNumber)
+        _sequenceNumber(++NextSequenceNumber),
+        _shared( new ChunkManagerShared( _ns, _key ) )
     {
 
         //
@@ -646,7 +708,8 @@ namespace mongo {
         _unique( oldManager->isUnique() ),
         _chunkRanges(),
         _mutex("ChunkManager"),
-        _sequenceNumber(++NextSequenceNumber)
+        _sequenceNumber(++NextSequenceNumber),
+        _shared( oldManager->_shared )
     {
         //
         // Sets up a chunk manager based on an older manager
@@ -662,9 +725,10 @@ namespace mongo {
             ChunkMap chunkMap;
             set<Shard> shards;
             ShardVersionMap shardVersions;
+            vector<pair<BSONObj,BSONObj> > changed;
             Timer t;
 
-            bool success = _load( config, chunkMap, shards, shardVersions, _oldManager );
+            bool success = _load( config, chunkMap, shards, shardVersions, _oldManager, &changed );
 
             if( success ){
                 {
@@ -677,15 +741,28 @@ namespace mongo {
                           << endl;
                 }
 
+                // Chunks carried over from the old manager were checked when it loaded, so
+                // only the changed ones need to be.  Ranges are likewise updated around them,
+                // unless so much changed that rebuilding them is as cheap.
+                bool incremental = !changed.empty() && changed.size() < chunkMap.size() / 2;
+
                 // TODO: Merge into diff code above, so we validate in one place
-                if (_isValid(chunkMap)) {
+                if (incremental ? _isValidAround(chunkMap, changed) : _isValid(chunkMap)) {
                     // These variables are const for thread-safety. Since the
                     // constructor can only be called from one thread, we don't have
                     // to worry about that here.
                     const_cast<ChunkMap&>(_chunkMap).swap(chunkMap);
                     const_cast<set<Shard>&>(_shards).swap(shards);
                     const_cast<ShardVersionMap&>(_shardVersions).swap(shardVersions);
-                    const_cast<ChunkRangeManager&>(_chunkRanges).reloadAll(_chunkMap);
+                    ChunkRangeManager& chunkRanges = const_cast<ChunkRangeManager&>(_chunkRanges);
+                    if (incremental) {
+                        chunkRanges = _oldManager->_chunkRanges;
+                        chunkRanges.reloadChanged(_chunkMap, changed);
+                    }
+                    else {
+                        chunkRanges.reloadAll(_chunkMap);
+                    }
+                    _shared->setNumChunks(_chunkMap.size());
 
                     // Once we load data, clear reference to old manager
                     _oldManager.reset();
@@ -714,10 +791,13 @@ namespace mongo {
      * differently
      *
      * The mongos adapter here tracks all shards, and stores ranges by (max, Chunk) in the map.
+     * It also remembers the bounds of each chunk it adds, so the rest of the load only has to
+     * look at those.
      */
-    class CMConfigDiffTracker : public ConfigDiffTracker<ChunkPtr,Shard> {
+    class CMConfigDiffTracker : public ConfigDiffTracker<ChunkPtr,Shard,ChunkMap> {
     public:
-        CMConfigDiffTracker( ChunkManager* manager ) : _manager( manager ) {}
+        CMConfigDiffTracker( ChunkManager* manager, vector<pair<BSONObj,BSONObj> >* changed )
+            : _manager( manager ), _changed( changed ) {}
 
         virtual bool isTracked( const BSONObj& chunkDoc ) const {
             // Mongos tracks all shards
@@ -732,6 +812,7 @@ namespace mongo {
 
         virtual pair<BSONObj,ChunkPtr> rangeFor( const BSONObj& chunkDoc, const BSONObj& min, const BSONObj& max ) const {
             ChunkPtr c( new Chunk( _manager, chunkDoc ) );
+            _changed->push_back( make_pair( min, max ) );
             return make_pair( max, c );
         }
 
@@ -744,6 +825,7 @@ namespace mongo {
         }
 
         ChunkManager* _manager;
+        vector<pair<BSONObj,BSONObj> >* _changed;
 
     };
 
@@ -751,8 +833,10 @@ namespace mongo {
                               ChunkMap& chunkMap,
                               set<Shard>& shards,
                               ShardVersionMap& shardVersions,
-                              ChunkManagerPtr oldManager)
+                              ChunkManagerPtr oldManager,
+                              vector<pair<BSONObj,BSONObj> >* changed)
     {
+        changed->clear();
 
         // Reset the max version, but not the epoch, when we aren't loading from the oldManager
         _version = ChunkVersion( 0, _version.epoch() );
@@ -767,41 +851,35 @@ namespace mongo {
             // Load a copy of the old versions
             shardVersions = oldManager->_shardVersions;
 
-            // Load a copy of the chunk map, replacing the chunk manager with our own
-            const ChunkMap& oldChunkMap = oldManager->getChunkMap();
-
-            // Could be v.expensive
-            // TODO: If chunks were immutable and didn't reference the manager, we could do more
-            // interesting things here
-            for( ChunkMap::const_iterator it = oldChunkMap.begin(); it != oldChunkMap.end(); it++ ){
-
-                ChunkPtr oldC = it->second;
-                ChunkPtr c( new Chunk( this, oldC->getMin(),
-                                             oldC->getMax(),
-                                             oldC->getShard(),
-                                             oldC->getLastmod() ) );
-
-                c->setBytesWritten( oldC->getBytesWritten() );
-
-                chunkMap.insert( make_pair( oldC->getMax(), c ) );
-            }
+            // Start from the old chunk map.  Chunks don't reference the manager that loaded
+            // them, so the copy can share them all, and only the diff is applied below.
+            chunkMap = oldManager->_chunkMap;
 
             // Also get any minor versions stored for reload
             oldManager->getMarkedMinorVersions( minorVersions );
 
             LOG(2) << "loading chunk manager for collection " << _ns
                    << " using old chunk manager w/ version " << _version.toString()
-                   << " and " << oldChunkMap.size() << " chunks" << endl;
+                   << " and " << chunkMap.size() << " chunks" << endl;
         }
 
         // Attach a diff tracker for the versioned chunk data
-        CMConfigDiffTracker differ( this );
+        CMConfigDiffTracker differ( this, changed );
         differ.attach( _ns, chunkMap, _version, shardVersions );
 
         // Diff tracker should *always* find at least one chunk if collection exists
         int diffsApplied = differ.calculateConfigDiff( config, minorVersions );
+
+        // Only what was added on top of the old chunks counts as a change
+        if( !oldManager || !oldManager->getVersion().isSet() || diffsApplied <= 0 )
+            changed->clear();
+
         if( diffsApplied > 0 ){
 
+            // The minor versions asked for were just reloaded
+            if( !minorVersions.empty() )
+                _shared->_splitHeuristics.clearMarkedMinorVersions( minorVersions );
+
             LOG(2) << "loaded " << diffsApplied << " chunks into new chunk manager for " << _ns
                    << " with version " << _version << endl;
 
@@ -853,18 +931,26 @@ namespace mongo {
     }
 
     ChunkManagerPtr ChunkManager::reload(bool force) const {
+        return _shared->reload(force);
+    }
+
+    ChunkManagerPtr ChunkManagerShared::reload(bool force) const {
         return grid.getDBConfig(getns())->getChunkManager(getns(), force);
     }
 
+    int ChunkManagerShared::getCurrentDesiredChunkSize() const {
+        return ChunkManager::desiredChunkSize( _numChunks.load() );
+    }
+
     void ChunkManager::markMinorForReload( ChunkVersion majorVersion ) const {
-        _splitHeuristics.markMinorForReload( getns(), majorVersion );
+        _shared->_splitHeuristics.markMinorForReload( getns(), majorVersion );
     }
 
     void ChunkManager::getMarkedMinorVersions( set<ChunkVersion>& minorVersions ) const {
-        _splitHeuristics.getMarkedMinorVersions( minorVersions );
+        _shared->_splitHeuristics.getMarkedMinorVersions( minorVersions );
     }
 
-    void ChunkManager::SplitHeuristics::markMinorForReload( const string& ns, ChunkVersion majorVersion ) {
+    void ChunkManagerShared::SplitHeuristics::markMinorForReload( const string& ns, ChunkVersion majorVersion ) {
 
         // When we get a stale minor version, it means that some *other* mongos has just split a
         // chunk into a number of smaller parts, so we shouldn't need reload the data needed to
@@ -902,13 +988,21 @@ namespace mongo {
             grid.getDBConfig( ns )->getChunkManagerIfExists( ns, true, true );
     }
 
-    void ChunkManager::SplitHeuristics::getMarkedMinorVersions( set<ChunkVersion>& minorVersions ) {
+    void ChunkManagerShared::SplitHeuristics::getMarkedMinorVersions( set<ChunkVersion>& minorVersions ) {
         scoped_lock lk( _staleMinorSetMutex );
         for( set<ChunkVersion>::iterator it = _staleMinorSet.begin(); it != _staleMinorSet.end(); it++ ){
             minorVersions.insert( *it );
         }
     }
 
+    void ChunkManagerShared::SplitHeuristics::clearMarkedMinorVersions(
+            const set<ChunkVersion>& minorVersions ) {
+        scoped_lock lk( _staleMinorSetMutex );
+        for( set<ChunkVersion>::const_iterator it = minorVersions.begin(); it != minorVersions.end(); it++ ){
+            _staleMinorSet.erase( *it );
+        }
+    }
+
     bool ChunkManager::_isValid(const ChunkMap& chunkMap) {
 #define ENSURE(x) do { if(!(x)) { log() << "ChunkManager::_isValid failed: " #x << endl; return false; } } while(0)
 
@@ -933,6 +1027,40 @@ namespace mongo {
 
         return true;
 
+#undef ENSURE
+    }
+
+    bool ChunkManager::_isValidAround(const ChunkMap& chunkMap,
+                                      const vector<pair<BSONObj,BSONObj> >& changed) {
+#define ENSURE(x) do { if(!(x)) { log() << "ChunkManager::_isValidAround failed: " #x << endl; return false; } } while(0)
+
+        // The diff tracker already refused overlaps, and any gap it left is next to a chunk
+        // it added, so checking each added chunk against its neighbors is enough.
+        for (vector<pair<BSONObj,BSONObj> >::const_iterator i = changed.begin();
+             i != changed.end(); ++i) {
+
+            ChunkMap::const_iterator it = chunkMap.find(i->second);
+            ENSURE(it != chunkMap.end());
+            ENSURE(it->second->getMin() == i->first);
+
+            if (it == chunkMap.begin()) {
+                ENSURE(allOfType(MinKey, it->second->getMin()));
+            }
+            else {
+                ENSURE(boost::prior(it)->second->getMax() == it->second->getMin());
+            }
+
+            ChunkMap::const_iterator next = boost::next(it);
+            if (next == chunkMap.end()) {
+                ENSURE(allOfType(MaxKey, it->second->getMax()));
+            }
+            else {
+                ENSURE(next->second->getMin() == it->second->getMax());
+            }
+        }
+
+        return true;
+
 #undef ENSURE
     }
 
@@ -1090,6 +1218,56 @@ namespace mongo {
                                    << ", number of chunks: " << _chunkMap.size() );
     }
 
+    namespace {
+        // orders indexes into points by the point
+        class PointIndexCmp {
+        public:
+            PointIndexCmp( const vector<BSONObj>& points ) : _points( points ) {}
+            bool operator()( size_t a, size_t b ) const {
+                return _points[a].woCompare( _points[b] ) < 0;
+            }
+        private:
+            const vector<BSONObj>& _points;
+        };
+    }
+
+    void ChunkManager::findIntersectingChunks( const vector<BSONObj>& points,
+                                               vector<ChunkPtr>* chunks ) const {
+        // binary searching again is cheaper than stepping through more chunks than this
+        const int maxSteps = 4;
+
+        vector<size_t> order( points.size() );
+        for ( size_t i = 0; i < order.size(); ++i )
+            order[i] = i;
+        sort( order.begin(), order.end(), PointIndexCmp( points ) );
+
+        chunks->assign( points.size(), ChunkPtr() );
+
+        ChunkMap::const_iterator it = _chunkMap.end();
+        for ( size_t i = 0; i < order.size(); ++i ) {
+            const BSONObj& point = points[order[i]];
+
+            // chunks are keyed by max, so step while this point is past the chunk
+            for ( int steps = 0;
+                  it != _chunkMap.end() && steps < maxSteps && it->first.woCompare( point ) <= 0;
+                  ++steps ) {
+                ++it;
+            }
+
+            if ( it == _chunkMap.end() || !it->second->containsPoint( point ) ) {
+                it = _chunkMap.upper_bound( point );
+                if ( it == _chunkMap.end() || !it->second->containsPoint( point ) ) {
+                    // fails the same way a single lookup would
+                    ( *chunks )[order[i]] = findIntersectingChunk( point );
+                    it = _chunkMap.end();
+                    continue;
+                }
+            }
+
+            ( *chunks )[order[i]] = it->second;
+        }
+    }
+
     ChunkPtr ChunkManager::findChunkForDoc( const BSONObj& doc ) const {
         BSONObj key = _key.extractKey( doc );
         return findIntersectingChunk( key );
@@ -1122,6 +1300,36 @@ namespace mongo {
             uassert(13502, "unrecognized special query type: " + special.toString(), false);
         }
 
+        if ( special.empty() ) {
+            StatusWithMatchExpression swme( Status::OK() );
+            try {
+                swme = MatchExpressionParser::parse( query );
+            }
+            catch ( const DBException& e ) {
+                swme = StatusWithMatchExpression( e.toStatus() );
+            }
+
+            // a query the new parser doesn't take still gets the old targeting below
+            if ( swme.isOK() ) {
+                boost::scoped_ptr<MatchExpression> expr( swme.getValue() );
+
+                vector<OrderedIntervalList> bounds;
+                BSONForEach( keyElt, _key.key() ) {
+                    bounds.push_back( OrderedIntervalList() );
+                    IndexBoundsBuilder::allValuesForField( keyElt, &bounds.back() );
+                }
+
+                _getShardsForExpression( expr.get(), bounds, shards );
+
+                // SERVER-4914: see below
+                if ( shards.empty() ) {
+                    massert( 17371, "no chunk ranges available", !_chunkRanges.ranges().empty() );
+                    shards.insert( _chunkRanges.ranges().begin()->second->getShard() );
+                }
+                return;
+            }
+        }
+
         do {
             boost::scoped_ptr<FieldRangeSetPair> frsp (org.topFrsp());
 
@@ -1159,6 +1367,191 @@ namespace mongo {
         }
     }
 
+    namespace {
+
+        // Compound shard key ranges aren't multiplied out past this many, the fields after the
+        // one that would go over get their whole range instead
+        const size_t kMaxTargetedRanges = 64 * 1024;
+
+        /**
+         * @return true if IndexBoundsBuilder can bound the field of expr.  Anything else, like
+         *     $exists, $ne or a range over a hashed field, leaves the field unbounded.
+         */
+        bool canBound( const MatchExpression* expr, bool hashed ) {
+            switch ( expr->matchType() ) {
+            case MatchExpression::EQ:
+                return true;
+            case MatchExpression::MATCH_IN:
+                return ! hashed ||
+                    static_cast<const InMatchExpression*>( expr )->getData().numRegexes() == 0;
+            case MatchExpression::LTE:
+            case MatchExpression::LT:
+            case MatchExpression::GT:
+            case MatchExpression::GTE:
+            case MatchExpression::REGEX:
+            case MatchExpression::MOD:
+            case MatchExpression::TYPE_OPERATOR:
+                return ! hashed;
+            default:
+                return false;
+            }
+        }
+
+        bool isPoint( const Interval& interval ) {
+            return interval.startInclusive && interval.endInclusive &&
+                interval.start.woCompare( interval.end, false ) == 0;
+        }
+
+        BSONObj appendField( const BSONObj& obj, const string& name, const BSONElement& value ) {
+            BSONObjBuilder b;
+            b.appendElements( obj );
+            b.appendAs( value, name );
+            return b.obj();
+        }
+
+        /** intersects bounds with what predicate allows for the shard key field it is over */
+        void boundField( const MatchExpression* predicate, const BSONObj& keyPattern,
+                         vector<OrderedIntervalList>* bounds ) {
+            size_t field = 0;
+            BSONForEach( keyElt, keyPattern ) {
+                if ( predicate->path() == keyElt.fieldName() &&
+                     canBound( predicate, str::equals( keyElt.valuestrsafe(), "hashed" ) ) ) {
+                    bool exact;
+                    IndexBoundsBuilder::translateAndIntersect( predicate, keyElt,
+                                                               &(*bounds)[field], &exact );
+                }
+                field++;
+            }
+        }
+
+        /**
+         * Intersects bounds with the predicates of an $and, or of its nested $ands, and collects
+         * the $ors it has into ors.
+         */
+        void boundAnd( const MatchExpression* expr, const BSONObj& keyPattern,
+                       vector<OrderedIntervalList>* bounds,
+                       vector<const MatchExpression*>* ors ) {
+
+            for ( size_t i = 0; i < expr->numChildren(); i++ ) {
+                const MatchExpression* child = expr->getChild( i );
+
+                if ( child->matchType() == MatchExpression::AND )
+                    boundAnd( child, keyPattern, bounds, ors );
+                else if ( child->matchType() == MatchExpression::OR )
+                    ors->push_back( child );
+                else
+                    boundField( child, keyPattern, bounds );
+            }
+        }
+    }
+
+    void ChunkManager::_getShardsForExpression( const MatchExpression* expr,
+                                                const vector<OrderedIntervalList>& bounds,
+                                                set<Shard>& shards ) const {
+
+        if ( shards.size() == _shards.size() )
+            return;
+
+        switch ( expr->matchType() ) {
+        case MatchExpression::ALWAYS_FALSE:
+            return;
+
+        case MatchExpression::OR:
+            for ( size_t i = 0; i < expr->numChildren(); i++ ) {
+                _getShardsForExpression( expr->getChild( i ), bounds, shards );
+                if ( shards.size() == _shards.size() )
+                    return;
+            }
+            return;
+
+        case MatchExpression::AND: {
+            vector<OrderedIntervalList> andBounds( bounds );
+            vector<const MatchExpression*> ors;
+            boundAnd( expr, _key.key(), &andBounds, &ors );
+
+            if ( ors.empty() ) {
+                _getShardsForBounds( andBounds, shards );
+                return;
+            }
+
+            // a document matching the $and matches a clause of each of its $ors, so it is on a
+            // shard that every one of them targets
+            set<Shard> common;
+            for ( size_t i = 0; i < ors.size(); i++ ) {
+                set<Shard> orShards;
+                _getShardsForExpression( ors[i], andBounds, orShards );
+                if ( i == 0 ) {
+                    common.swap( orShards );
+                    continue;
+                }
+
+                set<Shard> both;
+                std::set_intersection( common.begin(), common.end(),
+                                       orShards.begin(), orShards.end(),
+                                       std::inserter( both, both.begin() ) );
+                common.swap( both );
+            }
+            shards.insert( common.begin(), common.end() );
+            return;
+        }
+
+        default: {
+            vector<OrderedIntervalList> fieldBounds( bounds );
+            boundField( expr, _key.key(), &fieldBounds );
+            _getShardsForBounds( fieldBounds, shards );
+            return;
+        }
+        }
+    }
+
+    void ChunkManager::_getShardsForBounds( const vector<OrderedIntervalList>& bounds,
+                                            set<Shard>& shards ) const {
+
+        // Like KeyPattern::keyBounds: the intervals of the leading fields are multiplied out for
+        // as long as they are all points, and the fields after that add their whole span.  Shard
+        // keys are ascending or hashed, so the intervals are already in key order.
+        BoundList ranges( 1, make_pair( BSONObj(), BSONObj() ) );
+        bool pointsOnly = true;
+        for ( size_t field = 0; field < bounds.size(); field++ ) {
+            const vector<Interval>& intervals = bounds[field].intervals;
+            const string& name = bounds[field].name;
+
+            // no value of this field matches
+            if ( intervals.empty() )
+                return;
+
+            bool multiply = pointsOnly &&
+                ( ranges.size() == 1 || ranges.size() * intervals.size() <= kMaxTargetedRanges );
+
+            BoundList extended;
+            for ( BoundList::const_iterator it = ranges.begin(); it != ranges.end(); ++it ) {
+                if ( ! multiply ) {
+                    extended.push_back( make_pair(
+                        appendField( it->first, name, intervals.front().start ),
+                        appendField( it->second, name, intervals.back().end ) ) );
+                    continue;
+                }
+
+                for ( size_t i = 0; i < intervals.size(); i++ ) {
+                    extended.push_back( make_pair(
+                        appendField( it->first, name, intervals[i].start ),
+                        appendField( it->second, name, intervals[i].end ) ) );
+                }
+            }
+            ranges.swap( extended );
+
+            for ( size_t i = 0; multiply && i < intervals.size(); i++ )
+                multiply = isPoint( intervals[i] );
+            pointsOnly = multiply;
+        }
+
+        for ( BoundList::const_iterator it = ranges.begin(); it != ranges.end(); ++it ) {
+            getShardsForRange( shards, it->first, it->second );
+            if ( shards.size() == _shards.size() )
+                return;
+        }
+    }
+
     void ChunkManager::getShardsForRange( set<Shard>& shards,
                                           const BSONObj& min,
                                           const BSONObj& max ) const {
@@ -1326,7 +1719,7 @@ namespace mongo {
         return ss.str();
     }
 
-    void ChunkRangeManager::assertValid() const {
+    void ChunkRangeManager::assertValid(const ChunkMap& chunks) const {
         if (_ranges.empty())
             return;
 
@@ -1352,7 +1745,6 @@ namespace mongo {
             }
 
             // Make sure we match the original chunks
-            const ChunkMap chunks = _ranges.begin()->second->getManager()->_chunkMap;
             for ( ChunkMap::const_iterator i=chunks.begin(); i!=chunks.end(); ++i ) {
                 const ChunkPtr chunk = i->second;
 
@@ -1382,7 +1774,94 @@ namespace mongo {
         _ranges.clear();
         _insertRange(chunks.begin(), chunks.end());
 
-        DEV assertValid();
+        DEV assertValid(chunks);
+    }
+
+    namespace {
+        // orders chunk bounds by their min
+        struct LessMin {
+            bool operator()(const pair<BSONObj,BSONObj>& a, const pair<BSONObj,BSONObj>& b) const {
+                return a.first.woCompare(b.first) < 0;
+            }
+        };
+    }
+
+    void ChunkRangeManager::reloadChanged(const ChunkMap& chunks,
+                                          const vector<pair<BSONObj,BSONObj> >& changed) {
+        if (_ranges.empty()) {
+            reloadAll(chunks);
+            return;
+        }
+
+        // Join the changed bounds into disjoint spans, in order.  Outside of these the chunks,
+        // and so the ranges, are what they were.
+        vector<pair<BSONObj,BSONObj> > spans(changed);
+        sort(spans.begin(), spans.end(), LessMin());
+
+        size_t numSpans = 0;
+        for (size_t i = 0; i < spans.size(); i++) {
+            if (numSpans > 0 && spans[i].first.woCompare(spans[numSpans - 1].second) <= 0) {
+                if (spans[i].second.woCompare(spans[numSpans - 1].second) > 0)
+                    spans[numSpans - 1].second = spans[i].second;
+            }
+            else {
+                spans[numSpans++] = spans[i];
+            }
+        }
+        spans.resize(numSpans);
+
+        for (size_t i = 0; i < spans.size(); i++) {
+            const BSONObj& min = spans[i].first;
+            const BSONObj& max = spans[i].second;
+
+            // The ranges containing min and max may reach outside of the span, and only those
+            // parts of them are kept.
+            ChunkRangeMap::const_iterator first = _ranges.upper_bound(min);
+            ChunkRangeMap::const_iterator last = _ranges.upper_bound(max);
+            verify(first != _ranges.end());
+
+            shared_ptr<ChunkRange> before;
+            if (first->second->getMin().woCompare(min) < 0)
+                before.reset(new ChunkRange(*first->second, first->second->getMin(), min));
+
+            shared_ptr<ChunkRange> after;
+            shared_ptr<ChunkRange> lastRange;
+            if (last != _ranges.end() && last->second->getMin().woCompare(max) < 0) {
+                lastRange = last->second;
+                after.reset(new ChunkRange(*lastRange, max, lastRange->getMax()));
+                ++last;
+            }
+
+            _ranges.erase(first, last);
+
+            if (before)
+                _ranges.insert(make_pair(before->getMax(), before));
+            _insertRange(chunks.upper_bound(min), chunks.upper_bound(max));
+            if (after)
+                _ranges.insert(make_pair(after->getMax(), after));
+
+            _mergeAt(min);
+            _mergeAt(max);
+        }
+
+        DEV assertValid(chunks);
+    }
+
+    void ChunkRangeManager::_mergeAt(const BSONObj& key) {
+        // the range ending at key, if any, and the one after it
+        ChunkRangeMap::const_iterator left = _ranges.find(key);
+        if (left == _ranges.end())
+            return;
+        ChunkRangeMap::const_iterator right = boost::next(left);
+        if (right == _ranges.end() || right->second->getShard() != left->second->getShard())
+            return;
+
+        shared_ptr<ChunkRange> merged(new ChunkRange(*left->second, *right->second));
+        BSONObj leftKey = left->first;
+        BSONObj rightKey = right->first;
+        _ranges.erase(leftKey);
+        _ranges.erase(rightKey);
+        _ranges.insert(make_pair(merged->getMax(), merged));
     }
 
     void ChunkRangeManager::_insertRange(ChunkMap::const_iterator begin, const ChunkMap::const_iterator end) {
@@ -1393,18 +1872,20 @@ namespace mongo {
                 ++begin;
 
             shared_ptr<ChunkRange> cr (new ChunkRange(first, begin));
-            _ranges[cr->getMax()] = cr;
+            _ranges.insert(make_pair(cr->getMax(), cr));
         }
     }
 
     int ChunkManager::getCurrentDesiredChunkSize() const {
+        return desiredChunkSize( numChunks() );
+    }
+
+    int ChunkManager::desiredChunkSize( int nc ) {
         // split faster in early chunks helps spread out an initial load better
         const int minChunkSize = 1 << 20;  // 1 MBytes
 
         int splitThreshold = Chunk::MaxChunkSize;
 
-        int nc = numChunks();
-
         if ( nc <= 1 ) {
             return 1024;
         }
@@ -1426,7 +1907,8 @@ namespace mongo {
     _unique(),
     _chunkRanges(),
     _mutex( "ChunkManager" ),
-    _sequenceNumber()
+    _sequenceNumber(),
+    _shared( new ChunkManagerShared( _ns, _key ) )
     {}
 
     class ChunkObjUnitTest : public StartupTest {
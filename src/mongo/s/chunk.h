@@ -36,6 +36,7 @@
 #include "mongo/s/shard.h"
 #include "mongo/s/shardkey.h"
 #include "mongo/util/concurrency/ticketholder.h"
+#include "mongo/util/persistent_map.h"
 
 namespace mongo {
 
@@ -43,16 +44,92 @@ namespace mongo {
     class Chunk;
     class ChunkRange;
     class ChunkManager;
+    class ChunkManagerShared;
     class ChunkObjUnitTest;
+    class MatchExpression;
+    struct OrderedIntervalList;
 
     typedef shared_ptr<const Chunk> ChunkPtr;
 
     // key is max for each Chunk or ChunkRange
-    typedef map<BSONObj,ChunkPtr,BSONObjCmp> ChunkMap;
-    typedef map<BSONObj,shared_ptr<ChunkRange>,BSONObjCmp> ChunkRangeMap;
+    // Each reload of a ChunkManager starts from a copy of the previous version's maps, which
+    // share the unchanged entries, and changes just the chunks found in the diff.
+    typedef PersistentMap<BSONObj,ChunkPtr,BSONObjCmp> ChunkMap;
+    typedef PersistentMap<BSONObj,shared_ptr<ChunkRange>,BSONObjCmp> ChunkRangeMap;
 
     typedef shared_ptr<const ChunkManager> ChunkManagerPtr;
 
+    /**
+     * What all the versions of one collection's ChunkManager have in common.  Chunks point here
+     * rather than at the ChunkManager which loaded them, so a reload can keep the Chunks which
+     * didn't change, and the bytes written to them, instead of re-creating every one.
+     */
+    class ChunkManagerShared : boost::noncopyable {
+    public:
+        ChunkManagerShared( const string& ns, const ShardKeyPattern& key )
+            : _ns( ns ), _key( key ), _numChunks( 0 ) {}
+
+        const string& getns() const { return _ns; }
+        const ShardKeyPattern& getShardKey() const { return _key; }
+
+        // The split threshold for the number of chunks in the latest version loaded
+        int getCurrentDesiredChunkSize() const;
+        void setNumChunks( int numChunks ) { _numChunks.store( numChunks ); }
+
+        ChunkManagerPtr reload( bool force = true ) const;
+
+        //
+        // Split Heuristic info
+        //
+
+        class SplitHeuristics {
+        public:
+
+            SplitHeuristics() :
+                _splitTickets( maxParallelSplits ),
+                _staleMinorSetMutex( "SplitHeuristics::staleMinorSet" ),
+                _staleMinorCount( 0 ) {}
+
+            void markMinorForReload( const string& ns, ChunkVersion majorVersion );
+            void getMarkedMinorVersions( set<ChunkVersion>& minorVersions );
+            // Forgets minor versions which a reload has picked up
+            void clearMarkedMinorVersions( const set<ChunkVersion>& minorVersions );
+
+            TicketHolder _splitTickets;
+
+            mutex _staleMinorSetMutex;
+
+            // mutex protects below
+            int _staleMinorCount;
+            set<ChunkVersion> _staleMinorSet;
+
+            // Test whether we should split once data * splitTestFactor > chunkSize (approximately)
+            static const int splitTestFactor = 5;
+            // Maximum number of parallel threads requesting a split
+            static const int maxParallelSplits = 5;
+
+            // The idea here is that we're over-aggressive on split testing by a factor of
+            // splitTestFactor, so we can safely wait until we get to splitTestFactor invalid splits
+            // before changing.  Unfortunately, we also potentially over-request the splits by a
+            // factor of maxParallelSplits, but since the factors are identical it works out
+            // (for now) for parallel or sequential oversplitting.
+            // TODO: Make splitting a separate thread with notifications?
+            static const int staleMinorReloadThreshold = maxParallelSplits;
+
+        };
+
+        SplitHeuristics _splitHeuristics;
+
+        //
+        // End split heuristics
+        //
+
+    private:
+        const string _ns;
+        const ShardKeyPattern _key;
+        AtomicUInt32 _numChunks;
+    };
+
     /**
        config.chunks
        { ns : "alleyinsider.fs.chunks" , min : {} , max : {} , server : "localhost:30001" }
@@ -223,14 +300,13 @@ namespace mongo {
 
         string getns() const;
         Shard getShard() const { return _shard; }
-        const ChunkManager* getManager() const { return _manager; }
-        
 
     private:
 
         // main shard info
-        
-        const ChunkManager * _manager;
+
+        // shared by every version of the manager, so isn't tied to the one that loaded us
+        const shared_ptr<ChunkManagerShared> _shared;
 
         BSONObj _min;
         BSONObj _max;
@@ -255,6 +331,13 @@ namespace mongo {
          */
         BSONObj _getExtremeKey( int sort ) const;
 
+        /**
+         * @return the lowest shard key in this chunk that sorts after 'key', or an empty object
+         *     if there is none or the shard key is special.  Lets a forced split carve a chunk
+         *     dominated by one shard key value into that value and the rest.
+         */
+        BSONObj _getKeyAfter( const BSONObj& key ) const;
+
         /** initializes _dataWritten with a random value so that a mongos restart wouldn't cause delay in splitting */
         static int mkDataWritten();
 
@@ -263,7 +346,6 @@ namespace mongo {
 
     class ChunkRange {
     public:
-        const ChunkManager* getManager() const { return _manager; }
         Shard getShard() const { return _shard; }
 
         const BSONObj& getMin() const { return _min; }
@@ -278,14 +360,12 @@ namespace mongo {
         bool containsPoint( const BSONObj& point ) const;
 
         ChunkRange(ChunkMap::const_iterator begin, const ChunkMap::const_iterator end)
-            : _manager(begin->second->getManager())
-            , _shard(begin->second->getShard())
+            : _shard(begin->second->getShard())
             , _min(begin->second->getMin())
             , _max(boost::prior(end)->second->getMax()) {
             verify( begin != end );
 
             DEV while (begin != end) {
-                verify(begin->second->getManager() == _manager);
                 verify(begin->second->getShard() == _shard);
                 ++begin;
             }
@@ -293,21 +373,28 @@ namespace mongo {
 
         // Merge min and max (must be adjacent ranges)
         ChunkRange(const ChunkRange& min, const ChunkRange& max)
-            : _manager(min.getManager())
-            , _shard(min.getShard())
+            : _shard(min.getShard())
             , _min(min.getMin())
             , _max(max.getMax()) {
             verify(min.getShard() == max.getShard());
-            verify(min.getManager() == max.getManager());
             verify(min.getMax() == max.getMin());
         }
 
+        // The part of range from min to max (which must be inside it)
+        ChunkRange(const ChunkRange& range, const BSONObj& min, const BSONObj& max)
+            : _shard(range.getShard())
+            , _min(min)
+            , _max(max) {
+            verify(range.getMin().woCompare(min) <= 0);
+            verify(min.woCompare(max) < 0);
+            verify(max.woCompare(range.getMax()) <= 0);
+        }
+
         friend ostream& operator<<(ostream& out, const ChunkRange& cr) {
             return (out << "ChunkRange(min=" << cr._min << ", max=" << cr._max << ", shard=" << cr._shard <<")");
         }
 
     private:
-        const ChunkManager* _manager;
         const Shard _shard;
         const BSONObj _min;
         const BSONObj _max;
@@ -322,8 +409,14 @@ namespace mongo {
 
         void reloadAll(const ChunkMap& chunks);
 
+        /**
+         * Updates ranges built from an earlier version of the chunks to match chunks, given the
+         * [min, max) bounds of every chunk added since.  Costs about O(log n) per changed chunk.
+         */
+        void reloadChanged(const ChunkMap& chunks, const vector<pair<BSONObj,BSONObj> >& changed);
+
         // Slow operation -- wrap with DEV
-        void assertValid() const;
+        void assertValid(const ChunkMap& chunks) const;
 
         ChunkRangeMap::const_iterator upper_bound(const BSONObj& o) const { return _ranges.upper_bound(o); }
         ChunkRangeMap::const_iterator lower_bound(const BSONObj& o) const { return _ranges.lower_bound(o); }
@@ -332,6 +425,9 @@ namespace mongo {
         // assumes nothing in this range exists in _ranges
         void _insertRange(ChunkMap::const_iterator begin, const ChunkMap::const_iterator end);
 
+        // joins the ranges either side of key, if they're on the same shard
+        void _mergeAt(const BSONObj& key);
+
         ChunkRangeMap _ranges;
     };
 
@@ -413,6 +509,14 @@ namespace mongo {
          */
         ChunkPtr findIntersectingChunk( const BSONObj& point ) const;
 
+        /**
+         * Does findIntersectingChunk() for many points at once, setting chunks to the chunk for
+         * each.  The points are sorted and the chunk map is walked once, so points on or near
+         * the same chunks cost little more than finding the chunks.
+         */
+        void findIntersectingChunks( const vector<BSONObj>& points,
+                                     vector<ChunkPtr>* chunks ) const;
+
 
         ChunkPtr findChunkOnServer( const Shard& shard ) const;
 
@@ -421,6 +525,7 @@ namespace mongo {
         /** @param shards set to the shards covered by the interval [min, max], see SERVER-4791 */
         void getShardsForRange( set<Shard>& shards, const BSONObj& min, const BSONObj& max ) const;
 
+        // Cheap: the copy shares the map's structure
         ChunkMap getChunkMap() const { return _chunkMap; }
 
         /**
@@ -447,6 +552,7 @@ namespace mongo {
         void _printChunks() const;
 
         int getCurrentDesiredChunkSize() const;
+        static int desiredChunkSize( int numChunks );
 
         ChunkManagerPtr reload(bool force=true) const; // doesn't modify self!
 
@@ -458,12 +564,34 @@ namespace mongo {
         // helpers for loading
 
         // returns true if load was consistent
+        // changed is set to the bounds of the chunks added on top of oldManager's, or cleared if
+        // the chunks weren't loaded from it
         bool _load( const string& config, ChunkMap& chunks, set<Shard>& shards,
-                                    ShardVersionMap& shardVersions, ChunkManagerPtr oldManager);
+                    ShardVersionMap& shardVersions, ChunkManagerPtr oldManager,
+                    vector<pair<BSONObj,BSONObj> >* changed );
         static bool _isValid(const ChunkMap& chunks);
+        // only checks around the changed chunks, for chunks that were valid before they changed
+        static bool _isValidAround(const ChunkMap& chunks,
+                                   const vector<pair<BSONObj,BSONObj> >& changed);
 
         // end helpers
 
+        // helpers for getShardsForQuery
+
+        /**
+         * Adds the shards that may have documents matching expr whose shard key fields are also
+         * within bounds, one interval list per field of the shard key.  An $or adds the shards of
+         * each of its clauses, so matching chunks are found for every clause, however deeply
+         * nested, rather than the clauses being widened into one range.
+         */
+        void _getShardsForExpression( const MatchExpression* expr,
+                                      const vector<OrderedIntervalList>& bounds,
+                                      set<Shard>& shards ) const;
+
+        /** adds the shards of the chunks that intersect the ranges of the shard key in bounds */
+        void _getShardsForBounds( const vector<OrderedIntervalList>& bounds,
+                                  set<Shard>& shards ) const;
+
         // All members should be const for thread-safety
         const string _ns;
         const ShardKeyPattern _key;
@@ -487,53 +615,9 @@ namespace mongo {
 
         const unsigned long long _sequenceNumber;
 
-        //
-        // Split Heuristic info
-        //
-
-
-        class SplitHeuristics {
-        public:
-
-            SplitHeuristics() :
-                _splitTickets( maxParallelSplits ),
-                _staleMinorSetMutex( "SplitHeuristics::staleMinorSet" ),
-                _staleMinorCount( 0 ) {}
-
-            void markMinorForReload( const string& ns, ChunkVersion majorVersion );
-            void getMarkedMinorVersions( set<ChunkVersion>& minorVersions );
-
-            TicketHolder _splitTickets;
-
-            mutex _staleMinorSetMutex;
-
-            // mutex protects below
-            int _staleMinorCount;
-            set<ChunkVersion> _staleMinorSet;
-
-            // Test whether we should split once data * splitTestFactor > chunkSize (approximately)
-            static const int splitTestFactor = 5;
-            // Maximum number of parallel threads requesting a split
-            static const int maxParallelSplits = 5;
-
-            // The idea here is that we're over-aggressive on split testing by a factor of
-            // splitTestFactor, so we can safely wait until we get to splitTestFactor invalid splits
-            // before changing.  Unfortunately, we also potentially over-request the splits by a
-            // factor of maxParallelSplits, but since the factors are identical it works out
-            // (for now) for parallel or sequential oversplitting.
-            // TODO: Make splitting a separate thread with notifications?
-            static const int staleMinorReloadThreshold = maxParallelSplits;
-
-        };
-
-        mutable SplitHeuristics _splitHeuristics;
-
-        //
-        // End split heuristics
-        //
+        const shared_ptr<ChunkManagerShared> _shared;
 
         friend class Chunk;
-        friend class ChunkRangeManager; // only needed for CRM::assertValid()
         static AtomicUInt NextSequenceNumber;
         
         /** Just for testing */
@@ -573,7 +657,7 @@ namespace mongo {
         Chunk _c;
     };
     */
-    inline string Chunk::genID() const { return genID(_manager->getns(), _min); }
+    inline string Chunk::genID() const { return genID(_shared->getns(), _min); }
 
     bool setShardVersion( DBClientBase & conn,
                           const string& ns,
@@ -107,6 +107,47 @@ namespace mongo {
         return Status::OK();
     }
 
+    void ChunkManagerTargeter::targetDocs( const vector<BSONObj>& docs,
+                                           vector<ShardEndpoint*>* endpoints,
+                                           vector<Status>* statuses ) const {
+
+        if ( !_manager ) {
+            // Unsharded, or not found
+            NSTargeter::targetDocs( docs, endpoints, statuses );
+            return;
+        }
+
+        vector<BSONObj> keys;
+        vector<size_t> keyDocs;
+        size_t firstDoc = statuses->size();
+        for ( size_t i = 0; i < docs.size(); ++i ) {
+            if ( !_manager->hasShardKey( docs[i] ) ) {
+                statuses->push_back( Status( ErrorCodes::ShardKeyNotFound,
+                                             stream() << "document " << docs[i]
+                                                      << " does not contain shard key for pattern "
+                                                      << _manager->getShardKey().key() ) );
+            }
+            else {
+                statuses->push_back( Status::OK() );
+                keys.push_back( _manager->getShardKey().extractKey( docs[i] ) );
+                keyDocs.push_back( i );
+            }
+            endpoints->push_back( NULL );
+        }
+
+        vector<ChunkPtr> chunks;
+        _manager->findIntersectingChunks( keys, &chunks );
+
+        for ( size_t i = 0; i < keys.size(); ++i ) {
+            const Shard& shard = chunks[i]->getShard();
+            ( *endpoints )[firstDoc + keyDocs[i]] = new ShardEndpoint( shard.getName(),
+                                                                       _manager->getVersion( shard ),
+                                                                       shard.getAddress() );
+
+            _stats->chunkSizeDelta[chunks[i]->getMin()] += docs[keyDocs[i]].objsize();
+        }
+    }
+
     Status ChunkManagerTargeter::targetQuery( const BSONObj& query,
                                               vector<ShardEndpoint*>* endpoints ) const {
 
@@ -52,6 +52,14 @@ namespace mongo {
 
         Status targetDoc( const BSONObj& doc, ShardEndpoint** endpoint ) const;
 
+        /**
+         * Extracts the shard keys of all the docs, then finds all their chunks in one pass over
+         * the chunk map.
+         */
+        void targetDocs( const std::vector<BSONObj>& docs,
+                         std::vector<ShardEndpoint*>* endpoints,
+                         std::vector<Status>* statuses ) const;
+
         Status targetQuery( const BSONObj& query, std::vector<ShardEndpoint*>* endpoints ) const;
 
         void noteStaleResponse( const ShardEndpoint& endpoint, const BSONObj& staleInfo );
@@ -41,6 +41,7 @@
 #include "mongo/db/field_parser.h"
 #include "mongo/db/hasher.h"
 #include "mongo/db/index_names.h"
+#include "mongo/db/keypattern.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/db/wire_version.h"
 #include "mongo/s/chunk.h"
@@ -54,6 +55,7 @@
 #include "mongo/s/writeback_listener.h"
 #include "mongo/util/net/listen.h"
 #include "mongo/util/net/message.h"
+#include "mongo/util/net/message_compression.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/ramlog.h"
 #include "mongo/util/stringutils.h"
@@ -462,14 +464,30 @@ namespace mongo {
                         ( IndexNames::findPluginName( proposedKey ) == IndexNames::HASHED );
 
                 // Currently the allowable shard keys are either
-                // i) a hashed single field, e.g. { a : "hashed" }, or
+                // i) a hashed field, optionally followed by ascending fields, e.g.
+                //    { a : "hashed" } or { a : "hashed" , b : 1 }, or
                 // ii) a compound list of ascending fields, e.g. { a : 1 , b : 1 }
+                //
+                // The hashed field of i) spreads the documents over the chunks, while the
+                // ascending fields after it keep each hashed value's documents in order, so a
+                // range query on them that fixes the hashed field targets only the chunks
+                // holding that value.
                 if ( isHashedShardKey ) {
                     // case i)
-                    if ( proposedKey.nFields() > 1 ) {
-                        errmsg = "hashed shard keys currently only support single field keys";
+                    BSONObjIterator it( proposedKey );
+                    BSONElement hashedElt = it.next();
+                    if ( !str::equals( hashedElt.valuestrsafe() , "hashed" ) ) {
+                        errmsg = "the hashed field of a hashed shard key must come first";
                         return false;
                     }
+                    while ( it.more() ) {
+                        BSONElement e = it.next();
+                        if ( !e.isNumber() || e.number() != 1.0 ) {
+                            errmsg = "the fields after the hashed field of a shard key must be "
+                                     "ascending";
+                            return false;
+                        }
+                    }
                     if ( cmdObj["unique"].trueValue() ) {
                         // it's possible to ensure uniqueness on the hashed field by
                         // declaring an additional (non-hashed) unique index on the field,
@@ -482,7 +500,8 @@ namespace mongo {
                     BSONForEach(e, proposedKey) {
                         if (!e.isNumber() || e.number() != 1.0) {
                             errmsg = str::stream() << "Unsupported shard key pattern.  Pattern must"
-                                                   << " either be a single hashed field, or a list"
+                                                   << " either be a hashed field followed by any"
+                                                   << " ascending fields, or a list"
                                                    << " of ascending fields.";
                             return false;
                         }
@@ -701,6 +720,12 @@ namespace mongo {
                     }
                     sort( allSplits.begin() , allSplits.end() );
 
+                    // split points must name every field of a compound hashed key
+                    KeyPattern keyPattern( proposedKey );
+                    for ( size_t i = 0; i < allSplits.size(); i++ ) {
+                        allSplits[i] = keyPattern.extendRangeBound( allSplits[i] , false );
+                    }
+
                     // 1. the initial splits define the "big chunks" that we will subdivide later
                     int lastIndex = -1;
                     for ( int i = 1; i < numShards; i++ ){
@@ -1378,6 +1403,7 @@ namespace mongo {
                 // compiled for.
                 result.append("maxWireVersion", maxWireVersion);
                 result.append("minWireVersion", minWireVersion);
+                negotiateMessageCompression(cmdObj, ClientBasic::getCurrent()->port(), result);
 
                 return true;
             }
@@ -1024,44 +1024,44 @@ namespace mongo {
                     return passthrough( conf , cmdObj , options, result );
                 }
 
-                ChunkManagerPtr cm = conf->getChunkManager( fullns );
-                massert( 10420 ,  "how could chunk manager be null!" , cm );
-
                 BSONObj query = getQuery(cmdObj);
-                set<Shard> shards;
-                cm->getShardsForQuery(shards, query);
 
-                set<BSONObj,BSONObjCmp> all;
-                int size = 32;
-
-                for ( set<Shard>::iterator i=shards.begin(), end=shards.end() ; i != end; ++i ) {
-                    ShardConnection conn( *i , fullns );
-                    BSONObj res;
-                    bool ok = conn->runCommand( conf->getName() , cmdObj , res, options );
-                    conn.done();
+                // Ask all the shards at once
+                vector<Strategy::CommandResult> distinctResult;
+                SHARDED->commandOp( dbName, cmdObj, options, fullns, query, &distinctResult );
 
-                    if ( ! ok ) {
-                        result.appendElements( res );
+                for ( vector<Strategy::CommandResult>::const_iterator i = distinctResult.begin();
+                        i != distinctResult.end(); ++i ) {
+                    if ( ! i->result["ok"].trueValue() ) {
+                        result.appendElements( i->result );
                         return false;
                     }
+                }
+
+                // The shards' responses are kept until we're done, so the set points into them
+                // rather than copying every value
+                BSONElementSet all;
+                int size = 0;
 
-                    BSONObjIterator it( res["values"].embeddedObject() );
+                for ( vector<Strategy::CommandResult>::const_iterator i = distinctResult.begin();
+                        i != distinctResult.end(); ++i ) {
+                    BSONObjIterator it( i->result["values"].embeddedObject() );
                     while ( it.more() ) {
                         BSONElement nxt = it.next();
-                        BSONObjBuilder temp(32);
-                        temp.appendAs( nxt , "" );
-                        all.insert( temp.obj() );
-                    }
+                        if ( ! all.insert( nxt ).second )
+                            continue;
 
+                        size += nxt.size();
+                        uassert( 17370, "distinct too big, 16mb cap",
+                                 size + 1024 < BSONObjMaxUserSize );
+                    }
                 }
 
-                BSONObjBuilder b( size );
-                int n=0;
-                for ( set<BSONObj,BSONObjCmp>::iterator i = all.begin() ; i != all.end(); i++ ) {
-                    b.appendAs( i->firstElement() , b.numStr( n++ ) );
+                BSONArrayBuilder b( result.subarrayStart( "values" ) );
+                for ( BSONElementSet::const_iterator i = all.begin(); i != all.end(); ++i ) {
+                    b.append( *i );
                 }
-
-                result.appendArray( "values" , b.obj() );
+                b.doneFast();
                 return true;
             }
         } disinctCmd;
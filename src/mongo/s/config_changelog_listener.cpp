@@ -0,0 +1,170 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/pch.h"
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "mongo/client/connpool.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/s/config.h"
+#include "mongo/s/config_changelog_listener.h"
+#include "mongo/s/grid.h"
+#include "mongo/s/type_changelog.h"
+
+namespace mongo {
+
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(configChangelogListener, bool, true);
+
+    namespace {
+
+        // Thread that tails config.changelog.
+        boost::scoped_ptr<boost::thread> _listenerThread;
+
+        // Entries stamped this long before the last one seen are read again when the cursor is
+        // reopened, so that a writer with a slow clock isn't missed.  Repeats cost only a version
+        // check against config.chunks.
+        const long long kClockSlackMillis = 60 * 1000;
+
+        /**
+         * Refreshes whatever this mongos has cached for the namespaces of a batch of changelog
+         * entries: chunk changes reload the ChunkManager, which only reads the chunks newer than
+         * the cached version, and collection or database changes reload the DBConfig.
+         */
+        void applyChanges( const set<string>& chunkChanges, const set<string>& dbChanges,
+                           const set<string>& droppedDbs ) {
+
+            for ( set<string>::const_iterator i = droppedDbs.begin(); i != droppedDbs.end(); ++i ) {
+                DBConfigPtr config = grid.getLoadedDBConfig( *i );
+                if ( config ) {
+                    LOG(1) << "changelog: database " << *i << " dropped" << endl;
+                    grid.removeDBIfExists( *config );
+                }
+            }
+
+            for ( set<string>::const_iterator i = dbChanges.begin(); i != dbChanges.end(); ++i ) {
+                DBConfigPtr config = grid.getLoadedDBConfig( *i );
+                if ( config && ! droppedDbs.count( nsToDatabase( *i ) ) ) {
+                    LOG(1) << "changelog: reloading config for " << *i << endl;
+                    config->reload();
+                }
+            }
+
+            for ( set<string>::const_iterator i = chunkChanges.begin();
+                  i != chunkChanges.end(); ++i ) {
+                DBConfigPtr config = grid.getLoadedDBConfig( *i );
+                if ( ! config || ! config->isSharded( *i ) )
+                    continue;
+                LOG(1) << "changelog: refreshing chunks of " << *i << endl;
+                config->getChunkManagerIfExists( *i, true );
+            }
+        }
+
+        void listenToChangelog() {
+            Date_t since = jsTime();
+
+            while ( ! inShutdown() ) {
+                try {
+                    ScopedDbConnection conn( configServer.modelServer() );
+
+                    BSONObj query = BSON( ChangelogType::time.name() <<
+                                          BSON( "$gt" << Date_t( since.millis -
+                                                                 kClockSlackMillis ) ) );
+                    auto_ptr<DBClientCursor> cursor =
+                        conn->query( ChangelogType::ConfigNS, query, 0, 0, 0,
+                                     QueryOption_CursorTailable | QueryOption_AwaitData );
+
+                    while ( cursor.get() && ! inShutdown() ) {
+                        // with AwaitData the config server holds each getMore for a while when
+                        // there's nothing new
+                        if ( ! cursor->more() ) {
+                            if ( cursor->isDead() )
+                                break;
+                            continue;
+                        }
+
+                        set<string> chunkChanges;
+                        set<string> dbChanges;
+                        set<string> droppedDbs;
+                        while ( cursor->moreInCurrentBatch() ) {
+                            BSONObj entry = cursor->nextSafe();
+
+                            Date_t time = entry[ChangelogType::time.name()].date();
+                            if ( time.millis > since.millis )
+                                since = time;
+
+                            string what = entry[ChangelogType::what.name()].str();
+                            string ns = entry[ChangelogType::ns.name()].str();
+                            if ( ns.empty() )
+                                continue;
+
+                            if ( what == "split" || what == "multi-split" ||
+                                 what == "merge" || what == "moveChunk.commit" ) {
+                                chunkChanges.insert( ns );
+                            }
+                            else if ( what == "shardCollection" || what == "dropCollection" ||
+                                      what == "movePrimary" ) {
+                                dbChanges.insert( ns );
+                            }
+                            else if ( what == "dropDatabase" ) {
+                                droppedDbs.insert( ns );
+                            }
+                        }
+
+                        applyChanges( chunkChanges, dbChanges, droppedDbs );
+                    }
+
+                    if ( cursor.get() && ! cursor->isDead() )
+                        conn.kill();
+                    else
+                        conn.done();
+                }
+                catch ( const DBException& e ) {
+                    LOG(1) << "error tailing " << ChangelogType::ConfigNS << causedBy( e ) << endl;
+                }
+
+                // the cursor dies straight away while the changelog is empty or missing
+                sleepsecs( 1 );
+            }
+        }
+    }
+
+    bool startConfigChangelogListener() {
+        if ( ! configChangelogListener )
+            return false;
+
+        if ( _listenerThread == NULL ) {
+            _listenerThread.reset( new boost::thread( listenToChangelog ) );
+        }
+
+        return _listenerThread != NULL;
+    }
+}
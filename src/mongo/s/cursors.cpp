@@ -60,6 +60,7 @@ namespace mongo {
         _ntoreturn = q.ntoreturn;
 
         _totalSent = 0;
+        _totalBytesSent = 0;
         _done = false;
 
         _id = 0;
@@ -89,6 +90,19 @@ namespace mongo {
         return _totalSent;
     }
 
+    int ShardedClientCursor::getReplyBufferSize( int ntoreturn ) const {
+        if ( _totalSent == 0 )
+            return INIT_REPLY_BUFFER_SIZE;
+
+        const long long maxSize = 3 * 1024 * 1024;
+        long long avgObjSize = _totalBytesSent / _totalSent;
+        ntoreturn = abs( ntoreturn );
+
+        long long size = ntoreturn > 0 ? avgObjSize * ntoreturn + avgObjSize : maxSize + avgObjSize;
+        return static_cast<int>( std::max( static_cast<long long>( INIT_REPLY_BUFFER_SIZE ),
+                                           std::min( size, maxSize + avgObjSize ) ) );
+    }
+
     void ShardedClientCursor::accessed() {
         if ( _lastAccessMillis > 0 )
             _lastAccessMillis = Listener::getElapsedTimeMillis();
@@ -101,7 +115,7 @@ namespace mongo {
     }
 
     bool ShardedClientCursor::sendNextBatchAndReply( Request& r ){
-        BufBuilder buffer( INIT_REPLY_BUFFER_SIZE );
+        BufBuilder buffer( getReplyBufferSize( _ntoreturn ) );
         int docCount = 0;
         bool hasMore = sendNextBatch( r, _ntoreturn, buffer, docCount );
         replyToQuery( 0, r.p(), r.m(), buffer.buf(), buffer.len(), docCount,
@@ -119,6 +133,7 @@ namespace mongo {
             maxSize *= 3;
 
         docCount = 0;
+        const long long bytesBefore = _totalBytesSent;
 
         // Send more if ntoreturn is 0, or any value > 1
         // (one is assumed to be a single doc return, with no cursor)
@@ -144,6 +159,18 @@ namespace mongo {
                 // first batch should be max 100 unless batch size specified
                 break;
             }
+
+            // stop before a document of the usual size would go over the limit, rather than after
+            long long avgObjSize = ( bytesBefore + buffer.len() ) / ( _totalSent + docCount );
+            if ( buffer.len() + avgObjSize > maxSize ) {
+                break;
+            }
+
+            // with half a batch in hand, reply instead of waiting on a shard; the shards read
+            // ahead while the client works through this one
+            if ( buffer.len() >= maxSize / 2 && ! _cursor->nextIsBuffered() ) {
+                break;
+            }
         }
 
         bool hasMore = sendMore && _cursor->more();
@@ -158,6 +185,7 @@ namespace mongo {
                << " totalSent: " << _totalSent << endl;
 
         _totalSent += docCount;
+        _totalBytesSent += buffer.len();
         _done = ! hasMore;
 
         return hasMore;
@@ -175,28 +203,36 @@ namespace mongo {
     CursorCache::CursorCache()
         :_mutex( "CursorCache" ),
          _random( getCCRandomSeed() ),
-         _shardedTotal(0) {
+         _nextTimeoutPartition( 0 ) {
     }
 
     CursorCache::~CursorCache() {
         // TODO: delete old cursors?
+        size_t numCursors = 0;
+        size_t numRefs = 0;
+        for ( int p = 0; p < kNumPartitions; p++ ) {
+            verify(_partitions[p].refs.size() == _partitions[p].refsNS.size());
+            numCursors += _partitions[p].cursors.size();
+            numRefs += _partitions[p].refs.size();
+        }
+
         bool print = logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(1));
-        if ( _cursors.size() || _refs.size() )
+        if ( numCursors || numRefs )
             print = true;
-        verify(_refs.size() == _refsNS.size());
         
         if ( print ) 
             log() << " CursorCache at shutdown - "
-                  << " sharded: " << _cursors.size()
-                  << " passthrough: " << _refs.size()
+                  << " sharded: " << numCursors
+                  << " passthrough: " << numRefs
                   << endl;
     }
 
     ShardedClientCursorPtr CursorCache::get( long long id ) const {
         LOG(_myLogLevel) << "CursorCache::get id: " << id << endl;
-        scoped_lock lk( _mutex );
-        MapSharded::const_iterator i = _cursors.find( id );
-        if ( i == _cursors.end() ) {
+        const Partition& partition = partitionFor( id );
+        scoped_lock lk( partition.mutex );
+        MapSharded::const_iterator i = partition.cursors.find( id );
+        if ( i == partition.cursors.end() ) {
             OCCASIONALLY log() << "Sharded CursorCache missing cursor id: " << id << endl;
             return ShardedClientCursorPtr();
         }
@@ -207,52 +243,67 @@ namespace mongo {
     void CursorCache::store( ShardedClientCursorPtr cursor ) {
         LOG(_myLogLevel) << "CursorCache::store cursor " << " id: " << cursor->getId() << endl;
         verify( cursor->getId() );
-        scoped_lock lk( _mutex );
-        _cursors[cursor->getId()] = cursor;
-        _shardedTotal++;
+        Partition& partition = partitionFor( cursor->getId() );
+        scoped_lock lk( partition.mutex );
+        partition.cursors[cursor->getId()] = cursor;
+        partition.shardedTotal++;
     }
     void CursorCache::remove( long long id ) {
         verify( id );
-        scoped_lock lk( _mutex );
-        _cursors.erase( id );
+        Partition& partition = partitionFor( id );
+
+        // destroyed once the mutex is released, as that kills the cursors on the shards
+        ShardedClientCursorPtr removed;
+        {
+            scoped_lock lk( partition.mutex );
+            MapSharded::iterator i = partition.cursors.find( id );
+            if ( i == partition.cursors.end() )
+                return;
+            removed = i->second;
+            partition.cursors.erase( i );
+        }
     }
     
     void CursorCache::removeRef( long long id ) {
         verify( id );
-        scoped_lock lk( _mutex );
-        _refs.erase( id );
-        _refsNS.erase( id );
+        Partition& partition = partitionFor( id );
+        scoped_lock lk( partition.mutex );
+        partition.refs.erase( id );
+        partition.refsNS.erase( id );
     }
 
     void CursorCache::storeRef(const std::string& server, long long id, const std::string& ns) {
         LOG(_myLogLevel) << "CursorCache::storeRef server: " << server << " id: " << id << endl;
         verify( id );
-        scoped_lock lk( _mutex );
-        _refs[id] = server;
-        _refsNS[id] = ns;
+        Partition& partition = partitionFor( id );
+        scoped_lock lk( partition.mutex );
+        partition.refs[id] = server;
+        partition.refsNS[id] = ns;
     }
 
     string CursorCache::getRef( long long id ) const {
         verify( id );
-        scoped_lock lk( _mutex );
-        MapNormal::const_iterator i = _refs.find( id );
+        const Partition& partition = partitionFor( id );
+        scoped_lock lk( partition.mutex );
+        MapNormal::const_iterator i = partition.refs.find( id );
 
-        LOG(_myLogLevel) << "CursorCache::getRef id: " << id << " out: " << ( i == _refs.end() ? " NONE " : i->second ) << endl;
+        LOG(_myLogLevel) << "CursorCache::getRef id: " << id << " out: " << ( i == partition.refs.end() ? " NONE " : i->second ) << endl;
 
-        if ( i == _refs.end() )
+        if ( i == partition.refs.end() )
             return "";
         return i->second;
     }
 
     std::string CursorCache::getRefNS(long long id) const {
         verify(id);
-        scoped_lock lk(_mutex);
-        MapNormal::const_iterator i = _refsNS.find(id);
+        const Partition& partition = partitionFor( id );
+        scoped_lock lk( partition.mutex );
+        MapNormal::const_iterator i = partition.refsNS.find(id);
 
         LOG(_myLogLevel) << "CursorCache::getRefNs id: " << id
-                << " out: " << ( i == _refsNS.end() ? " NONE " : i->second ) << std::endl;
+                << " out: " << ( i == partition.refsNS.end() ? " NONE " : i->second ) << std::endl;
 
-        if ( i == _refsNS.end() )
+        if ( i == partition.refsNS.end() )
             return "";
         return i->second;
     }
@@ -260,10 +311,11 @@ namespace mongo {
 
     long long CursorCache::genId() {
         while ( true ) {
-            scoped_lock lk( _mutex );
-
             long long x = Listener::getElapsedTimeMillis() << 32;
-            x |= _random.nextInt32();
+            {
+                scoped_lock lk( _mutex );
+                x |= _random.nextInt32();
+            }
 
             if ( x == 0 )
                 continue;
@@ -271,12 +323,15 @@ namespace mongo {
             if ( x < 0 )
                 x *= -1;
 
-            MapSharded::iterator i = _cursors.find( x );
-            if ( i != _cursors.end() )
+            const Partition& partition = partitionFor( x );
+            scoped_lock lk( partition.mutex );
+
+            MapSharded::const_iterator i = partition.cursors.find( x );
+            if ( i != partition.cursors.end() )
                 continue;
 
-            MapNormal::iterator j = _refs.find( x );
-            if ( j != _refs.end() )
+            MapNormal::const_iterator j = partition.refs.find( x );
+            if ( j != partition.refs.end() )
                 continue;
 
             return x;
@@ -309,11 +364,13 @@ namespace mongo {
             }
 
             string server;
+            ShardedClientCursorPtr killed;
             {
-                scoped_lock lk( _mutex );
+                Partition& partition = partitionFor( id );
+                scoped_lock lk( partition.mutex );
 
-                MapSharded::iterator i = _cursors.find( id );
-                if ( i != _cursors.end() ) {
+                MapSharded::iterator i = partition.cursors.find( id );
+                if ( i != partition.cursors.end() ) {
                     const bool isAuthorized = authSession->isAuthorizedForActionsOnNamespace(
                             NamespaceString(i->second->getNS()), ActionType::killCursors);
                     audit::logKillCursorsAuthzCheck(
@@ -322,31 +379,37 @@ namespace mongo {
                             id,
                             isAuthorized ? ErrorCodes::OK : ErrorCodes::Unauthorized);
                     if (isAuthorized) {
-                        _cursors.erase( i );
+                        // destroyed below, without the mutex
+                        killed = i->second;
+                        partition.cursors.erase( i );
                     }
-                    continue;
-                }
-
-                MapNormal::iterator refsIt = _refs.find(id);
-                MapNormal::iterator refsNSIt = _refsNS.find(id);
-                if (refsIt == _refs.end()) {
-                    warning() << "can't find cursor: " << id << endl;
-                    continue;
                 }
-                verify(refsNSIt != _refsNS.end());
-                const bool isAuthorized = authSession->isAuthorizedForActionsOnNamespace(
-                        NamespaceString(refsNSIt->second), ActionType::killCursors);
-                audit::logKillCursorsAuthzCheck(
-                        client,
-                        NamespaceString(refsNSIt->second),
-                        id,
-                        isAuthorized ? ErrorCodes::OK : ErrorCodes::Unauthorized);
-                if (!isAuthorized) {
-                    continue;
+                else {
+                    MapNormal::iterator refsIt = partition.refs.find(id);
+                    MapNormal::iterator refsNSIt = partition.refsNS.find(id);
+                    if (refsIt == partition.refs.end()) {
+                        warning() << "can't find cursor: " << id << endl;
+                        continue;
+                    }
+                    verify(refsNSIt != partition.refsNS.end());
+                    const bool isAuthorized = authSession->isAuthorizedForActionsOnNamespace(
+                            NamespaceString(refsNSIt->second), ActionType::killCursors);
+                    audit::logKillCursorsAuthzCheck(
+                            client,
+                            NamespaceString(refsNSIt->second),
+                            id,
+                            isAuthorized ? ErrorCodes::OK : ErrorCodes::Unauthorized);
+                    if (!isAuthorized) {
+                        continue;
+                    }
+                    server = refsIt->second;
+                    partition.refs.erase(refsIt);
+                    partition.refsNS.erase(refsNSIt);
                 }
-                server = refsIt->second;
-                _refs.erase(refsIt);
-                _refsNS.erase(refsNSIt);
+            }
+
+            if ( killed ) {
+                continue;
             }
 
             LOG(_myLogLevel) << "CursorCache::found gotKillCursors id: " << id << " server: " << server << endl;
@@ -359,27 +422,45 @@ namespace mongo {
     }
 
     void CursorCache::appendInfo( BSONObjBuilder& result ) const {
-        scoped_lock lk( _mutex );
-        result.append( "sharded" , (int)_cursors.size() );
-        result.appendNumber( "shardedEver" , _shardedTotal );
-        result.append( "refs" , (int)_refs.size() );
-        result.append( "totalOpen" , (int)(_cursors.size() + _refs.size() ) );
+        int numCursors = 0;
+        long long shardedTotal = 0;
+        int numRefs = 0;
+        for ( int p = 0; p < kNumPartitions; p++ ) {
+            scoped_lock lk( _partitions[p].mutex );
+            numCursors += _partitions[p].cursors.size();
+            shardedTotal += _partitions[p].shardedTotal;
+            numRefs += _partitions[p].refs.size();
+        }
+
+        result.append( "sharded" , numCursors );
+        result.appendNumber( "shardedEver" , shardedTotal );
+        result.append( "refs" , numRefs );
+        result.append( "totalOpen" , numCursors + numRefs );
     }
 
     void CursorCache::doTimeouts() {
+        Partition* partition;
+        {
+            scoped_lock lk( _mutex );
+            partition = &_partitions[_nextTimeoutPartition];
+            _nextTimeoutPartition = ( _nextTimeoutPartition + 1 ) % kNumPartitions;
+        }
+
+        // destroyed once the mutex is released, as that kills the cursors on the shards
+        vector<ShardedClientCursorPtr> timedOut;
+
         long long now = Listener::getElapsedTimeMillis();
-        scoped_lock lk( _mutex );
-        for ( MapSharded::iterator i=_cursors.begin(); i!=_cursors.end(); ++i ) {
+        scoped_lock lk( partition->mutex );
+        for ( MapSharded::iterator i = partition->cursors.begin(); i != partition->cursors.end(); ) {
             // Note: cursors with no timeout will always have an idleTime of 0
             long long idleFor = i->second->idleTime( now );
             if ( idleFor < TIMEOUT ) {
+                ++i;
                 continue;
             }
             log() << "killing old cursor " << i->second->getId() << " idle for: " << idleFor << "ms" << endl; // TODO: make LOG(1)
-            _cursors.erase( i );
-            i = _cursors.begin(); // possible 2nd entry will get skipped, will get on next pass
-            if ( i == _cursors.end() )
-                break;
+            timedOut.push_back( i->second );
+            partition->cursors.erase( i++ );
         }
     }
 
@@ -396,7 +477,8 @@ namespace mongo {
     };
 
     void CursorCache::startTimeoutThread() {
-        task::repeat( new CursorTimeoutTask , 4000 );
+        // every partition is looked at every 4 seconds
+        task::repeat( new CursorTimeoutTask , 4000 / kNumPartitions );
     }
 
     class CmdCursorInfo : public Command {
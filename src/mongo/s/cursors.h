@@ -75,6 +75,12 @@ namespace mongo {
          */
         bool sendNextBatch( Request& r, int ntoreturn, BufBuilder& buffer, int& docCount );
 
+        /**
+         * @return a starting size for the buffer of a batch of up to ntoreturn documents, from
+         *         the average size of the documents this cursor sent so far
+         */
+        int getReplyBufferSize( int ntoreturn ) const;
+
         void accessed();
         /** @return idle time in ms */
         long long idleTime( long long now );
@@ -92,6 +98,7 @@ namespace mongo {
         int _ntoreturn;
 
         int _totalSent;
+        long long _totalBytesSent;
         bool _done;
 
         long long _id;
@@ -130,18 +137,43 @@ namespace mongo {
 
         long long genId();
 
+        /** Times out the idle cursors of the next partition; each call takes the next one. */
         void doTimeouts();
         void startTimeoutThread();
     private:
-        mutable mongo::mutex _mutex;
+        /**
+         * The cursors whose ids fall in one partition, under their own mutex so that requests
+         * on different cursors rarely wait on each other.
+         */
+        struct Partition {
+            Partition() : mutex( "CursorCache" ), shardedTotal( 0 ) {}
+
+            mutable mongo::mutex mutex;
+
+            MapSharded cursors;
+            MapNormal refs; // Maps cursor ID to shard name
+            MapNormal refsNS; // Maps cursor ID to namespace
+
+            long long shardedTotal;
+        };
+
+        static const int kNumPartitions = 16;
+
+        Partition& partitionFor( long long id ) {
+            return _partitions[ static_cast<unsigned long long>( id ) % kNumPartitions ];
+        }
+        const Partition& partitionFor( long long id ) const {
+            return _partitions[ static_cast<unsigned long long>( id ) % kNumPartitions ];
+        }
+
+        Partition _partitions[kNumPartitions];
+
+        // Protects _random and _nextTimeoutPartition.
+        mongo::mutex _mutex;
 
         PseudoRandom _random;
 
-        MapSharded _cursors;
-        MapNormal _refs; // Maps cursor ID to shard name
-        MapNormal _refsNS; // Maps cursor ID to namespace
-        
-        long long _shardedTotal;
+        int _nextTimeoutPartition;
 
         static const int _myLogLevel;
     };
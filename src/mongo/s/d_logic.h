@@ -33,7 +33,9 @@
 #include "mongo/pch.h"
 
 #include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/s/collection_metadata.h"
+#include "mongo/s/split_key_sketch.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/util/net/message.h"
@@ -128,6 +130,12 @@ namespace mongo {
         bool needCollectionMetadata( const string& ns ) const;
         CollectionMetadataPtr getCollectionMetadata( const string& ns );
 
+        /**
+         * Bumped every time any collection's metadata is installed, replaced or dropped, so
+         * callers caching metadata can tell cheaply whether what they hold is still current.
+         */
+        unsigned long long getMetadataGeneration() const { return _metadataGeneration.load(); }
+
         // chunk migrate and split support
 
         /**
@@ -272,6 +280,9 @@ namespace mongo {
         // Map from a namespace into the metadata we need for each collection on this shard
         typedef map<string,CollectionMetadataPtr> CollectionMetadataMap;
         CollectionMetadataMap _collMetadata;
+
+        // written under _mutex after _collMetadata changes, read without it
+        AtomicUInt64 _metadataGeneration;
     };
 
     extern ShardingState shardingState;
@@ -291,8 +302,19 @@ namespace mongo {
         const ChunkVersion getVersion( const string& ns ) const;
         void setVersion( const string& ns , const ChunkVersion& version );
 
+        /**
+         * The shard's current metadata for ns, as ShardingState::getCollectionMetadata returns
+         * it, but cached on this connection so that each op doesn't take ShardingState's mutex
+         * and copy the pointer.  The reference is valid until the next call.
+         */
+        const CollectionMetadataPtr& getCollectionMetadata( const string& ns );
+
         static ShardedConnectionInfo* get( bool create );
         static void reset();
+        /** detaches this thread's info, if any, without deleting it */
+        static ShardedConnectionInfo* release();
+        /** gives this thread info that release() took from another one */
+        static void attach( ShardedConnectionInfo* info );
         static void addHook();
 
         bool inForceVersionOkMode() const {
@@ -310,6 +332,14 @@ namespace mongo {
         typedef map<string,ChunkVersion> NSVersionMap;
         NSVersionMap _versions;
 
+        struct CachedMetadata {
+            CachedMetadata() : generation( ~0ULL ) {}
+            unsigned long long generation; // of shardingState when metadata was read
+            CollectionMetadataPtr metadata;
+        };
+        typedef map<string,CachedMetadata> NSMetadataMap;
+        NSMetadataMap _metadata;
+
         static boost::thread_specific_ptr<ShardedConnectionInfo> _tl;
     };
 
@@ -376,4 +406,7 @@ namespace mongo {
 
     void aboutToDeleteForSharding( const StringData& ns, const Database* db , const DiskLoc& dl );
 
+    // Samples of the shard keys in this shard's chunks, which splitVector takes split points from
+    extern ChunkKeySketches chunkKeySketches;
+
 }
@@ -51,6 +51,7 @@
 #include "mongo/db/auth/authorization_manager_global.h"
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/auth/privilege.h"
+#include "mongo/db/catalog/index_catalog.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/dbhelpers.h"
@@ -62,10 +63,13 @@
 #include "mongo/db/pagefault.h"
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/range_deleter_service.h"
+#include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/replication_server_status.h"
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/repl/rs_config.h"
 #include "mongo/db/repl/write_concern.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/structure/collection.h"
 #include "mongo/logger/ramlog.h"
 #include "mongo/s/chunk.h"
 #include "mongo/s/chunk_version.h"
@@ -197,6 +201,16 @@ namespace mongo {
     }
 
 
+    // How long the donor aims to block writes to a migrating chunk for.  Once the recipient has
+    // caught up, the donor only enters the critical section when the mods still queued would take
+    // the recipient about this long to apply going by how long it has taken so far, or once it
+    // has waited migrateCriticalSectionMaxWaitSecs for that.
+    MONGO_EXPORT_SERVER_PARAMETER(migrateCriticalSectionBudgetMillis, int, 100);
+    MONGO_EXPORT_SERVER_PARAMETER(migrateCriticalSectionMaxWaitSecs, int, 60);
+
+    // The donor aborts a migration whose queued mods take more memory than this.
+    MONGO_EXPORT_SERVER_PARAMETER(migrateMaxQueuedModsMB, int, 500);
+
     class MigrateFromStatus {
     public:
 
@@ -302,8 +316,7 @@ namespace mongo {
                 }
 
                 // can't filter deletes :(
-                _deleted.push_back( ide.wrap() );
-                _memoryUsed += ide.size() + 5;
+                queueMod( &_deleted , ide );
                 return;
             }
 
@@ -323,11 +336,20 @@ namespace mongo {
             if ( ! isInRange( it , _min , _max , _shardKeyPattern ) )
                 return;
 
-            _reload.push_back( ide.wrap() );
-            _memoryUsed += ide.size() + 5;
+            queueMod( &_reload , ide );
         }
 
-        void xfer( list<BSONObj> * l , BSONObjBuilder& b , const char * name , long long& size , bool explode ) {
+        /**
+         * Queues the _id of a document changed while migrating, unless it's queued already:
+         * both deletes and reloads are applied as of when they're transferred, so a document
+         * written many times between two _transferMods only needs sending once.
+         */
+        void queueMod( BSONObjSet* mods , const BSONElement& ide ) {
+            if ( mods->insert( ide.wrap() ).second )
+                _memoryUsed += ide.size() + 5;
+        }
+
+        void xfer( BSONObjSet* l , BSONObjBuilder& b , const char * name , long long& size , bool explode ) {
             const long long maxSize = 1024 * 1024;
 
             if ( l->size() == 0 || size > maxSize )
@@ -335,7 +357,7 @@ namespace mongo {
 
             BSONArrayBuilder arr(b.subarrayStart(name));
 
-            list<BSONObj>::iterator i = l->begin();
+            BSONObjSet::iterator i = l->begin();
 
             while ( i != l->end() && size < maxSize ) {
                 BSONObj t = *i;
@@ -349,8 +371,9 @@ namespace mongo {
                 else {
                     arr.append( t );
                 }
-                i = l->erase( i );
+                l->erase( i++ );
                 size += t.objsize();
+                _memoryUsed -= t.firstElement().size() + 5;
             }
 
             arr.done();
@@ -538,9 +561,9 @@ namespace mongo {
             return true;
         }
 
-        void aboutToDelete( const Database* db , const DiskLoc& dl ) {
+        void aboutToDelete( const StringData& ns , const Database* db , const DiskLoc& dl ) {
             verify(db);
-            Lock::assertWriteLocked(db->name());
+            Lock::assertWriteLocked(ns);
 
             if ( ! _getActive() )
                 return;
@@ -563,6 +586,9 @@ namespace mongo {
 
         long long mbUsed() const { return _memoryUsed / ( 1024 * 1024 ); }
 
+        /** @return deletes and reloads waiting for _transferMods; read without a lock */
+        size_t modsQueued() const { return _deleted.size() + _reload.size(); }
+
         bool getInCriticalSection() const {
             scoped_lock l(_mutex);
             return _inCriticalSection;
@@ -617,8 +643,8 @@ namespace mongo {
         // updates applied by 1 thread in a write lock
         set<DiskLoc> _cloneLocs;
 
-        list<BSONObj> _reload; // objects that were modified that must be recloned
-        list<BSONObj> _deleted; // objects deleted during clone that should be deleted later
+        BSONObjSet _reload; // _ids of objects that were modified that must be recloned
+        BSONObjSet _deleted; // _ids of objects deleted during clone that should be deleted later
         long long _memoryUsed; // bytes in _reload + _deleted
 
         bool _getActive() const { scoped_lock l(_mutex); return _active; }
@@ -655,6 +681,10 @@ namespace mongo {
                           bool notInActiveChunk) {
         // TODO: include fullObj?
         migrateFromStatus.logOp(opstr, ns, obj, patt, notInActiveChunk);
+
+        if ( opstr[0] == 'i' && !notInActiveChunk ) {
+            chunkKeySketches.noteInsert( ns, obj );
+        }
     }
 
     void aboutToDeleteForSharding( const StringData& ns,
@@ -662,10 +692,10 @@ namespace mongo {
                                    const NamespaceDetails* nsd,
                                    const DiskLoc& dl )
     {
-        // Note: namespace is currently unused since we only have a single migration per host,
-        // but will be needed for parallel migrations.
+        // Note: namespace is only used for lock checks since we only have a single migration per
+        // host, but will be needed for parallel migrations.
         if ( nsd->isCapped() ) return;
-        migrateFromStatus.aboutToDelete( db, dl );
+        migrateFromStatus.aboutToDelete( ns, db, dl );
     }
 
     class TransferModsCommand : public ChunkCommandHelper {
@@ -1045,11 +1075,14 @@ namespace mongo {
 
             // Track last result from TO shard for sanity check
             BSONObj res;
+            // Started once the TO shard is steady but too far behind to enter the critical section
+            scoped_ptr<Timer> steadyTimer;
             for ( int i=0; i<86400; i++ ) { // don't want a single chunk move to take more than a day
                 verify( !Lock::isLocked() );
                 // Exponential sleep backoff, up to 1024ms. Don't sleep much on the first few
-                // iterations, since we want empty chunk migrations to be fast.
-                sleepmillis( 1 << std::min( i , 10 ) );
+                // iterations, since we want empty chunk migrations to be fast.  Once the TO shard
+                // is steady it keeps pulling mods, so check back soon.
+                sleepmillis( steadyTimer ? 10 : 1 << std::min( i , 10 ) );
                 ScopedDbConnection conn(toShard.getConnString());
                 bool ok;
                 res = BSONObj();
@@ -1082,7 +1115,7 @@ namespace mongo {
                     return false;
                 }
 
-                LOG(0) << "moveChunk data transfer progress: " << res << " my mem used: " << migrateFromStatus.mbUsed() << migrateLog;
+                LOG( steadyTimer ? 1 : 0 ) << "moveChunk data transfer progress: " << res << " my mem used: " << migrateFromStatus.mbUsed() << migrateLog;
 
                 if ( ! ok || res["state"].String() == "fail" ) {
                     warning() << "moveChunk error transferring data caused migration abort: " << res << migrateLog;
@@ -1091,10 +1124,24 @@ namespace mongo {
                     return false;
                 }
 
-                if ( res["state"].String() == "steady" )
-                    break;
+                if ( res["state"].String() == "steady" ) {
+                    // Only block writes once what's left can be applied within the budget.
+                    const double microsPerMod = res["counts"]["applyMicrosPerMod"].numberDouble();
+                    const double leftMillis = migrateFromStatus.modsQueued() * microsPerMod / 1000;
+                    if ( leftMillis <= migrateCriticalSectionBudgetMillis ) {
+                        break;
+                    }
+                    if ( !steadyTimer ) {
+                        steadyTimer.reset( new Timer() );
+                    }
+                    else if ( steadyTimer->seconds() >= migrateCriticalSectionMaxWaitSecs ) {
+                        warning() << "moveChunk entering critical section over budget, about "
+                                  << leftMillis << "ms of mods queued" << migrateLog;
+                        break;
+                    }
+                }
 
-                if ( migrateFromStatus.mbUsed() > (500 * 1024 * 1024) ) {
+                if ( migrateFromStatus.mbUsed() > migrateMaxQueuedModsMB ) {
                     // this is too much memory for us to use for this
                     // so we're going to abort the migrate
                     ScopedDbConnection conn(toShard.getConnString());
@@ -1497,6 +1544,49 @@ namespace mongo {
     MONGO_FP_DECLARE(migrateThreadHangAtStep4);
     MONGO_FP_DECLARE(migrateThreadHangAtStep5);
 
+    /**
+     * Runs one _migrateClone against the donor on a thread of its own, so the recipient can
+     * insert the last batch while the donor reads the next.
+     */
+    class CloneBatchFetcher : boost::noncopyable {
+    public:
+        explicit CloneBatchFetcher( DBClientBase* conn ) : _conn( conn ), _ok( false ) {
+            _thread.reset( new boost::thread( boost::bind( &CloneBatchFetcher::_run, this ) ) );
+        }
+        ~CloneBatchFetcher() {
+            if ( _thread )
+                _thread->join();
+        }
+
+        /** waits for the batch.  @return false if the command failed, res then saying why */
+        bool get( BSONObj* res ) {
+            _thread->join();
+            _thread.reset();
+            *res = _res;
+            return _ok;
+        }
+
+    private:
+        void _run() {
+            try {
+                // gets array of objects to copy, in disk order
+                _ok = _conn->runCommand( "admin" , BSON( "_migrateClone" << 1 ) , _res );
+            }
+            catch ( std::exception& e ) {
+                _ok = false;
+                _res = BSON( "errmsg" << e.what() );
+            }
+        }
+
+        DBClientBase* _conn;
+        bool _ok;
+        BSONObj _res;
+        scoped_ptr<boost::thread> _thread;
+    };
+
+    // documents the recipient clones per write lock; other writers get in between runs
+    static const size_t cloneDocsPerLock = 128;
+
     class MigrateStatus {
     public:
         
@@ -1513,6 +1603,7 @@ namespace mongo {
             clonedBytes = 0;
             numCatchup = 0;
             numSteady = 0;
+            applyMicros = 0;
 
             active = true;
         }
@@ -1651,9 +1742,12 @@ namespace mongo {
                 // 3. initial bulk clone
                 state = CLONE;
 
+                scoped_ptr<CloneBatchFetcher> fetcher( new CloneBatchFetcher( conn.get() ) );
                 while ( true ) {
                     BSONObj res;
-                    if ( ! conn->runCommand( "admin" , BSON( "_migrateClone" << 1 ) , res ) ) {  // gets array of objects to copy, in disk order
+                    bool ok = fetcher->get( &res );
+                    fetcher.reset();
+                    if ( ! ok ) {
                         state = FAIL;
                         errmsg = "_migrateClone failed: ";
                         errmsg += res.toString();
@@ -1663,52 +1757,12 @@ namespace mongo {
                     }
 
                     BSONObj arr = res["objects"].Obj();
-                    int thisTime = 0;
-
-                    BSONObjIterator i( arr );
-                    while( i.more() ) {
-                        BSONObj o = i.next().Obj();
-                        {
-                            PageFaultRetryableSection pgrs;
-                            while ( 1 ) {
-                                try {
-                                    Client::WriteContext cx( ns );
-
-                                    BSONObj localDoc;
-                                    if ( willOverrideLocalId( o, &localDoc ) ) {
-                                        string errMsg =
-                                            str::stream() << "cannot migrate chunk, local document "
-                                                          << localDoc
-                                                          << " has same _id as cloned "
-                                                          << "remote document " << o;
-
-                                        warning() << errMsg << endl;
-
-                                        // Exception will abort migration cleanly
-                                        uasserted( 16976, errMsg );
-                                    }
-
-                                    Helpers::upsert( ns, o, true );
-                                    break;
-                                }
-                                catch ( PageFaultException& e ) {
-                                    e.touch();
-                                }
-                            }
-                        }
-                        thisTime++;
-                        numCloned++;
-                        clonedBytes += o.objsize();
-
-                        if ( secondaryThrottle && thisTime > 0 ) {
-                            if ( ! waitForReplication( cc().getLastOp(), 2, 60 /* seconds to wait */ ) ) {
-                                warning() << "secondaryThrottle on, but doc insert timed out after 60 seconds, continuing" << endl;
-                            }
-                        }
-                    }
-
-                    if ( thisTime == 0 )
+                    if ( arr.isEmpty() )
                         break;
+
+                    // the donor reads the next batch while we insert this one
+                    fetcher.reset( new CloneBatchFetcher( conn.get() ) );
+                    cloneDocuments( arr );
                 }
 
                 timing.done(3);
@@ -1735,7 +1789,12 @@ namespace mongo {
                         break;
 
                     apply( res , &lastOpApplied );
-                    
+
+                    // Without secondaryThrottle we only wait for the secondaries once, below,
+                    // before entering the critical section.
+                    if ( ! secondaryThrottle )
+                        continue;
+
                     const int maxIterations = 3600*50;
                     int i;
                     for ( i=0;i<maxIterations; i++) {
@@ -1853,6 +1912,9 @@ namespace mongo {
                 bb.append( "clonedBytes" , clonedBytes );
                 bb.append( "catchup" , numCatchup );
                 bb.append( "steady" , numSteady );
+                const long long numMods = numCatchup + numSteady;
+                bb.append( "applyMicrosPerMod" ,
+                           numMods ? static_cast<double>( applyMicros ) / numMods : 0.0 );
                 bb.done();
             }
 
@@ -1866,7 +1928,10 @@ namespace mongo {
             }
 
             bool didAnything = false;
+            long long numMods = 0;
+            Timer t;
 
+            // Like cloned documents, the mods are applied cloneDocsPerLock of them per write lock.
             if ( xfer["deleted"].isABSONObj() ) {
                 Helpers::RemoveSaver rs( "moveChunk" , ns , "removedDuring" );
 
@@ -1874,32 +1939,35 @@ namespace mongo {
                 while ( i.more() ) {
                     Client::WriteContext cx(ns);
 
-                    BSONObj id = i.next().Obj();
+                    for ( size_t n = 0; n < cloneDocsPerLock && i.more(); ++n ) {
+                        BSONObj id = i.next().Obj();
+                        ++numMods;
 
-                    // do not apply deletes if they do not belong to the chunk being migrated
-                    BSONObj fullObj;
-                    if ( Helpers::findById( cc() , ns.c_str() , id, fullObj ) ) {
-                        if ( ! isInRange( fullObj , min , max , shardKeyPattern ) ) {
-                            log() << "not applying out of range deletion: " << fullObj << migrateLog;
+                        // do not apply deletes if they do not belong to the chunk being migrated
+                        BSONObj fullObj;
+                        if ( Helpers::findById( cc() , ns.c_str() , id, fullObj ) ) {
+                            if ( ! isInRange( fullObj , min , max , shardKeyPattern ) ) {
+                                log() << "not applying out of range deletion: " << fullObj << migrateLog;
 
-                            continue;
+                                continue;
+                            }
                         }
-                    }
 
-                    // id object most likely has form { _id : ObjectId(...) }
-                    // infer from that correct index to use, e.g. { _id : 1 }
-                    BSONObj idIndexPattern = Helpers::inferKeyPattern( id );
+                        // id object most likely has form { _id : ObjectId(...) }
+                        // infer from that correct index to use, e.g. { _id : 1 }
+                        BSONObj idIndexPattern = Helpers::inferKeyPattern( id );
 
-                    // TODO: create a better interface to remove objects directly
-                    KeyRange range( ns, id, id, idIndexPattern );
-                    Helpers::removeRange( range ,
-                                          true , /*maxInclusive*/
-                                          false , /* secondaryThrottle */
-                                          serverGlobalParams.moveParanoia ? &rs : 0 , /*callback*/
-                                          true ); /*fromMigrate*/
+                        // TODO: create a better interface to remove objects directly
+                        KeyRange range( ns, id, id, idIndexPattern );
+                        Helpers::removeRange( range ,
+                                              true , /*maxInclusive*/
+                                              false , /* secondaryThrottle */
+                                              serverGlobalParams.moveParanoia ? &rs : 0 , /*callback*/
+                                              true ); /*fromMigrate*/
 
-                    *lastOpApplied = cx.ctx().getClient()->getLastOp().asDate();
-                    didAnything = true;
+                        *lastOpApplied = cx.ctx().getClient()->getLastOp().asDate();
+                        didAnything = true;
+                    }
                 }
             }
 
@@ -1908,30 +1976,40 @@ namespace mongo {
                 while ( i.more() ) {
                     Client::WriteContext cx(ns);
 
-                    BSONObj it = i.next().Obj();
+                    for ( size_t n = 0; n < cloneDocsPerLock && i.more(); ++n ) {
+                        BSONObj it = i.next().Obj();
+                        ++numMods;
 
-                    BSONObj localDoc;
-                    if ( willOverrideLocalId( it, &localDoc ) ) {
-                        string errMsg =
-                            str::stream() << "cannot migrate chunk, local document "
-                                          << localDoc
-                                          << " has same _id as reloaded remote document "
-                                          << it;
+                        BSONObj localDoc;
+                        if ( willOverrideLocalId( it, &localDoc ) ) {
+                            string errMsg =
+                                str::stream() << "cannot migrate chunk, local document "
+                                              << localDoc
+                                              << " has same _id as reloaded remote document "
+                                              << it;
 
-                        warning() << errMsg << endl;
+                            warning() << errMsg << endl;
 
-                        // Exception will abort migration cleanly
-                        uasserted( 16977, errMsg );
-                    }
+                            // Exception will abort migration cleanly
+                            uasserted( 16977, errMsg );
+                        }
 
-                    // We are in write lock here, so sure we aren't killing
-                    Helpers::upsert( ns , it , true );
+                        // We are in write lock here, so sure we aren't killing
+                        Helpers::upsert( ns , it , true );
 
-                    *lastOpApplied = cx.ctx().getClient()->getLastOp().asDate();
-                    didAnything = true;
+                        *lastOpApplied = cx.ctx().getClient()->getLastOp().asDate();
+                        didAnything = true;
+                    }
                 }
             }
 
+            // what the FROM shard goes by to decide when to enter the critical section
+            applyMicros += t.micros();
+            if ( state == CATCHUP )
+                numCatchup += numMods;
+            else
+                numSteady += numMods;
+
             return didAnything;
         }
 
@@ -1941,6 +2019,103 @@ namespace mongo {
          * Must be in WriteContext to avoid races and DBHelper errors.
          * TODO: Could optimize this check out if sharding on _id.
          */
+        /**
+         * Inserts the documents of one _migrateClone batch, cloneDocsPerLock of them per write
+         * lock, holding back the keys of non-unique indexes to put in each btree in one pass (see
+         * IndexCatalog::beginBatchInsert).  Documents whose _id is already here go through
+         * Helpers::upsert.
+         */
+        void cloneDocuments( const BSONObj& arr ) {
+            vector<BSONObj> docs;
+            BSONObjIterator i( arr );
+            while ( i.more() )
+                docs.push_back( i.next().Obj() );
+
+            size_t next = 0;
+            PageFaultRetryableSection pgrs;
+            while ( next < docs.size() ) {
+                try {
+                    Client::WriteContext cx( ns );
+                    const size_t runEnd = std::min( docs.size(), next + cloneDocsPerLock );
+
+                    IndexCatalog* batch = NULL;
+                    try {
+                        while ( next < runEnd ) {
+                            const BSONObj& o = docs[next];
+
+                            BSONObj localDoc;
+                            if ( willOverrideLocalId( o, &localDoc ) ) {
+                                string errMsg =
+                                    str::stream() << "cannot migrate chunk, local document "
+                                                  << localDoc
+                                                  << " has same _id as cloned "
+                                                  << "remote document " << o;
+
+                                warning() << errMsg << endl;
+
+                                // Exception will abort migration cleanly
+                                uasserted( 16976, errMsg );
+                            }
+
+                            // the first document may create the collection
+                            Collection* collection = cx.ctx().db()->getCollection( ns );
+                            if ( localDoc.isEmpty() && collection &&
+                                 !collection->details()->isCapped() &&
+                                 collection->details()->findIdIndex() >= 0 ) {
+                                if ( !batch ) {
+                                    batch = collection->getIndexCatalog();
+                                    batch->beginBatchInsert();
+                                }
+                                StatusWith<DiskLoc> loc = collection->insertDocument( o, false );
+                                uassertStatusOK( loc.getStatus() );
+                                logOp( "i", ns.c_str(), o, NULL, NULL, true /* fromMigrate */ );
+                            }
+                            else {
+                                // the upsert must see every key inserted so far
+                                finishBatchInsert( &batch );
+                                Helpers::upsert( ns, o, true );
+                            }
+
+                            next++;
+                            numCloned++;
+                            clonedBytes += o.objsize();
+
+                            // a document and its keys must go to the journal in the same group
+                            // commit
+                            if ( batch && getDur().aCommitIsNeeded() )
+                                finishBatchInsert( &batch );
+                            getDur().commitIfNeeded();
+                        }
+                    }
+                    catch ( ... ) {
+                        finishBatchInsert( &batch );
+                        throw;
+                    }
+                    finishBatchInsert( &batch );
+                }
+                catch ( PageFaultException& e ) {
+                    // documents before next are in, with their keys; retry from next
+                    e.touch();
+                    continue;
+                }
+
+                if ( secondaryThrottle ) {
+                    if ( ! waitForReplication( cc().getLastOp(), 2, 60 /* seconds to wait */ ) ) {
+                        warning() << "secondaryThrottle on, but doc insert timed out after 60 seconds, continuing" << endl;
+                    }
+                }
+            }
+        }
+
+        static void finishBatchInsert( IndexCatalog** batch ) {
+            if ( !*batch )
+                return;
+            // the held back keys of documents already inserted can't wait for a retry
+            NoPageFaultsAllowed npfa;
+            (*batch)->finishBatchInsert();
+            *batch = NULL;
+        }
+
         bool willOverrideLocalId( BSONObj remoteDoc, BSONObj* localDoc ) {
 
             *localDoc = BSONObj();
@@ -2038,6 +2213,7 @@ namespace mongo {
         long long clonedBytes;
         long long numCatchup;
         long long numSteady;
+        long long applyMicros; // spent applying the catchup and steady mods
         bool secondaryThrottle;
 
         int replSetMajorityCount;
@@ -51,11 +51,13 @@
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/config.h"
 #include "mongo/s/d_logic.h"
+#include "mongo/s/split_key_sketch.h"
 #include "mongo/s/type_chunk.h"
 #include "mongo/util/timer.h"
 
 namespace mongo {
 
+    ChunkKeySketches chunkKeySketches;
 
     class CmdMedianKey : public Command {
     public:
@@ -152,6 +154,10 @@ namespace mongo {
             // invalidated during a db lock yield.
             BSONObj missingFieldObj = IndexLegacy::getMissingField(idx->info.obj());
             BSONElement missingField = missingFieldObj.firstElement();
+
+            // Only the first field of a hashed index is hashed; the fields after it, if any, are
+            // missing when null like those of any other index.
+            BSONObj nullObj = BSON( "" << BSONNULL );
             
             // for now, the only check is that all shard keys are filled
             // a 'missingField' valued index key is ok if the field is present in the document,
@@ -171,7 +177,8 @@ namespace mongo {
                     }
                     BSONElement currKeyElt = i.next();
                     
-                    if ( !currKeyElt.eoo() && !currKeyElt.valuesEqual( missingField ) )
+                    if ( !currKeyElt.eoo() &&
+                         !currKeyElt.valuesEqual( k == 0 ? missingField : nullObj.firstElement() ) )
                         continue;
 
                     // This is a fetch, but it's OK.  The underlying code won't throw a page fault
@@ -267,6 +274,24 @@ namespace mongo {
 
             vector<BSONObj> splitKeys;
 
+            // Split points of a chunk of a sharded collection may come from the chunk's sketch,
+            // or the index scan may sample them for the next time if it sees the whole chunk.
+            const BSONObj chunkMin = min.getOwned();
+            const BSONObj chunkMax = max.getOwned();
+            CollectionMetadataPtr metadata;
+            if ( shardingState.enabled() && !chunkMin.isEmpty() ) {
+                metadata = shardingState.getCollectionMetadata( ns );
+            }
+
+            bool isChunk = false;
+            if ( metadata && metadata->getKeyPattern().woCompare( keyPattern ) == 0 &&
+                 !KeyPattern( keyPattern ).isSpecial() ) {
+                ChunkType chunk;
+                isChunk = metadata->getNextChunk( chunkMin, &chunk ) &&
+                          chunk.getMin().woCompare( chunkMin ) == 0 &&
+                          chunk.getMax().woCompare( chunkMax ) == 0;
+            }
+
             {
                 // Get the size estimate for this namespace
                 Client::ReadContext ctx( ns );
@@ -356,7 +381,32 @@ namespace mongo {
                 }
                 
                 //
-                // 2. Traverse the index and add the keyCount-th key to the result vector. If that key
+                // 2.a If every key of the chunk has been sampled, read the split points off the
+                //     sample instead of scanning the index.
+                //
+
+                SplitKeySketch sketch;
+                if ( isChunk &&
+                     chunkKeySketches.get( ns, metadata->getCollVersion().epoch(),
+                                           chunkMin, chunkMax, &sketch ) &&
+                     sketch.isUsable() ) {
+
+                    if ( forceMedianSplit ) {
+                        keyCount = sketch.count() / 2;
+                    }
+
+                    sketch.getSplitKeys( chunkMin, keyCount, maxSplitPoints, &splitKeys );
+
+                    LOG(1) << "picked " << splitKeys.size() << " split keys for chunk " << ns
+                           << " " << chunkMin << " -->> " << chunkMax << " from a sketch of "
+                           << sketch.count() << " keys" << endl;
+
+                    result.append( "splitKeys" , splitKeys );
+                    return true;
+                }
+
+                //
+                // 2.b Traverse the index and add the keyCount-th key to the result vector. If that key
                 //    appeared in the vector before, we omit it. The invariant here is that all the
                 //    instances of a given key value live in the same chunk.
                 //
@@ -381,10 +431,19 @@ namespace mongo {
                 set<BSONObj> tooFrequentKeys;
                 splitKeys.push_back(prettyKey(idx->keyPattern(), currKey.getOwned()).extractFields( keyPattern ) );
 
+                // Sample the keys of the first pass, kept if it gets to the end of the chunk
+                bool sampling = isChunk;
+                SplitKeySketch sample( curTimeMicros64() );
+
                 runner->setYieldPolicy(Runner::YIELD_AUTO);
                 while ( 1 ) {
                     while (Runner::RUNNER_ADVANCED == state) {
                         currCount++;
+
+                        if ( sampling ) {
+                            sample.add( prettyKey( idx->keyPattern(),
+                                                   currKey ).extractFields( keyPattern ) );
+                        }
                         
                         if ( currCount > keyCount && !forceMedianSplit ) {
                             currKey = prettyKey(idx->keyPattern(), currKey.getOwned()).extractFields(keyPattern);
@@ -410,6 +469,13 @@ namespace mongo {
 
                         state = runner->getNext(&currKey, NULL);
                     }
+
+                    if ( sampling && Runner::RUNNER_EOF == state ) {
+                        chunkKeySketches.install( ns, metadata->getCollVersion().epoch(),
+                                                  metadata->getKeyPattern(),
+                                                  chunkMin, chunkMax, sample );
+                    }
+                    sampling = false;
                     
                     if ( ! forceMedianSplit )
                         break;
@@ -136,6 +136,9 @@ namespace mongo {
         _shardName.clear();
         _shardHost.clear();
         _collMetadata.clear();
+        _metadataGeneration.fetchAndAdd( 1 );
+
+        chunkKeySketches.clear();
     }
 
     // TODO we shouldn't need three ways for checking the version. Fix this.
@@ -195,6 +198,9 @@ namespace mongo {
         // TODO: a bit dangerous to have two different zero-version states - no-metadata and
         // no-version
         _collMetadata[ns] = cloned;
+        _metadataGeneration.fetchAndAdd( 1 );
+
+        chunkKeySketches.drop( ns, min, max );
     }
 
     void ShardingState::undoDonateChunk( const string& ns, CollectionMetadataPtr prevMetadata ) {
@@ -204,6 +210,7 @@ namespace mongo {
         CollectionMetadataMap::iterator it = _collMetadata.find( ns );
         verify( it != _collMetadata.end() );
         it->second = prevMetadata;
+        _metadataGeneration.fetchAndAdd( 1 );
     }
 
     bool ShardingState::notePending( const string& ns,
@@ -245,6 +252,7 @@ namespace mongo {
         if ( !cloned ) return false;
 
         _collMetadata[ns] = cloned;
+        _metadataGeneration.fetchAndAdd( 1 );
         return true;
     }
 
@@ -287,6 +295,7 @@ namespace mongo {
         if ( !cloned ) return false;
 
         _collMetadata[ns] = cloned;
+        _metadataGeneration.fetchAndAdd( 1 );
         return true;
     }
 
@@ -311,6 +320,9 @@ namespace mongo {
         uassert( 16857, errMsg, NULL != cloned.get() );
 
         _collMetadata[ns] = cloned;
+        _metadataGeneration.fetchAndAdd( 1 );
+
+        chunkKeySketches.split( ns, min, max, splitKeys );
     }
 
     void ShardingState::mergeChunks( const string& ns,
@@ -333,6 +345,9 @@ namespace mongo {
         uassert( 17004, errMsg, NULL != cloned.get() );
 
         _collMetadata[ns] = cloned;
+        _metadataGeneration.fetchAndAdd( 1 );
+
+        chunkKeySketches.drop( ns, minKey, maxKey );
     }
 
     void ShardingState::resetMetadata( const string& ns ) {
@@ -342,6 +357,7 @@ namespace mongo {
                   << endl;
 
         _collMetadata.erase( ns );
+        _metadataGeneration.fetchAndAdd( 1 );
     }
 
     Status ShardingState::refreshMetadataIfNeeded( const string& ns,
@@ -556,6 +572,7 @@ namespace mongo {
                     installType = InstallType_New;
                     dassert( it == _collMetadata.end() );
                     _collMetadata.insert( make_pair( ns, remoteMetadata ) );
+                    _metadataGeneration.fetchAndAdd( 1 );
                 }
                 else if ( remoteShardVersion.epoch().isSet() &&
                           remoteShardVersion.epoch() == afterShardVersion.epoch() ) {
@@ -566,6 +583,7 @@ namespace mongo {
                     // Invariant: If CollMetadata was not found, version should be have been 0.
                     dassert( it != _collMetadata.end() );
                     it->second = remoteMetadata;
+                    _metadataGeneration.fetchAndAdd( 1 );
                 }
                 else if ( remoteShardVersion.epoch().isSet() ) {
 
@@ -575,6 +593,7 @@ namespace mongo {
                     // Invariant: If CollMetadata was not found, version should be have been 0.
                     dassert( it != _collMetadata.end() );
                     it->second = remoteMetadata;
+                    _metadataGeneration.fetchAndAdd( 1 );
                 }
                 else {
                     dassert( !remoteShardVersion.epoch().isSet() );
@@ -582,6 +601,7 @@ namespace mongo {
                     // Drop detected
                     installType = InstallType_Drop;
                     _collMetadata.erase( it );
+                    _metadataGeneration.fetchAndAdd( 1 );
                 }
 
                 *latestShardVersion = remoteShardVersion;
@@ -714,6 +734,15 @@ namespace mongo {
         _tl.reset();
     }
 
+    ShardedConnectionInfo* ShardedConnectionInfo::release() {
+        return _tl.release();
+    }
+
+    void ShardedConnectionInfo::attach( ShardedConnectionInfo* info ) {
+        verify( _tl.get() == 0 );
+        _tl.reset( info );
+    }
+
     const ChunkVersion ShardedConnectionInfo::getVersion( const string& ns ) const {
         NSVersionMap::const_iterator it = _versions.find( ns );
         if ( it != _versions.end() ) {
@@ -728,6 +757,19 @@ namespace mongo {
         _versions[ns] = version;
     }
 
+    const CollectionMetadataPtr& ShardedConnectionInfo::getCollectionMetadata( const string& ns ) {
+        CachedMetadata& cached = _metadata[ns];
+
+        // read the generation first: a change racing with the lookup below leaves the entry
+        // marked stale rather than current
+        unsigned long long generation = shardingState.getMetadataGeneration();
+        if ( cached.generation != generation ) {
+            cached.metadata = shardingState.getCollectionMetadata( ns );
+            cached.generation = generation;
+        }
+        return cached.metadata;
+    }
+
     void ShardedConnectionInfo::addHook() {
         static mongo::mutex lock("ShardedConnectionInfo::addHook mutex");
         static bool done = false;
@@ -1203,7 +1245,8 @@ namespace mongo {
         // TODO : all collections at some point, be sharded or not, will have a version
         //  (and a CollectionMetadata)
         received = info->getVersion( ns );
-        wanted = shardingState.getVersion( ns );
+        const CollectionMetadataPtr& metadata = info->getCollectionMetadata( ns );
+        wanted = metadata ? metadata->getShardVersion() : ChunkVersion( 0, OID() );
 
         if( received.isWriteCompatibleWith( wanted ) ) return true;
 
@@ -31,6 +31,7 @@
 #include "mongo/db/dbmessage.h"
 #include "mongo/s/shard.h"
 #include "mongo/util/net/message.h"
+#include "mongo/util/net/socket_poll.h"
 
 namespace mongo {
 
@@ -57,7 +58,9 @@ namespace mongo {
             it != _pendingCommands.end(); ++it ) {
 
             PendingCommand* command = *it;
-            dassert( NULL == command->conn );
+
+            // Already sent, or failed to
+            if ( NULL != command->conn || !command->status.isOK() ) continue;
 
             try {
                 // TODO: Figure out how to handle repl sets, configs
@@ -91,10 +94,54 @@ namespace mongo {
         return static_cast<int>( _pendingCommands.size() );
     }
 
+    DBClientMultiCommand::PendingQueue::iterator DBClientMultiCommand::nextReady() {
+
+        vector<pollfd> fds;
+        vector<PendingQueue::iterator> polled;
+
+        for ( PendingQueue::iterator it = _pendingCommands.begin();
+            it != _pendingCommands.end(); ++it ) {
+
+            PendingCommand* command = *it;
+
+            // Send errors are ready now
+            if ( !command->status.isOK() ) return it;
+
+            dassert( NULL != command->conn );
+            DBClientConnection* conn = dynamic_cast<DBClientConnection*>( command->conn );
+            if ( NULL == conn ) return _pendingCommands.begin();
+
+            pollfd fd;
+            fd.fd = conn->port().psock->rawFD();
+            fd.events = POLLIN;
+            fd.revents = 0;
+            fds.push_back( fd );
+            polled.push_back( it );
+        }
+
+        verify( !polled.empty() );
+        if ( polled.size() == 1u || !isPollSupported() ) return polled.front();
+
+        while ( true ) {
+            int nEvents = socketPoll( &fds.front(), fds.size(), -1 );
+            if ( nEvents < 0 ) {
+                if ( errno == EINTR ) continue;
+                // recv will find out what's wrong, if anything
+                return polled.front();
+            }
+
+            for ( size_t i = 0; i < fds.size(); ++i ) {
+                // Errors and hangups are also ready, to be found by recv
+                if ( fds[i].revents != 0 ) return polled[i];
+            }
+        }
+    }
+
     Status DBClientMultiCommand::recvAny( ConnectionString* endpoint, BSONSerializable* response ) {
 
-        scoped_ptr<PendingCommand> command( _pendingCommands.front() );
-        _pendingCommands.pop_front();
+        PendingQueue::iterator readyIt = nextReady();
+        scoped_ptr<PendingCommand> command( *readyIt );
+        _pendingCommands.erase( readyIt );
 
         *endpoint = command->endpoint;
         if ( !command->status.isOK() ) return command->status;
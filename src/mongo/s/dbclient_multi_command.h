@@ -39,6 +39,9 @@ namespace mongo {
      * A DBClientMultiCommand uses the client driver (DBClientConnections) to send and recv
      * commands to different hosts in parallel.
      *
+     * Commands may be added and sent while others are still in flight, and responses are
+     * returned in the order they arrive, so one slow host doesn't hold up the others.
+     *
      * See MultiCommandDispatch for more details.
      */
     class DBClientMultiCommand : public MultiCommandDispatch {
@@ -78,6 +81,13 @@ namespace mongo {
         };
 
         typedef std::deque<PendingCommand*> PendingQueue;
+
+        /**
+         * Returns the sent command whose response (or error) is ready first, in send order if
+         * we can't tell.  Blocks until there is one.
+         */
+        PendingQueue::iterator nextReady();
+
         PendingQueue _pendingCommands;
     };
 
@@ -170,6 +170,17 @@ namespace mongo {
 
     }
 
+    DBConfigPtr Grid::getLoadedDBConfig( const StringData& ns ) {
+        string database = nsToDatabase( ns );
+
+        if ( database == "config" )
+            return configServerPtr;
+
+        scoped_lock l( _lock );
+        map<string,DBConfigPtr>::const_iterator it = _databases.find( database );
+        return it == _databases.end() ? DBConfigPtr() : it->second;
+    }
+
     void Grid::removeDBIfExists( const DBConfig& database ) {
 
         scoped_lock l( _lock );
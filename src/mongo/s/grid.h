@@ -53,6 +53,12 @@ namespace mongo {
          */
         DBConfigPtr getDBConfig( const StringData& ns , bool create=true , const string& shardNameHint="" );
 
+        /**
+         * @return the config of the db if this process has already loaded it, otherwise an
+         *     empty pointer.  Never goes to the config servers.
+         */
+        DBConfigPtr getLoadedDBConfig( const StringData& ns );
+
         /**
          * removes db entry.
          * on next getDBConfig call will fetch from db
@@ -61,9 +61,9 @@ namespace mongo {
                                  const BSONSerializable& request ) = 0;
 
         /**
-         * Sends all the commands in this dispatch to their endpoints, in undefined order and
-         * without waiting for responses.  May block on full send queue (though this should be
-         * rare).
+         * Sends all the commands added since the last sendAll to their endpoints, in undefined
+         * order and without waiting for responses.  Earlier commands may still be pending.  May
+         * block on full send queue (though this should be rare).
          *
          * Any error which occurs during sendAll will be reported on recvAny, *does not throw.*
          */
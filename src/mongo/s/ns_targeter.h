@@ -84,6 +84,21 @@ namespace mongo {
          */
         virtual Status targetDoc( const BSONObj& doc, ShardEndpoint** endpoint ) const = 0;
 
+        /**
+         * Targets many single document writes at once, which implementations may do more cheaply
+         * than a targetDoc for each.  Appends an endpoint and a status for each doc, the endpoint
+         * being NULL if the status is !OK.  The caller owns the endpoints.
+         */
+        virtual void targetDocs( const std::vector<BSONObj>& docs,
+                                 std::vector<ShardEndpoint*>* endpoints,
+                                 std::vector<Status>* statuses ) const {
+            for ( size_t i = 0; i < docs.size(); ++i ) {
+                ShardEndpoint* endpoint = NULL;
+                statuses->push_back( targetDoc( docs[i], &endpoint ) );
+                endpoints->push_back( endpoint );
+            }
+        }
+
         /**
          * Returns a vector of ShardEndpoints for a potentially multi-shard query.
          *
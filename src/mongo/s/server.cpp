@@ -54,6 +54,7 @@
 #include "mongo/s/chunk.h"
 #include "mongo/s/client_info.h"
 #include "mongo/s/config.h"
+#include "mongo/s/config_changelog_listener.h"
 #include "mongo/s/config_server_checker_service.h"
 #include "mongo/s/config_upgrade.h"
 #include "mongo/s/cursors.h"
@@ -299,6 +300,7 @@ static bool runMongosServer( bool doUpgrade ) {
     }
 
     startConfigServerChecker();
+    startConfigChangelogListener();
 
     VersionType initVersionInfo;
     VersionType versionInfo;
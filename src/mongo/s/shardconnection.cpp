@@ -32,6 +32,8 @@
 
 #include <set>
 
+#include "mongo/client/dbclient_rs.h"
+#include "mongo/client/distlock.h"
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/client.h"
 #include "mongo/db/commands.h"
@@ -497,6 +499,47 @@ namespace mongo {
         true
     );
 
+    /**
+     * Sets PoolForHost::setMinPerHost(), the idle connections the pools keep open in the
+     * background to every host they have used.
+     */
+    class ConnPoolMinPerHostParameter : public BoundedIntParameter {
+    public:
+        ConnPoolMinPerHostParameter()
+            : BoundedIntParameter( ServerParameterSet::getGlobal(), "connPoolMinPerHost",
+                                   &_value, 0, 1000 ),
+              _value( 0 ) {}
+
+        using BoundedIntParameter::set;
+        virtual Status set( const int& newValue ) {
+            Status status = BoundedIntParameter::set( newValue );
+            if ( status.isOK() )
+                PoolForHost::setMinPerHost( newValue );
+            return status;
+        }
+
+    private:
+        int _value;
+    } connPoolMinPerHostParameter;
+
+    /**
+     * How long a lazy secondary read waits before it is also sent to another secondary;
+     * 0 turns hedging off.  See DBClientReplicaSet::hedgedReadDelayMillis.
+     */
+    BoundedIntParameter hedgedReadDelayMillisParameter( ServerParameterSet::getGlobal(),
+                                                        "hedgedReadDelayMillis",
+                                                        &DBClientReplicaSet::hedgedReadDelayMillis,
+                                                        0, 60000 );
+
+    /**
+     * How long a released distributed lock is kept for this process to take back locally.
+     * See DistributedLock::leaseMillis.
+     */
+    BoundedIntParameter distLockLeaseMillisParameter( ServerParameterSet::getGlobal(),
+                                                      "distLockLeaseMillis",
+                                                      &DistributedLock::leaseMillis,
+                                                      0, 60000 );
+
     void ShardConnection::releaseMyConnections() {
         ClientConnections::threadInstance()->releaseAll();
     }
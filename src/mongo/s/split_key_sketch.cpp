@@ -0,0 +1,245 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/s/split_key_sketch.h"
+
+#include <algorithm>
+
+namespace mongo {
+
+    using std::string;
+    using std::vector;
+
+    const size_t SplitKeySketch::kMaxSamples = 256;
+    const size_t SplitKeySketch::kMinSamples = 64;
+
+    SplitKeySketch::SplitKeySketch( int64_t seed ) : _random( seed ), _count( 0 ) {
+    }
+
+    void SplitKeySketch::add( const BSONObj& key ) {
+        _count++;
+
+        if ( _samples.size() == static_cast<size_t>( _count - 1 ) &&
+             _samples.size() < kMaxSamples ) {
+            _samples.push_back( key.getOwned() );
+            return;
+        }
+
+        // keep the new key with the same chance each counted key has of being a sample
+        const uint64_t slot = static_cast<uint64_t>( _random.nextInt64() ) % _count;
+        if ( slot < _samples.size() ) {
+            _samples[slot] = key.getOwned();
+        }
+    }
+
+    bool SplitKeySketch::isUsable() const {
+        return _samples.size() >= kMinSamples || _samples.size() == static_cast<size_t>( _count );
+    }
+
+    void SplitKeySketch::getSplitKeys( const BSONObj& min,
+                                       long long keyCount,
+                                       long long maxSplitPoints,
+                                       vector<BSONObj>* splitKeys ) const {
+        if ( _samples.empty() || keyCount <= 0 ) {
+            return;
+        }
+
+        vector<BSONObj> sorted( _samples );
+        std::sort( sorted.begin(), sorted.end(), BSONObjCmp() );
+
+        BSONObj last = min;
+        long long numPicked = 0;
+        for ( long long pos = keyCount; pos < _count; pos += keyCount + 1 ) {
+            const BSONObj& key = sorted[ pos * sorted.size() / _count ];
+            if ( key.woCompare( last ) <= 0 ) {
+                continue;
+            }
+
+            splitKeys->push_back( key );
+            last = key;
+
+            if ( maxSplitPoints && ++numPicked >= maxSplitPoints ) {
+                break;
+            }
+        }
+    }
+
+    void SplitKeySketch::split( const vector<BSONObj>& splitKeys,
+                                vector<SplitKeySketch>* pieces ) const {
+        const size_t first = pieces->size();
+        for ( size_t i = 0; i <= splitKeys.size(); i++ ) {
+            pieces->push_back( SplitKeySketch( _count + i ) );
+        }
+
+        for ( vector<BSONObj>::const_iterator it = _samples.begin(); it != _samples.end(); ++it ) {
+            const size_t piece = std::upper_bound( splitKeys.begin(), splitKeys.end(), *it,
+                                                   BSONObjCmp() ) - splitKeys.begin();
+            ( *pieces )[first + piece]._samples.push_back( *it );
+        }
+
+        for ( size_t i = first; i < pieces->size(); i++ ) {
+            SplitKeySketch& piece = ( *pieces )[i];
+            piece._count = _samples.empty() ? 0 :
+                    _count * static_cast<long long>( piece._samples.size() ) / _samples.size();
+        }
+    }
+
+    ChunkKeySketches::ChunkKeySketches() : _mutex( "ChunkKeySketches" ) {
+    }
+
+    void ChunkKeySketches::noteInsert( const StringData& ns, const BSONObj& doc ) {
+        if ( _numCollections.load() == 0 ) {
+            return;
+        }
+
+        scoped_lock lk( _mutex );
+
+        CollectionSketchMap::iterator coll = _collections.find( ns.toString() );
+        if ( coll == _collections.end() ) {
+            return;
+        }
+
+        const BSONObj key = doc.extractFields( coll->second.keyPattern, true );
+
+        ChunkSketchMap& chunks = coll->second.chunks;
+        ChunkSketchMap::iterator it = chunks.upper_bound( key );
+        if ( it == chunks.begin() ) {
+            return;
+        }
+        --it;
+
+        if ( key.woCompare( it->second.max ) >= 0 ) {
+            return;
+        }
+
+        it->second.sketch.add( key );
+    }
+
+    void ChunkKeySketches::install( const string& ns,
+                                    const OID& epoch,
+                                    const BSONObj& keyPattern,
+                                    const BSONObj& min,
+                                    const BSONObj& max,
+                                    const SplitKeySketch& sketch ) {
+        scoped_lock lk( _mutex );
+
+        CollectionSketchMap::iterator coll = _collections.find( ns );
+        if ( coll == _collections.end() ) {
+            coll = _collections.insert( make_pair( ns, CollectionSketches() ) ).first;
+            _numCollections.fetchAndAdd( 1 );
+        }
+        else if ( coll->second.epoch != epoch ) {
+            coll->second.chunks.clear();
+        }
+
+        coll->second.epoch = epoch;
+        coll->second.keyPattern = keyPattern.getOwned();
+
+        ChunkSketch& chunk = coll->second.chunks[min.getOwned()];
+        chunk.max = max.getOwned();
+        chunk.sketch = sketch;
+    }
+
+    bool ChunkKeySketches::get( const string& ns,
+                                const OID& epoch,
+                                const BSONObj& min,
+                                const BSONObj& max,
+                                SplitKeySketch* sketch ) const {
+        scoped_lock lk( _mutex );
+
+        CollectionSketchMap::const_iterator coll = _collections.find( ns );
+        if ( coll == _collections.end() || coll->second.epoch != epoch ) {
+            return false;
+        }
+
+        ChunkSketchMap::const_iterator it = coll->second.chunks.find( min );
+        if ( it == coll->second.chunks.end() || it->second.max.woCompare( max ) != 0 ) {
+            return false;
+        }
+
+        *sketch = it->second.sketch;
+        return true;
+    }
+
+    void ChunkKeySketches::split( const string& ns,
+                                  const BSONObj& min,
+                                  const BSONObj& max,
+                                  const vector<BSONObj>& splitKeys ) {
+        scoped_lock lk( _mutex );
+
+        CollectionSketchMap::iterator coll = _collections.find( ns );
+        if ( coll == _collections.end() ) {
+            return;
+        }
+
+        ChunkSketchMap& chunks = coll->second.chunks;
+        ChunkSketchMap::iterator it = chunks.find( min );
+        if ( it == chunks.end() || it->second.max.woCompare( max ) != 0 ) {
+            return;
+        }
+
+        vector<SplitKeySketch> pieces;
+        it->second.sketch.split( splitKeys, &pieces );
+        chunks.erase( it );
+
+        BSONObj pieceMin = min;
+        for ( size_t i = 0; i < pieces.size(); i++ ) {
+            ChunkSketch& chunk = chunks[pieceMin.getOwned()];
+            chunk.max = ( i < splitKeys.size() ? splitKeys[i] : max ).getOwned();
+            chunk.sketch = pieces[i];
+            pieceMin = chunk.max;
+        }
+    }
+
+    void ChunkKeySketches::drop( const string& ns, const BSONObj& min, const BSONObj& max ) {
+        scoped_lock lk( _mutex );
+
+        CollectionSketchMap::iterator coll = _collections.find( ns );
+        if ( coll == _collections.end() ) {
+            return;
+        }
+
+        ChunkSketchMap& chunks = coll->second.chunks;
+        ChunkSketchMap::iterator first = chunks.lower_bound( min );
+        if ( first != chunks.begin() ) {
+            ChunkSketchMap::iterator prev = first;
+            --prev;
+            if ( prev->second.max.woCompare( min ) > 0 ) {
+                first = prev;
+            }
+        }
+        chunks.erase( first, chunks.lower_bound( max ) );
+    }
+
+    void ChunkKeySketches::clear() {
+        scoped_lock lk( _mutex );
+        _collections.clear();
+        _numCollections.store( 0 );
+    }
+
+}  // namespace mongo
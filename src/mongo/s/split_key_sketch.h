@@ -0,0 +1,184 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/random.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    /**
+     * A uniform sample of the shard keys in a chunk, from which split points can be read without
+     * scanning the chunk's index.
+     *
+     * Up to kMaxSamples keys are kept in a reservoir: every key counted has the same chance of
+     * being among the samples, so the i-th smallest sample sits at about i/numSamples of the chunk.
+     * While every key counted is still held the sketch is exact.
+     *
+     * Not thread safe.
+     */
+    class SplitKeySketch {
+    public:
+        static const size_t kMaxSamples;
+
+        // fewer than this many samples of a larger chunk place split points too coarsely
+        static const size_t kMinSamples;
+
+        explicit SplitKeySketch( int64_t seed = 0 );
+
+        /**
+         * Counts one more key of the chunk, 'key' being in shard key form.
+         */
+        void add( const BSONObj& key );
+
+        /**
+         * Number of keys counted, an estimate once the sketch has been split.
+         */
+        long long count() const { return _count; }
+
+        size_t numSamples() const { return _samples.size(); }
+
+        /**
+         * True if there are enough samples to place split points with.
+         */
+        bool isUsable() const;
+
+        /**
+         * Appends to 'splitKeys' about every ('keyCount' + 1)-th key, as splitVector's index scan
+         * would pick them, and at most 'maxSplitPoints' of them if that is not zero. Keys not
+         * above 'min' or the previous split key are skipped, so no two split points are equal.
+         */
+        void getSplitKeys( const BSONObj& min,
+                           long long keyCount,
+                           long long maxSplitPoints,
+                           std::vector<BSONObj>* splitKeys ) const;
+
+        /**
+         * Divides this sketch at 'splitKeys', sorted, into splitKeys.size() + 1 sketches of the
+         * chunks the split makes. Each piece keeps the samples in its range and its share of the
+         * count.
+         */
+        void split( const std::vector<BSONObj>& splitKeys,
+                    std::vector<SplitKeySketch>* pieces ) const;
+
+    private:
+        PseudoRandom _random;
+        long long _count;
+        std::vector<BSONObj> _samples;
+    };
+
+    /**
+     * The split key sketches a shard keeps of its chunks, by collection and chunk range.
+     *
+     * A chunk gets a sketch once its keys have all been seen by a splitVector index scan. From
+     * then on every insert into it is counted, and when it splits here its sketch is divided
+     * among the new chunks, so splitVector can answer from the sketch rather than scan again.
+     * Removes are not counted, which only makes a chunk look bigger than it is. Sketches of a
+     * chunk that moves or merges are dropped, as is a collection's sketches when its epoch
+     * changes.
+     *
+     * Thread safe.
+     */
+    class ChunkKeySketches {
+    public:
+        ChunkKeySketches();
+
+        /**
+         * Counts the shard key of 'doc', just inserted into 'ns', in the sketch of its chunk.
+         */
+        void noteInsert( const StringData& ns, const BSONObj& doc );
+
+        /**
+         * Installs 'sketch' for the chunk [min, max) of 'ns', sharded by 'keyPattern' at 'epoch'.
+         * Sketches of other epochs are dropped.
+         */
+        void install( const std::string& ns,
+                      const OID& epoch,
+                      const BSONObj& keyPattern,
+                      const BSONObj& min,
+                      const BSONObj& max,
+                      const SplitKeySketch& sketch );
+
+        /**
+         * Copies the sketch of the chunk [min, max) of 'ns' at 'epoch' into 'sketch'.
+         *
+         * @return false if there is no sketch of exactly that chunk
+         */
+        bool get( const std::string& ns,
+                  const OID& epoch,
+                  const BSONObj& min,
+                  const BSONObj& max,
+                  SplitKeySketch* sketch ) const;
+
+        /**
+         * Divides the sketch of [min, max) of 'ns', if any, among the chunks split at 'splitKeys'.
+         */
+        void split( const std::string& ns,
+                    const BSONObj& min,
+                    const BSONObj& max,
+                    const std::vector<BSONObj>& splitKeys );
+
+        /**
+         * Drops the sketches of the chunks of 'ns' overlapping [min, max).
+         */
+        void drop( const std::string& ns, const BSONObj& min, const BSONObj& max );
+
+        void clear();
+
+    private:
+        struct ChunkSketch {
+            BSONObj max;
+            SplitKeySketch sketch;
+        };
+
+        typedef std::map<BSONObj, ChunkSketch, BSONObjCmp> ChunkSketchMap;
+
+        struct CollectionSketches {
+            OID epoch;
+            BSONObj keyPattern;
+            ChunkSketchMap chunks;
+        };
+
+        typedef std::map<std::string, CollectionSketches> CollectionSketchMap;
+
+        mutable mongo::mutex _mutex;
+        CollectionSketchMap _collections;
+
+        // Number of collections with sketches, read without the mutex so inserts into the others
+        // need not take it.
+        AtomicUInt32 _numCollections;
+    };
+
+}  // namespace mongo
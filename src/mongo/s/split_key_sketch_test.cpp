@@ -0,0 +1,244 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/s/split_key_sketch.h"
+
+#include "mongo/unittest/unittest.h"
+
+namespace {
+
+    using mongo::BSONObj;
+    using mongo::ChunkKeySketches;
+    using mongo::MAXKEY;
+    using mongo::MINKEY;
+    using mongo::OID;
+    using mongo::SplitKeySketch;
+    using std::vector;
+
+    SplitKeySketch sketchOf( int from, int to ) {
+        SplitKeySketch sketch( 12345 );
+        for ( int i = from; i < to; i++ ) {
+            sketch.add( BSON( "x" << i ) );
+        }
+        return sketch;
+    }
+
+    TEST(SplitKeySketch, ExactWhileSmall) {
+        SplitKeySketch sketch = sketchOf( 0, 100 );
+        ASSERT_EQUALS( 100, sketch.count() );
+        ASSERT_EQUALS( 100U, sketch.numSamples() );
+        ASSERT( sketch.isUsable() );
+
+        // the keys an index scan with keyCount 29 would pick
+        vector<BSONObj> splitKeys;
+        sketch.getSplitKeys( BSON( "x" << MINKEY ), 29, 0, &splitKeys );
+        ASSERT_EQUALS( 3U, splitKeys.size() );
+        ASSERT_EQUALS( BSON( "x" << 29 ), splitKeys[0] );
+        ASSERT_EQUALS( BSON( "x" << 59 ), splitKeys[1] );
+        ASSERT_EQUALS( BSON( "x" << 89 ), splitKeys[2] );
+
+        splitKeys.clear();
+        sketch.getSplitKeys( BSON( "x" << MINKEY ), 29, 2, &splitKeys );
+        ASSERT_EQUALS( 2U, splitKeys.size() );
+
+        splitKeys.clear();
+        sketch.getSplitKeys( BSON( "x" << MINKEY ), 100, 0, &splitKeys );
+        ASSERT( splitKeys.empty() );
+    }
+
+    TEST(SplitKeySketch, SampledQuantiles) {
+        SplitKeySketch sketch = sketchOf( 0, 100000 );
+        ASSERT_EQUALS( 100000, sketch.count() );
+        ASSERT_EQUALS( SplitKeySketch::kMaxSamples, sketch.numSamples() );
+        ASSERT( sketch.isUsable() );
+
+        vector<BSONObj> splitKeys;
+        sketch.getSplitKeys( BSON( "x" << MINKEY ), 24999, 0, &splitKeys );
+        ASSERT_EQUALS( 3U, splitKeys.size() );
+        for ( size_t i = 0; i < splitKeys.size(); i++ ) {
+            int expected = 25000 * ( i + 1 );
+            ASSERT_LESS_THAN( expected - 10000, splitKeys[i]["x"].numberInt() );
+            ASSERT_GREATER_THAN( expected + 10000, splitKeys[i]["x"].numberInt() );
+        }
+    }
+
+    TEST(SplitKeySketch, FrequentKeysSplitOnce) {
+        SplitKeySketch sketch( 1 );
+        for ( int i = 0; i < 100; i++ ) {
+            sketch.add( BSON( "x" << ( i < 90 ? 5 : i ) ) );
+        }
+
+        vector<BSONObj> splitKeys;
+        sketch.getSplitKeys( BSON( "x" << MINKEY ), 9, 0, &splitKeys );
+        ASSERT_EQUALS( 2U, splitKeys.size() );
+        ASSERT_EQUALS( BSON( "x" << 5 ), splitKeys[0] );
+        ASSERT_EQUALS( BSON( "x" << 99 ), splitKeys[1] );
+
+        // never at the chunk's min
+        splitKeys.clear();
+        sketch.getSplitKeys( BSON( "x" << 5 ), 9, 0, &splitKeys );
+        ASSERT_EQUALS( 1U, splitKeys.size() );
+        ASSERT_EQUALS( BSON( "x" << 99 ), splitKeys[0] );
+    }
+
+    TEST(SplitKeySketch, Split) {
+        SplitKeySketch sketch = sketchOf( 0, 100 );
+
+        vector<BSONObj> splitKeys;
+        splitKeys.push_back( BSON( "x" << 25 ) );
+        splitKeys.push_back( BSON( "x" << 50 ) );
+
+        vector<SplitKeySketch> pieces;
+        sketch.split( splitKeys, &pieces );
+        ASSERT_EQUALS( 3U, pieces.size() );
+        ASSERT_EQUALS( 25, pieces[0].count() );
+        ASSERT_EQUALS( 25, pieces[1].count() );
+        ASSERT_EQUALS( 50, pieces[2].count() );
+        ASSERT( pieces[2].isUsable() );
+
+        vector<BSONObj> pieceKeys;
+        pieces[2].getSplitKeys( BSON( "x" << 50 ), 24, 0, &pieceKeys );
+        ASSERT_EQUALS( 2U, pieceKeys.size() );
+        ASSERT_EQUALS( BSON( "x" << 74 ), pieceKeys[0] );
+        ASSERT_EQUALS( BSON( "x" << 99 ), pieceKeys[1] );
+    }
+
+    TEST(SplitKeySketch, SplitSampled) {
+        SplitKeySketch sketch = sketchOf( 0, 100000 );
+
+        vector<BSONObj> splitKeys;
+        splitKeys.push_back( BSON( "x" << 50000 ) );
+
+        vector<SplitKeySketch> pieces;
+        sketch.split( splitKeys, &pieces );
+        ASSERT_EQUALS( 2U, pieces.size() );
+        // counts are rounded down
+        ASSERT_LESS_THAN( 99998, pieces[0].count() + pieces[1].count() );
+        ASSERT_LESS_THAN( 40000, pieces[0].count() );
+        ASSERT_LESS_THAN( 40000, pieces[1].count() );
+        ASSERT_EQUALS( sketch.numSamples(), pieces[0].numSamples() + pieces[1].numSamples() );
+
+        // still sampled uniformly as more keys come in
+        for ( int i = 0; i < 50000; i++ ) {
+            pieces[1].add( BSON( "x" << 100000 + i ) );
+        }
+        ASSERT_LESS_THAN( 90000, pieces[1].count() );
+        ASSERT_GREATER_THAN( pieces[1].numSamples(), SplitKeySketch::kMinSamples );
+        vector<BSONObj> pieceKeys;
+        pieces[1].getSplitKeys( BSON( "x" << 50000 ), pieces[1].count() / 2, 1, &pieceKeys );
+        ASSERT_EQUALS( 1U, pieceKeys.size() );
+        ASSERT_LESS_THAN( 80000, pieceKeys[0]["x"].numberInt() );
+        ASSERT_GREATER_THAN( 120000, pieceKeys[0]["x"].numberInt() );
+    }
+
+    TEST(ChunkKeySketches, CountsInsertsByChunk) {
+        ChunkKeySketches sketches;
+        const OID epoch = OID::gen();
+        const BSONObj keyPattern = BSON( "x" << 1 );
+
+        // no sketches yet, nothing counted
+        sketches.noteInsert( "foo.bar", BSON( "_id" << 1 << "x" << 1 ) );
+
+        sketches.install( "foo.bar", epoch, keyPattern,
+                          BSON( "x" << MINKEY ), BSON( "x" << 0 ), SplitKeySketch( 1 ) );
+        sketches.install( "foo.bar", epoch, keyPattern,
+                          BSON( "x" << 10 ), BSON( "x" << MAXKEY ), SplitKeySketch( 2 ) );
+
+        for ( int i = -5; i < 15; i++ ) {
+            sketches.noteInsert( "foo.bar", BSON( "_id" << i << "x" << i ) );
+        }
+        sketches.noteInsert( "foo.baz", BSON( "_id" << 1 << "x" << 1 ) );
+
+        SplitKeySketch sketch;
+        ASSERT( sketches.get( "foo.bar", epoch, BSON( "x" << MINKEY ), BSON( "x" << 0 ),
+                              &sketch ) );
+        ASSERT_EQUALS( 5, sketch.count() );
+        ASSERT( sketches.get( "foo.bar", epoch, BSON( "x" << 10 ), BSON( "x" << MAXKEY ),
+                              &sketch ) );
+        ASSERT_EQUALS( 5, sketch.count() );
+
+        // only the exact chunk and epoch
+        ASSERT( !sketches.get( "foo.bar", epoch, BSON( "x" << 0 ), BSON( "x" << 10 ), &sketch ) );
+        ASSERT( !sketches.get( "foo.bar", epoch, BSON( "x" << 10 ), BSON( "x" << 20 ),
+                               &sketch ) );
+        ASSERT( !sketches.get( "foo.bar", OID::gen(), BSON( "x" << 10 ), BSON( "x" << MAXKEY ),
+                               &sketch ) );
+
+        // documents without the shard key have it null
+        sketches.noteInsert( "foo.bar", BSON( "_id" << 100 ) );
+        ASSERT( sketches.get( "foo.bar", epoch, BSON( "x" << MINKEY ), BSON( "x" << 0 ),
+                              &sketch ) );
+        ASSERT_EQUALS( 6, sketch.count() );
+    }
+
+    TEST(ChunkKeySketches, SplitAndDrop) {
+        ChunkKeySketches sketches;
+        const OID epoch = OID::gen();
+
+        sketches.install( "foo.bar", epoch, BSON( "x" << 1 ),
+                          BSON( "x" << 0 ), BSON( "x" << 100 ), sketchOf( 0, 100 ) );
+
+        vector<BSONObj> splitKeys;
+        splitKeys.push_back( BSON( "x" << 40 ) );
+        splitKeys.push_back( BSON( "x" << 70 ) );
+        sketches.split( "foo.bar", BSON( "x" << 0 ), BSON( "x" << 100 ), splitKeys );
+
+        SplitKeySketch sketch;
+        ASSERT( !sketches.get( "foo.bar", epoch, BSON( "x" << 0 ), BSON( "x" << 100 ), &sketch ) );
+        ASSERT( sketches.get( "foo.bar", epoch, BSON( "x" << 0 ), BSON( "x" << 40 ), &sketch ) );
+        ASSERT_EQUALS( 40, sketch.count() );
+        ASSERT( sketches.get( "foo.bar", epoch, BSON( "x" << 40 ), BSON( "x" << 70 ), &sketch ) );
+        ASSERT_EQUALS( 30, sketch.count() );
+        ASSERT( sketches.get( "foo.bar", epoch, BSON( "x" << 70 ), BSON( "x" << 100 ), &sketch ) );
+        ASSERT_EQUALS( 30, sketch.count() );
+
+        sketches.noteInsert( "foo.bar", BSON( "x" << 45 ) );
+        ASSERT( sketches.get( "foo.bar", epoch, BSON( "x" << 40 ), BSON( "x" << 70 ), &sketch ) );
+        ASSERT_EQUALS( 31, sketch.count() );
+
+        // a migrated range takes every sketch it overlaps
+        sketches.drop( "foo.bar", BSON( "x" << 40 ), BSON( "x" << 70 ) );
+        ASSERT( !sketches.get( "foo.bar", epoch, BSON( "x" << 40 ), BSON( "x" << 70 ), &sketch ) );
+        ASSERT( sketches.get( "foo.bar", epoch, BSON( "x" << 0 ), BSON( "x" << 40 ), &sketch ) );
+        sketches.drop( "foo.bar", BSON( "x" << 20 ), BSON( "x" << 80 ) );
+        ASSERT( !sketches.get( "foo.bar", epoch, BSON( "x" << 0 ), BSON( "x" << 40 ), &sketch ) );
+        ASSERT( !sketches.get( "foo.bar", epoch, BSON( "x" << 70 ), BSON( "x" << 100 ),
+                               &sketch ) );
+
+        // a new epoch starts over
+        sketches.install( "foo.bar", epoch, BSON( "x" << 1 ),
+                          BSON( "x" << 0 ), BSON( "x" << 100 ), sketchOf( 0, 100 ) );
+        sketches.install( "foo.bar", OID::gen(), BSON( "x" << 1 ),
+                          BSON( "x" << 100 ), BSON( "x" << 200 ), sketchOf( 100, 200 ) );
+        ASSERT( !sketches.get( "foo.bar", epoch, BSON( "x" << 0 ), BSON( "x" << 100 ), &sketch ) );
+
+        sketches.clear();
+        sketches.noteInsert( "foo.bar", BSON( "x" << 150 ) );
+    }
+
+} // namespace
@@ -248,7 +248,7 @@ namespace mongo {
             else if ( cursor ) {
 
                 // TODO: Try to match logic of mongod, where on subsequent getMore() we pull lots more data?
-                BufBuilder buffer( ShardedClientCursor::INIT_REPLY_BUFFER_SIZE );
+                BufBuilder buffer( cursor->getReplyBufferSize( ntoreturn ) );
                 int docCount = 0;
                 const int startFrom = cursor->getTotalSent();
                 bool hasMore = cursor->sendNextBatch( r, ntoreturn, buffer, docCount );
@@ -541,9 +541,133 @@ namespace mongo {
 
             if (!d.moreJSObjs()) return;
 
+            if ((flags & InsertOption_ContinueOnError) && !(flags & WriteOption_FromWriteback)) {
+                Message regrouped;
+                if (_regroupInsertsByShard(ns, d, &regrouped)) {
+                    DbMessage regroupedD(regrouped);
+                    _insert(ns, regroupedD, flags, r);
+                    return;
+                }
+            }
+
             _insert(ns, d, flags, r);
         }
 
+        /**
+         * With continue-on-error the order of the documents only matters within a shard, so a
+         * sharded batch is rewritten with the documents for each shard next to each other, in
+         * their original order.  Each shard then gets one insert instead of one per run of
+         * documents.  Documents that can't be placed yet (no shard key) go last, in order.
+         *
+         * @return false, leaving 'd' where it was, if there is nothing to regroup
+         */
+        bool _regroupInsertsByShard(const string& ns, DbMessage& d, Message* regrouped) {
+            ChunkManagerPtr manager;
+            ShardPtr primary;
+            grid.getDBConfig(ns)->getChunkManagerOrPrimary(ns, manager, primary);
+            if (!manager)
+                return false;
+
+            d.markSet();
+
+            vector<string> shardOrder;
+            map<string, vector<BSONObj> > byShard;
+            vector<BSONObj> unplaced;
+            string lastShard;
+            int runs = 0;
+
+            try {
+                while (d.moreJSObjs()) {
+                    BSONObj o = d.nextJsObj();
+                    if (!manager->hasShardKey(o)) {
+                        unplaced.push_back(o);
+                        continue;
+                    }
+
+                    string shard = manager->findChunkForDoc(o)->getShard().getName();
+                    if (shard != lastShard) {
+                        runs++;
+                        lastShard = shard;
+                    }
+
+                    vector<BSONObj>& docs = byShard[shard];
+                    if (docs.empty())
+                        shardOrder.push_back(shard);
+                    docs.push_back(o);
+                }
+            }
+            catch (DBException& e) {
+                // let the normal path report it
+                LOG(3) << "not regrouping inserts to " << ns << causedBy(e) << endl;
+                d.markReset();
+                return false;
+            }
+
+            if (runs <= static_cast<int>(shardOrder.size())) {
+                d.markReset();
+                return false;
+            }
+
+            LOG(3) << "regrouped " << runs << " runs of inserts to " << ns << " into "
+                   << shardOrder.size() << " shards" << endl;
+
+            BufBuilder b;
+            b.appendNum(d.reservedField());
+            b.appendStr(ns);
+            for (vector<string>::const_iterator it = shardOrder.begin();
+                    it != shardOrder.end(); ++it) {
+                const vector<BSONObj>& docs = byShard[*it];
+                for (size_t i = 0; i < docs.size(); i++)
+                    b.appendBuf(docs[i].objdata(), docs[i].objsize());
+            }
+            for (size_t i = 0; i < unplaced.size(); i++)
+                b.appendBuf(unplaced[i].objdata(), unplaced[i].objsize());
+
+            regrouped->setData(dbInsert, b.buf(), b.len());
+            return true;
+        }
+
+        /**
+         * Runs getLastError on the shards written to since the last one, as the intermediate
+         * check of a bulk insert does.
+         *
+         * @return the error, if any
+         */
+        string _intermediateInsertGLE(Request& r) {
+            ClientInfo* ci = r.getClientInfo();
+
+            //
+            // WARNING: Without this, we will use the *previous* shard for GLE
+            //
+            ci->newRequest();
+
+            BSONObjBuilder gleB;
+            string errMsg;
+
+            // TODO: Can't actually pass GLE parameters here,
+            // so we use defaults?
+            ci->getLastError("admin",
+                             BSON( "getLastError" << 1 ),
+                             gleB,
+                             errMsg,
+                             false);
+
+            string insertErr = errMsg;
+            BSONObj gle = gleB.obj();
+            if (gle["err"].type() == String)
+                insertErr = gle["err"].String();
+
+            LOG(3) << "intermediate GLE result was " << gle
+                   << " errmsg: " << errMsg << endl;
+
+            //
+            // Clear out the shards we've checked so far, if we're successful
+            //
+            ci->clearSinceLastGetError();
+
+            return insertErr;
+        }
+
         void _insert(const string& ns, DbMessage& d, int flags, Request& r) // TODO: remove
         {
             uassert( 16056, str::stream() << "shutting down server during insert", ! inShutdown() );
@@ -557,6 +681,13 @@ namespace mongo {
 
             bool prevInsertException = false;
 
+            // With continue-on-error, an insert doesn't wait for the shard to answer before the
+            // next group is sent to another shard; the shards written to are only checked
+            // together, before one of them gets a second group (a shard's last error only
+            // covers its last insert) or once the batch is done.
+            const bool deferGLE = continueOnError;
+            set<string> uncheckedShards;
+
             while (d.moreJSObjs()) {
 
                 // TODO: Replace this with a better check to see if we're making progress
@@ -594,6 +725,24 @@ namespace mongo {
                               << group.inserts.size() << " intermediate documents" << endl;
                 }
 
+                if (deferGLE && group.inserts.size() > 0 &&
+                        uncheckedShards.count(group.shard->getName())) {
+
+                    LOG(3) << "running intermediate GLE to " << uncheckedShards.size()
+                           << " shards during bulk insert because "
+                           << group.shard->toString() << " is written to again" << endl;
+
+                    string insertErr = _intermediateInsertGLE(r);
+                    uncheckedShards.clear();
+
+                    if (insertErr.size() > 0) {
+                        // continuing on error, a later error supersedes this one
+                        warning() << "error inserting documents during bulk insert"
+                                  << causedBy(insertErr) << endl;
+                        prevInsertException = true;
+                    }
+                }
+
                 scoped_ptr<ShardConnection> dbconPtr;
 
                 try {
@@ -646,6 +795,10 @@ namespace mongo {
 
                             globalOpCounters.incInsertInWriteLock(group.inserts.size());
 
+                            if (deferGLE) {
+                                uncheckedShards.insert(group.shard->getName());
+                            }
+
                             //
                             // CHECK INTERMEDIATE ERROR
                             //
@@ -653,7 +806,17 @@ namespace mongo {
                             // We need to check the mongod error if we're inserting more documents,
                             // or if a later mongos error might mask an insert error,
                             // or if an earlier error might mask this error from GLE
-                            if (d.moreJSObjs() || group.hasException() || prevInsertException) {
+                            if (deferGLE) {
+                                if (!d.moreJSObjs() && (group.hasException() || prevInsertException)) {
+                                    LOG(3) << "running intermediate GLE to "
+                                           << uncheckedShards.size() << " shards at the end of "
+                                           << "bulk insert" << endl;
+
+                                    insertErr = _intermediateInsertGLE(r);
+                                    uncheckedShards.clear();
+                                }
+                            }
+                            else if (d.moreJSObjs() || group.hasException() || prevInsertException) {
 
                                 LOG(3) << "running intermediate GLE to "
                                        << group.shard->toString() << " during bulk insert "
@@ -663,36 +826,7 @@ namespace mongo {
                                                                       "a previous error exists"))
                                        << endl;
 
-                                ClientInfo* ci = r.getClientInfo();
-
-                                //
-                                // WARNING: Without this, we will use the *previous* shard for GLE
-                                //
-                                ci->newRequest();
-
-                                BSONObjBuilder gleB;
-                                string errMsg;
-
-                                // TODO: Can't actually pass GLE parameters here,
-                                // so we use defaults?
-                                ci->getLastError("admin",
-                                                 BSON( "getLastError" << 1 ),
-                                                 gleB,
-                                                 errMsg,
-                                                 false);
-
-                                insertErr = errMsg;
-                                BSONObj gle = gleB.obj();
-                                if (gle["err"].type() == String)
-                                    insertErr = gle["err"].String();
-
-                                LOG(3) << "intermediate GLE result was " << gle
-                                       << " errmsg: " << errMsg << endl;
-
-                                //
-                                // Clear out the shards we've checked so far, if we're successful
-                                //
-                                ci->clearSinceLastGetError();
+                                insertErr = _intermediateInsertGLE(r);
                             }
                         }
                         catch (DBException& e) {
@@ -807,7 +941,7 @@ namespace mongo {
 
                 // Reset our list of last shards we talked to, since we already got writebacks
                 // earlier.
-                if (d.moreJSObjs()) r.getClientInfo()->clearSinceLastGetError();
+                if (d.moreJSObjs() && !deferGLE) r.getClientInfo()->clearSinceLastGetError();
             }
         }
 
@@ -43,6 +43,8 @@ namespace mongo {
     const BSONField<BSONObj> SettingsType::balancerActiveWindow("activeWindow");
     const BSONField<bool> SettingsType::shortBalancerSleep("_nosleep");
     const BSONField<bool> SettingsType::secondaryThrottle("_secondaryThrottle");
+    const BSONField<int> SettingsType::maxConcurrentMigrations("maxConcurrentMigrations", 1);
+    const BSONField<bool> SettingsType::balanceByLoad("balanceByLoad", false);
 
     SettingsType::SettingsType() {
         clear();
@@ -96,6 +98,11 @@ namespace mongo {
                     return false;
                 }
             }
+            if (_isMaxConcurrentMigrationsSet && !(_maxConcurrentMigrations > 0)) {
+                *errMsg = stream() << maxConcurrentMigrations.name() <<
+                                      " must be greater than zero";
+                return false;
+            }
             return true;
         }
         else {
@@ -115,6 +122,10 @@ namespace mongo {
         }
         if (_isShortBalancerSleepSet) builder.append(shortBalancerSleep(), _shortBalancerSleep);
         if (_isSecondaryThrottleSet) builder.append(secondaryThrottle(), _secondaryThrottle);
+        if (_isMaxConcurrentMigrationsSet) {
+            builder.append(maxConcurrentMigrations(), _maxConcurrentMigrations);
+        }
+        if (_isBalanceByLoadSet) builder.append(balanceByLoad(), _balanceByLoad);
 
         return builder.obj();
     }
@@ -151,6 +162,15 @@ namespace mongo {
         if (fieldState == FieldParser::FIELD_INVALID) return false;
         _isSecondaryThrottleSet = fieldState == FieldParser::FIELD_SET;
 
+        fieldState = FieldParser::extract(source, maxConcurrentMigrations,
+                                          &_maxConcurrentMigrations, errMsg);
+        if (fieldState == FieldParser::FIELD_INVALID) return false;
+        _isMaxConcurrentMigrationsSet = fieldState == FieldParser::FIELD_SET;
+
+        fieldState = FieldParser::extract(source, balanceByLoad, &_balanceByLoad, errMsg);
+        if (fieldState == FieldParser::FIELD_INVALID) return false;
+        _isBalanceByLoadSet = fieldState == FieldParser::FIELD_SET;
+
         return true;
     }
 
@@ -174,6 +194,12 @@ namespace mongo {
         _secondaryThrottle = false;
         _isSecondaryThrottleSet = false;
 
+        _maxConcurrentMigrations = 1;
+        _isMaxConcurrentMigrationsSet = false;
+
+        _balanceByLoad = false;
+        _isBalanceByLoadSet = false;
+
     }
 
     void SettingsType::cloneTo(SettingsType* other) const {
@@ -197,6 +223,12 @@ namespace mongo {
         other->_secondaryThrottle = _secondaryThrottle;
         other->_isSecondaryThrottleSet = _isSecondaryThrottleSet;
 
+        other->_maxConcurrentMigrations = _maxConcurrentMigrations;
+        other->_isMaxConcurrentMigrationsSet = _isMaxConcurrentMigrationsSet;
+
+        other->_balanceByLoad = _balanceByLoad;
+        other->_isBalanceByLoadSet = _isBalanceByLoadSet;
+
     }
 
     std::string SettingsType::toString() const {
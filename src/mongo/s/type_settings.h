@@ -75,6 +75,8 @@ namespace mongo {
         static const BSONField<BSONObj> balancerActiveWindow;
         static const BSONField<bool> shortBalancerSleep;
         static const BSONField<bool> secondaryThrottle;
+        static const BSONField<int> maxConcurrentMigrations;
+        static const BSONField<bool> balanceByLoad;
 
         //
         // settings type methods
@@ -241,6 +243,48 @@ namespace mongo {
                 return secondaryThrottle.getDefault();
             }
         }
+        void setMaxConcurrentMigrations(int maxConcurrentMigrations) {
+            _maxConcurrentMigrations = maxConcurrentMigrations;
+            _isMaxConcurrentMigrationsSet = true;
+        }
+
+        void unsetMaxConcurrentMigrations() { _isMaxConcurrentMigrationsSet = false; }
+
+        bool isMaxConcurrentMigrationsSet() const {
+            return _isMaxConcurrentMigrationsSet || maxConcurrentMigrations.hasDefault();
+        }
+
+        // Calling get*() methods when the member is not set and has no default results in undefined
+        // behavior
+        int getMaxConcurrentMigrations() const {
+            if (_isMaxConcurrentMigrationsSet) {
+                return _maxConcurrentMigrations;
+            } else {
+                dassert(maxConcurrentMigrations.hasDefault());
+                return maxConcurrentMigrations.getDefault();
+            }
+        }
+        void setBalanceByLoad(bool balanceByLoad) {
+            _balanceByLoad = balanceByLoad;
+            _isBalanceByLoadSet = true;
+        }
+
+        void unsetBalanceByLoad() { _isBalanceByLoadSet = false; }
+
+        bool isBalanceByLoadSet() const {
+            return _isBalanceByLoadSet || balanceByLoad.hasDefault();
+        }
+
+        // Calling get*() methods when the member is not set and has no default results in undefined
+        // behavior
+        bool getBalanceByLoad() const {
+            if (_isBalanceByLoadSet) {
+                return _balanceByLoad;
+            } else {
+                dassert(balanceByLoad.hasDefault());
+                return balanceByLoad.getDefault();
+            }
+        }
 
     private:
         // Convention: (M)andatory, (O)ptional, (S)pecial rule.
@@ -264,6 +308,12 @@ namespace mongo {
 
         bool _secondaryThrottle;         // (O)  only migrate chunks as fast as at least
         bool _isSecondaryThrottleSet;    // one secondary can keep up with
+
+        int _maxConcurrentMigrations;    // (O)  how many migrations between distinct shards
+        bool _isMaxConcurrentMigrationsSet; // a balancing round may run at once
+
+        bool _balanceByLoad;             // (O)  balance collections by data size and operation
+        bool _isBalanceByLoadSet;        // rate rather than by chunk count
     };
 
 } // namespace mongo
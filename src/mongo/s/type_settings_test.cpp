@@ -95,7 +95,9 @@ namespace {
                            SettingsType::balancerActiveWindow(BSON("start" << "23:00" <<
                                                                    "stop" << "6:00" )) <<
                            SettingsType::shortBalancerSleep(true) <<
-                           SettingsType::secondaryThrottle(true));
+                           SettingsType::secondaryThrottle(true) <<
+                           SettingsType::maxConcurrentMigrations(4) <<
+                           SettingsType::balanceByLoad(true));
         ASSERT(settings.parseBSON(objBalancer, &errMsg));
         ASSERT_EQUALS(errMsg, "");
         ASSERT_TRUE(settings.isValid(NULL));
@@ -105,6 +107,13 @@ namespace {
                                                                "stop" << "6:00" ));
         ASSERT_EQUALS(settings.getShortBalancerSleep(), true);
         ASSERT_EQUALS(settings.getSecondaryThrottle(), true);
+        ASSERT_EQUALS(settings.getMaxConcurrentMigrations(), 4);
+        ASSERT_EQUALS(settings.getBalanceByLoad(), true);
+
+        BSONObj objNoMigrations = BSON(SettingsType::key("balancer") <<
+                                       SettingsType::maxConcurrentMigrations(0));
+        ASSERT(settings.parseBSON(objNoMigrations, &errMsg));
+        ASSERT_FALSE(settings.isValid(NULL));
     }
 
     TEST(Validity, BadType) {
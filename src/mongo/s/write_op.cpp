@@ -119,30 +119,41 @@ namespace mongo {
 
         for ( vector<ShardEndpoint*>::iterator it = endpoints.begin(); it != endpoints.end();
             ++it ) {
+            // For now, multiple endpoints imply no versioning
+            addTargetedWrite( **it, endpoints.size() > 1u, targetedWrites );
+        }
 
-            ShardEndpoint* endpoint = *it;
+        _state = WriteOpState_Pending;
+        return Status::OK();
+    }
 
-            _childOps.push_back( new ChildWriteOp( this ) );
+    void WriteOp::targetInsert( const ShardEndpoint& endpoint,
+                                std::vector<TargetedWrite*>* targetedWrites ) {
+        dassert( _itemRef.getOpType() == BatchedCommandRequest::BatchType_Insert );
+        addTargetedWrite( endpoint, false, targetedWrites );
+        _state = WriteOpState_Pending;
+    }
 
-            WriteOpRef ref( _itemRef.getItemIndex(), _childOps.size() - 1 );
+    void WriteOp::addTargetedWrite( const ShardEndpoint& endpoint,
+                                    bool broadcast,
+                                    std::vector<TargetedWrite*>* targetedWrites ) {
 
-            // For now, multiple endpoints imply no versioning
-            if ( endpoints.size() == 1u ) {
-                targetedWrites->push_back( new TargetedWrite( *endpoint, ref ) );
-            }
-            else {
-                ShardEndpoint broadcastEndpoint( endpoint->shardName,
-                                                 ChunkVersion::IGNORED(),
-                                                 endpoint->shardHost );
-                targetedWrites->push_back( new TargetedWrite( broadcastEndpoint, ref ) );
-            }
+        _childOps.push_back( new ChildWriteOp( this ) );
 
-            _childOps.back()->pendingWrite = targetedWrites->back();
-            _childOps.back()->state = WriteOpState_Pending;
+        WriteOpRef ref( _itemRef.getItemIndex(), _childOps.size() - 1 );
+
+        if ( !broadcast ) {
+            targetedWrites->push_back( new TargetedWrite( endpoint, ref ) );
+        }
+        else {
+            ShardEndpoint broadcastEndpoint( endpoint.shardName,
+                                             ChunkVersion::IGNORED(),
+                                             endpoint.shardHost );
+            targetedWrites->push_back( new TargetedWrite( broadcastEndpoint, ref ) );
         }
 
-        _state = WriteOpState_Pending;
-        return Status::OK();
+        _childOps.back()->pendingWrite = targetedWrites->back();
+        _childOps.back()->state = WriteOpState_Pending;
     }
 
     static bool isRetryErrCode( int errCode ) {
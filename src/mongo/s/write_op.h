@@ -124,6 +124,13 @@ namespace mongo {
         Status targetWrites( const NSTargeter& targeter,
                              std::vector<TargetedWrite*>* targetedWrites );
 
+        /**
+         * Creates the TargetedWrite for an insert whose document the caller has already targeted
+         * to endpoint, as when targeting a whole batch of inserts at once.
+         */
+        void targetInsert( const ShardEndpoint& endpoint,
+                           std::vector<TargetedWrite*>* targetedWrites );
+
         /**
          * Resets the state of this write op to _Ready and stops waiting for any outstanding
          * TargetedWrites.  Optional error can be provided for reporting.
@@ -157,6 +164,13 @@ namespace mongo {
 
     private:
 
+        /**
+         * Adds a pending child op and its TargetedWrite to endpoint, unversioned if broadcast.
+         */
+        void addTargetedWrite( const ShardEndpoint& endpoint,
+                               bool broadcast,
+                               std::vector<TargetedWrite*>* targetedWrites );
+
         /**
          * Updates the op state after new information is received.
          */
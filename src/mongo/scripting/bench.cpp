@@ -65,11 +65,49 @@ namespace mongo {
     void BenchRunEventCounter::reset() {
         _numEvents = 0;
         _totalTimeMicros = 0;
+        for (int i = 0; i < kNumBuckets; ++i)
+            _buckets[i] = 0;
     }
 
     void BenchRunEventCounter::updateFrom(const BenchRunEventCounter &other) {
         _numEvents += other._numEvents;
         _totalTimeMicros += other._totalTimeMicros;
+        for (int i = 0; i < kNumBuckets; ++i)
+            _buckets[i] += other._buckets[i];
+    }
+
+    // static
+    int BenchRunEventCounter::bucketFor(unsigned long long timeMicros) {
+        if (timeMicros < 4)
+            return static_cast<int>(timeMicros);
+        int log2 = 2;
+        while (timeMicros >> (log2 + 1))
+            ++log2;
+        int bucket = 4 * (log2 - 1) + static_cast<int>((timeMicros >> (log2 - 2)) & 3);
+        return std::min(bucket, kNumBuckets - 1);
+    }
+
+    // static
+    unsigned long long BenchRunEventCounter::upperBound(int bucket) {
+        if (bucket < 4)
+            return bucket;
+        int log2 = bucket / 4 + 1;
+        unsigned long long lower = static_cast<unsigned long long>(4 + bucket % 4) << (log2 - 2);
+        return lower + (1ULL << (log2 - 2)) - 1;
+    }
+
+    unsigned long long BenchRunEventCounter::getPercentileMicros(double fraction) const {
+        // the rank of the event at the percentile, counting from 1
+        unsigned long long rank = static_cast<unsigned long long>(fraction * _numEvents);
+        if (rank < _numEvents)
+            ++rank;
+        unsigned long long seen = 0;
+        for (int i = 0; i < kNumBuckets; ++i) {
+            seen += _buckets[i];
+            if (seen >= rank)
+                return upperBound(i);
+        }
+        return 0;
     }
 
     BenchRunStats::BenchRunStats() {
@@ -118,6 +156,7 @@ namespace mongo {
 
         parallel = 1;
         seconds = 1;
+        opsPerSecond = 0;
         hideResults = true;
         handleErrors = false;
         hideErrors = false;
@@ -155,6 +194,9 @@ namespace mongo {
             this->parallel = args["parallel"].numberInt();
         if ( args["seconds"].isNumber() )
             this->seconds = args["seconds"].number();
+        if ( args["opsPerSecond"].isNumber() )
+            this->opsPerSecond = args["opsPerSecond"].number();
+        uassert(17372, "benchRun opsPerSecond must not be negative", this->opsPerSecond >= 0);
         if ( ! args["hideResults"].eoo() )
             this->hideResults = args["hideResults"].trueValue();
         if ( ! args["handleErrors"].eoo() )
@@ -309,11 +351,32 @@ namespace mongo {
         return _brState->shouldWorkerFinish();
     }
 
+    unsigned long long BenchRunWorker::waitForScheduledOp( const Timer &timer,
+                                                           long long opNumber ) {
+        if ( _config->opsPerSecond <= 0 )
+            return 0;
+
+        // every worker runs its share of the rate, starting together
+        const double intervalMicros = 1000.0 * 1000 * _config->parallel / _config->opsPerSecond;
+        const unsigned long long dueMicros =
+                static_cast<unsigned long long>( opNumber * intervalMicros );
+
+        while ( !shouldStop() ) {
+            unsigned long long now = timer.micros();
+            if ( now >= dueMicros )
+                return now - dueMicros;
+            // wake up now and then so a slow rate doesn't hold up stopping the run
+            sleepmicros( std::min( dueMicros - now, 100 * 1000ULL ) );
+        }
+        return 0;
+    }
+
     void doNothing(const BSONObj&) { }
 
     void BenchRunWorker::generateLoadOnConnection( DBClientBase* conn ) {
         verify( conn );
         long long count = 0;
+        long long scheduled = 0;
         mongo::Timer timer;
 
         BsonTemplateEvaluator bsonTemplateEvaluator;
@@ -324,6 +387,9 @@ namespace mongo {
 
                 if ( shouldStop() ) break;
 
+                unsigned long long lagMicros = waitForScheduledOp( timer, scheduled++ );
+                if ( shouldStop() ) break;
+
                 BSONElement e = i.next();
 
                 string ns = e["ns"].String();
@@ -372,7 +438,7 @@ namespace mongo {
 
                         BSONObj result;
                         {
-                            BenchRunEventTrace _bret(&_stats.findOneCounter);
+                            BenchRunEventTrace _bret(&_stats.findOneCounter, lagMicros);
                             result = conn->findOne( ns , fixQuery( e["query"].Obj(),
                                                                    bsonTemplateEvaluator ) );
                         }
@@ -427,12 +493,12 @@ namespace mongo {
 
                         // use special query function for exhaust query option
                         if (options & QueryOption_Exhaust) {
-                            BenchRunEventTrace _bret(&_stats.queryCounter);
+                            BenchRunEventTrace _bret(&_stats.queryCounter, lagMicros);
                             boost::function<void (const BSONObj&)> castedDoNothing(doNothing);
                             count =  conn->query(castedDoNothing, ns, fixedQuery, &filter, options);
                         }
                         else {
-                            BenchRunEventTrace _bret(&_stats.queryCounter);
+                            BenchRunEventTrace _bret(&_stats.queryCounter, lagMicros);
                             cursor = conn->query(ns, fixedQuery, limit, skip, &filter, options,
                                                  batchSize);
                             count = cursor->itcount();
@@ -468,7 +534,7 @@ namespace mongo {
                         bool safe = e["safe"].trueValue();
 
                         {
-                            BenchRunEventTrace _bret(&_stats.updateCounter);
+                            BenchRunEventTrace _bret(&_stats.updateCounter, lagMicros);
                             conn->update( ns, fixQuery( query, bsonTemplateEvaluator ), update,
                                           upsert , multi );
                             if (safe)
@@ -498,7 +564,7 @@ namespace mongo {
                         bool safe = e["safe"].trueValue();
                         BSONObj result;
                         {
-                            BenchRunEventTrace _bret(&_stats.insertCounter);
+                            BenchRunEventTrace _bret(&_stats.insertCounter, lagMicros);
                             conn->insert( ns, fixQuery( e["doc"].Obj(), bsonTemplateEvaluator ) );
                             if (safe)
                                 result = conn->getLastErrorDetailed();
@@ -531,7 +597,7 @@ namespace mongo {
                         BSONObj result;
 
                         {
-                            BenchRunEventTrace _bret(&_stats.deleteCounter);
+                            BenchRunEventTrace _bret(&_stats.deleteCounter, lagMicros);
                             conn->remove( ns, fixQuery( query, bsonTemplateEvaluator ), ! multi );
                             if (safe)
                                 result = conn->getLastErrorDetailed();
@@ -761,6 +827,18 @@ namespace mongo {
                         static_cast<double>(counter.getTotalTimeMicros()) / counter.getNumEvents());
      }
 
+     static void appendPercentileMicrosIfAvailable(
+             BSONObjBuilder &buf, const std::string &name, const BenchRunEventCounter &counter) {
+
+         if (counter.getNumEvents() == 0)
+             return;
+         BSONObjBuilder percentiles(buf.subobjStart(name));
+         percentiles.appendNumber("p50", (long long) counter.getPercentileMicros(0.5));
+         percentiles.appendNumber("p99", (long long) counter.getPercentileMicros(0.99));
+         percentiles.appendNumber("p999", (long long) counter.getPercentileMicros(0.999));
+         percentiles.done();
+     }
+
      BSONObj BenchRunner::finish( BenchRunner* runner ) {
 
          runner->stop();
@@ -787,6 +865,16 @@ namespace mongo {
          appendAverageMicrosIfAvailable(buf, "deleteLatencyAverageMicros", stats.deleteCounter);
          appendAverageMicrosIfAvailable(buf, "updateLatencyAverageMicros", stats.updateCounter);
          appendAverageMicrosIfAvailable(buf, "queryLatencyAverageMicros", stats.queryCounter);
+         appendPercentileMicrosIfAvailable(buf, "findOneLatencyPercentilesMicros",
+                                           stats.findOneCounter);
+         appendPercentileMicrosIfAvailable(buf, "insertLatencyPercentilesMicros",
+                                           stats.insertCounter);
+         appendPercentileMicrosIfAvailable(buf, "deleteLatencyPercentilesMicros",
+                                           stats.deleteCounter);
+         appendPercentileMicrosIfAvailable(buf, "updateLatencyPercentilesMicros",
+                                           stats.updateCounter);
+         appendPercentileMicrosIfAvailable(buf, "queryLatencyPercentilesMicros",
+                                           stats.queryCounter);
 
          {
              BSONObjIterator i( after );
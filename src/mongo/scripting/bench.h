@@ -85,6 +85,15 @@ namespace mongo {
          */
         double seconds;
 
+        /**
+         * Target rate of operations per second across all threads.  When zero, each thread
+         * sends its next operation as soon as the last one returns.  Otherwise each thread sends
+         * operations on a fixed schedule, whether or not earlier ones have returned in time, and
+         * latencies are measured from when an operation was due rather than from when it was
+         * sent, so a stall is charged to every operation it delayed.
+         */
+        double opsPerSecond;
+
         bool hideResults;
         bool handleErrors;
         bool hideErrors;
@@ -142,6 +151,7 @@ namespace mongo {
         void countOne(unsigned long long timeMicros) {
             ++_numEvents;
             _totalTimeMicros += timeMicros;
+            ++_buckets[bucketFor(timeMicros)];
         }
 
         /**
@@ -154,9 +164,23 @@ namespace mongo {
          */
         unsigned long long getNumEvents() const { return _numEvents; }
 
+        /**
+         * Get the latency below which "fraction" of the observed events fell.  Latencies are
+         * counted in buckets, four to each power of two microseconds, and this is the upper bound
+         * of the bucket the percentile falls in, so it is high by at most a quarter.
+         */
+        unsigned long long getPercentileMicros(double fraction) const;
+
     private:
+        // Enough for latencies up to 2^40 micros.
+        static const int kNumBuckets = 160;
+
+        static int bucketFor(unsigned long long timeMicros);
+        static unsigned long long upperBound(int bucket);
+
         unsigned long long _numEvents;
         unsigned long long _totalTimeMicros;
+        unsigned long long _buckets[kNumBuckets];
     };
 
     /**
@@ -174,18 +198,25 @@ namespace mongo {
      */
     class BenchRunEventTrace : private boost::noncopyable {
     public:
-        explicit BenchRunEventTrace(BenchRunEventCounter *eventCounter) {
+        /**
+         * "lagMicros" is added to the measured duration, for an event that was due to start
+         * that long before it did.
+         */
+        explicit BenchRunEventTrace(BenchRunEventCounter *eventCounter,
+                                    unsigned long long lagMicros=0) {
             initialize(eventCounter, eventCounter, false);
+            _lagMicros = lagMicros;
         }
 
         BenchRunEventTrace(BenchRunEventCounter *successCounter,
                            BenchRunEventCounter *failCounter,
                            bool defaultToFailure=true) {
             initialize(successCounter, failCounter, defaultToFailure);
+            _lagMicros = 0;
         }
 
         ~BenchRunEventTrace() {
-            (_succeeded ? _successCounter : _failCounter)->countOne(_timer.micros());
+            (_succeeded ? _successCounter : _failCounter)->countOne(_timer.micros() + _lagMicros);
         }
 
         void succeed() { _succeeded = true; }
@@ -201,6 +232,7 @@ namespace mongo {
         }
 
         Timer _timer;
+        unsigned long long _lagMicros;
         BenchRunEventCounter *_successCounter;
         BenchRunEventCounter *_failCounter;
         bool _succeeded;
@@ -332,6 +364,12 @@ namespace mongo {
         /// Predicate, used to decide whether or not it's time to terminate the worker.
         bool shouldStop() const;
 
+        /**
+         * In open-loop mode, sleep until the operation "opNumber" of this worker is due, and
+         * return how many micros past due it already is.  Returns 0 in closed-loop mode.
+         */
+        unsigned long long waitForScheduledOp( const Timer &timer, long long opNumber );
+
         const BenchRunConfig *_config;
         BenchRunState *_brState;
         BenchRunStats _stats;
@@ -24,6 +24,7 @@
 
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/client/dbclientinterface.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/platform/unordered_set.h"
 #include "mongo/scripting/bench.h"
 #include "mongo/util/file.h"
@@ -268,12 +269,23 @@ namespace mongo {
         injectNative("benchFinish", BenchRunner::benchFinish);
     }
 
+    // Idle scopes kept for reuse, in all and for any one database, and how many uses a scope
+    // gets before it's discarded.  A pooled scope keeps its context, the db bindings and the
+    // functions it compiled, so any $where or map/reduce it runs again skips all of that.
+    MONGO_EXPORT_SERVER_PARAMETER(jsScopePoolSize, int, 10);
+    MONGO_EXPORT_SERVER_PARAMETER(jsScopePoolSizePerDatabase, int, 4);
+    MONGO_EXPORT_SERVER_PARAMETER(jsScopeMaxReuse, int, 10);
+
+    Counter64 ScriptEngine::_scopePoolHits;
+    Counter64 ScriptEngine::_scopePoolMisses;
+
 namespace {
     class ScopeCache {
     public:
         ScopeCache() : _mutex("ScopeCache") {}
 
-        void release(const string& poolName, const boost::shared_ptr<Scope>& scope) {
+        void release(const string& db, const string& poolName,
+                     const boost::shared_ptr<Scope>& scope) {
             scoped_lock lk(_mutex);
 
             if (scope->hasOutOfMemoryException()) {
@@ -283,18 +295,37 @@ namespace {
                 return;
             }
 
-            if (scope->getTimesUsed() > kMaxScopeReuse)
+            if (scope->getTimesUsed() > jsScopeMaxReuse)
                 return; // used too many times to save
 
             if (!scope->getError().empty())
                 return; // not saving errored scopes
 
-            if (_pools.size() >= kMaxPoolSize) {
+            const unsigned maxPoolSize = std::max(0, static_cast<int>(jsScopePoolSize));
+            if (maxPoolSize == 0)
+                return;
+
+            // one database's scopes mustn't push out every other database's: past its share it
+            // gives up its own least recently used scope
+            const int maxForDb = std::max(1, static_cast<int>(jsScopePoolSizePerDatabase));
+            int forDb = 0;
+            Pools::iterator oldestForDb = _pools.end();
+            for (Pools::iterator it = _pools.begin(); it != _pools.end(); ++it) {
+                if (it->db == db) {
+                    ++forDb;
+                    oldestForDb = it;
+                }
+            }
+            if (forDb >= maxForDb) {
+                _pools.erase(oldestForDb);
+            }
+
+            while (_pools.size() >= maxPoolSize) {
                 // prefer to keep recently-used scopes
                 _pools.pop_back();
             }
 
-            ScopeAndPool toStore = {scope, poolName};
+            ScopeAndPool toStore = {scope, db, poolName};
             _pools.push_front(toStore);
         }
 
@@ -317,13 +348,12 @@ namespace {
     private:
         struct ScopeAndPool {
             boost::shared_ptr<Scope> scope;
+            string db;
             string poolName;
         };
 
-        // Note: if these numbers change, reconsider choice of datastructure for _pools
-        static const unsigned kMaxPoolSize = 10;
-        static const int kMaxScopeReuse = 10;
-
+        // Note: jsScopePoolSize is expected to stay in the tens; reconsider the choice of
+        // datastructure for _pools if it doesn't
         typedef deque<ScopeAndPool> Pools; // More-recently used Scopes are kept at the front.
         Pools _pools;    // protected by _mutex
         mongo::mutex _mutex;
@@ -334,14 +364,16 @@ namespace {
 
     class PooledScope : public Scope {
     public:
-        PooledScope(const std::string& pool, const boost::shared_ptr<Scope>& real)
-            : _pool(pool)
+        PooledScope(const std::string& db, const std::string& pool,
+                    const boost::shared_ptr<Scope>& real)
+            : _db(db)
+            , _pool(pool)
             , _real(real) {
             _real->loadStored(true);
         }
 
         virtual ~PooledScope() {
-            scopeCache.release(_pool, _real);
+            scopeCache.release(_db, _pool, _real);
         }
 
         // wrappers for the derived (_real) scope
@@ -402,6 +434,7 @@ namespace {
         }
 
     private:
+        string _db;
         string _pool;
         boost::shared_ptr<Scope> _real;
     };
@@ -410,12 +443,16 @@ namespace {
     auto_ptr<Scope> ScriptEngine::getPooledScope(const string& db, const string& scopeType) {
         const string fullPoolName = db + scopeType;
         boost::shared_ptr<Scope> s = scopeCache.tryAcquire(fullPoolName);
-        if (!s) {
+        if (s) {
+            _scopePoolHits.increment();
+        }
+        else {
+            _scopePoolMisses.increment();
             s.reset(newScope());
         }
 
         auto_ptr<Scope> p;
-        p.reset(new PooledScope(fullPoolName, s));
+        p.reset(new PooledScope(db, fullPoolName, s));
         p->setLocalDB(db);
         p->loadStored(true);
         return p;
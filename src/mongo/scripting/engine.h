@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include "mongo/base/counter.h"
 #include "mongo/db/jsobj.h"
 
 namespace mongo {
@@ -195,6 +196,10 @@ namespace mongo {
          */
         auto_ptr<Scope> getPooledScope(const string& db, const string& scopeType);
 
+        /** getPooledScope() calls that found a pooled scope, and those that made a new one */
+        static const Counter64* scopePoolHits() { return &_scopePoolHits; }
+        static const Counter64* scopePoolMisses() { return &_scopePoolMisses; }
+
         void setScopeInitCallback(void (*func)(Scope&)) { _scopeInitCallback = func; }
         static void setConnectCallback(void (*func)(DBClientWithCommands&)) {
             _connectCallback = func;
@@ -235,6 +240,9 @@ namespace mongo {
         void (*_scopeInitCallback)(Scope&);
 
     private:
+        static Counter64 _scopePoolHits;
+        static Counter64 _scopePoolMisses;
+
         static void (*_connectCallback)(DBClientWithCommands&);
         static const char* (*_checkInterruptCallback)();
         static unsigned (*_getCurrentOpIdCallback)();
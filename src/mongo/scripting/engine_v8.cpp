@@ -64,11 +64,12 @@ namespace mongo {
         return obj->GetInternalField(1).As<v8::Object>();
     }
 
-    void V8Scope::wrapBSONObject(v8::Handle<v8::Object> obj, BSONObj data, bool readOnly) {
+    void V8Scope::wrapBSONObject(v8::Handle<v8::Object> obj, BSONObj data, bool readOnly,
+                                 const BSONObj* owner) {
         verify(LazyBsonFT()->HasInstance(obj));
 
         // Nothing below throws
-        BSONHolder* holder = new BSONHolder(data);
+        BSONHolder* holder = new BSONHolder(data, owner);
         holder->_readOnly = readOnly;
         holder->_scope = this;
         obj->SetInternalField(0, v8::External::New(holder)); // Holder
@@ -77,6 +78,43 @@ namespace mongo {
         bsonHolderTracker.track(p, holder);
     }
 
+    /**
+     * If accessing a subobject, it may get modified and the base obj would not know.  A lazy
+     * subobject tracks that itself, so v8ToMongo can ask it; anything else (arrays, DBRefs) has
+     * to set the base as modified, which means some optim is lost.
+     */
+    static void noteSubobjectAccess(V8Scope* scope, BSONHolder* holder, const BSONElement& elmt,
+                                    const v8::Handle<v8::Value>& val) {
+        if (elmt.type() != mongo::Object && elmt.type() != mongo::Array)
+            return;
+        if (elmt.type() == mongo::Object && scope->LazyBsonFT()->HasInstance(val))
+            holder->_childAccessed = true;
+        else
+            holder->_modified = true;
+    }
+
+    /** @return true if obj is a lazy object that, with each lazy subobject read from it, is
+     *  unchanged, so that its original BSON can be used as is */
+    static bool lazyUnmodified(V8Scope* scope, const v8::Handle<v8::Object>& obj) {
+        BSONHolder* holder = unwrapHolder(scope, obj);
+        if (!holder || holder->_modified)
+            return false;
+        if (!holder->_childAccessed)
+            return true;
+
+        v8::Handle<v8::Object> realObject = unwrapObject(scope, obj);
+        if (realObject.IsEmpty())
+            return false;
+        v8::Local<v8::Array> names = realObject->GetOwnPropertyNames();
+        for (unsigned int i = 0; i < names->Length(); i++) {
+            v8::Local<v8::Value> value = realObject->Get(names->Get(i));
+            if (scope->LazyBsonFT()->HasInstance(value) &&
+                !lazyUnmodified(scope, value.As<v8::Object>()))
+                return false;
+        }
+        return true;
+    }
+
     static v8::Handle<v8::Value> namedGet(v8::Local<v8::String> name,
                                           const v8::AccessorInfo& info) {
         v8::HandleScope handle_scope;
@@ -100,18 +138,14 @@ namespace mongo {
             if (elmt.eoo())
                 return handle_scope.Close(v8::Handle<v8::Value>());
 
-            val = scope->mongoToV8Element(elmt, holder->_readOnly);
+            val = scope->mongoToV8Element(elmt, holder->_readOnly, holder->bufferOwner());
 
             if (obj.objsize() > 128 || val->IsObject()) {
                 // Only cache if expected to help (large BSON) or is required due to js semantics
                 realObject->Set(name, val);
             }
 
-            if (elmt.type() == mongo::Object || elmt.type() == mongo::Array) {
-              // if accessing a subobject, it may get modified and base obj would not know
-              // have to set base as modified, which means some optim is lost
-              holder->_modified = true;
-            }
+            noteSubobjectAccess(scope, holder, elmt, val);
         }
         catch (const DBException &dbEx) {
             return v8AssertionException(dbEx.toString());
@@ -217,14 +251,10 @@ namespace mongo {
             BSONElement elmt = obj.getField(key);
             if (elmt.eoo())
                 return handle_scope.Close(v8::Handle<v8::Value>());
-            val = scope->mongoToV8Element(elmt, holder->_readOnly);
+            val = scope->mongoToV8Element(elmt, holder->_readOnly, holder->bufferOwner());
             realObject->Set(index, val);
 
-            if (elmt.type() == mongo::Object || elmt.type() == mongo::Array) {
-                // if accessing a subobject, it may get modified and base obj would not know
-                // have to set base as modified, which means some optim is lost
-                holder->_modified = true;
-            }
+            noteSubobjectAccess(scope, holder, elmt, val);
         }
         catch (const DBException &dbEx) {
             return v8AssertionException(dbEx.toString());
@@ -1322,7 +1352,8 @@ namespace mongo {
     /**
      * converts a BSONObj to a Lazy V8 object
      */
-    v8::Handle<v8::Object> V8Scope::mongoToLZV8(const BSONObj& m, bool readOnly) {
+    v8::Handle<v8::Object> V8Scope::mongoToLZV8(const BSONObj& m, bool readOnly,
+                                                const BSONObj* owner) {
         if (m.firstElementType() == String && str::equals(m.firstElementFieldName(), "$ref")) {
             BSONObjIterator it(m);
             const BSONElement ref = it.next();
@@ -1349,11 +1380,12 @@ namespace mongo {
                                         "v8 still executing."),
                        *o != NULL);
 
-        wrapBSONObject(o, m, readOnly);
+        wrapBSONObject(o, m, readOnly, owner);
         return o;
     }
 
-    v8::Handle<v8::Value> V8Scope::mongoToV8Element(const BSONElement &elem, bool readOnly) {
+    v8::Handle<v8::Value> V8Scope::mongoToV8Element(const BSONElement &elem, bool readOnly,
+                                                    const BSONObj* owner) {
         v8::Handle<v8::Value> argv[3];      // arguments for v8 instance constructors
         v8::Local<v8::Object> instance;     // instance of v8 type
         uint64_t nativeUnsignedLong;        // native representation of NumberLong
@@ -1385,12 +1417,12 @@ namespace mongo {
             v8::Handle<v8::Array> array = v8::Array::New();
             int i = 0;
             BSONForEach(subElem, elem.embeddedObject()) {
-                array->Set(i++, mongoToV8Element(subElem, readOnly));
+                array->Set(i++, mongoToV8Element(subElem, readOnly, owner));
             }
             return array;
         }
         case mongo::Object:
-            return mongoToLZV8(elem.embeddedObject(), readOnly);
+            return mongoToLZV8(elem.embeddedObject(), readOnly, owner);
         case mongo::Date:
             return v8::Date::New((double) ((long long)elem.date().millis));
         case mongo::Bool:
@@ -1630,10 +1662,11 @@ namespace mongo {
         BSONObj originalBSON;
         if (LazyBsonFT()->HasInstance(o)) {
             originalBSON = unwrapBSONObj(this, o);
-            BSONHolder* holder = unwrapHolder(this, o);
-            if (holder && !holder->_modified) {
-                // object was not modified, use bson as is
-                return originalBSON;
+            if (lazyUnmodified(this, o)) {
+                // object was not modified, use bson as is.  a subobject's bson lies within its
+                // document's, which the caller can't hold on to: only a nested one is copied
+                // right away
+                return depth == 0 ? originalBSON.getOwned() : originalBSON;
             }
         }
 
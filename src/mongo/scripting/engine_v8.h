@@ -230,8 +230,11 @@ namespace mongo {
         /**
          * Convert BSON types to v8 Javascript types
          */
-        v8::Handle<v8::Object> mongoToLZV8(const mongo::BSONObj& m, bool readOnly = false);
-        v8::Handle<v8::Value> mongoToV8Element(const BSONElement& f, bool readOnly = false);
+        /** owner, if given, is an owned object m or f lies within, for m to be used in place */
+        v8::Handle<v8::Object> mongoToLZV8(const mongo::BSONObj& m, bool readOnly = false,
+                                           const mongo::BSONObj* owner = NULL);
+        v8::Handle<v8::Value> mongoToV8Element(const BSONElement& f, bool readOnly = false,
+                                               const mongo::BSONObj* owner = NULL);
 
         /**
          * Convert v8 Javascript types to BSON types
@@ -343,7 +346,8 @@ namespace mongo {
          * Attach data to obj such that the data has the same lifetime as the Object obj points to.
          * obj must have been created by either LazyBsonFT or ROBsonFT.
          */
-        void wrapBSONObject(v8::Handle<v8::Object> obj, BSONObj data, bool readOnly);
+        void wrapBSONObject(v8::Handle<v8::Object> obj, BSONObj data, bool readOnly,
+                            const BSONObj* owner = NULL);
 
         /**
          * Trampoline to call a c++ function with a specific signature (V8Scope*, v8::Arguments&).
@@ -517,21 +521,34 @@ namespace mongo {
     class BSONHolder {
     MONGO_DISALLOW_COPYING(BSONHolder);
     public:
-        explicit BSONHolder(BSONObj obj) :
+        /**
+         * @param owner  if given, an owned object that obj lies within, such as the document of
+         *               a subobject.  obj is then used in place rather than copied.
+         */
+        explicit BSONHolder(BSONObj obj, const BSONObj* owner = NULL) :
             _scope(NULL),
-            _obj(obj.getOwned()),
-            _modified(false) {
+            _obj(owner ? obj : obj.getOwned()),
+            _owner(owner ? *owner : BSONObj()),
+            _external(owner ? 0 : _obj.objsize()),
+            _modified(false),
+            _childAccessed(false) {
             // give hint v8's GC
-            v8::V8::AdjustAmountOfExternalAllocatedMemory(_obj.objsize());
+            v8::V8::AdjustAmountOfExternalAllocatedMemory(_external);
         }
         ~BSONHolder() {
             if (_scope && _scope->getIsolate())
                 // if v8 is still up, send hint to GC
-                v8::V8::AdjustAmountOfExternalAllocatedMemory(-_obj.objsize());
+                v8::V8::AdjustAmountOfExternalAllocatedMemory(-_external);
         }
+        /** the owned object _obj lies within, for subobjects read from _obj to use in place */
+        const BSONObj* bufferOwner() const { return _obj.isOwned() ? &_obj : &_owner; }
+
         V8Scope* _scope;
         BSONObj _obj;
+        BSONObj _owner; // keeps _obj's buffer alive when _obj isn't owned
+        int _external;
         bool _modified;
+        bool _childAccessed; // a lazy subobject was read, and may have been modified since
         bool _readOnly;
         set<string> _removed;
     };
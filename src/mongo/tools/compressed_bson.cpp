@@ -0,0 +1,76 @@
+// compressed_bson.cpp
+
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/tools/compressed_bson.h"
+
+#include "mongo/util/compress.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    const char* const compressedBSONSuffix = ".snappy";
+
+    void CompressedBSONWriter::write( const BSONObj& obj ) {
+        _block.append( obj.objdata(), obj.objsize() );
+        if ( _block.size() >= BlockBytes )
+            _writeBlock();
+    }
+
+    void CompressedBSONWriter::finish() {
+        if ( ! _block.empty() )
+            _writeBlock();
+    }
+
+    void CompressedBSONWriter::_writeBlock() {
+        int len = compress( _block.data(), _block.size(), &_compressed );
+        uassert( 17373, errnoWithPrefix( "couldn't write to file" ),
+                 fwrite( &len, 4, 1, _out ) == 1 &&
+                 fwrite( _compressed.data(), len, 1, _out ) == 1 );
+        _block.clear();
+    }
+
+    bool CompressedBSONReader::next( BSONObj* obj ) {
+        while ( _pos >= _block.size() ) {
+            int len;
+            size_t amt = fread( &len, 1, 4, _in );
+            if ( amt == 0 && feof( _in ) )
+                return false;
+            uassert( 17374, "truncated compressed block", amt == 4 && len > 0 );
+
+            _compressed.resize( len );
+            uassert( 17375, "truncated compressed block",
+                     fread( &_compressed[0], len, 1, _in ) == 1 );
+            uassert( 17376, "couldn't uncompress block",
+                     uncompress( _compressed.data(), len, &_block ) );
+            _pos = 0;
+            _bytesRead += 4 + len;
+        }
+
+        const char* data = _block.data() + _pos;
+        int size;
+        memcpy( &size, data, 4 );
+        uassert( 17377, mongoutils::str::stream() << "invalid object size: " << size,
+                 size >= 5 && _pos + size <= _block.size() );
+        *obj = BSONObj( data );
+        _pos += size;
+        return true;
+    }
+
+}
@@ -0,0 +1,77 @@
+// compressed_bson.h
+
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <boost/noncopyable.hpp>
+
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    /**
+     * A compressed dump file holds the documents of a .bson file in blocks.  Each block is the
+     * length of its compressed bytes, little endian like the BSON in it, followed by a snappy
+     * compressed run of whole documents.  Its name is that of the .bson file with this suffix.
+     */
+    extern const char* const compressedBSONSuffix;
+
+    class CompressedBSONWriter : boost::noncopyable {
+    public:
+        explicit CompressedBSONWriter( FILE* out ) : _out( out ) {}
+
+        void write( const BSONObj& obj );
+
+        /** writes the documents buffered since the last full block; call before closing out */
+        void finish();
+
+    private:
+        // uncompressed bytes per block
+        static const size_t BlockBytes = 1024 * 1024;
+
+        void _writeBlock();
+
+        FILE* _out;
+        std::string _block;
+        std::string _compressed;
+    };
+
+    class CompressedBSONReader : boost::noncopyable {
+    public:
+        explicit CompressedBSONReader( FILE* in ) : _in( in ), _pos( 0 ), _bytesRead( 0 ) {}
+
+        /**
+         * Sets *obj to the next document, which stays valid until the next call.
+         * @return false at the end of the file
+         */
+        bool next( BSONObj* obj );
+
+        /** bytes of the file read so far */
+        unsigned long long bytesRead() const { return _bytesRead; }
+
+    private:
+        FILE* _in;
+        std::string _compressed;
+        std::string _block;
+        size_t _pos;
+        unsigned long long _bytesRead;
+    };
+
+}
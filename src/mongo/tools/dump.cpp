@@ -18,6 +18,7 @@
 
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/convenience.hpp>
+#include <boost/thread/thread.hpp>
 #include <fcntl.h>
 #include <fstream>
 #include <map>
@@ -25,8 +26,10 @@
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/db/db.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/tools/compressed_bson.h"
 #include "mongo/tools/mongodump_options.h"
 #include "mongo/tools/tool.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/options_parser/option_section.h"
 
 using namespace mongo;
@@ -40,26 +43,34 @@ class Dump : public Tool {
     private:
         FILE* _f;
     };
-public:
-    Dump() : Tool() { }
-
-    virtual void printHelp(ostream& out) {
-        printMongoDumpHelp(&out);
-    }
 
-    // This is a functor that writes a BSONObj to a file
-    struct Writer {
-        Writer(FILE* out, ProgressMeter* m) :_out(out), _m(m) {}
-
-        void operator () (const BSONObj& obj) {
-            size_t toWrite = obj.objsize();
-            size_t written = 0;
+    /**
+     * The .bson file of a collection.  The cursors reading the ranges of a collection write to it
+     * in turn, a document at a time.
+     */
+    class OutputFile : boost::noncopyable {
+    public:
+        OutputFile(FILE* out, bool compress, ProgressMeter* m) :
+            _mutex("dumpOutputFile"), _out(out), _m(m) {
+            if (compress)
+                _compressed.reset(new CompressedBSONWriter(out));
+        }
 
-            while (toWrite) {
-                size_t ret = fwrite( obj.objdata()+written, 1, toWrite, _out );
-                uassert(14035, errnoWithPrefix("couldn't write to file"), ret);
-                toWrite -= ret;
-                written += ret;
+        void write(const BSONObj& obj) {
+            scoped_lock lk(_mutex);
+            if (_compressed) {
+                _compressed->write(obj);
+            }
+            else {
+                size_t toWrite = obj.objsize();
+                size_t written = 0;
+
+                while (toWrite) {
+                    size_t ret = fwrite( obj.objdata()+written, 1, toWrite, _out );
+                    uassert(14035, errnoWithPrefix("couldn't write to file"), ret);
+                    toWrite -= ret;
+                    written += ret;
+                }
             }
 
             // if there's a progress bar, hit it
@@ -68,11 +79,44 @@ public:
             }
         }
 
+        /** writes what compression holds back; call once every cursor is done */
+        void finish() {
+            if (_compressed)
+                _compressed->finish();
+        }
+
+    private:
+        mongo::mutex _mutex;
         FILE* _out;
         ProgressMeter* _m;
+        scoped_ptr<CompressedBSONWriter> _compressed;
     };
 
-    void doCollection( const string coll , FILE* out , ProgressMeter *m ) {
+    /** what the collections of a database need from its system.namespaces and system.indexes */
+    struct DatabaseMetadata {
+        map<string, BSONObj> collectionOptions;
+        multimap<string, BSONObj> indexes;
+    };
+
+public:
+    Dump() : Tool(), _errorMutex("dumpErrors") { }
+
+    virtual void printHelp(ostream& out) {
+        printMongoDumpHelp(&out);
+    }
+
+    // This is a functor that writes a BSONObj to a file
+    struct Writer {
+        Writer(OutputFile* out) :_out(out) {}
+
+        void operator () (const BSONObj& obj) {
+            _out->write(obj);
+        }
+
+        OutputFile* _out;
+    };
+
+    void doCollection( const string coll , OutputFile* out , DBClientBase& connBase ) {
         Query q = _query;
 
         int queryOptions = QueryOption_SlaveOk | QueryOption_NoCursorTimeout;
@@ -81,9 +125,12 @@ public:
         else if (mongoDumpGlobalParams.snapShotQuery) {
             q.snapshot();
         }
+        else if (_canSplitCollections && _query.isEmpty() &&
+                 doCollectionRanges(coll, out, connBase)) {
+            return;
+        }
         
-        DBClientBase& connBase = conn(true);
-        Writer writer(out, m);
+        Writer writer(out);
 
         // use low-latency "exhaust" mode if going over the network
         if (!_usingMongos && typeid(connBase) == typeid(DBClientConnection&)) {
@@ -94,48 +141,100 @@ public:
         else {
             //This branch should only be taken with DBDirectClient or mongos which doesn't support exhaust mode
             scoped_ptr<DBClientCursor> cursor(connBase.query( coll.c_str() , q , 0 , 0 , 0 , queryOptions ));
+            cursor->setPrefetch(true, DBClientCursor::PrefetchAtHalfBatch, true);
             while ( cursor->more() ) {
                 writer(cursor->next());
             }
         }
     }
 
-    void writeCollectionFile( const string coll , boost::filesystem::path outputFile ) {
+    /**
+     * Reads coll over the cursors of a parallelCollectionScan, each drained by a thread and
+     * connection of its own.  @return false, having read nothing, if the server can't split coll
+     * (it is capped, or the server is too old).
+     */
+    bool doCollectionRanges( const string& coll , OutputFile* out , DBClientBase& connBase ) {
+        BSONObj res;
+        BSONObj cmd = BSON("parallelCollectionScan" << nsToCollectionSubstring(coll) <<
+                           "numCursors" << mongoDumpGlobalParams.numCursorsPerCollection);
+        if (!connBase.runCommand(nsToDatabase(coll), cmd, res, QueryOption_SlaveOk)) {
+            if (logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(1))) {
+                toolInfoLog() << "\t\t reading " << coll << " with one cursor: " << res
+                              << std::endl;
+            }
+            return false;
+        }
+
+        boost::thread_group threads;
+        vector<BSONElement> cursors = res["cursors"].Array();
+        for (vector<BSONElement>::iterator it = cursors.begin(); it != cursors.end(); ++it) {
+            long long cursorId = it->Obj()["cursor"]["id"].numberLong();
+            threads.create_thread(boost::bind(&Dump::drainCursor, this, coll, cursorId, out));
+        }
+        threads.join_all();
+        return true;
+    }
+
+    void drainCursor( const string coll , long long cursorId , OutputFile* out ) {
+        try {
+            scoped_ptr<DBClientBase> connBase(newConnection(true));
+            DBClientCursor cursor(connBase.get(), coll, cursorId, 0,
+                                  QueryOption_SlaveOk | QueryOption_NoCursorTimeout);
+            cursor.setPrefetch(true, DBClientCursor::PrefetchAtHalfBatch, true);
+            while (cursor.more()) {
+                out->write(cursor.next());
+            }
+        }
+        catch (std::exception& e) {
+            noteError(str::stream() << "reading part of " << coll << ": " << e.what());
+        }
+    }
+
+    void writeCollectionFile( const string coll , boost::filesystem::path outputFile ,
+                              DBClientBase& connBase , bool compress ) {
+        if (compress) {
+            outputFile = outputFile.string() + compressedBSONSuffix;
+        }
         toolInfoLog() << "\t" << coll << " to " << outputFile.string() << std::endl;
 
         FilePtr f (fopen(outputFile.string().c_str(), "wb"));
         uassert(10262, errnoWithPrefix("couldn't open file"), f);
 
-        ProgressMeter m(conn(true).count(coll.c_str(), BSONObj(), QueryOption_SlaveOk));
+        ProgressMeter m(connBase.count(coll.c_str(), BSONObj(), QueryOption_SlaveOk));
         m.setName("Collection File Writing Progress");
         m.setUnits("objects");
 
-        doCollection(coll, f, &m);
+        OutputFile out(f, compress, &m);
+        doCollection(coll, &out, connBase);
+        out.finish();
 
         toolInfoLog() << "\t\t " << m.done() << " objects" << std::endl;
     }
 
     void writeMetadataFile( const string coll, boost::filesystem::path outputFile, 
-                            map<string, BSONObj> options, multimap<string, BSONObj> indexes ) {
+                            const DatabaseMetadata& metadata ) {
         toolInfoLog() << "\tMetadata for " << coll << " to " << outputFile.string() << std::endl;
 
+        const map<string, BSONObj>& options = metadata.collectionOptions;
+        const multimap<string, BSONObj>& indexes = metadata.indexes;
         bool hasOptions = options.count(coll) > 0;
         bool hasIndexes = indexes.count(coll) > 0;
 
-        BSONObjBuilder metadata;
+        BSONObjBuilder b;
 
         if (hasOptions) {
-            metadata << "options" << options.find(coll)->second;
+            b << "options" << options.find(coll)->second;
         }
 
         if (hasIndexes) {
-            BSONArrayBuilder indexesOutput (metadata.subarrayStart("indexes"));
+            BSONArrayBuilder indexesOutput (b.subarrayStart("indexes"));
 
             // I'd kill for C++11 auto here...
-            const pair<multimap<string, BSONObj>::iterator, multimap<string, BSONObj>::iterator>
+            const pair<multimap<string, BSONObj>::const_iterator,
+                       multimap<string, BSONObj>::const_iterator>
                 range = indexes.equal_range(coll);
 
-            for (multimap<string, BSONObj>::iterator it=range.first; it!=range.second; ++it) {
+            for (multimap<string, BSONObj>::const_iterator it=range.first; it!=range.second; ++it) {
                  indexesOutput << it->second;
             }
 
@@ -144,13 +243,38 @@ public:
 
         ofstream file (outputFile.string().c_str());
         uassert(15933, "Couldn't open file: " + outputFile.string(), file.is_open());
-        file << metadata.done().jsonString();
+        file << b.done().jsonString();
     }
 
+    void dumpCollection( const string name , const boost::filesystem::path outdir ,
+                         const DatabaseMetadata& metadata , DBClientBase& connBase ) {
+        const string filename = nsToCollectionSubstring( name ).toString();
+        writeCollectionFile( name , outdir / ( filename + ".bson" ) , connBase ,
+                             mongoDumpGlobalParams.compress );
+        writeMetadataFile( name, outdir / (filename + ".metadata.json"), metadata );
+    }
 
+    /** dumps a collection on a pool thread, with a connection of its own */
+    void dumpCollectionTask( const string name , const boost::filesystem::path outdir ,
+                             boost::shared_ptr<DatabaseMetadata> metadata ) {
+        try {
+            scoped_ptr<DBClientBase> connBase(newConnection(true));
+            dumpCollection( name , outdir , *metadata , *connBase );
+        }
+        catch (std::exception& e) {
+            noteError(str::stream() << "dumping " << name << ": " << e.what());
+        }
+    }
+
+    void noteError( const string& error ) {
+        toolError() << "ERROR " << error << std::endl;
+        scoped_lock lk(_errorMutex);
+        _errors++;
+    }
 
     void writeCollectionStdout( const string coll ) {
-        doCollection(coll, stdout, NULL);
+        OutputFile out(stdout, false, NULL);
+        doCollection(coll, &out, conn(true));
     }
 
     void go( const string db , const boost::filesystem::path outdir ) {
@@ -158,8 +282,7 @@ public:
 
         boost::filesystem::create_directories( outdir );
 
-        map <string, BSONObj> collectionOptions;
-        multimap <string, BSONObj> indexes;
+        boost::shared_ptr<DatabaseMetadata> metadata(new DatabaseMetadata());
         vector <string> collections;
 
         // Save indexes for database
@@ -168,7 +291,7 @@ public:
         while ( cursor->more() ) {
             BSONObj obj = cursor->nextSafe();
             const string name = obj.getField( "ns" ).valuestr();
-            indexes.insert( pair<string, BSONObj> (name, obj.getOwned()) );
+            metadata->indexes.insert( pair<string, BSONObj> (name, obj.getOwned()) );
         }
 
         string sns = db + ".system.namespaces";
@@ -177,7 +300,8 @@ public:
             BSONObj obj = cursor->nextSafe();
             const string name = obj.getField( "name" ).valuestr();
             if (obj.hasField("options")) {
-                collectionOptions[name] = obj.getField("options").embeddedObject().getOwned();
+                metadata->collectionOptions[name] =
+                    obj.getField("options").embeddedObject().getOwned();
             }
 
             // skip namespaces with $ in them only if we don't specify a collection to dump
@@ -208,7 +332,8 @@ public:
             if (nsToCollectionSubstring(name) == "system.indexes") {
               // Create system.indexes.bson for compatibility with pre 2.2 mongorestore
               const string filename = name.substr( db.size() + 1 );
-              writeCollectionFile( name.c_str() , outdir / ( filename + ".bson" ) );
+              writeCollectionFile( name.c_str() , outdir / ( filename + ".bson" ) , conn( true ) ,
+                                   false );
               // Don't dump indexes as *.metadata.json
               continue;
             }
@@ -217,10 +342,12 @@ public:
         }
         
         for (vector<string>::iterator it = collections.begin(); it != collections.end(); ++it) {
-            string name = *it;
-            const string filename = name.substr( db.size() + 1 );
-            writeCollectionFile( name , outdir / ( filename + ".bson" ) );
-            writeMetadataFile( name, outdir / (filename + ".metadata.json"), collectionOptions, indexes);
+            if (_pool) {
+                _pool->schedule(&Dump::dumpCollectionTask, this, *it, outdir, metadata);
+            }
+            else {
+                dumpCollection(*it, outdir, *metadata, conn(true));
+            }
         }
 
     }
@@ -329,7 +456,8 @@ public:
         m.setName("Repair Progress");
         m.setUnits("objects");
 
-        Writer w( f , &m );
+        OutputFile out( f , false , &m );
+        Writer w( &out );
 
         try {
             toolInfoLog() << "forward extent pass" << std::endl;
@@ -357,6 +485,7 @@ public:
             toolError() << "ERROR: backwards extent pass failed:" << e.toString() << std::endl;
         }
 
+        out.finish();
         toolInfoLog() << "\t\t " << m.done() << " objects" << std::endl;
     }
     
@@ -457,6 +586,18 @@ public:
 
         _usingMongos = isMongos();
 
+        // the ranges of a collection are read on connections of their own
+        _canSplitCollections = mongoDumpGlobalParams.numCursorsPerCollection > 1 &&
+                               !_usingMongos && !toolGlobalParams.useDirectClient;
+
+        _errors = 0;
+        if (mongoDumpGlobalParams.numParallelCollections > 1 &&
+            !toolGlobalParams.useDirectClient) {
+            // picks the member of a replica set the threads connect to
+            conn(true);
+            _pool.reset(new ThreadPool(mongoDumpGlobalParams.numParallelCollections));
+        }
+
         boost::filesystem::path root(mongoDumpGlobalParams.outputFile);
 
         if (toolGlobalParams.db == "") {
@@ -498,20 +639,37 @@ public:
             go(toolGlobalParams.db, root / toolGlobalParams.db);
         }
 
+        if (_pool) {
+            _pool->join();
+        }
+
         if (!opLogName.empty()) {
             BSONObjBuilder b;
             b.appendTimestamp("$gt", opLogStart);
 
             _query = BSON("ts" << b.obj());
 
-            writeCollectionFile( opLogName , root / "oplog.bson" );
+            writeCollectionFile( opLogName , root / "oplog.bson" , conn( true ) , false );
+        }
+
+        if (_errors) {
+            toolError() << _errors << " collections or parts of collections failed to dump"
+                        << std::endl;
+            return -1;
         }
 
         return 0;
     }
 
     bool _usingMongos;
+    bool _canSplitCollections;
     BSONObj _query;
+
+    // dumps the collections of every database when dumping several at once
+    scoped_ptr<ThreadPool> _pool;
+
+    mongo::mutex _errorMutex;
+    int _errors;
 };
 
 REGISTER_MONGO_TOOL(Dump);
@@ -18,21 +18,35 @@
 
 #include <boost/filesystem/convenience.hpp>
 #include <boost/filesystem/operations.hpp>
+#include <boost/thread/thread.hpp>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/db/json.h"
+#include "mongo/db/namespace_string.h"
 #include "mongo/tools/mongoexport_options.h"
 #include "mongo/tools/tool.h"
 #include "mongo/tools/tool_logger.h"
 #include "mongo/util/options_parser/option_section.h"
+#include "mongo/util/queue.h"
 
 using namespace mongo;
 
 class Export : public Tool {
+    static const int BLOCK_BYTES; // encoded output handed to the writer at once
+    static const int RANGE_BLOCKS; // blocks a range encodes ahead of its turn, when ordered
+
+    typedef boost::shared_ptr<string> BlockPtr;
+    typedef BlockingQueue<BlockPtr> BlockQueue;
+
+    AtomicInt64 _num;
+    mongo::mutex _errorMutex;
+    int _errors;
+
 public:
-    Export() : Tool() { }
+    Export() : Tool(), _errorMutex("exportErrors"), _errors(0) { }
 
     virtual void printHelp( ostream & out ) {
         printMongoExportHelp(&out);
@@ -105,6 +119,136 @@ public:
         return "";
     }
 
+    /** @return true if documents are separated by commas rather than newlines */
+    bool inArray() const {
+        return mongoExportGlobalParams.jsonArray && !mongoExportGlobalParams.csv;
+    }
+
+    /** Writes obj as a CSV row or JSON document, without the separator that follows it */
+    void formatDocument(ostream& out, const BSONObj& obj) {
+        if (mongoExportGlobalParams.csv) {
+            for (std::vector<std::string>::iterator i = toolGlobalParams.fields.begin();
+                 i != toolGlobalParams.fields.end(); i++) {
+                if (i != toolGlobalParams.fields.begin())
+                    out << ",";
+                const BSONElement & e = obj.getFieldDotted(i->c_str());
+                if ( ! e.eoo() ) {
+                    out << csvString(e);
+                }
+            }
+        }
+        else {
+            out << obj.jsonString();
+        }
+    }
+
+    void noteError(const string& error) {
+        toolError() << "ERROR " << error << std::endl;
+        scoped_lock lk(_errorMutex);
+        _errors++;
+    }
+
+    /**
+     * Exports ns over the cursors of a parallelCollectionScan, each encoded into blocks by a
+     * thread and connection of its own while this thread writes them out: a range at a time in
+     * the order of the cursors, or as they come with --unordered.
+     * @return false, having written nothing, if the server can't split ns (it is capped, or the
+     * server is too old).
+     */
+    bool exportRanges(const string& ns, ostream& out) {
+        DBClientBase& connBase = conn(mongoExportGlobalParams.slaveOk);
+        BSONObj res;
+        BSONObj cmd = BSON("parallelCollectionScan" << nsToCollectionSubstring(ns) <<
+                           "numCursors" << mongoExportGlobalParams.numCursors);
+        if (!connBase.runCommand(nsToDatabase(ns), cmd, res,
+                                 mongoExportGlobalParams.slaveOk ? QueryOption_SlaveOk : 0)) {
+            toolInfoLog() << "exporting " << ns << " with one cursor: " << res << endl;
+            return false;
+        }
+
+        vector<BSONElement> cursors = res["cursors"].Array();
+        const int numRanges = cursors.size();
+        vector<boost::shared_ptr<BlockQueue> > queues;
+        if (mongoExportGlobalParams.unordered) {
+            queues.push_back(boost::shared_ptr<BlockQueue>(new BlockQueue(numRanges * 4 + 1)));
+        }
+        else {
+            for (int i = 0; i < numRanges; i++) {
+                queues.push_back(boost::shared_ptr<BlockQueue>(new BlockQueue(RANGE_BLOCKS + 1)));
+            }
+        }
+
+        boost::thread_group threads;
+        for (int i = 0; i < numRanges; i++) {
+            long long cursorId = cursors[i].Obj()["cursor"]["id"].numberLong();
+            BlockQueue* blocks = queues[mongoExportGlobalParams.unordered ? 0 : i].get();
+            threads.create_thread(boost::bind(&Export::encodeRange, this, ns, cursorId, blocks));
+        }
+
+        bool first = true;
+        if (mongoExportGlobalParams.unordered) {
+            writeBlocks(out, queues[0].get(), numRanges, &first);
+        }
+        else {
+            for (int i = 0; i < numRanges; i++) {
+                writeBlocks(out, queues[i].get(), 1, &first);
+            }
+        }
+        threads.join_all();
+        return true;
+    }
+
+    // Always ends with an empty block, even after an error, so the writer isn't left waiting.
+    void encodeRange(const string ns, long long cursorId, BlockQueue* blocks) {
+        try {
+            scoped_ptr<DBClientBase> connBase(newConnection(mongoExportGlobalParams.slaveOk));
+            DBClientCursor cursor(connBase.get(), ns, cursorId, 0,
+                    (mongoExportGlobalParams.slaveOk ? QueryOption_SlaveOk : 0) |
+                    QueryOption_NoCursorTimeout);
+            cursor.setPrefetch(true, DBClientCursor::PrefetchAtHalfBatch, true);
+            stringstream ss;
+            long long numInBlock = 0;
+            while (cursor.more()) {
+                if (inArray() && numInBlock)
+                    ss << ',';
+                formatDocument(ss, cursor.next());
+                if (!inArray())
+                    ss << '\n';
+                numInBlock++;
+
+                if (ss.tellp() >= BLOCK_BYTES) {
+                    blocks->push(BlockPtr(new string(ss.str())));
+                    _num.fetchAndAdd(numInBlock);
+                    ss.str("");
+                    numInBlock = 0;
+                }
+            }
+            if (numInBlock) {
+                blocks->push(BlockPtr(new string(ss.str())));
+                _num.fetchAndAdd(numInBlock);
+            }
+        }
+        catch (std::exception& e) {
+            noteError(str::stream() << "exporting part of " << ns << ": " << e.what());
+        }
+        blocks->push(BlockPtr());
+    }
+
+    /** Writes the blocks of 'blocks' until 'numRanges' of them have ended */
+    void writeBlocks(ostream& out, BlockQueue* blocks, int numRanges, bool* first) {
+        while (numRanges) {
+            BlockPtr block = blocks->blockingPop();
+            if (!block) {
+                numRanges--;
+                continue;
+            }
+            if (inArray() && !*first)
+                out << ',';
+            out << *block;
+            *first = false;
+        }
+    }
+
     int run() {
         string ns;
         ostream *outPtr = &cout;
@@ -161,17 +305,15 @@ public:
             return -1;
         }
 
-        Query q(mongoExportGlobalParams.query);
-
-        if (mongoExportGlobalParams.snapShotQuery) {
-            q.snapshot();
+        bool parallel = mongoExportGlobalParams.numCursors > 1;
+        if (parallel && (!mongoExportGlobalParams.query.empty() ||
+                         mongoExportGlobalParams.skip || mongoExportGlobalParams.limit ||
+                         toolGlobalParams.useDirectClient)) {
+            toolInfoLog() << "exporting with one cursor: numCursors can't be used with a query, "
+                          << "skip, limit or dbpath" << endl;
+            parallel = false;
         }
 
-        auto_ptr<DBClientCursor> cursor = conn().query(ns.c_str(), q,
-                mongoExportGlobalParams.limit, mongoExportGlobalParams.skip, fieldsToReturn,
-                (mongoExportGlobalParams.slaveOk ? QueryOption_SlaveOk : 0) |
-                QueryOption_NoCursorTimeout);
-
         if (mongoExportGlobalParams.csv) {
             for (std::vector<std::string>::iterator i = toolGlobalParams.fields.begin();
                  i != toolGlobalParams.fields.end(); i++) {
@@ -185,40 +327,49 @@ public:
         if (mongoExportGlobalParams.jsonArray)
             out << '[';
 
-        long long num = 0;
-        while ( cursor->more() ) {
-            num++;
-            BSONObj obj = cursor->next();
-            if (mongoExportGlobalParams.csv) {
-                for (std::vector<std::string>::iterator i = toolGlobalParams.fields.begin();
-                     i != toolGlobalParams.fields.end(); i++) {
-                    if (i != toolGlobalParams.fields.begin())
-                        out << ",";
-                    const BSONElement & e = obj.getFieldDotted(i->c_str());
-                    if ( ! e.eoo() ) {
-                        out << csvString(e);
-                    }
-                }
-                out << endl;
+        _num.store(0);
+        if (!parallel || !exportRanges(ns, out)) {
+            Query q(mongoExportGlobalParams.query);
+
+            if (mongoExportGlobalParams.snapShotQuery) {
+                q.snapshot();
             }
-            else {
-                if (mongoExportGlobalParams.jsonArray && num != 1)
+
+            auto_ptr<DBClientCursor> cursor = conn().query(ns.c_str(), q,
+                    mongoExportGlobalParams.limit, mongoExportGlobalParams.skip, fieldsToReturn,
+                    (mongoExportGlobalParams.slaveOk ? QueryOption_SlaveOk : 0) |
+                    QueryOption_NoCursorTimeout);
+            cursor->setPrefetch(true, DBClientCursor::PrefetchAtHalfBatch, true);
+
+            long long num = 0;
+            while ( cursor->more() ) {
+                num++;
+                BSONObj obj = cursor->next();
+                if (inArray() && num != 1)
                     out << ',';
 
-                out << obj.jsonString();
+                formatDocument(out, obj);
 
-                if (!mongoExportGlobalParams.jsonArray)
+                if (!inArray())
                     out << endl;
             }
+            _num.store(num);
         }
 
         if (mongoExportGlobalParams.jsonArray)
             out << ']' << endl;
 
-        toolInfoOutput() << "exported " << num << " records" << endl;
+        toolInfoOutput() << "exported " << _num.load() << " records" << endl;
 
+        if (_errors) {
+            toolError() << _errors << " ranges failed to export" << std::endl;
+            return -1;
+        }
         return 0;
     }
 };
 
+const int Export::BLOCK_BYTES(1024 * 1024);
+const int Export::RANGE_BLOCKS(16);
+
 REGISTER_MONGO_TOOL(Export);
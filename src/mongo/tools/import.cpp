@@ -18,6 +18,8 @@
 
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem/operations.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/thread.hpp>
 #include <fstream>
 #include <iostream>
 
@@ -26,7 +28,9 @@
 #include "mongo/tools/mongoimport_options.h"
 #include "mongo/tools/tool.h"
 #include "mongo/util/options_parser/option_section.h"
+#include "mongo/util/queue.h"
 #include "mongo/util/text.h"
+#include "mongo/util/timer.h"
 
 using namespace mongo;
 using std::string;
@@ -39,6 +43,86 @@ class Import : public Tool {
 
     const char * _sep;
     static const int BUF_SIZE;
+    static const int ROW_CHUNK_BYTES; // rows handed to a parsing worker at once
+    static const int INSERT_BATCH_BYTES;
+
+    struct RowChunk {
+        RowChunk(long long seq) : seq(seq) {}
+        long long seq;
+        vector<string> rows;
+    };
+    typedef boost::shared_ptr<RowChunk> RowChunkPtr;
+
+    struct DocChunk {
+        DocChunk(long long seq) : seq(seq) {}
+        long long seq;
+        vector<BSONObj> docs;
+    };
+    typedef boost::shared_ptr<DocChunk> DocChunkPtr;
+
+    /**
+     * Hands parsed chunks from the parsing workers to the insertion workers, in the order they
+     * were read if 'ordered'.  Holds up to 'window' chunks, which when ordered means the chunks
+     * up to 'window' past the next to insert, so the worker parsing that one never waits.
+     */
+    class DocChunkQueue : boost::noncopyable {
+    public:
+        DocChunkQueue(bool ordered, size_t window) :
+            _mutex("importDocChunks"),
+            _ordered(ordered),
+            _window(window),
+            _next(0),
+            _done(false) {}
+
+        void push(const DocChunkPtr& chunk) {
+            scoped_lock lk(_mutex);
+            while (_ordered ? (chunk->seq >= _next + static_cast<long long>(_window))
+                            : (_chunks.size() >= _window)) {
+                _changed.wait(lk.boost());
+            }
+            _chunks[chunk->seq] = chunk;
+            _changed.notify_all();
+        }
+
+        /** @return an empty pointer once done() was called and every chunk has been taken */
+        DocChunkPtr pop() {
+            scoped_lock lk(_mutex);
+            while (true) {
+                if (!_chunks.empty() && (!_ordered || _chunks.begin()->first == _next)) {
+                    DocChunkPtr chunk = _chunks.begin()->second;
+                    _chunks.erase(_chunks.begin());
+                    _next = chunk->seq + 1;
+                    _changed.notify_all();
+                    return chunk;
+                }
+                if (_done && _chunks.empty()) {
+                    return DocChunkPtr();
+                }
+                _changed.wait(lk.boost());
+            }
+        }
+
+        /** Called once every chunk has been pushed */
+        void done() {
+            scoped_lock lk(_mutex);
+            _done = true;
+            _changed.notify_all();
+        }
+
+    private:
+        mongo::mutex _mutex;
+        boost::condition _changed;
+        const bool _ordered;
+        const size_t _window;
+        long long _next;
+        bool _done;
+        std::map<long long, DocChunkPtr> _chunks;
+    };
+
+    AtomicInt64 _errors;
+    AtomicInt64 _lastErrorFailures;
+    AtomicInt64 _numParsed;
+    AtomicUInt32 _stop; // set to stop reading, with --stopOnError
 
     void csvTokenizeRow(const string& row, vector<string>& tokens) {
         bool inQuotes = false;
@@ -171,21 +255,21 @@ class Import : public Tool {
     }
 
     /*
-     * Parses one object from the input file.  This usually corresponds to one line in the input
-     * file, unless the file is a CSV and contains a newline within a quoted string entry.
-     * Returns a true if a BSONObj was successfully created and false if not.
+     * Reads one row from the input file into row.  This usually corresponds to one line in the
+     * input file, unless the file is a CSV and contains a newline within a quoted string entry.
+     * 'buf' is scratch space of BUF_SIZE+2 bytes.
+     * Returns false if the line was empty.
      */
-    bool parseRow(istream* in, BSONObj& o, int& numBytesRead) {
-        boost::scoped_array<char> buffer(new char[BUF_SIZE+2]);
-        char* line = buffer.get();
+    bool readRow(istream* in, char* buf, string* row, int* numBytesRead) {
+        char* line = buf;
 
-        numBytesRead = getLine(in, line);
-        line += numBytesRead;
+        *numBytesRead = getLine(in, line);
+        line += *numBytesRead;
 
         if (line[0] == '\0') {
             return false;
         }
-        numBytesRead += strlen( line );
+        *numBytesRead += strlen( line );
 
         if (_type == JSON) {
             // Strip out trailing whitespace
@@ -194,17 +278,11 @@ class Import : public Tool {
                 *end = 0;
                 end--;
             }
-            try {
-                o = fromjson( line );
-            } catch ( MsgAssertionException& e ) {
-                uasserted(13504, string("BSON representation of supplied JSON is too large: ") + e.what());
-            }
+            row->assign(line);
             return true;
         }
 
-        vector<string> tokens;
         if (_type == CSV) {
-            string row;
             bool inside_quotes = false;
             size_t last_quote = 0;
             while (true) {
@@ -216,57 +294,85 @@ class Import : public Tool {
                     last_quote = lineStr.find_first_of('"', last_quote+1);
                 }
 
-                row.append(lineStr);
+                row->append(lineStr);
 
                 if (inside_quotes) {
-                    row.append("\n");
+                    row->append("\n");
+                    line = buf;
                     int num = getLine(in, line);
                     line += num;
-                    numBytesRead += num;
+                    *numBytesRead += num;
 
                     uassert(15854, "CSV file ends while inside quoted field", line[0] != '\0');
-                    numBytesRead += strlen( line );
+                    *numBytesRead += strlen( line );
                 } else {
                     break;
                 }
             }
             // now 'row' is string corresponding to one row of the CSV file
             // (which may span multiple lines) and represents one BSONObj
-            csvTokenizeRow(row, tokens);
         }
         else {  // _type == TSV
             while (line[0] != '\t' && isspace(line[0])) { // Strip leading whitespace, but not tabs
                 line++;
             }
+            row->assign(line);
+        }
+        return true;
+    }
+
+    void tokenizeRow(const string& row, vector<string>* tokens) {
+        if (_type == CSV) {
+            csvTokenizeRow(row, *tokens);
+        }
+        else {
+            boost::split(*tokens, row, boost::is_any_of(_sep));
+        }
+    }
+
+    /** Takes the field names from a CSV or TSV header row */
+    void parseHeader(const string& row) {
+        vector<string> tokens;
+        tokenizeRow(row, &tokens);
+        toolGlobalParams.fields.insert(toolGlobalParams.fields.end(), tokens.begin(), tokens.end());
+    }
 
-            boost::split(tokens, line, boost::is_any_of(_sep));
+    /*
+     * Parses one object from a row read by readRow().  Only reads shared state, so the parsing
+     * workers call it at once.
+     * throws:
+     *     exception on parsing error
+     */
+    BSONObj parseRow(const string& row) {
+        if (_type == JSON) {
+            try {
+                return fromjson( row );
+            } catch ( MsgAssertionException& e ) {
+                uasserted(13504, string("BSON representation of supplied JSON is too large: ") + e.what());
+            }
         }
 
+        vector<string> tokens;
+        tokenizeRow(row, &tokens);
+
         // Now that the row is tokenized, create a BSONObj out of it.
         BSONObjBuilder b;
         unsigned int pos=0;
         for (vector<string>::iterator it = tokens.begin(); it != tokens.end(); ++it) {
-            string token = *it;
-            if (mongoImportGlobalParams.headerLine) {
-                toolGlobalParams.fields.push_back(token);
+            string name;
+            if (pos < toolGlobalParams.fields.size()) {
+                name = toolGlobalParams.fields[pos];
             }
             else {
-                string name;
-                if (pos < toolGlobalParams.fields.size()) {
-                    name = toolGlobalParams.fields[pos];
-                }
-                else {
-                    stringstream ss;
-                    ss << "field" << pos;
-                    name = ss.str();
-                }
-                pos++;
-
-                _append( b , name , token );
+                stringstream ss;
+                ss << "field" << pos;
+                name = ss.str();
             }
+            pos++;
+
+            _append( b , name , *it );
         }
-        o = b.obj();
-        return true;
+        return b.obj();
     }
 
 public:
@@ -278,11 +384,9 @@ public:
         printMongoImportHelp(&out);
     }
 
-    unsigned long long lastErrorFailures;
-
     /** @return true if ok */
-    bool checkLastError() { 
-        string s = conn().getLastError();
+    bool checkLastError(DBClientBase& c) {
+        string s = c.getLastError();
         if( !s.empty() ) { 
             if( str::contains(s,"uplicate") ) {
                 // we don't want to return an error from the mongoimport process for
@@ -290,7 +394,7 @@ public:
                 toolInfoLog() << s << endl;
             }
             else {
-                lastErrorFailures++;
+                _lastErrorFailures.fetchAndAdd(1);
                 toolInfoLog() << "error: " << s << endl;
                 return false;
             }
@@ -298,7 +402,7 @@ public:
         return true;
     }
 
-    void importDocument (const std::string &ns, const BSONObj& o) {
+    void importDocument (DBClientBase& c, const std::string &ns, const BSONObj& o) {
         bool doUpsert = mongoImportGlobalParams.upsert;
         BSONObjBuilder b;
         if (mongoImportGlobalParams.upsert) {
@@ -314,16 +418,217 @@ public:
         }
 
         if (doUpsert) {
-            conn().update(ns, Query(b.obj()), o, true);
+            c.update(ns, Query(b.obj()), o, true);
         }
         else {
-            conn().insert(ns.c_str(), o);
+            c.insert(ns.c_str(), o);
+        }
+    }
+
+    void noteError(const string& error) {
+        toolError() << "exception:" << error << std::endl;
+        _errors.fetchAndAdd(1);
+        if (mongoImportGlobalParams.stopOnError) {
+            _stop.store(1);
+        }
+    }
+
+    DocChunkPtr parseChunk(const RowChunk& rows) {
+        DocChunkPtr docs(new DocChunk(rows.seq));
+        docs->docs.reserve(rows.rows.size());
+        for (vector<string>::const_iterator it = rows.rows.begin(); it != rows.rows.end(); ++it) {
+            if (_stop.load()) {
+                break;
+            }
+            try {
+                docs->docs.push_back(parseRow(*it));
+                _numParsed.fetchAndAdd(1);
+            }
+            catch (const std::exception& e) {
+                noteError(e.what());
+            }
+        }
+        return docs;
+    }
+
+    /**
+     * Inserts the documents of 'chunk' in batches of up to INSERT_BATCH_BYTES, or upserts them
+     * one at a time, checking for errors after each batch.
+     */
+    void insertChunk(DBClientBase& c, const string& ns, const DocChunk& chunk) {
+        if (!mongoImportGlobalParams.doimport || chunk.docs.empty()) {
+            return;
+        }
+
+        if (mongoImportGlobalParams.upsert) {
+            for (vector<BSONObj>::const_iterator it = chunk.docs.begin(); it != chunk.docs.end();
+                 ++it) {
+                importDocument(c, ns, *it);
+            }
+            if (!checkLastError(c) && mongoImportGlobalParams.stopOnError) {
+                _stop.store(1);
+            }
+            return;
+        }
+
+        const int flags = mongoImportGlobalParams.stopOnError ? 0 : InsertOption_ContinueOnError;
+        vector<BSONObj>::const_iterator begin = chunk.docs.begin();
+        while (begin != chunk.docs.end()) {
+            vector<BSONObj>::const_iterator end = begin;
+            int batchBytes = 0;
+            while (end != chunk.docs.end() &&
+                   (end == begin || batchBytes + end->objsize() <= INSERT_BATCH_BYTES)) {
+                batchBytes += end->objsize();
+                ++end;
+            }
+            c.insert(ns, vector<BSONObj>(begin, end), flags);
+            if (!checkLastError(c) && mongoImportGlobalParams.stopOnError) {
+                _stop.store(1);
+                return;
+            }
+            begin = end;
+        }
+    }
+
+    void parseChunks(BlockingQueue<RowChunkPtr>* rowChunks, DocChunkQueue* docChunks) {
+        while (true) {
+            RowChunkPtr rows = rowChunks->blockingPop();
+            if (!rows) {
+                break;
+            }
+            // pushed even when empty so an ordered queue isn't left waiting for its sequence
+            docChunks->push(parseChunk(*rows));
+        }
+    }
+
+    // Keeps taking chunks after an error so the parsing workers are never left waiting.
+    void insertChunks(DocChunkQueue* docChunks, const string ns) {
+        scoped_ptr<DBClientBase> c;
+        try {
+            c.reset(newConnection());
+        }
+        catch (const std::exception& e) {
+            noteError(str::stream() << "connecting to insert into " << ns << ": " << e.what());
+        }
+
+        while (DocChunkPtr docs = docChunks->pop()) {
+            if (!c || _stop.load()) {
+                continue;
+            }
+            try {
+                insertChunk(*c, ns, *docs);
+            }
+            catch (const std::exception& e) {
+                noteError(e.what());
+            }
+        }
+    }
+
+    /**
+     * Reads 'in' a chunk of rows at a time for the parsing workers, whose documents the
+     * insertion workers send in batches over connections of their own.  A direct client can't
+     * be shared with other threads, so with one each chunk is parsed and inserted as it's read.
+     * @return the number of bytes read
+     */
+    long long importRows(istream* in, const string& ns, ProgressMeter& pm, Timer& timer) {
+        const bool threaded = !toolGlobalParams.useDirectClient;
+        const int numParsers = mongoImportGlobalParams.numParsingWorkers;
+        int numInserters = mongoImportGlobalParams.numInsertionWorkers;
+        if (mongoImportGlobalParams.maintainInsertionOrder && numInserters > 1) {
+            toolInfoLog() << "inserting over one connection to maintain insertion order" << endl;
+            numInserters = 1;
+        }
+
+        BlockingQueue<RowChunkPtr> rowChunks(numParsers * 2 + 1);
+        DocChunkQueue docChunks(mongoImportGlobalParams.maintainInsertionOrder,
+                                numParsers * 2 + numInserters);
+        boost::thread_group parsers;
+        boost::thread_group inserters;
+        if (threaded) {
+            for (int i = 0; i < numParsers; i++) {
+                parsers.create_thread(boost::bind(&Import::parseChunks, this, &rowChunks,
+                                                  &docChunks));
+            }
+            for (int i = 0; i < numInserters; i++) {
+                inserters.create_thread(boost::bind(&Import::insertChunks, this, &docChunks,
+                                                    ns));
+            }
+        }
+
+        boost::scoped_array<char> buffer(new char[BUF_SIZE+2]);
+        long long bytesRead = 0;
+        long long numRows = 0;
+        long long seq = 0;
+        RowChunkPtr chunk(new RowChunk(seq++));
+        int chunkBytes = 0;
+        while (in->rdstate() == 0 && !_stop.load()) {
+            int len = 0;
+            try {
+                string row;
+                if (!readRow(in, buffer.get(), &row, &len)) {
+                    continue;
+                }
+
+                if (mongoImportGlobalParams.headerLine) {
+                    parseHeader(row);
+                    mongoImportGlobalParams.headerLine = false;
+                }
+                else {
+                    chunkBytes += row.size();
+                    chunk->rows.push_back(row);
+                    numRows++;
+                }
+            }
+            catch ( const std::exception& e ) {
+                noteError(e.what());
+            }
+            bytesRead += len + 1;
+
+            if (chunkBytes >= ROW_CHUNK_BYTES) {
+                dispatchChunk(chunk, threaded ? &rowChunks : NULL, ns);
+                chunk.reset(new RowChunk(seq++));
+                chunkBytes = 0;
+            }
+
+            if (!toolGlobalParams.quiet) {
+                if (pm.hit(len + 1)) {
+                    log() << "\t\t\t" << numRows << "\t"
+                          << (numRows * 1000 / (timer.millis() + 1)) << "/second" << std::endl;
+                }
+            }
+        }
+        if (!chunk->rows.empty()) {
+            dispatchChunk(chunk, threaded ? &rowChunks : NULL, ns);
+        }
+
+        if (threaded) {
+            for (int i = 0; i < numParsers; i++) {
+                rowChunks.push(RowChunkPtr());
+            }
+            parsers.join_all();
+            docChunks.done();
+            inserters.join_all();
+        }
+        return bytesRead;
+    }
+
+    /** Queues 'chunk' for the parsing workers, or with no queue parses and inserts it here */
+    void dispatchChunk(const RowChunkPtr& chunk, BlockingQueue<RowChunkPtr>* rowChunks,
+                       const string& ns) {
+        if (rowChunks) {
+            rowChunks->push(chunk);
+            return;
+        }
+        try {
+            insertChunk(conn(), ns, *parseChunk(*chunk));
+        }
+        catch (const std::exception& e) {
+            noteError(e.what());
         }
     }
 
     int run() {
         long long fileSize = 0;
-        int headerRows = 0;
 
         istream * in = &cin;
 
@@ -395,10 +700,7 @@ public:
         }
 
         if (_type == CSV || _type == TSV) {
-            if (mongoImportGlobalParams.headerLine) {
-                headerRows = 1;
-            }
-            else {
+            if (!mongoImportGlobalParams.headerLine) {
                 if (!toolGlobalParams.fieldsSpecified) {
                     throw UserException(9998, "You need to specify fields or have a headerline to "
                                               "import this file type");
@@ -407,15 +709,18 @@ public:
         }
 
 
-        time_t start = time(0);
+        Timer timer;
         if (logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(1))) {
             toolInfoLog() << "filesize: " << fileSize << endl;
         }
         ProgressMeter pm( fileSize );
-        int num = 0;
-        int lastNumChecked = num;
-        int errors = 0;
-        lastErrorFailures = 0;
+        long long num = 0;
+        long long lastNumChecked = num;
+        long long bytesRead = 0;
+        _errors.store(0);
+        _lastErrorFailures.store(0);
+        _numParsed.store(0);
+        _stop.store(0);
         int len = 0;
 
         // We have to handle jsonArrays differently since we can't read line by line
@@ -453,12 +758,12 @@ public:
 
                     // Import documents
                     if (mongoImportGlobalParams.doimport) {
-                        importDocument(ns, o);
+                        importDocument(conn(), ns, o);
 
                         if (num < 10) {
                             // we absolutely want to check the first and last op of the batch. we do
                             // a few more as that won't be too time expensive.
-                            checkLastError();
+                            checkLastError(conn());
                             lastNumChecked = num;
                         }
                     }
@@ -487,11 +792,12 @@ public:
                     next_buffer = temp_buffer;
 
                     num++;
+                    bytesRead += len;
                 }
                 catch ( const std::exception& e ) {
                     toolError() << "exception: " << e.what()
                               << ", current buffer: " << current_buffer << std::endl;
-                    errors++;
+                    _errors.fetchAndAdd(1);
 
                     // Since we only support JSON arrays all on one line, we might as well stop now
                     // because we can't read any more documents
@@ -500,67 +806,37 @@ public:
 
                 if (!toolGlobalParams.quiet) {
                     if (pm.hit(len + 1)) {
-                        log() << "\t\t\t" << num << "\t" << (num / (time(0) - start)) << "/second"
-                              << std::endl;
+                        log() << "\t\t\t" << num << "\t"
+                              << (num * 1000 / (timer.millis() + 1)) << "/second" << std::endl;
                     }
                 }
             }
-        }
-        else {
-            while (in->rdstate() == 0) {
-                try {
-                    BSONObj o;
-
-                    if (!parseRow(in, o, len)) {
-                        continue;
-                    }
-
-                    if (mongoImportGlobalParams.headerLine) {
-                        mongoImportGlobalParams.headerLine = false;
-                    }
-                    else if (mongoImportGlobalParams.doimport) {
-                        importDocument(ns, o);
-
-                        if (num < 10) {
-                            // we absolutely want to check the first and last op of the batch. we do
-                            // a few more as that won't be too time expensive.
-                            checkLastError();
-                            lastNumChecked = num;
-                        }
-                    }
 
-                    num++;
-                }
-                catch ( const std::exception& e ) {
-                    toolError() << "exception:" << e.what() << std::endl;
-                    errors++;
-
-                    if (mongoImportGlobalParams.stopOnError)
-                        break;
-                }
-
-                if (!toolGlobalParams.quiet) {
-                    if (pm.hit(len + 1)) {
-                        log() << "\t\t\t" << num << "\t" << (num / (time(0) - start)) << "/second"
-                              << std::endl;
-                    }
-                }
+            // this is for two reasons: to wait for all operations to reach the server and be
+            // processed, and secondly to check if there were an error (on the last op)
+            if( lastNumChecked+1 != num ) { // avoid redundant log message if already reported above
+                toolInfoLog() << "check " << lastNumChecked << " " << num << endl;
+                checkLastError(conn());
             }
         }
-
-        // this is for two reasons: to wait for all operations to reach the server and be processed, and this will wait until all data reaches the server,
-        // and secondly to check if there were an error (on the last op)
-        if( lastNumChecked+1 != num ) { // avoid redundant log message if already reported above
-            toolInfoLog() << "check " << lastNumChecked << " " << num << endl;
-            checkLastError();
+        else {
+            // every batch is checked as it's inserted
+            bytesRead = importRows(in, ns, pm, timer);
+            num = _numParsed.load();
         }
 
+        long long lastErrorFailures = _lastErrorFailures.load();
+        long long errors = _errors.load();
         bool hadErrors = lastErrorFailures || errors;
 
         // the message is vague on lastErrorFailures as we don't call it on every single operation. 
         // so if we have a lastErrorFailure there might be more than just what has been counted.
         toolInfoLog() << (lastErrorFailures ? "tried to import " : "imported ")
-                      << (num - headerRows) << " objects" << std::endl;
+                      << num << " objects" << std::endl;
+
+        double secs = (timer.millis() + 1) / 1000.0;
+        toolInfoLog() << "\t" << static_cast<long long>(num / secs) << " objects/second, "
+                      << (bytesRead / secs / (1024 * 1024)) << " MB/second" << std::endl;
 
         if ( !hadErrors )
             return 0;
@@ -573,5 +849,7 @@ public:
 };
 
 const int Import::BUF_SIZE(1024 * 1024 * 16);
+const int Import::ROW_CHUNK_BYTES(1024 * 1024 * 4);
+const int Import::INSERT_BATCH_BYTES(1024 * 1024 * 8);
 
 REGISTER_MONGO_TOOL(Import);
@@ -60,6 +60,18 @@ namespace mongo {
         options->addOptionChaining("forceTableScan", "forceTableScan", moe::Switch,
                 "force a table scan (do not use $snapshot)");
 
+        options->addOptionChaining("numParallelCollections", "numParallelCollections,j", moe::Int,
+                "number of collections to dump at once")
+                                  .setDefault(moe::Value(4));
+
+        options->addOptionChaining("numCursorsPerCollection", "numCursorsPerCollection",
+                moe::Int, "number of ranges of each collection to read at once; implies "
+                "--forceTableScan")
+                                  .setDefault(moe::Value(1));
+
+        options->addOptionChaining("compress", "compress", moe::Switch,
+                "snappy compress the collections, to <collection>.bson.snappy files");
+
 
         return Status::OK();
     }
@@ -104,8 +116,19 @@ namespace mongo {
             }
         }
         mongoDumpGlobalParams.outputFile = getParam("out");
+        mongoDumpGlobalParams.numParallelCollections = getParam("numParallelCollections", 4);
+        mongoDumpGlobalParams.numCursorsPerCollection = getParam("numCursorsPerCollection", 1);
+        mongoDumpGlobalParams.compress = hasParam("compress");
+        if (mongoDumpGlobalParams.numParallelCollections < 1 ||
+            mongoDumpGlobalParams.numCursorsPerCollection < 1) {
+            return Status(ErrorCodes::BadValue,
+                          "numParallelCollections and numCursorsPerCollection must be positive");
+        }
+
+        // a parallel scan can't take $snapshot
         mongoDumpGlobalParams.snapShotQuery = false;
-        if (!hasParam("query") && !hasParam("dbpath") && !hasParam("forceTableScan")) {
+        if (!hasParam("query") && !hasParam("dbpath") && !hasParam("forceTableScan") &&
+            mongoDumpGlobalParams.numCursorsPerCollection == 1) {
             mongoDumpGlobalParams.snapShotQuery = true;
         }
 
@@ -31,6 +31,9 @@ namespace mongo {
         bool useOplog;
         bool repair;
         bool snapShotQuery;
+        int numParallelCollections;
+        int numCursorsPerCollection;
+        bool compress;  // to .bson.snappy files
     };
 
     extern MongoDumpGlobalParams mongoDumpGlobalParams;
@@ -74,6 +74,15 @@ namespace mongo {
                 "limit the numbers of documents returned, default all")
                                   .setDefault(moe::Value(0));
 
+        options->addOptionChaining("numCursors", "numCursors", moe::Int,
+                "number of cursors reading and encoding the collection at once; "
+                "only without a query, skip or limit")
+                                  .setDefault(moe::Value(1));
+
+        options->addOptionChaining("unordered", "unordered", moe::Switch,
+                "with numCursors, write each cursor's documents as they are encoded rather "
+                "than a cursor at a time");
+
 
         return Status::OK();
     }
@@ -116,6 +125,11 @@ namespace mongo {
         mongoExportGlobalParams.slaveOk = params["slaveOk"].as<bool>();
         mongoExportGlobalParams.limit = getParam("limit", 0);
         mongoExportGlobalParams.skip = getParam("skip", 0);
+        mongoExportGlobalParams.numCursors = getParam("numCursors", 1);
+        mongoExportGlobalParams.unordered = hasParam("unordered");
+        if (mongoExportGlobalParams.numCursors < 1) {
+            return Status(ErrorCodes::BadValue, "numCursors must be positive");
+        }
 
         // we write output to standard error by default to avoid mangling output, but we don't need
         // to do this if an output file was specified
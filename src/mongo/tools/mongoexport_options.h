@@ -35,6 +35,8 @@ namespace mongo {
         bool snapShotQuery;
         unsigned int skip;
         unsigned int limit;
+        int numCursors;
+        bool unordered;
     };
 
     extern MongoExportGlobalParams mongoExportGlobalParams;
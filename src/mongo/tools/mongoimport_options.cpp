@@ -79,6 +79,17 @@ namespace mongo {
                 "load a json array, not one item per line. Currently limited to 16MB.");
 
 
+        options->addOptionChaining("numParsingWorkers", "numParsingWorkers", moe::Int,
+                "number of threads parsing the input")
+                                  .setDefault(moe::Value(4));
+
+        options->addOptionChaining("numInsertionWorkers", "numInsertionWorkers", moe::Int,
+                "number of connections inserting the parsed documents")
+                                  .setDefault(moe::Value(1));
+
+        options->addOptionChaining("maintainInsertionOrder", "maintainInsertionOrder",
+                moe::Switch, "insert the documents in the order of the input, over one connection");
+
         options->addOptionChaining("noimport", "noimport", moe::Switch,
                 "don't actually import. useful for benchmarking parser")
                                   .hidden();
@@ -140,6 +151,14 @@ namespace mongo {
         mongoImportGlobalParams.jsonArray = hasParam("jsonArray");
         mongoImportGlobalParams.headerLine = hasParam("headerline");
         mongoImportGlobalParams.stopOnError = hasParam("stopOnError");
+        mongoImportGlobalParams.numParsingWorkers = getParam("numParsingWorkers", 4);
+        mongoImportGlobalParams.numInsertionWorkers = getParam("numInsertionWorkers", 1);
+        mongoImportGlobalParams.maintainInsertionOrder = hasParam("maintainInsertionOrder");
+        if (mongoImportGlobalParams.numParsingWorkers < 1 ||
+            mongoImportGlobalParams.numInsertionWorkers < 1) {
+            return Status(ErrorCodes::BadValue,
+                          "numParsingWorkers and numInsertionWorkers must be positive");
+        }
 
         return Status::OK();
     }
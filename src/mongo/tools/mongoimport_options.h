@@ -36,6 +36,9 @@ namespace mongo {
         bool stopOnError;
         bool jsonArray;
         bool doimport;
+        int numParsingWorkers;
+        int numInsertionWorkers;
+        bool maintainInsertionOrder;
     };
 
     extern MongoImportGlobalParams mongoImportGlobalParams;
@@ -53,6 +53,13 @@ namespace mongo {
         options->addOptionChaining("oplogns", "oplogns", moe::String, "ns to pull from")
                                   .setDefault(moe::Value(std::string("local.oplog.rs")));
 
+        options->addOptionChaining("numWriters", "numWriters", moe::Int,
+                "number of connections applying each batch of ops")
+                                  .setDefault(moe::Value(1));
+
+        options->addOptionChaining("checkpointFile", "checkpointFile", moe::String,
+                "file recording the last op applied, to resume from when it exists");
+
 
         return Status::OK();
     }
@@ -87,6 +94,11 @@ namespace mongo {
 
         mongoOplogGlobalParams.seconds = getParam("seconds", 86400);
         mongoOplogGlobalParams.ns = getParam("oplogns");
+        mongoOplogGlobalParams.numWriters = getParam("numWriters", 1);
+        mongoOplogGlobalParams.checkpointFile = getParam("checkpointFile");
+        if (mongoOplogGlobalParams.numWriters < 1) {
+            return Status(ErrorCodes::BadValue, "numWriters must be positive");
+        }
 
         return Status::OK();
     }
@@ -29,6 +29,8 @@ namespace mongo {
         int seconds;
         std::string from;
         std::string ns;
+        int numWriters;
+        std::string checkpointFile;
     };
 
     extern MongoOplogGlobalParams mongoOplogGlobalParams;
@@ -72,6 +72,15 @@ namespace mongo {
         options->addOptionChaining("w", "w", moe::Int, "minimum number of replicas per write")
                                   .setDefault(moe::Value(0));
 
+        options->addOptionChaining("numParallelCollections", "numParallelCollections,j", moe::Int,
+                "number of collections to restore at once")
+                                  .setDefault(moe::Value(4));
+
+        options->addOptionChaining("numInsertionWorkersPerCollection",
+                "numInsertionWorkersPerCollection", moe::Int,
+                "number of connections inserting the batches of each collection")
+                                  .setDefault(moe::Value(1));
+
         options->addOptionChaining("dir", "dir", moe::String, "directory to restore from")
                                   .hidden()
                                   .setDefault(moe::Value(std::string("dump")))
@@ -123,6 +132,14 @@ namespace mongo {
         mongoRestoreGlobalParams.w = getParam( "w" , 0 );
         mongoRestoreGlobalParams.oplogReplay = hasParam("oplogReplay");
         mongoRestoreGlobalParams.oplogLimit = getParam("oplogLimit", "");
+        mongoRestoreGlobalParams.numParallelCollections = getParam("numParallelCollections", 4);
+        mongoRestoreGlobalParams.numInsertionWorkers =
+            getParam("numInsertionWorkersPerCollection", 1);
+        if (mongoRestoreGlobalParams.numParallelCollections < 1 ||
+            mongoRestoreGlobalParams.numInsertionWorkers < 1) {
+            return Status(ErrorCodes::BadValue, "numParallelCollections and "
+                          "numInsertionWorkersPerCollection must be positive");
+        }
 
         // Make the default db "" if it was not explicitly set
         if (!params.count("db")) {
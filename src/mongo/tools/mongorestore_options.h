@@ -33,6 +33,8 @@ namespace mongo {
         bool restoreOptions;
         bool restoreIndexes;
         int w;
+        int numParallelCollections;
+        int numInsertionWorkers;  // per collection
         std::string restoreDirectory;
     };
 
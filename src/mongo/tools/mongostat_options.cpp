@@ -49,6 +49,10 @@ namespace mongo {
 
         options->addOptionChaining("all", "all", moe::Switch, "all optional fields");
 
+        options->addOptionChaining("intervalMillis", "intervalMillis", moe::Int,
+                "milliseconds between samples instead of the sleep time; the server sends only "
+                "what changed, for sampling many times a second");
+
         options->addOptionChaining("sleep", "sleep", moe::Int, "seconds to sleep between samples")
                                   .hidden()
                                   .setSources(moe::SourceCommandLine)
@@ -127,6 +131,7 @@ namespace mongo {
         mongoStatGlobalParams.showHeaders = !hasParam("noheaders");
         mongoStatGlobalParams.rowCount = getParam("rowcount", 0);
         mongoStatGlobalParams.sleep = getParam("sleep", 1);
+        mongoStatGlobalParams.intervalMillis = getParam("intervalMillis", 0);
         mongoStatGlobalParams.allFields = hasParam("all");
 
         // Make the default db "admin" if it was not explicitly set
@@ -141,6 +146,16 @@ namespace mongo {
                           "Error parsing command line: --sleep must be greater than 0");
         }
 
+        if (mongoStatGlobalParams.intervalMillis < 0) {
+            return Status(ErrorCodes::BadValue,
+                          "Error parsing command line: --intervalMillis can't be negative");
+        }
+
+        if (mongoStatGlobalParams.intervalMillis && mongoStatGlobalParams.many) {
+            return Status(ErrorCodes::BadValue,
+                          "Error parsing command line: --intervalMillis only works with one host");
+        }
+
         if (mongoStatGlobalParams.rowCount < 0) {
             return Status(ErrorCodes::BadValue,
                           "Error parsing command line: --rowcount (-n) can't be negative");
@@ -33,6 +33,7 @@ namespace mongo {
         bool many;
         bool allFields;
         int sleep;
+        int intervalMillis;  // 0 to sleep 'sleep' seconds and fetch whole serverStatus documents
         std::string url;
     };
 
@@ -37,6 +37,10 @@ namespace mongo {
         options->addOptionChaining("locks", "locks", moe::Switch,
                 "use db lock info instead of top");
 
+        options->addOptionChaining("intervalMillis", "intervalMillis", moe::Int,
+                "milliseconds between samples instead of the sleep time; the server sends only "
+                "what changed, for sampling many times a second");
+
         options->addOptionChaining("sleep", "sleep", moe::Int, "seconds to sleep between samples")
                                   .hidden()
                                   .setSources(moe::SourceCommandLine)
@@ -69,12 +73,18 @@ namespace mongo {
 
         mongoTopGlobalParams.sleep = getParam("sleep", 1);
         mongoTopGlobalParams.useLocks = hasParam("locks");
+        mongoTopGlobalParams.intervalMillis = getParam("intervalMillis", 0);
 
         // Make the default db "admin" if it was not explicitly set
         if (!params.count("db")) {
             toolGlobalParams.db = "admin";
         }
 
+        if (mongoTopGlobalParams.intervalMillis < 0) {
+            return Status(ErrorCodes::BadValue,
+                          "Error parsing command line: --intervalMillis can't be negative");
+        }
+
         return Status::OK();
     }
 
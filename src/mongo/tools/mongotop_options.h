@@ -28,6 +28,7 @@ namespace mongo {
     struct MongoTopGlobalParams {
         bool useLocks;
         int sleep;
+        int intervalMillis;  // 0 to sleep 'sleep' seconds and fetch whole documents
     };
 
     extern MongoTopGlobalParams mongoTopGlobalParams;
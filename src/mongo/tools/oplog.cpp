@@ -16,10 +16,16 @@
 
 #include "mongo/pch.h"
 
+#include <boost/filesystem/operations.hpp>
+#include <boost/thread/thread.hpp>
 #include <fstream>
 #include <iostream>
 
+#include "third_party/murmurhash3/MurmurHash3.h"
+
+#include "mongo/db/hasher.h"
 #include "mongo/db/json.h"
+#include "mongo/db/namespace_string.h"
 #include "mongo/db/repl/oplogreader.h"
 #include "mongo/tools/mongooplog_options.h"
 #include "mongo/tools/tool.h"
@@ -28,6 +34,18 @@
 using namespace mongo;
 
 class OplogTool : public Tool {
+    static const size_t MAX_BATCH_OPS;
+    static const int MAX_BATCH_BYTES; // of the ops read before they're applied
+    static const int MAX_APPLY_OPS_BYTES; // of the ops in one applyOps command
+
+    typedef vector<BSONObj> OpVector;
+
+    // the connections the writers apply their ops over; none unless there are several
+    vector<boost::shared_ptr<DBClientBase> > _writers;
+    // by namespace, whether its ops can be spread over the writers by document
+    map<string, bool> _splitByDocument;
+    AtomicInt64 _errors;
+
 public:
     OplogTool() : Tool() { }
 
@@ -35,6 +53,176 @@ public:
         printMongoOplogHelp(&out);
     }
 
+    /** The _id of the one document an insert, update or delete writes, or eoo. */
+    static BSONElement opDocumentId(const BSONObj& op) {
+        const char* opType = op.getStringField("op");
+        if (opType[0] == '\0' || opType[1] != '\0')
+            return BSONElement();
+        switch (opType[0]) {
+        case 'i':
+        case 'd':
+            return op.getObjectField("o")["_id"];
+        case 'u':
+            return op.getObjectField("o2")["_id"];
+        default:
+            return BSONElement();
+        }
+    }
+
+    /**
+     * Commands, and the index builds written to system.indexes, change what the ops after them
+     * apply to, so they're applied alone with everything before them done.
+     */
+    static bool isBarrier(const BSONObj& op) {
+        return str::equals(op.getStringField("op"), "c") ||
+               nsToCollectionSubstring(op.getStringField("ns")) == "system.indexes";
+    }
+
+    /**
+     * The rules a secondary splits its batches by (see SyncTail::fillWriterVectors), asked of
+     * the destination: capped collections keep their insertion order, and a unique index other
+     * than _id could see two documents transiently collide if their ops were reordered.
+     */
+    bool canSplitByDocument(const string& ns) {
+        map<string, bool>::iterator it = _splitByDocument.find(ns);
+        if (it != _splitByDocument.end())
+            return it->second;
+
+        bool split = NamespaceString::normal(ns) && !NamespaceString(ns).isSystem();
+        if (split) {
+            string db = nsToDatabase(ns);
+            BSONObj coll = conn().findOne(db + ".system.namespaces", BSON("name" << ns));
+            BSONObj unique = conn().findOne(db + ".system.indexes",
+                                            BSON("ns" << ns << "unique" << true <<
+                                                 "name" << BSON("$ne" << "_id_")));
+            split = !coll.getObjectField("options")["capped"].trueValue() && unique.isEmpty();
+        }
+        _splitByDocument[ns] = split;
+        return split;
+    }
+
+    /**
+     * Ops on the same document keep their order by landing on the same writer.  A collection
+     * with an op that doesn't name its document, or that can't be split, has all of its ops go
+     * to one writer, in order, as if by namespace alone.
+     */
+    void fillWriterVectors(const OpVector& ops, vector<OpVector>* writerVectors) {
+        map<string, bool> splitByDocument;
+        for (OpVector::const_iterator it = ops.begin(); it != ops.end(); ++it) {
+            string ns = it->getStringField("ns");
+            map<string, bool>::iterator split = splitByDocument.find(ns);
+            if (split == splitByDocument.end())
+                split = splitByDocument.insert(make_pair(ns, canSplitByDocument(ns))).first;
+            if (split->second && opDocumentId(*it).eoo())
+                split->second = false;
+        }
+
+        for (OpVector::const_iterator it = ops.begin(); it != ops.end(); ++it) {
+            const BSONElement e = it->getField("ns");
+            const char* ns = e.valuestr();
+            uint32_t hash = 0;
+            MurmurHash3_x86_32(ns, e.valuestrsize(), 0, &hash);
+
+            if (splitByDocument[ns]) {
+                // hashed by canonical type, so _ids that compare equal go together
+                unsigned long long docHash = BSONElementHasher::hash64(opDocumentId(*it), hash);
+                (*writerVectors)[docHash % writerVectors->size()].push_back(*it);
+                continue;
+            }
+
+            (*writerVectors)[hash % writerVectors->size()].push_back(*it);
+        }
+    }
+
+    /** Applies 'ops' in order over 'c', in applyOps commands of up to MAX_APPLY_OPS_BYTES */
+    void applyOpsOn(DBClientBase* c, const OpVector* ops) {
+        OpVector::const_iterator begin = ops->begin();
+        while (begin != ops->end()) {
+            BSONObjBuilder b;
+            BSONArrayBuilder updates(b.subarrayStart("applyOps"));
+            int bytes = 0;
+            OpVector::const_iterator end = begin;
+            while (end != ops->end() &&
+                   (end == begin || bytes + end->objsize() <= MAX_APPLY_OPS_BYTES)) {
+                bytes += end->objsize();
+                updates.append(*end);
+                ++end;
+            }
+            updates.done();
+
+            try {
+                BSONObj res;
+                if (!c->runCommand("admin", b.obj(), res)) {
+                    toolError() << res << std::endl;
+                    _errors.fetchAndAdd(1);
+                }
+            }
+            catch (std::exception& e) {
+                toolError() << "applying ops: " << e.what() << std::endl;
+                _errors.fetchAndAdd(1);
+            }
+            begin = end;
+        }
+    }
+
+    /** Applies 'ops' over the writers, then records the last of them in the checkpoint file */
+    void applyBatch(const OpVector& ops) {
+        if (ops.empty())
+            return;
+
+        if (_writers.empty() || ops.size() == 1) {
+            applyOpsOn(&conn(), &ops);
+        }
+        else {
+            vector<OpVector> writerVectors(_writers.size());
+            fillWriterVectors(ops, &writerVectors);
+
+            boost::thread_group threads;
+            for (size_t i = 0; i < writerVectors.size(); i++) {
+                if (writerVectors[i].empty())
+                    continue;
+                threads.create_thread(boost::bind(&OplogTool::applyOpsOn, this,
+                                                  _writers[i].get(), &writerVectors[i]));
+            }
+            threads.join_all();
+        }
+
+        checkpoint(ops.back());
+    }
+
+    /** Replaces the checkpoint file with the optime of 'lastOp' */
+    void checkpoint(const BSONObj& lastOp) {
+        const string& file = mongoOplogGlobalParams.checkpointFile;
+        if (file.empty())
+            return;
+
+        string tmp = file + ".tmp";
+        {
+            ofstream out(tmp.c_str(), ios_base::out | ios_base::trunc);
+            out << BSON("ts" << lastOp["ts"]).jsonString() << endl;
+            if (!out.good()) {
+                toolError() << "couldn't write checkpoint file " << tmp << std::endl;
+                return;
+            }
+        }
+        boost::filesystem::rename(tmp, file);
+    }
+
+    /** @return the optime recorded in the checkpoint file, or a null optime without one */
+    OpTime readCheckpoint() {
+        const string& file = mongoOplogGlobalParams.checkpointFile;
+        if (file.empty() || !boost::filesystem::exists(file))
+            return OpTime();
+
+        ifstream in(file.c_str());
+        string line;
+        getline(in, line);
+        BSONObj checkpoint = fromjson(line);
+        uassert(17379, str::stream() << "bad checkpoint file " << file << ": " << line,
+                checkpoint["ts"].type() == Timestamp);
+        return checkpoint["ts"]._opTime();
+    }
+
     int run() {
 
         Client::initThread( "oplogreplay" );
@@ -47,12 +235,28 @@ public:
 
         toolInfoLog() << "connected" << std::endl;
 
-        OpTime start(time(0) - mongoOplogGlobalParams.seconds, 0);
-        toolInfoLog() << "starting from " << start.toStringPretty() << std::endl;
+        // a direct client can't be shared with other threads
+        if (!toolGlobalParams.useDirectClient && mongoOplogGlobalParams.numWriters > 1) {
+            for (int i = 0; i < mongoOplogGlobalParams.numWriters; i++) {
+                _writers.push_back(boost::shared_ptr<DBClientBase>(newConnection()));
+            }
+        }
+
+        OpTime start = readCheckpoint();
+        if (start.isNull()) {
+            start = OpTime(time(0) - mongoOplogGlobalParams.seconds, 0);
+            toolInfoLog() << "starting from " << start.toStringPretty() << std::endl;
+        }
+        else {
+            // the op at the checkpoint is applied again, which is harmless as ops are idempotent
+            toolInfoLog() << "resuming from checkpoint " << start.toStringPretty() << std::endl;
+        }
 
         r.tailingQueryGTE(mongoOplogGlobalParams.ns.c_str(), start);
 
         int num = 0;
+        OpVector batch;
+        int batchBytes = 0;
         while ( r.more() ) {
             BSONObj o = r.next();
             if (logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(2))) {
@@ -60,6 +264,7 @@ public:
             }
             
             if ( o["$err"].type() ) {
+                applyBatch(batch);
                 toolError() << "error getting oplog" << std::endl;
                 toolError() << o << std::endl;
                 return -1;
@@ -71,27 +276,41 @@ public:
                 toolInfoLog() << num << "\t" << o << std::endl;
             }
             
-            if ( o["op"].String() == "n" )
-                continue;
+            if ( o["op"].String() != "n" ) {
+                if (isBarrier(o)) {
+                    applyBatch(batch);
+                    batch.clear();
+                    batchBytes = 0;
 
-            BSONObjBuilder b( o.objsize() + 32 );
-            BSONArrayBuilder updates( b.subarrayStart( "applyOps" ) );
-            updates.append( o );
-            updates.done();
+                    applyBatch(OpVector(1, o.getOwned()));
+                    _splitByDocument.clear();
+                    continue;
+                }
 
-            BSONObj c = b.obj();
-            
-            BSONObj res;
-            bool ok = conn().runCommand( "admin" , c , res );
-            if (!ok) {
-                toolError() << res << std::endl;
-            } else if (print) {
-                toolInfoLog() << res << std::endl;
+                batch.push_back(o.getOwned());
+                batchBytes += o.objsize();
+            }
+
+            // apply rather than wait on the source with ops in hand
+            if (batch.size() >= MAX_BATCH_OPS || batchBytes >= MAX_BATCH_BYTES ||
+                !r.moreInCurrentBatch()) {
+                applyBatch(batch);
+                batch.clear();
+                batchBytes = 0;
             }
         }
+        applyBatch(batch);
+
+        if (_errors.load()) {
+            toolError() << _errors.load() << " applyOps commands failed" << std::endl;
+        }
 
         return 0;
     }
 };
 
+const size_t OplogTool::MAX_BATCH_OPS(5000);
+const int OplogTool::MAX_BATCH_BYTES(64 * 1024 * 1024);
+const int OplogTool::MAX_APPLY_OPS_BYTES(8 * 1024 * 1024);
+
 REGISTER_MONGO_TOOL(OplogTool);
@@ -20,17 +20,22 @@
 #include <boost/filesystem/operations.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/thread/thread.hpp>
 #include <fcntl.h>
 #include <fstream>
 #include <set>
 
 #include "mongo/client/dbclientcursor.h"
+#include "mongo/client/write_pipeline.h"
 #include "mongo/db/json.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/tools/compressed_bson.h"
 #include "mongo/tools/mongorestore_options.h"
 #include "mongo/tools/tool.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/mmap.h"
 #include "mongo/util/options_parser/option_section.h"
+#include "mongo/util/queue.h"
 #include "mongo/util/stringutils.h"
 
 using namespace mongo;
@@ -50,7 +55,10 @@ public:
     scoped_ptr<OpTime> _oplogLimitTS; // for oplog replay (limit)
     int _oplogEntrySkips; // oplog entries skipped
     int _oplogEntryApplies; // oplog entries applied
-    Restore() : BSONTool() { }
+    scoped_ptr<ThreadPool> _pool; // restores collections when restoring several at once
+    mongo::mutex _errorMutex;
+    int _errors; // collections that failed on the pool
+    Restore() : BSONTool(), _errorMutex("restoreErrors"), _errors(0) { }
 
     virtual void printHelp(ostream& out) {
         printMongoRestoreHelp(&out);
@@ -158,6 +166,11 @@ public:
             }
         }
 
+        if (mongoRestoreGlobalParams.numParallelCollections > 1 &&
+            !toolGlobalParams.useDirectClient) {
+            _pool.reset(new ThreadPool(mongoRestoreGlobalParams.numParallelCollections));
+        }
+
         /* If toolGlobalParams.db is not "" then the user specified a db name to restore as.
          *
          * In that case we better be given either a root directory that
@@ -169,6 +182,9 @@ public:
          */
         drillDown(root, toolGlobalParams.db != "", toolGlobalParams.coll != "",
                   !(_oplogLimitTS.get() == NULL), true);
+        if (_pool) {
+            _pool->join();
+        }
 
         // should this happen for oplog replay as well?
         string err = conn().getLastError(toolGlobalParams.db == "" ? "admin" : toolGlobalParams.db);
@@ -185,6 +201,12 @@ public:
                           << " skipped)." << std::endl;
         }
 
+        if (_errors) {
+            toolError() << _errors << " collections or parts of collections failed to restore"
+                        << std::endl;
+            return -1;
+        }
+
         return EXIT_CLEAN;
     }
 
@@ -250,6 +272,10 @@ public:
             }
 
             if (!indexes.empty() && !json_metadata) {
+                // the collections they index are all there first
+                if (_pool) {
+                    _pool->join();
+                }
                 drillDown(indexes, use_db, use_coll, oplogReplayLimit);
             }
 
@@ -261,15 +287,20 @@ public:
             return;
         }
 
-        if ( ! ( endsWith( root.string().c_str() , ".bson" ) ||
-                 endsWith( root.string().c_str() , ".bin" ) ) ) {
+        // the name of the file as it would be uncompressed
+        string leaf = root.leaf().string();
+        if ( endsWith( leaf.c_str() , compressedBSONSuffix ) )
+            leaf.resize( leaf.size() - strlen( compressedBSONSuffix ) );
+
+        if ( ! ( endsWith( leaf.c_str() , ".bson" ) ||
+                 endsWith( leaf.c_str() , ".bin" ) ) ) {
             toolError() << "don't know what to do with file [" << root.string() << "]" << std::endl;
             return;
         }
 
         toolInfoLog() << root.string() << std::endl;
 
-        if ( root.leaf() == "system.profile.bson" ) {
+        if ( leaf == "system.profile.bson" ) {
             toolInfoLog() << "\t skipping system.profile.bson" << std::endl;
             return;
         }
@@ -286,7 +317,7 @@ public:
 
         verify( ns.size() );
 
-        string oldCollName = root.leaf().string(); // Name of the collection that was dumped from
+        string oldCollName = leaf; // Name of the collection that was dumped from
         oldCollName = oldCollName.substr( 0 , oldCollName.find_last_of( "." ) );
         if (use_coll) {
             ns += "." + toolGlobalParams.coll;
@@ -304,22 +335,11 @@ public:
 
         toolInfoLog() << "\tgoing into namespace [" << ns << "]" << std::endl;
 
-        if (mongoRestoreGlobalParams.drop) {
-            if (root.leaf() != "system.users.bson" ) {
-                toolInfoLog() << "\t dropping" << std::endl;
-                conn().dropCollection( ns );
-            } else {
-                // Create map of the users currently in the DB
-                BSONObj fields = BSON("user" << 1);
-                scoped_ptr<DBClientCursor> cursor(conn().query(ns, Query(), 0, 0, &fields));
-                while (cursor->more()) {
-                    BSONObj user = cursor->next();
-                    _users.insert(user["user"].String());
-                }
-            }
-        }
-
-        BSONObj metadataObject;
+        CollectionJob job;
+        job.file = root;
+        job.ns = ns;
+        job.db = nsToDatabase(ns);
+        job.coll = nsToCollectionSubstring(ns).toString();
         if (mongoRestoreGlobalParams.restoreOptions || mongoRestoreGlobalParams.restoreIndexes) {
             boost::filesystem::path metadataFile = (root.branch_path() / (oldCollName + ".metadata.json"));
             if (!boost::filesystem::exists(metadataFile.string())) {
@@ -329,18 +349,54 @@ public:
                     toolInfoLog() << metadataFile.string() << " not found. Skipping." << std::endl;
                 }
             } else {
-                metadataObject = parseMetadataFile(metadataFile.string());
+                job.metadata = parseMetadataFile(metadataFile.string());
             }
         }
 
-        _curns = ns.c_str();
-        _curdb = nsToDatabase(_curns);
-        _curcoll = nsToCollectionSubstring(_curns).toString();
+        // users and legacy index files go through gotObject(), on this thread
+        job.isSystemFile = leaf == "system.users.bson" || job.coll == "system.indexes";
+        if (_pool && !job.isSystemFile) {
+            _pool->schedule(&Restore::restoreCollectionTask, this, job);
+        }
+        else {
+            restoreCollection(job, conn());
+        }
+    }
+
+    /** a .bson file and the collection its documents go to */
+    struct CollectionJob {
+        CollectionJob() : isSystemFile(false) {}
+        boost::filesystem::path file;
+        string ns;
+        string db;
+        string coll;
+        BSONObj metadata;
+        bool isSystemFile;
+    };
+
+    void restoreCollection(const CollectionJob& job, DBClientBase& c) {
+        const string& ns = job.ns;
+        bool isUsers = job.file.leaf() == "system.users.bson";
+
+        if (mongoRestoreGlobalParams.drop) {
+            if (!isUsers) {
+                toolInfoLog() << "\t dropping " << ns << std::endl;
+                c.dropCollection( ns );
+            } else {
+                // Create map of the users currently in the DB
+                BSONObj fields = BSON("user" << 1);
+                scoped_ptr<DBClientCursor> cursor(c.query(ns, Query(), 0, 0, &fields));
+                while (cursor->more()) {
+                    BSONObj user = cursor->next();
+                    _users.insert(user["user"].String());
+                }
+            }
+        }
 
         // If drop is not used, warn if the collection exists.
          if (!mongoRestoreGlobalParams.drop) {
-             scoped_ptr<DBClientCursor> cursor(conn().query(_curdb + ".system.namespaces",
-                                                             Query(BSON("name" << ns))));
+             scoped_ptr<DBClientCursor> cursor(c.query(job.db + ".system.namespaces",
+                                                       Query(BSON("name" << ns))));
              if (cursor->more()) {
                  // collection already exists show warning
                  toolError() << "Restoring to " << ns << " without dropping. Restored data "
@@ -349,27 +405,216 @@ public:
              }
          }
 
-        if (mongoRestoreGlobalParams.restoreOptions && metadataObject.hasField("options")) {
+        if (mongoRestoreGlobalParams.restoreOptions && job.metadata.hasField("options")) {
             // Try to create collection with given options
-            createCollectionWithOptions(metadataObject["options"].Obj());
+            createCollectionWithOptions(c, job, job.metadata["options"].Obj());
+        }
+
+        if (job.isSystemFile) {
+            _curns = ns;
+            _curdb = job.db;
+            _curcoll = job.coll;
+            processFile( job.file );
+        }
+        else {
+            insertDocuments(job, c);
         }
 
-        processFile( root );
-        if (mongoRestoreGlobalParams.drop && root.leaf() == "system.users.bson") {
+        if (mongoRestoreGlobalParams.drop && isUsers) {
             // Delete any users that used to exist but weren't in the dump file
             for (set<string>::iterator it = _users.begin(); it != _users.end(); ++it) {
                 BSONObj userMatch = BSON("user" << *it);
-                conn().remove(ns, Query(userMatch));
+                c.remove(ns, Query(userMatch));
             }
             _users.clear();
         }
 
-        if (mongoRestoreGlobalParams.restoreIndexes && metadataObject.hasField("indexes")) {
-            vector<BSONElement> indexes = metadataObject["indexes"].Array();
-            for (vector<BSONElement>::iterator it = indexes.begin(); it != indexes.end(); ++it) {
-                createIndex((*it).Obj(), false);
+        if (mongoRestoreGlobalParams.restoreIndexes && job.metadata.hasField("indexes")) {
+            vector<BSONElement> indexes = job.metadata["indexes"].Array();
+            createIndexes(c, job, indexes);
+        }
+    }
+
+    /** restores a collection on a pool thread, with a connection of its own */
+    void restoreCollectionTask(const CollectionJob job) {
+        try {
+            scoped_ptr<DBClientBase> c(newConnection());
+            restoreCollection(job, *c);
+        }
+        catch (std::exception& e) {
+            noteError(str::stream() << "restoring " << job.ns << ": " << e.what());
+        }
+    }
+
+    /**
+     * Batches the documents of a collection and inserts them while the file is still being read:
+     * on inserter threads with connections of their own or, with none, on the reading thread.
+     */
+    class BatchInserter : boost::noncopyable {
+    public:
+        BatchInserter(Restore* tool, const CollectionJob& job, DBClientBase& c, int numWorkers) :
+            _tool(tool), _job(job), _conn(c), _numWorkers(numWorkers),
+            _queue(numWorkers * 2 + 1), _batch(new Batch()), _batchBytes(0) {
+            for (int i = 0; i < numWorkers; i++) {
+                _workers.create_thread(boost::bind(&BatchInserter::work, this));
+            }
+        }
+
+        void add(const BSONObj& obj) {
+            if (_batchBytes + obj.objsize() > BatchBytes && !_batch->empty()) {
+                flush();
+            }
+            // the reader reuses its buffer
+            _batch->push_back(obj.getOwned());
+            _batchBytes += obj.objsize();
+        }
+
+        /** inserts what's left and waits for the inserter threads */
+        void finish() {
+            if (!_batch->empty()) {
+                flush();
+            }
+            if (_numWorkers == 0) {
+                checkLastError(_conn);
+            }
+            for (int i = 0; i < _numWorkers; i++) {
+                _queue.push(BatchPtr());
+            }
+            _workers.join_all();
+        }
+
+    private:
+        typedef vector<BSONObj> Batch;
+        typedef boost::shared_ptr<Batch> BatchPtr;
+
+        // well within the largest message a server takes
+        static const int BatchBytes = 8 * 1024 * 1024;
+        // write commands a worker has in flight
+        static const int PipelineDepth = 4;
+
+        void flush() {
+            if (_numWorkers == 0) {
+                insert(_conn, *_batch);
+            }
+            else {
+                _queue.push(_batch);
+            }
+            _batch.reset(new Batch());
+            _batchBytes = 0;
+        }
+
+        void insert(DBClientBase& c, const Batch& batch) {
+            c.insert(_job.ns, batch, InsertOption_ContinueOnError);
+
+            // wait for insert to propagate to "w" nodes (doesn't warn if w used without replset)
+            if (mongoRestoreGlobalParams.w > 0) {
+                string err = c.getLastError(_job.db, false, false, mongoRestoreGlobalParams.w);
+                if (!err.empty()) {
+                    toolError() << err << std::endl;
+                }
+            }
+        }
+
+        void checkLastError(DBClientBase& c) {
+            string err = c.getLastError(_job.db);
+            if (!err.empty()) {
+                toolError() << _job.ns << ": " << err << std::endl;
+            }
+        }
+
+        void reportPipelineErrors(const DBClientWritePipeline& pipeline) {
+            const vector<DBClientWritePipeline::Error>& errors = pipeline.errors();
+            for (size_t i = 0; i < errors.size(); i++) {
+                toolError() << _job.ns << ": " << errors[i].reply << std::endl;
             }
         }
+
+        // Keeps taking batches after an error so the reader is never left waiting on a full
+        // queue.  With a write concern the batches go out as pipelined write commands, so the
+        // next is sent while the last is still being acknowledged.
+        void work() {
+            scoped_ptr<DBClientBase> c;
+            scoped_ptr<DBClientWritePipeline> pipeline;
+            try {
+                c.reset(_tool->newConnection());
+                if (mongoRestoreGlobalParams.w > 0 && DBClientWritePipeline::supported(c.get())) {
+                    pipeline.reset(new DBClientWritePipeline(
+                            c.get(), BSON("w" << mongoRestoreGlobalParams.w), PipelineDepth));
+                }
+            }
+            catch (std::exception& e) {
+                _tool->noteError(str::stream() << "connecting to insert into " << _job.ns << ": "
+                                               << e.what());
+                c.reset();
+            }
+
+            while (true) {
+                BatchPtr batch = _queue.blockingPop();
+                if (!batch) {
+                    break;
+                }
+                if (!c) {
+                    continue;
+                }
+                try {
+                    if (pipeline) {
+                        pipeline->insert(_job.ns, *batch, false);
+                    }
+                    else {
+                        insert(*c, *batch);
+                    }
+                }
+                catch (std::exception& e) {
+                    _tool->noteError(str::stream() << "inserting into " << _job.ns << ": "
+                                                   << e.what());
+                    if (pipeline) {
+                        // the replies in flight can't be told apart any more
+                        pipeline.reset();
+                        c.reset();
+                    }
+                }
+            }
+
+            if (c) {
+                try {
+                    if (pipeline) {
+                        pipeline->flush();
+                        reportPipelineErrors(*pipeline);
+                    }
+                    else {
+                        checkLastError(*c);
+                    }
+                }
+                catch (std::exception& e) {
+                    _tool->noteError(str::stream() << "inserting into " << _job.ns << ": "
+                                                   << e.what());
+                }
+            }
+        }
+
+        Restore* _tool;
+        const CollectionJob& _job;
+        DBClientBase& _conn;
+        const int _numWorkers;
+        BlockingQueue<BatchPtr> _queue;
+        boost::thread_group _workers;
+        BatchPtr _batch;
+        int _batchBytes;
+    };
+
+    void insertDocuments(const CollectionJob& job, DBClientBase& c) {
+        // a direct client can't be shared with other threads
+        int numWorkers = toolGlobalParams.useDirectClient ?
+            0 : mongoRestoreGlobalParams.numInsertionWorkers;
+        BatchInserter inserter(this, job, c, numWorkers);
+        processFile(job.file, boost::bind(&BatchInserter::add, &inserter, _1));
+        inserter.finish();
+    }
+
+    void noteError(const string& error) {
+        toolError() << "ERROR " << error << std::endl;
+        scoped_lock lk(_errorMutex);
+        _errors++;
     }
 
     virtual void gotObject( const BSONObj& obj ) {
@@ -400,7 +645,7 @@ public:
             }
         }
         else if (nsToCollectionSubstring(_curns) == "system.indexes") {
-            createIndex(obj, true);
+            createIndex(conn(), _curdb, _curcoll, obj, true);
         }
         else if (mongoRestoreGlobalParams.drop &&
                  nsToCollectionSubstring(_curns) == ".system.users" &&
@@ -460,14 +705,14 @@ private:
         return nfields == obj2.nFields();
     }
 
-    void createCollectionWithOptions(BSONObj cmdObj) {
+    void createCollectionWithOptions(DBClientBase& c, const CollectionJob& job, BSONObj cmdObj) {
 
         // Create a new cmdObj to skip undefined fields and fix collection name
         BSONObjBuilder bo;
 
         // Add a "create" field if it doesn't exist
         if (!cmdObj.hasField("create")) {
-            bo.append("create", _curcoll);
+            bo.append("create", job.coll);
         }
 
         BSONObjIterator i(cmdObj);
@@ -476,11 +721,11 @@ private:
 
             // Replace the "create" field with the name of the collection we are actually creating
             if (strcmp(e.fieldName(), "create") == 0) {
-                bo.append("create", _curcoll);
+                bo.append("create", job.coll);
             }
             else {
                 if (e.type() == Undefined) {
-                    toolInfoLog() << _curns << ": skipping undefined field: " << e.fieldName()
+                    toolInfoLog() << job.ns << ": skipping undefined field: " << e.fieldName()
                                   << std::endl;
                 }
                 else {
@@ -491,14 +736,14 @@ private:
         cmdObj = bo.obj();
 
         BSONObj fields = BSON("options" << 1);
-        scoped_ptr<DBClientCursor> cursor(conn().query(_curdb + ".system.namespaces", Query(BSON("name" << _curns)), 0, 0, &fields));
+        scoped_ptr<DBClientCursor> cursor(c.query(job.db + ".system.namespaces", Query(BSON("name" << job.ns)), 0, 0, &fields));
 
         bool createColl = true;
         if (cursor->more()) {
             createColl = false;
             BSONObj obj = cursor->next();
             if (!obj.hasField("options") || !optionsSame(cmdObj, obj["options"].Obj())) {
-                toolError() << "WARNING: collection " << _curns
+                toolError() << "WARNING: collection " << job.ns
                           << " exists with different options than are in the metadata.json file and"
                           << " not using --drop. Options in the metadata file will be ignored."
                           << std::endl;
@@ -510,10 +755,10 @@ private:
         }
 
         BSONObj info;
-        if (!conn().runCommand(_curdb, cmdObj, info)) {
-            uasserted(15936, "Creating collection " + _curns + " failed. Errmsg: " + info["errmsg"].String());
+        if (!c.runCommand(job.db, cmdObj, info)) {
+            uasserted(15936, "Creating collection " + job.ns + " failed. Errmsg: " + info["errmsg"].String());
         } else {
-            toolInfoLog() << "\tCreated collection " << _curns << " with options: "
+            toolInfoLog() << "\tCreated collection " << job.ns << " with options: "
                           << cmdObj.jsonString() << std::endl;
         }
     }
@@ -521,14 +766,15 @@ private:
     /* We must handle if the dbname or collection name is different at restore time than what was dumped.
        If keepCollName is true, however, we keep the same collection name that's in the index object.
      */
-    void createIndex(BSONObj indexObj, bool keepCollName) {
+    BSONObj fixIndexSpec(const string& db, const string& coll, const BSONObj& indexObj,
+                         bool keepCollName) {
         BSONObjBuilder bo;
         BSONObjIterator i(indexObj);
         while ( i.more() ) {
             BSONElement e = i.next();
             if (strcmp(e.fieldName(), "ns") == 0) {
                 NamespaceString n(e.String());
-                string s = _curdb + "." + (keepCollName ? n.coll().toString() : _curcoll);
+                string s = db + "." + (keepCollName ? n.coll().toString() : coll);
                 bo.append("ns", s);
             }
             // Remove index version number
@@ -536,14 +782,65 @@ private:
                 bo.append(e);
             }
         }
-        BSONObj o = bo.obj();
+        return bo.obj();
+    }
+
+    /* Builds all the indexes of the current collection with one createIndexes command, so the
+       server scans the restored documents once rather than once per index.  Servers without the
+       command get the indexes one at a time.
+     */
+    void createIndexes(DBClientBase& c, const CollectionJob& job,
+                       const vector<BSONElement>& indexes) {
+        if (indexes.empty()) {
+            return;
+        }
+
+        BSONArrayBuilder specs;
+        for (vector<BSONElement>::const_iterator it = indexes.begin(); it != indexes.end(); ++it) {
+            BSONObj o = fixIndexSpec(job.db, job.coll, it->Obj(), false);
+            if (logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(0))) {
+                toolInfoLog() << "\tCreating index: " << o << std::endl;
+            }
+            specs.append(o);
+        }
+
+        BSONObj info;
+        if (c.runCommand(job.db,
+                         BSON("createIndexes" << job.coll << "indexes" << specs.arr()),
+                         info)) {
+            if (mongoRestoreGlobalParams.w > 1) {
+                BSONObj err = c.getLastErrorDetailed(job.db, false, false,
+                                                     mongoRestoreGlobalParams.w);
+                if (err.hasField("err") && !err["err"].isNull()) {
+                    toolError() << "Error replicating indexes on " << job.ns << ": "
+                                << err["err"] << std::endl;
+                    ::abort();
+                }
+            }
+            return;
+        }
+
+        if (info["code"].numberInt() != ErrorCodes::CommandNotFound) {
+            toolError() << "Error creating indexes on " << job.ns << ": "
+                        << info["code"].numberInt() << " " << info["errmsg"] << std::endl;
+            ::abort();
+        }
+
+        for (vector<BSONElement>::const_iterator it = indexes.begin(); it != indexes.end(); ++it) {
+            createIndex(c, job.db, job.coll, it->Obj(), false);
+        }
+    }
+
+    void createIndex(DBClientBase& c, const string& db, const string& coll, BSONObj indexObj,
+                     bool keepCollName) {
+        BSONObj o = fixIndexSpec(db, coll, indexObj, keepCollName);
         if (logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(0))) {
             toolInfoLog() << "\tCreating index: " << o << std::endl;
         }
-        conn().insert( _curdb + ".system.indexes" ,  o );
+        c.insert( db + ".system.indexes" ,  o );
 
         // We're stricter about errors for indexes than for regular data
-        BSONObj err = conn().getLastErrorDetailed(_curdb, false, false, mongoRestoreGlobalParams.w);
+        BSONObj err = c.getLastErrorDetailed(db, false, false, mongoRestoreGlobalParams.w);
 
         if (err.hasField("err") && !err["err"].isNull()) {
             if (err["err"].str() == "norepl" && mongoRestoreGlobalParams.w > 1) {
@@ -37,7 +37,7 @@ namespace mongo {
     class Stat : public Tool {
     public:
 
-        Stat() : Tool() {
+        Stat() : Tool() , _deltas( "serverStatus" ) , _useDeltas( false ) {
             _autoreconnect = true;
         }
 
@@ -73,6 +73,14 @@ namespace mongo {
                 }
                 return e.embeddedObjectUserCheck();
             }
+            if ( _useDeltas ) {
+                BSONObj out;
+                if ( _deltas.next( conn() , &out ) )
+                    return out;
+                toolError() << "statsDelta failed, fetching whole serverStatus documents: "
+                            << out << std::endl;
+                _useDeltas = false;
+            }
             BSONObj out;
             if (!conn().simpleCommand(toolGlobalParams.db, &out, "serverStatus")) {
                 toolError() << "error: " << out << std::endl;
@@ -83,7 +91,13 @@ namespace mongo {
 
         int run() {
             _statUtil.setAll(mongoStatGlobalParams.allFields);
-            _statUtil.setSeconds(mongoStatGlobalParams.sleep);
+            if (mongoStatGlobalParams.intervalMillis) {
+                _statUtil.setSeconds(mongoStatGlobalParams.intervalMillis / 1000.0);
+                _useDeltas = !mongoStatGlobalParams.http;
+            }
+            else {
+                _statUtil.setSeconds(mongoStatGlobalParams.sleep);
+            }
             if (mongoStatGlobalParams.many)
                 return runMany();
             return runNormal();
@@ -141,7 +155,10 @@ namespace mongo {
 
             while (mongoStatGlobalParams.rowCount == 0 ||
                    rowNum < mongoStatGlobalParams.rowCount) {
-                sleepsecs((int)ceil(_statUtil.getSeconds()));
+                if (mongoStatGlobalParams.intervalMillis)
+                    sleepmillis(mongoStatGlobalParams.intervalMillis);
+                else
+                    sleepsecs((int)ceil(_statUtil.getSeconds()));
                 BSONObj now;
                 try {
                     now = stats();
@@ -486,6 +503,8 @@ namespace mongo {
         }
 
         StatUtil _statUtil;
+        StatsDeltaStream _deltas;
+        bool _useDeltas;
 
         struct Row {
             Row( string h , string e ) {
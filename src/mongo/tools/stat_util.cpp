@@ -19,6 +19,7 @@
 #include <iomanip>
 
 #include "stat_util.h"
+#include "mongo/client/dbclientinterface.h"
 #include "mongo/util/mongoutils/str.h"
 
 using namespace mongoutils;
@@ -349,5 +350,44 @@ namespace mongo {
 
         return data;
     }
-}
 
+    bool StatsDeltaStream::next( DBClientBase& conn , BSONObj* out ) {
+        BSONObj reply;
+        if ( ! conn.runCommand( "admin" , BSON( "statsDelta" << _command << "token" << _token ) , reply ) ) {
+            *out = reply;
+            return false;
+        }
+
+        _token = reply["token"].numberLong();
+        BSONObj changed = reply["changed"].Obj();
+        if ( reply["full"].trueValue() )
+            _current = changed.getOwned();
+        else
+            _current = merge( _current , changed );
+        *out = _current;
+        return true;
+    }
+
+    BSONObj StatsDeltaStream::merge( const BSONObj& base , const BSONObj& changed ) {
+        BSONObjBuilder b;
+        BSONObjIterator i( base );
+        while ( i.more() ) {
+            BSONElement e = i.next();
+            BSONElement c = changed[e.fieldName()];
+            if ( c.eoo() )
+                b.append( e );
+            else if ( c.type() == Object && e.type() == Object )
+                b.append( e.fieldName() , merge( e.Obj() , c.Obj() ) );
+            else
+                b.append( c );
+        }
+
+        BSONObjIterator j( changed );
+        while ( j.more() ) {
+            BSONElement c = j.next();
+            if ( ! base.hasField( c.fieldName() ) )
+                b.append( c );
+        }
+        return b.obj();
+    }
+}
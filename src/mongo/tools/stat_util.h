@@ -23,6 +23,8 @@
 
 namespace mongo {
 
+    class DBClientBase;
+
 
     struct NamespaceInfo {
         string ns;
@@ -112,5 +114,29 @@ namespace mongo {
         bool _all;
         
     };
-}
 
+    /**
+     * Follows a statsDelta stream of serverStatus or top: keeps the whole document and merges in
+     * what the server says changed, so sampling many times a second transfers a few counters
+     * rather than the whole document each time.
+     */
+    class StatsDeltaStream {
+    public:
+        /** @param command - "serverStatus" or "top" */
+        explicit StatsDeltaStream( const string& command ) : _command( command ) , _token( 0 ) {}
+
+        /**
+         * Sets *out to the latest document.
+         * @return false, with the reply in *out, if the server can't run statsDelta
+         */
+        bool next( DBClientBase& conn , BSONObj* out );
+
+        /** @return 'base' with the fields of 'changed' replacing or added to its own */
+        static BSONObj merge( const BSONObj& base , const BSONObj& changed );
+
+    private:
+        string _command;
+        long long _token;
+        BSONObj _current;
+    };
+}
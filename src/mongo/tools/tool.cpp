@@ -18,6 +18,7 @@
 
 #include "mongo/tools/tool.h"
 
+#include <boost/bind.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <fstream>
 #include <iostream>
@@ -32,6 +33,7 @@
 #include "mongo/db/namespace_details.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/platform/posix_fadvise.h"
+#include "mongo/tools/compressed_bson.h"
 #include "mongo/util/file_allocator.h"
 #include "mongo/util/options_parser/option_section.h"
 #include "mongo/util/password.h"
@@ -178,6 +180,25 @@ namespace mongo {
         return *_conn;
     }
 
+    DBClientBase* Tool::newConnection( bool slaveIfPaired ) {
+        string errmsg;
+        ConnectionString cs = ConnectionString::parse(toolGlobalParams.connectionString, errmsg);
+        if ( slaveIfPaired && _conn->type() == ConnectionString::SET )
+            cs = ConnectionString( HostAndPort( conn( true ).getServerAddress() ) );
+
+        DBClientBase* c = cs.connect( errmsg );
+        uassert( 17378, str::stream() << "couldn't connect to [" << cs.toString() << "] "
+                                      << errmsg, c );
+        try {
+            authenticate( c );
+        }
+        catch ( ... ) {
+            delete c;
+            throw;
+        }
+        return c;
+    }
+
     bool Tool::isMaster() {
         if (toolGlobalParams.useDirectClient) {
             return true;
@@ -232,11 +253,18 @@ namespace mongo {
             return;
         }
 
-        _conn->auth(BSON(saslCommandUserSourceFieldName << getAuthenticationDatabase() <<
-                         saslCommandUserFieldName << toolGlobalParams.username <<
-                         saslCommandPasswordFieldName << toolGlobalParams.password  <<
-                         saslCommandMechanismFieldName <<
-                         toolGlobalParams.authenticationMechanism));
+        authenticate(_conn);
+    }
+
+    void Tool::authenticate( DBClientBase* conn ) {
+        if (toolGlobalParams.username.empty())
+            return;
+
+        conn->auth(BSON(saslCommandUserSourceFieldName << getAuthenticationDatabase() <<
+                        saslCommandUserFieldName << toolGlobalParams.username <<
+                        saslCommandPasswordFieldName << toolGlobalParams.password  <<
+                        saslCommandMechanismFieldName <<
+                        toolGlobalParams.authenticationMechanism));
     }
 
     BSONTool::BSONTool() : Tool() { }
@@ -251,6 +279,11 @@ namespace mongo {
     }
 
     long long BSONTool::processFile( const boost::filesystem::path& root ) {
+        return processFile( root , boost::bind( &BSONTool::gotObject , this , _1 ) );
+    }
+
+    long long BSONTool::processFile( const boost::filesystem::path& root ,
+                                     const boost::function<void(const BSONObj&)>& handler ) {
         std::string fileName = root.string();
 
         unsigned long long fileLength = file_size( root );
@@ -284,25 +317,41 @@ namespace mongo {
         boost::scoped_array<char> buf_holder(new char[BUF_SIZE]);
         char * buf = buf_holder.get();
 
+        scoped_ptr<CompressedBSONReader> compressed;
+        if ( endsWith( fileName.c_str(), compressedBSONSuffix ) )
+            compressed.reset( new CompressedBSONReader( file ) );
+
         ProgressMeter m(fileLength);
         if (!toolGlobalParams.quiet) {
             m.setUnits( "bytes" );
         }
 
         while ( read < fileLength ) {
-            size_t amt = fread(buf, 1, 4, file);
-            verify( amt == 4 );
+            BSONObj o;
+            int size;
+            if ( compressed ) {
+                unsigned long long before = compressed->bytesRead();
+                if ( ! compressed->next( &o ) )
+                    break;
+                // counted here in bytes of the file, like the progress meter
+                size = compressed->bytesRead() - before;
+            }
+            else {
+                size_t amt = fread(buf, 1, 4, file);
+                verify( amt == 4 );
 
-            int size = ((int*)buf)[0];
-            uassert( 10264 , str::stream() << "invalid object size: " << size , size < BUF_SIZE );
+                size = ((int*)buf)[0];
+                uassert( 10264 , str::stream() << "invalid object size: " << size , size < BUF_SIZE );
 
-            amt = fread(buf+4, 1, size-4, file);
-            verify( amt == (size_t)( size - 4 ) );
+                amt = fread(buf+4, 1, size-4, file);
+                verify( amt == (size_t)( size - 4 ) );
+
+                o = BSONObj( buf );
+            }
 
-            BSONObj o( buf );
             if (bsonToolGlobalParams.objcheck && !o.valid()) {
                 toolError() << "INVALID OBJECT - going to try and print out " << std::endl;
-                toolError() << "size: " << size << std::endl;
+                toolError() << "size: " << o.objsize() << std::endl;
                 BSONObjIterator i(o);
                 while ( i.more() ) {
                     BSONElement e = i.next();
@@ -319,15 +368,15 @@ namespace mongo {
             }
 
             if (!bsonToolGlobalParams.hasFilter || _matcher->matches(o)) {
-                gotObject( o );
+                handler( o );
                 processed++;
             }
 
-            read += o.objsize();
+            read += size;
             num++;
 
             if (!toolGlobalParams.quiet) {
-                m.hit(o.objsize());
+                m.hit(size);
             }
         }
 
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <boost/function.hpp>
 #include <string>
 
 #if defined(_WIN32)
@@ -64,6 +65,12 @@ namespace mongo {
 
         mongo::DBClientBase &conn( bool slaveIfPaired = false );
 
+        /**
+         * @return a new connection to the server conn( slaveIfPaired ) talks to, authenticated
+         * like it, for a thread of the tool's own.  The caller owns it.
+         */
+        mongo::DBClientBase* newConnection( bool slaveIfPaired = false );
+
         bool _autoreconnect;
 
     protected:
@@ -73,6 +80,7 @@ namespace mongo {
 
     private:
         void auth();
+        void authenticate( DBClientBase* conn );
     };
 
     class BSONTool : public Tool {
@@ -88,6 +96,10 @@ namespace mongo {
 
         long long processFile( const boost::filesystem::path& file );
 
+        /** calls 'handler' with each document of 'file' that matches rather than gotObject() */
+        long long processFile( const boost::filesystem::path& file ,
+                               const boost::function<void(const BSONObj&)>& handler );
+
     };
 
 }
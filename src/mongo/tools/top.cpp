@@ -30,7 +30,8 @@ namespace mongo {
     class TopTool : public Tool {
     public:
 
-        TopTool() : Tool() {
+        TopTool() : Tool() , _lockDeltas( "serverStatus" ) , _topDeltas( "top" ) ,
+                    _useDeltas( false ) {
             _autoreconnect = true;
         }
 
@@ -44,9 +45,25 @@ namespace mongo {
             return getDataTop();
         }
 
+        /**
+         * Fetches the next document of 'stream' when sampling many times a second.
+         * @return false to fetch the whole document instead
+         */
+        bool fetchDelta( StatsDeltaStream& stream , BSONObj* out ) {
+            if ( ! _useDeltas )
+                return false;
+            if ( stream.next( conn() , out ) )
+                return true;
+            toolError() << "statsDelta failed, fetching whole documents: " << *out << std::endl;
+            _useDeltas = false;
+            return false;
+        }
+
         NamespaceStats getDataLocks() {
 
             BSONObj out;
+            if ( fetchDelta( _lockDeltas , &out ) )
+                return StatUtil::parseServerStatusLocks( out );
             if (!conn().simpleCommand(toolGlobalParams.db, &out, "serverStatus")) {
                 toolError() << "error: " << out << std::endl;
                 return NamespaceStats();
@@ -59,7 +76,8 @@ namespace mongo {
             NamespaceStats stats;
 
             BSONObj out;
-            if (!conn().simpleCommand(toolGlobalParams.db, &out, "top")) {
+            if ( !fetchDelta( _topDeltas , &out ) &&
+                 !conn().simpleCommand(toolGlobalParams.db, &out, "top")) {
                 toolError() << "error: " << out << std::endl;
                 return stats;
             }
@@ -135,10 +153,15 @@ namespace mongo {
                 return EXIT_FAILURE;
             }
 
+            _useDeltas = mongoTopGlobalParams.intervalMillis > 0;
+
             NamespaceStats prev = getData();
 
             while ( true ) {
-                sleepsecs(mongoTopGlobalParams.sleep);
+                if (mongoTopGlobalParams.intervalMillis)
+                    sleepmillis(mongoTopGlobalParams.intervalMillis);
+                else
+                    sleepsecs(mongoTopGlobalParams.sleep);
                 
                 NamespaceStats now;
                 try {
@@ -164,6 +187,11 @@ namespace mongo {
 
             return 0;
         }
+
+    private:
+        StatsDeltaStream _lockDeltas;
+        StatsDeltaStream _topDeltas;
+        bool _useDeltas;
     };
 
     REGISTER_MONGO_TOOL(TopTool);
@@ -32,8 +32,13 @@
 
 #include "mongo/util/alignedbuilder.h"
 
+#include "mongo/util/numa.h"
+
 namespace mongo {
 
+    bool AlignedBuilder::nodeLocal = false;
+    bool AlignedBuilder::hugePages = false;
+
     AlignedBuilder::AlignedBuilder(unsigned initSize) {
         _len = 0;
         _malloc(initSize);
@@ -122,6 +127,15 @@ namespace mongo {
         massert(13524, "out of memory AlignedBuilder", res == 0);
         _p._allocationAddress = p;
         _p._data = (char *) p;
+        // huge pages only pay off for buffers spanning at least one
+        const unsigned HugePageSize = 2 * 1024 * 1024;
+        const bool huge = hugePages && sz >= HugePageSize;
+        if( nodeLocal || huge ) {
+            if( !adviseMemoryPlacement(p, sz, nodeLocal, huge) ) {
+                LOG(1) << "couldn't set NUMA placement of journal buffer: "
+                       << errnoWithDescription() << endl;
+            }
+        }
 #else
         mallocSelfAligned(sz);
         verify( ((size_t) _p._data) % Alignment == 0 );
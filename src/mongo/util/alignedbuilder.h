@@ -106,6 +106,14 @@ namespace mongo {
         /** @return the in-use length */
         unsigned len() const { return _len; }
 
+        /**
+         * Whether buffers allocated from now on are kept on the NUMA node of the thread that fills
+         * them, whatever the process's memory policy, and whether large ones ask for transparent
+         * huge pages.  Linux only.
+         */
+        static bool nodeLocal;
+        static bool hugePages;
+
     private:
         static const unsigned Alignment = 8192;
 
@@ -41,6 +41,11 @@ namespace mongo {
         // if you change this you must bump dur::CurrentVersion
         void gen(const void *buf, unsigned len) {
             wassert( ((size_t)buf) % 8 == 0 ); // performance warning
+            genUnaligned(buf, len);
+        }
+
+        /** as gen(), without the warning, for buffers such as records that needn't be aligned */
+        void genUnaligned(const void *buf, unsigned len) {
             unsigned n = len / 8 / 2;
             const unsigned long long *p = (const unsigned long long *) buf;
             unsigned long long a = 0;
@@ -42,6 +42,14 @@ namespace mongo {
         snappy::RawCompress(input, input_length, compressed, compressed_length);
     }
 
+    bool uncompressedLength(const char* compressed, size_t compressed_length, size_t* result) {
+        return snappy::GetUncompressedLength(compressed, compressed_length, result);
+    }
+
+    bool rawUncompress(const char* compressed, size_t compressed_length, char* uncompressed) {
+        return snappy::RawUncompress(compressed, compressed_length, uncompressed);
+    }
+
     size_t maxCompressedLength(size_t source_len) {
         return snappy::MaxCompressedLength(source_len);
     }
@@ -0,0 +1,107 @@
+// @file intentlock.h
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects
+*    for all of the code used other than as permitted herein. If you modify
+*    file(s) with this exception, you may extend this exception to your
+*    version of the file(s), but you are not obligated to do so. If you do not
+*    wish to do so, delete this exception statement from your version. If you
+*    delete this exception statement from all source files in the program,
+*    then also delete it in the license file.
+*/
+
+#pragma once
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace mongo {
+
+    /** The shared (S) and intent exclusive (IX) modes of a database lock.
+
+        S holders read the whole database, IX holders each write one collection of it, locked
+        separately.  Holders of a mode are compatible with each other and not with the other
+        mode:
+
+            S IX  <== lock that was around
+        S   * -
+        IX  - *
+
+        The exclusive (X) mode, which excludes both, is left to the rwlock this sits beside:
+        S and IX holders hold that shared first.
+
+        Neither side starves the other: a holder that finds the other side waiting hands it
+        the next turn, and newcomers of its own side then wait behind it.
+
+        Non-recursive.
+    */
+    class IntentLock : boost::noncopyable {
+        enum Side { S, IX };
+        struct Z {
+            Z() : n(0), waiting(0) { }
+            boost::condition c;
+            int n;
+            int waiting;
+        };
+        boost::mutex m;
+        Z z[2];
+        Side turn;
+
+        static Side other(Side s) { return s == S ? IX : S; }
+
+        void lock(Side me) {
+            boost::mutex::scoped_lock lk(m);
+            Z& mine = z[me];
+            Z& theirs = z[other(me)];
+            mine.waiting++;
+            while( theirs.n || ( theirs.waiting && turn != me ) )
+                mine.c.wait(lk);
+            mine.waiting--;
+            mine.n++;
+            if( theirs.waiting )
+                turn = other(me);
+        }
+
+        void unlock(Side me) {
+            boost::mutex::scoped_lock lk(m);
+            Z& mine = z[me];
+            Z& theirs = z[other(me)];
+            mine.n--;
+            if( mine.n == 0 ) {
+                turn = other(me);
+                if( theirs.waiting )
+                    theirs.c.notify_all();
+                else if( mine.waiting )
+                    mine.c.notify_all();
+            }
+        }
+
+    public:
+        IntentLock() : turn(S) { }
+
+        void lock_S()    { lock(S); }
+        void unlock_S()  { unlock(S); }
+        void lock_IX()   { lock(IX); }
+        void unlock_IX() { unlock(IX); }
+    };
+
+}
@@ -0,0 +1,111 @@
+// @file qlock.h
+
+/**
+*    Copyright (C) 2012 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects
+*    for all of the code used other than as permitted herein. If you modify
+*    file(s) with this exception, you may extend this exception to your
+*    version of the file(s), but you are not obligated to do so. If you do not
+*    wish to do so, delete this exception statement from your version. If you
+*    delete this exception statement from all source files in the program,
+*    then also delete it in the license file.
+*/
+
+#pragma once
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    /** Admission by priority class, in front of a lock.
+
+        A request arrives at the gate of a lock before acquiring it, and leaves once it has it
+        (or gave up).  While requests of a class are between the two, requests of lower classes
+        wait at the gate instead of queueing on the lock, so a stream of low class requests
+        can't keep a lock that's wanted by a higher class held.  The highest class never waits.
+
+        The wait is bounded, so lower classes are slowed down by higher ones but not starved
+        outright.  Uncontended arrivals and departures are a few atomic operations.
+    */
+    class PriorityGate : boost::noncopyable {
+    public:
+        enum { NumClasses = 3 };
+
+        PriorityGate() { }
+
+        /** @return false if cls waited maxWaitMillis for higher classes, and came in anyway */
+        bool arrive( int cls, int maxWaitMillis ) {
+            bool got = true;
+            if( _higherPending(cls) )
+                got = _wait(cls, maxWaitMillis);
+            _pending[cls].fetchAndAdd(1);
+            return got;
+        }
+
+        void leave( int cls ) {
+            _pending[cls].fetchAndSubtract(1);
+            if( _sleepers.load() ) {
+                boost::mutex::scoped_lock lk(_m);
+                _c.notify_all();
+            }
+        }
+
+        unsigned pending( int cls ) const { return _pending[cls].load(); }
+
+    private:
+        bool _higherPending( int cls ) const {
+            for( int i = cls + 1; i < NumClasses; i++ ) {
+                if( _pending[i].load() )
+                    return true;
+            }
+            return false;
+        }
+
+        bool _wait( int cls, int maxWaitMillis ) {
+            unsigned long long end = curTimeMillis64() + maxWaitMillis;
+            boost::mutex::scoped_lock lk(_m);
+            // leave() decrements before checking for sleepers, we count ourselves before
+            // checking for pending requests: one of us sees the other
+            _sleepers.fetchAndAdd(1);
+            bool got = true;
+            while( _higherPending(cls) ) {
+                unsigned long long now = curTimeMillis64();
+                if( now >= end ) {
+                    got = false;
+                    break;
+                }
+                _c.timed_wait(lk, boost::posix_time::milliseconds(end - now));
+            }
+            _sleepers.fetchAndSubtract(1);
+            return got;
+        }
+
+        AtomicUInt32 _pending[NumClasses];
+        AtomicUInt32 _sleepers;
+        boost::mutex _m;
+        boost::condition _c;
+    };
+
+}
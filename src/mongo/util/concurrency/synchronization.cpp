@@ -70,11 +70,13 @@ namespace mongo {
         }
     }
 
-    void NotifyAll::notifyAll(When e) {
+    unsigned NotifyAll::notifyAll(When e) {
         scoped_lock lock( _mutex );
+        unsigned n = _nWaiting;
         _lastDone = e;
         _nWaiting = 0;
         _condition.notify_all();
+        return n;
     }
 
 } // namespace mongo
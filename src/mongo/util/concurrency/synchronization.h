@@ -68,8 +68,10 @@ namespace mongo {
         /** a bit faster than waitFor( now() ) */
         void awaitBeyondNow();
 
-        /** may be called multiple times. notifies all waiters */
-        void notifyAll(When);
+        /** may be called multiple times. notifies all waiters
+            @return the number of threads that were waiting
+        */
+        unsigned notifyAll(When);
 
         /** indicates how many threads are waiting for a notify. */
         unsigned nWaiting() const { return _nWaiting; }
@@ -17,81 +17,90 @@
 #include <boost/thread/condition_variable.hpp>
 #include <iostream>
 
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/concurrency/mutex.h"
 
 namespace mongo {
 
+    /**
+     * A counting semaphore.  Acquiring and releasing are a compare-and-swap or an atomic add;
+     * the mutex and condition are only used to park threads waiting for a ticket, and to wake
+     * them.
+     */
     class TicketHolder {
     public:
-        TicketHolder( int num ) : _mutex("TicketHolder") {
-            _outof = num;
-            _num = num;
-        }
+        TicketHolder( int num ) : _outof( num ), _num( num ), _mutex("TicketHolder") { }
 
         bool tryAcquire() {
-            scoped_lock lk( _mutex );
-            return _tryAcquire();
+            int n = _num.load();
+            while ( n > 0 ) {
+                int prev = _num.compareAndSwap( n, n - 1 );
+                if ( prev == n )
+                    return true;
+                n = prev;
+            }
+            return false;
         }
 
         void waitForTicket() {
-            scoped_lock lk( _mutex );
+            if ( tryAcquire() )
+                return;
 
-            while( ! _tryAcquire() ) {
+            scoped_lock lk( _mutex );
+            // release() adds its ticket before looking for waiters, we count ourselves before
+            // trying again: one of us sees the other
+            _waiters.fetchAndAdd( 1 );
+            while( ! tryAcquire() ) {
                 _newTicket.wait( lk.boost() );
             }
+            _waiters.fetchAndSubtract( 1 );
         }
 
         void release() {
-            {
+            _num.fetchAndAdd( 1 );
+            if ( _waiters.load() ) {
                 scoped_lock lk( _mutex );
-                _num++;
+                _newTicket.notify_one();
             }
-            _newTicket.notify_one();
         }
 
-        void resize( int newSize ) {
+        /** @return false, changing nothing, if more than newSize tickets are in use */
+        bool resize( int newSize ) {
             {
                 scoped_lock lk( _mutex );
 
-                int used = _outof - _num;
+                int used = _outof.load() - _num.load();
                 if ( used > newSize ) {
                     std::cout << "can't resize since we're using (" << used << ") more than newSize(" << newSize << ")" << std::endl;
-                    return;
+                    return false;
                 }
 
-                _outof = newSize;
-                _num = _outof - used;
+                _num.fetchAndAdd( newSize - _outof.load() );
+                _outof.store( newSize );
             }
 
             // Potentially wasteful, but easier to see is correct
             _newTicket.notify_all();
+            return true;
         }
 
         int available() const {
-            return _num;
+            return _num.load();
         }
 
         int used() const {
-            return _outof - _num;
+            return _outof.load() - _num.load();
         }
 
-        int outof() const { return _outof; }
+        int outof() const { return _outof.load(); }
 
-    private:
+        /** threads waiting in waitForTicket() */
+        int waiting() const { return _waiters.load(); }
 
-        bool _tryAcquire(){
-            if ( _num <= 0 ) {
-                if ( _num < 0 ) {
-                    std::cerr << "DISASTER! in TicketHolder" << std::endl;
-                }
-                return false;
-            }
-            _num--;
-            return true;
-        }
-
-        int _outof;
-        int _num;
+    private:
+        AtomicInt32 _outof;
+        AtomicInt32 _num;
+        AtomicInt32 _waiters;
         mongo::mutex _mutex;
         boost::condition_variable_any _newTicket;
     };
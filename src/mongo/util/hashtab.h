@@ -53,12 +53,21 @@ namespace mongo {
         void* _buf;
         int n; // number of hashtable buckets
         int maxChain;
+        // No key in use lies further than this past its bucket, so a lookup can stop there
+        // rather than at maxChain.  In memory only: set on open, raised by put(), never lowered.
+        int maxUsedChain;
 
         Node& nodes(int i) {
             Node *nodes = (Node *) _buf;
             return nodes[i];
         }
 
+        /** how far node i is from the bucket of a key with hash h */
+        int chainOf(int i, int h) const {
+            int start = h % n;
+            return i >= start ? i - start : i + n - start;
+        }
+
         int _find(const Key& k, bool& found) {
             found = false;
             int h = k.hash();
@@ -79,6 +88,10 @@ namespace mongo {
                     return i;
                 }
                 chain++;
+                // Killed nodes leave holes, so an unused node doesn't end a chain, but nothing is
+                // stored past maxUsedChain.  Misses are common and used to walk maxChain nodes.
+                if ( chain > maxUsedChain && firstNonUsed >= 0 )
+                    return firstNonUsed;
                 i = (i+1) % n;
                 if ( i == start ) {
                     // shouldn't get here / defensive for infinite loops
@@ -106,6 +119,12 @@ namespace mongo {
             _buf = buf;
             //nodes = (Node *) buf;
 
+            maxUsedChain = 0;
+            for ( int i = 0; i < n; i++ ) {
+                if ( nodes(i).inUse() )
+                    maxUsedChain = std::max( maxUsedChain, chainOf(i, nodes(i).hash) );
+            }
+
             if ( sizeof(Node) != 628 ) {
                 out() << "HashTable() " << _name << " sizeof(node):" << sizeof(Node) << " n:" << n << " sizeof(Key): " << sizeof(Key) << " sizeof(Type):" << sizeof(Type) << endl;
                 verify( sizeof(Node) == 628 );
@@ -138,6 +157,10 @@ namespace mongo {
             int i = _find(k, found);
             if ( i < 0 )
                 return false;
+            if ( !found ) {
+                // raised before the node is written, for a reader probing without a lock
+                maxUsedChain = std::max( maxUsedChain, chainOf(i, k.hash()) );
+            }
             Node* n = getDur().writing( &nodes(i) );
             if ( !found ) {
                 n->k = k;
@@ -42,6 +42,8 @@
 using namespace mongoutils;
 
 namespace mongo {
+    bool LogFile::asyncAppends = true;
+
     struct LogfileTest : public StartupTest {
         LogfileTest() { }
         void run() {
@@ -161,8 +163,30 @@ namespace mongo {
 #include <fcntl.h>
 #include "paths.h"
 
+#if defined(__linux__)
+#include <linux/aio_abi.h>
+#include <sys/syscall.h>
+#endif
+
 namespace mongo {
 
+#if defined(__linux__)
+    namespace {
+        // appends go out in chunks of this size, this many at a time
+        const size_t AioChunkSize = 256 * 1024;
+        const int AioDepth = 16;
+
+        long ioSetup(unsigned n, aio_context_t* ctx) { return syscall(SYS_io_setup, n, ctx); }
+        long ioDestroy(aio_context_t ctx) { return syscall(SYS_io_destroy, ctx); }
+        long ioSubmit(aio_context_t ctx, long n, struct iocb** cbs) {
+            return syscall(SYS_io_submit, ctx, n, cbs);
+        }
+        long ioGetEvents(aio_context_t ctx, long min, long max, struct io_event* events) {
+            return syscall(SYS_io_getevents, ctx, min, max, events, (struct timespec*) 0);
+        }
+    }
+#endif
+
     LogFile::LogFile(const std::string& name, bool readwrite) : _name(name) {
         int options = O_CREAT
                     | (readwrite?O_RDWR:O_WRONLY)
@@ -191,15 +215,93 @@ namespace mongo {
             uasserted(13516, str::stream() << "couldn't open file " << name << " for writing " << errnoWithDescription());
         }
 
+#if defined(__linux__)
+        _aio = 0;
+        if( _direct && asyncAppends ) {
+            aio_context_t ctx = 0;
+            if( ioSetup(AioDepth, &ctx) == 0 )
+                _aio = ctx;
+            else
+                LOG(1) << "io_setup failed, journal appends will be synchronous writes "
+                       << errnoWithDescription() << endl;
+        }
+#endif
+
         flushMyDirectory(name);
     }
 
     LogFile::~LogFile() {
+#if defined(__linux__)
+        if( _aio )
+            ioDestroy(_aio);
+        _aio = 0;
+#endif
         if( _fd >= 0 )
             close(_fd);
         _fd = -1;
     }
 
+#if defined(__linux__)
+    size_t LogFile::_aioWrite(const char *buf, size_t len, unsigned long long pos) {
+        size_t done = 0;
+        while( done < len ) {
+            struct iocb cbs[AioDepth];
+            struct iocb* cbp[AioDepth];
+            size_t lens[AioDepth];
+            long n = 0;
+            size_t batch = 0;
+            for( ; n < AioDepth && done + batch < len; n++ ) {
+                size_t l = std::min(AioChunkSize, len - done - batch);
+                memset(&cbs[n], 0, sizeof(cbs[n]));
+                cbs[n].aio_fildes = _fd;
+                cbs[n].aio_lio_opcode = IOCB_CMD_PWRITE;
+                cbs[n].aio_buf = reinterpret_cast<uintptr_t>(buf + done + batch);
+                cbs[n].aio_nbytes = l;
+                cbs[n].aio_offset = pos + done + batch;
+                cbp[n] = &cbs[n];
+                lens[n] = l;
+                batch += l;
+            }
+
+            long submitted = ioSubmit(_aio, n, cbp);
+            if( submitted <= 0 ) {
+                log() << "io_submit failed, journal appends will be synchronous writes "
+                      << errnoWithDescription() << endl;
+                ioDestroy(_aio);
+                _aio = 0;
+                return done;
+            }
+
+            struct io_event events[AioDepth];
+            long reaped = 0;
+            while( reaped < submitted ) {
+                long r = ioGetEvents(_aio, submitted - reaped, submitted - reaped, events + reaped);
+                if( r < 0 ) {
+                    if( errno == EINTR )
+                        continue;
+                    log() << "io_getevents failed " << errnoWithDescription() << endl;
+                    fassertFailed( 17331 );
+                }
+                reaped += r;
+            }
+            for( long i = 0; i < reaped; i++ ) {
+                struct iocb* cb = reinterpret_cast<struct iocb*>(events[i].obj);
+                if( events[i].res < 0 || (size_t) events[i].res != cb->aio_nbytes ) {
+                    log() << "LogFile async append failed with " << cb->aio_nbytes
+                          << " bytes at offset " << cb->aio_offset << " result " << events[i].res
+                          << std::endl;
+                    fassertFailed( 17332 );
+                }
+            }
+
+            // chunks are handed out in order, so a partial submit wrote a prefix
+            for( long i = 0; i < submitted; i++ )
+                done += lens[i];
+        }
+        return done;
+    }
+#endif
+
     void LogFile::truncate() {
         verify(_fd >= 0);
 
@@ -240,10 +342,21 @@ namespace mongo {
         fassert( 16142, _fd >= 0 );
         fassert( 16143, reinterpret_cast<ssize_t>( buf ) % g_minOSPageSizeBytes == 0 );  // aligned
 
-#ifdef POSIX_FADV_DONTNEED
+#if defined(POSIX_FADV_DONTNEED) || defined(__linux__)
         const off_t pos = lseek(_fd, 0, SEEK_CUR); // doesn't actually seek, just get current position
 #endif
 
+#if defined(__linux__)
+        if( _aio ) {
+            size_t written = _aioWrite(buf, len, pos);
+            buf += written;
+            charsToWrite -= written;
+            // keep the file position where write() would have left it, for the next append
+            // and for truncate()
+            lseek(_fd, pos + written, SEEK_SET);
+        }
+#endif
+
         while ( charsToWrite > 0 ) {
             const ssize_t written = write( _fd, buf, static_cast<size_t>( charsToWrite ) );
             if ( -1 == written ) {
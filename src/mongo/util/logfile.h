@@ -57,6 +57,12 @@ namespace mongo {
 
         void truncate(); // Removes extra data after current position
 
+        /** on linux with direct i/o, split each append into chunks submitted together with
+            io_submit, so the device has several writes in flight rather than one at a time.
+            set before files are opened.
+        */
+        static bool asyncAppends;
+
     private:
 #if defined(_WIN32)
         typedef HANDLE fd_type;
@@ -65,6 +71,11 @@ namespace mongo {
 #endif
         fd_type _fd;
         bool _direct; // are we using direct I/O
+#if defined(__linux__)
+        unsigned long _aio; // aio_context_t, 0 when appends are plain writes
+        /** @return bytes written from the start of buf, all of len unless submitting failed */
+        size_t _aioWrite(const char *buf, size_t len, unsigned long long pos);
+#endif
     };
 
 }
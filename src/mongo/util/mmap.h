@@ -221,6 +221,13 @@ namespace mongo {
 
         /** close the current private view and open a new replacement */
         void* remapPrivateView(void *oldPrivateAddr);
+
+#if !defined(_WIN32) && !defined(__sunos__)
+        /** replace just [ofs, ofs+len) of the private view, which must be page aligned, with
+            the file's current contents.  atomic, so needs no lock on the files.
+        */
+        void remapPrivateViewRange(void *privateAddr, size_t ofs, size_t len);
+#endif
     };
 
     /** p is called from within a mutex that MongoFile uses.  so be careful not to deadlock. */
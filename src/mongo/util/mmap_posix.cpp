@@ -195,6 +195,22 @@ namespace mongo {
         return x;
     }
 
+#if !defined(__sunos__)
+    void MemoryMappedFile::remapPrivateViewRange(void *privateAddr, size_t ofs, size_t rangeLen) {
+        void *addr = static_cast<char*>(privateAddr) + ofs;
+        void *x = mmap( addr, rangeLen, PROT_READ|PROT_WRITE,
+                        MAP_PRIVATE|MAP_NORESERVE|MAP_FIXED, fd, ofs );
+        if( x == MAP_FAILED ) {
+            int err = errno;
+            error()  << "17333 Couldn't remap private view range: " << errnoWithDescription(err) << endl;
+            log() << "aborting" << endl;
+            printMemInfo();
+            abort();
+        }
+        verify( x == addr );
+    }
+#endif
+
     void MemoryMappedFile::flush(bool sync) {
         if ( views.empty() || fd == 0 )
             return;
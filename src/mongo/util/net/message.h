@@ -20,6 +20,7 @@
 #include <vector>
 
 #include "mongo/bson/util/atomic_int.h"
+#include "mongo/bson/util/builder.h"
 #include "mongo/util/goodies.h"
 #include "mongo/util/net/hostandport.h"
 #include "mongo/util/net/sock.h"
@@ -46,7 +47,8 @@ namespace mongo {
         dbQuery = 2004,
         dbGetMore = 2005,
         dbDelete = 2006,
-        dbKillCursors = 2007
+        dbKillCursors = 2007,
+        dbCompressed = 2012 /* another message, compressed.  see message_compression.h */
     };
 
     bool doesOpGetAResponse( int op );
@@ -62,6 +64,7 @@ namespace mongo {
         case dbGetMore: return "getmore";
         case dbDelete: return "remove";
         case dbKillCursors: return "killcursors";
+        case dbCompressed: return "compressed";
         default:
             massert( 16141, str::stream() << "cannot translate opcode " << op, !op );
             return "";
@@ -77,6 +80,7 @@ namespace mongo {
         case dbQuery:
         case dbGetMore:
         case dbKillCursors:
+        case dbCompressed:
             return false;
 
         case dbUpdate:
@@ -292,6 +296,26 @@ namespace mongo {
         }
 
         void send( MessagingPort &p, const char *context );
+
+        /** appends the buffers send() writes, in order, without copying them */
+        void appendBuffers( std::vector< std::pair< char*, int > >& v ) const {
+            if ( _buf ) {
+                v.push_back( std::make_pair( reinterpret_cast<char*>( _buf ), _buf->len ) );
+                return;
+            }
+            v.insert( v.end(), _data.begin(), _data.end() );
+        }
+
+        /** appends the bytes send() would write, for callers that do their own socket writes */
+        void appendTo( BufBuilder& b ) const {
+            if ( _buf ) {
+                b.appendBuf( _buf, _buf->len );
+                return;
+            }
+            for (MsgVec::const_iterator i = _data.begin(); i != _data.end(); ++i) {
+                b.appendBuf( i->first, i->second );
+            }
+        }
         
         string toString() const;
 
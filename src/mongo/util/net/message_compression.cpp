@@ -0,0 +1,202 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/pch.h"
+
+#include "mongo/util/net/message_compression.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/compress.h"
+#include "mongo/util/net/message_port.h"
+
+namespace mongo {
+
+    bool messageCompressionEnabled = false;
+
+    namespace {
+
+        // opcode, uncompressed body length, compressor id
+        const int CompressedPrefixBytes = sizeof(MSGHEADER) + 4 + 4 + 1;
+
+        // smaller messages don't shrink enough to pay for the work
+        const int MinCompressibleBodyBytes = 1024;
+
+        AtomicUInt64 messagesOut;
+        AtomicUInt64 bytesOutUncompressed;
+        AtomicUInt64 bytesOutCompressed;
+        AtomicUInt64 messagesIn;
+        AtomicUInt64 bytesInUncompressed;
+        AtomicUInt64 bytesInCompressed;
+
+    } // namespace
+
+    bool compressMessage( const Message& m, Message& compressed ) {
+        verify( compressed.empty() );
+        if ( m.operation() == dbCompressed )
+            return false;
+        int bodyLen = m.size() - sizeof(MSGHEADER);
+        if ( bodyLen < MinCompressibleBodyBytes )
+            return false;
+
+        // snappy wants the input in one piece
+        vector< pair<char*, int> > pieces;
+        m.appendBuffers( pieces );
+        BufBuilder whole;
+        const char* src = pieces[0].first;
+        if ( pieces.size() > 1 ) {
+            m.appendTo( whole );
+            src = whole.buf();
+        }
+        const MSGHEADER* header = reinterpret_cast<const MSGHEADER*>( src );
+
+        char* buf = static_cast<char*>( malloc( CompressedPrefixBytes +
+                                                maxCompressedLength( bodyLen ) ) );
+        verify( buf );
+        size_t outLen;
+        rawCompress( src + sizeof(MSGHEADER), bodyLen, buf + CompressedPrefixBytes, &outLen );
+        int total = CompressedPrefixBytes + outLen;
+        if ( total > m.size() - m.size() / 8 ) {
+            free( buf );
+            return false;
+        }
+
+        MSGHEADER* out = reinterpret_cast<MSGHEADER*>( buf );
+        out->messageLength = total;
+        out->requestID = header->requestID;
+        out->responseTo = header->responseTo;
+        out->opCode = dbCompressed;
+        char* p = buf + sizeof(MSGHEADER);
+        memcpy( p, &header->opCode, 4 );
+        memcpy( p + 4, &bodyLen, 4 );
+        p[8] = MessageCompressorSnappy;
+        compressed.setData( reinterpret_cast<MsgData*>( buf ), true );
+
+        messagesOut.fetchAndAdd( 1 );
+        bytesOutUncompressed.fetchAndAdd( m.size() );
+        bytesOutCompressed.fetchAndAdd( total );
+        return true;
+    }
+
+    void decompressMessage( Message& m ) {
+        if ( m.empty() || m.operation() != dbCompressed )
+            return;
+
+        const char* src = reinterpret_cast<const char*>( m.singleData() );
+        int len = m.size();
+        uassert( 17350, "compressed message too short", len >= CompressedPrefixBytes );
+        int opCode;
+        int bodyLen;
+        memcpy( &opCode, src + sizeof(MSGHEADER), 4 );
+        memcpy( &bodyLen, src + sizeof(MSGHEADER) + 4, 4 );
+        char compressor = src[ sizeof(MSGHEADER) + 8 ];
+        uassert( 17351, str::stream() << "unknown message compressor " << int(compressor),
+                 compressor == MessageCompressorSnappy );
+        uassert( 17352, str::stream() << "invalid uncompressed message length " << bodyLen,
+                 bodyLen >= 0 &&
+                 bodyLen + static_cast<int>(sizeof(MSGHEADER)) <= MaxMessageSizeBytes );
+
+        const char* compressedBody = src + CompressedPrefixBytes;
+        size_t compressedLen = len - CompressedPrefixBytes;
+        size_t expected;
+        uassert( 17353, "malformed compressed message",
+                 uncompressedLength( compressedBody, compressedLen, &expected ) &&
+                 expected == static_cast<size_t>( bodyLen ) );
+
+        int total = sizeof(MSGHEADER) + bodyLen;
+        // same rounding as MessagingPort::recv
+        char* buf = static_cast<char*>( malloc( (total+1023)&0xfffffc00 ) );
+        verify( buf );
+        if ( ! rawUncompress( compressedBody, compressedLen, buf + sizeof(MSGHEADER) ) ) {
+            free( buf );
+            uasserted( 17354, "malformed compressed message" );
+        }
+
+        const MSGHEADER* header = reinterpret_cast<const MSGHEADER*>( src );
+        MSGHEADER* out = reinterpret_cast<MSGHEADER*>( buf );
+        out->messageLength = total;
+        out->requestID = header->requestID;
+        out->responseTo = header->responseTo;
+        out->opCode = opCode;
+
+        messagesIn.fetchAndAdd( 1 );
+        bytesInCompressed.fetchAndAdd( len );
+        bytesInUncompressed.fetchAndAdd( total );
+
+        m.reset();
+        m.setData( reinterpret_cast<MsgData*>( buf ), true );
+    }
+
+    void negotiateMessageCompression( const BSONObj& cmdObj,
+                                      AbstractMessagingPort* port,
+                                      BSONObjBuilder& result ) {
+        BSONElement requested = cmdObj["compression"];
+        if ( ! messageCompressionEnabled || ! port || requested.type() != Array )
+            return;
+
+        BSONForEach( e, requested.Obj() ) {
+            if ( e.type() == String && str::equals( e.valuestr(), "snappy" ) ) {
+                result.append( "compression", BSON_ARRAY( "snappy" ) );
+                // the reply to this still has to go out as the client expects it
+                port->startCompressing( true );
+                return;
+            }
+        }
+    }
+
+    void appendMessageCompressionRequest( BSONObjBuilder& b ) {
+        b.append( "compression", BSON_ARRAY( "snappy" ) );
+    }
+
+    bool messageCompressionAccepted( const BSONObj& isMasterReply ) {
+        BSONElement agreed = isMasterReply["compression"];
+        if ( agreed.type() != Array )
+            return false;
+        BSONForEach( e, agreed.Obj() ) {
+            if ( e.type() == String && str::equals( e.valuestr(), "snappy" ) )
+                return true;
+        }
+        return false;
+    }
+
+    void appendMessageCompressionStats( BSONObjBuilder& b ) {
+        BSONObjBuilder c( b.subobjStart( "compression" ) );
+        c.appendNumber( "messagesOut", static_cast<long long>( messagesOut.load() ) );
+        c.appendNumber( "bytesOutUncompressed",
+                        static_cast<long long>( bytesOutUncompressed.load() ) );
+        c.appendNumber( "bytesOutCompressed",
+                        static_cast<long long>( bytesOutCompressed.load() ) );
+        c.appendNumber( "messagesIn", static_cast<long long>( messagesIn.load() ) );
+        c.appendNumber( "bytesInCompressed", static_cast<long long>( bytesInCompressed.load() ) );
+        c.appendNumber( "bytesInUncompressed",
+                        static_cast<long long>( bytesInUncompressed.load() ) );
+        c.done();
+    }
+
+} // namespace mongo
@@ -0,0 +1,85 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#pragma once
+
+#include "mongo/util/net/message.h"
+
+namespace mongo {
+
+    class BSONObj;
+    class BSONObjBuilder;
+    class AbstractMessagingPort;
+
+    /**
+     * Messages on the wire may be wrapped in a dbCompressed message once both ends have agreed to
+     * it.  Its body is the wrapped message's opcode, the length of its body uncompressed and a
+     * compressor id, all little endian, followed by the wrapped body compressed.  Its id and
+     * responseTo are those of the wrapped message.
+     *
+     * The client end asks for it with compression: ["snappy"] in the isMaster it sends right after
+     * connecting, and the server agrees by listing snappy in its reply.  Each end compresses
+     * only what it sends after that.
+     */
+
+    /** whether this process offers or agrees to compression; networkMessageCompression sets it */
+    extern bool messageCompressionEnabled;
+
+    /** the compressors this build understands */
+    enum MessageCompressorId {
+        MessageCompressorSnappy = 1
+    };
+
+    /** fills compressed with m wrapped, and returns true, if that shrinks m enough to pay */
+    bool compressMessage( const Message& m, Message& compressed );
+
+    /**
+     * If m is a dbCompressed message, replaces it with the message it wraps.  uasserts if m can't
+     * be decompressed.
+     */
+    void decompressMessage( Message& m );
+
+    /**
+     * For the server's isMaster: if the client asked for compression and it's enabled here, says
+     * so in result and starts compressing what the port sends after the reply.
+     */
+    void negotiateMessageCompression( const BSONObj& cmdObj,
+                                      AbstractMessagingPort* port,
+                                      BSONObjBuilder& result );
+
+    /** adds the isMaster field a client uses to ask for compression */
+    void appendMessageCompressionRequest( BSONObjBuilder& b );
+
+    /** whether an isMaster reply agreed to the compression a client asked for */
+    bool messageCompressionAccepted( const BSONObj& isMasterReply );
+
+    /** bytes sent and received compressed, before and after, for serverStatus */
+    void appendMessageCompressionStats( BSONObjBuilder& b );
+
+} // namespace mongo
@@ -0,0 +1,133 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/net/message_compression.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+
+    namespace {
+
+        /** a message with a body of n repetitive bytes */
+        void makeMessage( Message& m, int n ) {
+            string body;
+            while ( static_cast<int>( body.size() ) < n )
+                body += "a fairly repetitive body; ";
+            body.resize( n );
+            m.setData( dbQuery, body.data(), body.size() );
+            m.header()->id = 1234;
+            m.header()->responseTo = 99;
+        }
+
+        class CompressionEnabled {
+        public:
+            CompressionEnabled() : _old( messageCompressionEnabled ) {
+                messageCompressionEnabled = true;
+            }
+            ~CompressionEnabled() { messageCompressionEnabled = _old; }
+        private:
+            bool _old;
+        };
+
+        TEST(MessageCompression, RoundTrip) {
+            Message m;
+            makeMessage( m, 100000 );
+
+            Message compressed;
+            ASSERT( compressMessage( m, compressed ) );
+            ASSERT_EQUALS( dbCompressed, compressed.operation() );
+            ASSERT_LESS_THAN( compressed.size(), m.size() / 2 );
+            ASSERT_EQUALS( 1234, compressed.header()->id );
+            ASSERT_EQUALS( 99, compressed.header()->responseTo );
+
+            decompressMessage( compressed );
+            ASSERT_EQUALS( dbQuery, compressed.operation() );
+            ASSERT_EQUALS( m.size(), compressed.size() );
+            ASSERT_EQUALS( 1234, compressed.header()->id );
+            ASSERT_EQUALS( 99, compressed.header()->responseTo );
+            ASSERT_EQUALS( 0, memcmp( m.singleData(), compressed.singleData(), m.size() ) );
+        }
+
+        TEST(MessageCompression, MultipleBuffers) {
+            Message m;
+            makeMessage( m, 4000 );
+            char* more = static_cast<char*>( malloc( 4000 ) );
+            memset( more, 'x', 4000 );
+            m.appendData( more, 4000 );
+
+            Message compressed;
+            ASSERT( compressMessage( m, compressed ) );
+            decompressMessage( compressed );
+            ASSERT_EQUALS( m.size(), compressed.size() );
+            ASSERT_EQUALS( 'x', reinterpret_cast<char*>( compressed.singleData() )[ m.size() - 1 ] );
+        }
+
+        TEST(MessageCompression, SmallMessagesAreLeftAlone) {
+            Message m;
+            makeMessage( m, 100 );
+            Message compressed;
+            ASSERT( ! compressMessage( m, compressed ) );
+            ASSERT( compressed.empty() );
+
+            // and decompressing anything else is a no-op
+            decompressMessage( m );
+            ASSERT_EQUALS( dbQuery, m.operation() );
+        }
+
+        TEST(MessageCompression, RejectsUnknownCompressor) {
+            Message m;
+            makeMessage( m, 100000 );
+            Message compressed;
+            ASSERT( compressMessage( m, compressed ) );
+            reinterpret_cast<char*>( compressed.singleData() )[ sizeof(MSGHEADER) + 8 ] = 42;
+            ASSERT_THROWS( decompressMessage( compressed ), UserException );
+        }
+
+        TEST(MessageCompression, Negotiation) {
+            CompressionEnabled enabled;
+            BSONObjBuilder request;
+            request.append( "isMaster", 1 );
+            appendMessageCompressionRequest( request );
+            ASSERT( ! messageCompressionAccepted( BSON( "ismaster" << true ) ) );
+            ASSERT( messageCompressionAccepted( BSON( "compression" << BSON_ARRAY( "snappy" ) ) ) );
+            ASSERT( ! messageCompressionAccepted( BSON( "compression" << BSON_ARRAY( "zip" ) ) ) );
+
+            // without a port, the server doesn't agree
+            BSONObjBuilder result;
+            negotiateMessageCompression( request.obj(), NULL, result );
+            ASSERT( ! messageCompressionAccepted( result.obj() ) );
+        }
+
+    } // namespace
+
+} // namespace mongo
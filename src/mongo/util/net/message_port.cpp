@@ -26,6 +26,8 @@
 #include "mongo/util/goodies.h"
 #include "mongo/util/net/listen.h"
 #include "mongo/util/net/message.h"
+#include "mongo/util/net/message_compression.h"
+#include "mongo/util/net/socket_poll.h"
 #include "mongo/util/net/ssl_manager.h"
 #include "mongo/util/net/ssl_options.h"
 #include "mongo/util/scopeguard.h"
@@ -125,18 +127,18 @@ namespace mongo {
     }
 
     MessagingPort::MessagingPort(int fd, const SockAddr& remote) 
-        : psock( new Socket( fd , remote ) ) , piggyBackData(0) {
+        : psock( new Socket( fd , remote ) ) , _recvStart(0), _recvEnd(0), piggyBackData(0) {
         ports.insert(this);
     }
 
     MessagingPort::MessagingPort( double timeout, logger::LogSeverity ll ) 
-        : psock( new Socket( timeout, ll ) ) {
+        : psock( new Socket( timeout, ll ) ), _recvStart(0), _recvEnd(0) {
         ports.insert(this);
         piggyBackData = 0;
     }
 
     MessagingPort::MessagingPort( boost::shared_ptr<Socket> sock )
-        : psock( sock ), piggyBackData( 0 ) {
+        : psock( sock ), _recvStart( 0 ), _recvEnd( 0 ), piggyBackData( 0 ) {
         ports.insert(this);
     }
 
@@ -155,13 +157,45 @@ namespace mongo {
         ports.erase(this);
     }
     
+    void MessagingPort::recvBuffered( char* buf, int len ) {
+        int buffered = _recvEnd - _recvStart;
+        if ( buffered > 0 ) {
+            int n = std::min( len, buffered );
+            memcpy( buf, _recvBuf.get() + _recvStart, n );
+            _recvStart += n;
+            buf += n;
+            len -= n;
+        }
+        if ( len == 0 )
+            return;
+
+        _recvStart = _recvEnd = 0;
+        if ( len >= RecvBufferSize ) {
+            // big enough that copying costs more than the syscall it would save
+            psock->recv( buf, len );
+            return;
+        }
+        if ( ! _recvBuf )
+            _recvBuf.reset( new char[RecvBufferSize] );
+        while ( _recvEnd < len )
+            _recvEnd += psock->unsafe_recv( _recvBuf.get() + _recvEnd, RecvBufferSize - _recvEnd );
+        memcpy( buf, _recvBuf.get(), len );
+        _recvStart = len;
+    }
+
     bool MessagingPort::recv(Message& m) {
         try {
 again:
             //mmm( log() << "*  recv() sock:" << this->sock << endl; )
+            // Nothing is read ahead until the handshake is in: the SSL handshake needs the
+            // socket to itself, and the reactor goes back to reading the socket directly.
+            const bool readAhead = ! psock->isAwaitingHandshake();
             MSGHEADER header;
             int headerLen = sizeof(MSGHEADER);
-            psock->recv( (char *)&header, headerLen );
+            if ( readAhead )
+                recvBuffered( (char *)&header, headerLen );
+            else
+                psock->recv( (char *)&header, headerLen );
             int len = header.messageLength; 
 
             if ( len == 542393671 ) {
@@ -218,10 +252,14 @@ again:
             memcpy(md, &header, headerLen);
             int left = len - headerLen;
 
-            psock->recv( (char *)&md->_data, left );
+            if ( readAhead )
+                recvBuffered( (char *)&md->_data, left );
+            else
+                psock->recv( (char *)&md->_data, left );
 
             guard.Dismiss();
             m.setData(md, true);
+            decompressMessage(m);
             return true;
 
         }
@@ -243,6 +281,26 @@ again:
         say(/*received.from, */response, responseTo);
     }
 
+    void AbstractMessagingPort::startCompressing( bool afterNextSend ) {
+        _compression = afterNextSend ? CompressionAfterNextSend : CompressionOn;
+    }
+
+    Message& AbstractMessagingPort::prepareToSend( Message& m, Message& compressed ) {
+        if ( _compression == CompressionAfterNextSend ) {
+            _compression = CompressionOn;
+            return m;
+        }
+        if ( _compression == CompressionOn && compressMessage( m, compressed ) )
+            return compressed;
+        return m;
+    }
+
+    MSGID AbstractMessagingPort::replyReleasing(Message& received, Message& response,
+                                                MSGID responseTo) {
+        reply(received, response, responseTo);
+        return response.header()->id;
+    }
+
     bool MessagingPort::call(Message& toSend, Message& response) {
         mmm( log() << "*call()" << endl; )
         say(toSend);
@@ -273,26 +331,56 @@ again:
         return true;
     }
 
+    int MessagingPort::waitForInput( const vector<MessagingPort*>& ports, int timeoutMillis ) {
+        for ( size_t i = 0; i < ports.size(); i++ ) {
+            if ( ports[i]->hasBufferedInput() )
+                return i;
+        }
+
+        if ( ! isPollSupported() )
+            return -1;
+
+        vector<pollfd> pollInfo( ports.size() );
+        for ( size_t i = 0; i < ports.size(); i++ ) {
+            pollInfo[i].fd = ports[i]->psock->rawFD();
+            pollInfo[i].events = POLLIN;
+            pollInfo[i].revents = 0;
+        }
+
+        int nEvents = socketPoll( &pollInfo[0], pollInfo.size(), timeoutMillis );
+        if ( nEvents <= 0 )
+            return -1;
+
+        for ( size_t i = 0; i < pollInfo.size(); i++ ) {
+            if ( pollInfo[i].revents )
+                return i;
+        }
+        return -1;
+    }
+
     void MessagingPort::say(Message& toSend, int responseTo) {
         verify( !toSend.empty() );
         mmm( log() << "*  say()  thr:" << GetCurrentThreadId() << endl; )
         toSend.header()->id = nextMessageId();
         toSend.header()->responseTo = responseTo;
 
+        Message compressed;
+        Message& out = prepareToSend( toSend, compressed );
+
         if ( piggyBackData && piggyBackData->len() ) {
             mmm( log() << "*     have piggy back" << endl; )
-            if ( ( piggyBackData->len() + toSend.header()->len ) > 1300 ) {
+            if ( ( piggyBackData->len() + out.header()->len ) > 1300 ) {
                 // won't fit in a packet - so just send it off
                 piggyBackData->flush();
             }
             else {
-                piggyBackData->append( toSend );
+                piggyBackData->append( out );
                 piggyBackData->flush();
                 return;
             }
         }
 
-        toSend.send( *this, "say" );
+        out.send( *this, "say" );
     }
 
     void MessagingPort::piggyBack( Message& toSend , int responseTo ) {
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <boost/scoped_array.hpp>
 #include <vector>
 
 #include "mongo/util/net/message.h"
@@ -31,11 +32,18 @@ namespace mongo {
 
     class AbstractMessagingPort : boost::noncopyable {
     public:
-        AbstractMessagingPort() : tag(0), _connectionId(0) {}
+        AbstractMessagingPort() : tag(0), _connectionId(0), _compression(CompressionOff) {}
         virtual ~AbstractMessagingPort() { }
         virtual void reply(Message& received, Message& response, MSGID responseTo) = 0; // like the reply below, but doesn't rely on received.data still being available
         virtual void reply(Message& received, Message& response) = 0;
 
+        /**
+         * Like reply(), but the port may keep response's buffers to send later rather than copy
+         * them, leaving response empty.
+         * @return the id the reply went out with
+         */
+        virtual MSGID replyReleasing(Message& received, Message& response, MSGID responseTo);
+
         virtual HostAndPort remote() const = 0;
         virtual unsigned remotePort() const = 0;
         virtual SockAddr remoteAddr() const = 0;
@@ -52,15 +60,28 @@ namespace mongo {
         long long connectionId() const { return _connectionId; }
         void setConnectionId( long long connectionId );
 
+        /**
+         * Compresses what this port sends from now on, where it pays; see message_compression.h.
+         * With afterNextSend the next message still goes out uncompressed.
+         */
+        void startCompressing( bool afterNextSend );
+
     public:
         // TODO make this private with some helpers
 
         /* ports can be tagged with various classes.  see closeAllSockets(tag). defaults to 0. */
         unsigned tag;
 
+    protected:
+        /** @return m, or compressed after filling it with m compressed */
+        Message& prepareToSend( Message& m, Message& compressed );
+
     private:
         long long _connectionId;
         std::string _x509SubjectName;
+
+        enum Compression { CompressionOff, CompressionAfterNextSend, CompressionOn };
+        Compression _compression;
     };
 
     class MessagingPort : public AbstractMessagingPort {
@@ -102,6 +123,17 @@ namespace mongo {
          */
         bool recv( const Message& sent , Message& response );
 
+        /** @return true if recv() already holds bytes read off the socket past the last message */
+        bool hasBufferedInput() const { return _recvEnd > _recvStart; }
+
+        /**
+         * Waits up to timeoutMillis, or for ever if it is negative, for one of ports to have
+         * something for recv().  A closed or failed socket counts, so that recv() reports it.
+         * @return the index of the first port that does, or -1 if none did in time or poll()
+         *     isn't available
+         */
+        static int waitForInput( const vector<MessagingPort*>& ports, int timeoutMillis );
+
         void piggyBack( Message& toSend , int responseTo = 0 );
 
         unsigned remotePort() const { return psock->remotePort(); }
@@ -140,7 +172,18 @@ namespace mongo {
         }
 
     private:
-        
+        /**
+         * Fills buf with the next len bytes of the stream. Small reads take whatever the socket
+         * has, up to RecvBufferSize, so the header, body and any pipelined messages behind them
+         * come in with one recv() call.
+         */
+        void recvBuffered( char* buf, int len );
+
+        enum { RecvBufferSize = 16 * 1024 };
+        boost::scoped_array<char> _recvBuf; // allocated on first use
+        int _recvStart;
+        int _recvEnd;
+
         PiggyBackData * piggyBackData;
 
         // this is the parsed version of remote
@@ -28,6 +28,21 @@ namespace mongo {
 
     struct LastError;
 
+    /**
+     * The thread local state a handler's connected() set up for a connection, taken off the
+     * thread so that the connection's later messages can be processed on other threads.
+     */
+    class ConnectionThreadState {
+    public:
+        virtual ~ConnectionThreadState() {}
+
+        /** puts the state on the calling thread, which must have none of its own */
+        virtual void attach() = 0;
+
+        /** takes the state back off the calling thread */
+        virtual void detach() = 0;
+    };
+
     class MessageHandler {
     public:
         virtual ~MessageHandler() {}
@@ -47,6 +62,17 @@ namespace mongo {
          * called once when a socket is disconnected
          */
         virtual void disconnected( AbstractMessagingPort* p ) = 0;
+
+        /**
+         * Servers that don't give each connection a thread of its own call this on the thread
+         * that ran connected(), and attach the result around each later call.  Deleting it
+         * frees what connected() set up.  The default, NULL, means the handler needs a thread
+         * per connection.
+         */
+        virtual ConnectionThreadState* detachThreadState() { return NULL; }
+
+        /** whether detachThreadState() is supported */
+        virtual bool canDetachThreadState() const { return false; }
     };
 
     class MessageServer {
@@ -64,6 +90,16 @@ namespace mongo {
         virtual void setupSockets() = 0;
     };
 
-    // TODO use a factory here to decide between port and asio variations
+    /**
+     * With the asyncNetworking startup parameter set, and a handler that can detach its thread
+     * state, this is an epoll reactor that hands messages to a pool of workers (linux only).
+     * Otherwise each connection gets its own thread.
+     */
     MessageServer * createServer( const MessageServer::Options& opts , MessageHandler * handler );
+
+#ifdef __linux__
+    MessageServer * createReactorServer( const MessageServer::Options& opts ,
+                                         MessageHandler * handler ,
+                                         int workers );
+#endif
 }
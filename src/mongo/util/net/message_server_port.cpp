@@ -23,11 +23,13 @@
 
 
 #include "mongo/db/lasterror.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/util/concurrency/thread_name.h"
 #include "mongo/util/net/listen.h"
 #include "mongo/util/net/message.h"
+#include "mongo/util/net/message_compression.h"
 #include "mongo/util/net/message_port.h"
 #include "mongo/util/net/message_server.h"
 #include "mongo/util/net/ssl_manager.h"
@@ -38,6 +40,15 @@
 
 namespace mongo {
 
+    // opt in to the reactor server; see createServer()
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(asyncNetworking, bool, false);
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(asyncNetworkingWorkers, int, 64);
+
+    // offer and accept compressed messages, see message_compression.h
+    ExportedServerParameter<bool> networkMessageCompressionParameter(
+            ServerParameterSet::getGlobal(), "networkMessageCompression",
+            &messageCompressionEnabled, true, false );
+
     class PortMessageServer : public MessageServer , public Listener {
     public:
         /**
@@ -245,6 +256,16 @@ namespace mongo {
 
 
     MessageServer * createServer( const MessageServer::Options& opts , MessageHandler * handler ) {
+#ifdef __linux__
+        if ( asyncNetworking && handler->canDetachThreadState() ) {
+            int workers = std::max( 1, asyncNetworkingWorkers );
+            log() << "processing messages on " << workers << " worker threads" << endl;
+            return createReactorServer( opts , handler , workers );
+        }
+#endif
+        if ( asyncNetworking )
+            warning() << "asyncNetworking is not supported here, using a thread per connection"
+                      << endl;
         return new PortMessageServer( opts , handler );
     }
 
@@ -0,0 +1,622 @@
+// message_server_reactor.cpp
+
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ * A message server that doesn't tie up a thread per connection: one reactor thread waits on
+ * every idle connection with epoll and reads their messages without blocking, and a fixed pool
+ * of workers processes them.  A worker buffers the replies it makes and hands the connection
+ * back, and the reactor writes them out before it reads the connection's next message, so a
+ * connection has at most one message in flight just as with a thread of its own.
+ *
+ * The first message of a connection, which may be an http probe, an endian check or an SSL
+ * handshake, is read by the worker with the usual blocking MessagingPort::recv, as is every
+ * message on a connection that went on to use SSL.
+ */
+
+#include "mongo/pch.h"
+
+#ifdef __linux__
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include <boost/thread/thread.hpp>
+
+#include "mongo/db/lasterror.h"
+#include "mongo/db/stats/counters.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/concurrency/ticketholder.h"
+#include "mongo/util/net/listen.h"
+#include "mongo/util/net/message.h"
+#include "mongo/util/net/message_compression.h"
+#include "mongo/util/net/message_port.h"
+#include "mongo/util/net/message_server.h"
+#include "mongo/util/net/ssl_manager.h"
+
+namespace mongo {
+
+    namespace {
+
+        // replies beyond this are written by the worker itself rather than queued, which
+        // bounds the memory an exhaust cursor or a burst of large replies can hold
+        const int MaxBufferedReplyBytes = 4 * 1024 * 1024;
+
+        class ReactorConnection;
+
+        /**
+         * Replies are queued on the connection for the reactor to write.  replyReleasing()
+         * queues the reply's own buffers, so they go from there to the socket with one
+         * scatter/gather send and no copy.
+         */
+        class ReactorPort : public MessagingPort {
+        public:
+            ReactorPort( boost::shared_ptr<Socket> socket, ReactorConnection* conn ) :
+                MessagingPort( socket ), _conn( conn ) {
+            }
+
+            virtual void reply( Message& received, Message& response, MSGID responseTo );
+
+            virtual void reply( Message& received, Message& response ) {
+                reply( received, response, received.header()->id );
+            }
+
+            virtual MSGID replyReleasing( Message& received, Message& response,
+                                          MSGID responseTo );
+
+        private:
+            /** sets the reply's ids, and queues it, or sends it now if it can't be queued */
+            MSGID queueOrSend( Message& response, MSGID responseTo, bool releasing );
+
+            ReactorConnection* _conn;
+        };
+
+        /**
+         * At any time a connection belongs either to the reactor or to exactly one worker, and
+         * only its owner touches it; ownership passes through the server's queues.
+         */
+        class ReactorConnection : boost::noncopyable {
+        public:
+            ReactorConnection( boost::shared_ptr<Socket> socket, long long connectionId ) :
+                port( socket, this ),
+                le( new LastError() ),
+                connected( false ),
+                closing( false ),
+                registered( false ),
+                headerBytes( 0 ),
+                partial( 0 ),
+                partialBytes( 0 ),
+                outOffset( 0 ),
+                outBytes( 0 ) {
+                port.setConnectionId( connectionId );
+                port.psock->setLogLevel( logger::LogSeverity::Debug(1) );
+                threadName = str::stream() << "conn" << connectionId;
+                otherSide = port.psock->remoteString();
+            }
+
+            ~ReactorConnection() {
+                threadState.reset();
+                delete le;
+                if ( partial )
+                    free( partial );
+                clearReplies();
+            }
+
+            int fd() const { return port.psock->rawFD(); }
+
+            /** raw reads and writes won't do until the handshake is in and if SSL is on */
+            bool needsBlockingIO() { return port.psock->isAwaitingHandshake() ||
+                                            port.psock->isSecure(); }
+
+            bool hasOutput() const { return ! replies.empty(); }
+
+            /** takes response, which must own its buffers */
+            void queueReply( Message& response ) {
+                Message* r = new Message();
+                *r = response;
+                replies.push_back( r );
+                outBytes += r->size();
+            }
+
+            /** the unwritten parts of the queued replies, up to max pieces */
+            void gatherReplies( vector< pair<char*, int> >& pieces, unsigned max ) const {
+                for ( unsigned i = 0; i < replies.size() && pieces.size() < max; i++ ) {
+                    unsigned first = pieces.size();
+                    replies[i]->appendBuffers( pieces );
+                    // skip what's already written of the oldest
+                    for ( int skip = ( i == 0 ? outOffset : 0 ); skip > 0; ) {
+                        int n = std::min( skip, pieces[first].second );
+                        pieces[first].first += n;
+                        pieces[first].second -= n;
+                        skip -= n;
+                        if ( pieces[first].second == 0 )
+                            pieces.erase( pieces.begin() + first );
+                    }
+                }
+                if ( pieces.size() > max )
+                    pieces.resize( max );
+            }
+
+            /** notes that n more bytes of the queued replies were written */
+            void consumeReplies( int n ) {
+                outBytes -= n;
+                while ( n > 0 ) {
+                    int left = replies.front()->size() - outOffset;
+                    if ( n < left ) {
+                        outOffset += n;
+                        return;
+                    }
+                    n -= left;
+                    delete replies.front();
+                    replies.pop_front();
+                    outOffset = 0;
+                }
+            }
+
+            void clearReplies() {
+                for ( unsigned i = 0; i < replies.size(); i++ )
+                    delete replies[i];
+                replies.clear();
+                outOffset = 0;
+                outBytes = 0;
+            }
+
+            void flushInline() {
+                if ( hasOutput() ) {
+                    vector< pair<char*, int> > pieces;
+                    gatherReplies( pieces, std::numeric_limits<unsigned>::max() );
+                    port.psock->send( pieces, "reply" );
+                }
+                clearReplies();
+            }
+
+            ReactorPort port;
+            scoped_ptr<ConnectionThreadState> threadState;
+            LastError* le;
+            string threadName;
+            string otherSide;
+
+            bool connected; // connected() has run
+            bool closing;   // to be handed to a worker for disconnected()
+            bool registered; // with epoll
+
+            // the message being read (reactor) and the one being processed (worker)
+            MSGHEADER header;
+            int headerBytes;
+            MsgData* partial;
+            int partialBytes;
+            Message request;
+
+            // replies not yet written, oldest first; outOffset bytes of the first have gone,
+            // and outBytes remain in all
+            std::deque<Message*> replies;
+            int outOffset;
+            long long outBytes;
+        };
+
+        MSGID ReactorPort::queueOrSend( Message& response, MSGID responseTo, bool releasing ) {
+            verify( !response.empty() );
+            MSGID id = nextMessageId();
+            response.header()->id = id;
+            response.header()->responseTo = responseTo;
+
+            Message compressed;
+            Message& out = prepareToSend( response, compressed );
+            if ( _conn->needsBlockingIO() ||
+                 _conn->outBytes + out.size() > MaxBufferedReplyBytes ) {
+                _conn->flushInline();
+                out.send( *this, "reply" );
+            }
+            else if ( &out == &compressed || ( releasing && response.doIFreeIt() ) ) {
+                _conn->queueReply( out );
+            }
+            else {
+                // the caller keeps response, so what's queued is a copy
+                BufBuilder b( response.size() );
+                response.appendTo( b );
+                Message copy;
+                copy.setData( reinterpret_cast<MsgData*>( b.buf() ), true );
+                b.decouple();
+                _conn->queueReply( copy );
+            }
+            return id;
+        }
+
+        void ReactorPort::reply( Message& received, Message& response, MSGID responseTo ) {
+            queueOrSend( response, responseTo, false );
+        }
+
+        MSGID ReactorPort::replyReleasing( Message& received, Message& response,
+                                           MSGID responseTo ) {
+            return queueOrSend( response, responseTo, true );
+        }
+
+        class ReactorMessageServer : public MessageServer , public Listener {
+        public:
+            ReactorMessageServer( const MessageServer::Options& opts, MessageHandler* handler,
+                                  int workers ) :
+                Listener( "" , opts.ipList, opts.port ),
+                _handler( handler ),
+                _pool( workers ),
+                _mutex( "ReactorMessageServer" ) {
+                _epfd = epoll_create1( EPOLL_CLOEXEC );
+                massert( 17346, str::stream() << "epoll_create1 failed: " << errnoWithDescription(),
+                         _epfd >= 0 );
+                _wakeFd = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+                massert( 17347, str::stream() << "eventfd failed: " << errnoWithDescription(),
+                         _wakeFd >= 0 );
+
+                struct epoll_event ev;
+                memset( &ev, 0, sizeof(ev) );
+                ev.events = EPOLLIN;
+                ev.data.ptr = NULL;
+                massert( 17348, str::stream() << "epoll_ctl failed: " << errnoWithDescription(),
+                         epoll_ctl( _epfd, EPOLL_CTL_ADD, _wakeFd, &ev ) == 0 );
+            }
+
+            virtual void accepted( boost::shared_ptr<Socket> psocket, long long connectionId ) {
+                if ( ! Listener::globalTicketHolder.tryAcquire() ) {
+                    log() << "connection refused because too many open connections: "
+                          << Listener::globalTicketHolder.used() << endl;
+                    psocket->close();
+                    sleepmillis(2); // otherwise we'll hard loop
+                    return;
+                }
+
+                // connected() runs on a worker, like everything else the handler does
+                _pool.schedule( &ReactorMessageServer::turn, this,
+                                new ReactorConnection( psocket, connectionId ) );
+            }
+
+            virtual void setAsTimeTracker() {
+                Listener::setAsTimeTracker();
+            }
+
+            virtual void setupSockets() {
+                Listener::setupSockets();
+            }
+
+            void run() {
+                boost::thread reactor( boost::bind( &ReactorMessageServer::reactorThread, this ) );
+                initAndListen();
+            }
+
+            virtual bool useUnixSockets() const { return true; }
+
+        private:
+            MessageHandler* _handler;
+            ThreadPool _pool;
+            int _epfd;
+            int _wakeFd;
+
+            // connections workers have handed back, guarded by _mutex
+            SimpleMutex _mutex;
+            vector<ReactorConnection*> _handedBack;
+
+            // ---- workers ----
+
+            /** runs connected(), or processes one message, or closes the connection */
+            void turn( ReactorConnection* c ) {
+                setThreadName( c->threadName.c_str() );
+                lastError.reset( c->le );
+                if ( c->threadState )
+                    c->threadState->attach();
+
+                if ( c->closing ) {
+                    close( c );
+                    return;
+                }
+
+                try {
+                    if ( ! c->connected ) {
+                        c->connected = true;
+                        _handler->connected( &c->port );
+                    }
+                    else {
+                        c->port.psock->clearCounters();
+                        bool blockingRead = c->request.empty();
+                        // epoll can't see what recv() read ahead, so a blocking read keeps
+                        // going while that holds whole messages
+                        do {
+                            if ( blockingRead && ! c->port.recv( c->request ) ) {
+                                c->closing = true;
+                                break;
+                            }
+                            long long bytesIn = blockingRead ? 0 : c->request.size();
+                            if ( ! blockingRead )
+                                decompressMessage( c->request ); // recv() did it otherwise
+                            if ( inShutdown() )
+                                c->closing = true;
+                            else
+                                _handler->process( c->request , &c->port , c->le );
+                            networkCounter.hit( bytesIn + c->port.psock->getBytesIn() ,
+                                                c->port.psock->getBytesOut() );
+                            c->port.psock->clearCounters();
+                            c->request.reset();
+                        } while ( blockingRead && ! c->closing && c->port.hasBufferedInput() );
+                    }
+                }
+                catch ( AssertionException& e ) {
+                    log() << "AssertionException handling request, closing client connection: "
+                          << e << endl;
+                    c->closing = true;
+                }
+                catch ( SocketException& e ) {
+                    log() << "SocketException handling request, closing client connection: "
+                          << e << endl;
+                    c->closing = true;
+                }
+                catch ( const DBException& e ) { // must be right above std::exception to avoid catching subclasses
+                    log() << "DBException handling request, closing client connection: "
+                          << e << endl;
+                    c->closing = true;
+                }
+                catch ( std::exception &e ) {
+                    error() << "Uncaught std::exception: " << e.what() << ", terminating" << endl;
+                    dbexit( EXIT_UNCAUGHT );
+                }
+                catch ( ... ) {
+                    error() << "Uncaught exception, terminating" << endl;
+                    dbexit( EXIT_UNCAUGHT );
+                }
+                c->request.reset();
+
+                if ( c->closing ) {
+                    // no need to go through the reactor for this
+                    close( c );
+                    return;
+                }
+                detach( c );
+                handBack( c );
+            }
+
+            /** takes the connection's state off this thread */
+            void detach( ReactorConnection* c ) {
+                if ( c->threadState )
+                    c->threadState->detach();
+                else
+                    c->threadState.reset( _handler->detachThreadState() );
+                lastError.release();
+            }
+
+            /** the normal disconnect path; expects the connection's state attached */
+            void close( ReactorConnection* c ) {
+                TicketHolderReleaser connTicketReleaser( &Listener::globalTicketHolder );
+
+                if ( !serverGlobalParams.quiet ) {
+                    int conns = Listener::globalTicketHolder.used()-1;
+                    const char* word = (conns == 1 ? " connection" : " connections");
+                    log() << "end connection " << c->otherSide << " (" << conns << word
+                          << " now open)" << endl;
+                }
+                c->port.shutdown();
+                _handler->disconnected( &c->port );
+
+                detach( c );
+                delete c;
+            }
+
+            void handBack( ReactorConnection* c ) {
+                {
+                    SimpleMutex::scoped_lock lk( _mutex );
+                    _handedBack.push_back( c );
+                }
+                unsigned long long one = 1;
+                if ( write( _wakeFd, &one, sizeof(one) ) < 0 ) {
+                    // the counter is full, so the reactor has a wakeup coming anyway
+                }
+            }
+
+            // ---- reactor ----
+
+            void reactorThread() {
+                setThreadName( "reactor" );
+                const int MaxEvents = 256;
+                struct epoll_event events[MaxEvents];
+
+                while ( ! inShutdown() ) {
+                    int n = epoll_wait( _epfd, events, MaxEvents, 1000 );
+                    if ( n < 0 ) {
+                        if ( errno == EINTR )
+                            continue;
+                        error() << "epoll_wait failed: " << errnoWithDescription() << endl;
+                        fassertFailed( 17349 );
+                    }
+
+                    for ( int i = 0; i < n; i++ ) {
+                        ReactorConnection* c =
+                            static_cast<ReactorConnection*>( events[i].data.ptr );
+                        if ( ! c )
+                            takeHandedBack();
+                        else if ( events[i].events & EPOLLOUT )
+                            writeReplies( c );
+                        else
+                            readRequest( c );
+                    }
+                }
+            }
+
+            void takeHandedBack() {
+                unsigned long long count;
+                if ( read( _wakeFd, &count, sizeof(count) ) < 0 ) {
+                    // spurious wakeup; the queue is checked regardless
+                }
+
+                vector<ReactorConnection*> conns;
+                {
+                    SimpleMutex::scoped_lock lk( _mutex );
+                    conns.swap( _handedBack );
+                }
+                for ( unsigned i = 0; i < conns.size(); i++ ) {
+                    if ( conns[i]->hasOutput() )
+                        writeReplies( conns[i] );
+                    else
+                        wait( conns[i], EPOLLIN );
+                }
+            }
+
+            /**
+             * Gives the connection to a worker, for a message or for disconnected().  Its
+             * last wait has fired, so epoll won't report it again until the next wait().
+             */
+            void dispatch( ReactorConnection* c ) {
+                _pool.schedule( &ReactorMessageServer::turn, this, c );
+            }
+
+            void dispatchClose( ReactorConnection* c ) {
+                c->closing = true;
+                dispatch( c );
+            }
+
+            /** waits for events on the connection; each wait reports only once */
+            void wait( ReactorConnection* c, unsigned events ) {
+                struct epoll_event ev;
+                memset( &ev, 0, sizeof(ev) );
+                ev.events = events | EPOLLONESHOT;
+                ev.data.ptr = c;
+                int op = c->registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+                if ( epoll_ctl( _epfd, op, c->fd(), &ev ) != 0 ) {
+                    LOG(1) << "epoll_ctl failed for " << c->otherSide << ": "
+                           << errnoWithDescription() << endl;
+                    dispatchClose( c );
+                    return;
+                }
+                c->registered = true;
+            }
+
+            /** @return bytes read, or -1 if the connection should wait, or 0 to close it */
+            int readSome( ReactorConnection* c, char* buf, int len ) {
+                while ( true ) {
+                    int r = ::recv( c->fd(), buf, len, MSG_DONTWAIT );
+                    if ( r > 0 )
+                        return r;
+                    if ( r < 0 && errno == EINTR )
+                        continue;
+                    if ( r < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK ) )
+                        return -1;
+                    return 0;
+                }
+            }
+
+            void readRequest( ReactorConnection* c ) {
+                if ( c->needsBlockingIO() ) {
+                    dispatch( c );
+                    return;
+                }
+
+                while ( c->headerBytes < static_cast<int>(sizeof(MSGHEADER)) ) {
+                    int r = readSome( c, reinterpret_cast<char*>(&c->header) + c->headerBytes,
+                                      sizeof(MSGHEADER) - c->headerBytes );
+                    if ( r < 0 ) {
+                        wait( c, EPOLLIN );
+                        return;
+                    }
+                    if ( r == 0 ) {
+                        dispatchClose( c );
+                        return;
+                    }
+                    c->headerBytes += r;
+                }
+
+                int len = c->header.messageLength;
+                if ( ! c->partial ) {
+                    if ( len < static_cast<int>(sizeof(MSGHEADER)) || len > MaxMessageSizeBytes ) {
+                        LOG(0) << "recv(): message len " << len << " is invalid. "
+                               << "Min " << sizeof(MSGHEADER) << " Max: " << MaxMessageSizeBytes
+                               << endl;
+                        dispatchClose( c );
+                        return;
+                    }
+                    // same rounding as MessagingPort::recv
+                    c->partial = static_cast<MsgData*>( malloc( (len+1023)&0xfffffc00 ) );
+                    verify( c->partial );
+                    memcpy( c->partial, &c->header, sizeof(MSGHEADER) );
+                    c->partialBytes = sizeof(MSGHEADER);
+                }
+
+                while ( c->partialBytes < len ) {
+                    int r = readSome( c, reinterpret_cast<char*>(c->partial) + c->partialBytes,
+                                      len - c->partialBytes );
+                    if ( r < 0 ) {
+                        wait( c, EPOLLIN );
+                        return;
+                    }
+                    if ( r == 0 ) {
+                        dispatchClose( c );
+                        return;
+                    }
+                    c->partialBytes += r;
+                }
+
+                c->request.setData( c->partial, true );
+                c->partial = 0;
+                c->headerBytes = 0;
+                dispatch( c );
+            }
+
+            void writeReplies( ReactorConnection* c ) {
+                const unsigned MaxPieces = 64;
+                long long written = 0;
+                vector< pair<char*, int> > pieces;
+                struct iovec iov[MaxPieces];
+                while ( c->hasOutput() ) {
+                    pieces.clear();
+                    c->gatherReplies( pieces, MaxPieces );
+                    for ( unsigned i = 0; i < pieces.size(); i++ ) {
+                        iov[i].iov_base = pieces[i].first;
+                        iov[i].iov_len = pieces[i].second;
+                    }
+                    struct msghdr meta;
+                    memset( &meta, 0, sizeof(meta) );
+                    meta.msg_iov = iov;
+                    meta.msg_iovlen = pieces.size();
+
+                    int r = ::sendmsg( c->fd(), &meta, MSG_DONTWAIT | MSG_NOSIGNAL );
+                    if ( r < 0 && errno == EINTR )
+                        continue;
+                    if ( r < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK ) ) {
+                        networkCounter.hit( 0, written );
+                        wait( c, EPOLLOUT );
+                        return;
+                    }
+                    if ( r <= 0 ) {
+                        LOG(1) << "error writing reply to " << c->otherSide << ": "
+                               << errnoWithDescription() << endl;
+                        networkCounter.hit( 0, written );
+                        dispatchClose( c );
+                        return;
+                    }
+                    c->consumeReplies( r );
+                    written += r;
+                }
+                networkCounter.hit( 0, written );
+                wait( c, EPOLLIN );
+            }
+        };
+
+    } // namespace
+
+    MessageServer * createReactorServer( const MessageServer::Options& opts ,
+                                         MessageHandler * handler ,
+                                         int workers ) {
+        return new ReactorMessageServer( opts , handler , workers );
+    }
+
+} // namespace mongo
+
+#endif // __linux__
@@ -236,6 +236,15 @@ namespace mongo {
             return _awaitingHandshake;
         }
 
+        /** true once traffic on this socket goes through SSL, so raw reads and writes won't do */
+        bool isSecure() const {
+#ifdef MONGO_SSL
+            return _sslConnection.get() != NULL;
+#else
+            return false;
+#endif
+        }
+
 #ifdef MONGO_SSL
         /** secures inline */
         bool secure( SSLManagerInterface* ssl );
@@ -19,16 +19,20 @@
 
 #include <boost/thread/recursive_mutex.hpp>
 #include <boost/thread/tss.hpp>
+#include <map>
 #include <string>
 #include <vector>
 
 #include "mongo/base/init.h"
 #include "mongo/bson/util/atomic_int.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/net/sock.h"
 #include "mongo/util/net/ssl_options.h"
 #include "mongo/util/scopeguard.h"
+#include "mongo/util/time_support.h"
 
 #ifdef MONGO_SSL
 #include <openssl/evp.h>
@@ -129,6 +133,46 @@ namespace mongo {
         SSLManagerInterface* theSSLManager = NULL;
         static const int BUFFER_SIZE = 8*1024;
 
+        /**
+         * AES-GCM suites first; OpenSSL runs them on AES-NI where the CPU has it, and they need
+         * no separate MAC.  No @STRENGTH, which would put 256 bit CBC suites ahead of them.
+         */
+        const char defaultCipherConfig[] =
+            "ECDHE+AESGCM:DHE+AESGCM:AESGCM:HIGH:!EXPORT:!aNULL:!eNULL:!MD5";
+
+        /** names the server's session cache; resumed sessions must come from the same one */
+        const unsigned char sessionIdContext[] = "mongod";
+
+        /** outgoing connections keep a session to resume for at most this many peers */
+        const size_t maxClientSessions = 1000;
+
+        struct HandshakeStats {
+            AtomicUInt64 accepted;
+            AtomicUInt64 acceptedResumed;
+            AtomicUInt64 connected;
+            AtomicUInt64 connectedResumed;
+            AtomicUInt64 failed;
+            AtomicUInt64 micros;
+        } handshakeStats;
+
+        /** counts a handshake, and the time it took, however it ends */
+        class HandshakeTimer {
+        public:
+            HandshakeTimer() : _start(curTimeMicros64()), _done(false) {}
+            ~HandshakeTimer() {
+                handshakeStats.micros.fetchAndAdd(curTimeMicros64() - _start);
+                if (!_done)
+                    handshakeStats.failed.fetchAndAdd(1);
+            }
+            void done(AtomicUInt64& full, AtomicUInt64& resumed, SSL* ssl) {
+                _done = true;
+                (SSL_session_reused(ssl) ? resumed : full).fetchAndAdd(1);
+            }
+        private:
+            unsigned long long _start;
+            bool _done;
+        };
+
         struct Params {
             Params(const std::string& pemfile,
                    const std::string& pempwd,
@@ -137,7 +181,8 @@ namespace mongo {
                    const std::string& cafile = "",
                    const std::string& crlfile = "",
                    bool weakCertificateValidation = false,
-                   bool fipsMode = false) :
+                   bool fipsMode = false,
+                   const std::string& cipherConfig = "") :
                 pemfile(pemfile),
                 pempwd(pempwd),
                 clusterfile(clusterfile),
@@ -145,7 +190,8 @@ namespace mongo {
                 cafile(cafile),
                 crlfile(crlfile),
                 weakCertificateValidation(weakCertificateValidation),
-                fipsMode(fipsMode) {};
+                fipsMode(fipsMode),
+                cipherConfig(cipherConfig) {};
 
             std::string pemfile;
             std::string pempwd;
@@ -155,6 +201,7 @@ namespace mongo {
             std::string crlfile;
             bool weakCertificateValidation;
             bool fipsMode;
+            std::string cipherConfig;
         };
 
         class SSLManager : public SSLManagerInterface {
@@ -204,6 +251,17 @@ namespace mongo {
             std::string _serverSubjectName;
             std::string _clientSubjectName;
 
+            // the last session with each peer we connected to, to resume on the next connect()
+            SimpleMutex _clientSessionsMutex;
+            typedef std::map<std::string, SSL_SESSION*> SessionMap;
+            SessionMap _clientSessions;
+
+            /** has ssl offer to resume the last session with peer, if there is one */
+            void _resumeClientSession(const std::string& peer, SSL* ssl);
+
+            /** remembers ssl's session for the next connection to peer */
+            void _saveClientSession(const std::string& peer, SSL* ssl);
+
             /**
              * creates an SSL object to be used for this file descriptor.
              * caller must SSL_free it.
@@ -282,12 +340,26 @@ namespace mongo {
                 sslGlobalParams.sslCAFile,
                 sslGlobalParams.sslCRLFile,
                 sslGlobalParams.sslWeakCertificateValidation,
-                sslGlobalParams.sslFIPSMode);
+                sslGlobalParams.sslFIPSMode,
+                sslGlobalParams.sslCipherConfig);
             theSSLManager = new SSLManager(params, isSSLServer);
         }
         return Status::OK();
     }
 
+    void appendSSLStats(BSONObjBuilder& b) {
+        BSONObjBuilder h(b.subobjStart("handshakes"));
+        h.appendNumber("accepted", static_cast<long long>(handshakeStats.accepted.load()));
+        h.appendNumber("acceptedResumed",
+                       static_cast<long long>(handshakeStats.acceptedResumed.load()));
+        h.appendNumber("connected", static_cast<long long>(handshakeStats.connected.load()));
+        h.appendNumber("connectedResumed",
+                       static_cast<long long>(handshakeStats.connectedResumed.load()));
+        h.appendNumber("failed", static_cast<long long>(handshakeStats.failed.load()));
+        h.appendNumber("totalMicros", static_cast<long long>(handshakeStats.micros.load()));
+        h.done();
+    }
+
     SSLManagerInterface* getSSLManager() {
         SimpleMutex::scoped_lock lck(sslManagerMtx);
         if (theSSLManager)
@@ -357,7 +429,8 @@ namespace mongo {
 
     SSLManager::SSLManager(const Params& params, bool isServer) :
         _validateCertificates(false),
-        _weakValidation(params.weakCertificateValidation) {
+        _weakValidation(params.weakCertificateValidation),
+        _clientSessionsMutex("SSL client sessions") {
 
         SSL_library_init();
         SSL_load_error_strings();
@@ -412,6 +485,10 @@ namespace mongo {
     }
 
     SSLManager::~SSLManager() {
+        for (SessionMap::iterator i = _clientSessions.begin(); i != _clientSessions.end(); ++i) {
+            SSL_SESSION_free(i->second);
+        }
+
         ERR_free_strings();
         EVP_cleanup();
 
@@ -508,20 +585,44 @@ namespace mongo {
 
         // SSL_OP_ALL - Activate all bug workaround options, to support buggy client SSL's.
         // SSL_OP_NO_SSLv2 - Disable SSL v2 support 
-        SSL_CTX_set_options(*context, SSL_OP_ALL|SSL_OP_NO_SSLv2);
+        // SSL_OP_CIPHER_SERVER_PREFERENCE - Pick the cipher by our order, not the client's
+        SSL_CTX_set_options(*context, SSL_OP_ALL|SSL_OP_NO_SSLv2|SSL_OP_CIPHER_SERVER_PREFERENCE);
+
+        const std::string& ciphers = params.cipherConfig.empty() ?
+            std::string(defaultCipherConfig) : params.cipherConfig;
+        if (SSL_CTX_set_cipher_list(*context, ciphers.c_str()) != 1) {
+            error() << "can't use cipher config " << ciphers << ": " <<
+                getSSLErrorMessage(ERR_get_error()) << endl;
+            return false;
+        }
 
-        // HIGH - Enable strong ciphers
-        // !EXPORT - Disable export ciphers (40/56 bit) 
-        // !aNULL - Disable anonymous auth ciphers
-        // @STRENGTH - Sort ciphers based on strength 
-        SSL_CTX_set_cipher_list(*context, "HIGH:!EXPORT:!aNULL@STRENGTH");
+#ifndef OPENSSL_NO_ECDH
+        // The ECDHE suites need a curve to be set before OpenSSL 1.0.2
+        EC_KEY* ecdh = EC_KEY_new_by_curve_name(NID_X9_62_prime256v1);
+        if (ecdh) {
+            SSL_CTX_set_tmp_ecdh(*context, ecdh);
+            EC_KEY_free(ecdh);
+        }
+#endif
 
         // If renegotiation is needed, don't return from recv() or send() until it's successful.
         // Note: this is for blocking sockets only.
         SSL_CTX_set_mode(*context, SSL_MODE_AUTO_RETRY);
 
-        // Disable session caching (see SERVER-10261)
-        SSL_CTX_set_session_cache_mode(*context, SSL_SESS_CACHE_OFF);
+        // Let reconnecting peers resume their session, or present a ticket, rather than do a
+        // full handshake.  Resumption needs the session id context set when peers are sent
+        // for their certificates (see SERVER-10261).  Client sessions are kept per peer by
+        // connect(), not by OpenSSL.
+        if (context == &_serverContext) {
+            SSL_CTX_set_session_cache_mode(*context, SSL_SESS_CACHE_SERVER);
+            SSL_CTX_set_session_id_context(*context, sessionIdContext,
+                                           sizeof(sessionIdContext) - 1);
+        }
+        else {
+            SSL_CTX_set_session_cache_mode(*context, SSL_SESS_CACHE_CLIENT |
+                                                     SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        }
+        SSL_CTX_clear_options(*context, SSL_OP_NO_TICKET);
  
         // Use the clusterfile for internal outgoing SSL connections if specified 
         if (context == &_clientContext && !params.clusterfile.empty()) {
@@ -715,10 +816,42 @@ namespace mongo {
         }
     }
 
+    void SSLManager::_resumeClientSession(const std::string& peer, SSL* ssl) {
+        SimpleMutex::scoped_lock lk(_clientSessionsMutex);
+        SessionMap::const_iterator i = _clientSessions.find(peer);
+        if (i != _clientSessions.end())
+            SSL_set_session(ssl, i->second); // takes its own reference
+    }
+
+    void SSLManager::_saveClientSession(const std::string& peer, SSL* ssl) {
+        SSL_SESSION* session = SSL_get1_session(ssl);
+        if (!session)
+            return;
+        SimpleMutex::scoped_lock lk(_clientSessionsMutex);
+        SessionMap::iterator i = _clientSessions.find(peer);
+        if (i != _clientSessions.end()) {
+            SSL_SESSION_free(i->second);
+            i->second = session;
+            return;
+        }
+        if (_clientSessions.size() >= maxClientSessions) {
+            // rare enough that starting over beats tracking which peer is oldest
+            for (i = _clientSessions.begin(); i != _clientSessions.end(); ++i) {
+                SSL_SESSION_free(i->second);
+            }
+            _clientSessions.clear();
+        }
+        _clientSessions[peer] = session;
+    }
+
     SSLConnection* SSLManager::connect(Socket* socket) {
+        HandshakeTimer timer;
         SSLConnection* sslConn = new SSLConnection(_clientContext, socket, NULL, 0);
         ScopeGuard sslGuard = MakeGuard(::SSL_free, sslConn->ssl);
         ScopeGuard bioGuard = MakeGuard(::BIO_free, sslConn->networkBIO);
+
+        const std::string peer = socket->remoteString();
+        _resumeClientSession(peer, sslConn->ssl);
  
         int ret;
         do {
@@ -727,6 +860,9 @@ namespace mongo {
  
         if (ret != 1)
             _handleSSLError(SSL_get_error(sslConn, ret));
+
+        timer.done(handshakeStats.connected, handshakeStats.connectedResumed, sslConn->ssl);
+        _saveClientSession(peer, sslConn->ssl);
  
         sslGuard.Dismiss();
         bioGuard.Dismiss();
@@ -734,6 +870,7 @@ namespace mongo {
     }
 
     SSLConnection* SSLManager::accept(Socket* socket, const char* initialBytes, int len) {
+        HandshakeTimer timer;
         SSLConnection* sslConn = new SSLConnection(_serverContext, socket, initialBytes, len);
         ScopeGuard sslGuard = MakeGuard(::SSL_free, sslConn->ssl);
         ScopeGuard bioGuard = MakeGuard(::BIO_free, sslConn->networkBIO);
@@ -745,6 +882,8 @@ namespace mongo {
  
         if (ret != 1)
             _handleSSLError(SSL_get_error(sslConn, ret));
+
+        timer.done(handshakeStats.accepted, handshakeStats.acceptedResumed, sslConn->ssl);
  
         sslGuard.Dismiss();
         bioGuard.Dismiss();
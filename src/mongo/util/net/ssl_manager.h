@@ -36,6 +36,8 @@ namespace mongo {
 #ifdef MONGO_SSL
 namespace mongo {
 
+    class BSONObjBuilder;
+
     class SSLConnection {
     public:
         SSL* ssl;
@@ -118,6 +120,9 @@ namespace mongo {
     // Access SSL functions through this instance.
     SSLManagerInterface* getSSLManager();
 
+    /** handshakes done, resumed, failed and the time they took, for serverStatus */
+    void appendSSLStats(BSONObjBuilder& b);
+
     extern bool isSSLServer;
 }
 #endif // #ifdef MONGO_SSL
@@ -56,6 +56,9 @@ namespace mongo {
         options->addOptionChaining("ssl.FIPSMode", "sslFIPSMode", moe::Switch,
                 "activate FIPS 140-2 mode at startup");
 
+        options->addOptionChaining("ssl.cipherConfig", "sslCipherConfig", moe::String,
+                "OpenSSL cipher list, in order of preference; defaults to AES-GCM first");
+
 
         return Status::OK();
     }
@@ -162,6 +165,9 @@ namespace mongo {
             if (params.count("ssl.FIPSMode")) {
                 sslGlobalParams.sslFIPSMode = true;
             }
+            if (params.count("ssl.cipherConfig")) {
+                sslGlobalParams.sslCipherConfig = params["ssl.cipherConfig"].as<string>();
+            }
         }
         else if (sslGlobalParams.sslPEMKeyFile.size() ||
                  sslGlobalParams.sslPEMKeyPassword.size() ||
@@ -170,7 +176,8 @@ namespace mongo {
                  sslGlobalParams.sslCAFile.size() ||
                  sslGlobalParams.sslCRLFile.size() ||
                  sslGlobalParams.sslWeakCertificateValidation ||
-                 sslGlobalParams.sslFIPSMode) {
+                 sslGlobalParams.sslFIPSMode ||
+                 sslGlobalParams.sslCipherConfig.size()) {
             return Status(ErrorCodes::BadValue,
                           "need to enable SSL via the sslMode flag when "
                           "using SSL configuration parameters");
@@ -38,6 +38,7 @@ namespace mongo {
         std::string sslCRLFile;     // --sslCRLFile
         bool sslWeakCertificateValidation; // --sslWeakCertificateValidation
         bool sslFIPSMode; // --sslFIPSMode
+        std::string sslCipherConfig; // --sslCipherConfig
 
         SSLGlobalParams() {
             sslMode.store(SSLMode_noSSL);
@@ -0,0 +1,167 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/util/numa.h"
+
+#include <cstdio>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <fstream>
+#endif
+
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    using namespace mongoutils;
+
+#if defined(__linux__)
+
+    namespace {
+
+        // from <numaif.h>, which would mean linking against libnuma
+        const int MpolDefault = 0;
+        const int MpolPreferred = 1;
+        const int MpolBind = 2;
+        const int MpolInterleave = 3;
+
+        const unsigned MaxNodes = 64;
+
+        /** parse a list of nodes such as "0,2-3" into a mask.  @return false if malformed */
+        bool parseNodes( const std::string& list, unsigned long long* mask ) {
+            *mask = 0;
+            std::string::size_type pos = 0;
+            while ( pos < list.size() ) {
+                std::string::size_type end = list.find( ',', pos );
+                if ( end == std::string::npos )
+                    end = list.size();
+                std::string range = list.substr( pos, end - pos );
+                unsigned first, last;
+                char extra;
+                if ( sscanf( range.c_str(), "%u-%u%c", &first, &last, &extra ) == 2 ) {
+                }
+                else if ( sscanf( range.c_str(), "%u%c", &first, &extra ) == 1 ) {
+                    last = first;
+                }
+                else {
+                    return false;
+                }
+                if ( first > last || last >= MaxNodes )
+                    return false;
+                for ( unsigned n = first; n <= last; n++ )
+                    *mask |= 1ULL << n;
+                pos = end + 1;
+            }
+            return *mask != 0;
+        }
+
+        /** @return the mask of online nodes, or 0 if unknown */
+        unsigned long long onlineNodes() {
+            std::ifstream f( "/sys/devices/system/node/online" );
+            std::string line;
+            unsigned long long mask = 0;
+            if ( !std::getline( f, line ) || !parseNodes( line, &mask ) )
+                return 0;
+            return mask;
+        }
+
+    }
+
+    Status setProcessNumaPolicy( const std::string& policy ) {
+        int mode;
+        unsigned long long mask = 0;
+        if ( policy == "default" ) {
+            mode = MpolDefault;
+        }
+        else if ( policy == "interleave" ) {
+            mode = MpolInterleave;
+            mask = onlineNodes();
+            if ( !mask )
+                return Status( ErrorCodes::BadValue, "couldn't find the machine's NUMA nodes" );
+        }
+        else if ( str::startsWith( policy, "interleave:" ) || str::startsWith( policy, "bind:" ) ) {
+            mode = str::startsWith( policy, "bind:" ) ? MpolBind : MpolInterleave;
+            if ( !parseNodes( str::after( policy, ':' ), &mask ) )
+                return Status( ErrorCodes::BadValue,
+                               str::stream() << "bad list of NUMA nodes in '" << policy << "'" );
+        }
+        else {
+            return Status( ErrorCodes::BadValue,
+                           str::stream() << "unknown NUMA policy '" << policy << "'" );
+        }
+
+        if ( syscall( SYS_set_mempolicy, mode, mode == MpolDefault ? NULL : &mask,
+                      mode == MpolDefault ? 0 : MaxNodes + 1 ) != 0 ) {
+            return Status( ErrorCodes::BadValue,
+                           str::stream() << "set_mempolicy failed for '" << policy << "': "
+                                         << errnoWithDescription() );
+        }
+        log() << "NUMA policy for memory and data files set to " << policy << std::endl;
+        return Status::OK();
+    }
+
+    bool adviseMemoryPlacement( void* p, size_t len, bool nodeLocal, bool hugePages ) {
+        const size_t pageSize = sysconf( _SC_PAGESIZE );
+        size_t start = ( reinterpret_cast<size_t>( p ) + pageSize - 1 ) & ~( pageSize - 1 );
+        size_t end = ( reinterpret_cast<size_t>( p ) + len ) & ~( pageSize - 1 );
+        if ( end <= start )
+            return true;
+
+        bool ok = true;
+        // preferred with no nodes means the local node
+        if ( nodeLocal && syscall( SYS_mbind, start, end - start, MpolPreferred, NULL, 0, 0 ) )
+            ok = false;
+#if defined(MADV_HUGEPAGE)
+        if ( hugePages && madvise( reinterpret_cast<void*>( start ), end - start, MADV_HUGEPAGE ) )
+            ok = false;
+#else
+        if ( hugePages )
+            ok = false;
+#endif
+        return ok;
+    }
+
+#else
+
+    Status setProcessNumaPolicy( const std::string& policy ) {
+        if ( policy == "default" )
+            return Status::OK();
+        return Status( ErrorCodes::BadValue, "NUMA policies are only supported on linux" );
+    }
+
+    bool adviseMemoryPlacement( void* p, size_t len, bool nodeLocal, bool hugePages ) {
+        return !nodeLocal && !hugePages;
+    }
+
+#endif
+
+} // namespace mongo
@@ -0,0 +1,63 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "mongo/base/status.h"
+
+namespace mongo {
+
+    /**
+     * Control over where memory is placed on NUMA machines.  Only linux supports it; elsewhere
+     * these do nothing and report so.
+     */
+
+    /**
+     * Places the memory the process allocates from now on, including the page cache pages that
+     * back data file mappings, according to 'policy':
+     *   "default"            - the kernel's: on the node of the thread that first touches a page
+     *   "interleave"         - round robin across all nodes, as numactl --interleave=all does
+     *   "interleave:<nodes>" - round robin across the listed nodes, e.g. "interleave:0,1"
+     *   "bind:<nodes>"       - only on the listed nodes
+     * The kernel places page cache pages by the policy of the faulting thread, not that of the
+     * mapping, so this is what decides where data files end up.  Threads inherit the policy when
+     * they are created, so set it before starting any.
+     */
+    Status setProcessNumaPolicy( const std::string& policy );
+
+    /**
+     * If 'nodeLocal', places the pages of [p, p + len) on the node of the thread that first
+     * touches each, whatever the process policy; if 'hugePages', asks for transparent huge pages
+     * for them.  Only whole pages within the range are affected.
+     * @return false if that isn't supported here
+     */
+    bool adviseMemoryPlacement( void* p, size_t len, bool nodeLocal, bool hugePages );
+
+} // namespace mongo
@@ -0,0 +1,367 @@
+// persistent_map.h
+
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <boost/intrusive_ptr.hpp>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+    /**
+     * An ordered map with the interface of a const std::map plus insert and erase, whose copies
+     * share structure: copying one is O(1), and changing a copy only copies the O(log n) tree
+     * nodes on the path to the change, leaving everything else shared with the original.
+     *
+     * It is a balanced (AVL) tree of reference counted nodes.  Nodes only one map can reach are
+     * changed in place, so a map that isn't shared costs about what a std::map would.
+     *
+     * Copies may be read from several threads while another copy changes.  One map must not be
+     * changed and read at once, and unlike std::map, any insert or erase invalidates the map's
+     * iterators.  Values can't be changed in place; erase and insert again instead.
+     */
+    template< typename K, typename V, typename Compare = std::less<K> >
+    class PersistentMap {
+    private:
+        struct Node;
+        typedef boost::intrusive_ptr<Node> NodePtr;
+
+    public:
+        typedef K key_type;
+        typedef V mapped_type;
+        typedef std::pair<const K, V> value_type;
+        typedef Compare key_compare;
+        typedef size_t size_type;
+
+        class const_iterator;
+        typedef const_iterator iterator;
+
+        PersistentMap() : _size( 0 ) {}
+        explicit PersistentMap( const Compare& cmp ) : _size( 0 ), _cmp( cmp ) {}
+
+        const_iterator begin() const {
+            const_iterator it( _root.get() );
+            for ( const Node* n = _root.get(); n; n = n->left.get() )
+                it.push( n );
+            return it;
+        }
+        const_iterator end() const { return const_iterator( _root.get() ); }
+
+        size_type size() const { return _size; }
+        bool empty() const { return _size == 0; }
+        key_compare key_comp() const { return _cmp; }
+
+        void clear() { _root.reset(); _size = 0; }
+        void swap( PersistentMap& other ) {
+            _root.swap( other._root );
+            std::swap( _size, other._size );
+            std::swap( _cmp, other._cmp );
+        }
+
+        /** the first entry whose key isn't less than k */
+        const_iterator lower_bound( const K& k ) const { return _bound( k, false ); }
+        /** the first entry whose key is greater than k */
+        const_iterator upper_bound( const K& k ) const { return _bound( k, true ); }
+
+        const_iterator find( const K& k ) const {
+            const_iterator it = lower_bound( k );
+            if ( it != end() && _cmp( k, it->first ) )
+                return end();
+            return it;
+        }
+        size_type count( const K& k ) const { return find( k ) == end() ? 0 : 1; }
+
+        /** @return false, changing nothing, if there already is an entry for v.first */
+        bool insert( const value_type& v ) {
+            if ( find( v.first ) != end() )
+                return false;
+            _insert( _root, v );
+            _size++;
+            return true;
+        }
+
+        /** @return the number of entries erased, 0 or 1 */
+        size_type erase( const K& k ) {
+            if ( find( k ) == end() )
+                return 0;
+            _erase( _root, k );
+            _size--;
+            return 1;
+        }
+
+        void erase( const_iterator first, const_iterator last ) {
+            // erasing invalidates iterators, so find all the keys first
+            std::vector<K> keys;
+            for ( ; first != last; ++first )
+                keys.push_back( first->first );
+            for ( size_t i = 0; i < keys.size(); i++ )
+                erase( keys[i] );
+        }
+
+        /**
+         * Bidirectional iterator over a map, holding the path to its entry from the root.  It
+         * isn't invalidated by changes to copies of the map it came from.
+         */
+        class const_iterator {
+        public:
+            typedef std::bidirectional_iterator_tag iterator_category;
+            typedef typename PersistentMap::value_type value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const value_type* pointer;
+            typedef const value_type& reference;
+
+            const_iterator() : _root( NULL ), _depth( 0 ) {}
+
+            reference operator*() const { return _top()->value; }
+            pointer operator->() const { return &_top()->value; }
+
+            const_iterator& operator++() {
+                const Node* n = _top();
+                if ( n->right ) {
+                    for ( n = n->right.get(); n; n = n->left.get() )
+                        push( n );
+                }
+                else {
+                    // go up until we leave a left subtree
+                    _depth--;
+                    while ( _depth > 0 && _path[_depth - 1]->right.get() == n ) {
+                        n = _path[--_depth];
+                    }
+                }
+                return *this;
+            }
+
+            const_iterator& operator--() {
+                if ( _depth == 0 ) {
+                    // from end() to the last entry
+                    for ( const Node* n = _root; n; n = n->right.get() )
+                        push( n );
+                    return *this;
+                }
+                const Node* n = _top();
+                if ( n->left ) {
+                    for ( n = n->left.get(); n; n = n->right.get() )
+                        push( n );
+                }
+                else {
+                    _depth--;
+                    while ( _depth > 0 && _path[_depth - 1]->left.get() == n ) {
+                        n = _path[--_depth];
+                    }
+                }
+                return *this;
+            }
+
+            const_iterator operator++( int ) { const_iterator old = *this; ++*this; return old; }
+            const_iterator operator--( int ) { const_iterator old = *this; --*this; return old; }
+
+            bool operator==( const const_iterator& other ) const {
+                return _node() == other._node();
+            }
+            bool operator!=( const const_iterator& other ) const { return !( *this == other ); }
+
+        private:
+            friend class PersistentMap;
+
+            explicit const_iterator( const Node* root ) : _root( root ), _depth( 0 ) {}
+
+            void push( const Node* n ) {
+                dassert( _depth < maxDepth );
+                _path[_depth++] = n;
+            }
+            const Node* _top() const {
+                dassert( _depth > 0 );
+                return _path[_depth - 1];
+            }
+            const Node* _node() const { return _depth ? _path[_depth - 1] : NULL; }
+
+            // An AVL tree is at most ~1.44 log2(n) high, so this covers any map that fits in memory
+            static const int maxDepth = 96;
+
+            const Node* _root;
+            int _depth;
+            const Node* _path[maxDepth];
+        };
+
+    private:
+        struct Node {
+            explicit Node( const value_type& v ) : value( v ), height( 1 ) {}
+            // copies share the children, so they stop being changeable in place
+            Node( const Node& other )
+                : value( other.value ), left( other.left ), right( other.right ),
+                  height( other.height ) {}
+
+            friend void intrusive_ptr_add_ref( const Node* n ) { n->refs.fetchAndAdd( 1 ); }
+            friend void intrusive_ptr_release( const Node* n ) {
+                if ( n->refs.subtractAndFetch( 1 ) == 0 )
+                    delete n;
+            }
+
+            const value_type value;
+            NodePtr left;
+            NodePtr right;
+            int height;
+            mutable AtomicUInt32 refs;
+
+        private:
+            Node& operator=( const Node& );
+        };
+
+        static int _height( const NodePtr& n ) { return n ? n->height : 0; }
+
+        static void _fixHeight( Node* n ) {
+            n->height = 1 + std::max( _height( n->left ), _height( n->right ) );
+        }
+
+        /**
+         * Makes the node in slot one only this map reaches, copying it if it is shared.  The
+         * parent must already be, so a refcount of 1 means nothing else can see the node.
+         */
+        static void _own( NodePtr& slot ) {
+            if ( slot->refs.load() > 1 )
+                slot.reset( new Node( *slot ) );
+        }
+
+        static void _rotateRight( NodePtr& slot ) {
+            _own( slot->left );
+            NodePtr l = slot->left;
+            slot->left = l->right;
+            _fixHeight( slot.get() );
+            l->right = slot;
+            slot = l;
+            _fixHeight( slot.get() );
+        }
+
+        static void _rotateLeft( NodePtr& slot ) {
+            _own( slot->right );
+            NodePtr r = slot->right;
+            slot->right = r->left;
+            _fixHeight( slot.get() );
+            r->left = slot;
+            slot = r;
+            _fixHeight( slot.get() );
+        }
+
+        // the node in slot is owned, and its subtrees are balanced and differ in height by <= 2
+        static void _rebalance( NodePtr& slot ) {
+            int balance = _height( slot->left ) - _height( slot->right );
+            if ( balance > 1 ) {
+                if ( _height( slot->left->left ) < _height( slot->left->right ) ) {
+                    _own( slot->left );
+                    _rotateLeft( slot->left );
+                }
+                _rotateRight( slot );
+            }
+            else if ( balance < -1 ) {
+                if ( _height( slot->right->right ) < _height( slot->right->left ) ) {
+                    _own( slot->right );
+                    _rotateRight( slot->right );
+                }
+                _rotateLeft( slot );
+            }
+            else {
+                _fixHeight( slot.get() );
+            }
+        }
+
+        // v.first isn't in the subtree
+        void _insert( NodePtr& slot, const value_type& v ) {
+            if ( !slot ) {
+                slot.reset( new Node( v ) );
+                return;
+            }
+            _own( slot );
+            if ( _cmp( v.first, slot->value.first ) )
+                _insert( slot->left, v );
+            else
+                _insert( slot->right, v );
+            _rebalance( slot );
+        }
+
+        // k is in the subtree
+        void _erase( NodePtr& slot, const K& k ) {
+            _own( slot );
+            if ( _cmp( k, slot->value.first ) ) {
+                _erase( slot->left, k );
+            }
+            else if ( _cmp( slot->value.first, k ) ) {
+                _erase( slot->right, k );
+            }
+            else if ( !slot->left ) {
+                slot = NodePtr( slot->right );
+                return;
+            }
+            else if ( !slot->right ) {
+                slot = NodePtr( slot->left );
+                return;
+            }
+            else {
+                // values are const, so the successor's goes into a new node here
+                NodePtr successor;
+                _takeMin( slot->right, &successor );
+                NodePtr replacement( new Node( successor->value ) );
+                replacement->left = slot->left;
+                replacement->right = slot->right;
+                slot = replacement;
+            }
+            _rebalance( slot );
+        }
+
+        static void _takeMin( NodePtr& slot, NodePtr* min ) {
+            _own( slot );
+            if ( !slot->left ) {
+                *min = slot;
+                slot = NodePtr( slot->right );
+                return;
+            }
+            _takeMin( slot->left, min );
+            _rebalance( slot );
+        }
+
+        const_iterator _bound( const K& k, bool upper ) const {
+            const_iterator it( _root.get() );
+            int found = 0;
+            for ( const Node* n = _root.get(); n; ) {
+                it.push( n );
+                bool goLeft = upper ? _cmp( k, n->value.first ) : !_cmp( n->value.first, k );
+                if ( goLeft ) {
+                    // n is the best candidate so far
+                    found = it._depth;
+                    n = n->left.get();
+                }
+                else {
+                    n = n->right.get();
+                }
+            }
+            it._depth = found;
+            return it;
+        }
+
+        NodePtr _root;
+        size_type _size;
+        Compare _cmp;
+    };
+
+} // namespace mongo
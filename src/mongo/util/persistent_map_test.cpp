@@ -0,0 +1,159 @@
+// persistent_map_test.cpp
+
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "mongo/unittest/unittest.h"
+
+#include <boost/next_prior.hpp>
+#include <map>
+
+#include "mongo/platform/random.h"
+#include "mongo/util/persistent_map.h"
+
+namespace {
+    using namespace mongo;
+    using std::make_pair;
+    using std::vector;
+
+    typedef PersistentMap<int, int> IntMap;
+    typedef std::map<int, int> StdMap;
+
+    void assertSame( const IntMap& m, const StdMap& expected ) {
+        ASSERT_EQUALS( expected.size(), m.size() );
+        IntMap::const_iterator it = m.begin();
+        for ( StdMap::const_iterator e = expected.begin(); e != expected.end(); ++e, ++it ) {
+            ASSERT( it != m.end() );
+            ASSERT_EQUALS( e->first, it->first );
+            ASSERT_EQUALS( e->second, it->second );
+        }
+        ASSERT( it == m.end() );
+
+        // and backwards
+        for ( StdMap::const_reverse_iterator e = expected.rbegin(); e != expected.rend(); ++e ) {
+            --it;
+            ASSERT_EQUALS( e->first, it->first );
+        }
+        ASSERT( it == m.begin() );
+    }
+
+    TEST(PersistentMapTest, Empty) {
+        IntMap m;
+        ASSERT( m.empty() );
+        ASSERT( m.begin() == m.end() );
+        ASSERT( m.find( 1 ) == m.end() );
+        ASSERT( m.lower_bound( 1 ) == m.end() );
+        ASSERT_EQUALS( 0U, m.erase( 1 ) );
+    }
+
+    TEST(PersistentMapTest, InsertFindErase) {
+        IntMap m;
+        ASSERT( m.insert( make_pair( 2, 20 ) ) );
+        ASSERT( m.insert( make_pair( 1, 10 ) ) );
+        ASSERT( m.insert( make_pair( 3, 30 ) ) );
+        ASSERT( !m.insert( make_pair( 2, 21 ) ) );
+
+        ASSERT_EQUALS( 3U, m.size() );
+        ASSERT_EQUALS( 20, m.find( 2 )->second );
+        ASSERT( m.find( 4 ) == m.end() );
+        ASSERT_EQUALS( 1, m.begin()->first );
+        ASSERT_EQUALS( 3, boost::prior( m.end() )->first );
+
+        ASSERT_EQUALS( 1U, m.erase( 2 ) );
+        ASSERT_EQUALS( 0U, m.erase( 2 ) );
+        ASSERT_EQUALS( 2U, m.size() );
+        ASSERT( m.find( 2 ) == m.end() );
+    }
+
+    TEST(PersistentMapTest, Bounds) {
+        IntMap m;
+        for ( int i = 0; i < 100; i += 10 )
+            m.insert( make_pair( i, i ) );
+
+        ASSERT_EQUALS( 10, m.lower_bound( 10 )->first );
+        ASSERT_EQUALS( 20, m.upper_bound( 10 )->first );
+        ASSERT_EQUALS( 20, m.lower_bound( 11 )->first );
+        ASSERT_EQUALS( 0, m.lower_bound( -5 )->first );
+        ASSERT( m.upper_bound( 90 ) == m.end() );
+        ASSERT_EQUALS( 10, boost::prior( m.upper_bound( 15 ) )->first );
+
+        m.erase( m.lower_bound( 20 ), m.upper_bound( 50 ) );
+        ASSERT_EQUALS( 6U, m.size() );
+        ASSERT_EQUALS( 60, m.upper_bound( 10 )->first );
+    }
+
+    TEST(PersistentMapTest, CopiesAreIndependent) {
+        IntMap a;
+        StdMap expectedA;
+        for ( int i = 0; i < 1000; i++ ) {
+            a.insert( make_pair( i, i ) );
+            expectedA.insert( make_pair( i, i ) );
+        }
+
+        IntMap b = a;
+        StdMap expectedB = expectedA;
+        for ( int i = 0; i < 1000; i += 3 ) {
+            b.erase( i );
+            expectedB.erase( i );
+        }
+        b.insert( make_pair( 5000, 1 ) );
+        expectedB.insert( make_pair( 5000, 1 ) );
+        a.erase( 1 );
+        expectedA.erase( 1 );
+
+        assertSame( a, expectedA );
+        assertSame( b, expectedB );
+
+        // iterators aren't invalidated by changes to other copies
+        IntMap::const_iterator it = a.find( 500 );
+        b.erase( 500 );
+        b.clear();
+        ASSERT_EQUALS( 500, it->first );
+        ASSERT_EQUALS( 501, ( ++it )->first );
+    }
+
+    // PseudoRandom::nextInt32( max ) can be negative
+    int nextIndex( PseudoRandom* rand, int max ) {
+        return static_cast<uint32_t>( rand->nextInt32() ) % max;
+    }
+
+    TEST(PersistentMapTest, RandomAgainstStdMap) {
+        PseudoRandom rand( 12345 );
+        vector<IntMap> maps( 1 );
+        vector<StdMap> expected( 1 );
+
+        for ( int i = 0; i < 100000; i++ ) {
+            int which = nextIndex( &rand, maps.size() );
+            if ( maps.size() < 20 && nextIndex( &rand, 1000 ) == 0 ) {
+                maps.push_back( maps[which] );
+                expected.push_back( expected[which] );
+                continue;
+            }
+
+            int key = nextIndex( &rand, 2000 );
+            if ( nextIndex( &rand, 2 ) ) {
+                ASSERT_EQUALS( expected[which].insert( make_pair( key, i ) ).second,
+                               maps[which].insert( make_pair( key, i ) ) );
+            }
+            else {
+                ASSERT_EQUALS( expected[which].erase( key ), maps[which].erase( key ) );
+            }
+        }
+
+        for ( size_t i = 0; i < maps.size(); i++ )
+            assertSame( maps[i], expected[i] );
+    }
+
+} // namespace
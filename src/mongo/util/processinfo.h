@@ -123,6 +123,20 @@ namespace mongo {
          */
         static bool pagesInMemory(const void* start, size_t numPages, vector<char>* out);
 
+        /**
+         * Hints that the pages holding 'length' bytes from 'start' will be needed soon, so that
+         * the OS can start reading them in.  Doesn't wait for them, and does nothing where
+         * unsupported.
+         */
+        static void willNeed(const void* start, size_t length);
+
+        /**
+         * Fills in the CPU time (user plus system) used by the calling thread and the number of
+         * major page faults it has taken.  Returns false where per-thread usage isn't available,
+         * in which case the outputs are untouched.
+         */
+        static bool getThreadUsage(uint64_t* cpuMicros, uint64_t* majorFaults);
+
     private:
         /**
          * Host and operating system info.  Does not change over time.
@@ -206,4 +206,15 @@ namespace mongo {
         return true;
     }
 
+    void ProcessInfo::willNeed(const void* start, size_t length) {
+        const char* startOfFirstPage = static_cast<const char*>(alignToStartOfPage(start));
+        size_t len = length + (static_cast<const char*>(start) - startOfFirstPage);
+        // Only a hint, so failure doesn't matter.
+        madvise(const_cast<char*>(startOfFirstPage), len, MADV_WILLNEED);
+    }
+
+    bool ProcessInfo::getThreadUsage(uint64_t* cpuMicros, uint64_t* majorFaults) {
+        return false;
+    }
+
 }
@@ -20,6 +20,7 @@
 #include <sys/file.h>
 #include <sys/mman.h>
 #include <sys/param.h>
+#include <sys/resource.h>
 #include <sys/sysctl.h>
 #include <sys/types.h>
 #include <sys/user.h>
@@ -172,4 +173,22 @@ namespace mongo {
         }
         return true;
     }
+
+    void ProcessInfo::willNeed(const void* start, size_t length) {
+        const char* startOfFirstPage = static_cast<const char*>(alignToStartOfPage(start));
+        size_t len = length + (static_cast<const char*>(start) - startOfFirstPage);
+        // Only a hint, so failure doesn't matter.
+        madvise(const_cast<char*>(startOfFirstPage), len, MADV_WILLNEED);
+    }
+
+    bool ProcessInfo::getThreadUsage(uint64_t* cpuMicros, uint64_t* majorFaults) {
+        struct rusage usage;
+        if (getrusage(RUSAGE_THREAD, &usage) != 0) {
+            return false;
+        }
+        *cpuMicros = static_cast<uint64_t>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000
+                     + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+        *majorFaults = usage.ru_majflt;
+        return true;
+    }
 }
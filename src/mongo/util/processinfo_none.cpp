@@ -67,4 +67,12 @@ namespace mongo {
         verify(0);
     }
 
+    void ProcessInfo::willNeed(const void* start, size_t length) {
+        // No read-ahead hint on this platform.
+    }
+
+    bool ProcessInfo::getThreadUsage(uint64_t* cpuMicros, uint64_t* majorFaults) {
+        return false;
+    }
+
 }
@@ -249,4 +249,12 @@ namespace mongo {
         return true;
     }
 
+    void ProcessInfo::willNeed(const void* start, size_t length) {
+        // No read-ahead hint on this platform.
+    }
+
+    bool ProcessInfo::getThreadUsage(uint64_t* cpuMicros, uint64_t* majorFaults) {
+        return false;
+    }
+
 }
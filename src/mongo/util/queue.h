@@ -69,6 +69,25 @@ namespace mongo {
             _cvNoLongerEmpty.notify_one();
         }
 
+        /**
+         * Pushes each of [begin, end) in order, waiting for room like push() but taking the
+         * lock once for all of them.
+         */
+        template<typename Iterator>
+        void pushAll(Iterator begin, Iterator end) {
+            scoped_lock l( _lock );
+            for ( ; begin != end; ++begin ) {
+                size_t tSize = _getSize(*begin);
+                while (_currentSize + tSize >= _maxSize) {
+                    _cvNoLongerEmpty.notify_one();
+                    _cvNoLongerFull.wait( l.boost() );
+                }
+                _queue.push( *begin );
+                _currentSize += tSize;
+            }
+            _cvNoLongerEmpty.notify_one();
+        }
+
         bool empty() const {
             scoped_lock l( _lock );
             return _queue.empty();
@@ -18,6 +18,7 @@
 
 #include "mongo/pch.h" // for malloc/realloc/INFINITY pulled from bson
 
+#include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/bson/bsontypes.h"
 #include "mongo/util/safe_num.h"
 
@@ -68,6 +69,26 @@ namespace mongo {
         return os << snum.debugString();
     }
 
+    //
+    // output support
+    //
+
+    void SafeNum::toBSON(const StringData& fieldName, BSONObjBuilder* bob) const {
+        switch (_type) {
+        case NumberInt:
+            bob->append(fieldName, _value.int32Val);
+            break;
+        case NumberLong:
+            bob->append(fieldName, _value.int64Val);
+            break;
+        case NumberDouble:
+            bob->append(fieldName, _value.doubleVal);
+            break;
+        default:
+            verify(false);
+        }
+    }
+
     //
     // comparison support
     //
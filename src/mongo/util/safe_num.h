@@ -23,6 +23,8 @@
 
 namespace mongo {
 
+    class BSONObjBuilder;
+
 namespace mutablebson {
     class Element;
     class Document;
@@ -140,7 +142,14 @@ namespace mutablebson {
         friend class mutablebson::Element;
         friend class mutablebson::Document;
 
-        // TODO: output to builder
+        //
+        // output support
+        //
+
+        /**
+         * Appends this number to 'bob' as 'fieldName', with its own type. Must be valid.
+         */
+        void toBSON(const StringData& fieldName, BSONObjBuilder* bob) const;
 
         //
         // accessors
@@ -120,6 +120,38 @@ namespace {
         ASSERT_EQUALS( before, m.capacity() );
     }
 
+    TEST( StringMapTest, RandomAgainstUnorderedMap ) {
+        StringMap<int> m;
+        unordered_map<string,int> expected;
+        PseudoRandom r( 1234 );
+        char buf[64];
+
+        for ( int i = 0; i < 100000; i++ ) {
+            sprintf( buf, "key%d", static_cast<unsigned>( r.nextInt32() ) % 3000 );
+            switch ( static_cast<unsigned>( r.nextInt32() ) % 3 ) {
+            case 0:
+                m[buf] = i;
+                expected[buf] = i;
+                break;
+            case 1:
+                ASSERT_EQUALS( expected.erase( buf ), m.erase( buf ) );
+                break;
+            default: {
+                StringMap<int>::const_iterator it = m.find( buf );
+                ASSERT_EQUALS( expected.count( buf ), it != m.end() ? 1U : 0U );
+                if ( it != m.end() )
+                    ASSERT_EQUALS( expected[buf], it->second );
+            }
+            }
+        }
+
+        size_t n = 0;
+        for ( StringMap<int>::const_iterator it = m.begin(); it != m.end(); ++it, ++n ) {
+            ASSERT_EQUALS( expected[it->first], it->second );
+        }
+        ASSERT_EQUALS( expected.size(), n );
+    }
+
     TEST( StringMapTest, Iterator1 ) {
         StringMap<int> m;
         ASSERT( m.begin() == m.end() );
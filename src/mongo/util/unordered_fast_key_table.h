@@ -46,16 +46,25 @@ namespace mongo {
 
     private:
         struct Entry {
-            Entry()
-                : used( false ), everUsed( false ) {
-            }
-
-            bool used;
-            bool everUsed;
             size_t curHash;
             value_type data;
         };
 
+        /**
+         * Each bucket has a control byte, kept apart from the entries so that probing reads a
+         * few contiguous bytes and only touches an entry whose control byte matches the 7 hash
+         * bits of the key looked up.
+         */
+        enum {
+            CONTROL_EMPTY = 0, // never used; ends a probe sequence
+            CONTROL_ERASED = 1, // was used; probes continue past it
+            CONTROL_USED = 0x80 // or'd with the low 7 bits of the entry's hash
+        };
+
+        static unsigned char usedControl( size_t hash ) {
+            return static_cast<unsigned char>( CONTROL_USED | ( hash & 0x7f ) );
+        }
+
         struct Area {
             Area( unsigned capacity, double maxProbeRatio );
             Area( const Area& other );
@@ -64,15 +73,19 @@ namespace mongo {
 
             bool transfer( Area* newArea, const UnorderedFastKeyTable& sm ) const;
 
+            bool isUsed( unsigned pos ) const { return _control[pos] & CONTROL_USED; }
+
             void swap( Area* other ) {
                 using std::swap;
                 swap( _capacity, other->_capacity );
                 swap( _maxProbe, other->_maxProbe );
+                swap( _control, other->_control );
                 swap( _entries, other->_entries );
             }
 
             unsigned _capacity;
             unsigned _maxProbe;
+            boost::scoped_array<unsigned char> _control;
             boost::scoped_array<Entry> _entries;
         };
 
@@ -157,7 +170,7 @@ namespace mongo {
 
             void _skip() {
                 while ( true ) {
-                    if ( _area->_entries[_position].used )
+                    if ( _area->isUsed( _position ) )
                         break;
                     if ( _position >= _max ) {
                         _position = -1;
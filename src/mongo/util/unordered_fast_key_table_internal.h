@@ -16,6 +16,8 @@
  *    limitations under the License.
  */
 
+#include <string.h>
+
 #include "mongo/util/assert_util.h"
 
 namespace mongo {
@@ -24,14 +26,18 @@ namespace mongo {
                                                                    double maxProbeRatio)
         : _capacity( capacity ),
           _maxProbe( static_cast<unsigned>( capacity * maxProbeRatio ) ),
+          _control( new unsigned char[_capacity] ),
           _entries( new Entry[_capacity] ) {
+        memset( _control.get(), CONTROL_EMPTY, _capacity );
     }
 
     template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
     inline UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::Area(const Area& other )
         : _capacity( other._capacity ),
           _maxProbe( other._maxProbe ),
+          _control( new unsigned char[_capacity] ),
           _entries( new Entry[_capacity] ) {
+        memcpy( _control.get(), other._control.get(), _capacity );
         for ( unsigned i = 0; i < _capacity; i++ ) {
             _entries[i] = other._entries[i];
         }
@@ -46,19 +52,28 @@ namespace mongo {
         if ( firstEmpty )
             *firstEmpty = -1;
 
-        for ( unsigned probe = 0; probe < _maxProbe; probe++ ) {
-            unsigned pos = (hash + probe) % _capacity;
+        if ( _maxProbe == 0 )
+            return -1;
+
+        const unsigned char used = usedControl( hash );
+        unsigned pos = hash % _capacity;
+
+        for ( unsigned probe = 0; probe < _maxProbe; probe++, pos++ ) {
+            if ( pos == _capacity )
+                pos = 0;
+
+            const unsigned char control = _control[pos];
 
-            if ( ! _entries[pos].used ) {
+            if ( ! ( control & CONTROL_USED ) ) {
                 // space is empty
                 if ( firstEmpty && *firstEmpty == -1 )
                     *firstEmpty = pos;
-                if ( ! _entries[pos].everUsed )
+                if ( control == CONTROL_EMPTY )
                     return -1;
                 continue;
             }
 
-            if ( _entries[pos].curHash != hash ) {
+            if ( control != used || _entries[pos].curHash != hash ) {
                 // space has something else
                 continue;
             }
@@ -81,7 +96,7 @@ namespace mongo {
             Area* newArea,
             const UnorderedFastKeyTable& sm) const {
         for ( unsigned i = 0; i < _capacity; i++ ) {
-            if ( ! _entries[i].used )
+            if ( ! isUsed( i ) )
                 continue;
 
             int firstEmpty = -1;
@@ -95,6 +110,7 @@ namespace mongo {
                 return false;
             }
 
+            newArea->_control[firstEmpty] = _control[i];
             newArea->_entries[firstEmpty] = _entries[i];
         }
         return true;
@@ -143,8 +159,7 @@ namespace mongo {
             // need to add
             if ( firstEmpty >= 0 ) {
                 _size++;
-                _area._entries[firstEmpty].used = true;
-                _area._entries[firstEmpty].everUsed = true;
+                _area._control[firstEmpty] = usedControl( hash );
                 _area._entries[firstEmpty].curHash = hash;
                 _area._entries[firstEmpty].data.first = _convertorOther(key);
                 return _area._entries[firstEmpty].data.second;
@@ -165,7 +180,7 @@ namespace mongo {
         if ( pos < 0 )
             return 0;
 
-        _area._entries[pos].used = false;
+        _area._control[pos] = CONTROL_ERASED;
         _area._entries[pos].data.second = V();
         return 1;
     }